@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/c/c_api_experimental.h"
 
+#include <cstring>
+#include <memory>
+
 #include "absl/strings/substitute.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -750,3 +753,169 @@ TF_Library* TF_LoadPluggableDeviceLibrary(const char* library_filename,
 void TF_DeletePluggableDeviceLibraryHandle(TF_Library* lib_handle) {
   delete lib_handle;
 }
+
+struct TF_SessionCallable {
+  tensorflow::Session::CallableHandle handle;
+  int num_inputs;
+  std::vector<TF_DataType> output_types;
+  // Borrowed, nullptr for the outputs that aren't bound.
+  std::vector<TF_Tensor*> bound_outputs;
+};
+
+namespace {
+
+std::string CallableTensorName(const TF_Output& output) {
+  return tensorflow::strings::StrCat(output.oper->node.name(), ":",
+                                     output.index);
+}
+
+// Writes `src` into the buffer of the bound output `dst`, unless `src` is
+// backed by it already, e.g. when the output forwards an input fed from the
+// same tensor.
+Status WriteBoundOutput(int index, const tensorflow::Tensor& src,
+                        TF_Tensor* dst) {
+  if (!src.IsInitialized()) {
+    return tensorflow::errors::FailedPrecondition(
+        "Output ", index, " of the callable has an uninitialized value");
+  }
+  tensorflow::Tensor bound;
+  TF_RETURN_IF_ERROR(tensorflow::TF_TensorToTensor(dst, &bound));
+  if (src.shape() != bound.shape()) {
+    return InvalidArgument("Output ", index, " of shape ",
+                           src.shape().DebugString(),
+                           " can't be written to its bound tensor of shape ",
+                           bound.shape().DebugString());
+  }
+  if (src.NumElements() == 0 || src.data() == bound.data()) {
+    return Status::OK();
+  }
+  if (src.dtype() == tensorflow::DT_STRING) {
+    auto from = src.flat<tensorflow::tstring>();
+    auto to = bound.flat<tensorflow::tstring>();
+    for (int64_t i = 0; i < from.size(); ++i) {
+      to(i) = from(i);
+    }
+  } else {
+    std::memcpy(bound.data(), src.data(), src.TotalBytes());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+TF_SessionCallable* TF_SessionMakeCallable(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    int ninputs, const TF_Output* outputs, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets, TF_Status* status) {
+  status->status = Status::OK();
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return nullptr;
+  }
+  tensorflow::CallableOptions options;
+  if (run_options != nullptr &&
+      !options.mutable_run_options()->ParseFromArray(run_options->data,
+                                                     run_options->length)) {
+    status->status = InvalidArgument("Unparseable RunOptions proto");
+    return nullptr;
+  }
+  auto callable = std::make_unique<TF_SessionCallable>();
+  callable->num_inputs = ninputs;
+  for (int i = 0; i < ninputs; ++i) {
+    options.add_feed(CallableTensorName(inputs[i]));
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    options.add_fetch(CallableTensorName(outputs[i]));
+    callable->output_types.push_back(TF_OperationOutputType(outputs[i]));
+  }
+  callable->bound_outputs.assign(noutputs, nullptr);
+  for (int i = 0; i < ntargets; ++i) {
+    options.add_target(target_opers[i]->node.name());
+  }
+  status->status = session->session->MakeCallable(options, &callable->handle);
+  if (!status->status.ok()) return nullptr;
+  return callable.release();
+}
+
+void TF_SessionReleaseCallable(TF_Session* session,
+                               TF_SessionCallable* callable,
+                               TF_Status* status) {
+  status->status = session->session->ReleaseCallable(callable->handle);
+  delete callable;
+}
+
+void TF_SessionCallableBindOutput(TF_SessionCallable* callable, int index,
+                                  TF_Tensor* tensor, TF_Status* status) {
+  status->status = Status::OK();
+  const int noutputs = callable->output_types.size();
+  if (index < 0 || index >= noutputs) {
+    status->status = InvalidArgument("Output index ", index,
+                                     " is out of range for a callable with ",
+                                     noutputs, " outputs");
+    return;
+  }
+  if (tensor != nullptr) {
+    const auto type = static_cast<tensorflow::DataType>(TF_TensorType(tensor));
+    const auto output_type =
+        static_cast<tensorflow::DataType>(callable->output_types[index]);
+    if (type != output_type) {
+      status->status = InvalidArgument(
+          "Can't bind a tensor of type ", tensorflow::DataTypeString(type),
+          " to output ", index, " of type ",
+          tensorflow::DataTypeString(output_type));
+      return;
+    }
+    if (!tensorflow::DataTypeCanUseMemcpy(type) &&
+        type != tensorflow::DT_STRING) {
+      status->status = tensorflow::errors::Unimplemented(
+          "Outputs of type ", tensorflow::DataTypeString(type),
+          " can't be bound");
+      return;
+    }
+  }
+  callable->bound_outputs[index] = tensor;
+}
+
+void TF_SessionRunCallable(TF_Session* session, TF_SessionCallable* callable,
+                           TF_Tensor* const* input_values,
+                           TF_Tensor** output_values, TF_Buffer* run_metadata,
+                           TF_Status* status) {
+  status->status = Status::OK();
+  const int noutputs = callable->output_types.size();
+  for (int i = 0; i < noutputs; ++i) {
+    output_values[i] = nullptr;
+  }
+  if (run_metadata != nullptr && run_metadata->data != nullptr) {
+    status->status =
+        InvalidArgument("Passing non-empty run_metadata is invalid.");
+    return;
+  }
+
+  // The feeds share the buffers of the input tensors.
+  std::vector<tensorflow::Tensor> feeds(callable->num_inputs);
+  for (int i = 0; i < callable->num_inputs; ++i) {
+    status->status = tensorflow::TF_TensorToTensor(input_values[i], &feeds[i]);
+    if (!status->status.ok()) return;
+  }
+  std::vector<tensorflow::Tensor> fetches;
+  tensorflow::RunMetadata run_metadata_proto;
+  status->status = session->session->RunCallable(
+      callable->handle, feeds, &fetches,
+      run_metadata == nullptr ? nullptr : &run_metadata_proto);
+  if (!status->status.ok()) return;
+  if (run_metadata != nullptr) {
+    status->status = MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    TF_Tensor* bound = callable->bound_outputs[i];
+    if (bound != nullptr) {
+      status->status = WriteBoundOutput(i, fetches[i], bound);
+    } else {
+      output_values[i] =
+          tensorflow::TF_TensorFromTensor(fetches[i], &status->status);
+    }
+    if (!status->status.ok()) return;
+  }
+}
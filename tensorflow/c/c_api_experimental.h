@@ -325,6 +325,53 @@ TF_CAPI_EXPORT extern TF_Library* TF_LoadPluggableDeviceLibrary(
 TF_CAPI_EXPORT extern void TF_DeletePluggableDeviceLibraryHandle(
     TF_Library* lib_handle);
 
+// A subgraph of a session with fixed inputs, outputs and targets, which is
+// prepared once and can then be run many times without looking up the feeds
+// and fetches on each run, like the C++ Session::MakeCallable().
+typedef struct TF_SessionCallable TF_SessionCallable;
+
+// Makes a callable that feeds `inputs`, fetches `outputs` and runs
+// `target_opers` of the graph of `session`, with the serialized RunOptions
+// `run_options`, which may be NULL.
+//
+// On success, returns the callable, which must be released with
+// TF_SessionReleaseCallable. On failure, returns NULL and places an error
+// status in status.
+TF_CAPI_EXPORT extern TF_SessionCallable* TF_SessionMakeCallable(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    int ninputs, const TF_Output* outputs, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets, TF_Status* status);
+
+// Releases `callable`, which was made for `session`, and deletes it.
+TF_CAPI_EXPORT extern void TF_SessionReleaseCallable(
+    TF_Session* session, TF_SessionCallable* callable, TF_Status* status);
+
+// Binds `tensor` to the output `index` of `callable`, so that the runs
+// of the callable write that output into the buffer of `tensor` instead of
+// returning a new tensor. `tensor` must have the type of the output, and
+// the shape the output has on each run. The caller keeps the ownership of
+// `tensor`, which must outlive the binding. Passing NULL unbinds the output.
+//
+// Only numeric, boolean and string outputs can be bound. Runs of a callable
+// with bound outputs must not overlap.
+TF_CAPI_EXPORT extern void TF_SessionCallableBindOutput(
+    TF_SessionCallable* callable, int index, TF_Tensor* tensor,
+    TF_Status* status);
+
+// Runs `callable` in `session`, like TF_SessionRun. `input_values` holds a
+// tensor for each input, and aligned input tensors are fed without copying
+// their buffers (see TF_TensorIsAligned). `output_values` has room for each
+// output: the bound outputs are written to their tensors and set to NULL in
+// `output_values`, while the others are returned as new tensors that the
+// caller owns.
+//
+// `run_metadata`, if not NULL, must be empty, and receives the serialized
+// RunMetadata of the run.
+TF_CAPI_EXPORT extern void TF_SessionRunCallable(
+    TF_Session* session, TF_SessionCallable* callable,
+    TF_Tensor* const* input_values, TF_Tensor** output_values,
+    TF_Buffer* run_metadata, TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
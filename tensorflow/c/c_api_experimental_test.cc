@@ -255,5 +255,130 @@ TEST(CAPI_EXPERIMENTAL, LibraryPluggableDeviceLoadFunctions) {
 #endif  // !defined(PLATFORM_WINDOWS)
 }
 
+// Feeds a vector of int32 and fetches its negation and the fed tensor itself.
+class SessionCallableTest : public ::testing::Test {
+ protected:
+  SessionCallableTest() : status_(TF_NewStatus()), graph_(TF_NewGraph()) {
+    feed_ = Placeholder(graph_, status_, "feed", TF_INT32, {2});
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    neg_ = Neg(feed_, graph_, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TF_OperationDescription* desc =
+        TF_NewOperation(graph_, "Identity", "identity");
+    TF_AddInput(desc, {feed_, 0});
+    identity_ = TF_FinishOperation(desc, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+
+    TF_SessionOptions* options = TF_NewSessionOptions();
+    session_ = TF_NewSession(graph_, options, status_);
+    TF_DeleteSessionOptions(options);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+
+    const TF_Output input = {feed_, 0};
+    const TF_Output outputs[] = {{neg_, 0}, {identity_, 0}};
+    callable_ = TF_SessionMakeCallable(session_, /*run_options=*/nullptr,
+                                       &input, 1, outputs, 2,
+                                       /*target_opers=*/nullptr, 0, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  }
+
+  ~SessionCallableTest() override {
+    TF_SessionReleaseCallable(session_, callable_, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TF_CloseSession(session_, status_);
+    TF_DeleteSession(session_, status_);
+    TF_DeleteGraph(graph_);
+    TF_DeleteStatus(status_);
+  }
+
+  // Runs the callable on `values`, and returns the outputs.
+  std::vector<TF_Tensor*> Run(const std::vector<int32_t>& values) {
+    TF_Tensor* input = Int32Tensor(values);
+    std::vector<TF_Tensor*> outputs(2);
+    TF_SessionRunCallable(session_, callable_, &input, outputs.data(),
+                          /*run_metadata=*/nullptr, status_);
+    TF_DeleteTensor(input);
+    return outputs;
+  }
+
+  TF_Status* status_;
+  TF_Graph* graph_;
+  TF_Operation* feed_;
+  TF_Operation* neg_;
+  TF_Operation* identity_;
+  TF_Session* session_;
+  TF_SessionCallable* callable_;
+};
+
+TEST_F(SessionCallableTest, ReturnsUnboundOutputs) {
+  for (int32_t v : {1, 5}) {
+    std::vector<TF_Tensor*> outputs = Run({v, -v});
+    ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    const auto* neg = static_cast<const int32_t*>(TF_TensorData(outputs[0]));
+    EXPECT_EQ(neg[0], -v);
+    EXPECT_EQ(neg[1], v);
+    TF_DeleteTensor(outputs[0]);
+    TF_DeleteTensor(outputs[1]);
+  }
+}
+
+TEST_F(SessionCallableTest, FeedsAlignedInputsWithoutCopies) {
+  TF_Tensor* input = Int32Tensor({3, 4});
+  ASSERT_TRUE(TF_TensorIsAligned(input));
+  TF_Tensor* outputs[2];
+  TF_SessionRunCallable(session_, callable_, &input, outputs,
+                        /*run_metadata=*/nullptr, status_);
+  ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  EXPECT_EQ(TF_TensorData(outputs[1]), TF_TensorData(input));
+  TF_DeleteTensor(outputs[0]);
+  TF_DeleteTensor(outputs[1]);
+  TF_DeleteTensor(input);
+}
+
+TEST_F(SessionCallableTest, WritesBoundOutputs) {
+  TF_Tensor* bound = Int32Tensor({0, 0});
+  void* const data = TF_TensorData(bound);
+  TF_SessionCallableBindOutput(callable_, 0, bound, status_);
+  ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  for (int32_t v : {1, 5}) {
+    std::vector<TF_Tensor*> outputs = Run({v, 2 * v});
+    ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    EXPECT_EQ(outputs[0], nullptr);
+    ASSERT_NE(outputs[1], nullptr);
+    TF_DeleteTensor(outputs[1]);
+    ASSERT_EQ(TF_TensorData(bound), data);
+    EXPECT_EQ(static_cast<const int32_t*>(data)[0], -v);
+    EXPECT_EQ(static_cast<const int32_t*>(data)[1], -2 * v);
+  }
+
+  TF_SessionCallableBindOutput(callable_, 0, nullptr, status_);
+  ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  std::vector<TF_Tensor*> outputs = Run({7, 8});
+  ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  ASSERT_NE(outputs[0], nullptr);
+  EXPECT_EQ(static_cast<const int32_t*>(data)[0], -5);
+  TF_DeleteTensor(outputs[0]);
+  TF_DeleteTensor(outputs[1]);
+  TF_DeleteTensor(bound);
+}
+
+TEST_F(SessionCallableTest, RejectsMismatchedBoundOutputs) {
+  TF_Tensor* float_tensor = FloatTensor(1.0f);
+  TF_SessionCallableBindOutput(callable_, 0, float_tensor, status_);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status_));
+  TF_SessionCallableBindOutput(callable_, 2, nullptr, status_);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status_));
+  TF_DeleteTensor(float_tensor);
+
+  TF_Tensor* scalar = Int32Tensor(0);
+  TF_SessionCallableBindOutput(callable_, 0, scalar, status_);
+  ASSERT_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  std::vector<TF_Tensor*> outputs = Run({1, 2});
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status_));
+  EXPECT_EQ(outputs[0], nullptr);
+  TF_DeleteTensor(outputs[1]);
+  TF_DeleteTensor(scalar);
+}
+
 }  // namespace
 }  // namespace tensorflow
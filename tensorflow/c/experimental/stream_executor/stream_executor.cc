@@ -145,6 +145,11 @@ port::Status ValidateSPStreamExecutor(const SP_StreamExecutor& se,
   TF_VALIDATE_NOT_NULL(SP_StreamExecutor, se, mem_zero);
   TF_VALIDATE_NOT_NULL(SP_StreamExecutor, se, memset);
   TF_VALIDATE_NOT_NULL(SP_StreamExecutor, se, memset32);
+  if ((se.allocate_region == nullptr) != (se.deallocate_region == nullptr)) {
+    return port::FailedPreconditionError(
+        "'allocate_region' and 'deallocate_region' fields in "
+        "SP_StreamExecutor must be set together.");
+  }
   return port::Status::OK();
 }
 
@@ -251,6 +256,27 @@ class CStreamExecutor : public internal::StreamExecutorInterface {
     stream_executor_->deallocate(&device_, &device_memory_base);
   }
 
+  bool AllocatesRegions() const {
+    return stream_executor_->allocate_region != nullptr;
+  }
+  DeviceMemoryBase AllocateRegion(uint64 alignment, uint64 size,
+                                  uint64* bytes_received) {
+    SP_DeviceMemoryBase mem = {SP_DEVICE_MEMORY_BASE_STRUCT_SIZE};
+    uint64_t c_bytes_received = 0;
+    stream_executor_->allocate_region(&device_, alignment, size, &mem,
+                                      &c_bytes_received);
+    port::Status status = ValidateSPDeviceMemoryBase(mem);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    *bytes_received = c_bytes_received;
+    return DeviceMemoryBaseFromC(mem);
+  }
+  void DeallocateRegion(DeviceMemoryBase* region) {
+    SP_DeviceMemoryBase device_memory_base = DeviceMemoryBaseToC(region);
+    stream_executor_->deallocate_region(&device_, &device_memory_base);
+  }
+
   void* HostMemoryAllocate(uint64 size) override {
     return stream_executor_->host_memory_allocate(&device_, size);
   }
@@ -652,8 +678,28 @@ class CStreamExecutor : public internal::StreamExecutorInterface {
   std::string platform_name_;
   int visible_device_count_;
 };
+
+CStreamExecutor* AsCStreamExecutor(StreamExecutor* executor) {
+  auto* c_executor = dynamic_cast<CStreamExecutor*>(executor->implementation());
+  CHECK(c_executor != nullptr) << "Not a pluggable device executor.";
+  return c_executor;
+}
 }  // namespace
 
+bool PluginAllocatesRegions(StreamExecutor* executor) {
+  return AsCStreamExecutor(executor)->AllocatesRegions();
+}
+
+DeviceMemoryBase AllocateRegion(StreamExecutor* executor, uint64 alignment,
+                                uint64 size, uint64* bytes_received) {
+  return AsCStreamExecutor(executor)->AllocateRegion(alignment, size,
+                                                     bytes_received);
+}
+
+void DeallocateRegion(StreamExecutor* executor, DeviceMemoryBase* region) {
+  AsCStreamExecutor(executor)->DeallocateRegion(region);
+}
+
 CPlatform::CPlatform(SP_Platform platform,
                      void (*destroy_platform)(SP_Platform*),
                      SP_PlatformFns platform_fns,
@@ -83,8 +83,8 @@ limitations under the License.
 //   }
 
 #define SE_MAJOR 0
-#define SE_MINOR 0
-#define SE_PATCH 1
+#define SE_MINOR 1
+#define SE_PATCH 0
 
 #ifdef __cplusplus
 extern "C" {
@@ -412,10 +412,27 @@ typedef struct SP_StreamExecutor {
   // `callback_arg` should be passed as the first argument to `callback_fn`.
   TF_Bool (*host_callback)(const SP_Device* device, SP_Stream stream,
                            SE_StatusCallbackFn callback_fn, void* callback_arg);
+
+  // [Optional]
+  // Allocates a region of at least `size` bytes aligned to `alignment` for the
+  // BFC allocator to carve tensors from, and sets `bytes_received` to the size
+  // of the region, which may be larger, e.g. rounded up to the page size of
+  // the device. This lets plugins serve regions from their own pools in their
+  // own granularity. Only used when `use_bfc_allocator` is set in
+  // `SP_Platform`; regions are allocated with `allocate` if not set. Must be
+  // set together with `deallocate_region`.
+  void (*allocate_region)(const SP_Device* device, uint64_t alignment,
+                          uint64_t size, SP_DeviceMemoryBase* mem,
+                          uint64_t* bytes_received);
+
+  // [Optional]
+  // Deallocates a region allocated by `allocate_region`. `mem->size` is the
+  // `bytes_received` of the allocation.
+  void (*deallocate_region)(const SP_Device* device, SP_DeviceMemoryBase* mem);
 } SP_StreamExecutor;
 
 #define SP_STREAMEXECUTOR_STRUCT_SIZE \
-  TF_OFFSET_OF_END(SP_StreamExecutor, host_callback)
+  TF_OFFSET_OF_END(SP_StreamExecutor, deallocate_region)
 
 typedef struct SE_CreateStreamExecutorParams {
   size_t struct_size;
@@ -450,9 +467,17 @@ typedef struct SP_Platform {
   // Whether to wrap allocator for this device with an allocator that uses BFC
   // (best-fit with coalescing) strategy.
   TF_Bool use_bfc_allocator;
+
+  // Whether `host_callback` runs the callbacks on threads that may block and
+  // enqueue more work on the device. If set, TensorFlow completes copies and
+  // the other work waiting on streams with `host_callback`, instead of
+  // recording events and polling their status, which saves several calls per
+  // op for ops with short kernels.
+  TF_Bool use_host_callback_for_completion;
 } SP_Platform;
 
-#define SP_PLATFORM_STRUCT_SIZE TF_OFFSET_OF_END(SP_Platform, use_bfc_allocator)
+#define SP_PLATFORM_STRUCT_SIZE \
+  TF_OFFSET_OF_END(SP_Platform, use_host_callback_for_completion)
 
 typedef struct SP_PlatformFns {
   size_t struct_size;
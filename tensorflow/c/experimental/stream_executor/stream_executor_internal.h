@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/c/experimental/stream_executor/stream_executor.h"
 #include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/stream_executor/device_memory.h"
 #include "tensorflow/stream_executor/executor_cache.h"
 #include "tensorflow/stream_executor/lib/status.h"
 #include "tensorflow/stream_executor/platform.h"
@@ -43,6 +44,16 @@ port::Status InitStreamExecutorPlugin(SEInitPluginFn init_fn,
                                       std::string* device_type,
                                       std::string* platform_name);
 
+// Whether the plugin of `executor`, a pluggable device executor, allocates the
+// regions of BFC allocators with `allocate_region`.
+bool PluginAllocatesRegions(StreamExecutor* executor);
+
+// Allocate and deallocate regions with `allocate_region` and
+// `deallocate_region`. Must only be called if PluginAllocatesRegions.
+DeviceMemoryBase AllocateRegion(StreamExecutor* executor, uint64 alignment,
+                                uint64 size, uint64* bytes_received);
+void DeallocateRegion(StreamExecutor* executor, DeviceMemoryBase* region);
+
 // This file implements core stream executor base classes in terms of
 // the C API defined in stream_executor.h. A class "CSomething" represents a
 // "Something" that can be manipulated via calls in the C interface.
@@ -70,6 +81,9 @@ class CPlatform : public Platform {
     return visible_device_count;
   }
   bool UseBfcAllocator() const { return platform_.use_bfc_allocator; }
+  bool UseHostCallbackForCompletion() const {
+    return platform_.use_host_callback_for_completion;
+  }
   port::StatusOr<std::unique_ptr<DeviceDescription>> DescriptionForDevice(
       int ordinal) const override;
   port::StatusOr<StreamExecutor*> ExecutorForDevice(int ordinal) override;
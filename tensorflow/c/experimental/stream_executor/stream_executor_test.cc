@@ -132,6 +132,32 @@ TEST(StreamExecutor, UnifiedMemoryAllocateNotSet) {
       "'unified_memory_allocate' field in SP_StreamExecutor must be set.");
 }
 
+TEST(StreamExecutor, DeallocateRegionNotSet) {
+  auto plugin_init = [](SE_PlatformRegistrationParams* const params,
+                        TF_Status* const status) -> void {
+    TF_SetStatus(status, TF_OK, "");
+    test_util::PopulateDefaultPlatformRegistrationParams(params);
+    params->platform_fns->create_stream_executor =
+        [](const SP_Platform* platform, SE_CreateStreamExecutorParams* params,
+           TF_Status* status) {
+          TF_SetStatus(status, TF_OK, "");
+          test_util::PopulateDefaultStreamExecutor(params->stream_executor);
+          params->stream_executor->allocate_region =
+              [](const SP_Device* const device, uint64_t alignment,
+                 uint64_t size, SP_DeviceMemoryBase* const mem,
+                 uint64_t* const bytes_received) {};
+        };
+  };
+
+  std::string device_type, platform_name;
+  port::Status status =
+      InitStreamExecutorPlugin(plugin_init, &device_type, &platform_name);
+  ASSERT_EQ(status.code(), tensorflow::error::FAILED_PRECONDITION);
+  ASSERT_EQ(status.error_message(),
+            "'allocate_region' and 'deallocate_region' fields in "
+            "SP_StreamExecutor must be set together.");
+}
+
 /*** StreamExecutor behavior tests ***/
 class StreamExecutorTest : public ::testing::Test {
  protected:
@@ -185,6 +211,36 @@ TEST_F(StreamExecutorTest, Allocate) {
   ASSERT_EQ(mem.opaque(), nullptr);
 }
 
+TEST_F(StreamExecutorTest, AllocateRegion) {
+  StreamExecutor* executor = GetExecutor(0);
+  ASSERT_FALSE(PluginAllocatesRegions(executor));
+  cplatform_.reset();
+
+  // Regions are rounded up to 1KB pages.
+  se_.allocate_region = [](const SP_Device* const device, uint64_t alignment,
+                           uint64_t size, SP_DeviceMemoryBase* const mem,
+                           uint64_t* const bytes_received) {
+    *bytes_received = (size + 1023) / 1024 * 1024;
+    mem->struct_size = SP_DEVICE_MEMORY_BASE_STRUCT_SIZE;
+    mem->opaque = malloc(*bytes_received);
+    mem->size = *bytes_received;
+  };
+  se_.deallocate_region = [](const SP_Device* const device,
+                             SP_DeviceMemoryBase* const mem) {
+    EXPECT_EQ(mem->size, 2048);
+    free(mem->opaque);
+  };
+  executor = GetExecutor(0);
+  ASSERT_TRUE(PluginAllocatesRegions(executor));
+  uint64 bytes_received = 0;
+  DeviceMemoryBase region = AllocateRegion(executor, /*alignment=*/256,
+                                           /*size=*/1500, &bytes_received);
+  ASSERT_NE(region.opaque(), nullptr);
+  EXPECT_EQ(bytes_received, 2048);
+  DeviceMemoryBase region_to_free(region.opaque(), bytes_received);
+  DeallocateRegion(executor, &region_to_free);
+}
+
 TEST_F(StreamExecutorTest, HostMemoryAllocate) {
   static bool allocate_called = false;
   static bool deallocate_called = false;
@@ -99,6 +99,7 @@ Status ReadCheckpointObjectGraph(BundleReader* bundle_reader,
 Status SavedModelV2Bundle::Load(const std::string& export_dir,
                                 SavedModelV2Bundle* const bundle) {
   metrics::SavedModelReadApi(kCCLoadBundleV2Label).IncrementBy(1);
+  const uint64 read_start_microseconds = EnvTime::NowMicros();
   SavedModel saved_model_proto;
   TF_RETURN_IF_ERROR(ReadSavedModelProto(export_dir, &saved_model_proto));
 
@@ -122,6 +123,8 @@ Status SavedModelV2Bundle::Load(const std::string& export_dir,
   // Load GraphDebugInfo.
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info_));
+  metrics::SavedModelLoadLatencyByStage(export_dir, "read_meta_graph")
+      .Add(EnvTime::NowMicros() - read_start_microseconds);
 
   const std::string variables_dir =
       io::JoinPath(export_dir, kSavedModelVariablesDirectory);
@@ -129,6 +132,7 @@ Status SavedModelV2Bundle::Load(const std::string& export_dir,
     LOG(INFO)
         << "No checkpoint found, assuming this is a program-only SavedModel";
   } else {
+    const uint64 index_start_microseconds = EnvTime::NowMicros();
     // Load the variables checkpoint reader.
     const std::string variables_prefix =
         io::JoinPath(variables_dir, kSavedModelVariablesFilename);
@@ -142,6 +146,8 @@ Status SavedModelV2Bundle::Load(const std::string& export_dir,
     // Deserialize the object graph proto from the tensor bundle.
     TF_RETURN_IF_ERROR(ReadCheckpointObjectGraph(
         bundle->variable_reader_.get(), &bundle->trackable_object_graph_));
+    metrics::SavedModelLoadLatencyByStage(export_dir, "read_checkpoint_index")
+        .Add(EnvTime::NowMicros() - index_start_microseconds);
   }
   return Status::OK();
 }
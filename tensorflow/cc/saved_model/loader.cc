@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <atomic>
+#include <memory>
 #include <unordered_set>
+#include <utility>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
 #include "tensorflow/cc/saved_model/metrics.h"
@@ -38,7 +42,9 @@ limitations under the License.
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -51,17 +57,6 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were successfully loaded.",
     "model_path");
-auto* load_latency_by_stage = monitoring::Sampler<2>::New(
-    {
-        "/tensorflow/cc/saved_model/load_latency_by_stage",  // metric name
-        "Distribution of wall time spent (in microseconds) in each stage "
-        "(restore graph from disk, run init graph op, etc) when loading the "
-        "model",
-        "model_path",
-        "stage",
-    },
-    // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
-    monitoring::Buckets::Exponential(10, 1.8, 33));
 
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
@@ -234,11 +229,87 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
 
   AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
 
+  // With TF_SAVED_MODEL_MMAP_VARIABLES set, the restored variables alias the
+  // memory-mapped data files, so that loading does not copy them and pages
+  // are only read when the model uses them.
+  bool mmap_variables = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SAVED_MODEL_MMAP_VARIABLES", false,
+                                        &mmap_variables));
+  std::unique_ptr<ScopedBundleReaderOptions> reader_options;
+  if (mmap_variables) {
+    BundleReader::Options options;
+    options.use_mmap = true;
+    options.verify_mapped_checksums = false;
+    reader_options =
+        absl::make_unique<ScopedBundleReaderOptions>(variables_path, options);
+  }
+
   RunMetadata run_metadata;
   return RunOnce(run_options, inputs, {}, {string(restore_op_name)},
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// Reads the variable data files of a SavedModel on a background thread, so
+// that reading them from disk overlaps with importing the graph and creating
+// the restore op's executors, and the restore op then mostly reads from the
+// page cache. Reading stops early when the prefetcher is destroyed.
+class VariablePrefetcher {
+ public:
+  explicit VariablePrefetcher(const string& export_dir) {
+    const string variables_path =
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                     kSavedModelVariablesFilename);
+    std::vector<string> data_files;
+    if (!Env::Default()
+             ->GetMatchingPaths(strings::StrCat(variables_path, ".data-*"),
+                                &data_files)
+             .ok() ||
+        data_files.empty()) {
+      return;
+    }
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "saved_model_prefetch_variables",
+        [this, export_dir, data_files = std::move(data_files)]() {
+          const uint64 start_microseconds = EnvTime::NowMicros();
+          std::unique_ptr<char[]> scratch(new char[kChunkSize]);
+          for (const string& data_file : data_files) {
+            if (!PrefetchFile(data_file, scratch.get())) return;
+          }
+          metrics::SavedModelLoadLatencyByStage(export_dir,
+                                                "prefetch_variables")
+              .Add(GetLatencyMicroseconds(start_microseconds));
+        }));
+  }
+
+  ~VariablePrefetcher() {
+    cancelled_ = true;
+    thread_.reset();
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 8 << 20;
+
+  // Returns false if the prefetcher was cancelled before reading all of
+  // `filename`. Errors are ignored, the restore op reports them.
+  bool PrefetchFile(const string& filename, char* scratch) {
+    std::unique_ptr<RandomAccessFile> file;
+    if (!Env::Default()->NewRandomAccessFile(filename, &file).ok()) {
+      return true;
+    }
+    uint64 offset = 0;
+    while (!cancelled_) {
+      StringPiece chunk;
+      const Status status = file->Read(offset, kChunkSize, &chunk, scratch);
+      offset += chunk.size();
+      if (!status.ok() || chunk.size() < kChunkSize) return true;
+    }
+    return false;
+  }
+
+  std::atomic<bool> cancelled_{false};
+  std::unique_ptr<Thread> thread_;
+};
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() {}
@@ -258,12 +329,34 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
                               SavedModelBundle* const bundle) {
+  const uint64 read_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  metrics::SavedModelLoadLatencyByStage(export_dir, "read_meta_graph")
+      .Add(GetLatencyMicroseconds(read_start_microseconds));
+
+  // With TF_SAVED_MODEL_PREFETCH_VARIABLES set, the variable data files are
+  // read while the graph is imported. Memory-mapped variables are only read
+  // when they are used, so they are not prefetched.
+  bool prefetch_variables = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SAVED_MODEL_PREFETCH_VARIABLES",
+                                        false, &prefetch_variables));
+  bool mmap_variables = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SAVED_MODEL_MMAP_VARIABLES", false,
+                                        &mmap_variables));
+  std::unique_ptr<VariablePrefetcher> prefetcher;
+  if (prefetch_variables && !mmap_variables &&
+      bundle->meta_graph_def.has_saver_def()) {
+    prefetcher = absl::make_unique<VariablePrefetcher>(export_dir);
+  }
+
+  const uint64 import_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
+  metrics::SavedModelLoadLatencyByStage(export_dir, "import_graph")
+      .Add(GetLatencyMicroseconds(import_start_microseconds));
   TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
                                     export_dir, &bundle->session));
   return Status::OK();
@@ -427,11 +520,11 @@ Status RestoreSession(const RunOptions& run_options,
       internal::GetInitOp(export_dir, meta_graph, &init_op_name));
   TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
                                asset_file_defs, session->get(), init_op_name));
-  load_latency_by_stage->GetCell(export_dir, "restore_graph")
-      ->Add(restore_graph_walltime);
+  metrics::SavedModelLoadLatencyByStage(export_dir, "restore_graph")
+      .Add(restore_graph_walltime);
   // Record wall time spent in init op.
-  load_latency_by_stage->GetCell(export_dir, "init_graph")
-      ->Add(GetLatencyMicroseconds(graph_init_start_microseconds));
+  metrics::SavedModelLoadLatencyByStage(export_dir, "init_graph")
+      .Add(GetLatencyMicroseconds(graph_init_start_microseconds));
   return Status::OK();
 }
 
@@ -51,6 +51,19 @@ auto* saved_model_read_api = monitoring::Counter<1>::New(
     "/tensorflow/core/saved_model/read/api",
     "The API used to load the SavedModel.", "api_label");
 
+// Distribution of the wall time spent in each stage of loading a SavedModel.
+auto* saved_model_load_latency_by_stage = monitoring::Sampler<2>::New(
+    {
+        "/tensorflow/cc/saved_model/load_latency_by_stage",  // Metric name.
+        "Distribution of wall time spent (in microseconds) in each stage "
+        "(restore graph from disk, run init graph op, etc) when loading the "
+        "model",       // Metric description.
+        "model_path",  // Cell label.
+        "stage",       // Cell label.
+    },
+    // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
 // Distribution of checkpoint write durations.
 auto* checkpoint_write_durations = monitoring::Sampler<1>::New(
     {
@@ -100,6 +113,12 @@ monitoring::CounterCell& SavedModelReadApi(absl::string_view api_label) {
   return *saved_model_read_api->GetCell(std::string(api_label));
 }
 
+monitoring::SamplerCell& SavedModelLoadLatencyByStage(
+    absl::string_view model_path, absl::string_view stage) {
+  return *saved_model_load_latency_by_stage->GetCell(std::string(model_path),
+                                                     std::string(stage));
+}
+
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label) {
   return *checkpoint_read_durations->GetCell(std::string(api_label));
 }
@@ -50,6 +50,13 @@ monitoring::CounterCell& SavedModelWriteApi(absl::string_view api_label);
 // `foo` should be incremented when the read API `foo` is called.
 monitoring::CounterCell& SavedModelReadApi(absl::string_view api_label);
 
+// Returns "/tensorflow/cc/saved_model/load_latency_by_stage" cell. This metric
+// has 2 fields, "model_path" and "stage", and records the wall time in
+// microseconds that loading the SavedModel at `model_path` spent in `stage`,
+// such as "read_meta_graph", "import_graph", "restore_graph" or "init_graph".
+monitoring::SamplerCell& SavedModelLoadLatencyByStage(
+    absl::string_view model_path, absl::string_view stage);
+
 // Returns "/tensorflow/core/checkpoint/read/read_durations" cell belonging to
 // field `api_label`.
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label);
@@ -43,6 +43,16 @@ TEST(MetricsTest, TestSavedModelRead) {
   EXPECT_EQ(SavedModelRead("2").value(), 2);
 }
 
+TEST(MetricsTest, TestSavedModelLoadLatencyByStage) {
+  EXPECT_EQ(SavedModelLoadLatencyByStage("/foo", "restore_graph").value().num(),
+            0);
+  SavedModelLoadLatencyByStage("/foo", "restore_graph").Add(100);
+  EXPECT_EQ(SavedModelLoadLatencyByStage("/foo", "restore_graph").value().num(),
+            1);
+  EXPECT_EQ(SavedModelLoadLatencyByStage("/foo", "init_graph").value().num(),
+            0);
+}
+
 TEST(MetricsTest, TestCheckpointRead) {
   EXPECT_EQ(CheckpointReadDuration("foo").value().num(), 0);
   CheckpointReadDuration("foo").Add(100);
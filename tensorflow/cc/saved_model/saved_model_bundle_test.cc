@@ -125,6 +125,22 @@ TEST_F(LoaderTest, ResourceLeakTest) {
   }
 }
 
+TEST_F(LoaderTest, PrefetchVariables) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  setenv("TF_SAVED_MODEL_PREFETCH_VARIABLES", "true", /*overwrite=*/1);
+  const Status status = LoadSavedModel(session_options, run_options,
+                                       export_dir, {kSavedModelTagServe},
+                                       &bundle);
+  unsetenv("TF_SAVED_MODEL_PREFETCH_VARIABLES");
+  TF_ASSERT_OK(status);
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
 TEST_F(LoaderTest, TagMatch) {
   SavedModelBundle bundle;
   SessionOptions session_options;
@@ -385,5 +401,41 @@ TEST_F(LoaderTest, UpdateMetricsV1) {
   EXPECT_EQ(metrics::SavedModelReadApi(kCCLoadLabel).value(), api_count + 1);
 }
 
+TEST_F(LoaderTest, UpdateLoadLatencyByStage) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataPbTxt);
+  const int64_t read_count =
+      metrics::SavedModelLoadLatencyByStage(export_dir, "read_meta_graph")
+          .value()
+          .num();
+  const int64_t restore_count =
+      metrics::SavedModelLoadLatencyByStage(export_dir, "restore_graph")
+          .value()
+          .num();
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+
+  for (const char* stage : {"read_meta_graph", "import_graph", "restore_graph",
+                            "init_graph"}) {
+    EXPECT_GE(metrics::SavedModelLoadLatencyByStage(export_dir, stage)
+                  .value()
+                  .num(),
+              1)
+        << stage;
+  }
+  EXPECT_EQ(metrics::SavedModelLoadLatencyByStage(export_dir, "read_meta_graph")
+                .value()
+                .num(),
+            read_count + 1);
+  EXPECT_EQ(metrics::SavedModelLoadLatencyByStage(export_dir, "restore_graph")
+                .value()
+                .num(),
+            restore_count + 1);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,562 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/tools/memmapped_saved_model.h"
+
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The NoOp that assigns the variables kept in the package their values.
+constexpr char kRestoreOpName[] = "memmapped_package_restore";
+
+// Returns the name of the node that produces `tensor_name`.
+string GetNodeName(const string& tensor_name) {
+  return string(ParseTensorName(tensor_name).node());
+}
+
+bool IsVariable(const NodeDef& node) {
+  return node.op() == "Variable" || node.op() == "VariableV2" ||
+         node.op() == "VarHandleOp";
+}
+
+bool IsResourceVariableRead(const NodeDef& node) {
+  return node.op() == "ReadVariableOp" || node.op() == "ResourceGather";
+}
+
+// Hands out distinct, well-formed region names derived from node and file
+// names.
+class RegionNamer {
+ public:
+  string Name(StringPiece kind, StringPiece name) {
+    string region = strings::StrCat(
+        MemmappedFileSystem::kMemmappedPackagePrefix, kind, ".");
+    for (char c : name) {
+      if (c == '/') {
+        region += '.';
+      } else if (absl::ascii_isalnum(c) || c == '_' || c == '.') {
+        region += c;
+      } else {
+        region += '_';
+      }
+    }
+    string unique_region = region;
+    for (int i = 1; !used_regions_.insert(unique_region).second; ++i) {
+      unique_region = strings::StrCat(region, "_", i);
+    }
+    return unique_region;
+  }
+
+ private:
+  std::unordered_set<string> used_regions_;
+};
+
+// Gets the tensor names of the inputs and outputs of all SignatureDefs.
+void GetSignatureDefsTensorNames(const MetaGraphDef& meta_graph_def,
+                                 std::vector<string>* tensor_names) {
+  auto add_tensor_names = [tensor_names](const TensorInfo& tensor_info) {
+    if (tensor_info.has_coo_sparse()) {
+      const TensorInfo_CooSparse& coo_sparse = tensor_info.coo_sparse();
+      tensor_names->push_back(coo_sparse.values_tensor_name());
+      tensor_names->push_back(coo_sparse.indices_tensor_name());
+      tensor_names->push_back(coo_sparse.dense_shape_tensor_name());
+    } else if (tensor_info.has_composite_tensor()) {
+      for (const auto& component :
+           tensor_info.composite_tensor().components()) {
+        tensor_names->push_back(component.name());
+      }
+    } else {
+      tensor_names->push_back(tensor_info.name());
+    }
+  };
+  for (const auto& sigdef_elem : meta_graph_def.signature_def()) {
+    for (const auto& input_elem : sigdef_elem.second.inputs()) {
+      add_tensor_names(input_elem.second);
+    }
+    for (const auto& output_elem : sigdef_elem.second.outputs()) {
+      add_tensor_names(output_elem.second);
+    }
+  }
+}
+
+// Gets the names of the nodes needed by `targets`.
+Status GetReachableNodes(
+    const std::unordered_map<string, const NodeDef*>& name_to_node,
+    const std::vector<string>& targets,
+    std::unordered_set<string>* reachable_node_names) {
+  std::queue<string> nodes_to_visit;
+  for (const string& target : targets) {
+    nodes_to_visit.push(GetNodeName(target));
+  }
+  while (!nodes_to_visit.empty()) {
+    const string node_name = nodes_to_visit.front();
+    nodes_to_visit.pop();
+    if (!reachable_node_names->insert(node_name).second) {
+      continue;
+    }
+    const auto node_it = name_to_node.find(node_name);
+    if (node_it == name_to_node.end()) {
+      return errors::InvalidArgument("Node ", node_name,
+                                     " is not in the MetaGraphDef");
+    }
+    for (const string& input : node_it->second->input()) {
+      nodes_to_visit.push(GetNodeName(input));
+    }
+  }
+  return Status::OK();
+}
+
+// Gets the variables used by the reachable nodes, and those of them that the
+// reachable nodes may also write: reference variables they take as reference
+// inputs, and resource variables they use other than to read them.
+Status GetVariables(
+    const GraphDef& graph_def,
+    const std::unordered_map<string, const NodeDef*>& name_to_node,
+    const std::unordered_set<string>& reachable_node_names,
+    std::unordered_set<string>* variable_names,
+    std::unordered_set<string>* written_variable_names) {
+  for (const string& node_name : reachable_node_names) {
+    if (IsVariable(*name_to_node.at(node_name))) {
+      variable_names->insert(node_name);
+    }
+  }
+  const FunctionLibraryDefinition flib_def(OpRegistry::Global(),
+                                           graph_def.library());
+  for (const NodeDef& node : graph_def.node()) {
+    if (reachable_node_names.find(node.name()) ==
+        reachable_node_names.end()) {
+      continue;
+    }
+    DataTypeVector input_types;
+    for (int i = 0; i < node.input_size(); ++i) {
+      const TensorId input = ParseTensorName(node.input(i));
+      const string variable_name(input.node());
+      if (input.index() == Graph::kControlSlot ||
+          variable_names->find(variable_name) == variable_names->end()) {
+        continue;
+      }
+      if (name_to_node.at(variable_name)->op() == "VarHandleOp") {
+        if (i != 0 || !IsResourceVariableRead(node)) {
+          written_variable_names->insert(variable_name);
+        }
+        continue;
+      }
+      if (input_types.empty()) {
+        const OpDef* op_def = nullptr;
+        TF_RETURN_IF_ERROR(flib_def.LookUpOpDef(node.op(), &op_def));
+        DataTypeVector output_types;
+        TF_RETURN_IF_ERROR(
+            InOutTypesForNode(node, *op_def, &input_types, &output_types));
+      }
+      if (i >= static_cast<int>(input_types.size()) ||
+          IsRefType(input_types[i])) {
+        written_variable_names->insert(variable_name);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+// Gets a map from variable name to variable value. Resource variables are
+// read by ReadVariableOps added to the session.
+Status GetVariableValues(
+    Session* session,
+    const std::unordered_map<string, const NodeDef*>& name_to_node,
+    const std::unordered_set<string>& variable_names,
+    std::unordered_map<string, Tensor>* variable_values) {
+  if (variable_names.empty()) {
+    return Status::OK();
+  }
+  GraphDef read_ops;
+  std::vector<string> names;
+  std::vector<string> tensor_names;
+  for (const string& variable_name : variable_names) {
+    const NodeDef& variable = *name_to_node.at(variable_name);
+    names.push_back(variable_name);
+    if (variable.op() == "VarHandleOp") {
+      NodeDef* read = read_ops.add_node();
+      read->set_name(strings::StrCat(variable_name, "/memmapped_package_read"));
+      read->set_op("ReadVariableOp");
+      read->set_device(variable.device());
+      read->add_input(variable_name);
+      AddNodeAttr("dtype", variable.attr().at("dtype"), read);
+      tensor_names.push_back(strings::StrCat(read->name(), ":0"));
+    } else {
+      tensor_names.push_back(strings::StrCat(variable_name, ":0"));
+    }
+  }
+  if (read_ops.node_size() > 0) {
+    TF_RETURN_IF_ERROR(session->Extend(read_ops));
+  }
+  std::vector<Tensor> outputs;
+  TF_RETURN_IF_ERROR(
+      session->Run(/* inputs */ {}, tensor_names, /* targets */ {}, &outputs));
+  for (size_t i = 0; i < names.size(); ++i) {
+    (*variable_values)[names[i]] = outputs[i];
+  }
+  return Status::OK();
+}
+
+// Writes graph constants into the package as the nodes are converted.
+class ConstantWriter {
+ public:
+  ConstantWriter(const MemmappedSavedModelOptions& options,
+                 MemmappedFileSystemWriter* writer)
+      : options_(options), writer_(writer) {}
+
+  // Whether `value` is mapped from the package instead of being stored in the
+  // GraphDef. ImmutableConst can only map tensors with a flat, non-empty
+  // buffer.
+  bool IsMemmapped(const Tensor& value) const {
+    if (!DataTypeCanUseMemcpy(value.dtype())) {
+      return false;
+    }
+    const size_t bytes = value.tensor_data().size();
+    return bytes > 0 &&
+           static_cast<int64_t>(bytes) >= options_.min_memmapped_tensor_bytes;
+  }
+
+  // Converts `node` into a constant with `value`.
+  Status MakeConstant(const string& name, const Tensor& value, NodeDef* node) {
+    node->set_name(name);
+    AddNodeAttr("dtype", value.dtype(), node);
+    if (!IsMemmapped(value)) {
+      node->set_op("Const");
+      AddNodeAttr("value", value, node);
+      return Status::OK();
+    }
+    const string region = region_namer_.Name("tensor", name);
+    TF_RETURN_IF_ERROR(writer_->SaveTensor(value, region));
+    node->set_op("ImmutableConst");
+    AddNodeAttr("shape", value.shape(), node);
+    AddNodeAttr("memory_region_name", region, node);
+    return Status::OK();
+  }
+
+  // Saves the contents of an asset file, returning its packaged filename.
+  Status SaveAsset(const string& filename, const string& path,
+                   string* packaged_filename) {
+    string contents;
+    TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path, &contents));
+    *packaged_filename = region_namer_.Name("asset", filename);
+    return writer_->SaveFile(contents, *packaged_filename);
+  }
+
+ private:
+  const MemmappedSavedModelOptions options_;
+  MemmappedFileSystemWriter* const writer_;
+  RegionNamer region_namer_;
+};
+
+// Converts a ReadVariableOp of a frozen variable into an Identity.
+void ConvertReadVariableOpToIdentity(const NodeDef& node,
+                                     NodeDef* identity_node) {
+  identity_node->set_name(node.name());
+  identity_node->set_op("Identity");
+  identity_node->set_device(node.device());
+  *identity_node->mutable_input() = node.input();
+  AddNodeAttr("T", node.attr().at("dtype"), identity_node);
+}
+
+// Converts a ResourceGather of a frozen variable into a GatherV2 with a
+// constant axis.
+void ConvertResourceGatherToGatherV2(const NodeDef& node, NodeDef* gather_node,
+                                     NodeDef* axis_node) {
+  int batch_dims = 0;
+  if (node.attr().count("batch_dims")) {
+    batch_dims = node.attr().at("batch_dims").i();
+  }
+  axis_node->set_name(strings::StrCat(node.name(), "/axis"));
+  axis_node->set_op("Const");
+  AddNodeAttr("dtype", DT_INT32, axis_node);
+  AddNodeAttr("value", Tensor(batch_dims), axis_node);
+
+  gather_node->set_name(node.name());
+  gather_node->set_op("GatherV2");
+  gather_node->set_device(node.device());
+  gather_node->add_input(node.input(0));
+  gather_node->add_input(node.input(1));
+  gather_node->add_input(axis_node->name());
+  for (int i = 2; i < node.input_size(); ++i) {
+    gather_node->add_input(node.input(i));
+  }
+  AddNodeAttr("Tparams", node.attr().at("dtype"), gather_node);
+  AddNodeAttr("Tindices", node.attr().at("Tindices"), gather_node);
+  AddNodeAttr("Taxis", DT_INT32, gather_node);
+  AddNodeAttr("batch_dims", batch_dims, gather_node);
+}
+
+// Adds an op that assigns the written `variable` its current `value` from
+// the package to `restore_nodes`, and returns its name.
+Status AddVariableRestore(const NodeDef& variable, const Tensor& value,
+                          ConstantWriter* constant_writer,
+                          GraphDef* restore_nodes, string* assign_name) {
+  NodeDef* value_node = restore_nodes->add_node();
+  TF_RETURN_IF_ERROR(constant_writer->MakeConstant(
+      strings::StrCat(variable.name(), "/memmapped_package_value"), value,
+      value_node));
+  NodeDef* assign = restore_nodes->add_node();
+  assign->set_name(
+      strings::StrCat(variable.name(), "/memmapped_package_assign"));
+  assign->set_device(variable.device());
+  assign->add_input(variable.name());
+  assign->add_input(value_node->name());
+  if (variable.op() == "VarHandleOp") {
+    assign->set_op("AssignVariableOp");
+    AddNodeAttr("dtype", value.dtype(), assign);
+  } else {
+    assign->set_op("Assign");
+    AddNodeAttr("T", value.dtype(), assign);
+    AddNodeAttr("validate_shape", true, assign);
+    AddNodeAttr("use_locking", true, assign);
+  }
+  *assign_name = assign->name();
+  return Status::OK();
+}
+
+// Converts the subgraph of all nodes needed by `targets` into
+// `package_graph_def`, whose constants are written by `constant_writer`.
+Status ConvertGraphDef(const SavedModelBundle& saved_model_bundle,
+                       const std::vector<string>& targets,
+                       const std::unordered_map<string, string>& asset_files,
+                       ConstantWriter* constant_writer,
+                       GraphDef* package_graph_def,
+                       bool* has_restore_op) {
+  const GraphDef& graph_def = saved_model_bundle.meta_graph_def.graph_def();
+  // Copy versions and library as-is from original graph.
+  *package_graph_def->mutable_versions() = graph_def.versions();
+  *package_graph_def->mutable_library() = graph_def.library();
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : graph_def.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  std::unordered_set<string> reachable_node_names;
+  TF_RETURN_IF_ERROR(
+      GetReachableNodes(name_to_node, targets, &reachable_node_names));
+  std::unordered_set<string> variable_names;
+  std::unordered_set<string> written_variable_names;
+  TF_RETURN_IF_ERROR(GetVariables(graph_def, name_to_node,
+                                  reachable_node_names, &variable_names,
+                                  &written_variable_names));
+  std::unordered_map<string, Tensor> variable_values;
+  TF_RETURN_IF_ERROR(GetVariableValues(saved_model_bundle.session.get(),
+                                       name_to_node, variable_names,
+                                       &variable_values));
+  auto is_frozen = [&](const string& tensor_name) {
+    const string node_name = GetNodeName(tensor_name);
+    return variable_names.find(node_name) != variable_names.end() &&
+           written_variable_names.find(node_name) ==
+               written_variable_names.end();
+  };
+
+  GraphDef restore_nodes;
+  NodeDef restore_op;
+  restore_op.set_name(kRestoreOpName);
+  restore_op.set_op("NoOp");
+  // We copy the nodes in the same order they were in the original graph_def.
+  for (const NodeDef& node : graph_def.node()) {
+    if (reachable_node_names.find(node.name()) ==
+        reachable_node_names.end()) {
+      continue;
+    }
+    const auto asset_it = asset_files.find(node.name());
+    if (asset_it != asset_files.end()) {
+      // The asset filename becomes the file in the package.
+      NodeDef* filename_node = package_graph_def->add_node();
+      filename_node->set_name(node.name());
+      filename_node->set_op("Const");
+      AddNodeAttr("dtype", DT_STRING, filename_node);
+      AddNodeAttr("value", Tensor(tstring(asset_it->second)), filename_node);
+    } else if (written_variable_names.find(node.name()) !=
+               written_variable_names.end()) {
+      *package_graph_def->add_node() = node;
+      string assign_name;
+      TF_RETURN_IF_ERROR(AddVariableRestore(
+          node, variable_values.at(node.name()), constant_writer,
+          &restore_nodes, &assign_name));
+      restore_op.add_input(strings::StrCat("^", assign_name));
+    } else if (variable_names.find(node.name()) != variable_names.end()) {
+      TF_RETURN_IF_ERROR(constant_writer->MakeConstant(
+          node.name(), variable_values.at(node.name()),
+          package_graph_def->add_node()));
+    } else if (node.op() == "ReadVariableOp" && is_frozen(node.input(0))) {
+      ConvertReadVariableOpToIdentity(node, package_graph_def->add_node());
+    } else if (node.op() == "ResourceGather" && is_frozen(node.input(0))) {
+      NodeDef* gather_node = package_graph_def->add_node();
+      ConvertResourceGatherToGatherV2(node, gather_node,
+                                      package_graph_def->add_node());
+    } else if (node.op() == "Const") {
+      Tensor value;
+      TF_RETURN_IF_ERROR(GetNodeAttr(node, "value", &value));
+      if (constant_writer->IsMemmapped(value)) {
+        NodeDef* const_node = package_graph_def->add_node();
+        TF_RETURN_IF_ERROR(
+            constant_writer->MakeConstant(node.name(), value, const_node));
+        *const_node->mutable_input() = node.input();
+      } else {
+        *package_graph_def->add_node() = node;
+      }
+    } else {
+      // If the node doesn't need converting, just copy the node as-is.
+      *package_graph_def->add_node() = node;
+    }
+  }
+  *has_restore_op = restore_op.input_size() > 0;
+  if (*has_restore_op) {
+    for (const NodeDef& node : restore_nodes.node()) {
+      *package_graph_def->add_node() = node;
+    }
+    *package_graph_def->add_node() = restore_op;
+  }
+  return Status::OK();
+}
+
+Status RunTarget(const RunOptions& run_options, const string& target,
+                 Session* session) {
+  RunMetadata run_metadata;
+  return session->Run(run_options, /* inputs */ {}, /* output_names */ {},
+                      {target}, /* outputs */ nullptr, &run_metadata);
+}
+
+}  // namespace
+
+Status ConvertSavedModelToMemmappedPackage(
+    const SavedModelBundle& saved_model_bundle, const string& export_dir,
+    const string& package_filename,
+    const MemmappedSavedModelOptions& options) {
+  const MetaGraphDef& meta_graph_def = saved_model_bundle.meta_graph_def;
+  std::vector<string> targets;
+  GetSignatureDefsTensorNames(meta_graph_def, &targets);
+  string init_op_name;
+  TF_RETURN_IF_ERROR(
+      internal::GetInitOp(export_dir, meta_graph_def, &init_op_name));
+  if (!init_op_name.empty()) {
+    targets.push_back(init_op_name);
+  }
+
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(Env::Default(), package_filename));
+  ConstantWriter constant_writer(options, &writer);
+  std::vector<AssetFileDef> asset_file_defs;
+  TF_RETURN_IF_ERROR(
+      internal::GetAssetFileDefs(meta_graph_def, &asset_file_defs));
+  std::unordered_map<string, string> asset_files;
+  for (const AssetFileDef& asset_file_def : asset_file_defs) {
+    const string path = io::JoinPath(export_dir, kSavedModelAssetsDirectory,
+                                     asset_file_def.filename());
+    string packaged_filename;
+    TF_RETURN_IF_ERROR(constant_writer.SaveAsset(asset_file_def.filename(),
+                                                 path, &packaged_filename));
+    asset_files[GetNodeName(asset_file_def.tensor_info().name())] =
+        packaged_filename;
+  }
+
+  MetaGraphDef package_meta_graph_def;
+  bool has_restore_op = false;
+  TF_RETURN_IF_ERROR(ConvertGraphDef(
+      saved_model_bundle, targets, asset_files, &constant_writer,
+      package_meta_graph_def.mutable_graph_def(), &has_restore_op));
+  *package_meta_graph_def.mutable_meta_info_def() =
+      meta_graph_def.meta_info_def();
+  // The converted graph uses ops the stripped op list may not have.
+  package_meta_graph_def.mutable_meta_info_def()->clear_stripped_op_list();
+  *package_meta_graph_def.mutable_signature_def() =
+      meta_graph_def.signature_def();
+  if (!init_op_name.empty()) {
+    SignatureDef init_op_signature;
+    (*init_op_signature.mutable_outputs())[kSavedModelInitOpSignatureKey]
+        .set_name(init_op_name);
+    (*package_meta_graph_def
+          .mutable_signature_def())[kSavedModelInitOpSignatureKey] =
+        init_op_signature;
+  }
+  if (has_restore_op) {
+    package_meta_graph_def.mutable_saver_def()->set_restore_op_name(
+        kRestoreOpName);
+  }
+  TF_RETURN_IF_ERROR(writer.SaveProtobuf(package_meta_graph_def,
+                                         kMemmappedSavedModelMetaGraphDef));
+  return writer.FlushAndClose();
+}
+
+MemmappedSavedModelBundle::~MemmappedSavedModelBundle() {
+  if (session) {
+    session->Close().IgnoreError();
+  }
+}
+
+Status LoadMemmappedSavedModel(const SessionOptions& session_options,
+                               const RunOptions& run_options,
+                               const string& package_filename,
+                               MemmappedSavedModelBundle* bundle) {
+  bundle->env.reset(new MemmappedEnv(session_options.env));
+  TF_RETURN_IF_ERROR(bundle->env->InitializeFromFile(package_filename));
+  TF_RETURN_IF_ERROR(ReadBinaryProto(bundle->env.get(),
+                                     kMemmappedSavedModelMetaGraphDef,
+                                     &bundle->meta_graph_def));
+  SessionOptions options = session_options;
+  options.env = bundle->env.get();
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  Session* session = nullptr;
+  TF_RETURN_IF_ERROR(NewSession(options, &session));
+  bundle->session.reset(session);
+  TF_RETURN_IF_ERROR(
+      bundle->session->Create(bundle->meta_graph_def.graph_def()));
+  // Variables are assigned their values before the init op runs, as they are
+  // restored before it by the SavedModel loader.
+  const string& restore_op_name =
+      bundle->meta_graph_def.saver_def().restore_op_name();
+  if (!restore_op_name.empty()) {
+    TF_RETURN_IF_ERROR(
+        RunTarget(run_options, restore_op_name, bundle->session.get()));
+  }
+  string init_op_name;
+  TF_RETURN_IF_ERROR(internal::GetInitOp(
+      package_filename, bundle->meta_graph_def, &init_op_name));
+  if (!init_op_name.empty()) {
+    TF_RETURN_IF_ERROR(
+        RunTarget(run_options, init_op_name, bundle->session.get()));
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,84 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_TOOLS_MEMMAPPED_SAVED_MODEL_H_
+#define TENSORFLOW_CC_TOOLS_MEMMAPPED_SAVED_MODEL_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+
+namespace tensorflow {
+
+// The region of a memmapped SavedModel package that holds its MetaGraphDef.
+constexpr char kMemmappedSavedModelMetaGraphDef[] =
+    "memmapped_package://saved_model.meta_graph_def";
+
+struct MemmappedSavedModelOptions {
+  // Constants and variables of fewer bytes stay in the GraphDef instead of
+  // being memory-mapped from the package.
+  int64_t min_memmapped_tensor_bytes = 1024;
+};
+
+// Converts the MetaGraphDef of `saved_model_bundle`, loaded from `export_dir`,
+// into one memmapped package at `package_filename`, which
+// LoadMemmappedSavedModel() loads without copying its constants.
+//
+// The package keeps the nodes needed by the SignatureDefs and the init op.
+// Variables that those nodes only read are frozen to their values, and
+// constants of at least `options.min_memmapped_tensor_bytes` bytes become
+// ImmutableConst nodes of tensors in the package. Variables that they write,
+// such as the state of an init op, stay variables and are assigned their
+// values from the package by the init op. Assets are copied into the package,
+// and their filename tensors set to the packaged files.
+Status ConvertSavedModelToMemmappedPackage(
+    const SavedModelBundle& saved_model_bundle, const string& export_dir,
+    const string& package_filename,
+    const MemmappedSavedModelOptions& options = MemmappedSavedModelOptions());
+
+// A SavedModel loaded from a memmapped package. The package stays mapped for
+// as long as the bundle exists.
+struct MemmappedSavedModelBundle : public SavedModelBundleInterface {
+  ~MemmappedSavedModelBundle() override;
+
+  Session* GetSession() const override { return session.get(); }
+  const protobuf::Map<string, SignatureDef>& GetSignatures() const override {
+    return meta_graph_def.signature_def();
+  }
+
+  // Declared before `session`, which reads the package through it.
+  std::unique_ptr<MemmappedEnv> env;
+  std::unique_ptr<Session> session;
+  MetaGraphDef meta_graph_def;
+};
+
+// Loads a package written by ConvertSavedModelToMemmappedPackage() and runs
+// its init op. The session reads the package through a MemmappedEnv wrapping
+// `session_options.env`, and runs with graph optimizations at level L0, since
+// constant folding would copy the memory-mapped tensors.
+Status LoadMemmappedSavedModel(const SessionOptions& session_options,
+                               const RunOptions& run_options,
+                               const string& package_filename,
+                               MemmappedSavedModelBundle* bundle);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_TOOLS_MEMMAPPED_SAVED_MODEL_H_
@@ -0,0 +1,100 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// This program converts a SavedModel into a memmapped package, which
+// LoadMemmappedSavedModel() loads for serving without copying its constants
+// and variables into the heap. To use it, run something like this:
+//
+// bazel build tensorflow/cc/tools:convert_saved_model_to_memmapped_package
+// bazel-bin/tensorflow/cc/tools/convert_saved_model_to_memmapped_package \
+// --export_dir=/path/to/saved_model --out_package=model.mmap
+
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/cc/tools/memmapped_saved_model.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+int ParseFlagsAndConvertSavedModel(int argc, char* argv[]) {
+  string export_dir = "";
+  string tags = kSavedModelTagServe;
+  string out_package = "";
+  int64_t min_memmapped_tensor_bytes =
+      MemmappedSavedModelOptions().min_memmapped_tensor_bytes;
+  std::vector<Flag> flag_list = {
+      Flag("export_dir", &export_dir, "SavedModel directory to convert"),
+      Flag("tags", &tags, "comma separated tags of the MetaGraphDef to load"),
+      Flag("out_package", &out_package, "memmapped package file name"),
+      Flag("min_memmapped_tensor_bytes", &min_memmapped_tensor_bytes,
+           "smallest constant, in bytes, to map from the package"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (!parse_result) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << ".\n" << usage;
+    return -1;
+  }
+  if (export_dir.empty() || out_package.empty()) {
+    LOG(ERROR) << "export_dir and out_package can't be empty.\n" << usage;
+    return -1;
+  }
+
+  const std::vector<string> tag_list = str_util::Split(tags, ',');
+  SavedModelBundle saved_model_bundle;
+  Status load_status = LoadSavedModel(
+      SessionOptions(), RunOptions(), export_dir,
+      std::unordered_set<string>(tag_list.begin(), tag_list.end()),
+      &saved_model_bundle);
+  if (!load_status.ok()) {
+    LOG(ERROR) << "Loading SavedModel '" << export_dir << "' failed with "
+               << load_status.error_message();
+    return -1;
+  }
+
+  MemmappedSavedModelOptions options;
+  options.min_memmapped_tensor_bytes = min_memmapped_tensor_bytes;
+  Status convert_status = ConvertSavedModelToMemmappedPackage(
+      saved_model_bundle, export_dir, out_package, options);
+  if (!convert_status.ok()) {
+    LOG(ERROR) << "Converting SavedModel '" << export_dir << "' failed with "
+               << convert_status.error_message();
+    return -1;
+  }
+  LOG(INFO) << "Converted " << export_dir << " to " << out_package;
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::ParseFlagsAndConvertSavedModel(argc, argv);
+}
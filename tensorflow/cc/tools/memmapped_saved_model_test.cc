@@ -0,0 +1,228 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/tools/memmapped_saved_model.h"
+
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestData[] = "cc/saved_model/testdata/half_plus_two/00000123";
+
+class MemmappedSavedModelTest : public ::testing::Test {
+ protected:
+  MemmappedSavedModelTest()
+      : export_dir_(io::JoinPath(testing::TensorFlowSrcRoot(), kTestData)),
+        package_filename_(
+            io::JoinPath(testing::TmpDir(), "memmapped_saved_model")) {}
+
+  // Converts the half plus two SavedModel and loads the package.
+  void ConvertAndLoadHalfPlusTwo(const MemmappedSavedModelOptions& options,
+                                 MemmappedSavedModelBundle* bundle) {
+    SavedModelBundle saved_model_bundle;
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                                {kSavedModelTagServe}, &saved_model_bundle));
+    TF_ASSERT_OK(ConvertSavedModelToMemmappedPackage(
+        saved_model_bundle, export_dir_, package_filename_, options));
+    TF_ASSERT_OK(LoadMemmappedSavedModel(SessionOptions(), RunOptions(),
+                                         package_filename_, bundle));
+  }
+
+  const NodeDef* FindNode(const MemmappedSavedModelBundle& bundle,
+                          const string& name) {
+    for (const NodeDef& node : bundle.meta_graph_def.graph_def().node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  void CheckHalfPlusTwo(const MemmappedSavedModelBundle& bundle) {
+    const SignatureDef& signature_def =
+        bundle.GetSignatures().at("regress_x_to_y");
+    const string input_name = signature_def.inputs().at(kRegressInputs).name();
+    const string output_name =
+        signature_def.outputs().at(kRegressOutputs).name();
+    std::vector<tstring> serialized_examples;
+    for (float x : {0, 1, 2, 3}) {
+      Example example;
+      (*example.mutable_features()->mutable_feature())["x"]
+          .mutable_float_list()
+          ->add_value(x);
+      serialized_examples.push_back(example.SerializeAsString());
+    }
+    Tensor input =
+        test::AsTensor<tstring>(serialized_examples, TensorShape({4}));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(bundle.GetSession()->Run({{input_name, input}},
+                                          {output_name}, {}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    test::ExpectTensorEqual<float>(
+        outputs[0],
+        test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+  }
+
+  const string export_dir_;
+  const string package_filename_;
+};
+
+TEST_F(MemmappedSavedModelTest, HalfPlusTwo) {
+  MemmappedSavedModelOptions options;
+  options.min_memmapped_tensor_bytes = 0;
+  MemmappedSavedModelBundle bundle;
+  ConvertAndLoadHalfPlusTwo(options, &bundle);
+  CheckHalfPlusTwo(bundle);
+
+  // The variables the regression reads are mapped from the package.
+  for (const string& name : {"a", "b", "c"}) {
+    const NodeDef* node = FindNode(bundle, name);
+    ASSERT_NE(node, nullptr) << name;
+    EXPECT_EQ(node->op(), "ImmutableConst") << name;
+  }
+  // The variable the init op assigns stays a variable.
+  const NodeDef* filename_tensor = FindNode(bundle, "filename_tensor");
+  ASSERT_NE(filename_tensor, nullptr);
+  EXPECT_EQ(filename_tensor->op(), "VariableV2");
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(
+      bundle.GetSession()->Run({}, {"filename_tensor:0"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<tstring>(
+      outputs[0], test::AsTensor<tstring>({"foo.txt"}, TensorShape({})));
+  // The saver isn't needed by the signatures or the init op.
+  EXPECT_EQ(FindNode(bundle, "save/restore_all"), nullptr);
+}
+
+TEST_F(MemmappedSavedModelTest, KeepsSmallTensorsInGraphDef) {
+  MemmappedSavedModelBundle bundle;
+  ConvertAndLoadHalfPlusTwo(MemmappedSavedModelOptions(), &bundle);
+  CheckHalfPlusTwo(bundle);
+
+  const NodeDef* a = FindNode(bundle, "a");
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a->op(), "Const");
+}
+
+TEST_F(MemmappedSavedModelTest, PackagesAssets) {
+  MemmappedSavedModelBundle bundle;
+  ConvertAndLoadHalfPlusTwo(MemmappedSavedModelOptions(), &bundle);
+
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(bundle.env.get(),
+                                "memmapped_package://asset.foo.txt",
+                                &contents));
+  EXPECT_EQ(contents, "asset-file-contents");
+}
+
+TEST_F(MemmappedSavedModelTest, ResourceVariables) {
+  Scope scope = Scope::NewRootScope();
+  Output weights =
+      ops::VarHandleOp(scope.WithOpName("weights"), DT_FLOAT, {4});
+  auto init_weights = ops::AssignVariableOp(
+      scope.WithOpName("init_weights"), weights,
+      ops::Const(scope.WithOpName("initial_weights"), {1.0f, 2.0f, 3.0f, 4.0f},
+                 {4}));
+  Output counter = ops::VarHandleOp(scope.WithOpName("counter"), DT_INT64, {});
+  auto init_counter = ops::AssignVariableOp(
+      scope.WithOpName("init_counter"), counter,
+      ops::Const<int64_t>(scope.WithOpName("initial_counter"), 5, {}));
+  ops::NoOp init(scope.WithOpName("init").WithControlDependencies(
+      {init_weights, init_counter}));
+
+  Output read_weights = ops::ReadVariableOp(scope.WithOpName("read_weights"),
+                                            weights, DT_FLOAT);
+  Output doubled_weights = ops::Mul(scope.WithOpName("doubled_weights"),
+                                    read_weights, 2.0f);
+  Output gathered_weights = ops::ResourceGather(
+      scope.WithOpName("gathered_weights"), weights,
+      ops::Const(scope.WithOpName("indices"), {3, 1}, {2}), DT_FLOAT);
+  auto increment = ops::AssignAddVariableOp(
+      scope.WithOpName("increment"), counter,
+      ops::Const<int64_t>(scope.WithOpName("one"), 1, {}));
+  Output count =
+      ops::ReadVariableOp(scope.WithOpName("count").WithControlDependencies(
+                              {increment}),
+                          counter, DT_INT64);
+
+  SavedModelBundle saved_model_bundle;
+  TF_ASSERT_OK(
+      scope.ToGraphDef(saved_model_bundle.meta_graph_def.mutable_graph_def()));
+  SignatureDef& signature_def =
+      (*saved_model_bundle.meta_graph_def.mutable_signature_def())["serving"];
+  (*signature_def.mutable_outputs())["doubled"].set_name("doubled_weights:0");
+  (*signature_def.mutable_outputs())["gathered"].set_name(
+      "gathered_weights:0");
+  (*signature_def.mutable_outputs())["count"].set_name("count:0");
+  saved_model_bundle.session.reset(NewSession(SessionOptions()));
+  TF_ASSERT_OK(saved_model_bundle.session->Create(
+      saved_model_bundle.meta_graph_def.graph_def()));
+  TF_ASSERT_OK(saved_model_bundle.session->Run({}, {}, {"init"}, nullptr));
+
+  MemmappedSavedModelOptions options;
+  options.min_memmapped_tensor_bytes = 0;
+  TF_ASSERT_OK(ConvertSavedModelToMemmappedPackage(
+      saved_model_bundle, /*export_dir=*/"", package_filename_, options));
+  MemmappedSavedModelBundle bundle;
+  TF_ASSERT_OK(LoadMemmappedSavedModel(SessionOptions(), RunOptions(),
+                                       package_filename_, &bundle));
+
+  // The weights are only read, so they are mapped from the package, while
+  // the counter is incremented and stays a variable.
+  const NodeDef* weights_node = FindNode(bundle, "weights");
+  ASSERT_NE(weights_node, nullptr);
+  EXPECT_EQ(weights_node->op(), "ImmutableConst");
+  const NodeDef* counter_node = FindNode(bundle, "counter");
+  ASSERT_NE(counter_node, nullptr);
+  EXPECT_EQ(counter_node->op(), "VarHandleOp");
+  // The initializers aren't needed by the signature.
+  EXPECT_EQ(FindNode(bundle, "init"), nullptr);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.GetSession()->Run(
+      {}, {"doubled_weights:0", "gathered_weights:0", "count:0"}, {},
+      &outputs));
+  ASSERT_EQ(outputs.size(), 3);
+  test::ExpectTensorEqual<float>(
+      outputs[0], test::AsTensor<float>({2.0f, 4.0f, 6.0f, 8.0f}, {4}));
+  test::ExpectTensorEqual<float>(outputs[1],
+                                 test::AsTensor<float>({4.0f, 2.0f}, {2}));
+  test::ExpectTensorEqual<int64_t>(outputs[2],
+                                   test::AsTensor<int64_t>({6}, {}));
+}
+
+TEST_F(MemmappedSavedModelTest, LoadFailsForMissingPackage) {
+  MemmappedSavedModelBundle bundle;
+  EXPECT_FALSE(LoadMemmappedSavedModel(
+                   SessionOptions(), RunOptions(),
+                   io::JoinPath(testing::TmpDir(), "missing_package"), &bundle)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
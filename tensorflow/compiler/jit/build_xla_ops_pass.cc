@@ -18,6 +18,7 @@ limitations under the License.
 #include "absl/algorithm/container.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/framework/scope_internal.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/device_util.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/cc/ops/xla_jit_ops.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
@@ -463,11 +465,41 @@ Status PredicateInt32Inputs(const Scope& root, Node* n,
   return Status::OK();
 }
 
+// Returns the shapes of the non-constant inputs of a cluster if the cluster can
+// be compiled before it first runs, i.e. it has no compile-time constant or
+// resource inputs and all its inputs have static, non-empty shapes.
+absl::optional<std::vector<TensorShape>> GetPrecompileArgShapes(
+    const XlaClusterInfo& cluster_info, const GraphShapeInfo& shape_info) {
+  if (!cluster_info.constant_inputs.empty() ||
+      !cluster_info.resource_inputs.empty()) {
+    return absl::nullopt;
+  }
+  std::vector<TensorShape> arg_shapes;
+  for (const Output& input : cluster_info.non_constant_inputs) {
+    auto it = shape_info.find(input.node()->name());
+    if (it == shape_info.end() ||
+        input.index() >= static_cast<int>(it->second.size())) {
+      return absl::nullopt;
+    }
+    const PartialTensorShape& shape = it->second[input.index()].shape;
+    TensorShape static_shape;
+    // Empty tensors are passed to the compiler as constants, so they are part
+    // of the cache key.
+    if (!shape.AsTensorShape(&static_shape) ||
+        static_shape.num_elements() == 0) {
+      return absl::nullopt;
+    }
+    arg_shapes.push_back(static_shape);
+  }
+  return arg_shapes;
+}
+
 Status ReplaceNodeWithXlaCompileAndXlaRun(
     jit::DeviceInfoCache* device_info_cache,
     const GraphOptimizationPassOptions& options,
     const FunctionLibraryDefinition& flib_def, bool lazy_compilation_enabled,
-    const DebuggingOpts& debugging_opts, Graph* g, Node* n) {
+    const DebuggingOpts& debugging_opts, const GraphShapeInfo* shape_info,
+    Graph* g, Node* n) {
   XlaClusterInfo cluster_info;
   TF_RETURN_IF_ERROR(GetXlaClusterInfo(n, &cluster_info));
 
@@ -502,6 +534,17 @@ Status ReplaceNodeWithXlaCompileAndXlaRun(
   TF_RETURN_IF_ERROR(
       GetNodeAttr(n->attrs(), kXlaHasReferenceVarsAttr, &has_ref_attr));
   xla_compile.operation.node()->AddAttr(kXlaHasReferenceVarsAttr, has_ref_attr);
+  // Only lazily compiled clusters have a fallback to run while they compile.
+  if (shape_info != nullptr && !requires_compilation) {
+    absl::optional<std::vector<TensorShape>> arg_shapes =
+        GetPrecompileArgShapes(cluster_info, *shape_info);
+    if (arg_shapes) {
+      VLOG(2) << "Compiling " << cluster_info.function.name()
+              << " before its first execution.";
+      xla_compile.operation.node()->AddAttr(kXlaPrecompileArgShapesAttr,
+                                            *arg_shapes);
+    }
+  }
   TF_RETURN_IF_ERROR(
       CopyIncomingControlEdges(g, /*from=*/n, /*to=*/xla_compile.key.node()));
 
@@ -604,10 +647,27 @@ Status BuildXlaOpsPass::Run(const GraphOptimizationPassOptions& options) {
   VLOG(1) << "check_input_numerics = " << debugging_opts.check_input_numerics;
   VLOG(1) << "check_output_numerics = " << debugging_opts.check_output_numerics;
 
+  // The shapes are inferred before the clusters are rewritten, while their
+  // inputs are still wired to the original nodes.
+  GraphShapeInfo shape_info;
+  bool precompile_clusters = lazy_compilation_enabled &&
+                             flags.tf_xla_parallel_first_step_compilation &&
+                             !xla_compiled_kernels.empty();
+  if (precompile_clusters) {
+    Status status = InferShapes(graph, /*arg_shapes=*/{}, options.flib_def,
+                                &shape_info);
+    if (!status.ok()) {
+      VLOG(1) << "Not compiling clusters before their first execution: "
+              << status;
+      precompile_clusters = false;
+    }
+  }
+
   for (Node* n : xla_compiled_kernels) {
     TF_RETURN_IF_ERROR(ReplaceNodeWithXlaCompileAndXlaRun(
         &device_info_cache, options, *options.flib_def,
-        lazy_compilation_enabled, debugging_opts, graph, n));
+        lazy_compilation_enabled, debugging_opts,
+        precompile_clusters ? &shape_info : nullptr, graph, n));
   }
 
   if (VLOG_IS_ON(1)) {
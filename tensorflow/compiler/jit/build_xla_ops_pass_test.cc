@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
 #include "tensorflow/compiler/jit/test_util.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -258,6 +259,61 @@ TEST_F(BuildXlaOpsTest, NoExtraMergeForEdgeToSink) {
                                 NodeWith(Op("NoOp")))));
 }
 
+FunctionDefLibrary CreateFunctionDefLibWithFloatIdentity(const string& name) {
+  FunctionDefLibrary fdef_lib;
+  FunctionDef func = FunctionDefHelper::Create(
+      /*function_name=*/name, /*in_def=*/{"in: float"},
+      /*out_def=*/{"out: float"},
+      /*attr_def=*/{}, /*node_def=*/{{{"out"}, "Identity", {"in"}}},
+      /*ret_def=*/{{"out", "out:output:0"}});
+  *fdef_lib.add_function() = std::move(func);
+  return fdef_lib;
+}
+
+TEST_F(BuildXlaOpsTest, PrecompileStaticallyShapedClusters) {
+  BuildXlaOpsPassFlags* flags = GetBuildXlaOpsPassFlags();
+  flags->tf_xla_parallel_first_step_compilation = true;
+
+  Scope root = Scope::NewRootScope().ExitOnError();
+  FunctionDefLibrary fdef_lib =
+      CreateFunctionDefLibWithFloatIdentity("cluster_identity");
+  TF_ASSERT_OK(root.graph()->AddFunctionLibrary(fdef_lib));
+
+  Output static_input =
+      ops::Const(root.WithOpName("static_input"), {1.0f, 2.0f});
+  Output dynamic_input =
+      ops::Placeholder(root.WithOpName("dynamic_input"), DT_FLOAT);
+  Node* static_call;
+  TF_ASSERT_OK(MakeXlaCompiledKernel(root.graph(), "cluster_identity",
+                                     "static_call", &static_call));
+  static_call->AddAttr(kXlaHasReferenceVarsAttr, false);
+  root.graph()->AddEdge(static_input.node(), 0, static_call, 0);
+  Node* dynamic_call;
+  TF_ASSERT_OK(MakeXlaCompiledKernel(root.graph(), "cluster_identity",
+                                     "dynamic_call", &dynamic_call));
+  dynamic_call->AddAttr(kXlaHasReferenceVarsAttr, false);
+  root.graph()->AddEdge(dynamic_input.node(), 0, dynamic_call, 0);
+
+  std::unique_ptr<Graph> graph;
+  Status status = BuildXlaOps(root, fdef_lib, &graph);
+  flags->tf_xla_parallel_first_step_compilation = false;
+  TF_ASSERT_OK(status);
+
+  Node* static_compile = FindNodeByName(graph.get(), "static_call/xla_compile");
+  ASSERT_NE(static_compile, nullptr);
+  std::vector<TensorShape> arg_shapes;
+  TF_ASSERT_OK(GetNodeAttr(static_compile->attrs(), kXlaPrecompileArgShapesAttr,
+                           &arg_shapes));
+  ASSERT_EQ(arg_shapes.size(), 1);
+  EXPECT_EQ(arg_shapes[0], TensorShape({2}));
+
+  Node* dynamic_compile =
+      FindNodeByName(graph.get(), "dynamic_call/xla_compile");
+  ASSERT_NE(dynamic_compile, nullptr);
+  EXPECT_FALSE(HasNodeAttr(dynamic_compile->def(),
+                           kXlaPrecompileArgShapesAttr));
+}
+
 #ifdef GOOGLE_CUDA
 FunctionDefLibrary CreateFunctionDefLibWithInt32Input(const string& name) {
   FunctionDefLibrary fdef_lib;
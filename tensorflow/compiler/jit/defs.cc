@@ -30,4 +30,7 @@ const char* const kXlaInternalScopeAttr = "_XlaInternalScope";
 
 const char* const kXlaClusterIdAttr = "_xla_compile_id";
 
+// Set by BuildXlaOpsPass when tf_xla_parallel_first_step_compilation is on.
+const char* const kXlaPrecompileArgShapesAttr = "_XlaPrecompileArgShapes";
+
 }  // namespace tensorflow
@@ -38,6 +38,11 @@ extern const char* const kXlaInternalScopeAttr;  // "_XlaInternalScope"
 // The id of the compiled cluster.
 extern const char* const kXlaClusterIdAttr;  // "_xla_compile_id"
 
+// The static shapes of the non-constant arguments of an _XlaCompile node whose
+// cluster is compiled before its first execution.
+extern const char* const kXlaPrecompileArgShapesAttr;
+// "_XlaPrecompileArgShapes"
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_COMPILER_JIT_DEFS_H_
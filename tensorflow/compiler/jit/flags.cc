@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/flags.h"
 
+#include <algorithm>
 #include <mutex>  // NOLINT
 
 #include "absl/base/call_once.h"
@@ -140,6 +141,7 @@ void AllocateAndParseFlags() {
   build_ops_flags->tf_xla_check_cluster_input_numerics = false;
   build_ops_flags->tf_xla_check_cluster_output_numerics = false;
   build_ops_flags->tf_xla_disable_constant_folding = false;
+  build_ops_flags->tf_xla_parallel_first_step_compilation = false;
 
   mark_for_compilation_flags = new MarkForCompilationPassFlags;
   mark_for_compilation_flags->xla_auto_jit_flag.optimization_level_single_gpu =
@@ -164,6 +166,8 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_persistent_cache_directory = "";
+  ops_flags->tf_xla_log_recompiled_clusters = 0;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -186,6 +190,23 @@ void AllocateAndParseFlags() {
     return true;
   };
 
+  auto setter_for_shape_bucket_boundaries = [](string sequence) {
+    std::vector<int64_t> boundaries;
+    for (absl::string_view boundary :
+         absl::StrSplit(sequence, ',', absl::SkipEmpty())) {
+      int64_t value;
+      if (!absl::SimpleAtoi(boundary, &value) || value <= 0) {
+        return false;
+      }
+      boundaries.push_back(value);
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()),
+                     boundaries.end());
+    ops_flags->tf_xla_shape_bucket_boundaries = std::move(boundaries);
+    return true;
+  };
+
   flag_list = new std::vector<Flag>(
       {Flag("tf_xla_enable_lazy_compilation",
             &build_ops_flags->tf_xla_enable_lazy_compilation, ""),
@@ -205,6 +226,11 @@ void AllocateAndParseFlags() {
             &build_ops_flags->tf_xla_disable_constant_folding,
             "If true then disables constant folding on TF graph before XLA "
             "compilation."),
+       Flag("tf_xla_parallel_first_step_compilation",
+            &build_ops_flags->tf_xla_parallel_first_step_compilation,
+            "If true then statically shaped clusters are compiled "
+            "concurrently in the background before the first step reaches "
+            "them, and run through TensorFlow until they are compiled."),
 
        Flag("tf_xla_compile_on_demand", &device_flags->tf_xla_compile_on_demand,
             "Switch a device into 'on-demand' mode, where instead of "
@@ -222,6 +248,23 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_persistent_cache_directory",
+            &ops_flags->tf_xla_persistent_cache_directory,
+            "If non-empty, the optimized HLO of compiled clusters is persisted "
+            "to this directory and reused across restarts, which skips the "
+            "HLO optimization passes when recompiling them."),
+       Flag("tf_xla_shape_bucket_boundaries",
+            setter_for_shape_bucket_boundaries, "",
+            "Comma-separated sizes, e.g. \"32,64,128\". If set, dimensions of "
+            "the cluster inputs that change between calls are padded with "
+            "zeros up to the next size and the results sliced back, so that "
+            "variable-length inputs reuse a few executables. Only correct for "
+            "clusters whose results do not depend on the padding."),
+       Flag("tf_xla_log_recompiled_clusters",
+            &ops_flags->tf_xla_log_recompiled_clusters,
+            "If positive, the XLA compilation caches log this many of the "
+            "clusters they compiled the most times, with the input shapes "
+            "they were compiled for, when they are destroyed."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
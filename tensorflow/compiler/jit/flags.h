@@ -102,6 +102,17 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // If non-empty, the optimized HLO of every compiled cluster is persisted to
+  // this directory, which may be shared between jobs, and reused when the same
+  // cluster is compiled for the same device after a restart.
+  string tf_xla_persistent_cache_directory;
+  // If non-empty, dynamic dimensions of the cluster inputs are padded up to the
+  // next of these sizes, and the results sliced back, so that variable-length
+  // inputs share a few executables instead of each being compiled.  Sorted.
+  std::vector<int64_t> tf_xla_shape_bucket_boundaries;
+  // If positive, each compilation cache logs this many of the clusters it
+  // compiled the most times, with their signatures, when it is destroyed.
+  int32 tf_xla_log_recompiled_clusters;
 };
 
 // Flags for the build_xla_ops pass.
@@ -125,6 +136,12 @@ struct BuildXlaOpsPassFlags {
   // Disables all constant folding. The primary use for this is for testing to
   // guarantee that tests are run on XLA and not on TF's CPU implementation.
   bool tf_xla_disable_constant_folding;
+
+  // If true, lazily compiled clusters whose inputs all have static shapes are
+  // compiled concurrently in the background as soon as their _XlaCompile
+  // kernels are created, instead of one at a time as the first step reaches
+  // them.  They run through the TF fallback path until they are compiled.
+  bool tf_xla_parallel_first_step_compilation;
 };
 
 // Flags for the IntroduceFloatingPointJitter pass.
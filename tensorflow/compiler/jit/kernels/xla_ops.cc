@@ -86,12 +86,14 @@ class XlaExecutableClosure {
   explicit XlaExecutableClosure(
       xla::LocalClient* client, xla::LocalExecutable* executable,
       const XlaCompiler::CompilationResult* compilation_result,
-      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args)
+      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args,
+      XlaCompilationCache::BucketedShapes bucketed_shapes)
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        bucketed_shapes_(std::move(bucketed_shapes)) {}
 
   XlaExecutableClosure(XlaExecutableClosure&&) = default;
   XlaExecutableClosure& operator=(XlaExecutableClosure&&) = default;
@@ -105,6 +107,9 @@ class XlaExecutableClosure {
     return resource_var_snapshots_;
   }
   int num_constant_args() const { return num_constant_args_; }
+  const XlaCompilationCache::BucketedShapes& bucketed_shapes() const {
+    return bucketed_shapes_;
+  }
 
  private:
   xla::LocalClient* client_;
@@ -112,6 +117,8 @@ class XlaExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   ResourceVarsSnapshot resource_var_snapshots_;
   int num_constant_args_;
+  // How the arguments were padded for `executable_`.
+  XlaCompilationCache::BucketedShapes bucketed_shapes_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaExecutableClosure);
 };
@@ -170,6 +177,32 @@ XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
       platform_info_(XlaPlatformInfoFromDevice(ctx->device())),
       has_ref_vars_(has_ref_vars) {}
 
+// Looks up the compilation cache of `device`, creating it on first use.
+static Status LookupOrCreateCompilationCache(
+    ResourceMgr* rm, DeviceBase* device, FunctionLibraryRuntime* flr,
+    const XlaPlatformInfo& platform_info, XlaCompilationCache** cache) {
+  if (!rm) {
+    return errors::Internal("No resource manager.");
+  }
+  return rm->LookupOrCreate<XlaCompilationCache>(
+      rm->default_container(), "xla_cache", cache,
+      [&](XlaCompilationCache** cache) {
+        return BuildXlaCompilationCache(device, flr, platform_info, cache);
+      });
+}
+
+static XlaCompiler::CompileOptions GenerateCompileOptions(
+    bool has_ref_vars, bool may_alias_resource_update) {
+  XlaCompiler::CompileOptions compile_options;
+  compile_options.is_entry_computation = true;
+  // Optimization: where possible, have the computation return a naked array
+  // rather than a one-element tuple.
+  compile_options.always_return_tuple = false;
+  compile_options.alias_resource_update = !has_ref_vars &&
+                                          may_alias_resource_update;
+  return compile_options;
+}
+
 static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function, bool has_ref_vars,
     const XlaPlatformInfo& platform_info,
@@ -179,21 +212,14 @@ static Status CompileToLocalExecutable(
     XlaCompilationCache::CompileMode compile_mode,
     bool may_alias_resource_update, xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    XlaCompilationCache::BucketedShapes* bucketed_shapes = nullptr) {
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
-  ResourceMgr* rm = ctx->resource_manager();
-  if (!rm) {
-    return errors::Internal("No resource manager.");
-  }
-
   XlaCompilationCache* cache;
-  TF_RETURN_IF_ERROR(rm->LookupOrCreate<XlaCompilationCache>(
-      rm->default_container(), "xla_cache", &cache,
-      [&](XlaCompilationCache** cache) {
-        return BuildXlaCompilationCache(ctx->device(), ctx->function_library(),
-                                        platform_info, cache);
-      }));
+  TF_RETURN_IF_ERROR(LookupOrCreateCompilationCache(
+      ctx->resource_manager(), ctx->device(), ctx->function_library(),
+      platform_info, &cache));
   // Hold the reference to the JIT during evaluation. (We could probably
   // free it sooner because the ResourceMgr will retain a reference, but
   // this is more obviously correct.)
@@ -206,19 +232,18 @@ static Status CompileToLocalExecutable(
       ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr,
       platform_info, has_ref_vars);
 
-  XlaCompiler::CompileOptions compile_options;
-  compile_options.is_entry_computation = true;
-  // Optimization: where possible, have the computation return a naked array
-  // rather than a one-element tuple.
-  compile_options.always_return_tuple = false;
-  compile_options.alias_resource_update = !has_ref_vars &&
-                                          may_alias_resource_update;
+  XlaCompiler::CompileOptions compile_options =
+      GenerateCompileOptions(has_ref_vars, may_alias_resource_update);
 
   StatusOr<std::vector<XlaCompiler::Argument>> args =
       XlaComputationLaunchContext::BuildXlaCompilerArguments(
           constants, inputs, variable_infos,
           static_cast<Device*>(ctx->device()));
   TF_RETURN_IF_ERROR(args.status());
+  // Bucketing pads plain device buffers, which XLA devices do not use.
+  if (bucketed_shapes != nullptr && !platform_info.is_on_xla_device()) {
+    *bucketed_shapes = cache->BucketArguments(function, &*args);
+  }
   return cache->Compile(options, function, *args, compile_options, compile_mode,
                         compilation_result, executable);
 }
@@ -367,6 +392,55 @@ bool HasRefVars(OpKernelConstruction* ctx) {
   return has_ref_vars;
 }
 
+// Queues the compilation of a cluster whose arguments have the static shapes
+// recorded by BuildXlaOpsPass, so that all such clusters compile concurrently
+// instead of one at a time as the first step reaches them.  The request
+// matches the one XlaCompileOp::Compute makes, so once the compilation is done
+// the first execution hits the cache.
+Status PrecompileCluster(OpKernelConstruction* ctx,
+                         const NameAttrList& function,
+                         const XlaPlatformInfo& platform_info,
+                         bool has_ref_vars) {
+  std::vector<TensorShape> arg_shapes;
+  TF_RETURN_IF_ERROR(ctx->GetAttr(kXlaPrecompileArgShapesAttr, &arg_shapes));
+  DataTypeVector arg_types;
+  TF_RETURN_IF_ERROR(ctx->GetAttr("Targs", &arg_types));
+  if (arg_shapes.size() != arg_types.size()) {
+    return errors::InvalidArgument("Expected ", arg_types.size(),
+                                   " argument shapes, got ", arg_shapes.size());
+  }
+
+  XlaCompilationCache* cache;
+  TF_RETURN_IF_ERROR(LookupOrCreateCompilationCache(
+      ctx->resource_manager(), ctx->device(), ctx->function_library(),
+      platform_info, &cache));
+  core::ScopedUnref cache_ref(cache);
+
+  // Compute passes the stream of the op's device context, which is the
+  // device's compute stream.
+  const DeviceBase::GpuDeviceInfo* gpu_device_info =
+      ctx->device()->tensorflow_gpu_device_info();
+  se::Stream* stream = gpu_device_info ? gpu_device_info->stream : nullptr;
+  XlaCompiler::Options options =
+      GenerateCompilerOptions(*cache, *ctx->function_library(), ctx->device(),
+                              stream, platform_info, has_ref_vars);
+
+  std::vector<XlaCompiler::Argument> args(arg_types.size());
+  for (int i = 0, end = args.size(); i < end; ++i) {
+    args[i].kind = XlaCompiler::Argument::kParameter;
+    args[i].type = arg_types[i];
+    args[i].shape = arg_shapes[i];
+  }
+
+  const XlaCompiler::CompilationResult* compilation_result;
+  xla::LocalExecutable* executable;
+  return cache->Compile(
+      options, function, args,
+      GenerateCompileOptions(has_ref_vars, /*may_alias_resource_update=*/false),
+      XlaCompilationCache::CompileMode::kAsync, &compilation_result,
+      &executable);
+}
+
 }  // namespace
 
 XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
@@ -384,7 +458,19 @@ XlaCompileOp::XlaCompileOp(OpKernelConstruction* ctx)
       function_(FunctionAttr(ctx)),
       platform_info_(XlaPlatformInfoFromDevice(ctx->device())),
       must_compile_(MustCompileAttr(ctx)),
-      has_ref_vars_(HasRefVars(ctx)) {}
+      has_ref_vars_(HasRefVars(ctx)) {
+  // Must-compile clusters have no fallback to run while they compile.
+  if (must_compile_ || GetXlaOpsCommonFlags().tf_xla_always_defer_compilation ||
+      !HasNodeAttr(def(), kXlaPrecompileArgShapesAttr)) {
+    return;
+  }
+  Status status = PrecompileCluster(ctx, function_, platform_info_,
+                                    has_ref_vars_);
+  if (!status.ok()) {
+    VLOG(1) << "Could not compile " << function_.name()
+            << " ahead of its first execution: " << status;
+  }
+}
 
 void XlaCompileOp::Compute(OpKernelContext* ctx) {
   VLOG(3) << "XlaCompileOp " << def().name()
@@ -393,6 +479,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
   ResourceVarsSnapshot variables;
+  XlaCompilationCache::BucketedShapes bucketed_shapes;
 
   std::vector<const Tensor*> inputs = InputsFromContext(ctx);
   bool cannot_compile_cluster;
@@ -424,7 +511,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
     Status status = CompileToLocalExecutable(
         ctx, function_, has_ref_vars_, platform_info_, inputs, variable_infos,
         constants_, compile_mode, /*may_alias_resource_update=*/false, &client,
-        &kernel, &executable);
+        &kernel, &executable, &bucketed_shapes);
     OP_REQUIRES_OK(ctx, SnapshotResourceVariables(ctx, resources_,
                                                   variable_infos, &variables));
     if (compile_mode != XlaCompilationCache::CompileMode::kLazy ||
@@ -468,7 +555,8 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   // variables.
   XlaExecutableClosureStore::KeyT key =
       XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
-          client, executable, kernel, std::move(variables), constants_.size()));
+          client, executable, kernel, std::move(variables), constants_.size(),
+          std::move(bucketed_shapes)));
 
   Tensor compilation_key(cpu_allocator, DT_STRING, TensorShape({}));
   compilation_key.flat<tstring>()(0) = key;
@@ -510,6 +598,7 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       closure.executable()->executable()->module().input_output_alias_config();
   StatusOr<std::vector<xla::ExecutionInput>> execution_inputs;
   std::map<int, const Tensor*> snapshot_ptrs;
+  std::map<int, Tensor> padded_inputs;
   {
     tensorflow::profiler::TraceMe hlo_module_activity(
         [&] {
@@ -523,10 +612,14 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       snapshot_ptrs.emplace(p.first,
                             p.second.has_value() ? &p.second.value() : nullptr);
     }
+    OP_REQUIRES_OK(ctx, PadBucketedInputs(
+                            ctx, closure.bucketed_shapes(),
+                            /*missing_ctx_input_prefix=*/
+                            closure.num_constant_args(), &padded_inputs));
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-        input_output_alias);
+        input_output_alias, &padded_inputs);
     OP_REQUIRES_OK(ctx, execution_inputs.status());
   }
 
@@ -568,6 +661,7 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
           ctx, closure.compilation_result(), execution_output->ConsumeResult(),
           /*missing_ctx_input_prefix=*/closure.num_constant_args(),
           absl::MakeSpan(*variable_infos), input_output_alias, snapshot_ptrs));
+  OP_REQUIRES_OK(ctx, SliceBucketedOutputs(ctx, closure.bucketed_shapes()));
 }
 
 XlaMergeOp::XlaMergeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
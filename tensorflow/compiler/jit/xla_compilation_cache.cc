@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include "tensorflow/compiler/mlir/mlir_bridge_rollout_policy.h"
 #include "absl/base/call_once.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -31,6 +33,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -43,8 +47,15 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/public/version.h"
@@ -53,17 +64,63 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+auto* cache_lookups = monitoring::Counter<2>::New(
+    "/tensorflow/core/xla_compilation_cache/lookups",
+    "The number of XLA compilation cache lookups, by cluster and result: "
+    "\"hit\" if the signature was compiled, \"miss\" if it gets compiled, "
+    "\"compiling\" if it is being compiled asynchronously, \"deferred\" if "
+    "it isn't compiled yet and \"megamorphic\" if the cluster is no longer "
+    "compiled. The last three run the cluster in the TF executor.",
+    "cluster", "result");
+
+auto* cluster_compile_time = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/xla_compilation_cache/compile_time_usecs",
+     "The time spent compiling each XLA cluster, in microseconds.", "cluster"},
+    // 1ms to ~17min.
+    monitoring::Buckets::Exponential(1000, 2, 20));
+
+auto* megamorphic_clusters = monitoring::Gauge<bool, 1>::New(
+    "/tensorflow/core/xla_compilation_cache/megamorphic",
+    "Whether the XLA cluster has been recompiled too often and is no longer "
+    "compiled.",
+    "cluster");
+
+}  // namespace
+
 constexpr int64_t XlaCompilationCache::kDefaultCompilationThreshold;
+constexpr int XlaCompilationCache::kMaxReportedSignatures;
 constexpr int64_t
     XlaCompilationCache::AsyncCompilationState::kNumCompilerThreads;
 constexpr int64_t
     XlaCompilationCache::AsyncCompilationState::kMaxNumOngoingCompilations;
 
+static XlaCompilationCache::Config ConfigFromFlags() {
+  const XlaOpsCommonFlags& flags = GetXlaOpsCommonFlags();
+  XlaCompilationCache::Config config(flags.tf_xla_persistent_cache_directory);
+  config.shape_bucket_boundaries = flags.tf_xla_shape_bucket_boundaries;
+  config.num_recompiled_clusters_to_log =
+      flags.tf_xla_log_recompiled_clusters;
+  return config;
+}
+
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : XlaCompilationCache(ConfigFromFlags(), client, std::move(device_type)) {}
+
+XlaCompilationCache::XlaCompilationCache(Config config,
+                                         xla::LocalClient* client,
+                                         DeviceType device_type)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      config_(std::move(config)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  if (config_.num_recompiled_clusters_to_log > 0) {
+    LOG(INFO) << RecompiledClustersString(
+        config_.num_recompiled_clusters_to_log);
+  }
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -91,6 +148,45 @@ string XlaCompilationCache::DebugString() const {
   return "XLA JIT compilation cache";
 }
 
+string XlaCompilationCache::RecompiledClustersString(int max_clusters) {
+  mutex_lock lock(cluster_compile_stats_mu_);
+  std::vector<const std::pair<const string, ClusterCompileStats>*> clusters;
+  for (const auto& cluster : cluster_compile_stats_) {
+    if (cluster.second.compile_count > 0) clusters.push_back(&cluster);
+  }
+  std::sort(clusters.begin(), clusters.end(),
+            [](const auto* a, const auto* b) {
+              if (a->second.compile_count != b->second.compile_count) {
+                return a->second.compile_count > b->second.compile_count;
+              }
+              return a->first < b->first;
+            });
+  if (clusters.size() > static_cast<size_t>(max_clusters)) {
+    clusters.resize(max_clusters);
+  }
+
+  string result = absl::StrCat("Most recompiled XLA clusters on ",
+                               device_type_.type_string(), ":\n");
+  for (const auto* cluster : clusters) {
+    const ClusterCompileStats& stats = cluster->second;
+    absl::StrAppend(&result, cluster->first, ": ", stats.compile_count,
+                    " compilations in ",
+                    stats.cumulative_compile_time_us / 1000, "ms, ",
+                    stats.execution_count, " executions",
+                    stats.is_megamorphic ? ", megamorphic" : "", "\n");
+    for (const string& signature : stats.compiled_signatures) {
+      absl::StrAppend(&result, "  ", signature, "\n");
+    }
+    const int64_t num_signatures = stats.compiled_signatures.size();
+    if (stats.compile_count > num_signatures) {
+      absl::StrAppend(&result, "  ... and ",
+                      stats.compile_count - num_signatures,
+                      " more\n");
+    }
+  }
+  return result;
+}
+
 // Compute a string signature which encodes the shapes of the
 // arguments in the supplied list.
 string XlaCompilationCache::Signature::HumanString() const {
@@ -138,6 +234,105 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
   return h;
 }
 
+XlaCompilationCache::BucketedShapes XlaCompilationCache::BucketArguments(
+    const NameAttrList& function, std::vector<XlaCompiler::Argument>* args) {
+  const std::vector<int64_t>& boundaries = config_.shape_bucket_boundaries;
+  if (boundaries.empty()) {
+    return {};
+  }
+  for (const XlaCompiler::Argument& arg : *args) {
+    if (arg.kind == XlaCompiler::Argument::kResource) {
+      return {};
+    }
+  }
+
+  // Record the dimensions of this call and find out which are dynamic.
+  std::vector<absl::InlinedVector<bool, 4>> is_dynamic(args->size());
+  {
+    mutex_lock lock(observed_arg_dims_mu_);
+    ObservedArgDims& observed = observed_arg_dims_[function.name()];
+    observed.first_dims.resize(args->size());
+    observed.is_dynamic.resize(args->size());
+    for (int i = 0, end = args->size(); i < end; ++i) {
+      const XlaCompiler::Argument& arg = (*args)[i];
+      if (arg.kind != XlaCompiler::Argument::kParameter ||
+          !absl::holds_alternative<TensorShape>(arg.shape) ||
+          !DataTypeCanUseMemcpy(arg.type)) {
+        continue;
+      }
+      absl::InlinedVector<int64_t, 4> dims =
+          absl::get<TensorShape>(arg.shape).dim_sizes();
+      if (observed.is_dynamic[i].size() != dims.size()) {
+        observed.first_dims[i] = dims;
+        observed.is_dynamic[i].assign(dims.size(), false);
+      }
+      for (int d = 0, rank = dims.size(); d < rank; ++d) {
+        if (dims[d] != observed.first_dims[i][d]) {
+          observed.is_dynamic[i][d] = true;
+        }
+      }
+      is_dynamic[i] = observed.is_dynamic[i];
+    }
+  }
+
+  BucketedShapes bucketed;
+  // Sizes of the dimensions that are not padded.
+  absl::flat_hash_set<int64_t> static_sizes;
+  for (int i = 0, end = args->size(); i < end; ++i) {
+    const XlaCompiler::Argument& arg = (*args)[i];
+    if (!absl::holds_alternative<TensorShape>(arg.shape)) {
+      continue;
+    }
+    TensorShape shape = absl::get<TensorShape>(arg.shape);
+    bool is_padded = false;
+    for (int d = 0; d < shape.dims(); ++d) {
+      const int64_t size = shape.dim_size(d);
+      if (d >= static_cast<int>(is_dynamic[i].size()) || !is_dynamic[i][d]) {
+        static_sizes.insert(size);
+        continue;
+      }
+      auto bucket =
+          std::lower_bound(boundaries.begin(), boundaries.end(), size);
+      if (bucket == boundaries.end()) {
+        VLOG(2) << "Not bucketing " << function.name() << ": dimension " << d
+                << " of argument " << i << " exceeds the largest bucket.";
+        return {};
+      }
+      auto inserted = bucketed.actual_sizes.emplace(*bucket, size);
+      if (!inserted.second && inserted.first->second != size) {
+        VLOG(2) << "Not bucketing " << function.name() << ": sizes "
+                << inserted.first->second << " and " << size
+                << " share bucket " << *bucket << ".";
+        return {};
+      }
+      if (*bucket != size) {
+        shape.set_dim(d, *bucket);
+        is_padded = true;
+      }
+    }
+    if (is_padded) {
+      bucketed.padded_args.emplace(i, shape);
+    }
+  }
+
+  for (auto it = bucketed.actual_sizes.begin();
+       it != bucketed.actual_sizes.end();) {
+    if (it->first == it->second) {
+      bucketed.actual_sizes.erase(it++);
+    } else if (static_sizes.contains(it->first)) {
+      VLOG(2) << "Not bucketing " << function.name() << ": bucket "
+              << it->first << " is also the size of a static dimension.";
+      return {};
+    } else {
+      ++it;
+    }
+  }
+  for (const auto& padded_arg : bucketed.padded_args) {
+    (*args)[padded_arg.first].shape = padded_arg.second;
+  }
+  return bucketed;
+}
+
 StatusOr<XlaCompilationCache::Signature> XlaCompilationCache::BuildSignature(
     const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args) {
@@ -187,6 +382,10 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
   build_options.mutable_debug_options()->set_xla_detailed_logging_and_dumping(
       options.detailed_logging);
+  if (!config_.persistent_cache_directory.empty()) {
+    return BuildPersistedExecutable(*result.computation, argument_layouts,
+                                    build_options, executable);
+  }
   TF_ASSIGN_OR_RETURN(
       auto executables,
       client_->Compile(*result.computation, argument_layouts, build_options));
@@ -195,6 +394,117 @@ Status XlaCompilationCache::BuildExecutable(
   return Status::OK();
 }
 
+StatusOr<XlaSerializedCacheKey> XlaCompilationCache::BuildPersistentCacheKey(
+    const xla::XlaComputation& computation,
+    const std::vector<const xla::Shape*>& argument_layouts,
+    const xla::ExecutableBuildOptions& build_options) {
+  XlaSerializedCacheKey key;
+  // The unique ids and names in the proto depend on the order clusters are
+  // compiled in, so the module is fingerprinted in its canonical form.
+  TF_ASSIGN_OR_RETURN(xla::HloModuleConfig module_config,
+                      xla::HloModule::CreateModuleConfigFromProto(
+                          computation.proto(), build_options.debug_options()));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<xla::HloModule> module,
+      xla::HloModule::CreateFromProto(computation.proto(), module_config));
+  key.set_module_fingerprint(Fingerprint64(
+      module->ToString(xla::HloPrintOptions::Canonical()
+                           .set_print_large_constants(true)
+                           .set_print_backend_config(true))));
+  key.set_device_type(device_type_.type_string());
+
+  TF_ASSIGN_OR_RETURN(
+      se::StreamExecutor * executor,
+      client_->backend().stream_executor(build_options.device_ordinal()));
+  const se::DeviceDescription& device = executor->GetDeviceDescription();
+  key.set_device_description(absl::StrJoin(
+      {client_->platform()->Name(), device.name(), device.device_vendor(),
+       device.platform_version(), device.driver_version(),
+       device.runtime_version(), string(TF_GIT_VERSION)},
+      "|"));
+
+  string options = absl::StrCat(
+      "replicas=", build_options.num_replicas(),
+      ",partitions=", build_options.num_partitions(),
+      ",alias_passthrough_params=", build_options.alias_passthrough_params(),
+      ",debug_options=",
+      DeterministicProtoHash64(build_options.debug_options()), ",result=",
+      xla::ShapeUtil::HumanStringWithLayout(build_options.result_layout()
+                                                ? *build_options.result_layout()
+                                                : xla::Shape()));
+  for (const xla::Shape* shape : argument_layouts) {
+    absl::StrAppend(&options, ",arg=",
+                    xla::ShapeUtil::HumanStringWithLayout(*shape));
+  }
+  key.set_build_options(options);
+  return key;
+}
+
+Status XlaCompilationCache::BuildPersistedExecutable(
+    const xla::XlaComputation& computation,
+    const std::vector<const xla::Shape*>& argument_layouts,
+    const xla::ExecutableBuildOptions& build_options,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  TF_ASSIGN_OR_RETURN(
+      XlaSerializedCacheKey key,
+      BuildPersistentCacheKey(computation, argument_layouts, build_options));
+  Env* env = Env::Default();
+  const string path = io::JoinPath(
+      config_.persistent_cache_directory,
+      absl::StrCat(device_type_.type_string(), "__",
+                   DeterministicProtoHash64(key), ".pb"));
+
+  if (env->FileExists(path).ok()) {
+    XlaSerializedCacheEntry entry;
+    Status status = ReadBinaryProto(env, path, &entry);
+    if (status.ok() &&
+        entry.key().SerializeAsString() != key.SerializeAsString()) {
+      status = errors::FailedPrecondition("the cache key does not match");
+    }
+    if (status.ok()) {
+      xla::ExecutableBuildOptions backend_options = build_options;
+      backend_options.set_run_backend_only(true);
+      auto executables = client_->Compile(
+          xla::XlaComputation(entry.optimized_module()), argument_layouts,
+          backend_options);
+      status = executables.status();
+      if (status.ok()) {
+        TF_RET_CHECK(executables.ValueOrDie().size() == 1);
+        VLOG(1) << "Loaded persisted XLA executable " << path;
+        *executable = std::move(executables.ValueOrDie()[0]);
+        return Status::OK();
+      }
+    }
+    LOG(WARNING) << "Ignoring persisted XLA executable " << path << ": "
+                 << status;
+  }
+
+  TF_ASSIGN_OR_RETURN(
+      auto executables,
+      client_->Compile(computation, argument_layouts, build_options));
+  TF_RET_CHECK(executables.size() == 1);
+  *executable = std::move(executables[0]);
+
+  // Failing to persist the executable only costs a recompilation in the next
+  // run, so errors are logged rather than returned. The entry is written to a
+  // temporary file first so that concurrent jobs never read a partial entry.
+  XlaSerializedCacheEntry entry;
+  *entry.mutable_key() = std::move(key);
+  *entry.mutable_optimized_module() =
+      (*executable)->executable()->module().ToProto();
+  const string tmp_path = absl::StrCat(path, ".tmp.", env->NowMicros(), ".",
+                                       random::New64());
+  Status status = env->RecursivelyCreateDir(config_.persistent_cache_directory);
+  if (status.ok()) status = WriteBinaryProto(env, tmp_path, entry);
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to persist XLA executable " << path << ": "
+                 << status;
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return Status::OK();
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     const std::vector<XlaCompiler::Argument>& args,
@@ -383,6 +693,7 @@ Status XlaCompilationCache::CompileStrict(
   const uint64 compile_end_us = env->NowMicros();
   const uint64 compile_time_us = compile_end_us - compile_start_us;
   metrics::UpdateXlaCompilationTime(compile_time_us);
+  cluster_compile_time->GetCell(function.name())->Add(compile_time_us);
 
   mutex_lock lock(cluster_compile_stats_mu_);
   const std::string& function_name = function.name();
@@ -576,6 +887,7 @@ Status XlaCompilationCache::CompileImpl(
               << " as megamorphic, compile_count=" << it->second.compile_count
               << " execution_count=" << it->second.execution_count;
       it->second.is_megamorphic = true;
+      megamorphic_clusters->GetCell(function.name())->Set(true);
     }
 
     is_megamorphic = it->second.is_megamorphic;
@@ -606,8 +918,20 @@ Status XlaCompilationCache::CompileImpl(
     if (!ShouldCompileCluster(compile_mode, is_megamorphic, is_first_execution,
                               current_request_count, function)) {
       VLOG(2) << "Not compiling for signature: " << human_signature;
+      const char* result = is_megamorphic ? "megamorphic" : "deferred";
+      cache_lookups->GetCell(function.name(), result)->IncrementBy(1);
       return Status::OK();
-    } else if (compile_mode == CompileMode::kAsync) {
+    }
+    cache_lookups->GetCell(function.name(), "miss")->IncrementBy(1);
+    {
+      mutex_lock lock(cluster_compile_stats_mu_);
+      std::vector<string>& signatures =
+          cluster_compile_stats_[function.name()].compiled_signatures;
+      if (signatures.size() < kMaxReportedSignatures) {
+        signatures.push_back(signature.HumanString());
+      }
+    }
+    if (compile_mode == CompileMode::kAsync) {
       VLOG(2) << "Queueing asynchronous compilation for signature: "
               << human_signature;
       TF_RETURN_IF_ERROR(CompileAsynchronous(entry, compile_options, options,
@@ -621,9 +945,11 @@ Status XlaCompilationCache::CompileImpl(
   } else if (state == CompileState::kCompiling) {
     VLOG(2) << "Ongoing asynchronous compilation for signature: "
             << human_signature;
+    cache_lookups->GetCell(function.name(), "compiling")->IncrementBy(1);
     return Status::OK();
   } else if (state == CompileState::kCompiled) {
     VLOG(2) << "Already Compiled for signature: " << human_signature;
+    cache_lookups->GetCell(function.name(), "hit")->IncrementBy(1);
   }
 
   TF_RETURN_IF_ERROR(entry->compilation_status);
@@ -18,8 +18,11 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -38,13 +41,38 @@ namespace tensorflow {
 // which converts a Tensorflow graph into a compiled XLA compilation.
 //
 // Since XLA computations must have static shapes, the cache generates a new
-// XLA computation for each new set of input shapes.
+// XLA computation for each new set of input shapes, unless BucketArguments
+// pads the shapes of the arguments to a few bucket sizes first.
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
 class XlaCompilationCache : public ResourceBase {
  public:
+  struct Config {
+    Config() = default;
+    explicit Config(absl::string_view persistent_cache_directory)
+        : persistent_cache_directory(persistent_cache_directory) {}
+
+    // If non-empty, the optimized HLO of every compiled executable is written
+    // to this directory. Later compilations of the same computation for the
+    // same device, e.g. after a restart, load it and only run the backend code
+    // generation.
+    string persistent_cache_directory;
+
+    // Sorted sizes that the dynamic dimensions of the arguments are padded to
+    // by BucketArguments. Empty disables bucketing.
+    std::vector<int64_t> shape_bucket_boundaries;
+
+    // If positive, the clusters compiled the most times, at most this many,
+    // are logged with their signatures when the cache is destroyed.
+    int num_recompiled_clusters_to_log = 0;
+  };
+
+  // Reads the configuration from the tf_xla_persistent_cache_directory,
+  // tf_xla_shape_bucket_boundaries and tf_xla_log_recompiled_clusters flags.
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
+  XlaCompilationCache(Config config, xla::LocalClient* client,
+                      DeviceType device_type);
   ~XlaCompilationCache() override;
 
   enum class CompileMode {
@@ -102,11 +130,47 @@ class XlaCompilationCache : public ResourceBase {
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // How the arguments of a call were padded by BucketArguments.
+  struct BucketedShapes {
+    // The padded shape of each padded argument, keyed by argument number.
+    std::map<int, TensorShape> padded_args;
+
+    // The actual size of each padded dimension, keyed by its padded size.
+    // Dimensions of the results that have a padded size are sliced back to
+    // the actual size.
+    absl::flat_hash_map<int64_t, int64_t> actual_sizes;
+
+    bool empty() const { return padded_args.empty(); }
+  };
+
+  // Pads the dynamic dimensions of the parameters in `args` up to the next
+  // bucket boundary, so that calls with nearby shapes share a signature and an
+  // executable rather than each being compiled. A dimension is dynamic once
+  // `function` has been called with two different sizes for it. The caller
+  // must pad the arguments with zeros and slice the results accordingly, so
+  // bucketing is only correct for clusters whose results do not depend on the
+  // padding.
+  //
+  // Bucketing is skipped, leaving `args` untouched and returning an empty
+  // result, if it is disabled or the padded dimensions could not be told apart
+  // in the results: when a dynamic dimension exceeds the largest boundary, two
+  // of them of different sizes share a bucket, or a bucket equals the size of
+  // another dimension. Clusters with resource arguments are never bucketed,
+  // since padding would leak into the variables they update.
+  BucketedShapes BucketArguments(const NameAttrList& function,
+                                 std::vector<XlaCompiler::Argument>* args);
+
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
   string DebugString() const override;
 
+  // Describes the `max_clusters` clusters compiled the most times: their
+  // compile count and time, whether they went megamorphic, and the signatures
+  // they were compiled for, which are the shapes a bucketing configuration has
+  // to cover.
+  string RecompiledClustersString(int max_clusters);
+
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
   struct Signature {
@@ -153,6 +217,21 @@ class XlaCompilationCache : public ResourceBase {
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Like BuildExecutable, but first looks for the optimized HLO of
+  // `computation` in the persistent cache directory, and persists it after a
+  // miss.
+  Status BuildPersistedExecutable(
+      const xla::XlaComputation& computation,
+      const std::vector<const xla::Shape*>& argument_layouts,
+      const xla::ExecutableBuildOptions& build_options,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
+  // Returns the key of `computation` in the persistent cache.
+  StatusOr<XlaSerializedCacheKey> BuildPersistentCacheKey(
+      const xla::XlaComputation& computation,
+      const std::vector<const xla::Shape*>& argument_layouts,
+      const xla::ExecutableBuildOptions& build_options);
+
   // Determines whether the cluster should be compiled.
   bool ShouldCompileCluster(CompileMode compile_mode, bool is_megamorphic,
                             bool is_first_execution,
@@ -161,6 +240,7 @@ class XlaCompilationCache : public ResourceBase {
 
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  const Config config_;
 
   // The value associated with a cache entry.
   struct Entry {
@@ -211,12 +291,29 @@ class XlaCompilationCache : public ResourceBase {
     // Cumulative time spent compiling the cluster.
     int64_t cumulative_compile_time_us = 0;
 
+    // The human-readable signatures the cluster was compiled for, the first
+    // kMaxReportedSignatures of them.
+    std::vector<string> compiled_signatures;
+
     // True if we have decided that this cluster is too dynamic (i.e. its shapes
     // change too frequently) to profitably JIT compile.  Once a cluster is
     // tagged megamorphic, it stays megamorphic forever.
     bool is_megamorphic = false;
   };
 
+  // The argument dimensions a cluster was first called with, and which of them
+  // have since been seen with a different size.
+  struct ObservedArgDims {
+    std::vector<absl::InlinedVector<int64_t, 4>> first_dims;
+    std::vector<absl::InlinedVector<bool, 4>> is_dynamic;
+  };
+
+  mutex observed_arg_dims_mu_;
+
+  // Maps cluster names to the dimensions observed by BucketArguments.
+  absl::flat_hash_map<string, ObservedArgDims> observed_arg_dims_
+      TF_GUARDED_BY(observed_arg_dims_mu_);
+
   mutex cluster_compile_stats_mu_;
 
   // Maps cluster names to compilation statistics for said cluster.
@@ -251,6 +348,10 @@ class XlaCompilationCache : public ResourceBase {
   // signature before  we attempt to compile it.
   static constexpr int64_t kDefaultCompilationThreshold = 2;
 
+  // The number of signatures of each cluster kept for
+  // RecompiledClustersString.
+  static constexpr int kMaxReportedSignatures = 32;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
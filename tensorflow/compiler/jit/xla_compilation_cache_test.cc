@@ -18,6 +18,11 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -54,6 +59,155 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+TEST(XlaCompilationCacheTest, BucketArgumentsPadsDynamicDimensions) {
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  XlaCompilationCache::Config config;
+  config.shape_bucket_boundaries = {8, 16};
+  auto cache = new XlaCompilationCache(std::move(config), client,
+                                       DeviceType(DEVICE_CPU_XLA_JIT));
+  core::ScopedUnref cache_ref(cache);
+
+  NameAttrList fn;
+  fn.set_name("afunction");
+  auto make_args = [](int64_t rows, int64_t cols) {
+    std::vector<XlaCompiler::Argument> args(1);
+    args[0].kind = XlaCompiler::Argument::kParameter;
+    args[0].type = DT_FLOAT;
+    args[0].shape = TensorShape({rows, cols});
+    return args;
+  };
+
+  // Nothing is dynamic on the first call.
+  std::vector<XlaCompiler::Argument> args = make_args(2, 5);
+  EXPECT_TRUE(cache->BucketArguments(fn, &args).empty());
+
+  args = make_args(2, 7);
+  XlaCompilationCache::BucketedShapes bucketed =
+      cache->BucketArguments(fn, &args);
+  ASSERT_EQ(bucketed.padded_args.size(), 1);
+  EXPECT_EQ(bucketed.padded_args.at(0), TensorShape({2, 8}));
+  EXPECT_EQ(absl::get<TensorShape>(args[0].shape), TensorShape({2, 8}));
+  ASSERT_EQ(bucketed.actual_sizes.size(), 1);
+  EXPECT_EQ(bucketed.actual_sizes.at(8), 7);
+
+  // Sizes above the largest bucket are compiled as is.
+  args = make_args(2, 20);
+  EXPECT_TRUE(cache->BucketArguments(fn, &args).empty());
+  EXPECT_EQ(absl::get<TensorShape>(args[0].shape), TensorShape({2, 20}));
+
+  // A bucket that is also the size of a static dimension cannot be sliced
+  // unambiguously.
+  NameAttrList square_fn;
+  square_fn.set_name("square");
+  args = make_args(8, 8);
+  EXPECT_TRUE(cache->BucketArguments(square_fn, &args).empty());
+  args = make_args(8, 3);
+  EXPECT_TRUE(cache->BucketArguments(square_fn, &args).empty());
+}
+
+// Runs before TestDisabledXlaCompilation, which disables compilation for the
+// rest of the process.
+TEST(XlaCompilationCacheTest, PersistentCacheRoundTrip) {
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = FunctionDefHelper::Create(
+      "AddSelf", {"x: float"}, {"y: float"}, {},
+      {{{"add"}, "Add", {"x", "x"}, {{"T", DT_FLOAT}}}},
+      {{"y", "add:z:0"}});
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), fdef_lib);
+
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  DeviceType device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  XlaCompiler::Options options;
+  options.device_type = device_type;
+  options.client = client;
+  options.flib_def = &flib_def;
+  options.graph_def_version = TF_GRAPH_DEF_VERSION;
+
+  NameAttrList fn;
+  fn.set_name("AddSelf");
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({2});
+
+  const string dir = io::JoinPath(testing::TmpDir(), "xla_persistent_cache");
+  std::vector<string> entries;
+  for (int i = 0; i < 2; ++i) {
+    auto cache = new XlaCompilationCache(XlaCompilationCache::Config(dir),
+                                         client, device_type);
+    core::ScopedUnref cache_ref(cache);
+    const XlaCompiler::CompilationResult* compilation_result;
+    xla::LocalExecutable* executable;
+    TF_ASSERT_OK(cache->Compile(options, fn, args,
+                                XlaCompiler::CompileOptions{},
+                                XlaCompilationCache::CompileMode::kStrict,
+                                &compilation_result, &executable));
+    ASSERT_NE(executable, nullptr);
+
+    // The second cache loads the entry written by the first one rather than
+    // adding a new one.
+    TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+        io::JoinPath(dir, "*.pb"), &entries));
+    EXPECT_EQ(entries.size(), 1u);
+  }
+}
+
+int64_t GetLookupCount(const string& cluster, const string& result) {
+  const std::unique_ptr<monitoring::CollectedMetrics> collected_metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  const monitoring::PointSet& lookups = *collected_metrics->point_set_map.at(
+      "/tensorflow/core/xla_compilation_cache/lookups");
+  for (const auto& point : lookups.points) {
+    if (point->labels[0].value == cluster &&
+        point->labels[1].value == result) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
+TEST(XlaCompilationCacheTest, ExportsCompilationTelemetry) {
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = FunctionDefHelper::Create(
+      "SquareSelf", {"x: float"}, {"y: float"}, {},
+      {{{"mul"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+      {{"y", "mul:z:0"}});
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), fdef_lib);
+
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  DeviceType device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  XlaCompiler::Options options;
+  options.device_type = device_type;
+  options.client = client;
+  options.flib_def = &flib_def;
+  options.graph_def_version = TF_GRAPH_DEF_VERSION;
+
+  NameAttrList fn;
+  fn.set_name("SquareSelf");
+  auto cache = new XlaCompilationCache(client, device_type);
+  core::ScopedUnref cache_ref(cache);
+  for (int64_t size : {2, 2, 3}) {
+    std::vector<XlaCompiler::Argument> args(1);
+    args[0].kind = XlaCompiler::Argument::kParameter;
+    args[0].type = DT_FLOAT;
+    args[0].shape = TensorShape({size});
+    const XlaCompiler::CompilationResult* compilation_result;
+    xla::LocalExecutable* executable;
+    TF_ASSERT_OK(cache->Compile(options, fn, args,
+                                XlaCompiler::CompileOptions{},
+                                XlaCompilationCache::CompileMode::kStrict,
+                                &compilation_result, &executable));
+  }
+
+  EXPECT_EQ(GetLookupCount("SquareSelf", "miss"), 2);
+  EXPECT_EQ(GetLookupCount("SquareSelf", "hit"), 1);
+  const string report = cache->RecompiledClustersString(/*max_clusters=*/10);
+  EXPECT_TRUE(absl::StrContains(report, "SquareSelf: 2 compilations"))
+      << report;
+  EXPECT_TRUE(absl::StrContains(report, "SquareSelf,float [2]")) << report;
+  EXPECT_TRUE(absl::StrContains(report, "SquareSelf,float [3]")) << report;
+}
+
 TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
   NameAttrList fn;
   fn.set_name("afunction");
@@ -70,6 +70,8 @@ absl::optional<AllocatorStats> XlaDeviceAllocator::GetStats() {
   tf_stats.peak_bytes_reserved = se_stats->peak_bytes_reserved;
   tf_stats.bytes_reservable_limit = se_stats->bytes_reservable_limit;
   tf_stats.largest_free_block_bytes = se_stats->largest_free_block_bytes;
+  tf_stats.pool_bytes = se_stats->pool_bytes;
+  tf_stats.peak_pool_bytes = se_stats->peak_pool_bytes;
   return tf_stats;
 }
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
 #include "absl/algorithm/container.h"
@@ -56,6 +58,92 @@ se::Platform::Id XlaPlatformInfoFromDevice(DeviceBase* device_base) {
   return platform_id;
 }
 
+// Copies the overlap of the leading corners of `src` and `dst`, which have the
+// same type and rank, and zeroes the rest of `dst`. Device tensors are copied
+// on the stream of `ctx`.
+Status CopyLeadingCorner(OpKernelContext* ctx, const Tensor& src, bool on_host,
+                         Tensor* dst) {
+  se::Stream* stream = nullptr;
+  if (!on_host && ctx->op_device_context() != nullptr) {
+    stream = ctx->op_device_context()->stream();
+  }
+  char* dst_base = static_cast<char*>(DMAHelper::base(dst));
+  const char* src_base = static_cast<const char*>(DMAHelper::base(&src));
+  auto copy = [&](int64_t src_offset, int64_t dst_offset, int64_t size) {
+    if (stream != nullptr) {
+      se::DeviceMemoryBase dst_mem(dst_base + dst_offset, size);
+      stream->ThenMemcpy(
+          &dst_mem,
+          se::DeviceMemoryBase(const_cast<char*>(src_base) + src_offset, size),
+          size);
+    } else {
+      std::memcpy(dst_base + dst_offset, src_base + src_offset, size);
+    }
+  };
+
+  const int rank = src.dims();
+  bool dst_is_larger = false;
+  for (int d = 0; d < rank; ++d) {
+    dst_is_larger |= dst->dim_size(d) > src.dim_size(d);
+  }
+  if (dst_is_larger) {
+    if (stream != nullptr) {
+      se::DeviceMemoryBase dst_mem(dst_base, dst->TotalBytes());
+      stream->ThenMemZero(&dst_mem, dst->TotalBytes());
+    } else {
+      std::memset(dst_base, 0, dst->TotalBytes());
+    }
+  }
+
+  // The dimensions after the innermost one whose size differs are contiguous
+  // in both tensors, so each index into the dimensions before it is one copy.
+  int split_dim = rank - 1;
+  while (split_dim >= 0 &&
+         src.dim_size(split_dim) == dst->dim_size(split_dim)) {
+    --split_dim;
+  }
+  if (split_dim < 0) {
+    copy(0, 0, src.TotalBytes());
+  } else {
+    std::vector<int64_t> src_strides(rank), dst_strides(rank);
+    int64_t src_stride = DataTypeSize(src.dtype());
+    int64_t dst_stride = src_stride;
+    for (int d = rank - 1; d >= 0; --d) {
+      src_strides[d] = src_stride;
+      dst_strides[d] = dst_stride;
+      src_stride *= src.dim_size(d);
+      dst_stride *= dst->dim_size(d);
+    }
+    const int64_t chunk_size =
+        std::min(src.dim_size(split_dim), dst->dim_size(split_dim)) *
+        src_strides[split_dim];
+    std::vector<int64_t> index(split_dim, 0);
+    bool done = chunk_size == 0;
+    while (!done) {
+      int64_t src_offset = 0, dst_offset = 0;
+      for (int d = 0; d < split_dim; ++d) {
+        src_offset += index[d] * src_strides[d];
+        dst_offset += index[d] * dst_strides[d];
+      }
+      copy(src_offset, dst_offset, chunk_size);
+      // Advance to the next index of the overlap, innermost dimension first.
+      done = true;
+      for (int d = split_dim - 1; d >= 0; --d) {
+        if (++index[d] < std::min(src.dim_size(d), dst->dim_size(d))) {
+          done = false;
+          break;
+        }
+        index[d] = 0;
+      }
+    }
+  }
+
+  if (stream != nullptr && !stream->ok()) {
+    return errors::Internal("Failed to enqueue the copy of a bucketed tensor.");
+  }
+  return Status::OK();
+}
+
 }  // anonymous namespace
 
 VariableInfo::VariableInfo(
@@ -139,6 +227,61 @@ std::vector<const Tensor*> InputsFromContext(OpKernelContext* ctx) {
   return inputs;
 }
 
+Status PadBucketedInputs(
+    OpKernelContext* ctx,
+    const XlaCompilationCache::BucketedShapes& bucketed_shapes,
+    int missing_ctx_input_prefix, std::map<int, Tensor>* padded_inputs) {
+  for (const auto& padded_arg : bucketed_shapes.padded_args) {
+    const int input_num = padded_arg.first - missing_ctx_input_prefix;
+    TF_RET_CHECK(input_num >= 0 && input_num < ctx->num_inputs());
+    const Tensor& input = ctx->input(input_num);
+    TF_RET_CHECK(input.dims() == padded_arg.second.dims());
+    Tensor padded;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(input.dtype(), padded_arg.second, &padded));
+    TF_RETURN_IF_ERROR(CopyLeadingCorner(
+        ctx, input, ctx->input_memory_type(input_num) == HOST_MEMORY,
+        &padded));
+    padded_inputs->emplace(padded_arg.first, std::move(padded));
+  }
+  return Status::OK();
+}
+
+Status SliceBucketedOutputs(
+    OpKernelContext* ctx,
+    const XlaCompilationCache::BucketedShapes& bucketed_shapes) {
+  if (bucketed_shapes.actual_sizes.empty()) {
+    return Status::OK();
+  }
+  for (int i = 0; i < ctx->num_outputs(); ++i) {
+    Tensor* output = ctx->mutable_output(i);
+    if (output == nullptr || !DataTypeCanUseMemcpy(output->dtype())) {
+      continue;
+    }
+    TensorShape actual_shape = output->shape();
+    bool is_padded = false;
+    for (int d = 0; d < actual_shape.dims(); ++d) {
+      auto it = bucketed_shapes.actual_sizes.find(actual_shape.dim_size(d));
+      if (it != bucketed_shapes.actual_sizes.end()) {
+        actual_shape.set_dim(d, it->second);
+        is_padded = true;
+      }
+    }
+    if (!is_padded) {
+      continue;
+    }
+    Tensor sliced;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(output->dtype(), actual_shape,
+                                          &sliced, ctx->output_alloc_attr(i)));
+    TF_RETURN_IF_ERROR(CopyLeadingCorner(
+        ctx, *output, ctx->output_memory_type(i) == HOST_MEMORY, &sliced));
+    // The padded output is owned by `ctx` until it is released.
+    std::unique_ptr<Tensor> padded(ctx->release_output(i).tensor);
+    ctx->set_output(i, std::move(sliced));
+  }
+  return Status::OK();
+}
+
 Status LockVariables(absl::Span<VariableInfo*> variables) {
   std::vector<int> lock_order(variables.size());
   std::iota(lock_order.begin(), lock_order.end(), 0);
@@ -245,7 +388,8 @@ XlaComputationLaunchContext::PopulateInputs(
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    const std::map<int, Tensor>* padded_inputs) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
@@ -271,6 +415,12 @@ XlaComputationLaunchContext::PopulateInputs(
     const Tensor* t = is_resource_variable
                           ? resource_vars.at(arg_num)
                           : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    if (padded_inputs != nullptr) {
+      auto padded_input = padded_inputs->find(arg_num);
+      if (padded_input != padded_inputs->end()) {
+        t = &padded_input->second;
+      }
+    }
     CHECK(t);
     bool donate_buffer =
         t->RefCountIsOne() && is_updated_resource_variable &&
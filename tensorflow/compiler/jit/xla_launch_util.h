@@ -129,6 +129,20 @@ Status GetVariableInfosFromInputs(ResourceMgr* rm, DeviceBase* dev,
 // Returns pointers to inputs stored in `ctx`.
 std::vector<const Tensor*> InputsFromContext(OpKernelContext* ctx);
 
+// Copies the inputs of `ctx` that `bucketed_shapes` pads into zero-padded
+// tensors of the padded shape, keyed by argument number. Assumes that the first
+// `missing_ctx_input_prefix` arguments are not inputs of `ctx`.
+Status PadBucketedInputs(
+    OpKernelContext* ctx,
+    const XlaCompilationCache::BucketedShapes& bucketed_shapes,
+    int missing_ctx_input_prefix, std::map<int, Tensor>* padded_inputs);
+
+// Replaces the outputs of `ctx` whose dimensions have a padded size in
+// `bucketed_shapes` by their slice of the actual size.
+Status SliceBucketedOutputs(
+    OpKernelContext* ctx,
+    const XlaCompilationCache::BucketedShapes& bucketed_shapes);
+
 // Helper class to perform the marshalling of TensorFlow inputs and outputs to
 // ShapedBuffers suitable for passing to an XLA computation.
 class XlaComputationLaunchContext {
@@ -161,12 +175,16 @@ class XlaComputationLaunchContext {
   // missing and adjusts input indices accordingly.  All elements in kernel's
   // input_mapping must be greater than or equal to `missing_ctx_input_prefix`
   // (in other words, no inputs actually required by the kernel can be missing).
+  //
+  // Arguments in `padded_inputs`, if non-null, are read from there instead of
+  // from `ctx`.
   StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
       OpKernelContext* ctx,
       const XlaCompiler::CompilationResult* compilation_result,
       const std::map<int, const Tensor*>& resource_vars,
       int missing_ctx_input_prefix,
-      const xla::HloInputOutputAliasConfig& input_output_alias);
+      const xla::HloInputOutputAliasConfig& input_output_alias,
+      const std::map<int, Tensor>* padded_inputs = nullptr);
 
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
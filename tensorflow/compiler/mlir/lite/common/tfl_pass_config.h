@@ -40,6 +40,7 @@ struct PassConfig {
         enable_tflite_variables(false),
         disable_variable_freezing(false),
         unfold_large_splat_constant(false),
+        fuse_attention(false),
         guarantee_all_funcs_one_use(false),
         enable_hlo_to_tf_conversion(false) {}
 
@@ -77,6 +78,10 @@ struct PassConfig {
   // Whether to unfold large splat constant tensors and replace them with
   // fill operation.
   bool unfold_large_splat_constant;
+  // Whether to fuse scaled dot-product attention into the
+  // ScaledDotProductAttention custom op. The fused op is only emitted in
+  // float.
+  bool fuse_attention;
   // Whether to run the `GuaranteeAllFuncsOneUsePass` to ensure each function
   // has a single use.
   bool guarantee_all_funcs_one_use;
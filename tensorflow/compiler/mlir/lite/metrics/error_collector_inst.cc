@@ -15,10 +15,12 @@ limitations under the License.
 #include "tensorflow/compiler/mlir/lite/metrics/error_collector_inst.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
+#include "llvm/Support/Threading.h"
 #include "mlir/IR/Diagnostics.h"  // from @llvm-project
 #include "mlir/Pass/Pass.h"  // from @llvm-project
 
@@ -60,8 +62,10 @@ ErrorCollectorInstrumentation::ErrorCollectorInstrumentation(
       Location loc = diag.getLocation();
       std::string error_message = diag.str();
       std::string op_name, error_code;
-      if (loc_to_name_.count(loc)) {
-        op_name = loc_to_name_[loc];
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = loc_to_name_.find(loc);
+      if (it != loc_to_name_.end()) {
+        op_name = it->second;
       } else {
         op_name = extract_op_name_from_error_message(diag.str());
       }
@@ -86,7 +90,7 @@ ErrorCollectorInstrumentation::ErrorCollectorInstrumentation(
           ConverterErrorData::ErrorCode_Parse(error_code, &error_code_enum);
       if (!op_name.empty() || has_valid_error_code) {
         error_collector_->ReportError(NewConverterErrorData(
-            pass_name_, error_message, error_code_enum, op_name, loc));
+            CurrentPassName(), error_message, error_code_enum, op_name, loc));
       } else {
         common_error_message_ += diag.str();
         common_error_message_ += "\n";
@@ -96,45 +100,59 @@ ErrorCollectorInstrumentation::ErrorCollectorInstrumentation(
   }));
 }
 
-void ErrorCollectorInstrumentation::runBeforePass(Pass *pass,
-                                                  Operation *module) {
+std::string ErrorCollectorInstrumentation::CurrentPassName() {
+  auto it = pass_names_.find(llvm::get_threadid());
+  if (it == pass_names_.end() || it->second.empty()) return "";
+  return it->second.back();
+}
+
+void ErrorCollectorInstrumentation::runBeforePass(Pass *pass, Operation *op) {
   // Find the op names with tf or tfl dialect prefix, Ex: "tf.Abs" or "tfl.Abs".
-  auto collectOps = [this](Operation *op) {
-    const auto &op_name = op->getName().getStringRef().str();
+  // The walk happens outside of the lock as other threads may be running
+  // passes on other ops at the same time.
+  std::vector<std::pair<Location, std::string>> op_names;
+  auto collectOps = [&op_names](Operation *nested_op) {
+    std::string op_name = nested_op->getName().getStringRef().str();
     if (absl::StartsWith(op_name, "tf.") || absl::StartsWith(op_name, "tfl.")) {
-      loc_to_name_.emplace(op->getLoc(), op_name);
+      op_names.emplace_back(nested_op->getLoc(), std::move(op_name));
     }
   };
 
-  for (auto &region : module->getRegions()) {
+  for (auto &region : op->getRegions()) {
     region.walk(collectOps);
   }
 
-  pass_name_ = extract_pass_name(pass->getName().str());
-  error_collector_->Clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  loc_to_name_.insert(op_names.begin(), op_names.end());
+  pass_names_[llvm::get_threadid()].push_back(
+      extract_pass_name(pass->getName().str()));
+  if (op->getParentOp() == nullptr) error_collector_->Clear();
 }
 
-void ErrorCollectorInstrumentation::runAfterPass(Pass *pass,
-                                                 Operation *module) {
-  loc_to_name_.clear();
-  pass_name_.clear();
-  common_error_message_.clear();
-  error_collector_->Clear();
+void ErrorCollectorInstrumentation::runAfterPass(Pass *pass, Operation *op) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pass_names_[llvm::get_threadid()].pop_back();
+  if (op->getParentOp() == nullptr) {
+    loc_to_name_.clear();
+    common_error_message_.clear();
+    error_collector_->Clear();
+  }
 }
 
 void ErrorCollectorInstrumentation::runAfterPassFailed(Pass *pass,
-                                                       Operation *module) {
+                                                       Operation *op) {
+  std::lock_guard<std::mutex> lock(mutex_);
   // Create a new error if no errors collected yet.
   if (error_collector_->CollectedErrors().empty() &&
       !common_error_message_.empty()) {
     error_collector_->ReportError(NewConverterErrorData(
-        pass_name_, common_error_message_, ConverterErrorData::UNKNOWN,
-        /*op_name=*/"", module->getLoc()));
+        CurrentPassName(), common_error_message_, ConverterErrorData::UNKNOWN,
+        /*op_name=*/"", op->getLoc()));
   }
 
-  loc_to_name_.clear();
-  pass_name_.clear();
   common_error_message_.clear();
+  pass_names_[llvm::get_threadid()].pop_back();
+  if (op->getParentOp() == nullptr) loc_to_name_.clear();
 }
 
 }  // namespace TFL
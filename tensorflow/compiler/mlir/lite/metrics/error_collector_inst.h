@@ -15,6 +15,13 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_MLIR_LITE_METRICS_ERROR_COLLECTOR_INST_H_
 #define TENSORFLOW_COMPILER_MLIR_LITE_METRICS_ERROR_COLLECTOR_INST_H_
 
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "mlir/IR/Location.h"  // from @llvm-project
 #include "mlir/IR/Operation.h"  // from @llvm-project
 #include "mlir/Pass/PassInstrumentation.h"  // from @llvm-project
@@ -34,21 +41,30 @@ class ErrorCollectorInstrumentation : public PassInstrumentation {
   explicit ErrorCollectorInstrumentation(MLIRContext *context);
 
  private:
-  // Instrumentation hooks. These hooks don't need to be thread-safe. The pass
-  // manager runs each pass for the entire module, then it walks through
-  // each op in the module and runs the pass on them, may be in async mode.
-  void runBeforePass(Pass *pass, Operation *module) override;
-  void runAfterPass(Pass *pass, Operation *module) override;
-  void runAfterPassFailed(Pass *pass, Operation *module) override;
+  // Instrumentation hooks. When multithreading is enabled on the context, the
+  // pass manager runs the passes nested under the module, such as function
+  // passes, on several ops in parallel, so these hooks and the diagnostic
+  // handler may run concurrently. Collected errors are only cleared around
+  // passes on the top-level op, so that a nested pass that succeeds does not
+  // drop the errors of one that failed on another thread.
+  void runBeforePass(Pass *pass, Operation *op) override;
+  void runAfterPass(Pass *pass, Operation *op) override;
+  void runAfterPassFailed(Pass *pass, Operation *op) override;
+
+  // Returns the name of the innermost pass running on the calling thread.
+  std::string CurrentPassName();
 
   // The handler to capture error messages.
   std::unique_ptr<ScopedDiagnosticHandler> handler_;
+
+  // Guards the members below and the global ErrorCollector.
+  std::mutex mutex_;
   // A map from location to op name.
   std::unordered_map<Location, std::string, LocationHash> loc_to_name_;
   // Stores the error message for errors without op name and error code.
   std::string common_error_message_;
-  // Name of the running pass.
-  std::string pass_name_;
+  // Names of the passes running on each thread, the innermost last.
+  std::unordered_map<uint64_t, std::vector<std::string>> pass_names_;
   // Pointer to the global ErrorCollector instance.
   ErrorCollector *error_collector_;
 };
@@ -24,6 +24,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"  // from @llvm-project
 #include "mlir/IR/BuiltinOps.h"  // from @llvm-project
 #include "mlir/IR/Operation.h"  // from @llvm-project
 #include "mlir/Parser.h"  // from @llvm-project
@@ -85,6 +86,31 @@ class MockFailurePass
   };
 };
 
+// MockFunctionFailurePass reports errors and fails on every function.
+class MockFunctionFailurePass
+    : public PassWrapper<MockFunctionFailurePass, OperationPass<FuncOp>> {
+  void getDependentDialects(DialectRegistry& registry) const override {
+    registry.insert<TF::TensorFlowDialect>();
+  }
+
+ public:
+  explicit MockFunctionFailurePass() {}
+
+ private:
+  void runOnOperation() override {
+    getOperation().walk([](Operation* nestedOp) {
+      if (nestedOp->getName().getStringRef().str().rfind("tf.") != -1) {
+        AttachErrorCode(
+            nestedOp->emitError()
+                << "Failed at " << nestedOp->getName().getStringRef().str()
+                << " op",
+            tflite::metrics::ConverterErrorData::ERROR_NEEDS_FLEX_OPS);
+      }
+    });
+    signalPassFailure();
+  };
+};
+
 StatusOr<OwningModuleRef> LoadModule(MLIRContext* context,
                                      const std::string& file_name) {
   std::string error_message;
@@ -188,6 +214,45 @@ TEST(ErrorCollectorTest, TessFailurePass) {
   EXPECT_THAT(locations, Contains(testing::HasSubstr("line: 4")));
   EXPECT_THAT(locations, Contains(testing::HasSubstr("column: 10")));
 }
+
+TEST(ErrorCollectorTest, TestFailureFunctionPassesInParallel) {
+  using tflite::metrics::ConverterErrorData;
+  MLIRContext context;
+  context.allowUnregisteredDialects();
+  context.enableMultithreading();
+  context.loadDialect<StandardOpsDialect>();
+
+  constexpr int kNumFunctions = 16;
+  std::string module_string;
+  for (int i = 0; i < kNumFunctions; ++i) {
+    module_string += "func @f" + std::to_string(i) +
+                     "() -> tensor<i32> {\n"
+                     "  %0 = \"tf.Const\"() {value = dense<1> : tensor<i32>} : "
+                     "() -> tensor<i32>\n"
+                     "  return %0 : tensor<i32>\n"
+                     "}\n";
+  }
+  OwningModuleRef module = parseSourceString(module_string, &context);
+  ASSERT_TRUE(module);
+
+  PassManager pm(&context, OpPassManager::Nesting::Implicit);
+  pm.addNestedPass<FuncOp>(std::make_unique<MockFunctionFailurePass>());
+
+  pm.addInstrumentation(
+      std::make_unique<ErrorCollectorInstrumentation>(&context));
+  EXPECT_EQ(succeeded(pm.run(module.get())), false);
+
+  // Every function reports its own error, none is dropped by the passes that
+  // ran concurrently on the other functions.
+  auto collected_errors =
+      ErrorCollector::GetErrorCollector()->CollectedErrors();
+  EXPECT_EQ(collected_errors.size(), kNumFunctions);
+  for (const auto& error : collected_errors) {
+    EXPECT_EQ(error.subcomponent(), "MockFunctionFailurePass");
+    EXPECT_EQ(error.operator_().name(), "tf.Const");
+    EXPECT_EQ(error.error_code(), ConverterErrorData::ERROR_NEEDS_FLEX_OPS);
+  }
+}
 }  // namespace
 }  // namespace TFL
 }  // namespace mlir
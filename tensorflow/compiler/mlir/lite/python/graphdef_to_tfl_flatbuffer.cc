@@ -105,6 +105,7 @@ Status ConvertGraphDefToTFLiteFlatBuffer(const toco::ModelFlags& model_flags,
   }
   pass_config.unfold_large_splat_constant =
       toco_flags.unfold_large_splat_constant();
+  pass_config.fuse_attention = toco_flags.fuse_attention();
 
   return internal::ConvertMLIRToTFLiteFlatBuffer(
       model_flags, toco_flags, std::move(module), pass_config,
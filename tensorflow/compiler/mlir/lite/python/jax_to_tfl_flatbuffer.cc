@@ -158,6 +158,7 @@ Status ConvertJaxToTFLiteFlatBuffer(const std::string& input,
   }
   pass_config.unfold_large_splat_constant =
       toco_flags.unfold_large_splat_constant();
+  pass_config.fuse_attention = toco_flags.fuse_attention();
   pass_config.enable_hlo_to_tf_conversion = true;
 
   mlir::OwningModuleRef module;
@@ -0,0 +1,63 @@
+// RUN: tf-opt %s -tfl-fuse-attention | FileCheck %s
+
+// CHECK-LABEL: fuseKerasAttention
+func @fuseKerasAttention(%arg0: tensor<2x4x8x16xf32>, %arg1: tensor<2x4x10x16xf32>, %arg2: tensor<2x4x10x32xf32>, %arg3: tensor<2x1x8x10xf32>) -> tensor<2x4x8x32xf32> {
+  %cst = constant dense<2.500000e-01> : tensor<f32>
+  %0 = "tfl.mul"(%arg0, %cst) {fused_activation_function = "NONE"} : (tensor<2x4x8x16xf32>, tensor<f32>) -> tensor<2x4x8x16xf32>
+  %1 = "tfl.batch_matmul"(%0, %arg1) {adj_x = false, adj_y = true} : (tensor<2x4x8x16xf32>, tensor<2x4x10x16xf32>) -> tensor<2x4x8x10xf32>
+  %2 = "tfl.add"(%1, %arg3) {fused_activation_function = "NONE"} : (tensor<2x4x8x10xf32>, tensor<2x1x8x10xf32>) -> tensor<2x4x8x10xf32>
+  %3 = "tfl.softmax"(%2) {beta = 1.000000e+00 : f32} : (tensor<2x4x8x10xf32>) -> tensor<2x4x8x10xf32>
+  %4 = "tfl.batch_matmul"(%3, %arg2) {adj_x = false, adj_y = false} : (tensor<2x4x8x10xf32>, tensor<2x4x10x32xf32>) -> tensor<2x4x8x32xf32>
+  return %4 : tensor<2x4x8x32xf32>
+
+// CHECK: %[[RESULT:.*]] = "tfl.custom"(%arg0, %arg1, %arg2, %arg3) {custom_code = "ScaledDotProductAttention", custom_option = opaque<"tfl", "0x{{.*}}"> : tensor<{{[0-9]+}}xi8>} : (tensor<2x4x8x16xf32>, tensor<2x4x10x16xf32>, tensor<2x4x10x32xf32>, tensor<2x1x8x10xf32>) -> tensor<2x4x8x32xf32>
+// CHECK-NOT: tfl.softmax
+// CHECK: return %[[RESULT]]
+}
+
+// CHECK-LABEL: fuseScaledScoresWithoutMask
+func @fuseScaledScoresWithoutMask(%arg0: tensor<3x8x16xf32>, %arg1: tensor<3x10x16xf32>, %arg2: tensor<3x10x16xf32>) -> tensor<3x8x16xf32> {
+  %cst = constant dense<2.500000e-01> : tensor<f32>
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true} : (tensor<3x8x16xf32>, tensor<3x10x16xf32>) -> tensor<3x8x10xf32>
+  %1 = "tfl.mul"(%0, %cst) {fused_activation_function = "NONE"} : (tensor<3x8x10xf32>, tensor<f32>) -> tensor<3x8x10xf32>
+  %2 = "tfl.softmax"(%1) {beta = 2.000000e+00 : f32} : (tensor<3x8x10xf32>) -> tensor<3x8x10xf32>
+  %3 = "tfl.batch_matmul"(%2, %arg2) {adj_x = false, adj_y = false} : (tensor<3x8x10xf32>, tensor<3x10x16xf32>) -> tensor<3x8x16xf32>
+  return %3 : tensor<3x8x16xf32>
+
+// CHECK: %[[RESULT:.*]] = "tfl.custom"(%arg0, %arg1, %arg2) {custom_code = "ScaledDotProductAttention"
+// CHECK-NOT: tfl.mul
+// CHECK: return %[[RESULT]]
+}
+
+// CHECK-LABEL: notFuseWithoutTransposedKey
+func @notFuseWithoutTransposedKey(%arg0: tensor<3x8x16xf32>, %arg1: tensor<3x16x10xf32>, %arg2: tensor<3x10x16xf32>) -> tensor<3x8x16xf32> {
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = false} : (tensor<3x8x16xf32>, tensor<3x16x10xf32>) -> tensor<3x8x10xf32>
+  %1 = "tfl.softmax"(%0) {beta = 1.000000e+00 : f32} : (tensor<3x8x10xf32>) -> tensor<3x8x10xf32>
+  %2 = "tfl.batch_matmul"(%1, %arg2) {adj_x = false, adj_y = false} : (tensor<3x8x10xf32>, tensor<3x10x16xf32>) -> tensor<3x8x16xf32>
+  return %2 : tensor<3x8x16xf32>
+
+// CHECK-NOT: tfl.custom
+// CHECK: tfl.softmax
+}
+
+// CHECK-LABEL: notFuseBroadcastBatch
+func @notFuseBroadcastBatch(%arg0: tensor<3x8x16xf32>, %arg1: tensor<1x10x16xf32>, %arg2: tensor<3x10x16xf32>) -> tensor<3x8x16xf32> {
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true} : (tensor<3x8x16xf32>, tensor<1x10x16xf32>) -> tensor<3x8x10xf32>
+  %1 = "tfl.softmax"(%0) {beta = 1.000000e+00 : f32} : (tensor<3x8x10xf32>) -> tensor<3x8x10xf32>
+  %2 = "tfl.batch_matmul"(%1, %arg2) {adj_x = false, adj_y = false} : (tensor<3x8x10xf32>, tensor<3x10x16xf32>) -> tensor<3x8x16xf32>
+  return %2 : tensor<3x8x16xf32>
+
+// CHECK-NOT: tfl.custom
+// CHECK: tfl.softmax
+}
+
+// CHECK-LABEL: notFuseSharedScores
+func @notFuseSharedScores(%arg0: tensor<3x8x16xf32>, %arg1: tensor<3x10x16xf32>, %arg2: tensor<3x10x16xf32>) -> (tensor<3x8x16xf32>, tensor<3x8x10xf32>) {
+  %0 = "tfl.batch_matmul"(%arg0, %arg1) {adj_x = false, adj_y = true} : (tensor<3x8x16xf32>, tensor<3x10x16xf32>) -> tensor<3x8x10xf32>
+  %1 = "tfl.softmax"(%0) {beta = 1.000000e+00 : f32} : (tensor<3x8x10xf32>) -> tensor<3x8x10xf32>
+  %2 = "tfl.batch_matmul"(%1, %arg2) {adj_x = false, adj_y = false} : (tensor<3x8x10xf32>, tensor<3x10x16xf32>) -> tensor<3x8x16xf32>
+  return %2, %1 : tensor<3x8x16xf32>, tensor<3x8x10xf32>
+
+// CHECK-NOT: tfl.custom
+// CHECK: tfl.softmax
+}
@@ -287,6 +287,10 @@ void AddTFToTFLConversionPasses(const toco::ModelFlags& model_flags,
     pass_manager->addPass(mlir::TFL::CreateLegalizeHashTablesPass());
     pass_manager->addNestedPass<mlir::FuncOp>(
         mlir::TFL::CreateOptimizePass(/*enable_canonicalization=*/true));
+    if (pass_config.fuse_attention) {
+      pass_manager->addNestedPass<mlir::FuncOp>(
+          mlir::TFL::CreateFuseAttentionPass());
+    }
     // This pass operates on TensorFlow ops but is triggered after legalization
     // so that it can target constants introduced once TensorFlow Identity ops
     // are removed during legalization.
@@ -274,6 +274,7 @@ int main(int argc, char **argv) {
   pass_config.legalize_tf_while = convert_tf_while_to_tfl_while;
   pass_config.unfold_batch_matmul = unfold_batchmatmul;
   pass_config.unfold_large_splat_constant = unfold_large_splat_constant;
+  pass_config.fuse_attention = fuse_attention;
   pass_config.guarantee_all_funcs_one_use = guarantee_all_funcs_one_use;
 
   if (enable_hlo_to_tf_conversion) {
@@ -139,6 +139,13 @@ opt<bool> unfold_large_splat_constant(
                    "the generated model size."),
     llvm::cl::init(false));
 
+// NOLINTNEXTLINE
+opt<bool> fuse_attention(
+    "fuse-attention",
+    llvm::cl::desc("Whether to fuse scaled dot-product attention into the "
+                   "ScaledDotProductAttention custom op."),
+    llvm::cl::init(false));
+
 // NOLINTNEXTLINE
 opt<bool> guarantee_all_funcs_one_use(
     "guarantee-all-funcs-one-use",
@@ -0,0 +1,213 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// This transformation pass fuses the scaled dot-product attention that Keras
+// attention layers are lowered to,
+//
+//   batch_matmul(softmax(batch_matmul(query, key, adj_y) * scale + mask),
+//                value)
+//
+// into a ScaledDotProductAttention custom op, which computes it tile by tile
+// instead of materializing the scores, see
+// tensorflow/lite/kernels/scaled_dot_product_attention.cc.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/Attributes.h"  // from @llvm-project
+#include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
+#include "mlir/IR/BuiltinTypes.h"  // from @llvm-project
+#include "mlir/IR/Matchers.h"  // from @llvm-project
+#include "mlir/IR/PatternMatch.h"  // from @llvm-project
+#include "mlir/Pass/Pass.h"  // from @llvm-project
+#include "mlir/Support/LogicalResult.h"  // from @llvm-project
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/lite/ir/tfl_ops.h"
+#include "tensorflow/compiler/mlir/lite/transforms/passes.h"
+
+namespace mlir {
+namespace TFL {
+namespace {
+
+constexpr char kScaledDotProductAttention[] = "ScaledDotProductAttention";
+
+inline OpaqueElementsAttr CustomOption(OpBuilder* builder,
+                                       const std::string& content) {
+  ShapedType type = RankedTensorType::get(
+      {static_cast<int64_t>(content.size())}, builder->getIntegerType(8));
+  return OpaqueElementsAttr::get(builder->getContext()->getLoadedDialect("tfl"),
+                                 type,
+                                 StringRef(content.data(), content.size()));
+}
+
+// Matches `value` = `input` * `scale`, with a splat constant scale that
+// doesn't broadcast the input.
+bool MatchScalarMul(Value value, Value* input, float* scale) {
+  auto mul_op = value.getDefiningOp<TFL::MulOp>();
+  if (!mul_op || !mul_op->hasOneUse() ||
+      mul_op.fused_activation_function() != "NONE") {
+    return false;
+  }
+  for (int i = 0; i < 2; ++i) {
+    DenseFPElementsAttr cst;
+    Value other = mul_op.getOperand(1 - i);
+    if (!matchPattern(mul_op.getOperand(i), m_Constant(&cst)) ||
+        !cst.isSplat() || other.getType() != mul_op.getType()) {
+      continue;
+    }
+    *input = other;
+    *scale = cst.getSplatValue<APFloat>().convertToFloat();
+    return true;
+  }
+  return false;
+}
+
+// Returns whether `mask` is a float tensor that broadcasts to `scores`, with
+// static shapes.
+bool IsBroadcastableMask(Value mask, RankedTensorType scores_type) {
+  auto mask_type = mask.getType().dyn_cast<RankedTensorType>();
+  if (!mask_type || !mask_type.getElementType().isF32() ||
+      !mask_type.hasStaticShape() || !scores_type.hasStaticShape() ||
+      mask_type.getRank() > scores_type.getRank()) {
+    return false;
+  }
+  const int offset = scores_type.getRank() - mask_type.getRank();
+  for (int i = 0; i < mask_type.getRank(); ++i) {
+    const int64_t size = mask_type.getDimSize(i);
+    if (size != 1 && size != scores_type.getDimSize(offset + i)) return false;
+  }
+  return true;
+}
+
+struct FuseScaledDotProductAttention
+    : public OpRewritePattern<TFL::BatchMatMulOp> {
+  using OpRewritePattern<TFL::BatchMatMulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(TFL::BatchMatMulOp op,
+                                PatternRewriter& rewriter) const override {
+    if (op.adj_x() || op.adj_y()) return failure();
+    auto softmax_op = op.x().getDefiningOp<TFL::SoftmaxOp>();
+    if (!softmax_op || !softmax_op->hasOneUse()) return failure();
+    float scale = softmax_op.beta().convertToFloat();
+
+    // The mask is added to the scores, which may be scaled first.
+    Value scores = softmax_op.input();
+    Value mask;
+    if (auto add_op = scores.getDefiningOp<TFL::AddOp>()) {
+      if (!add_op->hasOneUse() ||
+          add_op.fused_activation_function() != "NONE") {
+        return failure();
+      }
+      scores = add_op.lhs();
+      mask = add_op.rhs();
+      if (!scores.getDefiningOp<TFL::BatchMatMulOp>() &&
+          !scores.getDefiningOp<TFL::MulOp>()) {
+        std::swap(scores, mask);
+      }
+    }
+    float scores_scale;
+    if (MatchScalarMul(scores, &scores, &scores_scale)) scale *= scores_scale;
+
+    auto scores_op = scores.getDefiningOp<TFL::BatchMatMulOp>();
+    if (!scores_op || !scores_op->hasOneUse() || scores_op.adj_x() ||
+        !scores_op.adj_y()) {
+      return failure();
+    }
+    // Keras scales the queries rather than the scores.
+    Value query = scores_op.x();
+    float query_scale;
+    if (MatchScalarMul(query, &query, &query_scale)) scale *= query_scale;
+    Value key = scores_op.y();
+    Value value = op.y();
+
+    // The kernel doesn't broadcast the batch dimensions, and only supports
+    // float tensors here: the quantized variants aren't produced by the
+    // quantization passes.
+    auto query_type = query.getType().dyn_cast<RankedTensorType>();
+    auto key_type = key.getType().dyn_cast<RankedTensorType>();
+    auto value_type = value.getType().dyn_cast<RankedTensorType>();
+    auto scores_type = scores.getType().dyn_cast<RankedTensorType>();
+    auto output_type = op.getType().dyn_cast<RankedTensorType>();
+    if (!query_type || !key_type || !value_type || !scores_type ||
+        !output_type || !query_type.getElementType().isF32() ||
+        !key_type.getElementType().isF32() ||
+        !value_type.getElementType().isF32() ||
+        !output_type.getElementType().isF32()) {
+      return failure();
+    }
+    const int64_t rank = query_type.getRank();
+    if (rank < 2 || key_type.getRank() != rank ||
+        value_type.getRank() != rank || output_type.getRank() != rank) {
+      return failure();
+    }
+    for (int64_t i = 0; i < rank - 2; ++i) {
+      const int64_t size = query_type.getDimSize(i);
+      if (size == ShapedType::kDynamicSize || key_type.getDimSize(i) != size ||
+          value_type.getDimSize(i) != size) {
+        return failure();
+      }
+    }
+    if (mask && !IsBroadcastableMask(mask, scores_type)) return failure();
+
+    flexbuffers::Builder fbb;
+    size_t start_map = fbb.StartMap();
+    fbb.Float("scale", scale);
+    fbb.EndMap(start_map);
+    fbb.Finish();
+    const std::vector<uint8_t>& buffer = fbb.GetBuffer();
+    const std::string custom_option(buffer.begin(), buffer.end());
+
+    llvm::SmallVector<Value, 4> operands = {query, key, value};
+    if (mask) operands.push_back(mask);
+    auto custom_op = rewriter.create<TFL::CustomOp>(
+        op.getLoc(), op->getResultTypes(), ValueRange(operands),
+        kScaledDotProductAttention, CustomOption(&rewriter, custom_option));
+    rewriter.replaceOp(op, custom_op.getResults());
+    return success();
+  }
+};
+
+struct FuseAttentionPass : public PassWrapper<FuseAttentionPass, FunctionPass> {
+  void runOnFunction() override;
+
+  StringRef getArgument() const final { return "tfl-fuse-attention"; }
+  StringRef getDescription() const final {
+    return "Fuse scaled dot-product attention into a custom op.";
+  }
+};
+
+void FuseAttentionPass::runOnFunction() {
+  OwningRewritePatternList patterns(&getContext());
+  auto func = getFunction();
+  patterns.insert<FuseScaledDotProductAttention>(func.getContext());
+  if (failed(applyPatternsAndFoldGreedily(func, std::move(patterns)))) {
+    signalPassFailure();
+  }
+}
+}  // namespace
+
+// Creates an instance of the TensorFlow Lite attention fusion pass.
+std::unique_ptr<OperationPass<FuncOp>> CreateFuseAttentionPass() {
+  return std::make_unique<FuseAttentionPass>();
+}
+
+static PassRegistration<FuseAttentionPass> pass;
+
+}  // namespace TFL
+}  // namespace mlir
@@ -152,6 +152,10 @@ std::unique_ptr<OperationPass<FuncOp>> CreateGetArithmeticCountPass();
 // Creates unfold large constant pass, which will replace large splat constant
 // tensors with fill op.
 std::unique_ptr<OperationPass<ModuleOp>> CreateUnfoldLargeSplatConstantPass();
+
+// Creates a pass which fuses scaled dot-product attention into the
+// ScaledDotProductAttention custom op.
+std::unique_ptr<OperationPass<FuncOp>> CreateFuseAttentionPass();
 }  // namespace TFL
 
 }  // namespace mlir
@@ -17,7 +17,9 @@ limitations under the License.
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/compiler/tf2tensorrt/common/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_allocator.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_instance.pb.h"  // NOLINT
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_logger.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 
 #if GOOGLE_CUDA && GOOGLE_TENSORRT
@@ -40,6 +43,47 @@ namespace tensorflow {
 namespace tensorrt {
 using ::nvinfer1::IRuntime;
 
+namespace {
+
+string GetLoadedTensorRTVersionString() {
+  return absl::StrJoin(GetLoadedTensorRTVersion(), ".");
+}
+
+// Returns the name of the GPU the kernel runs on, or an empty string if it is
+// not known.
+string GetDeviceName(OpKernelContext* ctx) {
+  const DeviceBase::GpuDeviceInfo* gpu_device_info =
+      ctx->device()->tensorflow_gpu_device_info();
+  if (gpu_device_info == nullptr || gpu_device_info->stream == nullptr) {
+    return "";
+  }
+  return gpu_device_info->stream->parent()->GetDeviceDescription().name();
+}
+
+// Returns an error if the serialized engine was built by a different TensorRT
+// version or on a different GPU model, in which case deserializing it fails or,
+// worse, yields an engine that is not tuned for this GPU. Engines serialized
+// before this information was recorded are assumed to be compatible.
+Status CheckEngineCompatibility(const TRTEngineInstance& engine_instance,
+                                const string& device_name) {
+  const string trt_version = GetLoadedTensorRTVersionString();
+  if (!engine_instance.trt_version().empty() &&
+      engine_instance.trt_version() != trt_version) {
+    return errors::FailedPrecondition(
+        "The engine was built with TensorRT ", engine_instance.trt_version(),
+        " but TensorRT ", trt_version, " is loaded.");
+  }
+  if (!engine_instance.device_name().empty() && !device_name.empty() &&
+      engine_instance.device_name() != device_name) {
+    return errors::FailedPrecondition("The engine was built on ",
+                                      engine_instance.device_name(),
+                                      " but runs on ", device_name, ".");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 class CreateTRTResourceHandle : public OpKernel {
  public:
   explicit CreateTRTResourceHandle(OpKernelConstruction* ctx) : OpKernel(ctx) {
@@ -117,15 +161,28 @@ class InitializeTRTResource : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->env()->NewRandomAccessFile(filename, &file));
     auto reader = absl::make_unique<io::RecordReader>(file.get());
 
+    const string device_name = GetDeviceName(ctx);
     uint64 offset = 0;
     int num_loaded_engine = 0;
+    int num_skipped_engine = 0;
     do {
       tstring record;
       Status status = reader->ReadRecord(&offset, &record);
       if (errors::IsOutOfRange(status)) break;
+      OP_REQUIRES_OK(ctx, status);
 
       TRTEngineInstance engine_instance;
       engine_instance.ParseFromString(record);
+      // Incompatible engines are left out of the cache, so that the
+      // TRTEngineOp builds them again the first time they are needed.
+      status = CheckEngineCompatibility(engine_instance, device_name);
+      if (!status.ok()) {
+        LOG_WARNING_WITH_PREFIX << "Not loading a serialized engine for op "
+                                << handle.name() << ": "
+                                << status.error_message();
+        ++num_skipped_engine;
+        continue;
+      }
       std::vector<TensorShape> engine_input_shapes;
       for (const TensorShapeProto& shape : engine_instance.input_shapes()) {
         engine_input_shapes.emplace_back(shape);
@@ -139,6 +196,12 @@ class InitializeTRTResource : public OpKernel {
               engine_instance.serialized_engine().c_str(),
               engine_instance.serialized_engine().size(), nullptr));
       auto raw_engine = engine.get();
+      if (raw_engine == nullptr) {
+        LOG_WARNING_WITH_PREFIX << "Failed to deserialize an engine for op "
+                                << handle.name();
+        ++num_skipped_engine;
+        continue;
+      }
       std::vector<ExecutionContext> ctx_vec;
       if (num_loaded_engine == 0) {
         // Restore profiles if there are any. Currently only 1 engine is allowed
@@ -159,7 +222,8 @@ class InitializeTRTResource : public OpKernel {
     } while (1);
     VLOG(1) << "Loaded " << num_loaded_engine << " TRT engines for op "
             << handle.name() << " on device " << ctx->device()->name()
-            << " from file " << filename;
+            << " from file " << filename << ", skipped " << num_skipped_engine
+            << " engines";
   }
 
  private:
@@ -201,6 +265,8 @@ class SerializeTRTResource : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->env()->NewWritableFile(filename, &file));
     auto writer = absl::make_unique<io::RecordWriter>(file.get());
 
+    const string trt_version = GetLoadedTensorRTVersionString();
+    const string device_name = GetDeviceName(ctx);
     int num_serialized_engines = 0;
     for (const auto& pair : resource->cache_) {
       // Ignore engines that failed to build.
@@ -218,6 +284,8 @@ class SerializeTRTResource : public OpKernel {
           engine->cuda_engine->serialize());
       engine_instance.set_serialized_engine(engine_data->data(),
                                             engine_data->size());
+      engine_instance.set_trt_version(trt_version);
+      engine_instance.set_device_name(device_name);
 
       OP_REQUIRES_OK(ctx,
                      writer->WriteRecord(engine_instance.SerializeAsString()));
@@ -20,7 +20,9 @@ limitations under the License.
 
 #include "absl/container/inlined_vector.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/tf2tensorrt/common/datavec.h"
+#include "tensorflow/compiler/tf2tensorrt/common/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/convert/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_instance.pb.h"  // NOLINT
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_logger.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -324,6 +327,9 @@ TEST_P(TRTEngineResourceOpsTest, Basic) {
   EXPECT_EQ(2, engine_instance.input_shapes(0).dim_size());
   EXPECT_EQ(1, engine_instance.input_shapes(0).dim(0).size());
   EXPECT_EQ(1, engine_instance.input_shapes(0).dim(1).size());
+  EXPECT_EQ(absl::StrJoin(GetLoadedTensorRTVersion(), "."),
+            engine_instance.trt_version());
+  EXPECT_FALSE(engine_instance.device_name().empty());
   EXPECT_TRUE(errors::IsOutOfRange(reader->ReadRecord(&offset, &record)));
 
   // Recreate the resource and use the file with the serialized engine to
@@ -393,6 +399,33 @@ TEST_P(TRTEngineResourceOpsTest, Basic) {
   // to the resource to destroy resource.
   EXPECT_TRUE(resource->RefCountIsOne());
   resource->Unref();
+
+  // Rewrite the engine as if it was built by another TensorRT version.
+  const string mismatch_filename =
+      io::JoinPath(testing::TmpDir(), "trt_engine_file_other_version");
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(env->NewWritableFile(mismatch_filename, &file));
+    io::RecordWriter writer(file.get());
+    engine_instance.set_trt_version("0.0.0");
+    TF_ASSERT_OK(writer.WriteRecord(engine_instance.SerializeAsString()));
+    TF_ASSERT_OK(writer.Close());
+  }
+
+  // Check that initializing the resource from it skips the engine.
+  Reset();
+  TF_ASSERT_OK(NodeDefBuilder("op", "InitializeTRTResource")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("max_cached_engines_count", 1)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<ResourceHandle>(TensorShape({}), {handle});
+  AddInputFromArray<tstring>(TensorShape({}), {mismatch_filename});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(rm->Lookup(container, resource_name, &resource).ok());
+  EXPECT_EQ(0, resource->cache_.size());
+  resource->Unref();
 }
 
 }  // namespace tensorrt
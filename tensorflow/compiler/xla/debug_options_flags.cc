@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_map.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/compiler/xla/debug_options_parsers.h"
@@ -75,6 +76,14 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_force_host_platform_device_count(1);
   opts.set_xla_gpu_deterministic_reductions(true);
   opts.set_xla_gpu_all_reduce_combine_threshold_bytes(30 * 1024 * 1024);
+  opts.set_xla_gpu_enable_latency_hiding_scheduler(false);
+  opts.set_xla_gpu_latency_hiding_scheduler_memory_limit(1024 * 1024 * 1024);
+  opts.set_xla_gpu_enable_auto_sharding(false);
+  opts.set_xla_hlo_pass_parallelism(1);
+  opts.set_xla_buffer_assignment_fast_heap_simulation(false);
+  opts.set_xla_gpu_host_offload_prefetch_bytes(0);
+  opts.set_xla_gpu_enable_while_loop_all_reduce_pipelining(false);
+  opts.set_xla_gpu_enable_cuda_graphs(false);
   opts.set_xla_cpu_enable_xprof_traceme(false);
   opts.set_xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found(false);
   opts.set_xla_multiheap_size_constraint_per_heap(-1);
@@ -176,6 +185,20 @@ static void AllocateFlags() {
         return true;
       };
 
+  // Custom "sub-parser" lambda for xla_gpu_host_offloaded_parameters.
+  auto setter_for_xla_gpu_host_offloaded_parameters =
+      [](string comma_separated_values) {
+        for (absl::string_view value :
+             absl::StrSplit(comma_separated_values, ',', absl::SkipEmpty())) {
+          int64_t parameter_number;
+          if (!absl::SimpleAtoi(value, &parameter_number)) {
+            return false;
+          }
+          flag_values->add_xla_gpu_host_offloaded_parameters(parameter_number);
+        }
+        return true;
+      };
+
   // Custom "sub-parser" lambda for xla_gpu_ptx_file.
   auto setter_for_xla_gpu_ptx_file = [](string value) {
     flag_values->add_xla_gpu_ptx_file(value);
@@ -596,6 +619,75 @@ static void AllocateFlags() {
       flag_values->xla_gpu_algorithm_denylist_path(),
       "An AlgorithmDenylist text proto file as a denylist of convolutions to "
       "avoid to use."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_load_autotune_results_from",
+      string_setter_for(&DebugOptions::set_xla_gpu_load_autotune_results_from),
+      flag_values->xla_gpu_load_autotune_results_from(),
+      "File to load GEMM and convolution autotuning results from. "
+      "Instructions with a result in the file are not autotuned again."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_dump_autotune_results_to",
+      string_setter_for(&DebugOptions::set_xla_gpu_dump_autotune_results_to),
+      flag_values->xla_gpu_dump_autotune_results_to(),
+      "File to write all GEMM and convolution autotuning results to, in the "
+      "format read by --xla_gpu_load_autotune_results_from."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_latency_hiding_scheduler",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_latency_hiding_scheduler),
+      flag_values->xla_gpu_enable_latency_hiding_scheduler(),
+      "Overlap async collectives with enough independent compute to hide "
+      "their estimated duration."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_latency_hiding_scheduler_memory_limit",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_latency_hiding_scheduler_memory_limit),
+      flag_values->xla_gpu_latency_hiding_scheduler_memory_limit(),
+      "Upper bound on the bytes of async collective buffers the latency "
+      "hiding scheduler keeps in flight at once."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_auto_sharding",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_auto_sharding),
+      flag_values->xla_gpu_enable_auto_sharding(),
+      "Search shardings for the instructions of SPMD partitioned modules "
+      "that have none from cost estimates."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_hlo_pass_parallelism",
+      int32_setter_for(&DebugOptions::set_xla_hlo_pass_parallelism),
+      flag_values->xla_hlo_pass_parallelism(),
+      "Number of threads that passes rewriting single computations use to run "
+      "on the computations of a module concurrently."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_buffer_assignment_fast_heap_simulation",
+      bool_setter_for(
+          &DebugOptions::set_xla_buffer_assignment_fast_heap_simulation),
+      flag_values->xla_buffer_assignment_fast_heap_simulation(),
+      "Assign sequentially ordered buffers with a single size-ordered best-fit "
+      "heap. Faster, but may use more memory."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_host_offloaded_parameters",
+      setter_for_xla_gpu_host_offloaded_parameters, "",
+      "Comma-separated list of the entry parameters that are passed in pinned "
+      "host memory."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_host_offload_prefetch_bytes",
+      int64_setter_for(&DebugOptions::set_xla_gpu_host_offload_prefetch_bytes),
+      flag_values->xla_gpu_host_offload_prefetch_bytes(),
+      "Bytes of device memory that host offloaded parameters may be prefetched "
+      "into at once. 0 disables prefetching."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_while_loop_all_reduce_pipelining",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_while_loop_all_reduce_pipelining),
+      flag_values->xla_gpu_enable_while_loop_all_reduce_pipelining(),
+      "Pipeline loop carried all-reduces across the back-edge of while loops "
+      "so they overlap the next iteration."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Capture runs of kernels into CUDA graphs the first time an executable "
+      "runs and replay them afterwards."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_deterministic_reductions",
       bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_reductions),
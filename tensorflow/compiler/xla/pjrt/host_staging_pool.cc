@@ -0,0 +1,71 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/pjrt/host_staging_pool.h"
+
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+HostStagingPool::HostStagingPool(tensorflow::Allocator* allocator,
+                                 size_t chunk_size, int num_chunks)
+    : allocator_(allocator), chunk_size_(chunk_size), num_chunks_(num_chunks) {
+  CHECK_GT(chunk_size_, 0);
+  CHECK_GT(num_chunks_, 0);
+}
+
+HostStagingPool::~HostStagingPool() {
+  absl::MutexLock lock(&mu_);
+  // Chunks can only be missing if a stream failed before the transfers that
+  // hold them completed; the memory is leaked rather than freed while a DMA
+  // may still read from it.
+  if (free_chunks_.size() != num_allocated_) {
+    LOG(ERROR) << num_allocated_ - free_chunks_.size()
+               << " host staging chunks are still in use.";
+  }
+  for (void* chunk : free_chunks_) {
+    allocator_->DeallocateRaw(chunk);
+  }
+}
+
+StatusOr<void*> HostStagingPool::Acquire() {
+  absl::MutexLock lock(&mu_);
+  auto chunk_available = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !free_chunks_.empty() || num_allocated_ < num_chunks_;
+  };
+  mu_.Await(absl::Condition(&chunk_available));
+  if (!free_chunks_.empty()) {
+    void* chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+    return chunk;
+  }
+  void* chunk = allocator_->AllocateRaw(
+      tensorflow::Allocator::kAllocatorAlignment, chunk_size_);
+  if (chunk == nullptr) {
+    return ResourceExhausted(
+        "Failed to allocate a host staging buffer of %d bytes.", chunk_size_);
+  }
+  ++num_allocated_;
+  return chunk;
+}
+
+void HostStagingPool::Release(void* chunk) {
+  absl::MutexLock lock(&mu_);
+  DCHECK_LT(free_chunks_.size(), num_allocated_);
+  free_chunks_.push_back(chunk);
+}
+
+}  // namespace xla
@@ -0,0 +1,64 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_PJRT_HOST_STAGING_POOL_H_
+#define TENSORFLOW_COMPILER_XLA_PJRT_HOST_STAGING_POOL_H_
+
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/framework/allocator.h"
+
+namespace xla {
+
+// A bounded set of equally sized host buffers ("chunks") that are reused to
+// stage host-to-device transfers. On GPU the chunks come from the pinned host
+// memory allocator, so a transfer of any size needs at most
+// `num_chunks * chunk_size` bytes of pinned memory, and copying the next chunk
+// into pinned memory overlaps with the DMA of the previous one.
+//
+// This class is thread-safe.
+class HostStagingPool {
+ public:
+  HostStagingPool(tensorflow::Allocator* allocator, size_t chunk_size,
+                  int num_chunks);
+  ~HostStagingPool();
+
+  HostStagingPool(const HostStagingPool&) = delete;
+  HostStagingPool& operator=(const HostStagingPool&) = delete;
+
+  size_t chunk_size() const { return chunk_size_; }
+
+  // Returns a chunk of `chunk_size()` bytes. Chunks are allocated lazily, up to
+  // `num_chunks`; once that many are in use, blocks until one is released.
+  StatusOr<void*> Acquire();
+
+  // Returns a chunk obtained from Acquire() to the pool.
+  void Release(void* chunk);
+
+ private:
+  tensorflow::Allocator* const allocator_;
+  const size_t chunk_size_;
+  const int num_chunks_;
+
+  absl::Mutex mu_;
+  int num_allocated_ ABSL_GUARDED_BY(mu_) = 0;
+  std::vector<void*> free_chunks_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_PJRT_HOST_STAGING_POOL_H_
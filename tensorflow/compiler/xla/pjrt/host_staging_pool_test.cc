@@ -0,0 +1,62 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/pjrt/host_staging_pool.h"
+
+#include "absl/synchronization/notification.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+TEST(HostStagingPoolTest, ReusesChunks) {
+  HostStagingPool pool(tensorflow::cpu_allocator(), /*chunk_size=*/64,
+                       /*num_chunks=*/2);
+  EXPECT_EQ(pool.chunk_size(), 64);
+  TF_ASSERT_OK_AND_ASSIGN(void* a, pool.Acquire());
+  TF_ASSERT_OK_AND_ASSIGN(void* b, pool.Acquire());
+  EXPECT_NE(a, b);
+  pool.Release(a);
+  TF_ASSERT_OK_AND_ASSIGN(void* c, pool.Acquire());
+  EXPECT_EQ(a, c);
+  pool.Release(b);
+  pool.Release(c);
+}
+
+TEST(HostStagingPoolTest, AcquireBlocksUntilRelease) {
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         1);
+  HostStagingPool pool(tensorflow::cpu_allocator(), /*chunk_size=*/64,
+                       /*num_chunks=*/1);
+  TF_ASSERT_OK_AND_ASSIGN(void* a, pool.Acquire());
+
+  absl::Notification acquired;
+  void* b = nullptr;
+  threads.Schedule([&]() {
+    b = pool.Acquire().ValueOrDie();
+    acquired.Notify();
+  });
+  EXPECT_FALSE(acquired.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  pool.Release(a);
+  acquired.WaitForNotification();
+  EXPECT_EQ(a, b);
+  pool.Release(b);
+}
+
+}  // namespace
+}  // namespace xla
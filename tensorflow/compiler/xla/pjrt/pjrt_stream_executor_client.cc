@@ -192,6 +192,12 @@ class CpuAllocator : public tensorflow::Allocator {
   }
 };
 
+// Host-to-device transfers that are staged through pinned memory are split into
+// chunks of this size, so that copying one chunk into pinned memory overlaps
+// with the DMA of the previous one.
+static constexpr size_t kHostToDeviceStagingChunkBytes = 8 << 20;  // 8 MiB
+static constexpr int kNumHostToDeviceStagingChunks = 4;
+
 PjRtStreamExecutorClient::PjRtStreamExecutorClient(
     std::string platform_name, LocalClient* client,
     std::vector<std::unique_ptr<PjRtStreamExecutorDevice>> devices,
@@ -222,6 +228,11 @@ PjRtStreamExecutorClient::PjRtStreamExecutorClient(
   if (!host_memory_allocator_) {
     host_memory_allocator_ = std::make_unique<CpuAllocator>();
   }
+  if (should_stage_host_to_device_transfers_) {
+    host_to_device_staging_pool_ = std::make_unique<HostStagingPool>(
+        host_memory_allocator_.get(), kHostToDeviceStagingChunkBytes,
+        kNumHostToDeviceStagingChunks);
+  }
 
   for (const std::unique_ptr<PjRtStreamExecutorDevice>& device :
        owned_devices_) {
@@ -501,6 +512,32 @@ Status AddDestinationBufferSynchronization(
   return Status::OK();
 }
 
+// Enqueues a copy of `src` into `dst` on `copy_stream`, staged chunk by chunk
+// through `staging_pool`. Each chunk returns to the pool once its DMA has
+// completed, so only the host copy into a chunk waits, and only for the DMA
+// `num_chunks` chunks earlier.
+Status TransferToDeviceInChunks(LocalDeviceState* local_device,
+                                se::Stream* copy_stream,
+                                HostStagingPool* staging_pool, const void* src,
+                                se::DeviceMemoryBase dst) {
+  const char* src_bytes = static_cast<const char*>(src);
+  const int64_t size = dst.size();
+  for (int64_t offset = 0; offset < size;
+       offset += staging_pool->chunk_size()) {
+    const int64_t chunk_size =
+        std::min<int64_t>(staging_pool->chunk_size(), size - offset);
+    TF_ASSIGN_OR_RETURN(void* chunk, staging_pool->Acquire());
+    std::memcpy(chunk, src_bytes + offset, chunk_size);
+    se::DeviceMemoryBase dst_chunk(static_cast<char*>(dst.opaque()) + offset,
+                                   chunk_size);
+    copy_stream->ThenMemcpy(&dst_chunk, chunk, chunk_size);
+    local_device->ThenExecuteCallback(
+        copy_stream,
+        [staging_pool, chunk]() { staging_pool->Release(chunk); });
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 PjRtStreamExecutorBuffer::ScopedHold::~ScopedHold() {
@@ -773,12 +810,25 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
       py_buffer->GetBufferWithUsageHold());
   CHECK(device_buffer.ok());
 
+  // Large transfers that would be staged in pinned memory anyway are pipelined
+  // through the chunks of the staging pool instead, if the host data can be
+  // copied to the device verbatim. This bounds the pinned memory a transfer
+  // needs and lets the host copy overlap with the DMA.
+  HostStagingPool* staging_pool = host_to_device_staging_pool();
+  bool transfer_in_chunks =
+      staging_pool != nullptr && host_and_device_strides_equal &&
+      host_buffer_semantics != HostBufferSemantics::kImmutableOnlyDuringCall &&
+      size > static_cast<int64_t>(staging_pool->chunk_size()) &&
+      device_buffer->device_memory().size() == 1 &&
+      device_buffer->device_memory()[0].size() == static_cast<uint64_t>(size);
+
   // If necessary, allocate a host-side buffer for staging host-to-device
   // transfers. On GPU this is a buffer in pinned memory.
   std::shared_ptr<void> staging_buffer;
-  if (host_buffer_semantics == HostBufferSemantics::kImmutableOnlyDuringCall ||
-      should_stage_host_to_device_transfers() ||
-      !host_and_device_strides_equal) {
+  if (!transfer_in_chunks &&
+      (host_buffer_semantics == HostBufferSemantics::kImmutableOnlyDuringCall ||
+       should_stage_host_to_device_transfers() ||
+       !host_and_device_strides_equal)) {
     void* ptr = host_memory_allocator()->AllocateRaw(
         tensorflow::Allocator::kAllocatorAlignment, size);
     staging_buffer = std::shared_ptr<void>(
@@ -828,7 +878,8 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
        on_device_shape{py_buffer->on_device_shape()},
        staging_buffer{std::move(staging_buffer)},
        on_done_with_host_buffer{std::move(on_done_with_host_buffer)},
-       host_buffer_semantics, transpose{std::move(transpose)}]() {
+       host_buffer_semantics, transpose{std::move(transpose)},
+       transfer_in_chunks, staging_pool]() {
         PjRtStreamExecutorBuffer::ScopedHold device_buffer(
             movable_device_buffer);
         // This function uses TF_CHECK_OK and ValueOrDie() since we have no way
@@ -841,7 +892,11 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
         // If applicable on the backend, stage the transfer via host memory
         // allocated via the host_memory_allocator. On GPU, this is pinned
         // memory.
-        if (staging_buffer) {
+        if (transfer_in_chunks) {
+          TF_CHECK_OK(TransferToDeviceInChunks(
+              local_device, local_device->host_to_device_stream(),
+              staging_pool, data, buffer.root_buffer()));
+        } else if (staging_buffer) {
           // If we didn't already copy the input buffer into the staging buffer,
           // do so now.
           if (host_buffer_semantics !=
@@ -924,6 +979,193 @@ PjRtStreamExecutorClient::CreateUninitializedBuffer(
   return std::unique_ptr<PjRtBuffer>(std::move(py_buffer));
 }
 
+namespace {
+
+// Implements PjRtClient::AsyncBufferTransferManager for
+// PjRtStreamExecutorClient. Transfers are enqueued on the host-to-device stream
+// by the calling thread, in the order they are issued. Raw data is staged
+// through the client's staging pool, if it has one, so a buffer can be filled
+// piecewise while earlier pieces are still in flight. Each buffer has its own
+// definition event, recorded after the last transfer into it.
+class AsyncHostToDeviceTransferManager
+    : public PjRtClient::AsyncBufferTransferManager {
+ public:
+  static StatusOr<std::unique_ptr<AsyncHostToDeviceTransferManager>> Create(
+      absl::Span<const Shape> shapes, PjRtStreamExecutorDevice* device,
+      PjRtStreamExecutorClient* client) {
+    TF_ASSIGN_OR_RETURN(LocalDeviceState * local_device,
+                        device->GetLocalDeviceState());
+    TransferManager* transfer_manager =
+        client->client()->backend().transfer_manager();
+    auto manager = absl::WrapUnique(
+        new AsyncHostToDeviceTransferManager(device, client, local_device));
+    for (const Shape& shape : shapes) {
+      TF_ASSIGN_OR_RETURN(Shape compact_shape,
+                          transfer_manager->ChooseCompactLayoutForShape(shape));
+      TF_ASSIGN_OR_RETURN(
+          std::unique_ptr<PjRtStreamExecutorBuffer> buffer,
+          AllocateDestinationBuffer(compact_shape, device, local_device,
+                                    local_device->host_to_device_stream(),
+                                    /*is_uninitialized_create=*/false, client));
+      PjRtStreamExecutorBuffer::ScopedHold hold =
+          buffer->GetBufferWithUsageHold();
+      CHECK(hold.ok());
+      absl::MutexLock lock(&manager->mu_);
+      manager->on_device_shapes_.push_back(buffer->on_device_shape());
+      manager->buffer_sizes_.push_back(hold->device_memory()[0].size());
+      manager->buffers_.push_back(std::move(buffer));
+      manager->holds_.push_back(std::move(hold));
+      manager->last_transfer_started_.push_back(false);
+    }
+    return manager;
+  }
+
+  size_t buffer_count() const override { return buffer_sizes_.size(); }
+
+  PjRtDevice* device() const override { return device_; }
+
+  std::unique_ptr<PjRtBuffer> RetrieveBuffer(int buffer_index) override {
+    absl::MutexLock lock(&mu_);
+    CHECK(buffers_[buffer_index] != nullptr)
+        << "RetrieveBuffer called twice for buffer " << buffer_index;
+    return std::move(buffers_[buffer_index]);
+  }
+
+  Status TransferLiteralToBuffer(int buffer_index, const LiteralSlice& literal,
+                                 std::function<void()> on_done) override {
+    tensorflow::profiler::TraceMe traceme(
+        "AsyncHostToDeviceTransferManager::TransferLiteralToBuffer");
+    absl::MutexLock lock(&mu_);
+    TF_RETURN_IF_ERROR(StartTransfer(buffer_index, /*is_last_transfer=*/true));
+    se::Stream* stream = local_device_->host_to_device_stream();
+    TransferManager* transfer_manager =
+        client_->client()->backend().transfer_manager();
+    ShapedBuffer shaped_buffer =
+        holds_[buffer_index]->AsShapedBuffer(on_device_shapes_[buffer_index]);
+    TF_RETURN_IF_ERROR(transfer_manager->TransferLiteralToDeviceAsync(
+        stream, literal, shaped_buffer));
+    if (on_done) {
+      local_device_->ThenExecuteCallback(stream, std::move(on_done));
+    }
+    return FinishTransfers(buffer_index);
+  }
+
+  size_t buffer_size(int buffer_index) const override {
+    return buffer_sizes_[buffer_index];
+  }
+
+  Status TransferRawDataToBuffer(int buffer_index, absl::string_view data,
+                                 std::function<void()> on_done) override {
+    return TransferRawDataToSubBuffer(buffer_index, data.data(),
+                                      /*offset=*/0, data.size(),
+                                      /*is_last_transfer=*/true,
+                                      std::move(on_done));
+  }
+
+  Status TransferRawDataToSubBuffer(int buffer_index, const void* data,
+                                    int64_t offset, int64_t transfer_size,
+                                    bool is_last_transfer,
+                                    std::function<void()> on_done) override {
+    tensorflow::profiler::TraceMe traceme(
+        "AsyncHostToDeviceTransferManager::TransferRawDataToSubBuffer");
+    absl::MutexLock lock(&mu_);
+    if (on_device_shapes_[buffer_index].IsTuple()) {
+      return InvalidArgument("Raw data can't be transferred into tuple %s",
+                             on_device_shapes_[buffer_index].ToString());
+    }
+    se::DeviceMemoryBase buffer = holds_[buffer_index]->device_memory()[0];
+    if (offset < 0 || transfer_size < 0 ||
+        offset + transfer_size > static_cast<int64_t>(buffer.size())) {
+      return InvalidArgument(
+          "Transfer of %d bytes at offset %d is out of bounds of buffer %d of "
+          "%d bytes",
+          transfer_size, offset, buffer_index, buffer.size());
+    }
+    TF_RETURN_IF_ERROR(StartTransfer(buffer_index, is_last_transfer));
+    se::Stream* stream = local_device_->host_to_device_stream();
+    se::DeviceMemoryBase sub_buffer(
+        static_cast<char*>(buffer.opaque()) + offset, transfer_size);
+    if (transfer_size > 0) {
+      if (HostStagingPool* staging_pool =
+              client_->host_to_device_staging_pool()) {
+        TF_RETURN_IF_ERROR(TransferToDeviceInChunks(
+            local_device_, stream, staging_pool, data, sub_buffer));
+      } else {
+        stream->ThenMemcpy(&sub_buffer, data, transfer_size);
+      }
+    }
+    if (on_done) {
+      local_device_->ThenExecuteCallback(stream, std::move(on_done));
+    }
+    return is_last_transfer ? FinishTransfers(buffer_index) : Status::OK();
+  }
+
+  void SetTransferError(Status error) override {
+    LOG(FATAL) << "Async transfers into buffers on " << device_->DebugString()
+               << " failed: " << error;
+  }
+
+ private:
+  AsyncHostToDeviceTransferManager(PjRtStreamExecutorDevice* device,
+                                   PjRtStreamExecutorClient* client,
+                                   LocalDeviceState* local_device)
+      : device_(device), client_(client), local_device_(local_device) {}
+
+  // Fails if the last transfer into `buffer_index` has already been started.
+  Status StartTransfer(int buffer_index, bool is_last_transfer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (last_transfer_started_[buffer_index]) {
+      return FailedPrecondition(
+          "Transfer into buffer %d after its last transfer was started",
+          buffer_index);
+    }
+    last_transfer_started_[buffer_index] = is_last_transfer;
+    return Status::OK();
+  }
+
+  // Makes the buffer available to its consumers once the transfers enqueued
+  // into it so far have completed.
+  Status FinishTransfers(int buffer_index) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    std::shared_ptr<BufferSequencingEvent> event =
+        holds_[buffer_index]->definition_events()[0];
+    return AddDestinationBufferSynchronization(
+        local_device_, std::move(holds_[buffer_index]), std::move(event),
+        local_device_->host_to_device_stream());
+  }
+
+  PjRtStreamExecutorDevice* const device_;
+  PjRtStreamExecutorClient* const client_;
+  LocalDeviceState* const local_device_;
+
+  // Only appended to by Create().
+  absl::InlinedVector<Shape, 4> on_device_shapes_;
+  absl::InlinedVector<size_t, 4> buffer_sizes_;
+
+  absl::Mutex mu_;
+  // Null once retrieved by RetrieveBuffer().
+  absl::InlinedVector<std::unique_ptr<PjRtStreamExecutorBuffer>, 4> buffers_
+      ABSL_GUARDED_BY(mu_);
+  // Usage holds on the buffers, which keep them alive until the last transfer
+  // into each of them has been enqueued. Declared after `buffers_` so that
+  // they are dropped first.
+  std::vector<PjRtStreamExecutorBuffer::ScopedHold> holds_ ABSL_GUARDED_BY(mu_);
+  absl::InlinedVector<bool, 4> last_transfer_started_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<PjRtClient::AsyncBufferTransferManager>>
+PjRtStreamExecutorClient::CreateBuffersForAsyncTransfer(
+    absl::Span<const Shape> shapes, PjRtDevice* device) {
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<AsyncHostToDeviceTransferManager> manager,
+      AsyncHostToDeviceTransferManager::Create(
+          shapes, tensorflow::down_cast<PjRtStreamExecutorDevice*>(device),
+          this));
+  return std::unique_ptr<PjRtClient::AsyncBufferTransferManager>(
+      std::move(manager));
+}
+
 StatusOr<std::unique_ptr<PjRtBuffer>>
 PjRtStreamExecutorClient::BufferFromHostLiteral(const LiteralSlice& literal,
                                                 PjRtDevice* device) {
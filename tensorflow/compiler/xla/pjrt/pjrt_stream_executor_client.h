@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/client/xla_computation.h"
 #include "tensorflow/compiler/xla/layout.h"
 #include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/pjrt/host_staging_pool.h"
 #include "tensorflow/compiler/xla/pjrt/local_device_state.h"
 #include "tensorflow/compiler/xla/pjrt/pjrt_client.h"
 #include "tensorflow/compiler/xla/pjrt/tracked_device_buffer.h"
@@ -201,11 +202,12 @@ class PjRtStreamExecutorClient : public PjRtClient {
       const Shape& shape, PjRtDevice* device,
       std::shared_ptr<BufferSequencingEvent> definition_event);
 
+  // Each buffer of the batch becomes available to its consumers as soon as
+  // the last transfer into it completes, rather than once the whole batch has
+  // been transferred.
   StatusOr<std::unique_ptr<PjRtClient::AsyncBufferTransferManager>>
   CreateBuffersForAsyncTransfer(absl::Span<const Shape> shapes,
-                                PjRtDevice* device) override {
-    return Unimplemented("Async transfer to buffers not implemented");
-  };
+                                PjRtDevice* device) override;
 
   StatusOr<std::unique_ptr<PjRtBuffer>> BufferFromHostBuffer(
       const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
@@ -257,6 +259,12 @@ class PjRtStreamExecutorClient : public PjRtClient {
   bool should_stage_host_to_device_transfers() const {
     return should_stage_host_to_device_transfers_;
   }
+  // Pool of chunks of host_memory_allocator() memory that large host-to-device
+  // transfers are staged and pipelined through. Only present if
+  // should_stage_host_to_device_transfers().
+  HostStagingPool* host_to_device_staging_pool() const {
+    return host_to_device_staging_pool_.get();
+  }
 
   gpu::GpuExecutableRunOptions* gpu_run_options() const {
     return gpu_run_options_.get();
@@ -308,6 +316,9 @@ class PjRtStreamExecutorClient : public PjRtClient {
 
   // Allocator to be used for staging memory transfers to devices.
   std::unique_ptr<tensorflow::Allocator> host_memory_allocator_;
+  // Declared before the devices, whose destructors wait for the stream
+  // callbacks that return chunks to the pool.
+  std::unique_ptr<HostStagingPool> host_to_device_staging_pool_;
 
   // Device memory allocator. If owned, the allocator must outlive the devices,
   // because it is the device destructor that waits for any outstanding work to
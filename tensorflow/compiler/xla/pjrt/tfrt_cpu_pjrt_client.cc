@@ -21,6 +21,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include "absl/algorithm/container.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -46,6 +47,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/shape.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
@@ -68,9 +70,22 @@ static tfrt::AsyncValueRef<CpuEvent> GetOrCreateReadyEvent(
   return ready_event->CopyRef();
 }
 
-TfrtCpuDevice::TfrtCpuDevice(int id, bool asynchronous)
+TfrtCpuDevice::TfrtCpuDevice(int id, bool asynchronous, int numa_node)
     : id_(id),
+      numa_node_(numa_node),
       max_inflight_computations_semaphore_(/*capacity=*/asynchronous ? 32 : 1) {
+  if (numa_node_ != tensorflow::port::kNUMANoAffinity) {
+    tensorflow::ThreadOptions thread_options;
+    thread_options.numa_node = numa_node_;
+    eigen_intraop_pool_ = std::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), thread_options,
+        absl::StrCat("XLAEigen_numa", numa_node_),
+        std::max(1, tensorflow::port::MaxParallelism(numa_node_)),
+        /*low_latency_hint=*/true, /*allocator=*/nullptr);
+    eigen_intraop_device_ = std::make_unique<Eigen::ThreadPoolDevice>(
+        eigen_intraop_pool_->AsEigenThreadPool(),
+        eigen_intraop_pool_->NumThreads());
+  }
 }
 
 absl::string_view TfrtCpuDevice::device_kind() const {
@@ -97,8 +112,19 @@ static int CpuDeviceCount() {
 }
 
 static StatusOr<std::vector<std::unique_ptr<TfrtCpuDevice>>> GetTfrtCpuDevices(
-    bool asynchronous) {
+    bool asynchronous, bool numa_aware) {
   std::vector<std::unique_ptr<TfrtCpuDevice>> devices;
+  if (numa_aware) {
+    if (tensorflow::port::NUMAEnabled()) {
+      for (int node = 0; node < tensorflow::port::NUMANumNodes(); ++node) {
+        devices.push_back(std::make_unique<TfrtCpuDevice>(
+            /*id=*/node, asynchronous, /*numa_node=*/node));
+      }
+      return std::move(devices);
+    }
+    LOG(WARNING) << "NUMA-aware TFRT CPU client requested, but the host has a "
+                    "single NUMA node or NUMA support is not compiled in.";
+  }
   for (int i = 0; i < CpuDeviceCount(); ++i) {
     auto device = std::make_unique<TfrtCpuDevice>(
         /*id=*/i, asynchronous);
@@ -107,11 +133,16 @@ static StatusOr<std::vector<std::unique_ptr<TfrtCpuDevice>>> GetTfrtCpuDevices(
   return std::move(devices);
 }
 
-StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous) {
+StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous,
+                                                       bool numa_aware) {
+  TF_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
+                      GetTfrtCpuDevices(asynchronous, numa_aware));
+
   // TODO(zhangqiaorjc): Allow users set the number of threads.
   // `num_blocking_threads=16` is picked arbitrarily for now.
-  // Need at least CpuDeviceCount threads to launch one collective.
-  int num_threads = std::max(DefaultThreadPoolSize(), CpuDeviceCount());
+  // Need at least one thread per device to launch one collective.
+  int num_threads =
+      std::max(DefaultThreadPoolSize(), static_cast<int>(devices.size()));
   auto host_context = std::make_unique<tfrt::HostContext>(
       [](const tfrt::DecodedDiagnostic& diag) {
         LOG(ERROR) << "Encountered runtime error: " << diag.message << "\n";
@@ -121,9 +152,6 @@ StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous) {
           /*num_threads=*/num_threads,
           /*num_blocking_threads=*/16));
 
-  TF_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
-                      GetTfrtCpuDevices(asynchronous));
-
   return std::unique_ptr<PjRtClient>(std::make_unique<TfrtCpuClient>(
       /*process_index=*/0, std::move(devices), std::move(host_context)));
 }
@@ -135,11 +163,6 @@ TfrtCpuClient::TfrtCpuClient(
       owned_devices_(std::move(devices)),
       host_ctx_(std::move(host_ctx)),
       computation_placer_(std::make_unique<ComputationPlacer>()),
-      eigen_intraop_pool_(new tensorflow::thread::ThreadPool(
-          tensorflow::Env::Default(), "XLAEigen", DefaultThreadPoolSize())),
-      eigen_intraop_device_(
-          new Eigen::ThreadPoolDevice(eigen_intraop_pool_->AsEigenThreadPool(),
-                                      eigen_intraop_pool_->NumThreads())),
       last_collective_launch_event_(
           tfrt::MakeAvailableAsyncValueRef<CpuEvent>(host_ctx_.get())),
       transpose_cache_(1024) {
@@ -161,6 +184,16 @@ TfrtCpuClient::TfrtCpuClient(
   for (int idx = 0; idx < addressable_devices_.size(); ++idx) {
     CHECK(addressable_devices_[idx] != nullptr) << idx;
   }
+  if (absl::c_any_of(owned_devices_,
+                     [](const std::unique_ptr<TfrtCpuDevice>& device) {
+                       return device->eigen_intraop_device() == nullptr;
+                     })) {
+    eigen_intraop_pool_ = std::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "XLAEigen", DefaultThreadPoolSize());
+    eigen_intraop_device_ = std::make_unique<Eigen::ThreadPoolDevice>(
+        eigen_intraop_pool_->AsEigenThreadPool(),
+        eigen_intraop_pool_->NumThreads());
+  }
   LOG(INFO) << "TfrtCpuClient created.";
 }
 
@@ -379,7 +412,8 @@ StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBuffer(
   absl::InlinedVector<std::shared_ptr<MaybeOwningCpuMemory>, 4> buffers;
   if (!on_device_shape.IsTuple()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(on_device_shape);
-    auto device_buffer = MaybeOwningCpuMemory::AllocateShared(byte_size);
+    auto device_buffer =
+        MaybeOwningCpuMemory::AllocateShared(byte_size, device->numa_node());
     buffers.push_back(std::move(device_buffer));
     return std::make_unique<TfrtCpuBuffer>(
         on_device_shape,
@@ -392,7 +426,8 @@ StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBuffer(
   buffers.reserve(on_device_shape.tuple_shapes().size());
   for (const auto& leaf_shape : on_device_shape.tuple_shapes()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(leaf_shape);
-    auto device_buffer = MaybeOwningCpuMemory::AllocateShared(byte_size);
+    auto device_buffer =
+        MaybeOwningCpuMemory::AllocateShared(byte_size, device->numa_node());
     buffers.push_back(std::move(device_buffer));
   }
   return std::make_unique<TfrtCpuBuffer>(
@@ -460,7 +495,9 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
     buffers.push_back(std::move(device_buffer));
     on_delete_callback = std::move(on_done_with_host_buffer);
   } else {
-    auto device_buffer = MaybeOwningCpuMemory::AllocateShared(byte_size);
+    TfrtCpuDevice* cpu_device = tensorflow::down_cast<TfrtCpuDevice*>(device);
+    auto device_buffer = MaybeOwningCpuMemory::AllocateShared(
+        byte_size, cpu_device->numa_node());
     auto dst_data_ptr = device_buffer->data();
     buffers.push_back(device_buffer);
     if (!has_default_layout) {
@@ -468,18 +505,33 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
       // into major-to-minor layout. Currently we choose to always do this
       // synchronously.
       // TODO(phawkins): consider performing the transpose asynchronously.
-      // TODO(phawkins): parallelize the transpose.
+      //
+      // Large transposes are split across the intra-op threads of the device
+      // the buffer is allocated for. The plan only uses more than one thread if
+      // there is enough work per thread.
+      Eigen::ThreadPoolDevice* intra_op_device =
+          cpu_device->eigen_intraop_device() != nullptr
+              ? cpu_device->eigen_intraop_device()
+              : eigen_intraop_device();
       std::shared_ptr<TransposePlan> transpose;
       {
         absl::InlinedVector<int64_t, 4> permutation(dims.size());
         absl::c_iota(permutation, 0);
         absl::MutexLock lock(&transpose_mu_);
         TF_ASSIGN_OR_RETURN(
-            transpose, transpose_cache_.GetOrCreate(
-                           primitive_util::ByteWidth(type), dims, permutation,
-                           TransposePlan::Striding{*byte_strides}));
+            transpose,
+            transpose_cache_.GetOrCreate(
+                primitive_util::ByteWidth(type), dims, permutation,
+                TransposePlan::Striding{*byte_strides},
+                /*output_tiling=*/TransposePlan::Tiling{},
+                TransposePlan::Transformation::kNone,
+                intra_op_device->numThreads()));
       }
-      transpose->Execute(data, dst_data_ptr);
+      transpose->Execute(data, dst_data_ptr,
+                         [intra_op_device](std::function<void()> fn) {
+                           intra_op_device->enqueueNoNotification(
+                               std::move(fn));
+                         });
       if (on_done_with_host_buffer) {
         on_done_with_host_buffer();
         on_done_with_host_buffer = nullptr;
@@ -1107,7 +1159,9 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuBuffer::CopyToDevice(
 
   for (int i = 0; i < num_leaf_buffers; ++i) {
     auto src_buffer = src_device_buffer->Buffers()[i];
-    auto dst_buffer = MaybeOwningCpuMemory::AllocateShared(src_buffer->size());
+    auto dst_buffer = MaybeOwningCpuMemory::AllocateShared(
+        src_buffer->size(),
+        tensorflow::down_cast<TfrtCpuDevice*>(dst_device)->numa_node());
     src_buffers.push_back(std::move(src_buffer));
     dst_buffers.push_back(std::move(dst_buffer));
     tfrt::RCReference<tfrt::IndirectAsyncValue> definition_event =
@@ -1262,7 +1316,8 @@ Status TfrtCpuExecutable::SetUpDonation(bool tuple_inputs) {
 // and assemble the buffer pointers in order to call into CpuExecutable.
 static std::shared_ptr<MaybeOwningCpuMemory> MemoryForAllocation(
     const BufferAllocation& allocation,
-    absl::Span<const std::shared_ptr<TrackedTfrtCpuDeviceBuffer>> arguments) {
+    absl::Span<const std::shared_ptr<TrackedTfrtCpuDeviceBuffer>> arguments,
+    int numa_node) {
   if (allocation.is_entry_computation_parameter()) {
     const std::shared_ptr<TrackedTfrtCpuDeviceBuffer>& arg =
         arguments[allocation.parameter_number()];
@@ -1280,7 +1335,7 @@ static std::shared_ptr<MaybeOwningCpuMemory> MemoryForAllocation(
 
   // Output and temporary buffer.
   int64_t buffer_size = allocation.size();
-  auto out = MaybeOwningCpuMemory::AllocateShared(buffer_size);
+  auto out = MaybeOwningCpuMemory::AllocateShared(buffer_size, numa_node);
 
   // Since the output buffer and all the temporary buffers were written into
   // by the JITed code, msan has no way of knowing their memory was
@@ -1293,13 +1348,14 @@ static std::shared_ptr<MaybeOwningCpuMemory> MemoryForAllocation(
 static StatusOr<std::vector<std::shared_ptr<MaybeOwningCpuMemory>>>
 CreateBufferTable(
     const BufferAssignment& assignment,
-    absl::Span<const std::shared_ptr<TrackedTfrtCpuDeviceBuffer>> arguments) {
+    absl::Span<const std::shared_ptr<TrackedTfrtCpuDeviceBuffer>> arguments,
+    int numa_node) {
   std::vector<std::shared_ptr<MaybeOwningCpuMemory>> buffers(
       assignment.Allocations().size());
   for (BufferAllocation::Index i = 0; i < assignment.Allocations().size();
        ++i) {
     const BufferAllocation& allocation = assignment.GetAllocation(i);
-    buffers[i] = MemoryForAllocation(allocation, arguments);
+    buffers[i] = MemoryForAllocation(allocation, arguments, numa_node);
   }
   return std::move(buffers);
 }
@@ -1469,7 +1525,8 @@ TfrtCpuExecutable::ExecuteHelper(
       tensorflow::down_cast<cpu::CpuExecutable*>(cpu_executable_.get());
   TF_ASSIGN_OR_RETURN(
       std::vector<std::shared_ptr<MaybeOwningCpuMemory>> buffer_table,
-      CreateBufferTable(cpu_executable->buffer_assignment(), tracked_buffers));
+      CreateBufferTable(cpu_executable->buffer_assignment(), tracked_buffers,
+                        device->numa_node()));
   TF_ASSIGN_OR_RETURN(auto result_buffers,
                       CreateResultShapedBuffer(result_buffer_indices_,
                                                buffer_table, tracked_buffers));
@@ -1499,7 +1556,10 @@ TfrtCpuExecutable::ExecuteHelper(
   run_options.set_device_ordinal(device->local_hardware_id());
   // Need to keep device_assignment alive until execution completes.
   run_options.set_device_assignment(device_assignment.get());
-  run_options.set_intra_op_thread_pool(client_->eigen_intraop_device());
+  run_options.set_intra_op_thread_pool(
+      device->eigen_intraop_device() != nullptr
+          ? device->eigen_intraop_device()
+          : client_->eigen_intraop_device());
 
   // Schedule only one collective at a time.
   bool is_a_collective_launch = !!last_collective_launch_event;
@@ -37,6 +37,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_module_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tfrt/host_context/async_value_ref.h"  // from @tf_runtime
 #include "tfrt/host_context/host_context.h"  // from @tf_runtime
@@ -45,7 +47,11 @@ namespace xla {
 
 class TfrtCpuDevice final : public PjRtDevice {
  public:
-  TfrtCpuDevice(int id, bool asynchronous);
+  // If `numa_node` is not kNUMANoAffinity, the device allocates its buffers on
+  // that NUMA node and runs the intra-op work of its computations on its own
+  // thread pool, whose threads are pinned to the node.
+  TfrtCpuDevice(int id, bool asynchronous,
+                int numa_node = tensorflow::port::kNUMANoAffinity);
 
   void SetClient(PjRtClient* client) {
     CHECK(client_ == nullptr);
@@ -78,10 +84,22 @@ class TfrtCpuDevice final : public PjRtDevice {
     return max_inflight_computations_semaphore_;
   }
 
+  int numa_node() const { return numa_node_; }
+
+  // Returns the thread pool pinned to the NUMA node of the device, or nullptr
+  // if the device has no NUMA affinity and uses the pool of the client.
+  Eigen::ThreadPoolDevice* eigen_intraop_device() const {
+    return eigen_intraop_device_.get();
+  }
+
  private:
   int id_;
+  int numa_node_;
   PjRtClient* client_ = nullptr;
 
+  std::unique_ptr<tensorflow::thread::ThreadPool> eigen_intraop_pool_;
+  std::unique_ptr<Eigen::ThreadPoolDevice> eigen_intraop_device_;
+
   // TODO(zhangqiaorjc): Optimize semaphore related overhead.
   // Semaphore used to limit how many programs can be enqueued by the host
   // ahead of the device.
@@ -227,6 +245,7 @@ class TfrtCpuClient final : public PjRtClient {
   std::unique_ptr<ComputationPlacer> computation_placer_;
 
   // TODO(zhangqiaorjc): Use tfrt::compat::EigenHostContextThreadPool.
+  // Only created if some device has no thread pool of its own.
   std::unique_ptr<tensorflow::thread::ThreadPool> eigen_intraop_pool_;
   std::unique_ptr<Eigen::ThreadPoolDevice> eigen_intraop_device_;
 
@@ -651,7 +670,12 @@ class TfrtCpuExecutable final : public PjRtExecutable {
   bool cheap_computation_;
 };
 
-StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous);
+// If `numa_aware` is true and the host has more than one NUMA node, the client
+// has one device per NUMA node instead of the number of devices set by
+// --xla_force_host_platform_device_count. SPMD programs then run one
+// partition per socket without memory traffic across sockets.
+StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous,
+                                                       bool numa_aware = false);
 
 }  // namespace xla
 
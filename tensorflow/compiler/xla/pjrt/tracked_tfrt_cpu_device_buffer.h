@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_PJRT_TRACKED_TFRT_CPU_DEVICE_BUFFER_H_
 #define TENSORFLOW_COMPILER_XLA_PJRT_TRACKED_TFRT_CPU_DEVICE_BUFFER_H_
 
+#include <functional>
 #include <memory>
 
 #include "absl/container/inlined_vector.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/cpu_function_runtime.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tfrt/host_context/async_value_ref.h"  // from @tf_runtime
 
 namespace xla {
@@ -36,8 +38,7 @@ class MaybeOwningCpuMemory {
       : buf_(buf), size_(size) {}
 
   // Owning.
-  using OwnedDataPtr =
-      std::unique_ptr<uint8_t[], decltype(tensorflow::port::AlignedFree)*>;
+  using OwnedDataPtr = std::unique_ptr<uint8_t[], std::function<void(void*)>>;
   explicit MaybeOwningCpuMemory(OwnedDataPtr data, size_t size)
       : buf_(data.get()), data_(std::move(data)), size_(size) {}
 
@@ -56,6 +57,23 @@ class MaybeOwningCpuMemory {
         size);
   }
 
+  // Like above, but the memory is bound to `numa_node`, regardless of which
+  // thread touches it first. Allocates like above if `numa_node` is
+  // kNUMANoAffinity.
+  static std::shared_ptr<MaybeOwningCpuMemory> AllocateShared(size_t size,
+                                                              int numa_node) {
+    if (numa_node == tensorflow::port::kNUMANoAffinity || size == 0) {
+      return AllocateShared(size);
+    }
+    return std::make_shared<MaybeOwningCpuMemory>(
+        OwnedDataPtr{static_cast<uint8_t*>(tensorflow::port::NUMAMalloc(
+                         numa_node, size, cpu_function_runtime::kMinAlign)),
+                     [size](void* ptr) {
+                       tensorflow::port::NUMAFree(ptr, size);
+                     }},
+        size);
+  }
+
   void* data() const { return buf_; }
   size_t size() const { return size_; }
   bool owns_data() const { return data_ != nullptr; }
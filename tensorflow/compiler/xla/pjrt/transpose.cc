@@ -1103,6 +1103,11 @@ void TransposePlan::Initialize() {
     // vectorized kernel for this element size?
     int min_inner_block_elems;
     int max_inner_block_elems;
+#ifdef EIGEN_VECTORIZE_AVX512
+    constexpr bool kHasAvx512Kernels = true;
+#else
+    constexpr bool kHasAvx512Kernels = false;
+#endif
     switch (elem_size_in_bytes_) {
       case 1:
         min_inner_block_elems = 4;
@@ -1110,15 +1115,15 @@ void TransposePlan::Initialize() {
         break;
       case 2:
         min_inner_block_elems = 8;
-        max_inner_block_elems = 8;
+        max_inner_block_elems = kHasAvx512Kernels ? 16 : 8;
         break;
       case 4:
         min_inner_block_elems = 4;
-        max_inner_block_elems = 8;
+        max_inner_block_elems = kHasAvx512Kernels ? 16 : 8;
         break;
       case 8:
         min_inner_block_elems = 2;
-        max_inner_block_elems = 4;
+        max_inner_block_elems = kHasAvx512Kernels ? 8 : 4;
         break;
       case 16:
         min_inner_block_elems = 1;
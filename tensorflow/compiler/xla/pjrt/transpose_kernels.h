@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_PJRT_TRANSPOSE_KERNELS_H_
 #define TENSORFLOW_COMPILER_XLA_PJRT_TRANSPOSE_KERNELS_H_
 
+#include <array>
 #include <cstdint>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -69,7 +70,46 @@ struct TransposeMicroKernel<uint8_t, /*bs=*/4> {
   }
 };
 
-// TODO(phawkins): add an 8x8 byte transpose kernel.
+template <>
+struct TransposeMicroKernel<uint8_t, /*bs=*/8> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    std::array<__m128i, 8> packet;
+    for (int i = 0; i < 8; ++i) {
+      packet[i] =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + lda * i));
+    }
+
+    // This is the first half of the 16x16 kernel below, on 8 byte rows.
+    // 00 10 01 11 02 12 03 13 04 14 05 15 06 16 07 17
+    __m128i t0 = _mm_unpacklo_epi8(packet[0], packet[1]);
+    __m128i t1 = _mm_unpacklo_epi8(packet[2], packet[3]);
+    __m128i t2 = _mm_unpacklo_epi8(packet[4], packet[5]);
+    __m128i t3 = _mm_unpacklo_epi8(packet[6], packet[7]);
+
+    // 00 10 20 30 01 11 21 31 02 12 22 32 03 13 23 33
+    __m128i s0 = _mm_unpacklo_epi16(t0, t1);
+    __m128i s1 = _mm_unpackhi_epi16(t0, t1);  // 04 14 24 34 ...
+    __m128i s2 = _mm_unpacklo_epi16(t2, t3);  // 40 50 60 70 ...
+    __m128i s3 = _mm_unpackhi_epi16(t2, t3);  // 44 54 64 74 ...
+
+    // 00 10 20 30 40 50 60 70 01 11 21 31 41 51 61 71
+    __m128i u0 = _mm_unpacklo_epi32(s0, s2);
+    __m128i u1 = _mm_unpackhi_epi32(s0, s2);  // 02 12 22 32 ...
+    __m128i u2 = _mm_unpacklo_epi32(s1, s3);  // 04 14 24 34 ...
+    __m128i u3 = _mm_unpackhi_epi32(s1, s3);  // 06 16 26 36 ...
+
+    auto store = [&](int i, __m128i x) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(b + ldb * i), x);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(b + ldb * (i + 1)),
+                       _mm_unpackhi_epi64(x, x));
+    };
+    store(0, u0);
+    store(2, u1);
+    store(4, u2);
+    store(6, u3);
+  }
+};
 
 // TODO(phawkins): Eigen doesn't have a SSE/AVX byte Packet16c type. Add one
 // and call it here rather than using AVX intrinsics.
@@ -285,6 +325,73 @@ struct TransposeMicroKernel<uint64_t, /*bs=*/4> {
   }
 };
 
+// The AVX-512 kernels transpose 512-bit blocks, which halves the number of
+// kernel invocations for 2, 4 and 8 byte elements. The plan picks them whenever
+// both stride-1 dimensions are large enough.
+#ifdef EIGEN_VECTORIZE_AVX512
+
+template <>
+struct TransposeMicroKernel<uint16_t, /*bs=*/16> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet16h;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 16;
+    PacketBlock<Packet16h, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet16h>(
+          reinterpret_cast<const Eigen::half*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<Eigen::half>(
+          reinterpret_cast<Eigen::half*>(b + ldb * i), block.packet[i]);
+    }
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint32_t, /*bs=*/16> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet16f;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 16;
+    PacketBlock<Packet16f, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet16f>(
+          reinterpret_cast<const float*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<float>(reinterpret_cast<float*>(b + ldb * i),
+                                      block.packet[i]);
+    }
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint64_t, /*bs=*/8> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet8d;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 8;
+    PacketBlock<Packet8d, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet8d>(
+          reinterpret_cast<const double*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<double>(reinterpret_cast<double*>(b + ldb * i),
+                                       block.packet[i]);
+    }
+  }
+};
+
+#endif  // EIGEN_VECTORIZE_AVX512
+
 #endif  // EIGEN_VECTORIZE_AVX
 
 }  // namespace xla
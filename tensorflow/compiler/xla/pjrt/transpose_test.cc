@@ -301,6 +301,9 @@ std::vector<TransposeTestCase> GetTransposeTestCases() {
       TransposeTestCase(/*dims=*/{16, 16}, /*permutation=*/{1, 0}),
       TransposeTestCase(/*dims=*/{11, 15}, /*permutation=*/{0, 1}),
       TransposeTestCase(/*dims=*/{11, 15}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{9, 12}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{19, 33}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{33, 19}, /*permutation=*/{1, 0}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{0, 1, 2}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{0, 2, 1}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{1, 2, 0}),
@@ -264,13 +264,14 @@ PYBIND11_MODULE(xla_extension, m) {
       py::arg("asynchronous") = true);
   m.def(
       "get_tfrt_cpu_client",
-      [](bool asynchronous) -> StatusOr<std::shared_ptr<PyClient>> {
+      [](bool asynchronous,
+         bool numa_aware) -> StatusOr<std::shared_ptr<PyClient>> {
         py::gil_scoped_release gil_release;
         TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtClient> client,
-                            GetTfrtCpuClient(asynchronous));
+                            GetTfrtCpuClient(asynchronous, numa_aware));
         return std::make_shared<PyClient>(std::move(client));
       },
-      py::arg("asynchronous") = true);
+      py::arg("asynchronous") = true, py::arg("numa_aware") = false);
   m.def("get_interpreter_client", []() -> StatusOr<std::shared_ptr<PyClient>> {
     py::gil_scoped_release gil_release;
     TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtClient> client,
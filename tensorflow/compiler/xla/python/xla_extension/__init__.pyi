@@ -346,7 +346,8 @@ class Client:
 
 
 def get_cpu_client(asynchronous: bool = ...) -> Client: ...
-def get_tfrt_cpu_client(asynchronous: bool = ...) -> Client: ...
+def get_tfrt_cpu_client(asynchronous: bool = ...,
+                        numa_aware: bool = ...) -> Client: ...
 def get_interpreter_client() -> Client: ...
 def get_gpu_client(
     asynchronous: bool = ...,
@@ -1418,8 +1418,19 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
   const HloOrdering& hlo_ordering = assignment->hlo_ordering();
 
   // Returns a heap algorithm that chooses the best result from several
-  // algorithms.
-  auto get_heap_algorithm = [&](int64_t alignment) {
+  // algorithms, or only the spatial one if fast heap simulation is requested.
+  const bool fast_heap_simulation =
+      assignment->module()
+          .config()
+          .debug_options()
+          .xla_buffer_assignment_fast_heap_simulation();
+  auto get_heap_algorithm =
+      [&](int64_t alignment) -> std::unique_ptr<HeapAlgorithm<HloValue>> {
+    if (fast_heap_simulation) {
+      return absl::make_unique<ConstrainedGlobalDecreasingSizeBestFitHeap>(
+          assignment->multiheap_size_constraint_per_heap(), alignment,
+          GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial);
+    }
     auto algorithms = absl::make_unique<
         std::vector<std::unique_ptr<HeapAlgorithm<HloValue>>>>();
     algorithms->push_back(
@@ -29,6 +29,7 @@ limitations under the License.
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/computation_layout.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_matmul_ruy.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
@@ -87,6 +88,9 @@ CpuExecutable::CpuExecutable(
 CpuExecutable::~CpuExecutable() {
   XlaDebugInfoManager::Get()->UnregisterModule(module_name_, shared_module(),
                                                buffer_assignment_);
+  // The constants of this executable are freed with the JIT, and the ruy
+  // matmuls may have cached them by address.
+  runtime::ClearRuyPrepackedCaches();
 }
 
 static StatusOr<MaybeOwningDeviceMemory> MemoryForAllocation(
@@ -26,6 +26,7 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kXlaCpuMatmulRuntime = "xla_cpu_matmul_runtime";
 
 }  // namespace
 
@@ -99,6 +100,21 @@ absl::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
                                                tile_size_n_in_vector_width);
 }
 
+MatmulRuntime GetMatmulRuntime(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kXlaCpuMatmulRuntime);
+  if (it == extra_options_map.end() || it->second == "eigen") {
+    return MatmulRuntime::kEigen;
+  }
+  if (it->second == "ruy") {
+    return MatmulRuntime::kRuy;
+  }
+  CHECK_EQ(it->second, "auto") << "Unknown " << kXlaCpuMatmulRuntime
+                               << ", expected eigen, ruy or auto";
+  return MatmulRuntime::kAuto;
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
@@ -24,12 +24,23 @@ namespace xla {
 namespace cpu {
 namespace options {
 
+// The runtime library that dots which are not emitted as LLVM IR call into.
+enum class MatmulRuntime {
+  // Eigen, or oneDNN if xla_cpu_use_mkl_dnn is set.
+  kEigen,
+  // ruy for F32 dots, which packs its operands and caches packed constants.
+  kRuy,
+  // ruy for small and skinny F32 dots and kEigen otherwise.
+  kAuto,
+};
+
 bool OptimizeForSizeRequested(const HloModuleConfig& config);
 bool VectorizedReduceDisabled(const HloModuleConfig& config);
 bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 absl::optional<int64_t> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 absl::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+MatmulRuntime GetMatmulRuntime(const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
@@ -84,6 +84,10 @@ extern const char* const kMKLSingleThreadedMatMulF32SymbolName =
     "__xla_cpu_runtime_MKLSingleThreadedMatMulF32";
 extern const char* const kMKLSingleThreadedMatMulF64SymbolName =
     "__xla_cpu_runtime_MKLSingleThreadedMatMulF64";
+extern const char* const kRuyMatMulF32SymbolName =
+    "__xla_cpu_runtime_RuyMatMulF32";
+extern const char* const kRuySingleThreadedMatMulF32SymbolName =
+    "__xla_cpu_runtime_RuySingleThreadedMatMulF32";
 extern const char* const kEigenConvF16SymbolName =
     "__xla_cpu_runtime_EigenConvF16";
 extern const char* const kEigenConvF32SymbolName =
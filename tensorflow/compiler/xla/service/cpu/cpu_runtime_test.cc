@@ -15,6 +15,7 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_custom_call_status.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul_mkl.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_matmul_ruy.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/service/custom_call_status_internal.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -238,6 +240,112 @@ INSTANTIATE_TEST_CASE_P(MKLMatMulTestInstantiaion, MKLMatMulTest,
                         MKLMatMulTest::Name);
 #endif  // ENABLE_MKL
 
+std::unique_ptr<Array2D<float>> RuyMatrixMultiply(const Array2D<float>& a,
+                                                  const Array2D<float>& b,
+                                                  bool transpose_lhs,
+                                                  bool transpose_rhs,
+                                                  bool single_threaded,
+                                                  bool rhs_is_constant) {
+  CHECK_EQ(a.width(), b.height());
+  int64_t m = a.height();
+  int64_t n = b.width();
+  int64_t k = a.width();
+
+  // Like the Eigen one, the ruy matmul runtime function expects the matrices
+  // in column major order.
+  auto a_transpose = MaybeTransposeArray2D(a, !transpose_lhs);
+  auto b_transpose = MaybeTransposeArray2D(b, !transpose_rhs);
+  auto c_transpose = absl::make_unique<Array2D<float>>(n, m);
+  if (single_threaded) {
+    __xla_cpu_runtime_RuySingleThreadedMatMulF32(
+        nullptr, c_transpose->data(), a_transpose->data(), b_transpose->data(),
+        m, n, k, transpose_lhs, transpose_rhs, /*lhs_is_constant=*/false,
+        rhs_is_constant);
+  } else {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(), "XLAEigen",
+                                        2);
+    Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), pool.NumThreads());
+    ExecutableRunOptions run_options;
+    run_options.set_intra_op_thread_pool(&device);
+
+    __xla_cpu_runtime_RuyMatMulF32(
+        &run_options, c_transpose->data(), a_transpose->data(),
+        b_transpose->data(), m, n, k, transpose_lhs, transpose_rhs,
+        /*lhs_is_constant=*/false, rhs_is_constant);
+  }
+  return MaybeTransposeArray2D(*c_transpose, true);
+}
+
+class RuyMatMulTest : public CpuRuntimeTest,
+                      public ::testing::WithParamInterface<MatMulTestParam> {
+ public:
+  static string Name(const ::testing::TestParamInfo<MatMulTestParam>& info) {
+    MatMulShape shape = std::get<0>(info.param);
+    bool transpose_lhs = std::get<1>(info.param);
+    bool transpose_rhs = std::get<2>(info.param);
+    bool single_threaded = std::get<3>(info.param);
+
+    return absl::StrFormat("RuyMatMul_%d_%d_%d_%s%s%s_threaded", shape.m,
+                           shape.k, shape.n, transpose_lhs ? "Tlhs_" : "",
+                           transpose_rhs ? "Trhs_" : "",
+                           single_threaded ? "single" : "multi");
+  }
+};
+
+TEST_P(RuyMatMulTest, DoIt) {
+  MatMulShape shape = std::get<0>(GetParam());
+  bool transpose_lhs = std::get<1>(GetParam());
+  bool transpose_rhs = std::get<2>(GetParam());
+  bool single_threaded = std::get<3>(GetParam());
+
+  auto a = MakeLinspaceArray2D(0.0, 1.0, shape.m, shape.k);
+  auto b = MakeLinspaceArray2D(-2.0, 2.0, shape.k, shape.n);
+  auto c = RuyMatrixMultiply(*a, *b, transpose_lhs, transpose_rhs,
+                             single_threaded, /*rhs_is_constant=*/false);
+  CheckMatrixMultiply(*a, *b, *c);
+}
+
+INSTANTIATE_TEST_SUITE_P(RuyMatMulTestInstantiaion, RuyMatMulTest,
+                         ::testing::Combine(::testing::ValuesIn(MatMulShapes),
+                                            ::testing::Bool(),
+                                            ::testing::Bool(),
+                                            ::testing::Bool()),
+                         RuyMatMulTest::Name);
+
+TEST_F(CpuRuntimeTest, RuyMatMulWithConstantRhs) {
+  const int64_t m = 4, k = 512, n = 512;
+  auto a = MakeLinspaceArray2D(0.0, 1.0, m, k);
+  auto b = MakeLinspaceArray2D(-2.0, 2.0, k, n);
+  auto a_column_major = MaybeTransposeArray2D(*a, true);
+  auto b_column_major = MaybeTransposeArray2D(*b, true);
+  Array2D<float> c_column_major(n, m);
+
+  // The second call may use the packed rhs cached by the first.
+  for (int i = 0; i < 2; ++i) {
+    __xla_cpu_runtime_RuySingleThreadedMatMulF32(
+        nullptr, c_column_major.data(), a_column_major->data(),
+        b_column_major->data(), m, n, k, /*transpose_lhs=*/false,
+        /*transpose_rhs=*/false, /*lhs_is_constant=*/false,
+        /*rhs_is_constant=*/true);
+    CheckMatrixMultiply(*a, *b, *MaybeTransposeArray2D(c_column_major, true));
+  }
+
+  // Reusing the buffer of the constant for different values must not pick up
+  // the stale packed copy once the caches are cleared.
+  b = MakeLinspaceArray2D(1.0, 3.0, k, n);
+  auto new_b_column_major = MaybeTransposeArray2D(*b, true);
+  std::copy(new_b_column_major->data(),
+            new_b_column_major->data() + new_b_column_major->num_elements(),
+            b_column_major->data());
+  cpu::runtime::ClearRuyPrepackedCaches();
+  __xla_cpu_runtime_RuySingleThreadedMatMulF32(
+      nullptr, c_column_major.data(), a_column_major->data(),
+      b_column_major->data(), m, n, k, /*transpose_lhs=*/false,
+      /*transpose_rhs=*/false, /*lhs_is_constant=*/false,
+      /*rhs_is_constant=*/true);
+  CheckMatrixMultiply(*a, *b, *MaybeTransposeArray2D(c_column_major, true));
+}
+
 TEST_F(CpuRuntimeTest, SuccessStatus) {
   XlaCustomCallStatus success_status;
   // Success is the default state.
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -69,6 +70,11 @@ struct DotInfo {
   Shape result_shape;
   DotDimensionNumbers dim_nums;
 
+  // Whether the operands are constants, whose packed form the runtime may
+  // cache across calls.
+  bool lhs_is_constant = false;
+  bool rhs_is_constant = false;
+
   DotInfo() = default;
 
   explicit DotInfo(const HloInstruction& instr) {
@@ -77,6 +83,8 @@ struct DotInfo {
     rhs_shape = instr.operand(1)->shape();
     result_shape = instr.shape();
     dim_nums = instr.dot_dimension_numbers();
+    lhs_is_constant = instr.operand(0)->IsConstant();
+    rhs_is_constant = instr.operand(1)->IsConstant();
   }
 };
 
@@ -140,6 +148,10 @@ class DotOpEmitter {
   // Emits a call to the CPU runtime to perform the matrix multiply.
   Status EmitCallToRuntime();
 
+  // Returns true if the F32 matrix multiply should call into ruy rather than
+  // Eigen or oneDNN.
+  bool ShouldUseRuy() const;
+
   // Represents the dimensions of a matrix-matrix multiply operation.
   struct MatMultDims {
     // The number of rows in the LHS.
@@ -739,10 +751,12 @@ Status DotOpEmitter::EmitCallToRuntime() {
   //          int64_t m, int64_t n, int64_t k, int32 transpose_lhs,
   //          int32 transpose_rhs);
   // The two transpose_... parameters are actually booleans, but we use int32
-  // to avoid target-dependent calling convention details.
+  // to avoid target-dependent calling convention details. The ruy functions
+  // take two more booleans, lhs_is_constant and rhs_is_constant.
 
   bool multi_threaded = ShouldUseMultiThreadedEigen(hlo_module_config_);
   bool use_mkl_dnn = hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
+  bool use_ruy = false;
   PrimitiveType type = target_array_.GetShape().element_type();
   llvm::Function* function = b_->GetInsertBlock()->getParent();
   llvm::Module* module = function->getParent();
@@ -756,12 +770,20 @@ Status DotOpEmitter::EmitCallToRuntime() {
       float_type = b_->getHalfTy();
       break;
     case F32:
-      fn_name = multi_threaded
-                    ? (use_mkl_dnn ? runtime::kMKLMatMulF32SymbolName
-                                   : runtime::kEigenMatMulF32SymbolName)
-                    : (use_mkl_dnn
-                           ? runtime::kMKLSingleThreadedMatMulF32SymbolName
-                           : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      use_ruy = ShouldUseRuy();
+      if (use_ruy) {
+        fn_name = multi_threaded
+                      ? runtime::kRuyMatMulF32SymbolName
+                      : runtime::kRuySingleThreadedMatMulF32SymbolName;
+      } else {
+        fn_name =
+            multi_threaded
+                ? (use_mkl_dnn ? runtime::kMKLMatMulF32SymbolName
+                               : runtime::kEigenMatMulF32SymbolName)
+                : (use_mkl_dnn
+                       ? runtime::kMKLSingleThreadedMatMulF32SymbolName
+                       : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      }
       float_type = b_->getFloatTy();
       break;
     case F64:
@@ -800,11 +822,15 @@ Status DotOpEmitter::EmitCallToRuntime() {
   llvm::Type* int64_type = b_->getInt64Ty();
   llvm::Type* int32_type = b_->getInt32Ty();
   llvm::Type* int8_ptr_type = b_->getInt8Ty()->getPointerTo();
-  llvm::FunctionType* matmul_type = llvm::FunctionType::get(
-      b_->getVoidTy(),
-      {int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type,
-       int64_type, int64_type, int64_type, int32_type, int32_type},
-      /*isVarArg=*/false);
+  std::vector<llvm::Type*> arg_types = {
+      int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type, int64_type,
+      int64_type,    int64_type,     int32_type,     int32_type};
+  if (use_ruy) {
+    arg_types.push_back(int32_type);
+    arg_types.push_back(int32_type);
+  }
+  llvm::FunctionType* matmul_type =
+      llvm::FunctionType::get(b_->getVoidTy(), arg_types, /*isVarArg=*/false);
 
   llvm::FunctionCallee matmul_func =
       module->getOrInsertFunction(fn_name, matmul_type);
@@ -833,25 +859,50 @@ Status DotOpEmitter::EmitCallToRuntime() {
   const llvm_ir::IrArray* rhs = &rhs_array_;
   bool transpose_lhs = !mat_mult_dims.lhs_canonical;
   bool transpose_rhs = !mat_mult_dims.rhs_canonical;
+  bool lhs_is_constant = dot_info_.lhs_is_constant;
+  bool rhs_is_constant = dot_info_.rhs_is_constant;
 
   if (!mat_mult_dims.lhs_column_major) {
     std::swap(mat_mult_dims.m, mat_mult_dims.n);
     std::swap(lhs, rhs);
     std::swap(transpose_lhs, transpose_rhs);
+    std::swap(lhs_is_constant, rhs_is_constant);
   }
 
-  b_->CreateCall(
-      matmul_func,
-      {b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
-       b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
-       b_->getInt64(mat_mult_dims.m), b_->getInt64(mat_mult_dims.n),
-       b_->getInt64(mat_mult_dims.k), b_->getInt32(transpose_lhs),
-       b_->getInt32(transpose_rhs)});
+  std::vector<llvm::Value*> args = {
+      b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
+      b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
+      b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
+      b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
+      b_->getInt64(mat_mult_dims.m),
+      b_->getInt64(mat_mult_dims.n),
+      b_->getInt64(mat_mult_dims.k),
+      b_->getInt32(transpose_lhs),
+      b_->getInt32(transpose_rhs)};
+  if (use_ruy) {
+    args.push_back(b_->getInt32(lhs_is_constant));
+    args.push_back(b_->getInt32(rhs_is_constant));
+  }
+  b_->CreateCall(matmul_func, args);
   return Status::OK();
 }
 
+bool DotOpEmitter::ShouldUseRuy() const {
+  options::MatmulRuntime matmul_runtime =
+      options::GetMatmulRuntime(hlo_module_config_);
+  if (matmul_runtime != options::MatmulRuntime::kAuto) {
+    return matmul_runtime == options::MatmulRuntime::kRuy;
+  }
+  // Eigen and oneDNN are tuned for large GEMMs and reach a fraction of peak
+  // when one side is only a few rows or columns, e.g. for small batch
+  // inference, which is where ruy's kernels do better.
+  constexpr int64_t kMaxSkinnyDimension = 8;
+  constexpr int64_t kMaxSmallGemmSize = 128 * 128 * 128;
+  MatMultDims dims = GetMatMultDims();
+  return std::min(dims.m, dims.n) <= kMaxSkinnyDimension ||
+         dims.m * dims.n * dims.k <= kMaxSmallGemmSize;
+}
+
 DotOpEmitter::MatMultDims DotOpEmitter::GetMatMultDims() const {
   CHECK_LE(dot_info_.result_shape.dimensions_size(), 2);
 
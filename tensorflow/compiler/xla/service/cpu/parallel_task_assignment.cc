@@ -79,8 +79,11 @@ class DefaultCostModel : public ParallelCostModel {
       max_parallelism = std::min<int64_t>(
           max_parallelism_,
           std::ceil(std::sqrt(tensorflow::port::MaxParallelism())));
-      // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
+      // Size the tasks so that the bytes each of them reads and writes fill
+      // the L2 cache. Counting only the output would leave loop fusions that
+      // read many large operands into a small result single-threaded.
+      instruction_cost = std::max(shape_size_(instruction->shape()),
+                                  cost_analysis_->bytes_accessed(*instruction));
       min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     } else {
       // Use max parallelism for compute bound instructions.
@@ -114,10 +117,18 @@ ParallelTaskAssignment::ParallelTaskAssignment(
     const TargetMachineFeatures* target_machine_features)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
+  // Run cost analysis on 'module'. Instructions in while bodies and called
+  // computations are assigned parallel tasks too, so cost every non-fusion
+  // computation rather than only the entry: otherwise they would look free of
+  // flops and bytes, and be treated as I/O bound outputs.
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
-  HloComputation* computation = module->entry_computation();
-  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  Status status;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    status = computation->Accept(cost_analysis.get());
+    if (!status.ok()) {
+      break;
+    }
+  }
   if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
     cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
@@ -205,5 +205,56 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, LoopFusionInWhileBodyParallelized) {
+  // The fusion writes a single L2-sized output, but reads three more, so it is
+  // worth splitting even though it runs inside a loop.
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_loop_fusion_in_while
+    fused_computation {
+      p0 = f32[65536]{0} parameter(0)
+      p1 = f32[65536]{0} parameter(1)
+      p2 = f32[65536]{0} parameter(2)
+      add0 = f32[65536]{0} add(p0, p1)
+      ROOT add1 = f32[65536]{0} add(add0, p2)
+    }
+    body {
+      state = (s32[], f32[65536]{0}, f32[65536]{0}, f32[65536]{0}) parameter(0)
+      i = s32[] get-tuple-element(state), index=0
+      one = s32[] constant(1)
+      next_i = s32[] add(i, one)
+      a = f32[65536]{0} get-tuple-element(state), index=1
+      b = f32[65536]{0} get-tuple-element(state), index=2
+      c = f32[65536]{0} get-tuple-element(state), index=3
+      sum = f32[65536]{0} fusion(a, b, c), kind=kLoop, calls=fused_computation
+      ROOT next_state = (s32[], f32[65536]{0}, f32[65536]{0}, f32[65536]{0})
+        tuple(next_i, sum, b, c)
+    }
+    condition {
+      state = (s32[], f32[65536]{0}, f32[65536]{0}, f32[65536]{0}) parameter(0)
+      i = s32[] get-tuple-element(state), index=0
+      limit = s32[] constant(10)
+      ROOT less_than = pred[] compare(i, limit), direction=LT
+    }
+    ENTRY main {
+      zero = s32[] constant(0)
+      a = f32[65536]{0} parameter(0)
+      b = f32[65536]{0} parameter(1)
+      c = f32[65536]{0} parameter(2)
+      init = (s32[], f32[65536]{0}, f32[65536]{0}, f32[65536]{0})
+        tuple(zero, a, b, c)
+      ROOT while = (s32[], f32[65536]{0}, f32[65536]{0}, f32[65536]{0})
+        while(init), condition=condition, body=body
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+  HloInstruction* sum =
+      m->GetComputationWithName("body")->root_instruction()->mutable_operand(1);
+  EXPECT_EQ(sum->opcode(), HloOpcode::kCall);
+}
+
 }  // namespace
 }  // namespace xla
@@ -15,10 +15,14 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FFT_IMPL_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FFT_IMPL_H_
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <complex>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "third_party/eigen3/unsupported/Eigen/FFT"
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -176,6 +180,97 @@ void EigenFftC2R(const EigenDevice& device, Real* out, Complex* operand,
       full_fft.template fft<Eigen::RealPart, Eigen::FFT_REVERSE>(inner_axis);
 }
 
+// Returns this thread's Eigen::FFT, which keeps the factorization and twiddle
+// factors of every length it has transformed. The tensor fft() recomputes them
+// on every call, which dominates the cost of small transforms. Eigen::FFT is
+// not thread safe, hence one per thread.
+template <typename Real>
+Eigen::FFT<Real>& GetThreadLocalFft() {
+  // Real transforms produce and consume only the non-negative frequencies.
+  thread_local Eigen::FFT<Real> fft(typename Eigen::FFT<Real>::impl_type(),
+                                    Eigen::FFT<Real>::HalfSpectrum);
+  return fft;
+}
+
+// Calls `fn` for every index in [0, batch). The generic version runs them in
+// order; the thread pool version below splits them across the pool.
+template <typename EigenDevice, typename Fn>
+void ForEachBatchElement(const EigenDevice& device, int64_t batch,
+                         const Eigen::TensorOpCost& cost, Fn fn) {
+  for (int64_t i = 0; i < batch; ++i) {
+    fn(i);
+  }
+}
+
+#ifdef EIGEN_USE_THREADS
+template <typename Fn>
+void ForEachBatchElement(const Eigen::ThreadPoolDevice& device, int64_t batch,
+                         const Eigen::TensorOpCost& cost, Fn fn) {
+  device.parallelFor(batch, cost,
+                     [&fn](Eigen::Index first, Eigen::Index last) {
+                       for (Eigen::Index i = first; i < last; ++i) {
+                         fn(i);
+                       }
+                     });
+}
+#endif  // EIGEN_USE_THREADS
+
+// Computes a batch of one-dimensional transforms of any type with the cached
+// Eigen::FFT plans.
+template <typename EigenDevice, typename Real>
+void EigenFft1D(const EigenDevice& device, void* out, void* operand,
+                FftType fft_type, int64_t input_batch, int64_t fft_length) {
+  using Complex = std::complex<Real>;
+  const int64_t n = fft_length;
+  const int64_t half_n = n / 2 + 1;
+  const bool real_input = fft_type == FftType::RFFT;
+  const bool real_output = fft_type == FftType::IRFFT;
+  const int64_t in_elems = (real_input || !real_output) ? n : half_n;
+  const int64_t out_elems = fft_type == FftType::RFFT ? half_n : n;
+  // The usual estimate of 5 n log2(n) flops for a radix-2 FFT.
+  const Eigen::TensorOpCost cost(
+      in_elems * (real_input ? sizeof(Real) : sizeof(Complex)),
+      out_elems * (real_output ? sizeof(Real) : sizeof(Complex)),
+      5.0 * n * std::max(1.0, std::log2(static_cast<double>(n))));
+
+  switch (fft_type) {
+    case FftType::FFT:
+    case FftType::IFFT: {
+      Complex* in = static_cast<Complex*>(operand);
+      Complex* result = static_cast<Complex*>(out);
+      const bool forward = fft_type == FftType::FFT;
+      ForEachBatchElement(device, input_batch, cost, [&](int64_t i) {
+        Eigen::FFT<Real>& fft = GetThreadLocalFft<Real>();
+        if (forward) {
+          fft.fwd(result + i * n, in + i * n, n);
+        } else {
+          fft.inv(result + i * n, in + i * n, n);
+        }
+      });
+      break;
+    }
+    case FftType::RFFT: {
+      Real* in = static_cast<Real*>(operand);
+      Complex* result = static_cast<Complex*>(out);
+      ForEachBatchElement(device, input_batch, cost, [&](int64_t i) {
+        GetThreadLocalFft<Real>().fwd(result + i * half_n, in + i * n, n);
+      });
+      break;
+    }
+    case FftType::IRFFT: {
+      Complex* in = static_cast<Complex*>(operand);
+      Real* result = static_cast<Real*>(out);
+      ForEachBatchElement(device, input_batch, cost, [&](int64_t i) {
+        GetThreadLocalFft<Real>().inv(result + i * n, in + i * half_n, n);
+      });
+      break;
+    }
+    default:
+      // Unsupported FFT type
+      abort();
+  }
+}
+
 template <int FFTRank, typename EigenDevice>
 void EigenFftWithRank(const EigenDevice& device, void* out, void* operand,
                       FftType fft_type, bool double_precision,
@@ -247,9 +342,20 @@ void EigenFftImpl(const EigenDevice& device, void* out, void* operand,
                   int64_t fft_length2) {
   switch (fft_rank) {
     case 1:
-      internal::EigenFftWithRank<1, EigenDevice>(device, out, operand, fft_type,
-                                                 double_precision, input_batch,
-                                                 fft_length0, 0, 0);
+      // One-dimensional transforms are independent across the batch, so they
+      // are computed one at a time with cached plans, in parallel if the
+      // device has a thread pool. Eigen::FFT does not handle length 1.
+      if (fft_length0 <= 1) {
+        internal::EigenFftWithRank<1, EigenDevice>(
+            device, out, operand, fft_type, double_precision, input_batch,
+            fft_length0, 0, 0);
+      } else if (double_precision) {
+        internal::EigenFft1D<EigenDevice, double>(
+            device, out, operand, fft_type, input_batch, fft_length0);
+      } else {
+        internal::EigenFft1D<EigenDevice, float>(
+            device, out, operand, fft_type, input_batch, fft_length0);
+      }
       break;
     case 2:
       internal::EigenFftWithRank<2, EigenDevice>(device, out, operand, fft_type,
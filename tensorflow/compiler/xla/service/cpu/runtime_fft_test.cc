@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/xla/service/cpu/runtime_fft_impl.h"
+
+#include <complex>
+#include <vector>
+
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -29,3 +33,51 @@ TEST(FftTypeTest, MatchesProto) {
   EXPECT_EQ(::xla::FftType::IRFFT, static_cast<::tensorflow::int32>(
                                        ::tensorflow::xla::FftType::IRFFT));
 }
+
+TEST(EigenFftTest, ImpulseTransformsToConstant) {
+  Eigen::DefaultDevice device;
+  constexpr int64_t kBatch = 3;
+  constexpr int64_t kLength = 12;
+  std::vector<std::complex<float>> input(kBatch * kLength);
+  for (int64_t b = 0; b < kBatch; ++b) {
+    input[b * kLength] = std::complex<float>(b + 1, 0);
+  }
+  std::vector<std::complex<float>> output(kBatch * kLength);
+  ::tensorflow::xla::EigenFftImpl(
+      device, output.data(), input.data(), ::tensorflow::xla::FftType::FFT,
+      /*double_precision=*/false, /*fft_rank=*/1, kBatch, kLength, 0, 0);
+  for (int64_t b = 0; b < kBatch; ++b) {
+    for (int64_t i = 0; i < kLength; ++i) {
+      EXPECT_NEAR(output[b * kLength + i].real(), b + 1, 1e-5);
+      EXPECT_NEAR(output[b * kLength + i].imag(), 0, 1e-5);
+    }
+  }
+}
+
+// Runs the real transforms of every length twice, so that the second round
+// uses the plans cached by the first.
+TEST(EigenFftTest, RealRoundTrip) {
+  Eigen::DefaultDevice device;
+  constexpr int64_t kBatch = 2;
+  for (int round = 0; round < 2; ++round) {
+    for (int64_t length : {1, 2, 5, 8, 30, 64}) {
+      std::vector<double> input(kBatch * length);
+      for (int64_t i = 0; i < input.size(); ++i) {
+        input[i] = (i * 7 % 11) - 5.0;
+      }
+      std::vector<std::complex<double>> spectrum(kBatch * (length / 2 + 1));
+      ::tensorflow::xla::EigenFftImpl(
+          device, spectrum.data(), input.data(),
+          ::tensorflow::xla::FftType::RFFT, /*double_precision=*/true,
+          /*fft_rank=*/1, kBatch, length, 0, 0);
+      std::vector<double> output(kBatch * length);
+      ::tensorflow::xla::EigenFftImpl(
+          device, output.data(), spectrum.data(),
+          ::tensorflow::xla::FftType::IRFFT, /*double_precision=*/true,
+          /*fft_rank=*/1, kBatch, length, 0, 0);
+      for (int64_t i = 0; i < input.size(); ++i) {
+        EXPECT_NEAR(output[i], input[i], 1e-9) << "length " << length;
+      }
+    }
+  }
+}
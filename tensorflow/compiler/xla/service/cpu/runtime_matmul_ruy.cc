@@ -0,0 +1,147 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/cpu/runtime_matmul_ruy.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#define EIGEN_USE_THREADS
+
+#include "ruy/context.h"  // from @ruy
+#include "ruy/mul_params.h"  // from @ruy
+#include "ruy/ruy.h"  // from @ruy
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace {
+
+// ruy contexts are not thread safe, so every call borrows one from this pool.
+// Each context keeps its own cache of packed constants. ClearAll drops the
+// idle contexts and makes the ones in use be dropped when they are returned.
+class RuyContextPool {
+ public:
+  struct Entry {
+    std::unique_ptr<ruy::Context> context;
+    int64_t generation;
+  };
+
+  static RuyContextPool* Get() {
+    static RuyContextPool* pool = new RuyContextPool;
+    return pool;
+  }
+
+  Entry Acquire() {
+    tensorflow::mutex_lock lock(mu_);
+    if (free_.empty()) {
+      return {std::make_unique<ruy::Context>(), generation_};
+    }
+    Entry entry = std::move(free_.back());
+    free_.pop_back();
+    return entry;
+  }
+
+  void Release(Entry entry) {
+    tensorflow::mutex_lock lock(mu_);
+    if (entry.generation == generation_) {
+      free_.push_back(std::move(entry));
+    }
+  }
+
+  void ClearAll() {
+    tensorflow::mutex_lock lock(mu_);
+    free_.clear();
+    ++generation_;
+  }
+
+ private:
+  tensorflow::mutex mu_;
+  std::vector<Entry> free_ TF_GUARDED_BY(mu_);
+  int64_t generation_ TF_GUARDED_BY(mu_) = 0;
+};
+
+void MakeRuyMatrix(float* data, int64_t rows, int64_t cols, bool transpose,
+                   bool is_constant, ruy::Matrix<float>* matrix) {
+  // A transposed column-major matrix is the same buffer read as row major.
+  ruy::MakeSimpleLayout(
+      rows, cols, transpose ? ruy::Order::kRowMajor : ruy::Order::kColMajor,
+      matrix->mutable_layout());
+  matrix->set_data(data);
+  if (is_constant) {
+    matrix->set_cache_policy(ruy::CachePolicy::kCacheIfLargeSpeedup);
+  }
+}
+
+void RuyMatMul(int num_threads, float* out, float* lhs, float* rhs, int64_t m,
+               int64_t n, int64_t k, int32_t transpose_lhs,
+               int32_t transpose_rhs, int32_t lhs_is_constant,
+               int32_t rhs_is_constant) {
+  ruy::Matrix<float> ruy_lhs;
+  ruy::Matrix<float> ruy_rhs;
+  ruy::Matrix<float> ruy_out;
+  MakeRuyMatrix(lhs, m, k, transpose_lhs, lhs_is_constant, &ruy_lhs);
+  MakeRuyMatrix(rhs, k, n, transpose_rhs, rhs_is_constant, &ruy_rhs);
+  MakeRuyMatrix(out, m, n, /*transpose=*/false, /*is_constant=*/false,
+                &ruy_out);
+
+  RuyContextPool* pool = RuyContextPool::Get();
+  RuyContextPool::Entry entry = pool->Acquire();
+  entry.context->set_max_num_threads(num_threads);
+  ruy::Mul(ruy_lhs, ruy_rhs, ruy::MulParams<float, float>(),
+           entry.context.get(), &ruy_out);
+  pool->Release(std::move(entry));
+}
+
+}  // namespace
+
+namespace xla {
+namespace cpu {
+namespace runtime {
+
+void ClearRuyPrepackedCaches() { RuyContextPool::Get()->ClearAll(); }
+
+}  // namespace runtime
+}  // namespace cpu
+}  // namespace xla
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_RuyMatMulF32(
+    const void* run_options_ptr, float* out, float* lhs, float* rhs, int64_t m,
+    int64_t n, int64_t k, int32_t transpose_lhs, int32_t transpose_rhs,
+    int32_t lhs_is_constant, int32_t rhs_is_constant) {
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  // Use the same number of threads as the Eigen dots and convolutions so that
+  // switching between ruy and Eigen does not change the parallelism.
+  int num_threads = 1;
+  if (run_options != nullptr &&
+      run_options->intra_op_thread_pool() != nullptr) {
+    num_threads = run_options->intra_op_thread_pool()->numThreads();
+  }
+  RuyMatMul(num_threads, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs,
+            lhs_is_constant, rhs_is_constant);
+}
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_RuySingleThreadedMatMulF32(
+    const void* run_options_ptr, float* out, float* lhs, float* rhs, int64_t m,
+    int64_t n, int64_t k, int32_t transpose_lhs, int32_t transpose_rhs,
+    int32_t lhs_is_constant, int32_t rhs_is_constant) {
+  RuyMatMul(/*num_threads=*/1, out, lhs, rhs, m, n, k, transpose_lhs,
+            transpose_rhs, lhs_is_constant, rhs_is_constant);
+}
@@ -0,0 +1,59 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_MATMUL_RUY_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_MATMUL_RUY_H_
+
+#include <stdint.h>
+
+extern "C" {
+
+// Performs a matrix multiplication using ruy. The operands follow the
+// conventions of __xla_cpu_runtime_EigenMatMulF32: 'lhs', 'rhs' and 'out' are
+// column major, lhs is m x k, rhs is k x n, and out is m x n.
+//
+// If 'lhs_is_constant' or 'rhs_is_constant' is set, the packed form of that
+// operand is cached across calls, keyed by its address. The multi-threaded
+// version uses as many threads as the intra-op thread pool of the run options
+// has.
+extern void __xla_cpu_runtime_RuyMatMulF32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    float* lhs, float* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs, int32_t lhs_is_constant,
+    int32_t rhs_is_constant);
+
+extern void __xla_cpu_runtime_RuySingleThreadedMatMulF32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    float* lhs, float* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs, int32_t lhs_is_constant,
+    int32_t rhs_is_constant);
+
+}  // extern "C"
+
+namespace xla {
+namespace cpu {
+namespace runtime {
+
+// Drops the packed constants cached by the ruy matmul functions. Must be called
+// when constants they may have seen are freed, since a new constant could be
+// allocated at the same address.
+void ClearRuyPrepackedCaches();
+
+}  // namespace runtime
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_MATMUL_RUY_H_
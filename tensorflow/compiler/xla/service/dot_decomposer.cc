@@ -175,42 +175,41 @@ Status CanonicalizeDot(HloInstruction* original_dot) {
 
 }  // namespace
 
-StatusOr<bool> DotDecomposer::Run(HloModule* module) {
+StatusOr<bool> DotDecomposer::RunOnComputation(
+    HloComputation* computation) {
   // Gather all Non-canonical Dot operations.
   std::vector<HloInstruction*> non_canonical_dots;
-  for (auto* computation : module->MakeNonfusionComputations()) {
-    for (auto* instruction : computation->instructions()) {
-      if (instruction->opcode() != HloOpcode::kDot) {
-        continue;
-      }
-      const DotDimensionNumbers& dnums = instruction->dot_dimension_numbers();
-      // A dot it not canonical if there is more than one contracting dimension.
-      if (dnums.lhs_contracting_dimensions_size() != 1) {
-        non_canonical_dots.push_back(instruction);
-        continue;
-      }
-      // A dot is not canonical if it has more than one non-contracting
-      // dimension.
-      if (dnums.lhs_batch_dimensions_size() + 2 <
-              instruction->operand(0)->shape().rank() ||
-          dnums.rhs_batch_dimensions_size() + 2 <
-              instruction->operand(1)->shape().rank()) {
-        non_canonical_dots.push_back(instruction);
-        continue;
-      }
-      if (dnums.lhs_batch_dimensions().empty() &&
-          dnums.lhs_contracting_dimensions().empty()) {
-        non_canonical_dots.push_back(instruction);
-        continue;
-      }
-      // Check that batch dims, if present, are canonical.
-      std::vector<int64_t> canonical_batch_dims(
-          dnums.lhs_batch_dimensions_size());
-      absl::c_iota(canonical_batch_dims, 0);
-      if (!absl::c_equal(dnums.lhs_batch_dimensions(), canonical_batch_dims) ||
-          !absl::c_equal(dnums.rhs_batch_dimensions(), canonical_batch_dims)) {
-        non_canonical_dots.push_back(instruction);
-      }
+  for (auto* instruction : computation->instructions()) {
+    if (instruction->opcode() != HloOpcode::kDot) {
+      continue;
+    }
+    const DotDimensionNumbers& dnums = instruction->dot_dimension_numbers();
+    // A dot it not canonical if there is more than one contracting dimension.
+    if (dnums.lhs_contracting_dimensions_size() != 1) {
+      non_canonical_dots.push_back(instruction);
+      continue;
+    }
+    // A dot is not canonical if it has more than one non-contracting
+    // dimension.
+    if (dnums.lhs_batch_dimensions_size() + 2 <
+            instruction->operand(0)->shape().rank() ||
+        dnums.rhs_batch_dimensions_size() + 2 <
+            instruction->operand(1)->shape().rank()) {
+      non_canonical_dots.push_back(instruction);
+      continue;
+    }
+    if (dnums.lhs_batch_dimensions().empty() &&
+        dnums.lhs_contracting_dimensions().empty()) {
+      non_canonical_dots.push_back(instruction);
+      continue;
+    }
+    // Check that batch dims, if present, are canonical.
+    std::vector<int64_t> canonical_batch_dims(
+        dnums.lhs_batch_dimensions_size());
+    absl::c_iota(canonical_batch_dims, 0);
+    if (!absl::c_equal(dnums.lhs_batch_dimensions(), canonical_batch_dims) ||
+        !absl::c_equal(dnums.rhs_batch_dimensions(), canonical_batch_dims)) {
+      non_canonical_dots.push_back(instruction);
     }
   }
   bool changed = false;
@@ -24,13 +24,13 @@ namespace xla {
 // DotDecomposer is a pass which converts dots into a canonical form where
 // non-contracting and contracting dimensions are reshaped together and batch
 // dimensions are the most major dimensions.
-class DotDecomposer : public HloModulePass {
+class DotDecomposer : public HloComputationPass {
  public:
   absl::string_view name() const override { return "dot_decomposer"; }
 
-  // Run DotDecomposer pass on computations in 'module'.
-  // Returns whether the 'module' was changed.
-  StatusOr<bool> Run(HloModule* module) override;
+  // Run DotDecomposer pass on 'computation'.
+  // Returns whether the 'computation' was changed.
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override;
 };
 
 }  // namespace xla
@@ -0,0 +1,201 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_results_store.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/autotune_maps/autotune_maps_utils.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+bool IsTextProtoPath(const std::string& path) {
+  return absl::EndsWith(path, ".pbtxt") || absl::EndsWith(path, ".txt");
+}
+
+}  // namespace
+
+/*static*/ AutotuneResultsStore& AutotuneResultsStore::Global() {
+  static auto& store = *new AutotuneResultsStore();
+  return store;
+}
+
+/*static*/ std::string AutotuneResultsStore::DeviceKey(
+    se::StreamExecutor* executor) {
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  std::string device = tensorflow::autotune_maps_utils::DeviceIdToIdentifier(
+      executor->device_ordinal());
+#else
+  std::string device = executor->GetDeviceDescription().name();
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+  std::string dnn_version = "none";
+  if (auto* dnn = executor->AsDnn()) {
+    StatusOr<se::dnn::VersionInfo> version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+      dnn_version = absl::StrCat(version.major_version(), ".",
+                                 version.minor_version(), ".", version.patch());
+    }
+  }
+  std::string blas_version = "none";
+  if (auto* blas = executor->AsBlas()) {
+    (void)blas->GetVersion(&blas_version);
+  }
+  return absl::StrCat(device, ", dnn ", dnn_version, ", blas ", blas_version);
+}
+
+/*static*/ std::string AutotuneResultsStore::HloKey(
+    const HloInstruction& instr) {
+  auto options = HloPrintOptions::Canonical();
+  options.set_print_backend_config(true);
+  return instr.ToString(options);
+}
+
+absl::optional<tensorflow::AutotuneResult> AutotuneResultsStore::Lookup(
+    Kind kind, const std::string& device, const std::string& hlo) {
+  tensorflow::mutex_lock lock(mu_);
+  auto it = results_.find(std::make_tuple(kind, device, hlo));
+  if (it == results_.end()) {
+    ++misses_;
+    VLOG(4) << "Autotune results store miss: " << hlo;
+    return absl::nullopt;
+  }
+  ++hits_;
+  VLOG(2) << "Autotune results store hits/(hits + misses): " << hits_ << "/"
+          << hits_ + misses_;
+  return it->second;
+}
+
+bool AutotuneResultsStore::Insert(Kind kind, const std::string& device,
+                                  const std::string& hlo,
+                                  const tensorflow::AutotuneResult& result) {
+  tensorflow::mutex_lock lock(mu_);
+  return results_.emplace(std::make_tuple(kind, device, hlo), result).second;
+}
+
+Status AutotuneResultsStore::Load(const AutotuneResults& results) {
+  if (results.version() != kVersion) {
+    return InvalidArgument(
+        "Autotune results have version %d, but version %d is expected.",
+        results.version(), kVersion);
+  }
+  tensorflow::mutex_lock lock(mu_);
+  for (const AutotuneResults::Entry& entry : results.dots()) {
+    results_.emplace(std::make_tuple(Kind::kGemm, entry.device(), entry.hlo()),
+                     entry.result());
+  }
+  for (const AutotuneResults::Entry& entry : results.convs()) {
+    results_.emplace(std::make_tuple(Kind::kConv, entry.device(), entry.hlo()),
+                     entry.result());
+  }
+  return Status::OK();
+}
+
+AutotuneResults AutotuneResultsStore::Serialize() const {
+  tensorflow::mutex_lock lock(mu_);
+  // The map is unordered, so entries are sorted by key to make the output
+  // deterministic.
+  std::vector<const Key*> keys;
+  keys.reserve(results_.size());
+  for (const auto& kv : results_) {
+    keys.push_back(&kv.first);
+  }
+  std::sort(keys.begin(), keys.end(),
+            [](const Key* a, const Key* b) { return *a < *b; });
+
+  AutotuneResults results;
+  results.set_version(kVersion);
+  for (const Key* key : keys) {
+    AutotuneResults::Entry* entry = std::get<0>(*key) == Kind::kGemm
+                                        ? results.add_dots()
+                                        : results.add_convs();
+    entry->set_device(std::get<1>(*key));
+    entry->set_hlo(std::get<2>(*key));
+    *entry->mutable_result() = results_.at(*key);
+  }
+  return results;
+}
+
+Status AutotuneResultsStore::MaybeLoad(const DebugOptions& debug_options) {
+  const std::string& path = debug_options.xla_gpu_load_autotune_results_from();
+  if (path.empty()) {
+    return Status::OK();
+  }
+  {
+    tensorflow::mutex_lock lock(mu_);
+    if (!loaded_paths_.insert(path).second) {
+      return Status::OK();
+    }
+  }
+  return LoadFromFile(path);
+}
+
+Status AutotuneResultsStore::MaybeExport(
+    const DebugOptions& debug_options) const {
+  const std::string& path = debug_options.xla_gpu_dump_autotune_results_to();
+  if (path.empty()) {
+    return Status::OK();
+  }
+  return ExportToFile(path);
+}
+
+Status AutotuneResultsStore::LoadFromFile(const std::string& path) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  AutotuneResults results;
+  TF_RETURN_IF_ERROR(IsTextProtoPath(path)
+                         ? tensorflow::ReadTextProto(env, path, &results)
+                         : tensorflow::ReadBinaryProto(env, path, &results));
+  TF_RETURN_IF_ERROR(Load(results));
+  VLOG(1) << "Loaded " << results.dots_size() << " GEMM and "
+          << results.convs_size() << " convolution autotune results from "
+          << path;
+  return Status::OK();
+}
+
+Status AutotuneResultsStore::ExportToFile(const std::string& path) const {
+  // The results are written to a temporary file first, so that a process
+  // loading them concurrently never reads a partial file.
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const AutotuneResults results = Serialize();
+  const std::string tmp_path = absl::StrCat(path, ".tmp.", env->NowMicros());
+  Status status = IsTextProtoPath(path)
+                      ? tensorflow::WriteTextProto(env, tmp_path, results)
+                      : tensorflow::WriteBinaryProto(env, tmp_path, results);
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+void AutotuneResultsStore::Clear() {
+  tensorflow::mutex_lock lock(mu_);
+  results_.clear();
+  loaded_paths_.clear();
+  hits_ = 0;
+  misses_ = 0;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,105 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_STORE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_STORE_H_
+
+#include <string>
+#include <tuple>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+
+namespace xla {
+namespace gpu {
+
+// The process-wide store of the algorithms GemmAlgorithmPicker and
+// GpuConvAlgorithmPicker picked. Results are keyed by the device they were
+// measured on and the canonical text of the instruction, so that they can be
+// exported after a run and loaded into another process, which then skips
+// autotuning for every instruction the store covers. Loading the same results
+// into every replica also makes them pick the same algorithms.
+//
+// This class is thread-safe.
+class AutotuneResultsStore {
+ public:
+  enum class Kind { kGemm, kConv };
+
+  // Bumped whenever the meaning of stored results changes.
+  static constexpr int kVersion = 1;
+
+  static AutotuneResultsStore& Global();
+
+  // Identifies the GPU model of `executor` together with the cuDNN and cuBLAS
+  // versions it uses. The GPU model is described the same way as in the
+  // TensorFlow runtime's convolution autotune maps.
+  static std::string DeviceKey(se::StreamExecutor* executor);
+
+  // Returns the canonical text of `instr` that results are keyed by.
+  static std::string HloKey(const HloInstruction& instr);
+
+  absl::optional<tensorflow::AutotuneResult> Lookup(Kind kind,
+                                                    const std::string& device,
+                                                    const std::string& hlo);
+
+  // Stores `result`, unless a result is already stored for the same key.
+  // Returns whether it was stored.
+  bool Insert(Kind kind, const std::string& device, const std::string& hlo,
+              const tensorflow::AutotuneResult& result);
+
+  // Adds `results` to the store. Results already present are kept.
+  Status Load(const AutotuneResults& results);
+
+  // Returns all stored results, sorted so that the output is deterministic.
+  AutotuneResults Serialize() const;
+
+  // Loads the results `debug_options` points to, unless the file was loaded
+  // before, and exports the store to the file `debug_options` points to.
+  // The export happens at the end of every autotuning pass, so the file always
+  // holds everything autotuned so far.
+  Status MaybeLoad(const DebugOptions& debug_options);
+  Status MaybeExport(const DebugOptions& debug_options) const;
+
+  // Reads and writes results as a text proto if `path` ends in ".pbtxt" or
+  // ".txt" and as a binary proto otherwise.
+  Status LoadFromFile(const std::string& path);
+  Status ExportToFile(const std::string& path) const;
+
+  // Drops all results. For tests only.
+  void Clear();
+
+ private:
+  using Key = std::tuple<Kind, std::string, std::string>;
+
+  mutable tensorflow::mutex mu_;
+  absl::flat_hash_map<Key, tensorflow::AutotuneResult> results_
+      TF_GUARDED_BY(mu_);
+  absl::flat_hash_set<std::string> loaded_paths_ TF_GUARDED_BY(mu_);
+  int64_t hits_ TF_GUARDED_BY(mu_) = 0;
+  int64_t misses_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_STORE_H_
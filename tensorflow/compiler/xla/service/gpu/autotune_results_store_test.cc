@@ -0,0 +1,126 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_results_store.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using Kind = AutotuneResultsStore::Kind;
+
+constexpr char kDevice[] = "Tesla V100 sm_7.0, dnn 8.1.0, blas 11402";
+
+tensorflow::AutotuneResult GemmResult(int64_t algorithm) {
+  tensorflow::AutotuneResult result;
+  result.mutable_gemm()->set_algorithm(algorithm);
+  return result;
+}
+
+tensorflow::AutotuneResult ConvResult(int64_t algorithm) {
+  tensorflow::AutotuneResult result;
+  result.mutable_conv()->set_algorithm(algorithm);
+  result.set_scratch_bytes(1024);
+  return result;
+}
+
+TEST(AutotuneResultsStoreTest, KeysByKindDeviceAndHlo) {
+  AutotuneResultsStore store;
+  EXPECT_TRUE(store.Insert(Kind::kGemm, kDevice, "dot", GemmResult(3)));
+  EXPECT_FALSE(store.Insert(Kind::kGemm, kDevice, "dot", GemmResult(4)));
+
+  auto result = store.Lookup(Kind::kGemm, kDevice, "dot");
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->gemm().algorithm(), 3);
+  EXPECT_FALSE(store.Lookup(Kind::kConv, kDevice, "dot").has_value());
+  EXPECT_FALSE(store.Lookup(Kind::kGemm, "other device", "dot").has_value());
+}
+
+TEST(AutotuneResultsStoreTest, SerializeIsDeterministic) {
+  AutotuneResultsStore store;
+  store.Insert(Kind::kGemm, kDevice, "dot.2", GemmResult(2));
+  store.Insert(Kind::kConv, kDevice, "conv", ConvResult(5));
+  store.Insert(Kind::kGemm, kDevice, "dot.1", GemmResult(1));
+
+  AutotuneResults results = store.Serialize();
+  EXPECT_EQ(results.version(), AutotuneResultsStore::kVersion);
+  ASSERT_EQ(results.dots_size(), 2);
+  EXPECT_EQ(results.dots(0).hlo(), "dot.1");
+  EXPECT_EQ(results.dots(1).hlo(), "dot.2");
+  ASSERT_EQ(results.convs_size(), 1);
+  EXPECT_EQ(results.convs(0).device(), kDevice);
+  EXPECT_EQ(results.convs(0).result().scratch_bytes(), 1024);
+}
+
+TEST(AutotuneResultsStoreTest, LoadKeepsExistingResults) {
+  AutotuneResultsStore store;
+  store.Insert(Kind::kGemm, kDevice, "dot", GemmResult(1));
+
+  AutotuneResults results;
+  results.set_version(AutotuneResultsStore::kVersion);
+  AutotuneResults::Entry* entry = results.add_dots();
+  entry->set_device(kDevice);
+  entry->set_hlo("dot");
+  *entry->mutable_result() = GemmResult(7);
+  entry = results.add_convs();
+  entry->set_device(kDevice);
+  entry->set_hlo("conv");
+  *entry->mutable_result() = ConvResult(2);
+  TF_ASSERT_OK(store.Load(results));
+
+  EXPECT_EQ(store.Lookup(Kind::kGemm, kDevice, "dot")->gemm().algorithm(), 1);
+  EXPECT_EQ(store.Lookup(Kind::kConv, kDevice, "conv")->conv().algorithm(), 2);
+}
+
+TEST(AutotuneResultsStoreTest, RejectsOtherVersions) {
+  AutotuneResultsStore store;
+  AutotuneResults results;
+  results.set_version(AutotuneResultsStore::kVersion + 1);
+  results.add_dots()->set_hlo("dot");
+  EXPECT_FALSE(store.Load(results).ok());
+  EXPECT_FALSE(store.Lookup(Kind::kGemm, "", "dot").has_value());
+}
+
+TEST(AutotuneResultsStoreTest, RoundTripsThroughFiles) {
+  std::string dir = tensorflow::testing::TmpDir();
+  for (const char* name : {"results.pb", "results.pbtxt"}) {
+    const std::string path = tensorflow::io::JoinPath(dir, name);
+    AutotuneResultsStore exported;
+    exported.Insert(Kind::kConv, kDevice, "conv", ConvResult(4));
+    DebugOptions debug_options;
+    debug_options.set_xla_gpu_dump_autotune_results_to(path);
+    TF_ASSERT_OK(exported.MaybeExport(debug_options));
+
+    AutotuneResultsStore loaded;
+    debug_options.set_xla_gpu_load_autotune_results_from(path);
+    TF_ASSERT_OK(loaded.MaybeLoad(debug_options));
+    auto result = loaded.Lookup(Kind::kConv, kDevice, "conv");
+    ASSERT_TRUE(result.has_value()) << name;
+    EXPECT_EQ(result->conv().algorithm(), 4);
+
+    // A file is only loaded once.
+    TF_ASSERT_OK(tensorflow::Env::Default()->DeleteFile(path));
+    TF_EXPECT_OK(loaded.MaybeLoad(debug_options));
+  }
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -51,6 +51,7 @@ class BufferAllocations {
     return memory_allocator_;
   }
   int device_ordinal() const { return device_ordinal_; }
+  int64_t buffer_count() const { return buffers_.size(); }
 
   // Returns the device address of buffer `buffer_index`. `buffer_index` must be
   // a valid index, i.e., in [0, buffer_count). This function returns null if
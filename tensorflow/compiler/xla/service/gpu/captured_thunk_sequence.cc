@@ -0,0 +1,225 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/captured_thunk_sequence.h"
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/copy_thunk.h"
+#include "tensorflow/compiler/xla/service/gpu/sequential_thunk.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/scoped_annotation.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+using ::tensorflow::profiler::ScopedAnnotation;
+
+// Runs of fewer thunks are executed as usual, since launching a graph costs
+// about as much as launching a few kernels.
+constexpr int64_t kMinThunksPerGraph = 4;
+
+Status ExecuteThunk(Thunk* thunk, const Thunk::ExecuteParams& params) {
+  ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
+  return thunk->ExecuteOnStream(params);
+}
+
+}  // namespace
+
+CapturedThunkSequence::CapturedThunkSequence(const ThunkSequence& thunks) {
+  std::vector<Thunk*> run;
+  auto end_run = [&] {
+    if (run.size() >= kMinThunksPerGraph) {
+      segments_.push_back({std::move(run), /*captured=*/true});
+    } else {
+      for (Thunk* thunk : run) {
+        segments_.push_back({{thunk}, /*captured=*/false});
+      }
+    }
+    run.clear();
+  };
+  for (const std::unique_ptr<Thunk>& thunk : thunks) {
+    if (CanCapture(*thunk)) {
+      run.push_back(thunk.get());
+      continue;
+    }
+    end_run();
+    segments_.push_back({{thunk.get()}, /*captured=*/false});
+  }
+  end_run();
+  VLOG(2) << "Capturing thunks into " << graph_count() << " graphs.";
+}
+
+CapturedThunkSequence::~CapturedThunkSequence() {
+#if GOOGLE_CUDA
+  tensorflow::mutex_lock lock(mutex_);
+  for (auto& item : graphs_) {
+    const Graph& graph = item.second;
+    if (graph.exec != nullptr) {
+      se::gpu::GpuDriver::DestroyGraphExec(graph.context, graph.exec);
+    }
+  }
+#endif  // GOOGLE_CUDA
+}
+
+/*static*/ bool CapturedThunkSequence::CanCapture(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+      return true;
+    case Thunk::kCopy:
+      // Host to device copies read host memory that isn't a buffer.
+      return dynamic_cast<const DeviceToDeviceCopyThunk*>(&thunk) != nullptr;
+    case Thunk::kSequential:
+      return absl::c_all_of(
+          static_cast<const SequentialThunk&>(thunk).thunks(),
+          [](const std::unique_ptr<Thunk>& thunk) {
+            return CanCapture(*thunk);
+          });
+    default:
+      return false;
+  }
+}
+
+int64_t CapturedThunkSequence::graph_count() const {
+  return absl::c_count_if(
+      segments_, [](const Segment& segment) { return segment.captured; });
+}
+
+Status CapturedThunkSequence::ExecuteOnStream(
+    const Thunk::ExecuteParams& params) {
+  for (int64_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+#if GOOGLE_CUDA
+    if (segment.captured) {
+      TF_RETURN_IF_ERROR(LaunchGraph(i, params));
+      continue;
+    }
+#endif  // GOOGLE_CUDA
+    for (Thunk* thunk : segment.thunks) {
+      TF_RETURN_IF_ERROR(ExecuteThunk(thunk, params));
+    }
+  }
+  return Status::OK();
+}
+
+#if GOOGLE_CUDA
+namespace {
+
+// Captures the work `thunks` enqueue onto `params.stream` into a graph.
+StatusOr<se::gpu::GpuGraphHandle> Capture(absl::Span<Thunk* const> thunks,
+                                          const Thunk::ExecuteParams& params,
+                                          se::gpu::GpuContext* context) {
+  se::gpu::GpuStreamHandle stream = se::gpu::AsGpuStreamValue(params.stream);
+  TF_RETURN_IF_ERROR(se::gpu::GpuDriver::BeginStreamCapture(context, stream));
+  Status status = Status::OK();
+  for (Thunk* thunk : thunks) {
+    status = thunk->ExecuteOnStream(params);
+    if (!status.ok()) {
+      break;
+    }
+  }
+  // The capture has to end even if a thunk failed, so the stream can be used
+  // again.
+  StatusOr<se::gpu::GpuGraphHandle> graph =
+      se::gpu::GpuDriver::EndStreamCapture(context, stream);
+  if (!status.ok()) {
+    if (graph.ok()) {
+      se::gpu::GpuDriver::DestroyGraph(context, graph.ValueOrDie());
+    }
+    return status;
+  }
+  return graph;
+}
+
+}  // namespace
+
+Status CapturedThunkSequence::LaunchGraph(int64_t segment_index,
+                                          const Thunk::ExecuteParams& params) {
+  const Segment& segment = segments_[segment_index];
+  se::StreamExecutor* executor = params.stream->parent();
+  se::gpu::GpuContext* context =
+      static_cast<se::gpu::GpuExecutor*>(executor->implementation())
+          ->gpu_context();
+  const BufferAllocations& buffer_allocations = *params.buffer_allocations;
+  std::vector<const void*> addresses(buffer_allocations.buffer_count());
+  for (int64_t i = 0; i < addresses.size(); ++i) {
+    addresses[i] = buffer_allocations.GetDeviceAddress(i).opaque();
+  }
+
+  tensorflow::mutex_lock lock(mutex_);
+  Graph& graph = graphs_[{executor, segment_index}];
+  if (!graph.disabled &&
+      (graph.exec == nullptr || graph.addresses != addresses)) {
+    StatusOr<se::gpu::GpuGraphHandle> captured =
+        Capture(segment.thunks, params, context);
+    if (captured.ok()) {
+      se::gpu::GpuGraphHandle new_graph = captured.ValueOrDie();
+      if (graph.exec != nullptr &&
+          !se::gpu::GpuDriver::UpdateGraphExec(context, graph.exec,
+                                               new_graph)) {
+        se::gpu::GpuDriver::DestroyGraphExec(context, graph.exec);
+        graph.exec = nullptr;
+      }
+      if (graph.exec == nullptr) {
+        StatusOr<se::gpu::GpuGraphExecHandle> exec =
+            se::gpu::GpuDriver::InstantiateGraph(context, new_graph);
+        if (exec.ok()) {
+          graph.context = context;
+          graph.exec = exec.ValueOrDie();
+        } else {
+          captured = exec.status();
+        }
+      }
+      se::gpu::GpuDriver::DestroyGraph(context, new_graph);
+    }
+    if (captured.ok()) {
+      graph.addresses = std::move(addresses);
+    } else {
+      LOG(WARNING) << "Executing " << segment.thunks.size()
+                   << " thunks without a CUDA graph: " << captured.status();
+      graph.disabled = true;
+    }
+  }
+  if (graph.disabled) {
+    for (Thunk* thunk : segment.thunks) {
+      TF_RETURN_IF_ERROR(ExecuteThunk(thunk, params));
+    }
+    return Status::OK();
+  }
+
+  ScopedAnnotation annotation([&] {
+    return absl::StrCat("CUDA graph of ", segment.thunks.size(), " thunks");
+  });
+  return se::gpu::GpuDriver::LaunchGraph(
+      context, graph.exec, se::gpu::AsGpuStreamValue(params.stream));
+}
+#endif  // GOOGLE_CUDA
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CAPTURED_THUNK_SEQUENCE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CAPTURED_THUNK_SEQUENCE_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/gpu/thunk.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/stream_executor/gpu/gpu_types.h"
+#endif  // GOOGLE_CUDA
+
+#if GOOGLE_CUDA
+namespace stream_executor {
+namespace gpu {
+class GpuContext;
+}  // namespace gpu
+}  // namespace stream_executor
+#endif  // GOOGLE_CUDA
+
+namespace xla {
+namespace gpu {
+
+// Executes a sequence of thunks on one stream, replaying the runs of thunks
+// that only enqueue kernels, memsets and device to device copies from CUDA
+// graphs. This saves the launch overhead of every kernel but one per run.
+//
+// The first execution of a run captures the work its thunks enqueue into a
+// graph and instantiates it. Later executions replay the graph as long as the
+// buffer addresses don't change. Otherwise the run is captured again and the
+// parameters of the instantiated graph are updated from the new capture,
+// which is much cheaper than instantiating it again. Other thunks, and runs
+// that are too short to benefit or fail to be captured, are executed as
+// usual. Without CUDA, all thunks are executed as usual.
+class CapturedThunkSequence {
+ public:
+  // `thunks` must outlive this object.
+  explicit CapturedThunkSequence(const ThunkSequence& thunks);
+  ~CapturedThunkSequence();
+
+  CapturedThunkSequence(const CapturedThunkSequence&) = delete;
+  CapturedThunkSequence& operator=(const CapturedThunkSequence&) = delete;
+
+  // Returns whether the work `thunk` enqueues can be captured into a graph and
+  // only depends on the buffer addresses.
+  static bool CanCapture(const Thunk& thunk);
+
+  // Executes the thunks on `params.stream`. The thunks must be initialized.
+  Status ExecuteOnStream(const Thunk::ExecuteParams& params);
+
+  // Returns the number of graphs the thunks are captured into.
+  int64_t graph_count() const;
+
+ private:
+  // Consecutive thunks that are captured into one graph, or a single thunk
+  // that is executed as usual.
+  struct Segment {
+    std::vector<Thunk*> thunks;
+    bool captured;
+  };
+
+  std::vector<Segment> segments_;
+
+#if GOOGLE_CUDA
+  struct Graph {
+    se::gpu::GpuContext* context = nullptr;
+    se::gpu::GpuGraphExecHandle exec = nullptr;
+    // The buffer addresses the graph was captured with.
+    std::vector<const void*> addresses;
+    // Set if capturing the segment failed, after which its thunks are
+    // executed as usual.
+    bool disabled = false;
+  };
+
+  Status LaunchGraph(int64_t segment_index,
+                     const Thunk::ExecuteParams& params);
+
+  tensorflow::mutex mutex_;
+  // The graphs by executor and index of the segment they are captured from.
+  absl::flat_hash_map<std::pair<se::StreamExecutor*, int64_t>, Graph> graphs_
+      TF_GUARDED_BY(mutex_);
+#endif  // GOOGLE_CUDA
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_CAPTURED_THUNK_SEQUENCE_H_
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <limits>
 
+#include "tensorflow/compiler/xla/service/gpu/autotune_results_store.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
@@ -42,16 +43,6 @@ namespace gpu {
 
 using tensorflow::AutotuneResult;
 
-using GemmCacheKey =
-    std::tuple<se::StreamExecutor*, Shape, Shape, Shape, std::string>;
-
-static tensorflow::mutex autotune_cache_mu(tensorflow::LINKER_INITIALIZED);
-static auto& autotune_cache TF_GUARDED_BY(autotune_cache_mu) =
-    *new absl::flat_hash_map<GemmCacheKey,
-                             absl::optional<se::blas::AlgorithmType>>();
-static int64_t cache_hits TF_GUARDED_BY(autotune_cache_mu) = 0;
-static int64_t cache_misses TF_GUARDED_BY(autotune_cache_mu) = 0;
-
 // Experimentally tries to pick the best algorithm for the given gemm.
 //
 // This may fail under perfectly normal circumstances.  In particular, it will
@@ -217,50 +208,43 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoUncachedGemmAutotune(
 }
 
 static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
-    const HloInstruction* instr, const GemmBackendConfig& gemm_config,
-    se::DeviceMemoryAllocator* allocator, se::Stream* stream) {
-  const HloInstruction* lhs = instr->operand(0);
-  const HloInstruction* rhs = instr->operand(1);
-
+    const HloInstruction* instr, se::DeviceMemoryAllocator* allocator,
+    se::Stream* stream) {
   // Don't run autotuning concurrently on the same GPU.
   tensorflow::mutex_lock gpu_lock = LockGpu(stream->parent());
 
-  GemmCacheKey key =
-      std::make_tuple(stream->parent(), lhs->shape(), rhs->shape(),
-                      instr->shape(), gemm_config.SerializeAsString());
-
-  tensorflow::mutex_lock cache_lock(autotune_cache_mu);
-  auto it = autotune_cache.find(key);
-  int64_t autotuning_requests = cache_hits + cache_misses;
-  if (autotuning_requests && autotuning_requests % 10 == 0) {
-    VLOG(2) << "Autotuning cache hits/(hits + misses): " << cache_hits << "/"
-            << autotuning_requests;
-  }
-
-  if (it != autotune_cache.end()) {
-    cache_hits++;
+  // The key covers the operand and result shapes as well as the backend
+  // config. A stored result without an algorithm means that no algorithm
+  // could be picked and the generic API is used.
+  AutotuneResultsStore& store = AutotuneResultsStore::Global();
+  const std::string device = AutotuneResultsStore::DeviceKey(stream->parent());
+  const std::string hlo = AutotuneResultsStore::HloKey(*instr);
+  if (absl::optional<AutotuneResult> cached =
+          store.Lookup(AutotuneResultsStore::Kind::kGemm, device, hlo)) {
     VLOG(4) << "Autotuning cache hit, using algorithm: "
-            << (it->second.has_value() ? absl::StrCat(*(it->second))
-                                       : "<generic>");
-    return it->second;
+            << (cached->has_gemm() ? absl::StrCat(cached->gemm().algorithm())
+                                   : "<generic>");
+    if (!cached->has_gemm()) {
+      return {absl::nullopt};
+    }
+    return {cached->gemm().algorithm()};
   }
-  cache_misses++;
-  VLOG(4) << "Autotuning cache miss";
 
   // Make sure any previous activity on this executor is done. We don't want
   // other work still running on the GPU to interfere with autotuning.
   if (!stream->parent()->SynchronizeAllActivity()) {
-    auto options = HloPrintOptions::Canonical();
-    options.set_print_backend_config(true);
     return InternalError(
-        "Failed to synchronize GPU for autotuning gemm instruction: %s",
-        instr->ToString(options));
+        "Failed to synchronize GPU for autotuning gemm instruction: %s", hlo);
   }
 
   TF_ASSIGN_OR_RETURN(absl::optional<se::blas::AlgorithmType> result,
                       DoUncachedGemmAutotune(instr, stream, allocator));
 
-  CHECK(autotune_cache.emplace(key, result).second);
+  AutotuneResult stored;
+  if (result) {
+    stored.mutable_gemm()->set_algorithm(*result);
+  }
+  CHECK(store.Insert(AutotuneResultsStore::Kind::kGemm, device, hlo, stored));
   return result;
 }
 
@@ -277,7 +261,7 @@ static StatusOr<bool> RunOnInstruction(HloInstruction* instr,
       instr->backend_config<GemmBackendConfig>().ValueOrDie();
 
   TF_ASSIGN_OR_RETURN(absl::optional<se::blas::AlgorithmType> gemm_algorithm,
-                      DoGemmAutotune(instr, gemm_config, allocator, stream));
+                      DoGemmAutotune(instr, allocator, stream));
 
   // We update instruction->backend_config(); if no algorithms are supported,
   // a different API is used, which does not require specifying an algorithm.
@@ -311,12 +295,16 @@ StatusOr<bool> GemmAlgorithmPicker::Run(HloModule* module) {
     return false;
   }
 
+  AutotuneResultsStore& store = AutotuneResultsStore::Global();
+  TF_RETURN_IF_ERROR(store.MaybeLoad(module->config().debug_options()));
+
   bool changed = false;
   for (HloComputation* computation : module->MakeNonfusionComputations()) {
     TF_ASSIGN_OR_RETURN(
         bool result, RunOnComputation(computation, stream_exec_, allocator_));
     changed |= result;
   }
+  TF_RETURN_IF_ERROR(store.MaybeExport(module->config().debug_options()));
   return changed;
 }
 
@@ -90,6 +90,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_spmd_partitioner.h"
 #include "tensorflow/compiler/xla/service/gpu/horizontal_input_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/horizontal_loop_fusion.h"
+#include "tensorflow/compiler/xla/service/gpu/host_offload_prefetcher.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
@@ -138,9 +139,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/slice_sinker.h"
 #include "tensorflow/compiler/xla/service/slow_operation_alarm.h"
 #include "tensorflow/compiler/xla/service/sort_simplifier.h"
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
 #include "tensorflow/compiler/xla/service/stable_sort_expander.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/service/tuple_simplifier.h"
+#include "tensorflow/compiler/xla/service/while_loop_all_reduce_pipeliner.h"
 #include "tensorflow/compiler/xla/service/while_loop_constant_sinking.h"
 #include "tensorflow/compiler/xla/service/while_loop_simplifier.h"
 #include "tensorflow/compiler/xla/service/while_loop_trip_count_annotator.h"
@@ -293,6 +296,13 @@ Status GpuCompiler::OptimizeHloModule(
       spmd_simplify.AddPass<ConditionalSimplifier>();
       spmd_simplify.AddPass<HloDCE>();
 
+      if (hlo_module->config()
+              .debug_options()
+              .xla_gpu_enable_auto_sharding()) {
+        spmd::AutoShardingOptions auto_sharding_options;
+        auto_sharding_options.num_devices = num_partitions;
+        spmd_pipeline.AddPass<spmd::AutoSharding>(auto_sharding_options);
+      }
       spmd_pipeline.AddPass<ShardingPropagation>(/*is_spmd=*/true);
       spmd_pipeline.AddPass<GpuSpmdPartitioner>(
           num_partitions, hlo_module->config().replica_count());
@@ -544,6 +554,10 @@ Status GpuCompiler::OptimizeHloModule(
         /*combine_threshold_in_bytes=*/30 * 1024 * 1024,
         /*combine_threshold_count=*/256);
 
+    if (debug_options.xla_gpu_enable_while_loop_all_reduce_pipelining()) {
+      pipeline.AddPass<WhileLoopAllReducePipeliner>();
+    }
+
     if (debug_options.xla_gpu_enable_async_all_reduce()) {
       pipeline.AddPass<AsyncCollectiveCreator>(
           AsyncCollectiveCreator::CollectiveCreatorConfig{
@@ -592,6 +606,20 @@ Status GpuCompiler::PrepareHloModuleForIrEmitting(HloModule* hlo_module) {
   }
   pipeline.AddPass<LoopScheduleLinearizer>(GetCanShareBuffer());
   pipeline.AddPass<GpuCopyInsertion>(GetCanShareBuffer());
+
+  const DebugOptions& debug_options = hlo_module->config().debug_options();
+  if (!debug_options.xla_gpu_host_offloaded_parameters().empty() &&
+      debug_options.xla_gpu_host_offload_prefetch_bytes() > 0) {
+    HostOffloadPrefetcher::Options options;
+    options.parameter_numbers.assign(
+        debug_options.xla_gpu_host_offloaded_parameters().begin(),
+        debug_options.xla_gpu_host_offloaded_parameters().end());
+    options.max_prefetch_bytes =
+        debug_options.xla_gpu_host_offload_prefetch_bytes();
+    options.alignment_in_bytes = kXlaAllocatedBufferAlignBytes;
+    options.shape_size = ShapeSizeBytesFunction();
+    pipeline.AddPass<HostOffloadPrefetcher>(std::move(options));
+  }
   pipeline.AddPass<GpuSanitizeConstantNames>();
   return pipeline.Run(hlo_module).status();
 }
@@ -1174,6 +1202,8 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
   }
 
   GpuVersion gpu_version = GetGpuVersion(stream_exec);
+  const bool enable_cuda_graphs =
+      module->config().debug_options().xla_gpu_enable_cuda_graphs();
   auto* gpu_executable = new GpuExecutable(
       {std::move(backend_result.first), std::move(backend_result.second),
        gpu_version, std::move(compile_module_results.thunks_or_bef),
@@ -1184,7 +1214,7 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
        std::move(buffer_assignment_proto),
        compile_module_results.buffer_assignment->ToVerboseString(),
        std::move(module), profile_index, std::move(profile_printer),
-       std::move(profile_index_map)});
+       std::move(profile_index_map), enable_cuda_graphs});
   if (embed_ir_in_executable) {
     DCHECK_NE("", ir_module_string_before_opt);
     gpu_executable->set_ir_module_string(ir_module_string_before_opt);
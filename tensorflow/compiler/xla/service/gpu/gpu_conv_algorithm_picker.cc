@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_results_store.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_asm_opts_util.h"
@@ -224,32 +225,6 @@ StatusOr<bool> CheckRedzones(const se::RedzoneAllocator& allocator,
 }
 #endif
 
-using ConvCacheKey =
-    std::tuple<se::StreamExecutor*,
-               /* conv->ToString(HloPrintOptions::Canonical()) */ std::string>;
-
-struct ConvCacheStats {
-  int64_t cache_hits = 0;
-  int64_t cache_misses = 0;
-
-  void LogStats() {
-    VLOG(2) << "Cache hits: " << cache_hits;
-    VLOG(2) << "Cache misses: " << cache_misses;
-  }
-};
-
-ConvCacheKey AutotuneCacheKeyfromInstruction(
-    const HloCustomCallInstruction* conv, se::StreamExecutor* se) {
-  auto options = HloPrintOptions::Canonical();
-  options.set_print_backend_config(true);
-  return std::make_tuple(se, conv->ToString(options));
-}
-
-tensorflow::mutex autotune_cache_lock(tensorflow::LINKER_INITIALIZED);
-auto& autotune_cache TF_GUARDED_BY(autotune_cache_lock) =
-    *new absl::flat_hash_map<ConvCacheKey, AutotuneResult>();
-auto& autotune_cache_stats TF_GUARDED_BY(autotune_cache_lock) =
-    *new ConvCacheStats();
 }  // anonymous namespace
 
 StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
@@ -268,24 +243,20 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   // We cache the autotuning results to avoid doing the duplicate work,
   // which can greatly improve both stability (deterministic numeric results
   // within a process for a given input) and performance (2x speedup on some
-  // models).
-  ConvCacheKey key = AutotuneCacheKeyfromInstruction(instr, stream_exec_);
-  {
-    tensorflow::mutex_lock lock(autotune_cache_lock);
-    auto it = autotune_cache.find(key);
-    if (it != autotune_cache.end()) {
-      autotune_cache_stats.cache_hits++;
-      return it->second;
-    }
-    autotune_cache_stats.cache_misses++;
+  // models). Results loaded from a previous run are hits as well.
+  AutotuneResultsStore& store = AutotuneResultsStore::Global();
+  const std::string device = AutotuneResultsStore::DeviceKey(stream_exec_);
+  const std::string hlo = AutotuneResultsStore::HloKey(*instr);
+  if (absl::optional<AutotuneResult> cached =
+          store.Lookup(AutotuneResultsStore::Kind::kConv, device, hlo)) {
+    return *std::move(cached);
   }
 
   // Make sure any previous activity on this executor is done. We don't want
   // other work still running on the GPU to interfere with autotuning.
   if (!stream_exec_->SynchronizeAllActivity()) {
     return InternalError(
-        "Failed to synchronize GPU for autotuning conv instruction: %s",
-        std::get<1>(key) /* instr */);
+        "Failed to synchronize GPU for autotuning conv instruction: %s", hlo);
   }
 
   // allocator either points to this->allocator_ or, if that's null, to a
@@ -314,8 +285,8 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   }
 
   if (result_or.ok()) {
-    tensorflow::mutex_lock lock(autotune_cache_lock);
-    CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
+    CHECK(store.Insert(AutotuneResultsStore::Kind::kConv, device, hlo,
+                       result_or.ValueOrDie()));
   }
   return result_or;
 }
@@ -385,8 +356,7 @@ GpuConvAlgorithmPicker::PickBestAlgorithmNoCacheCuda(
   const bool crash_on_checking_failure =
       debug_options.xla_gpu_crash_on_verification_failures();
 
-  std::string canonical_hlo =
-      std::get<1>(AutotuneCacheKeyfromInstruction(instr, stream_exec_));
+  std::string canonical_hlo = AutotuneResultsStore::HloKey(*instr);
 
   string blas_version;
   if (auto* blas = stream_exec_->AsBlas()) {
@@ -784,17 +754,16 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(HloModule* module) {
     return false;
   }
 
+  AutotuneResultsStore& store = AutotuneResultsStore::Global();
+  TF_RETURN_IF_ERROR(store.MaybeLoad(module->config().debug_options()));
+
   bool changed = false;
   for (HloComputation* computation : module->MakeNonfusionComputations()) {
     TF_ASSIGN_OR_RETURN(bool result, RunOnComputation(computation));
     changed |= result;
   }
 
-  {
-    tensorflow::mutex_lock lock(autotune_cache_lock);
-    autotune_cache_stats.LogStats();
-  }
-
+  TF_RETURN_IF_ERROR(store.MaybeExport(module->config().debug_options()));
   return changed;
 }
 
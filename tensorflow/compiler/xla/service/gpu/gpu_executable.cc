@@ -109,6 +109,20 @@ GpuExecutable::GpuExecutable(GpuExecutable::Params params)
       output_info_(std::move(params.output_info)) {
   XlaDebugInfoManager::Get()->RegisterModule(module_name_, shared_module(),
                                              debug_buffer_assignment_);
+  // Graphs are captured from a single stream.
+  if (params.enable_cuda_graphs &&
+      absl::holds_alternative<OwnedThunkSchedule>(thunks_or_bef_)) {
+    const ThunkSchedule& thunk_schedule =
+        *absl::get<OwnedThunkSchedule>(thunks_or_bef_);
+    if (thunk_schedule.StreamCount() == 1) {
+      captured_thunks_ =
+          absl::make_unique<CapturedThunkSequence>(thunk_schedule.TotalOrder());
+    } else {
+      VLOG(1) << "Not using CUDA graphs for " << module_name_
+              << " because it uses " << thunk_schedule.StreamCount()
+              << " streams.";
+    }
+  }
 }
 
 GpuExecutable::~GpuExecutable() {
@@ -192,32 +206,11 @@ Status GpuExecutable::ExecuteThunks(
       [&] { return absl::StrCat(module_name_, ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  absl::flat_hash_map<const Thunk*, std::unique_ptr<se::Event>>
-      thunk_to_finish_event;
+  const GpuExecutableRunOptions* gpu_options =
+      run_options->run_options().gpu_executable_run_options();
   std::vector<std::function<void()>> deferred_host_callbacks;
-  for (const std::unique_ptr<Thunk>& thunk : thunk_schedule.TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
-
-    int32_t stream_no = thunk_schedule.StreamNumberForThunk(thunk.get());
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
-
-    for (const Thunk* dependency : thunk_schedule.DependsOn(thunk.get())) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
-
-    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
-            << " on stream " << stream_no;
-
-    TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(*thunk))
-        << "`run_options` must have a stream borrower for async thunks.";
-
-    const GpuExecutableRunOptions* gpu_options =
-        run_options->run_options().gpu_executable_run_options();
-    Thunk::ExecuteParams thunk_params{
+  auto execute_params = [&](se::Stream* stream) {
+    return Thunk::ExecuteParams{
         &buffer_allocations,
         stream,
         async_comms_stream.ok() ? async_comms_stream->get() : nullptr,
@@ -230,12 +223,47 @@ Status GpuExecutable::ExecuteThunks(
         gpu_options && gpu_options->nccl_unique_id_callback()
             ? &gpu_options->nccl_unique_id_callback()
             : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule.Depended(thunk.get())) {
-      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk.get()] = std::move(finish_event);
+  };
+
+  if (captured_thunks_ != nullptr) {
+    for (const std::unique_ptr<Thunk>& thunk : thunk_schedule.TotalOrder()) {
+      TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(*thunk))
+          << "`run_options` must have a stream borrower for async thunks.";
+    }
+    TF_RETURN_IF_ERROR(
+        captured_thunks_->ExecuteOnStream(execute_params(main_stream)));
+  } else {
+    absl::flat_hash_map<const Thunk*, std::unique_ptr<se::Event>>
+        thunk_to_finish_event;
+    for (const std::unique_ptr<Thunk>& thunk : thunk_schedule.TotalOrder()) {
+      // Annotate execution of this op if tracing was enabled when we started
+      // running this module.  If tracing is enabled *while* we're running the
+      // module, we won't get any data, but that's probably an OK trade-off.
+      ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
+
+      int32_t stream_no = thunk_schedule.StreamNumberForThunk(thunk.get());
+      se::Stream* stream =
+          (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+
+      for (const Thunk* dependency : thunk_schedule.DependsOn(thunk.get())) {
+        stream->ThenWaitFor(
+            FindOrDie(thunk_to_finish_event, dependency).get());
+      }
+
+      VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
+              << " on stream " << stream_no;
+
+      TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(*thunk))
+          << "`run_options` must have a stream borrower for async thunks.";
+
+      TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(execute_params(stream)));
+      if (thunk_schedule.Depended(thunk.get())) {
+        auto finish_event =
+            absl::make_unique<se::Event>(main_stream->parent());
+        finish_event->Init();
+        stream->ThenRecordEvent(finish_event.get());
+        thunk_to_finish_event[thunk.get()] = std::move(finish_event);
+      }
     }
   }
 
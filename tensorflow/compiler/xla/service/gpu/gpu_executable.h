@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/captured_thunk_sequence.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
@@ -95,6 +96,9 @@ class GpuExecutable : public Executable {
     size_t entry_computation_profile_index = 0;
     std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data = nullptr;
     std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map = nullptr;
+    // Whether to replay the thunks from CUDA graphs where possible, see
+    // CapturedThunkSequence.
+    bool enable_cuda_graphs = false;
   };
 
   // We need to share ownership of hlo_module and assignment with profiler to
@@ -208,6 +212,10 @@ class GpuExecutable : public Executable {
   // IrEmitter.
   absl::variant<OwnedThunkSchedule, OwnedBefBuffer> thunks_or_bef_;
 
+  // Executes the thunks instead of ExecuteThunks if the thunks are replayed
+  // from CUDA graphs.
+  std::unique_ptr<CapturedThunkSequence> captured_thunks_;
+
   std::string module_name_;
 
   xla::Shape output_shape_;
@@ -15,12 +15,18 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_map>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
+#include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
@@ -185,10 +191,33 @@ void BFSLaunchOrder(const HloComputation* computation,
   }
 }
 
-bool ShouldScheduleAsEarlyAsPossible(const HloInstruction& instr) {
+bool IsAsyncCollectiveStart(const HloInstruction& instr) {
   switch (instr.opcode()) {
+    case HloOpcode::kAllGatherStart:
     case HloOpcode::kAllReduceStart:
+    case HloOpcode::kCollectivePermuteStart:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsAsyncCollectiveDone(const HloInstruction& instr) {
+  switch (instr.opcode()) {
+    case HloOpcode::kAllGatherDone:
+    case HloOpcode::kAllReduceDone:
+    case HloOpcode::kCollectivePermuteDone:
       return true;
+    default:
+      return false;
+  }
+}
+
+bool ShouldScheduleAsEarlyAsPossible(const HloInstruction& instr) {
+  if (IsAsyncCollectiveStart(instr)) {
+    return true;
+  }
+  switch (instr.opcode()) {
     case HloOpcode::kCustomCall:
       return static_cast<const HloCustomCallInstruction&>(instr)
                  .custom_call_schedule() ==
@@ -207,9 +236,10 @@ bool ShouldScheduleSuccessor(
 }
 
 bool ShouldScheduleAsLateAsPossible(const HloInstruction& instr) {
+  if (IsAsyncCollectiveDone(instr)) {
+    return true;
+  }
   switch (instr.opcode()) {
-    case HloOpcode::kAllReduceDone:
-      return true;
     case HloOpcode::kCustomCall:
       return static_cast<const HloCustomCallInstruction&>(instr)
                  .custom_call_schedule() == CustomCallSchedule::SCHEDULE_LATEST;
@@ -306,6 +336,187 @@ HloInstructionSequence PostprocessorToScheduleAsEarlyOrLateAsPossible(
   return result;
 }
 
+// Rough device characteristics the latency hiding scheduler estimates
+// durations with. Only the ratio between compute and communication time
+// matters, so they need not match a particular GPU.
+constexpr double kFlopsPerSecond = 1e13;
+constexpr double kMemoryBytesPerSecond = 1e12;
+constexpr double kInterconnectBytesPerSecond = 5e10;
+// Cost of a collective that does not depend on its size.
+constexpr double kCollectiveLatencySeconds = 1e-5;
+
+int64_t BufferBytes(const Shape& shape) {
+  int64_t bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+// Estimates how long instructions keep the GPU busy and how long async
+// collectives take to complete.
+class LatencyEstimator {
+ public:
+  explicit LatencyEstimator(const HloCostAnalysis* cost_analysis)
+      : cost_analysis_(cost_analysis) {}
+
+  double ComputeSeconds(const HloInstruction& instr) const {
+    if (IsAsyncCollectiveStart(instr) || IsAsyncCollectiveDone(instr)) {
+      return 0;
+    }
+    int64_t flops = cost_analysis_->flop_count(instr);
+    int64_t bytes = cost_analysis_->bytes_accessed(instr);
+    // HloCostAnalysis knows nothing about the library calls GEMMs and
+    // convolutions are lowered to.
+    if (instr.opcode() == HloOpcode::kCustomCall) {
+      flops = IsCublasGemm(instr) ? GemmFlops(instr) : 0;
+      bytes = BufferBytes(instr.shape());
+      for (const HloInstruction* operand : instr.operands()) {
+        bytes += BufferBytes(operand->shape());
+      }
+    }
+    return std::max(std::max<int64_t>(flops, 0) / kFlopsPerSecond,
+                    std::max<int64_t>(bytes, 0) / kMemoryBytesPerSecond);
+  }
+
+  double CollectiveSeconds(const HloInstruction& start) const {
+    int64_t bytes = 0;
+    for (const HloInstruction* operand : start.operands()) {
+      bytes += BufferBytes(operand->shape());
+    }
+    switch (start.opcode()) {
+      case HloOpcode::kAllReduceStart:
+        // A ring all-reduce sends every byte twice, once to reduce and once to
+        // broadcast the result.
+        bytes *= 2;
+        break;
+      case HloOpcode::kAllGatherStart:
+        // The gathered result is received.
+        bytes = BufferBytes(start.shape()) - bytes;
+        break;
+      default:
+        break;
+    }
+    return kCollectiveLatencySeconds + bytes / kInterconnectBytesPerSecond;
+  }
+
+ private:
+  static int64_t GemmFlops(const HloInstruction& gemm) {
+    auto config_or = gemm.backend_config<GemmBackendConfig>();
+    if (!config_or.ok()) {
+      return 0;
+    }
+    const Shape& lhs_shape = gemm.operand(0)->shape();
+    const DotDimensionNumbers& dnums =
+        config_or.ValueOrDie().dot_dimension_numbers();
+    int64_t contracted = 1;
+    for (int64_t dim : dnums.lhs_contracting_dimensions()) {
+      contracted *= lhs_shape.dimensions(dim);
+    }
+    const Shape& output_shape =
+        gemm.shape().IsTuple() ? gemm.shape().tuple_shapes(0) : gemm.shape();
+    return 2 * ShapeUtil::ElementsIn(output_shape) * contracted;
+  }
+
+  const HloCostAnalysis* cost_analysis_;
+};
+
+// Places the done ops of async collectives so that the compute scheduled
+// between each start and its done covers the estimated duration of the
+// collective. Waiting longer than that only keeps the collective's buffers
+// alive, and waiting less stalls the GPU. `input` is expected to schedule the
+// starts as early as possible. A done op is still scheduled before its first
+// user, and before a start that would push the bytes of the collectives in
+// flight over `memory_limit`.
+HloInstructionSequence ScheduleAsyncDonesForLatencyHiding(
+    const HloInstructionSequence& input, const LatencyEstimator& estimator,
+    int64_t memory_limit) {
+  struct InFlightCollective {
+    HloInstruction* done;
+    // The compute time at which the collective is estimated to be complete.
+    double finish_seconds;
+    int64_t bytes;
+  };
+  // In the order the collectives were started.
+  std::vector<InFlightCollective> in_flight;
+  int64_t in_flight_bytes = 0;
+  // The estimated compute time of everything scheduled so far.
+  double seconds = 0;
+
+  // Done ops without control predecessors only depend on their start, so they
+  // can be scheduled anywhere after it.
+  auto movable_done = [](const HloInstruction* start) -> HloInstruction* {
+    if (start->user_count() != 1 ||
+        !IsAsyncCollectiveDone(*start->users()[0]) ||
+        !start->users()[0]->control_predecessors().empty()) {
+      return nullptr;
+    }
+    return start->users()[0];
+  };
+  absl::flat_hash_set<const HloInstruction*> moved_dones;
+  for (HloInstruction* instr : input.instructions()) {
+    if (IsAsyncCollectiveStart(*instr)) {
+      if (HloInstruction* done = movable_done(instr)) {
+        moved_dones.insert(done);
+      }
+    }
+  }
+
+  HloInstructionSequence result;
+  auto schedule_done = [&](int64_t index) {
+    result.push_back(in_flight[index].done);
+    in_flight_bytes -= in_flight[index].bytes;
+    in_flight.erase(in_flight.begin() + index);
+  };
+  auto depends_on = [](const HloInstruction* instr,
+                       const HloInstruction* done) {
+    return absl::c_linear_search(instr->operands(), done) ||
+           absl::c_linear_search(instr->control_predecessors(), done);
+  };
+
+  for (HloInstruction* instr : input.instructions()) {
+    if (moved_dones.contains(instr)) {
+      continue;
+    }
+    for (int64_t i = 0; i < in_flight.size();) {
+      if (depends_on(instr, in_flight[i].done)) {
+        schedule_done(i);
+      } else {
+        ++i;
+      }
+    }
+    if (IsAsyncCollectiveStart(*instr) && movable_done(instr) != nullptr) {
+      const int64_t bytes = BufferBytes(instr->shape());
+      while (memory_limit > 0 && !in_flight.empty() &&
+             in_flight_bytes + bytes > memory_limit) {
+        schedule_done(0);
+      }
+      result.push_back(instr);
+      in_flight.push_back({movable_done(instr),
+                           seconds + estimator.CollectiveSeconds(*instr),
+                           bytes});
+      in_flight_bytes += bytes;
+      continue;
+    }
+    result.push_back(instr);
+    seconds += estimator.ComputeSeconds(*instr);
+    for (int64_t i = 0; i < in_flight.size();) {
+      if (in_flight[i].finish_seconds <= seconds) {
+        schedule_done(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+  while (!in_flight.empty()) {
+    schedule_done(0);
+  }
+  return result;
+}
+
 }  // end namespace
 
 GpuHloSchedule::GpuHloSchedule() {}
@@ -321,6 +532,27 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
   if (stream_assignment.StreamCount() == 1) {
     // All kernels are launched on a single stream, so there's no loss of
     // concurrency by optimizing for minimal memory usage.
+    MemorySchedulerPostprocessor postprocessor =
+        PostprocessorToScheduleAsEarlyOrLateAsPossible;
+    const DebugOptions& debug_options = module->config().debug_options();
+    HloCostAnalysis cost_analysis([pointer_size](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, pointer_size);
+    });
+    LatencyEstimator estimator(&cost_analysis);
+    if (debug_options.xla_gpu_enable_latency_hiding_scheduler()) {
+      for (const HloComputation* computation :
+           module->MakeNonfusionComputations()) {
+        TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+      }
+      const int64_t memory_limit =
+          debug_options.xla_gpu_latency_hiding_scheduler_memory_limit();
+      postprocessor = [&estimator,
+                       memory_limit](const HloInstructionSequence& input) {
+        return ScheduleAsyncDonesForLatencyHiding(
+            PostprocessorToScheduleAsEarlyOrLateAsPossible(input), estimator,
+            memory_limit);
+      };
+    }
     TF_ASSIGN_OR_RETURN(
         HloSchedule sequences,
         ScheduleModule(
@@ -328,9 +560,8 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
             [pointer_size](const BufferValue& buffer) {
               return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
             },
-            ComputationSchedulerToModuleScheduler(
-                DefaultMemoryScheduler,
-                PostprocessorToScheduleAsEarlyOrLateAsPossible)));
+            ComputationSchedulerToModuleScheduler(DefaultMemoryScheduler,
+                                                  postprocessor)));
     schedule->thunk_launch_order_ =
         sequences.sequence(entry_computation).instructions();
     schedule->hlo_ordering_ =
@@ -482,5 +482,88 @@ TEST_F(GpuHloScheduleTest, AsyncAllReduce) {
   EXPECT_TRUE(order->ExecutesBefore(all_reduce_done, add4));
 }
 
+TEST_F(GpuHloScheduleTest, LatencyHidingSchedulesDoneOnceCollectiveIsHidden) {
+  const char* hlo_text = R"(
+  HloModule test
+
+  add {
+    x = f32[] parameter(0)
+    y = f32[] parameter(1)
+    ROOT add = f32[] add(x, y)
+  }
+
+  ENTRY entry {
+    x = f32[2,2] parameter(0)
+    a = f32[1024,1024] parameter(1)
+    b = f32[1024,1024] parameter(2)
+    start = (f32[2,2], f32[2,2]) all-reduce-start(x), to_apply=add
+    big0 = f32[1024,1024] add(a, b)
+    big1 = f32[1024,1024] multiply(big0, b)
+    done = f32[2,2] all-reduce-done(start)
+    ROOT tuple = (f32[2,2], f32[1024,1024]) tuple(done, big1)
+  })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+  module->config().set_debug_options(debug_options);
+
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  std::unique_ptr<HloOrdering> order =
+      BuildGpuHloSchedule(module.get(), *streams)->ConsumeHloOrdering();
+  auto get = [&](absl::string_view name) {
+    return FindInstruction(module.get(), name);
+  };
+
+  // The tiny all-reduce is hidden behind the first large add, so its buffers
+  // are released before the second one runs.
+  EXPECT_TRUE(order->ExecutesBefore(get("start"), get("big0")));
+  EXPECT_TRUE(order->ExecutesBefore(get("big0"), get("done")));
+  EXPECT_TRUE(order->ExecutesBefore(get("done"), get("big1")));
+}
+
+TEST_F(GpuHloScheduleTest, LatencyHidingRespectsMemoryLimit) {
+  const char* hlo_text = R"(
+  HloModule test
+
+  add {
+    x = f32[] parameter(0)
+    y = f32[] parameter(1)
+    ROOT add = f32[] add(x, y)
+  }
+
+  ENTRY entry {
+    x = f32[2,2] parameter(0)
+    y = f32[2,2] parameter(1)
+    start0 = (f32[2,2], f32[2,2]) all-reduce-start(x), to_apply=add
+    start1 = (f32[2,2], f32[2,2]) all-reduce-start(y), to_apply=add
+    done0 = f32[2,2] all-reduce-done(start0)
+    done1 = f32[2,2] all-reduce-done(start1)
+    ROOT sum = f32[2,2] add(done0, done1)
+  })";
+  for (int64_t memory_limit : {0, 48}) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module,
+                            ParseAndReturnVerifiedModule(hlo_text));
+    DebugOptions debug_options = module->config().debug_options();
+    debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+    debug_options.set_xla_gpu_latency_hiding_scheduler_memory_limit(
+        memory_limit);
+    module->config().set_debug_options(debug_options);
+
+    std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+    std::unique_ptr<HloOrdering> order =
+        BuildGpuHloSchedule(module.get(), *streams)->ConsumeHloOrdering();
+    const HloInstruction* start1 = FindInstruction(module.get(), "start1");
+    const HloInstruction* done0 = FindInstruction(module.get(), "done0");
+
+    // Each all-reduce keeps 32 bytes in flight, so a limit of 48 bytes only
+    // allows one at a time.
+    if (memory_limit == 0) {
+      EXPECT_TRUE(order->ExecutesBefore(start1, done0));
+    } else {
+      EXPECT_TRUE(order->ExecutesBefore(done0, start1));
+    }
+  }
+}
+
 }  // namespace gpu
 }  // namespace xla
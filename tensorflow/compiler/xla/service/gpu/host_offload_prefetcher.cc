@@ -0,0 +1,204 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/host_offload_prefetcher.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_live_range.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/memory_space_assignment.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+namespace msa = memory_space_assignment;
+
+// The memory space that memory space assignment places prefetched parameters
+// in. Everything else, which is in device memory as well, stays in the default
+// memory space.
+constexpr int64_t kPrefetchMemorySpace = 1;
+
+// Replaces the copy-start/copy-done pairs memory space assignment inserted.
+// Pairs that copy an offloaded parameter become a copy that is ordered after
+// the instruction scheduled right before the copy-start. Other pairs, such as
+// evictions, only move data within device memory and are removed.
+StatusOr<bool> ReplaceAsyncCopies(
+    HloModule* module,
+    const absl::flat_hash_set<const HloInstruction*>& offloaded_parameters) {
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    if (!module->schedule().is_computation_scheduled(computation)) {
+      continue;
+    }
+    const std::vector<HloInstruction*> sequence =
+        module->schedule().sequence(computation).instructions();
+    absl::flat_hash_map<const HloInstruction*, HloInstruction*>
+        scheduled_after;
+    HloInstruction* previous = nullptr;
+    for (HloInstruction* instruction : sequence) {
+      if (instruction->opcode() == HloOpcode::kCopyStart) {
+        if (previous != nullptr) {
+          scheduled_after[instruction] = previous;
+        }
+        continue;
+      }
+      if (instruction->opcode() != HloOpcode::kCopyDone) {
+        previous = instruction;
+        continue;
+      }
+      HloInstruction* copy_start = instruction->mutable_operand(0);
+      HloInstruction* source = copy_start->mutable_operand(0);
+      HloInstruction* replacement = source;
+      if (offloaded_parameters.contains(source)) {
+        replacement = computation->AddInstruction(HloInstruction::CreateUnary(
+            source->shape(), HloOpcode::kCopy, source));
+        auto it = scheduled_after.find(copy_start);
+        if (it != scheduled_after.end()) {
+          TF_RETURN_IF_ERROR(it->second->AddControlDependencyTo(replacement));
+        }
+        VLOG(2) << "Prefetching " << source->name() << " after "
+                << (it != scheduled_after.end() ? it->second->name()
+                                                : "the start");
+        changed = true;
+      }
+      TF_RETURN_IF_ERROR(instruction->ReplaceAllUsesWith(replacement));
+      TF_RETURN_IF_ERROR(computation->RemoveInstruction(instruction));
+      TF_RETURN_IF_ERROR(computation->RemoveInstruction(copy_start));
+    }
+  }
+  return changed;
+}
+
+void ResetMemorySpaces(HloModule* module) {
+  for (HloComputation* computation : module->computations()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      ShapeUtil::ForEachMutableSubshape(
+          instruction->mutable_shape(),
+          [](Shape* subshape, const ShapeIndex& /*index*/) {
+            if (subshape->has_layout()) {
+              subshape->mutable_layout()->set_memory_space(0);
+            }
+          });
+    }
+  }
+}
+
+}  // namespace
+
+StatusOr<bool> HostOffloadPrefetcher::Run(HloModule* module) {
+  if (options_.parameter_numbers.empty() || options_.max_prefetch_bytes <= 0) {
+    return false;
+  }
+  HloComputation* entry = module->entry_computation();
+  absl::flat_hash_set<const HloInstruction*> offloaded_parameters;
+  for (int64_t parameter_number : options_.parameter_numbers) {
+    if (parameter_number < 0 || parameter_number >= entry->num_parameters()) {
+      return InvalidArgument(
+          "Host offloaded parameter %d is out of range; the entry computation "
+          "has %d parameters.",
+          parameter_number, entry->num_parameters());
+    }
+    const HloInstruction* parameter =
+        entry->parameter_instruction(parameter_number);
+    if (!parameter->shape().IsArray()) {
+      VLOG(1) << "Not prefetching " << parameter->name()
+              << " because it is not an array.";
+      continue;
+    }
+    offloaded_parameters.insert(parameter);
+  }
+  if (offloaded_parameters.empty()) {
+    return false;
+  }
+
+  auto size_fn = [this](const BufferValue& buffer) {
+    return options_.shape_size(buffer.shape());
+  };
+  TF_ASSIGN_OR_RETURN(HloSchedule schedule, ScheduleModule(module, size_fn));
+  TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
+
+  // Memory space assignment sees the default memory as slow and the alternate
+  // memory as fast, which here is only true for the offloaded parameters.
+  HloCostAnalysis hlo_cost_analysis(options_.shape_size);
+  hlo_cost_analysis.set_flops_per_second(options_.flops_per_second);
+  hlo_cost_analysis.set_transcendentals_per_second(options_.flops_per_second);
+  hlo_cost_analysis.set_bytes_per_second(
+      options_.host_to_device_bytes_per_second);
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    TF_RETURN_IF_ERROR(computation->Accept(&hlo_cost_analysis));
+  }
+
+  msa::Options options;
+  options.alternate_memory_space = kPrefetchMemorySpace;
+  options.max_size_in_bytes = options_.max_prefetch_bytes;
+  options.alignment_in_bytes = options_.alignment_in_bytes;
+  options.size_fn = size_fn;
+  options.async_copy_bandwidth_bytes_per_second =
+      options_.host_to_device_bytes_per_second;
+  options.alternate_mem_bandwidth_bytes_per_second =
+      options_.device_bytes_per_second;
+  // Only the uses of offloaded parameters are worth prefetching for.
+  options.is_use_allowed_in_alternate_mem_fn = [&](const HloUse& use) {
+    return offloaded_parameters.contains(
+        use.instruction->operand(use.operand_number));
+  };
+  options.enable_cross_program_prefetch = false;
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<msa::MemorySpaceAssignmentCostAnalysis>
+                          cost_analysis,
+                      msa::MemorySpaceAssignmentCostAnalysis::Create(
+                          hlo_cost_analysis, options, *module));
+  msa::CostAnalysisPrefetchIntervalPicker prefetch_interval_picker(
+      *cost_analysis, /*min_async_copy_to_overlap_ratio=*/0.8,
+      /*max_async_copy_to_overlap_ratio=*/10.0,
+      /*preferred_async_copy_to_overlap_ratio=*/1.5,
+      /*buffer_size_for_max_async_copy=*/options_.max_prefetch_bytes);
+  options.prefetch_interval_picker = &prefetch_interval_picker;
+  options.cost_analysis = cost_analysis.get();
+  options.buffer_interval_compare =
+      msa::MemorySpaceAssignment::GetMemoryBoundednessBufferIntervalCompare(
+          *cost_analysis);
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloAliasAnalysis> alias_analysis,
+                      HloAliasAnalysis::Run(module));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloLiveRange> hlo_live_range,
+      HloLiveRange::Run(module->schedule(), *alias_analysis, entry));
+  TF_RETURN_IF_ERROR(msa::MemorySpaceAssignment::Run(module, *hlo_live_range,
+                                                     *alias_analysis, options)
+                         .status());
+
+  TF_ASSIGN_OR_RETURN(bool changed,
+                      ReplaceAsyncCopies(module, offloaded_parameters));
+  ResetMemorySpaces(module);
+  module->clear_schedule();
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,79 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_OFFLOAD_PREFETCHER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_OFFLOAD_PREFETCHER_H_
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// Prefetches entry parameters that live in pinned host memory, typically
+// weights too large to keep in device memory, into device memory shortly
+// before they are used.
+//
+// The caller passes the listed parameters in pinned host memory, which the
+// device can read directly through unified addressing. This pass treats device
+// memory as the alternate memory of memory space assignment, limited to
+// `max_prefetch_bytes`, and lets it pick which uses of these parameters to
+// prefetch and when, using its cost analysis and prefetch interval picker.
+// Every prefetch becomes a copy of the parameter, with a control dependency
+// that keeps it from starting before the instruction the prefetch was
+// scheduled after. Uses that are not prefetched keep reading host memory.
+//
+// The GPU backend has no notion of memory spaces, so this pass resets the
+// memory space of all shapes and clears the schedule it computes. It must run
+// after copy insertion.
+class HostOffloadPrefetcher : public HloModulePass {
+ public:
+  struct Options {
+    // Numbers of the entry parameters that are in host memory.
+    std::vector<int64_t> parameter_numbers;
+
+    // Upper bound on the bytes of prefetched parameters that are live in
+    // device memory at once.
+    int64_t max_prefetch_bytes = 0;
+    int64_t alignment_in_bytes = 1;
+
+    // The rates used to estimate how long instructions and prefetches take.
+    float flops_per_second = 1e13;
+    float device_bytes_per_second = 9e11;
+    float host_to_device_bytes_per_second = 2.5e10;
+
+    HloCostAnalysis::ShapeSizeFunction shape_size;
+  };
+
+  explicit HostOffloadPrefetcher(Options options)
+      : options_(std::move(options)) {}
+  ~HostOffloadPrefetcher() override = default;
+
+  absl::string_view name() const override { return "host-offload-prefetcher"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  Options options_;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_OFFLOAD_PREFETCHER_H_
@@ -0,0 +1,100 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/host_offload_prefetcher.h"
+
+#include <utility>
+
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+class HostOffloadPrefetcherTest : public HloTestBase {
+ protected:
+  HostOffloadPrefetcher::Options MakeOptions(int64_t max_prefetch_bytes) {
+    HostOffloadPrefetcher::Options options;
+    options.parameter_numbers = {1};
+    options.max_prefetch_bytes = max_prefetch_bytes;
+    options.shape_size = [](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, /*pointer_size=*/8);
+    };
+    return options;
+  }
+};
+
+// The weight is only needed by the last dot, so there is enough compute before
+// it to hide a prefetch.
+constexpr char kModule[] = R"(
+HloModule module
+
+ENTRY entry {
+  p0 = f32[512,512]{1,0} parameter(0)
+  weight = f32[512,512]{1,0} parameter(1)
+  dot0 = f32[512,512]{1,0} dot(p0, p0), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot1 = f32[512,512]{1,0} dot(dot0, dot0), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot2 = f32[512,512]{1,0} dot(dot1, dot1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT dot3 = f32[512,512]{1,0} dot(dot2, weight), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+TEST_F(HostOffloadPrefetcherTest, PrefetchesOffloadedParameter) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  HostOffloadPrefetcher prefetcher(MakeOptions(/*max_prefetch_bytes=*/1 << 20));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, prefetcher.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Dot(op::Dot(), op::Copy(op::Parameter(1))));
+  // The copy starts after some instruction instead of at the very beginning.
+  EXPECT_EQ(root->operand(1)->control_predecessors().size(), 1);
+
+  EXPECT_FALSE(module->has_schedule());
+  for (const HloInstruction* instruction :
+       module->entry_computation()->instructions()) {
+    EXPECT_NE(instruction->opcode(), HloOpcode::kCopyStart);
+    EXPECT_NE(instruction->opcode(), HloOpcode::kCopyDone);
+    EXPECT_EQ(instruction->shape().layout().memory_space(), 0);
+  }
+}
+
+TEST_F(HostOffloadPrefetcherTest, WeightLargerThanLimitIsNotPrefetched) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  HostOffloadPrefetcher prefetcher(MakeOptions(/*max_prefetch_bytes=*/1024));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, prefetcher.Run(module.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Dot(op::Dot(), op::Parameter(1)));
+}
+
+TEST_F(HostOffloadPrefetcherTest, RejectsUnknownParameter) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  HostOffloadPrefetcher::Options options = MakeOptions(1 << 20);
+  options.parameter_numbers = {2};
+  HostOffloadPrefetcher prefetcher(std::move(options));
+  EXPECT_FALSE(prefetcher.Run(module.get()).ok());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,83 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/executable.h"
+#include "tensorflow/compiler/xla/service/gpu/tests/gpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+class GpuCudaGraphTest : public GpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cuda_graphs(true);
+    // Keep every instruction in its own kernel, so there is a run of kernels
+    // long enough to be captured.
+    debug_options.set_xla_disable_all_hlo_passes(true);
+    return debug_options;
+  }
+};
+
+// Runs the same executable several times with new argument buffers, so the
+// graph is replayed as well as updated for new buffer addresses.
+TEST_F(GpuCudaGraphTest, ReplaysKernelsWithNewBuffers) {
+  const char* hlo_text = R"(
+HloModule mod
+ENTRY main {
+  p0 = f32[4] parameter(0)
+  a = f32[4] add(p0, p0)
+  b = f32[4] multiply(a, p0)
+  c = f32[4] subtract(b, a)
+  d = f32[4] add(c, b)
+  ROOT e = f32[4] multiply(d, d)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Executable> executable,
+      test_runner_.CreateExecutable(std::move(module),
+                                    /*run_hlo_passes=*/true));
+
+  for (float scale : {1.0f, 1.0f, 2.0f, -1.0f}) {
+    std::vector<float> input = {scale * 1, scale * 2, scale * 3, scale * 4};
+    std::vector<float> expected;
+    for (float x : input) {
+      // e = (4x^2 - 2x)^2
+      float d = 4 * x * x - 2 * x;
+      expected.push_back(d * d);
+    }
+    Literal argument = LiteralUtil::CreateR1<float>(input);
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        test_runner_.ExecuteWithExecutable(executable.get(), {&argument},
+                                           /*profile=*/nullptr));
+    EXPECT_TRUE(LiteralTestUtil::Near(LiteralUtil::CreateR1<float>(expected),
+                                      result, ErrorSpec{1e-5, 1e-5}));
+  }
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -16,11 +16,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/heap_simulator.h"
 
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/hlo_live_range.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
@@ -625,34 +627,140 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+// A subtree is rebuilt when one of its children holds more than this fraction
+// of its nodes. Higher values rebuild less often but allow deeper trees.
+constexpr double kIntervalTreeBalance = 2.0 / 3.0;
+
+int64_t SubtreeSize(const BufferIntervalTreeNode* node) {
+  int64_t size = 0;
+  std::vector<const BufferIntervalTreeNode*> visiting_stack;
+  if (node != nullptr) {
+    visiting_stack.push_back(node);
+  }
+  while (!visiting_stack.empty()) {
+    const BufferIntervalTreeNode* top = visiting_stack.back();
+    visiting_stack.pop_back();
+    ++size;
+    if (top->left != nullptr) {
+      visiting_stack.push_back(top->left);
+    }
+    if (top->right != nullptr) {
+      visiting_stack.push_back(top->right);
+    }
+  }
+  return size;
+}
+
+// Links nodes[begin, end), which are sorted by start time, into a balanced
+// tree below `parent` and returns its root. Nodes with the same start time as
+// the root are kept in its right subtree, which is where Add and Remove look
+// for them.
+BufferIntervalTreeNode* BuildBalancedSubtree(
+    absl::Span<BufferIntervalTreeNode* const> nodes, int64_t begin,
+    int64_t end, BufferIntervalTreeNode* parent) {
+  if (begin == end) {
+    return nullptr;
+  }
+  int64_t mid = begin + (end - begin) / 2;
+  while (mid > begin && nodes[mid - 1]->start == nodes[mid]->start) {
+    --mid;
+  }
+  BufferIntervalTreeNode* node = nodes[mid];
+  node->parent = parent;
+  node->left = BuildBalancedSubtree(nodes, begin, mid, node);
+  node->right = BuildBalancedSubtree(nodes, mid + 1, end, node);
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+  return node;
+}
+
+}  // namespace
+
 void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
       start, end, end, chunk,
       /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
+  BufferIntervalTreeNode* node = &node_storage_.back();
+  ++num_nodes_;
   if (root_ == nullptr) {
-    root_ = &node_storage_.back();
+    root_ = node;
     // This is root.
     return;
   }
 
   BufferIntervalTreeNode* parent = root_;
+  int64_t depth = 1;
   while (true) {
     parent->subtree_end = std::max(parent->subtree_end, end);
     if (parent->start > start) {
       if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->left = node;
+        break;
       }
       parent = parent->left;
     } else {
       if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->right = node;
+        break;
       }
       parent = parent->right;
     }
+    ++depth;
+  }
+  node->parent = parent;
+
+  if (depth <= std::log(num_nodes_) / std::log(1.0 / kIntervalTreeBalance)) {
+    return;
+  }
+  // The node is too deep, so some ancestor has a child that holds too many of
+  // its nodes. Rebuild the lowest such ancestor.
+  int64_t child_size = 1;
+  for (BufferIntervalTreeNode* child = node; child->parent != nullptr;
+       child = child->parent) {
+    BufferIntervalTreeNode* ancestor = child->parent;
+    const BufferIntervalTreeNode* sibling =
+        ancestor->left == child ? ancestor->right : ancestor->left;
+    const int64_t size = child_size + 1 + SubtreeSize(sibling);
+    if (child_size > kIntervalTreeBalance * size) {
+      Rebalance(ancestor);
+      return;
+    }
+    child_size = size;
+  }
+}
+
+void BufferIntervalTree::Rebalance(BufferIntervalTreeNode* node) {
+  // Collect the nodes of the subtree in order.
+  std::vector<BufferIntervalTreeNode*> nodes;
+  std::vector<BufferIntervalTreeNode*> visiting_stack;
+  BufferIntervalTreeNode* current = node;
+  while (current != nullptr || !visiting_stack.empty()) {
+    while (current != nullptr) {
+      visiting_stack.push_back(current);
+      current = current->left;
+    }
+    current = visiting_stack.back();
+    visiting_stack.pop_back();
+    nodes.push_back(current);
+    current = current->right;
+  }
+
+  BufferIntervalTreeNode* parent = node->parent;
+  BufferIntervalTreeNode* subtree_root =
+      BuildBalancedSubtree(nodes, 0, nodes.size(), parent);
+  if (parent == nullptr) {
+    root_ = subtree_root;
+  } else if (parent->left == node) {
+    parent->left = subtree_root;
+  } else {
+    parent->right = subtree_root;
   }
 }
 
@@ -675,6 +783,7 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
     return false;
   }
   // Found the node to be deleted, enter deletion sequence.
+  --num_nodes_;
 
   // Recursively traverse the parents of node and fix up the `subtree_end`
   // invariant of a node. Recursive lambda need an explicit
@@ -715,6 +824,9 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
     if (root_ == to_delete) {
       // Deleting root is simply reseting root;
       root_ = to_delete->left;
+      if (root_ != nullptr) {
+        root_->parent = nullptr;
+      }
       return true;
     }
 
@@ -882,7 +994,7 @@ GlobalDecreasingSizeBestFitHeap<BufferType>::FindChunkCandidate(
   //   |+-a-+  +-------b-------+  +---c---+
   //   ----------------------------------------> time
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
-    auto colocation_interval = buffer_intervals_.at(colocation);
+    const auto& colocation_interval = buffer_intervals_.at(colocation);
     auto colocation_overlapping = interval_tree_.ChunksOverlappingInTime(
         colocation_interval.start, colocation_interval.end);
     VLOG(1) << "  Alias size " << colocation_interval.size << ", start "
@@ -963,7 +1075,7 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::CommitChunk(
                      chunk_candidate.chunk);
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
     AddToChunkMap(colocation, chunk_candidate.chunk);
-    auto colocation_interval = buffer_intervals_[colocation];
+    const auto& colocation_interval = buffer_intervals_[colocation];
     interval_tree_.Add(colocation_interval.start, colocation_interval.end,
                        chunk_candidate.chunk);
   }
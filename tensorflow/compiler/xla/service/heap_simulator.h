@@ -328,6 +328,11 @@ struct BufferIntervalTreeNode {
 };
 
 // An interval tree that can query buffers overlapping in time.
+//
+// The tree is a binary search tree on the alloc time. Adding a node that ends
+// up too deep rebuilds the smallest unbalanced subtree above it (as in a
+// scapegoat tree), so the tree stays logarithmically deep even when buffers
+// are added in the order of their alloc times.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -345,7 +350,12 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Rebuilds the subtree rooted at `node` into a balanced tree.
+  void Rebalance(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
+  // The number of nodes in the tree, not counting removed ones.
+  int64_t num_nodes_ = 0;
   std::list<BufferIntervalTreeNode> node_storage_;
 };
 
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/heap_simulator.h"
 
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/literal.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -1632,5 +1635,99 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+int64_t Depth(const BufferIntervalTreeNode* node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  return 1 + std::max(Depth(node->left), Depth(node->right));
+}
+
+TEST_F(IntervalTreeTest, StaysBalancedWhenAddedInOrder) {
+  // Without rebalancing, adding intervals in the order of their start times
+  // degenerates the tree into a list.
+  constexpr int64_t kNumIntervals = 1024;
+  BufferIntervalTree tree;
+  for (int64_t i = 0; i < kNumIntervals; ++i) {
+    tree.Add(i, i + 10, HeapSimulator::Chunk{i, 1});
+  }
+  EXPECT_LE(Depth(tree.GetRoot()), 2 * 10 + 1);
+
+  std::vector<HeapSimulator::Chunk> chunks =
+      tree.ChunksOverlappingInTime(500, 505);
+  std::vector<int64_t> offsets;
+  for (const HeapSimulator::Chunk& chunk : chunks) {
+    offsets.push_back(chunk.offset);
+  }
+  absl::c_sort(offsets);
+  std::vector<int64_t> expected_offsets(16);
+  absl::c_iota(expected_offsets, 490);
+  EXPECT_EQ(offsets, expected_offsets);
+
+  for (int64_t i = kNumIntervals - 1; i >= 0; --i) {
+    EXPECT_TRUE(tree.Remove(i, i + 10, HeapSimulator::Chunk{i, 1}));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+TEST_F(IntervalTreeTest, RebalanceKeepsEqualStartsFindable) {
+  BufferIntervalTree tree;
+  for (int64_t i = 0; i < 256; ++i) {
+    tree.Add(i / 4, i / 4 + 1, HeapSimulator::Chunk{i, 1});
+  }
+  for (int64_t i = 0; i < 256; ++i) {
+    EXPECT_TRUE(tree.Remove(i / 4, i / 4 + 1, HeapSimulator::Chunk{i, 1}));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+// Runs GlobalDecreasingSizeBestFitHeap over `num_buffers` synthetic buffers of
+// varying sizes, at most `max_live` of which are live at once.
+void BM_GlobalDecreasingSizeBestFitHeap(
+    ::testing::benchmark::State& state) {
+  const int64_t num_buffers = state.range(0);
+  const int64_t max_live = state.range(1);
+  HloComputation::Builder builder("benchmark");
+  HloInstruction* constant = builder.AddInstruction(
+      HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+  std::vector<std::unique_ptr<HloValue>> buffers;
+  for (int64_t i = 0; i < num_buffers; ++i) {
+    buffers.push_back(
+        absl::make_unique<HloValue>(i, constant, ShapeIndex{}));
+  }
+  // Sizes up to 1 MiB and lifetimes up to `max_live` steps drawn from a
+  // deterministic sequence.
+  std::vector<int64_t> sizes(num_buffers);
+  std::vector<int64_t> lifetimes(num_buffers);
+  uint64_t random = 42;
+  for (int64_t i = 0; i < num_buffers; ++i) {
+    random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+    sizes[i] = (random >> 33) % (1 << 20) + 1;
+    lifetimes[i] = (random >> 13) % max_live + 1;
+  }
+
+  for (auto s : state) {
+    GlobalDecreasingSizeBestFitHeap<HloValue> heap(/*alignment=*/64);
+    std::multimap<int64_t, int64_t> frees;
+    for (int64_t i = 0; i < num_buffers; ++i) {
+      while (!frees.empty() && frees.begin()->first <= i) {
+        const int64_t buffer = frees.begin()->second;
+        heap.Free(buffers[buffer].get(), sizes[buffer]);
+        frees.erase(frees.begin());
+      }
+      heap.Alloc(buffers[i].get(), sizes[i]);
+      frees.emplace(i + lifetimes[i], i);
+    }
+    for (const auto& free : frees) {
+      heap.Free(buffers[free.second].get(), sizes[free.second]);
+    }
+    tensorflow::testing::DoNotOptimize(heap.Finish());
+  }
+}
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)
+    ->ArgPair(1 << 10, 64)
+    ->ArgPair(1 << 14, 64)
+    ->ArgPair(1 << 14, 1024)
+    ->ArgPair(1 << 17, 256);
+
 }  // namespace
 }  // namespace xla
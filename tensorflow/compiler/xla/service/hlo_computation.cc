@@ -117,8 +117,14 @@ HloInstruction* HloComputation::AddInstruction(
 HloInstruction* HloComputation::AddInstructionInternal(
     std::unique_ptr<HloInstruction> instruction) {
   if (parent() != nullptr) {
-    instruction->UniquifyName(&parent()->instruction_name_uniquer());
-    instruction->SetUniqueId(parent()->NewUniqueInstructionId());
+    if (next_deferred_id_ < limit_deferred_id_) {
+      instruction->SetUniqueId(next_deferred_id_++);
+    } else {
+      CHECK_EQ(limit_deferred_id_, 0)
+          << "Ran out of deferred ids in " << name();
+      instruction->UniquifyName(&parent()->instruction_name_uniquer());
+      instruction->SetUniqueId(parent()->NewUniqueInstructionId());
+    }
   }
   instruction->set_parent(this);
   HloInstruction* pinst = instruction.get();
@@ -127,6 +133,31 @@ HloInstruction* HloComputation::AddInstructionInternal(
   return pinst;
 }
 
+void HloComputation::StartDeferredUniquing(int first_id, int limit_id) {
+  CHECK_EQ(limit_deferred_id_, 0) << "Uniquing is already deferred in "
+                                  << name();
+  CHECK_LT(first_id, limit_id);
+  first_deferred_id_ = first_id;
+  next_deferred_id_ = first_id;
+  limit_deferred_id_ = limit_id;
+}
+
+void HloComputation::FinishDeferredUniquing() {
+  CHECK_NE(limit_deferred_id_, 0) << "Uniquing is not deferred in " << name();
+  // instructions_ is in the order the instructions were added.
+  for (const std::unique_ptr<HloInstruction>& instruction : instructions_) {
+    if (instruction->unique_id() >= first_deferred_id_ &&
+        instruction->unique_id() < next_deferred_id_) {
+      instruction->UniquifyName(&parent()->instruction_name_uniquer());
+      instruction->ClearUniqueIdInternal();
+      instruction->SetUniqueId(parent()->NewUniqueInstructionId());
+    }
+  }
+  first_deferred_id_ = 0;
+  next_deferred_id_ = 0;
+  limit_deferred_id_ = 0;
+}
+
 HloInstruction* HloComputation::AddParameter(
     std::unique_ptr<HloInstruction> instruction) {
   CHECK(instruction->opcode() == HloOpcode::kParameter);
@@ -529,6 +529,18 @@ class HloComputation {
   // Returns true if a given instruction is marked dead in this computation.
   bool IsMarkedAsDead(const HloInstruction* inst);
 
+  // Until FinishDeferredUniquing is called, instructions added to this
+  // computation take their ids from [first_id, limit_id) and keep the names
+  // they were given, instead of drawing both from the module. This lets a pass
+  // run on several computations of a module concurrently. The ids in the range
+  // must not be used by any instruction of the module.
+  void StartDeferredUniquing(int first_id, int limit_id);
+
+  // Gives the instructions added since StartDeferredUniquing module-unique
+  // names and ids, in the order they were added. The result therefore does not
+  // depend on how the additions to different computations interleaved.
+  void FinishDeferredUniquing();
+
  private:
   explicit HloComputation(
       const string& name, int parameter_count,
@@ -613,6 +625,12 @@ class HloComputation {
 
   std::vector<HloInstruction*> param_instructions_;
 
+  // The ids handed out while uniquing is deferred, the next of which is
+  // next_deferred_id_. The range is empty unless uniquing is deferred.
+  int first_deferred_id_ = 0;
+  int next_deferred_id_ = 0;
+  int limit_deferred_id_ = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(HloComputation);
 };
 
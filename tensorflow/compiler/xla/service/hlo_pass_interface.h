@@ -92,6 +92,9 @@ class HloPassInterface {
   virtual StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) = 0;
 
   virtual bool IsPassPipeline() { return false; }
+
+  // Returns true if the pass is an HloComputationPass.
+  virtual bool IsComputationPass() { return false; }
 };
 
 // Base class for passes which are module-scoped.
@@ -117,6 +120,33 @@ class HloModulePass : public HloPassInterface {
   virtual void UpdateLayout(Shape* shape) {}
 };
 
+// Base class for passes which transform every non-fusion computation of a
+// module on its own. Running the pass on a computation may only read and write
+// that computation and its instructions. In particular it must not add or
+// remove computations, modify fused computations, or look at other
+// computations, including the ones the computation calls. HloPassPipeline may
+// then run the pass on several computations of a module concurrently, see
+// --xla_hlo_pass_parallelism.
+class HloComputationPass : public HloModulePass {
+ public:
+  // Runs the pass on the given computation. Returns whether it modified the
+  // computation.
+  virtual StatusOr<bool> RunOnComputation(HloComputation* computation) = 0;
+
+  // Runs the pass on each non-fusion computation of the module in turn.
+  StatusOr<bool> Run(HloModule* module) override {
+    bool changed = false;
+    for (HloComputation* computation : module->MakeNonfusionComputations()) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed,
+                          RunOnComputation(computation));
+      changed |= computation_changed;
+    }
+    return changed;
+  }
+
+  bool IsComputationPass() final { return true; }
+};
+
 // Base class for passes which are module-group scoped. These passes cannot run
 // on an HLO module.
 class HloModuleGroupPass : public HloPassInterface {
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
 #include <functional>
+#include <limits>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -27,6 +28,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -40,6 +43,8 @@ void RecordPassStartMetadata(HloModule& module, const std::string& pass_name,
   // An HloPassMetadata was just created so Status should always be OK.
   TF_CHECK_OK(module.metadata()->set_current_pass_name(pass_name));
   TF_CHECK_OK(module.metadata()->set_current_pass_pipeline_name(pipeline_name));
+  TF_CHECK_OK(module.metadata()->set_current_pass_instruction_count_before(
+      module.instruction_count()));
 }
 
 void RecordPassStartMetadata(HloModuleGroup& module_group,
@@ -59,6 +64,9 @@ Status AttemptRecordPassEndMetadata(HloModule& module,
       module.metadata()->set_current_pass_module_id(module.unique_id()));
   TF_RETURN_IF_ERROR(
       module.metadata()->set_current_pass_module_changed(module_changed));
+  TF_RETURN_IF_ERROR(
+      module.metadata()->set_current_pass_instruction_count_after(
+          module.instruction_count()));
   TF_RETURN_IF_ERROR(module.metadata()->RecordPassEnd());
   return Status::OK();
 }
@@ -119,6 +127,45 @@ void SetInstructionMetadata(HloModuleGroup& module_group) {
   }
 }
 
+// Runs `pass` on `computations` concurrently. The instructions the pass adds
+// get module-unique names and ids once all computations are done, in the order
+// of `computations`, so the result does not depend on the thread schedule.
+StatusOr<bool> RunComputationPassInParallel(
+    HloComputationPass* pass, HloModule* module,
+    absl::Span<HloComputation* const> computations,
+    tensorflow::thread::ThreadPool* thread_pool) {
+  // Each computation gets its own range of ids above all the ids in use.
+  const int64_t first_id = module->NewUniqueInstructionId();
+  const int64_t ids_per_computation =
+      (std::numeric_limits<int>::max() - first_id) / computations.size();
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    computations[i]->StartDeferredUniquing(
+        first_id + i * ids_per_computation,
+        first_id + (i + 1) * ids_per_computation);
+  }
+
+  std::vector<StatusOr<bool>> results(computations.size(), false);
+  tensorflow::BlockingCounter counter(computations.size());
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    thread_pool->Schedule([&, i]() {
+      results[i] = pass->RunOnComputation(computations[i]);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+
+  bool changed = false;
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    computations[i]->FinishDeferredUniquing();
+  }
+  for (const StatusOr<bool>& result : results) {
+    TF_RETURN_IF_ERROR(result.status());
+    changed |= result.ValueOrDie();
+  }
+  module->Cleanup();
+  return changed;
+}
+
 }  // namespace
 
 template <typename HloT>
@@ -176,7 +223,8 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
       compilation_stats_->StartPass(pass_name);
     }
     RecordPassStartMetadata(*hlo, pass_name, pipeline_name);
-    TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
+    TF_ASSIGN_OR_RETURN(bool pass_changed,
+                        RunPass(pass, hlo, debug_options));
     SetInstructionMetadata(*hlo);
     if (!dump_regex.empty() && (pass_changed || dump_regex != ".*")) {
       MaybeDumpHloAndSaveFilenames(*hlo,
@@ -198,6 +246,31 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
   return changed;
 }
 
+StatusOr<bool> HloPassPipeline::RunPass(HloPassInterface* pass,
+                                        HloModule* module,
+                                        const DebugOptions& debug_options) {
+  const int parallelism = debug_options.xla_hlo_pass_parallelism();
+  // The schedule refers to instructions by id, which a parallel run changes.
+  if (parallelism <= 1 || !pass->IsComputationPass() ||
+      module->has_schedule()) {
+    return RunHelper(pass, module);
+  }
+  std::vector<HloComputation*> computations =
+      module->MakeNonfusionComputations();
+  if (computations.size() <= 1) {
+    return RunHelper(pass, module);
+  }
+  if (thread_pool_ == nullptr || thread_pool_->NumThreads() != parallelism) {
+    thread_pool_ = std::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "hlo_pass_pipeline", parallelism);
+  }
+  VLOG(1) << "  Running " << pass->name() << " on " << computations.size()
+          << " computations in parallel";
+  return RunComputationPassInParallel(
+      static_cast<HloComputationPass*>(pass), module, computations,
+      thread_pool_.get());
+}
+
 std::vector<HloPassInterface*> HloPassPipeline::GetEnabledPasses(
     const DebugOptions& debug_options) {
   if (debug_options.xla_disable_all_hlo_passes()) {
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -117,6 +118,15 @@ class HloPassPipeline : public HloPassInterface {
   StatusOr<bool> RunPassesInternal(HloT* hlo,
                                    const DebugOptions& debug_options);
 
+  // Runs the pass on the module. HloComputationPasses run on the computations
+  // of the module concurrently if --xla_hlo_pass_parallelism allows it.
+  StatusOr<bool> RunPass(HloPassInterface* pass, HloModule* module,
+                         const DebugOptions& debug_options);
+  StatusOr<bool> RunPass(HloPassInterface* pass, HloModuleGroup* module_group,
+                         const DebugOptions& debug_options) {
+    return RunHelper(pass, module_group);
+  }
+
   // Helpers which run the given passes on the given HLO construct. These
   // helpers enable templating of the core of the pipeline logic by providing
   // HloModule and HloModuleGroup specific methods with the same name.
@@ -142,6 +152,9 @@ class HloPassPipeline : public HloPassInterface {
   // Use via compilation_stats_, not directly.
   std::unique_ptr<CompilationStats> empty_compilation_stats_;
 
+  // Runs HloComputationPasses. Created when the first one runs in parallel.
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+
   // Allow PhaseOrderPipeline to modify private passes_ member in order to
   // perform PhaseOrdering.
   friend class ::xla::PhaseOrderPipeline;
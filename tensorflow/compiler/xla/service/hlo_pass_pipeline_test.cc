@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -99,6 +100,19 @@ class BarBlowerUpper : public HloModulePass {
   }
 };
 
+// A computation pass which negates the root of every computation.
+class NegateRootComputationPass : public HloComputationPass {
+  absl::string_view name() const override { return "negate-root"; }
+
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    HloInstruction* root = computation->root_instruction();
+    computation->set_root_instruction(
+        computation->AddInstruction(HloInstruction::CreateUnary(
+            root->shape(), HloOpcode::kNegate, root)));
+    return true;
+  }
+};
+
 TEST_F(HloPassPipelineTest, ModulePassChanged) {
   // Test an HLO module pass which changes a module.
   const string module_str = R"(
@@ -297,5 +311,92 @@ TEST_F(HloPassPipelineTest, SetHloModuleMetadata) {
   }
 }
 
+TEST_F(HloPassPipelineTest, ComputationPassInParallel) {
+  const string module_str = R"(
+HloModule ComputationPassInParallel
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT add = f32[] add(x, y)
+}
+
+mul {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT mul = f32[] multiply(x, y)
+}
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  c = f32[] call(a, b), to_apply=add
+  ROOT d = f32[] call(c, b), to_apply=mul
+}
+)";
+  auto run = [&](int parallelism) -> StatusOr<std::unique_ptr<HloModule>> {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<VerifiedHloModule> module,
+                        ParseAndReturnVerifiedModule(module_str));
+    DebugOptions debug_options = GetDebugOptionsForTest();
+    debug_options.set_xla_hlo_pass_parallelism(parallelism);
+    module->config().set_debug_options(debug_options);
+    HloPassPipeline pipeline(TestName());
+    pipeline.AddPass<NegateRootComputationPass>();
+    pipeline.AddPass<NegateRootComputationPass>();
+    TF_ASSIGN_OR_RETURN(bool changed, pipeline.Run(module.get()));
+    EXPECT_TRUE(changed);
+    return std::unique_ptr<HloModule>(std::move(module));
+  };
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> serial, run(1));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> parallel, run(4));
+
+  // The parallel run assigns the same names and ids as the serial one.
+  ASSERT_EQ(serial->computation_count(), parallel->computation_count());
+  for (int64_t i = 0; i < serial->computation_count(); ++i) {
+    std::vector<HloInstruction*> expected =
+        serial->computations()[i]->MakeInstructionPostOrder();
+    std::vector<HloInstruction*> actual =
+        parallel->computations()[i]->MakeInstructionPostOrder();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (int64_t j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(expected[j]->name(), actual[j]->name());
+      EXPECT_EQ(expected[j]->unique_id(), actual[j]->unique_id());
+    }
+  }
+  absl::flat_hash_set<int> ids;
+  absl::flat_hash_set<std::string> names;
+  for (HloComputation* computation : parallel->computations()) {
+    EXPECT_EQ(computation->root_instruction()->opcode(), HloOpcode::kNegate);
+    for (HloInstruction* instruction : computation->instructions()) {
+      EXPECT_TRUE(ids.insert(instruction->unique_id()).second);
+      EXPECT_TRUE(names.insert(instruction->name()).second);
+    }
+  }
+}
+
+TEST_F(HloPassPipelineTest, RecordInstructionCounts) {
+  const string module_str = R"(
+HloModule RecordInstructionCounts
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT c = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  HloPassPipeline pipeline(TestName());
+  pipeline.AddPass<NegateRootComputationPass>();
+  TF_ASSERT_OK(pipeline.Run(module.get()).status());
+
+  const HloModuleMetadataProto& metadata = module->metadata().proto();
+  ASSERT_THAT(metadata.pass_metadata(), SizeIs(2));
+  const HloPassMetadata& pass_metadata = metadata.pass_metadata(1);
+  EXPECT_THAT(pass_metadata.pass_name(), StrEq("negate-root"));
+  EXPECT_EQ(pass_metadata.instruction_count_before(), 3);
+  EXPECT_EQ(pass_metadata.instruction_count_after(), 4);
+}
+
 }  // namespace
 }  // namespace xla
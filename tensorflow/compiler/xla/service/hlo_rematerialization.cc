@@ -25,9 +25,11 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
@@ -42,6 +44,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/hlo_ordering.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -120,6 +123,8 @@ struct RematStrategy {
     // Change the layout into a compact form and uncompress it back at a later
     // program point.
     kCompress,
+    // Copy the node to host memory and copy it back at a later program point.
+    kHostOffload,
   } kind;
   Shape compact_shape;
 };
@@ -245,6 +250,7 @@ class InstructionList {
   //    for (auto item = q.first(); item != nullptr; item = q.next(item)) {...}
   Item* first() const { return first_; }
   Item* next(Item* item) const { return item->next; }
+  Item* prev(Item* item) const { return item->prev; }
 
   Item* first_skip_node() const { return first_skip_node_; }
   Item* next_skip_node(Item* item) const { return item->next_skip_node; }
@@ -497,7 +503,9 @@ class MemoryUsageTracker {
       const HloRematerialization::CompactShapeFunction& compact_shape_function,
       const TuplePointsToAnalysis& points_to_analysis,
       const InstructionList& instruction_list,
-      HloRematerialization::RematerializationMode mode);
+      HloRematerialization::RematerializationMode mode,
+      const HloRematerialization::HostOffloadConfig* host_offload_config,
+      const HloCostAnalysis* cost_analysis);
 
   // Starts the placement of the given instruction. This adds the sizes of the
   // LogicalBuffers defined by the instruction to the current memory
@@ -547,9 +555,21 @@ class MemoryUsageTracker {
   int64_t MemoryReducedIfRematerialized(
       absl::Span<const Item* const> items) const;
 
+  // Returns the number of bytes that the current memory usage will be reduced
+  // by if the output of the given instruction is offloaded to host memory.
+  int64_t MemoryReducedIfOffloaded(Item* item) const;
+
   Status AddCompressInstructions(Item* original_item, Item* compressed_item,
                                  Item* uncompressed_item);
 
+  // Adjusts memory usage to account for offloading original_item to host
+  // memory. The copy to host memory (to_host_start and to_host_done) has been
+  // placed, the copy back (from_host_start and from_host_done) replaces
+  // original_item for all remaining unplaced uses.
+  Status AddHostOffloadInstructions(Item* original_item, Item* to_host_start,
+                                    Item* to_host_done, Item* from_host_start,
+                                    Item* from_host_done);
+
   // Adjusts memory usage to account for the rematerialization of
   // original_item for all remaining unplaced uses. The rematerialization
   // is remat_item. This method should be called after the HLO graph has
@@ -587,6 +607,8 @@ class MemoryUsageTracker {
   // Returns whether 'item' is currently in progress.
   bool IsInProgressItem(Item* item) const { return item == in_progress_item_; }
 
+  Item* in_progress_item() const { return in_progress_item_; }
+
   // Returns the current memory usage. This is the sum of sizes of all live
   // values.
   int64_t memory_usage() const { return memory_usage_; }
@@ -600,6 +622,14 @@ class MemoryUsageTracker {
     return size;
   }
 
+  // Returns the estimated run time of the given instruction. Must only be
+  // called if offloading to host memory is enabled.
+  double EstimatedSeconds(const Item* item) const;
+
+  const HloRematerialization::HostOffloadConfig* host_offload_config() const {
+    return host_offload_config_;
+  }
+
   // Check invariants of the data structure. This is expensive to call.
   bool Check() const;
 
@@ -737,10 +767,12 @@ class MemoryUsageTracker {
     return false;
   }
 
-  // Create a new buffer, add it to buffers_, and return a reference.
+  // Create a new buffer, add it to buffers_, and return a reference. The size
+  // of the buffer is computed from its shape unless it is given.
   Buffer& NewBuffer(Item* defining_instruction, const Shape& shape,
                     const ShapeIndex& index, UsesList&& uses, bool live_out,
-                    bool has_indirect_uses) {
+                    bool has_indirect_uses,
+                    absl::optional<int64_t> size = absl::nullopt) {
     int buffer_id = buffers_.size();
     auto get_num_of_unique_users = [](const UsesList& uses) -> int64_t {
       absl::flat_hash_set<Item*> users_set;
@@ -749,9 +781,10 @@ class MemoryUsageTracker {
       }
       return users_set.size();
     };
-    buffers_.push_back(Buffer{
-        buffer_id, defining_instruction, size_function_(shape), shape, live_out,
-        has_indirect_uses, index, uses, get_num_of_unique_users(uses)});
+    buffers_.push_back(Buffer{buffer_id, defining_instruction,
+                              size.has_value() ? *size : size_function_(shape),
+                              shape, live_out, has_indirect_uses, index, uses,
+                              get_num_of_unique_users(uses)});
     return buffers_.back();
   }
 
@@ -780,6 +813,11 @@ class MemoryUsageTracker {
   Item* in_progress_item_ = nullptr;
 
   HloRematerialization::RematerializationMode mode_;
+
+  // Enables offloading to host memory if non-null.
+  const HloRematerialization::HostOffloadConfig* host_offload_config_;
+  const HloCostAnalysis* cost_analysis_;
+
   // All buffers in the computation.
   std::vector<Buffer> buffers_;
 };
@@ -790,12 +828,17 @@ MemoryUsageTracker::MemoryUsageTracker(
     const HloRematerialization::CompactShapeFunction& compact_shape_function,
     const TuplePointsToAnalysis& points_to_analysis,
     const InstructionList& instruction_list,
-    HloRematerialization::RematerializationMode mode)
+    HloRematerialization::RematerializationMode mode,
+    const HloRematerialization::HostOffloadConfig* host_offload_config,
+    const HloCostAnalysis* cost_analysis)
     : computation_(computation),
       instruction_list_(instruction_list),
       size_function_(size_function),
       compact_shape_function_(compact_shape_function),
-      mode_(mode) {
+      mode_(mode),
+      host_offload_config_(host_offload_config),
+      cost_analysis_(cost_analysis) {
+  CHECK((host_offload_config_ == nullptr) == (cost_analysis_ == nullptr));
   PointsToSet::BufferSet live_out_set =
       points_to_analysis.GetPointsToSet(computation_->root_instruction())
           .CreateFlattenedSet();
@@ -1069,6 +1112,126 @@ Status MemoryUsageTracker::AddCompressInstructions(Item* original_item,
   return Status::OK();
 }
 
+int64_t MemoryUsageTracker::MemoryReducedIfOffloaded(Item* item) const {
+  CHECK_NE(in_progress_item_, nullptr);
+  if (!item->placed || item == in_progress_item_ ||
+      item->buffers_output.size() != 1) {
+    return 0;
+  }
+  BufferId buffer_id = item->buffers_output[0];
+  const Buffer& buffer = buffers_.at(buffer_id);
+  if (buffer.live_out || buffer.has_indirect_uses ||
+      !IsCurrentlyLive(buffer_id) || IsInUse(buffer_id) ||
+      !IsInstructionCurrentlyLive(item)) {
+    return 0;
+  }
+  // The value is held in host memory across the current program point, which
+  // does not count towards the memory limit.
+  return AllocatedSize(buffer_id);
+}
+
+Status MemoryUsageTracker::AddHostOffloadInstructions(Item* original_item,
+                                                      Item* to_host_start,
+                                                      Item* to_host_done,
+                                                      Item* from_host_start,
+                                                      Item* from_host_done) {
+  TF_RET_CHECK(to_host_start->placed && to_host_done->placed);
+  TF_RET_CHECK(original_item->buffers_output.size() == 1);
+  BufferId original_buffer_id = original_item->buffers_output[0];
+  Buffer& original_buffer = buffers_.at(original_buffer_id);
+  const int64_t size = original_buffer.size;
+  // Original buffer is now dead.
+  memory_usage_ -= AllocatedSize(original_buffer_id);
+
+  UsesList placed_users;
+  UsesList unplaced_users;
+  for (ItemUse& user : original_buffer.users) {
+    if (user.user->placed) {
+      CHECK(IsFinished(user.user)) << user.user->instruction->name();
+      placed_users.push_back(user);
+    } else {
+      unplaced_users.push_back(user);
+    }
+  }
+  original_buffer.users = std::move(placed_users);
+  original_buffer.unfinished_user_count = 0;
+  original_buffer.users.push_back(ItemUse{to_host_start, 0, absl::nullopt});
+  // We are reallocating the vector containing the buffers potentially,
+  // invalidating the original_buffer reference, so copy the index that we need
+  // across NewBuffer calls.
+  ShapeIndex copied_index = original_buffer.index;
+
+  // The buffers in host memory take no device memory. The copy back allocates
+  // its device buffer when it starts, and the output of from_host_done aliases
+  // that buffer, so the buffer of from_host_start is live until the last use
+  // of from_host_done and the buffer of from_host_done takes no memory.
+  Buffer& to_host_start_buffer = NewBuffer(
+      to_host_start, to_host_start->instruction->shape(), copied_index,
+      {ItemUse{to_host_done, 0, absl::nullopt}}, /*live_out=*/false,
+      /*has_indirect_uses=*/false, /*size=*/0);
+  // Both copy instructions have been placed already.
+  to_host_start_buffer.unfinished_user_count = 0;
+  to_host_start->buffers_used = original_item->buffers_output;
+  to_host_start->buffers_output = {to_host_start_buffer.id};
+  to_host_start->buffers_defined = {to_host_start_buffer.id};
+
+  Buffer& host_buffer = NewBuffer(
+      to_host_done, to_host_done->instruction->shape(), copied_index,
+      {ItemUse{from_host_start, 0, absl::nullopt}}, /*live_out=*/false,
+      /*has_indirect_uses=*/false, /*size=*/0);
+  to_host_done->buffers_used = to_host_start->buffers_output;
+  to_host_done->buffers_output = {host_buffer.id};
+  to_host_done->buffers_defined = {host_buffer.id};
+
+  UsesList from_host_start_users = unplaced_users;
+  from_host_start_users.push_back(ItemUse{from_host_done, 0, absl::nullopt});
+  Buffer& from_host_start_buffer = NewBuffer(
+      from_host_start, from_host_start->instruction->shape(), copied_index,
+      std::move(from_host_start_users), /*live_out=*/false,
+      /*has_indirect_uses=*/false, size);
+  from_host_start->buffers_used = to_host_done->buffers_output;
+  from_host_start->buffers_output = {from_host_start_buffer.id};
+  from_host_start->buffers_defined = {from_host_start_buffer.id};
+
+  Buffer& reloaded_buffer = NewBuffer(
+      from_host_done, from_host_done->instruction->shape(), copied_index,
+      std::move(unplaced_users), /*live_out=*/false,
+      /*has_indirect_uses=*/false, /*size=*/0);
+  from_host_done->buffers_used = from_host_start->buffers_output;
+  from_host_done->buffers_output = {reloaded_buffer.id};
+  from_host_done->buffers_defined = {reloaded_buffer.id};
+
+  for (ItemUse& user : reloaded_buffer.users) {
+    BufferIdList& buffers_used = user.user->buffers_used;
+    std::replace(buffers_used.begin(), buffers_used.end(), original_buffer_id,
+                 reloaded_buffer.id);
+    const BufferId reload_buffer_id = from_host_start->buffers_output[0];
+    if (!absl::c_linear_search(buffers_used, reload_buffer_id)) {
+      buffers_used.push_back(reload_buffer_id);
+    }
+  }
+
+  return Status::OK();
+}
+
+double MemoryUsageTracker::EstimatedSeconds(const Item* item) const {
+  CHECK(cost_analysis_ != nullptr);
+  const HloInstruction* instruction = item->instruction;
+  double bytes = cost_analysis_->bytes_accessed(*instruction);
+  if (bytes == 0) {
+    // Instructions added by rematerialization are not known to the cost
+    // analysis. Estimate them by their operand and output sizes.
+    bytes = size_function_(instruction->shape());
+    for (const HloInstruction* operand : instruction->operands()) {
+      bytes += size_function_(operand->shape());
+    }
+  }
+  return std::max<double>(
+      cost_analysis_->flop_count(*instruction) /
+          host_offload_config_->flops_per_second,
+      bytes / host_offload_config_->device_bytes_per_second);
+}
+
 Status MemoryUsageTracker::AddRematerializedInstruction(
     Item* original_item, Item* remat_item, absl::Span<Item*> indirect_users) {
   VLOG(3) << "AddRematerializedInstruction: original_instruction = "
@@ -1381,13 +1544,32 @@ MemoryUsageTracker::PickRematerializationCandidates(
     absl::flat_hash_map<const HloInstruction*, bool>* rematerializable_map,
     int min_block_size, int max_block_size) {
   std::vector<Item*> best_items;
-  int64_t best_cost = 0;
+  double best_cost = 0;
   RematStrategy best_strategy;
 
   int effort = 0;
   VLOG(5) << "Picking candidate block with size in [" << min_block_size << ", "
           << max_block_size << "]";
 
+  // With offloading to host memory enabled, the cost of every strategy is the
+  // estimated run time it adds per byte it saves. An offload only adds the
+  // part of the copy to host memory that the instructions placed since the
+  // value was defined cannot hide, plus the copy back, which is issued right
+  // before the next use.
+  const HloRematerialization::HostOffloadConfig* offload = host_offload_config_;
+  auto seconds_per_byte = [](double seconds, int64_t memory_reduced) {
+    return seconds / memory_reduced;
+  };
+  absl::flat_hash_map<const Item*, double> seconds_before;
+  double seconds_before_in_progress = 0;
+  if (offload != nullptr) {
+    for (auto* item = instruction_list.first(); item != in_progress_item_;
+         item = instruction_list.next(item)) {
+      seconds_before[item] = seconds_before_in_progress;
+      seconds_before_in_progress += EstimatedSeconds(item);
+    }
+  }
+
   for (auto* start_item = instruction_list.first_skip_node();
        start_item != nullptr;
        start_item = instruction_list.next_skip_node(start_item)) {
@@ -1428,7 +1610,16 @@ MemoryUsageTracker::PickRematerializationCandidates(
                   MemoryReducedIfCompressed(item, compact_shape);
               effort++;
               if (memory_reduced > 0) {
-                const int64_t cost = memory_limit_bytes / memory_reduced;
+                double cost = memory_limit_bytes / memory_reduced;
+                if (offload != nullptr) {
+                  // Both copies read and write the value.
+                  const double copy_bytes =
+                      2 * (size_function_(original_shape) +
+                           size_function_(compact_shape));
+                  cost = seconds_per_byte(
+                      copy_bytes / offload->device_bytes_per_second,
+                      memory_reduced);
+                }
                 if (best_items.empty() || cost < best_cost) {
                   VLOG(3) << "candidate " << candidate->name() << "("
                           << candidate->ToShortString() << ")"
@@ -1445,6 +1636,33 @@ MemoryUsageTracker::PickRematerializationCandidates(
             }
           }
         }
+        const int64_t memory_reduced =
+            offload == nullptr ? 0 : MemoryReducedIfOffloaded(item);
+        if (memory_reduced > 0 && candidate->shape().IsArray() &&
+            LayoutUtil::HasLayout(candidate->shape()) &&
+            candidate->shape().layout().memory_space() !=
+                offload->host_memory_space) {
+          effort++;
+          const double hidden_seconds = seconds_before_in_progress -
+                                        seconds_before.at(item) -
+                                        EstimatedSeconds(item);
+          const double to_host_seconds =
+              memory_reduced / offload->bandwidth_to_host_bytes_per_second;
+          const double from_host_seconds =
+              memory_reduced / offload->bandwidth_from_host_bytes_per_second;
+          const double cost = seconds_per_byte(
+              std::max(0.0, to_host_seconds - hidden_seconds) +
+                  from_host_seconds,
+              memory_reduced);
+          if (best_items.empty() || cost < best_cost) {
+            VLOG(3) << "candidate " << candidate->name() << "("
+                    << candidate->ToShortString() << ")"
+                    << " now best when offloaded to host memory";
+            best_strategy.kind = RematStrategy::kHostOffload;
+            best_items = block;
+            best_cost = cost;
+          }
+        }
       }
       // Do not consider recomputation in compress-only mode.
       if (mode_ == HloRematerialization::RematerializationMode::kCompressOnly) {
@@ -1476,8 +1694,15 @@ MemoryUsageTracker::PickRematerializationCandidates(
       const int64_t memory_reduced = MemoryReducedIfRematerialized(block);
       effort++;
       if (memory_reduced > 0) {
-        const int cost =
+        double cost =
             RematerializationCost(block, memory_reduced, memory_limit_bytes);
+        if (offload != nullptr && cost > 0) {
+          double seconds = 0;
+          for (const Item* item : block) {
+            seconds += EstimatedSeconds(item);
+          }
+          cost = seconds_per_byte(seconds, memory_reduced);
+        }
 
         VLOG(5) << "Candidate block of size " << block.size()
                 << " starting from " << block[0]->instruction->name()
@@ -1743,6 +1968,96 @@ StatusOr<int64_t> CompressInstruction(MemoryUsageTracker* memory_tracker,
   return 2;
 }
 
+// Offloads the output of best_item to host memory. The copy to host memory
+// starts right after best_item and is done right before the in-progress
+// instruction, so it overlaps with every instruction placed in between. The
+// copy back starts one instruction before the earliest remaining use.
+StatusOr<int64_t> OffloadInstruction(MemoryUsageTracker* memory_tracker,
+                                     Item* best_item,
+                                     InstructionList* instruction_list) {
+  HloInstruction* best = best_item->instruction;
+  VLOG(5) << "Offloading instruction " << best->name() << " (saving "
+          << HumanReadableNumBytes(
+                 memory_tracker->MemoryReducedIfOffloaded(best_item))
+          << ") to host memory";
+
+  HloComputation* computation = best->parent();
+  const Shape& device_shape = best->shape();
+  Shape host_shape = device_shape;
+  host_shape.mutable_layout()->set_memory_space(
+      memory_tracker->host_offload_config()->host_memory_space);
+  const Shape context_shape = ShapeUtil::MakeShape(U32, {});
+
+  HloInstruction* to_host_start = computation->AddInstruction(
+      HloInstruction::CreateCopyStart(
+          ShapeUtil::MakeTupleShape({host_shape, device_shape, context_shape}),
+          best),
+      /*new_name=*/best->name() + ".remat_offload_start");
+  HloInstruction* to_host_done = computation->AddInstruction(
+      HloInstruction::CreateUnary(host_shape, HloOpcode::kCopyDone,
+                                  to_host_start),
+      /*new_name=*/best->name() + ".remat_offload_done");
+  HloInstruction* from_host_start = computation->AddInstruction(
+      HloInstruction::CreateCopyStart(
+          ShapeUtil::MakeTupleShape({device_shape, host_shape, context_shape}),
+          to_host_done),
+      /*new_name=*/best->name() + ".remat_reload_start");
+  HloInstruction* from_host_done = computation->AddInstruction(
+      HloInstruction::CreateUnary(device_shape, HloOpcode::kCopyDone,
+                                  from_host_start),
+      /*new_name=*/best->name() + ".remat_reload_done");
+
+  Item* to_host_start_item = instruction_list->CreateItem(to_host_start);
+  to_host_start_item->placed = true;
+  Item* to_host_done_item = instruction_list->CreateItem(to_host_done);
+  to_host_done_item->placed = true;
+  Item* from_host_start_item = instruction_list->CreateItem(from_host_start);
+  Item* from_host_done_item = instruction_list->CreateItem(from_host_done);
+
+  // Replace each remaining use of 'best' with the copy back.
+  std::vector<HloInstruction*> best_users_copy = best->users();
+  for (HloInstruction* user : best_users_copy) {
+    if (!memory_tracker->IsPlaced(user)) {
+      VLOG(5) << "  Replacing use of " << best->name() << " in " << user->name()
+              << " with " << from_host_done->name();
+      TF_RETURN_IF_ERROR(best->ReplaceUseWith(user, from_host_done));
+    }
+  }
+
+  // Account for the offload in the memory tracker.
+  TF_RETURN_IF_ERROR(memory_tracker->AddHostOffloadInstructions(
+      best_item, to_host_start_item, to_host_done_item, from_host_start_item,
+      from_host_done_item));
+
+  ItemList place_before;
+  for (auto user : from_host_done->users()) {
+    place_before.push_back(instruction_list->GetItem(user));
+  }
+
+  for (Item* item : {to_host_start_item, to_host_done_item,
+                     from_host_start_item, from_host_done_item}) {
+    instruction_list->Denylist(item->instruction);
+  }
+
+  instruction_list->InsertBeforeInstructions(from_host_done_item,
+                                             place_before);
+  // Overlap the copy back with the instruction before the earliest use if
+  // that instruction has not been placed yet.
+  Item* previous = instruction_list->prev(from_host_done_item);
+  if (previous != nullptr && !previous->placed) {
+    instruction_list->InsertBeforeInstructions(from_host_start_item,
+                                               {previous});
+  } else {
+    instruction_list->InsertBeforeInstructions(from_host_start_item,
+                                               {from_host_done_item});
+  }
+  instruction_list->InsertBeforeInstructions(
+      to_host_done_item, {memory_tracker->in_progress_item()});
+  instruction_list->InsertAfterInstructions(to_host_start_item, {best_item});
+
+  return 4;
+}
+
 // A simple struct to encapsulate the number of instructions added during
 // rematerialization.
 struct InstructionsAdded {
@@ -1793,6 +2108,18 @@ StatusOr<InstructionsAdded> RematerializeBestBlock(
         num_instructions_added.net_instructions_added,
         CompressInstruction(memory_tracker, best_items[0],
                             best_strategy.compact_shape, instruction_list));
+  } else if (best_strategy.kind == RematStrategy::kHostOffload) {
+    CHECK(best_items.size() == 1)
+        << "More than one instruction offloaded simultaneously.";
+    HloInstruction* best = best_items[0]->instruction;
+    VLOG(1) << "Offloading instruction " << best->name() << " (saving "
+            << HumanReadableNumBytes(
+                   memory_tracker->MemoryReducedIfOffloaded(best_items[0]))
+            << ")";
+
+    TF_ASSIGN_OR_RETURN(
+        num_instructions_added.net_instructions_added,
+        OffloadInstruction(memory_tracker, best_items[0], instruction_list));
   } else {
     TF_ASSIGN_OR_RETURN(
         num_instructions_added.net_instructions_added,
@@ -1809,7 +2136,10 @@ StatusOr<int64_t> HloRematerialization::ComputePeakMemory(
   InstructionList instruction_list(order);
   MemoryUsageTracker tracker(computation, size_function_,
                              compact_shape_function_, *points_to_analysis_,
-                             instruction_list, mode_);
+                             instruction_list, mode_,
+                             host_offload_config_ ? &*host_offload_config_
+                                                  : nullptr,
+                             cost_analysis_.get());
   int64_t peak_memory = tracker.memory_usage();
   for (auto* item = instruction_list.first(); item != nullptr;
        item = instruction_list.next(item)) {
@@ -1853,7 +2183,9 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
   InstructionList instruction_list(schedule->sequence(computation));
   MemoryUsageTracker memory_tracker(
       computation, size_function_, compact_shape_function_,
-      *points_to_analysis_, instruction_list, mode_);
+      *points_to_analysis_, instruction_list, mode_,
+      host_offload_config_ ? &*host_offload_config_ : nullptr,
+      cost_analysis_.get());
 
   instruction_list.PromoteNodesToSkip([&](Item* item) {
     return memory_tracker.AllocatedSize(item) >= min_remat_size;
@@ -2044,6 +2376,13 @@ StatusOr<bool> HloRematerialization::Run(HloModule* module) {
 
   TF_RET_CHECK(module->has_schedule());
   TF_ASSIGN_OR_RETURN(points_to_analysis_, TuplePointsToAnalysis::Run(module));
+  cost_analysis_.reset();
+  if (host_offload_config_.has_value()) {
+    cost_analysis_ = absl::make_unique<HloCostAnalysis>(size_function_);
+    for (HloComputation* computation : module->MakeNonfusionComputations()) {
+      TF_RETURN_IF_ERROR(computation->Accept(cost_analysis_.get()));
+    }
+  }
 
   // Adjust memory limit to account for the output of the entry
   // computation. This is necessary because the per-computation accounting in
@@ -17,8 +17,10 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/call_graph.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -65,6 +67,28 @@ class HloRematerialization : public HloModulePass {
 
   static Shape DefaultCompactShapeFunction(const Shape& shape) { return shape; }
 
+  // Configures offloading to host memory. When set, a value that is live
+  // across the program point where memory use is too high can also be copied
+  // to host memory asynchronously after it is defined and copied back before
+  // its next use, in addition to the strategies selected by the
+  // RematerializationMode. All strategies are then ranked by the bytes they
+  // save per microsecond they are estimated to add to the run time, instead
+  // of by the bytes saved alone.
+  struct HostOffloadConfig {
+    // The memory space of the layouts of the values in host memory.
+    int64_t host_memory_space = 1;
+
+    // The bandwidths of the transfers between device and host memory.
+    float bandwidth_to_host_bytes_per_second = 1.2e10;
+    float bandwidth_from_host_bytes_per_second = 1.2e10;
+
+    // The rates used to estimate the run time of instructions: the time of
+    // the instructions that recomputation and compression add, and the time
+    // of the instructions that an offload to host memory overlaps with.
+    float flops_per_second = 1e13;
+    float device_bytes_per_second = 1e12;
+  };
+
   // Constructor parameters:
   //
   //   size_function: Function which returns the size in bytes of the top-level
@@ -80,13 +104,17 @@ class HloRematerialization : public HloModulePass {
   //
   //   compact_shape_function: Function which returns the compact form of a
   //   shape. If nullptr is provided, an default identity function is used.
+  //
+  //   host_offload_config: If set, values may also be offloaded to host
+  //     memory, see HostOffloadConfig.
   explicit HloRematerialization(
       const ShapeSizeFunction& size_function, int64_t memory_limit_bytes,
       RematerializationSizes* sizes, RematerializationPass pass_location,
       int block_size_limit, int block_rematerialization_factor,
       CompactShapeFunction compact_shape_function = nullptr,
       RematerializationMode mode = RematerializationMode::kRecomputeAndCompress,
-      int64_t min_remat_size = 0)
+      int64_t min_remat_size = 0,
+      absl::optional<HostOffloadConfig> host_offload_config = absl::nullopt)
       : size_function_(size_function),
         memory_limit_bytes_(memory_limit_bytes),
         sizes_(sizes),
@@ -97,7 +125,8 @@ class HloRematerialization : public HloModulePass {
                                     ? DefaultCompactShapeFunction
                                     : std::move(compact_shape_function)),
         mode_(mode),
-        min_remat_size_(min_remat_size) {}
+        min_remat_size_(min_remat_size),
+        host_offload_config_(std::move(host_offload_config)) {}
   ~HloRematerialization() override = default;
 
   absl::string_view name() const override { return "rematerialization"; }
@@ -197,6 +226,11 @@ class HloRematerialization : public HloModulePass {
   RematerializationMode mode_;
 
   int64_t min_remat_size_;
+
+  absl::optional<HostOffloadConfig> host_offload_config_;
+
+  // Estimates the run time of instructions when host_offload_config_ is set.
+  std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
 }  // namespace xla
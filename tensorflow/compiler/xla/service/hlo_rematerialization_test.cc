@@ -18,6 +18,8 @@ limitations under the License.
 #include <memory>
 #include <string>
 
+#include "absl/algorithm/container.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
@@ -747,6 +749,108 @@ ENTRY %entry {
               op::Reduce(op::Copy(op::Copy(broadcast)), op::Constant()));
 }
 
+constexpr int64_t kHostMemorySpace = 5;
+
+// The dot is live across the peak at negate and can either be recomputed or
+// offloaded to host memory.
+constexpr char kOffloadHloString[] = R"(
+HloModule fusion, is_scheduled=true
+
+%add_float {
+  %x = f32[] parameter(0)
+  %y = f32[] parameter(1)
+  ROOT %add = f32[] add(f32[] %x, f32[] %y)
+}
+
+ENTRY %entry {
+  %param.0 = f32[64,64]{1,0} parameter(0)
+  %param.1 = f32[64,64]{1,0} parameter(1)
+  %constant = f32[] constant(0)
+  %dot = f32[64,64]{1,0} dot(%param.0, %param.1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  %reduce.0 = f32[] reduce(%dot, %constant), dimensions={1, 0}, to_apply=%add_float
+  %negate = f32[64,64]{1,0} negate(%param.0)
+  %reduce.1 = f32[] reduce(%negate, %constant), dimensions={1, 0}, to_apply=%add_float
+  %add.0 = f32[] add(%reduce.0, %reduce.1)
+  %reduce.2 = f32[] reduce(%dot, %constant), dimensions={1, 0}, to_apply=%add_float
+  ROOT %add.1 = f32[] add(%add.0, %reduce.2)
+}
+)";
+
+class HostOffloadRematerializationTest : public RematerializationTestBase {
+ protected:
+  StatusOr<bool> RunHloRematerialization(
+      int64_t memory_limit_bytes, HloModule* module,
+      const HloRematerialization::HostOffloadConfig& config) {
+    TF_EXPECT_OK(verifier().Run(module).status());
+    HloRematerialization remat(
+        ByteSizeOf, memory_limit_bytes,
+        /*sizes=*/nullptr,
+        HloRematerialization::RematerializationPass::kPreFusion,
+        /*block_size_limit=*/1, /*block_rematerialization_factor=*/1, nullptr,
+        HloRematerialization::RematerializationMode::kRecomputeOnly,
+        /*min_remat_size=*/0, config);
+    TF_ASSIGN_OR_RETURN(bool changed, remat.Run(module));
+    TF_EXPECT_OK(verifier().Run(module).status());
+    return changed;
+  }
+};
+
+TEST_F(HostOffloadRematerializationTest, RecomputesWhenCheaperThanOffload) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kOffloadHloString));
+  HloRematerialization::HostOffloadConfig config;
+  config.host_memory_space = kHostMemorySpace;
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunHloRematerialization(
+                              /*memory_limit_bytes=*/20 * 1024, module.get(),
+                              config));
+  EXPECT_TRUE(changed);
+  HloInstruction* reduce =
+      module->entry_computation()->GetInstructionWithName("reduce.2");
+  EXPECT_THAT(reduce,
+              op::Reduce(op::Dot(op::Parameter(0), op::Parameter(1)), _));
+  EXPECT_NE(reduce->operand(0)->name(), "dot");
+}
+
+TEST_F(HostOffloadRematerializationTest, OffloadsWhenRecomputeIsExpensive) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kOffloadHloString));
+  HloRematerialization::HostOffloadConfig config;
+  config.host_memory_space = kHostMemorySpace;
+  config.flops_per_second = 1e6;
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunHloRematerialization(
+                              /*memory_limit_bytes=*/20 * 1024, module.get(),
+                              config));
+  EXPECT_TRUE(changed);
+  HloComputation* entry = module->entry_computation();
+  HloInstruction* dot = entry->GetInstructionWithName("dot");
+  HloInstruction* reduce = entry->GetInstructionWithName("reduce.2");
+  EXPECT_THAT(reduce,
+              op::Reduce(op::AsyncCopy(0, kHostMemorySpace,
+                                       op::AsyncCopy(kHostMemorySpace, 0, dot)),
+                         _));
+
+  // The copy to host memory overlaps with the rest of the dot's uses and the
+  // copy back with the instruction before its next use.
+  const HloInstructionSequence& sequence =
+      module->schedule().sequence(entry);
+  auto position = [&](absl::string_view name) {
+    return absl::c_find_if(sequence.instructions(),
+                           [&](const HloInstruction* instruction) {
+                             return instruction->name() == name;
+                           }) -
+           sequence.instructions().begin();
+  };
+  EXPECT_LT(position("dot.remat_offload_start"), position("reduce.0"));
+  EXPECT_LT(position("reduce.0"), position("dot.remat_offload_done"));
+  EXPECT_LT(position("dot.remat_offload_done"), position("negate"));
+  EXPECT_LT(position("dot.remat_reload_start"), position("add.0"));
+  EXPECT_LT(position("add.0"), position("dot.remat_reload_done"));
+}
+
 // Test rematerialization of values through bitcasts
 // Its expected that the broadcast gets rematerialized
 TEST_F(HloRematerializationTest, ThroughBitcastRemat) {
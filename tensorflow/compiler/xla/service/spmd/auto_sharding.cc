@@ -0,0 +1,442 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/array.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace spmd {
+
+namespace {
+
+// A way to shard an instruction: the sharding of its output and the shardings
+// it requires of its operands.
+struct Strategy {
+  HloSharding output;
+  // Indexed by operand number. Operands without a required sharding are
+  // absl::nullopt.
+  std::vector<absl::optional<HloSharding>> operands;
+  // The estimated run time of the instruction with this strategy, in seconds.
+  double seconds;
+};
+
+class StrategyBuilder {
+ public:
+  StrategyBuilder(const AutoShardingOptions& options,
+                  const HloCostAnalysis& cost_analysis)
+      : options_(options), cost_analysis_(cost_analysis) {}
+
+  // Returns the candidate strategies of `instruction`, or an empty vector if
+  // the instruction is left to sharding propagation.
+  std::vector<Strategy> Build(const HloInstruction* instruction) const {
+    const Shape& shape = instruction->shape();
+    if (!shape.IsArray()) {
+      return {};
+    }
+    if (instruction->has_sharding()) {
+      return {Strategy{instruction->sharding(),
+                       std::vector<absl::optional<HloSharding>>(
+                           instruction->operand_count()),
+                       0}};
+    }
+    switch (instruction->opcode()) {
+      case HloOpcode::kParameter:
+      case HloOpcode::kConstant:
+        return Tilings(instruction, /*follow_operands=*/false);
+      case HloOpcode::kDot:
+        return DotStrategies(instruction);
+      case HloOpcode::kConvolution:
+        return ConvolutionStrategies(instruction);
+      default:
+        if (instruction->IsElementwise()) {
+          return Tilings(instruction, /*follow_operands=*/true);
+        }
+        return {};
+    }
+  }
+
+ private:
+  // Returns a sharding which tiles `dim` of `shape` across all devices.
+  HloSharding TileOnDim(const Shape& shape, int64_t dim) const {
+    std::vector<int64_t> tile_dims(shape.rank(), 1);
+    tile_dims[dim] = options_.num_devices;
+    Array<int64_t> tile_assignment(tile_dims);
+    tile_assignment.FillIota(0);
+    return HloSharding::Tile(tile_assignment);
+  }
+
+  bool CanTile(const Shape& shape, int64_t dim) const {
+    return shape.dimensions(dim) % options_.num_devices == 0;
+  }
+
+  double ComputeSeconds(const HloInstruction* instruction,
+                        bool partitioned) const {
+    double seconds =
+        cost_analysis_.flop_count(*instruction) / options_.flops_per_second;
+    return partitioned ? seconds / options_.num_devices : seconds;
+  }
+
+  // The strategies which replicate the instruction or tile one of its
+  // dimensions. If `follow_operands` is true, operands of the same shape are
+  // required to have the same sharding.
+  std::vector<Strategy> Tilings(const HloInstruction* instruction,
+                                bool follow_operands) const {
+    const Shape& shape = instruction->shape();
+    std::vector<HloSharding> shardings = {HloSharding::Replicate()};
+    for (int64_t dim = 0; dim < shape.rank(); ++dim) {
+      if (CanTile(shape, dim)) {
+        shardings.push_back(TileOnDim(shape, dim));
+      }
+    }
+    std::vector<Strategy> strategies;
+    for (const HloSharding& sharding : shardings) {
+      Strategy strategy{sharding, {}, 0};
+      for (const HloInstruction* operand : instruction->operands()) {
+        if (follow_operands &&
+            ShapeUtil::SameDimensions(operand->shape(), shape)) {
+          strategy.operands.push_back(sharding);
+        } else {
+          strategy.operands.push_back(absl::nullopt);
+        }
+      }
+      strategies.push_back(std::move(strategy));
+    }
+    return strategies;
+  }
+
+  // Partitions the dimensions `lhs_dim` and `rhs_dim` of the two operands. If
+  // `output_dim` is absl::nullopt, the outputs of all devices are partial sums
+  // which are combined by an all-reduce.
+  Strategy PartitionedStrategy(const HloInstruction* instruction,
+                               int64_t lhs_dim, int64_t rhs_dim,
+                               absl::optional<int64_t> output_dim) const {
+    const Shape& lhs_shape = instruction->operand(0)->shape();
+    const Shape& rhs_shape = instruction->operand(1)->shape();
+    Strategy strategy{HloSharding::Replicate(),
+                      {absl::nullopt, absl::nullopt},
+                      ComputeSeconds(instruction, /*partitioned=*/true)};
+    strategy.operands[0] = lhs_dim < 0 ? HloSharding::Replicate()
+                                       : TileOnDim(lhs_shape, lhs_dim);
+    strategy.operands[1] = rhs_dim < 0 ? HloSharding::Replicate()
+                                       : TileOnDim(rhs_shape, rhs_dim);
+    if (output_dim.has_value()) {
+      strategy.output = TileOnDim(instruction->shape(), *output_dim);
+    } else {
+      const double bytes = ShapeUtil::ByteSizeOf(instruction->shape());
+      const int64_t n = options_.num_devices;
+      strategy.seconds += options_.collective_latency_seconds +
+                          2 * bytes * (n - 1) / n /
+                              options_.interconnect_bytes_per_second;
+    }
+    return strategy;
+  }
+
+  Strategy ReplicatedStrategy(const HloInstruction* instruction) const {
+    return Strategy{HloSharding::Replicate(),
+                    {HloSharding::Replicate(), HloSharding::Replicate()},
+                    ComputeSeconds(instruction, /*partitioned=*/false)};
+  }
+
+  std::vector<Strategy> DotStrategies(const HloInstruction* dot) const {
+    const DotDimensionNumbers& dnums = dot->dot_dimension_numbers();
+    const Shape& lhs_shape = dot->operand(0)->shape();
+    const Shape& rhs_shape = dot->operand(1)->shape();
+    std::vector<Strategy> strategies = {ReplicatedStrategy(dot)};
+
+    // The output holds the batch dimensions, then the non-contracting
+    // dimensions of the lhs, then those of the rhs.
+    int64_t output_dim = 0;
+    for (int64_t i = 0; i < dnums.lhs_batch_dimensions_size(); ++i) {
+      const int64_t lhs_dim = dnums.lhs_batch_dimensions(i);
+      const int64_t rhs_dim = dnums.rhs_batch_dimensions(i);
+      if (CanTile(lhs_shape, lhs_dim)) {
+        strategies.push_back(
+            PartitionedStrategy(dot, lhs_dim, rhs_dim, output_dim));
+      }
+      ++output_dim;
+    }
+    for (int64_t lhs_dim = 0; lhs_dim < lhs_shape.rank(); ++lhs_dim) {
+      if (absl::c_linear_search(dnums.lhs_batch_dimensions(), lhs_dim) ||
+          absl::c_linear_search(dnums.lhs_contracting_dimensions(), lhs_dim)) {
+        continue;
+      }
+      if (CanTile(lhs_shape, lhs_dim)) {
+        strategies.push_back(
+            PartitionedStrategy(dot, lhs_dim, /*rhs_dim=*/-1, output_dim));
+      }
+      ++output_dim;
+    }
+    for (int64_t rhs_dim = 0; rhs_dim < rhs_shape.rank(); ++rhs_dim) {
+      if (absl::c_linear_search(dnums.rhs_batch_dimensions(), rhs_dim) ||
+          absl::c_linear_search(dnums.rhs_contracting_dimensions(), rhs_dim)) {
+        continue;
+      }
+      if (CanTile(rhs_shape, rhs_dim)) {
+        strategies.push_back(
+            PartitionedStrategy(dot, /*lhs_dim=*/-1, rhs_dim, output_dim));
+      }
+      ++output_dim;
+    }
+    for (int64_t i = 0; i < dnums.lhs_contracting_dimensions_size(); ++i) {
+      const int64_t lhs_dim = dnums.lhs_contracting_dimensions(i);
+      if (CanTile(lhs_shape, lhs_dim)) {
+        strategies.push_back(PartitionedStrategy(
+            dot, lhs_dim, dnums.rhs_contracting_dimensions(i), absl::nullopt));
+      }
+    }
+    return strategies;
+  }
+
+  std::vector<Strategy> ConvolutionStrategies(
+      const HloInstruction* conv) const {
+    std::vector<Strategy> strategies = {ReplicatedStrategy(conv)};
+    if (conv->feature_group_count() != 1 || conv->batch_group_count() != 1) {
+      return strategies;
+    }
+    const ConvolutionDimensionNumbers& dnums =
+        conv->convolution_dimension_numbers();
+    const Shape& lhs_shape = conv->operand(0)->shape();
+    const Shape& rhs_shape = conv->operand(1)->shape();
+    if (CanTile(lhs_shape, dnums.input_batch_dimension())) {
+      strategies.push_back(PartitionedStrategy(
+          conv, dnums.input_batch_dimension(), /*rhs_dim=*/-1,
+          dnums.output_batch_dimension()));
+    }
+    if (CanTile(rhs_shape, dnums.kernel_output_feature_dimension())) {
+      strategies.push_back(PartitionedStrategy(
+          conv, /*lhs_dim=*/-1, dnums.kernel_output_feature_dimension(),
+          dnums.output_feature_dimension()));
+    }
+    if (CanTile(lhs_shape, dnums.input_feature_dimension())) {
+      strategies.push_back(PartitionedStrategy(
+          conv, dnums.input_feature_dimension(),
+          dnums.kernel_input_feature_dimension(), absl::nullopt));
+    }
+    return strategies;
+  }
+
+  const AutoShardingOptions& options_;
+  const HloCostAnalysis& cost_analysis_;
+};
+
+// Returns the estimated time of the collectives needed to turn a value of
+// `shape` sharded as `from` into one sharded as `to`.
+double ReshardSeconds(const Shape& shape, const HloSharding& from,
+                      const HloSharding& to,
+                      const AutoShardingOptions& options) {
+  if (from == to) {
+    return 0;
+  }
+  if (from.IsReplicated()) {
+    // Every device slices its tile locally.
+    return 0;
+  }
+  const double bytes = ShapeUtil::ByteSizeOf(shape);
+  const int64_t n = options.num_devices;
+  if (to.IsReplicated()) {
+    // All-gather.
+    return options.collective_latency_seconds +
+           bytes * (n - 1) / n / options.interconnect_bytes_per_second;
+  }
+  // All-to-all.
+  return options.collective_latency_seconds +
+         bytes * (n - 1) / (n * n) / options.interconnect_bytes_per_second;
+}
+
+}  // namespace
+
+StatusOr<bool> AutoSharding::Run(HloModule* module) {
+  if (options_.num_devices <= 1) {
+    return false;
+  }
+  HloComputation* entry = module->entry_computation();
+  HloCostAnalysis cost_analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  TF_RETURN_IF_ERROR(entry->Accept(&cost_analysis));
+
+  StrategyBuilder builder(options_, cost_analysis);
+  std::vector<HloInstruction*> nodes;
+  absl::flat_hash_map<const HloInstruction*, std::vector<Strategy>> strategies;
+  for (HloInstruction* instruction : entry->MakeInstructionPostOrder()) {
+    std::vector<Strategy> candidates = builder.Build(instruction);
+    if (!candidates.empty()) {
+      nodes.push_back(instruction);
+      strategies[instruction] = std::move(candidates);
+    }
+  }
+
+  // The time of resharding `operand` from the given strategy to the sharding
+  // `required` by one of its users.
+  auto reshard_seconds = [&](const HloInstruction* operand,
+                             const Strategy& strategy,
+                             const HloSharding& required) {
+    return ReshardSeconds(operand->shape(), strategy.output, required,
+                          options_);
+  };
+  // Picks the strategy of `instruction` with the lowest cost. Ties are broken
+  // in favor of strategies which keep fewer bytes per device.
+  auto pick = [&](const HloInstruction* instruction,
+                  const std::function<double(const Strategy&)>& cost) {
+    const std::vector<Strategy>& candidates = strategies.at(instruction);
+    int64_t best = 0;
+    double best_cost = cost(candidates[0]);
+    for (int64_t i = 1; i < candidates.size(); ++i) {
+      const double candidate_cost = cost(candidates[i]);
+      if (candidate_cost < best_cost ||
+          (candidate_cost == best_cost &&
+           candidates[best].output.IsReplicated() &&
+           !candidates[i].output.IsReplicated())) {
+        best = i;
+        best_cost = candidate_cost;
+      }
+    }
+    return best;
+  };
+
+  // Computes, in post order, the cost of the subgraph below every instruction
+  // for each of its strategies, as if no operand was shared between users.
+  // This is exact for trees.
+  absl::flat_hash_map<const HloInstruction*, std::vector<double>> subgraph_cost;
+  for (const HloInstruction* instruction : nodes) {
+    std::vector<double>& costs = subgraph_cost[instruction];
+    for (const Strategy& strategy : strategies.at(instruction)) {
+      double seconds = strategy.seconds;
+      for (int64_t i = 0; i < instruction->operand_count(); ++i) {
+        const HloInstruction* operand = instruction->operand(i);
+        if (!strategy.operands[i].has_value() ||
+            !strategies.contains(operand)) {
+          continue;
+        }
+        const std::vector<Strategy>& operand_strategies =
+            strategies.at(operand);
+        double best = std::numeric_limits<double>::infinity();
+        for (int64_t j = 0; j < operand_strategies.size(); ++j) {
+          best = std::min(best, subgraph_cost.at(operand)[j] +
+                                    reshard_seconds(operand,
+                                                    operand_strategies[j],
+                                                    *strategy.operands[i]));
+        }
+        seconds += best;
+      }
+      costs.push_back(seconds);
+    }
+  }
+
+  // Picks strategies in reverse post order, so that the strategies of all
+  // users of an instruction are known when it is picked.
+  absl::flat_hash_map<const HloInstruction*, int64_t> chosen;
+  auto chosen_strategy = [&](const HloInstruction* instruction) {
+    return &strategies.at(instruction)[chosen.at(instruction)];
+  };
+  auto users_seconds = [&](const HloInstruction* instruction,
+                           const Strategy& strategy) {
+    double seconds = 0;
+    for (const HloInstruction* user : instruction->users()) {
+      if (!chosen.contains(user)) {
+        continue;
+      }
+      const Strategy* user_strategy = chosen_strategy(user);
+      for (int64_t i : user->OperandIndices(instruction)) {
+        if (user_strategy->operands[i].has_value()) {
+          seconds += reshard_seconds(instruction, strategy,
+                                     *user_strategy->operands[i]);
+        }
+      }
+    }
+    return seconds;
+  };
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    const HloInstruction* instruction = *it;
+    const std::vector<Strategy>& candidates = strategies.at(instruction);
+    const std::vector<double>& costs = subgraph_cost.at(instruction);
+    chosen[instruction] = pick(instruction, [&](const Strategy& strategy) {
+      return costs[&strategy - candidates.data()] +
+             users_seconds(instruction, strategy);
+    });
+  }
+
+  // Shared operands make the picks above approximate. Revisit every
+  // instruction with the strategies of its operands and users fixed until no
+  // pick changes. Every change lowers the total cost, or keeps it and lowers
+  // the bytes per device.
+  auto local_seconds = [&](const HloInstruction* instruction,
+                           const Strategy& strategy) {
+    double seconds = strategy.seconds + users_seconds(instruction, strategy);
+    for (int64_t i = 0; i < instruction->operand_count(); ++i) {
+      const HloInstruction* operand = instruction->operand(i);
+      if (strategy.operands[i].has_value() && chosen.contains(operand)) {
+        seconds += reshard_seconds(operand, *chosen_strategy(operand),
+                                   *strategy.operands[i]);
+      }
+    }
+    return seconds;
+  };
+  for (int64_t iteration = 0;
+       iteration < options_.max_refinement_iterations; ++iteration) {
+    bool changed = false;
+    for (const HloInstruction* instruction : nodes) {
+      const std::vector<Strategy>& candidates = strategies.at(instruction);
+      const int64_t best =
+          pick(instruction, [&](const Strategy& strategy) {
+            return local_seconds(instruction, strategy);
+          });
+      const Strategy& current = *chosen_strategy(instruction);
+      const double best_seconds =
+          local_seconds(instruction, candidates[best]);
+      const double current_seconds = local_seconds(instruction, current);
+      if (best_seconds < current_seconds ||
+          (best_seconds == current_seconds && current.output.IsReplicated() &&
+           !candidates[best].output.IsReplicated())) {
+        chosen[instruction] = best;
+        changed = true;
+      }
+    }
+    VLOG(2) << "Auto-sharding refinement iteration " << iteration
+            << (changed ? " changed strategies" : " converged");
+    if (!changed) {
+      break;
+    }
+  }
+
+  bool changed = false;
+  for (HloInstruction* instruction : nodes) {
+    if (instruction->has_sharding()) {
+      continue;
+    }
+    VLOG(2) << "Auto-sharding " << instruction->name() << " as "
+            << chosen_strategy(instruction)->output.ToString();
+    instruction->set_sharding(chosen_strategy(instruction)->output);
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace spmd
+}  // namespace xla
@@ -0,0 +1,79 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace spmd {
+
+struct AutoShardingOptions {
+  // The number of devices in the one-dimensional device mesh that shardings
+  // are searched for.
+  int64_t num_devices = 1;
+
+  // The rates used to estimate the run time of a sharding strategy.
+  double flops_per_second = 1e14;
+  double interconnect_bytes_per_second = 1e11;
+  double collective_latency_seconds = 1e-5;
+
+  // The maximum number of passes over the graph that refine the initial
+  // assignment of strategies.
+  int64_t max_refinement_iterations = 10;
+};
+
+// Picks shardings for the instructions of the entry computation that have no
+// sharding yet, so that the SPMD partitioner can run without hand-written
+// annotations.
+//
+// Every parameter, constant, elementwise instruction, dot and convolution gets
+// a set of candidate strategies: replicated, or tiled along one dimension
+// across all devices. The strategies of dots and convolutions also fix how
+// their operands must be sharded, and partitioning a contracting dimension
+// adds an all-reduce. A strategy costs its estimated compute time plus the
+// time of the collectives that reshard its operands from the strategies
+// picked for them.
+//
+// The search is a dynamic program over the graph which is exact if no value
+// has more than one user: it computes the cheapest cost of the subgraph below
+// each instruction for each of its strategies in post order, then picks
+// strategies in reverse post order. Shared operands are then reconciled by
+// revisiting each instruction with the strategies of its operands and users
+// fixed until no pick changes. Existing shardings are kept and constrain the
+// search.
+//
+// Instructions without candidate strategies are left unsharded, so
+// ShardingPropagation should run after this pass.
+class AutoSharding : public HloModulePass {
+ public:
+  explicit AutoSharding(const AutoShardingOptions& options)
+      : options_(options) {}
+  ~AutoSharding() override = default;
+
+  absl::string_view name() const override { return "auto-sharding"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  AutoShardingOptions options_;
+};
+
+}  // namespace spmd
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_SPMD_AUTO_SHARDING_H_
@@ -0,0 +1,127 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/spmd/auto_sharding.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace spmd {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+class AutoShardingTest : public HloTestBase {
+ protected:
+  StatusOr<bool> RunAutoSharding(HloModule* module,
+                                 int64_t num_devices = 4) {
+    AutoShardingOptions options;
+    options.num_devices = num_devices;
+    return AutoSharding(options).Run(module);
+  }
+};
+
+TEST_F(AutoShardingTest, FollowsShardedUserOfDot) {
+  absl::string_view hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[1024,256] parameter(0)
+  w = f32[256,256] parameter(1)
+  bias = f32[1024,256] parameter(2), sharding={devices=[4,1]0,1,2,3}
+  dot = f32[1024,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  ROOT add = f32[1024,256] add(dot, bias)
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get()));
+  EXPECT_TRUE(changed);
+  // Data parallelism: the batch dimension is partitioned and the weight is
+  // replicated.
+  EXPECT_THAT(FindInstruction(module.get(), "x"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "w"), op::Sharding("{replicated}"));
+  EXPECT_THAT(FindInstruction(module.get(), "dot"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "add"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+}
+
+TEST_F(AutoShardingTest, FollowsShardedWeight) {
+  absl::string_view hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[1024,256] parameter(0)
+  w = f32[256,256] parameter(1), sharding={devices=[1,4]0,1,2,3}
+  ROOT dot = f32[1024,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get()));
+  EXPECT_TRUE(changed);
+  // Partitioning the non-contracting dimension of the weight needs no
+  // collective.
+  EXPECT_THAT(FindInstruction(module.get(), "x"), op::Sharding("{replicated}"));
+  EXPECT_THAT(FindInstruction(module.get(), "w"),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "dot"),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+}
+
+TEST_F(AutoShardingTest, ShardsContractingDimensionOfShardedOperands) {
+  absl::string_view hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[16,4096] parameter(0), sharding={devices=[1,4]0,1,2,3}
+  w = f32[4096,16] parameter(1), sharding={devices=[4,1]0,1,2,3}
+  ROOT dot = f32[16,16] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get()));
+  EXPECT_TRUE(changed);
+  // All-reducing the small output is cheaper than gathering either operand.
+  EXPECT_THAT(FindInstruction(module.get(), "dot"),
+              op::Sharding("{replicated}"));
+}
+
+TEST_F(AutoShardingTest, NoChangeForSingleDevice) {
+  absl::string_view hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  x = f32[1024,256] parameter(0)
+  w = f32[256,256] parameter(1)
+  ROOT dot = f32[1024,256] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunAutoSharding(module.get(), /*num_devices=*/1));
+  EXPECT_FALSE(changed);
+  EXPECT_FALSE(FindInstruction(module.get(), "dot")->has_sharding());
+}
+
+}  // namespace
+}  // namespace spmd
+}  // namespace xla
@@ -0,0 +1,308 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/while_loop_all_reduce_pipeliner.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/call_graph.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_instructions.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_query.h"
+#include "tensorflow/compiler/xla/service/while_loop_analysis.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+
+namespace xla {
+
+namespace {
+
+// An all-reduce in a while body whose result is the element `tuple_index` of
+// the root tuple and is not used otherwise.
+struct PipelinedAllReduce {
+  int64_t tuple_index;
+  HloInstruction* all_reduce;
+};
+
+// Peeling clones the body into the computation of the loop, which is only
+// done for bodies without control flow or channels that have to be paired.
+bool CanPeel(const HloComputation* body) {
+  for (const HloInstruction* instruction : body->instructions()) {
+    switch (instruction->opcode()) {
+      case HloOpcode::kCall:
+      case HloOpcode::kConditional:
+      case HloOpcode::kWhile:
+      case HloOpcode::kSend:
+      case HloOpcode::kSendDone:
+      case HloOpcode::kRecv:
+      case HloOpcode::kRecvDone:
+        return false;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+// Returns the tuple indices of the loop state that `computation` reads, or
+// nullopt if it does not only read the state through get-tuple-elements.
+absl::optional<absl::flat_hash_set<int64_t>> ReadTupleIndices(
+    const HloComputation* computation) {
+  absl::flat_hash_set<int64_t> indices;
+  for (const HloInstruction* user :
+       computation->parameter_instruction(0)->users()) {
+    if (user->opcode() != HloOpcode::kGetTupleElement) {
+      return absl::nullopt;
+    }
+    indices.insert(user->tuple_index());
+  }
+  return indices;
+}
+
+std::vector<PipelinedAllReduce> FindPipelinedAllReduces(
+    HloInstruction* while_instruction) {
+  HloComputation* body = while_instruction->while_body();
+  HloInstruction* root = body->root_instruction();
+  if (root->opcode() != HloOpcode::kTuple || !CanPeel(body) ||
+      !ReadTupleIndices(body).has_value()) {
+    return {};
+  }
+  absl::optional<absl::flat_hash_set<int64_t>> condition_indices =
+      ReadTupleIndices(while_instruction->while_condition());
+  if (!condition_indices.has_value()) {
+    return {};
+  }
+  std::vector<PipelinedAllReduce> pipelined;
+  for (int64_t i = 0; i < root->operand_count(); ++i) {
+    auto* all_reduce =
+        DynCast<HloAllReduceInstruction>(root->mutable_operand(i));
+    if (all_reduce == nullptr || all_reduce->operand_count() != 1 ||
+        !all_reduce->shape().IsArray() || all_reduce->constrain_layout() ||
+        all_reduce->user_count() != 1 ||
+        root->OperandIndices(all_reduce).size() != 1 ||
+        !all_reduce->control_predecessors().empty() ||
+        !all_reduce->control_successors().empty() ||
+        condition_indices->contains(i)) {
+      continue;
+    }
+    pipelined.push_back({i, all_reduce});
+  }
+  return pipelined;
+}
+
+// Clones `all_reduce` with a new operand, giving the clone a new channel id
+// if the all-reduce has one.
+HloInstruction* CloneAllReduce(HloInstruction* all_reduce,
+                               HloInstruction* operand,
+                               int64_t* next_channel_id) {
+  HloInstruction* clone = operand->parent()->AddInstruction(
+      all_reduce->CloneWithNewOperands(all_reduce->shape(), {operand}));
+  if (clone->channel_id().has_value()) {
+    clone->set_channel_id((*next_channel_id)++);
+  }
+  return clone;
+}
+
+// Clones the body of `while_instruction` in front of it as the first
+// iteration of the loop, which passes the operands of the pipelined
+// all-reduces on to the loop instead of their results.
+Status PeelFirstIteration(HloInstruction* while_instruction,
+                          const std::vector<PipelinedAllReduce>& pipelined,
+                          int64_t* next_channel_id) {
+  HloComputation* computation = while_instruction->parent();
+  HloComputation* body = while_instruction->while_body();
+  absl::flat_hash_map<const HloInstruction*, HloInstruction*> peeled;
+  peeled[body->parameter_instruction(0)] =
+      while_instruction->mutable_operand(0);
+  absl::flat_hash_set<const HloInstruction*> skipped;
+  for (const PipelinedAllReduce& all_reduce : pipelined) {
+    skipped.insert(all_reduce.all_reduce);
+  }
+
+  const std::vector<HloInstruction*> post_order =
+      body->MakeInstructionPostOrder();
+  for (HloInstruction* instruction : post_order) {
+    if (instruction->opcode() == HloOpcode::kParameter) {
+      continue;
+    }
+    if (skipped.contains(instruction)) {
+      peeled[instruction] = peeled.at(instruction->operand(0));
+      continue;
+    }
+    // Read the loop state from the tuple it is built with, which keeps the
+    // induction variable of the loop analyzable.
+    HloInstruction* state = peeled.at(instruction->operand(0));
+    if (instruction->opcode() == HloOpcode::kGetTupleElement &&
+        state->opcode() == HloOpcode::kTuple) {
+      peeled[instruction] =
+          state->mutable_operand(instruction->tuple_index());
+      continue;
+    }
+    std::vector<HloInstruction*> operands;
+    operands.reserve(instruction->operand_count());
+    for (const HloInstruction* operand : instruction->operands()) {
+      operands.push_back(peeled.at(operand));
+    }
+    HloInstruction* clone = computation->AddInstruction(
+        instruction->CloneWithNewOperands(instruction->shape(), operands));
+    if (clone->channel_id().has_value()) {
+      clone->set_channel_id((*next_channel_id)++);
+    }
+    peeled[instruction] = clone;
+  }
+  for (HloInstruction* instruction : post_order) {
+    if (instruction->opcode() == HloOpcode::kParameter) {
+      continue;
+    }
+    for (const HloInstruction* successor : instruction->control_successors()) {
+      TF_RETURN_IF_ERROR(peeled.at(instruction)->AddControlDependencyTo(
+          peeled.at(successor)));
+    }
+  }
+  return while_instruction->ReplaceOperandWith(
+      0, peeled.at(body->root_instruction()));
+}
+
+// Reduces the operands the loop passes on for the pipelined all-reduces after
+// the last iteration.
+Status AddLastAllReduces(HloInstruction* while_instruction,
+                         const std::vector<PipelinedAllReduce>& pipelined,
+                         int64_t* next_channel_id) {
+  HloComputation* computation = while_instruction->parent();
+  const std::vector<HloInstruction*> users = while_instruction->users();
+  const Shape& shape = while_instruction->shape();
+  std::vector<HloInstruction*> elements(shape.tuple_shapes_size());
+  for (int64_t i = 0; i < shape.tuple_shapes_size(); ++i) {
+    elements[i] =
+        computation->AddInstruction(HloInstruction::CreateGetTupleElement(
+            shape.tuple_shapes(i), while_instruction, i));
+  }
+  for (const PipelinedAllReduce& all_reduce : pipelined) {
+    elements[all_reduce.tuple_index] =
+        CloneAllReduce(all_reduce.all_reduce,
+                       elements[all_reduce.tuple_index], next_channel_id);
+  }
+  HloInstruction* tuple =
+      computation->AddInstruction(HloInstruction::CreateTuple(elements));
+  return while_instruction->ReplaceUsesWith(users, tuple);
+}
+
+// Moves the pipelined all-reduces of the body from the end of one iteration
+// to the reads of their results in the next one.
+Status RotateAllReduces(HloInstruction* while_instruction,
+                        const std::vector<PipelinedAllReduce>& pipelined) {
+  HloComputation* body = while_instruction->while_body();
+  HloInstruction* parameter = body->parameter_instruction(0);
+  HloInstruction* root = body->root_instruction();
+  absl::flat_hash_map<int64_t, std::vector<HloInstruction*>> reads;
+  for (HloInstruction* user : parameter->users()) {
+    reads[user->tuple_index()].push_back(user);
+  }
+  for (const PipelinedAllReduce& pipelined_all_reduce : pipelined) {
+    HloInstruction* all_reduce = pipelined_all_reduce.all_reduce;
+    const int64_t tuple_index = pipelined_all_reduce.tuple_index;
+    TF_RETURN_IF_ERROR(
+        root->ReplaceOperandWith(tuple_index, all_reduce->mutable_operand(0)));
+
+    auto it = reads.find(tuple_index);
+    if (it != reads.end()) {
+      HloInstruction* read =
+          body->AddInstruction(HloInstruction::CreateGetTupleElement(
+              all_reduce->shape(), parameter, tuple_index));
+      // The all-reduce keeps its channel id, since the original is removed.
+      HloInstruction* reduced = body->AddInstruction(
+          all_reduce->CloneWithNewOperands(all_reduce->shape(), {read}));
+      for (HloInstruction* old_read : it->second) {
+        TF_RETURN_IF_ERROR(old_read->ReplaceAllUsesWith(reduced));
+        TF_RETURN_IF_ERROR(body->RemoveInstruction(old_read));
+      }
+    }
+    TF_RETURN_IF_ERROR(body->RemoveInstruction(all_reduce));
+  }
+  return Status::OK();
+}
+
+Status UpdateKnownTripCount(HloInstruction* while_instruction) {
+  if (while_instruction->raw_backend_config_string().empty()) {
+    return Status::OK();
+  }
+  TF_ASSIGN_OR_RETURN(
+      WhileLoopBackendConfig config,
+      while_instruction->backend_config<WhileLoopBackendConfig>());
+  if (!config.has_known_trip_count()) {
+    return Status::OK();
+  }
+  config.mutable_known_trip_count()->set_n(config.known_trip_count().n() - 1);
+  return while_instruction->set_backend_config(config);
+}
+
+}  // namespace
+
+StatusOr<bool> WhileLoopAllReducePipeliner::Run(HloModule* module) {
+  // In case of MPMD, all-reduces might be cross-module and should preserve
+  // their channel ID, which cloning them would change.
+  if (module->config().num_partitions() > 1 &&
+      !module->config().use_spmd_partitioning()) {
+    return false;
+  }
+  std::unique_ptr<CallGraph> call_graph = CallGraph::Build(module);
+  std::vector<HloInstruction*> while_instructions;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      // The body is rewritten in place, so it can't be shared.
+      if (instruction->opcode() == HloOpcode::kWhile &&
+          instruction->shape().IsTuple() &&
+          call_graph->GetComputationCallers(instruction->while_body())
+                  .size() == 1) {
+        while_instructions.push_back(instruction);
+      }
+    }
+  }
+
+  bool changed = false;
+  int64_t next_channel_id = hlo_query::NextChannelId(*module);
+  for (HloInstruction* while_instruction : while_instructions) {
+    const std::vector<PipelinedAllReduce> pipelined =
+        FindPipelinedAllReduces(while_instruction);
+    if (pipelined.empty()) {
+      continue;
+    }
+    absl::optional<int64_t> trip_count =
+        ComputeWhileLoopTripCount(while_instruction);
+    if (!trip_count.has_value() || *trip_count < 2) {
+      VLOG(2) << "Not pipelining all-reduces in " << while_instruction->name()
+              << " without a known trip count of at least two.";
+      continue;
+    }
+    VLOG(1) << "Pipelining " << pipelined.size() << " all-reduces in "
+            << while_instruction->name();
+    TF_RETURN_IF_ERROR(
+        PeelFirstIteration(while_instruction, pipelined, &next_channel_id));
+    TF_RETURN_IF_ERROR(
+        AddLastAllReduces(while_instruction, pipelined, &next_channel_id));
+    TF_RETURN_IF_ERROR(RotateAllReduces(while_instruction, pipelined));
+    TF_RETURN_IF_ERROR(UpdateKnownTripCount(while_instruction));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace xla
@@ -0,0 +1,64 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_WHILE_LOOP_ALL_REDUCE_PIPELINER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_WHILE_LOOP_ALL_REDUCE_PIPELINER_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+// HLO pass that software-pipelines all-reduces across the back-edge of while
+// loops, so that the all-reduce of one iteration can overlap the computation
+// of the next one.
+//
+// An all-reduce is pipelined if its result is only passed to the next
+// iteration through the root tuple of the loop body and the loop condition
+// does not read it. The loop then carries the value before the all-reduce
+// instead, and the next iteration reduces it where it used to read the loop
+// state. The first iteration is peeled off the loop and a last all-reduce
+// runs after it, so the loop needs a known trip count of at least two.
+//
+// Pattern before this pass:
+// a = ...
+// while:
+//   b = f(a)
+//   a = all-reduce(b)
+// Pattern after this pass:
+// b = f(a)
+// while:
+//   a = all-reduce(b)
+//   b = f(a)
+// a = all-reduce(b)
+//
+// Within an iteration the all-reduce only has to finish before the first
+// instruction that reads its result, which lets the scheduler overlap it with
+// everything else in the body once it is made asynchronous.
+class WhileLoopAllReducePipeliner : public HloModulePass {
+ public:
+  WhileLoopAllReducePipeliner() = default;
+  ~WhileLoopAllReducePipeliner() override = default;
+
+  absl::string_view name() const override {
+    return "while-loop-all-reduce-pipeliner";
+  }
+  StatusOr<bool> Run(HloModule* module) override;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_WHILE_LOOP_ALL_REDUCE_PIPELINER_H_
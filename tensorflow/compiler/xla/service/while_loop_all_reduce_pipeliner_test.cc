@@ -0,0 +1,197 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/while_loop_all_reduce_pipeliner.h"
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_verifier.h"
+#include "tensorflow/compiler/xla/service/while_loop_analysis.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace {
+
+namespace op = ::xla::testing::opcode_matchers;
+
+class WhileLoopAllReducePipelinerTest : public HloTestBase {};
+
+TEST_F(WhileLoopAllReducePipelinerTest, PipelinesLoopCarriedAllReduce) {
+  constexpr absl::string_view kHloModule = R"(
+    HloModule pipelined_all_reduce
+
+    %reduction {
+      %x = f32[] parameter(0)
+      %y = f32[] parameter(1)
+      ROOT %add = f32[] add(f32[] %x, f32[] %y)
+    }
+
+    %while_condition {
+      %param = (s32[], f32[1024], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %trip_count = s32[] constant(4)
+      ROOT result = pred[] compare(%gte.0, %trip_count), direction=LT
+    }
+
+    %while_body {
+      %param = (s32[], f32[1024], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %gte.1 = f32[1024] get-tuple-element(%param), index=1
+      %gte.2 = f32[1024] get-tuple-element(%param), index=2
+      %gradient = f32[1024] multiply(f32[1024] %gte.1, f32[1024] %gte.2)
+      %all-reduce = f32[1024] all-reduce(f32[1024] %gradient), channel_id=1, replica_groups={{0,1,2,3}}, use_global_device_ids=true, to_apply=%reduction
+      %constant = s32[] constant(1)
+      %increment_iteration = s32[] add(s32[] %gte.0, s32[] %constant)
+      ROOT %loop_result = (s32[], f32[1024], f32[1024]) tuple(%increment_iteration, %all-reduce, %gte.2)
+    }
+
+    ENTRY pipelined_all_reduce {
+      %param.0 = f32[1024] parameter(0)
+      %param.1 = f32[1024] parameter(1)
+      %constant.0 = s32[] constant(0)
+      %while_init = (s32[], f32[1024], f32[1024]) tuple(s32[] %constant.0, f32[1024] %param.0, f32[1024] %param.1)
+      ROOT %while = (s32[], f32[1024], f32[1024]) while(%while_init), condition=%while_condition, body=%while_body
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(kHloModule));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          WhileLoopAllReducePipeliner{}.Run(module.get()));
+  ASSERT_TRUE(changed);
+  TF_ASSERT_OK(
+      HloVerifier(/*layout_sensitive=*/false, /*allow_mixed_precision=*/true)
+          .Run(module.get())
+          .status());
+
+  // The last all-reduce runs after the loop.
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root,
+              op::Tuple(op::GetTupleElement(op::While(), 0),
+                        op::AllReduce(op::GetTupleElement(op::While(), 1)),
+                        op::GetTupleElement(op::While(), 2)));
+  HloInstruction* while_instruction =
+      root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_EQ(root->operand(1)->channel_id(), 2);
+
+  // The first iteration is peeled and passes the gradient on to the loop.
+  EXPECT_THAT(while_instruction->operand(0),
+              op::Tuple(op::Add(op::Constant(), op::Constant()),
+                        op::Multiply(op::Parameter(0), op::Parameter(1)),
+                        op::Parameter(1)));
+  EXPECT_EQ(ComputeWhileLoopTripCount(while_instruction), 3);
+
+  // Each iteration reduces the gradient of the previous one.
+  EXPECT_THAT(
+      while_instruction->while_body()->root_instruction(),
+      op::Tuple(op::Add(),
+                op::Multiply(op::AllReduce(op::GetTupleElement(
+                                 op::Parameter(0), 1)),
+                             op::GetTupleElement(op::Parameter(0), 2)),
+                op::GetTupleElement(op::Parameter(0), 2)));
+}
+
+TEST_F(WhileLoopAllReducePipelinerTest, AllReduceUsedInBodyIsNotPipelined) {
+  constexpr absl::string_view kHloModule = R"(
+    HloModule all_reduce_used_in_body
+
+    %reduction {
+      %x = f32[] parameter(0)
+      %y = f32[] parameter(1)
+      ROOT %add = f32[] add(f32[] %x, f32[] %y)
+    }
+
+    %while_condition {
+      %param = (s32[], f32[1024], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %trip_count = s32[] constant(4)
+      ROOT result = pred[] compare(%gte.0, %trip_count), direction=LT
+    }
+
+    %while_body {
+      %param = (s32[], f32[1024], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %gte.1 = f32[1024] get-tuple-element(%param), index=1
+      %all-reduce = f32[1024] all-reduce(f32[1024] %gte.1), replica_groups={}, to_apply=%reduction
+      %scaled = f32[1024] multiply(f32[1024] %all-reduce, f32[1024] %all-reduce)
+      %constant = s32[] constant(1)
+      %increment_iteration = s32[] add(s32[] %gte.0, s32[] %constant)
+      ROOT %loop_result = (s32[], f32[1024], f32[1024]) tuple(%increment_iteration, %all-reduce, %scaled)
+    }
+
+    ENTRY all_reduce_used_in_body {
+      %param.0 = f32[1024] parameter(0)
+      %constant.0 = s32[] constant(0)
+      %while_init = (s32[], f32[1024], f32[1024]) tuple(s32[] %constant.0, f32[1024] %param.0, f32[1024] %param.0)
+      ROOT %while = (s32[], f32[1024], f32[1024]) while(%while_init), condition=%while_condition, body=%while_body
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(kHloModule));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          WhileLoopAllReducePipeliner{}.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(WhileLoopAllReducePipelinerTest, UnknownTripCountIsNotPipelined) {
+  constexpr absl::string_view kHloModule = R"(
+    HloModule unknown_trip_count
+
+    %reduction {
+      %x = f32[] parameter(0)
+      %y = f32[] parameter(1)
+      ROOT %add = f32[] add(f32[] %x, f32[] %y)
+    }
+
+    %while_condition {
+      %param = (s32[], s32[], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %gte.1 = s32[] get-tuple-element(%param), index=1
+      ROOT result = pred[] compare(%gte.0, %gte.1), direction=LT
+    }
+
+    %while_body {
+      %param = (s32[], s32[], f32[1024]) parameter(0)
+      %gte.0 = s32[] get-tuple-element(%param), index=0
+      %gte.1 = s32[] get-tuple-element(%param), index=1
+      %gte.2 = f32[1024] get-tuple-element(%param), index=2
+      %gradient = f32[1024] multiply(f32[1024] %gte.2, f32[1024] %gte.2)
+      %all-reduce = f32[1024] all-reduce(f32[1024] %gradient), replica_groups={}, to_apply=%reduction
+      %constant = s32[] constant(1)
+      %increment_iteration = s32[] add(s32[] %gte.0, s32[] %constant)
+      ROOT %loop_result = (s32[], s32[], f32[1024]) tuple(%increment_iteration, %gte.1, %all-reduce)
+    }
+
+    ENTRY unknown_trip_count {
+      %param.0 = s32[] parameter(0)
+      %param.1 = f32[1024] parameter(1)
+      %constant.0 = s32[] constant(0)
+      %while_init = (s32[], s32[], f32[1024]) tuple(s32[] %constant.0, s32[] %param.0, f32[1024] %param.1)
+      ROOT %while = (s32[], s32[], f32[1024]) while(%while_init), condition=%while_condition, body=%while_body
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(kHloModule));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          WhileLoopAllReducePipeliner{}.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace xla
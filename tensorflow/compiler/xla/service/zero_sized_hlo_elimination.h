@@ -21,9 +21,9 @@ limitations under the License.
 
 // HLO pass that replaces zero sized Hlos with a zero sized constant literal.
 namespace xla {
-class ZeroSizedHloElimination : public HloModulePass {
+class ZeroSizedHloElimination : public HloComputationPass {
  public:
-  StatusOr<bool> Run(HloModule* module) override;
+  StatusOr<bool> RunOnComputation(HloComputation* comp) override;
   absl::string_view name() const override {
     return "zero_sized_hlo_elimination";
   }
@@ -15,7 +15,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <tuple>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/copy_tensor.h"
@@ -190,8 +192,34 @@ class CollectiveAdapterImpl : public CollectiveAdapter {
   const T* data_end_;
 };
 
+// Type string of a merge or final op, used to keep reductions that combine
+// elements differently out of the same fusion bucket.
+string ReductionOpName(const OpKernel* op) {
+  return op == nullptr ? "" : op->type_string();
+}
+
+// Orders the members of a fusion group so that reductions that can share a
+// bucket are adjacent, and each bucket is laid out by instance key.
+std::tuple<DataType, string, string, int32> FusionSortKey(
+    const CollectiveParams& col_params) {
+  return std::make_tuple(col_params.instance.data_type,
+                         ReductionOpName(col_params.merge_op),
+                         ReductionOpName(col_params.final_op),
+                         col_params.instance.instance_key);
+}
+
+// Whether two reductions combine elements the same way and can therefore
+// share a packed buffer.
+bool SameReductionType(const CollectiveParams& a, const CollectiveParams& b) {
+  return a.instance.data_type == b.instance.data_type &&
+         ReductionOpName(a.merge_op) == ReductionOpName(b.merge_op) &&
+         ReductionOpName(a.final_op) == ReductionOpName(b.final_op);
+}
+
 }  // namespace
 
+/* static */ constexpr int64_t BaseCollectiveExecutor::kFusionThresholdBytes;
+
 CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
                                          Allocator* allocator,
                                          bool align_chunks) {
@@ -247,6 +275,20 @@ void BaseCollectiveExecutor::StartAbort(const Status& s) {
     status = status_;
   }
   LOG(ERROR) << "BaseCollectiveExecutor::StartAbort " << s;
+  std::vector<PendingFusedReduction> pending;
+  {
+    mutex_lock l(fusion_mu_);
+    fusion_status_ = status;
+    for (auto& it : pending_fusions_) {
+      for (auto& reduction : it.second) {
+        pending.push_back(std::move(reduction));
+      }
+    }
+    pending_fusions_.clear();
+  }
+  for (auto& reduction : pending) {
+    reduction.done(status);
+  }
   cem_->GetParamResolver()->StartAbort(status);
   remote_access_->StartAbort(status);
   if (cem_->GetNcclCommunicator() != nullptr) {
@@ -269,10 +311,9 @@ Status BaseCollectiveExecutor::GetStatus(const Status& s) {
   return s;
 }
 
-void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
-                                          const CollectiveParams* col_params,
-                                          const string& exec_key,
-                                          StatusCallback done) {
+StatusCallback BaseCollectiveExecutor::MakeSafeDone(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    StatusCallback done) {
   // See CompleteParamsAsync() how done() and the timeout callback interacts.
   const auto is_callback_called = std::make_shared<std::atomic<bool>>(false);
   auto done_safe = [this, done, ctx, is_callback_called](const Status& s) {
@@ -301,6 +342,21 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
           }
         });
   }
+  return done_safe;
+}
+
+void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
+                                          const CollectiveParams* col_params,
+                                          const string& exec_key,
+                                          StatusCallback done) {
+  StatusCallback done_safe = MakeSafeDone(ctx, col_params, std::move(done));
+  const CollImplDetails& impl_details = col_params->instance.impl_details;
+  if (col_params->instance.type == REDUCTION_COLLECTIVE &&
+      col_params->group.device_type == DEVICE_CPU &&
+      impl_details.fusion_key != 0 && impl_details.fusion_group_size > 1) {
+    ExecuteFusedAsync(ctx, col_params, exec_key, std::move(done_safe));
+    return;
+  }
 
   Tensor* output = ctx->mutable_output(0);
   const Tensor* input = (col_params->instance.type == REDUCTION_COLLECTIVE ||
@@ -311,6 +367,22 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                           col_params->is_source))
                             ? &ctx->input(0)
                             : nullptr;
+  CreateAndLaunchCollective(ctx, col_params, exec_key, input, output,
+                            done_safe);
+}
+
+void BaseCollectiveExecutor::ExecuteOnTensorsAsync(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    const string& exec_key, const Tensor* input, Tensor* output,
+    StatusCallback done) {
+  CreateAndLaunchCollective(ctx, col_params, exec_key, input, output,
+                            MakeSafeDone(ctx, col_params, std::move(done)));
+}
+
+void BaseCollectiveExecutor::CreateAndLaunchCollective(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    const string& exec_key, const Tensor* input, Tensor* output,
+    const StatusCallback& done_safe) {
   CollectiveImplementationInterface* col_impl = nullptr;
   Status status = CreateCollective(*col_params, &col_impl);
   if (!status.ok()) {
@@ -318,11 +390,19 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
     DCHECK_EQ(nullptr, col_impl);
     return;
   }
+  LaunchCollective(col_impl, ctx, col_params, exec_key, input, output,
+                   done_safe);
+}
+
+void BaseCollectiveExecutor::LaunchCollective(
+    CollectiveImplementationInterface* col_impl, OpKernelContext* ctx,
+    const CollectiveParams* col_params, const string& exec_key,
+    const Tensor* input, Tensor* output, const StatusCallback& done_safe) {
   core::ScopedUnref unref(col_impl);
   auto col_ctx = std::make_shared<CollectiveContext>(
       this, cem_->GetNcclCommunicator(), dev_mgr_, ctx, CtxParams(ctx),
       col_params, exec_key, step_id_, input, output);
-  status = col_impl->InitializeCollectiveContext(col_ctx);
+  Status status = col_impl->InitializeCollectiveContext(col_ctx);
   if (!status.ok()) {
     done_safe(status);
     return;
@@ -350,6 +430,208 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   });
 }
 
+void BaseCollectiveExecutor::ExecuteFusedAsync(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    const string& exec_key, StatusCallback done) {
+  const CollImplDetails& impl_details = col_params->instance.impl_details;
+  // Loop iterations reuse the fusion key, so the frame and iteration are part
+  // of the group's identity just as they are part of `exec_key`.
+  const string fusion_key = strings::StrCat(
+      ctx->device()->name(), ":", col_params->group.group_key, ":",
+      impl_details.fusion_key, ":", ctx->frame_iter().frame_id, ":",
+      ctx->frame_iter().iter_id);
+  std::vector<PendingFusedReduction> reductions;
+  Status status;
+  {
+    mutex_lock l(fusion_mu_);
+    status = fusion_status_;
+    if (status.ok()) {
+      std::vector<PendingFusedReduction>& pending =
+          pending_fusions_[fusion_key];
+      pending.push_back({ctx, col_params, exec_key, std::move(done)});
+      if (pending.size() <
+          static_cast<size_t>(impl_details.fusion_group_size)) {
+        return;
+      }
+      reductions = std::move(pending);
+      pending_fusions_.erase(fusion_key);
+    }
+  }
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  LaunchFusedReductions(std::move(reductions));
+}
+
+void BaseCollectiveExecutor::LaunchFusedReductions(
+    std::vector<PendingFusedReduction> reductions) {
+  const int32 fusion_group_size =
+      reductions[0].col_params->instance.impl_details.fusion_group_size;
+  for (const PendingFusedReduction& reduction : reductions) {
+    if (reduction.col_params->instance.impl_details.fusion_group_size !=
+        fusion_group_size) {
+      Status status = errors::InvalidArgument(
+          "Collective ", reduction.col_params->name, " declares a fusion group "
+          "of size ",
+          reduction.col_params->instance.impl_details.fusion_group_size,
+          " but other members of fusion group ",
+          reduction.col_params->instance.impl_details.fusion_key,
+          " declare size ", fusion_group_size);
+      for (PendingFusedReduction& r : reductions) {
+        r.done(status);
+      }
+      return;
+    }
+  }
+  std::sort(reductions.begin(), reductions.end(),
+            [](const PendingFusedReduction& a, const PendingFusedReduction& b) {
+              return FusionSortKey(*a.col_params) <
+                     FusionSortKey(*b.col_params);
+            });
+
+  // A bucket of one runs as the plain, unfused collective.
+  auto launch_unfused = [this](PendingFusedReduction& r) {
+    CollectiveImplementationInterface* col_impl = nullptr;
+    Status status = CreateCollective(*r.col_params, &col_impl);
+    if (!status.ok()) {
+      r.done(status);
+      return;
+    }
+    LaunchCollective(col_impl, r.ctx, r.col_params, r.exec_key,
+                     &r.ctx->input(0), r.ctx->mutable_output(0), r.done);
+  };
+  std::vector<PendingFusedReduction> bucket;
+  int64_t bucket_bytes = 0;
+  auto flush = [this, &bucket, &bucket_bytes, &launch_unfused]() {
+    if (bucket.size() == 1) {
+      launch_unfused(bucket[0]);
+    } else if (bucket.size() > 1) {
+      LaunchFusedBucket(std::move(bucket));
+    }
+    bucket.clear();
+    bucket_bytes = 0;
+  };
+  for (PendingFusedReduction& reduction : reductions) {
+    const int64_t bytes = reduction.ctx->input(0).TotalBytes();
+    if (bytes == 0) {
+      launch_unfused(reduction);
+      continue;
+    }
+    if (!bucket.empty() &&
+        (!SameReductionType(*bucket[0].col_params, *reduction.col_params) ||
+         bucket_bytes + bytes > kFusionThresholdBytes)) {
+      flush();
+    }
+    bucket_bytes += bytes;
+    bucket.push_back(std::move(reduction));
+  }
+  flush();
+}
+
+void BaseCollectiveExecutor::LaunchFusedBucket(
+    std::vector<PendingFusedReduction> bucket) {
+  auto fail_all = [&bucket](const Status& s) {
+    for (PendingFusedReduction& r : bucket) {
+      r.done(s);
+    }
+  };
+  const CollectiveParams& first = *bucket[0].col_params;
+  const DataType dtype = first.instance.data_type;
+  // Every member starts at an aligned offset so that its slice of the result
+  // can be handed out without a copy.
+  const int64_t align_elts =
+      std::max<int64_t>(1, EIGEN_MAX_ALIGN_BYTES / DataTypeSize(dtype));
+  std::vector<int64_t> offsets;
+  offsets.reserve(bucket.size());
+  int64_t total_elts = 0;
+  for (const PendingFusedReduction& r : bucket) {
+    offsets.push_back(total_elts);
+    const int64_t num_elts = r.ctx->input(0).NumElements();
+    total_elts += (num_elts + align_elts - 1) / align_elts * align_elts;
+  }
+
+  OpKernelContext* ctx = bucket[0].ctx;
+  auto packed = std::make_shared<Tensor>();
+  Status status =
+      ctx->allocate_temp(dtype, TensorShape({total_elts}), packed.get());
+  if (!status.ok()) {
+    fail_all(status);
+    return;
+  }
+  char* packed_data = const_cast<char*>(packed->tensor_data().data());
+  // Zero the padding between members; it is reduced along with the data but
+  // never read back.
+  std::memset(packed_data, 0, packed->TotalBytes());
+  const int64_t elt_bytes = DataTypeSize(dtype);
+  for (int i = 0; i < bucket.size(); ++i) {
+    const StringPiece input = bucket[i].ctx->input(0).tensor_data();
+    std::memcpy(packed_data + offsets[i] * elt_bytes, input.data(),
+                input.size());
+  }
+
+  // The fused pass borrows the resolved group and rank of its first member
+  // and runs under that member's exec key, which no other pass uses.
+  CollectiveParams* fused_params = new CollectiveParams();
+  fused_params->group = first.group;
+  fused_params->instance = first.instance;
+  fused_params->instance.impl_details = first.instance.impl_details;
+  fused_params->instance.shape = TensorShape({total_elts});
+  // Let the ring subdivide the packed buffer so that its chunks pipeline.
+  fused_params->instance.impl_details.subdiv_offsets.clear();
+  fused_params->instance.impl_details.subdiv_permutations.clear();
+  if (fused_params->instance.impl_details.max_subdivs_per_device == -1) {
+    fused_params->instance.impl_details.max_subdivs_per_device = 0;
+  }
+  fused_params->name = strings::StrCat(first.name, "/fused");
+  fused_params->default_rank = first.default_rank;
+  fused_params->merge_op = first.merge_op;
+  fused_params->final_op = first.final_op;
+  VLOG(1) << "Fusing " << bucket.size() << " reductions of group "
+          << first.group.group_key << " into " << total_elts << " elements of "
+          << DataTypeString(dtype) << " under exec key " << bucket[0].exec_key;
+
+  CollectiveImplementationInterface* col_impl = nullptr;
+  status = CreateCollective(*fused_params, &col_impl);
+  if (status.ok()) {
+    status = col_impl->InitializeCollectiveParams(fused_params);
+    if (!status.ok()) {
+      col_impl->Unref();
+    }
+  }
+  if (!status.ok()) {
+    fused_params->Unref();
+    fail_all(status);
+    return;
+  }
+  const string exec_key = bucket[0].exec_key;
+  auto members = std::make_shared<std::vector<PendingFusedReduction>>(
+      std::move(bucket));
+  auto offsets_ptr = std::make_shared<std::vector<int64_t>>(std::move(offsets));
+  LaunchCollective(
+      col_impl, ctx, fused_params, exec_key, packed.get(), packed.get(),
+      [packed, members, offsets_ptr, fused_params](const Status& s) {
+        core::ScopedUnref unref(fused_params);
+        for (int i = 0; i < members->size(); ++i) {
+          PendingFusedReduction& r = (*members)[i];
+          Status member_status = s;
+          if (member_status.ok()) {
+            Tensor* output = r.ctx->mutable_output(0);
+            const TensorShape shape = r.ctx->input(0).shape();
+            const int64_t begin = (*offsets_ptr)[i];
+            if (!output->CopyFrom(
+                    packed->Slice(begin, begin + shape.num_elements()),
+                    shape)) {
+              member_status = errors::Internal(
+                  "Failed to alias the fused reduction result for ",
+                  r.col_params->name);
+            }
+          }
+          r.done(member_status);
+        }
+      });
+}
+
 void BaseCollectiveExecutor::CompleteParamsAsync(
     const DeviceAttributes& device, CollectiveParams* cp,
     CancellationManager* cancel_mgr, StatusCallback done) {
@@ -478,7 +760,10 @@ void BaseCollectiveExecutor::UnblockDependencies(
         col_params.group.num_devices_per_task.at(task_name);
     launched_[col_params.instance.instance_key] = num_devices;
   }
-  if (--launched_[col_params.instance.instance_key] == 0) {
+  // Collectives that launch several NCCL ops per device, such as
+  // HierarchicalReduce, unblock more than once; only the first round counts.
+  int32& remaining = launched_[col_params.instance.instance_key];
+  if (remaining > 0 && --remaining == 0) {
     VLOG(1) << "Unblocking dependencies for collective instance "
             << col_params.instance.instance_key;
     launch_cv_.notify_all();
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/framework/collective.h"
@@ -95,6 +97,9 @@ CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
 // arguments and device+interconnect topology.
 class BaseCollectiveExecutor : public CollectiveExecutor {
  public:
+  // Upper bound on the bytes packed into one fused reduction buffer.
+  static constexpr int64_t kFusionThresholdBytes = 4 << 20;
+
   BaseCollectiveExecutor(CollectiveExecutorMgrInterface* cem,
                          CollectiveRemoteAccess* remote_access, int64_t step_id,
                          const DeviceMgr* dev_mgr,
@@ -112,6 +117,11 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   void ExecuteAsync(OpKernelContext* ctx, const CollectiveParams* col_params,
                     const string& exec_key, StatusCallback done) override;
 
+  void ExecuteOnTensorsAsync(OpKernelContext* ctx,
+                             const CollectiveParams* col_params,
+                             const string& exec_key, const Tensor* input,
+                             Tensor* output, StatusCallback done) override;
+
   void CompleteParamsAsync(const DeviceAttributes& device, CollectiveParams* cp,
                            CancellationManager* cancel_mgr,
                            StatusCallback done) override;
@@ -150,14 +160,63 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   Status status_ TF_GUARDED_BY(status_mu_);
 
  private:
+  // A reduction waiting for the other members of its fusion group.
+  struct PendingFusedReduction {
+    OpKernelContext* ctx;
+    const CollectiveParams* col_params;
+    string exec_key;
+    StatusCallback done;
+  };
+
   Status CreateCollective(const CollectiveParams& col_params,
                           CollectiveImplementationInterface** col_impl);
+  // Wraps `done` so that it is called once, either when the collective
+  // finishes or when it times out, and aborts the executor on errors.
+  StatusCallback MakeSafeDone(OpKernelContext* ctx,
+                              const CollectiveParams* col_params,
+                              StatusCallback done);
+  // Creates and launches the collective described by `col_params`.
+  void CreateAndLaunchCollective(OpKernelContext* ctx,
+                                 const CollectiveParams* col_params,
+                                 const string& exec_key, const Tensor* input,
+                                 Tensor* output,
+                                 const StatusCallback& done_safe);
+  // Runs `col_impl` on `input` and `output` and calls `done` when it finishes.
+  // Takes ownership of the caller's reference on `col_impl`.
+  void LaunchCollective(CollectiveImplementationInterface* col_impl,
+                        OpKernelContext* ctx,
+                        const CollectiveParams* col_params,
+                        const string& exec_key, const Tensor* input,
+                        Tensor* output, const StatusCallback& done);
+  // Buffers a reduction that names a fusion group until all
+  // `fusion_group_size` members of the group have arrived on this device, and
+  // then launches the whole group.
+  void ExecuteFusedAsync(OpKernelContext* ctx,
+                         const CollectiveParams* col_params,
+                         const string& exec_key, StatusCallback done)
+      TF_LOCKS_EXCLUDED(fusion_mu_);
+  // Splits a complete fusion group into buckets of reductions with the same
+  // type and ops, each at most kFusionThresholdBytes, and launches one ring
+  // pass per bucket. Every device derives the same buckets because they only
+  // depend on the instance keys and shapes of the group.
+  void LaunchFusedReductions(std::vector<PendingFusedReduction> reductions);
+  // Packs a bucket of reductions into one buffer, reduces it, and hands each
+  // member an aligned slice of the result.
+  void LaunchFusedBucket(std::vector<PendingFusedReduction> bucket);
   // Check if all ops on which this collective depends on have launched.
   bool CheckDependencies(const CollectiveParams& col_params)
       TF_EXCLUSIVE_LOCKS_REQUIRED(launch_mu_);
   // Tries to return the status that is the original error. It returns the
   // aborted status if the collective executor is aborted.
   Status GetStatus(const Status& s) TF_LOCKS_EXCLUDED(status_mu_);
+
+  mutex fusion_mu_;
+  // Set by StartAbort so that late members of a fusion group fail instead of
+  // waiting for peers that will never arrive.
+  Status fusion_status_ TF_GUARDED_BY(fusion_mu_);
+  // Fusion group key -> members of the group that have arrived so far.
+  std::unordered_map<string, std::vector<PendingFusedReduction>>
+      pending_fusions_ TF_GUARDED_BY(fusion_mu_);
 };
 
 }  // namespace tensorflow
@@ -15,8 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
@@ -37,6 +42,7 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr int64_t BFCAllocator::kDecommittedAllocationId;
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
@@ -59,6 +65,8 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
   // Allocate the requested amount of memory.
   memory_limit_ = total_memory;
   stats_.bytes_limit = static_cast<int64_t>(total_memory);
+  stats_.pool_bytes = 0;
+  stats_.peak_pool_bytes = 0;
 
   // Create a bunch of bins of various good sizes.
 
@@ -157,6 +165,9 @@ bool BFCAllocator::Extend(size_t alignment, size_t rounded_bytes) {
           << Name() << ".";
 
   total_region_allocated_bytes_ += bytes_received;
+  stats_.pool_bytes = total_region_allocated_bytes_;
+  stats_.peak_pool_bytes =
+      std::max(*stats_.peak_pool_bytes, *stats_.pool_bytes);
   VLOG(1) << "Total allocated bytes: "
           << strings::HumanReadableNumBytes(total_region_allocated_bytes_);
 
@@ -387,10 +398,155 @@ void BFCAllocator::DeallocateRegions(
     // Deallocate the memory.
     sub_allocator_->Free(it->ptr(), it->memory_size());
     total_region_allocated_bytes_ -= it->memory_size();
+    stats_.pool_bytes = total_region_allocated_bytes_;
     it = region_manager_.RemoveAllocationRegion(it);
   }
 }
 
+bool BFCAllocator::Defragment(size_t alignment, size_t rounded_bytes) {
+  if (!defragmentation_enabled_) {
+    return false;
+  }
+  const size_t granularity = sub_allocator_->DecommitGranularity();
+  const size_t needed_bytes =
+      (rounded_bytes + granularity - 1) / granularity * granularity;
+
+  // Only whole pages of the free chunks can be decommitted.  The chunks freed
+  // after the safe frontier may still be used by another stream.
+  struct Candidate {
+    ChunkHandle h;
+    size_t offset;
+    size_t num_bytes;
+  };
+  std::vector<Candidate> candidates;
+  size_t decommittable_bytes = 0;
+  const uint64 safe_frontier = safe_frontier_.load(std::memory_order_relaxed);
+  for (BinNum b = 0; b < kNumBins; b++) {
+    for (ChunkHandle h : BinFromIndex(b)->free_chunks) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (c->freed_at_count > safe_frontier) continue;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(c->ptr);
+      const uintptr_t page_begin =
+          (begin + granularity - 1) / granularity * granularity;
+      const uintptr_t page_end = (begin + c->size) / granularity * granularity;
+      if (page_end > page_begin) {
+        candidates.push_back({h, page_begin - begin, page_end - page_begin});
+        decommittable_bytes += page_end - page_begin;
+      }
+    }
+  }
+  size_t available_bytes = memory_limit_ - total_region_allocated_bytes_;
+  if (available_bytes + decommittable_bytes < needed_bytes) {
+    return false;
+  }
+
+  if (available_bytes < needed_bytes) {
+    LOG(WARNING) << "Defragmentation: decommitting the memory behind free "
+                 << "chunks of " << Name() << " to map "
+                 << strings::HumanReadableNumBytes(needed_bytes)
+                 << " contiguously. If you see this message frequently, you "
+                 << "are running near the threshold of the available device "
+                 << "memory and the synchronizations it requires may incur "
+                 << "great performance overhead.";
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                return a.num_bytes > b.num_bytes;
+              });
+    for (const Candidate& candidate : candidates) {
+      if (available_bytes >= needed_bytes ||
+          !DecommitChunk(candidate.h, candidate.offset, candidate.num_bytes)) {
+        break;
+      }
+      available_bytes += candidate.num_bytes;
+    }
+    if (available_bytes < needed_bytes) {
+      return false;
+    }
+  }
+
+  // Reuses the addresses of the smallest fitting decommitted chunk before
+  // growing the regions.
+  ChunkHandle best = kInvalidChunkHandle;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (c->decommitted() && c->size >= needed_bytes &&
+          (best == kInvalidChunkHandle ||
+           c->size < ChunkFromHandle(best)->size)) {
+        best = h;
+      }
+      h = c->next;
+    }
+  }
+  if (best != kInvalidChunkHandle && RecommitChunk(best, needed_bytes)) {
+    return true;
+  }
+  return Extend(alignment, rounded_bytes);
+}
+
+bool BFCAllocator::DecommitChunk(ChunkHandle h, size_t offset,
+                                 size_t num_bytes) {
+  RemoveFreeChunkFromBin(h);
+  if (offset > 0) {
+    SplitChunk(h, offset);
+    InsertFreeChunkIntoBin(h);
+    h = ChunkFromHandle(h)->next;
+    RemoveFreeChunkFromBin(h);
+  }
+  if (ChunkFromHandle(h)->size > num_bytes) {
+    SplitChunk(h, num_bytes);
+  }
+  Chunk* c = ChunkFromHandle(h);
+  if (!sub_allocator_->Decommit(c->ptr, c->size)) {
+    InsertFreeChunkIntoBin(TryToCoalesce(h, /*ignore_freed_at=*/false));
+    return false;
+  }
+  c->allocation_id = kDecommittedAllocationId;
+  c->requested_size = 0;
+  c->freed_at_count = 0;
+  total_region_allocated_bytes_ -= num_bytes;
+  decommitted_bytes_ += num_bytes;
+  stats_.pool_bytes = total_region_allocated_bytes_;
+
+  // Merges the adjacent decommitted chunks so that they can be recommitted
+  // together.
+  const ChunkHandle prev = c->prev;
+  if (c->next != kInvalidChunkHandle &&
+      ChunkFromHandle(c->next)->decommitted()) {
+    Merge(h, c->next);
+  }
+  if (prev != kInvalidChunkHandle && ChunkFromHandle(prev)->decommitted()) {
+    Merge(prev, h);
+  }
+  return true;
+}
+
+bool BFCAllocator::RecommitChunk(ChunkHandle h, size_t num_bytes) {
+  if (total_region_allocated_bytes_ + num_bytes > memory_limit_) {
+    return false;
+  }
+  if (ChunkFromHandle(h)->size > num_bytes) {
+    SplitChunk(h, num_bytes);
+  }
+  Chunk* c = ChunkFromHandle(h);
+  if (!sub_allocator_->Recommit(c->ptr, c->size)) {
+    if (c->next != kInvalidChunkHandle &&
+        ChunkFromHandle(c->next)->decommitted()) {
+      Merge(h, c->next);
+    }
+    return false;
+  }
+  c->allocation_id = -1;
+  total_region_allocated_bytes_ += num_bytes;
+  decommitted_bytes_ -= num_bytes;
+  stats_.pool_bytes = total_region_allocated_bytes_;
+  stats_.peak_pool_bytes =
+      std::max(*stats_.peak_pool_bytes, *stats_.pool_bytes);
+  InsertFreeChunkIntoBin(TryToCoalesce(h, /*ignore_freed_at=*/false));
+  return true;
+}
+
 void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
                                         size_t num_bytes,
                                         bool dump_log_on_failure,
@@ -404,6 +560,30 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (thread_cache_enabled_) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    // Memory parked in the thread caches may be all that stands between this
+    // request and success, so only report a failure after flushing them.
+    ptr = AllocateRawFromBins(unused_alignment, num_bytes, rounded_bytes,
+                              /*dump_log_on_failure=*/false, freed_before);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    if (FlushThreadCaches() == 0 && !dump_log_on_failure) {
+      return nullptr;
+    }
+  }
+  return AllocateRawFromBins(unused_alignment, num_bytes, rounded_bytes,
+                             dump_log_on_failure, freed_before);
+}
+
+void* BFCAllocator::AllocateRawFromBins(size_t unused_alignment,
+                                        size_t num_bytes, size_t rounded_bytes,
+                                        bool dump_log_on_failure,
+                                        uint64 freed_before) {
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
@@ -454,6 +634,16 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // The free memory is too fragmented to be used by the request.  Move the
+  // physical memory behind the free chunks to a range of addresses that fits.
+  if (Defragment(unused_alignment, rounded_bytes)) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
@@ -580,6 +770,19 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
             std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        if (thread_cache_enabled_) {
+          UpdateClientBytesInUse(chunk->size);
+          if (BinNumForSize(chunk->size) < kNumThreadCacheBins) {
+            LiveChunkInfo info;
+            info.size = chunk->size;
+            info.requested_size = chunk->requested_size;
+            info.allocation_id = chunk->allocation_id;
+            RecordLiveChunk(chunk->ptr, info);
+          }
+        }
+        if (attribution_sampling_period_ > 0) {
+          MaybeAttributeChunk(chunk);
+        }
 
 #ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
@@ -619,7 +822,7 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
   ChunkHandle h_new_chunk = AllocateChunk();
 
   Chunk* c = ChunkFromHandle(h);
-  CHECK(!c->in_use() && (c->bin_num == kInvalidBinNum));
+  CHECK((!c->in_use() || c->decommitted()) && (c->bin_num == kInvalidBinNum));
 
   // Create a new chunk starting num_bytes after c
   BFCAllocator::Chunk* new_chunk = ChunkFromHandle(h_new_chunk);
@@ -630,8 +833,8 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
   new_chunk->size = c->size - num_bytes;
   c->size = num_bytes;
 
-  // The new chunk is not in use.
-  new_chunk->allocation_id = -1;
+  // The new chunk is not in use, or decommitted like c.
+  new_chunk->allocation_id = c->allocation_id;
 
   // It inherits the freed time.
   new_chunk->freed_at_count = c->freed_at_count;
@@ -649,13 +852,17 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
   }
 
   // Add the newly free chunk to the free bin.
-  InsertFreeChunkIntoBin(h_new_chunk);
+  if (!new_chunk->decommitted()) {
+    InsertFreeChunkIntoBin(h_new_chunk);
+  }
 }
 
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(3) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
-  DeallocateRawInternal(ptr);
+  if (!thread_cache_enabled_ || !DeallocateToThreadCache(ptr)) {
+    DeallocateRawInternal(ptr);
+  }
   retry_helper_.NotifyDealloc();
 }
 
@@ -676,6 +883,9 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   int64_t alloc_bytes = chunk->size;
 
   MarkFree(h);
+  if (thread_cache_enabled_) {
+    UpdateClientBytesInUse(-alloc_bytes);
+  }
 
   // Consider coalescing it.
   if (timing_counter_) {
@@ -700,8 +910,9 @@ void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
                          BFCAllocator::ChunkHandle h2) {
   Chunk* c1 = ChunkFromHandle(h1);
   Chunk* c2 = ChunkFromHandle(h2);
-  // We can only merge chunks that are not in use.
-  CHECK(!c1->in_use() && !c2->in_use());
+  // We can only merge chunks that are not in use, or both decommitted.
+  CHECK((!c1->in_use() && !c2->in_use()) ||
+        (c1->decommitted() && c2->decommitted()));
 
   // c1's prev doesn't change, still points to the same ptr, and is
   // still not in use.
@@ -777,6 +988,11 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
+  if (c->site != nullptr) {
+    c->site->live_bytes -=
+        static_cast<int64_t>(c->size) * attribution_sampling_period_;
+    c->site = nullptr;
+  }
 
 #ifdef TENSORFLOW_MEM_DEBUG
   if (ShouldRecordOpName()) {
@@ -908,6 +1124,10 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  LiveChunkInfo info;
+  if (FindLiveChunk(ptr, &info)) {
+    return info.requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -917,6 +1137,10 @@ size_t BFCAllocator::RequestedSize(const void* ptr) const {
 }
 
 size_t BFCAllocator::AllocatedSize(const void* ptr) const {
+  LiveChunkInfo info;
+  if (FindLiveChunk(ptr, &info)) {
+    return info.size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -926,6 +1150,10 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64_t BFCAllocator::AllocationId(const void* ptr) const {
+  LiveChunkInfo info;
+  if (FindLiveChunk(ptr, &info)) {
+    return info.allocation_id;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -985,7 +1213,7 @@ string BFCAllocator::RenderOccupancy() {
     // Then render each chunk left to right.
     while (h != kInvalidChunkHandle) {
       Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
+      if (c->in_use() && !c->decommitted()) {
         // Render the wasted space
         size_t wasted = c->size - c->requested_size;
         if (wasted > 0) {
@@ -1047,11 +1275,12 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
+      if (c->in_use() && !c->decommitted()) {
         in_use_by_size[c->size]++;
       }
       string buf = strings::StrCat(
-          (c->in_use() ? "InUse" : "Free "), " at ",
+          (c->decommitted() ? "Decommitted" : c->in_use() ? "InUse" : "Free "),
+          " at ",
           strings::Hex(reinterpret_cast<uint64>(c->ptr)), " of size ", c->size);
 #ifdef TENSORFLOW_MEM_DEBUG
       if (ShouldRecordOpName()) {
@@ -1083,7 +1312,92 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
             << (memory_limit_ - total_region_allocated_bytes_)
             << " curr_region_allocation_bytes_: "
             << curr_region_allocation_bytes_;
-  LOG(INFO) << "Stats: \n" << stats_.DebugString();
+  if (defragmentation_enabled_) {
+    LOG(INFO) << "decommitted_bytes_: " << decommitted_bytes_;
+  }
+  LOG(INFO) << "Stats: \n" << ClientStats().DebugString();
+
+  if (attribution_sampling_period_ > 0) {
+    static constexpr int kMaxLoggedSites = 20;
+    LOG(INFO) << "Top allocation sites by estimated live bytes "
+              << "(op, kind, live, peak, allocations):";
+    for (const AllocationSiteStats& site :
+         GetTopAllocationSitesInternal(kMaxLoggedSites)) {
+      LOG(INFO) << site.op_name << "\t" << site.region_type << "\t"
+                << strings::HumanReadableNumBytes(site.live_bytes) << "\t"
+                << strings::HumanReadableNumBytes(site.peak_live_bytes) << "\t"
+                << site.num_allocations;
+    }
+  }
+}
+
+void BFCAllocator::EnableDefragmentation() {
+  CHECK(sub_allocator_->SupportsDecommit())
+      << "Defragmentation requires a sub-allocator that supports decommit.";
+  mutex_lock l(lock_);
+  CHECK_EQ(stats_.num_allocs, 0) << "EnableDefragmentation() must be called "
+                                    "before the first allocation.";
+  VLOG(1) << "Enabling defragmentation for " << Name();
+  defragmentation_enabled_ = true;
+}
+
+void BFCAllocator::EnableMemoryAttribution(int sampling_period) {
+  CHECK_GT(sampling_period, 0);
+  CHECK(!thread_cache_enabled_)
+      << "Memory attribution is not supported with the thread cache.";
+  mutex_lock l(lock_);
+  CHECK_EQ(stats_.num_allocs, 0) << "EnableMemoryAttribution() must be called "
+                                    "before the first allocation.";
+  VLOG(1) << "Enabling memory attribution for " << Name()
+          << " with a sampling period of " << sampling_period;
+  attribution_sampling_period_ = sampling_period;
+}
+
+void BFCAllocator::MaybeAttributeChunk(Chunk* chunk) {
+  chunk->site = nullptr;
+  if (++num_attribution_candidates_ % attribution_sampling_period_ != 0) {
+    return;
+  }
+  const auto& annotation =
+      profiler::ScopedMemoryDebugAnnotation::CurrentAnnotation();
+  std::pair<string, string> key(
+      annotation.pending_op_name ? annotation.pending_op_name : "UNKNOWN",
+      annotation.pending_region_type ? annotation.pending_region_type : "");
+  std::unique_ptr<AllocationSiteStats>& site = allocation_sites_[key];
+  if (site == nullptr) {
+    site = absl::make_unique<AllocationSiteStats>();
+    site->op_name = std::move(key.first);
+    site->region_type = std::move(key.second);
+  }
+  site->live_bytes +=
+      static_cast<int64_t>(chunk->size) * attribution_sampling_period_;
+  site->peak_live_bytes = std::max(site->peak_live_bytes, site->live_bytes);
+  site->num_allocations += attribution_sampling_period_;
+  chunk->site = site.get();
+}
+
+std::vector<BFCAllocator::AllocationSiteStats>
+BFCAllocator::GetTopAllocationSites(int max_sites) {
+  mutex_lock l(lock_);
+  return GetTopAllocationSitesInternal(max_sites);
+}
+
+std::vector<BFCAllocator::AllocationSiteStats>
+BFCAllocator::GetTopAllocationSitesInternal(int max_sites) {
+  std::vector<AllocationSiteStats> sites;
+  sites.reserve(allocation_sites_.size());
+  for (const auto& it : allocation_sites_) {
+    sites.push_back(*it.second);
+  }
+  std::sort(sites.begin(), sites.end(),
+            [](const AllocationSiteStats& a, const AllocationSiteStats& b) {
+              if (a.live_bytes != b.live_bytes) {
+                return a.live_bytes > b.live_bytes;
+              }
+              return a.peak_live_bytes > b.peak_live_bytes;
+            });
+  if (sites.size() > static_cast<size_t>(max_sites)) sites.resize(max_sites);
+  return sites;
 }
 
 void BFCAllocator::MaybeWriteMemoryMap() {
@@ -1107,6 +1421,9 @@ void BFCAllocator::MaybeWriteMemoryMap() {
 }
 
 MemoryDump BFCAllocator::RecordMemoryMap() {
+  if (thread_cache_enabled_) {
+    FlushThreadCaches();
+  }
   mutex_lock l(lock_);
   return RecordMemoryMapInternal();
 }
@@ -1116,11 +1433,12 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   md.set_allocator_name(Name());
 
   // Record the general stats
+  const AllocatorStats stats = ClientStats();
   MemAllocatorStats* mas = md.mutable_stats();
-  mas->set_num_allocs(stats_.num_allocs);
-  mas->set_bytes_in_use(stats_.bytes_in_use);
-  mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
-  mas->set_largest_alloc_size(stats_.largest_alloc_size);
+  mas->set_num_allocs(stats.num_allocs);
+  mas->set_bytes_in_use(stats.bytes_in_use);
+  mas->set_peak_bytes_in_use(stats.peak_bytes_in_use);
+  mas->set_largest_alloc_size(stats.largest_alloc_size);
 
   // Record summary data for every bin.
   const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
@@ -1142,11 +1460,18 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
+      if (c->decommitted()) {
+        h = c->next;
+        continue;
+      }
       MemChunk* mc = md.add_chunk();
       mc->set_in_use(c->in_use());
       mc->set_address(reinterpret_cast<uint64>(c->ptr));
       mc->set_size(c->size);
-      mc->set_requested_size(c->requested_size);
+      LiveChunkInfo info;
+      mc->set_requested_size(c->in_use() && FindLiveChunk(c->ptr, &info)
+                                 ? info.requested_size
+                                 : c->requested_size);
       mc->set_bin(c->bin_num);
 #ifdef TENSORFLOW_MEM_DEBUG
       mc->set_op_name(c->op_name ? string(c->op_name) : "UNKNOWN");
@@ -1179,7 +1504,7 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  return ClientStats();
 }
 
 bool BFCAllocator::ClearStats() {
@@ -1187,9 +1512,231 @@ bool BFCAllocator::ClearStats() {
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
+  stats_.peak_pool_bytes = stats_.pool_bytes;
+  if (thread_cache_enabled_) {
+    for (auto& shard : thread_cache_shards_) {
+      mutex_lock shard_lock(shard->mu);
+      shard->num_allocs = 0;
+      shard->largest_alloc_size = 0;
+    }
+    client_peak_bytes_in_use_.store(
+        client_bytes_in_use_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
   return true;
 }
 
+AllocatorStats BFCAllocator::ClientStats() {
+  AllocatorStats stats = stats_;
+  if (!thread_cache_enabled_) {
+    return stats;
+  }
+  // stats_ counts parked chunks as in use; report client usage instead.
+  stats.bytes_in_use = client_bytes_in_use_.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use =
+      client_peak_bytes_in_use_.load(std::memory_order_relaxed);
+  for (auto& shard : thread_cache_shards_) {
+    mutex_lock shard_lock(shard->mu);
+    stats.num_allocs += shard->num_allocs;
+    stats.largest_alloc_size =
+        std::max(stats.largest_alloc_size, shard->largest_alloc_size);
+  }
+  return stats;
+}
+
+void BFCAllocator::EnableThreadCache(int num_shards,
+                                     size_t max_cached_bytes_per_shard) {
+  CHECK_GT(num_shards, 0);
+  CHECK(timing_counter_ == nullptr)
+      << "Timestamped chunks are not supported with the thread cache.";
+  CHECK_EQ(attribution_sampling_period_, 0)
+      << "Memory attribution is not supported with the thread cache.";
+  {
+    mutex_lock l(lock_);
+    CHECK_EQ(stats_.num_allocs, 0)
+        << "EnableThreadCache() must be called before the first allocation.";
+  }
+  VLOG(1) << "Enabling thread cache for " << Name() << " with " << num_shards
+          << " shards of "
+          << strings::HumanReadableNumBytes(max_cached_bytes_per_shard);
+  max_cached_bytes_per_shard_ = max_cached_bytes_per_shard;
+  for (int i = 0; i < num_shards; ++i) {
+    thread_cache_shards_.push_back(absl::make_unique<ThreadCacheShard>());
+    live_chunk_shards_.push_back(absl::make_unique<LiveChunkShard>());
+  }
+  thread_cache_enabled_ = true;
+}
+
+BFCAllocator::ThreadCacheShard*
+BFCAllocator::ThreadCacheShardForCurrentThread() {
+  static thread_local const size_t thread_hash =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  return thread_cache_shards_[thread_hash % thread_cache_shards_.size()]
+      .get();
+}
+
+BFCAllocator::LiveChunkShard* BFCAllocator::LiveChunkShardFor(
+    const void* ptr) const {
+  // Chunks are kMinAllocationSize aligned, so drop the bits that are always
+  // zero before picking a shard.
+  const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr);
+  return live_chunk_shards_[(p >> kMinAllocationBits) %
+                            live_chunk_shards_.size()]
+      .get();
+}
+
+void BFCAllocator::RecordLiveChunk(const void* ptr,
+                                   const LiveChunkInfo& info) {
+  LiveChunkShard* shard = LiveChunkShardFor(ptr);
+  mutex_lock l(shard->mu);
+  shard->chunks[ptr] = info;
+}
+
+bool BFCAllocator::FindLiveChunk(const void* ptr, LiveChunkInfo* info) const {
+  if (!thread_cache_enabled_) {
+    return false;
+  }
+  LiveChunkShard* shard = LiveChunkShardFor(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->chunks.find(ptr);
+  if (it == shard->chunks.end()) {
+    return false;
+  }
+  *info = it->second;
+  return true;
+}
+
+void BFCAllocator::UpdateClientBytesInUse(int64_t delta) {
+  const int64_t in_use =
+      client_bytes_in_use_.fetch_add(delta, std::memory_order_relaxed) + delta;
+  if (delta <= 0) {
+    return;
+  }
+  int64_t peak = client_peak_bytes_in_use_.load(std::memory_order_relaxed);
+  while (in_use > peak && !client_peak_bytes_in_use_.compare_exchange_weak(
+                              peak, in_use, std::memory_order_relaxed)) {
+  }
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes) {
+  const BinNum bin_num = BinNumForSize(rounded_bytes);
+  if (bin_num >= kNumThreadCacheBins) {
+    return nullptr;
+  }
+  CachedChunk chunk;
+  ThreadCacheShard* shard = ThreadCacheShardForCurrentThread();
+  {
+    mutex_lock l(shard->mu);
+    // All chunks of a bin are within a factor of two of each other, so the
+    // most recently parked chunk that fits is as good as any.
+    std::vector<CachedChunk>& cached = shard->bins[bin_num];
+    for (auto it = cached.rbegin(); it != cached.rend(); ++it) {
+      if (it->size >= rounded_bytes) {
+        chunk = *it;
+        *it = cached.back();
+        cached.pop_back();
+        break;
+      }
+    }
+    if (chunk.ptr == nullptr) {
+      return nullptr;
+    }
+    shard->cached_bytes -= chunk.size;
+    ++shard->num_allocs;
+    shard->largest_alloc_size = std::max<int64_t>(
+        shard->largest_alloc_size, static_cast<int64_t>(chunk.size));
+  }
+  LiveChunkInfo info;
+  info.size = chunk.size;
+  info.requested_size = num_bytes;
+  info.allocation_id =
+      next_allocation_id_.fetch_add(1, std::memory_order_relaxed);
+  RecordLiveChunk(chunk.ptr, info);
+  UpdateClientBytesInUse(chunk.size);
+  VLOG(4) << "Returning cached: " << chunk.ptr;
+  return chunk.ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  if (ptr == nullptr) {
+    return false;
+  }
+  CachedChunk chunk;
+  chunk.ptr = ptr;
+  {
+    LiveChunkShard* live_shard = LiveChunkShardFor(ptr);
+    mutex_lock l(live_shard->mu);
+    auto it = live_shard->chunks.find(ptr);
+    if (it == live_shard->chunks.end()) {
+      return false;
+    }
+    chunk.size = it->second.size;
+    live_shard->chunks.erase(it);
+  }
+  UpdateClientBytesInUse(-static_cast<int64_t>(chunk.size));
+
+  std::vector<CachedChunk> overflow;
+  ThreadCacheShard* shard = ThreadCacheShardForCurrentThread();
+  {
+    mutex_lock l(shard->mu);
+    shard->bins[BinNumForSize(chunk.size)].push_back(chunk);
+    shard->cached_bytes += chunk.size;
+    if (shard->cached_bytes > max_cached_bytes_per_shard_) {
+      // Flush the least recently parked chunks of every bin until the shard
+      // is at most half full, so that overflows are handled in batches.
+      const size_t target = max_cached_bytes_per_shard_ / 2;
+      for (auto& cached : shard->bins) {
+        size_t n = 0;
+        while (n < cached.size() && shard->cached_bytes > target) {
+          shard->cached_bytes -= cached[n].size;
+          overflow.push_back(cached[n]);
+          ++n;
+        }
+        cached.erase(cached.begin(), cached.begin() + n);
+      }
+    }
+  }
+  if (!overflow.empty()) {
+    ReturnCachedChunksToBins(overflow);
+  }
+  return true;
+}
+
+void BFCAllocator::ReturnCachedChunksToBins(
+    const std::vector<CachedChunk>& chunks) {
+  mutex_lock l(lock_);
+  for (const CachedChunk& chunk : chunks) {
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(chunk.ptr);
+    CHECK(h != kInvalidChunkHandle);
+    MarkFree(h);
+    InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+  }
+  VLOG(2) << "Returned " << chunks.size() << " cached chunks to the bins of "
+          << Name();
+}
+
+size_t BFCAllocator::FlushThreadCaches() {
+  if (!thread_cache_enabled_) {
+    return 0;
+  }
+  std::vector<CachedChunk> chunks;
+  size_t bytes = 0;
+  for (auto& shard : thread_cache_shards_) {
+    mutex_lock l(shard->mu);
+    for (auto& cached : shard->bins) {
+      chunks.insert(chunks.end(), cached.begin(), cached.end());
+      cached.clear();
+    }
+    bytes += shard->cached_bytes;
+    shard->cached_bytes = 0;
+  }
+  if (!chunks.empty()) {
+    ReturnCachedChunksToBins(chunks);
+  }
+  return bytes;
+}
+
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
 BFCAllocator::get_bin_debug_info() {
   std::array<BinDebugInfo, kNumBins> bin_infos;
@@ -1197,6 +1744,10 @@ BFCAllocator::get_bin_debug_info() {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
+      if (c->decommitted()) {
+        h = c->next;
+        continue;
+      }
       BinNum bin_num = BinNumForSize(c->size);
       BinDebugInfo& bin_info = bin_infos[bin_num];
       bin_info.total_bytes_in_bin += c->size;
@@ -17,12 +17,15 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -77,10 +80,72 @@ class BFCAllocator : public Allocator {
 
   bool ClearStats() override;
 
-  void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
+  void SetTimingCounter(SharedCounter* sc) {
+    CHECK(!thread_cache_enabled_)
+        << "Timestamped chunks are not supported with the thread cache.";
+    timing_counter_ = sc;
+  }
+
+  // Enables a caching front end that keeps recently freed small chunks (those
+  // falling in the first kNumThreadCacheBins bins) in 'num_shards' caches
+  // selected by the calling thread, so that repeated small allocations are
+  // served without acquiring the allocator-wide lock.  Each shard holds at
+  // most 'max_cached_bytes_per_shard' bytes; on overflow half of it is
+  // returned to the bins in a single batch.
+  //
+  // Memory held in the caches is not reported as in use by GetStats() and
+  // is returned to the bins before a MemoryDump is recorded or an allocation
+  // is reported as having failed.
+  //
+  // Must be called before the first allocation, and is incompatible with
+  // SetTimingCounter().
+  void EnableThreadCache(int num_shards, size_t max_cached_bytes_per_shard);
+
+  // Returns all chunks parked in the thread caches to the bins.  Returns the
+  // number of bytes released.
+  size_t FlushThreadCaches();
 
   void SetSafeFrontier(uint64 count) override;
 
+  // Enables attributing the memory in use to the sites which allocated it,
+  // i.e. the op and the kind of memory (e.g. "output" or "temp") annotated by
+  // profiler::ScopedMemoryDebugAnnotation.  One in every 'sampling_period'
+  // allocations is attributed and accounts for 'sampling_period' times its
+  // size, which keeps the cost on the allocation path low.  The sites holding
+  // the most memory are logged when an allocation fails.
+  //
+  // Must be called before the first allocation, and is incompatible with
+  // EnableThreadCache().
+  void EnableMemoryAttribution(int sampling_period);
+
+  // The memory attributed to an allocation site.  The bytes and allocations
+  // are estimated from the sampled allocations.
+  struct AllocationSiteStats {
+    string op_name;
+    string region_type;
+    int64_t live_bytes = 0;
+    // The high-water mark of live_bytes.
+    int64_t peak_live_bytes = 0;
+    int64_t num_allocations = 0;
+  };
+
+  // Returns up to 'max_sites' allocation sites, sorted by decreasing live
+  // bytes and then by decreasing peak live bytes.  Empty unless
+  // EnableMemoryAttribution() was called.
+  std::vector<AllocationSiteStats> GetTopAllocationSites(int max_sites);
+
+  // Enables releasing the physical memory behind the free chunks when an
+  // allocation finds none large enough and the memory limit leaves no room to
+  // extend the regions.  The released memory is then mapped again behind a
+  // large enough range of addresses, either a range released before or a new
+  // region, so that fragmented free memory becomes usable without moving the
+  // live chunks.
+  //
+  // Requires a sub allocator that supports decommitting memory, see
+  // SubAllocator::SupportsDecommit().  Must be called before the first
+  // allocation.
+  void EnableDefragmentation();
+
   bool ShouldRecordOpName() const { return true; }
 
   MemoryDump RecordMemoryMap();
@@ -100,12 +165,80 @@ class BFCAllocator : public Allocator {
                             bool dump_log_on_failure,
                             uint64 freed_before_count);
 
+  // Serves an allocation from the bins, acquiring lock_.
+  void* AllocateRawFromBins(size_t alignment, size_t num_bytes,
+                            size_t rounded_bytes, bool dump_log_on_failure,
+                            uint64 freed_before_count);
+
   void* AllocateRawInternalWithRetry(
       size_t alignment, size_t num_bytes,
       const AllocationAttributes& allocation_attr);
 
   void DeallocateRawInternal(void* ptr);
 
+  // Thread cache implementation; see EnableThreadCache().
+  //
+  // Chunks parked in a thread cache are still in use as far as the bins are
+  // concerned.  Both the parked chunks and the live allocations that may be
+  // parked on deallocation are tracked outside of lock_: the former in a
+  // ThreadCacheShard chosen by the calling thread, the latter in a
+  // LiveChunkShard chosen by address so that a chunk can be freed by a
+  // different thread than the one that allocated it.  Both kinds of shard
+  // lock are leaf locks: no other lock is acquired while holding one.
+  static constexpr int kNumThreadCacheBins = 8;
+
+  struct CachedChunk {
+    void* ptr = nullptr;
+    size_t size = 0;
+  };
+
+  struct ThreadCacheShard {
+    mutex mu;
+    std::array<std::vector<CachedChunk>, kNumThreadCacheBins> bins
+        TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+    // Allocations served from this shard since the last ClearStats().
+    int64_t num_allocs TF_GUARDED_BY(mu) = 0;
+    int64_t largest_alloc_size TF_GUARDED_BY(mu) = 0;
+  };
+
+  struct LiveChunkInfo {
+    size_t size = 0;
+    size_t requested_size = 0;
+    int64_t allocation_id = -1;
+  };
+
+  struct LiveChunkShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, LiveChunkInfo> chunks TF_GUARDED_BY(mu);
+  };
+
+  ThreadCacheShard* ThreadCacheShardForCurrentThread();
+  LiveChunkShard* LiveChunkShardFor(const void* ptr) const;
+
+  // Returns a parked chunk of at least 'rounded_bytes' bytes, or nullptr.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes);
+
+  // Parks the chunk at 'ptr' in the calling thread's cache.  Returns false,
+  // doing nothing, if 'ptr' is not a live cacheable allocation.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Records a live allocation that was just served from the bins.
+  void RecordLiveChunk(const void* ptr, const LiveChunkInfo& info);
+
+  // Looks up the metadata of a live cacheable allocation.
+  bool FindLiveChunk(const void* ptr, LiveChunkInfo* info) const;
+
+  // Adds 'delta' bytes to the bytes in use by clients, tracking the peak.
+  void UpdateClientBytesInUse(int64_t delta);
+
+  // Returns parked chunks to the bins.
+  void ReturnCachedChunksToBins(const std::vector<CachedChunk>& chunks);
+
+  // Returns the stats as seen by clients of the allocator, i.e. excluding
+  // memory parked in the thread caches.
+  AllocatorStats ClientStats() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -148,6 +281,11 @@ class BFCAllocator : public Allocator {
   // The following means that the largest bin'd chunk size is 256 << 21 = 512MB.
   static constexpr int kNumBins = 21;
 
+  // The allocation_id of the chunks whose memory was released by
+  // defragmentation.  They count as in use so that they are never merged with
+  // free chunks nor put in a bin, but no client holds them.
+  static constexpr int64_t kDecommittedAllocationId = -2;
+
   // A Chunk points to a piece of memory that's either entirely free or entirely
   // in use by one user memory allocation.
   //
@@ -196,6 +334,14 @@ class BFCAllocator : public Allocator {
 
     bool in_use() const { return allocation_id != -1; }
 
+    bool decommitted() const {
+      return allocation_id == kDecommittedAllocationId;
+    }
+
+    // The site this chunk is attributed to while in use, if it was sampled by
+    // EnableMemoryAttribution().
+    AllocationSiteStats* site = nullptr;
+
 #ifdef TENSORFLOW_MEM_DEBUG
     // optional debugging info
     const char* op_name = nullptr;
@@ -451,13 +597,32 @@ class BFCAllocator : public Allocator {
   void DeallocateRegions(const absl::flat_hash_set<void*>& region_ptrs)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Releases the memory behind the free chunks, the largest first, until the
+  // memory limit leaves room for 'rounded_bytes', and maps it again behind the
+  // smallest fitting decommitted range or a new region.  Returns true if a
+  // free chunk of 'rounded_bytes' may now be found.  See
+  // EnableDefragmentation().
+  bool Defragment(size_t alignment, size_t rounded_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Decommits the 'num_bytes' at 'offset' in the free chunk 'h', splitting it
+  // as needed.  Returns false, leaving the chunk free, on failure.
+  bool DecommitChunk(ChunkHandle h, size_t offset, size_t num_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Maps memory behind the first 'num_bytes' of the decommitted chunk 'h',
+  // which become a free chunk.
+  bool RecommitChunk(ChunkHandle h, size_t num_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Returns a pointer to an underlying allocated chunk of size
   // 'rounded_bytes'.
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
                      uint64 freed_before) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Splits the chunk specified by 'h' into two chunks, one at least
-  // of size 'num_bytes'.
+  // of size 'num_bytes'.  'h' is either free or decommitted, and the second
+  // chunk is free, and put in a bin, or decommitted alike.
   void SplitChunk(ChunkHandle h, size_t num_bytes)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -495,6 +660,13 @@ class BFCAllocator : public Allocator {
 
   void MarkFree(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Attributes the newly allocated 'chunk' to the current allocation site if
+  // it is sampled.
+  void MaybeAttributeChunk(Chunk* chunk) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  std::vector<AllocationSiteStats> GetTopAllocationSitesInternal(int max_sites)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -572,6 +744,14 @@ class BFCAllocator : public Allocator {
   // memory fragmentation.
   const bool garbage_collection_;
 
+  // Whether the allocator will decommit free chunks to avoid OOM due to memory
+  // fragmentation, see EnableDefragmentation().
+  bool defragmentation_enabled_ = false;
+
+  // The bytes of the decommitted chunks, which total_region_allocated_bytes_
+  // doesn't count.
+  size_t decommitted_bytes_ = 0;
+
   // Whether the allocator will coalesce adjacent sub allocator provided
   // AllocationRegions. This may be disabled if discrete sub allocator
   // regions can't be treated as contiguous (e.g. if the allocation refers to
@@ -598,8 +778,9 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ TF_GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64_t next_allocation_id_ TF_GUARDED_BY(lock_);
+  // newly-created chunk.  Atomic so that the thread cache can assign ids
+  // without acquiring lock_.
+  std::atomic<int64_t> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
@@ -609,6 +790,25 @@ class BFCAllocator : public Allocator {
   int64 size_history_[MEM_DEBUG_SIZE_HISTORY_SIZE];
 #endif
 
+  // Thread cache state.  Immutable after EnableThreadCache().
+  bool thread_cache_enabled_ = false;
+  size_t max_cached_bytes_per_shard_ = 0;
+  std::vector<std::unique_ptr<ThreadCacheShard>> thread_cache_shards_;
+  std::vector<std::unique_ptr<LiveChunkShard>> live_chunk_shards_;
+
+  // Bytes in use by clients, and its high-water mark since the last
+  // ClearStats(), maintained only when the thread cache is enabled.
+  std::atomic<int64_t> client_bytes_in_use_{0};
+  std::atomic<int64_t> client_peak_bytes_in_use_{0};
+
+  // Memory attribution state.  The sampling period is immutable after
+  // EnableMemoryAttribution(), and 0 when attribution is disabled.
+  int attribution_sampling_period_ = 0;
+  int64_t num_attribution_candidates_ TF_GUARDED_BY(lock_) = 0;
+  absl::flat_hash_map<std::pair<string, string>,
+                      std::unique_ptr<AllocationSiteStats>>
+      allocation_sites_ TF_GUARDED_BY(lock_);
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   friend class GPUBFCAllocatorPrivateMethodsTest_SubAllocatorSpecific;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
@@ -0,0 +1,379 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/profiler/lib/scoped_memory_debug_annotation.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+
+namespace tensorflow {
+namespace {
+
+SubAllocator* CreateCPUSubAllocator() {
+  return new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+}
+
+void CheckStats(Allocator* a, int64_t num_allocs, int64_t bytes_in_use,
+                int64_t peak_bytes_in_use, int64_t largest_alloc_size) {
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_allocs, num_allocs);
+  EXPECT_EQ(stats->bytes_in_use, bytes_in_use);
+  EXPECT_EQ(stats->peak_bytes_in_use, peak_bytes_in_use);
+  EXPECT_EQ(stats->largest_alloc_size, largest_alloc_size);
+}
+
+TEST(BFCAllocatorTest, AllocateAndFree) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(a.RequestedSize(p), 1000);
+  EXPECT_EQ(a.AllocatedSize(p), 1024);
+  CheckStats(&a, 1, 1024, 1024, 1024);
+  a.DeallocateRaw(p);
+  CheckStats(&a, 1, 0, 1024, 1024);
+}
+
+TEST(BFCAllocatorTest, ReportsPoolBytes) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  EXPECT_EQ(*a.GetStats()->pool_bytes, 0);
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(p, nullptr);
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  EXPECT_GE(*stats->pool_bytes, 1024);
+  EXPECT_EQ(*stats->peak_pool_bytes, *stats->pool_bytes);
+  a.DeallocateRaw(p);
+  // The region stays in the pool after the free.
+  EXPECT_EQ(*a.GetStats()->pool_bytes, *stats->pool_bytes);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesChunks) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/4,
+                      /*max_cached_bytes_per_shard=*/64 << 10);
+
+  void* p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(p1, nullptr);
+  a.DeallocateRaw(p1);
+  CheckStats(&a, 1, 0, 1024, 1024);
+
+  // The parked chunk is handed back out, with the new requested size.
+  void* p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(a.RequestedSize(p2), 900);
+  EXPECT_EQ(a.AllocatedSize(p2), 1024);
+  EXPECT_GT(a.AllocationId(p2), 1);
+  CheckStats(&a, 2, 1024, 1024, 1024);
+  a.DeallocateRaw(p2);
+  CheckStats(&a, 2, 0, 1024, 1024);
+
+  EXPECT_EQ(a.FlushThreadCaches(), 1024);
+  EXPECT_EQ(a.FlushThreadCaches(), 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheLargeAllocationsBypassCache) {
+  BFCAllocator a(CreateCPUSubAllocator(), 16 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/1, /*max_cached_bytes_per_shard=*/1 << 20);
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(p, nullptr);
+  a.DeallocateRaw(p);
+  CheckStats(&a, 1, 0, 1 << 20, 1 << 20);
+  EXPECT_EQ(a.FlushThreadCaches(), 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheOverflowIsFlushed) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/1, /*max_cached_bytes_per_shard=*/8 << 10);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 1024));
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  CheckStats(&a, 16, 0, 16 << 10, 1024);
+  // Overflowing the shard returns half of it to the bins, so it never holds
+  // more than its limit.
+  EXPECT_LE(a.FlushThreadCaches(), 8 << 10);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheFlushedBeforeOOM) {
+  BFCAllocator a(CreateCPUSubAllocator(), 64 << 10, /*allow_growth=*/false,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/1, /*max_cached_bytes_per_shard=*/1 << 20);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 4 << 10);
+    ASSERT_NE(p, nullptr);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  // All of the memory is parked in the cache; a large request must still
+  // succeed.
+  AllocationAttributes attrs;
+  attrs.retry_on_failure = false;
+  void* big = a.AllocateRaw(Allocator::kAllocatorAlignment, 32 << 10, attrs);
+  ASSERT_NE(big, nullptr);
+  a.DeallocateRaw(big);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheMemoryDump) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/2, /*max_cached_bytes_per_shard=*/1 << 20);
+  void* live = a.AllocateRaw(Allocator::kAllocatorAlignment, 2000);
+  void* parked = a.AllocateRaw(Allocator::kAllocatorAlignment, 3000);
+  a.DeallocateRaw(parked);
+
+  MemoryDump md = a.RecordMemoryMap();
+  EXPECT_EQ(md.stats().num_allocs(), 2);
+  EXPECT_EQ(md.stats().bytes_in_use(), 2048);
+  int64_t in_use_chunks = 0;
+  for (const MemChunk& chunk : md.chunk()) {
+    if (chunk.in_use()) {
+      ++in_use_chunks;
+      EXPECT_EQ(chunk.address(), reinterpret_cast<uint64>(live));
+      EXPECT_EQ(chunk.requested_size(), 2000);
+    }
+  }
+  EXPECT_EQ(in_use_chunks, 1);
+  a.DeallocateRaw(live);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheConcurrentAllocations) {
+  BFCAllocator a(CreateCPUSubAllocator(), 256 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableThreadCache(/*num_shards=*/8,
+                      /*max_cached_bytes_per_shard=*/256 << 10);
+  constexpr int kNumThreads = 8;
+  {
+    thread::ThreadPool pool(Env::Default(), "bfc_test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(t, 17);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 10000; ++i) {
+          if (ptrs.empty() || rand.Uniform(3) != 0) {
+            const size_t size = rand.Uniform(32 << 10) + 1;
+            void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, size);
+            ASSERT_NE(p, nullptr);
+            EXPECT_EQ(a.RequestedSize(p), size);
+            ptrs.push_back(p);
+          } else {
+            const int j = rand.Uniform(ptrs.size());
+            a.DeallocateRaw(ptrs[j]);
+            ptrs[j] = ptrs.back();
+            ptrs.pop_back();
+          }
+        }
+        for (void* p : ptrs) {
+          a.DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->bytes_in_use, 0);
+  a.FlushThreadCaches();
+  MemoryDump md = a.RecordMemoryMap();
+  for (const MemChunk& chunk : md.chunk()) {
+    EXPECT_FALSE(chunk.in_use());
+  }
+}
+
+TEST(BFCAllocatorTest, MemoryAttribution) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableMemoryAttribution(/*sampling_period=*/1);
+  void* p1;
+  void* p2;
+  void* p3;
+  {
+    profiler::ScopedMemoryDebugAnnotation annotation(
+        "matmul", /*step_id=*/1, "output", /*data_type=*/1,
+        []() { return std::string(); });
+    p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  }
+  {
+    profiler::ScopedMemoryDebugAnnotation annotation("conv");
+    p3 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  }
+  a.DeallocateRaw(p2);
+
+  std::vector<BFCAllocator::AllocationSiteStats> sites =
+      a.GetTopAllocationSites(/*max_sites=*/10);
+  ASSERT_EQ(sites.size(), 2);
+  EXPECT_EQ(sites[0].op_name, "matmul");
+  EXPECT_EQ(sites[0].region_type, "output");
+  EXPECT_EQ(sites[0].live_bytes, 4096);
+  EXPECT_EQ(sites[0].peak_live_bytes, 8192);
+  EXPECT_EQ(sites[0].num_allocations, 2);
+  EXPECT_EQ(sites[1].op_name, "conv");
+  EXPECT_EQ(sites[1].region_type, "");
+  EXPECT_EQ(sites[1].live_bytes, 1024);
+  EXPECT_EQ(sites[1].peak_live_bytes, 1024);
+  EXPECT_EQ(sites[1].num_allocations, 1);
+
+  a.DeallocateRaw(p1);
+  a.DeallocateRaw(p3);
+  // Without live bytes, the sites are sorted by their high-water marks.
+  sites = a.GetTopAllocationSites(/*max_sites=*/1);
+  ASSERT_EQ(sites.size(), 1);
+  EXPECT_EQ(sites[0].op_name, "matmul");
+  EXPECT_EQ(sites[0].live_bytes, 0);
+  EXPECT_EQ(sites[0].peak_live_bytes, 8192);
+}
+
+TEST(BFCAllocatorTest, SampledMemoryAttribution) {
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 20, /*allow_growth=*/true,
+                 "cpu_bfc");
+  a.EnableMemoryAttribution(/*sampling_period=*/4);
+  profiler::ScopedMemoryDebugAnnotation annotation("matmul");
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 8; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 1024));
+  }
+  // Two allocations are sampled, each accounting for four.
+  std::vector<BFCAllocator::AllocationSiteStats> sites =
+      a.GetTopAllocationSites(/*max_sites=*/10);
+  ASSERT_EQ(sites.size(), 1);
+  EXPECT_EQ(sites[0].live_bytes, 8192);
+  EXPECT_EQ(sites[0].num_allocations, 8);
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  sites = a.GetTopAllocationSites(/*max_sites=*/10);
+  ASSERT_EQ(sites.size(), 1);
+  EXPECT_EQ(sites[0].live_bytes, 0);
+  EXPECT_EQ(sites[0].peak_live_bytes, 8192);
+}
+
+// A sub-allocator that pretends to release the pages it decommits.
+class DecommittingSubAllocator : public SubAllocator {
+ public:
+  static constexpr size_t kGranularity = 4096;
+
+  DecommittingSubAllocator() : SubAllocator({}, {}) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    *bytes_received = num_bytes;
+    return port::AlignedMalloc(num_bytes, kGranularity);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+  bool SupportsCoalescing() const override { return false; }
+
+  bool SupportsDecommit() const override { return true; }
+  size_t DecommitGranularity() const override { return kGranularity; }
+  bool Decommit(void* ptr, size_t num_bytes) override {
+    decommitted_bytes += num_bytes;
+    return true;
+  }
+  bool Recommit(void* ptr, size_t num_bytes) override {
+    decommitted_bytes -= num_bytes;
+    return true;
+  }
+
+  size_t decommitted_bytes = 0;
+};
+
+TEST(BFCAllocatorTest, DefragmentationDecommitsFreeChunks) {
+  auto* sub_allocator = new DecommittingSubAllocator;
+  BFCAllocator a(sub_allocator, 1 << 20, /*allow_growth=*/false, "cpu_bfc");
+  a.EnableDefragmentation();
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 64 << 10));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  a.DeallocateRaw(ptrs[1]);
+  a.DeallocateRaw(ptrs[3]);
+
+  // Neither hole fits, so both are decommitted to map a new region.
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 128 << 10);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(sub_allocator->decommitted_bytes, 128 << 10);
+  EXPECT_EQ(*a.GetStats()->pool_bytes, 1 << 20);
+  a.DeallocateRaw(p);
+
+  // Decommitting the chunk between the holes merges them, and the addresses
+  // of the holes are used again.
+  a.DeallocateRaw(ptrs[2]);
+  p = a.AllocateRaw(Allocator::kAllocatorAlignment, 192 << 10);
+  EXPECT_EQ(p, ptrs[1]);
+  EXPECT_EQ(sub_allocator->decommitted_bytes, 128 << 10);
+  EXPECT_EQ(*a.GetStats()->pool_bytes, 1 << 20);
+  EXPECT_EQ(a.GetStats()->bytes_in_use, (13 << 16) + (192 << 10));
+
+  a.DeallocateRaw(p);
+  for (int i = 0; i < 16; ++i) {
+    if (i < 1 || i > 3) a.DeallocateRaw(ptrs[i]);
+  }
+}
+
+TEST(BFCAllocatorTest, DefragmentationRespectsMemoryLimit) {
+  BFCAllocator a(new DecommittingSubAllocator, 1 << 20,
+                 /*allow_growth=*/false, "cpu_bfc");
+  a.EnableDefragmentation();
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 64 << 10));
+  }
+  a.DeallocateRaw(ptrs[1]);
+  // The free bytes are less than requested.
+  EXPECT_EQ(a.AllocateRaw(Allocator::kAllocatorAlignment, 128 << 10),
+            nullptr);
+  for (int i = 0; i < 16; ++i) {
+    if (i != 1) a.DeallocateRaw(ptrs[i]);
+  }
+}
+
+void BM_AllocateDeallocate(::testing::benchmark::State& state) {
+  const bool thread_cache = state.range(0);
+  BFCAllocator a(CreateCPUSubAllocator(), 1 << 30, /*allow_growth=*/true,
+                 "cpu_bfc");
+  if (thread_cache) {
+    a.EnableThreadCache(/*num_shards=*/1,
+                        /*max_cached_bytes_per_shard=*/1 << 20);
+  }
+  for (auto s : state) {
+    void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    a.DeallocateRaw(p);
+  }
+}
+BENCHMARK(BM_AllocateDeallocate)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
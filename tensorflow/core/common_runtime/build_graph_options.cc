@@ -32,6 +32,15 @@ string BuildGraphOptions::DebugString() const {
   for (auto& s : callable_options.target()) {
     strings::StrAppend(&rv, s, ", ");
   }
+  if (!feed_shapes.empty()) {
+    strings::StrAppend(&rv, "\nFeed shapes: ");
+    for (const string& s : callable_options.feed()) {
+      auto it = feed_shapes.find(s);
+      if (it != feed_shapes.end()) {
+        strings::StrAppend(&rv, s, ":", it->second.DebugString(), ", ");
+      }
+    }
+  }
   if (collective_graph_key != kNoCollectiveGraphKey) {
     strings::StrAppend(&rv, "\ncollective_graph_key: ", collective_graph_key);
   }
@@ -622,6 +622,30 @@ void CollectiveParamResolverLocal::CompleteInstanceAsync(
                        "intended only for non-distributed deployment."));
 }
 
+// A hierarchical reduction pays off when a group spans several tasks that each
+// have several GPUs: NCCL handles the fast intra-task links and only a shard of
+// the tensor crosses the network from each device.
+bool CollectiveParamResolverLocal::UseHierarchicalReduce(
+    const CollectiveParams& cp) const {
+  const string& hint = cp.instance.impl_details.communication_hint;
+  if (hint != "auto" && hint != "hierarchical") {
+    return false;
+  }
+  if (cp.instance.type != REDUCTION_COLLECTIVE ||
+      cp.group.device_type != DEVICE_GPU || nccl_communicator_ == nullptr ||
+      cp.group.num_tasks < 2 || !cp.group.same_num_devices_per_task ||
+      cp.group.group_size / cp.group.num_tasks < 2) {
+    return false;
+  }
+  CollectiveImplementationInterface* col_impl;
+  return CollectiveRegistry::LookupParamResolverInstance("NcclReduce",
+                                                         &col_impl)
+             .ok() &&
+         CollectiveRegistry::LookupParamResolverInstance("HierarchicalReduce",
+                                                         &col_impl)
+             .ok();
+}
+
 // TODO(b/111897089): we need a better way to pick the collective
 // implementation.  The ideal way would depend upon the topology and link
 // strength before picking a particular implementation.
@@ -639,6 +663,9 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  if (UseHierarchicalReduce(*cp)) {
+    cp->instance.impl_details.collective_name = "HierarchicalReduce";
+  }
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
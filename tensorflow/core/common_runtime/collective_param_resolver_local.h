@@ -180,6 +180,10 @@ class CollectiveParamResolverLocal : public ParamResolverInterface {
   // best implementation.
   void AssignCollectiveType(CollectiveParams* cp);
 
+  // Returns true if `cp` is a reduction whose group layout suits
+  // HierarchicalReduce.
+  bool UseHierarchicalReduce(const CollectiveParams& cp) const;
+
   void StartAbortLocal(const Status& s)
       TF_LOCKS_EXCLUDED(status_mu_, group_mu_, instance_mu_);
 
@@ -21,6 +21,8 @@ namespace tensorflow {
 // Types of per-request cost.
 constexpr char kTpuCostName[] = "tpu";
 constexpr char kNoOpCostName[] = "no_op";
+// Time the RunHandler pool threads spent running the closures of a request.
+constexpr char kRunHandlerCostName[] = "run_handler";
 
 // Each type of per-request cost could have the following versions.
 //
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/cost_util.h"
 
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_split.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/request_cost_accessor_registry.h"
 
@@ -22,10 +26,15 @@ namespace tensorflow {
 
 namespace {
 
-// Gets the type of CostMeasurement from env.
-const char* GetCostMeasurementType() {
-  static const char* type = std::getenv("TF_COST_MEASUREMENT_TYPE");
-  return type;
+// Gets the types of CostMeasurement from env.
+const std::vector<std::string>& GetCostMeasurementTypes() {
+  static const std::vector<std::string>* types = [] {
+    const char* types = std::getenv("TF_COST_MEASUREMENT_TYPE");
+    if (types == nullptr) return new std::vector<std::string>();
+    return new std::vector<std::string>(
+        absl::StrSplit(types, ',', absl::SkipEmpty()));
+  }();
+  return *types;
 }
 
 // Gets the type of RequestCostAccessor from env.
@@ -36,11 +45,16 @@ const char* GetRequestCostAccessorType() {
 
 }  // namespace
 
-std::unique_ptr<CostMeasurement> CreateCostMeasurement() {
-  const char* cost_measurement_type = GetCostMeasurementType();
-  return cost_measurement_type ? CostMeasurementRegistry::CreateByNameOrNull(
-                                     cost_measurement_type)
-                               : nullptr;
+std::vector<std::unique_ptr<CostMeasurement>> CreateCostMeasurements() {
+  std::vector<std::unique_ptr<CostMeasurement>> cost_measurements;
+  for (const std::string& type : GetCostMeasurementTypes()) {
+    std::unique_ptr<CostMeasurement> cost_measurement =
+        CostMeasurementRegistry::CreateByNameOrNull(type);
+    if (cost_measurement) {
+      cost_measurements.push_back(std::move(cost_measurement));
+    }
+  }
+  return cost_measurements;
 }
 
 std::unique_ptr<RequestCostAccessor> CreateRequestCostAccessor() {
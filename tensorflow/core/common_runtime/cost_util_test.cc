@@ -30,20 +30,30 @@ class TestCostMeasurement : public CostMeasurement {
 };
 REGISTER_COST_MEASUREMENT("test", TestCostMeasurement);
 
+class OtherTestCostMeasurement : public CostMeasurement {
+ public:
+  absl::Duration GetTotalCost() override { return absl::ZeroDuration(); }
+  absl::string_view GetCostType() const override { return "other_test"; }
+};
+REGISTER_COST_MEASUREMENT("other_test", OtherTestCostMeasurement);
+
 class TestRequestCostAccessor : public RequestCostAccessor {
  public:
   RequestCost* GetRequestCost() const override { return nullptr; }
 };
 REGISTER_REQUEST_COST_ACCESSOR("test", TestRequestCostAccessor);
 
-TEST(CreateCostMeasurementTest, Basic) {
-  setenv("TF_COST_MEASUREMENT_TYPE", "test", /*overwrite=*/1);
-  std::unique_ptr<CostMeasurement> test_cost_measurement =
-      CreateCostMeasurement();
+TEST(CreateCostMeasurementsTest, Basic) {
+  setenv("TF_COST_MEASUREMENT_TYPE", "test,unregistered,other_test",
+         /*overwrite=*/1);
+  std::vector<std::unique_ptr<CostMeasurement>> test_cost_measurements =
+      CreateCostMeasurements();
 
-  ASSERT_NE(test_cost_measurement, nullptr);
-  EXPECT_EQ(test_cost_measurement->GetTotalCost(), absl::ZeroDuration());
-  EXPECT_EQ(test_cost_measurement->GetCostType(), "test");
+  ASSERT_EQ(test_cost_measurements.size(), 2);
+  EXPECT_EQ(test_cost_measurements[0]->GetTotalCost(), absl::ZeroDuration());
+  EXPECT_EQ(test_cost_measurements[0]->GetCostType(), "test");
+  EXPECT_EQ(test_cost_measurements[1]->GetTotalCost(), absl::ZeroDuration());
+  EXPECT_EQ(test_cost_measurements[1]->GetCostType(), "other_test");
 }
 
 TEST(CreateRequestCostAccessorTest, Basic) {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -28,6 +29,23 @@ namespace {
 //  - Should EventMgrs be shared between devices on a machine with multiple
 //  devices of the same type?
 static const int kNumThreads = 2;
+
+// The polling delay is polling_active_delay_usecs with one queued function,
+// half of it with this many more, a third with twice as many more, etc.
+constexpr int64_t kPendingPerDelayHalving = 8;
+
+auto* callback_delay = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/device_event_mgr/callback_delay_usecs",
+     "The time from queueing the oldest function waiting for an event with "
+     "ThenExecute to its execution being scheduled, in microseconds."},
+    // 1us to ~8s.
+    monitoring::Buckets::Exponential(1, 2, 24));
+
+auto* funcs_per_event = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/device_event_mgr/funcs_per_event",
+     "The number of functions queued with ThenExecute that waited for the "
+     "same event."},
+    monitoring::Buckets::Exponential(1, 2, 16));
 }  // namespace
 
 namespace device_event_mgr {
@@ -107,11 +125,38 @@ EventMgr::~EventMgr() {
   for (auto& e : free_events_) {
     delete e;
   }
-  while (!used_events_.empty()) {
-    InUse* ue = &used_events_[0];
-    delete ue->event;
-    if (ue->func != nullptr) threadpool_.Schedule(ue->func);
-    used_events_.pop_front();
+  for (auto& stream_events : used_events_) {
+    for (InUse& iu : stream_events.second) {
+      delete iu.event;
+      for (auto& func : iu.funcs) {
+        if (func != nullptr) threadpool_.Schedule(std::move(func));
+      }
+    }
+  }
+  PendingFunc* pending = pending_funcs_.exchange(nullptr);
+  while (pending != nullptr) {
+    if (pending->func != nullptr) {
+      threadpool_.Schedule(std::move(pending->func));
+    }
+    PendingFunc* next = pending->next;
+    delete pending;
+    pending = next;
+  }
+}
+
+void EventMgr::ThenExecute(se::Stream* stream, std::function<void()> func) {
+  PendingFunc* pending =
+      new PendingFunc{stream, std::move(func), Env::Default()->NowMicros(),
+                      pending_funcs_.load(std::memory_order_relaxed)};
+  while (!pending_funcs_.compare_exchange_weak(pending->next, pending,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+  }
+  // The polling thread only waits when no function is pending, so only the
+  // first one needs to wake it up.
+  if (num_pending_.fetch_add(1, std::memory_order_relaxed) == 0) {
+    mutex_lock l(mu_);
+    events_pending_.notify_all();
   }
 }
 
@@ -139,50 +184,58 @@ void EventMgr::StopPollingLoop() {
 
 // A polling loop to detect completion of device events.
 //
-// While one or more events is outstanding, poll for completed events.  When no
-// events are outstanding, we sleep until one is enqueued.
+// While one or more functions is pending, poll for completed events.  When no
+// functions are pending, we sleep until one is enqueued.
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
   while (true) {
-    bool events_still_pending;
     {
       mutex_lock l(mu_);
       if (stop_polling_) {
         break;
       }
-      if (used_events_.empty()) {
+      if (num_pending_.load(std::memory_order_relaxed) == 0) {
         events_pending_.wait(l);
+        continue;
       }
-      PollEvents(true, &to_free);
-      events_still_pending = !used_events_.empty();
+      PollEvents(&to_free);
     }
-    FreeMemory(to_free);
-    to_free.clear();
+    FreeMemory(&to_free);
 
-    if (events_still_pending) {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+    const int64_t num_pending = num_pending_.load(std::memory_order_relaxed);
+    if (num_pending > 0) {
+      const int64_t delay_usecs = PollingDelayUsecs(num_pending);
+      if (delay_usecs > 0) Env::Default()->SleepForMicroseconds(delay_usecs);
     }
   }
   polling_stopped_->Notify();
 }
 
-void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
-  VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
-          << " used_events_ " << used_events_.size();
-  // Events are created on demand, and repeatedly reused.  There is no
-  // limit placed here on the number of allocated Events.
-  if (free_events_.empty()) {
-    free_events_.push_back(new se::Event(exec_));
-    free_events_.back()->Init();
+int64_t EventMgr::PollingDelayUsecs(int64_t num_pending) const {
+  return polling_active_delay_usecs_ * kPendingPerDelayHalving /
+         (kPendingPerDelayHalving + num_pending - 1);
+}
+
+void EventMgr::FreeMemory(ToFreeVector* to_free) {
+  if (to_free->empty()) return;
+  const uint64 now_micros = Env::Default()->NowMicros();
+  std::vector<std::function<void()>> funcs;
+  for (InUse& iu : *to_free) {
+    callback_delay->GetCell()->Add(now_micros - iu.enqueue_micros);
+    funcs_per_event->GetCell()->Add(iu.funcs.size());
+    for (auto& func : iu.funcs) {
+      if (func != nullptr) funcs.push_back(std::move(func));
+    }
+  }
+  to_free->clear();
+  // The functions must be called in another thread.  They are scheduled
+  // together, since they would run one after the other in the single
+  // callback thread anyway.
+  if (!funcs.empty()) {
+    threadpool_.Schedule([funcs = std::move(funcs)]() {
+      for (const auto& func : funcs) func();
+    });
   }
-  se::Event* e = free_events_.back();
-  free_events_.pop_back();
-  stream->ThenRecordEvent(e);
-  in_use.event = e;
-  bool was_empty = used_events_.empty();
-  used_events_.push_back(in_use);
-  // Maybe wake up the polling thread
-  if (was_empty) events_pending_.notify_all();
 }
 
 // This function must be called periodically to check whether pending
@@ -193,52 +246,75 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
 // is used to cap pending kernels there should never be more than
 // that many.)
 //
-// NOTE: If all events are on the same stream, no later event will
-// complete before an earlier event, except possibly if the earlier
-// event transitions to an error state, so there's no advantage in
-// looking past the first kPending event.  However, if we're using
-// multiple streams there may be some gain in looking deeper.
-// As a compromise, PollEvent() calls that are triggered by the queueing
-// of a single event never look past the first kPending event.  Consequently
-// those calls do an expected constant amount of work, unaffected by the
-// length of the pending queue.  Calls coming from the dedicated
-// polling thread always sweep the full queue.
-void EventMgr::PollEvents(bool is_dedicated_poller,
-                          gtl::InlinedVector<InUse, 4>* to_free) {
+// The functions queued on a stream since the last poll were all queued
+// before the event recorded here, so one event serves them all.  At high
+// kernel rates this records far fewer events than one per function, at the
+// cost of executing the functions up to one polling delay later.
+//
+// NOTE: No later event of a stream will complete before an earlier event,
+// except possibly if the earlier event transitions to an error state, so
+// the sweep of each stream stops at its first kPending event.
+void EventMgr::PollEvents(ToFreeVector* to_free) {
+  // Takes the functions queued since the last poll, and puts them back in
+  // the order they were queued in.
+  PendingFunc* pending =
+      pending_funcs_.exchange(nullptr, std::memory_order_acquire);
+  PendingFunc* oldest = nullptr;
+  while (pending != nullptr) {
+    PendingFunc* next = pending->next;
+    pending->next = oldest;
+    oldest = pending;
+    pending = next;
+  }
+  absl::flat_hash_map<se::Stream*, InUse*> new_events;
+  while (oldest != nullptr) {
+    InUse*& in_use = new_events[oldest->stream];
+    if (in_use == nullptr) {
+      std::deque<InUse>& stream_events = used_events_[oldest->stream];
+      stream_events.push_back({nullptr, {}, oldest->enqueue_micros});
+      in_use = &stream_events.back();
+    }
+    in_use->funcs.push_back(std::move(oldest->func));
+    PendingFunc* next = oldest->next;
+    delete oldest;
+    oldest = next;
+  }
+  for (auto& new_event : new_events) {
+    // Events are created on demand, and repeatedly reused.  There is no
+    // limit placed here on the number of allocated Events.
+    if (free_events_.empty()) {
+      free_events_.push_back(new se::Event(exec_));
+      free_events_.back()->Init();
+    }
+    se::Event* e = free_events_.back();
+    free_events_.pop_back();
+    new_event.first->ThenRecordEvent(e);
+    new_event.second->event = e;
+  }
   VLOG(2) << "PollEvents  free_events_ " << free_events_.size()
-          << " used_events_ " << used_events_.size();
-  // Sweep the remaining events in order.  If this is the dedicated
-  // polling thread, check the entire set.  Otherwise, just sweep up to
-  // the first non-complete record that is still pending.
-  for (auto& iu : used_events_) {
-    if (iu.event == nullptr) continue;
-    se::Event::Status s = iu.event->PollForStatus();
-    switch (s) {
-      case se::Event::Status::kUnknown:
-      case se::Event::Status::kError:
+          << " streams " << used_events_.size() << " new events "
+          << new_events.size();
+
+  for (auto it = used_events_.begin(); it != used_events_.end();) {
+    std::deque<InUse>& stream_events = it->second;
+    while (!stream_events.empty()) {
+      InUse& iu = stream_events.front();
+      se::Event::Status s = iu.event->PollForStatus();
+      if (s == se::Event::Status::kPending) break;
+      if (s != se::Event::Status::kComplete) {
         // We don't expect to see these.  Someday maybe propagate
         // a Status error, but for now fail hard.
         LOG(FATAL) << "Unexpected Event status: " << static_cast<int>(s);
-        break;
-      case se::Event::Status::kPending:
-        if (!is_dedicated_poller) return;  // quit processing queue
-        break;
-      case se::Event::Status::kComplete:
-        // Make a copy of the InUse record so we can free it after releasing
-        // the lock
-        to_free->push_back(iu);
-        free_events_.push_back(iu.event);
-        // Mark this InUse record as completed.
-        iu.event = nullptr;
+      }
+      free_events_.push_back(iu.event);
+      num_pending_.fetch_sub(iu.funcs.size(), std::memory_order_relaxed);
+      to_free->push_back(std::move(iu));
+      stream_events.pop_front();
     }
-  }
-  // Then clear any completed InUse records from the front of the queue.
-  while (!used_events_.empty()) {
-    InUse& iu = used_events_.front();
-    if (iu.event == nullptr) {
-      used_events_.pop_front();
+    if (stream_events.empty()) {
+      used_events_.erase(it++);
     } else {
-      break;
+      ++it;
     }
   }
 }
@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_DEVICE_EVENT_MGR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_DEVICE_EVENT_MGR_H_
 
+#include <atomic>
 #include <deque>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -70,15 +72,11 @@ class EventMgr {
   // Execute func when all pending stream actions have completed.
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
-  inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
-    ToFreeVector to_free;
-    {
-      mutex_lock l(mu_);
-      QueueFunc(stream, std::move(func));
-      PollEvents(false, &to_free);
-    }
-    FreeMemory(to_free);
-  }
+  //
+  // This only queues func without taking a lock.  The polling thread records
+  // one event on the stream for all the functions queued on it since its
+  // last poll, so the stream must outlive the execution of func.
+  void ThenExecute(se::Stream* stream, std::function<void()> func);
 
  private:
   friend class TEST_EventMgr;
@@ -89,40 +87,41 @@ class EventMgr {
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
+  // A function queued by ThenExecute, that the polling thread hasn't seen
+  // yet.
+  struct PendingFunc {
+    se::Stream* stream;
+    std::function<void()> func;
+    uint64 enqueue_micros;
+    PendingFunc* next;
+  };
+
+  // The functions queued on a stream between two polls, which all wait for
+  // the same event.
   struct InUse {
     se::Event* event;
-    std::function<void()> func;
+    std::vector<std::function<void()>> funcs;
+    // When the oldest function was queued.
+    uint64 enqueue_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
 
   EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options);
 
-  void FreeMemory(const ToFreeVector& to_free) {
-    for (const auto& iu : to_free) {
-      // The function must be called in another thread.
-      if (iu.func != nullptr) threadpool_.Schedule(iu.func);
-    }
-  }
-
-  // Stream-enqueue an unused Event and save with it a collection of
-  // Tensors and/or a BufRec to be deleted only after the Event
-  // records.
-  void QueueInUse(se::Stream* stream, InUse in_use)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
-
-  void QueueFunc(se::Stream* stream, std::function<void()> func)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, std::move(func)});
-  }
-
-  // This function should be called at roughly the same tempo as
-  // QueueTensors() to check whether pending events have recorded,
-  // and then retire them.  It appends InUse elements that need cleanup
+  // Executes the functions of the completed events in another thread, and
+  // clears "*to_free".
+  void FreeMemory(ToFreeVector* to_free);
+
+  // Records an event on each stream with newly queued functions, and retires
+  // the completed events.  It appends InUse elements that need cleanup
   // to "*to_free".  The caller should call FreeMemory(to_free)
   // when this returns.
-  void PollEvents(bool is_dedicated_poller, ToFreeVector* to_free)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void PollEvents(ToFreeVector* to_free) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // The delay before the next poll, which shrinks as the queued functions
+  // pile up so that deep queues are drained sooner.
+  int64_t PollingDelayUsecs(int64_t num_pending) const;
 
   // An internal polling loop that runs at a low frequency to clear
   // straggler Events.
@@ -132,11 +131,19 @@ class EventMgr {
   void StartPollingLoop();
   void StopPollingLoop();
 
+  // The functions queued by ThenExecute, newest first.  Pushed to without a
+  // lock, and taken all at once by the polling thread.
+  std::atomic<PendingFunc*> pending_funcs_{nullptr};
+
+  // The number of queued functions that have yet to be executed.
+  std::atomic<int64_t> num_pending_{0};
+
   // A stack of unused events
   std::vector<se::Event*> free_events_ TF_GUARDED_BY(mu_);
 
-  // A FIFO queue of InUse events and associated tensors.
-  std::deque<InUse> used_events_ TF_GUARDED_BY(mu_);
+  // A FIFO queue of InUse events per stream.
+  absl::flat_hash_map<se::Stream*, std::deque<InUse>> used_events_
+      TF_GUARDED_BY(mu_);
 
   bool stop_polling_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
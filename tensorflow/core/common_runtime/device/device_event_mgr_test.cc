@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -53,10 +54,7 @@ class TEST_EventMgrHelper {
     StopPollingLoop();
   }
 
-  size_t queue_size() {
-    mutex_lock l(em_->mu_);
-    return em_->used_events_.size();
-  }
+  size_t queue_size() { return em_->num_pending_.load(); }
 
   size_t free_size() {
     mutex_lock l(em_->mu_);
@@ -71,9 +69,9 @@ class TEST_EventMgrHelper {
       EventMgr::ToFreeVector to_free;
       {
         mutex_lock l(em_->mu_);
-        em_->PollEvents(true, &to_free);
+        em_->PollEvents(&to_free);
       }
-      em_->FreeMemory(to_free);
+      em_->FreeMemory(&to_free);
     }
   }
 
@@ -138,6 +136,26 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Functions queued on a stream between two polls wait for the same event.
+TEST(EventMgr, BatchesFunctionsPerStream) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  TEST_EventMgr em(stream_exec, GPUOptions());
+  TEST_EventMgrHelper th(&em);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  BlockingCounter counter(10);
+  for (int i = 0; i < 10; ++i) {
+    em.ThenExecute(stream.get(), [&counter]() { counter.DecrementCount(); });
+  }
+  EXPECT_EQ(10, th.queue_size());
+  EXPECT_EQ(0, th.free_size());
+  th.PollEvents();
+  counter.Wait();
+  EXPECT_EQ(0, th.queue_size());
+  EXPECT_EQ(1, th.free_size());
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
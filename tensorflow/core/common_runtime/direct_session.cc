@@ -20,12 +20,15 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/common_runtime/constant_folding.h"
+#include "tensorflow/core/common_runtime/cost_constants.h"
+#include "tensorflow/core/common_runtime/cost_util.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
@@ -38,7 +41,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/common_runtime/request_cost.h"
+#include "tensorflow/core/common_runtime/request_cost_accessor.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/common_runtime/single_threaded_executor.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -62,6 +69,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/threadpool_options.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -347,11 +355,16 @@ DirectSession::DirectSession(const SessionOptions& options,
   }
   // The default value of sync_on_finish will be flipped soon and this
   // environment variable will be removed as well.
-  const Status status =
+  Status status =
       ReadBoolFromEnvVar("TF_SYNC_ON_FINISH", true, &sync_on_finish_);
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  status = ReadInt64FromEnvVar("TF_PARTITION_MAX_COALESCED_TENSOR_BYTES", 0,
+                               &max_coalesced_tensor_bytes_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
   session_handle_ =
       strings::StrCat("direct", strings::FpToString(random::New64()));
   int devices_added = 0;
@@ -760,6 +773,19 @@ Status DirectSession::RunInternal(
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
 
+  if (handler_ptr != nullptr) {
+    std::unique_ptr<RequestCostAccessor> request_cost_accessor =
+        CreateRequestCostAccessor();
+    RequestCost* request_cost = request_cost_accessor != nullptr
+                                    ? request_cost_accessor->GetRequestCost()
+                                    : nullptr;
+    if (request_cost != nullptr) {
+      request_cost->RecordCost(
+          {{kRunHandlerCostName,
+            absl::Microseconds(handler_ptr->GetTaskExecutionMicros())}});
+    }
+  }
+
   if (device_profiler_session) {
     TF_RETURN_IF_ERROR(device_profiler_session->CollectData(
         run_metadata->mutable_step_stats()));
@@ -858,6 +884,15 @@ Status DirectSession::Run(const RunOptions& run_options,
   RunStateArgs run_state_args(run_options.debug_options());
   run_state_args.collective_graph_key =
       run_options.experimental().collective_graph_key();
+  if (options_.config.experimental().max_feed_shape_specializations() > 0 &&
+      !options_.config.graph_options().place_pruned_graph()) {
+    for (const auto& it : inputs) {
+      // Resource feeds are replaced by the tensors they refer to.
+      if (it.second.dtype() != DT_RESOURCE) {
+        run_state_args.feed_shapes.emplace(it.first, it.second.shape());
+      }
+    }
+  }
 
   TF_RETURN_IF_ERROR(GetOrCreateExecutors(input_tensor_names, output_names,
                                           target_nodes, &executors_and_keys,
@@ -1315,6 +1350,7 @@ Status DirectSession::CreateExecutors(
   std::unique_ptr<ExecutorsAndKeys> ek(new ExecutorsAndKeys);
 
   ek->callable_options = callable_options;
+  options.feed_shapes = run_state_args->feed_shapes;
 
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
   TF_RETURN_IF_ERROR(CreateGraphs(
@@ -1420,7 +1456,15 @@ Status DirectSession::CreateExecutors(
 
     item->executor = nullptr;
     item->device = device;
-    auto executor_type = options_.config.experimental().executor_type();
+    string executor_type = options_.config.experimental().executor_type();
+    const int max_nodes =
+        options_.config.experimental().single_threaded_executor_max_nodes();
+    if (executor_type.empty() && max_nodes > 0 &&
+        device->device_type() == DEVICE_CPU &&
+        partition_graph->num_op_nodes() <= max_nodes &&
+        ValidateGraphForSingleThreadedExecutor(*partition_graph).ok()) {
+      executor_type = "SINGLE_THREADED_EXECUTOR";
+    }
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
     if (!options_.config.experimental().disable_output_partition_graphs() ||
@@ -1471,6 +1515,57 @@ Status DirectSession::GetOrCreateExecutors(
     gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
     gtl::ArraySlice<string> target_nodes, ExecutorsAndKeys** executors_and_keys,
     RunStateArgs* run_state_args) {
+  // Runs that need a handle, or whose key depends on more than the names, go
+  // through the string keyed lookup.
+  if (LogMemory::IsEnabled() || run_state_args->is_partial_run ||
+      !run_state_args->feed_shapes.empty() ||
+      !run_state_args->debug_options.debug_tensor_watch_opts().empty()) {
+    return GetOrCreateExecutorsForKey(inputs, outputs, target_nodes,
+                                      executors_and_keys, run_state_args);
+  }
+
+  auto matches = [&](const RunSignature& signature) {
+    return absl::c_equal(signature.inputs, inputs) &&
+           absl::c_equal(signature.outputs, outputs) &&
+           absl::c_equal(signature.target_nodes, target_nodes);
+  };
+  uint64 hash = Hash64Combine(inputs.size(), outputs.size());
+  for (const auto* names : {&inputs, &outputs, &target_nodes}) {
+    for (const string& name : *names) {
+      hash = Hash64Combine(hash, Hash64(name));
+    }
+  }
+  {
+    tf_shared_lock l(executor_lock_);
+    auto it = run_signatures_.find(hash);
+    if (it != run_signatures_.end()) {
+      for (const RunSignature& signature : it->second) {
+        if (matches(signature)) {
+          *executors_and_keys = signature.executors_and_keys;
+          return Status::OK();
+        }
+      }
+    }
+  }
+
+  TF_RETURN_IF_ERROR(GetOrCreateExecutorsForKey(
+      inputs, outputs, target_nodes, executors_and_keys, run_state_args));
+
+  mutex_lock l(executor_lock_);
+  std::vector<RunSignature>& signatures = run_signatures_[hash];
+  if (std::none_of(signatures.begin(), signatures.end(), matches)) {
+    signatures.push_back({{inputs.begin(), inputs.end()},
+                          {outputs.begin(), outputs.end()},
+                          {target_nodes.begin(), target_nodes.end()},
+                          *executors_and_keys});
+  }
+  return Status::OK();
+}
+
+Status DirectSession::GetOrCreateExecutorsForKey(
+    gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
+    gtl::ArraySlice<string> target_nodes, ExecutorsAndKeys** executors_and_keys,
+    RunStateArgs* run_state_args) {
   int64_t handle_name_counter_value = -1;
   if (LogMemory::IsEnabled() || run_state_args->is_partial_run) {
     handle_name_counter_value = handle_name_counter_.fetch_add(1);
@@ -1482,11 +1577,26 @@ Status DirectSession::GetOrCreateExecutors(
         run_state_args->debug_options.debug_tensor_watch_opts());
   }
 
+  // Executors specialized to the feed shapes are cached under keys that also
+  // hold the shapes, in the order of the feeds.
+  auto feed_shapes_summary = [run_state_args](gtl::ArraySlice<string> feeds) {
+    string summary;
+    if (run_state_args->feed_shapes.empty()) return summary;
+    for (const string& feed : feeds) {
+      strings::StrAppend(&summary, "/");
+      auto it = run_state_args->feed_shapes.find(feed);
+      if (it != run_state_args->feed_shapes.end()) {
+        strings::StrAppend(&summary, it->second.DebugString());
+      }
+    }
+    return summary;
+  };
+
   // Fast lookup path, no sorting.
   const string key = strings::StrCat(
       absl::StrJoin(inputs, ","), "->", absl::StrJoin(outputs, ","), "/",
       absl::StrJoin(target_nodes, ","), "/", run_state_args->is_partial_run,
-      "/", debug_tensor_watches_summary);
+      "/", debug_tensor_watches_summary, feed_shapes_summary(inputs));
   // Set the handle, if it's needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1516,10 +1626,12 @@ Status DirectSession::GetOrCreateExecutors(
   std::vector<string> tn_sorted(target_nodes.begin(), target_nodes.end());
   std::sort(tn_sorted.begin(), tn_sorted.end());
 
-  const string sorted_key = strings::StrCat(
+  const string sorted_signature = strings::StrCat(
       absl::StrJoin(inputs_sorted, ","), "->",
       absl::StrJoin(outputs_sorted, ","), "/", absl::StrJoin(tn_sorted, ","),
       "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary);
+  const string sorted_key =
+      strings::StrCat(sorted_signature, feed_shapes_summary(inputs_sorted));
   // Set the handle, if its needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1536,6 +1648,26 @@ Status DirectSession::GetOrCreateExecutors(
     }
   }
 
+  // Once the signature has as many specializations as allowed, other feed
+  // shapes are run by the unspecialized executors.
+  if (!run_state_args->feed_shapes.empty()) {
+    bool specialize;
+    {
+      mutex_lock l(executor_lock_);
+      int& num_specializations =
+          num_feed_shape_specializations_[sorted_signature];
+      specialize =
+          num_specializations <
+          options_.config.experimental().max_feed_shape_specializations();
+      if (specialize) ++num_specializations;
+    }
+    if (!specialize) {
+      run_state_args->feed_shapes.clear();
+      return GetOrCreateExecutors(inputs, outputs, target_nodes,
+                                  executors_and_keys, run_state_args);
+    }
+  }
+
   // Nothing found, so create the executors and store in the cache.
   // The executor_lock_ is intentionally released while executors are
   // being created.
@@ -1674,6 +1806,30 @@ Status DirectSession::CreateGraphs(
   };
   popts.flib_def = flib_def->get();
   popts.control_flow_added = false;
+  popts.max_coalesced_tensor_bytes = max_coalesced_tensor_bytes_;
+  // The shapes of the tensors to coalesce are inferred before Partition adds
+  // its own nodes.
+  std::unique_ptr<ShapeRefiner> shape_refiner;
+  if (popts.max_coalesced_tensor_bytes > 0) {
+    shape_refiner = absl::make_unique<ShapeRefiner>(
+        client_graph->graph.versions(), client_graph->graph.op_registry());
+    std::vector<Node*> order;
+    GetReversePostOrder(client_graph->graph, &order);
+    for (Node* node : order) {
+      // The shapes of the nodes that fail shape inference stay unknown.
+      shape_refiner->AddNode(node).IgnoreError();
+    }
+    popts.get_output_shape = [&shape_refiner](const Node* node, int index,
+                                              TensorShape* shape) {
+      shape_inference::InferenceContext* c = shape_refiner->GetContext(node);
+      if (c == nullptr || !c->FullyDefined(c->output(index))) return false;
+      *shape = TensorShape();
+      for (int i = 0; i < c->Rank(c->output(index)); ++i) {
+        shape->AddDim(c->Value(c->Dim(c->output(index), i)));
+      }
+      return true;
+    };
+  }
 
   std::unordered_map<string, GraphDef> partitions;
   TF_RETURN_IF_ERROR(Partition(popts, &client_graph->graph, &partitions));
@@ -23,6 +23,7 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -236,6 +237,9 @@ class DirectSession : public Session {
     std::unique_ptr<Graph> graph;
     const DebugOptions& debug_options;
     int64_t collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+    // The shapes of the fed tensors, keyed by feed name, if the executors may
+    // be specialized to them.
+    std::unordered_map<string, TensorShape> feed_shapes;
   };
 
   // Retrieves an already existing set of executors to run 'inputs' and
@@ -245,6 +249,12 @@ class DirectSession : public Session {
       gtl::ArraySlice<string> target_nodes,
       ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
 
+  // Like GetOrCreateExecutors, but without consulting `run_signatures_`.
+  ::tensorflow::Status GetOrCreateExecutorsForKey(
+      gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
+      gtl::ArraySlice<string> target_nodes,
+      ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
+
   // Creates a set of executors to run the subgraph defined by
   // `callable_options`.
   ::tensorflow::Status CreateExecutors(
@@ -355,6 +365,11 @@ class DirectSession : public Session {
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
 
+  // The largest tensors that the partitions coalesce into a single transfer
+  // between two devices, if positive. Set by the
+  // TF_PARTITION_MAX_COALESCED_TENSOR_BYTES environment variable.
+  int64_t max_coalesced_tensor_bytes_ = 0;
+
   std::vector<std::unique_ptr<FunctionInfo>> functions_
       TF_GUARDED_BY(executor_lock_);
 
@@ -366,6 +381,24 @@ class DirectSession : public Session {
   // same ExecutorsAndKey object.
   std::unordered_map<string, std::shared_ptr<ExecutorsAndKeys>> executors_
       TF_GUARDED_BY(executor_lock_);
+  // The number of executors specialized to feed shapes, keyed by the sorted
+  // signature they were specialized from.
+  std::unordered_map<string, int> num_feed_shape_specializations_
+      TF_GUARDED_BY(executor_lock_);
+
+  // The executors of plain Run() calls, i.e. ones without debug watches, feed
+  // shape specialization, memory logging or partial runs, keyed by a hash of
+  // the feed, fetch and target names in the order they were given. This
+  // spares those calls from building and looking up the string key of
+  // `executors_`, and is read under a shared lock.
+  struct RunSignature {
+    std::vector<string> inputs;
+    std::vector<string> outputs;
+    std::vector<string> target_nodes;
+    ExecutorsAndKeys* executors_and_keys;  // owned by `executors_`
+  };
+  absl::flat_hash_map<uint64, std::vector<RunSignature>> run_signatures_
+      TF_GUARDED_BY(executor_lock_);
 
   class RunCallableCallFrame;
   struct Callable {
@@ -153,6 +153,28 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_RepeatedFetchOrders) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Runs with the same fetches in a different order share executors, and
+  // repeated runs look them up by the names as given.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+
+    TF_ASSERT_OK(session->Run({}, {y_neg_ + ":0", y_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(-5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(5.0, outputs[1].matrix<float>()(0, 0));
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -1073,6 +1095,55 @@ TEST(DirectSessionTest, FetchMultipleTimes) {
   }
 }
 
+TEST(DirectSessionTest, SpecializesFeedShapes) {
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("shape", PartialTensorShape())
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &x));
+  Node* shape = test::graph::Unary(&g, "Shape", x);
+  Node* y = test::graph::Identity(&g, shape);
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_max_feed_shape_specializations(
+      1);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  auto run = [&](const std::vector<int32>& dims, bool* has_shape_op) {
+    Tensor x_value(DT_FLOAT, TensorShape({dims[0], dims[1]}));
+    RunMetadata run_metadata;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(run_options, {{"x", x_value}},
+                              {y->name() + ":0"}, {}, &outputs,
+                              &run_metadata));
+    ASSERT_EQ(outputs.size(), 1);
+    test::ExpectTensorEqual<int32>(outputs[0], test::AsTensor<int32>(dims));
+    *has_shape_op = false;
+    for (const GraphDef& partition : run_metadata.partition_graphs()) {
+      for (const NodeDef& node : partition.node()) {
+        if (node.op() == "Shape") *has_shape_op = true;
+      }
+    }
+  };
+
+  // The first feed shape gets executors in which Shape is folded.
+  bool has_shape_op;
+  run({2, 3}, &has_shape_op);
+  EXPECT_FALSE(has_shape_op);
+  run({2, 3}, &has_shape_op);
+  EXPECT_FALSE(has_shape_op);
+  // Other feed shapes use the unspecialized executors.
+  run({4, 3}, &has_shape_op);
+  EXPECT_TRUE(has_shape_op);
+}
+
 TEST(DirectSessionTest, MultipleFeedTestSomeSyncRun) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -2711,6 +2782,77 @@ BENCHMARK(BM_FeedFetchCallableSingleThreadExecutor)
     ->Arg(5)
     ->Arg(10);
 
+// A benchmark for the transfers of many small tensors between two devices:
+// the GPUs when there are two of them, and two CPU devices otherwise. Each
+// tensor is produced and consumed on the second device, through an identity
+// that is placed on the first device, so that it crosses devices twice.
+//
+// `mode` selects the optimization of the transfers: 0 for none, 1 for the
+// coalescing of the tensors into one transfer per device pair, 2 for the
+// placement of the identities with their consumers.
+void BM_CrossDeviceSmallTensors(::testing::benchmark::State& state) {
+  const int num_tensors = state.range(0);
+  const int mode = state.range(1);
+
+  SessionOptions opts;
+  (*opts.config.mutable_device_count())["CPU"] = 2;
+  // Keep the identities, which would otherwise be optimized away.
+  opts.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  opts.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  if (mode == 1) {
+    setenv("TF_PARTITION_MAX_COALESCED_TENSOR_BYTES", "4096", 1);
+  } else if (mode == 2) {
+    setenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS", "true", 1);
+  }
+  std::unique_ptr<Session> session(NewSession(opts));
+
+  std::vector<DeviceAttributes> devices;
+  TF_CHECK_OK(session->ListDevices(&devices));
+  std::vector<string> cpus, gpus;
+  for (const DeviceAttributes& device : devices) {
+    if (device.device_type() == "GPU") gpus.push_back(device.name());
+    if (device.device_type() == "CPU") cpus.push_back(device.name());
+  }
+  const std::vector<string>& pair = gpus.size() >= 2 ? gpus : cpus;
+
+  Graph g(OpRegistry::Global());
+  std::vector<Node*> identities;
+  for (int i = 0; i < num_tensors; ++i) {
+    Tensor value(DT_FLOAT, TensorShape({64}));
+    value.flat<float>().setConstant(i);
+    Node* c = test::graph::Constant(&g, value);
+    c->set_requested_device(pair[1]);
+    identities.push_back(test::graph::Identity(&g, c));
+  }
+  Node* sum = test::graph::Multi(&g, "AddN", identities);
+  sum->set_requested_device(pair[1]);
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  TF_CHECK_OK(session->Create(gd));
+
+  // The first run places and partitions the graph.
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session->Run({}, {sum->name() + ":0"}, {}, &outputs));
+  unsetenv("TF_PARTITION_MAX_COALESCED_TENSOR_BYTES");
+  unsetenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS");
+
+  for (auto s : state) {
+    TF_CHECK_OK(session->Run({}, {sum->name() + ":0"}, {}, &outputs));
+  }
+}
+
+BENCHMARK(BM_CrossDeviceSmallTensors)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 2)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 2);
+
 }  // namespace
 
 class DirectSessionCollectiveTest : public ::testing::Test {
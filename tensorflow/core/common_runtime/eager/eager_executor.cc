@@ -29,11 +29,19 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+bool IsDeviceQueuesEnabled() {
+  bool enabled = false;
+  TF_CHECK_OK(
+      ReadBoolFromEnvVar("TF_EAGER_ASYNC_DEVICE_QUEUES", false, &enabled));
+  return enabled;
+}
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async)
     : next_node_id_(0),
       ok_(true),
+      enable_device_queues_(async && IsDeviceQueuesEnabled()),
       thread_(async ? tensorflow::Env::Default()->StartThread(
                           tensorflow::ThreadOptions(), "eager_async_executor",
                           std::bind(&EagerExecutor::Run, this))
@@ -214,7 +222,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
   DCHECK(item->state != NodeState::kDONE);
   item->state = NodeState::kDONE;
 
-  bool async = item->node->AsAsync() != nullptr;
+  bool async = item->node->AsAsync() != nullptr || item->on_device_queue;
   // If executing synchronously we don't need to notify if status is OK since
   // the node  was never added to the unfinished_nodes_ list and nobody should
   // ever be waiting for it.
@@ -233,10 +241,10 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
       node_queue_.pop();
     } else if (async) {
-      // If it is an Async node then we will find the node in the unfinished
-      // nodes list. However we only notify if we are at the front of the list
-      // since we don't want to notify any waiters of earlier nodes.
-      need_notification = item->id == unfinished_nodes_.begin()->first;
+      // If it is an Async node, or it ran on a device queue, then we will find
+      // the node in the unfinished nodes list. However we only notify if we
+      // are at the front of the list since we don't want to notify any
+      // waiters of earlier nodes.
       // Remove item if it exists in unfinished_nodes_.
       // With async execution, if two separate nodes failed and enter this
       // callback, then the second node might not find itself in
@@ -245,9 +253,12 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       //   2) ClearError is called and executor status_ is set to OK
       //   3) Callback of the second failed node is triggered
       // In this case, do not taint the executor status or other note items
-      // because they are inserted after the ClearError.
-      auto result = unfinished_nodes_.erase(item->id);
-      if (result == 0) return;
+      // because they are inserted after the ClearError. The same holds for a
+      // node that was still running on a device queue when it was aborted.
+      auto it = unfinished_nodes_.find(item->id);
+      if (it == unfinished_nodes_.end()) return;
+      need_notification = it == unfinished_nodes_.begin();
+      unfinished_nodes_.erase(it);
     }
 
     if (!status.ok() && item->node->Fatal()) {
@@ -378,6 +389,12 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
 
   AsyncEagerNode* async_node = item->node->AsAsync();
   if (async_node == nullptr) {
+    if (from_queue && enable_device_queues_) {
+      Device* device = item->node->QueueDevice();
+      if (device != nullptr) {
+        return RunOnDeviceQueue(std::move(item), device);
+      }
+    }
     tensorflow::Status status = item->node->Run();
     NodeDone(item, status, from_queue);
     return status;
@@ -417,6 +434,67 @@ Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
   return Status::OK();
 }
 
+Status EagerExecutor::RunOnDeviceQueue(core::RefCountPtr<NodeItem> item,
+                                       Device* device) {
+  item->state = NodeState::kSCHEDULED;
+  item->on_device_queue = true;
+  core::RefCountPtr<NodeItem> queued_item(item.get());
+  queued_item->Ref();
+
+  TF_RETURN_IF_ERROR(MoveToUnfinished(std::move(item), /*from_queue=*/true));
+
+  DeviceQueue* queue;
+  {
+    tensorflow::mutex_lock l(node_queue_mutex_);
+    std::unique_ptr<DeviceQueue>& entry = device_queues_[device];
+    if (entry == nullptr) {
+      entry = std::make_unique<DeviceQueue>();
+      DeviceQueue* new_queue = entry.get();
+      new_queue->thread.reset(tensorflow::Env::Default()->StartThread(
+          tensorflow::ThreadOptions(), "eager_device_queue",
+          [this, new_queue]() { RunDeviceQueue(new_queue); }));
+    }
+    queue = entry.get();
+  }
+  DVLOG(3) << "Add Node: [id " << queued_item->id << "] to queue of "
+           << device->name();
+  {
+    tensorflow::mutex_lock l(queue->mu);
+    queue->nodes.push(std::move(queued_item));
+    queue->nodes_pending.notify_one();
+  }
+
+  // Return the status of the executor in case we are in an error state.
+  return status();
+}
+
+void EagerExecutor::RunDeviceQueue(DeviceQueue* queue) {
+  while (true) {
+    core::RefCountPtr<NodeItem> item;
+    {
+      tensorflow::mutex_lock l(queue->mu);
+      while (queue->nodes.empty() && !queue->shut_down) {
+        queue->nodes_pending.wait(l);
+      }
+      if (queue->shut_down) return;
+      item = std::move(queue->nodes.front());
+      queue->nodes.pop();
+    }
+    {
+      // A node that is no longer unfinished has been aborted because an
+      // earlier node failed.
+      tensorflow::tf_shared_lock l(node_queue_mutex_);
+      if (unfinished_nodes_.find(item->id) == unfinished_nodes_.end()) {
+        continue;
+      }
+    }
+    DVLOG(3) << "Running Node: [id " << item->id << "] "
+             << item->node->DebugString();
+    Status status = item->node->Run();
+    NodeDone(item, status, /*from_queue=*/false);
+  }
+}
+
 void EagerExecutor::AddCleanup(intptr_t key, std::function<void()> callback) {
   cleanups_[key].push_back(callback);
 }
@@ -21,6 +21,7 @@ limitations under the License.
 #include <memory>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -75,6 +76,12 @@ class EagerNode {
 
   // Indicates whether a node failure should make the executor unusable.
   virtual bool Fatal() const { return true; }
+
+  // Returns the device whose queue this node may run on when the executor has
+  // per-device queues enabled, or nullptr if the node must run on the executor
+  // thread in the order it was added. Only nodes whose effects are fully
+  // described by their input and output tensor handles may return a device.
+  virtual Device* QueueDevice() const { return nullptr; }
 };
 
 class AsyncEagerNode : public EagerNode {
@@ -106,9 +113,14 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
 // device of the input handle. Fix that.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
+//
+// If TF_EAGER_ASYNC_DEVICE_QUEUES is set, an async executor hands nodes that
+// report a QueueDevice() to a queue with its own thread for that device instead
+// of running them on the executor thread. Nodes on different devices then run
+// concurrently and may complete out of order. Data dependencies are respected
+// because a node blocks on its input handles until they are ready, and every
+// other node, e.g. a stateful op, still runs in order on the executor thread.
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async);
@@ -188,6 +200,26 @@ class EagerExecutor {
     uint64 id;
     std::unique_ptr<EagerNode> node;
     NodeState state;
+    // Whether the node was handed to a device queue.
+    bool on_device_queue = false;
+  };
+
+  // A queue of nodes for one device, run in order by `thread`.
+  struct DeviceQueue {
+    ~DeviceQueue() {
+      {
+        mutex_lock l(mu);
+        shut_down = true;
+        nodes_pending.notify_all();
+      }
+      thread.reset();
+    }
+
+    mutex mu;
+    condition_variable nodes_pending TF_GUARDED_BY(mu);
+    std::queue<core::RefCountPtr<NodeItem>> nodes TF_GUARDED_BY(mu);
+    bool shut_down TF_GUARDED_BY(mu) = false;
+    std::unique_ptr<Thread> thread;
   };
 
   const char* StateStringLocked()
@@ -204,6 +236,11 @@ class EagerExecutor {
   void Run();
 
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Moves `item`, which must be at the front of `node_queue_`, to the queue of
+  // `device`.
+  Status RunOnDeviceQueue(core::RefCountPtr<NodeItem> item, Device* device);
+  // Runs the nodes added to `queue` till it is shut down.
+  void RunDeviceQueue(DeviceQueue* queue);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
 
   // The impl of WaitForAllPendingNodes
@@ -249,6 +286,13 @@ class EagerExecutor {
   ExecutorState state_ TF_GUARDED_BY(node_queue_mutex_) =
       ExecutorState::kActive;
 
+  const bool enable_device_queues_;
+
+  // Queues created on demand by `thread_`. Declared after the state used by
+  // NodeDone, so that the queue threads are joined before it is destroyed.
+  std::unordered_map<const Device*, std::unique_ptr<DeviceQueue>>
+      device_queues_ TF_GUARDED_BY(node_queue_mutex_);
+
   // Thread object that calls the `Run` method in async mode.This thread runs
   // until state_ is set to kShuttingDown. It is `nullptr` in sync mode.
   const std::unique_ptr<Thread> thread_;
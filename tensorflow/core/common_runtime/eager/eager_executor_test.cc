@@ -0,0 +1,230 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// A node that runs `run`, on the queue of `device` if it is not null.
+class TestNode : public EagerNode {
+ public:
+  TestNode(Device* device, std::function<Status()> run,
+           std::atomic<int>* num_aborted = nullptr)
+      : device_(device), run_(std::move(run)), num_aborted_(num_aborted) {}
+
+  Status Run() override { return run_(); }
+
+  void Abort(Status status) override {
+    if (num_aborted_ != nullptr) ++*num_aborted_;
+  }
+
+  string DebugString() const override { return "[TestNode]"; }
+
+  Device* QueueDevice() const override { return device_; }
+
+ private:
+  Device* const device_;
+  const std::function<Status()> run_;
+  std::atomic<int>* const num_aborted_;
+};
+
+class EagerExecutorDeviceQueuesTest : public ::testing::Test {
+ protected:
+  EagerExecutorDeviceQueuesTest()
+      : cpu0_(DeviceFactory::NewDevice("CPU", {},
+                                       "/job:localhost/replica:0/task:0")),
+        cpu1_(DeviceFactory::NewDevice("CPU", {},
+                                       "/job:localhost/replica:0/task:1")) {}
+
+  void SetUp() override {
+    setenv("TF_EAGER_ASYNC_DEVICE_QUEUES", "1", 1 /* replace */);
+  }
+
+  void TearDown() override { unsetenv("TF_EAGER_ASYNC_DEVICE_QUEUES"); }
+
+  std::unique_ptr<Device> cpu0_;
+  std::unique_ptr<Device> cpu1_;
+};
+
+TEST_F(EagerExecutorDeviceQueuesTest, NodesOnDifferentDevicesRunConcurrently) {
+  EagerExecutor executor(/*async=*/true);
+  Notification second_ran;
+  std::atomic<int> num_done(0);
+
+  // The first node can only finish once the node after it has run, which it
+  // does on the queue of another device.
+  TF_ASSERT_OK(executor.AddOrExecute(
+      std::make_unique<TestNode>(cpu0_.get(), [&]() {
+        second_ran.WaitForNotification();
+        ++num_done;
+        return Status::OK();
+      })));
+  TF_ASSERT_OK(executor.AddOrExecute(
+      std::make_unique<TestNode>(cpu1_.get(), [&]() {
+        second_ran.Notify();
+        ++num_done;
+        return Status::OK();
+      })));
+
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  EXPECT_EQ(num_done, 2);
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST_F(EagerExecutorDeviceQueuesTest, ErrorOnDeviceQueuePoisonsExecutor) {
+  EagerExecutor executor(/*async=*/true);
+  TF_ASSERT_OK(executor.AddOrExecute(std::make_unique<TestNode>(
+      cpu0_.get(), []() { return errors::Internal("node failed"); })));
+
+  Status status = executor.WaitForAllPendingNodes();
+  EXPECT_TRUE(errors::IsInternal(status)) << status;
+  EXPECT_FALSE(executor.ok());
+
+  std::atomic<int> num_aborted(0);
+  EXPECT_FALSE(executor
+                   .AddOrExecute(std::make_unique<TestNode>(
+                       cpu0_.get(), []() { return Status::OK(); },
+                       &num_aborted))
+                   .ok());
+  EXPECT_EQ(num_aborted, 1);
+
+  executor.ClearError();
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST_F(EagerExecutorDeviceQueuesTest, SkipsNodesAbortedByEarlierFailure) {
+  EagerExecutor executor(/*async=*/true);
+  Notification release_first;
+  std::atomic<int> num_aborted(0);
+  std::atomic<bool> second_ran(false);
+  std::atomic<bool> third_ran(false);
+
+  // The first node blocks the queue of cpu0, so the second one is still
+  // queued behind it when a node on the executor thread fails.
+  TF_ASSERT_OK(executor.AddOrExecute(std::make_unique<TestNode>(
+      cpu0_.get(),
+      [&]() {
+        release_first.WaitForNotification();
+        return Status::OK();
+      },
+      &num_aborted)));
+  TF_ASSERT_OK(executor.AddOrExecute(std::make_unique<TestNode>(
+      cpu0_.get(),
+      [&]() {
+        second_ran = true;
+        return Status::OK();
+      },
+      &num_aborted)));
+  TF_ASSERT_OK(executor.AddOrExecute(std::make_unique<TestNode>(
+      /*device=*/nullptr, []() { return errors::Internal("node failed"); })));
+
+  Status status = executor.WaitForAllPendingNodes();
+  EXPECT_TRUE(errors::IsInternal(status)) << status;
+  EXPECT_EQ(num_aborted, 2);
+  release_first.Notify();
+
+  // Queues run in order, so once a later node on cpu0 has run the aborted
+  // one has been dequeued.
+  executor.ClearError();
+  TF_ASSERT_OK(executor.AddOrExecute(
+      std::make_unique<TestNode>(cpu0_.get(), [&]() {
+        third_ran = true;
+        return Status::OK();
+      })));
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  EXPECT_TRUE(third_ran);
+  EXPECT_FALSE(second_ran);
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST_F(EagerExecutorDeviceQueuesTest, WaitsForNodesOnDeviceQueues) {
+  EagerExecutor executor(/*async=*/true);
+  Notification release;
+  std::atomic<bool> ran(false);
+  TF_ASSERT_OK(executor.AddOrExecute(
+      std::make_unique<TestNode>(cpu0_.get(), [&]() {
+        release.WaitForNotification();
+        ran = true;
+        return Status::OK();
+      })));
+
+  Notification wait_done;
+  Status wait_status;
+  std::unique_ptr<Thread> waiter(Env::Default()->StartThread(
+      ThreadOptions(), "waiter", [&]() {
+        wait_status = executor.WaitForAllPendingNodes();
+        wait_done.Notify();
+      }));
+
+  // The node has left the executor queue, but is still running on the
+  // device queue.
+  EXPECT_FALSE(WaitForNotificationWithTimeout(&wait_done, 100 * 1000));
+  release.Notify();
+  wait_done.WaitForNotification();
+  TF_EXPECT_OK(wait_status);
+  EXPECT_TRUE(ran);
+  waiter.reset();
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST_F(EagerExecutorDeviceQueuesTest, DestroyedWhileQueueIsBusy) {
+  auto executor = std::make_unique<EagerExecutor>(/*async=*/true);
+  Notification first_started;
+  Notification release_first;
+  std::atomic<bool> first_ran(false);
+  TF_ASSERT_OK(executor->AddOrExecute(
+      std::make_unique<TestNode>(cpu0_.get(), [&]() {
+        first_started.Notify();
+        release_first.WaitForNotification();
+        first_ran = true;
+        return Status::OK();
+      })));
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestNode>(
+      cpu0_.get(), []() { return Status::OK(); })));
+  first_started.WaitForNotification();
+
+  // Destruction waits for the running node, but not for the queued one.
+  Notification destroyed;
+  std::unique_ptr<Thread> destroyer(Env::Default()->StartThread(
+      ThreadOptions(), "destroyer", [&]() {
+        executor.reset();
+        destroyed.Notify();
+      }));
+  EXPECT_FALSE(WaitForNotificationWithTimeout(&destroyed, 100 * 1000));
+  release_first.Notify();
+  destroyed.WaitForNotification();
+  destroyer.reset();
+  EXPECT_TRUE(first_ran);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -193,6 +193,26 @@ class EagerOperation : public ImmediateExecutionOperation {
   // Op name recorded for memory debugging purpose.
   const char* op_name() const { return op_name_; }
 
+  // Returns the kernel this operation last ran with if it was looked up with
+  // `cache_key` while the context's kernel cache was at `generation`, and null
+  // otherwise. This lets an operation that is reset and executed again with
+  // the same attributes skip the context's kernel cache.
+  KernelAndDevice* GetCachedKernel(const Fprint128& cache_key,
+                                   int64_t generation) const {
+    if (cached_kernel_ == nullptr || cached_kernel_generation_ != generation ||
+        !(cached_kernel_key_ == cache_key)) {
+      return nullptr;
+    }
+    return cached_kernel_.get();
+  }
+  void SetCachedKernel(const Fprint128& cache_key, int64_t generation,
+                       KernelAndDevice* kernel) {
+    kernel->Ref();
+    cached_kernel_.reset(kernel);
+    cached_kernel_key_ = cache_key;
+    cached_kernel_generation_ = generation;
+  }
+
   // For LLVM style RTTI.
   static bool classof(const AbstractOperation* ptr) {
     return ptr->getKind() == kEager;
@@ -255,6 +275,12 @@ class EagerOperation : public ImmediateExecutionOperation {
   EagerExecutor* executor_;                              // Not owned.
   absl::optional<EagerRemoteFunctionParams> remote_func_params_;
 
+  // Set by SetCachedKernel. Deliberately kept across Reset, since the cache key
+  // covers the op name, attributes and device.
+  core::RefCountPtr<KernelAndDevice> cached_kernel_;
+  Fprint128 cached_kernel_key_ = {0, 0};
+  int64_t cached_kernel_generation_ = -1;
+
   // Inference information
   const tensorflow::OpDef* op_def_;  // op definition from protobuf
   int inference_arg_idx_;  // arg definition index for the next input to be
@@ -47,5 +47,45 @@ TEST(EagerOperationTest, DeviceName) {
   ctx->Unref();
 }
 
+TEST(EagerOperationTest, ReexecuteAfterReset) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  Device* device = device_mgr.ListDevices()[0];
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+
+  auto op = new EagerOperation(ctx);
+  for (int i = 0; i < 3; ++i) {
+    if (i == 2) {
+      // Kernels cached on the operation must not outlive the kernel cache.
+      const int64_t generation = ctx->KernelCacheGeneration();
+      ctx->ClearCachesAndDefaultExecutor();
+      EXPECT_EQ(generation + 1, ctx->KernelCacheGeneration());
+    }
+    TF_ASSERT_OK(op->Reset("Identity", nullptr, false, nullptr));
+    Tensor t(DT_FLOAT, TensorShape({}));
+    t.scalar<float>()() = i;
+    TensorHandle* input =
+        TensorHandle::CreateLocalHandle(std::move(t), device, device, ctx);
+    TF_ASSERT_OK(op->AddInput(input));
+    input->Unref();
+
+    AbstractTensorHandle* retval = nullptr;
+    int num_retvals = 1;
+    TF_ASSERT_OK(op->Execute(absl::MakeSpan(&retval, 1), &num_retvals));
+    ASSERT_EQ(1, num_retvals);
+    const Tensor* output;
+    TF_ASSERT_OK(down_cast<TensorHandle*>(retval)->Tensor(&output));
+    EXPECT_EQ(i, output->scalar<float>()());
+    retval->Unref();
+    op->Clear();
+  }
+
+  delete op;
+  ctx->Unref();
+}
+
 }  // namespace
 }  // namespace tensorflow
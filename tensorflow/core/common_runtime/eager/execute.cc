@@ -897,7 +897,33 @@ Status GetOrCreateKernelAndDevice(
     }
   }
 
+  // Primitive ops that are executed repeatedly, e.g. reset and run again in a
+  // loop, usually hit the kernel cached on the operation itself, which avoids
+  // taking the context's cache lock. The generation is read before any lookup
+  // so that a kernel found in a cache that is cleared concurrently is not
+  // reused afterwards.
+  const bool use_op_kernel_cache =
+      !op->is_function() && !ctx.RunEagerOpAsFunction();
+  const int64_t kernel_cache_generation = ctx.KernelCacheGeneration();
+  if (use_op_kernel_cache) {
+    KernelAndDevice* cached_kernel =
+        op->GetCachedKernel(cache_key, kernel_cache_generation);
+    if (cached_kernel != nullptr) {
+      int num_outputs = cached_kernel->num_outputs();
+      if (num_outputs > *num_retvals) {
+        return errors::InvalidArgument("Expecting ", num_outputs,
+                                       " outputs, but *num_retvals is ",
+                                       *num_retvals);
+      }
+      *num_retvals = num_outputs;
+      cached_kernel->Ref();  // Ownership of reference is passed to out_kernel.
+      out_kernel->reset(cached_kernel);
+      return Status::OK();
+    }
+  }
+
   core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  bool cache_on_op = use_op_kernel_cache && kernel != nullptr;
   AbstractOperationPtr wrapped_op_releaser;
   if (kernel == nullptr) {
     VLOG(2) << "Creating new kernel for " << op->Name() << " on device "
@@ -1029,9 +1055,13 @@ Status GetOrCreateKernelAndDevice(
       TF_RETURN_IF_ERROR(OpDefForOp(op->Name().data(), &op_def));
       if (KernelCacheEnabled(*op_def)) {
         ctx.AddKernelToCache(cache_key, kernel.get());
+        cache_on_op = use_op_kernel_cache;
       }
     }
   }
+  if (cache_on_op) {
+    op->SetCachedKernel(cache_key, kernel_cache_generation, kernel.get());
+  }
 
   int num_outputs = kernel->num_outputs();
   if (num_outputs > *num_retvals) {
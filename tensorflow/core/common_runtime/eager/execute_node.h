@@ -30,6 +30,7 @@ limitations under the License.
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/eager/attr_builder.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/execute.h"
@@ -225,6 +226,25 @@ class AsyncExecuteNode : public EagerNode {
     }
   }
 
+  Device* QueueDevice() const override {
+    // Stateful ops and ops on resources have effects that are not visible
+    // through their inputs and outputs, so they keep running in order.
+    if (remote_func_params_.has_value() || kernel_->kernel() == nullptr) {
+      return nullptr;
+    }
+    const OpDef* op_def = nullptr;
+    if (!OpDefForOp(kernel_->kernel()->type_string(), &op_def).ok() ||
+        op_def->is_stateful()) {
+      return nullptr;
+    }
+    for (const TensorHandle* h : inputs_) {
+      if (h->dtype == DT_RESOURCE) {
+        return nullptr;
+      }
+    }
+    return kernel_->device();
+  }
+
   std::string DebugString() const override {
     std::string out = "[AsyncExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
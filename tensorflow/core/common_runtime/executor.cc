@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/step_memory_plan.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -64,6 +66,7 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/profile_utils/cpu_utils.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
@@ -72,6 +75,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -143,6 +147,9 @@ class ExecutorImpl : public Executor {
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    TF_RETURN_IF_ERROR(MaybeCreateStepMemoryPlan());
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_USE_WORK_STEALING",
+                                          false, &use_work_stealing_));
     return Status::OK();
   }
 
@@ -214,8 +221,30 @@ class ExecutorImpl : public Executor {
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
   };
 
+  // Serves the intermediate tensors of CPU graphs without control flow from a
+  // pre-planned per-step arena when TF_EXECUTOR_USE_STEP_MEMORY_PLAN is set.
+  Status MaybeCreateStepMemoryPlan() {
+    bool use_step_memory_plan = false;
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_USE_STEP_MEMORY_PLAN",
+                                          false, &use_step_memory_plan));
+    Device* device = immutable_state_.params().device;
+    if (use_step_memory_plan &&
+        device->device_type() == DEVICE_CPU &&
+        !immutable_state_.requires_control_flow_support()) {
+      step_memory_plan_.reset(
+          new StepMemoryPlan(device->GetAllocator(AllocatorAttributes()),
+                             immutable_state_.graph_view().num_nodes()));
+    }
+    return Status::OK();
+  }
+
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  core::RefCountPtr<StepMemoryPlan> step_memory_plan_;
+  // If true, expensive ready nodes are kept on the thread that produced their
+  // inputs and other threads steal them when idle.  Set by
+  // TF_EXECUTOR_USE_WORK_STEALING.
+  bool use_work_stealing_ = false;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -274,7 +303,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                StepMemoryPlan* step_memory_plan, bool use_work_stealing);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -288,6 +318,40 @@ class ExecutorState {
 
   struct AsyncState;
 
+  // The expensive ready nodes of one call to Process() that other threads may
+  // steal.  The owning thread pops nodes from the back, so that the successors
+  // of a node tend to run on the thread that produced their inputs while they
+  // are still in its cache.  Each node pushed is paired with one steal task in
+  // `runner_`, which pops from the front and does nothing if the owner has
+  // already taken the node.
+  class StealableQueue : public core::RefCounted {
+   public:
+    void PushBack(const TaggedNode& node) {
+      mutex_lock l(mu_);
+      nodes_.push_back(node);
+    }
+
+    absl::optional<TaggedNode> PopBack() {
+      mutex_lock l(mu_);
+      if (nodes_.empty()) return absl::nullopt;
+      TaggedNode node = nodes_.back();
+      nodes_.pop_back();
+      return node;
+    }
+
+    absl::optional<TaggedNode> PopFront() {
+      mutex_lock l(mu_);
+      if (nodes_.empty()) return absl::nullopt;
+      TaggedNode node = nodes_.front();
+      nodes_.pop_front();
+      return node;
+    }
+
+   private:
+    mutex mu_;
+    std::deque<TaggedNode> nodes_ TF_GUARDED_BY(mu_);
+  };
+
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64_t scheduled_nsec);
 
@@ -316,15 +380,22 @@ class ExecutorState {
   // This method will clear `*ready` before returning.
   bool NodeDone(const Status& s, TaggedNodeSeq* ready,
                 NodeExecStatsInterface* stats,
-                TaggedNodeReadyQueue* inline_ready);
+                TaggedNodeReadyQueue* inline_ready, StealableQueue* stealable);
 
   // Schedule all the expensive nodes in '*ready', and put all the inexpensive
-  // nodes in 'ready' into 'inline_ready'.
+  // nodes in 'ready' into 'inline_ready'.  If `stealable` is not null, the
+  // expensive nodes are pushed onto it instead of being dispatched, and
+  // `runner_` is only asked to steal them.
   //
   // This method will clear `*ready` before returning.
   //
   // REQUIRES: `!ready->empty()`.
-  void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
+  void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+                     StealableQueue* stealable);
+
+  // Schedules a task that runs the node at the front of `stealable`, if the
+  // thread owning it has not taken the node by then.
+  void ScheduleSteal(StealableQueue* stealable, int64_t scheduled_nsec);
 
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
@@ -376,6 +447,9 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
+  const bool use_work_stealing_;
+  // If not null, serves the allocations of this step's kernels.
+  core::RefCountPtr<StepArena> step_arena_;
 
   PropagatorStateType propagator_;
 
@@ -397,7 +471,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, StepMemoryPlan* step_memory_plan,
+    bool use_work_stealing)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -423,6 +498,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
+      use_work_stealing_(use_work_stealing && !args.run_all_kernels_inline),
       propagator_(immutable_state, step_id_, vlog_),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
@@ -430,6 +506,9 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (step_memory_plan != nullptr) {
+    step_arena_ = step_memory_plan->BeginStep();
+  }
 }
 
 template <class PropagatorStateType>
@@ -437,6 +516,9 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
   if (device_context_) {
     device_context_->Unref();
   }
+  if (step_arena_) {
+    step_arena_->EndStep();
+  }
   delete slice_reader_cache_;
 }
 
@@ -488,7 +570,7 @@ void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   } else {
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(&ready, nullptr);
+    ScheduleReady(&ready, nullptr, nullptr);
   }
 }
 
@@ -635,7 +717,7 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
       propagator_.PropagateOutputs(state->tagged_node, &outputs, &ready);
     }
     outputs.clear();
-    const bool completed = NodeDone(s, &ready, stats, nullptr);
+    const bool completed = NodeDone(s, &ready, stats, nullptr, nullptr);
     delete state;
     if (completed) ScheduleFinish();
   };
@@ -690,6 +772,11 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   WithContext wc(context_);
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
+  core::RefCountPtr<StealableQueue> stealable;
+  if (use_work_stealing_) {
+    stealable.reset(new StealableQueue);
+  }
+  int64_t num_inline_nodes = -1;
 
   // Parameters passed to OpKernel::Compute.
   TensorValueVec inputs;
@@ -744,9 +831,6 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
     if (finish_when_deferred_ops_done) Finish();
   };
 
-  // Set the device_context for this device, if it exists.
-  params.op_device_context = device_context_;
-
   Status s;
   NodeExecStatsInterface* stats = nullptr;
 
@@ -754,14 +838,30 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
   bool completed = false;
   inline_ready.push_back(tagged_node);
-  while (!inline_ready.empty()) {
+  while (true) {
+    if (inline_ready.empty()) {
+      // Take back the most recently produced expensive node that no other
+      // thread has stolen.
+      absl::optional<TaggedNode> node;
+      if (stealable) node = stealable->PopBack();
+      if (!node) break;
+      inline_ready.push_back(*node);
+    }
     tagged_node = inline_ready.front();
     inline_ready.pop_front();
+    ++num_inline_nodes;
     const NodeItem& item = tagged_node.get_node_item();
     const int id = item.node_id;
 
     propagator_.MaybeMarkStarted(tagged_node);
 
+    // Set the device_context for this device, if it exists, unless the device
+    // assigned another one to this node.
+    DeviceContext* node_device_context = immutable_state_.device_context(id);
+    params.op_device_context = node_device_context != nullptr
+                                   ? node_device_context
+                                   : device_context_;
+
     params.track_allocations = false;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.get_is_dead()) {
@@ -805,7 +905,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
         }
         propagator_.MaybeMarkCompleted(tagged_node);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, &ready, stats, &inline_ready);
+        completed = NodeDone(s, &ready, stats, &inline_ready, stealable.get());
         continue;
       }
 
@@ -816,6 +916,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
       params.outputs_required_array = item.outputs_required.get();
+      params.step_allocator = step_arena_ ? step_arena_->ForNode(id) : nullptr;
 
       if (item.kernel_is_async) {
         ProcessAsync(item, params, tagged_node, first_input, stats);
@@ -854,10 +955,15 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
         scheduled_nsec = nodestats::NowInNsec();
       }
       // Postprocess.
-      completed = NodeDone(s, &ready, stats, &inline_ready);
+      completed = NodeDone(s, &ready, stats, &inline_ready, stealable.get());
     }
   }  // while !inline_ready.empty()
 
+  if (use_work_stealing_ && num_inline_nodes > 0) {
+    metrics::UpdateExecutorWorkStealing(num_inline_nodes,
+                                        /*stolen_nodes=*/0);
+  }
+
   // This thread of computation is done if completed = true.
   if (completed) ScheduleFinish();
 }
@@ -1080,7 +1186,7 @@ Status ExecutorState<PropagatorStateType>::ProcessOutputs(
 template <class PropagatorStateType>
 bool ExecutorState<PropagatorStateType>::NodeDone(
     const Status& s, TaggedNodeSeq* ready, NodeExecStatsInterface* stats,
-    TaggedNodeReadyQueue* inline_ready) {
+    TaggedNodeReadyQueue* inline_ready, StealableQueue* stealable) {
   if (stats) {
     nodestats::SetAllEnd(stats);
     DCHECK_NE(stats_collector_, nullptr);
@@ -1099,7 +1205,7 @@ bool ExecutorState<PropagatorStateType>::NodeDone(
       }
 
       // Schedule the ready nodes in 'ready'.
-      ScheduleReady(ready, inline_ready);
+      ScheduleReady(ready, inline_ready, stealable);
 
       return false;
     }
@@ -1157,7 +1263,8 @@ bool ExecutorState<PropagatorStateType>::NodeDone(
 
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleReady(
-    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+    StealableQueue* stealable) {
   DCHECK(!ready->empty());
 
   int64_t scheduled_nsec = 0;
@@ -1198,8 +1305,13 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
           if (curr_expensive_node) {
             // Dispatch to another thread since there is plenty of work to
             // do for this thread.
-            RunTask(std::bind(&ExecutorState::Process, this,
-                              *curr_expensive_node, scheduled_nsec));
+            if (stealable) {
+              stealable->PushBack(*curr_expensive_node);
+              ScheduleSteal(stealable, scheduled_nsec);
+            } else {
+              RunTask(std::bind(&ExecutorState::Process, this,
+                                *curr_expensive_node, scheduled_nsec));
+            }
           }
           curr_expensive_node = &tagged_node;
         }
@@ -1208,6 +1320,11 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     if (curr_expensive_node) {
       if (inline_ready->empty()) {
         inline_ready->push_back(*curr_expensive_node);
+      } else if (stealable) {
+        // There are inline nodes to run already. This thread runs the
+        // expensive node after them, unless an idle thread steals it first.
+        stealable->PushBack(*curr_expensive_node);
+        ScheduleSteal(stealable, scheduled_nsec);
       } else {
         // There are inline nodes to run already. We dispatch this expensive
         // node to other thread.
@@ -1219,6 +1336,24 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleSteal(
+    StealableQueue* stealable, int64_t scheduled_nsec) {
+  // The task may run after the owning thread has returned from Process(), and
+  // after this step has finished, so it must not touch `this` unless it
+  // finds a node; a pending node keeps the step alive.
+  stealable->Ref();
+  RunTask([this, stealable, scheduled_nsec]() {
+    core::ScopedUnref unref(stealable);
+    absl::optional<TaggedNode> node = stealable->PopFront();
+    if (node) {
+      metrics::UpdateExecutorWorkStealing(/*inline_nodes=*/0,
+                                          /*stolen_nodes=*/1);
+      Process(*node, scheduled_nsec);
+    }
+  });
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1356,11 +1491,14 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        step_memory_plan_.get(),
+                                        use_work_stealing_))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, step_memory_plan_.get(),
+         use_work_stealing_))
         ->RunAsync(std::move(done));
   }
 }
@@ -255,6 +255,25 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWithWorkStealing) {
+  setenv("TF_EXECUTOR_USE_WORK_STEALING", "1", /*overwrite=*/1);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_USE_WORK_STEALING");
+  Rendezvous::Args args;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                               V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -484,6 +503,38 @@ BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 1024);
 
+// Create 'width' chains of 'depth' identities of a scalar, that are summed at
+// the end. The nodes are created one level at a time, so that the IDs of
+// consecutive nodes of a chain are 'width' apart, as they are in the layered
+// graphs built by many front ends, and the executor can't rely on the ID order
+// being close to the execution order.
+static void BM_executor_chains(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<Node*> tails;
+  for (int i = 0; i < width; ++i) {
+    tails.push_back(test::graph::Constant(g, test::AsScalar<float>(i)));
+  }
+  for (int i = 0; i < depth; ++i) {
+    for (Node*& tail : tails) {
+      tail = test::graph::Identity(g, tail);
+    }
+  }
+  test::graph::Multi(g, "AddN", tails);
+
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+
+  const int64_t num_nodes = width * (depth + 1) + 1;
+  state.SetLabel(strings::StrCat("Nodes = ", num_nodes));
+  state.SetItemsProcessed(num_nodes * static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_executor_chains)->UseRealTime()->ArgPair(64, 1024);
+BENCHMARK(BM_executor_chains)->UseRealTime()->ArgPair(1024, 256);
+
 static void BM_const_identity(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int outputs_per_const = state.range(1);
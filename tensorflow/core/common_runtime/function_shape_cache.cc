@@ -0,0 +1,95 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/function_shape_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+auto* function_shape_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/function_shape_cache/lookups",
+    "The number of lookups of the shapes inferred for function calls.",
+    "result");
+
+}  // namespace
+
+FunctionShapeCache* FunctionShapeCache::Global() {
+  static FunctionShapeCache* cache = [] {
+    int64_t capacity;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_FUNCTION_SHAPE_CACHE_CAPACITY",
+                                    /*default_val=*/10000, &capacity));
+    return new FunctionShapeCache(capacity);
+  }();
+  return cache;
+}
+
+std::shared_ptr<const FunctionShapes> FunctionShapeCache::Lookup(uint64 key) {
+  mutex_lock lock(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    function_shape_cache_lookups->GetCell("miss")->IncrementBy(1);
+    return nullptr;
+  }
+  function_shape_cache_lookups->GetCell("hit")->IncrementBy(1);
+  return it->second;
+}
+
+void FunctionShapeCache::Insert(uint64 key, FunctionShapes shapes) {
+  if (!enabled()) return;
+  auto entry = std::make_shared<const FunctionShapes>(std::move(shapes));
+  mutex_lock lock(mu_);
+  if (!entries_.emplace(key, std::move(entry)).second) return;
+  insertion_order_.push_back(key);
+  while (insertion_order_.size() > capacity_) {
+    entries_.erase(insertion_order_.front());
+    insertion_order_.pop_front();
+  }
+}
+
+int64_t FunctionShapeCache::size() {
+  mutex_lock lock(mu_);
+  return entries_.size();
+}
+
+void FunctionShapeCache::Clear() {
+  mutex_lock lock(mu_);
+  entries_.clear();
+  insertion_order_.clear();
+}
+
+uint64 FunctionFingerprint(const FunctionLibraryDefinition& library,
+                           const FunctionDef& fdef) {
+  uint64 fingerprint = DeterministicProtoHash64(fdef);
+  const FunctionLibraryDefinition reachable =
+      library.ReachableDefinitions(fdef);
+  std::vector<string> names = reachable.ListFunctionNames();
+  std::sort(names.begin(), names.end());
+  for (const string& name : names) {
+    fingerprint = FingerprintCat64(
+        fingerprint, DeterministicProtoHash64(*reachable.Find(name)));
+  }
+  return fingerprint;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_SHAPE_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_SHAPE_CACHE_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/framework/full_type.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The shapes inferred for the outputs of a function call from the body of the
+// function.
+struct FunctionShapes {
+  struct HandleShapeAndType {
+    TensorShapeProto shape;
+    DataType dtype = DT_INVALID;
+    FullTypeDef type;
+  };
+
+  struct Output {
+    // Unset if the body didn't set the output.
+    absl::optional<TensorShapeProto> shape;
+    // The shapes and types of the resource the output is a handle to, if any.
+    std::vector<HandleShapeAndType> handle_shapes_and_types;
+    // The value of the output, if it was inferred.
+    absl::optional<TensorProto> value;
+  };
+
+  std::vector<Output> outputs;
+  // The inputs of the call whose values the inference of the body requested.
+  std::vector<int> requested_input_tensors;
+};
+
+// Memoizes FunctionShapes by a fingerprint of everything the inference of the
+// function body reads, so that functions that are called many times with the
+// same input shapes, or in graphs that are imported or optimized again, are
+// inferred once. ShapeRefiner and grappler's GraphProperties both use it, with
+// keys that differ by the caller since they infer shapes differently.
+//
+// Thread-safe.
+class FunctionShapeCache {
+ public:
+  // The process-wide cache. Its capacity is TF_FUNCTION_SHAPE_CACHE_CAPACITY
+  // entries (default 10000), and 0 disables it.
+  static FunctionShapeCache* Global();
+
+  explicit FunctionShapeCache(int64_t capacity) : capacity_(capacity) {}
+
+  bool enabled() const { return capacity_ > 0; }
+
+  // Returns the shapes inserted for `key`, or nullptr.
+  std::shared_ptr<const FunctionShapes> Lookup(uint64 key)
+      TF_LOCKS_EXCLUDED(mu_);
+  // Evicts the oldest entry once the capacity is reached.
+  void Insert(uint64 key, FunctionShapes shapes) TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t size() TF_LOCKS_EXCLUDED(mu_);
+  void Clear() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  const int64_t capacity_;
+  mutex mu_;
+  absl::flat_hash_map<uint64, std::shared_ptr<const FunctionShapes>> entries_
+      TF_GUARDED_BY(mu_);
+  std::deque<uint64> insertion_order_ TF_GUARDED_BY(mu_);
+};
+
+// Returns a fingerprint of `fdef` and of the functions of `library` it calls,
+// directly or not.
+uint64 FunctionFingerprint(const FunctionLibraryDefinition& library,
+                           const FunctionDef& fdef);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_SHAPE_CACHE_H_
@@ -107,6 +107,9 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   // Stop clang from complaining about unused private fields when
   // TF_CUDA_MALLOC_ASYNC_SUPPORTED is not defined.
   (void)reserve_memory_;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT",
+                                 /*default_val=*/false,
+                                 &enforce_memory_limit_));
 
 #if TF_CUDA_MALLOC_ASYNC_SUPPORTED
   stream_exec_ = DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(),
@@ -172,13 +175,25 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   VLOG(1) << Name() << " CudaMallocAsync initialized on platform: "
           << platform_device_id.value() << " with pool size of: " << pool_size
           << " this ptr: " << this;
-  uint64_t pool_size_64 = pool_size;
+  // The pool keeps up to the release threshold bytes when the streams
+  // synchronize, and releases the rest to the driver.
+  int64 release_threshold = 0;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD",
+                                  static_cast<int64>(pool_size),
+                                  &release_threshold));
+  if (release_threshold < 0) {
+    LOG(FATAL)  // Crash OK.
+        << "TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD must not be negative, got "
+        << release_threshold;
+  }
+  uint64_t pool_size_64 = release_threshold;
   if (auto status = cuMemPoolSetAttribute(
           pool_, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &pool_size_64))
     LOG(FATAL) <<  // Crash OK.
         "Failed to set CUDA pool attribute: " << GetCudaErrorMessage(status);
 
-  if (compute_stats) {
+  // The memory limit is enforced on the stats.
+  if (compute_stats || enforce_memory_limit_) {
     stats_ = std::make_unique<AllocatorStats>();
     stats_->bytes_limit = static_cast<int64>(pool_size);
   }  // If not set, it means we do not compute stats.
@@ -278,11 +293,30 @@ void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
         << "The instantiation of GpuCudaMallocAsyncAllocator failed."
         << " See previous errors.";
   }
+  if (stats_) {
+    // The bytes are counted in use before the allocation, so that concurrent
+    // allocations can't exceed the limit together.
+    mutex_lock lock(lock_);
+    if (enforce_memory_limit_ &&
+        stats_->bytes_in_use + static_cast<int64>(num_bytes) >
+            *stats_->bytes_limit) {
+      LOG(WARNING) << Name() << " ran out of memory trying to allocate "
+                   << num_bytes << " bytes with " << stats_->bytes_in_use
+                   << " bytes in use of the " << *stats_->bytes_limit
+                   << " bytes limit.";
+      return nullptr;
+    }
+    stats_->bytes_in_use += num_bytes;
+  }
   se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
   void* ptr = nullptr;
   if (auto result =
           cuMemAllocFromPoolAsync(reinterpret_cast<CUdeviceptr*>(&ptr),
                                   num_bytes, pool_, cuda_stream_)) {
+    if (stats_) {
+      mutex_lock lock(lock_);
+      stats_->bytes_in_use -= num_bytes;
+    }
     size_t free, total;
     cuMemGetInfo(&free, &total);
     LOG(ERROR) << Name() << " cuMemAllocAsync failed to allocate " << num_bytes
@@ -301,7 +335,6 @@ void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
   if (stats_) {
     mutex_lock lock(lock_);
     ++(stats_->num_allocs);
-    stats_->bytes_in_use += num_bytes;
     if (stats_->bytes_in_use > stats_->peak_bytes_in_use) {
       VLOG(9) << "New Peak memory usage of " << stats_->bytes_in_use
               << " bytes.";
@@ -372,7 +405,20 @@ size_t GpuCudaMallocAsyncAllocator::AllocatedSize(const void* ptr) const {
 absl::optional<AllocatorStats> GpuCudaMallocAsyncAllocator::GetStats() {
   if (!stats_) return absl::nullopt;
   mutex_lock l(lock_);
-  return *stats_;
+  AllocatorStats stats = *stats_;
+#if CUDA_VERSION >= 11030
+  // Includes the memory freed in stream order that the pool keeps.
+  cuuint64_t pool_bytes;
+  cuuint64_t peak_pool_bytes;
+  if (cuMemPoolGetAttribute(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                            &pool_bytes) == CUDA_SUCCESS &&
+      cuMemPoolGetAttribute(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH,
+                            &peak_pool_bytes) == CUDA_SUCCESS) {
+    stats.pool_bytes = static_cast<int64>(pool_bytes);
+    stats.peak_pool_bytes = static_cast<int64>(peak_pool_bytes);
+  }
+#endif
+  return stats;
 }
 
 bool GpuCudaMallocAsyncAllocator::ClearStats() {
@@ -381,6 +427,15 @@ bool GpuCudaMallocAsyncAllocator::ClearStats() {
   stats_->num_allocs = 0;
   stats_->peak_bytes_in_use = stats_->bytes_in_use;
   stats_->largest_alloc_size = 0;
+#if CUDA_VERSION >= 11030
+  // Resets the high watermark to the current value.
+  cuuint64_t zero = 0;
+  if (auto result = cuMemPoolSetAttribute(
+          pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH, &zero)) {
+    LOG(ERROR) << "Failed to reset CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH: "
+               << GetCudaErrorMessage(result);
+  }
+#endif
   return true;
 }
 
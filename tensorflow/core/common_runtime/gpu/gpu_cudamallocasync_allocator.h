@@ -61,7 +61,20 @@ namespace tensorflow {
 //
 // Here, the pool_size isn't the absolute max as for [Gpu]BFCAllocator.
 // The pool can grow above that up to the total GPU memory.  But the
-// driver can return the excess memory to other processes.
+// driver can return the excess memory to other processes. Set
+// `TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT=true` to fail the allocations
+// that would bring the bytes in use above pool_size, like the BFC memory
+// allocator does, and `TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD=nb_bytes` to
+// keep a pool of a different size than pool_size.
+//
+// The stats report the bytes in use as requested, and with CUDA 11.3+, the
+// bytes the pool holds from the driver as pool_bytes.
+//
+// The memory is allocated and freed on the compute stream given to
+// SetStreamAndPreallocateMemory. With several compute streams, see
+// TF_GPU_NUM_COMPUTE_STREAMS, the GPU device wraps the allocator in a
+// GPUStreamSafeAllocator, which only frees the memory once every compute
+// stream is done with it, so the allocations are usable on all of them.
 class GpuCudaMallocAsyncAllocator : public Allocator {
  public:
   explicit GpuCudaMallocAsyncAllocator(PlatformDeviceId platform_device_id,
@@ -98,8 +111,8 @@ class GpuCudaMallocAsyncAllocator : public Allocator {
   se::StreamExecutor* stream_exec_;  // Not owned.
 
   // cudaMallocAsync is stream aware. But TF StreamExecutor use only 1
-  // compute stream and already synchronize with the h2d, d2h and d2d
-  // stream. So we do not need to ask cudaMallocAsync to add extra
+  // compute stream by default and already synchronize with the h2d, d2h and
+  // d2d stream. So we do not need to ask cudaMallocAsync to add extra
   // synchronization.
   // Not owned.
   CUstream cuda_stream_;
@@ -118,6 +131,9 @@ class GpuCudaMallocAsyncAllocator : public Allocator {
 
   bool reserve_memory_;
 
+  // Whether to fail the allocations above stats_->bytes_limit.
+  bool enforce_memory_limit_ = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuCudaMallocAsyncAllocator);
 
   // Stats.
@@ -0,0 +1,220 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device/device_id.h"
+#include "tensorflow/core/common_runtime/device/device_id_utils.h"
+#include "tensorflow/core/common_runtime/device/device_mem_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+
+namespace tensorflow {
+namespace {
+
+se::StreamExecutor* GetExecutor() {
+  return DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(),
+                                                   PlatformDeviceId(0))
+      .ValueOrDie();
+}
+
+bool DriverSupportsCudaMallocAsync() {
+  int driver_version;
+  cuDriverGetVersion(&driver_version);
+  if (driver_version < 11020) {
+    LOG(INFO) << "Driver version too old, skipping: " << driver_version;
+    return false;
+  }
+  return true;
+}
+
+// A compute stream for the allocator, which must outlive it.
+class AllocatorStream {
+ public:
+  AllocatorStream() : stream_(GetExecutor()) { stream_.Init(); }
+
+  void* cuda_stream() {
+    return stream_.implementation()->GpuStreamMemberHack();
+  }
+
+ private:
+  se::Stream stream_;
+};
+
+TEST(GpuCudaMallocAsyncAllocatorTest, StatsTrackBytesInUse) {
+  if (!DriverSupportsCudaMallocAsync()) return;
+  AllocatorStream stream;
+  GpuCudaMallocAsyncAllocator allocator(PlatformDeviceId(0), 1 << 30);
+  allocator.SetStreamAndPreallocateMemory(stream.cuda_stream());
+
+  void* small = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* large = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(allocator.RequestedSize(large), 4096);
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_allocs, 2);
+  EXPECT_EQ(stats->bytes_in_use, 5120);
+  EXPECT_EQ(stats->peak_bytes_in_use, 5120);
+  EXPECT_EQ(stats->largest_alloc_size, 4096);
+  EXPECT_EQ(*stats->bytes_limit, 1 << 30);
+#if CUDA_VERSION >= 11030
+  ASSERT_TRUE(stats->pool_bytes);
+  EXPECT_GE(*stats->pool_bytes, stats->bytes_in_use);
+  EXPECT_GE(*stats->peak_pool_bytes, *stats->pool_bytes);
+#endif
+
+  allocator.DeallocateRaw(small);
+  stats = allocator.GetStats();
+  EXPECT_EQ(stats->bytes_in_use, 4096);
+  EXPECT_EQ(stats->peak_bytes_in_use, 5120);
+
+  EXPECT_TRUE(allocator.ClearStats());
+  stats = allocator.GetStats();
+  EXPECT_EQ(stats->num_allocs, 0);
+  EXPECT_EQ(stats->bytes_in_use, 4096);
+  EXPECT_EQ(stats->peak_bytes_in_use, 4096);
+  EXPECT_EQ(stats->largest_alloc_size, 0);
+  allocator.DeallocateRaw(large);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 0);
+}
+
+TEST(GpuCudaMallocAsyncAllocatorTest, EnforcesMemoryLimit) {
+  if (!DriverSupportsCudaMallocAsync()) return;
+  setenv("TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT", "true", 1);
+  AllocatorStream stream;
+  GpuCudaMallocAsyncAllocator allocator(PlatformDeviceId(0), 1 << 20,
+                                        /*reserve_memory=*/false,
+                                        /*compute_stats=*/false);
+  unsetenv("TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT");
+  allocator.SetStreamAndPreallocateMemory(stream.cuda_stream());
+
+  void* ptr = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(allocator.AllocateRaw(Allocator::kAllocatorAlignment, 256),
+            nullptr);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 1 << 20);
+  EXPECT_EQ(allocator.GetStats()->num_allocs, 1);
+
+  allocator.DeallocateRaw(ptr);
+  ptr = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  EXPECT_NE(ptr, nullptr);
+  allocator.DeallocateRaw(ptr);
+}
+
+// An allocation of a trace, freed `lifetime` allocations later.
+struct TraceAllocation {
+  size_t bytes;
+  int lifetime;
+};
+
+// Variable shape workloads mix many short lived small tensors with fewer long
+// lived large ones of varying sizes, which leave holes of odd sizes behind
+// when they are freed.
+std::vector<TraceAllocation> FragmentingTrace(int num_allocations) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  std::vector<TraceAllocation> trace(num_allocations);
+  for (TraceAllocation& allocation : trace) {
+    if (rand.Uniform(10) == 0) {
+      allocation.bytes = (1 + rand.Uniform(64)) << 20;
+      allocation.lifetime = 100 + rand.Uniform(400);
+    } else {
+      allocation.bytes = 256 * (1 + rand.Uniform(4096));
+      allocation.lifetime = 1 + rand.Uniform(20);
+    }
+  }
+  return trace;
+}
+
+// Replays the trace, and returns the number of allocations that failed.
+int ReplayTrace(const std::vector<TraceAllocation>& trace,
+                Allocator* allocator) {
+  int num_failures = 0;
+  std::vector<std::vector<void*>> frees(trace.size() + 500);
+  for (size_t i = 0; i < trace.size(); ++i) {
+    for (void* ptr : frees[i]) allocator->DeallocateRaw(ptr);
+    void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                       trace[i].bytes);
+    if (ptr == nullptr) {
+      ++num_failures;
+    } else {
+      frees[i + trace[i].lifetime].push_back(ptr);
+    }
+  }
+  for (size_t i = trace.size(); i < frees.size(); ++i) {
+    for (void* ptr : frees[i]) allocator->DeallocateRaw(ptr);
+  }
+  return num_failures;
+}
+
+// Compares the BFC allocator (0) and the cudaMallocAsync allocator (1) on
+// the same 2GB limit. The BFC allocator fails the allocations it can't fit in
+// the free chunks of its regions, while cudaMallocAsync maps the holes again.
+static void BM_FragmentingTrace(::testing::benchmark::State& state) {
+  constexpr size_t kMemoryLimit = 2ull << 30;
+  const std::vector<TraceAllocation> trace = FragmentingTrace(10000);
+  AllocatorStream stream;
+  std::unique_ptr<Allocator> allocator;
+  if (state.range(0) == 0) {
+    allocator = std::make_unique<GPUBFCAllocator>(
+        new DeviceMemAllocator(GetExecutor(), PlatformDeviceId(0),
+                               /*use_unified_memory=*/false, {}, {}),
+        kMemoryLimit, "GPU_0_bfc");
+  } else {
+    if (!DriverSupportsCudaMallocAsync()) {
+      state.SkipWithError("cudaMallocAsync isn't supported by the driver.");
+      return;
+    }
+    setenv("TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT", "true", 1);
+    auto* async_allocator =
+        new GpuCudaMallocAsyncAllocator(PlatformDeviceId(0), kMemoryLimit);
+    unsetenv("TF_CUDA_MALLOC_ASYNC_ENFORCE_MEMORY_LIMIT");
+    async_allocator->SetStreamAndPreallocateMemory(stream.cuda_stream());
+    allocator.reset(async_allocator);
+  }
+
+  int num_failures = 0;
+  for (auto s : state) {
+    num_failures += ReplayTrace(trace, allocator.get());
+  }
+  absl::optional<AllocatorStats> stats = allocator->GetStats();
+  state.counters["failures_per_replay"] =
+      static_cast<double>(num_failures) / state.iterations();
+  state.counters["peak_in_use_MB"] = stats->peak_bytes_in_use >> 20;
+  if (stats->peak_pool_bytes) {
+    state.counters["peak_pool_MB"] = *stats->peak_pool_bytes >> 20;
+  }
+}
+BENCHMARK(BM_FragmentingTrace)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+
+#endif  // GOOGLE_CUDA
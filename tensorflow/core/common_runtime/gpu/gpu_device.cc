@@ -33,7 +33,9 @@ limitations under the License.
 #include <tuple>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_split.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
@@ -44,6 +46,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_safe_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
@@ -57,6 +61,7 @@ limitations under the License.
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -299,6 +304,29 @@ class BaseGPUDevice::StreamGroupFactory {
     return group;
   }
 
+  // Returns the allocator that wraps `gpu_allocator` to only reuse the memory
+  // freed on tf_device_id once the compute streams of `stream_groups` have
+  // passed the free, creating it if it does not yet exist. All the devices of
+  // a GPU share the allocator, like they share its streams.
+  // This function is thread safe.
+  Allocator* GetOrCreateStreamSafeAllocator(
+      TfDeviceId tf_device_id,
+      const gtl::InlinedVector<StreamGroup*, 4>& stream_groups,
+      Allocator* gpu_allocator, EventMgr* event_mgr) {
+    mutex_lock guard(lock_);
+    std::unique_ptr<GPUStreamSafeAllocator>& allocator =
+        stream_safe_allocators_[tf_device_id.value()];
+    if (!allocator) {
+      std::vector<se::Stream*> compute_streams;
+      for (const StreamGroup* group : stream_groups) {
+        compute_streams.push_back(group->compute);
+      }
+      allocator = absl::make_unique<GPUStreamSafeAllocator>(
+          gpu_allocator, event_mgr, std::move(compute_streams));
+    }
+    return allocator.get();
+  }
+
   // Returns a reference to the StreamGroupFactory singleton. Note that this is
   // never destroyed, so the objects it owns are never deleted.
   static StreamGroupFactory& Global() {
@@ -309,6 +337,8 @@ class BaseGPUDevice::StreamGroupFactory {
   // Helper method for unit tests to reset the streams. Never use in production.
   void TestOnlyReset() {
     mutex_lock guard(lock_);
+    // Waits for the pending frees, which need the streams.
+    stream_safe_allocators_.clear();
     for (auto& item : streams_) {
       auto& stream = item.second;
       if (stream.compute) {
@@ -373,6 +403,8 @@ class BaseGPUDevice::StreamGroupFactory {
   mutex lock_;
   using key_type = std::tuple<int, int>;
   std::map<key_type, StreamGroup> streams_;
+  std::map<int, std::unique_ptr<GPUStreamSafeAllocator>>
+      stream_safe_allocators_;
 
   // StreamGroupFactory cannot be created directly; Call
   // StreamGroupFactory::Global() to get the global instance.
@@ -380,6 +412,8 @@ class BaseGPUDevice::StreamGroupFactory {
   TF_DISALLOW_COPY_AND_ASSIGN(StreamGroupFactory);
 };
 
+constexpr int BaseGPUDevice::kMaxComputeStreams;
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              TfDeviceId tf_device_id,
@@ -402,29 +436,39 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete gpu_device_info_;
-  if (scratch_) gpu_allocator_->DeallocateRaw(scratch_);
-  device_context_->Unref();
+  for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
+  for (GPUDeviceContext* device_context : device_contexts_) {
+    device_context->Unref();
+  }
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
+  if (scratch_.empty()) {
     DCHECK(stream_);
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     profiler::ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
-    void* scratch_buffer = gpu_allocator_->AllocateRaw(
-        Allocator::kAllocatorAlignment, scratch_buffer_size);
-    if (scratch_buffer == nullptr) {
-      return errors::FailedPrecondition(
-          "Failed to allocate scratch buffer for device ",
-          tf_device_id_.value());
-    }
-    se::DeviceMemory<char> mem(
-        se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
-    TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
-        &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    // Kernels running concurrently on different streams can't share one.
+    gtl::InlinedVector<char*, 4> scratch;
+    auto cleanup = gtl::MakeCleanup([this, &scratch] {
+      for (char* buffer : scratch) gpu_allocator_->DeallocateRaw(buffer);
+    });
+    for (int i = 0, end = stream_groups_.size(); i < end; ++i) {
+      void* scratch_buffer = gpu_allocator_->AllocateRaw(
+          Allocator::kAllocatorAlignment, scratch_buffer_size);
+      if (scratch_buffer == nullptr) {
+        return errors::FailedPrecondition(
+            "Failed to allocate scratch buffer for device ",
+            tf_device_id_.value());
+      }
+      scratch.push_back(static_cast<char*>(scratch_buffer));
+      se::DeviceMemory<char> mem(
+          se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
+      TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
+          &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
+    }
+    scratch_.swap(scratch);
   }
   return Status::OK();
 }
@@ -439,18 +483,29 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   executor_ = executor_status.ValueOrDie();
 
-  stream_ = StreamGroupFactory::Global().GetOrCreate(
-      tf_device_id_, 0, executor_, options.config.gpu_options());
-  device_context_ =
-      new GPUDeviceContext(0, stream_->compute,
-#if TENSORFLOW_USE_ROCM
-                           stream_->nccl,
-#endif
-                           stream_->host_to_device, stream_->device_to_host,
-                           stream_->device_to_device);
+  int64_t num_compute_streams = 1;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_GPU_NUM_COMPUTE_STREAMS", 1,
+                                         &num_compute_streams));
+  if (num_compute_streams < 1 || num_compute_streams > kMaxComputeStreams) {
+    return errors::InvalidArgument(
+        "TF_GPU_NUM_COMPUTE_STREAMS must be between 1 and ",
+        kMaxComputeStreams, ", got ", num_compute_streams);
+  }
+  for (int i = 0; i < num_compute_streams; ++i) {
+    stream_groups_.push_back(StreamGroupFactory::Global().GetOrCreate(
+        tf_device_id_, i, executor_, options.config.gpu_options()));
+    device_contexts_.push_back(NewDeviceContext(i));
+  }
+  stream_ = stream_groups_[0];
+  device_context_ = device_contexts_[0];
 
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
+  if (num_compute_streams > 1) {
+    gpu_allocator_ =
+        StreamGroupFactory::Global().GetOrCreateStreamSafeAllocator(
+            tf_device_id_, stream_groups_, gpu_allocator_, em_);
+  }
 
   GPUKernelTracker::Params tracker_params(
       options.config.gpu_options().experimental().kernel_tracker_max_interval(),
@@ -543,6 +598,56 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   return Status::OK();
 }
 
+GPUDeviceContext* BaseGPUDevice::NewDeviceContext(int stream_id) const {
+  const StreamGroup* group = stream_groups_[stream_id];
+  return new GPUDeviceContext(stream_id, group->compute,
+#if TENSORFLOW_USE_ROCM
+                              group->nccl,
+#endif
+                              group->host_to_device, group->device_to_host,
+                              group->device_to_device);
+}
+
+Status BaseGPUDevice::FillContextMap(
+    const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+  if (stream_groups_.size() == 1) return Status::OK();
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = stream_groups_.size();
+  std::vector<int> node_to_stream_id;
+  TF_RETURN_IF_ERROR(
+      gpu_stream_util::AssignStreams(graph, opts, &node_to_stream_id));
+
+  device_context_map->assign(graph->num_node_ids(), nullptr);
+  for (const Node* n : graph->op_nodes()) {
+    const int stream_id = node_to_stream_id[n->id()];
+    // Control inputs are waited for too, since they may order the accesses
+    // to resources.
+    gtl::InlinedVector<se::Stream*, 2> input_streams;
+    for (const Edge* e : n->in_edges()) {
+      if (!e->src()->IsOp()) continue;
+      const int input_stream_id = node_to_stream_id[e->src()->id()];
+      se::Stream* input_stream = stream_groups_[input_stream_id]->compute;
+      if (input_stream_id != stream_id &&
+          !absl::c_linear_search(input_streams, input_stream)) {
+        input_streams.push_back(input_stream);
+      }
+    }
+    GPUDeviceContext* device_context;
+    if (input_streams.empty()) {
+      device_context = device_contexts_[stream_id];
+      device_context->Ref();
+    } else {
+      device_context = NewDeviceContext(stream_id);
+      device_context->set_input_streams(std::move(input_streams));
+    }
+    (*device_context_map)[n->id()] = device_context;
+  }
+  VLOG(1) << "Assigned the " << graph->num_op_nodes() << " nodes of a graph to "
+          << stream_groups_.size() << " compute streams on GPU "
+          << tf_device_id_.value();
+  return Status::OK();
+}
+
 string BaseGPUDevice::ComputeOpKernelDebugString(const OpKernel& op_kernel,
                                                  const int& stream_id) {
   return strings::StrCat(op_kernel.name(), " op ", op_kernel.type_string(),
@@ -661,6 +766,9 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     }
   }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  for (se::Stream* input_stream : gpu_device_context->input_streams()) {
+    stream->ThenWaitFor(input_stream);
+  }
   profiler::ScopedMemoryDebugAnnotation op_annotation(
       op_kernel->name_view().data(), context->step_id());
   bool should_log_inputs_and_outputs = ShouldLogInputsAndOutputs(op_kernel);
@@ -720,11 +828,14 @@ Status BaseGPUDevice::Sync() {
 
   // Device::Sync is supposed to block until all operations queued on the device
   // at the time of the call have completed.  On GPUs, only operations enqueued
-  // on the compute stream can remain pending after the (Async)OpKernel that
+  // on the compute streams can remain pending after the (Async)OpKernel that
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
-  return stream_->compute->BlockHostUntilDone();
+  for (StreamGroup* group : stream_groups_) {
+    TF_RETURN_IF_ERROR(group->compute->BlockHostUntilDone());
+  }
+  return Status::OK();
 }
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
@@ -755,6 +866,9 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   }
 
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  for (se::Stream* input_stream : gpu_device_context->input_streams()) {
+    stream->ThenWaitFor(input_stream);
+  }
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
@@ -1112,11 +1226,12 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, static_cast<int>(stream_groups_.size()));
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      stream_groups_[stream_id]->compute->implementation()
+          ->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1133,7 +1248,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
@@ -62,12 +62,21 @@ class BaseGPUDevice : public LocalDevice {
   ~BaseGPUDevice() override;
 
   // Initialize the device and return the status of initialization.
+  //
+  // The kernels run on TF_GPU_NUM_COMPUTE_STREAMS compute streams, one by
+  // default. With more than one, FillContextMap assigns independent branches
+  // of the graphs to different streams, and the memory freed by the kernels
+  // is only reused once every stream has passed the free.
   Status Init(const SessionOptions& options);
 
   void Compute(OpKernel* op_kernel, OpKernelContext* context) override;
 
   Status Sync() override;
 
+  Status FillContextMap(
+      const Graph* graph,
+      std::vector<DeviceContext*>* device_context_map) override;
+
   void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
                     AsyncOpKernel::DoneCallback done) override;
 
@@ -147,10 +156,19 @@ class BaseGPUDevice : public LocalDevice {
   };
   class StreamGroupFactory;
 
-  StreamGroup* stream_;
+  // The maximum value of TF_GPU_NUM_COMPUTE_STREAMS.
+  static constexpr int kMaxComputeStreams = 8;
+
+  // The stream group of each compute stream, indexed by stream id.
+  gtl::InlinedVector<StreamGroup*, 4> stream_groups_;
+  StreamGroup* stream_;  // == stream_groups_[0]
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
-  GPUDeviceContext* device_context_;
+  // The Eigen scratch buffer of each compute stream.
+  gtl::InlinedVector<char*, 4> scratch_;
+  // The default device context of each compute stream. Owns one reference on
+  // each.
+  gtl::InlinedVector<GPUDeviceContext*, 4> device_contexts_;
+  GPUDeviceContext* device_context_;  // == device_contexts_[0]
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   mutex trace_mu_;
   TfDeviceId tf_device_id_;
@@ -165,6 +183,9 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns a new context running ops on the compute stream `stream_id`.
+  GPUDeviceContext* NewDeviceContext(int stream_id) const;
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
@@ -25,14 +25,63 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/errors.h"
+
 namespace tensorflow {
 
+namespace {
+
+auto* prefetched_bytes = monitoring::Counter<0>::New(
+    "/tensorflow/core/gpu_managed_allocator/prefetched_bytes",
+    "The bytes of unified memory prefetched to GPUs before they are read.");
+
+auto* prefetched_rows = monitoring::Counter<0>::New(
+    "/tensorflow/core/gpu_managed_allocator/prefetched_rows",
+    "The table rows of unified memory prefetched to GPUs before they are "
+    "read.");
+
+}  // namespace
+
+GpuManagedAllocator::GpuManagedAllocator(int device_ordinal)
+    : device_ordinal_(device_ordinal) {
+#if GOOGLE_CUDA
+  CUdevice device;
+  int concurrent_managed_access = 0;
+  if (cuDeviceGet(&device, device_ordinal) == CUDA_SUCCESS &&
+      cuDeviceGetAttribute(&concurrent_managed_access,
+                           CU_DEVICE_ATTRIBUTE_CONCURRENT_MANAGED_ACCESS,
+                           device) == CUDA_SUCCESS) {
+    hints_supported_ = concurrent_managed_access != 0;
+  }
+#endif
+  if (!hints_supported_) {
+    LOG(WARNING) << "GPU " << device_ordinal
+                 << " doesn't support concurrent managed access, unified "
+                    "memory is allocated without placement hints.";
+  }
+}
+
 void* GpuManagedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   void* ptr = nullptr;
 #if GOOGLE_CUDA
   CUdeviceptr result = 0;
   CHECK_EQ(cuMemAllocManaged(&result, num_bytes, CU_MEM_ATTACH_GLOBAL),
            CUDA_SUCCESS);
+  if (hints_supported_) {
+    // The pages stay on the host unless they are prefetched, and the device
+    // reads host resident pages without faulting them in.
+    CUdevice device;
+    CHECK_EQ(cuDeviceGet(&device, device_ordinal_), CUDA_SUCCESS);
+    CHECK_EQ(cuMemAdvise(result, num_bytes,
+                         CU_MEM_ADVISE_SET_PREFERRED_LOCATION, CU_DEVICE_CPU),
+             CUDA_SUCCESS);
+    CHECK_EQ(cuMemAdvise(result, num_bytes, CU_MEM_ADVISE_SET_ACCESSED_BY,
+                         device),
+             CUDA_SUCCESS);
+  }
   ptr = reinterpret_cast<void*>(result);
 #elif TENSORFLOW_USE_ROCM
   void** result = 0;
@@ -40,6 +89,15 @@ void* GpuManagedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   ptr = reinterpret_cast<void*>(result);
 #endif
   CHECK(!(reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)));
+
+  mutex_lock l(mu_);
+  sizes_[ptr] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += num_bytes;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64_t>(stats_.largest_alloc_size, num_bytes);
   return ptr;
 }
 
@@ -49,6 +107,96 @@ void GpuManagedAllocator::DeallocateRaw(void* ptr) {
 #elif TENSORFLOW_USE_ROCM
   CHECK_EQ(hipFree(ptr), hipSuccess);
 #endif
+  mutex_lock l(mu_);
+  auto it = sizes_.find(ptr);
+  if (it == sizes_.end()) return;
+  stats_.bytes_in_use -= it->second;
+  sizes_.erase(it);
+}
+
+absl::optional<AllocatorStats> GpuManagedAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+bool GpuManagedAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+  return true;
+}
+
+Status GpuManagedAllocator::PrefetchRows(const void* table, size_t row_bytes,
+                                         absl::Span<const int64_t> ids,
+                                         void* stream) {
+  if (device_ordinal_ < 0) {
+    return errors::FailedPrecondition(
+        "Prefetching requires the oversubscription mode.");
+  }
+  if (!hints_supported_ || ids.empty()) return Status::OK();
+  size_t table_bytes;
+  {
+    mutex_lock l(mu_);
+    auto it = sizes_.find(const_cast<void*>(table));
+    if (it == sizes_.end()) {
+      return errors::InvalidArgument(
+          "The table wasn't allocated by this allocator.");
+    }
+    table_bytes = it->second;
+  }
+  for (int64_t id : ids) {
+    if (id < 0 || (id + 1) * row_bytes > table_bytes) {
+      return errors::InvalidArgument("Row ", id,
+                                     " is out of the bounds of the table.");
+    }
+  }
+  int64_t num_bytes = 0;
+#if GOOGLE_CUDA
+  CUdevice device;
+  if (cuDeviceGet(&device, device_ordinal_) != CUDA_SUCCESS) {
+    return errors::Internal("Failed to get GPU ", device_ordinal_);
+  }
+  const CUdeviceptr base = reinterpret_cast<CUdeviceptr>(table);
+  for (const auto& range : RowRanges(row_bytes, ids, kPrefetchGranularity)) {
+    // The last block may extend past the end of the table.
+    const size_t size = std::min(range.second, table_bytes - range.first);
+    if (cuMemPrefetchAsync(base + range.first, size, device,
+                           reinterpret_cast<CUstream>(stream)) !=
+        CUDA_SUCCESS) {
+      return errors::Internal("Failed to prefetch ", size,
+                              " bytes of unified memory to GPU ",
+                              device_ordinal_);
+    }
+    num_bytes += size;
+  }
+#endif
+  prefetched_bytes->GetCell()->IncrementBy(num_bytes);
+  prefetched_rows->GetCell()->IncrementBy(ids.size());
+  return Status::OK();
+}
+
+std::vector<std::pair<size_t, size_t>> GpuManagedAllocator::RowRanges(
+    size_t row_bytes, absl::Span<const int64_t> ids, size_t granularity) {
+  std::vector<int64_t> sorted_ids(ids.begin(), ids.end());
+  std::sort(sorted_ids.begin(), sorted_ids.end());
+  std::vector<std::pair<size_t, size_t>> ranges;
+  size_t end = 0;
+  for (int64_t id : sorted_ids) {
+    const size_t row_begin = id * row_bytes;
+    const size_t begin = row_begin / granularity * granularity;
+    const size_t row_end = row_begin + row_bytes;
+    const size_t block_end =
+        (row_end + granularity - 1) / granularity * granularity;
+    if (!ranges.empty() && begin <= end) {
+      end = std::max(end, block_end);
+      ranges.back().second = end - ranges.back().first;
+    } else {
+      ranges.emplace_back(begin, block_end - begin);
+      end = block_end;
+    }
+  }
+  return ranges;
 }
 
 }  // namespace tensorflow
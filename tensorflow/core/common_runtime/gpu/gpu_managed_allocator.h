@@ -16,19 +16,66 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
 
 namespace tensorflow {
 
 // An allocator for CUDA unified memory. Memory allocated with this allocator
 // can be accessed from both host and device. CUDA transparently migrates dirty
-// pages, which can be slow. Therefore, this allocator is intended for
+// pages, which can be slow. Therefore, the default allocator is intended for
 // convenience in functional tests only.
+//
+// The oversubscription mode is meant for tables that exceed the device memory,
+// like large embedding tables: the memory is advised to stay on the host and
+// to be mapped by the device, so that the device reads cold rows over the
+// interconnect instead of faulting them in and evicting others, and the rows
+// the next steps are going to read are migrated ahead of time with
+// PrefetchRows. The hints are dropped on devices without concurrent managed
+// access.
 class GpuManagedAllocator : public Allocator {
  public:
+  // The granularity of the prefetches of PrefetchRows, at which the driver
+  // migrates managed memory efficiently.
+  static constexpr size_t kPrefetchGranularity = 64 << 10;
+
+  GpuManagedAllocator() = default;
+  // Allocates in oversubscription mode for the device `device_ordinal`.
+  explicit GpuManagedAllocator(int device_ordinal);
+
   string Name() override { return "GpuManagedAllocator"; }
   void* AllocateRaw(size_t alignment, size_t num_bytes) override;
   void DeallocateRaw(void* ptr) override;
+  absl::optional<AllocatorStats> GetStats() override;
+  bool ClearStats() override;
+
+  // Migrates the rows `ids` of the table at `table`, made of rows of
+  // `row_bytes` bytes, to the device asynchronously on `stream`, a CUstream.
+  // Only supported in oversubscription mode.
+  Status PrefetchRows(const void* table, size_t row_bytes,
+                      absl::Span<const int64_t> ids, void* stream);
+
+  // Returns the sorted, disjoint (offset, size) byte ranges of whole
+  // `granularity` blocks that cover the rows `ids` of a table of rows of
+  // `row_bytes` bytes.
+  static std::vector<std::pair<size_t, size_t>> RowRanges(
+      size_t row_bytes, absl::Span<const int64_t> ids, size_t granularity);
+
+ private:
+  // The device of the oversubscription mode, or -1.
+  const int device_ordinal_ = -1;
+  // Whether the device supports the hints of the oversubscription mode.
+  bool hints_supported_ = false;
+
+  mutex mu_;
+  absl::flat_hash_map<void*, size_t> sizes_ TF_GUARDED_BY(mu_);
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
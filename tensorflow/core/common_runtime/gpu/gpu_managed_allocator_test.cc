@@ -0,0 +1,80 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+TEST(GpuManagedAllocatorTest, RowRangesCoverWholeBlocks) {
+  EXPECT_EQ(GpuManagedAllocator::RowRanges(16, {}, 64), Ranges());
+  // Rows 0 and 1 share the first block, row 9 is alone in the third one.
+  EXPECT_EQ(GpuManagedAllocator::RowRanges(16, {9, 1, 0, 1}, 64),
+            Ranges({{0, 64}, {128, 64}}));
+  // Row 1 straddles the first two blocks, and row 2 the next two.
+  EXPECT_EQ(GpuManagedAllocator::RowRanges(48, {1, 2}, 64),
+            Ranges({{0, 192}}));
+  // Rows larger than a block span several blocks.
+  EXPECT_EQ(GpuManagedAllocator::RowRanges(100, {2}, 64),
+            Ranges({{192, 128}}));
+}
+
+TEST(GpuManagedAllocatorTest, OversubscriptionPrefetchesRows) {
+  ASSERT_EQ(cuInit(0), CUDA_SUCCESS);
+  GpuManagedAllocator allocator(/*device_ordinal=*/0);
+  constexpr size_t kRowBytes = 1024;
+  constexpr size_t kNumRows = 1024;
+  void* table = allocator.AllocateRaw(Allocator::kAllocatorAlignment,
+                                      kRowBytes * kNumRows);
+  ASSERT_NE(table, nullptr);
+  // The memory stays accessible from the host.
+  memset(table, 1, kRowBytes * kNumRows);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, kRowBytes * kNumRows);
+
+  CUstream stream;
+  ASSERT_EQ(cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING), CUDA_SUCCESS);
+  TF_EXPECT_OK(allocator.PrefetchRows(table, kRowBytes, {0, 7, 512, 1023},
+                                      stream));
+  EXPECT_FALSE(
+      allocator.PrefetchRows(table, kRowBytes, {kNumRows}, stream).ok());
+  EXPECT_FALSE(allocator.PrefetchRows(table, kRowBytes, {-1}, stream).ok());
+  EXPECT_EQ(cuStreamSynchronize(stream), CUDA_SUCCESS);
+  EXPECT_EQ(cuStreamDestroy(stream), CUDA_SUCCESS);
+
+  allocator.DeallocateRaw(table);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 0);
+  EXPECT_EQ(allocator.GetStats()->peak_bytes_in_use, kRowBytes * kNumRows);
+}
+
+TEST(GpuManagedAllocatorTest, PrefetchRequiresOversubscription) {
+  GpuManagedAllocator allocator;
+  EXPECT_FALSE(allocator.PrefetchRows(nullptr, 16, {0}, nullptr).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -72,6 +72,19 @@ static bool UseCudaMallocAsyncAllocator() {
 #endif
 }
 
+static bool UseGpuHostPoolAllocator() {
+  const char* allocator_env = std::getenv("TF_GPU_HOST_ALLOCATOR");
+  return allocator_env != nullptr && std::strcmp(allocator_env, "pool") == 0;
+}
+
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static bool UseBfcDefragmentation() {
+  bool defragmentation = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_GPU_BFC_DEFRAGMENTATION",
+                                 /*default_val=*/false, &defragmentation));
+  return defragmentation;
+}
+
 /*static*/ GPUProcessState* GPUProcessState::singleton(GPUProcessState* ps) {
   static GPUProcessState* instance = ps ? ps : new GPUProcessState;
   DCHECK((!ps) || (ps == instance))
@@ -103,9 +116,7 @@ static SubAllocator* CreateSubAllocator(
                                                             platform_device_id)
                       .ValueOrDie();
 
-  // FIXME(imintz): Observed OOM issues when using the virtual memory
-  // allocators. This should be reenabled when resolved.
-#if 0 && defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
   // Use the old allocator when unified memory is required.
   // TODO(imintz): Remove the cuMemAlloc capability of this allocator.
   if (options.per_process_gpu_memory_fraction() > 1.0 ||
@@ -113,6 +124,13 @@ static SubAllocator* CreateSubAllocator(
     return new DeviceMemAllocator(executor, platform_device_id,
                                   /*use_unified_memory=*/true, alloc_visitors,
                                   {});
+  } else if (!UseBfcDefragmentation()) {
+    // FIXME(imintz): Observed OOM issues when using the virtual memory
+    // allocators. This should be the default when resolved; until then it's
+    // only used to let the BFC allocator defragment its memory.
+    return new DeviceMemAllocator(executor, platform_device_id,
+                                  /*use_unified_memory=*/false, alloc_visitors,
+                                  {});
   } else {
     auto* gpu_context = reinterpret_cast<stream_executor::gpu::GpuContext*>(
         executor->implementation()->GpuContextHack());
@@ -135,7 +153,7 @@ static SubAllocator* CreateSubAllocator(
     return GpuVirtualMemAllocator::Create(
                alloc_visitors, {}, *gpu_context, platform_device_id,
                /*virtual_address_space_size=*/total_bytes * 2,
-               platform_peer_gpu_ids_vec)
+               platform_peer_gpu_ids_vec, /*supports_decommit=*/true)
         .ValueOrDie()
         .release();
   }
@@ -186,6 +204,9 @@ Allocator* GPUProcessState::GetGPUAllocator(
         sub_allocator, total_bytes, options,
         strings::StrCat("GPU_", tf_device_id.value(), "_bfc"),
         options.experimental().internal_fragmentation_fraction());
+    if (sub_allocator->SupportsDecommit()) {
+      gpu_bfc_allocator->EnableDefragmentation();
+    }
     Allocator* gpu_allocator = gpu_bfc_allocator;
 
     SharedCounter* timing_counter = nullptr;
@@ -331,9 +352,20 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     while (gpu_host_free_visitors_.size() <= numa_node) {
       gpu_host_free_visitors_.push_back({});
     }
+    std::vector<SubAllocator::Visitor> alloc_visitors =
+        gpu_host_alloc_visitors_[numa_node];
+    alloc_visitors.push_back([this](void* ptr, int, size_t num_bytes) {
+      mutex_lock l(gpu_host_chunks_mu_);
+      gpu_host_chunks_[reinterpret_cast<uintptr_t>(ptr)] = num_bytes;
+    });
+    std::vector<SubAllocator::Visitor> free_visitors =
+        gpu_host_free_visitors_[numa_node];
+    free_visitors.push_back([this](void* ptr, int, size_t) {
+      mutex_lock l(gpu_host_chunks_mu_);
+      gpu_host_chunks_.erase(reinterpret_cast<uintptr_t>(ptr));
+    });
     SubAllocator* sub_allocator = new DeviceHostAllocator(
-        se, numa_node, gpu_host_alloc_visitors_[numa_node],
-        gpu_host_free_visitors_[numa_node]);
+        se, numa_node, alloc_visitors, free_visitors);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64_t gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -344,9 +376,20 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
     int64_t gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
 
-    Allocator* allocator =
-        new BFCAllocator(sub_allocator, gpu_host_mem_limit,
-                         /*allow_growth=*/true, /*name=*/"gpu_host_bfc");
+    Allocator* allocator;
+    if (UseGpuHostPoolAllocator()) {
+      // The buffers copied to and from the GPUs come in few sizes, so reusing
+      // them whole avoids the fragmentation of the regions of the BFC
+      // allocator, which holds on to its pinned memory until it is destroyed.
+      LOG(INFO) << "Using pool allocator for pinned host memory.";
+      allocator = new PoolAllocator(
+          /*pool_size_limit=*/100, /*auto_resize=*/true, sub_allocator,
+          new SizeClassRounder, "gpu_host_pool", gpu_host_mem_limit);
+    } else {
+      allocator =
+          new BFCAllocator(sub_allocator, gpu_host_mem_limit,
+                           /*allow_growth=*/true, /*name=*/"gpu_host_bfc");
+    }
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -377,6 +420,15 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   }
 }
 
+bool GPUProcessState::IsGpuHostMemory(const void* ptr, size_t num_bytes) {
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr);
+  mutex_lock l(gpu_host_chunks_mu_);
+  auto it = gpu_host_chunks_.upper_bound(begin);
+  if (it == gpu_host_chunks_.begin()) return false;
+  --it;
+  return begin + num_bytes <= it->first + it->second;
+}
+
 void GPUProcessState::AddGPUAllocVisitor(int bus_id,
                                          const SubAllocator::Visitor& visitor) {
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
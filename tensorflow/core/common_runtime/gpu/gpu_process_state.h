@@ -95,8 +95,15 @@ class GPUProcessState {
     return gpu_allocators_.size();
   }
 
+  // Returns the allocator of pinned host memory, a BFC allocator, or a pool
+  // of buffers by size class when TF_GPU_HOST_ALLOCATOR=pool.  Either way,
+  // TF_GPU_HOST_MEM_LIMIT_IN_MB caps its memory.
   virtual Allocator* GetGpuHostAllocator(int numa_node);
 
+  // Returns whether [ptr, ptr + num_bytes) lies in the pinned memory of a
+  // GpuHostAllocator.
+  bool IsGpuHostMemory(const void* ptr, size_t num_bytes);
+
   // Registers a Visitor to be invoked on new chunks of memory allocated by the
   // SubAllocator of every GPU proximate to the specified bus.  The AllocVisitor
   // is provided with a memory pointer, a GPU id, and the size of the area it
@@ -162,6 +169,12 @@ class GPUProcessState {
       TF_GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_host_free_visitors_
       TF_GUARDED_BY(mu_);
+
+  // The sizes of the chunks of pinned memory of the GpuHostAllocators, by
+  // address.
+  mutex gpu_host_chunks_mu_;
+  std::map<uintptr_t, size_t> gpu_host_chunks_
+      TF_GUARDED_BY(gpu_host_chunks_mu_);
 };
 
 }  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_safe_allocator.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace tensorflow {
+
+GPUStreamSafeAllocator::GPUStreamSafeAllocator(Allocator* allocator,
+                                               EventMgr* event_mgr,
+                                               std::vector<se::Stream*> streams)
+    : AllocatorWrapper(allocator),
+      event_mgr_(event_mgr),
+      streams_(std::move(streams)) {}
+
+GPUStreamSafeAllocator::~GPUStreamSafeAllocator() {
+  mutex_lock l(mu_);
+  while (fence_in_flight_) {
+    fence_done_.wait(l);
+  }
+}
+
+void GPUStreamSafeAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  {
+    mutex_lock l(mu_);
+    pending_.push_back(ptr);
+    if (fence_in_flight_) return;
+    fence_in_flight_ = true;
+  }
+  StartFence();
+}
+
+void GPUStreamSafeAllocator::StartFence() {
+  auto batch = std::make_shared<std::vector<void*>>();
+  {
+    mutex_lock l(mu_);
+    batch->swap(pending_);
+  }
+  auto num_remaining = std::make_shared<std::atomic<int>>(streams_.size());
+  for (se::Stream* stream : streams_) {
+    event_mgr_->ThenExecute(stream, [this, batch, num_remaining]() {
+      if (num_remaining->fetch_sub(1) == 1) {
+        FinishFence(std::move(*batch));
+      }
+    });
+  }
+}
+
+void GPUStreamSafeAllocator::FinishFence(std::vector<void*> batch) {
+  for (void* ptr : batch) {
+    wrapped()->DeallocateRaw(ptr);
+  }
+  {
+    mutex_lock l(mu_);
+    if (pending_.empty()) {
+      fence_in_flight_ = false;
+      fence_done_.notify_all();
+      return;
+    }
+  }
+  StartFence();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,76 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_SAFE_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_SAFE_ALLOCATOR_H_
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device/device_event_mgr.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// An allocator that wraps the allocator of a GPU whose kernels run on several
+// compute streams. The wrapped allocator hands out freed memory right away,
+// which is only safe while all the kernels using the memory run on one
+// stream: a kernel queued on another stream could then write the memory
+// before the kernels still reading it have completed. So freed memory is only
+// returned to the wrapped allocator once every compute stream has completed
+// the work queued before the free.
+//
+// The frees are batched: while the streams catch up with one batch, the next
+// frees accumulate into the following one.
+class GPUStreamSafeAllocator : public AllocatorWrapper {
+ public:
+  // Does not take ownership of `allocator`, `event_mgr` or `streams`.
+  GPUStreamSafeAllocator(Allocator* allocator, EventMgr* event_mgr,
+                         std::vector<se::Stream*> streams);
+  // Waits for the pending frees to be returned to the wrapped allocator.
+  ~GPUStreamSafeAllocator() override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  absl::optional<AllocatorStats> GetStats() override {
+    return wrapped()->GetStats();
+  }
+  bool ClearStats() override { return wrapped()->ClearStats(); }
+  void SetSafeFrontier(uint64 count) override {
+    wrapped()->SetSafeFrontier(count);
+  }
+
+ private:
+  // Queues a callback on every stream that returns the pending frees to the
+  // wrapped allocator once all of them have run.
+  void StartFence();
+  void FinishFence(std::vector<void*> batch);
+
+  EventMgr* const event_mgr_;
+  const std::vector<se::Stream*> streams_;
+
+  mutex mu_;
+  condition_variable fence_done_;
+  std::vector<void*> pending_ TF_GUARDED_BY(mu_);
+  bool fence_in_flight_ TF_GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUStreamSafeAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_SAFE_ALLOCATOR_H_
@@ -0,0 +1,71 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+
+Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
+                     std::vector<int>* node_to_stream_id) {
+  if (opts.max_streams < 1) {
+    return errors::InvalidArgument("max_streams must be positive, got ",
+                                   opts.max_streams);
+  }
+  node_to_stream_id->assign(graph->num_node_ids(), 0);
+  if (opts.max_streams == 1) return Status::OK();
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph, &order, NodeComparatorID());
+  std::vector<bool> assigned(graph->num_node_ids(), false);
+  std::vector<bool> continued(graph->num_node_ids(), false);
+  std::vector<int64_t> num_nodes(opts.max_streams, 0);
+  for (const Node* n : order) {
+    if (!n->IsOp()) continue;
+    int stream_id = -1;
+    bool has_inputs = false;
+    // Prefers continuing the stream of a data input over that of a control
+    // input. Inputs that aren't assigned yet are the back edges of loops.
+    for (bool control : {false, true}) {
+      for (const Edge* e : n->in_edges()) {
+        const Node* src = e->src();
+        if (e->IsControlEdge() != control || !assigned[src->id()]) continue;
+        has_inputs = true;
+        if (stream_id < 0 && !continued[src->id()]) {
+          stream_id = (*node_to_stream_id)[src->id()];
+          continued[src->id()] = true;
+        }
+      }
+    }
+    if (stream_id < 0) {
+      stream_id = has_inputs ? std::min_element(num_nodes.begin(),
+                                                num_nodes.end()) -
+                                   num_nodes.begin()
+                             : 0;
+    }
+    (*node_to_stream_id)[n->id()] = stream_id;
+    assigned[n->id()] = true;
+    ++num_nodes[stream_id];
+  }
+  return Status::OK();
+}
+
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
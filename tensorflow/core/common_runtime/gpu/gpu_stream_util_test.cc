@@ -0,0 +1,102 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+namespace {
+
+TEST(AssignStreamsTest, SingleStream) {
+  Graph g(OpRegistry::Global());
+  Node* c = test::graph::Constant(&g, Tensor(1.0f));
+  Node* a = test::graph::Unary(&g, "Neg", c);
+  Node* b = test::graph::Unary(&g, "Neg", c);
+  test::graph::Binary(&g, "Add", a, b);
+
+  std::vector<int> node_to_stream_id;
+  TF_ASSERT_OK(AssignStreams(&g, AssignStreamsOpts(), &node_to_stream_id));
+  ASSERT_EQ(node_to_stream_id.size(), g.num_node_ids());
+  for (int stream_id : node_to_stream_id) {
+    EXPECT_EQ(stream_id, 0);
+  }
+}
+
+TEST(AssignStreamsTest, IndependentBranches) {
+  Graph g(OpRegistry::Global());
+  Node* c = test::graph::Constant(&g, Tensor(1.0f));
+  Node* a1 = test::graph::Unary(&g, "Neg", c);
+  Node* a2 = test::graph::Unary(&g, "Neg", a1);
+  Node* b1 = test::graph::Unary(&g, "Neg", c);
+  Node* b2 = test::graph::Unary(&g, "Neg", b1);
+  Node* sum = test::graph::Binary(&g, "Add", a2, b2);
+
+  AssignStreamsOpts opts;
+  opts.max_streams = 4;
+  std::vector<int> node_to_stream_id;
+  TF_ASSERT_OK(AssignStreams(&g, opts, &node_to_stream_id));
+  auto stream = [&node_to_stream_id](const Node* n) {
+    return node_to_stream_id[n->id()];
+  };
+  EXPECT_EQ(stream(c), 0);
+  // Each branch stays on one stream, and the branches on different ones.
+  EXPECT_EQ(stream(a1), stream(a2));
+  EXPECT_EQ(stream(b1), stream(b2));
+  EXPECT_NE(stream(a1), stream(b1));
+  // The join continues one of the branches.
+  EXPECT_TRUE(stream(sum) == stream(a2) || stream(sum) == stream(b2));
+  for (int stream_id : node_to_stream_id) {
+    EXPECT_GE(stream_id, 0);
+    EXPECT_LT(stream_id, opts.max_streams);
+  }
+}
+
+TEST(AssignStreamsTest, MoreBranchesThanStreams) {
+  Graph g(OpRegistry::Global());
+  Node* c = test::graph::Constant(&g, Tensor(1.0f));
+  std::vector<Node*> branches;
+  for (int i = 0; i < 6; ++i) {
+    branches.push_back(test::graph::Unary(&g, "Neg", c));
+  }
+
+  AssignStreamsOpts opts;
+  opts.max_streams = 2;
+  std::vector<int> node_to_stream_id;
+  TF_ASSERT_OK(AssignStreams(&g, opts, &node_to_stream_id));
+  int num_on_stream_0 = 0;
+  for (const Node* n : branches) {
+    if (node_to_stream_id[n->id()] == 0) ++num_on_stream_0;
+  }
+  // The constant counts towards stream 0.
+  EXPECT_EQ(num_on_stream_0, 3);
+}
+
+TEST(AssignStreamsTest, InvalidMaxStreams) {
+  Graph g(OpRegistry::Global());
+  AssignStreamsOpts opts;
+  opts.max_streams = 0;
+  std::vector<int> node_to_stream_id;
+  EXPECT_FALSE(AssignStreams(&g, opts, &node_to_stream_id).ok());
+}
+
+}  // namespace
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <map>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 // IMPLEMENTATION NOTE:
@@ -109,6 +112,69 @@ void* GetBase(const Tensor* src) {
 
 void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+namespace {
+
+// Copies of at least this many bytes of pageable host memory register the
+// memory with the driver for the duration of the copy, or never if 0.
+int64_t HostMemoryRegisterThresholdBytes() {
+  static const int64_t threshold_bytes = [] {
+    int64_t threshold_in_mb = 0;
+    Status status = ReadInt64FromEnvVar("TF_GPU_HOST_REGISTER_THRESHOLD_IN_MB",
+                                        /*default_val=*/0, &threshold_in_mb);
+    if (!status.ok()) {
+      LOG(ERROR) << "GPUUtil: " << status.error_message();
+    }
+    return threshold_in_mb * (1LL << 20);
+  }();
+  return threshold_bytes;
+}
+
+// The number of copies using each range of host memory registered by
+// MaybeRegisterHostMemory, which is registered once for all of them.
+mutex registered_host_memory_mu(LINKER_INITIALIZED);
+std::map<void*, int>* registered_host_memory
+    TF_PT_GUARDED_BY(registered_host_memory_mu) = new std::map<void*, int>;
+
+// Registers the pageable host memory of a large copy, so that the copy is
+// done by DMA like those of pinned memory rather than staged through the
+// pinned buffers of the driver.  One-off large copies, e.g. of checkpoints,
+// can't reuse the memory of the GpuHostAllocator anyway.  Returns the
+// function that unregisters the memory, to be called once the copy
+// completed, or nullptr when the memory isn't registered.
+std::function<void()> MaybeRegisterHostMemory(se::StreamExecutor* executor,
+                                              void* ptr, int64_t num_bytes) {
+  const int64_t threshold_bytes = HostMemoryRegisterThresholdBytes();
+  if (threshold_bytes == 0 || num_bytes < threshold_bytes ||
+      GPUProcessState::singleton()->IsGpuHostMemory(ptr, num_bytes)) {
+    return nullptr;
+  }
+  {
+    mutex_lock l(registered_host_memory_mu);
+    int& num_copies = (*registered_host_memory)[ptr];
+    if (num_copies == 0 && !executor->HostMemoryRegister(ptr, num_bytes)) {
+      // E.g. the memory overlaps memory registered for another copy, which
+      // is then copied from pageable memory.
+      registered_host_memory->erase(ptr);
+      return nullptr;
+    }
+    ++num_copies;
+  }
+  VLOG(1) << "Registered " << num_bytes << " bytes of host memory at " << ptr
+          << " for a copy";
+  return [executor, ptr]() {
+    mutex_lock l(registered_host_memory_mu);
+    auto it = registered_host_memory->find(ptr);
+    if (--it->second == 0) {
+      registered_host_memory->erase(it);
+      if (!executor->HostMemoryUnregister(ptr)) {
+        LOG(ERROR) << "Failed to unregister host memory at " << ptr;
+      }
+    }
+  };
+}
+
+}  // namespace
+
 /*static*/
 void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
                               const DeviceContext* device_context,
@@ -276,20 +342,25 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64_t total_bytes = gpu_tensor->TotalBytes();
+  std::function<void()> unregister_host_memory;
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     void* dst_ptr = GetBase(cpu_tensor);
+    unregister_host_memory = MaybeRegisterHostMemory(
+        send_device_to_host_stream->parent(), dst_ptr, total_bytes);
     send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
   }
   // Use of the input may outlive stack scope, so keep a ref.
   TensorReference input_ref(*gpu_tensor);
   dev_info->event_mgr->ThenExecute(
       send_device_to_host_stream,
-      [send_device_to_host_stream, done, input_ref]() {
+      [send_device_to_host_stream, done, input_ref,
+       unregister_host_memory = std::move(unregister_host_memory)]() {
         if (!send_device_to_host_stream->ok()) {
           LOG(FATAL) << "GPU->CPU Memcpy failed";
         }
+        if (unregister_host_memory) unregister_host_memory();
         input_ref.Unref();
         done(Status::OK());
       });
@@ -323,18 +394,24 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   }
 
   const int64_t total_bytes = cpu_tensor->TotalBytes();
+  std::function<void()> unregister_host_memory;
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
+    unregister_host_memory = MaybeRegisterHostMemory(
+        recv_host_to_device_stream->parent(), src_ptr, total_bytes);
     recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
   }
   // Use of cpu_tensor may outlive stack scope, so keep a ref.
   TensorReference input_ref(*cpu_tensor);
   dev_info->event_mgr->ThenExecute(
       recv_host_to_device_stream,
-      [recv_host_to_device_stream, done, input_ref]() {
+      [recv_host_to_device_stream, done, input_ref,
+       unregister_host_memory = std::move(unregister_host_memory)]() {
+        // The memory must be unregistered before it can be freed.
+        if (unregister_host_memory) unregister_host_memory();
         input_ref.Unref();
         if (!recv_host_to_device_stream->ok()) {
           LOG(FATAL) << "CPU->GPU Memcpy failed";
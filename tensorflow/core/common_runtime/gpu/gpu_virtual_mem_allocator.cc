@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_virtual_mem_allocator.h"
 
+#include <iterator>
+
 #include "absl/strings/str_format.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/stream_executor/lib/status.h"
@@ -63,7 +65,7 @@ GpuVirtualMemAllocator::Create(
     const std::vector<Visitor>& alloc_visitors,
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id, size_t virtual_address_space_size,
-    const std::vector<PlatformDeviceId>& peer_gpu_ids) {
+    const std::vector<PlatformDeviceId>& peer_gpu_ids, bool supports_decommit) {
   std::vector<GpuDeviceHandle> access_gpu_handles;
   access_gpu_handles.reserve(peer_gpu_ids.size() + 1);
 
@@ -105,7 +107,8 @@ GpuVirtualMemAllocator::Create(
 
   return std::unique_ptr<GpuVirtualMemAllocator>(new GpuVirtualMemAllocator(
       alloc_visitors, free_visitors, gpu_context, gpu_id,
-      std::move(access_gpu_handles), vmem, max_granularity));
+      std::move(access_gpu_handles), vmem, max_granularity,
+      supports_decommit));
 }
 
 GpuVirtualMemAllocator::GpuVirtualMemAllocator(
@@ -113,13 +116,14 @@ GpuVirtualMemAllocator::GpuVirtualMemAllocator(
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id,
     const std::vector<GpuDeviceHandle> access_gpu_handles,
-    GpuDriver::VmemSpan vmem, size_t granularity)
+    GpuDriver::VmemSpan vmem, size_t granularity, bool supports_decommit)
     : SubAllocator(alloc_visitors, free_visitors),
       gpu_context_(gpu_context),
       gpu_id_(gpu_id),
       access_gpu_handles_(access_gpu_handles),
       vmem_(vmem),
-      granularity_(granularity) {}
+      granularity_(granularity),
+      supports_decommit_(supports_decommit) {}
 
 GpuVirtualMemAllocator::~GpuVirtualMemAllocator() {
   for (const auto mapping : mappings_) {
@@ -147,53 +151,133 @@ void* GpuVirtualMemAllocator::Alloc(size_t alignment, size_t num_bytes,
     return nullptr;
   }
 
-  // Create physical memory backing allocation.
-  auto maybe_handle =
-      GpuDriver::CreateMemoryHandle(&gpu_context_, padded_bytes);
-  if (!maybe_handle.ok()) {
-    LOG(ERROR) << maybe_handle.status();
-    return nullptr;
-  }
-  GpuDriver::GenericMemoryHandle handle = std::move(maybe_handle).ValueOrDie();
-
-  // Map VAs for this physical memory.
-  auto status =
-      GpuDriver::MapMemory(&gpu_context_, next_va, handle, access_gpu_handles_);
+  // Create and map the physical memory backing the allocation.
+  auto status = MapPages(next_va, padded_bytes,
+                         supports_decommit_ ? granularity_ : padded_bytes);
   if (!status.ok()) {
     LOG(ERROR) << status;
-    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
     return nullptr;
   }
-  next_alloc_offset_ += handle.bytes;
-  mappings_.push_back({next_va, std::move(handle)});
+  next_alloc_offset_ += padded_bytes;
   VisitAlloc(reinterpret_cast<void*>(next_va), gpu_id_.value(), padded_bytes);
   *bytes_received = padded_bytes;
   return reinterpret_cast<void*>(next_va);
 }
 
+stream_executor::port::Status GpuVirtualMemAllocator::MapPages(
+    GpuDevicePtr va, size_t num_bytes, size_t page_bytes) {
+  std::vector<Mapping> new_mappings;
+  stream_executor::port::Status status;
+  for (size_t offset = 0; offset < num_bytes; offset += page_bytes) {
+    auto maybe_handle = GpuDriver::CreateMemoryHandle(&gpu_context_,
+                                                      page_bytes);
+    if (!maybe_handle.ok()) {
+      status = maybe_handle.status();
+      break;
+    }
+    GpuDriver::GenericMemoryHandle handle =
+        std::move(maybe_handle).ValueOrDie();
+    status = GpuDriver::MapMemory(&gpu_context_, va + offset, handle,
+                                  access_gpu_handles_);
+    if (!status.ok()) {
+      GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
+      break;
+    }
+    new_mappings.push_back({va + offset, std::move(handle)});
+  }
+  if (!status.ok()) {
+    for (auto& mapping : new_mappings) {
+      GpuDriver::UnmapMemory(&gpu_context_, mapping.va, mapping.physical.bytes);
+      GpuDriver::ReleaseMemoryHandle(&gpu_context_,
+                                     std::move(mapping.physical));
+    }
+    return status;
+  }
+  // Keeps the mappings sorted by va.
+  mappings_.insert(LowerBound(va),
+                   std::make_move_iterator(new_mappings.begin()),
+                   std::make_move_iterator(new_mappings.end()));
+  return status;
+}
+
+std::vector<GpuVirtualMemAllocator::Mapping>::iterator
+GpuVirtualMemAllocator::LowerBound(GpuDevicePtr va) {
+  return std::lower_bound(
+      mappings_.begin(), mappings_.end(), va,
+      [](const Mapping& mapping, GpuDevicePtr va) { return mapping.va < va; });
+}
+
+bool GpuVirtualMemAllocator::Decommit(void* ptr, size_t num_bytes) {
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  if (!supports_decommit_ || va % granularity_ != 0 ||
+      num_bytes % granularity_ != 0) {
+    LOG(ERROR) << "Can't decommit " << num_bytes << " bytes at " << ptr;
+    return false;
+  }
+  auto begin = LowerBound(va);
+  auto end = LowerBound(va + num_bytes);
+  if (static_cast<size_t>(end - begin) != num_bytes / granularity_) {
+    LOG(ERROR) << "Can't decommit " << num_bytes << " bytes at " << ptr
+               << " which are not all mapped.";
+    return false;
+  }
+  if (!GpuDriver::SynchronizeContext(&gpu_context_)) {
+    LOG(ERROR) << "Failed to synchronize the context of GPU "
+               << gpu_id_.value() << " before decommitting memory.";
+    return false;
+  }
+  for (auto it = begin; it != end; ++it) {
+    GpuDriver::UnmapMemory(&gpu_context_, it->va, it->physical.bytes);
+    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(it->physical));
+  }
+  mappings_.erase(begin, end);
+  VLOG(1) << "Decommitted " << strings::HumanReadableNumBytes(num_bytes)
+          << " at " << ptr;
+  return true;
+}
+
+bool GpuVirtualMemAllocator::Recommit(void* ptr, size_t num_bytes) {
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  if (!supports_decommit_ || va % granularity_ != 0 ||
+      num_bytes % granularity_ != 0 ||
+      LowerBound(va) != LowerBound(va + num_bytes)) {
+    LOG(ERROR) << "Can't recommit " << num_bytes << " bytes at " << ptr;
+    return false;
+  }
+  auto status = MapPages(va, num_bytes, granularity_);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return false;
+  }
+  VLOG(1) << "Recommitted " << strings::HumanReadableNumBytes(num_bytes)
+          << " at " << ptr;
+  return true;
+}
+
 void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   if (ptr == nullptr) return;
 
-  auto mapping_it =
-      std::lower_bound(mappings_.begin(), mappings_.end(), ptr,
-                       [](const Mapping& mapping, const void* ptr) {
-                         return reinterpret_cast<const void*>(mapping.va) < ptr;
-                       });
-  if (mapping_it == mappings_.end() ||
-      (reinterpret_cast<void*>(mapping_it->va) != ptr)) {
+  // The decommitted parts of the range have no mapping.
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  auto mapping_it = LowerBound(va);
+  if (mapping_it == mappings_.end() || mapping_it->va >= va + num_bytes) {
     LOG(ERROR) << "Could not find GPU vmem mapping for address at "
                << reinterpret_cast<uintptr_t>(ptr);
     return;
   }
 
   int num_mappings_to_free = 0;
-  int total_bytes = 0;
-  for (auto it = mapping_it; it != mappings_.end() && total_bytes < num_bytes;
+  size_t total_bytes = 0;
+  size_t mapped_end = 0;
+  for (auto it = mapping_it; it != mappings_.end() && it->va < va + num_bytes;
        ++it) {
     ++num_mappings_to_free;
     total_bytes += it->physical.bytes;
+    mapped_end = it->va + it->physical.bytes - va;
   }
-  if (total_bytes != num_bytes) {
+  if (mapped_end > num_bytes ||
+      (!supports_decommit_ &&
+       (mapping_it->va != va || total_bytes != num_bytes))) {
     LOG(ERROR) << "Invalid size requested for freeing GPU vmem mapping. Got "
                << strings::HumanReadableNumBytes(num_bytes) << " but expected "
                << strings::HumanReadableNumBytes(mapping_it->physical.bytes);
@@ -209,7 +293,7 @@ void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
 
   // Move back the next_alloc_offset_ if this free was at the end.
   if (mapping_it + num_mappings_to_free == mappings_.end()) {
-    next_alloc_offset_ = mapping_it->va - vmem_.base;
+    next_alloc_offset_ = va - vmem_.base;
   }
 
   mappings_.erase(mapping_it, mapping_it + num_mappings_to_free);
@@ -37,6 +37,10 @@ namespace tensorflow {
 // reserving a large chunk of virtual addresses at construction and then mapping
 // physical memory pages to this virtual address range as requested.
 //
+// With `supports_decommit`, the physical memory is mapped in pages of the min
+// allocation granularity, so that Decommit() can release the pages behind
+// parts of the allocations and Recommit() map new ones.
+//
 // This class is not thread-safe.
 class GpuVirtualMemAllocator : public SubAllocator {
  public:
@@ -46,7 +50,8 @@ class GpuVirtualMemAllocator : public SubAllocator {
          const std::vector<Visitor>& free_visitors,
          stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
          size_t virtual_address_space_size,
-         const std::vector<PlatformDeviceId>& peer_gpu_ids);
+         const std::vector<PlatformDeviceId>& peer_gpu_ids,
+         bool supports_decommit = false);
   ~GpuVirtualMemAllocator() override;
 
   // Allocates memory at least as large as requested by num_bytes. Will be
@@ -70,13 +75,36 @@ class GpuVirtualMemAllocator : public SubAllocator {
 
   bool SupportsCoalescing() const override { return true; }
 
+  bool SupportsDecommit() const override { return supports_decommit_; }
+  size_t DecommitGranularity() const override { return granularity_; }
+
+  // Synchronizes the context before unmapping the pages, as kernels queued
+  // before the range was freed may still access it.
+  bool Decommit(void* ptr, size_t num_bytes) override;
+  bool Recommit(void* ptr, size_t num_bytes) override;
+
  private:
+  struct Mapping {
+    stream_executor::gpu::GpuDevicePtr va;
+    stream_executor::gpu::GpuDriver::GenericMemoryHandle physical;
+  };
+
   GpuVirtualMemAllocator(
       const std::vector<Visitor>& alloc_visitors,
       const std::vector<Visitor>& free_visitors,
       stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
       std::vector<stream_executor::gpu::GpuDeviceHandle> access_device_handles,
-      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity);
+      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity,
+      bool supports_decommit);
+
+  // Maps physical memory behind the num_bytes from va, in pages of page_bytes,
+  // and adds them to mappings_. On failure, nothing stays mapped.
+  stream_executor::port::Status MapPages(stream_executor::gpu::GpuDevicePtr va,
+                                         size_t num_bytes, size_t page_bytes);
+
+  // Returns the first mapping at or after va.
+  std::vector<Mapping>::iterator LowerBound(
+      stream_executor::gpu::GpuDevicePtr va);
 
   stream_executor::gpu::GpuContext& gpu_context_;
   PlatformDeviceId gpu_id_;
@@ -97,10 +125,8 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // Smallest allocation as determined by CUDA.
   const size_t granularity_;
 
-  struct Mapping {
-    stream_executor::gpu::GpuDevicePtr va;
-    stream_executor::gpu::GpuDriver::GenericMemoryHandle physical;
-  };
+  const bool supports_decommit_;
+
   // List of mappings, sorted by va.
   std::vector<Mapping> mappings_;
 
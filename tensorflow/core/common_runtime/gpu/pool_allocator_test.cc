@@ -246,6 +246,59 @@ TEST(PoolAllocatorTest, Pow2Rounder) {
   EXPECT_EQ(65536, rounder.RoundUp(65536));
 }
 
+TEST(PoolAllocatorTest, SizeClassRounder) {
+  SizeClassRounder rounder;
+  EXPECT_EQ(1, rounder.RoundUp(1));
+  EXPECT_EQ(8, rounder.RoundUp(8));
+  EXPECT_EQ(10, rounder.RoundUp(9));
+  EXPECT_EQ(16, rounder.RoundUp(15));
+  EXPECT_EQ(20, rounder.RoundUp(17));
+  EXPECT_EQ(40960, rounder.RoundUp(40000));
+  EXPECT_EQ(65536, rounder.RoundUp(65535));
+  EXPECT_EQ(81920, rounder.RoundUp(65537));
+}
+
+TEST(PoolAllocatorTest, MemoryLimitAndStats) {
+  se::Platform* platform =
+      se::MultiPlatformManager::PlatformWithName(GpuPlatformName())
+          .ValueOrDie();
+  PoolAllocator pool(
+      10 /*pool_size_limit*/, false /*auto_resize*/,
+      new DeviceHostAllocator(
+          platform->GetExecutor(se::StreamExecutorConfig(/*ordinal=*/0))
+              .ValueOrDie(),
+          0 /*numa_node*/, {}, {}),
+      new Pow2Rounder, "pool", 4096 /*memory_limit*/);
+
+  // Each buffer takes 2048 bytes with its ChunkPrefix.
+  void* p1 = pool.AllocateRaw(4, 1024 + 1);
+  void* p2 = pool.AllocateRaw(4, 1024 + 1);
+  ASSERT_NE(nullptr, p1);
+  ASSERT_NE(nullptr, p2);
+  EXPECT_EQ(nullptr, pool.AllocateRaw(4, 1024 + 1));
+  absl::optional<AllocatorStats> stats = pool.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(4096, stats->bytes_in_use);
+  EXPECT_EQ(4096, *stats->pool_bytes);
+  EXPECT_EQ(4096, *stats->bytes_limit);
+
+  // The freed buffers stay in the pool, until a buffer of another size
+  // needs the memory.
+  pool.DeallocateRaw(p1);
+  pool.DeallocateRaw(p2);
+  EXPECT_EQ(0, pool.GetStats()->bytes_in_use);
+  EXPECT_EQ(4096, *pool.GetStats()->pool_bytes);
+  void* p3 = pool.AllocateRaw(4, 4000);
+  ASSERT_NE(nullptr, p3);
+  EXPECT_EQ(2, pool.evicted_count());
+  stats = pool.GetStats();
+  EXPECT_EQ(4096, stats->bytes_in_use);
+  EXPECT_EQ(4096, *stats->pool_bytes);
+  EXPECT_EQ(4096, stats->peak_bytes_in_use);
+  pool.DeallocateRaw(p3);
+}
+
 TEST(PoolAllocatorTest, Name) {
   se::Platform* platform =
       se::MultiPlatformManager::PlatformWithName(GpuPlatformName())
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <utility>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -59,6 +61,15 @@ class GPUDeviceContext : public DeviceContext {
   }
   int stream_id() const { return stream_id_; }
 
+  // The streams that stream() waits for before running each op with this
+  // context, i.e. the other streams the inputs of the op are produced on.
+  const gtl::InlinedVector<se::Stream*, 2>& input_streams() const {
+    return input_streams_;
+  }
+  void set_input_streams(gtl::InlinedVector<se::Stream*, 2> input_streams) {
+    input_streams_ = std::move(input_streams);
+  }
+
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
                              bool sync_dst_compute) const override;
@@ -92,6 +103,8 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  // Compute streams that the stream waits for before each op.
+  gtl::InlinedVector<se::Stream*, 2> input_streams_;
 };
 
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 
 #include <algorithm>
+#include <functional>
+#include <queue>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -340,8 +342,8 @@ class GraphConstructor {
   gtl::FlatMap<string, string> uniquified_names_;
 
   // Index of NodeDefs in node_defs_ with all inputs already converted. We use a
-  // (sorted) set so nodes are created in the order defined in the GraphDef.
-  std::set<int> ready_;
+  // min-heap so nodes are created in the order defined in the GraphDef.
+  std::priority_queue<int, std::vector<int>, std::greater<int>> ready_;
 
   // Mapping between index within node_defs_ and the number of inputs that
   // still need to be converted.
@@ -354,10 +356,12 @@ class GraphConstructor {
   // Used in the conversion from node_defs_ to g_ to represent the ith input
   // of a node.
   struct InputInfo {
-    explicit InputInfo(const string& node_name, Node* n, int i)
+    explicit InputInfo(StringPiece node_name, Node* n, int i)
         : name(node_name), node(n), index(i) {}
-    // Use string instead of StringPiece so we don't have to manage lifetime
-    string name;
+    // Points to a key of gdef_nodes_ or existing_nodes_, which aren't
+    // modified after BuildNodeIndex(), rather than to the NodeDef whose inputs
+    // may be rewritten.
+    StringPiece name;
     Node* node;
     int index;
 
@@ -375,10 +379,10 @@ class GraphConstructor {
   // Used in the conversion from node_defs_ to g_ to represent an edge from
   // the node named 'name' to node 'n'.
   struct EdgeInfo {
-    explicit EdgeInfo(const string& name, int i1, Node* n, int i2)
+    explicit EdgeInfo(StringPiece name, int i1, Node* n, int i2)
         : src_name(name), src_index(i1), dst_node(n), dst_index(i2) {}
-    // Use string instead of StringPiece so we don't have to manage lifetime
-    string src_name;
+    // Points to a key of gdef_nodes_, like InputInfo::name.
+    StringPiece src_name;
     int src_index;
     Node* dst_node;
     int dst_index;
@@ -536,7 +540,7 @@ void GraphConstructor::UpdatePendingCountAndReady(int processed,
       CHECK_GT(*current_pending_count, 0);
       (*current_pending_count)--;
       if (*current_pending_count == 0) {
-        ready_.insert(output);
+        ready_.push(output);
       }
     }
   }
@@ -639,6 +643,7 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 
 Status GraphConstructor::BuildNodeIndex() {
   // Validate the node names and add them to gdef_nodes_ and gdef_prefixes_.
+  gdef_nodes_.reserve(node_def_count());
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (!IsValidNodeName(node_def.name(), opts_.allow_internal_ops)) {
@@ -685,7 +690,8 @@ Status GraphConstructor::InitFromEdges() {
   const int num_nodes = node_def_count();
   pending_count_.reserve(num_nodes);
   outputs_.resize(num_nodes);
-  gtl::FlatSet<string> next_iteration_nodes;
+  // The NodeDefs aren't consumed until Convert(), so their names outlive this.
+  absl::flat_hash_set<StringPiece> next_iteration_nodes;
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (IsNextIteration(node_def)) {
@@ -710,8 +716,7 @@ Status GraphConstructor::InitFromEdges() {
           num_control_edges++;
         } else {
           TensorId id(ParseTensorName(input_name));
-          if (next_iteration_nodes.find(string(id.first)) !=
-              next_iteration_nodes.end()) {
+          if (next_iteration_nodes.contains(id.first)) {
             has_loop_back_edge = true;
           }
         }
@@ -741,7 +746,7 @@ Status GraphConstructor::InitFromEdges() {
       }
     }
     if (pending_count == 0) {
-      ready_.insert(n);
+      ready_.push(n);
     }
     pending_count_.push_back(pending_count);
   }
@@ -1118,8 +1123,8 @@ Status GraphConstructor::Convert() {
   // inputs, pending_counts_ with the number of inputs for each node and
   // outputs_ with the outputs of each node).
   while (!ready_.empty()) {
-    int o = *ready_.begin();
-    ready_.erase(ready_.begin());
+    int o = ready_.top();
+    ready_.pop();
     ++processed;
     inputs.clear();
     bool has_data_back_edge = false;
@@ -1133,7 +1138,8 @@ Status GraphConstructor::Convert() {
     input_already_exists.clear();
     input_already_exists.resize(node_def.input_size(), false);
 
-    std::string node_name = node_def.name();
+    // Looked up before the name is prefixed or uniquified.
+    NodeInfo* node_info = &gdef_nodes_.find(node_def.name())->second;
 
     if (opts_.importing) {
       if (opts_.skip_mapped_nodes) {
@@ -1163,6 +1169,7 @@ Status GraphConstructor::Convert() {
     TF_RETURN_IF_ERROR(ValidateColocationConstraints(node_def));
     for (int i = 0; i < node_def.input_size(); ++i) {
       TensorId tensor_id = ParseTensorName(node_def.input(i));
+      StringPiece src_name;
       Node* src_node;
       int src_index;
 
@@ -1170,6 +1177,7 @@ Status GraphConstructor::Convert() {
         // Locate input in newly-imported nodes
         auto iter = gdef_nodes_.find(tensor_id.node());
         DCHECK(iter != gdef_nodes_.end()) << tensor_id.node();
+        src_name = iter->first;
         src_node = iter->second.node;
         src_index = tensor_id.index();
         if (src_node == nullptr) has_data_back_edge = true;
@@ -1177,6 +1185,7 @@ Status GraphConstructor::Convert() {
         // Input refers to preexistng node in graph
         auto iter = existing_nodes_.find(tensor_id.node());
         DCHECK(iter != existing_nodes_.end()) << tensor_id.node();
+        src_name = iter->first;
         src_node = iter->second;
         src_index = tensor_id.index();
       }
@@ -1197,7 +1206,7 @@ Status GraphConstructor::Convert() {
         return errors::InvalidArgument(out.str());
       }
 
-      inputs.emplace_back(string(tensor_id.node()), src_node, src_index);
+      inputs.emplace_back(src_name, src_node, src_index);
     }
 
     if (has_data_back_edge && !IsMerge(node_def)) {
@@ -1234,7 +1243,7 @@ Status GraphConstructor::Convert() {
 
     TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
 
-    gdef_nodes_[node_name].node = node;
+    node_info->node = node;
 
     // Remove duplicate control inputs before adding edges to the graph. It
     // will allow us to skip expensive duplicates check in 'AddControlEdge'.
@@ -1284,7 +1293,7 @@ Status GraphConstructor::Convert() {
 Status GraphConstructor::AddBackEdges() {
   // Add the back edges after all nodes are created.
   for (const auto& e : back_edges_) {
-    Node* src_node = gdef_nodes_[e.src_name].node;
+    Node* src_node = gdef_nodes_.find(e.src_name)->second.node;
     if (e.src_index == Graph::kControlSlot) {
       g_->AddControlEdge(src_node, e.dst_node, kDoNotCheckDuplicates);
     } else {
@@ -22,6 +22,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_join.h"
@@ -683,6 +684,7 @@ Status GraphExecutionState::OptimizeGraph(
 
     // Add feeds to the GrapplerItem if we know them.
     absl::flat_hash_set<absl::string_view> node_names;
+    absl::flat_hash_map<string, TensorShape> specialized_feed_nodes;
     if (!(options.callable_options.feed().empty() &&
           options.callable_options.tensor_connection().empty())) {
       std::vector<SafeTensorId> feeds;
@@ -699,6 +701,16 @@ Status GraphExecutionState::OptimizeGraph(
       // the graph to infer feed data type and shape.
       absl::flat_hash_set<absl::string_view> feed_nodes;
 
+      // The shapes that the fed Placeholders are guaranteed to have in every
+      // run of the graph.
+      absl::flat_hash_map<string, TensorShape> feed_node_shapes;
+      for (const auto& feed_shape : options.feed_shapes) {
+        const SafeTensorId feed(ParseTensorName(feed_shape.first));
+        if (feed.index() == 0) {
+          feed_node_shapes.emplace(feed.node(), feed_shape.second);
+        }
+      }
+
       // For feeds with tensor index larger than 0, we can't infer data type or
       // shape from the graph. Currently we only support type and shape
       // inference from a small set of node types: Placeholder, Const, etc...
@@ -736,6 +748,20 @@ Status GraphExecutionState::OptimizeGraph(
           continue;
         }
 
+        // A Placeholder whose shape is guaranteed is specialized to it rather
+        // than fed, so that the optimizers do not treat its shape as unknown.
+        auto feed_node_shape = feed_node_shapes.find(node->name());
+        if (node->type_string() == "Placeholder" &&
+            feed_node_shape != feed_node_shapes.end() &&
+            partial_shape.IsCompatibleWith(feed_node_shape->second)) {
+          VLOG(3) << "Specialize feed: " << node->name()
+                  << "; shape: " << feed_node_shape->second;
+          specialized_feed_nodes.emplace(node->name(),
+                                         feed_node_shape->second);
+          item.keep_ops.push_back(node->name());
+          continue;
+        }
+
         // If the shape of the placeholder is only partially known, we are free
         // to set unknown dimensions of its shape to any value we desire. We
         // choose 0 to minimize the memory impact. Note that this only matters
@@ -788,6 +814,14 @@ Status GraphExecutionState::OptimizeGraph(
 
     // Convert Graph to GraphDef and add it to the GrapplerItem.
     graph.ToGraphDef(&item.graph);
+    if (!specialized_feed_nodes.empty()) {
+      for (NodeDef& node : *item.graph.mutable_node()) {
+        auto it = specialized_feed_nodes.find(node.name());
+        if (it != specialized_feed_nodes.end()) {
+          it->second.AsProto((*node.mutable_attr())["shape"].mutable_shape());
+        }
+      }
+    }
     // TODO(b/114748242): Add a unit test to test this bug fix.
     if (flib_def) {
       *item.graph.mutable_library() = flib_def->ToProto();
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/graph_view.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -114,12 +116,14 @@ size_t GraphView::NodeItemBytes(const Node* n) {
                 "NodeItem must be aligned with AllocatorAttributes");
   static_assert(sizeof(EdgeInfo) % alignof(AllocatorAttributes) == 0,
                 "EdgeInfo must be aligned with AllocatorAttributes");
+  static_assert(sizeof(NodeItem) <= 64, "NodeItem must fit in a cache line");
   const size_t bytes =
       ((raw_bytes + kItemAlignment - 1) / kItemAlignment) * kItemAlignment;
   return bytes;
 }
 
-char* GraphView::InitializeNode(char* ptr, const Node* n) {
+char* GraphView::InitializeNode(char* ptr, const Node* n,
+                                const std::vector<int32>& positions) {
   const int id = n->id();
   CHECK(node_offsets_[id] == kuint32max);  // Initial value in constructor
 
@@ -150,12 +154,8 @@ char* GraphView::InitializeNode(char* ptr, const Node* n) {
   item->num_output_edges = num_output_edges;
   item->num_output_control_edges = num_output_control_edges;
 
-  // Fill output edges.
-  // Keep track of the last EdgeInfo in the EdgeInfo array that references
-  // a given output slot.  For all but the last, we need to do a copy of the
-  // Tensor when propagating results downstream in the graph, but for the
-  // last one, we can just do a move of the Tensor object to propagate it.
-  gtl::InlinedVector<EdgeInfo*, 4> last_indices(num_outputs, nullptr);
+  // Fill output edges, in the order of their destinations in space_, so that
+  // propagating the outputs walks forward through memory.
   EdgeInfo* dst_edge = item->output_edge_base();
   for (auto e : n->out_edges()) {
     if (e->IsControlEdge()) continue;
@@ -163,15 +163,26 @@ char* GraphView::InitializeNode(char* ptr, const Node* n) {
     CHECK_LE(e->src_output(), 0x3FFFFFFF);  // Must fit in 31 bits
     dst_edge->output_slot = e->src_output();
     dst_edge->is_last = false;
-    const int output_slot = dst_edge->output_slot;
-    if (output_slot >= 0) {
-      last_indices[output_slot] = dst_edge;
-    }
     // NOTE: The `input_slot` will be rewritten to the frame-wide offset later
     // in `ExecutorImpl::Initialize()`.
     dst_edge->input_slot = e->dst_input();
     dst_edge++;
   }
+  std::stable_sort(item->output_edge_base(), dst_edge,
+                   [&positions](const EdgeInfo& a, const EdgeInfo& b) {
+                     return positions[a.dst_id] < positions[b.dst_id];
+                   });
+  // Keep track of the last EdgeInfo in the EdgeInfo array that references
+  // a given output slot.  For all but the last, we need to do a copy of the
+  // Tensor when propagating results downstream in the graph, but for the
+  // last one, we can just do a move of the Tensor object to propagate it.
+  gtl::InlinedVector<EdgeInfo*, 4> last_indices(num_outputs, nullptr);
+  for (EdgeInfo* edge_info = item->output_edge_base(); edge_info != dst_edge;
+       ++edge_info) {
+    if (edge_info->output_slot >= 0) {
+      last_indices[edge_info->output_slot] = edge_info;
+    }
+  }
   for (EdgeInfo* edge_info : last_indices) {
     if (edge_info != nullptr) {
       edge_info->is_last = true;
@@ -183,6 +194,11 @@ char* GraphView::InitializeNode(char* ptr, const Node* n) {
     dst_control_edge->dst_id = e->dst()->id();
     dst_control_edge++;
   }
+  std::stable_sort(
+      item->output_control_edge_base(), dst_control_edge,
+      [&positions](const ControlEdgeInfo& a, const ControlEdgeInfo& b) {
+        return positions[a.dst_id] < positions[b.dst_id];
+      });
 
   AllocatorAttributes* output_attrs = item->output_attr_base();
   for (int i = 0; i < num_outputs; i++) {
@@ -262,10 +278,30 @@ Status GraphView::Initialize(const Graph* g) {
     node_offsets_[i] = kuint32max;
   }
 
+  // Lay the nodes out in a topological order, so that the executor mostly
+  // walks forward through space_ and the per-node state allocated in the
+  // same order. The nodes that the search does not reach, if any, follow in
+  // ID order.
+  std::vector<Node*> order;
+  GetReversePostOrder(*g, &order, NodeComparatorID());
+  std::vector<int32> positions(num_nodes, -1);
+  node_order_.clear();
+  node_order_.reserve(g->num_nodes());
+  for (const Node* n : order) {
+    positions[n->id()] = node_order_.size();
+    node_order_.push_back(n->id());
+  }
+  for (const Node* n : g->nodes()) {
+    if (positions[n->id()] < 0) {
+      positions[n->id()] = node_order_.size();
+      node_order_.push_back(n->id());
+    }
+  }
+
   space_ = new char[total_bytes];  // NodeItem objects are allocated here
   char* ptr = space_;
-  for (const Node* n : g->nodes()) {
-    ptr = InitializeNode(ptr, n);
+  for (int32_t id : node_order_) {
+    ptr = InitializeNode(ptr, g->FindNodeId(id), positions);
   }
   CHECK_EQ(ptr, space_ + total_bytes);
   return Status::OK();
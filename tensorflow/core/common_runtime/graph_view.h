@@ -55,7 +55,10 @@ struct ControlEdgeInfo {
 
 // Compact structure representing a graph node and its associated kernel.
 //
-// Each NodeItem is an element of exactly one GraphView.
+// Each NodeItem is an element of exactly one GraphView. The fields that are
+// read when propagating outputs to a node (its flags, counts and input
+// offset) come first, followed by the output edges, so that activating a node
+// touches as few cache lines as possible.
 struct NodeItem {
   // The index of this node's item in its GraphView.
   int node_id = -1;
@@ -86,12 +89,6 @@ struct NodeItem {
   bool is_distributed_communication : 1;  // True iff the op is registered to
                                           // use distributed communication.
 
-  // The kernel for this node.
-  OpKernel* kernel = nullptr;
-
-  // If the kernel is a Const op, this containts points to the constant tensor.
-  const Tensor* const_tensor = nullptr;
-
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
   int num_inputs;
@@ -107,6 +104,12 @@ struct NodeItem {
   // Number of output control edges.
   int32 num_output_control_edges;
 
+  // The kernel for this node.
+  OpKernel* kernel = nullptr;
+
+  // If the kernel is a Const op, this containts points to the constant tensor.
+  const Tensor* const_tensor = nullptr;
+
   // If non-null, contains an array of num_outputs bools, where the ith bool
   // is true if and only if the ith output is consumed by another node.
   std::unique_ptr<bool[]> outputs_required;
@@ -152,7 +155,8 @@ struct NodeItem {
   NodeItem() {}
 
   // Variable length section starts immediately after *this
-  // (uint8 is enough for DataType).
+  // (uint8 is enough for DataType). The edges are sorted by the position of
+  // their destination in the GraphView.
   //   EdgeInfo            out_edges[num_output_edges];
   //   ControlEdgeInfo     out_control_edges[num_output_control_edges];
   //   AllocatorAttributes output_attr[num_outputs];
@@ -239,11 +243,20 @@ class GraphView {
 
   int32 num_nodes() const { return num_nodes_; }
 
+  // Returns the IDs of the nodes in the order in which their `NodeItem`s are
+  // laid out, which is a topological order of the graph without the back
+  // edges of its loops. Consumers of per-node state should allocate it in
+  // this order, so that the state of a node is close to that of its
+  // successors.
+  const std::vector<int32>& node_order() const { return node_order_; }
+
  private:
-  char* InitializeNode(char* ptr, const Node* n);
+  char* InitializeNode(char* ptr, const Node* n,
+                       const std::vector<int32>& positions);
   size_t NodeItemBytes(const Node* n);
 
   int32 num_nodes_ = 0;
+  std::vector<int32> node_order_;
   uint32* node_offsets_ = nullptr;  // array of size "num_nodes_"
   // node_offsets_[id] holds the byte offset for node w/ "id" in space_
 
@@ -0,0 +1,312 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns the index of the member at `rank` among the members on its task.
+int LocalIndex(const CollGroupParams& group, int rank) {
+  int local_index = 0;
+  for (int i = 0; i < rank; ++i) {
+    if (group.members[i].task == group.members[rank].task) {
+      ++local_index;
+    }
+  }
+  return local_index;
+}
+
+}  // namespace
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HierarchicalReduce only supports reductions, got ",
+                            col_params->ToString());
+  }
+  if (col_params->group.device_type != DEVICE_GPU) {
+    return errors::Internal("HierarchicalReduce requires GPU devices, got ",
+                            col_params->group.device_type.type_string());
+  }
+  if (!col_params->group.same_num_devices_per_task) {
+    return errors::Internal(
+        "HierarchicalReduce requires the same number of devices on every "
+        "task, got ",
+        col_params->group.ToString());
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params;
+  TF_RETURN_IF_ERROR(collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality));
+
+  local_reduce_params_.reset(new CollectiveParams());
+  TF_RETURN_IF_ERROR(
+      BuildLocalParams(*col_params_, local_reduce_params_.get()));
+  // The gather is ordered after the reduction by this device, so only the
+  // reduction waits on the instance's dependencies.
+  local_gather_params_.reset(new CollectiveParams());
+  TF_RETURN_IF_ERROR(
+      BuildLocalParams(*col_params_, local_gather_params_.get()));
+  local_gather_params_->instance.type = GATHER_COLLECTIVE;
+  local_gather_params_->instance.impl_details.dependencies.clear();
+  cross_task_params_.reset(new CollectiveParams());
+  return BuildCrossTaskParams(*col_params_, cross_task_params_.get());
+}
+
+/* static */ Status HierarchicalReducer::BuildLocalParams(
+    const CollectiveParams& col_params, CollectiveParams* local) {
+  const CollGroupParams& group = col_params.group;
+  const string& task = group.members[col_params.default_rank].task;
+  local->group.group_key = group.group_key;
+  local->group.device_type = group.device_type;
+  local->group.num_tasks = 1;
+  local->group.same_num_devices_per_task = true;
+  // An empty communicator key makes NCCL build a task-local communicator.
+  local->group.runtime_details.communicator_key.clear();
+  local->group.members.clear();
+  for (int i = 0; i < group.members.size(); ++i) {
+    if (group.members[i].task != task) continue;
+    if (i == col_params.default_rank) {
+      local->default_rank = local->group.members.size();
+    }
+    local->group.members.push_back(group.members[i]);
+  }
+  local->group.group_size = local->group.members.size();
+  local->group.num_devices_per_task.clear();
+  local->group.num_devices_per_task[task] = local->group.group_size;
+  local->instance = col_params.instance;
+  local->instance.impl_details = col_params.instance.impl_details;
+  local->name = col_params.name;
+  local->merge_op = col_params.merge_op;
+  local->final_op = nullptr;
+  return Status::OK();
+}
+
+/* static */ Status HierarchicalReducer::BuildCrossTaskParams(
+    const CollectiveParams& col_params, CollectiveParams* cross_task) {
+  const CollGroupParams& group = col_params.group;
+  const int local_index = LocalIndex(group, col_params.default_rank);
+  const string& task = group.members[col_params.default_rank].task;
+  cross_task->group.group_key = group.group_key;
+  cross_task->group.device_type = group.device_type;
+  cross_task->group.same_num_devices_per_task = true;
+  cross_task->group.members.clear();
+  cross_task->group.num_devices_per_task.clear();
+  // Walk the tasks in the order they first appear so that every device
+  // derives the same ring order.
+  std::vector<string> tasks;
+  std::unordered_map<string, int> members_seen;
+  for (int i = 0; i < group.members.size(); ++i) {
+    const CollGroupMember& member = group.members[i];
+    const int index = members_seen[member.task]++;
+    if (index == 0) {
+      tasks.push_back(member.task);
+    }
+    if (index != local_index) continue;
+    if (member.task == task) {
+      cross_task->default_rank = cross_task->group.members.size();
+    }
+    cross_task->group.members.push_back(member);
+    cross_task->group.num_devices_per_task[member.task] = 1;
+  }
+  if (cross_task->group.members.size() != tasks.size()) {
+    return errors::Internal("Device ", local_index, " of task ", task,
+                            " has no peer on some task of group ",
+                            group.ToString());
+  }
+  cross_task->group.group_size = cross_task->group.members.size();
+  cross_task->group.num_tasks = cross_task->group.group_size;
+  cross_task->instance = col_params.instance;
+  cross_task->instance.impl_details = col_params.instance.impl_details;
+  cross_task->instance.impl_details.collective_name = "RingReduce";
+  cross_task->instance.impl_details.dependencies.clear();
+  cross_task->name = col_params.name;
+  cross_task->merge_op = col_params.merge_op;
+  // The final op needs the size of the whole group, so it runs once at the
+  // end rather than inside the ring.
+  cross_task->final_op = nullptr;
+  return Status::OK();
+}
+
+/* static */ int64_t HierarchicalReducer::ShardElements(
+    int64_t num_elements, int num_shards, int64_t align_elements) {
+  return num_elements / num_shards / align_elements * align_elements;
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  if (col_ctx_->nccl_communicator == nullptr) {
+    done(errors::Internal("HierarchicalReduce requires NCCL, which is not "
+                          "available for device ",
+                          col_ctx_->device_name));
+    return;
+  }
+  Status status = RunLocalNccl(local_reduce_params_.get(),
+                               strings::StrCat(col_ctx_->exec_key, ":local"),
+                               col_ctx_->input, col_ctx_->output);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+
+  const int num_local_devices = local_reduce_params_->group.group_size;
+  const int local_rank = local_reduce_params_->default_rank;
+  const int64_t num_elements = col_ctx_->output->NumElements();
+  const DataType dtype = col_ctx_->output->dtype();
+  const int64_t shard_elements = ShardElements(
+      num_elements, num_local_devices,
+      std::max<int64_t>(1, EIGEN_MAX_ALIGN_BYTES / DataTypeSize(dtype)));
+  const int64_t tail_begin = shard_elements * num_local_devices;
+  Tensor flat;
+  if (!flat.CopyFrom(*col_ctx_->output, TensorShape({num_elements}))) {
+    done(errors::Internal("Failed to flatten the output of ",
+                          col_params_->name));
+    return;
+  }
+  Tensor shard;
+  if (shard_elements > 0) {
+    shard = flat.Slice(local_rank * shard_elements,
+                       (local_rank + 1) * shard_elements);
+    // Rings of different local ranks run on the same tasks, so the rank is
+    // part of the key that keeps their buffers apart.
+    status = RunCrossTaskRing(
+        strings::StrCat(col_ctx_->exec_key, ":shard", local_rank), &shard);
+  }
+  if (status.ok() && tail_begin < num_elements) {
+    // Every local device holds the same partial sums of the tail, so each of
+    // them reduces it with its peers instead of waiting for a broadcast.
+    Tensor tail = flat.Slice(tail_begin, num_elements);
+    status = RunCrossTaskRing(
+        strings::StrCat(col_ctx_->exec_key, ":tail", local_rank), &tail);
+  }
+  if (status.ok() && shard_elements > 0) {
+    // Each shard already sits at its rank's offset, so NCCL gathers in place.
+    Tensor gathered = flat.Slice(0, tail_begin);
+    status = RunLocalNccl(local_gather_params_.get(),
+                          strings::StrCat(col_ctx_->exec_key, ":gather"),
+                          &shard, &gathered);
+  }
+  if (status.ok() && col_params_->final_op) {
+    status = RunFinalOp();
+  }
+  done(status);
+}
+
+Status HierarchicalReducer::RunLocalNccl(const CollectiveParams* params,
+                                         const string& exec_key,
+                                         const Tensor* input, Tensor* output) {
+  profiler::TraceMe activity("HierarchicalReduceLocal",
+                             profiler::TraceMeLevel::kInfo);
+  auto ctx = std::make_shared<CollectiveContext>(
+      col_ctx_->col_exec, col_ctx_->nccl_communicator, col_ctx_->dev_mgr,
+      col_ctx_->op_ctx, col_ctx_->op_params, params, exec_key,
+      col_ctx_->step_id, input, output);
+  ctx->device = col_ctx_->device;
+  ctx->device_locality = col_ctx_->device_locality;
+  Status status;
+  Notification note;
+  col_ctx_->nccl_communicator->Enqueue(ctx, [&status, &note](const Status& s) {
+    status = s;
+    note.Notify();
+  });
+  note.WaitForNotification();
+  return status;
+}
+
+Status HierarchicalReducer::RunCrossTaskRing(const string& exec_key,
+                                             Tensor* tensor) {
+  profiler::TraceMe activity("HierarchicalReduceCrossTask",
+                             profiler::TraceMeLevel::kInfo);
+  CollImplDetails& impl_details = cross_task_params_->instance.impl_details;
+  cross_task_params_->instance.shape = tensor->shape();
+  impl_details.subdiv_offsets.clear();
+  impl_details.subdiv_permutations.clear();
+  cross_task_params_->subdiv_rank.clear();
+  CollectiveImplementationInterface* ring = nullptr;
+  TF_RETURN_IF_ERROR(
+      CollectiveRegistry::Lookup(impl_details.collective_name, &ring));
+  core::ScopedUnref unref(ring);
+  TF_RETURN_IF_ERROR(
+      ring->InitializeCollectiveParams(cross_task_params_.get()));
+  auto ctx = std::make_shared<CollectiveContext>(
+      col_ctx_->col_exec, col_ctx_->nccl_communicator, col_ctx_->dev_mgr,
+      col_ctx_->op_ctx, col_ctx_->op_params, cross_task_params_.get(),
+      exec_key, col_ctx_->step_id, tensor, tensor);
+  TF_RETURN_IF_ERROR(ring->InitializeCollectiveContext(ctx));
+  Status status;
+  Notification note;
+  ring->Run([&status, &note](const Status& s) {
+    status = s;
+    note.Notify();
+  });
+  note.WaitForNotification();
+  return status;
+}
+
+Status HierarchicalReducer::RunFinalOp() {
+  Allocator* allocator =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0));
+  std::unique_ptr<CollectiveAdapter> ca(
+      MakeCollectiveAdapter(col_ctx_->output, /*num_chunks=*/1, allocator,
+                            /*align_chunks=*/false));
+  Tensor group_size_val = ca->Scalar(col_params_->group.group_size);
+  Tensor group_size = ca->Scalar(allocator, AllocationAttributes());
+  Status status;
+  Notification note;
+  col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+      &group_size_val, col_ctx_->device, &group_size,
+      [&status, &note](const Status& s) {
+        status = s;
+        note.Notify();
+      });
+  note.WaitForNotification();
+  TF_RETURN_IF_ERROR(status);
+  return collective_util::ComputeBinOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->final_op, col_ctx_->output, &group_size);
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+}  // namespace
+
+}  // namespace tensorflow
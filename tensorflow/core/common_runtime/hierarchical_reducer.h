@@ -0,0 +1,89 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/refcount.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce for groups that span
+// several tasks with the same number of devices each.
+//
+// 1. The devices of each task all-reduce the input with NCCL, so every local
+//    device holds the task's partial sum.
+// 2. The tensor is split into one shard per local device. The device with
+//    local index i ring-reduces shard i with the devices of the same local
+//    index on the other tasks, through the executor's remote access.
+// 3. The devices of each task all-gather the reduced shards with NCCL.
+//
+// Only 1/num_local_devices of the tensor crosses the network from each device,
+// and the intra-task traffic stays on the fast local interconnect.
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer() = default;
+  ~HierarchicalReducer() override = default;
+
+  // Checks that the group has the same number of devices on every task.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes the device and locality and builds the task-local and
+  // cross-task groups that this device takes part in.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Runs the three phases. Blocks, so it must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+  // Fills `local` with the group formed by the devices on the same task as
+  // the default rank of `col_params`.
+  static Status BuildLocalParams(const CollectiveParams& col_params,
+                                 CollectiveParams* local);
+
+  // Fills `cross_task` with the group formed by the device at the same
+  // task-local index as the default rank of `col_params` on every task.
+  static Status BuildCrossTaskParams(const CollectiveParams& col_params,
+                                     CollectiveParams* cross_task);
+
+  // Returns the number of elements in each of `num_shards` equal shards of a
+  // tensor of `num_elements`. Shards are a multiple of `align_elements` long so
+  // that every shard is an aligned slice; the remaining tail elements are
+  // reduced separately.
+  static int64_t ShardElements(int64_t num_elements, int num_shards,
+                               int64_t align_elements);
+
+ private:
+  // Runs a task-local NCCL collective described by `params`.
+  Status RunLocalNccl(const CollectiveParams* params, const string& exec_key,
+                      const Tensor* input, Tensor* output);
+  // Ring-reduces `tensor` in place among the cross-task group.
+  Status RunCrossTaskRing(const string& exec_key, Tensor* tensor);
+  // Applies the final op with the size of the whole group.
+  Status RunFinalOp();
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  core::RefCountPtr<CollectiveParams> local_reduce_params_;
+  core::RefCountPtr<CollectiveParams> local_gather_params_;
+  core::RefCountPtr<CollectiveParams> cross_task_params_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
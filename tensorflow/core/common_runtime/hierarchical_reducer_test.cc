@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kNumWorkers = 3;
+constexpr int kNumDevicesPerWorker = 4;
+
+class HierarchicalReducerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    test_env_ = CreateCollectiveTestEnv(kNumWorkers, kNumDevicesPerWorker,
+                                        DEVICE_CPU);
+  }
+
+  core::RefCountPtr<CollectiveParams> ParamsForRank(int rank) {
+    core::RefCountPtr<CollectiveParams> col_params = CreateCollectiveParams(
+        *test_env_, rank, "HierarchicalReduce", REDUCTION_COLLECTIVE,
+        DT_FLOAT, TensorShape({1024}));
+    col_params->group.same_num_devices_per_task = true;
+    return col_params;
+  }
+
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+};
+
+TEST_F(HierarchicalReducerTest, LocalParams) {
+  // Rank 6 is device 2 of task 1.
+  core::RefCountPtr<CollectiveParams> col_params = ParamsForRank(6);
+  core::RefCountPtr<CollectiveParams> local(new CollectiveParams());
+  TF_ASSERT_OK(
+      HierarchicalReducer::BuildLocalParams(*col_params, local.get()));
+  EXPECT_EQ(local->group.group_size, kNumDevicesPerWorker);
+  EXPECT_EQ(local->group.num_tasks, 1);
+  EXPECT_EQ(local->default_rank, 2);
+  EXPECT_TRUE(local->group.runtime_details.communicator_key.empty());
+  for (const CollGroupMember& member : local->group.members) {
+    EXPECT_EQ(member.task, "/job:worker/replica:0/task:1");
+  }
+  EXPECT_EQ(local->group.members[2].device.name(),
+            col_params->group.members[6].device.name());
+  EXPECT_EQ(local->final_op, nullptr);
+}
+
+TEST_F(HierarchicalReducerTest, CrossTaskParams) {
+  core::RefCountPtr<CollectiveParams> col_params = ParamsForRank(6);
+  core::RefCountPtr<CollectiveParams> cross_task(new CollectiveParams());
+  TF_ASSERT_OK(HierarchicalReducer::BuildCrossTaskParams(*col_params,
+                                                         cross_task.get()));
+  EXPECT_EQ(cross_task->group.group_size, kNumWorkers);
+  EXPECT_EQ(cross_task->group.num_tasks, kNumWorkers);
+  EXPECT_EQ(cross_task->default_rank, 1);
+  EXPECT_EQ(cross_task->instance.impl_details.collective_name, "RingReduce");
+  for (int wi = 0; wi < kNumWorkers; ++wi) {
+    // Every ring member is device 2 of its task.
+    EXPECT_EQ(cross_task->group.members[wi].device.name(),
+              col_params->group.members[wi * kNumDevicesPerWorker + 2]
+                  .device.name());
+  }
+}
+
+TEST_F(HierarchicalReducerTest, ShardElements) {
+  EXPECT_EQ(HierarchicalReducer::ShardElements(1024, 4, 16), 256);
+  // Shards are rounded down to the alignment, leaving a tail.
+  EXPECT_EQ(HierarchicalReducer::ShardElements(1000, 4, 16), 240);
+  // Tensors smaller than one aligned shard per device are all tail.
+  EXPECT_EQ(HierarchicalReducer::ShardElements(40, 4, 16), 0);
+}
+
+TEST_F(HierarchicalReducerTest, RequiresGpuGroup) {
+  core::RefCountPtr<CollectiveParams> col_params = ParamsForRank(0);
+  core::RefCountPtr<HierarchicalReducer> reducer(new HierarchicalReducer());
+  EXPECT_EQ(reducer->InitializeCollectiveParams(col_params.get()).code(),
+            error::INTERNAL);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -40,6 +41,9 @@ ImmutableExecutorState::~ImmutableExecutorState() {
       params_.delete_kernel(item->kernel);
     }
   }
+  for (DeviceContext* device_context : device_context_map_) {
+    if (device_context != nullptr) device_context->Unref();
+  }
 }
 
 namespace {
@@ -97,9 +101,12 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   pending_ids_.resize(gview_.num_nodes());
 
   // Preprocess every node in the graph to create an instance of op
-  // kernel for each node.
+  // kernel for each node. The nodes are visited in the order of their
+  // `NodeItem`s, so that the inputs and pending counts of each frame are
+  // allocated in a topological order, close to those of their neighbours.
   requires_control_flow_ = false;
-  for (const Node* n : graph.nodes()) {
+  for (int32_t node_id : gview_.node_order()) {
+    const Node* n = graph.FindNodeId(node_id);
     if (IsSink(n)) continue;
     if (IsSwitch(n) || IsMerge(n) || IsEnter(n) || IsExit(n)) {
       requires_control_flow_ = true;
@@ -258,6 +265,8 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
+  TF_RETURN_IF_ERROR(
+      params_.device->FillContextMap(&graph, &device_context_map_));
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
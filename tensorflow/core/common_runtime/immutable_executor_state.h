@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_view.h"
 #include "tensorflow/core/common_runtime/local_executor_params.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
@@ -92,6 +93,14 @@ class ImmutableExecutorState {
   }
   const std::vector<const NodeItem*>& root_nodes() const { return root_nodes_; }
 
+  // Returns the device context that the device assigned to the node, or null
+  // if the node runs with the default context of the device.
+  DeviceContext* device_context(int node_id) const {
+    return node_id < static_cast<int>(device_context_map_.size())
+               ? device_context_map_[node_id]
+               : nullptr;
+  }
+
   const FrameInfo& get_root_frame_info() const { return *root_frame_info_; }
 
   const FrameInfo& get_enter_frame_info(const NodeItem& node_item) const {
@@ -155,6 +164,10 @@ class ImmutableExecutorState {
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
+  // The device contexts filled in by Device::FillContextMap, indexed by node
+  // ID. Owns one reference on each non-null context.
+  std::vector<DeviceContext*> device_context_map_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableExecutorState);
 };
 
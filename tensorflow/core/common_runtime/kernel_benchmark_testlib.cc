@@ -61,6 +61,7 @@ Benchmark::Benchmark(const string& device, Graph* g,
 
   CHECK(!old_benchmark_api) << "Expected new API only";
   old_benchmark_api_ = false;
+  perf_counters_ = profile_utils::PerfCounters::Create();
   string t = absl::AsciiStrToUpper(device);
   // Allow NewDevice to allocate a new threadpool with different number of
   // threads for each new benchmark.
@@ -190,6 +191,7 @@ void Benchmark::RunWithRendezvousArgs(
   TF_CHECK_OK(device_->Sync());
   VLOG(3) << kWarmupRuns << " warmup runs done.";
 
+  if (perf_counters_) perf_counters_->Start();
   // Benchmark loop. Timer starts automatically at the beginning of the loop
   // and ends automatically after the last iteration.
   for (auto s : state) {
@@ -206,6 +208,16 @@ void Benchmark::RunWithRendezvousArgs(
     }
   }
   TF_CHECK_OK(device_->Sync());
+  if (perf_counters_) {
+    const profile_utils::PerfCounters::Values values = perf_counters_->Stop();
+    state.counters["cycles"] = benchmark::Counter(
+        values.cycles, benchmark::Counter::kAvgIterations);
+    state.counters["instructions"] = benchmark::Counter(
+        values.instructions, benchmark::Counter::kAvgIterations);
+    state.counters["cache_misses"] = benchmark::Counter(
+        values.cache_misses, benchmark::Counter::kAvgIterations);
+    state.counters["ipc"] = values.Ipc();
+  }
 }
 
 }  // end namespace test
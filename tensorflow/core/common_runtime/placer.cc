@@ -16,8 +16,12 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/placer.h"
 
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
+
 #include "tensorflow/core/common_runtime/colocation_graph.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/attr_value_util.h"
@@ -26,9 +30,11 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/port.h"
 
 namespace tensorflow {
@@ -106,6 +112,43 @@ bool IsGeneratorNode(const Node* node) {
          !IsRefType(node->output_type(0));
 }
 
+// Returns true if the node computes nothing expensive, so that running it on
+// another device costs less than transferring its outputs.
+bool IsCheapToMove(const Node* node) {
+  return IsGeneratorNode(node) || node->IsIdentity();
+}
+
+// Returns the number of distinct tensors that cross devices at `node` if it
+// is placed on the device with name index `device`.
+int NumCrossDeviceTensors(const Node* node, int device) {
+  absl::flat_hash_set<std::pair<int, int>> inputs;
+  for (const Edge* edge : node->in_edges()) {
+    const Node* src = edge->src();
+    if (src->IsOp() && src->assigned_device_name_index() != device) {
+      inputs.insert({src->id(), edge->src_output()});
+    }
+  }
+  // The partitioner sends a tensor once per device it is used on.
+  absl::flat_hash_set<std::pair<int, int>> outputs;
+  for (const Edge* edge : node->out_edges()) {
+    const Node* dst = edge->dst();
+    if (dst->IsOp() && dst->assigned_device_name_index() != device) {
+      outputs.insert({edge->src_output(), dst->assigned_device_name_index()});
+    }
+  }
+  return inputs.size() + outputs.size();
+}
+
+bool ReduceCrossDeviceTensorsFromEnv() {
+  bool reduce_cross_device_tensors;
+  Status status = ReadBoolFromEnvVar("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS",
+                                     false, &reduce_cross_device_tensors);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  return reduce_cross_device_tensors;
+}
+
 void LogDeviceAssignment(const Node* node, bool log_device_placement) {
   // Log placement if log_device_placement is set.
   if (log_device_placement) {
@@ -145,7 +188,8 @@ Placer::Placer(Graph* graph, const string& function_name,
       devices_(devices),
       default_local_device_(default_local_device),
       allow_soft_placement_(allow_soft_placement),
-      log_device_placement_(log_device_placement) {}
+      log_device_placement_(log_device_placement),
+      reduce_cross_device_tensors_(ReduceCrossDeviceTensorsFromEnv()) {}
 
 Placer::Placer(Graph* graph, const string& function_name,
                const FunctionLibraryDefinition* flib_def,
@@ -182,6 +226,26 @@ Status Placer::Run() {
 
   TF_RETURN_IF_ERROR(colocation_graph.Initialize());
 
+  // The nodes that Heuristic C may move, with the devices they may run on.
+  std::unordered_map<const Node*, std::vector<Device*>> movable_nodes;
+  std::vector<int> group_sizes;
+  if (reduce_cross_device_tensors_) {
+    group_sizes.resize(graph_->num_node_ids());
+    for (const Node* node : graph_->op_nodes()) {
+      ++group_sizes[colocation_graph.FindAndUpdateRoot(node->id())];
+    }
+  }
+  // Nodes that are colocated with others, or that the user placed, stay
+  // where the constraints put them.
+  auto maybe_movable = [&](const Node* node,
+                           const std::vector<Device*>& devices) {
+    if (reduce_cross_device_tensors_ && IsCheapToMove(node) &&
+        node->requested_device().empty() && !node->op_def().is_stateful() &&
+        group_sizes[colocation_graph.FindAndUpdateRoot(node->id())] == 1) {
+      movable_nodes[node] = devices;
+    }
+  };
+
   // For each node, assign a device based on the constraints in the disjoint
   // node set.
   std::vector<Node*> second_pass;
@@ -249,6 +313,7 @@ Status Placer::Run() {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
     }
 
+    maybe_movable(node, *devices);
     TF_RETURN_IF_ERROR(AssignAndLog(assigned_device, node, &colocation_graph,
                                     log_device_placement_));
   }
@@ -289,10 +354,42 @@ Status Placer::Run() {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
     }
 
+    maybe_movable(node, *devices);
     TF_RETURN_IF_ERROR(AssignAndLog(assigned_device, node, &colocation_graph,
                                     log_device_placement_));
   }
 
+  // Heuristic C: move the cheap nodes to the device of one of their
+  // consumers, when that leaves fewer tensors crossing devices. The
+  // consumers are visited first, so that a chain of cheap nodes can follow
+  // its consumer.
+  if (!movable_nodes.empty()) {
+    std::vector<Node*> order;
+    GetPostOrder(*graph_, &order);
+    for (Node* node : order) {
+      auto it = movable_nodes.find(node);
+      if (it == movable_nodes.end()) continue;
+      int best_device = node->assigned_device_name_index();
+      int best_num_tensors = NumCrossDeviceTensors(node, best_device);
+      for (const Node* dst : node->out_nodes()) {
+        const int device = dst->assigned_device_name_index();
+        if (!dst->IsOp() || device == best_device ||
+            !CanAssignToDevice(dst->assigned_device_name(), it->second)) {
+          continue;
+        }
+        const int num_tensors = NumCrossDeviceTensors(node, device);
+        if (num_tensors < best_num_tensors) {
+          best_device = device;
+          best_num_tensors = num_tensors;
+        }
+      }
+      if (best_device != node->assigned_device_name_index()) {
+        node->set_assigned_device_name_index(best_device);
+        LogDeviceAssignment(node, log_device_placement_);
+      }
+    }
+  }
+
   if (VLOG_IS_ON(3)) {
     DumpGraphToFile("placer_output", *graph_, nullptr);
     DumpColocationGraph("colocation_graph", colocation_graph);
@@ -100,6 +100,10 @@ class Placer {
   const Device* default_local_device_;               // Not owned.
   const bool allow_soft_placement_;
   const bool log_device_placement_;
+  // If true, cheap nodes are moved next to their consumers when that reduces
+  // the number of tensors crossing devices. Set by the
+  // TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS environment variable.
+  const bool reduce_cross_device_tensors_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Placer);
 };
@@ -186,6 +186,8 @@ REGISTER_KERNEL_BUILDER(Name("TestDeviceEnforce").Device("FakeGPU"), DummyOp);
 
 REGISTER_KERNEL_BUILDER(Name("Shape").Device("FakeCPU"), DummyOp);
 REGISTER_KERNEL_BUILDER(Name("Shape").Device("FakeGPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("Identity").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("Identity").Device("FakeGPU"), DummyOp);
 
 // Op that has kernels with device priorities specified.
 REGISTER_OP("TestDatasetOp").Input("a: float").Output("b: float");
@@ -774,6 +776,57 @@ TEST_F(PlacerTest, TestHeuristicGeneratorFollowsSingleConsumer) {
   EXPECT_COLOCATED(g, "assign", "in");
 }
 
+// Heuristic C moves cheap nodes next to their consumers, if that leaves fewer
+// tensors crossing devices.
+TEST_F(PlacerTest, TestHeuristicCheapNodeFollowsConsumers) {
+  for (bool reduce_cross_device_tensors : {false, true}) {
+    Graph g(OpRegistry::Global());
+    {  // Scope for temporary variables used to construct g.
+      GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+      Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+      // The identity prefers the GPU, but both its input and its consumer
+      // are on CPU.
+      Node* identity = ops::UnaryOp("Identity", ops::NodeOut(input, 0),
+                                    b.opts().WithName("id"));
+      ops::UnaryOp("ReluCPU", identity, b.opts().WithName("relu"));
+      TF_EXPECT_OK(BuildGraph(b, &g));
+    }
+
+    if (reduce_cross_device_tensors) {
+      setenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS", "true", 1);
+    }
+    Status status = Place(&g);
+    unsetenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS");
+    TF_EXPECT_OK(status);
+    if (reduce_cross_device_tensors) {
+      EXPECT_DEVICE_TYPE(g, "id", "FakeCPU");
+      EXPECT_COLOCATED(g, "id", "relu");
+    } else {
+      EXPECT_DEVICE_TYPE(g, "id", "FakeGPU");
+    }
+  }
+}
+
+// Nodes that the user placed are not moved.
+TEST_F(PlacerTest, TestHeuristicCheapNodeKeepsRequestedDevice) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    Node* identity = ops::UnaryOp(
+        "Identity", ops::NodeOut(input, 0),
+        b.opts().WithName("id").WithDevice("/job:a/device:FakeGPU:0"));
+    ops::UnaryOp("ReluCPU", identity, b.opts().WithName("relu"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  setenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS", "true", 1);
+  Status status = Place(&g);
+  unsetenv("TF_PLACER_REDUCE_CROSS_DEVICE_TENSORS");
+  TF_EXPECT_OK(status);
+  EXPECT_DEVICE_TYPE(g, "id", "FakeGPU");
+}
+
 TEST_F(PlacerTest, TestUncopiableTypeEdges) {
   Graph g(OpRegistry::Global());
 
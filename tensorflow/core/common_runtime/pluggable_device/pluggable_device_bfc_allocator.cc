@@ -75,12 +75,12 @@ bool PluggableDeviceBFCAllocator::GetGarbageCollectionValue() {
 }
 
 PluggableDeviceBFCAllocator::PluggableDeviceBFCAllocator(
-    DeviceMemAllocator* sub_allocator, size_t total_memory, const string& name)
+    SubAllocator* sub_allocator, size_t total_memory, const string& name)
     : PluggableDeviceBFCAllocator(sub_allocator, total_memory, GPUOptions(),
                                   name) {}
 
 PluggableDeviceBFCAllocator::PluggableDeviceBFCAllocator(
-    DeviceMemAllocator* sub_allocator, size_t total_memory,
+    SubAllocator* sub_allocator, size_t total_memory,
     const GPUOptions& gpu_options, const string& name)
     : BFCAllocator(
           sub_allocator, total_memory,
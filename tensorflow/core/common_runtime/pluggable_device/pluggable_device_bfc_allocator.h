@@ -33,9 +33,9 @@ namespace tensorflow {
 // coalescing' algorithm
 class PluggableDeviceBFCAllocator : public BFCAllocator {
  public:
-  PluggableDeviceBFCAllocator(DeviceMemAllocator* sub_allocator,
+  PluggableDeviceBFCAllocator(SubAllocator* sub_allocator,
                               size_t total_memory, const string& name);
-  PluggableDeviceBFCAllocator(DeviceMemAllocator* sub_allocator,
+  PluggableDeviceBFCAllocator(SubAllocator* sub_allocator,
                               size_t total_memory,
                               const GPUOptions& gpu_options,
                               const string& name);
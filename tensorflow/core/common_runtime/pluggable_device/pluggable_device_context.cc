@@ -52,7 +52,7 @@ Status PluggableDeviceContext::ThenExecute(Device* device, se::Stream* stream,
                                            std::function<void()> func) {
   const DeviceBase::GpuDeviceInfo* device_info =
       device->tensorflow_gpu_device_info();
-  device_info->event_mgr->ThenExecute(stream, func);
+  PluggableDeviceUtil::ThenExecute(device_info, stream, std::move(func));
   return Status::OK();
 }
 
@@ -42,6 +42,50 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Allocates the regions of a BFC allocator with the `allocate_region` and
+// `deallocate_region` callbacks of the plugin, which may hand out larger
+// regions than requested.
+class PluggableDeviceRegionAllocator : public SubAllocator {
+ public:
+  PluggableDeviceRegionAllocator(se::StreamExecutor* stream_exec,
+                                 PlatformDeviceId device_id,
+                                 const std::vector<Visitor>& alloc_visitors)
+      : SubAllocator(alloc_visitors, {}),
+        stream_exec_(stream_exec),
+        device_id_(device_id) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    *bytes_received = 0;
+    if (num_bytes == 0) return nullptr;
+    uint64 region_bytes = 0;
+    se::DeviceMemoryBase region = se::AllocateRegion(
+        stream_exec_, alignment, num_bytes, &region_bytes);
+    if (region.is_null()) return nullptr;
+    DCHECK_GE(region_bytes, num_bytes);
+    *bytes_received = region_bytes;
+    VisitAlloc(region.opaque(), device_id_.value(), region_bytes);
+    return region.opaque();
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    if (ptr == nullptr) return;
+    VisitFree(ptr, device_id_.value(), num_bytes);
+    se::DeviceMemoryBase region(ptr, num_bytes);
+    se::DeallocateRegion(stream_exec_, &region);
+  }
+
+  bool SupportsCoalescing() const override { return false; }
+
+ private:
+  se::StreamExecutor* stream_exec_;  // not owned, non-null
+  const PlatformDeviceId device_id_;
+};
+
+}  // namespace
+
 /*static*/ PluggableDeviceProcessState* PluggableDeviceProcessState::singleton(
     const string& device_type, const string& platform_name) {
   using ProcessStateMap =
@@ -110,12 +154,11 @@ Allocator* PluggableDeviceProcessState::GetPluggableDeviceAllocator(
 
     bool use_unified_memory = options.per_process_gpu_memory_fraction() > 1.0 ||
                               options.experimental().use_unified_memory();
-    DeviceMemAllocator* sub_allocator = new DeviceMemAllocator(
+    se::StreamExecutor* stream_exec =
         DeviceIdUtil::ExecutorForPlatformDeviceId(platform, platform_device_id)
-            .ValueOrDie(),
-        platform_device_id, use_unified_memory,
-        pluggable_device_visitors_[bus_id], {});
+            .ValueOrDie();
 
+    SubAllocator* sub_allocator = nullptr;
     Allocator* device_allocator = nullptr;
     auto cplatform = dynamic_cast<se::CPlatform*>(platform);
     if (cplatform == nullptr) {
@@ -123,11 +166,25 @@ Allocator* PluggableDeviceProcessState::GetPluggableDeviceAllocator(
                  << "stream_executor::CPlatform";
     }
     if (cplatform->UseBfcAllocator()) {
+      if (!use_unified_memory && se::PluginAllocatesRegions(stream_exec)) {
+        sub_allocator = new PluggableDeviceRegionAllocator(
+            stream_exec, platform_device_id,
+            pluggable_device_visitors_[bus_id]);
+      } else {
+        sub_allocator = new DeviceMemAllocator(
+            stream_exec, platform_device_id, use_unified_memory,
+            pluggable_device_visitors_[bus_id], {});
+      }
       device_allocator = new PluggableDeviceBFCAllocator(
           sub_allocator, total_bytes, options,
           strings::StrCat("PluggableDevice_", tf_device_id.value(), "_bfc"));
     } else {
-      device_allocator = new PluggableDeviceSimpleAllocator(sub_allocator);
+      DeviceMemAllocator* device_mem_allocator = new DeviceMemAllocator(
+          stream_exec, platform_device_id, use_unified_memory,
+          pluggable_device_visitors_[bus_id], {});
+      sub_allocator = device_mem_allocator;
+      device_allocator =
+          new PluggableDeviceSimpleAllocator(device_mem_allocator);
     }
 
     allocator_parts = {std::unique_ptr<Allocator>(device_allocator),
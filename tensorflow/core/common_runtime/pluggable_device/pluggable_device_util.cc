@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/pluggable_device/pluggable_device_util.h"
 
+#include "tensorflow/c/experimental/stream_executor/stream_executor_internal.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
@@ -156,8 +157,8 @@ void PluggableDeviceUtil::DeviceToDeviceCopy(
   }
   // Use of input may outlive stack scope, so keep a ref.
   TensorReference input_ref(*input);
-  dev_info->event_mgr->ThenExecute(
-      send_device_to_device_stream,
+  PluggableDeviceUtil::ThenExecute(
+      dev_info, send_device_to_device_stream,
       [done, send_device_to_device_stream, input_ref]() {
         input_ref.Unref();
         if (!send_device_to_device_stream->ok()) {
@@ -206,8 +207,8 @@ void PluggableDeviceUtil::CopyPluggableDeviceTensorToCPU(
 
   // Use of the input may outlive stack scope, so keep a ref.
   TensorReference input_ref(*device_tensor);
-  dev_info->event_mgr->ThenExecute(
-      send_device_to_host_stream,
+  PluggableDeviceUtil::ThenExecute(
+      dev_info, send_device_to_host_stream,
       [send_device_to_host_stream, done, input_ref]() {
         if (!send_device_to_host_stream->ok()) {
           LOG(FATAL) << "PluggableDevice->CPU Memcpy failed.";  // Crash OK
@@ -255,8 +256,8 @@ void PluggableDeviceUtil::CopyCPUTensorToPluggableDevice(
   }
   // Use of cpu_tensor may outlive stack scope, so keep a ref.
   TensorReference input_ref(*cpu_tensor);
-  dev_info->event_mgr->ThenExecute(
-      recv_host_to_device_stream,
+  PluggableDeviceUtil::ThenExecute(
+      dev_info, recv_host_to_device_stream,
       [recv_host_to_device_stream, done, input_ref]() {
         input_ref.Unref();
         if (!recv_host_to_device_stream->ok()) {
@@ -266,6 +267,19 @@ void PluggableDeviceUtil::CopyCPUTensorToPluggableDevice(
       });
 }
 
+// static
+void PluggableDeviceUtil::ThenExecute(const DeviceBase::GpuDeviceInfo* dev_info,
+                                      se::Stream* stream,
+                                      std::function<void()> func) {
+  auto* cplatform =
+      dynamic_cast<const se::CPlatform*>(stream->parent()->platform());
+  if (cplatform != nullptr && cplatform->UseHostCallbackForCompletion()) {
+    stream->ThenDoHostCallback(std::move(func));
+    return;
+  }
+  dev_info->event_mgr->ThenExecute(stream, std::move(func));
+}
+
 Status PluggableDeviceUtil::Sync(Device* device) {
   VLOG(1) << "PluggableDeviceUtil::Sync";
   auto* dev_info = device->tensorflow_gpu_device_info();
@@ -65,6 +65,13 @@ class PluggableDeviceUtil {
       Device* device, const DeviceContext* device_context,
       const Tensor* src_device_tensor, Tensor* dst_device_tensor,
       StatusCallback done);
+
+  // Runs `func` once the work enqueued on `stream` so far has completed, with
+  // the host callbacks of the plugin if its platform sets
+  // `use_host_callback_for_completion`, and with the EventMgr of the device
+  // `dev_info` describes otherwise.
+  static void ThenExecute(const DeviceBase::GpuDeviceInfo* dev_info,
+                          se::Stream* stream, std::function<void()> func);
 };
 
 }  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <sys/mman.h>  // for munmap
 #endif
 
+#include <algorithm>
 #include <map>
 #include <utility>
 
@@ -35,10 +36,12 @@ namespace tensorflow {
 
 PoolAllocator::PoolAllocator(size_t pool_size_limit, bool auto_resize,
                              SubAllocator* allocator,
-                             RoundUpInterface* size_rounder, string name)
+                             RoundUpInterface* size_rounder, string name,
+                             size_t memory_limit)
     : name_(std::move(name)),
       has_size_limit_(pool_size_limit > 0),
       auto_resize_(auto_resize),
+      memory_limit_(memory_limit),
       pool_size_limit_(pool_size_limit),
       allocator_(allocator),
       size_rounder_(size_rounder) {
@@ -46,6 +49,8 @@ PoolAllocator::PoolAllocator(size_t pool_size_limit, bool auto_resize,
     CHECK_LT(size_t{0}, pool_size_limit)
         << "size limit must be > 0 if auto_resize is true.";
   }
+  stats_.pool_bytes = 0;
+  stats_.peak_pool_bytes = 0;
 }
 
 PoolAllocator::~PoolAllocator() { Clear(); }
@@ -104,9 +109,9 @@ void* PoolAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   num_bytes += sizeof(ChunkPrefix);
   num_bytes = size_rounder_->RoundUp(num_bytes);
   PtrRecord* pr = nullptr;
-  if (has_size_limit_) {
-    {
-      mutex_lock lock(mutex_);
+  {
+    mutex_lock lock(mutex_);
+    if (has_size_limit_) {
       auto iter = pool_.find(num_bytes);
       if (iter == pool_.end()) {
         allocated_count_++;
@@ -118,9 +123,35 @@ void* PoolAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
         pr = iter->second;
         RemoveFromList(pr);
         pool_.erase(iter);
+        pooled_bytes_ -= pr->num_bytes;
         // Fall out of lock scope and do the result without the lock held.
       }
     }
+    if (pr == nullptr) {
+      if (memory_limit_ > 0) {
+        while (lru_tail_ != nullptr &&
+               stats_.bytes_in_use + pooled_bytes_ + num_bytes >
+                   memory_limit_) {
+          EvictOne();
+        }
+        if (stats_.bytes_in_use + pooled_bytes_ + num_bytes > memory_limit_) {
+          LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+                       << num_bytes << " bytes with " << stats_.bytes_in_use
+                       << " bytes in use and a limit of " << memory_limit_
+                       << " bytes.";
+          return nullptr;
+        }
+      }
+      // Reserves the bytes, so that concurrent allocations respect the
+      // limit.
+      AddPoolBytes(num_bytes);
+    }
+    ++stats_.num_allocs;
+    stats_.bytes_in_use += num_bytes;
+    stats_.peak_bytes_in_use =
+        std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+    stats_.largest_alloc_size =
+        std::max<int64_t>(stats_.largest_alloc_size, num_bytes);
   }
   if (pr != nullptr) {
     void* r = pr->ptr;
@@ -129,6 +160,13 @@ void* PoolAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   } else {
     size_t bytes_received;
     void* ptr = allocator_->Alloc(kPoolAlignment, num_bytes, &bytes_received);
+    if (ptr == nullptr || bytes_received != num_bytes) {
+      mutex_lock lock(mutex_);
+      const size_t accounted_bytes = ptr == nullptr ? 0 : bytes_received;
+      AddPoolBytes(static_cast<int64_t>(accounted_bytes) - num_bytes);
+      stats_.bytes_in_use += accounted_bytes - num_bytes;
+      if (ptr == nullptr) return nullptr;
+    }
     return PrepareChunk(ptr, alignment, bytes_received);
   }
 }
@@ -137,10 +175,12 @@ void PoolAllocator::DeallocateRaw(void* ptr) {
   if (ptr == nullptr) return;
   ChunkPrefix* cp = FindPrefix(ptr);
   CHECK_LE((void*)cp, (void*)ptr);
+  mutex_lock lock(mutex_);
+  stats_.bytes_in_use -= cp->num_bytes;
   if (!has_size_limit_ && !auto_resize_) {
+    AddPoolBytes(-static_cast<int64_t>(cp->num_bytes));
     allocator_->Free(cp, cp->num_bytes);
   } else {
-    mutex_lock lock(mutex_);
     ++put_count_;
     while (pool_.size() >= pool_size_limit_) {
       EvictOne();
@@ -150,18 +190,43 @@ void PoolAllocator::DeallocateRaw(void* ptr) {
     pr->ptr = cp;
     AddToList(pr);
     pool_.insert(std::make_pair(cp->num_bytes, pr));
+    pooled_bytes_ += cp->num_bytes;
   }
 }
 
+absl::optional<AllocatorStats> PoolAllocator::GetStats() {
+  mutex_lock lock(mutex_);
+  AllocatorStats stats = stats_;
+  if (memory_limit_ > 0) stats.bytes_limit = memory_limit_;
+  return stats;
+}
+
+bool PoolAllocator::ClearStats() {
+  mutex_lock lock(mutex_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+  stats_.peak_pool_bytes = stats_.pool_bytes;
+  return true;
+}
+
+void PoolAllocator::AddPoolBytes(int64_t num_bytes) {
+  stats_.pool_bytes = *stats_.pool_bytes + num_bytes;
+  stats_.peak_pool_bytes =
+      std::max(*stats_.peak_pool_bytes, *stats_.pool_bytes);
+}
+
 void PoolAllocator::Clear() {
   if (has_size_limit_) {
     mutex_lock lock(mutex_);
     for (auto iter : pool_) {
       PtrRecord* pr = iter.second;
       allocator_->Free(pr->ptr, pr->num_bytes);
+      AddPoolBytes(-static_cast<int64_t>(pr->num_bytes));
       delete pr;
     }
     pool_.clear();
+    pooled_bytes_ = 0;
     get_from_pool_count_ = 0;
     put_count_ = 0;
     allocated_count_ = 0;
@@ -213,6 +278,8 @@ void PoolAllocator::EvictOne() {
   }
   pool_.erase(iter);
   allocator_->Free(prec->ptr, prec->num_bytes);
+  pooled_bytes_ -= prec->num_bytes;
+  AddPoolBytes(-static_cast<int64_t>(prec->num_bytes));
   delete prec;
   ++evicted_count_;
   // Auto-resizing, and warning messages.
@@ -53,9 +53,13 @@ class PoolAllocator : public Allocator {
   // but will never lower it.
   // "allocator" is the object that performs the underlying memory
   // malloc/free operations.  This object takes ownership of allocator.
+  // If "memory_limit" is non-zero, it caps the bytes obtained from
+  // allocator, both in use and in the pool: the least recently used
+  // buffers of the pool are evicted to make room for new ones, and
+  // allocations that still don't fit fail.
   PoolAllocator(size_t pool_size_limit, bool auto_resize,
                 SubAllocator* allocator, RoundUpInterface* size_rounder,
-                string name);
+                string name, size_t memory_limit = 0);
   ~PoolAllocator() override;
 
   string Name() override { return name_; }
@@ -64,6 +68,12 @@ class PoolAllocator : public Allocator {
 
   void DeallocateRaw(void* ptr) override;
 
+  // The sizes are those of the buffers obtained from the SubAllocator, and
+  // pool_bytes also counts the buffers in the pool.
+  absl::optional<AllocatorStats> GetStats() override;
+
+  bool ClearStats() override;
+
   // Allocate an unused memory region of size "num_bytes".  Fetch from
   // the pool if available, otherwise call allocator_.
   void* Get(size_t num_bytes);
@@ -117,9 +127,13 @@ class PoolAllocator : public Allocator {
   // Delete the least recently used record.
   void EvictOne() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Accounts for "num_bytes" more bytes obtained from the SubAllocator.
+  void AddPoolBytes(int64_t num_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   const string name_;
   const bool has_size_limit_;
   const bool auto_resize_;
+  const size_t memory_limit_;
   size_t pool_size_limit_;
   std::unique_ptr<SubAllocator> allocator_;
   std::unique_ptr<RoundUpInterface> size_rounder_;
@@ -131,6 +145,9 @@ class PoolAllocator : public Allocator {
   int64_t put_count_ TF_GUARDED_BY(mutex_) = 0;
   int64_t allocated_count_ TF_GUARDED_BY(mutex_) = 0;
   int64_t evicted_count_ TF_GUARDED_BY(mutex_) = 0;
+  // The bytes of the buffers in pool_.
+  size_t pooled_bytes_ TF_GUARDED_BY(mutex_) = 0;
+  AllocatorStats stats_ TF_GUARDED_BY(mutex_);
 };
 
 // Do-nothing rounder. Passes through sizes unchanged.
@@ -147,6 +164,19 @@ class Pow2Rounder : public RoundUpInterface {
   }
 };
 
+// Size class rounder: rounds up to one of the four sizes evenly spaced
+// between consecutive powers of 2, so that buffers of similar sizes can be
+// reused for one another while wasting at most a quarter of their size,
+// unlike the half of the Pow2Rounder.
+class SizeClassRounder : public RoundUpInterface {
+ public:
+  size_t RoundUp(size_t num_bytes) override {
+    if (num_bytes <= 8) return num_bytes;
+    const size_t step = size_t{1} << (Log2Ceiling64(num_bytes) - 3);
+    return (num_bytes + step - 1) / step * step;
+  }
+};
+
 class BasicCPUAllocator : public SubAllocator {
  public:
   BasicCPUAllocator(int numa_node, const std::vector<Visitor>& alloc_visitors,
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 
+#include <algorithm>
 #include <iterator>
 #include <utility>
 
@@ -47,9 +48,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/reffed_status_callback.h"
 #if !defined(IS_MOBILE_PLATFORM)
@@ -82,6 +86,19 @@ void ProcessFunctionLibraryRuntime::FunctionData::DistributedInit(
                       });
 }
 
+namespace {
+
+// Returns true if optimized and partitioned multi-device functions should be
+// shared by all ProcessFunctionLibraryRuntimes in the process.
+bool ShareMultiDeviceFunctions() {
+  bool share = false;
+  TF_CHECK_OK(
+      ReadBoolFromEnvVar("TF_SHARE_MULTI_DEVICE_FUNCTIONS", false, &share));
+  return share;
+}
+
+}  // namespace
+
 ProcessFunctionLibraryRuntime::ProcessFunctionLibraryRuntime(
     const DeviceMgr* device_mgr, Env* env, const ConfigProto* config,
     int graph_def_version, const FunctionLibraryDefinition* lib_def,
@@ -102,7 +119,8 @@ ProcessFunctionLibraryRuntime::ProcessFunctionLibraryRuntime(
       session_metadata_(session_metadata),
       rendezvous_factory_(std::move(rendezvous_factory)),
       optimizer_options_(optimizer_options),
-      graph_def_version_(graph_def_version) {
+      graph_def_version_(graph_def_version),
+      share_multi_device_functions_(ShareMultiDeviceFunctions()) {
   if (device_mgr == nullptr) {
     (*flr_map_)[nullptr] = NewFunctionLibraryRuntime(
         nullptr, env, config_ ? &(*config_) : nullptr, nullptr,
@@ -650,6 +668,44 @@ Status ValidateMultiDeviceOptions(
   return Status::OK();
 }
 
+// Returns the key of a multi-device function in the process-level cache. Unlike
+// the function key of a runtime, it covers the definitions of the function and
+// of the functions it calls instead of the address of their library, the
+// devices the function is placed on and the session metadata of the runtime.
+string SharedMultiDeviceFunctionKey(
+    const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    const GraphDef& graph_def, const DeviceSet& dev_set,
+    const SessionMetadata* session_metadata) {
+  FunctionLibraryRuntime::InstantiateOptions key_options = options;
+  key_options.lib_def = nullptr;
+  key_options.state_handle.clear();
+  string serialized_graph;
+  SerializeToStringDeterministic(graph_def, &serialized_graph);
+  std::vector<string> device_names;
+  for (const Device* device : dev_set.devices()) {
+    device_names.push_back(device->name());
+  }
+  std::sort(device_names.begin(), device_names.end());
+  std::vector<string> composite_device_names;
+  for (const auto& it : options.composite_devices) {
+    composite_device_names.push_back(it.first);
+  }
+  std::sort(composite_device_names.begin(), composite_device_names.end());
+  return absl::StrCat(
+      Canonicalize(function_name, attrs, key_options),
+      "|graph=", Fingerprint64(serialized_graph),
+      "|devices=", absl::StrJoin(device_names, ","),
+      "|composite_devices=", absl::StrJoin(composite_device_names, ","),
+      "|component=", options.is_component_function,
+      "|default_device_to_target=", options.default_device_to_target,
+      "|session_metadata=",
+      session_metadata == nullptr
+          ? "none"
+          : absl::StrCat(session_metadata->name(), ":",
+                         session_metadata->version()));
+}
+
 }  // anonymous namespace
 
 Status GetGraphAndArgRets(
@@ -688,6 +744,40 @@ Status GetGraphAndArgRets(
   return Status::OK();
 }
 
+class ProcessFunctionLibraryRuntime::SharedMultiDeviceFunctionCache {
+ public:
+  std::shared_ptr<const SharedMultiDeviceFunction> Find(const string& key) {
+    tf_shared_lock l(mu_);
+    auto it = functions_.find(key);
+    return it != functions_.end() ? it->second : nullptr;
+  }
+
+  void Add(const string& key,
+           std::shared_ptr<const SharedMultiDeviceFunction> function) {
+    mutex_lock l(mu_);
+    if (functions_.size() >= kMaxSize) {
+      VLOG(1) << "Not sharing multi-device function, the cache is full";
+      return;
+    }
+    functions_.emplace(key, std::move(function));
+  }
+
+ private:
+  // There is no eviction, so this bounds the memory held by the cache.
+  static constexpr int kMaxSize = 1024;
+
+  mutex mu_;
+  std::unordered_map<string, std::shared_ptr<const SharedMultiDeviceFunction>>
+      functions_ TF_GUARDED_BY(mu_);
+};
+
+/* static */
+ProcessFunctionLibraryRuntime::SharedMultiDeviceFunctionCache*
+ProcessFunctionLibraryRuntime::GetSharedMultiDeviceFunctionCache() {
+  static auto* cache = new SharedMultiDeviceFunctionCache;
+  return cache;
+}
+
 Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     const string& function_name, AttrSlice attrs,
     const FunctionLibraryRuntime::InstantiateOptions& options,
@@ -765,6 +855,42 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   }
   const std::shared_ptr<DeviceSet> dev_set = device_set();
 
+  // The graph collector expects to see the graphs of every instantiation, so
+  // functions that collect graphs are not shared. Neither are functions with an
+  // optimize_graph_fn, since there is no way to tell whether two of them
+  // rewrite the graph in the same way.
+  string shared_function_key;
+  if (share_multi_device_functions_ && options.graph_collector == nullptr &&
+      !options.optimize_graph_fn) {
+    shared_function_key =
+        SharedMultiDeviceFunctionKey(function_name, attrs, options, graph_def,
+                                     *dev_set, session_metadata_);
+    std::shared_ptr<const SharedMultiDeviceFunction> shared =
+        GetSharedMultiDeviceFunctionCache()->Find(shared_function_key);
+    if (shared != nullptr) {
+      VLOG(1) << "Instantiating MultiDevice function \"" << function_name
+              << "\" from a shared instantiation";
+      auto data = absl::make_unique<MultiDeviceFunctionData>(
+          function_name, function_key, shared->num_outputs,
+          FunctionLibraryDefinition(lib_def->default_registry(),
+                                    shared->library),
+          shared->ret_types);
+      std::vector<ComponentFunctionSource> components;
+      components.reserve(shared->components.size());
+      for (const auto& pair : shared->components) {
+        ComponentFunctionSource component;
+        component.target = pair.first;
+        component.shared = &pair.second;
+        components.push_back(std::move(component));
+      }
+      TF_RETURN_IF_ERROR(InstantiateComponentFunctions(
+          function_name, options, dev_set, /*node_name_to_control_ret=*/{},
+          components, data.get(), /*shared=*/nullptr));
+      *handle = AddMultiDeviceHandle(std::move(data), function_key);
+      return Status::OK();
+    }
+  }
+
   TF_RETURN_IF_ERROR(
       SetArgShape(options.input_resource_dtypes_and_shapes, arg_nodes));
   TF_RETURN_IF_ERROR(PinArgsAndRets(
@@ -935,6 +1061,42 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     }
   }
 
+  std::vector<ComponentFunctionSource> components;
+  components.reserve(subgraphs.size());
+  for (const auto& pair : subgraphs) {
+    ComponentFunctionSource component;
+    component.target = pair.first;
+    component.subgraph = pair.second.get();
+    components.push_back(std::move(component));
+  }
+  std::unique_ptr<SharedMultiDeviceFunction> shared;
+  if (!shared_function_key.empty()) {
+    shared = absl::make_unique<SharedMultiDeviceFunction>();
+    data->lib_def_.ToProto().Swap(&shared->library);
+    shared->num_outputs = data->num_outputs_;
+    shared->ret_types = data->ret_types_;
+  }
+  TF_RETURN_IF_ERROR(InstantiateComponentFunctions(
+      function_name, options, dev_set, node_name_to_control_ret, components,
+      data.get(), shared.get()));
+  if (shared != nullptr) {
+    GetSharedMultiDeviceFunctionCache()->Add(shared_function_key,
+                                             std::move(shared));
+  }
+
+  *handle = AddMultiDeviceHandle(std::move(data), function_key);
+  VLOG(2) << "Instantiated MultiDevice function \"" << function_name
+          << "\" with handle " << *handle;
+  return Status::OK();
+}
+
+Status ProcessFunctionLibraryRuntime::InstantiateComponentFunctions(
+    const string& function_name,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    const std::shared_ptr<DeviceSet>& dev_set,
+    const std::unordered_map<string, string>& node_name_to_control_ret,
+    const std::vector<ComponentFunctionSource>& components,
+    MultiDeviceFunctionData* data, SharedMultiDeviceFunction* shared) {
   // We must preserve control returns in each of the function components,
   // otherwise after function inlining we might prune side-effectful nodes.
   const auto control_ret =
@@ -945,13 +1107,21 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
                : absl::nullopt;
   };
 
+  if (shared != nullptr) {
+    // Insert the entries up front, so that they can be filled in
+    // concurrently below.
+    for (const ComponentFunctionSource& component : components) {
+      shared->components[component.target];
+    }
+  }
+
   int i = 0;
   // Generate a random function_name to avoid one function reuse the partition
   // function instantiated by another function.
   FunctionLibraryDefinition* data_lib_def = &data->lib_def_;
   FunctionNameGenerator name_generator(
       data_lib_def, absl::StrCat(function_name, "_", random::New64()));
-  auto subgraph_size = subgraphs.size();
+  auto subgraph_size = components.size();
   gtl::InlinedVector<Status, 4> instantiate_status(subgraph_size);
   BlockingCounter counter(static_cast<int>(subgraph_size));
   auto runner = [this, subgraph_size](std::function<void()> fn) {
@@ -964,32 +1134,45 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
       fn();
     }
   };
-  for (const auto& pair : subgraphs) {
+  for (const ComponentFunctionSource& component : components) {
     Status* status = &instantiate_status[i];
     string unique_name = name_generator.GetName();
-    ComponentFunctionData* comp_data = &data->glue_[pair.first];
-    runner([this, &pair, dev_set, comp_data, unique_name, data_lib_def,
-            &control_ret, &options, status, &counter, &data] {
-      const string& target = pair.first;
-
-      const string& device_type =
-          dev_set->FindDeviceByName(target)->device_type();
-      Graph* subgraph = pair.second.get();
-
-      status->Update(UpdateArgAndRetvalMetadata(
-          subgraph, device_type, &comp_data->arg_indices,
-          &comp_data->ret_indices, &comp_data->arg_alloc_attrs,
-          &comp_data->ret_alloc_attrs));
-      if (!status->ok()) {
-        counter.DecrementCount();
-        return;
-      }
+    ComponentFunctionData* comp_data = &data->glue_[component.target];
+    auto* shared_component =
+        shared != nullptr ? &shared->components[component.target] : nullptr;
+    runner([this, &component, dev_set, comp_data, shared_component,
+            unique_name, data_lib_def, &control_ret, &options, status,
+            &counter, data] {
+      const string& target = component.target;
+
       FunctionDef shard;
-      status->Update(
-          GraphToFunctionDef(*subgraph, unique_name, control_ret, &shard));
-      if (!status->ok()) {
-        counter.DecrementCount();
-        return;
+      if (component.shared != nullptr) {
+        *comp_data = component.shared->second;
+        shard = component.shared->first;
+        shard.mutable_signature()->set_name(unique_name);
+      } else {
+        const string& device_type =
+            dev_set->FindDeviceByName(target)->device_type();
+        Graph* subgraph = component.subgraph;
+
+        status->Update(UpdateArgAndRetvalMetadata(
+            subgraph, device_type, &comp_data->arg_indices,
+            &comp_data->ret_indices, &comp_data->arg_alloc_attrs,
+            &comp_data->ret_alloc_attrs));
+        if (!status->ok()) {
+          counter.DecrementCount();
+          return;
+        }
+        status->Update(
+            GraphToFunctionDef(*subgraph, unique_name, control_ret, &shard));
+        if (!status->ok()) {
+          counter.DecrementCount();
+          return;
+        }
+        if (shared_component != nullptr) {
+          shared_component->first = shard;
+          shared_component->second = *comp_data;
+        }
       }
       status->Update(data_lib_def->AddFunctionDef(shard));
       if (!status->ok()) {
@@ -1009,7 +1192,7 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
 
       auto* component_handle = new FunctionLibraryRuntime::Handle;
       auto done = [this, status, unique_name, comp_data, component_handle,
-                   &data, &counter](const Status& s) {
+                   data, &counter](const Status& s) {
         status->Update(s);
 
         VLOG(1) << "Finished instantiating component function " << unique_name
@@ -1047,9 +1230,6 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   }
   TF_RETURN_IF_ERROR(group.as_summary_status());
 
-  *handle = AddMultiDeviceHandle(std::move(data), function_key);
-  VLOG(2) << "Instantiated MultiDevice function \"" << function_name
-          << "\" with handle " << *handle;
   return Status::OK();
 }
 
@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_FUNCTION_LIBRARY_RUNTIME_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_FUNCTION_LIBRARY_RUNTIME_H_
 
+#include <memory>
 #include <unordered_map>
+#include <utility>
 
 // clang-format off
 // Required for IS_MOBILE_PLATFORM
@@ -379,6 +381,44 @@ class ProcessFunctionLibraryRuntime {
       const FunctionLibraryRuntime::InstantiateOptions& options,
       FunctionLibraryRuntime::Handle* handle);
 
+  // A multi-device function after optimization and partitioning. If
+  // TF_SHARE_MULTI_DEVICE_FUNCTIONS is set, these are kept in a process-level
+  // cache, so that runtimes with the same session metadata that instantiate the
+  // same function with the same options on the same devices only have to
+  // instantiate its components.
+  struct SharedMultiDeviceFunction {
+    FunctionDefLibrary library;
+    int num_outputs;
+    DataTypeVector ret_types;
+    // Maps the device name to the component function for this device and its
+    // data. The component function keeps the name it was first instantiated
+    // with.
+    std::unordered_map<string, std::pair<FunctionDef, ComponentFunctionData>>
+        components;
+  };
+
+  class SharedMultiDeviceFunctionCache;
+  static SharedMultiDeviceFunctionCache* GetSharedMultiDeviceFunctionCache();
+
+  // A component function to instantiate, either from its optimized subgraph
+  // or from a SharedMultiDeviceFunction.
+  struct ComponentFunctionSource {
+    string target;
+    Graph* subgraph = nullptr;
+    const std::pair<FunctionDef, ComponentFunctionData>* shared = nullptr;
+  };
+
+  // Adds the component functions of a multi-device function to the library
+  // of `data` and instantiates them. If `shared` is not null, the components
+  // built from subgraphs are recorded in it.
+  Status InstantiateComponentFunctions(
+      const string& function_name,
+      const FunctionLibraryRuntime::InstantiateOptions& options,
+      const std::shared_ptr<DeviceSet>& dev_set,
+      const std::unordered_map<string, string>& node_name_to_control_ret,
+      const std::vector<ComponentFunctionSource>& components,
+      MultiDeviceFunctionData* data, SharedMultiDeviceFunction* shared);
+
   void InstantiateRemote(
       const string& function_name, AttrSlice attrs,
       const FunctionLibraryRuntime::InstantiateOptions& options,
@@ -483,6 +523,8 @@ class ProcessFunctionLibraryRuntime {
 
   const OptimizerOptions optimizer_options_;
   const int graph_def_version_;
+  // Set from TF_SHARE_MULTI_DEVICE_FUNCTIONS when the runtime is created.
+  const bool share_multi_device_functions_;
 };
 
 }  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
+#include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function_testlib.h"
@@ -135,9 +136,15 @@ class ProcessFunctionLibraryRuntimeTest : public ::testing::Test {
     FunctionDefLibrary proto;
     for (const auto& fdef : flib) *(proto.add_function()) = fdef;
     lib_def_.reset(new FunctionLibraryDefinition(OpRegistry::Global(), proto));
-    OptimizerOptions opts;
     cluster_flr_.reset(new TestClusterFLR(device_mgr_.get()));
-    proc_flr_.reset(new ProcessFunctionLibraryRuntime(
+    proc_flr_ = NewRuntime(session_metadata);
+  }
+
+  // Returns a runtime for the library and cluster set up by Init().
+  std::unique_ptr<ProcessFunctionLibraryRuntime> NewRuntime(
+      const SessionMetadata* session_metadata) {
+    OptimizerOptions opts;
+    return std::make_unique<ProcessFunctionLibraryRuntime>(
         device_mgr_.get(), Env::Default(), /*config=*/nullptr,
         TF_GRAPH_DEF_VERSION, lib_def_.get(), opts,
         /*thread_pool=*/nullptr, cluster_flr_.get(), session_metadata,
@@ -158,7 +165,7 @@ class ProcessFunctionLibraryRuntimeTest : public ::testing::Test {
                     rendezvous_ref_counts_.end());
               rendezvous_ref_counts_[step_id]--;
               return Status::OK();
-            }}));
+            }});
   }
 
   void AddCompositeDevice(CompositeDevice* d) {
@@ -833,6 +840,74 @@ FunctionDef AddVarAcrossDevices() {
 }
 
 // An implementation of FunctionArgsInterface for packed inputs.
+// Counts how often the PRE_PLACEMENT passes run on the body of "XTimesTwo",
+// i.e. how often it is optimized and partitioned.
+class CountXTimesTwoOptimizations : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override {
+    if (options.is_function_graph && options.function_def != nullptr &&
+        options.function_def->signature().name() == "XTimesTwo") {
+      ++count_;
+    }
+    return Status::OK();
+  }
+
+  static int count_;
+};
+
+int CountXTimesTwoOptimizations::count_ = 0;
+
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::PRE_PLACEMENT, 1,
+                      CountXTimesTwoOptimizations);
+
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_SharedAcrossRuntimes) {
+  Init({test::function::XTimesTwo()});
+  const SessionMetadata session_metadata = GenerateSessionMetadata();
+  SessionMetadata other_session_metadata = session_metadata;
+  other_session_metadata.set_version(session_metadata.version() + 1);
+
+  setenv("TF_SHARE_MULTI_DEVICE_FUNCTIONS", "1", 1 /* replace */);
+  std::unique_ptr<ProcessFunctionLibraryRuntime> first =
+      NewRuntime(&session_metadata);
+  std::unique_ptr<ProcessFunctionLibraryRuntime> second =
+      NewRuntime(&session_metadata);
+  std::unique_ptr<ProcessFunctionLibraryRuntime> other =
+      NewRuntime(&other_session_metadata);
+  unsetenv("TF_SHARE_MULTI_DEVICE_FUNCTIONS");
+  std::unique_ptr<ProcessFunctionLibraryRuntime> not_sharing =
+      NewRuntime(&session_metadata);
+
+  // Runs XTimesTwo on `pflr` and returns how often it had to be optimized.
+  auto run = [this](ProcessFunctionLibraryRuntime* pflr,
+                    const FunctionLibraryRuntime::InstantiateOptions& options) {
+    const int count = CountXTimesTwoOptimizations::count_;
+    Tensor y;
+    TF_CHECK_OK((RunWithRuntime<std::vector<Tensor>, Tensor>(
+        "XTimesTwo", FunctionLibraryRuntime::Options(), {{"T", DT_FLOAT}},
+        options, {test::AsTensor<float>({1, 2})}, {&y}, pflr)));
+    test::ExpectTensorEqual<float>(y, test::AsTensor<float>({2, 4}));
+    return CountXTimesTwoOptimizations::count_ - count;
+  };
+
+  const FunctionLibraryRuntime::InstantiateOptions inst_opts =
+      MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"});
+  EXPECT_EQ(1, run(first.get(), inst_opts));
+  EXPECT_EQ(0, run(second.get(), inst_opts));
+  EXPECT_EQ(1, run(other.get(), inst_opts));
+  EXPECT_EQ(1, run(not_sharing.get(), inst_opts));
+
+  // A function with an optimize_graph_fn is never shared, even with a runtime
+  // whose instantiation used the same options.
+  FunctionLibraryRuntime::InstantiateOptions optimize_opts = inst_opts;
+  optimize_opts.optimize_graph_fn =
+      [](std::vector<string> ret_node_names,
+         std::vector<string> keep_node_names, FunctionLibraryDefinition* flib,
+         const DeviceSet& device_set, Device* cpu_device,
+         std::unique_ptr<Graph>* graph) { return Status::OK(); };
+  EXPECT_EQ(1, run(first.get(), optimize_opts));
+  EXPECT_EQ(1, run(second.get(), optimize_opts));
+}
+
 class TestFunctionPackedArgs : public FunctionArgsInterface {
  public:
   TestFunctionPackedArgs(const int index,
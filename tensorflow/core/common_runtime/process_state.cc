@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -100,9 +101,29 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       }
       int64_t cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       DCHECK(sub_allocator);
-      allocator =
+      BFCAllocator* bfc_allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, /*allow_growth=*/true,
                            /*name=*/"bfc_cpu_allocator_for_gpu");
+      // Optionally serve small allocations from per-thread caches to avoid
+      // contending on the allocator lock.
+      int64_t thread_cache_shards = 0;
+      status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_CACHE_SHARDS", 0,
+                                   &thread_cache_shards);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      if (thread_cache_shards > 0) {
+        int64_t thread_cache_limit_in_kb = 0;
+        status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_CACHE_LIMIT_IN_KB",
+                                     1 << 10 /*1MB per shard by default*/,
+                                     &thread_cache_limit_in_kb);
+        if (!status.ok()) {
+          LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+        }
+        bfc_allocator->EnableThreadCache(
+            thread_cache_shards, thread_cache_limit_in_kb * (1LL << 10));
+      }
+      allocator = bfc_allocator;
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
@@ -134,6 +155,28 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   return cpu_allocators_[numa_node];
 }
 
+Allocator* ProcessState::GetNUMAAllocator(int numa_node) {
+  if (numa_enabled_) return GetCPUAllocator(numa_node);
+  DCHECK_GE(numa_node, 0);
+  DCHECK_LT(numa_node, port::NUMANumNodes());
+  mutex_lock lock(mu_);
+  if (numa_allocators_.size() <= static_cast<size_t>(numa_node)) {
+    numa_allocators_.resize(numa_node + 1, nullptr);
+  }
+  Allocator*& allocator = numa_allocators_[numa_node];
+  if (allocator == nullptr) {
+    // Pools buffers like the CPU allocator does when NUMA is enabled, since
+    // each allocation from the sub-allocator is a system call.
+    allocator = new PoolAllocator(
+        /*pool_size_limit=*/100, /*auto_resize=*/true,
+        new BasicCPUAllocator(numa_node, cpu_alloc_visitors_,
+                              cpu_free_visitors_),
+        new NoopRounder, strings::StrCat("numa_pool_", numa_node));
+    VLOG(2) << "Using PoolAllocator for NUMA node " << numa_node;
+  }
+  return allocator;
+}
+
 void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
   VLOG(1) << "AddCPUAllocVisitor";
   mutex_lock lock(mu_);
@@ -160,6 +203,10 @@ void ProcessState::TestOnlyReset() {
     if (a != default_cpu_allocator) delete a;
   }
   cpu_allocators_.clear();
+  for (Allocator* a : numa_allocators_) {
+    delete a;
+  }
+  numa_allocators_.clear();
   for (Allocator* a : cpu_al_) {
     delete a;
   }
@@ -67,6 +67,12 @@ class ProcessState : public ProcessStateInterface {
   // Treats numa_node == kNUMANoAffinity as numa_node == 0.
   Allocator* GetCPUAllocator(int numa_node) override;
 
+  // Returns an allocator of memory with affinity to "numa_node", whether or
+  // not NUMA allocators are enabled for the CPU devices.  Lets the input
+  // pipelines feeding a device keep their buffers on the socket nearest to it.
+  // REQUIRES: 0 <= numa_node < port::NUMANumNodes().
+  Allocator* GetNUMAAllocator(int numa_node);
+
   // Registers alloc visitor for the CPU allocator(s).
   // REQUIRES: must be called before GetCPUAllocator.
   void AddCPUAllocVisitor(SubAllocator::Visitor v);
@@ -102,6 +108,9 @@ class ProcessState : public ProcessStateInterface {
   std::vector<Allocator*> cpu_allocators_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_alloc_visitors_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_free_visitors_ TF_GUARDED_BY(mu_);
+  // The allocators returned by GetNUMAAllocator() while NUMA allocators are
+  // not enabled, indexed by numa_node.
+  std::vector<Allocator*> numa_allocators_ TF_GUARDED_BY(mu_);
 
   // A cache of cpu allocators indexed by a numa node. Used as a fast path to
   // get CPU allocator by numa node id without locking the mutex. We can't use
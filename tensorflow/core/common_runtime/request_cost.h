@@ -16,12 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_REQUEST_COST_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_REQUEST_COST_H_
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
 namespace tensorflow {
@@ -39,11 +41,34 @@ class RequestCost {
   // rpc request, when all the costs have been collected.
   absl::flat_hash_map<std::string, absl::Duration> GetCosts() const;
 
+  // Metrics of a batch that processed the rpc request, or a part of it.
+  struct BatchMetrics {
+    // Size of the batch, including the padding.
+    int64_t processed_size = 0;
+    // Size of the rpc request's inputs in the batch.
+    int64_t input_size = 0;
+    // Size of the padding in the batch.
+    int64_t padding_size = 0;
+    // Costs of processing the whole batch, keyed by cost type.
+    absl::flat_hash_map<std::string, absl::Duration> batch_costs;
+  };
+
+  // Records the metrics of a batch. It's thread-safe, and can be called from
+  // different threads.
+  void RecordBatchMetrics(const BatchMetrics& batch_metrics);
+
+  // Gets the metrics of all the batches that processed the rpc request. It's
+  // thread-safe, and expected to be called at the end of processing the rpc
+  // request.
+  std::vector<BatchMetrics> GetBatchMetrics() const;
+
  private:
   mutable absl::Mutex mutex_;
   // Map from cost type to cost.
   absl::flat_hash_map<std::string, absl::Duration> cost_map_
       ABSL_GUARDED_BY(mutex_);
+  // Metrics of the batches, in the order they are recorded.
+  std::vector<BatchMetrics> batch_metrics_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/request_cost.h"
 
+#include <vector>
+
 #include "absl/time/time.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -48,5 +50,36 @@ TEST(RequestCostTest, Basic) {
                                    Pair("cpu_v2", absl::Milliseconds(44))));
 }
 
+TEST(RequestCostTest, BatchMetrics) {
+  RequestCost request_cost;
+
+  request_cost.RecordBatchMetrics(RequestCost::BatchMetrics{
+      /*processed_size=*/8,
+      /*input_size=*/8,
+      /*padding_size=*/0,
+      {{"cpu", absl::Milliseconds(80)}, {"tpu", absl::Milliseconds(160)}}});
+  request_cost.RecordBatchMetrics(RequestCost::BatchMetrics{
+      /*processed_size=*/4,
+      /*input_size=*/2,
+      /*padding_size=*/1,
+      {{"cpu", absl::Milliseconds(40)}, {"tpu", absl::Milliseconds(80)}}});
+
+  const std::vector<RequestCost::BatchMetrics> batch_metrics =
+      request_cost.GetBatchMetrics();
+  ASSERT_EQ(batch_metrics.size(), 2);
+  EXPECT_EQ(batch_metrics[0].processed_size, 8);
+  EXPECT_EQ(batch_metrics[0].input_size, 8);
+  EXPECT_EQ(batch_metrics[0].padding_size, 0);
+  EXPECT_THAT(batch_metrics[0].batch_costs,
+              UnorderedElementsAre(Pair("cpu", absl::Milliseconds(80)),
+                                   Pair("tpu", absl::Milliseconds(160))));
+  EXPECT_EQ(batch_metrics[1].processed_size, 4);
+  EXPECT_EQ(batch_metrics[1].input_size, 2);
+  EXPECT_EQ(batch_metrics[1].padding_size, 1);
+  EXPECT_THAT(batch_metrics[1].batch_costs,
+              UnorderedElementsAre(Pair("cpu", absl::Milliseconds(40)),
+                                   Pair("tpu", absl::Milliseconds(80))));
+}
+
 }  // namespace
 }  // namespace tensorflow
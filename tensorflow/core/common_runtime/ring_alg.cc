@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <utility>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -39,6 +41,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 // Set true for greater intelligibility of debug mode log messages.
 #define READABLE_KEYS false
@@ -310,6 +314,7 @@ void RingAlg::Finish(bool ok) {
   if (ok) {
     // Recover the output from the adaptor.
     ca_->ConsumeFinalValue(col_ctx_->output);
+    ExportTelemetry();
   }
   Status s;
   {
@@ -409,7 +414,11 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
       col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
       col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
-      done);
+      [this, rf, num_bytes = ca_->ChunkBytes(rf->sc_idx),
+       start_micros = Env::Default()->NowMicros(), done](const Status& s) {
+        if (s.ok()) RecordTransfer(*rf, nullptr, num_bytes, start_micros);
+        done(s);
+      });
 }
 
 void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
@@ -423,14 +432,117 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
-  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+  // Only the partial sums of the first pass are accumulated by the receiver,
+  // so only those may be sent in a lossy wire format.
+  CollectiveWireFormat wire_format;
+  if (!rf->second_pass && col_params_->merge_op != nullptr) {
+    wire_format = col_params_->instance.impl_details.wire_format;
+  }
+  col_ctx_->col_exec->remote_access()->RecvFromPeerWithWireFormat(
       col_params_->group.members[rf->recv_dev_idx].device.name(),
       col_params_->group.members[rf->recv_dev_idx].task,
       col_params_->group.members[rf->recv_dev_idx].is_local, recv_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
       col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
-      col_ctx_->device_locality, rf->subdiv_idx,
-      col_ctx_->op_ctx->cancellation_manager(), done);
+      col_ctx_->device_locality, rf->subdiv_idx, wire_format,
+      col_ctx_->op_ctx->cancellation_manager(),
+      [this, rf, num_bytes = ca_->ChunkBytes(rf->sc_idx),
+       start_micros = Env::Default()->NowMicros(), done](const Status& s) {
+        if (s.ok()) {
+          RecordTransfer(
+              *rf, &col_params_->group.members[rf->recv_dev_idx].device.name(),
+              num_bytes, start_micros);
+        }
+        done(s);
+      });
+}
+
+void RingAlg::StartTelemetry() {
+  start_micros_ = Env::Default()->NowMicros();
+  mutex_lock l(telemetry_mu_);
+  pass_end_micros_[0] = pass_end_micros_[1] = 0;
+  recv_peers_.clear();
+}
+
+void RingAlg::RecordTransfer(const RingField& rf, const string* recv_peer,
+                             int64_t num_bytes, uint64 start_micros) {
+  const uint64 end_micros = Env::Default()->NowMicros();
+  const int64_t usecs = end_micros - start_micros;
+  const int pass = rf.second_pass ? 1 : 0;
+  profiler::TraceMe::InstantActivity(
+      [&]() {
+        return profiler::TraceMeEncode(
+            recv_peer ? "RingRecv" : "RingSend",
+            {{"peer", recv_peer ? *recv_peer : ""},
+             {"bytes", num_bytes},
+             {"pass", pass},
+             {"subdiv", rf.subdiv_idx},
+             {"usecs", usecs}});
+      },
+      profiler::TraceMeLevel::kVerbose);
+  mutex_lock l(telemetry_mu_);
+  pass_end_micros_[pass] = std::max(pass_end_micros_[pass], end_micros);
+  if (recv_peer) {
+    PeerTelemetry& peer = recv_peers_[*recv_peer];
+    peer.num_bytes += num_bytes;
+    peer.wait_usecs += usecs;
+  }
+}
+
+void RingAlg::ExportTelemetry() {
+  const string collective = strings::StrCat("Ring", name_);
+  const uint64 end_micros = Env::Default()->NowMicros();
+  const int64_t total_usecs = end_micros - start_micros_;
+  const int64_t num_bytes = col_ctx_->output->TotalBytes();
+  // As reported by NCCL, the bus bandwidth scales the bandwidth of the
+  // collective by the fraction of the output that each device sends in an
+  // optimal algorithm: 2 (n - 1) / n for a reduction, (n - 1) / n otherwise.
+  double bus_fraction = (group_size_ - 1.0) / group_size_;
+  if (type_ == REDUCTION_COLLECTIVE) bus_fraction *= 2;
+  // Bytes per microsecond are megabytes per second.
+  const double bus_bandwidth_mbps =
+      total_usecs > 0 ? num_bytes * bus_fraction / total_usecs : 0.0;
+
+  mutex_lock l(telemetry_mu_);
+  const uint64 first_pass_end_micros =
+      std::max(pass_end_micros_[0], start_micros_);
+  const int64_t first_pass_usecs = first_pass_end_micros - start_micros_;
+  const int64_t second_pass_usecs =
+      pass_end_micros_[1] > first_pass_end_micros
+          ? pass_end_micros_[1] - first_pass_end_micros
+          : 0;
+  metrics::RecordCollectiveBusBandwidth(collective, bus_bandwidth_mbps);
+  metrics::UpdateCollectivePhaseTime(collective, "first_pass",
+                                     first_pass_usecs);
+  metrics::UpdateCollectivePhaseTime(collective, "second_pass",
+                                     second_pass_usecs);
+  const string* slowest_peer = nullptr;
+  int64_t slowest_peer_usecs = 0;
+  for (const auto& peer : recv_peers_) {
+    metrics::RecordCollectivePeerRecv(peer.first, peer.second.num_bytes,
+                                      peer.second.wait_usecs);
+    if (slowest_peer == nullptr ||
+        peer.second.wait_usecs > slowest_peer_usecs) {
+      slowest_peer = &peer.first;
+      slowest_peer_usecs = peer.second.wait_usecs;
+    }
+  }
+  profiler::TraceMe::InstantActivity(
+      [&]() {
+        return profiler::TraceMeEncode(
+            collective,
+            {{"exec_key", col_ctx_->exec_key},
+             {"device", col_ctx_->device_name},
+             {"group_size", group_size_},
+             {"bytes", num_bytes},
+             {"usecs", total_usecs},
+             {"bus_bandwidth_mbps", bus_bandwidth_mbps},
+             {"first_pass_usecs", first_pass_usecs},
+             {"second_pass_usecs", second_pass_usecs},
+             {"slowest_peer", slowest_peer ? *slowest_peer : ""},
+             {"slowest_peer_usecs", slowest_peer_usecs}});
+      },
+      profiler::TraceMeLevel::kInfo);
 }
 
 string RingAlg::FieldState() {
@@ -20,6 +20,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
 #include "tensorflow/core/framework/collective.h"
 
@@ -48,6 +49,11 @@ class RingAlg : public CollectiveImplementationInterface {
   void StartAbort(const Status& s);
   void Finish(bool ok);
 
+  // Starts timing the collective, called at the beginning of Run. The
+  // telemetry of successful collectives is exported by Finish, as a TraceMe
+  // and to monitoring.
+  void StartTelemetry();
+
   // Current status of a RingField
   enum RingFieldAction {
     RF_INIT = 0,    // Just initialized for a pass
@@ -83,6 +89,9 @@ class RingAlg : public CollectiveImplementationInterface {
   void AdvanceToSecondPass(RingField* rf);
   void DispatchSend(RingField* rf, const StatusCallback& done);
   void DispatchRecv(RingField* rf, const StatusCallback& done);
+  void RecordTransfer(const RingField& rf, const string* recv_peer,
+                      int64_t num_bytes, uint64 start_micros);
+  void ExportTelemetry();
 
   // For constructing log messages for debugging.
   string FieldState();
@@ -114,6 +123,18 @@ class RingAlg : public CollectiveImplementationInterface {
   mutex status_mu_;
   Status status_ TF_GUARDED_BY(status_mu_);
   std::vector<RingField> rfv_;
+
+  struct PeerTelemetry {
+    int64_t num_bytes = 0;
+    // From the dispatch of the receives to their completion.
+    int64_t wait_usecs = 0;
+  };
+  uint64 start_micros_ = 0;
+  mutex telemetry_mu_;
+  // When the last transfer of each pass completed.
+  uint64 pass_end_micros_[2] TF_GUARDED_BY(telemetry_mu_) = {0, 0};
+  absl::flat_hash_map<string, PeerTelemetry> recv_peers_
+      TF_GUARDED_BY(telemetry_mu_);
 };
 
 }  // namespace tensorflow
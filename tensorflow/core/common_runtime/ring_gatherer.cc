@@ -63,6 +63,7 @@ Status RingGatherer::InitializeCollectiveParams(CollectiveParams* col_params) {
 void RingGatherer::Run(StatusCallback done) {
   DCHECK(col_ctx_);
   DCHECK(col_params_);
+  StartTelemetry();
   done_ = std::move(done);
   group_size_ = col_params_->group.group_size;
   num_subdivs_ = static_cast<int>(
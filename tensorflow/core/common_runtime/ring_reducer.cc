@@ -59,6 +59,7 @@ void RingReducer::Run(StatusCallback done) {
   // any collective that is blocked on this instance.
   col_ctx_->col_exec->UnblockDependencies(*col_params_);
 
+  StartTelemetry();
   done_ = std::move(done);
   group_size_ = col_params_->group.group_size;
   num_subdivs_ = static_cast<int>(
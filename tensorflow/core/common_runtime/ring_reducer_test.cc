@@ -36,6 +36,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
@@ -198,6 +200,116 @@ class RingReducerTest : public ::testing::Test {
     Status status_;
   };
 
+  // Issues one reduction per entry of `lengths` on every device through the
+  // collective executor, all in one fusion group, and checks each result.
+  void RunFusedTest(int num_workers, int num_devices,
+                    const std::vector<int64_t>& lengths) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    const int group_size = num_workers * num_devices;
+    std::vector<std::vector<Tensor>> results(
+        group_size, std::vector<Tensor>(lengths.size()));
+    std::vector<std::vector<Status>> statuses(
+        group_size, std::vector<Status>(lengths.size()));
+    std::atomic<int> done(0);
+    for (int rank = 0; rank < group_size; ++rank) {
+      for (int mi = 0; mi < lengths.size(); ++mi) {
+        SchedClosure([this, rank, mi, &lengths, &results, &statuses, &done] {
+          statuses[rank][mi] =
+              DoFusedReduce(rank, /*instance_key=*/100 + mi, lengths.size(),
+                            lengths[mi], &results[rank][mi]);
+          ++done;
+        });
+      }
+    }
+    while (done < group_size * static_cast<int>(lengths.size())) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (int mi = 0; mi < lengths.size(); ++mi) {
+      std::vector<float> expected(lengths[mi]);
+      for (int rank = 0; rank < group_size; ++rank) {
+        for (int64_t i = 0; i < lengths[mi]; ++i) {
+          expected[i] += static_cast<float>(rank * 10 + i + mi);
+        }
+      }
+      for (int64_t i = 0; i < lengths[mi]; ++i) {
+        expected[i] /= static_cast<float>(group_size);
+      }
+      for (int rank = 0; rank < group_size; ++rank) {
+        TF_EXPECT_OK(statuses[rank][mi]);
+        test::ExpectTensorEqual<float>(test::AsTensor<float>(expected),
+                                       results[rank][mi]);
+      }
+    }
+  }
+
+  Status DoFusedReduce(int rank, int instance_key, int fusion_group_size,
+                       int64_t length, Tensor* result) {
+    core::RefCountPtr<CollectiveParams> col_params =
+        CreateCollectiveParams(*test_env_, rank, "RingReduce",
+                               REDUCTION_COLLECTIVE, DT_FLOAT,
+                               TensorShape({length}));
+    col_params->instance.instance_key = instance_key;
+    col_params->instance.impl_details.fusion_key = 1;
+    col_params->instance.impl_details.fusion_group_size = fusion_group_size;
+    // Mirror what param resolution does for each member, since members that
+    // end up in a bucket of their own run unfused.
+    core::RefCountPtr<RingReducer> reducer(new RingReducer());
+    TF_RETURN_IF_ERROR(reducer->InitializeCollectiveParams(col_params.get()));
+    reducer->group_size_tensor_ready_.Notify();  // To unblock destructor.
+
+    Device* device = nullptr;
+    TF_RETURN_IF_ERROR(test_env_->device_mgr->LookupDevice(
+        col_params->group.members[rank].device.name(), &device));
+    std::unique_ptr<OpKernel> merge_op = GetAdd(DT_FLOAT, DEVICE_CPU, device);
+    std::unique_ptr<OpKernel> final_op = GetDiv(DT_FLOAT, DEVICE_CPU, device);
+    col_params->merge_op = merge_op.get();
+    col_params->final_op = final_op.get();
+
+    Tensor input(DT_FLOAT, TensorShape({length}));
+    for (int64_t i = 0; i < length; ++i) {
+      input.flat<float>()(i) =
+          static_cast<float>(rank * 10 + i + instance_key - 100);
+    }
+    OpKernelContext::Params op_params;
+    CancellationManager cancellation_manager;
+    op_params.step_id = 0;
+    op_params.device = device;
+    // The merge op stands in for the collective op kernel, which only needs
+    // a single output of the reduced type.
+    op_params.op_kernel = merge_op.get();
+    op_params.cancellation_manager = &cancellation_manager;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    inputs.push_back(TensorValue(&input));
+    op_params.inputs = &inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+        {AllocatorAttributes()});
+    op_params.input_alloc_attrs = &input_aa;
+    DeviceContext* dev_ctx = new DeviceContext;
+    core::ScopedUnref unref_dev_ctx(dev_ctx);
+    op_params.op_device_context = dev_ctx;
+    int forward_from = 0;
+    op_params.forward_from_array = &forward_from;
+    AllocatorAttributes generic_alloc_attr;
+    op_params.output_attr_array = &generic_alloc_attr;
+    op_params.resource_manager = device->resource_manager();
+    OpKernelContext ctx(&op_params, 1);
+    ctx.set_output(0, Tensor(DT_FLOAT, TensorShape({length})));
+
+    Status status;
+    Notification n;
+    test_env_->col_exec->ExecuteAsync(
+        &ctx, col_params.get(), strings::StrCat(instance_key, ":0:0"),
+        [&status, &n](const Status& s) {
+          status = s;
+          n.Notify();
+        });
+    n.WaitForNotification();
+    if (status.ok()) {
+      *result = *ctx.mutable_output(0);
+    }
+    return status;
+  }
+
   std::unique_ptr<CollectiveTestEnv> test_env_;
   std::vector<std::unique_ptr<DeviceInstance>> instances_;
   mutex mu_;
@@ -375,6 +487,50 @@ TEST_F(RingReducerInitParamsTest, AutomaticSubdivDisabled) {
   RunSubdivPermsTest(cp.get(), {{0, 1, 2, 3}}, {0});
 }
 
+TEST_F(RingReducerTest, FusedSmallReductions) {
+  RunFusedTest(/*num_workers=*/1, /*num_devices=*/2, {5, 17, 64});
+}
+
+TEST_F(RingReducerTest, FusedReductionsAcrossWorkers) {
+  RunFusedTest(/*num_workers=*/2, /*num_devices=*/4, {1, 1001, 3, 4096});
+}
+
+TEST_F(RingReducerTest, FusedReductionsSplitAtThreshold) {
+  // The two large reductions cannot share a bucket, so the group is reduced
+  // in two fused passes.
+  const int64_t half_threshold_elts =
+      BaseCollectiveExecutor::kFusionThresholdBytes / sizeof(float) / 2;
+  RunFusedTest(/*num_workers=*/1, /*num_devices=*/2,
+               {7, half_threshold_elts, half_threshold_elts, 9});
+}
+
+TEST_F(RingReducerTest, ExportsTelemetry) {
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, /*num_workers=*/1, /*num_devices=*/4,
+                 /*num_subdivs=*/1, /*tensor_len=*/1024, /*fail_after=*/0);
+  const std::unique_ptr<monitoring::CollectedMetrics> collected_metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+
+  // Each device receives from the device preceding it in the ring.
+  const monitoring::PointSet& recv_bytes =
+      *collected_metrics->point_set_map.at(
+          "/tensorflow/core/collective/peer_recv_bytes");
+  EXPECT_GE(recv_bytes.points.size(), 4);
+  for (const auto& point : recv_bytes.points) {
+    EXPECT_GT(point->int64_value, 0);
+  }
+
+  const monitoring::PointSet& bus_bandwidth =
+      *collected_metrics->point_set_map.at(
+          "/tensorflow/core/collective/bus_bandwidth_mbps");
+  int64_t num_reductions = 0;
+  for (const auto& point : bus_bandwidth.points) {
+    if (point->labels[0].value == "RingReduce") {
+      num_reductions += point->histogram_value.num();
+    }
+  }
+  EXPECT_GE(num_reductions, 4);
+}
+
 // TODO(b/113171733): change to use TEST_P.
 #define DEF_TEST(B, T, W, D, S, L, A)                                         \
   TEST_F(RingReducerTest,                                                     \
@@ -31,6 +31,8 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 
@@ -154,9 +156,88 @@ Status ShapeRefiner::InferShapesForFunctionSubNode(
 // NOTE: Recursive user-defined functions are not supported.
 // Maybe we won't support recursive functions at all in TF, because of
 // other maintainability issues.
+uint64 ShapeRefiner::FunctionShapesKey(const FunctionDef* function_def,
+                                       AttrSlice attributes,
+                                       InferenceContext* outer_context) {
+  auto it = function_fingerprints_.find(function_def);
+  if (it == function_fingerprints_.end()) {
+    it = function_fingerprints_
+             .emplace(function_def,
+                      FunctionFingerprint(*function_library_, *function_def))
+             .first;
+  }
+  uint64 key = FingerprintCat64(Fingerprint64("ShapeRefiner"), it->second);
+  key = FingerprintCat64(key, Fingerprint64(Canonicalize("", attributes)));
+  key = FingerprintCat64(key, graph_def_version_);
+  key = FingerprintCat64(key, (require_shape_inference_fns_ ? 2 : 0) +
+                                  (disable_constant_propagation_ ? 1 : 0));
+
+  TensorShapeProto proto;
+  for (int i = 0; i < outer_context->num_inputs(); ++i) {
+    const ShapeHandle input = outer_context->input(i);
+    if (input.SameHandle(ShapeHandle())) {
+      key = FingerprintCat64(key, Fingerprint64("unset"));
+    } else {
+      outer_context->ShapeHandleToProto(input, &proto);
+      key = FingerprintCat64(key, DeterministicProtoHash64(proto));
+    }
+    const auto* resource = outer_context->input_handle_shapes_and_types(i);
+    if (resource != nullptr) {
+      for (const ShapeAndType& shape_and_type : *resource) {
+        outer_context->ShapeHandleToProto(shape_and_type.shape, &proto);
+        key = FingerprintCat64(key, DeterministicProtoHash64(proto));
+        key = FingerprintCat64(key, shape_and_type.dtype);
+        key = FingerprintCat64(key,
+                               DeterministicProtoHash64(shape_and_type.type));
+      }
+    }
+    const Tensor* input_tensor = outer_context->input_tensor(i);
+    if (input_tensor != nullptr) {
+      TensorProto tensor_proto;
+      input_tensor->AsProtoTensorContent(&tensor_proto);
+      key = FingerprintCat64(key, DeterministicProtoHash64(tensor_proto));
+    }
+    key = FingerprintCat64(key, i);
+  }
+  return key;
+}
+
 Status ShapeRefiner::InferShapesForFunction(
     const FunctionDef* function_def, AttrSlice attributes,
     ExtendedInferenceContext* outer_context) {
+  InferenceContext* ctx = outer_context->get_context();
+  FunctionShapeCache* cache = FunctionShapeCache::Global();
+  uint64 key = 0;
+  if (cache->enabled()) {
+    key = FunctionShapesKey(function_def, attributes, ctx);
+    std::shared_ptr<const FunctionShapes> shapes = cache->Lookup(key);
+    if (shapes != nullptr) {
+      for (int i = 0; i < shapes->outputs.size(); ++i) {
+        const FunctionShapes::Output& output = shapes->outputs[i];
+        if (output.shape) {
+          ShapeHandle handle;
+          TF_RETURN_IF_ERROR(
+              ctx->MakeShapeFromShapeProto(*output.shape, &handle));
+          ctx->set_output(i, handle);
+        }
+        if (output.handle_shapes_and_types.empty()) continue;
+        std::vector<ShapeAndType> shapes_and_types;
+        for (const auto& shape_and_type : output.handle_shapes_and_types) {
+          ShapeHandle handle;
+          TF_RETURN_IF_ERROR(
+              ctx->MakeShapeFromShapeProto(shape_and_type.shape, &handle));
+          shapes_and_types.push_back(
+              ShapeAndType(handle, shape_and_type.dtype, shape_and_type.type));
+        }
+        ctx->set_output_handle_shapes_and_types(i, shapes_and_types);
+      }
+      for (int i : shapes->requested_input_tensors) {
+        ctx->request_input_tensor(i);
+      }
+      return Status::OK();
+    }
+  }
+
   const Graph* graph;
   auto it = functions_.find(function_def);
   if (it != functions_.end()) {
@@ -201,6 +282,34 @@ Status ShapeRefiner::InferShapesForFunction(
     node_to_context_.erase(node);
   }
 
+  if (inference_status.ok() && cache->enabled()) {
+    FunctionShapes shapes;
+    shapes.outputs.resize(ctx->num_outputs());
+    for (int i = 0; i < ctx->num_outputs(); ++i) {
+      FunctionShapes::Output& output = shapes.outputs[i];
+      if (!ctx->output(i).SameHandle(ShapeHandle())) {
+        output.shape.emplace();
+        ctx->ShapeHandleToProto(ctx->output(i), &*output.shape);
+      }
+      const auto* resource = ctx->output_handle_shapes_and_types(i);
+      if (resource == nullptr) continue;
+      for (const ShapeAndType& shape_and_type : *resource) {
+        output.handle_shapes_and_types.emplace_back();
+        auto& handle_shape_and_type = output.handle_shapes_and_types.back();
+        ctx->ShapeHandleToProto(shape_and_type.shape,
+                                &handle_shape_and_type.shape);
+        handle_shape_and_type.dtype = shape_and_type.dtype;
+        handle_shape_and_type.type = shape_and_type.type;
+      }
+    }
+    for (int i = 0; i < ctx->num_inputs(); ++i) {
+      if (ctx->requested_input_tensor(i)) {
+        shapes.requested_input_tensors.push_back(i);
+      }
+    }
+    cache->Insert(key, std::move(shapes));
+  }
+
   return inference_status;
 }
 
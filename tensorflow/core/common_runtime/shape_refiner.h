@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/function_shape_cache.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/shape_inference.h"
@@ -180,10 +181,20 @@ class ShapeRefiner {
   //
   // On success:
   // - outer_context will contain output shapes inferred from input shapes
+  //
+  // The output shapes are memoized in FunctionShapeCache::Global(), so that
+  // calls of the same function with the same inputs are inferred once, even
+  // across refiners.
   Status InferShapesForFunction(const FunctionDef* function_def,
                                 AttrSlice attributes,
                                 ExtendedInferenceContext* outer_context);
 
+  // Returns the FunctionShapeCache key of the call of function_def with the
+  // inputs of outer_context.
+  uint64 FunctionShapesKey(const FunctionDef* function_def,
+                           AttrSlice attributes,
+                           shape_inference::InferenceContext* outer_context);
+
   // Performs shape inference for a node inside a function.
   //
   // 'outer_context' is the 'InferenceContext' for the function's call op.
@@ -326,6 +337,11 @@ class ShapeRefiner {
                       hash<const FunctionDef*>>
       functions_;
 
+  // Caches FunctionFingerprint() of each function definition for which
+  // shapes are refined.
+  absl::flat_hash_map<const FunctionDef*, uint64, hash<const FunctionDef*>>
+      function_fingerprints_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ShapeRefiner);
 };
 
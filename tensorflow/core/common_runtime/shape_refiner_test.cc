@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/function_shape_cache.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/function_testlib.h"
@@ -1494,6 +1495,40 @@ TEST_F(ShapeRefinerTest, FunctionShapeInferenceFallback) {
   EXPECT_SHAPE("?", m, x2, 0);
 }
 
+TEST_F(ShapeRefinerTest, FunctionShapeInferenceIsMemoized) {
+  FunctionDefLibrary f_lib_proto;
+  *(f_lib_proto.add_function()) = test::function::XTimesTwo();
+  FunctionLibraryDefinition f_lib(OpRegistry::Global(), f_lib_proto);
+
+  Scope root = Scope::NewRootScope();
+  TF_ASSERT_OK(root.graph()->AddFunctionLibrary(f_lib_proto));
+  auto x = ops::Const(root, {{1.0f, 2.0f}});
+  auto x2 = test::function::Call(&root, "x2", "XTimesTwo", {x});
+  auto y = ops::Const(root, {{1.0f, 2.0f}, {3.0f, 4.0f}, {5.0f, 6.0f}});
+  auto y2 = test::function::Call(&root, "y2", "XTimesTwo", {y});
+
+  FunctionShapeCache* cache = FunctionShapeCache::Global();
+  cache->Clear();
+  for (int i = 0; i < 2; ++i) {
+    // The second refiner finds the shapes inferred by the first one.
+    ShapeRefiner m(TF_GRAPH_DEF_VERSION, &f_lib);
+    m.set_function_library_for_shape_inference(&f_lib);
+    TF_ASSERT_OK(m.AddNode(x.node()));
+    TF_ASSERT_OK(m.AddNode(x2.node()));
+    EXPECT_SHAPE("[1,2]", m, x2, 0);
+    EXPECT_EQ(cache->size(), 1);
+  }
+
+  // Calls with other input shapes are inferred again.
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, &f_lib);
+  m.set_function_library_for_shape_inference(&f_lib);
+  TF_ASSERT_OK(m.AddNode(y.node()));
+  TF_ASSERT_OK(m.AddNode(y2.node()));
+  EXPECT_SHAPE("[3,2]", m, y2, 0);
+  EXPECT_EQ(cache->size(), 2);
+  cache->Clear();
+}
+
 TEST_F(ShapeRefinerTest, ChainedFunctionShapeInferenceWithMultipleInputs) {
   FunctionDefLibrary f_lib_proto;
   *(f_lib_proto.add_function()) = test::function::XTimesTwo();
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/single_threaded_executor.h"
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
@@ -37,9 +38,9 @@ Status ValidateOp(const Node& n) {
           DataTypeString(dt), " in outputs of node ", n.name());
     }
   }
-  if (n.IsControlFlow()) {
+  if (n.IsControlFlow() && !n.IsSwitch() && !n.IsMerge()) {
     return errors::FailedPrecondition(
-        "Single-threaded executor does not support low level control flow, "
+        "Single-threaded executor does not support low level loops, "
         " but saw control flow node ",
         n.name(),
         ".  Perhaps your graph contains old-style control flow primitives? "
@@ -60,6 +61,13 @@ Status ValidateOp(const Node& n) {
   return Status::OK();
 }
 
+Status ValidateGraphForSingleThreadedExecutor(const Graph& graph) {
+  for (const Node* n : graph.op_nodes()) {
+    TF_RETURN_IF_ERROR(ValidateOp(*n));
+  }
+  return Status::OK();
+}
+
 namespace {
 
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
@@ -102,9 +110,14 @@ class SingleThreadedExecutorImpl : public Executor {
     std::map<size_t, Node*> arg_index_to_node_map;
     absl::flat_hash_map<Node*, size_t> node_to_index_map;
 
+    has_control_flow_ = false;
+    for (const Node* n : ordered_nodes) {
+      TF_RETURN_IF_ERROR(ValidateOp(*n));
+      has_control_flow_ |= n->IsSwitch();
+    }
+
     // Create the kernel and input-related structures for each node in `graph`.
     for (Node* n : ordered_nodes) {
-      TF_RETURN_IF_ERROR(ValidateOp(*n));
       if (n->IsArg()) {
         int32_t arg_index;
         TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &arg_index));
@@ -121,8 +134,15 @@ class SingleThreadedExecutorImpl : public Executor {
       OpKernel* kernel;
       TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
 
+      // With control flow, a constant may only be produced if the node is on
+      // the branch taken, which its control inputs determine.
+      const bool may_be_dead =
+          has_control_flow_ &&
+          absl::c_any_of(n->in_edges(),
+                         [](const Edge* e) { return !e->src()->IsSource(); });
       const Tensor* const_tensor;
-      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor())) {
+      if (n->num_outputs() == 1 && !may_be_dead &&
+          (const_tensor = kernel->const_tensor())) {
         // Nodes that produce a single constant tensor are handled specially:
         // we evaluate the tensor once, and propagate it to its consumers as
         // a `const Tensor*`, to avoid refcount manipulation.
@@ -141,6 +161,8 @@ class SingleThreadedExecutorImpl : public Executor {
         kernel_state.kernel = kernel;
         kernel_state.num_inputs = n->num_inputs();
         kernel_state.num_outputs = n->num_outputs();
+        kernel_state.is_merge = n->IsMerge();
+        kernel_state.is_control_trigger = n->IsControlTrigger();
         node_to_index_map[n] = kernel_index;
         if (kernel_index == 0) {
           kernel_state.input_start_index = 0;
@@ -211,6 +233,14 @@ class SingleThreadedExecutorImpl : public Executor {
               e->dst_input());
         }
       }
+      if (has_control_flow_) {
+        for (const Edge* e : n->in_edges()) {
+          auto it = node_to_index_map.find(e->src());
+          if (e->IsControlEdge() && it != node_to_index_map.end()) {
+            kernel_state.control_input_kernels.push_back(it->second);
+          }
+        }
+      }
 
       // Compute allocator attributes for each node output, and corresponding
       // node input.
@@ -324,10 +354,17 @@ class SingleThreadedExecutorImpl : public Executor {
     params.stats_collector = args.stats_collector;
     params.executor_type = &kSingleThreadedExecutor;
 
-    // NOTE(mrry): We are assuming that the graph is loopless and condless.
+    // NOTE(mrry): We are assuming that the graph is loopless.
     params.frame_iter = FrameAndIter(0, 0);
     params.is_input_dead = false;
 
+    // With control flow, the kernels on the branches that are not taken are
+    // dead: they are not run, and their outputs are left without a value. A
+    // kernel is dead if any of its inputs is, except for a Merge, which is
+    // dead if all of its data inputs are, and a ControlTrigger, which never
+    // is.
+    std::vector<bool> is_dead(has_control_flow_ ? kernels_.size() : 0);
+
     device->TryGetDeviceContext(&params.op_device_context).IgnoreError();
     auto context_cleanup = gtl::MakeCleanup([&params] {
       if (params.op_device_context != nullptr) {
@@ -408,6 +445,14 @@ class SingleThreadedExecutorImpl : public Executor {
       const size_t num_inputs = kernel_state.num_inputs;
       const size_t num_outputs = kernel_state.num_outputs;
 
+      if (has_control_flow_ && IsDead(kernel_state, inputs, is_dead)) {
+        is_dead[i] = true;
+        for (size_t j = 0; j < num_inputs; ++j) {
+          inputs[input_start_index + j].ClearVal();
+        }
+        continue;
+      }
+
       node_inputs.clear();
       node_inputs.resize(num_inputs);
       input_alloc_attrs.clear();
@@ -425,6 +470,11 @@ class SingleThreadedExecutorImpl : public Executor {
           case Entry::State::HAS_VALUE:
             node_inputs[j].tensor = input.val.get();
             break;
+          case Entry::State::NO_VALUE:
+            // Only a Merge runs with some of its inputs dead.
+            DCHECK(kernel_state.is_merge) << "Input did not have a value.";
+            node_inputs[j].tensor = nullptr;
+            break;
           default:
             DCHECK(false) << "Input did not have a valid value.";
         }
@@ -446,6 +496,11 @@ class SingleThreadedExecutorImpl : public Executor {
       // Forward the outputs of the kernel to the inputs of subsequent kernels.
       for (size_t j = 0; j < num_outputs; ++j) {
         TensorValue val = ctx.release_output(j);
+        if (val.tensor == nullptr) {
+          // A Switch leaves the output of the branch not taken unset, which
+          // makes the consumers of that output dead.
+          continue;
+        }
         const size_t num_destinations = kernel_state.output_locations[j].size();
         if (num_destinations > 0) {
           // TODO(mrry): Consider flattening the `output_locations` vector
@@ -479,6 +534,29 @@ class SingleThreadedExecutorImpl : public Executor {
   }
 
  private:
+  struct KernelState;
+
+  // Returns true if the kernel of `kernel_state` is dead, given the inputs and
+  // the deadness of the kernels that ran before it.
+  static bool IsDead(const KernelState& kernel_state,
+                     const std::vector<Entry>& inputs,
+                     const std::vector<bool>& is_dead) {
+    if (kernel_state.is_control_trigger) return false;
+    size_t num_dead_inputs = 0;
+    for (size_t j = 0; j < kernel_state.num_inputs; ++j) {
+      if (inputs[kernel_state.input_start_index + j].state ==
+          Entry::State::NO_VALUE) {
+        ++num_dead_inputs;
+      }
+    }
+    if (kernel_state.is_merge) {
+      return num_dead_inputs == kernel_state.num_inputs;
+    }
+    return num_dead_inputs > 0 ||
+           absl::c_any_of(kernel_state.control_input_kernels,
+                          [&is_dead](size_t k) { return is_dead[k]; });
+  }
+
   const LocalExecutorParams params_;
 
   // All following members are read-only after Initialize().
@@ -488,6 +566,9 @@ class SingleThreadedExecutorImpl : public Executor {
   // `RunAsync()` for details.
   size_t total_num_inputs_;
 
+  // True if the graph has Switch nodes, which make some kernels dead.
+  bool has_control_flow_;
+
   // Represents cached graph structure state for each kernel.
   struct KernelState {
     // The kernel object. Not owned.
@@ -512,6 +593,13 @@ class SingleThreadedExecutorImpl : public Executor {
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
         output_alloc_attrs;  // Length = `num_outputs`.
+
+    // The indices in `kernels_` of the sources of the control inputs of
+    // `kernel`. Only set if the graph has control flow.
+    std::vector<size_t> control_input_kernels;
+
+    bool is_merge;
+    bool is_control_trigger;
   };
   std::vector<KernelState> kernels_;
 
@@ -34,10 +34,9 @@ namespace tensorflow {
 //
 // 1. Reference-typed tensors are not supported and will not be supported in
 //    future.
-// 2. Graphs with control flow (containing "Switch" and "Merge" nodes) are not
-//    currently supported. The current plan is to extend support to "functional"
-//    control flow after the TensorFlow APIs transition to building graphs in
-//    that form (e.g. `tf.cond_v2()`).
+// 2. Graphs with loops (containing "Enter", "Exit" and "NextIteration" nodes)
+//    are not currently supported. Conditionals lowered to "Switch" and "Merge"
+//    nodes are, and the kernels on the branches not taken are skipped.
 // 3. Partitioned graphs (containing "_Recv" nodes) are not currently supported.
 //    The present implementation executes kernels one at a time in topological
 //    order, and cannot currently distinguish between disconnected subgraphs
@@ -54,6 +53,10 @@ namespace tensorflow {
 Status NewSingleThreadedExecutor(const LocalExecutorParams& params,
                                  const Graph& graph, Executor** executor);
 
+// Returns an error if `graph` has nodes that the single-threaded executor does
+// not support, which limitations 1-3 above describe.
+Status ValidateGraphForSingleThreadedExecutor(const Graph& graph);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SINGLE_THREADED_EXECUTOR_H_
@@ -330,6 +330,35 @@ TEST_F(ExecutorTest, ControlDependenciesFromSpecialNodes) {
   EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
 }
 
+TEST_F(ExecutorTest, SwitchMerge) {
+  // out = pred ? in + 2 : -in
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto branch = test::graph::Switch(g.get(), in, pred);
+  auto neg = test::graph::Unary(g.get(), "Neg", branch, 0);
+  auto pivot_true = test::graph::Identity(g.get(), branch, 1);
+  // The constant is only produced on the branch taken.
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  g->AddControlEdge(pivot_true, two);
+  auto add = test::graph::Add(g.get(), pivot_true, two);
+  auto merge = test::graph::Merge(g.get(), neg, add);
+  test::graph::Retval(g.get(), 0, merge);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+
+  for (bool taken : {true, false}) {
+    Tensor pred_tensor(DT_BOOL, TensorShape({}));
+    pred_tensor.scalar<bool>()() = taken;
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(3.0), pred_tensor}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(taken ? 5.0 : -3.0, V(retvals[0]));
+  }
+}
+
 void BM_executor(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int depth = state.range(1);
@@ -0,0 +1,390 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_plan.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Rounds 'bytes' up to a non-zero multiple of the allocator alignment, so that
+// distinct planned allocations never start at the same address unless their
+// lifetimes are disjoint.
+size_t RoundUpToAlignment(size_t bytes) {
+  constexpr size_t kAlignment = Allocator::kAllocatorAlignment;
+  return std::max<size_t>(1, (bytes + kAlignment - 1) / kAlignment) *
+         kAlignment;
+}
+
+}  // namespace
+
+constexpr int StepMemoryPlan::kUnplanned;
+constexpr int StepMemoryPlan::kEscaped;
+
+StepMemoryPlan::StepMemoryPlan(Allocator* allocator, int num_nodes)
+    : allocator_(allocator), num_nodes_(num_nodes) {}
+
+StepMemoryPlan::~StepMemoryPlan() {
+  if (free_arena_ != nullptr) {
+    allocator_->DeallocateRaw(free_arena_);
+  }
+}
+
+core::RefCountPtr<StepArena> StepMemoryPlan::BeginStep() {
+  std::shared_ptr<const Plan> plan;
+  void* base = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (needs_replan_ && !recording_) {
+      needs_replan_ = false;
+      recording_ = true;
+      return core::RefCountPtr<StepArena>(new StepArena(
+          this, StepArena::Mode::kRecord, nullptr, nullptr, 0));
+    }
+    if (plan_ == nullptr || plan_->allocations.empty()) {
+      return core::RefCountPtr<StepArena>(new StepArena(
+          this, StepArena::Mode::kPassthrough, nullptr, nullptr, 0));
+    }
+    plan = plan_;
+    if (free_arena_ != nullptr && free_arena_bytes_ == plan->arena_bytes) {
+      std::swap(base, free_arena_);
+    }
+  }
+  if (base == nullptr) {
+    AllocationAttributes attr;
+    attr.retry_on_failure = false;
+    base = allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                   plan->arena_bytes, attr);
+    // If the arena can not be allocated the step uses the fallback for all
+    // of its allocations.
+  }
+  const size_t arena_bytes = plan->arena_bytes;
+  return core::RefCountPtr<StepArena>(new StepArena(
+      this, StepArena::Mode::kServe, std::move(plan), base, arena_bytes));
+}
+
+size_t StepMemoryPlan::arena_bytes() const {
+  mutex_lock l(mu_);
+  return plan_ == nullptr ? 0 : plan_->arena_bytes;
+}
+
+int64_t StepMemoryPlan::num_planned_allocations() const {
+  mutex_lock l(mu_);
+  return plan_ == nullptr ? 0 : plan_->allocations.size();
+}
+
+// static
+std::shared_ptr<const StepMemoryPlan::Plan> StepMemoryPlan::BuildPlan(
+    int num_nodes, const std::vector<Record>& records) {
+  auto plan = std::make_shared<Plan>();
+  plan->node_allocations.resize(num_nodes);
+
+  // Only allocations that were freed during the step are planned.
+  std::vector<int> order;
+  for (int i = 0; i < records.size(); ++i) {
+    const Record& record = records[i];
+    if (record.last_tick >= 0) {
+      order.push_back(i);
+      continue;
+    }
+    std::vector<int>& node_allocations = plan->node_allocations[record.node_id];
+    if (node_allocations.size() <= record.index) {
+      node_allocations.resize(record.index + 1, kUnplanned);
+    }
+    node_allocations[record.index] = kEscaped;
+  }
+  // Place the largest allocations first, each at the lowest offset that does
+  // not overlap with an already placed allocation whose lifetime overlaps.
+  std::sort(order.begin(), order.end(), [&records](int a, int b) {
+    if (records[a].size != records[b].size) {
+      return records[a].size > records[b].size;
+    }
+    return records[a].first_tick < records[b].first_tick;
+  });
+
+  struct Placed {
+    size_t offset;
+    size_t size;
+    const Record* record;
+  };
+  // Sorted by offset.
+  std::vector<Placed> placed;
+  placed.reserve(order.size());
+  for (int r : order) {
+    const Record& record = records[r];
+    const size_t size = RoundUpToAlignment(record.size);
+    size_t offset = 0;
+    for (auto it = placed.begin(); it != placed.end(); ++it) {
+      const bool lifetimes_overlap =
+          it->record->first_tick <= record.last_tick &&
+          record.first_tick <= it->record->last_tick;
+      if (!lifetimes_overlap) {
+        continue;
+      }
+      if (offset + size <= it->offset) {
+        break;
+      }
+      offset = std::max(offset, it->offset + it->size);
+    }
+    auto insert_at = std::upper_bound(
+        placed.begin(), placed.end(), offset,
+        [](size_t offset, const Placed& p) { return offset < p.offset; });
+    placed.insert(insert_at, Placed{offset, size, &record});
+  }
+
+  plan->allocations.resize(placed.size());
+  for (int i = 0; i < placed.size(); ++i) {
+    const Placed& p = placed[i];
+    PlannedAllocation& allocation = plan->allocations[i];
+    allocation.offset = p.offset;
+    allocation.size = p.size;
+    plan->arena_bytes = std::max(plan->arena_bytes, p.offset + p.size);
+
+    std::vector<int>& node_allocations =
+        plan->node_allocations[p.record->node_id];
+    if (node_allocations.size() <= p.record->index) {
+      node_allocations.resize(p.record->index + 1, kUnplanned);
+    }
+    node_allocations[p.record->index] = i;
+
+    // `placed` is sorted by offset, so only the following allocations that
+    // start before this one ends can alias it.
+    for (int j = i + 1;
+         j < placed.size() && placed[j].offset < p.offset + p.size; ++j) {
+      allocation.aliases.push_back(j);
+    }
+  }
+  for (int i = 0; i < plan->allocations.size(); ++i) {
+    for (int j : plan->allocations[i].aliases) {
+      if (j > i) {
+        plan->allocations[j].aliases.push_back(i);
+      }
+    }
+  }
+  return plan;
+}
+
+void StepMemoryPlan::RecordingDone(std::shared_ptr<const Plan> plan) {
+  VLOG(1) << "Planned " << plan->allocations.size()
+          << " allocations in a step arena of "
+          << strings::HumanReadableNumBytes(plan->arena_bytes);
+  void* stale_arena = nullptr;
+  {
+    mutex_lock l(mu_);
+    plan_ = std::move(plan);
+    recording_ = false;
+    std::swap(stale_arena, free_arena_);
+  }
+  if (stale_arena != nullptr) {
+    allocator_->DeallocateRaw(stale_arena);
+  }
+}
+
+void StepMemoryPlan::RequestReplan() {
+  mutex_lock l(mu_);
+  needs_replan_ = true;
+}
+
+void StepMemoryPlan::ReleaseArena(void* base, size_t bytes) {
+  {
+    mutex_lock l(mu_);
+    if (free_arena_ == nullptr && plan_ != nullptr &&
+        plan_->arena_bytes == bytes) {
+      free_arena_ = base;
+      free_arena_bytes_ = bytes;
+      return;
+    }
+  }
+  allocator_->DeallocateRaw(base);
+}
+
+StepArena::StepArena(StepMemoryPlan* plan, Mode mode,
+                     std::shared_ptr<const StepMemoryPlan::Plan> step_plan,
+                     void* base, size_t arena_bytes)
+    : plan_(plan),
+      mode_(mode),
+      step_plan_(std::move(step_plan)),
+      base_(static_cast<char*>(base)),
+      arena_bytes_(arena_bytes) {
+  plan_->Ref();
+  if (mode_ == Mode::kPassthrough) {
+    return;
+  }
+  node_allocators_.reset(new NodeAllocator[plan_->num_nodes_]);
+  for (int i = 0; i < plan_->num_nodes_; ++i) {
+    node_allocators_[i].arena_ = this;
+    node_allocators_[i].node_id_ = i;
+  }
+  if (mode_ == Mode::kServe) {
+    const int num_allocations = step_plan_->allocations.size();
+    in_use_.reset(new std::atomic<bool>[num_allocations]);
+    for (int i = 0; i < num_allocations; ++i) {
+      in_use_[i].store(false, std::memory_order_relaxed);
+    }
+  }
+}
+
+StepArena::~StepArena() {
+  if (base_ != nullptr) {
+    plan_->ReleaseArena(base_, arena_bytes_);
+  }
+}
+
+Allocator* StepArena::ForNode(int node_id) {
+  switch (mode_) {
+    case Mode::kPassthrough:
+      return nullptr;
+    case Mode::kRecord:
+      return &node_allocators_[node_id];
+    case Mode::kServe:
+      return base_ == nullptr ||
+                     step_plan_->node_allocations[node_id].empty()
+                 ? nullptr
+                 : &node_allocators_[node_id];
+  }
+  return nullptr;
+}
+
+void StepArena::EndStep() {
+  if (mode_ == Mode::kRecord) {
+    std::vector<StepMemoryPlan::Record> records;
+    {
+      mutex_lock l(mu_);
+      step_done_ = true;
+      records.swap(records_);
+      live_records_.clear();
+    }
+    plan_->RecordingDone(
+        StepMemoryPlan::BuildPlan(plan_->num_nodes_, records));
+  } else if (mode_ == Mode::kServe) {
+    bool escaped = false;
+    for (int i = 0; i < step_plan_->allocations.size(); ++i) {
+      if (in_use_[i].load(std::memory_order_acquire)) {
+        escaped = true;
+        break;
+      }
+    }
+    if (escaped || grew_.load(std::memory_order_relaxed)) {
+      VLOG(1) << "Step arena allocations "
+              << (escaped ? "outlived the step" : "grew")
+              << "; scheduling a new memory plan.";
+      plan_->RequestReplan();
+    }
+  }
+}
+
+bool StepArena::TryAcquire(int i) {
+  // Announce the acquisition before checking the aliases, so that of two
+  // steps racing for overlapping memory at least one observes the other.
+  in_use_[i].store(true, std::memory_order_seq_cst);
+  for (int j : step_plan_->allocations[i].aliases) {
+    if (in_use_[j].load(std::memory_order_seq_cst)) {
+      in_use_[i].store(false, std::memory_order_release);
+      return false;
+    }
+  }
+  return true;
+}
+
+void* StepArena::Allocate(int node_id, int index, size_t alignment,
+                          size_t num_bytes,
+                          const AllocationAttributes& allocation_attr) {
+  if (mode_ == Mode::kServe) {
+    const std::vector<int>& node_allocations =
+        step_plan_->node_allocations[node_id];
+    const int i = index < node_allocations.size()
+                      ? node_allocations[index]
+                      : StepMemoryPlan::kUnplanned;
+    if (i == StepMemoryPlan::kEscaped) {
+      // Outlived the recording step, and is expected to outlive this one.
+    } else if (i < 0) {
+      grew_.store(true, std::memory_order_relaxed);
+    } else if (num_bytes > step_plan_->allocations[i].size) {
+      grew_.store(true, std::memory_order_relaxed);
+    } else if (alignment <= Allocator::kAllocatorAlignment && TryAcquire(i)) {
+      Ref();
+      return base_ + step_plan_->allocations[i].offset;
+    }
+  }
+
+  void* ptr =
+      plan_->allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  Ref();
+  if (mode_ == Mode::kRecord) {
+    mutex_lock l(mu_);
+    if (!step_done_) {
+      StepMemoryPlan::Record record;
+      record.node_id = node_id;
+      record.index = index;
+      record.size = num_bytes;
+      record.first_tick = clock_++;
+      live_records_[ptr] = records_.size();
+      records_.push_back(record);
+    }
+  }
+  return ptr;
+}
+
+void StepArena::Deallocate(int node_id, void* ptr) {
+  char* p = static_cast<char*>(ptr);
+  if (base_ != nullptr && p >= base_ && p < base_ + arena_bytes_) {
+    // Of the node's planned allocations at this offset, exactly one is in use.
+    bool released = false;
+    for (int i : step_plan_->node_allocations[node_id]) {
+      if (i >= 0 && base_ + step_plan_->allocations[i].offset == p &&
+          in_use_[i].load(std::memory_order_relaxed)) {
+        in_use_[i].store(false, std::memory_order_release);
+        released = true;
+        break;
+      }
+    }
+    CHECK(released) << "Deallocating a step arena pointer that is not in use";
+    Unref();
+    return;
+  }
+
+  if (mode_ == Mode::kRecord) {
+    mutex_lock l(mu_);
+    auto it = live_records_.find(ptr);
+    if (it != live_records_.end()) {
+      records_[it->second].last_tick = clock_++;
+      live_records_.erase(it);
+    }
+  }
+  plan_->allocator_->DeallocateRaw(ptr);
+  Unref();
+}
+
+void* StepArena::NodeAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const int index = next_index_.fetch_add(1, std::memory_order_relaxed);
+  return arena_->Allocate(node_id_, index, alignment, num_bytes,
+                          allocation_attr);
+}
+
+void StepArena::NodeAllocator::DeallocateRaw(void* ptr) {
+  arena_->Deallocate(node_id_, ptr);
+}
+
+}  // namespace tensorflow
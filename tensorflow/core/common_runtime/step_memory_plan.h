@@ -0,0 +1,210 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_MEMORY_PLAN_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+class StepArena;
+
+// A static memory plan for the intermediate tensors of one executor's graph,
+// in the style of TFLite's ArenaPlanner.
+//
+// The first step run with a plan records, for every node, the size and
+// lifetime of each allocation the node makes.  From these, the plan assigns
+// every allocation an offset in a single arena such that allocations whose
+// lifetimes overlapped never share memory.  Subsequent steps allocate one
+// arena from the device allocator and serve the recorded allocations from it,
+// replacing a malloc/free pair per intermediate with one per step.
+//
+// The schedule of a step is not deterministic, so before handing out planned
+// memory a step checks that no other live allocation shares it.  Allocations
+// that were not recorded, that grew, or whose memory is still in use fall back
+// to the device allocator.  Allocations that grew, or planned allocations
+// that outlived the step in which they were made, cause the next step to
+// record a new plan.  Allocations that outlive the recording step (e.g.
+// fetched outputs) are never planned, and do not cause a new plan when they
+// escape later steps too.
+//
+// This class is thread-safe.
+class StepMemoryPlan : public core::RefCounted {
+ public:
+  // 'allocator' backs the arenas and serves the fallback allocations.  It
+  // must outlive the plan and all allocations made through it.
+  StepMemoryPlan(Allocator* allocator, int num_nodes);
+  ~StepMemoryPlan() override;
+
+  // Returns the arena for a new step.  The executor must call
+  // StepArena::EndStep() once all nodes of the step have completed.
+  core::RefCountPtr<StepArena> BeginStep();
+
+  // Returns the size of the arena of the current plan, or 0 if there is none.
+  size_t arena_bytes() const;
+
+  // Returns the number of allocations served by the current plan.
+  int64_t num_planned_allocations() const;
+
+ private:
+  friend class StepArena;
+
+  // Sentinels in Plan::node_allocations.  Allocations that were not recorded
+  // cause a replan when they are seen; allocations that escaped the
+  // recording step always use the device allocator and do not.
+  static constexpr int kUnplanned = -1;
+  static constexpr int kEscaped = -2;
+
+  struct PlannedAllocation {
+    size_t offset = 0;
+    size_t size = 0;
+    // Planned allocations whose memory overlaps with this one.
+    std::vector<int> aliases;
+  };
+
+  // A plan is immutable once built, and shared by the steps using it.
+  struct Plan {
+    size_t arena_bytes = 0;
+    std::vector<PlannedAllocation> allocations;
+    // For each node, the index into `allocations` of the node's i-th
+    // allocation, kEscaped if it outlived the recording step, or kUnplanned
+    // if it was not recorded.
+    std::vector<std::vector<int>> node_allocations;
+  };
+
+  // An allocation observed by a recording step, with its lifetime expressed
+  // in ticks of the step's allocation clock.
+  struct Record {
+    int node_id = -1;
+    int index = -1;
+    size_t size = 0;
+    int64_t first_tick = 0;
+    int64_t last_tick = -1;  // -1 if still live at the end of the step.
+  };
+
+  // Builds a plan from the allocations of a recording step.
+  static std::shared_ptr<const Plan> BuildPlan(
+      int num_nodes, const std::vector<Record>& records);
+
+  void RecordingDone(std::shared_ptr<const Plan> plan);
+  void RequestReplan();
+
+  // Returns the memory of an arena once the step using it is done with it.
+  void ReleaseArena(void* base, size_t bytes);
+
+  Allocator* const allocator_;
+  const int num_nodes_;
+
+  mutable mutex mu_;
+  std::shared_ptr<const Plan> plan_ TF_GUARDED_BY(mu_);
+  bool recording_ TF_GUARDED_BY(mu_) = false;
+  bool needs_replan_ TF_GUARDED_BY(mu_) = true;
+  // An arena of the current plan's size that is not used by any step.
+  void* free_arena_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t free_arena_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepMemoryPlan);
+};
+
+// The memory of one step executed with a StepMemoryPlan.  Holds a reference
+// for each allocation it serves, so that it outlives tensors that escape the
+// step.
+class StepArena : public core::RefCounted {
+ public:
+  ~StepArena() override;
+
+  // Returns the allocator to use for allocations with default attributes made
+  // by node 'node_id', or nullptr to use the device allocator.
+  Allocator* ForNode(int node_id);
+
+  // Called once all nodes of the step have completed.
+  void EndStep();
+
+ private:
+  friend class StepMemoryPlan;
+
+  enum class Mode {
+    kPassthrough,  // Another step is recording; use the device allocator.
+    kRecord,
+    kServe,
+  };
+
+  class NodeAllocator : public Allocator {
+   public:
+    NodeAllocator() = default;
+
+    string Name() override { return "step_arena"; }
+    void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+      return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+    }
+    void* AllocateRaw(size_t alignment, size_t num_bytes,
+                      const AllocationAttributes& allocation_attr) override;
+    void DeallocateRaw(void* ptr) override;
+
+   private:
+    friend class StepArena;
+
+    StepArena* arena_ = nullptr;
+    int node_id_ = -1;
+    // The number of allocations made by the node during this step.
+    std::atomic<int> next_index_{0};
+  };
+
+  StepArena(StepMemoryPlan* plan, Mode mode,
+            std::shared_ptr<const StepMemoryPlan::Plan> step_plan, void* base,
+            size_t arena_bytes);
+
+  void* Allocate(int node_id, int index, size_t alignment, size_t num_bytes,
+                 const AllocationAttributes& allocation_attr);
+  void Deallocate(int node_id, void* ptr);
+
+  // Marks planned allocation 'i' as in use, unless memory it aliases is
+  // already in use.
+  bool TryAcquire(int i);
+
+  core::RefCountPtr<StepMemoryPlan> plan_;
+  const Mode mode_;
+  std::unique_ptr<NodeAllocator[]> node_allocators_;
+
+  // Serving state.
+  const std::shared_ptr<const StepMemoryPlan::Plan> step_plan_;
+  char* const base_;
+  const size_t arena_bytes_;
+  std::unique_ptr<std::atomic<bool>[]> in_use_;
+  std::atomic<bool> grew_{false};
+
+  // Recording state.
+  mutex mu_;
+  bool step_done_ TF_GUARDED_BY(mu_) = false;
+  int64_t clock_ TF_GUARDED_BY(mu_) = 0;
+  std::vector<StepMemoryPlan::Record> records_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<void*, int> live_records_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArena);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_MEMORY_PLAN_H_
@@ -0,0 +1,185 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_memory_plan.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kAlign = Allocator::kAllocatorAlignment;
+
+// Simulates a chain a -> b -> c in which each node allocates its output and
+// the output of a node is freed once its consumer has run.
+struct ChainStep {
+  void* a = nullptr;
+  void* b = nullptr;
+  void* c = nullptr;
+};
+
+ChainStep RunChain(StepMemoryPlan* plan, size_t bytes) {
+  core::RefCountPtr<StepArena> arena = plan->BeginStep();
+  ChainStep step;
+  Allocator* a0 = arena->ForNode(0);
+  Allocator* a1 = arena->ForNode(1);
+  Allocator* a2 = arena->ForNode(2);
+  Allocator* fallback = cpu_allocator();
+  Allocator* n0 = a0 ? a0 : fallback;
+  Allocator* n1 = a1 ? a1 : fallback;
+  Allocator* n2 = a2 ? a2 : fallback;
+  step.a = n0->AllocateRaw(kAlign, bytes);
+  step.b = n1->AllocateRaw(kAlign, bytes);
+  n0->DeallocateRaw(step.a);
+  step.c = n2->AllocateRaw(kAlign, bytes);
+  n1->DeallocateRaw(step.b);
+  n2->DeallocateRaw(step.c);
+  arena->EndStep();
+  return step;
+}
+
+TEST(StepMemoryPlanTest, PlansAndReusesArena) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/3));
+  EXPECT_EQ(plan->num_planned_allocations(), 0);
+
+  RunChain(plan.get(), 1000);
+  EXPECT_EQ(plan->num_planned_allocations(), 3);
+  // 'a' and 'c' have disjoint lifetimes and share memory.
+  EXPECT_EQ(plan->arena_bytes(), 2 * 1024);
+
+  ChainStep first = RunChain(plan.get(), 1000);
+  EXPECT_EQ(first.a, first.c);
+  EXPECT_NE(first.a, first.b);
+  // The arena of the previous step is reused.
+  ChainStep second = RunChain(plan.get(), 1000);
+  EXPECT_EQ(first.a, second.a);
+  EXPECT_EQ(first.b, second.b);
+}
+
+TEST(StepMemoryPlanTest, SmallerAllocationsUseThePlan) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/3));
+  RunChain(plan.get(), 1000);
+  ChainStep step = RunChain(plan.get(), 100);
+  EXPECT_EQ(step.a, step.c);
+  EXPECT_EQ(plan->arena_bytes(), 2 * 1024);
+}
+
+TEST(StepMemoryPlanTest, GrowingAllocationsFallBackAndReplan) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/3));
+  RunChain(plan.get(), 1000);
+  EXPECT_EQ(plan->arena_bytes(), 2 * 1024);
+
+  // Allocations larger than planned go to the fallback allocator, and the
+  // next step records a new plan.
+  ChainStep step = RunChain(plan.get(), 4000);
+  EXPECT_NE(step.a, nullptr);
+  EXPECT_EQ(plan->arena_bytes(), 2 * 1024);
+  RunChain(plan.get(), 4000);
+  EXPECT_EQ(plan->arena_bytes(), 2 * 4032);
+}
+
+TEST(StepMemoryPlanTest, AliasedMemoryInUseFallsBack) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/3));
+  RunChain(plan.get(), 1000);
+
+  // Run the chain with a different schedule in which 'a' is still live when
+  // 'c' is allocated.
+  core::RefCountPtr<StepArena> arena = plan->BeginStep();
+  Allocator* n0 = arena->ForNode(0);
+  Allocator* n1 = arena->ForNode(1);
+  Allocator* n2 = arena->ForNode(2);
+  void* a = n0->AllocateRaw(kAlign, 1000);
+  void* b = n1->AllocateRaw(kAlign, 1000);
+  void* c = n2->AllocateRaw(kAlign, 1000);
+  EXPECT_NE(a, c);
+  EXPECT_NE(b, c);
+  n0->DeallocateRaw(a);
+  n1->DeallocateRaw(b);
+  n2->DeallocateRaw(c);
+  arena->EndStep();
+}
+
+TEST(StepMemoryPlanTest, EscapingAllocationsKeepArenaAlive) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/3));
+  RunChain(plan.get(), 1000);
+
+  Tensor escaped;
+  {
+    core::RefCountPtr<StepArena> arena = plan->BeginStep();
+    escaped = Tensor(arena->ForNode(0), DT_FLOAT, TensorShape({250}));
+    escaped.flat<float>().setConstant(1.0f);
+    arena->EndStep();
+  }
+  // The escaped tensor still owns its memory, which the next step must not
+  // reuse.
+  ChainStep step = RunChain(plan.get(), 1000);
+  EXPECT_NE(step.a, escaped.data());
+  EXPECT_NE(step.b, escaped.data());
+  EXPECT_EQ(escaped.flat<float>()(249), 1.0f);
+}
+
+TEST(StepMemoryPlanTest, AllocationsOutlivingRecordingAreNotPlanned) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/1));
+  void* p;
+  Allocator* allocator;
+  {
+    core::RefCountPtr<StepArena> arena = plan->BeginStep();
+    allocator = arena->ForNode(0);
+    p = allocator->AllocateRaw(kAlign, 1000);
+    arena->EndStep();
+  }
+  EXPECT_EQ(plan->num_planned_allocations(), 0);
+  allocator->DeallocateRaw(p);
+}
+
+TEST(StepMemoryPlanTest, EscapingOutputsDoNotReplan) {
+  core::RefCountPtr<StepMemoryPlan> plan(
+      new StepMemoryPlan(cpu_allocator(), /*num_nodes=*/1));
+  // The node makes an output that is only freed once the step has ended,
+  // like a fetched tensor, and a temporary.  Returns the temporary.
+  auto run_step = [&plan]() {
+    core::RefCountPtr<StepArena> arena = plan->BeginStep();
+    Allocator* n0 = arena->ForNode(0);
+    void* output = n0->AllocateRaw(kAlign, 1000);
+    void* temp = n0->AllocateRaw(kAlign, 1000);
+    n0->DeallocateRaw(temp);
+    arena->EndStep();
+    n0->DeallocateRaw(output);
+    return temp;
+  };
+
+  run_step();
+  EXPECT_EQ(plan->num_planned_allocations(), 1);
+
+  // Both serve steps use the same arena.  Had the escaping output of the
+  // first one caused a replan, the second would be a recording step that
+  // allocates its temporary from the device allocator.
+  void* first_temp = run_step();
+  void* second_temp = run_step();
+  EXPECT_EQ(first_temp, second_temp);
+  EXPECT_EQ(plan->num_planned_allocations(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,197 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_stats_critical_path.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+
+const char* const kCriticalPathDevice = "/critical_path";
+
+namespace {
+
+struct NodeTimes {
+  int64_t start_micros = std::numeric_limits<int64_t>::max();
+  int64_t end_micros = std::numeric_limits<int64_t>::min();
+  int64_t slack_micros = 0;
+  bool visited = false;
+  std::vector<int> inputs;
+  std::vector<int> outputs;
+};
+
+}  // namespace
+
+Status AnalyzeCriticalPath(const GraphDef& graph, const StepStats& step_stats,
+                           CriticalPathAnalysis* analysis) {
+  *analysis = CriticalPathAnalysis();
+  absl::flat_hash_map<string, int> node_ids;
+  node_ids.reserve(graph.node_size());
+  for (int i = 0; i < graph.node_size(); ++i) {
+    node_ids.emplace(graph.node(i).name(), i);
+  }
+
+  std::vector<NodeTimes> nodes(graph.node_size());
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      auto it = node_ids.find(node_stats.node_name());
+      if (it == node_ids.end()) continue;
+      NodeTimes& node = nodes[it->second];
+      node.start_micros =
+          std::min(node.start_micros, node_stats.all_start_micros());
+      node.end_micros =
+          std::max(node.end_micros, node_stats.all_start_micros() +
+                                        node_stats.all_end_rel_micros());
+    }
+  }
+  auto executed = [&nodes](int id) {
+    return nodes[id].start_micros <= nodes[id].end_micros;
+  };
+
+  std::vector<int> executed_ids;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    if (!executed(i)) continue;
+    executed_ids.push_back(i);
+    for (const string& input : graph.node(i).input()) {
+      auto it = node_ids.find(string(ParseTensorName(input).node()));
+      if (it == node_ids.end() || !executed(it->second)) continue;
+      const int input_id = it->second;
+      if (nodes[input_id].start_micros > nodes[i].start_micros) continue;
+      nodes[i].inputs.push_back(input_id);
+      nodes[input_id].outputs.push_back(i);
+    }
+  }
+  if (executed_ids.empty()) {
+    return errors::InvalidArgument(
+        "The step stats don't contain any node of the graph.");
+  }
+
+  // Visits the nodes from the last one to end, so the slack of the consumers
+  // of each node is known before its own unless they overlap.
+  std::sort(executed_ids.begin(), executed_ids.end(), [&nodes](int a, int b) {
+    if (nodes[a].end_micros != nodes[b].end_micros) {
+      return nodes[a].end_micros > nodes[b].end_micros;
+    }
+    return nodes[a].start_micros > nodes[b].start_micros;
+  });
+  analysis->step_end_micros = nodes[executed_ids.front()].end_micros;
+  analysis->step_start_micros = std::numeric_limits<int64_t>::max();
+  int64_t total_micros = 0;
+  for (int id : executed_ids) {
+    NodeTimes& node = nodes[id];
+    int64_t latest_end_micros = analysis->step_end_micros;
+    for (int output : node.outputs) {
+      if (!nodes[output].visited) continue;
+      latest_end_micros =
+          std::min(latest_end_micros,
+                   nodes[output].start_micros + nodes[output].slack_micros);
+    }
+    node.slack_micros = std::max<int64_t>(latest_end_micros - node.end_micros,
+                                          0);
+    node.visited = true;
+    analysis->step_start_micros =
+        std::min(analysis->step_start_micros, node.start_micros);
+    total_micros += node.end_micros - node.start_micros;
+
+    CriticalPathAnalysis::NodeTiming timing;
+    timing.node_name = graph.node(id).name();
+    timing.start_micros = node.start_micros;
+    timing.end_micros = node.end_micros;
+    timing.slack_micros = node.slack_micros;
+    analysis->nodes.push_back(std::move(timing));
+  }
+  std::stable_sort(analysis->nodes.begin(), analysis->nodes.end(),
+                   [](const CriticalPathAnalysis::NodeTiming& a,
+                      const CriticalPathAnalysis::NodeTiming& b) {
+                     return a.slack_micros < b.slack_micros;
+                   });
+
+  // Walks back from the last node to end along the inputs that ended last.
+  // Inputs may start at the same time as their consumers, so the walk stops at
+  // the first node visited twice.
+  for (NodeTimes& node : nodes) node.visited = false;
+  for (int id = executed_ids.front(); id >= 0 && !nodes[id].visited;) {
+    nodes[id].visited = true;
+    analysis->critical_path.push_back(graph.node(id).name());
+    analysis->critical_path_micros +=
+        nodes[id].end_micros - nodes[id].start_micros;
+    int last_input = -1;
+    for (int input : nodes[id].inputs) {
+      if (last_input < 0 ||
+          nodes[input].end_micros > nodes[last_input].end_micros) {
+        last_input = input;
+      }
+    }
+    id = last_input;
+  }
+  std::reverse(analysis->critical_path.begin(), analysis->critical_path.end());
+
+  // Sweeps the start and end times of the nodes, ends before starts at equal
+  // times so that back to back nodes don't count as running concurrently.
+  std::vector<std::pair<int64_t, int>> events;
+  events.reserve(2 * executed_ids.size());
+  for (int id : executed_ids) {
+    events.emplace_back(nodes[id].start_micros, 1);
+    events.emplace_back(nodes[id].end_micros, -1);
+  }
+  std::sort(events.begin(), events.end());
+  int num_running = 0;
+  for (size_t i = 0; i < events.size();) {
+    const int64_t time_micros = events[i].first;
+    for (; i < events.size() && events[i].first == time_micros; ++i) {
+      num_running += events[i].second;
+    }
+    if (analysis->parallelism.empty() ||
+        analysis->parallelism.back().second != num_running) {
+      analysis->parallelism.emplace_back(time_micros, num_running);
+    }
+  }
+  const int64_t step_micros =
+      analysis->step_end_micros - analysis->step_start_micros;
+  if (step_micros > 0) {
+    analysis->average_parallelism =
+        static_cast<double>(total_micros) / step_micros;
+  }
+  return Status::OK();
+}
+
+void AddCriticalPathToStepStats(const CriticalPathAnalysis& analysis,
+                                StepStats* step_stats) {
+  absl::flat_hash_map<string, const CriticalPathAnalysis::NodeTiming*>
+      timings;
+  for (const CriticalPathAnalysis::NodeTiming& timing : analysis.nodes) {
+    timings.emplace(timing.node_name, &timing);
+  }
+  DeviceStepStats* device_stats = step_stats->add_dev_stats();
+  device_stats->set_device(kCriticalPathDevice);
+  for (const string& node_name : analysis.critical_path) {
+    const CriticalPathAnalysis::NodeTiming& timing = *timings.at(node_name);
+    const int64_t duration_micros = timing.end_micros - timing.start_micros;
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_node_name(node_name);
+    node_stats->set_all_start_micros(timing.start_micros);
+    node_stats->set_op_end_rel_micros(duration_micros);
+    node_stats->set_all_end_rel_micros(duration_micros);
+    node_stats->set_timeline_label(
+        absl::StrCat(node_name, " slack=", timing.slack_micros, "us"));
+  }
+}
+
+}  // namespace tensorflow
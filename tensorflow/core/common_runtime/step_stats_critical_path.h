@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_CRITICAL_PATH_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_CRITICAL_PATH_H_
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The critical path of a step, computed from the node timings recorded by a
+// StepStatsCollector and the edges of the executed graph.
+struct CriticalPathAnalysis {
+  struct NodeTiming {
+    string node_name;
+    int64_t start_micros = 0;
+    int64_t end_micros = 0;
+    // How long the node could have ended later without delaying the step,
+    // given the observed start times of its consumers. The slack includes the
+    // scheduling gaps between the node and its consumers, and is 0 when the
+    // node overlaps a consumer, e.g. in a loop.
+    int64_t slack_micros = 0;
+  };
+
+  int64_t step_start_micros = 0;
+  int64_t step_end_micros = 0;
+
+  // The nodes of the critical path in execution order, ending with the node
+  // that ended last. Each node is preceded by its input that ended last.
+  std::vector<string> critical_path;
+  // The time spent executing the nodes of the critical path.
+  int64_t critical_path_micros = 0;
+
+  // The executed nodes, sorted by increasing slack.
+  std::vector<NodeTiming> nodes;
+
+  // The number of nodes running from each time on, in increasing time order.
+  // Only the times at which the number changes are listed.
+  std::vector<std::pair<int64_t, int>> parallelism;
+  // The total execution time of the nodes divided by the step time.
+  double average_parallelism = 0.0;
+};
+
+// Computes the critical path of the step recorded in `step_stats`, which
+// executed `graph`. When a node executed several times, e.g. in a loop, its
+// executions are merged into one spanning all of them. Edges along which the
+// consumer started before the producer, e.g. loop back edges, are ignored.
+Status AnalyzeCriticalPath(const GraphDef& graph, const StepStats& step_stats,
+                           CriticalPathAnalysis* analysis);
+
+// Adds the critical path as a device named kCriticalPathDevice to
+// `step_stats`, so that it is displayed as its own row in the trace viewer.
+// The timeline label of each node records its slack.
+extern const char* const kCriticalPathDevice;
+void AddCriticalPathToStepStats(const CriticalPathAnalysis& analysis,
+                                StepStats* step_stats);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_CRITICAL_PATH_H_
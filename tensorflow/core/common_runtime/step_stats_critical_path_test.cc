@@ -0,0 +1,157 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_stats_critical_path.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// a -> {b, c} -> d, where b is slower than c.
+GraphDef DiamondGraph() {
+  GraphDef graph;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      R"pb(
+        node { name: "a" op: "Const" }
+        node { name: "b" op: "Square" input: "a" }
+        node { name: "c" op: "Square" input: "a:0" }
+        node { name: "d" op: "AddV2" input: "b" input: "c" input: "^a" }
+      )pb",
+      &graph));
+  return graph;
+}
+
+void AddNodeStats(const string& name, int64_t start_micros,
+                  int64_t end_micros, DeviceStepStats* device_stats) {
+  NodeExecStats* node_stats = device_stats->add_node_stats();
+  node_stats->set_node_name(name);
+  node_stats->set_all_start_micros(start_micros);
+  node_stats->set_all_end_rel_micros(end_micros - start_micros);
+}
+
+StepStats DiamondStepStats() {
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  device_stats->set_device("/device:CPU:0");
+  AddNodeStats("a", 0, 10, device_stats);
+  AddNodeStats("b", 10, 40, device_stats);
+  AddNodeStats("c", 12, 20, device_stats);
+  AddNodeStats("d", 40, 50, device_stats);
+  return step_stats;
+}
+
+TEST(StepStatsCriticalPathTest, Diamond) {
+  CriticalPathAnalysis analysis;
+  TF_ASSERT_OK(
+      AnalyzeCriticalPath(DiamondGraph(), DiamondStepStats(), &analysis));
+  EXPECT_EQ(analysis.step_start_micros, 0);
+  EXPECT_EQ(analysis.step_end_micros, 50);
+  EXPECT_EQ(analysis.critical_path, std::vector<string>({"a", "b", "d"}));
+  EXPECT_EQ(analysis.critical_path_micros, 50);
+
+  ASSERT_EQ(analysis.nodes.size(), 4);
+  EXPECT_EQ(analysis.nodes.back().node_name, "c");
+  EXPECT_EQ(analysis.nodes.back().slack_micros, 20);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(analysis.nodes[i].slack_micros, 0);
+  }
+
+  EXPECT_EQ(analysis.parallelism,
+            (std::vector<std::pair<int64_t, int>>(
+                {{0, 1}, {12, 2}, {20, 1}, {50, 0}})));
+  EXPECT_DOUBLE_EQ(analysis.average_parallelism, 58.0 / 50);
+}
+
+TEST(StepStatsCriticalPathTest, SlackIncludesSchedulingGaps) {
+  GraphDef graph;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      R"pb(
+        node { name: "a" op: "Const" }
+        node { name: "b" op: "Square" input: "a" }
+      )pb",
+      &graph));
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  AddNodeStats("a", 0, 10, device_stats);
+  AddNodeStats("b", 15, 20, device_stats);
+  // Not part of the graph.
+  AddNodeStats("_SOURCE", 0, 100, device_stats);
+
+  CriticalPathAnalysis analysis;
+  TF_ASSERT_OK(AnalyzeCriticalPath(graph, step_stats, &analysis));
+  EXPECT_EQ(analysis.critical_path, std::vector<string>({"a", "b"}));
+  EXPECT_EQ(analysis.critical_path_micros, 15);
+  ASSERT_EQ(analysis.nodes.size(), 2);
+  EXPECT_EQ(analysis.nodes[0].node_name, "b");
+  EXPECT_EQ(analysis.nodes[0].slack_micros, 0);
+  EXPECT_EQ(analysis.nodes[1].node_name, "a");
+  EXPECT_EQ(analysis.nodes[1].slack_micros, 5);
+}
+
+TEST(StepStatsCriticalPathTest, MergesLoopIterations) {
+  GraphDef graph;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      R"pb(
+        node { name: "merge" op: "Merge" input: "enter" input: "next" }
+        node { name: "body" op: "Square" input: "merge" }
+        node { name: "next" op: "NextIteration" input: "body" }
+        node { name: "enter" op: "Enter" }
+      )pb",
+      &graph));
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  AddNodeStats("enter", 0, 1, device_stats);
+  AddNodeStats("merge", 1, 2, device_stats);
+  AddNodeStats("body", 2, 5, device_stats);
+  AddNodeStats("next", 5, 6, device_stats);
+  AddNodeStats("merge", 6, 7, device_stats);
+  AddNodeStats("body", 7, 10, device_stats);
+
+  CriticalPathAnalysis analysis;
+  TF_ASSERT_OK(AnalyzeCriticalPath(graph, step_stats, &analysis));
+  // The back edge from next to merge is ignored, since merge started before
+  // next once merged.
+  EXPECT_EQ(analysis.critical_path,
+            std::vector<string>({"enter", "merge", "body"}));
+  EXPECT_EQ(analysis.step_end_micros, 10);
+  EXPECT_EQ(analysis.nodes[0].slack_micros, 0);
+}
+
+TEST(StepStatsCriticalPathTest, NoExecutedNodes) {
+  CriticalPathAnalysis analysis;
+  EXPECT_FALSE(
+      AnalyzeCriticalPath(DiamondGraph(), StepStats(), &analysis).ok());
+}
+
+TEST(StepStatsCriticalPathTest, AddCriticalPathToStepStats) {
+  StepStats step_stats = DiamondStepStats();
+  CriticalPathAnalysis analysis;
+  TF_ASSERT_OK(AnalyzeCriticalPath(DiamondGraph(), step_stats, &analysis));
+  AddCriticalPathToStepStats(analysis, &step_stats);
+
+  ASSERT_EQ(step_stats.dev_stats_size(), 2);
+  const DeviceStepStats& device_stats = step_stats.dev_stats(1);
+  EXPECT_EQ(device_stats.device(), kCriticalPathDevice);
+  ASSERT_EQ(device_stats.node_stats_size(), 3);
+  EXPECT_EQ(device_stats.node_stats(1).node_name(), "b");
+  EXPECT_EQ(device_stats.node_stats(1).all_start_micros(), 10);
+  EXPECT_EQ(device_stats.node_stats(1).all_end_rel_micros(), 30);
+  EXPECT_EQ(device_stats.node_stats(1).timeline_label(), "b slack=0us");
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <algorithm>
 #include <limits>
 
+#include "zlib.h"
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/platform/snappy.h"
@@ -23,6 +26,46 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+// The initial size by which the output of a message stream grows.
+constexpr size_t kMinStreamOutputChunkSize = 256;
+
+Status ZlibError(absl::string_view operation, int error_code,
+                 const z_stream& stream) {
+  return errors::DataLoss("Failed to ", operation, " message stream: ",
+                          stream.msg ? stream.msg : "", " (zlib error ",
+                          error_code, ")");
+}
+
+// Runs `fn` (`deflate` or `inflate`) with `Z_SYNC_FLUSH` over `input`,
+// appending to `output` until all output is produced.
+template <typename Fn>
+Status RunZlibStream(Fn fn, absl::string_view operation, size_t chunk_size,
+                     absl::string_view input, z_stream& stream,
+                     std::string* output) {
+  output->clear();
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  chunk_size = std::max(chunk_size, kMinStreamOutputChunkSize);
+  do {
+    const size_t offset = output->size();
+    output->resize(offset + chunk_size);
+    stream.next_out = reinterpret_cast<Bytef*>(&(*output)[offset]);
+    stream.avail_out = chunk_size;
+    const int error_code = fn(&stream, Z_SYNC_FLUSH);
+    // `Z_BUF_ERROR` only means that no progress was possible, e.g. because the
+    // previous call filled the output exactly.
+    if (error_code != Z_OK && error_code != Z_BUF_ERROR) {
+      return ZlibError(operation, error_code, stream);
+    }
+    output->resize(offset + chunk_size - stream.avail_out);
+    chunk_size *= 2;
+  } while (stream.avail_in > 0 || stream.avail_out == 0);
+  return Status::OK();
+}
+
+}  // namespace
 
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out) {
@@ -161,5 +204,55 @@ Status UncompressElement(const CompressedElement& compressed,
   return Status::OK();
 }
 
+MessageStreamCompressor::MessageStreamCompressor()
+    : stream_(absl::make_unique<z_stream_s>()) {}
+
+MessageStreamCompressor::~MessageStreamCompressor() {
+  if (initialized_) {
+    deflateEnd(stream_.get());
+  }
+}
+
+Status MessageStreamCompressor::Compress(absl::string_view input,
+                                         std::string* output) {
+  if (!initialized_) {
+    *stream_ = {};
+    const int error_code =
+        deflateInit2(stream_.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     /*windowBits=*/MAX_WBITS, /*memLevel=*/8,
+                     Z_DEFAULT_STRATEGY);
+    if (error_code != Z_OK) {
+      return ZlibError("initialize compression of", error_code, *stream_);
+    }
+    initialized_ = true;
+  }
+  return RunZlibStream(deflate, "compress", input.size() / 2, input, *stream_,
+                       output);
+}
+
+MessageStreamUncompressor::MessageStreamUncompressor()
+    : stream_(absl::make_unique<z_stream_s>()) {}
+
+MessageStreamUncompressor::~MessageStreamUncompressor() {
+  if (initialized_) {
+    inflateEnd(stream_.get());
+  }
+}
+
+Status MessageStreamUncompressor::Uncompress(absl::string_view input,
+                                             std::string* output) {
+  if (!initialized_) {
+    *stream_ = {};
+    const int error_code =
+        inflateInit2(stream_.get(), /*windowBits=*/MAX_WBITS);
+    if (error_code != Z_OK) {
+      return ZlibError("initialize uncompression of", error_code, *stream_);
+    }
+    initialized_ = true;
+  }
+  return RunZlibStream(inflate, "uncompress", input.size() * 4, input,
+                       *stream_, output);
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -15,10 +15,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_COMPRESSION_UTILS_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_COMPRESSION_UTILS_H_
 
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/platform/status.h"
 
+struct z_stream_s;
+
 namespace tensorflow {
 namespace data {
 
@@ -35,6 +41,38 @@ Status CompressElement(const std::vector<Tensor>& element,
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
 
+// Compresses a sequence of messages as one zlib stream, flushing the stream
+// after each message. Each message is compressed with the earlier messages of
+// the stream as a dictionary, so a stream of small, similar messages compresses
+// much better than the messages do on their own. The messages must be
+// uncompressed in order by a single `MessageStreamUncompressor`.
+class MessageStreamCompressor {
+ public:
+  MessageStreamCompressor();
+  ~MessageStreamCompressor();
+
+  // Compresses the next message of the stream into `output`.
+  Status Compress(absl::string_view input, std::string* output);
+
+ private:
+  std::unique_ptr<z_stream_s> stream_;
+  bool initialized_ = false;
+};
+
+// Uncompresses the messages written by a `MessageStreamCompressor`.
+class MessageStreamUncompressor {
+ public:
+  MessageStreamUncompressor();
+  ~MessageStreamUncompressor();
+
+  // Uncompresses the next message of the stream into `output`.
+  Status Uncompress(absl::string_view input, std::string* output);
+
+ private:
+  std::unique_ptr<z_stream_s> stream_;
+  bool initialized_ = false;
+};
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/platform/test.h"
@@ -49,5 +50,49 @@ std::vector<std::vector<Tensor>> TestCases() {
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
+TEST(MessageStreamCompressionTest, RoundTrip) {
+  MessageStreamCompressor compressor;
+  MessageStreamUncompressor uncompressor;
+  for (int i = 0; i < 100; ++i) {
+    const std::string message =
+        absl::StrCat("message ", i, std::string(i * 100, 'x'));
+    std::string compressed;
+    TF_ASSERT_OK(compressor.Compress(message, &compressed));
+    std::string uncompressed;
+    TF_ASSERT_OK(uncompressor.Uncompress(compressed, &uncompressed));
+    EXPECT_EQ(uncompressed, message);
+  }
+}
+
+TEST(MessageStreamCompressionTest, EmptyMessage) {
+  MessageStreamCompressor compressor;
+  MessageStreamUncompressor uncompressor;
+  std::string compressed;
+  TF_ASSERT_OK(compressor.Compress("", &compressed));
+  std::string uncompressed = "stale";
+  TF_ASSERT_OK(uncompressor.Uncompress(compressed, &uncompressed));
+  EXPECT_EQ(uncompressed, "");
+}
+
+TEST(MessageStreamCompressionTest, UsesEarlierMessagesAsDictionary) {
+  std::string message;
+  for (int i = 0; i < 64; ++i) {
+    absl::StrAppend(&message, i * 7919 % 1000, ",");
+  }
+  MessageStreamCompressor compressor;
+  std::string first_compressed;
+  TF_ASSERT_OK(compressor.Compress(message, &first_compressed));
+  std::string second_compressed;
+  TF_ASSERT_OK(compressor.Compress(message, &second_compressed));
+  EXPECT_LT(second_compressed.size(), first_compressed.size() / 4);
+}
+
+TEST(MessageStreamCompressionTest, CorruptedInput) {
+  MessageStreamUncompressor uncompressor;
+  std::string uncompressed;
+  EXPECT_FALSE(
+      uncompressor.Uncompress("not a zlib stream", &uncompressed).ok());
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -40,8 +40,10 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/util/determinism.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -434,6 +436,23 @@ bool MatchesAnyVersion(StringPiece op_prefix, StringPiece op_to_match) {
   return (op_to_match[index] == 'V') && (op_prefix.length() == index);
 }
 
+int GetNumaNode(const DeviceAttributes& attributes) {
+  bool numa_aware = false;
+  Status s = ReadBoolFromEnvVar("TF_DATA_NUMA_AWARE", false, &numa_aware);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return port::kNUMANoAffinity;
+  }
+  if (!numa_aware || !port::NUMAEnabled() || port::NUMANumNodes() < 2) {
+    return port::kNUMANoAffinity;
+  }
+  const int numa_node = attributes.locality().numa_node();
+  if (numa_node < 0 || numa_node >= port::NUMANumNodes()) {
+    return port::kNUMANoAffinity;
+  }
+  return numa_node;
+}
+
 absl::flat_hash_set<string> GetExperiments() {
   return GetExperiments(port::JobName(),
                         [](const tstring& str) { return Hash64(str); });
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -354,6 +355,12 @@ bool ShouldApplyOptimizations(
     const absl::flat_hash_set<tstring>& optimizations_enabled,
     const absl::flat_hash_set<tstring>& optimizations_default);
 
+// Returns the NUMA node nearest to the device described by `attributes`, on
+// which the threads and buffers of the input pipelines iterated on the device
+// are placed, or `port::kNUMANoAffinity` if the TF_DATA_NUMA_AWARE environment
+// variable is not set or the host has a single NUMA node.
+int GetNumaNode(const DeviceAttributes& attributes);
+
 // Returns the default CPU budget.
 inline int GetCpuBudget() {
   static bool in_experiment = GetExperiments().contains("tune_cpu_budget");
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def_builder.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -610,6 +612,21 @@ INSTANTIATE_TEST_SUITE_P(
 
 REGISTER_DATASET_EXPERIMENT("test_only_experiment", 42);
 
+TEST(DatasetUtilsTest, GetNumaNode) {
+  DeviceAttributes attributes;
+  attributes.mutable_locality()->set_numa_node(1);
+  unsetenv("TF_DATA_NUMA_AWARE");
+  EXPECT_EQ(GetNumaNode(attributes), port::kNUMANoAffinity);
+
+  setenv("TF_DATA_NUMA_AWARE", "true", /*overwrite=*/1);
+  const bool numa_host = port::NUMAEnabled() && port::NUMANumNodes() > 1;
+  EXPECT_EQ(GetNumaNode(attributes), numa_host ? 1 : port::kNUMANoAffinity);
+  // Nodes the host does not have are ignored.
+  attributes.mutable_locality()->set_numa_node(port::NUMANumNodes());
+  EXPECT_EQ(GetNumaNode(attributes), port::kNUMANoAffinity);
+  unsetenv("TF_DATA_NUMA_AWARE");
+}
+
 TEST(DatasetUtilsTest, DatasetExperimentRegistry) {
   auto experiments = DatasetExperimentRegistry::Experiments();
   EXPECT_TRUE(experiments.find("test_only_experiment") != experiments.end());
@@ -15,11 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/data/root_dataset.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/hash_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/rewrite_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -34,6 +42,7 @@ constexpr char kGradientDescent[] = "gradient_descent";
 constexpr char kIntraOpParallelism[] = "intra_op_parallelism";
 constexpr char kPrivateThreadpoolSize[] = "threadpool_size";
 constexpr char kMemBandwidth[] = "mem_bw_used_megabytes_per_sec";
+constexpr char kTunedParameters[] = "tuned_parameters";
 
 // Default share of available RAM that can be used by model's internal buffers.
 constexpr double kRamBudgetShare = 0.5;
@@ -43,10 +52,50 @@ inline int64_t value_or_default(int64_t x, int64_t y, int64_t z) {
   return x == y ? z : x;
 }
 
+#if !defined(IS_MOBILE_PLATFORM)
+// Returns the file of TF_DATA_AUTOTUNE_STATE_DIR in which the tuned parameters
+// of `input` are saved, and sets `fingerprint` to the fingerprint of `input`.
+// Returns an empty string if the directory is not set.
+string AutotuneStateFilename(OpKernelContext* ctx, const DatasetBase* input,
+                             uint64* fingerprint) {
+  string dir;
+  Status s = ReadStringFromEnvVar("TF_DATA_AUTOTUNE_STATE_DIR", "", &dir);
+  if (!s.ok()) LOG(ERROR) << s;
+  if (dir.empty()) return "";
+
+  // The tuned parameters do not depend on the values of the elements, so
+  // external state is ignored.
+  GraphDef graph_def;
+  SerializationContext::Params params(ctx);
+  std::vector<std::pair<string, Tensor>> input_list;
+  params.input_list = &input_list;
+  params.external_state_policy =
+      SerializationContext::ExternalStatePolicy::kIgnore;
+  s = AsGraphDef(ctx, input, SerializationContext(params), &graph_def);
+  if (s.ok()) s = HashGraph(graph_def, fingerprint);
+  if (!s.ok()) {
+    VLOG(1) << "Not saving the tuned parameters of " << input->DebugString()
+            << ": " << s;
+    return "";
+  }
+  return io::JoinPath(dir,
+                      strings::StrCat("autotune_", strings::Hex(*fingerprint)));
+}
+#endif  // !IS_MOBILE_PLATFORM
+
 }  // namespace
 
 // static
 Status RootDataset::FromOptions(DatasetBase* input, DatasetBase** output) {
+  return FromOptions(input, /*autotune_state_file=*/"",
+                     /*autotune_state_fingerprint=*/0, output);
+}
+
+// static
+Status RootDataset::FromOptions(DatasetBase* input,
+                                const string& autotune_state_file,
+                                uint64 autotune_state_fingerprint,
+                                DatasetBase** output) {
   const Options& options = input->options();
   Params params;
   if (ShouldConfigureMaxIntraOpParallelism(options)) {
@@ -65,6 +114,8 @@ Status RootDataset::FromOptions(DatasetBase* input, DatasetBase** output) {
     params.autotune_ram_budget =
         value_or_default(options.autotune_options().ram_budget(), 0,
                          kRamBudgetShare * port::AvailableRam());
+    params.autotune_state_file = autotune_state_file;
+    params.autotune_state_fingerprint = autotune_state_fingerprint;
   }
   *output = new RootDataset(input, params);
   return Status::OK();
@@ -82,20 +133,35 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
           value_or_default(dataset()->params_.max_intra_op_parallelism, 0,
                            port::MaxParallelism());
     }
-    if (dataset()->params_.private_threadpool_size >= 0) {
-      threadpool_size_ =
-          value_or_default(dataset()->params_.private_threadpool_size, 0,
-                           port::MaxParallelism());
-      thread_pool_ = absl::make_unique<thread::ThreadPool>(
-          Env::Default(), ThreadOptions{}, "data_private_threadpool",
-          threadpool_size_);
-    }
     cancellation_manager_ = absl::make_unique<CancellationManager>();
   }
 
   ~Iterator() override { cancellation_manager_->StartCancel(); }
 
   Status Initialize(IteratorContext* ctx) override {
+    if (dataset()->params_.private_threadpool_size >= 0) {
+      // The threads of NUMA-aware input pipelines are pinned to the NUMA node
+      // of the device, so only its CPUs are available.
+      ThreadOptions thread_options;
+      thread_options.numa_node = ctx->numa_node();
+      threadpool_size_ =
+          value_or_default(dataset()->params_.private_threadpool_size, 0,
+                           port::MaxParallelism(ctx->numa_node()));
+      thread_pool_ = absl::make_unique<thread::ThreadPool>(
+          Env::Default(), thread_options, "data_private_threadpool",
+          threadpool_size_);
+    }
+    // The tuned parameters are set before the input iterators are created, so
+    // that these start at the tuned values.
+    if (model_ && !dataset()->params_.autotune_state_file.empty()) {
+      Status s = model_->SetTunedParametersFile(
+          dataset()->params_.autotune_state_file,
+          dataset()->params_.autotune_state_fingerprint);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to warm-start autotuning from "
+                     << dataset()->params_.autotune_state_file << ": " << s;
+      }
+    }
     return dataset()->input_->MakeIterator(IteratorContext(CreateParams(ctx)),
                                            this, prefix(), &input_impl_);
   }
@@ -117,12 +183,29 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
 
   Status SaveInternal(SerializationContext* ctx,
                       IteratorStateWriter* writer) override {
+    // Saves the tuned parameters, so that autotuning of the restored iterator
+    // does not start from scratch.
+    if (model_) {
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(kTunedParameters),
+          model_->GetTunedParameters().SerializeAsString()));
+    }
     TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
     return Status::OK();
   }
 
   Status RestoreInternal(IteratorContext* ctx,
                          IteratorStateReader* reader) override {
+    if (model_ && reader->Contains(full_name(kTunedParameters))) {
+      tstring serialized;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kTunedParameters), &serialized));
+      model::TunedParametersProto tuned;
+      if (!tuned.ParseFromString(serialized)) {
+        return errors::DataLoss("Failed to parse the tuned parameters.");
+      }
+      model_->SetTunedParameters(tuned);
+    }
     TF_RETURN_IF_ERROR(
         RestoreInput(IteratorContext(CreateParams(ctx)), reader, input_impl_));
     return Status::OK();
@@ -162,10 +245,17 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
   Status EnsureModelThreadStarted(IteratorContext* ctx) {
     mutex_lock l(mu_);
     if (!model_thread_) {
-      model_thread_ = ctx->StartThread("tf_data_model", [this]() {
+      int64_t cpu_budget = dataset()->params_.autotune_cpu_budget;
+      if (ctx->numa_node() != port::kNUMANoAffinity) {
+        // The autotuner models the CPUs of the NUMA node the pipeline is
+        // pinned to.
+        cpu_budget = std::min<int64_t>(
+            cpu_budget, port::MaxParallelism(ctx->numa_node()));
+      }
+      model_thread_ = ctx->StartThread("tf_data_model", [this, cpu_budget]() {
         Status status =
             model_->OptimizeLoop(dataset()->params_.autotune_algorithm,
-                                 dataset()->params_.autotune_cpu_budget,
+                                 cpu_budget,
                                  dataset()->params_.autotune_ram_budget,
                                  cancellation_manager_.get());
         if (!status.ok()) {
@@ -280,8 +370,18 @@ Status FinalizeDataset(OpKernelContext* ctx, DatasetBase* input,
   auto optimizations =
       SelectOptimizations(experiments, optimizations_enabled,
                           optimizations_disabled, optimizations_default);
+
+  // The fingerprint of the input is taken before the graph rewrites, which
+  // are deterministic.
+  string autotune_state_file;
+  uint64 autotune_state_fingerprint = 0;
+  if (ShouldUseAutotuning(options)) {
+    autotune_state_file =
+        AutotuneStateFilename(ctx, input, &autotune_state_fingerprint);
+  }
   if (optimizations.empty()) {
-    return RootDataset::FromOptions(input, output);
+    return RootDataset::FromOptions(input, autotune_state_file,
+                                    autotune_state_fingerprint, output);
   }
 
   auto optimization_configs = CreateGraphRewriteConfigs(options);
@@ -294,13 +394,15 @@ Status FinalizeDataset(OpKernelContext* ctx, DatasetBase* input,
     // Ignore DeadlineExceeded as it implies that the attempted rewrite took too
     // long which should not prevent further computation.
     LOG(WARNING) << s.ToString();
-    return RootDataset::FromOptions(input, output);
+    return RootDataset::FromOptions(input, autotune_state_file,
+                                    autotune_state_fingerprint, output);
   }
   if (!s.ok()) {
     return s;
   }
   input = *output;
-  TF_RETURN_IF_ERROR(RootDataset::FromOptions(input, output));
+  TF_RETURN_IF_ERROR(RootDataset::FromOptions(
+      input, autotune_state_file, autotune_state_fingerprint, output));
   input->Unref();
   return Status::OK();
 }
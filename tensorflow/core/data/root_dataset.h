@@ -33,10 +33,21 @@ class RootDataset : public DatasetBase {
     int64_t autotune_ram_budget = 0;
     int64_t max_intra_op_parallelism = 1;
     int64_t private_threadpool_size = 0;
+    // File from which autotuning is warm-started and to which the tuned
+    // parameters are saved, if any, and the fingerprint of the input.
+    string autotune_state_file;
+    uint64 autotune_state_fingerprint = 0;
   };
 
   static Status FromOptions(DatasetBase* input, DatasetBase** output);
 
+  // Same as above, additionally warm-starting autotuning from
+  // `autotune_state_file` if it is not empty.
+  static Status FromOptions(DatasetBase* input,
+                            const string& autotune_state_file,
+                            uint64 autotune_state_fingerprint,
+                            DatasetBase** output);
+
   ~RootDataset() override;
 
   const DataTypeVector& output_dtypes() const override;
@@ -68,6 +79,11 @@ class RootDataset : public DatasetBase {
 // dataset is about to be iterated. This can for instance apply static graph
 // optimizations or inject internal tf.data transformations responsible for
 // autotuning or threading configuration.
+//
+// If TF_DATA_AUTOTUNE_STATE_DIR is set, the tuned parameters of autotuned
+// input pipelines are saved to that directory, keyed by the fingerprint of the
+// input, and input pipelines with the same fingerprint start autotuning from
+// them, e.g. after the job restarts.
 Status FinalizeDataset(OpKernelContext* ctx, DatasetBase* input,
                        DatasetBase** output);
 
@@ -0,0 +1,148 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/auto_scaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+// The weight of a new report in the smoothed metrics.
+constexpr double kSmoothingFactor = 0.5;
+// Consumers waiting longer than this fraction of the time are input bound.
+constexpr double kInputBoundWaitFraction = 0.05;
+// Caps the growth of a job per decision.
+constexpr int64_t kMaxGrowthFactor = 10;
+// Buffers fuller than this on average mean that the workers outpace the
+// consumers.
+constexpr double kFullBufferFullness = 0.9;
+
+void Smooth(double value, bool is_new, double& smoothed) {
+  smoothed = is_new ? value : smoothed + kSmoothingFactor * (value - smoothed);
+}
+
+mutex* get_lock() {
+  static mutex lock(LINKER_INITIALIZED);
+  return &lock;
+}
+
+using AutoScalerHooks = std::unordered_map<std::string, AutoScalerHook*>;
+AutoScalerHooks& auto_scaler_hooks() {
+  static auto& hooks = *new AutoScalerHooks();
+  return hooks;
+}
+}  // namespace
+
+void AutoScaler::ReportConsumerWaitTime(int64_t job_id, int64_t job_client_id,
+                                        int64_t wait_time_usec,
+                                        int64_t interval_usec) {
+  if (interval_usec <= 0) {
+    return;
+  }
+  const double fraction = std::min(
+      std::max(static_cast<double>(wait_time_usec) / interval_usec, 0.0), 1.0);
+  auto inserted = jobs_[job_id].wait_fractions.emplace(job_client_id, 0.0);
+  Smooth(fraction, inserted.second, inserted.first->second);
+}
+
+void AutoScaler::ReportBufferFullness(int64_t job_id,
+                                      absl::string_view worker_address,
+                                      double fullness) {
+  auto inserted = jobs_[job_id].buffer_fullness.emplace(
+      std::string(worker_address), 0.0);
+  Smooth(std::min(std::max(fullness, 0.0), 1.0), inserted.second,
+         inserted.first->second);
+}
+
+void AutoScaler::RemoveConsumer(int64_t job_id, int64_t job_client_id) {
+  auto it = jobs_.find(job_id);
+  if (it != jobs_.end()) {
+    it->second.wait_fractions.erase(job_client_id);
+  }
+}
+
+void AutoScaler::RemoveJob(int64_t job_id) { jobs_.erase(job_id); }
+
+int64_t AutoScaler::GetTargetNumWorkers(int64_t job_id,
+                                        int64_t num_workers) const {
+  auto it = jobs_.find(job_id);
+  if (it == jobs_.end()) {
+    return num_workers;
+  }
+  const JobMetrics& metrics = it->second;
+  // Synchronous training steps wait for the slowest consumer.
+  double wait_fraction = 0.0;
+  for (const auto& consumer : metrics.wait_fractions) {
+    wait_fraction = std::max(wait_fraction, consumer.second);
+  }
+  if (wait_fraction > kInputBoundWaitFraction) {
+    // With the current rate per worker, the consumers would not wait with
+    // `num_workers / (1 - wait_fraction)` workers.
+    const double target = std::ceil(static_cast<double>(num_workers) /
+                                    (1.0 - wait_fraction));
+    if (target >= kMaxGrowthFactor * num_workers) {
+      return std::max<int64_t>(kMaxGrowthFactor * num_workers, 1);
+    }
+    return std::max(static_cast<int64_t>(target), num_workers + 1);
+  }
+  if (num_workers <= 1 || metrics.buffer_fullness.empty()) {
+    return num_workers;
+  }
+  double fullness = 0.0;
+  for (const auto& worker : metrics.buffer_fullness) {
+    fullness += worker.second;
+  }
+  fullness /= metrics.buffer_fullness.size();
+  // Scales down one worker at a time, since full buffers don't tell by how
+  // much the workers outpace the consumers.
+  return fullness >= kFullBufferFullness ? num_workers - 1 : num_workers;
+}
+
+void AutoScalerHook::Register(AutoScalerHook* hook) {
+  mutex_lock l(*get_lock());
+  if (!auto_scaler_hooks().insert({hook->Name(), hook}).second) {
+    LOG(ERROR) << "Two auto-scaler hooks are being registered with name "
+               << hook->Name() << ". Which one gets used is undefined.";
+  }
+}
+
+Status AutoScalerHook::Get(absl::string_view name, AutoScalerHook*& out) {
+  mutex_lock l(*get_lock());
+  auto it = auto_scaler_hooks().find(std::string(name));
+  if (it != auto_scaler_hooks().end()) {
+    out = it->second;
+    return Status::OK();
+  }
+  std::vector<std::string> available_names;
+  for (const auto& hook : auto_scaler_hooks()) {
+    available_names.push_back(hook.first);
+  }
+  return errors::NotFound("No auto-scaler hook has been registered as ", name,
+                          ". The available hooks are: [ ",
+                          absl::StrJoin(available_names, ", "), " ]");
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,103 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_AUTO_SCALER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_AUTO_SCALER_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// Computes the number of workers each job needs from the demand of its
+// consumers. Consumers report the fraction of time they wait for elements, and
+// workers report how full the buffers of the job's tasks are:
+//  - When some consumer waits for elements, the job is input bound, and gets
+//    the workers that would remove the wait at the current rate per worker.
+//  - When no consumer waits and the buffers of the tasks are full, the workers
+//    produce faster than the consumers read, and the job can do with one
+//    worker less.
+//
+// The metrics are smoothed over the reports, so that a single slow step
+// doesn't resize the job. Not thread-safe.
+class AutoScaler {
+ public:
+  // Records that a consumer of `job_id` waited `wait_time_usec` for elements
+  // during the last `interval_usec`.
+  void ReportConsumerWaitTime(int64_t job_id, int64_t job_client_id,
+                              int64_t wait_time_usec, int64_t interval_usec);
+  // Records the fullness, between 0 and 1, of the buffer of the task of
+  // `job_id` on `worker_address`.
+  void ReportBufferFullness(int64_t job_id, absl::string_view worker_address,
+                            double fullness);
+  // Forgets the metrics of a consumer, e.g. once it is released.
+  void RemoveConsumer(int64_t job_id, int64_t job_client_id);
+  // Forgets the metrics of a job, e.g. once it is finished.
+  void RemoveJob(int64_t job_id);
+
+  // Returns the number of workers `job_id` needs, given that it currently
+  // runs on `num_workers` workers. Jobs without metrics keep their workers.
+  int64_t GetTargetNumWorkers(int64_t job_id, int64_t num_workers) const;
+
+ private:
+  struct JobMetrics {
+    // Smoothed wait fraction of each consumer, keyed by job client id.
+    absl::flat_hash_map<int64_t, double> wait_fractions;
+    // Smoothed buffer fullness of each worker, keyed by worker address.
+    absl::flat_hash_map<std::string, double> buffer_fullness;
+  };
+
+  absl::flat_hash_map<int64_t, JobMetrics> jobs_;
+};
+
+// Receives the decisions of the dispatcher's `AutoScaler`, to add and remove
+// workers, e.g. through a cluster manager. Hooks are registered under a name,
+// which is set as `auto_scaler_hook` in the dispatcher config. Implementations
+// should be thread-safe, since all dispatchers share the registered instance.
+class AutoScalerHook {
+ public:
+  virtual ~AutoScalerHook() = default;
+
+  // Returns the name to set in the dispatcher config to use this hook.
+  virtual std::string Name() = 0;
+
+  // Called periodically with the target number of workers of each unfinished
+  // job, keyed by job id, and the addresses of the workers that are not
+  // draining. The hook may add workers, and adds the workers it wants to
+  // remove to `workers_to_drain`. The dispatcher stops assigning new tasks
+  // to these workers, and lets their current tasks finish.
+  virtual void UpdateTargetNumWorkers(
+      const absl::flat_hash_map<int64_t, int64_t>& target_num_workers,
+      const std::vector<std::string>& workers,
+      std::vector<std::string>& workers_to_drain) = 0;
+
+  // Called once for each draining worker when it no longer runs tasks of
+  // unfinished jobs, so it can be removed without losing elements.
+  virtual void WorkerDrained(const std::string& worker_address) = 0;
+
+  // Registers a hook. The hook must outlive all the dispatchers using it.
+  static void Register(AutoScalerHook* hook);
+  // Gets the hook registered as `name`, and stores it in `out`.
+  static Status Get(absl::string_view name, AutoScalerHook*& out);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_AUTO_SCALER_H_
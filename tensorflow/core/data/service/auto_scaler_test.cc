@@ -0,0 +1,131 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/auto_scaler.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+class TestAutoScalerHook : public AutoScalerHook {
+ public:
+  std::string Name() override { return "test"; }
+
+  void UpdateTargetNumWorkers(
+      const absl::flat_hash_map<int64_t, int64_t>& target_num_workers,
+      const std::vector<std::string>& workers,
+      std::vector<std::string>& workers_to_drain) override {}
+
+  void WorkerDrained(const std::string& worker_address) override {}
+};
+}  // namespace
+
+TEST(AutoScaler, NoMetricsKeepsWorkers) {
+  AutoScaler auto_scaler;
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(/*job_id=*/0, 4), 4);
+}
+
+TEST(AutoScaler, ScalesUpWaitingConsumers) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(/*job_id=*/0, /*job_client_id=*/0,
+                                     /*wait_time_usec=*/500,
+                                     /*interval_usec=*/1000);
+  // The consumer waits half of the time, so it needs twice the workers.
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 4), 8);
+  // A slightly waiting consumer still gets one worker more.
+  auto_scaler.ReportConsumerWaitTime(0, 1, 100, 1000);
+  auto_scaler.RemoveConsumer(0, 0);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 4), 5);
+}
+
+TEST(AutoScaler, FollowsSlowestConsumer) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  auto_scaler.ReportConsumerWaitTime(0, 1, 750, 1000);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 2), 8);
+}
+
+TEST(AutoScaler, CapsGrowth) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(0, 0, 1000, 1000);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 2), 20);
+}
+
+TEST(AutoScaler, SmoothsWaitTime) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(0, 0, 500, 1000);
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  // The smoothed wait fraction is 0.25.
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 3), 4);
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 3), 3);
+}
+
+TEST(AutoScaler, ScalesDownFullBuffers) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(0, 0, 0, 1000);
+  auto_scaler.ReportBufferFullness(0, "worker_0", 1.0);
+  auto_scaler.ReportBufferFullness(0, "worker_1", 0.95);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 2), 1);
+  // Keeps the last worker.
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 1), 1);
+  auto_scaler.ReportBufferFullness(0, "worker_1", 0.0);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 2), 2);
+}
+
+TEST(AutoScaler, WaitingConsumersOverrideFullBuffers) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportBufferFullness(0, "worker_0", 1.0);
+  auto_scaler.ReportConsumerWaitTime(0, 0, 500, 1000);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 1), 2);
+}
+
+TEST(AutoScaler, RemoveJob) {
+  AutoScaler auto_scaler;
+  auto_scaler.ReportConsumerWaitTime(0, 0, 500, 1000);
+  auto_scaler.ReportConsumerWaitTime(1, 1, 500, 1000);
+  auto_scaler.RemoveJob(0);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(0, 2), 2);
+  EXPECT_EQ(auto_scaler.GetTargetNumWorkers(1, 2), 4);
+}
+
+TEST(AutoScalerHook, Register) {
+  TestAutoScalerHook test_hook;
+  AutoScalerHook::Register(&test_hook);
+  AutoScalerHook* hook = nullptr;
+  TF_ASSERT_OK(AutoScalerHook::Get(test_hook.Name(), hook));
+  EXPECT_EQ(hook, &test_hook);
+}
+
+TEST(AutoScalerHook, MissingHook) {
+  AutoScalerHook* hook = nullptr;
+  Status s = AutoScalerHook::Get("unknown_hook", hook);
+  ASSERT_EQ(error::Code::NOT_FOUND, s.code());
+  ASSERT_TRUE(absl::StrContains(
+      s.ToString(), "No auto-scaler hook has been registered as unknown_hook"));
+}
+
+}  // namespace data
+}  // namespace tensorflow
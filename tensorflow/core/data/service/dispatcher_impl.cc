@@ -33,6 +33,7 @@ limitations under the License.
 #include "absl/types/optional.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/hash_utils.h"
+#include "tensorflow/core/data/service/auto_scaler.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
@@ -72,6 +73,7 @@ constexpr char kDatasetsDir[] = "datasets";
 constexpr int64_t kDefaultJobGcCheckIntervalMs = 10 * 60 * 1000;  // 10 minutes.
 constexpr int64_t kDefaultJobGcTimeoutMs = 5 * 60 * 1000;         // 5 minutes.
 constexpr int64_t kDefaultClientTimeoutMs = 2 * 60 * 1000;        // 2 minutes.
+constexpr int64_t kDefaultJournalSnapshotInterval = 10000;
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -143,6 +145,9 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
   if (new_config.client_timeout_ms() == 0) {
     new_config.set_client_timeout_ms(kDefaultClientTimeoutMs);
   }
+  if (new_config.journal_snapshot_interval() == 0) {
+    new_config.set_journal_snapshot_interval(kDefaultJournalSnapshotInterval);
+  }
   return new_config;
 }
 
@@ -172,6 +177,10 @@ DataServiceDispatcherImpl::~DataServiceDispatcherImpl() {
 
 Status DataServiceDispatcherImpl::Start() {
   mutex_lock l(mu_);
+  if (!config_.auto_scaler_hook().empty()) {
+    TF_RETURN_IF_ERROR(
+        AutoScalerHook::Get(config_.auto_scaler_hook(), auto_scaler_hook_));
+  }
   if (config_.job_gc_timeout_ms() >= 0) {
     job_gc_thread_ = absl::WrapUnique(
         env_->StartThread({}, "job-gc-thread", [&] { JobGcThread(); }));
@@ -195,17 +204,27 @@ Status DataServiceDispatcherImpl::Start() {
       env_, JournalDir(config_.work_dir()));
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
             << JournalDir(config_.work_dir());
+  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
+  DispatcherStateSnapshot snapshot;
+  bool snapshot_found = false;
+  TF_RETURN_IF_ERROR(reader.ReadSnapshot(snapshot, snapshot_found));
+  if (snapshot_found) {
+    TF_RETURN_IF_ERROR(state_.Restore(snapshot));
+  }
   Update update;
   bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
   Status s = reader.Read(update, end_of_journal);
   if (errors::IsNotFound(s)) {
-    LOG(INFO) << "No journal found. Starting dispatcher from new state.";
+    LOG(INFO) << (snapshot_found
+                      ? "Restored dispatcher state from journal snapshot."
+                      : "No journal found. Starting dispatcher from new "
+                        "state.");
   } else if (!s.ok()) {
     return s;
   } else {
     while (!end_of_journal) {
       TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+      ++updates_since_snapshot_;
       TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
     }
   }
@@ -291,7 +310,7 @@ Status DataServiceDispatcherImpl::FindNewTasks(
   }
   for (const auto& job : state_.ListJobs()) {
     if (!assigned_job_ids.contains(job->job_id) && job->IsRoundRobin() &&
-        !job->finished) {
+        !job->finished && !IsDraining(worker_address)) {
       VLOG(1) << "Creating pending task for reconnected worker "
               << worker_address;
       TF_RETURN_IF_ERROR(CreatePendingTask(job, worker_address));
@@ -331,6 +350,8 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
         request->transfer_address());
     *update.mutable_register_worker()->mutable_worker_tags() =
         request->worker_tags();
+    update.mutable_register_worker()->set_worker_hostname(
+        request->worker_hostname());
     TF_RETURN_IF_ERROR(Apply(update));
     TF_RETURN_IF_ERROR(CreateTasksForWorker(worker_address));
     TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, assigned_tasks));
@@ -342,6 +363,14 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
       FindTasksToDelete(current_tasks, assigned_tasks, response));
   TF_RETURN_IF_ERROR(
       FindNewTasks(worker_address, current_tasks, assigned_tasks, response));
+  for (const auto& task_metrics : request->task_metrics()) {
+    std::shared_ptr<const Task> task;
+    if (!state_.TaskFromId(task_metrics.task_id(), task).ok()) {
+      continue;
+    }
+    auto_scaler_.ReportBufferFullness(task->job->job_id, worker_address,
+                                      task_metrics.buffer_fullness());
+  }
 
   VLOG(4) << "Finished worker heartbeat for worker at address "
           << request->worker_address();
@@ -631,6 +660,7 @@ Status DataServiceDispatcherImpl::ReleaseJobClient(
   release_job_client->set_job_client_id(job_client_id);
   release_job_client->set_time_micros(env_->NowMicros());
   TF_RETURN_IF_ERROR(Apply(update));
+  auto_scaler_.RemoveConsumer(job->job_id, job_client_id);
   return Status::OK();
 }
 
@@ -701,6 +731,9 @@ Status DataServiceDispatcherImpl::CreateTasksForWorker(
     if (job->finished) {
       continue;
     }
+    if (IsDraining(worker_address) && !IsStaticShard(job->processing_mode)) {
+      continue;
+    }
     if (job->num_consumers.has_value()) {
       TF_RETURN_IF_ERROR(CreatePendingTask(job, worker_address));
       continue;
@@ -734,6 +767,10 @@ Status DataServiceDispatcherImpl::CreateTasksForJob(
   tasks.clear();
   tasks.reserve(workers.size());
   for (const auto& worker : workers) {
+    // Statically sharded jobs need a task on every worker to read all shards.
+    if (IsDraining(worker->address) && !IsStaticShard(job->processing_mode)) {
+      continue;
+    }
     std::shared_ptr<const Task> task;
     TF_RETURN_IF_ERROR(CreateTask(job, worker->address, task));
     tasks.push_back(task);
@@ -868,6 +905,12 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
         "Consider configuring the dispatcher with a higher "
         "`job_gc_timeout_ms`.");
   }
+  if (request->has_consumer_metrics()) {
+    auto_scaler_.ReportConsumerWaitTime(
+        job->job_id, request->job_client_id(),
+        request->consumer_metrics().wait_time_usec(),
+        request->consumer_metrics().interval_usec());
+  }
   if (request->optional_current_round_case() ==
       ClientHeartbeatRequest::kCurrentRound) {
     round_robin_rounds_[request->job_client_id()] =
@@ -923,6 +966,10 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
     task_info->set_transfer_address(task->transfer_address);
     *task_info->mutable_worker_tags() = {task->worker_tags.begin(),
                                          task->worker_tags.end()};
+    std::shared_ptr<const Worker> worker;
+    if (state_.WorkerFromAddress(task->worker_address, worker).ok()) {
+      task_info->set_worker_hostname(worker->hostname);
+    }
     task_info->set_task_id(task->task_id);
     task_info->set_job_id(job->job_id);
     task_info->set_starting_round(task->starting_round);
@@ -1015,39 +1062,138 @@ Status DataServiceDispatcherImpl::Apply(const Update& update)
   if (journal_writer_.has_value()) {
     TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
   }
-  return state_.Apply(update);
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  if (journal_writer_.has_value()) {
+    MaybeSnapshotState();
+  }
+  return Status::OK();
+}
+
+void DataServiceDispatcherImpl::MaybeSnapshotState()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (config_.journal_snapshot_interval() < 0 ||
+      ++updates_since_snapshot_ < config_.journal_snapshot_interval()) {
+    return;
+  }
+  updates_since_snapshot_ = 0;
+  DispatcherStateSnapshot snapshot;
+  state_.Snapshot(snapshot);
+  // The journal stays valid if the snapshot fails, so this only delays the
+  // compaction.
+  Status s = journal_writer_.value()->WriteSnapshot(snapshot);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to snapshot dispatcher state: " << s;
+  }
 }
 
 void DataServiceDispatcherImpl::JobGcThread() {
   int64_t next_check_micros = 0;
   while (true) {
-    mutex_lock l(mu_);
-    while (!cancelled_ && env_->NowMicros() < next_check_micros) {
-      int64_t remaining_micros = next_check_micros - env_->NowMicros();
-      job_gc_thread_cv_.wait_for(l,
-                                 std::chrono::microseconds(remaining_micros));
-    }
-    if (cancelled_) {
-      return;
-    }
     {
-      Status s = ReleaseMissingClients();
-      if (!s.ok()) {
-        LOG(WARNING) << "Error releasing missing clients: " << s;
+      mutex_lock l(mu_);
+      while (!cancelled_ && env_->NowMicros() < next_check_micros) {
+        int64_t remaining_micros = next_check_micros - env_->NowMicros();
+        job_gc_thread_cv_.wait_for(
+            l, std::chrono::microseconds(remaining_micros));
+      }
+      if (cancelled_) {
+        return;
+      }
+      {
+        Status s = ReleaseMissingClients();
+        if (!s.ok()) {
+          LOG(WARNING) << "Error releasing missing clients: " << s;
+        }
       }
+
+      {
+        Status s = GcOldJobs();
+        if (!s.ok()) {
+          LOG(WARNING) << "Error garbage collecting old jobs: " << s;
+        }
+      }
+      next_check_micros =
+          env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
+    }
+    if (auto_scaler_hook_ != nullptr) {
+      UpdateAutoScalerHook();
     }
+  }
+}
 
-    {
-      Status s = GcOldJobs();
-      if (!s.ok()) {
-        LOG(WARNING) << "Error garbage collecting old jobs: " << s;
+void DataServiceDispatcherImpl::UpdateAutoScalerHook() TF_LOCKS_EXCLUDED(mu_) {
+  absl::flat_hash_map<int64_t, int64_t> target_num_workers;
+  std::vector<std::string> workers;
+  std::vector<std::string> drained_workers;
+  {
+    mutex_lock l(mu_);
+    for (const auto& job : state_.ListJobs()) {
+      if (job->finished) {
+        auto_scaler_.RemoveJob(job->job_id);
+        continue;
+      }
+      std::vector<std::shared_ptr<const Task>> tasks;
+      if (!state_.TasksForJob(job->job_id, tasks).ok()) {
+        continue;
+      }
+      int64_t num_workers = 0;
+      for (const auto& task : tasks) {
+        if (!task->finished) {
+          ++num_workers;
+        }
+      }
+      target_num_workers[job->job_id] =
+          auto_scaler_.GetTargetNumWorkers(job->job_id, num_workers);
+    }
+    for (const auto& worker : state_.ListWorkers()) {
+      auto it = draining_workers_.find(worker->address);
+      if (it == draining_workers_.end()) {
+        workers.push_back(worker->address);
+        continue;
+      }
+      if (it->second) {
+        continue;
+      }
+      std::vector<std::shared_ptr<const Task>> tasks;
+      if (!state_.TasksForWorker(worker->address, tasks).ok()) {
+        continue;
+      }
+      bool drained = true;
+      for (const auto& task : tasks) {
+        if (!task->finished && !task->job->finished) {
+          drained = false;
+          break;
+        }
+      }
+      if (drained) {
+        it->second = true;
+        drained_workers.push_back(worker->address);
       }
     }
-    next_check_micros =
-        env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
+  }
+  // Calls the hook without holding `mu_`, since it may wait on a cluster
+  // manager.
+  for (const std::string& worker_address : drained_workers) {
+    auto_scaler_hook_->WorkerDrained(worker_address);
+  }
+  std::vector<std::string> workers_to_drain;
+  auto_scaler_hook_->UpdateTargetNumWorkers(target_num_workers, workers,
+                                            workers_to_drain);
+  if (workers_to_drain.empty()) {
+    return;
+  }
+  mutex_lock l(mu_);
+  for (const std::string& worker_address : workers_to_drain) {
+    VLOG(1) << "Draining worker " << worker_address;
+    draining_workers_.emplace(worker_address, false);
   }
 }
 
+bool DataServiceDispatcherImpl::IsDraining(
+    const std::string& worker_address) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  return draining_workers_.contains(worker_address);
+}
+
 Status DataServiceDispatcherImpl::ReleaseMissingClients()
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   int64_t now = env_->NowMicros();
@@ -1062,6 +1208,10 @@ Status DataServiceDispatcherImpl::ReleaseMissingClients()
       release_client->set_job_client_id(client_id);
       release_client->set_time_micros(now);
       TF_RETURN_IF_ERROR(Apply(update));
+      std::shared_ptr<const Job> job;
+      if (state_.JobForJobClientId(client_id, job).ok()) {
+        auto_scaler_.RemoveConsumer(job->job_id, client_id);
+      }
     }
   }
   return Status::OK();
@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "tensorflow/core/data/service/auto_scaler.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/dataset_store.h"
@@ -269,6 +270,9 @@ class DataServiceDispatcherImpl {
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, updating both the journal and the in-memory state.
   Status Apply(const Update& update) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Snapshots the state to the journal if `journal_snapshot_interval` updates
+  // have been journaled since the last snapshot.
+  void MaybeSnapshotState() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, but doesn't update the journal. Only meant to be
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
@@ -279,6 +283,13 @@ class DataServiceDispatcherImpl {
   Status ReleaseMissingClients() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Scans for old jobs and marks them as finished.
   Status GcOldJobs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Passes the target number of workers of the unfinished jobs to
+  // `auto_scaler_hook_`, and reports the draining workers that are drained.
+  void UpdateAutoScalerHook() TF_LOCKS_EXCLUDED(mu_);
+  // Returns whether `worker_address` was asked to drain, in which case it
+  // gets no new tasks.
+  bool IsDraining(const std::string& worker_address) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Gets a `DatasetDef` from `dataset_store_` for the given dataset id, and
   // stores it in `dataset_def`.
   Status GetDatasetDef(int64_t dataset_id,
@@ -314,9 +325,20 @@ class DataServiceDispatcherImpl {
   // Map from client id to the time of the client's last heartbeat.
   absl::flat_hash_map<int64_t, absl::Time> latest_client_heartbeats_time_
       TF_GUARDED_BY(mu_);
+  // Computes the number of workers of each job from the metrics reported in
+  // the heartbeats. Like `round_robin_rounds_`, the metrics aren't journaled.
+  AutoScaler auto_scaler_ TF_GUARDED_BY(mu_);
+  // The hook receiving the decisions of `auto_scaler_`, or nullptr when the
+  // dispatcher doesn't scale the workers.
+  AutoScalerHook* auto_scaler_hook_ = nullptr;
+  // Map from the address of each worker `auto_scaler_hook_` asked to drain to
+  // whether the hook was told the worker is drained.
+  absl::flat_hash_map<std::string, bool> draining_workers_ TF_GUARDED_BY(mu_);
 
   absl::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
+  // The number of updates journaled since the last snapshot.
+  int64_t updates_since_snapshot_ TF_GUARDED_BY(mu_) = 0;
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the job gc thread.
   condition_variable job_gc_thread_cv_;
@@ -14,7 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/dispatcher_state.h"
 
+#include <algorithm>
 #include <memory>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -87,6 +89,213 @@ Status DispatcherState::Apply(const Update& update) {
   return Status::OK();
 }
 
+void DispatcherState::Snapshot(DispatcherStateSnapshot& snapshot) const {
+  snapshot.Clear();
+  snapshot.set_next_available_dataset_id(next_available_dataset_id_);
+  snapshot.set_next_available_job_id(next_available_job_id_);
+  snapshot.set_next_available_job_client_id(next_available_job_client_id_);
+  snapshot.set_next_available_task_id(next_available_task_id_);
+  for (const auto& dataset : datasets_by_id_) {
+    RegisterDatasetUpdate* register_dataset = snapshot.add_datasets();
+    register_dataset->set_dataset_id(dataset.second->dataset_id);
+    register_dataset->set_fingerprint(dataset.second->fingerprint);
+  }
+  for (const auto& element_spec : id_element_spec_info_) {
+    SetElementSpecUpdate* set_element_spec = snapshot.add_element_specs();
+    set_element_spec->set_dataset_id(element_spec.first);
+    set_element_spec->set_element_spec(element_spec.second);
+  }
+  for (const auto& worker : workers_) {
+    RegisterWorkerUpdate* register_worker = snapshot.add_workers();
+    register_worker->set_worker_address(worker.second->address);
+    register_worker->set_transfer_address(worker.second->transfer_address);
+    *register_worker->mutable_worker_tags() = {worker.second->tags.begin(),
+                                               worker.second->tags.end()};
+    register_worker->set_worker_hostname(worker.second->hostname);
+  }
+  for (const auto& it : jobs_) {
+    const Job& job = *it.second;
+    JobSnapshot* job_snapshot = snapshot.add_jobs();
+    CreateJobUpdate* create_job = job_snapshot->mutable_create_job();
+    create_job->set_job_id(job.job_id);
+    create_job->set_dataset_id(job.dataset_id);
+    *create_job->mutable_processing_mode_def() = job.processing_mode;
+    if (job.named_job_key.has_value()) {
+      create_job->mutable_named_job_key()->set_name(job.named_job_key->name);
+      create_job->mutable_named_job_key()->set_index(job.named_job_key->index);
+    }
+    if (job.num_consumers.has_value()) {
+      create_job->set_num_consumers(job.num_consumers.value());
+    }
+    create_job->set_target_workers(job.target_workers);
+    if (job.distributed_epoch_state.has_value()) {
+      const DistributedEpochState& state = job.distributed_epoch_state.value();
+      create_job->set_num_split_providers(state.indices.size());
+      *job_snapshot->mutable_repetitions() = {state.repetitions.begin(),
+                                              state.repetitions.end()};
+      *job_snapshot->mutable_split_indices() = {state.indices.begin(),
+                                                state.indices.end()};
+    }
+    auto tasks_it = tasks_by_job_.find(job.job_id);
+    if (tasks_it != tasks_by_job_.end()) {
+      for (const auto& task : tasks_it->second) {
+        job_snapshot->add_task_ids(task->task_id);
+      }
+    }
+    // `std::queue` does not support iteration.
+    std::queue<PendingTask> pending_tasks = job.pending_tasks;
+    while (!pending_tasks.empty()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      PendingTaskSnapshot* pending_task_snapshot =
+          job_snapshot->add_pending_tasks();
+      pending_task_snapshot->set_task_id(pending_task.task->task_id);
+      pending_task_snapshot->set_target_round(pending_task.target_round);
+      *pending_task_snapshot->mutable_ready_consumers() = {
+          pending_task.ready_consumers.begin(),
+          pending_task.ready_consumers.end()};
+      pending_task_snapshot->set_failures(pending_task.failures);
+      pending_tasks.pop();
+    }
+    job_snapshot->set_num_clients(job.num_clients);
+    job_snapshot->set_last_client_released_micros(
+        job.last_client_released_micros);
+    job_snapshot->set_finished(job.finished);
+    job_snapshot->set_garbage_collected(job.garbage_collected);
+  }
+  for (const auto& it : tasks_) {
+    const Task& task = *it.second;
+    TaskSnapshot* task_snapshot = snapshot.add_tasks();
+    CreateTaskUpdate* create_task = task_snapshot->mutable_create_task();
+    create_task->set_task_id(task.task_id);
+    create_task->set_job_id(task.job->job_id);
+    create_task->set_worker_address(task.worker_address);
+    create_task->set_transfer_address(task.transfer_address);
+    *create_task->mutable_worker_tags() = {task.worker_tags.begin(),
+                                           task.worker_tags.end()};
+    task_snapshot->set_starting_round(task.starting_round);
+    task_snapshot->set_finished(task.finished);
+  }
+  for (const auto& it : jobs_for_client_ids_) {
+    // Lookups of unknown job client ids leave null entries.
+    if (it.second) {
+      AcquireJobClientUpdate* acquire_job_client = snapshot.add_job_clients();
+      acquire_job_client->set_job_client_id(it.first);
+      acquire_job_client->set_job_id(it.second->job_id);
+    }
+  }
+}
+
+Status DispatcherState::Restore(const DispatcherStateSnapshot& snapshot) {
+  if (!datasets_by_id_.empty() || !workers_.empty() || !jobs_.empty()) {
+    return errors::FailedPrecondition(
+        "Dispatcher snapshots can only be restored into an empty state.");
+  }
+  for (const auto& register_dataset : snapshot.datasets()) {
+    RegisterDataset(register_dataset);
+  }
+  for (const auto& set_element_spec : snapshot.element_specs()) {
+    SetElementSpec(set_element_spec);
+  }
+  for (const auto& register_worker : snapshot.workers()) {
+    RegisterWorker(register_worker);
+  }
+  // Restores jobs in creation order, so that the latest job with a name wins.
+  std::vector<const JobSnapshot*> job_snapshots;
+  for (const auto& job_snapshot : snapshot.jobs()) {
+    job_snapshots.push_back(&job_snapshot);
+  }
+  std::sort(job_snapshots.begin(), job_snapshots.end(),
+            [](const JobSnapshot* a, const JobSnapshot* b) {
+              return a->create_job().job_id() < b->create_job().job_id();
+            });
+  for (const JobSnapshot* job_snapshot : job_snapshots) {
+    CreateJob(job_snapshot->create_job());
+    Job& job = *jobs_[job_snapshot->create_job().job_id()];
+    if (job.distributed_epoch_state.has_value()) {
+      DistributedEpochState& state = job.distributed_epoch_state.value();
+      if (job_snapshot->repetitions_size() != state.repetitions.size() ||
+          job_snapshot->split_indices_size() != state.indices.size()) {
+        return errors::DataLoss("Invalid distributed epoch state for job ",
+                                job.job_id, " in the dispatcher snapshot.");
+      }
+      state.repetitions.assign(job_snapshot->repetitions().begin(),
+                               job_snapshot->repetitions().end());
+      state.indices.assign(job_snapshot->split_indices().begin(),
+                           job_snapshot->split_indices().end());
+    }
+    job.num_clients = job_snapshot->num_clients();
+    job.last_client_released_micros =
+        job_snapshot->last_client_released_micros();
+    job.finished = job_snapshot->finished();
+    job.garbage_collected = job_snapshot->garbage_collected();
+  }
+  for (const auto& task_snapshot : snapshot.tasks()) {
+    const CreateTaskUpdate& create_task = task_snapshot.create_task();
+    auto job_it = jobs_.find(create_task.job_id());
+    if (job_it == jobs_.end()) {
+      return errors::DataLoss("Task ", create_task.task_id(),
+                              " in the dispatcher snapshot belongs to unknown "
+                              "job ",
+                              create_task.job_id());
+    }
+    auto task = std::make_shared<Task>(create_task, job_it->second);
+    task->starting_round = task_snapshot.starting_round();
+    task->finished = task_snapshot.finished();
+    tasks_[task->task_id] = task;
+    TasksById& tasks_for_worker = tasks_by_worker_[task->worker_address];
+    if (!task->finished) {
+      tasks_for_worker[task->task_id] = task;
+    }
+  }
+  for (const auto& job_snapshot : snapshot.jobs()) {
+    const int64_t job_id = job_snapshot.create_job().job_id();
+    Job& job = *jobs_[job_id];
+    std::vector<std::shared_ptr<Task>>& tasks_for_job = tasks_by_job_[job_id];
+    for (int64_t task_id : job_snapshot.task_ids()) {
+      auto task_it = tasks_.find(task_id);
+      if (task_it == tasks_.end()) {
+        return errors::DataLoss("Unknown task ", task_id, " of job ", job_id,
+                                " in the dispatcher snapshot.");
+      }
+      tasks_for_job.push_back(task_it->second);
+    }
+    for (const auto& pending_task_snapshot : job_snapshot.pending_tasks()) {
+      auto task_it = tasks_.find(pending_task_snapshot.task_id());
+      if (task_it == tasks_.end()) {
+        return errors::DataLoss("Unknown pending task ",
+                                pending_task_snapshot.task_id(), " of job ",
+                                job_id, " in the dispatcher snapshot.");
+      }
+      job.pending_tasks.emplace(task_it->second,
+                                pending_task_snapshot.target_round());
+      PendingTask& pending_task = job.pending_tasks.back();
+      pending_task.ready_consumers.insert(
+          pending_task_snapshot.ready_consumers().begin(),
+          pending_task_snapshot.ready_consumers().end());
+      pending_task.failures = pending_task_snapshot.failures();
+    }
+  }
+  for (const auto& acquire_job_client : snapshot.job_clients()) {
+    auto job_it = jobs_.find(acquire_job_client.job_id());
+    if (job_it == jobs_.end()) {
+      return errors::DataLoss("Job client ", acquire_job_client.job_client_id(),
+                              " in the dispatcher snapshot reads unknown job ",
+                              acquire_job_client.job_id());
+    }
+    jobs_for_client_ids_[acquire_job_client.job_client_id()] = job_it->second;
+  }
+  // Keeps the ids of removed job clients and tasks from being reused.
+  next_available_dataset_id_ = std::max(next_available_dataset_id_,
+                                        snapshot.next_available_dataset_id());
+  next_available_job_id_ =
+      std::max(next_available_job_id_, snapshot.next_available_job_id());
+  next_available_job_client_id_ = std::max(
+      next_available_job_client_id_, snapshot.next_available_job_client_id());
+  next_available_task_id_ =
+      std::max(next_available_task_id_, snapshot.next_available_task_id());
+  return Status::OK();
+}
+
 void DispatcherState::RegisterDataset(
     const RegisterDatasetUpdate& register_dataset) {
   int64_t id = register_dataset.dataset_id();
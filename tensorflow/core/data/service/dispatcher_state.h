@@ -71,6 +71,11 @@ class DispatcherState {
 
   // Applies the given update to the dispatcher's state.
   Status Apply(const Update& update);
+  // Stores the dispatcher's state in `snapshot`.
+  void Snapshot(DispatcherStateSnapshot& snapshot) const;
+  // Restores the state stored in `snapshot`. Must be called before any other
+  // update is applied.
+  Status Restore(const DispatcherStateSnapshot& snapshot);
 
   // A dataset registered with the dispatcher.
   struct Dataset {
@@ -87,11 +92,13 @@ class DispatcherState {
         : address(register_worker.worker_address()),
           transfer_address(register_worker.transfer_address()),
           tags(register_worker.worker_tags().begin(),
-               register_worker.worker_tags().end()) {}
+               register_worker.worker_tags().end()),
+          hostname(register_worker.worker_hostname()) {}
 
     const std::string address;
     const std::string transfer_address;
     const std::vector<std::string> tags;
+    const std::string hostname;
   };
 
   // A key for identifying a named job. The key contains a user-specified name,
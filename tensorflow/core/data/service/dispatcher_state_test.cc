@@ -211,6 +211,17 @@ TEST(DispatcherState, RegisterWorker) {
   EXPECT_EQ(worker->address, address);
 }
 
+TEST(DispatcherState, RegisterWorkerHostname) {
+  DispatcherState state;
+  Update update;
+  update.mutable_register_worker()->set_worker_address("test_worker_address");
+  update.mutable_register_worker()->set_worker_hostname("test_hostname");
+  TF_EXPECT_OK(state.Apply(update));
+  std::shared_ptr<const Worker> worker;
+  TF_EXPECT_OK(state.WorkerFromAddress("test_worker_address", worker));
+  EXPECT_EQ(worker->hostname, "test_hostname");
+}
+
 TEST(DispatcherState, RegisterWorkerInFixedWorkerSet) {
   experimental::DispatcherConfig config;
   config.add_worker_addresses("/worker/task/0");
@@ -582,5 +593,69 @@ TEST(DispatcherState, ListActiveClients) {
   EXPECT_THAT(state.ListActiveClientIds(), UnorderedElementsAre(6, 8));
 }
 
+TEST(DispatcherState, SnapshotAndRestore) {
+  int64_t dataset_id = 10;
+  int64_t job_id = 3;
+  int64_t job_client_id = 6;
+  std::string worker_address = "test_worker_address";
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  TF_EXPECT_OK(SetElementSpec(dataset_id, "element_spec", state));
+  TF_EXPECT_OK(RegisterWorker(worker_address, state));
+  TF_EXPECT_OK(
+      CreateNamedJob(job_id, dataset_id, NamedJobKey("job", 0), state));
+  TF_EXPECT_OK(AcquireJobClientId(job_id, job_client_id, state));
+  TF_EXPECT_OK(CreateTask(/*task_id=*/8, job_id, worker_address, state));
+  TF_EXPECT_OK(CreateTask(/*task_id=*/9, job_id, worker_address, state));
+  TF_EXPECT_OK(FinishTask(/*task_id=*/8, state));
+
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+  DispatcherState restored;
+  TF_ASSERT_OK(restored.Restore(snapshot));
+
+  std::string element_spec;
+  TF_EXPECT_OK(restored.GetElementSpec(dataset_id, element_spec));
+  EXPECT_EQ(element_spec, "element_spec");
+  std::shared_ptr<const Worker> worker;
+  TF_EXPECT_OK(restored.WorkerFromAddress(worker_address, worker));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(restored.NamedJobByKey(NamedJobKey("job", 0), job));
+  EXPECT_EQ(job->job_id, job_id);
+  EXPECT_EQ(job->num_clients, 1);
+  EXPECT_FALSE(job->finished);
+  std::shared_ptr<const Job> client_job;
+  TF_EXPECT_OK(restored.JobForJobClientId(job_client_id, client_job));
+  EXPECT_EQ(client_job, job);
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_EXPECT_OK(restored.TasksForJob(job_id, tasks));
+  ASSERT_THAT(tasks, SizeIs(2));
+  EXPECT_EQ(tasks[0]->task_id, 8);
+  EXPECT_TRUE(tasks[0]->finished);
+  EXPECT_EQ(tasks[1]->task_id, 9);
+  EXPECT_FALSE(tasks[1]->finished);
+  TF_EXPECT_OK(restored.TasksForWorker(worker_address, tasks));
+  ASSERT_THAT(tasks, SizeIs(1));
+  EXPECT_EQ(tasks[0]->task_id, 9);
+  EXPECT_EQ(restored.NextAvailableDatasetId(), state.NextAvailableDatasetId());
+  EXPECT_EQ(restored.NextAvailableJobId(), state.NextAvailableJobId());
+  EXPECT_EQ(restored.NextAvailableJobClientId(),
+            state.NextAvailableJobClientId());
+  EXPECT_EQ(restored.NextAvailableTaskId(), state.NextAvailableTaskId());
+
+  // The restored state keeps applying updates.
+  TF_EXPECT_OK(FinishTask(/*task_id=*/9, restored));
+  TF_EXPECT_OK(restored.JobFromId(job_id, job));
+  EXPECT_TRUE(job->finished);
+}
+
+TEST(DispatcherState, RestoreIntoNonEmptyState) {
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(/*id=*/10, state));
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+  EXPECT_THAT(state.Restore(snapshot), StatusIs(error::FAILED_PRECONDITION));
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/grpc_worker_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
 #include "grpcpp/server_builder.h"
 #include "grpcpp/server_context.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/service/worker_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/platform/errors.h"
@@ -63,5 +66,64 @@ HANDLER(GetElement);
 HANDLER(GetWorkerTasks);
 #undef HANDLER
 
+::grpc::Status GrpcWorkerImpl::GetElements(
+    ServerContext* context,
+    ::grpc::ServerReaderWriter<GetElementsResponse, GetElementsRequest>*
+        stream) {
+  GetElementsRequest request;
+  if (!stream->Read(&request)) {
+    return ::grpc::Status::OK;
+  }
+  VLOG(3) << "Received GetElements stream for task " << request.task_id();
+  GetElementRequest element_request;
+  element_request.set_task_id(request.task_id());
+  const int64_t max_batch_size = std::max<int64_t>(request.max_batch_size(), 1);
+  std::unique_ptr<MessageStreamCompressor> compressor;
+  if (request.compress()) {
+    compressor = absl::make_unique<MessageStreamCompressor>();
+  }
+  int64_t credits = request.credits();
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    // Wait for the client to consume elements before producing more.
+    while (credits <= 0) {
+      if (!stream->Read(&request)) {
+        return ::grpc::Status::OK;
+      }
+      credits += request.credits();
+    }
+    if (context->IsCancelled()) {
+      return ::grpc::Status(::grpc::StatusCode::CANCELLED,
+                            "GetElements stream was cancelled.");
+    }
+    GetElementBatch batch;
+    const int64_t batch_size = std::min(credits, max_batch_size);
+    while (batch.elements_size() < batch_size && !end_of_sequence) {
+      GetElementResponse* element = batch.add_elements();
+      const Status s = impl_->GetElement(&element_request, element);
+      if (!s.ok()) {
+        return ToGrpcStatus(s);
+      }
+      end_of_sequence = element->end_of_sequence();
+    }
+    credits -= batch.elements_size();
+    GetElementsResponse response;
+    if (compressor) {
+      const Status s = compressor->Compress(
+          batch.SerializeAsString(), response.mutable_compressed_elements());
+      if (!s.ok()) {
+        return ToGrpcStatus(s);
+      }
+    } else {
+      *response.mutable_elements() = std::move(batch);
+    }
+    if (!stream->Write(response)) {
+      // The client has closed the stream.
+      return ::grpc::Status::OK;
+    }
+  }
+  return ::grpc::Status::OK;
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -58,6 +58,11 @@ class GrpcWorkerImpl : public WorkerService::Service {
   HANDLER(GetWorkerTasks);
 #undef HANDLER
 
+  ::grpc::Status GetElements(
+      ::grpc::ServerContext* context,
+      ::grpc::ServerReaderWriter<GetElementsResponse, GetElementsRequest>*
+          stream) override;
+
  private:
   std::string worker_address_;
   // A std::shared_ptr allows clients to access local servers and directly call
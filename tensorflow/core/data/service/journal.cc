@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -29,6 +31,8 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kSnapshot = "snapshot";
+constexpr StringPiece kTmpSuffix = ".tmp";
 
 Status ParseSequenceNumber(const std::string& journal_file,
                            int64_t* sequence_number) {
@@ -38,6 +42,14 @@ Status ParseSequenceNumber(const std::string& journal_file,
   }
   return Status::OK();
 }
+
+bool IsTmpFile(const std::string& filename) {
+  return absl::EndsWith(filename, kTmpSuffix);
+}
+
+bool IsSnapshotFile(const std::string& filename) {
+  return absl::StartsWith(filename, kSnapshot) && !IsTmpFile(filename);
+}
 }  // namespace
 
 std::string DataServiceJournalFile(const std::string& journal_dir,
@@ -46,6 +58,12 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kSnapshot, "_", sequence_number));
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -56,14 +74,21 @@ Status FileJournalWriter::EnsureInitialized() {
   std::vector<std::string> journal_files;
   TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(journal_dir_));
   TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
-  int64_t latest_sequence_number = -1;
+  int64_t next_sequence_number = 0;
   for (const auto& file : journal_files) {
+    if (IsTmpFile(file)) {
+      continue;
+    }
     int64_t sequence_number;
     TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
-    latest_sequence_number = std::max(latest_sequence_number, sequence_number);
+    // A snapshot may have been written without the journal file after it.
+    next_sequence_number =
+        std::max(next_sequence_number,
+                 IsSnapshotFile(file) ? sequence_number : sequence_number + 1);
   }
+  sequence_number_ = next_sequence_number;
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number_);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = absl::make_unique<io::RecordWriter>(file_.get());
   VLOG(1) << "Created journal writer to write to " << journal_file;
@@ -86,6 +111,57 @@ Status FileJournalWriter::Write(const Update& update) {
   return Status::OK();
 }
 
+Status FileJournalWriter::WriteSnapshot(
+    const DispatcherStateSnapshot& snapshot) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  const int64_t next_sequence_number = sequence_number_ + 1;
+  // Writes to a temporary file first, so that readers only see complete
+  // snapshots.
+  const std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir_, next_sequence_number);
+  const std::string tmp_file = absl::StrCat(snapshot_file, kTmpSuffix);
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env_, tmp_file, snapshot));
+  TF_RETURN_IF_ERROR(env_->RenameFile(tmp_file, snapshot_file));
+  // The next write starts the journal file after the snapshot.
+  Status s = writer_->Close();
+  writer_.reset();
+  s.Update(file_->Close());
+  file_.reset();
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to close journal file "
+                 << DataServiceJournalFile(journal_dir_, sequence_number_)
+                 << ": " << s;
+  }
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  DCHECK_EQ(sequence_number_, next_sequence_number);
+  VLOG(1) << "Wrote journal snapshot " << snapshot_file;
+  DeleteFilesBefore(next_sequence_number);
+  return Status::OK();
+}
+
+void FileJournalWriter::DeleteFilesBefore(int64_t sequence_number) {
+  std::vector<std::string> journal_files;
+  Status s = env_->GetChildren(journal_dir_, &journal_files);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to list journal directory " << journal_dir_ << ": "
+                 << s;
+    return;
+  }
+  for (const auto& file : journal_files) {
+    int64_t file_sequence_number;
+    if (IsTmpFile(file) ||
+        !ParseSequenceNumber(file, &file_sequence_number).ok() ||
+        file_sequence_number >= sequence_number) {
+      continue;
+    }
+    s = env_->DeleteFile(io::JoinPath(journal_dir_, file));
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete compacted journal file " << file
+                   << ": " << s;
+    }
+  }
+}
+
 FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -93,7 +169,36 @@ Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return Status::OK();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  return UpdateFile(DataServiceJournalFile(journal_dir_, sequence_number_));
+}
+
+Status FileJournalReader::ReadSnapshot(DispatcherStateSnapshot& snapshot,
+                                       bool& found) {
+  found = false;
+  if (errors::IsNotFound(env_->FileExists(journal_dir_))) {
+    return Status::OK();
+  }
+  std::vector<std::string> journal_files;
+  TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
+  int64_t latest_sequence_number = -1;
+  for (const auto& file : journal_files) {
+    int64_t sequence_number;
+    if (IsSnapshotFile(file)) {
+      TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
+      latest_sequence_number =
+          std::max(latest_sequence_number, sequence_number);
+    }
+  }
+  if (latest_sequence_number < 0) {
+    return Status::OK();
+  }
+  const std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir_, latest_sequence_number);
+  VLOG(1) << "Reading journal snapshot " << snapshot_file;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env_, snapshot_file, &snapshot));
+  sequence_number_ = latest_sequence_number;
+  found = true;
+  return Status::OK();
 }
 
 Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
@@ -28,6 +28,11 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the snapshot of the state before the journal file
+// with the given sequence number.
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
@@ -36,6 +41,9 @@ class JournalWriter {
   virtual Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
+  // Replaces the updates written so far with `snapshot`, which must be the
+  // state after applying them.
+  virtual Status WriteSnapshot(const DispatcherStateSnapshot& snapshot) = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -54,6 +62,10 @@ class JournalWriter {
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
 // can be stored durably in case of machine failure.
+//
+// `WriteSnapshot` compacts the journal: it writes "snapshot_<n>", holding the
+// state before "journal_<n>", starts writing "journal_<n>", and deletes the
+// older journal files and snapshots.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -65,10 +77,16 @@ class FileJournalWriter : public JournalWriter {
 
   Status Write(const Update& update) override;
   Status EnsureInitialized() override;
+  Status WriteSnapshot(const DispatcherStateSnapshot& snapshot) override;
 
  private:
+  // Deletes the journal files and snapshots before `sequence_number`.
+  void DeleteFilesBefore(int64_t sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of the journal file being written.
+  int64_t sequence_number_ = 0;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -93,6 +111,10 @@ class FileJournalReader : public JournalReader {
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
+  // Reads the latest snapshot in the journal directory into `snapshot`, and
+  // sets `found` to whether there is one. If there is, subsequent reads start
+  // from the first update after the snapshot. Must be called before `Read`.
+  Status ReadSnapshot(DispatcherStateSnapshot& snapshot, bool& found);
   Status Read(Update& update, bool& end_of_journal) override;
 
  private:
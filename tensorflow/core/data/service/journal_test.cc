@@ -113,6 +113,69 @@ TEST(Journal, AppendExistingJournal) {
   TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
 }
 
+TEST(Journal, SnapshotTruncatesJournal) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(MakeCreateJobUpdate()));
+  TF_EXPECT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+  DispatcherStateSnapshot snapshot;
+  snapshot.set_next_available_job_id(9);
+  TF_EXPECT_OK(writer.WriteSnapshot(snapshot));
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      DataServiceJournalFile(journal_dir, /*sequence_number=*/0))));
+  FileJournalReader reader(Env::Default(), journal_dir);
+  DispatcherStateSnapshot result;
+  bool found = false;
+  TF_ASSERT_OK(reader.ReadSnapshot(result, found));
+  EXPECT_TRUE(found);
+  EXPECT_EQ(result.next_available_job_id(), 9);
+  Update update;
+  bool end_of_journal = true;
+  TF_ASSERT_OK(reader.Read(update, end_of_journal));
+  EXPECT_FALSE(end_of_journal);
+  EXPECT_EQ(update.SerializeAsString(),
+            MakeFinishTaskUpdate().SerializeAsString());
+  TF_ASSERT_OK(reader.Read(update, end_of_journal));
+  EXPECT_TRUE(end_of_journal);
+}
+
+TEST(Journal, AppendAfterSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.Write(MakeCreateJobUpdate()));
+    TF_EXPECT_OK(writer.WriteSnapshot(DispatcherStateSnapshot()));
+  }
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  FileJournalReader reader(Env::Default(), journal_dir);
+  DispatcherStateSnapshot snapshot;
+  bool found = false;
+  TF_ASSERT_OK(reader.ReadSnapshot(snapshot, found));
+  EXPECT_TRUE(found);
+  Update update;
+  bool end_of_journal = true;
+  TF_ASSERT_OK(reader.Read(update, end_of_journal));
+  EXPECT_FALSE(end_of_journal);
+  EXPECT_EQ(update.SerializeAsString(),
+            MakeFinishTaskUpdate().SerializeAsString());
+}
+
+TEST(Journal, NoSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalReader reader(Env::Default(), journal_dir);
+  DispatcherStateSnapshot snapshot;
+  bool found = true;
+  TF_ASSERT_OK(reader.ReadSnapshot(snapshot, found));
+  EXPECT_FALSE(found);
+}
+
 TEST(Journal, MissingFile) {
   std::string journal_dir;
   EXPECT_TRUE(NewJournalDir(journal_dir));
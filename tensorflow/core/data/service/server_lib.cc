@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/grpc_dispatcher_impl.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/grpc_worker_impl.h"
+#include "tensorflow/core/data/service/worker_client.h"
 #include "tensorflow/core/platform/errors.h"
 
 namespace tensorflow {
@@ -143,7 +144,11 @@ Status WorkerGrpcDataServer::StartServiceInternal() {
       /*replace_all=*/false);
   std::string transfer_address = worker_address;
   std::string transfer_protocol = config_.data_transfer_protocol();
-  if (!transfer_protocol.empty() && transfer_protocol != "grpc") {
+  // The streaming protocols are served by the worker's gRPC service.
+  if (!transfer_protocol.empty() &&
+      transfer_protocol != kGrpcTransferProtocol &&
+      transfer_protocol != kGrpcStreamingTransferProtocol &&
+      transfer_protocol != kGrpcCompressedStreamingTransferProtocol) {
     TF_RETURN_IF_ERROR(DataTransferServer::Build(
         transfer_protocol, service_->get_element_getter(), &transfer_server_));
     TF_RETURN_IF_ERROR(transfer_server_->Start());
@@ -0,0 +1,838 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+#if defined(__linux__)
+namespace {
+
+// The number of random socket names the server tries before giving up.
+constexpr int kMaxBindAttempts = 100;
+// The socket names are numbered like ports, from 1 to `kMaxSocketNumber`.
+constexpr uint64_t kMaxSocketNumber = 1 << 30;
+// Requests only carry ids and flags.
+constexpr uint64_t kMaxRequestSize = 1 << 20;
+// Segments are at least this large, so that small elements don't remap them.
+constexpr size_t kMinSegmentSize = 1 << 20;
+
+// How each component of an element is written into a segment.
+enum class ComponentEncoding : int32_t {
+  // The bytes of a tensor of a memcpy-able type.
+  kRaw = 0,
+  // A serialized `CompressedElement`, from a scalar variant tensor.
+  kCompressed = 1,
+  // A serialized `TensorProto`, for the other types.
+  kTensorProto = 2,
+};
+
+struct RequestHeader {
+  uint64_t request_size;
+};
+
+struct ResponseHeader {
+  int32_t code;
+  uint32_t message_size;
+  // The size of the element written at the start of the segment.
+  uint64_t element_size;
+};
+
+// Fills in the address of the abstract Unix socket numbered `port`. Abstract
+// sockets have no file, and disappear with the server.
+socklen_t MakeAddress(int port, sockaddr_un& address) {
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  const std::string name = absl::StrCat("tf_data_service_shm_", port);
+  // `sun_path` starts with '\0' for the abstract namespace.
+  memcpy(address.sun_path + 1, name.data(), name.size());
+  return offsetof(sockaddr_un, sun_path) + 1 + name.size();
+}
+
+Status IoError(absl::string_view operation, int error = errno) {
+  return errors::Unavailable("Shared memory transfer failed to ", operation,
+                             ": ", strerror(error));
+}
+
+Status WriteFully(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IoError("send");
+    }
+    data += n;
+    size -= n;
+  }
+  return Status::OK();
+}
+
+Status ReadFully(int fd, char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = recv(fd, data, size, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IoError("receive");
+    }
+    if (n == 0) {
+      return errors::Unavailable("Shared memory transfer connection closed.");
+    }
+    data += n;
+    size -= n;
+  }
+  return Status::OK();
+}
+
+// Sends `header` followed by `message`, passing `segment_fd` along if it is
+// not negative.
+Status SendResponse(int fd, const ResponseHeader& header, int segment_fd,
+                    absl::string_view message) {
+  iovec iov;
+  iov.iov_base = const_cast<ResponseHeader*>(&header);
+  iov.iov_len = sizeof(header);
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  if (segment_fd >= 0) {
+    memset(control, 0, sizeof(control));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &segment_fd, sizeof(int));
+  }
+  ssize_t n;
+  do {
+    n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    return IoError("send");
+  }
+  TF_RETURN_IF_ERROR(WriteFully(fd, reinterpret_cast<const char*>(&header) + n,
+                                sizeof(header) - n));
+  return WriteFully(fd, message.data(), message.size());
+}
+
+// Receives the header of a response, and the segment passed along with it,
+// if any, into `segment_fd`. Otherwise sets `segment_fd` to -1.
+Status ReceiveResponseHeader(int fd, ResponseHeader& header, int& segment_fd) {
+  segment_fd = -1;
+  iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t n;
+  do {
+    n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    return IoError("receive");
+  }
+  if (n == 0) {
+    return errors::Unavailable("Shared memory transfer connection closed.");
+  }
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      memcpy(&segment_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  }
+  return ReadFully(fd, reinterpret_cast<char*>(&header) + n,
+                   sizeof(header) - n);
+}
+
+// A shared memory segment, mapped into the process.
+class Segment {
+ public:
+  Segment() = default;
+  ~Segment() { Reset(); }
+
+  // Replaces the segment by a new writable segment of `size` bytes.
+  Status Create(size_t size) {
+    Reset();
+    fd_ = memfd_create("tf_data_service_element", MFD_CLOEXEC);
+    if (fd_ < 0) {
+      return IoError("create a shared memory segment");
+    }
+    if (ftruncate(fd_, size) != 0) {
+      Status s = IoError("size a shared memory segment");
+      Reset();
+      return s;
+    }
+    return MapFd(size, PROT_READ | PROT_WRITE);
+  }
+
+  // Replaces the segment by the segment `fd`, mapped read-only. Takes
+  // ownership of `fd`.
+  Status Map(int fd) {
+    Reset();
+    fd_ = fd;
+    struct stat stats;
+    if (fstat(fd_, &stats) != 0) {
+      Status s = IoError("map a shared memory segment");
+      Reset();
+      return s;
+    }
+    return MapFd(stats.st_size, PROT_READ);
+  }
+
+  int fd() const { return fd_; }
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  Status MapFd(size_t size, int protection) {
+    void* data = mmap(nullptr, size, protection, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      Status s = IoError("map a shared memory segment");
+      Reset();
+      return s;
+    }
+    data_ = static_cast<char*>(data);
+    size_ = size;
+    return Status::OK();
+  }
+
+  void Reset() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    fd_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  int fd_ = -1;
+  char* data_ = nullptr;
+  size_t size_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Segment);
+};
+
+// Writes an element into a segment. Without a segment, only counts the bytes
+// the element needs.
+class SegmentWriter {
+ public:
+  explicit SegmentWriter(char* data) : data_(data) {}
+
+  template <typename T>
+  void Write(T value) {
+    if (data_ != nullptr) {
+      memcpy(data_ + size_, &value, sizeof(T));
+    }
+    size_ += sizeof(T);
+  }
+
+  // Returns where to write the next `size` bytes, or nullptr without a
+  // segment.
+  char* Reserve(size_t size) {
+    char* data = data_ == nullptr ? nullptr : data_ + size_;
+    size_ += size;
+    return data;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  char* const data_;
+  size_t size_ = 0;
+};
+
+// Reads an element from a segment, checking that it doesn't read past the
+// element.
+class SegmentReader {
+ public:
+  SegmentReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  Status Read(T& value) {
+    const char* data;
+    TF_RETURN_IF_ERROR(Skip(sizeof(T), data));
+    memcpy(&value, data, sizeof(T));
+    return Status::OK();
+  }
+
+  // Stores where the next `size` bytes start in `data`, and skips them.
+  Status Skip(uint64_t size, const char*& data) {
+    if (size > size_ - offset_) {
+      return errors::DataLoss("Truncated element in shared memory segment.");
+    }
+    data = data_ + offset_;
+    offset_ += size;
+    return Status::OK();
+  }
+
+ private:
+  const char* const data_;
+  const size_t size_;
+  size_t offset_ = 0;
+};
+
+struct EncodedComponent {
+  ComponentEncoding encoding;
+  const Tensor* tensor;
+  const CompressedElement* compressed = nullptr;
+  TensorProto proto;
+};
+
+std::vector<EncodedComponent> EncodeComponents(const GetElementResult& result) {
+  std::vector<EncodedComponent> components(result.components.size());
+  for (size_t i = 0; i < components.size(); ++i) {
+    const Tensor& tensor = result.components[i];
+    EncodedComponent& component = components[i];
+    component.tensor = &tensor;
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      component.encoding = ComponentEncoding::kRaw;
+      continue;
+    }
+    if (tensor.dtype() == DT_VARIANT &&
+        TensorShapeUtils::IsScalar(tensor.shape())) {
+      component.compressed =
+          tensor.scalar<Variant>()().get<CompressedElement>();
+      if (component.compressed != nullptr) {
+        component.encoding = ComponentEncoding::kCompressed;
+        continue;
+      }
+    }
+    component.encoding = ComponentEncoding::kTensorProto;
+    tensor.AsProtoTensorContent(&component.proto);
+  }
+  return components;
+}
+
+void WriteElement(const GetElementResult& result,
+                  const std::vector<EncodedComponent>& components,
+                  SegmentWriter& writer) {
+  writer.Write<uint8_t>(result.end_of_sequence);
+  writer.Write<uint8_t>(result.skip);
+  writer.Write<int64_t>(result.element_index);
+  writer.Write<int64_t>(components.size());
+  for (const EncodedComponent& component : components) {
+    const Tensor& tensor = *component.tensor;
+    writer.Write<int32_t>(static_cast<int32_t>(component.encoding));
+    writer.Write<int32_t>(tensor.dtype());
+    writer.Write<int64_t>(tensor.dims());
+    for (int i = 0; i < tensor.dims(); ++i) {
+      writer.Write<int64_t>(tensor.dim_size(i));
+    }
+    switch (component.encoding) {
+      case ComponentEncoding::kRaw: {
+        const StringPiece bytes = tensor.tensor_data();
+        writer.Write<uint64_t>(bytes.size());
+        char* data = writer.Reserve(bytes.size());
+        if (data != nullptr) {
+          memcpy(data, bytes.data(), bytes.size());
+        }
+        break;
+      }
+      case ComponentEncoding::kCompressed: {
+        const size_t size = component.compressed->ByteSizeLong();
+        writer.Write<uint64_t>(size);
+        char* data = writer.Reserve(size);
+        if (data != nullptr) {
+          component.compressed->SerializeWithCachedSizesToArray(
+              reinterpret_cast<uint8_t*>(data));
+        }
+        break;
+      }
+      case ComponentEncoding::kTensorProto: {
+        const size_t size = component.proto.ByteSizeLong();
+        writer.Write<uint64_t>(size);
+        char* data = writer.Reserve(size);
+        if (data != nullptr) {
+          component.proto.SerializeWithCachedSizesToArray(
+              reinterpret_cast<uint8_t*>(data));
+        }
+        break;
+      }
+    }
+  }
+}
+
+Status ReadElement(const char* data, size_t size, GetElementResult& result) {
+  SegmentReader reader(data, size);
+  uint8_t end_of_sequence, skip;
+  int64_t num_components;
+  TF_RETURN_IF_ERROR(reader.Read(end_of_sequence));
+  TF_RETURN_IF_ERROR(reader.Read(skip));
+  TF_RETURN_IF_ERROR(reader.Read(result.element_index));
+  TF_RETURN_IF_ERROR(reader.Read(num_components));
+  if (num_components < 0 || static_cast<uint64_t>(num_components) > size) {
+    return errors::DataLoss("Invalid number of components ", num_components,
+                            " in shared memory segment.");
+  }
+  result.end_of_sequence = end_of_sequence;
+  result.skip = skip;
+  result.components.clear();
+  result.components.reserve(num_components);
+  for (int64_t i = 0; i < num_components; ++i) {
+    int32_t encoding, dtype;
+    int64_t num_dims;
+    TF_RETURN_IF_ERROR(reader.Read(encoding));
+    TF_RETURN_IF_ERROR(reader.Read(dtype));
+    TF_RETURN_IF_ERROR(reader.Read(num_dims));
+    const char* dims_data;
+    TF_RETURN_IF_ERROR(reader.Skip(num_dims * sizeof(int64_t), dims_data));
+    std::vector<int64_t> dims(num_dims);
+    memcpy(dims.data(), dims_data, num_dims * sizeof(int64_t));
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        TensorShapeUtils::MakeShape(dims.data(), num_dims, &shape));
+    uint64_t num_bytes;
+    const char* bytes;
+    TF_RETURN_IF_ERROR(reader.Read(num_bytes));
+    TF_RETURN_IF_ERROR(reader.Skip(num_bytes, bytes));
+    switch (static_cast<ComponentEncoding>(encoding)) {
+      case ComponentEncoding::kRaw: {
+        const DataType type = static_cast<DataType>(dtype);
+        if (!DataTypeCanUseMemcpy(type)) {
+          return errors::DataLoss("Unexpected raw tensor of type ", dtype,
+                                  " in shared memory segment.");
+        }
+        Tensor tensor(type, shape);
+        if (tensor.TotalBytes() != num_bytes) {
+          return errors::DataLoss("Tensor of ", num_bytes, " bytes has shape ",
+                                  shape.DebugString());
+        }
+        memcpy(const_cast<char*>(tensor.tensor_data().data()), bytes,
+               num_bytes);
+        result.components.push_back(std::move(tensor));
+        break;
+      }
+      case ComponentEncoding::kCompressed: {
+        CompressedElement compressed;
+        if (!compressed.ParseFromArray(bytes, num_bytes)) {
+          return errors::DataLoss("Failed to parse compressed element.");
+        }
+        Tensor tensor(DT_VARIANT, TensorShape{});
+        tensor.scalar<Variant>()() = std::move(compressed);
+        result.components.push_back(std::move(tensor));
+        break;
+      }
+      case ComponentEncoding::kTensorProto: {
+        TensorProto proto;
+        Tensor tensor;
+        if (!proto.ParseFromArray(bytes, num_bytes) ||
+            !tensor.FromProto(proto)) {
+          return errors::DataLoss("Failed to parse tensor.");
+        }
+        result.components.push_back(std::move(tensor));
+        break;
+      }
+      default:
+        return errors::DataLoss("Unknown component encoding ", encoding,
+                                " in shared memory segment.");
+    }
+  }
+  return Status::OK();
+}
+
+// Serves the elements of a worker on an abstract Unix socket, with a thread
+// per connection. Each connection writes its elements into its own segment,
+// which it replaces by a larger one when an element doesn't fit.
+class SharedMemoryTransferServer : public DataTransferServer {
+ public:
+  explicit SharedMemoryTransferServer(GetElementT get_element)
+      : get_element_(std::move(get_element)) {}
+
+  ~SharedMemoryTransferServer() override {
+    std::vector<std::unique_ptr<Connection>> connections;
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      if (listen_fd_ >= 0) {
+        // Wakes up the accept thread.
+        shutdown(listen_fd_, SHUT_RDWR);
+      }
+      for (const auto& connection : connections_) {
+        shutdown(connection->fd, SHUT_RDWR);
+      }
+    }
+    accept_thread_.reset();
+    {
+      mutex_lock l(mu_);
+      connections = std::move(connections_);
+    }
+    connections.clear();
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+    }
+  }
+
+  Status Start() override {
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+      return IoError("create a socket");
+    }
+    for (int attempt = 0; attempt < kMaxBindAttempts && port_ < 0; ++attempt) {
+      const int port = static_cast<int>(random::New64() % kMaxSocketNumber) + 1;
+      sockaddr_un address;
+      const socklen_t address_size = MakeAddress(port, address);
+      if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+               address_size) == 0) {
+        port_ = port;
+      } else if (errno != EADDRINUSE) {
+        return IoError("bind a socket");
+      }
+    }
+    if (port_ < 0) {
+      return errors::Unavailable(
+          "Failed to find a free shared memory transfer socket.");
+    }
+    if (listen(listen_fd_, SOMAXCONN) != 0) {
+      return IoError("listen on a socket");
+    }
+    accept_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+        {}, "tf-data-service-shm-accept", [this] { AcceptThread(); }));
+    return Status::OK();
+  }
+
+  int get_port() override { return port_; }
+
+ private:
+  struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() {
+      thread.reset();
+      close(fd);
+    }
+
+    const int fd;
+    std::unique_ptr<Thread> thread;
+    // Set once the thread serving the connection is done, so the connection
+    // can be destroyed.
+    bool done = false;
+  };
+
+  void AcceptThread() TF_LOCKS_EXCLUDED(mu_) {
+    while (true) {
+      const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      const int accept_errno = errno;
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        if (fd >= 0) {
+          close(fd);
+        }
+        return;
+      }
+      if (fd < 0) {
+        if (accept_errno == EINTR || accept_errno == ECONNABORTED) {
+          continue;
+        }
+        LOG(ERROR) << IoError("accept a connection", accept_errno);
+        return;
+      }
+      // Destroys the connections which were closed.
+      connections_.erase(
+          std::remove_if(connections_.begin(), connections_.end(),
+                         [](const std::unique_ptr<Connection>& connection) {
+                           return connection->done;
+                         }),
+          connections_.end());
+      auto connection = absl::make_unique<Connection>(fd);
+      Connection* raw_connection = connection.get();
+      // `mu_` is held until `connection` is added, before the thread can mark
+      // it done.
+      connection->thread = absl::WrapUnique(Env::Default()->StartThread(
+          {}, "tf-data-service-shm-connection",
+          [this, raw_connection] { Serve(*raw_connection); }));
+      connections_.push_back(std::move(connection));
+    }
+  }
+
+  void Serve(Connection& connection) TF_LOCKS_EXCLUDED(mu_) {
+    Segment segment;
+    while (true) {
+      Status s = ServeRequest(connection.fd, segment);
+      if (!s.ok()) {
+        VLOG(2) << "Closing shared memory transfer connection: " << s;
+        break;
+      }
+    }
+    mutex_lock l(mu_);
+    connection.done = true;
+  }
+
+  Status ServeRequest(int fd, Segment& segment) {
+    RequestHeader header;
+    TF_RETURN_IF_ERROR(
+        ReadFully(fd, reinterpret_cast<char*>(&header), sizeof(header)));
+    if (header.request_size > kMaxRequestSize) {
+      return errors::DataLoss("Request of ", header.request_size,
+                              " bytes is too large.");
+    }
+    std::string serialized_request(header.request_size, '\0');
+    TF_RETURN_IF_ERROR(
+        ReadFully(fd, &serialized_request[0], serialized_request.size()));
+    GetElementRequest request;
+    if (!request.ParseFromString(serialized_request)) {
+      return errors::DataLoss("Failed to parse GetElementRequest.");
+    }
+
+    ResponseHeader response;
+    memset(&response, 0, sizeof(response));
+    int new_segment_fd = -1;
+    GetElementResult result;
+    Status s = get_element_(&request, &result);
+    if (s.ok()) {
+      const std::vector<EncodedComponent> components =
+          EncodeComponents(result);
+      SegmentWriter sizer(/*data=*/nullptr);
+      WriteElement(result, components, sizer);
+      if (sizer.size() > segment.size()) {
+        s = segment.Create(
+            std::max({sizer.size(), 2 * segment.size(), kMinSegmentSize}));
+        new_segment_fd = segment.fd();
+      }
+      if (s.ok()) {
+        SegmentWriter writer(segment.data());
+        WriteElement(result, components, writer);
+        response.element_size = writer.size();
+      }
+    }
+    response.code = s.code();
+    response.message_size = s.error_message().size();
+    return SendResponse(fd, response, new_segment_fd, s.error_message());
+  }
+
+  const GetElementT get_element_;
+  int listen_fd_ = -1;
+  int port_ = -1;
+  std::unique_ptr<Thread> accept_thread_;
+
+  mutex mu_;
+  std::vector<std::unique_ptr<Connection>> connections_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+// Reads elements from a `SharedMemoryTransferServer`. Concurrent requests use
+// separate connections, which are kept open for later requests.
+class SharedMemoryTransferClient : public DataTransferClient {
+ public:
+  explicit SharedMemoryTransferClient(int port) : port_(port) {
+    VLOG(2) << "Create SharedMemoryTransferClient for socket " << port_ << ".";
+  }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    VLOG(3) << "GetElement for task " << req.task_id()
+            << " from shared memory.";
+    std::unique_ptr<Connection> connection;
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+      if (!idle_connections_.empty()) {
+        connection = std::move(idle_connections_.back());
+        idle_connections_.pop_back();
+      }
+    }
+    if (!connection) {
+      TF_ASSIGN_OR_RETURN(connection, Connect());
+    }
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+      active_fds_.insert(connection->fd);
+    }
+    Status element_status;
+    Status s = Request(*connection, req, result, element_status);
+    mutex_lock l(mu_);
+    active_fds_.erase(connection->fd);
+    if (cancelled_) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    if (!s.ok()) {
+      // The connection may be in the middle of a message.
+      return s;
+    }
+    idle_connections_.push_back(std::move(connection));
+    return element_status;
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel SharedMemoryTransferClient.";
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (int fd : active_fds_) {
+      shutdown(fd, SHUT_RDWR);
+    }
+  }
+
+ private:
+  struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    const int fd;
+    Segment segment;
+  };
+
+  StatusOr<std::unique_ptr<Connection>> Connect() {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return IoError("create a socket");
+    }
+    auto connection = absl::make_unique<Connection>(fd);
+    sockaddr_un address;
+    const socklen_t address_size = MakeAddress(port_, address);
+    int result;
+    do {
+      result = connect(fd, reinterpret_cast<sockaddr*>(&address), address_size);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+      return IoError(absl::StrCat("connect to socket ", port_));
+    }
+    return connection;
+  }
+
+  // Sends `req`, and stores the element in `result` and the status of the
+  // request in `element_status`. Returns an error if the transfer fails.
+  Status Request(Connection& connection, const GetElementRequest& req,
+                 GetElementResult& result, Status& element_status) {
+    std::string serialized_request;
+    req.SerializeToString(&serialized_request);
+    RequestHeader header;
+    header.request_size = serialized_request.size();
+    TF_RETURN_IF_ERROR(WriteFully(
+        connection.fd, reinterpret_cast<const char*>(&header), sizeof(header)));
+    TF_RETURN_IF_ERROR(WriteFully(connection.fd, serialized_request.data(),
+                                  serialized_request.size()));
+    ResponseHeader response;
+    int segment_fd;
+    TF_RETURN_IF_ERROR(
+        ReceiveResponseHeader(connection.fd, response, segment_fd));
+    if (segment_fd >= 0) {
+      TF_RETURN_IF_ERROR(connection.segment.Map(segment_fd));
+    }
+    std::string message(response.message_size, '\0');
+    TF_RETURN_IF_ERROR(ReadFully(connection.fd, &message[0], message.size()));
+    if (response.code != error::OK) {
+      element_status =
+          Status(static_cast<error::Code>(response.code), message);
+      return Status::OK();
+    }
+    if (response.element_size > connection.segment.size()) {
+      return errors::DataLoss("Element of ", response.element_size,
+                              " bytes is larger than its segment.");
+    }
+    element_status = ReadElement(connection.segment.data(),
+                                 response.element_size, result);
+    return Status::OK();
+  }
+
+  const int port_;
+  mutex mu_;
+  std::vector<std::unique_ptr<Connection>> idle_connections_
+      TF_GUARDED_BY(mu_);
+  // The sockets of the requests in progress, to cancel them.
+  absl::flat_hash_set<int> active_fds_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+class SharedMemoryTransferRegistrar {
+ public:
+  SharedMemoryTransferRegistrar() {
+    DataTransferServer::Register(
+        kSharedMemoryTransferProtocol,
+        [](DataTransferServer::GetElementT get_element) {
+          return std::make_shared<SharedMemoryTransferServer>(
+              std::move(get_element));
+        });
+    DataTransferClient::Register(
+        kSharedMemoryTransferProtocol,
+        [](DataTransferClient::Config config,
+           std::unique_ptr<DataTransferClient>* out) {
+          // Only the port of the address names the socket.
+          absl::string_view address = config.address;
+          int port;
+          if (!absl::SimpleAtoi(address.substr(address.rfind(':') + 1),
+                                &port)) {
+            return errors::InvalidArgument(
+                "Shared memory transfer address ", config.address,
+                " doesn't end with a port.");
+          }
+          *out = absl::make_unique<SharedMemoryTransferClient>(port);
+          return Status::OK();
+        });
+  }
+};
+static SharedMemoryTransferRegistrar shared_memory_transfer_registrar;
+
+}  // namespace
+#endif  // defined(__linux__)
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,36 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+
+namespace tensorflow {
+namespace data {
+
+// Transfers elements between processes on the same host through shared
+// memory. Workers started with this data transfer protocol serve elements on
+// a Unix domain socket, named by the port of their transfer address, and
+// write each element into a shared memory segment which the client maps, so
+// that the tensor data is copied once instead of being serialized through the
+// network stack. Set the worker's `data_transfer_address` to e.g.
+// "localhost:%port%".
+//
+// Only reachable from the same host. Clients using this protocol read from
+// workers on other hosts with gRPC. Only supported on Linux.
+constexpr const char kSharedMemoryTransferProtocol[] = "shm";
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/test.h"
+
+#if defined(__linux__)
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Serves the elements in `elements_` by task id.
+class SharedMemoryTransferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(DataTransferServer::Build(
+        kSharedMemoryTransferProtocol,
+        [this](const GetElementRequest* request, GetElementResult* result) {
+          if (request->task_id() >= static_cast<int64_t>(elements_.size())) {
+            return errors::NotFound("Task ", request->task_id(), " not found");
+          }
+          result->components = elements_[request->task_id()];
+          result->element_index = request->task_id();
+          result->end_of_sequence = result->components.empty();
+          result->skip = false;
+          return Status::OK();
+        },
+        &server_));
+    TF_ASSERT_OK(server_->Start());
+    TF_ASSERT_OK(DataTransferClient::Build(
+        kSharedMemoryTransferProtocol,
+        {/*protocol=*/"grpc",
+         /*address=*/absl::StrCat("localhost:", server_->get_port())},
+        &client_));
+  }
+
+  Status GetElement(int64_t task_id, GetElementResult& result) {
+    GetElementRequest request;
+    request.set_task_id(task_id);
+    return client_->GetElement(request, result);
+  }
+
+  std::vector<std::vector<Tensor>> elements_;
+  std::shared_ptr<DataTransferServer> server_;
+  std::unique_ptr<DataTransferClient> client_;
+};
+
+TEST_F(SharedMemoryTransferTest, TransfersTensors) {
+  elements_.push_back({test::AsTensor<int64_t>({1, 2, 3, 4}, {2, 2}),
+                       test::AsTensor<tstring>({"a", "bc"}),
+                       test::AsScalar<float>(0.5)});
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(0, result));
+  EXPECT_FALSE(result.end_of_sequence);
+  EXPECT_EQ(result.element_index, 0);
+  ASSERT_EQ(result.components.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectEqual(result.components[i], elements_[0][i]);
+  }
+}
+
+TEST_F(SharedMemoryTransferTest, TransfersCompressedElements) {
+  std::vector<Tensor> element = {test::AsTensor<int32>({1, 2, 3})};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, &compressed));
+  Tensor tensor(DT_VARIANT, TensorShape{});
+  tensor.scalar<Variant>()() = compressed;
+  elements_.push_back({tensor});
+
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(0, result));
+  ASSERT_EQ(result.components.size(), 1);
+  const CompressedElement* received =
+      result.components[0].scalar<Variant>()().get<CompressedElement>();
+  ASSERT_NE(received, nullptr);
+  std::vector<Tensor> uncompressed;
+  TF_ASSERT_OK(UncompressElement(*received, &uncompressed));
+  ASSERT_EQ(uncompressed.size(), 1);
+  test::ExpectEqual(uncompressed[0], element[0]);
+}
+
+TEST_F(SharedMemoryTransferTest, GrowsSegment) {
+  elements_.push_back({test::AsScalar<int64_t>(7)});
+  elements_.push_back({Tensor(DT_FLOAT, TensorShape({1 << 20}))});
+  elements_[1][0].flat<float>().setConstant(1.5);
+  for (int64_t task_id : {0, 1, 0}) {
+    GetElementResult result;
+    TF_ASSERT_OK(GetElement(task_id, result));
+    ASSERT_EQ(result.components.size(), 1);
+    test::ExpectEqual(result.components[0], elements_[task_id][0]);
+  }
+}
+
+TEST_F(SharedMemoryTransferTest, EndOfSequence) {
+  elements_.push_back({});
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(0, result));
+  EXPECT_TRUE(result.end_of_sequence);
+  EXPECT_TRUE(result.components.empty());
+}
+
+TEST_F(SharedMemoryTransferTest, ForwardsErrors) {
+  GetElementResult result;
+  Status s = GetElement(3, result);
+  EXPECT_TRUE(errors::IsNotFound(s)) << s;
+  EXPECT_EQ(s.error_message(), "Task 3 not found");
+  // The connection is still usable.
+  elements_.push_back({test::AsScalar<int64_t>(7)});
+  TF_ASSERT_OK(GetElement(0, result));
+}
+
+TEST_F(SharedMemoryTransferTest, Cancel) {
+  client_->TryCancel();
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsCancelled(GetElement(0, result)));
+}
+
+TEST(SharedMemoryTransferClientTest, MissingServer) {
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(DataTransferClient::Build(kSharedMemoryTransferProtocol,
+                                         {"grpc", "localhost:0"}, &client));
+  GetElementRequest request;
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsUnavailable(client->GetElement(request, result)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // defined(__linux__)
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/task_runner.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -134,6 +135,10 @@ void FirstComeFirstServedTaskRunner::Cancel() {
   buffer_.Cancel(errors::Cancelled("tf.data service FCFS task is cancelled."));
 }
 
+double FirstComeFirstServedTaskRunner::BufferFullness() {
+  return buffer_.Fullness();
+}
+
 RoundRobinTaskRunner::RoundRobinTaskRunner(
     std::unique_ptr<TaskIterator> iterator, int64_t num_consumers,
     string worker_address)
@@ -267,6 +272,10 @@ void RoundRobinTaskRunner::Cancel() {
   new_round_cv_.notify_all();
 }
 
+double RoundRobinTaskRunner::BufferFullness() {
+  return prefetch_thread_.BufferFullness();
+}
+
 PrefetchThread::PrefetchThread(std::unique_ptr<TaskIterator> iterator,
                                int64_t round_size)
     : iterator_(std::move(iterator)), round_size_(round_size) {
@@ -348,5 +357,155 @@ Status PrefetchThread::GetStatus() {
   mutex_lock l(mu_);
   return status_;
 }
+
+double PrefetchThread::BufferFullness() {
+  mutex_lock l(mu_);
+  return static_cast<double>(buffer_.size()) / round_size_;
+}
+
+SharedElementCache::SharedElementCache(std::unique_ptr<TaskIterator> iterator,
+                                       int64_t max_size_bytes)
+    : iterator_(std::move(iterator)), max_size_bytes_(max_size_bytes) {
+  VLOG(1) << "Creating shared element cache of up to " << max_size_bytes
+          << " bytes";
+  producer_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+      /*thread_options=*/{}, /*name=*/"tf_data_service_shared_element_cache",
+      [this] { RunProducer(); }));
+}
+
+SharedElementCache::~SharedElementCache() {
+  Cancel();
+  // Joins the producer thread before `iterator_` is destroyed.
+  producer_thread_.reset();
+}
+
+void SharedElementCache::RegisterConsumer(int64_t consumer_id) {
+  mutex_lock l(mu_);
+  next_indices_.emplace(consumer_id, first_index_);
+}
+
+void SharedElementCache::UnregisterConsumer(int64_t consumer_id) {
+  mutex_lock l(mu_);
+  if (next_indices_.erase(consumer_id) > 0) {
+    EvictReadElements();
+    cv_.notify_all();
+  }
+}
+
+StatusOr<GetElementResult> SharedElementCache::GetNext(int64_t consumer_id) {
+  mutex_lock l(mu_);
+  while (true) {
+    if (cancelled_) {
+      return errors::Cancelled(
+          "tf.data service shared element cache is cancelled.");
+    }
+    auto it = next_indices_.find(consumer_id);
+    if (it == next_indices_.end()) {
+      return errors::Cancelled("Consumer ", consumer_id,
+                               " is not reading from the shared element "
+                               "cache.");
+    }
+    const int64_t index = it->second;
+    if (index < first_index_ + static_cast<int64_t>(window_.size())) {
+      GetElementResult result;
+      result.components = window_[index - first_index_].components;
+      result.element_index = index;
+      result.end_of_sequence = false;
+      result.skip = false;
+      ++it->second;
+      EvictReadElements();
+      return result;
+    }
+    TF_RETURN_IF_ERROR(status_);
+    if (end_of_sequence_) {
+      GetElementResult result;
+      result.element_index = index;
+      result.end_of_sequence = true;
+      result.skip = false;
+      return result;
+    }
+    cv_.wait(l);
+  }
+}
+
+void SharedElementCache::Cancel() {
+  VLOG(2) << "Cancelling tf.data service shared element cache.";
+  mutex_lock l(mu_);
+  cancelled_ = true;
+  cv_.notify_all();
+}
+
+void SharedElementCache::RunProducer() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      // An element is always admitted into an empty window, so that elements
+      // larger than `max_size_bytes_` are still produced.
+      while (!cancelled_ && !window_.empty() &&
+             size_bytes_ >= max_size_bytes_) {
+        cv_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    Status s = iterator_->GetNext(element, end_of_sequence);
+    mutex_lock l(mu_);
+    if (!s.ok() || end_of_sequence) {
+      status_ = s;
+      end_of_sequence_ = end_of_sequence;
+      cv_.notify_all();
+      return;
+    }
+    int64_t size_bytes = 0;
+    for (const Tensor& component : element) {
+      size_bytes += component.TotalBytes();
+    }
+    window_.push_back({std::move(element), size_bytes});
+    size_bytes_ += size_bytes;
+    cv_.notify_all();
+  }
+}
+
+void SharedElementCache::EvictReadElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Without consumers, the window is kept for consumers that register later.
+  if (next_indices_.empty()) {
+    return;
+  }
+  int64_t min_next_index = kint64max;
+  for (const auto& consumer : next_indices_) {
+    min_next_index = std::min(min_next_index, consumer.second);
+  }
+  bool evicted = false;
+  while (!window_.empty() && first_index_ < min_next_index) {
+    size_bytes_ -= window_.front().size_bytes;
+    window_.pop_front();
+    ++first_index_;
+    evicted = true;
+  }
+  if (evicted) {
+    cv_.notify_all();
+  }
+}
+
+SharedElementCacheTaskRunner::SharedElementCacheTaskRunner(
+    std::shared_ptr<SharedElementCache> cache, int64_t consumer_id)
+    : cache_(std::move(cache)), consumer_id_(consumer_id) {
+  cache_->RegisterConsumer(consumer_id_);
+}
+
+SharedElementCacheTaskRunner::~SharedElementCacheTaskRunner() { Cancel(); }
+
+Status SharedElementCacheTaskRunner::GetNext(const GetElementRequest& req,
+                                             GetElementResult& result) {
+  TF_ASSIGN_OR_RETURN(result, cache_->GetNext(consumer_id_));
+  return Status::OK();
+}
+
+void SharedElementCacheTaskRunner::Cancel() {
+  cache_->UnregisterConsumer(consumer_id_);
+}
 }  // namespace data
 }  // namespace tensorflow
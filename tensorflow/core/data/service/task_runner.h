@@ -15,9 +15,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 
+#include <deque>
 #include <memory>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/thread_safe_buffer.h"
@@ -76,6 +78,9 @@ class TaskRunner {
                          GetElementResult& result) = 0;
   // Cancels in-progress `GetNext` requests.
   virtual void Cancel() = 0;
+  // Returns the fraction of the runner's buffer holding elements ready to be
+  // served, between 0 and 1, or a negative value if the runner has no buffer.
+  virtual double BufferFullness() { return -1.0; }
 };
 
 // A task runner which provides elements on a first-come first-served basis.
@@ -89,6 +94,7 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
   Status GetNext(const GetElementRequest& req,
                  GetElementResult& result) override;
   void Cancel() override;
+  double BufferFullness() override;
 
  private:
   // Function to continually prefetch the next element. Returns an error if the
@@ -138,6 +144,8 @@ class PrefetchThread {
                     std::vector<std::unique_ptr<Element>>& out);
   // Returns the status for any failures encountered by the prefetch thread.
   Status GetStatus();
+  // Returns the fraction of the next round that is already prefetched.
+  double BufferFullness();
 
  private:
   const std::unique_ptr<TaskIterator> iterator_;
@@ -182,6 +190,7 @@ class RoundRobinTaskRunner : public TaskRunner {
   Status GetNext(const GetElementRequest& req,
                  GetElementResult& result) override;
   void Cancel() override;
+  double BufferFullness() override;
 
  private:
   // Prepares a full round of data. `wait_us` indicates how long to wait before
@@ -215,6 +224,82 @@ class RoundRobinTaskRunner : public TaskRunner {
   PrefetchThread prefetch_thread_;
 };
 
+// A bounded sliding window over the elements of a task iterator, shared by the
+// tasks of several jobs reading the same dataset. A single producer thread
+// reads the iterator into the window, and each consumer reads the window at its
+// own pace. Elements leave the window once every consumer has read them, and
+// the producer waits while the window holds `max_size_bytes` or more, so the
+// slowest consumer determines the window's memory use.
+class SharedElementCache {
+ public:
+  SharedElementCache(std::unique_ptr<TaskIterator> iterator,
+                     int64_t max_size_bytes);
+  ~SharedElementCache();
+
+  // Adds a consumer, which starts reading at the oldest element in the window.
+  void RegisterConsumer(int64_t consumer_id);
+  // Removes a consumer, so that it no longer holds elements in the window.
+  // Blocked `GetNext` calls of the consumer return a `Cancelled` error.
+  void UnregisterConsumer(int64_t consumer_id);
+  // Gets the next element for `consumer_id`, waiting until it is produced.
+  StatusOr<GetElementResult> GetNext(int64_t consumer_id);
+  // Cancels the producer and in-progress `GetNext` requests.
+  void Cancel();
+
+ private:
+  struct CachedElement {
+    std::vector<Tensor> components;
+    int64_t size_bytes;
+  };
+
+  // Reads elements into the window until the end of the iterator, an error,
+  // or cancellation.
+  void RunProducer();
+  // Drops the elements at the front of the window that every consumer has read.
+  void EvictReadElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Only accessed by the producer thread.
+  const std::unique_ptr<TaskIterator> iterator_;
+  const int64_t max_size_bytes_;
+  mutex mu_;
+  // Notified when elements are added to or removed from `window_`, when a
+  // consumer is removed, and when the producer finishes.
+  condition_variable cv_;
+  std::deque<CachedElement> window_ TF_GUARDED_BY(mu_);
+  // The index of the element at the front of `window_`.
+  int64_t first_index_ TF_GUARDED_BY(mu_) = 0;
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // The index of the next element to read, keyed by consumer id.
+  absl::flat_hash_map<int64_t, int64_t> next_indices_ TF_GUARDED_BY(mu_);
+  // Whether the producer has reached the end of the iterator.
+  bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
+  // The status if the producer fails.
+  Status status_ TF_GUARDED_BY(mu_) = Status::OK();
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> producer_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedElementCache);
+};
+
+// A task runner which reads the elements of a `SharedElementCache` as one of
+// its consumers.
+class SharedElementCacheTaskRunner : public TaskRunner {
+ public:
+  // Registers `consumer_id` with `cache`. Consumer ids must be unique within
+  // the cache, e.g. the ids of the tasks reading from it.
+  SharedElementCacheTaskRunner(std::shared_ptr<SharedElementCache> cache,
+                               int64_t consumer_id);
+  ~SharedElementCacheTaskRunner() override;
+
+  Status GetNext(const GetElementRequest& req,
+                 GetElementResult& result) override;
+  void Cancel() override;
+
+ private:
+  const std::shared_ptr<SharedElementCache> cache_;
+  const int64_t consumer_id_;
+};
+
 }  // namespace data
 }  // namespace tensorflow
 
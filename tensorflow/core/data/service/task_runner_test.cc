@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -180,6 +181,106 @@ TEST(FirstComeFirstServedTaskRunnerTest, Error) {
               testing::StatusIs(error::ABORTED));
 }
 
+TEST(SharedElementCacheTest, ConsumersReadAllElements) {
+  std::vector<std::vector<Tensor>> elements = GetRangeDataset(10);
+  auto cache = std::make_shared<SharedElementCache>(
+      absl::make_unique<TestTaskIterator>(elements, /*repeat=*/false),
+      /*max_size_bytes=*/1 << 20);
+  SharedElementCacheTaskRunner runner1(cache, /*consumer_id=*/1);
+  SharedElementCacheTaskRunner runner2(cache, /*consumer_id=*/2);
+  for (SharedElementCacheTaskRunner* runner : {&runner1, &runner2}) {
+    for (auto& expected_element : elements) {
+      GetElementResult result;
+      TF_ASSERT_OK(runner->GetNext(GetElementRequest(), result));
+      ASSERT_FALSE(result.end_of_sequence);
+      ASSERT_EQ(result.components.size(), 1);
+      test::ExpectEqual(result.components[0], expected_element[0]);
+    }
+    GetElementResult result;
+    TF_ASSERT_OK(runner->GetNext(GetElementRequest(), result));
+    EXPECT_TRUE(result.end_of_sequence);
+  }
+}
+
+TEST(SharedElementCacheTest, LateConsumerStartsAtOldestElement) {
+  std::vector<std::vector<Tensor>> elements = GetRangeDataset(10);
+  auto cache = std::make_shared<SharedElementCache>(
+      absl::make_unique<TestTaskIterator>(elements, /*repeat=*/true),
+      /*max_size_bytes=*/1 << 20);
+  SharedElementCacheTaskRunner fast_runner(cache, /*consumer_id=*/1);
+  SharedElementCacheTaskRunner slow_runner(cache, /*consumer_id=*/2);
+  GetElementResult result;
+  for (int i = 0; i < 5; ++i) {
+    TF_ASSERT_OK(fast_runner.GetNext(GetElementRequest(), result));
+  }
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(slow_runner.GetNext(GetElementRequest(), result));
+  }
+  // The slow consumer still needs element 2.
+  SharedElementCacheTaskRunner late_runner(cache, /*consumer_id=*/3);
+  TF_ASSERT_OK(late_runner.GetNext(GetElementRequest(), result));
+  EXPECT_EQ(result.element_index, 2);
+  test::ExpectEqual(result.components[0], elements[2][0]);
+}
+
+TEST(SharedElementCacheTest, SlowestConsumerBoundsWindow) {
+  std::vector<std::vector<Tensor>> elements = GetRangeDataset(10);
+  auto cache = std::make_shared<SharedElementCache>(
+      absl::make_unique<TestTaskIterator>(elements, /*repeat=*/true),
+      /*max_size_bytes=*/3 * sizeof(int64_t));
+  SharedElementCacheTaskRunner fast_runner(cache, /*consumer_id=*/1);
+  SharedElementCacheTaskRunner slow_runner(cache, /*consumer_id=*/2);
+  GetElementResult result;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(fast_runner.GetNext(GetElementRequest(), result));
+  }
+  // The window is full until the slow consumer reads element 0.
+  Notification fast_consumer_done;
+  std::unique_ptr<Thread> fast_consumer(Env::Default()->StartThread(
+      /*thread_options=*/{}, /*name=*/"fast_consumer", [&] {
+        GetElementResult fast_result;
+        TF_ASSERT_OK(fast_runner.GetNext(GetElementRequest(), fast_result));
+        EXPECT_EQ(fast_result.element_index, 3);
+        fast_consumer_done.Notify();
+      }));
+  EXPECT_FALSE(WaitForNotificationWithTimeout(&fast_consumer_done,
+                                              /*timeout_in_us=*/100 * 1000));
+  TF_ASSERT_OK(slow_runner.GetNext(GetElementRequest(), result));
+  EXPECT_EQ(result.element_index, 0);
+  fast_consumer_done.WaitForNotification();
+}
+
+TEST(SharedElementCacheTest, CancelConsumer) {
+  std::vector<std::vector<Tensor>> elements = GetRangeDataset(10);
+  auto cache = std::make_shared<SharedElementCache>(
+      absl::make_unique<TestTaskIterator>(elements, /*repeat=*/true),
+      /*max_size_bytes=*/3 * sizeof(int64_t));
+  SharedElementCacheTaskRunner runner1(cache, /*consumer_id=*/1);
+  SharedElementCacheTaskRunner runner2(cache, /*consumer_id=*/2);
+  runner2.Cancel();
+  GetElementResult result;
+  EXPECT_THAT(runner2.GetNext(GetElementRequest(), result),
+              testing::StatusIs(error::CANCELLED));
+  // The cancelled consumer no longer holds elements in the window.
+  for (int i = 0; i < 20; ++i) {
+    TF_ASSERT_OK(runner1.GetNext(GetElementRequest(), result));
+    test::ExpectEqual(result.components[0], elements[i % 10][0]);
+  }
+}
+
+TEST(SharedElementCacheTest, Error) {
+  auto cache = std::make_shared<SharedElementCache>(
+      absl::make_unique<TestErrorIterator>(errors::Aborted("Aborted")),
+      /*max_size_bytes=*/1 << 20);
+  SharedElementCacheTaskRunner runner1(cache, /*consumer_id=*/1);
+  SharedElementCacheTaskRunner runner2(cache, /*consumer_id=*/2);
+  GetElementResult result;
+  EXPECT_THAT(runner1.GetNext(GetElementRequest(), result),
+              testing::StatusIs(error::ABORTED));
+  EXPECT_THAT(runner2.GetNext(GetElementRequest(), result),
+              testing::StatusIs(error::ABORTED));
+}
+
 class ConsumeParallelTest
     : public ::testing::Test,
       public ::testing::WithParamInterface<std::tuple<int64_t, int64_t>> {};
@@ -49,6 +49,9 @@ class TestCluster {
     int64_t client_timeout_ms = 0;
     int64_t job_gc_check_interval_ms = 0;
     int64_t job_gc_timeout_ms = 0;
+    // The data transfer protocol of the workers. If empty, workers only serve
+    // their gRPC service.
+    std::string data_transfer_protocol;
   };
 
   // Creates a new test cluster with a dispatcher and `num_workers` workers.
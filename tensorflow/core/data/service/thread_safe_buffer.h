@@ -46,6 +46,9 @@ class ThreadSafeBuffer final {
   // REQUIRES: !status.ok()
   void Cancel(Status status);
 
+  // Returns the fraction of the buffer holding elements, between 0 and 1.
+  double Fullness();
+
  private:
   const size_t buffer_size_;
 
@@ -105,6 +108,12 @@ void ThreadSafeBuffer<T>::Cancel(Status status) {
   ready_to_pop_.notify_all();
 }
 
+template <class T>
+double ThreadSafeBuffer<T>::Fullness() {
+  mutex_lock l(mu_);
+  return static_cast<double>(results_.size()) / buffer_size_;
+}
+
 }  // namespace data
 }  // namespace tensorflow
 
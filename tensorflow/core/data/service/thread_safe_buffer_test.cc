@@ -224,6 +224,19 @@ TEST_P(ThreadSafeBufferTest, CancelMultipleTimes) {
               StatusIs(error::RESOURCE_EXHAUSTED));
 }
 
+TEST_P(ThreadSafeBufferTest, Fullness) {
+  ThreadSafeBuffer<int> buffer(GetBufferSize());
+  EXPECT_EQ(buffer.Fullness(), 0.0);
+  for (int i = 0; i < GetBufferSize(); ++i) {
+    TF_ASSERT_OK(buffer.Push(i));
+    EXPECT_DOUBLE_EQ(buffer.Fullness(),
+                     static_cast<double>(i + 1) / GetBufferSize());
+  }
+  TF_ASSERT_OK(buffer.Pop().status());
+  EXPECT_DOUBLE_EQ(buffer.Fullness(),
+                   static_cast<double>(GetBufferSize() - 1) / GetBufferSize());
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/worker_client.h"
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,10 +25,12 @@ limitations under the License.
 #include "grpcpp/security/credentials.h"
 #include "grpcpp/support/channel_arguments.h"
 #include "grpcpp/support/status.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
 #include "tensorflow/core/data/service/data_transfer.h"
@@ -49,6 +52,41 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+// The number of elements that a streaming client lets a worker send ahead of
+// the client's reads.
+constexpr int64_t kStreamCreditWindow = 32;
+// The maximum number of elements in a response of a `GetElements` stream.
+constexpr int64_t kStreamMaxBatchSize = 8;
+
+// Stores the element of `resp` in `result`.
+Status ParseGetElementResponse(GetElementResponse& resp,
+                               GetElementResult& result) {
+  result.end_of_sequence = resp.end_of_sequence();
+  result.skip = resp.skip_task();
+  switch (resp.element_case()) {
+    case GetElementResponse::kCompressed: {
+      Tensor tensor(DT_VARIANT, TensorShape{});
+      tensor.scalar<Variant>()() = std::move(resp.compressed());
+      result.components.push_back(tensor);
+      break;
+    }
+    case GetElementResponse::kUncompressed:
+      for (const auto& component : resp.uncompressed().components()) {
+        result.components.emplace_back();
+        if (!result.components.back().FromProto(component)) {
+          return errors::Internal("Failed to parse tensor.");
+        }
+      }
+      break;
+    case GetElementResponse::ELEMENT_NOT_SET:
+      break;
+  }
+  return Status::OK();
+}
+
+}  // namespace
 
 StatusOr<std::unique_ptr<DataServiceWorkerClient>>
 CreateDataServiceWorkerClient(const std::string& address,
@@ -77,7 +115,9 @@ Status DataServiceWorkerClient::EnsureInitialized() {
 }
 
 std::string DataServiceWorkerClient::GetDataTransferProtocol() const {
-  if (transfer_protocol_ == kGrpcTransferProtocol &&
+  if ((transfer_protocol_ == kGrpcTransferProtocol ||
+       transfer_protocol_ == kGrpcStreamingTransferProtocol ||
+       transfer_protocol_ == kGrpcCompressedStreamingTransferProtocol) &&
       LocalWorkers::Get(address_) != nullptr) {
     return kLocalTransferProtocol;
   }
@@ -114,26 +154,6 @@ class GrpcDataTransferClient : public DataTransferClient {
     }
     GetElementResponse resp;
     grpc::Status s = stub_->GetElement(&ctx, req, &resp);
-    result.end_of_sequence = resp.end_of_sequence();
-    result.skip = resp.skip_task();
-    switch (resp.element_case()) {
-      case GetElementResponse::kCompressed: {
-        Tensor tensor(DT_VARIANT, TensorShape{});
-        tensor.scalar<Variant>()() = std::move(resp.compressed());
-        result.components.push_back(tensor);
-        break;
-      }
-      case GetElementResponse::kUncompressed:
-        for (const auto& component : resp.uncompressed().components()) {
-          result.components.emplace_back();
-          if (!result.components.back().FromProto(component)) {
-            return errors::Internal("Failed to parse tensor.");
-          }
-        }
-        break;
-      case GetElementResponse::ELEMENT_NOT_SET:
-        break;
-    }
     {
       mutex_lock l(mu_);
       active_contexts_.erase(&ctx);
@@ -141,7 +161,7 @@ class GrpcDataTransferClient : public DataTransferClient {
     if (!s.ok()) {
       return grpc_util::WrapError("Failed to get element", s);
     }
-    return Status::OK();
+    return ParseGetElementResponse(resp, result);
   }
 
   void TryCancel() override {
@@ -182,6 +202,197 @@ class GrpcTransferClientRegistrar {
 };
 static GrpcTransferClientRegistrar gprc_client_registrar;
 
+// Streams the elements of each task with a `GetElements` RPC. The client lets
+// the worker send up to `kStreamCreditWindow` elements ahead of its reads, in
+// batches of up to `kStreamMaxBatchSize` elements, so that small elements do
+// not cost an RPC each. Elements which are in flight when the client is
+// destroyed are dropped. Round-robin reads, which request specific rounds, use
+// `GetElement` RPCs.
+class GrpcStreamingDataTransferClient : public DataTransferClient {
+ public:
+  GrpcStreamingDataTransferClient(
+      std::shared_ptr<grpc::ChannelCredentials> credentials,
+      std::string address, bool compress)
+      : unary_client_(credentials, address), compress_(compress) {
+    VLOG(2) << "Create GrpcStreamingDataTransferClient for worker " << address
+            << ".";
+    grpc::ChannelArguments args;
+    args.SetMaxReceiveMessageSize(-1);
+    auto channel = grpc::CreateCustomChannel(address, credentials, args);
+    stub_ = WorkerService::NewStub(channel);
+  }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    if (req.optional_consumer_index_case() !=
+            GetElementRequest::OPTIONAL_CONSUMER_INDEX_NOT_SET ||
+        req.optional_round_index_case() !=
+            GetElementRequest::OPTIONAL_ROUND_INDEX_NOT_SET) {
+      return unary_client_.GetElement(req, result);
+    }
+    VLOG(3) << "GetElement for task " << req.task_id()
+            << " from gRPC worker stream.";
+    TF_ASSIGN_OR_RETURN(std::shared_ptr<Stream> stream,
+                        GetOrStartStream(req.task_id()));
+    mutex_lock l(stream->mu);
+    if (stream->buffer.empty()) {
+      Status s = ReadBatch(*stream);
+      if (!s.ok()) {
+        RemoveStream(req.task_id(), stream);
+        return s;
+      }
+    }
+    GetElementResponse resp = std::move(stream->buffer.front());
+    stream->buffer.pop_front();
+    if (resp.end_of_sequence()) {
+      RemoveStream(req.task_id(), stream);
+    } else if (++stream->num_consumed >= kStreamCreditWindow / 2) {
+      // Grants credits in bulk, to avoid a message per element.
+      GetElementsRequest credits;
+      credits.set_credits(stream->num_consumed);
+      stream->num_consumed = 0;
+      if (!stream->reader_writer->Write(credits)) {
+        RemoveStream(req.task_id(), stream);
+      }
+    }
+    return ParseGetElementResponse(resp, result);
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel GrpcStreamingDataTransferClient.";
+    unary_client_.TryCancel();
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (const auto& stream : streams_) {
+      stream.second->ctx.TryCancel();
+    }
+  }
+
+ private:
+  struct Stream {
+    ~Stream() {
+      ctx.TryCancel();
+      if (reader_writer) {
+        GetElementsResponse ignored;
+        while (reader_writer->Read(&ignored)) {
+        }
+        reader_writer->Finish().IgnoreError();
+      }
+    }
+
+    grpc::ClientContext ctx;
+    std::unique_ptr<
+        grpc::ClientReaderWriter<GetElementsRequest, GetElementsResponse>>
+        reader_writer;
+    mutex mu;
+    // Received elements which have not been read yet.
+    std::deque<GetElementResponse> buffer TF_GUARDED_BY(mu);
+    // The number of elements read since credits were last granted.
+    int64_t num_consumed TF_GUARDED_BY(mu) = 0;
+    MessageStreamUncompressor uncompressor TF_GUARDED_BY(mu);
+  };
+
+  StatusOr<std::shared_ptr<Stream>> GetOrStartStream(int64_t task_id)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    std::shared_ptr<Stream>& stream = streams_[task_id];
+    if (stream) {
+      return stream;
+    }
+    auto new_stream = std::make_shared<Stream>();
+    new_stream->reader_writer = stub_->GetElements(&new_stream->ctx);
+    GetElementsRequest request;
+    request.set_task_id(task_id);
+    request.set_credits(kStreamCreditWindow);
+    request.set_max_batch_size(kStreamMaxBatchSize);
+    request.set_compress(compress_);
+    if (!new_stream->reader_writer->Write(request)) {
+      grpc::Status s = new_stream->reader_writer->Finish();
+      new_stream->reader_writer.reset();
+      streams_.erase(task_id);
+      return grpc_util::WrapError("Failed to start streaming elements", s);
+    }
+    stream = new_stream;
+    return stream;
+  }
+
+  // Reads the next batch of elements of `stream` into its buffer.
+  Status ReadBatch(Stream& stream) TF_EXCLUSIVE_LOCKS_REQUIRED(stream.mu) {
+    GetElementsResponse response;
+    if (!stream.reader_writer->Read(&response)) {
+      grpc::Status s = stream.reader_writer->Finish();
+      stream.reader_writer.reset();
+      if (!s.ok()) {
+        return grpc_util::WrapError("Failed to get elements", s);
+      }
+      return errors::Unavailable(
+          "The worker ended the element stream before the end of the task.");
+    }
+    GetElementBatch batch;
+    if (response.batch_case() == GetElementsResponse::kCompressedElements) {
+      std::string serialized_batch;
+      TF_RETURN_IF_ERROR(stream.uncompressor.Uncompress(
+          response.compressed_elements(), &serialized_batch));
+      if (!batch.ParseFromString(serialized_batch)) {
+        return errors::DataLoss("Failed to parse a batch of elements.");
+      }
+    } else {
+      batch = std::move(*response.mutable_elements());
+    }
+    if (batch.elements_size() == 0) {
+      return errors::Internal("Received an empty batch of elements.");
+    }
+    for (GetElementResponse& element : *batch.mutable_elements()) {
+      stream.buffer.push_back(std::move(element));
+    }
+    return Status::OK();
+  }
+
+  // Stops streaming through `stream`. The next read of the task starts a new
+  // stream.
+  void RemoveStream(int64_t task_id, const std::shared_ptr<Stream>& stream)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    auto it = streams_.find(task_id);
+    if (it != streams_.end() && it->second == stream) {
+      streams_.erase(it);
+    }
+  }
+
+  GrpcDataTransferClient unary_client_;
+  const bool compress_;
+  std::unique_ptr<WorkerService::Stub> stub_;
+  mutex mu_;
+  // The streams of the tasks being read, keyed by task id.
+  absl::flat_hash_map<int64_t, std::shared_ptr<Stream>> streams_
+      TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+class GrpcStreamingTransferClientRegistrar {
+ public:
+  GrpcStreamingTransferClientRegistrar() {
+    for (bool compress : {false, true}) {
+      DataTransferClient::Register(
+          compress ? kGrpcCompressedStreamingTransferProtocol
+                   : kGrpcStreamingTransferProtocol,
+          [compress](DataTransferClient::Config config,
+                     std::unique_ptr<DataTransferClient>* out) {
+            std::shared_ptr<grpc::ChannelCredentials> credentials;
+            TF_RETURN_IF_ERROR(CredentialsFactory::CreateClientCredentials(
+                config.protocol, &credentials));
+            *out = std::make_unique<GrpcStreamingDataTransferClient>(
+                credentials, config.address, compress);
+            return Status::OK();
+          });
+    }
+  }
+};
+static GrpcStreamingTransferClientRegistrar grpc_streaming_client_registrar;
+
 class LocalDataTransferClient : public DataTransferClient {
  public:
   explicit LocalDataTransferClient(absl::string_view worker_address)
@@ -31,6 +31,12 @@ namespace data {
 
 constexpr const char kLocalTransferProtocol[] = "local";
 constexpr const char kGrpcTransferProtocol[] = "grpc";
+// Streams elements from the worker's gRPC service in batches, uncompressed or
+// compressed by a zlib stream spanning each RPC. Workers serve them with their
+// gRPC service, so they need no data transfer server.
+constexpr const char kGrpcStreamingTransferProtocol[] = "grpc_stream";
+constexpr const char kGrpcCompressedStreamingTransferProtocol[] =
+    "grpc_stream_zlib";
 
 // Client for communicating with the tf.data service worker.
 class DataServiceWorkerClient : public DataServiceClientBase {
@@ -56,7 +56,14 @@ constexpr const char kProtocol[] = "grpc";
 class WorkerClientTest : public ::testing::Test {
  protected:
   void SetUp() override {
-    test_cluster_ = absl::make_unique<TestCluster>(/*num_workers=*/1);
+    TestCluster::Config config;
+    config.num_workers = 1;
+    InitializeCluster(config);
+  }
+
+  // Replaces the test cluster with one created from `config`.
+  void InitializeCluster(const TestCluster::Config& config) {
+    test_cluster_ = absl::make_unique<TestCluster>(config);
     TF_ASSERT_OK(test_cluster_->Initialize());
     dispatcher_client_ = absl::make_unique<DataServiceDispatcherClient>(
         test_cluster_->DispatcherAddress(), kProtocol);
@@ -186,6 +193,58 @@ TEST_F(WorkerClientTest, GrpcRead) {
                        MatchesRegex("Local worker.*is no longer available.*")));
 }
 
+TEST_F(WorkerClientTest, GrpcStreamingRead) {
+  const int64_t range = 50;
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t dataset_id, RegisterDataset(range));
+  for (const char* protocol : {kGrpcStreamingTransferProtocol,
+                               kGrpcCompressedStreamingTransferProtocol}) {
+    TF_ASSERT_OK_AND_ASSIGN(const int64_t job_client_id,
+                            CreateJob(dataset_id));
+    TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                            GetTaskToRead(job_client_id));
+    // Without a local worker, the client reads through a `GetElements` stream.
+    LocalWorkers::Remove(GetWorkerAddress());
+    TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<DataServiceWorkerClient> client,
+                            GetWorkerClient(protocol));
+    for (int64_t i = 0; i < range; ++i) {
+      TF_ASSERT_OK_AND_ASSIGN(GetElementResult result,
+                              GetElement(*client, task_id));
+      test::ExpectEqual(result.components[0], Tensor(int64_t{i * i}));
+      EXPECT_FALSE(result.end_of_sequence);
+    }
+    TF_ASSERT_OK_AND_ASSIGN(GetElementResult result,
+                            GetElement(*client, task_id));
+    EXPECT_TRUE(result.end_of_sequence);
+  }
+}
+
+TEST_F(WorkerClientTest, WorkerWithStreamingTransferProtocol) {
+  const int64_t range = 5;
+  for (const char* protocol : {kGrpcStreamingTransferProtocol,
+                               kGrpcCompressedStreamingTransferProtocol}) {
+    // The worker serves the streaming protocols with its gRPC service, so it
+    // starts without a data transfer server.
+    TestCluster::Config config;
+    config.num_workers = 1;
+    config.data_transfer_protocol = protocol;
+    InitializeCluster(config);
+    TF_ASSERT_OK_AND_ASSIGN(const int64_t dataset_id, RegisterDataset(range));
+    TF_ASSERT_OK_AND_ASSIGN(const int64_t job_client_id,
+                            CreateJob(dataset_id));
+    TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                            GetTaskToRead(job_client_id));
+    LocalWorkers::Remove(GetWorkerAddress());
+    TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<DataServiceWorkerClient> client,
+                            GetWorkerClient(protocol));
+    for (int64_t i = 0; i < range; ++i) {
+      TF_ASSERT_OK_AND_ASSIGN(GetElementResult result,
+                              GetElement(*client, task_id));
+      test::ExpectEqual(result.components[0], Tensor(int64_t{i * i}));
+      EXPECT_FALSE(result.end_of_sequence);
+    }
+  }
+}
+
 TEST_F(WorkerClientTest, LocalServerShutsDown) {
   TF_ASSERT_OK_AND_ASSIGN(const int64_t dataset_id,
                           RegisterDataset(/*range=*/5));
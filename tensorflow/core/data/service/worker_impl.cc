@@ -51,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/status.h"
@@ -189,6 +190,11 @@ Status DataServiceWorkerImpl::ValidateWorkerConfig() const {
                       config_.worker_tags().end(), ", "),
         "}");
   }
+  if (config_.shared_element_cache_size_bytes() < 0) {
+    return errors::FailedPrecondition(
+        "shared_element_cache_size_bytes must be non-negative, got ",
+        config_.shared_element_cache_size_bytes());
+  }
   return Status::OK();
 }
 
@@ -282,21 +288,65 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
   if (task.initialized) {
     return Status::OK();
   }
-  TF_ASSIGN_OR_RETURN(DatasetDef dataset_def, GetDatasetDef(task.task_def));
-  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Dataset> dataset,
-                      MakeDataset(dataset_def, task.task_def));
-  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Iterator> iterator,
-                      MakeDatasetIterator(*dataset, task.task_def));
-  auto task_iterator = absl::make_unique<StandaloneTaskIterator>(
-      std::move(dataset), std::move(iterator));
-  TF_RETURN_IF_ERROR(TaskRunner::Create(
-      config_, task.task_def, std::move(task_iterator), task.task_runner));
+  if (SharesElements(task.task_def)) {
+    TF_ASSIGN_OR_RETURN(std::shared_ptr<SharedElementCache> cache,
+                        GetOrCreateSharedElementCache(task.task_def));
+    task.task_runner = absl::make_unique<SharedElementCacheTaskRunner>(
+        std::move(cache), task.task_def.task_id());
+  } else {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<TaskIterator> task_iterator,
+                        MakeTaskIterator(task.task_def));
+    TF_RETURN_IF_ERROR(TaskRunner::Create(
+        config_, task.task_def, std::move(task_iterator), task.task_runner));
+  }
 
   task.initialized = true;
   VLOG(3) << "Created iterator for task " << task.task_def.task_id();
   return Status::OK();
 }
 
+bool DataServiceWorkerImpl::SharesElements(const TaskDef& task_def) const {
+  // Round-robin tasks and sharded tasks produce job-specific elements.
+  return config_.shared_element_cache_size_bytes() > 0 &&
+         IsNoShard(task_def.processing_mode_def()) &&
+         task_def.optional_num_consumers_case() != TaskDef::kNumConsumers;
+}
+
+StatusOr<std::shared_ptr<SharedElementCache>>
+DataServiceWorkerImpl::GetOrCreateSharedElementCache(const TaskDef& task_def)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // The dispatcher gives datasets with the same fingerprint the same id, so the
+  // tasks of all jobs reading the same dataset find the same cache.
+  std::weak_ptr<SharedElementCache>& weak_cache =
+      shared_element_caches_[task_def.dataset_id()];
+  std::shared_ptr<SharedElementCache> cache = weak_cache.lock();
+  if (cache) {
+    VLOG(1) << "Task " << task_def.task_id()
+            << " reads from the shared element cache of dataset "
+            << task_def.dataset_id();
+    return cache;
+  }
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<TaskIterator> task_iterator,
+                      MakeTaskIterator(task_def));
+  cache = std::make_shared<SharedElementCache>(
+      std::move(task_iterator), config_.shared_element_cache_size_bytes());
+  weak_cache = cache;
+  return cache;
+}
+
+StatusOr<std::unique_ptr<TaskIterator>> DataServiceWorkerImpl::MakeTaskIterator(
+    const TaskDef& task_def) const {
+  TF_ASSIGN_OR_RETURN(DatasetDef dataset_def, GetDatasetDef(task_def));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Dataset> dataset,
+                      MakeDataset(dataset_def, task_def));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Iterator> iterator,
+                      MakeDatasetIterator(*dataset, task_def));
+  std::unique_ptr<TaskIterator> task_iterator =
+      absl::make_unique<StandaloneTaskIterator>(std::move(dataset),
+                                                std::move(iterator));
+  return task_iterator;
+}
+
 StatusOr<DatasetDef> DataServiceWorkerImpl::GetDatasetDef(
     const TaskDef& task_def) const {
   switch (task_def.dataset_case()) {
@@ -480,17 +530,28 @@ void DataServiceWorkerImpl::HeartbeatThread() TF_LOCKS_EXCLUDED(mu_) {
 }
 
 Status DataServiceWorkerImpl::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
+  WorkerHeartbeatRequest request;
   std::vector<int64_t> current_tasks;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
+      mutex_lock task_lock(task.second->mu);
+      if (!task.second->initialized) {
+        continue;
+      }
+      const double fullness = task.second->task_runner->BufferFullness();
+      if (fullness >= 0) {
+        TaskMetrics* metrics = request.add_task_metrics();
+        metrics->set_task_id(task.first);
+        metrics->set_buffer_fullness(fullness);
+      }
     }
   }
-  WorkerHeartbeatRequest request;
   request.set_worker_address(worker_address_);
   request.set_transfer_address(transfer_address_);
   *request.mutable_worker_tags() = config_.worker_tags();
+  request.set_worker_hostname(port::Hostname());
   *request.mutable_current_tasks() = {current_tasks.begin(),
                                       current_tasks.end()};
   TF_ASSIGN_OR_RETURN(WorkerHeartbeatResponse response,
@@ -99,7 +99,17 @@ class DataServiceWorkerImpl {
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
-  Status EnsureTaskInitialized(Task& task);
+  Status EnsureTaskInitialized(Task& task) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns whether `task_def` reads from a cache shared with the tasks of
+  // other jobs.
+  bool SharesElements(const TaskDef& task_def) const;
+  // Gets the cache shared by the tasks reading the dataset of `task_def`,
+  // creating it if no other task is reading from it.
+  StatusOr<std::shared_ptr<SharedElementCache>> GetOrCreateSharedElementCache(
+      const TaskDef& task_def) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Creates an iterator over the elements of the task.
+  StatusOr<std::unique_ptr<TaskIterator>> MakeTaskIterator(
+      const TaskDef& task_def) const;
   // Stops a task, cancelling the task's outstanding requests and waiting for
   // them to finish.
   void StopTask(Task& task) TF_LOCKS_EXCLUDED(mu_);
@@ -136,6 +146,10 @@ class DataServiceWorkerImpl {
   // Tasks deleted by the local client. If the client tries to read from them
   // again, the worker will return a non-retriable FailedPrecondition error.
   absl::flat_hash_set<int64_t> deleted_tasks_ TF_GUARDED_BY(mu_);
+  // Caches shared by the tasks of different jobs, keyed by dataset id. A cache
+  // is owned by the task runners reading from it.
+  absl::flat_hash_map<int64_t, std::weak_ptr<SharedElementCache>>
+      shared_element_caches_ TF_GUARDED_BY(mu_);
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
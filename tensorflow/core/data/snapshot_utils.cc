@@ -24,6 +24,8 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -60,6 +62,9 @@ constexpr const char* const kStartIndex = "start_index";
 
 }  // namespace
 
+/* static */ constexpr const uint64 RandomAccessWriter::kMagic;
+/* static */ constexpr const int64_t RandomAccessWriter::kChunkSizeBytes;
+/* static */ constexpr const size_t RandomAccessWriter::kTrailerSize;
 /* static */ constexpr const int64_t
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64_t
@@ -108,6 +113,10 @@ Status Writer::Create(Env* env, const std::string& filename,
       *out_writer =
           absl::make_unique<TFRecordWriter>(filename, compression_type);
       break;
+    case 3:
+      *out_writer = absl::make_unique<RandomAccessWriter>(
+          filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot writer version: ", version,
                                      " is not supported.");
@@ -334,6 +343,130 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
 }
 #endif  // TF_CORD_SUPPORT
 
+RandomAccessWriter::RandomAccessWriter(const std::string& filename,
+                                       const std::string& compression_type,
+                                       const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes),
+      footer_(absl::make_unique<experimental::SnapshotFileFooter>()) {}
+
+Status RandomAccessWriter::Initialize(tensorflow::Env* env) {
+  if (compression_type_ != io::compression::kNone) {
+    return errors::InvalidArgument(
+        "Snapshot file format version 3 does not support compression, got ",
+        compression_type_, ".");
+  }
+  return env->NewWritableFile(filename_, &dest_);
+}
+
+Status RandomAccessWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (tensors.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected ", dtypes_.size(),
+                                   " tensors per element, got ",
+                                   tensors.size(), ".");
+  }
+  for (int i = 0, end = tensors.size(); i < end; ++i) {
+    if (tensors[i].dtype() != dtypes_[i]) {
+      return errors::InvalidArgument(
+          "Expected a ", DataTypeString(dtypes_[i]), " tensor for component ",
+          i, ", got ", DataTypeString(tensors[i].dtype()), ".");
+    }
+    chunk_bytes_ += tensors[i].TotalBytes();
+  }
+  chunk_.push_back(tensors);
+  if (chunk_bytes_ >= kChunkSizeBytes) {
+    return WriteChunk();
+  }
+  return Status::OK();
+}
+
+Status RandomAccessWriter::WriteChunk() {
+  if (chunk_.empty()) {
+    return Status::OK();
+  }
+  experimental::SnapshotChunkIndex index;
+  for (int i = 0, end = chunk_.size(); i < end; ++i) {
+    index.add_elements();
+  }
+  for (int j = 0, num_components = dtypes_.size(); j < num_components; ++j) {
+    for (int i = 0, end = chunk_.size(); i < end; ++i) {
+      const Tensor& tensor = chunk_[i][j];
+      experimental::SnapshotChunkIndex::Element* element =
+          index.mutable_elements(i);
+      experimental::TensorMetadata* metadata = element->add_tensor_metadata();
+      tensor.shape().AsProto(metadata->mutable_tensor_shape());
+      if (DataTypeCanUseMemcpy(dtypes_[j])) {
+        TF_RETURN_IF_ERROR(Align());
+        const StringPiece data = tensor.tensor_data();
+        element->add_offsets(offset_);
+        metadata->set_tensor_size_bytes(data.size());
+        TF_RETURN_IF_ERROR(Append(data));
+      } else {
+        TensorProto proto;
+        tensor.AsProtoTensorContent(&proto);
+        const std::string serialized = proto.SerializeAsString();
+        element->add_offsets(offset_);
+        metadata->set_tensor_size_bytes(serialized.size());
+        TF_RETURN_IF_ERROR(Append(serialized));
+      }
+    }
+  }
+
+  const std::string serialized_index = index.SerializeAsString();
+  experimental::SnapshotFileFooter::Chunk* chunk = footer_->add_chunks();
+  chunk->set_index_offset(offset_);
+  chunk->set_index_size(serialized_index.size());
+  chunk->set_num_elements(chunk_.size());
+  TF_RETURN_IF_ERROR(Append(serialized_index));
+  chunk_.clear();
+  chunk_bytes_ = 0;
+  return Status::OK();
+}
+
+Status RandomAccessWriter::Append(StringPiece data) {
+  TF_RETURN_IF_ERROR(dest_->Append(data));
+  offset_ += data.size();
+  return Status::OK();
+}
+
+Status RandomAccessWriter::Align() {
+  static constexpr char kPadding[Allocator::kAllocatorAlignment] = {};
+  const size_t remainder = offset_ % Allocator::kAllocatorAlignment;
+  if (remainder == 0) {
+    return Status::OK();
+  }
+  return Append(
+      StringPiece(kPadding, Allocator::kAllocatorAlignment - remainder));
+}
+
+Status RandomAccessWriter::Sync() {
+  TF_RETURN_IF_ERROR(WriteChunk());
+  return dest_->Sync();
+}
+
+Status RandomAccessWriter::Close() {
+  if (dest_ != nullptr) {
+    TF_RETURN_IF_ERROR(WriteChunk());
+    const std::string serialized_footer = footer_->SerializeAsString();
+    TF_RETURN_IF_ERROR(Append(serialized_footer));
+    char trailer[kTrailerSize];
+    core::EncodeFixed64(trailer, serialized_footer.size());
+    core::EncodeFixed64(trailer + sizeof(uint64), kMagic);
+    TF_RETURN_IF_ERROR(Append(StringPiece(trailer, sizeof(trailer))));
+    TF_RETURN_IF_ERROR(dest_->Close());
+    dest_ = nullptr;
+  }
+  return Status::OK();
+}
+
+RandomAccessWriter::~RandomAccessWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close snapshot file " << filename_ << ": " << s;
+  }
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -351,6 +484,10 @@ Status Reader::Create(Env* env, const std::string& filename,
       *out_reader =
           absl::make_unique<TFRecordReader>(filename, compression_type, dtypes);
       break;
+    case 3:
+      *out_reader = absl::make_unique<RandomAccessReader>(
+          filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot reader version: ", version,
                                      " is not supported.");
@@ -500,13 +637,8 @@ class Reader::Dataset : public DatasetBase {
                                    current_checkpoint_id_);
     }
 
-    // TODO(frankchn): Optimize this to not parse every single element.
     Status AdvanceToStartIndex(IteratorContext* ctx) {
-      for (int64_t i = 0; i < start_index_; ++i) {
-        std::vector<Tensor> unused;
-        TF_RETURN_IF_ERROR(reader_->ReadTensors(&unused));
-      }
-      return Status::OK();
+      return reader_->SkipRecords(start_index_);
     }
 
     std::unique_ptr<Reader> reader_;
@@ -942,6 +1074,260 @@ Status CustomReader::ReadRecord(absl::Cord* record) {
 }
 #endif  // TF_CORD_SUPPORT
 
+// A memory-mapped snapshot file, shared by the reader that mapped it and the
+// tensors aliasing it.
+class MappedSnapshotFile : public core::RefCounted {
+ public:
+  explicit MappedSnapshotFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const { return static_cast<const char*>(region_->data()); }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+namespace {
+
+// A tensor buffer aliasing part of a mapped snapshot file.
+class MappedSnapshotTensorBuffer : public TensorBuffer {
+ public:
+  MappedSnapshotTensorBuffer(MappedSnapshotFile* file, uint64 offset,
+                             size_t size)
+      : TensorBuffer(const_cast<char*>(file->data()) + offset),
+        file_(file),
+        size_(size) {
+    file_->Ref();
+  }
+  ~MappedSnapshotTensorBuffer() override { file_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name("snapshot_mmap");
+  }
+  bool GetAllocatedBytes(size_t*) const override { return false; }
+
+  // The mapping is read-only, so the buffer must never be forwarded to a
+  // kernel that writes to it.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  MappedSnapshotFile* const file_;
+  const size_t size_;
+};
+
+}  // namespace
+
+RandomAccessReader::RandomAccessReader(const std::string& filename,
+                                       const string& compression_type,
+                                       const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes),
+      footer_(absl::make_unique<experimental::SnapshotFileFooter>()),
+      chunk_index_(absl::make_unique<experimental::SnapshotChunkIndex>()) {}
+
+RandomAccessReader::~RandomAccessReader() {}
+
+Status RandomAccessReader::Initialize(Env* env) {
+  if (compression_type_ != io::compression::kNone) {
+    return errors::InvalidArgument(
+        "Snapshot file format version 3 does not support compression, got ",
+        compression_type_, ".");
+  }
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename_, &file_size_));
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  Status s = env->NewReadOnlyMemoryRegionFromFile(filename_, &region);
+  if (s.ok() && region->length() == file_size_) {
+    mapped_file_.reset(new MappedSnapshotFile(std::move(region)));
+  } else {
+    VLOG(2) << "Reading snapshot file " << filename_
+            << " without mapping it: " << s;
+  }
+
+  constexpr size_t kTrailerSize = RandomAccessWriter::kTrailerSize;
+  if (file_size_ < kTrailerSize) {
+    return errors::DataLoss("Snapshot file ", filename_, " is truncated.");
+  }
+  char trailer_scratch[kTrailerSize];
+  StringPiece trailer;
+  TF_RETURN_IF_ERROR(Read(file_size_ - kTrailerSize, kTrailerSize,
+                          trailer_scratch, &trailer));
+  if (core::DecodeFixed64(trailer.data() + sizeof(uint64)) !=
+      RandomAccessWriter::kMagic) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " was not written with file format version 3.");
+  }
+  const uint64 footer_size = core::DecodeFixed64(trailer.data());
+  if (footer_size > file_size_ - kTrailerSize) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " has a corrupted footer.");
+  }
+  std::string footer_scratch(footer_size, '\0');
+  StringPiece footer;
+  TF_RETURN_IF_ERROR(Read(file_size_ - kTrailerSize - footer_size, footer_size,
+                          &footer_scratch[0], &footer));
+  if (!footer_->ParseFromArray(footer.data(), footer.size())) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " has a corrupted footer.");
+  }
+  chunk_starts_.reserve(footer_->chunks_size());
+  for (const auto& chunk : footer_->chunks()) {
+    chunk_starts_.push_back(num_elements_);
+    num_elements_ += chunk.num_elements();
+  }
+  return Status::OK();
+}
+
+Status RandomAccessReader::ReadTensors(std::vector<Tensor>* read_tensors) {
+  if (next_index_ >= num_elements_) {
+    return errors::OutOfRange("Reached the end of snapshot file ", filename_,
+                              ".");
+  }
+  TF_RETURN_IF_ERROR(ReadElement(next_index_, read_tensors));
+  ++next_index_;
+  return Status::OK();
+}
+
+Status RandomAccessReader::SkipRecords(int64_t num_records) {
+  if (num_records > num_elements_ - next_index_) {
+    next_index_ = num_elements_;
+    return errors::OutOfRange("Reached the end of snapshot file ", filename_,
+                              ".");
+  }
+  next_index_ += num_records;
+  return Status::OK();
+}
+
+Status RandomAccessReader::Seek(int64_t index) {
+  if (index < 0 || index > num_elements_) {
+    return errors::InvalidArgument("Cannot seek to element ", index,
+                                   " of snapshot file ", filename_, " with ",
+                                   num_elements_, " elements.");
+  }
+  next_index_ = index;
+  return Status::OK();
+}
+
+Status RandomAccessReader::ReadElement(int64_t index,
+                                       std::vector<Tensor>* read_tensors) {
+  if (index < 0 || index >= num_elements_) {
+    return errors::OutOfRange("Element ", index, " is out of range of ",
+                              "snapshot file ", filename_, " with ",
+                              num_elements_, " elements.");
+  }
+  const int64_t chunk =
+      std::upper_bound(chunk_starts_.begin(), chunk_starts_.end(), index) -
+      chunk_starts_.begin() - 1;
+  TF_RETURN_IF_ERROR(LoadChunkIndex(chunk));
+  const experimental::SnapshotChunkIndex::Element& element =
+      chunk_index_->elements(index - chunk_starts_[chunk]);
+  if (element.tensor_metadata_size() != dtypes_.size() ||
+      element.offsets_size() != dtypes_.size()) {
+    return errors::DataLoss("Element ", index, " of snapshot file ", filename_,
+                            " does not have ", dtypes_.size(),
+                            " components.");
+  }
+  read_tensors->reserve(read_tensors->size() + dtypes_.size());
+  for (int i = 0, end = dtypes_.size(); i < end; ++i) {
+    Tensor tensor;
+    TF_RETURN_IF_ERROR(ReadTensor(dtypes_[i], element.tensor_metadata(i),
+                                  element.offsets(i), &tensor));
+    read_tensors->push_back(std::move(tensor));
+  }
+  return Status::OK();
+}
+
+Status RandomAccessReader::LoadChunkIndex(int64_t chunk) {
+  if (chunk == loaded_chunk_) {
+    return Status::OK();
+  }
+  const experimental::SnapshotFileFooter::Chunk& chunk_info =
+      footer_->chunks(chunk);
+  std::string scratch(chunk_info.index_size(), '\0');
+  StringPiece data;
+  TF_RETURN_IF_ERROR(Read(chunk_info.index_offset(), chunk_info.index_size(),
+                          &scratch[0], &data));
+  loaded_chunk_ = -1;
+  if (!chunk_index_->ParseFromArray(data.data(), data.size()) ||
+      chunk_index_->elements_size() != chunk_info.num_elements()) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " has a corrupted index for chunk ", chunk, ".");
+  }
+  loaded_chunk_ = chunk;
+  return Status::OK();
+}
+
+Status RandomAccessReader::ReadTensor(
+    DataType dtype, const experimental::TensorMetadata& metadata,
+    uint64 offset, Tensor* tensor) {
+  const uint64 size = metadata.tensor_size_bytes();
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    std::string scratch(size, '\0');
+    StringPiece data;
+    TF_RETURN_IF_ERROR(Read(offset, size, &scratch[0], &data));
+    TensorProto proto;
+    if (!proto.ParseFromArray(data.data(), data.size()) ||
+        !tensor->FromProto(proto)) {
+      return errors::DataLoss("Unable to parse tensor from stored proto.");
+    }
+    return Status::OK();
+  }
+
+  if (!TensorShape::IsValid(metadata.tensor_shape())) {
+    return errors::DataLoss("Invalid tensor shape in snapshot file ",
+                            filename_, ".");
+  }
+  const TensorShape shape(metadata.tensor_shape());
+  if (shape.num_elements() * DataTypeSize(dtype) != size) {
+    return errors::DataLoss("Tensor of shape ", shape.DebugString(),
+                            " in snapshot file ", filename_, " has ", size,
+                            " bytes.");
+  }
+  if (size > 0 && mapped_file_ != nullptr && offset <= file_size_ &&
+      size <= file_size_ - offset &&
+      reinterpret_cast<uintptr_t>(mapped_file_->data() + offset) %
+              Allocator::kAllocatorAlignment ==
+          0) {
+    core::RefCountPtr<TensorBuffer> buf(
+        new MappedSnapshotTensorBuffer(mapped_file_.get(), offset, size));
+    *tensor = Tensor(dtype, shape, std::move(buf));
+    return Status::OK();
+  }
+  *tensor = Tensor(dtype, shape);
+  if (size == 0) {
+    return Status::OK();
+  }
+  char* buf = const_cast<char*>(tensor->tensor_data().data());
+  StringPiece data;
+  TF_RETURN_IF_ERROR(Read(offset, size, buf, &data));
+  if (data.data() != buf) {
+    memcpy(buf, data.data(), size);
+  }
+  return Status::OK();
+}
+
+Status RandomAccessReader::Read(uint64 offset, size_t n, char* scratch,
+                                StringPiece* result) {
+  if (offset > file_size_ || n > file_size_ - offset) {
+    return errors::DataLoss("Snapshot file ", filename_, " is truncated.");
+  }
+  if (mapped_file_ != nullptr) {
+    *result = StringPiece(mapped_file_->data() + offset, n);
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(file_->Read(offset, n, result, scratch));
+  if (result->size() != n) {
+    return errors::DataLoss("Snapshot file ", filename_, " is truncated.");
+  }
+  return Status::OK();
+}
+
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata) {
   string metadata_filename = io::JoinPath(dir, kMetadataFilename);
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/status.h"
 
 namespace tensorflow {
@@ -37,8 +38,11 @@ namespace data {
 
 namespace experimental {
 
+class SnapshotChunkIndex;
+class SnapshotFileFooter;
 class SnapshotMetadataRecord;
 class SnapshotTensorMetadata;
+class TensorMetadata;
 
 }  // namespace experimental
 
@@ -164,6 +168,59 @@ class CustomWriter : public Writer {
   int num_complex_ = 0;
 };
 
+// Writes snapshots with a file format that supports random access (version 3).
+//
+// Elements are buffered into chunks of about `kChunkSizeBytes`, and each chunk
+// is written column by column: the tensors of the first component of all its
+// elements, then those of the second, and so on. Tensors of memcpy-able types
+// are written as raw bytes aligned to `Allocator::kAllocatorAlignment`, so that
+// readers mapping the file can alias them; others as serialized TensorProtos.
+// Each chunk is followed by its `SnapshotChunkIndex`, and the file ends with a
+// `SnapshotFileFooter` locating the chunk indices, the size of the footer and
+// `kMagic`.
+//
+// Compression is not supported, since it would prevent both random access and
+// aliasing.
+class RandomAccessWriter : public Writer {
+ public:
+  static constexpr const uint64 kMagic = 0x33544F4853504E53ull;
+  static constexpr const int64_t kChunkSizeBytes = 16 << 20;  // 16 MiB
+  static constexpr const size_t kTrailerSize = 2 * sizeof(uint64);
+
+  RandomAccessWriter(const std::string& filename,
+                     const std::string& compression_type,
+                     const DataTypeVector& dtypes);
+
+  Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  // Writes the buffered elements as a chunk, and flushes the file.
+  Status Sync() override;
+
+  Status Close() override;
+
+  ~RandomAccessWriter() override;
+
+ protected:
+  Status Initialize(tensorflow::Env* env) override;
+
+ private:
+  Status WriteChunk();
+  Status Append(StringPiece data);
+  // Pads the file up to the alignment of raw tensor data.
+  Status Align();
+
+  const std::string filename_;
+  const std::string compression_type_;
+  const DataTypeVector dtypes_;
+
+  std::unique_ptr<WritableFile> dest_;
+  uint64 offset_ = 0;
+  // The elements of the chunk being buffered, and their size.
+  std::vector<std::vector<Tensor>> chunk_;
+  int64_t chunk_bytes_ = 0;
+  std::unique_ptr<experimental::SnapshotFileFooter> footer_;
+};
+
 // Interface class for reading snapshot files previous written with Writer.
 class Reader {
  public:
@@ -311,6 +368,67 @@ class CustomReader : public Reader {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
 };
 
+class MappedSnapshotFile;
+
+// Reads snapshots previously written with `RandomAccessWriter`.
+//
+// The file is memory-mapped if its file system supports it, in which case the
+// tensors of memcpy-able types alias the mapping instead of being copied. Such
+// tensors must not be modified; they keep the mapping alive. Elements can be
+// read in any order, e.g. to shard a snapshot file or resume reading it.
+class RandomAccessReader : public Reader {
+ public:
+  RandomAccessReader(const std::string& filename,
+                     const string& compression_type,
+                     const DataTypeVector& dtypes);
+
+  Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  // Skips `num_records` without reading them.
+  Status SkipRecords(int64_t num_records) override;
+
+  // Reads the element at `index`. Does not change the element read by the
+  // next call to `ReadTensors`.
+  Status ReadElement(int64_t index, std::vector<Tensor>* read_tensors);
+
+  // Makes the next call to `ReadTensors` read the element at `index`.
+  Status Seek(int64_t index);
+
+  // Returns the number of elements in the file.
+  int64_t num_elements() const { return num_elements_; }
+
+  ~RandomAccessReader() override;
+
+ protected:
+  Status Initialize(Env* env) override;
+
+ private:
+  // Reads `n` bytes at `offset` into `result`, which points to the mapping if
+  // the file is mapped, and to `scratch` otherwise.
+  Status Read(uint64 offset, size_t n, char* scratch, StringPiece* result);
+  Status LoadChunkIndex(int64_t chunk);
+  Status ReadTensor(DataType dtype,
+                    const experimental::TensorMetadata& metadata,
+                    uint64 offset, Tensor* tensor);
+
+  const std::string filename_;
+  const string compression_type_;
+  const DataTypeVector dtypes_;
+
+  std::unique_ptr<RandomAccessFile> file_;
+  uint64 file_size_ = 0;
+  // Null if the file system does not support mapping the file.
+  core::RefCountPtr<MappedSnapshotFile> mapped_file_;
+  std::unique_ptr<experimental::SnapshotFileFooter> footer_;
+  // The index of the first element of each chunk.
+  std::vector<int64_t> chunk_starts_;
+  int64_t num_elements_ = 0;
+  int64_t next_index_ = 0;
+  // The index of the chunk last read.
+  int64_t loaded_chunk_ = -1;
+  std::unique_ptr<experimental::SnapshotChunkIndex> chunk_index_;
+};
+
 // Writes snapshot metadata to the given directory.
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata);
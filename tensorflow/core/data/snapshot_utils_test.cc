@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/data/snapshot_utils.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -89,6 +93,97 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kNone, 2);
   SnapshotRoundTrip(io::compression::kGzip, 2);
   SnapshotRoundTrip(io::compression::kSnappy, 2);
+
+  SnapshotRoundTrip(io::compression::kNone, 3);
+}
+
+// Writes `num_elements` elements of a float vector and a string scalar, with
+// values `i`, in a random access snapshot file.
+std::string WriteRandomAccessSnapshot(int num_elements, int vector_size) {
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_EXPECT_OK(Writer::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, {DT_FLOAT, DT_STRING}, &writer));
+  for (int i = 0; i < num_elements; ++i) {
+    Tensor vector(DT_FLOAT, TensorShape({vector_size}));
+    vector.flat<float>().setConstant(i);
+    Tensor scalar(DT_STRING, TensorShape({}));
+    scalar.scalar<tstring>()() = strings::StrCat(i);
+    TF_EXPECT_OK(writer->WriteTensors({vector, scalar}));
+  }
+  TF_EXPECT_OK(writer->Close());
+  return filename;
+}
+
+void ExpectElement(const std::vector<Tensor>& tensors, int i,
+                   int vector_size) {
+  ASSERT_EQ(tensors.size(), 2);
+  Tensor vector(DT_FLOAT, TensorShape({vector_size}));
+  vector.flat<float>().setConstant(i);
+  test::ExpectTensorEqual<float>(tensors[0], vector);
+  EXPECT_EQ(tensors[1].scalar<tstring>()(), strings::StrCat(i));
+}
+
+TEST(SnapshotUtilTest, RandomAccessSeek) {
+  // Elements of 4 MiB make chunks of 4 elements.
+  constexpr int kVectorSize = 1 << 20;
+  const std::string filename = WriteRandomAccessSnapshot(6, kVectorSize);
+
+  std::unique_ptr<Reader> base_reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, {DT_FLOAT, DT_STRING},
+                              &base_reader));
+  auto* reader = static_cast<RandomAccessReader*>(base_reader.get());
+  EXPECT_EQ(reader->num_elements(), 6);
+  for (int i : {5, 1, 4, 0}) {
+    std::vector<Tensor> tensors;
+    TF_ASSERT_OK(reader->ReadElement(i, &tensors));
+    ExpectElement(tensors, i, kVectorSize);
+  }
+
+  TF_ASSERT_OK(reader->SkipRecords(3));
+  std::vector<Tensor> tensors;
+  TF_ASSERT_OK(reader->ReadTensors(&tensors));
+  ExpectElement(tensors, 3, kVectorSize);
+  TF_ASSERT_OK(reader->Seek(5));
+  tensors.clear();
+  TF_ASSERT_OK(reader->ReadTensors(&tensors));
+  ExpectElement(tensors, 5, kVectorSize);
+  tensors.clear();
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&tensors)));
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadElement(6, &tensors)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, RandomAccessAliasesMappedFile) {
+  const std::string filename = WriteRandomAccessSnapshot(3, 100);
+  std::vector<Tensor> tensors;
+  {
+    std::unique_ptr<Reader> reader;
+    TF_ASSERT_OK(Reader::Create(Env::Default(), filename,
+                                io::compression::kNone, /*version=*/3,
+                                {DT_FLOAT, DT_STRING}, &reader));
+    TF_ASSERT_OK(reader->SkipRecords(1));
+    TF_ASSERT_OK(reader->ReadTensors(&tensors));
+  }
+  // The tensors outlive the reader.
+  ExpectElement(tensors, 1, 100);
+  TensorDescription description;
+  tensors[0].FillDescription(&description);
+  EXPECT_EQ(description.allocation_description().allocator_name(),
+            "snapshot_mmap");
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, RandomAccessRejectsCompression) {
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      Writer::Create(Env::Default(), filename, io::compression::kGzip,
+                     /*version=*/3, {DT_FLOAT}, &writer)));
 }
 
 void SnapshotReaderBenchmarkLoop(::testing::benchmark::State& state,
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/cancellable_call.h"
+#include "tensorflow/core/distributed_runtime/collective_wire_format.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -44,6 +45,7 @@ class RecvBufCall : public CancellableCall {
               const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
               const DeviceLocality& client_locality,
               const DeviceAttributes& server_attributes,
+              const CollectiveWireFormat& wire_format,
               CancellationManager* cancel_mgr, WorkerCacheInterface* wc)
       : CancellableCall(cancel_mgr, peer_task, wc) {
     req_.set_step_id(step_id);
@@ -56,6 +58,7 @@ class RecvBufCall : public CancellableCall {
     req_.set_src_incarnation(server_attributes.incarnation());
     req_.set_dst_device(to_device->name());
     req_.set_request_id(GetUniqueRequestId());
+    SetCollectiveWireFormat(wire_format, *to_tensor, &req_);
   }
 
   ~RecvBufCall() override {}
@@ -90,6 +93,9 @@ Status PopulateTensorFromResponse(const RecvBufResponse& response,
   int64_t num_bytes = 0;
   RecvBufRespExtra extra;
   response.transport_options().UnpackTo(&extra);
+  if (HasCollectiveWireFormat(extra)) {
+    return DecodeCollectiveWireFormat(extra, cpu_tensor);
+  }
   for (const auto& chunk : extra.tensor_content()) {
     num_bytes += chunk.size();
   }
@@ -111,6 +117,20 @@ void CollectiveRemoteAccessDistributed::RecvFromPeer(
     const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
     const DeviceLocality& client_locality, int dev_to_dev_stream_index,
     CancellationManager* cancellation_manager, const StatusCallback& done) {
+  RecvFromPeerWithWireFormat(peer_device, peer_task, peer_is_local, key,
+                             to_device, to_device_ctx, to_alloc_attr, to_tensor,
+                             client_locality, dev_to_dev_stream_index,
+                             CollectiveWireFormat(), cancellation_manager,
+                             done);
+}
+
+void CollectiveRemoteAccessDistributed::RecvFromPeerWithWireFormat(
+    const string& peer_device, const string& peer_task, bool peer_is_local,
+    const string& key, Device* to_device, DeviceContext* to_device_ctx,
+    const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+    const DeviceLocality& client_locality, int dev_to_dev_stream_index,
+    const CollectiveWireFormat& wire_format,
+    CancellationManager* cancellation_manager, const StatusCallback& done) {
   if (peer_is_local) {
     CollectiveRemoteAccessLocal::RecvFromPeer(
         peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
@@ -214,7 +234,7 @@ void CollectiveRemoteAccessDistributed::RecvFromPeer(
   state->call.reset(new RecvBufCall(
       step_id_, peer_device, peer_task, key, to_device, to_device_ctx,
       to_alloc_attr, dst_tensor, client_locality, state->server_attributes,
-      cancellation_manager, worker_cache_));
+      wire_format, cancellation_manager, worker_cache_));
   CancellationToken abortion_token =
       abortion_cancel_mgr_.get_cancellation_token();
   bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
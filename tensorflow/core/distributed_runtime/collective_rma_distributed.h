@@ -46,6 +46,17 @@ class CollectiveRemoteAccessDistributed : public CollectiveRemoteAccessLocal {
                     CancellationManager* cancellation_manager,
                     const StatusCallback& done) override;
 
+  // Remote values that `wire_format` applies to are requested in that format
+  // and converted back on arrival.
+  void RecvFromPeerWithWireFormat(
+      const string& peer_device, const string& peer_task, bool peer_is_local,
+      const string& key, Device* to_device, DeviceContext* to_device_ctx,
+      const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+      const DeviceLocality& client_locality, int dev_to_dev_stream_index,
+      const CollectiveWireFormat& wire_format,
+      CancellationManager* cancellation_manager,
+      const StatusCallback& done) override;
+
   void CheckPeerHealth(const string& peer_task, int64_t timeout_in_ms,
                        const StatusCallback& done) override;
 
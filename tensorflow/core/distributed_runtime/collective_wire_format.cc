@@ -0,0 +1,266 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/collective_wire_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace {
+
+bool IsSparse(float topk_fraction) {
+  return topk_fraction > 0 && topk_fraction < 1;
+}
+
+// Appends `values`, converted to T, to `out`.
+template <typename T>
+void AppendAs(const std::vector<float>& values, string* out) {
+  std::vector<T> converted(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    converted[i] = static_cast<T>(values[i]);
+  }
+  out->append(reinterpret_cast<const char*>(converted.data()),
+              converted.size() * sizeof(T));
+}
+
+// Returns `values` as they will be seen by the receiver.
+template <typename T>
+std::vector<float> RoundTrip(const std::vector<float>& values) {
+  std::vector<float> result(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    result[i] = static_cast<float>(static_cast<T>(values[i]));
+  }
+  return result;
+}
+
+template <typename T>
+void ReadAs(const char* data, int64_t num_values, std::vector<float>* values) {
+  values->resize(num_values);
+  for (int64_t i = 0; i < num_values; ++i) {
+    T value;
+    memcpy(&value, data + i * sizeof(T), sizeof(T));
+    (*values)[i] = static_cast<float>(value);
+  }
+}
+
+Status CheckWireDtype(DataType dtype) {
+  if (dtype != DT_FLOAT && dtype != DT_HALF && dtype != DT_BFLOAT16) {
+    return errors::InvalidArgument("Unsupported collective wire dtype ",
+                                   DataTypeString(dtype));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+void SetCollectiveWireFormat(const CollectiveWireFormat& wire_format,
+                             const Tensor& tensor, RecvBufRequest* request) {
+  if (!wire_format.compresses(tensor.dtype(), tensor.TotalBytes())) return;
+  request->set_wire_dtype(wire_format.dtype);
+  if (IsSparse(wire_format.topk_fraction)) {
+    request->set_wire_topk_fraction(wire_format.topk_fraction);
+  }
+}
+
+/* static */ bool CollectiveWireEncoder::Applies(const RecvBufRequest& request,
+                                                 const Tensor& tensor) {
+  return tensor.dtype() == DT_FLOAT && tensor.NumElements() > 0 &&
+         (request.wire_dtype() != DT_INVALID ||
+          IsSparse(request.wire_topk_fraction()));
+}
+
+/* static */ constexpr int CollectiveWireEncoder::kMaxResidualBuffers;
+
+std::shared_ptr<CollectiveWireEncoder::Residual>
+CollectiveWireEncoder::GetResidual(const string& key) {
+  mutex_lock l(mu_);
+  std::shared_ptr<Residual>& residual = residuals_[key];
+  if (residual == nullptr) residual = std::make_shared<Residual>();
+  residual->last_use = ++use_count_;
+  std::shared_ptr<Residual> result = residual;
+  if (residuals_.size() > static_cast<size_t>(kMaxResidualBuffers)) {
+    // Drop the least recently used quarter in one pass.
+    std::vector<int64_t> uses;
+    uses.reserve(residuals_.size());
+    for (const auto& it : residuals_) uses.push_back(it.second->last_use);
+    auto cutoff = uses.begin() + uses.size() / 4;
+    std::nth_element(uses.begin(), cutoff, uses.end());
+    const int64_t min_use = *cutoff;
+    for (auto it = residuals_.begin(); it != residuals_.end();) {
+      if (it->second->last_use < min_use) {
+        residuals_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return result;
+}
+
+Status CollectiveWireEncoder::Encode(const RecvBufRequest& request,
+                                     const Tensor& tensor,
+                                     int64_t max_chunk_bytes,
+                                     RecvBufRespExtra* extra) {
+  const DataType wire_dtype =
+      request.wire_dtype() == DT_INVALID ? DT_FLOAT : request.wire_dtype();
+  TF_RETURN_IF_ERROR(CheckWireDtype(wire_dtype));
+  if (tensor.dtype() != DT_FLOAT) {
+    return errors::Internal("Cannot encode a ", DataTypeString(tensor.dtype()),
+                            " tensor in a collective wire format");
+  }
+  const int64_t num_elements = tensor.NumElements();
+  auto flat = tensor.flat<float>();
+  std::vector<float> values(flat.data(), flat.data() + num_elements);
+
+  std::vector<int64_t> indices;
+  if (IsSparse(request.wire_topk_fraction())) {
+    std::shared_ptr<Residual> residual =
+        GetResidual(request.buf_rendezvous_key());
+    mutex_lock l(residual->mu);
+    if (residual->step_id != request.step_id()) {
+      residual->before = residual->after;
+      residual->step_id = request.step_id();
+    }
+    if (residual->before.NumElements() == num_elements) {
+      auto carried = residual->before.flat<float>();
+      for (int64_t i = 0; i < num_elements; ++i) values[i] += carried(i);
+    }
+
+    const int64_t k = std::min<int64_t>(
+        num_elements,
+        std::max<int64_t>(
+            1, static_cast<int64_t>(std::ceil(
+                   num_elements * request.wire_topk_fraction()))));
+    indices.resize(num_elements);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::nth_element(indices.begin(), indices.begin() + (k - 1), indices.end(),
+                     [&values](int64_t a, int64_t b) {
+                       return std::abs(values[a]) > std::abs(values[b]);
+                     });
+    indices.resize(k);
+    std::sort(indices.begin(), indices.end());
+
+    std::vector<float> selected(k);
+    for (int64_t i = 0; i < k; ++i) selected[i] = values[indices[i]];
+    std::vector<float> sent = selected;
+    if (wire_dtype == DT_HALF) {
+      sent = RoundTrip<Eigen::half>(selected);
+    } else if (wire_dtype == DT_BFLOAT16) {
+      sent = RoundTrip<bfloat16>(selected);
+    }
+    // Everything that the receiver does not see is fed back.
+    residual->after = Tensor(DT_FLOAT, tensor.shape());
+    auto left = residual->after.flat<float>();
+    for (int64_t i = 0; i < num_elements; ++i) left(i) = values[i];
+    for (int64_t i = 0; i < k; ++i) left(indices[i]) -= sent[i];
+    values = std::move(selected);
+  }
+
+  string encoded;
+  switch (wire_dtype) {
+    case DT_HALF:
+      AppendAs<Eigen::half>(values, &encoded);
+      break;
+    case DT_BFLOAT16:
+      AppendAs<bfloat16>(values, &encoded);
+      break;
+    default:
+      AppendAs<float>(values, &encoded);
+      break;
+  }
+
+  extra->Clear();
+  extra->set_wire_dtype(wire_dtype);
+  for (int64_t index : indices) extra->add_sparse_indices(index);
+  int64_t offset = 0;
+  const int64_t num_bytes = encoded.size();
+  while (offset < num_bytes) {
+    const int64_t bytes = max_chunk_bytes > 0
+                              ? std::min(num_bytes - offset, max_chunk_bytes)
+                              : num_bytes - offset;
+    extra->add_tensor_content(encoded.substr(offset, bytes));
+    offset += bytes;
+  }
+  return Status::OK();
+}
+
+bool HasCollectiveWireFormat(const RecvBufRespExtra& extra) {
+  return extra.wire_dtype() != DT_INVALID;
+}
+
+Status DecodeCollectiveWireFormat(const RecvBufRespExtra& extra,
+                                  Tensor* tensor) {
+  TF_RETURN_IF_ERROR(CheckWireDtype(extra.wire_dtype()));
+  if (tensor->dtype() != DT_FLOAT) {
+    return errors::Internal("Cannot decode a collective wire format into a ",
+                            DataTypeString(tensor->dtype()), " tensor");
+  }
+  const int64_t num_elements = tensor->NumElements();
+  const bool sparse = extra.sparse_indices_size() > 0;
+  const int64_t num_values =
+      sparse ? extra.sparse_indices_size() : num_elements;
+  const int64_t expected_bytes = num_values * DataTypeSize(extra.wire_dtype());
+
+  string encoded;
+  encoded.reserve(expected_bytes);
+  for (const auto& chunk : extra.tensor_content()) {
+    encoded.append(std::string(chunk));
+  }
+  if (static_cast<int64_t>(encoded.size()) != expected_bytes) {
+    return errors::Internal("Tensor Size Mismatch: RecvBufResponse returned ",
+                            encoded.size(), " bytes of ",
+                            DataTypeString(extra.wire_dtype()),
+                            ", expected: ", expected_bytes);
+  }
+
+  std::vector<float> values;
+  switch (extra.wire_dtype()) {
+    case DT_HALF:
+      ReadAs<Eigen::half>(encoded.data(), num_values, &values);
+      break;
+    case DT_BFLOAT16:
+      ReadAs<bfloat16>(encoded.data(), num_values, &values);
+      break;
+    default:
+      ReadAs<float>(encoded.data(), num_values, &values);
+      break;
+  }
+
+  auto flat = tensor->flat<float>();
+  if (!sparse) {
+    std::copy(values.begin(), values.end(), flat.data());
+    return Status::OK();
+  }
+  flat.setZero();
+  for (int64_t i = 0; i < num_values; ++i) {
+    const int64_t index = extra.sparse_indices(i);
+    if (index < 0 || index >= num_elements) {
+      return errors::Internal("Sparse index ", index,
+                              " out of range for a tensor of ", num_elements,
+                              " elements");
+    }
+    flat(index) = values[i];
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
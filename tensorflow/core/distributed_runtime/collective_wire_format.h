@@ -0,0 +1,87 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// Sets the wire format fields of `request` for receiving `tensor`, if
+// `wire_format` applies to it.
+void SetCollectiveWireFormat(const CollectiveWireFormat& wire_format,
+                             const Tensor& tensor, RecvBufRequest* request);
+
+// Encodes DT_FLOAT buffers in the wire format asked for by a RecvBufRequest.
+//
+// Top-k sparsification uses error feedback: the part of a buffer that is not
+// sent is remembered under the buffer's rendezvous key and added to the value
+// sent under the same key in a later step. A single encoder should therefore
+// serve all RecvBuf requests of a worker. Re-encoding a buffer for a retried
+// request of the same step yields the same response. The error feedback of
+// the least recently sent buffers is dropped once more than
+// kMaxResidualBuffers are remembered.
+class CollectiveWireEncoder {
+ public:
+  static constexpr int kMaxResidualBuffers = 4096;
+
+  CollectiveWireEncoder() = default;
+
+  // Returns true if `request` asks for a wire format that applies to `tensor`.
+  static bool Applies(const RecvBufRequest& request, const Tensor& tensor);
+
+  // Encodes `tensor` into `extra`, in tensor_content chunks of at most
+  // `max_chunk_bytes` if that is positive.
+  Status Encode(const RecvBufRequest& request, const Tensor& tensor,
+                int64_t max_chunk_bytes, RecvBufRespExtra* extra);
+
+ private:
+  struct Residual {
+    int64_t last_use = 0;  // Guarded by the encoder's mu_.
+    mutex mu;
+    int64_t step_id TF_GUARDED_BY(mu) = -1;
+    // The error carried into step `step_id`, and the error left by it.
+    Tensor before TF_GUARDED_BY(mu);
+    Tensor after TF_GUARDED_BY(mu);
+  };
+
+  std::shared_ptr<Residual> GetResidual(const string& key);
+
+  mutex mu_;
+  int64_t use_count_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<string, std::shared_ptr<Residual>> residuals_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CollectiveWireEncoder);
+};
+
+// Returns true if `extra` was produced by CollectiveWireEncoder::Encode.
+bool HasCollectiveWireFormat(const RecvBufRespExtra& extra);
+
+// Fills the DT_FLOAT `tensor` from `extra`.
+Status DecodeCollectiveWireFormat(const RecvBufRespExtra& extra,
+                                  Tensor* tensor);
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_WIRE_FORMAT_H_
@@ -0,0 +1,121 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/collective_wire_format.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+RecvBufRequest MakeRequest(DataType wire_dtype, float topk_fraction,
+                           int64_t step_id) {
+  RecvBufRequest request;
+  request.set_step_id(step_id);
+  request.set_buf_rendezvous_key("ring_key");
+  request.set_wire_dtype(wire_dtype);
+  request.set_wire_topk_fraction(topk_fraction);
+  return request;
+}
+
+Tensor RoundTrip(CollectiveWireEncoder* encoder, const RecvBufRequest& request,
+                 const Tensor& input, int64_t max_chunk_bytes = 0) {
+  RecvBufRespExtra extra;
+  TF_CHECK_OK(encoder->Encode(request, input, max_chunk_bytes, &extra));
+  EXPECT_TRUE(HasCollectiveWireFormat(extra));
+  Tensor output(DT_FLOAT, input.shape());
+  TF_CHECK_OK(DecodeCollectiveWireFormat(extra, &output));
+  return output;
+}
+
+TEST(CollectiveWireFormatTest, SetOnlyForLargeFloatTensors) {
+  CollectiveWireFormat wire_format;
+  wire_format.dtype = DT_BFLOAT16;
+  wire_format.min_bytes = 16;
+
+  RecvBufRequest request;
+  SetCollectiveWireFormat(wire_format, Tensor(DT_FLOAT, {2}), &request);
+  EXPECT_EQ(request.wire_dtype(), DT_INVALID);
+  SetCollectiveWireFormat(wire_format, Tensor(DT_INT32, {8}), &request);
+  EXPECT_EQ(request.wire_dtype(), DT_INVALID);
+  SetCollectiveWireFormat(wire_format, Tensor(DT_FLOAT, {8}), &request);
+  EXPECT_EQ(request.wire_dtype(), DT_BFLOAT16);
+  EXPECT_TRUE(CollectiveWireEncoder::Applies(request, Tensor(DT_FLOAT, {8})));
+}
+
+TEST(CollectiveWireFormatTest, DownCastsDenseValues) {
+  CollectiveWireEncoder encoder;
+  Tensor input = test::AsTensor<float>({1.0f, -2.5f, 0.125f, 3.0f});
+  RecvBufRespExtra extra;
+  TF_ASSERT_OK(encoder.Encode(MakeRequest(DT_HALF, 0, 1), input,
+                              /*max_chunk_bytes=*/3, &extra));
+  // Four halfs are sent in chunks of at most three bytes.
+  EXPECT_EQ(extra.tensor_content_size(), 3);
+  EXPECT_EQ(extra.sparse_indices_size(), 0);
+  Tensor output(DT_FLOAT, input.shape());
+  TF_ASSERT_OK(DecodeCollectiveWireFormat(extra, &output));
+  test::ExpectTensorEqual<float>(output, input);
+
+  Tensor bf16 = RoundTrip(&encoder, MakeRequest(DT_BFLOAT16, 0, 1),
+                          test::AsTensor<float>({1.0f + 1.0f / 1024}));
+  test::ExpectTensorEqual<float>(bf16, test::AsTensor<float>({1.0f}));
+}
+
+TEST(CollectiveWireFormatTest, SendsLargestElements) {
+  CollectiveWireEncoder encoder;
+  Tensor input = test::AsTensor<float>({0.5f, -4.0f, 1.0f, 3.0f});
+  Tensor output =
+      RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.5f, 1), input);
+  test::ExpectTensorEqual<float>(output,
+                                 test::AsTensor<float>({0, -4.0f, 0, 3.0f}));
+}
+
+TEST(CollectiveWireFormatTest, FeedsBackUnsentElements) {
+  CollectiveWireEncoder encoder;
+  Tensor input = test::AsTensor<float>({0.5f, -4.0f, 1.0f, 3.0f});
+  RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.25f, 1), input);
+  // The 3.0 left out of step 1 is added to step 2, making it the largest.
+  Tensor output = RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.25f, 2),
+                            test::AsTensor<float>({0, 0, 0, 3.0f}));
+  test::ExpectTensorEqual<float>(output,
+                                 test::AsTensor<float>({0, 0, 0, 6.0f}));
+}
+
+TEST(CollectiveWireFormatTest, RetriedStepIsEncodedAgain) {
+  CollectiveWireEncoder encoder;
+  Tensor input = test::AsTensor<float>({0.5f, -4.0f, 1.0f, 3.0f});
+  RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.25f, 1), input);
+  Tensor first = RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.25f, 2), input);
+  Tensor retry = RoundTrip(&encoder, MakeRequest(DT_INVALID, 0.25f, 2), input);
+  test::ExpectTensorEqual<float>(first, retry);
+}
+
+TEST(CollectiveWireFormatTest, DecodeChecksSize) {
+  RecvBufRespExtra extra;
+  extra.set_wire_dtype(DT_HALF);
+  extra.add_tensor_content(string(6, '\0'));
+  Tensor output(DT_FLOAT, {4});
+  EXPECT_EQ(DecodeCollectiveWireFormat(extra, &output).code(),
+            error::INTERNAL);
+
+  extra.add_sparse_indices(7);
+  extra.set_tensor_content(0, string(2, '\0'));
+  EXPECT_EQ(DecodeCollectiveWireFormat(extra, &output).code(),
+            error::INTERNAL);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/coordination/coordination_tree.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+CoordinationTree::CoordinationTree(int num_tasks, int fanout)
+    : num_tasks_(num_tasks), fanout_(fanout) {
+  CHECK_GT(num_tasks, 0);
+  CHECK_GT(fanout, 0);
+}
+
+int CoordinationTree::Parent(int task) const {
+  DCHECK(task >= 0 && task < num_tasks_) << task;
+  return task == 0 ? -1 : (task - 1) / fanout_;
+}
+
+std::vector<int> CoordinationTree::Children(int task) const {
+  DCHECK(task >= 0 && task < num_tasks_) << task;
+  std::vector<int> children;
+  const int64_t first = static_cast<int64_t>(task) * fanout_ + 1;
+  for (int64_t child = first; child < first + fanout_ && child < num_tasks_;
+       ++child) {
+    children.push_back(child);
+  }
+  return children;
+}
+
+int CoordinationTree::SubtreeSize(int task) const {
+  DCHECK(task >= 0 && task < num_tasks_) << task;
+  // The subtree covers a contiguous range of tasks on each level.
+  int size = 0;
+  int64_t first = task;
+  int64_t last = task;
+  while (first < num_tasks_) {
+    size += std::min<int64_t>(last, num_tasks_ - 1) - first + 1;
+    first = first * fanout_ + 1;
+    last = last * fanout_ + fanout_;
+  }
+  return size;
+}
+
+SubtreeBarrier::SubtreeBarrier(const CoordinationTree& tree, int task)
+    : task_(task) {
+  pending_.insert(task);
+  for (int child : tree.Children(task)) pending_.insert(child);
+}
+
+Status SubtreeBarrier::Arrive(int from, bool* subtree_done) {
+  *subtree_done = false;
+  if (pending_.erase(from) == 0) {
+    return errors::InvalidArgument("Unexpected barrier arrival from task ",
+                                   from, " at task ", task_);
+  }
+  *subtree_done = pending_.empty();
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_TREE_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_TREE_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// Arranges the tasks of a cluster in a k-ary tree rooted at the task that
+// runs the coordination service, task 0. In hierarchical mode, a task only
+// talks to its parent and its children: barrier arrivals and heartbeats are
+// aggregated on the way up, and key-value updates are forwarded to the
+// children on the way down, so that each task handles O(fanout) requests
+// instead of the service handling O(num_tasks).
+//
+// Tasks are numbered in breadth-first order, so the children of task i are
+// tasks i * fanout + 1 to i * fanout + fanout.
+class CoordinationTree {
+ public:
+  CoordinationTree(int num_tasks, int fanout);
+
+  int num_tasks() const { return num_tasks_; }
+  int fanout() const { return fanout_; }
+
+  // Returns the parent of `task`, or -1 for the root.
+  int Parent(int task) const;
+
+  // Returns the children of `task`, in increasing order.
+  std::vector<int> Children(int task) const;
+
+  // Returns the number of tasks in the subtree rooted at `task`, including
+  // `task` itself.
+  int SubtreeSize(int task) const;
+
+ private:
+  const int num_tasks_;
+  const int fanout_;
+};
+
+// Aggregates the arrivals at one barrier in the subtree rooted at one task.
+// The subtree has arrived once the task itself and the subtrees of all its
+// children have arrived; the task then reports a single arrival to its
+// parent.
+//
+// Not thread-safe.
+class SubtreeBarrier {
+ public:
+  SubtreeBarrier(const CoordinationTree& tree, int task);
+
+  // Records the arrival of the task itself (`from == task`), or of the whole
+  // subtree of its child `from`. Sets `*subtree_done` to true iff this
+  // arrival completes the subtree. Fails on arrivals from other tasks and on
+  // repeated arrivals.
+  Status Arrive(int from, bool* subtree_done);
+
+  bool done() const { return pending_.empty(); }
+
+ private:
+  const int task_;
+  std::unordered_set<int> pending_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COORDINATION_COORDINATION_TREE_H_
@@ -0,0 +1,80 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/coordination/coordination_tree.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(CoordinationTreeTest, Topology) {
+  CoordinationTree tree(/*num_tasks=*/10, /*fanout=*/3);
+  EXPECT_EQ(tree.Parent(0), -1);
+  EXPECT_EQ(tree.Parent(3), 0);
+  EXPECT_EQ(tree.Parent(4), 1);
+  EXPECT_EQ(tree.Parent(9), 2);
+  EXPECT_EQ(tree.Children(0), std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(tree.Children(2), std::vector<int>({7, 8, 9}));
+  EXPECT_EQ(tree.Children(3), std::vector<int>());
+  EXPECT_EQ(tree.SubtreeSize(0), 10);
+  EXPECT_EQ(tree.SubtreeSize(1), 4);
+  EXPECT_EQ(tree.SubtreeSize(3), 1);
+}
+
+TEST(CoordinationTreeTest, SubtreeSizesAddUp) {
+  for (int fanout = 1; fanout <= 4; ++fanout) {
+    CoordinationTree tree(/*num_tasks=*/37, fanout);
+    for (int task = 0; task < tree.num_tasks(); ++task) {
+      int size = 1;
+      for (int child : tree.Children(task)) {
+        EXPECT_EQ(tree.Parent(child), task);
+        size += tree.SubtreeSize(child);
+      }
+      EXPECT_EQ(tree.SubtreeSize(task), size) << task;
+    }
+  }
+}
+
+TEST(SubtreeBarrierTest, CompletesOnceSubtreeArrived) {
+  CoordinationTree tree(/*num_tasks=*/10, /*fanout=*/3);
+  SubtreeBarrier barrier(tree, /*task=*/1);
+  bool subtree_done;
+  TF_ASSERT_OK(barrier.Arrive(5, &subtree_done));
+  EXPECT_FALSE(subtree_done);
+  TF_ASSERT_OK(barrier.Arrive(1, &subtree_done));
+  EXPECT_FALSE(subtree_done);
+  TF_ASSERT_OK(barrier.Arrive(4, &subtree_done));
+  EXPECT_FALSE(subtree_done);
+  EXPECT_FALSE(barrier.done());
+  TF_ASSERT_OK(barrier.Arrive(6, &subtree_done));
+  EXPECT_TRUE(subtree_done);
+  EXPECT_TRUE(barrier.done());
+}
+
+TEST(SubtreeBarrierTest, RejectsUnexpectedArrivals) {
+  CoordinationTree tree(/*num_tasks=*/10, /*fanout=*/3);
+  SubtreeBarrier barrier(tree, /*task=*/3);
+  bool subtree_done;
+  EXPECT_EQ(barrier.Arrive(4, &subtree_done).code(), error::INVALID_ARGUMENT);
+  TF_ASSERT_OK(barrier.Arrive(3, &subtree_done));
+  EXPECT_TRUE(subtree_done);
+  EXPECT_EQ(barrier.Arrive(3, &subtree_done).code(), error::INVALID_ARGUMENT);
+  EXPECT_FALSE(subtree_done);
+}
+
+}  // namespace
+}  // namespace tensorflow
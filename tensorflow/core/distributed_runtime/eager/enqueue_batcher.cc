@@ -0,0 +1,156 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+auto* enqueue_batch_size_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/eager_client_enqueue_batch_size",
+     "The number of EnqueueRequests sent in one batch to a remote eager "
+     "context."},
+    // Power of 2 with bucket count 10 (> 512)
+    {monitoring::Buckets::Exponential(1, 2, 10)});
+
+auto* enqueue_latency_usecs_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/eager_client_enqueue_latency_usecs",
+     "The time from enqueuing a request for a remote eager context to "
+     "receiving its response, in microseconds."},
+    // Power of 2 with bucket count 20 (> 0.5 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
+}  // namespace
+
+struct EnqueueBatcher::Batch {
+  struct Member {
+    EnqueueResponse* response;
+    StatusCallback done;
+    int num_items;
+    uint64 enqueue_micros;
+  };
+
+  EnqueueRequest request;
+  EnqueueResponse response;
+  std::vector<Member> members;
+  int64_t num_bytes = 0;
+};
+
+EnqueueBatcher::EnqueueBatcher(Env* env, const Options& options, SendFn send)
+    : env_(env), options_(options), send_(std::move(send)) {}
+
+EnqueueBatcher::~EnqueueBatcher() {
+  // Batches hold a reference to the batcher while they are scheduled or in
+  // flight.
+  DCHECK(pending_ == nullptr);
+}
+
+void EnqueueBatcher::Enqueue(const EnqueueRequest& request,
+                             EnqueueResponse* response, StatusCallback done) {
+  {
+    mutex_lock l(mu_);
+    if (pending_ == nullptr) {
+      pending_ = absl::make_unique<Batch>();
+      pending_->request.set_context_id(request.context_id());
+    }
+    DCHECK_EQ(pending_->request.context_id(), request.context_id());
+    for (const QueueItem& item : request.queue()) {
+      *pending_->request.add_queue() = item;
+    }
+    pending_->num_bytes += request.ByteSizeLong();
+    pending_->members.push_back(
+        {response, std::move(done), request.queue_size(), env_->NowMicros()});
+    MaybeSchedulePendingLocked(/*force=*/false);
+    if (scheduled_.empty() || sending_) return;
+    sending_ = true;
+  }
+  SendScheduled();
+}
+
+void EnqueueBatcher::MaybeSchedulePendingLocked(bool force) {
+  if (pending_ == nullptr) return;
+  if (force || num_in_flight_ < options_.max_in_flight_batches ||
+      pending_->request.queue_size() >= options_.max_batch_items ||
+      pending_->num_bytes >= options_.max_batch_bytes) {
+    scheduled_.push_back(std::move(pending_));
+    ++num_in_flight_;
+  }
+}
+
+void EnqueueBatcher::SendScheduled() {
+  // `send_` is called without holding `mu_`, since it may complete the batch
+  // before it returns. Only one thread sends at a time, which keeps the
+  // batches in order.
+  std::shared_ptr<EnqueueBatcher> self = shared_from_this();
+  mu_.lock();
+  while (!scheduled_.empty()) {
+    Batch* batch = scheduled_.front().release();
+    scheduled_.pop_front();
+    mu_.unlock();
+    enqueue_batch_size_histogram->GetCell()->Add(batch->members.size());
+    send_(&batch->request, &batch->response,
+          [self, batch](const Status& s) { self->BatchDone(batch, s); });
+    mu_.lock();
+  }
+  sending_ = false;
+  mu_.unlock();
+}
+
+void EnqueueBatcher::BatchDone(Batch* batch, const Status& status) {
+  Status s = status;
+  int num_items = 0;
+  for (const Batch::Member& member : batch->members) {
+    num_items += member.num_items;
+  }
+  if (s.ok() && batch->response.queue_response_size() != num_items) {
+    s = errors::Internal("Expected ", num_items,
+                         " queue responses from the remote eager context, got ",
+                         batch->response.queue_response_size());
+  }
+  const uint64 now_micros = env_->NowMicros();
+  int offset = 0;
+  for (Batch::Member& member : batch->members) {
+    // On errors, the responses of the items that did run are still handed
+    // back, as an unbatched request would get them.
+    for (int i = 0; i < member.num_items &&
+                    offset + i < batch->response.queue_response_size();
+         ++i) {
+      member.response->add_queue_response()->Swap(
+          batch->response.mutable_queue_response(offset + i));
+    }
+    offset += member.num_items;
+    enqueue_latency_usecs_histogram->GetCell()->Add(now_micros -
+                                                    member.enqueue_micros);
+    member.done(s);
+  }
+  delete batch;
+
+  {
+    mutex_lock l(mu_);
+    --num_in_flight_;
+    MaybeSchedulePendingLocked(/*force=*/true);
+    if (scheduled_.empty() || sending_) return;
+    sending_ = true;
+  }
+  SendScheduled();
+}
+
+}  // namespace eager
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// Coalesces the EnqueueRequests sent to one remote eager context into fewer,
+// larger requests, without reordering them.
+//
+// While fewer than `max_in_flight_batches` requests are in flight, each
+// request is sent as it comes. Beyond that, requests are appended to a
+// pending batch, which is sent as soon as a request in flight completes, or
+// once it holds `max_batch_items` queue items or `max_batch_bytes` bytes.
+// Requests are thus only delayed while the remote worker is busy, by at most
+// one round trip.
+//
+// The remote context answers a batch with one queue response per queue item,
+// which are handed back to the requests of the batch. If the batch fails,
+// all its requests fail with its status; on a stream, the requests after a
+// failed one fail anyway.
+//
+// `send` must deliver the batches in the order in which it is called, e.g.
+// through a streaming RPC.
+class EnqueueBatcher : public std::enable_shared_from_this<EnqueueBatcher> {
+ public:
+  struct Options {
+    int max_in_flight_batches = 4;
+    int max_batch_items = 256;
+    int64_t max_batch_bytes = 4 << 20;
+  };
+
+  using SendFn = std::function<void(
+      const EnqueueRequest*, EnqueueResponse*, StatusCallback)>;
+
+  EnqueueBatcher(Env* env, const Options& options, SendFn send);
+  ~EnqueueBatcher();
+
+  // Sends `request` as part of a batch, and calls `done` once `response` has
+  // its queue responses. `request` can be deleted as soon as Enqueue()
+  // returns. The batcher must be owned by a shared_ptr.
+  void Enqueue(const EnqueueRequest& request, EnqueueResponse* response,
+               StatusCallback done);
+
+ private:
+  struct Batch;
+
+  // Moves the pending batch to the batches to send if it may be sent now.
+  void MaybeSchedulePendingLocked(bool force) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Sends the scheduled batches in order, unless another thread is already
+  // doing so. Takes `mu_`.
+  void SendScheduled();
+
+  void BatchDone(Batch* batch, const Status& status);
+
+  Env* const env_;  // Not owned.
+  const Options options_;
+  const SendFn send_;
+
+  mutex mu_;
+  // The batch that requests are being appended to, if any.
+  std::unique_ptr<Batch> pending_ TF_GUARDED_BY(mu_);
+  // Batches to send, in order.
+  std::deque<std::unique_ptr<Batch>> scheduled_ TF_GUARDED_BY(mu_);
+  // Number of batches scheduled or sent, and not completed.
+  int num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  // True while a thread sends the scheduled batches.
+  bool sending_ TF_GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EnqueueBatcher);
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
@@ -0,0 +1,192 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+// Records the batches sent through it, and completes them on demand like a
+// remote context that answers each queue item.
+class FakeStream {
+ public:
+  EnqueueBatcher::SendFn send_fn() {
+    return [this](const EnqueueRequest* request, EnqueueResponse* response,
+                  StatusCallback done) {
+      sent_.push_back({*request, response, std::move(done)});
+    };
+  }
+
+  int num_sent() const { return sent_.size(); }
+  const EnqueueRequest& request(int i) const { return sent_[i].request; }
+
+  void Complete(int i, const Status& status = Status::OK()) {
+    Sent& sent = sent_[i];
+    for (const QueueItem& item : sent.request.queue()) {
+      // Tags the response with the id of its operation.
+      sent.response->add_queue_response()->add_shape()->add_dim()->set_size(
+          item.operation().id());
+    }
+    StatusCallback done = std::move(sent.done);
+    done(status);
+  }
+
+ private:
+  struct Sent {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+  std::vector<Sent> sent_;
+};
+
+EnqueueRequest MakeRequest(std::vector<int64_t> op_ids) {
+  EnqueueRequest request;
+  request.set_context_id(7);
+  for (int64_t id : op_ids) {
+    request.add_queue()->mutable_operation()->set_id(id);
+  }
+  return request;
+}
+
+std::vector<int64_t> OpIds(const EnqueueRequest& request) {
+  std::vector<int64_t> ids;
+  for (const QueueItem& item : request.queue()) {
+    ids.push_back(item.operation().id());
+  }
+  return ids;
+}
+
+std::vector<int64_t> ResponseIds(const EnqueueResponse& response) {
+  std::vector<int64_t> ids;
+  for (const QueueResponse& item : response.queue_response()) {
+    ids.push_back(item.shape(0).dim(0).size());
+  }
+  return ids;
+}
+
+class EnqueueBatcherTest : public ::testing::Test {
+ protected:
+  void Init(int max_in_flight_batches, int max_batch_items = 256) {
+    EnqueueBatcher::Options options;
+    options.max_in_flight_batches = max_in_flight_batches;
+    options.max_batch_items = max_batch_items;
+    batcher_ = std::make_shared<EnqueueBatcher>(Env::Default(), options,
+                                                stream_.send_fn());
+  }
+
+  // Enqueues a request for `op_ids`, and returns its index.
+  int Enqueue(std::vector<int64_t> op_ids) {
+    const int i = responses_.size();
+    responses_.emplace_back(new EnqueueResponse);
+    statuses_.emplace_back(new Status(errors::Unknown("Not done")));
+    Status* status = statuses_.back().get();
+    batcher_->Enqueue(MakeRequest(op_ids), responses_.back().get(),
+                      [status](const Status& s) { *status = s; });
+    return i;
+  }
+
+  FakeStream stream_;
+  std::shared_ptr<EnqueueBatcher> batcher_;
+  std::vector<std::unique_ptr<EnqueueResponse>> responses_;
+  std::vector<std::unique_ptr<Status>> statuses_;
+};
+
+TEST_F(EnqueueBatcherTest, SendsRightAwayWhileNotBusy) {
+  Init(/*max_in_flight_batches=*/2);
+  Enqueue({1});
+  Enqueue({2, 3});
+  ASSERT_EQ(stream_.num_sent(), 2);
+  EXPECT_EQ(OpIds(stream_.request(0)), std::vector<int64_t>({1}));
+  EXPECT_EQ(OpIds(stream_.request(1)), std::vector<int64_t>({2, 3}));
+  EXPECT_EQ(stream_.request(1).context_id(), 7);
+
+  stream_.Complete(0);
+  stream_.Complete(1);
+  TF_EXPECT_OK(*statuses_[0]);
+  TF_EXPECT_OK(*statuses_[1]);
+  EXPECT_EQ(ResponseIds(*responses_[1]), std::vector<int64_t>({2, 3}));
+}
+
+TEST_F(EnqueueBatcherTest, CoalescesWhileBusy) {
+  Init(/*max_in_flight_batches=*/1);
+  Enqueue({1});
+  Enqueue({2});
+  Enqueue({3, 4});
+  Enqueue({5});
+  ASSERT_EQ(stream_.num_sent(), 1);
+  EXPECT_EQ(statuses_[1]->code(), error::UNKNOWN);
+
+  stream_.Complete(0);
+  TF_EXPECT_OK(*statuses_[0]);
+  ASSERT_EQ(stream_.num_sent(), 2);
+  EXPECT_EQ(OpIds(stream_.request(1)), std::vector<int64_t>({2, 3, 4, 5}));
+
+  stream_.Complete(1);
+  for (int i = 1; i < 4; ++i) TF_EXPECT_OK(*statuses_[i]);
+  EXPECT_EQ(ResponseIds(*responses_[1]), std::vector<int64_t>({2}));
+  EXPECT_EQ(ResponseIds(*responses_[2]), std::vector<int64_t>({3, 4}));
+  EXPECT_EQ(ResponseIds(*responses_[3]), std::vector<int64_t>({5}));
+}
+
+TEST_F(EnqueueBatcherTest, SendsFullBatches) {
+  Init(/*max_in_flight_batches=*/1, /*max_batch_items=*/2);
+  Enqueue({1});
+  Enqueue({2});
+  Enqueue({3});
+  Enqueue({4});
+  ASSERT_EQ(stream_.num_sent(), 2);
+  EXPECT_EQ(OpIds(stream_.request(1)), std::vector<int64_t>({2, 3}));
+
+  stream_.Complete(0);
+  ASSERT_EQ(stream_.num_sent(), 3);
+  EXPECT_EQ(OpIds(stream_.request(2)), std::vector<int64_t>({4}));
+  stream_.Complete(1);
+  stream_.Complete(2);
+  for (int i = 0; i < 4; ++i) TF_EXPECT_OK(*statuses_[i]);
+}
+
+TEST_F(EnqueueBatcherTest, FailsAllRequestsOfABatch) {
+  Init(/*max_in_flight_batches=*/1);
+  Enqueue({1});
+  Enqueue({2});
+  Enqueue({3});
+  stream_.Complete(0);
+  stream_.Complete(1, errors::Unavailable("Stream closed"));
+  EXPECT_EQ(statuses_[1]->code(), error::UNAVAILABLE);
+  EXPECT_EQ(statuses_[2]->code(), error::UNAVAILABLE);
+}
+
+TEST_F(EnqueueBatcherTest, ChecksNumResponses) {
+  batcher_ = std::make_shared<EnqueueBatcher>(
+      Env::Default(), EnqueueBatcher::Options(),
+      [](const EnqueueRequest* request, EnqueueResponse* response,
+         StatusCallback done) {
+        response->add_queue_response();
+        done(Status::OK());
+      });
+  Enqueue({1, 2});
+  EXPECT_EQ(statuses_[0]->code(), error::INTERNAL);
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -296,7 +296,8 @@ Status GraphMgr::Register(
     const string& handle, const GraphDef& gdef, WorkerSession* session,
     const GraphOptions& graph_options, const DebugOptions& debug_options,
     const ConfigProto& config_proto, int64_t collective_graph_key,
-    DistributedFunctionLibraryRuntime* cluster_flr, string* graph_handle) {
+    uint64 graph_fingerprint, DistributedFunctionLibraryRuntime* cluster_flr,
+    string* graph_handle) {
   Item* item = new Item;
   Status s = InitItem(handle, gdef, session, graph_options, debug_options,
                       config_proto, collective_graph_key, cluster_flr, item);
@@ -311,11 +312,37 @@ Status GraphMgr::Register(
     *graph_handle =
         strings::Printf("%016llx", static_cast<long long>(++next_id_));
     item->handle = *graph_handle;
+    item->num_handles = 1;
     CHECK(table_.insert({*graph_handle, item}).second);
+    if (graph_fingerprint != 0) {
+      item->fingerprint = graph_fingerprint;
+      fingerprint_table_[graph_fingerprint] = item;
+    }
   }
   return Status::OK();
 }
 
+bool GraphMgr::RegisterCached(uint64 graph_fingerprint, string* graph_handle) {
+  mutex_lock l(mu_);
+  auto iter = fingerprint_table_.find(graph_fingerprint);
+  if (iter == fingerprint_table_.end()) return false;
+  Item* item = iter->second;
+  item->Ref();
+  ++item->num_handles;
+  *graph_handle =
+      strings::Printf("%016llx", static_cast<long long>(++next_id_));
+  CHECK(table_.insert({*graph_handle, item}).second);
+  return true;
+}
+
+void GraphMgr::RemoveHandle(Item* item) {
+  if (--item->num_handles > 0 || item->fingerprint == 0) return;
+  auto iter = fingerprint_table_.find(item->fingerprint);
+  if (iter != fingerprint_table_.end() && iter->second == item) {
+    fingerprint_table_.erase(iter);
+  }
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
   // Removes one item from table_.
@@ -328,6 +355,7 @@ Status GraphMgr::Deregister(const string& handle) {
     }
     item = iter->second;
     table_.erase(iter);
+    RemoveHandle(item);
   }
   item->Unref();
   return Status::OK();
@@ -342,6 +370,7 @@ Status GraphMgr::DeregisterAll() {
       items.push_back(entry.second);
     }
     table_.clear();
+    fingerprint_table_.clear();
   }
   for (auto item : items) {
     item->Unref();
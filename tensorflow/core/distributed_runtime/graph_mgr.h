@@ -73,14 +73,22 @@ class GraphMgr {
   ~GraphMgr();
 
   // Registers a graph. Fills in "handle". The registered graph retains a
-  // reference to cluster_flr to do cross process function calls.
+  // reference to cluster_flr to do cross process function calls. If
+  // "graph_fingerprint" is non-zero, it identifies the arguments, and the
+  // graph can later be registered again with RegisterCached().
   Status Register(const string& handle, const GraphDef& gdef,
                   WorkerSession* session, const GraphOptions& graph_options,
                   const DebugOptions& debug_options,
                   const ConfigProto& config_proto, int64_t collective_graph_key,
+                  uint64 graph_fingerprint,
                   DistributedFunctionLibraryRuntime* cluster_flr,
                   string* graph_handle);
 
+  // Registers the graph last registered with "graph_fingerprint" again,
+  // sharing its executors, and fills in "graph_handle". Returns false if no
+  // graph with that fingerprint is registered.
+  bool RegisterCached(uint64 graph_fingerprint, string* graph_handle);
+
   // Executes one step of a registered graph "handle".
   //
   // If "out" is not nullptr, "out" specifies all keys the execution
@@ -126,9 +134,15 @@ class GraphMgr {
     // Session handle.
     string session;
 
-    // Graph handle.
+    // Handle under which the graph was first registered.
     string handle;
 
+    // Non-zero if the graph can be registered again with RegisterCached().
+    uint64 fingerprint = 0;
+
+    // Number of handles in table_ for this item.
+    int num_handles = 0;
+
     std::unique_ptr<FunctionLibraryDefinition> lib_def;
     // Owns the FunctionLibraryRuntime objects needed to execute functions, one
     // per device.
@@ -163,6 +177,13 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Maps graph fingerprints to registered graphs.
+  std::unordered_map<uint64, Item*> fingerprint_table_ TF_GUARDED_BY(mu_);
+
+  // Accounts for a handle of "item" removed from table_. Once the last one is
+  // gone, "item" can no longer be registered again by fingerprint.
+  void RemoveHandle(Item* item) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   void StartParallelExecutors(
       const string& handle, int64_t step_id, Item* item, Rendezvous* rendezvous,
       CollectiveExecutor::Handle* ce_handle, StepStatsCollector* collector,
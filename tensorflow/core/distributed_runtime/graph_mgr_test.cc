@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/graph_mgr.h"
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/debug.pb.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+class GraphMgrTest : public ::testing::Test {
+ protected:
+  GraphMgrTest()
+      : device_mgr_(DeviceFactory::NewDevice(
+            "CPU", {}, "/job:localhost/replica:0/task:0")),
+        compute_pool_(Env::Default(), "compute", 1) {
+    env_.env = Env::Default();
+    env_.local_devices = device_mgr_.ListDevices();
+    env_.device_mgr = &device_mgr_;
+    env_.compute_pool = &compute_pool_;
+    graph_mgr_ = std::make_unique<GraphMgr>(&env_, &device_mgr_);
+
+    NodeDef* node = graph_def_.add_node();
+    node->set_name("noop");
+    node->set_op("NoOp");
+    node->set_device(kDevice);
+    graph_def_.mutable_versions()->set_producer(TF_GRAPH_DEF_VERSION);
+  }
+
+  Status Register(uint64 fingerprint, string* handle) {
+    return graph_mgr_->Register(
+        "session", graph_def_, /*session=*/nullptr, GraphOptions(),
+        DebugOptions(), ConfigProto(), /*collective_graph_key=*/0, fingerprint,
+        /*cluster_flr=*/nullptr, handle);
+  }
+
+  StaticDeviceMgr device_mgr_;
+  thread::ThreadPool compute_pool_;
+  WorkerEnv env_;
+  std::unique_ptr<GraphMgr> graph_mgr_;
+  GraphDef graph_def_;
+};
+
+TEST_F(GraphMgrTest, RegisterCached) {
+  string handle;
+  TF_ASSERT_OK(Register(/*fingerprint=*/42, &handle));
+
+  string cached_handle;
+  ASSERT_TRUE(graph_mgr_->RegisterCached(42, &cached_handle));
+  EXPECT_NE(cached_handle, handle);
+  EXPECT_FALSE(graph_mgr_->RegisterCached(43, &cached_handle));
+}
+
+TEST_F(GraphMgrTest, RegisterWithoutFingerprintIsNotCached) {
+  string handle;
+  TF_ASSERT_OK(Register(/*fingerprint=*/0, &handle));
+  string cached_handle;
+  EXPECT_FALSE(graph_mgr_->RegisterCached(0, &cached_handle));
+}
+
+TEST_F(GraphMgrTest, DeregisterOneOfSharedHandles) {
+  string handle;
+  TF_ASSERT_OK(Register(/*fingerprint=*/42, &handle));
+  string cached_handle;
+  ASSERT_TRUE(graph_mgr_->RegisterCached(42, &cached_handle));
+
+  // The graph stays registered, and can be registered again, as long as one
+  // of its handles is.
+  TF_EXPECT_OK(graph_mgr_->Deregister(handle));
+  EXPECT_TRUE(errors::IsAborted(graph_mgr_->Deregister(handle)));
+  string other_handle;
+  ASSERT_TRUE(graph_mgr_->RegisterCached(42, &other_handle));
+
+  TF_EXPECT_OK(graph_mgr_->Deregister(cached_handle));
+  TF_EXPECT_OK(graph_mgr_->Deregister(other_handle));
+  EXPECT_FALSE(graph_mgr_->RegisterCached(42, &other_handle));
+}
+
+TEST_F(GraphMgrTest, DeregisterAllForgetsFingerprints) {
+  string handle;
+  TF_ASSERT_OK(Register(/*fingerprint=*/42, &handle));
+  TF_EXPECT_OK(graph_mgr_->DeregisterAll());
+  string cached_handle;
+  EXPECT_FALSE(graph_mgr_->RegisterCached(42, &cached_handle));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/profile_handler.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/debug/debug_graph_utils.h"
+#include "tensorflow/core/distributed_runtime/partition_registration.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/scheduler.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -48,10 +50,13 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -61,6 +66,42 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+// The maximum number of RegisterGraph requests of a client graph that are in
+// flight at a time.
+constexpr int kMaxConcurrentRegistrations = 64;
+}  // namespace
+
+// Remembers the partitions that the graphs of a session have registered on
+// each worker, by the fingerprint of their RegisterGraphRequest. Only used
+// with isolated worker sessions, which keep every registered graph until the
+// session is deleted, so the entries stay valid for the life of the session.
+class MasterSession::PartitionCache {
+ public:
+  // Returns true if a partition with `fingerprint` was registered on
+  // `worker`.
+  bool Contains(const string& worker, uint64 fingerprint) const {
+    mutex_lock l(mu_);
+    return registered_.count({worker, fingerprint}) > 0;
+  }
+
+  void Add(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu_);
+    registered_.insert({worker, fingerprint});
+  }
+
+ private:
+  struct Hasher {
+    size_t operator()(const std::pair<string, uint64>& key) const {
+      return Hash64Combine(Hash64(key.first), key.second);
+    }
+  };
+
+  mutable mutex mu_;
+  std::unordered_set<std::pair<string, uint64>, Hasher> registered_
+      TF_GUARDED_BY(mu_);
+};
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -73,7 +114,8 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
                     const SessionOptions& session_opts,
                     const StatsPublisherFactory& stats_publisher_factory,
                     bool is_partial, WorkerCacheInterface* worker_cache,
-                    bool should_deregister)
+                    bool should_deregister,
+                    std::shared_ptr<PartitionCache> partition_cache)
       : session_handle_(handle),
         bg_opts_(bopts),
         client_graph_before_register_(std::move(client_graph)),
@@ -82,6 +124,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         callable_opts_(bopts.callable_options),
         worker_cache_(worker_cache),
         should_deregister_(should_deregister),
+        partition_cache_(std::move(partition_cache)),
         collective_graph_key_(
             client_graph_before_register_->collective_graph_key) {
     VLOG(1) << "Created ReffedClientGraph for node with "
@@ -246,6 +289,8 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   std::unordered_map<string, NodeDetails> name_to_node_details_;
 
   const bool should_deregister_;
+  // Null if partitions are always registered in full.
+  const std::shared_ptr<PartitionCache> partition_cache_;
   const int64_t collective_graph_key_;
   std::atomic<int64_t> execution_count_ = {0};
 
@@ -460,39 +505,46 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     }
     return s;
   }
-  struct Call {
-    RegisterGraphRequest req;
-    RegisterGraphResponse resp;
-    Status status;
-  };
   const int num = partitions_.size();
-  gtl::InlinedVector<Call, 4> calls(num);
-  BlockingCounter done(num);
+  std::vector<PartitionRegistration> calls(num);
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
-    Call* c = &calls[i];
-    c->req.set_session_handle(session_handle_);
-    c->req.set_create_worker_session_called(!should_deregister_);
-    c->req.mutable_graph_def()->Swap(&graph_partitions[part.name]);
+    PartitionRegistration* c = &calls[i];
+    c->worker = part.worker;
+    c->request.set_session_handle(session_handle_);
+    c->request.set_create_worker_session_called(!should_deregister_);
+    c->request.mutable_graph_def()->Swap(&graph_partitions[part.name]);
     StripDefaultAttributes(*OpRegistry::Global(),
-                           c->req.mutable_graph_def()->mutable_node());
-    *c->req.mutable_config_proto() = session_opts_.config;
-    *c->req.mutable_graph_options() = session_opts_.config.graph_options();
-    *c->req.mutable_debug_options() =
+                           c->request.mutable_graph_def()->mutable_node());
+    *c->request.mutable_config_proto() = session_opts_.config;
+    *c->request.mutable_graph_options() = session_opts_.config.graph_options();
+    *c->request.mutable_debug_options() =
         callable_opts_.run_options().debug_options();
-    c->req.set_collective_graph_key(collective_graph_key_);
-    VLOG(2) << "Register " << c->req.graph_def().DebugString();
-    auto cb = [c, &done](const Status& s) {
-      c->status = s;
-      done.DecrementCount();
-    };
-    part.worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+    c->request.set_collective_graph_key(collective_graph_key_);
+    VLOG(2) << "Register " << c->request.graph_def().DebugString();
+    if (partition_cache_ != nullptr) {
+      string serialized;
+      if (SerializeToStringDeterministic(c->request, &serialized)) {
+        c->request.set_graph_fingerprint(Fingerprint64(serialized));
+      }
+      const uint64 fingerprint = c->request.graph_fingerprint();
+      if (fingerprint != 0 &&
+          partition_cache_->Contains(part.name, fingerprint)) {
+        c->graph_def.Swap(c->request.mutable_graph_def());
+        c->request.clear_graph_def();
+      }
+    }
   }
-  done.Wait();
+  RegisterGraphsOnWorkers(kMaxConcurrentRegistrations, &calls);
+
   for (int i = 0; i < num; ++i) {
-    Call* c = &calls[i];
+    PartitionRegistration* c = &calls[i];
     s.Update(c->status);
-    partitions_[i].graph_handle = c->resp.graph_handle();
+    partitions_[i].graph_handle = c->response.graph_handle();
+    if (c->status.ok() && c->request.graph_fingerprint() != 0) {
+      partition_cache_->Add(partitions_[i].name,
+                            c->request.graph_fingerprint());
+    }
   }
   return s;
 }
@@ -1236,7 +1288,8 @@ MasterSession::MasterSession(
       stats_publisher_factory_(std::move(stats_publisher_factory)),
       graph_version_(0),
       run_graphs_(5),
-      partial_run_graphs_(5) {
+      partial_run_graphs_(5),
+      partition_cache_(std::make_shared<PartitionCache>()) {
   UpdateLastAccessTime();
   CHECK(devices_) << "device_set was null!";
 
@@ -1538,7 +1591,8 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
       auto entry = new ReffedClientGraph(
           handle_, opts, std::move(client_graph), session_opts_,
           stats_publisher_factory_, is_partial, worker_cache,
-          !should_delete_worker_sessions_);
+          !should_delete_worker_sessions_,
+          should_delete_worker_sessions_ ? partition_cache_ : nullptr);
       iter = m->insert({hash, entry}).first;
       VLOG(1) << "Preparing to execute new graph";
     }
@@ -2007,7 +2061,10 @@ Status MasterSession::MakeCallable(const MakeCallableRequest& req,
     callable = new ReffedClientGraph(handle_, opts, std::move(client_graph),
                                      session_opts_, stats_publisher_factory_,
                                      false /* is_partial */, get_worker_cache(),
-                                     !should_delete_worker_sessions_);
+                                     !should_delete_worker_sessions_,
+                                     should_delete_worker_sessions_
+                                         ? partition_cache_
+                                         : nullptr);
   }
 
   Status s = BuildAndRegisterPartitions(callable);
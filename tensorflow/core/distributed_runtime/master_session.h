@@ -157,6 +157,11 @@ class MasterSession : public core::RefCounted {
   int64_t next_callable_handle_ TF_GUARDED_BY(mu_) = 0;
   RCGMap callables_ TF_GUARDED_BY(mu_);
 
+  // The partitions registered on the workers by the graphs of this session.
+  // Shared with the graphs, which may outlive the session.
+  class PartitionCache;
+  const std::shared_ptr<PartitionCache> partition_cache_;
+
   struct PerStepState {
     bool collect_costs = false;
     bool collect_timeline = false;
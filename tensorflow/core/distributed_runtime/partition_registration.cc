@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/partition_registration.h"
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Sends the requests of the registrations in `indices`.
+void SendRequests(int max_in_flight, const std::vector<int>& indices,
+                  std::vector<PartitionRegistration>* registrations) {
+  mutex mu;
+  condition_variable cv;
+  int in_flight = 0;
+  BlockingCounter done(indices.size());
+  for (int i : indices) {
+    {
+      mutex_lock l(mu);
+      while (in_flight >= max_in_flight) cv.wait(l);
+      ++in_flight;
+    }
+    PartitionRegistration* r = &(*registrations)[i];
+    r->response.Clear();
+    auto cb = [r, &mu, &cv, &in_flight, &done](const Status& s) {
+      r->status = s;
+      {
+        mutex_lock l(mu);
+        --in_flight;
+      }
+      cv.notify_one();
+      done.DecrementCount();
+    };
+    r->worker->RegisterGraphAsync(&r->request, &r->response, cb);
+  }
+  done.Wait();
+}
+
+}  // namespace
+
+void RegisterGraphsOnWorkers(
+    int max_in_flight, std::vector<PartitionRegistration>* registrations) {
+  const int num = registrations->size();
+  std::vector<int> indices(num);
+  for (int i = 0; i < num; ++i) {
+    indices[i] = i;
+  }
+  SendRequests(max_in_flight, indices, registrations);
+
+  indices.clear();
+  for (int i = 0; i < num; ++i) {
+    PartitionRegistration* r = &(*registrations)[i];
+    if (errors::IsNotFound(r->status) && !r->request.has_graph_def()) {
+      r->request.mutable_graph_def()->Swap(&r->graph_def);
+      indices.push_back(i);
+    }
+  }
+  if (!indices.empty()) SendRequests(max_in_flight, indices, registrations);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,49 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_REGISTRATION_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_REGISTRATION_H_
+
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// The RegisterGraph call for one partition of a client graph.
+struct PartitionRegistration {
+  WorkerInterface* worker = nullptr;  // Not owned.
+  RegisterGraphRequest request;
+  RegisterGraphResponse response;
+  Status status;
+  // The partition, while `request` only refers to it by its fingerprint.
+  GraphDef graph_def;
+};
+
+// Sends the requests of `registrations` to their workers, with at most
+// `max_in_flight` of them outstanding at a time, and waits for the responses.
+//
+// A worker answers a request that only refers to its partition by fingerprint
+// with NOT_FOUND if it no longer holds the partition, e.g. because it
+// restarted. Such requests are sent again with the full partition.
+void RegisterGraphsOnWorkers(
+    int max_in_flight, std::vector<PartitionRegistration>* registrations);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PARTITION_REGISTRATION_H_
@@ -0,0 +1,188 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/partition_registration.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A worker that holds the graphs it was sent, by fingerprint, and answers a
+// request that only refers to a graph it does not hold with NOT_FOUND.
+class FakeWorker : public TestWorkerInterface {
+ public:
+  // If `pool` is not null, requests are answered on it after a delay.
+  explicit FakeWorker(thread::ThreadPool* pool = nullptr) : pool_(pool) {}
+
+  void RegisterGraphAsync(const RegisterGraphRequest* request,
+                          RegisterGraphResponse* response,
+                          StatusCallback done) override {
+    Status status;
+    {
+      mutex_lock l(mu_);
+      requests_.push_back(*request);
+      max_in_flight_ = std::max(max_in_flight_, ++in_flight_);
+      if (request->has_graph_def()) {
+        fingerprints_.insert(request->graph_fingerprint());
+      } else if (fingerprints_.count(request->graph_fingerprint()) == 0) {
+        status = errors::NotFound("No graph with fingerprint ",
+                                  request->graph_fingerprint());
+      }
+      if (status.ok()) {
+        response->set_graph_handle(strings::StrCat(requests_.size()));
+      }
+    }
+    auto respond = [this, status, done]() {
+      {
+        mutex_lock l(mu_);
+        --in_flight_;
+      }
+      done(status);
+    };
+    if (pool_ == nullptr) {
+      respond();
+    } else {
+      pool_->Schedule([respond]() {
+        Env::Default()->SleepForMicroseconds(10 * 1000);
+        respond();
+      });
+    }
+  }
+
+  std::vector<RegisterGraphRequest> requests() {
+    mutex_lock l(mu_);
+    return requests_;
+  }
+
+  int max_in_flight() {
+    mutex_lock l(mu_);
+    return max_in_flight_;
+  }
+
+ private:
+  thread::ThreadPool* const pool_;
+  mutex mu_;
+  std::vector<RegisterGraphRequest> requests_ TF_GUARDED_BY(mu_);
+  std::set<uint64> fingerprints_ TF_GUARDED_BY(mu_);
+  int in_flight_ TF_GUARDED_BY(mu_) = 0;
+  int max_in_flight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+GraphDef MakeGraphDef(const string& node_name) {
+  GraphDef graph_def;
+  NodeDef* node = graph_def.add_node();
+  node->set_name(node_name);
+  node->set_op("NoOp");
+  return graph_def;
+}
+
+// Returns a registration for `worker` that only refers to `graph_def` by
+// `fingerprint`.
+PartitionRegistration ByFingerprint(WorkerInterface* worker,
+                                    const GraphDef& graph_def,
+                                    uint64 fingerprint) {
+  PartitionRegistration registration;
+  registration.worker = worker;
+  registration.request.set_graph_fingerprint(fingerprint);
+  registration.graph_def = graph_def;
+  return registration;
+}
+
+TEST(PartitionRegistrationTest, ReferencesToHeldPartitionsAreNotResent) {
+  FakeWorker worker;
+  std::vector<PartitionRegistration> registrations(1);
+  registrations[0].worker = &worker;
+  registrations[0].request.set_graph_fingerprint(7);
+  *registrations[0].request.mutable_graph_def() = MakeGraphDef("a");
+  RegisterGraphsOnWorkers(/*max_in_flight=*/64, &registrations);
+  TF_ASSERT_OK(registrations[0].status);
+
+  registrations = {ByFingerprint(&worker, MakeGraphDef("a"), 7)};
+  RegisterGraphsOnWorkers(/*max_in_flight=*/64, &registrations);
+  TF_EXPECT_OK(registrations[0].status);
+  EXPECT_EQ(registrations[0].response.graph_handle(), "2");
+  ASSERT_EQ(worker.requests().size(), 2);
+  EXPECT_FALSE(worker.requests()[1].has_graph_def());
+}
+
+TEST(PartitionRegistrationTest, NotFoundFallsBackToFullPartition) {
+  FakeWorker holding_worker;
+  FakeWorker restarted_worker;
+  std::vector<PartitionRegistration> registrations(1);
+  registrations[0].worker = &holding_worker;
+  registrations[0].request.set_graph_fingerprint(7);
+  *registrations[0].request.mutable_graph_def() = MakeGraphDef("a");
+  RegisterGraphsOnWorkers(/*max_in_flight=*/64, &registrations);
+  TF_ASSERT_OK(registrations[0].status);
+
+  // Only the worker that no longer holds its partition gets it in full.
+  registrations = {ByFingerprint(&holding_worker, MakeGraphDef("a"), 7),
+                   ByFingerprint(&restarted_worker, MakeGraphDef("b"), 8)};
+  RegisterGraphsOnWorkers(/*max_in_flight=*/64, &registrations);
+  TF_EXPECT_OK(registrations[0].status);
+  TF_EXPECT_OK(registrations[1].status);
+  EXPECT_EQ(registrations[1].response.graph_handle(), "2");
+
+  EXPECT_EQ(holding_worker.requests().size(), 2);
+  const std::vector<RegisterGraphRequest> requests =
+      restarted_worker.requests();
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_FALSE(requests[0].has_graph_def());
+  ASSERT_TRUE(requests[1].has_graph_def());
+  EXPECT_EQ(requests[1].graph_def().node(0).name(), "b");
+  EXPECT_EQ(requests[1].graph_fingerprint(), 8);
+}
+
+TEST(PartitionRegistrationTest, OtherErrorsAreNotRetried) {
+  TestWorkerInterface worker;
+  std::vector<PartitionRegistration> registrations = {
+      ByFingerprint(&worker, MakeGraphDef("a"), 7)};
+  RegisterGraphsOnWorkers(/*max_in_flight=*/64, &registrations);
+  EXPECT_TRUE(errors::IsUnimplemented(registrations[0].status));
+  EXPECT_FALSE(registrations[0].request.has_graph_def());
+}
+
+TEST(PartitionRegistrationTest, BoundsRequestsInFlight) {
+  thread::ThreadPool pool(Env::Default(), "workers", 8);
+  FakeWorker worker(&pool);
+  std::vector<PartitionRegistration> registrations(8);
+  for (int i = 0; i < registrations.size(); ++i) {
+    registrations[i].worker = &worker;
+    *registrations[i].request.mutable_graph_def() =
+        MakeGraphDef(strings::StrCat("node", i));
+  }
+  RegisterGraphsOnWorkers(/*max_in_flight=*/3, &registrations);
+  for (const PartitionRegistration& registration : registrations) {
+    TF_EXPECT_OK(registration.status);
+  }
+  EXPECT_EQ(worker.requests().size(), 8);
+  EXPECT_LE(worker.max_in_flight(), 3);
+  EXPECT_GE(worker.max_in_flight(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
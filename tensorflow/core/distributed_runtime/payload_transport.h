@@ -0,0 +1,54 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PAYLOAD_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PAYLOAD_TRANSPORT_H_
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// Moves the content of tensors returned by RecvTensor out of band, so that
+// only the tensor metadata travels in the RPC response.
+//
+// A task uses the same transport on the client side, in its remote
+// rendezvous, and on the server side, in its worker service. The client
+// describes itself in the transport_options of the RecvTensorRequest, and the
+// server decides per tensor whether the client can be reached out of band.
+class PayloadTransport {
+ public:
+  virtual ~PayloadTransport() {}
+
+  // Client side: describes this end of the transport in `request`.
+  virtual void AddRequestOptions(RecvTensorRequest* request) = 0;
+
+  // Server side: if the client that sent `request` can be reached, moves the
+  // content of `tensor` out of band and fills `response` with its metadata.
+  // Returns false if the content must be sent in the response instead.
+  virtual bool ExportPayload(const RecvTensorRequest& request,
+                             const Tensor& tensor,
+                             RecvTensorResponse* response) = 0;
+
+  // Client side: if `response` names an out-of-band payload, copies it into
+  // `tensor`, which was allocated from the metadata of `response`. Does
+  // nothing for responses that carry their content.
+  virtual Status ImportPayload(const RecvTensorResponse& response,
+                               Tensor* tensor) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PAYLOAD_TRANSPORT_H_
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
@@ -60,6 +61,16 @@ bool EnableStreaming() {
   return result;
 }
 
+// Setting environment variable "TF_ENABLE_EAGER_CLIENT_ENQUEUE_BATCHING" to
+// true coalesces the streamed requests for a remote eager context while its
+// worker is busy. See EnqueueBatcher.
+bool EnableEnqueueBatching() {
+  bool result;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_ENABLE_EAGER_CLIENT_ENQUEUE_BATCHING",
+                                 false, &result));
+  return result;
+}
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -166,10 +177,10 @@ class GrpcEagerClient : public EagerClient {
             << request->DebugString();
 
     mutex_lock l(mu_);
-    const auto& it = enqueue_dispatchers_.find(request->context_id());
-    if (it != enqueue_dispatchers_.end()) {
-      it->second.CancelCall();
-      enqueue_dispatchers_.erase(it);
+    const auto& it = enqueue_streams_.find(request->context_id());
+    if (it != enqueue_streams_.end()) {
+      it->second.dispatcher->CancelCall();
+      enqueue_streams_.erase(it);
     } else if (EnableStreaming()) {
       LOG(ERROR) << "Remote EagerContext with id " << request->context_id()
                  << " does not seem to exist.";
@@ -183,18 +194,33 @@ class GrpcEagerClient : public EagerClient {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
     if (EnableStreaming()) {
       mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
+      auto it = enqueue_streams_.find(request->context_id());
+      if (it == enqueue_streams_.end()) {
+        EnqueueStream stream;
+        stream.dispatcher =
+            std::make_shared<StreamingRPCDispatcher<EnqueueResponse>>(
+                &stub_, cq_, "/tensorflow.eager.EagerService/StreamingEnqueue");
+        if (EnableEnqueueBatching()) {
+          stream.batcher = std::make_shared<EnqueueBatcher>(
+              Env::Default(), EnqueueBatcher::Options(),
+              [dispatcher = stream.dispatcher](const EnqueueRequest* request,
+                                               EnqueueResponse* response,
+                                               StatusCallback done) {
+                dispatcher->SendNextRequest(*request, response,
+                                            std::move(done));
+              });
+        }
+        it = enqueue_streams_.emplace(request->context_id(), std::move(stream))
+                 .first;
       }
       // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      if (it->second.batcher != nullptr) {
+        it->second.batcher->Enqueue(*request, response,
+                                    std::move(done_wrapped));
+      } else {
+        it->second.dispatcher->SendNextRequest(*request, response,
+                                               std::move(done_wrapped));
+      }
     } else {
       Notification n;
       Status status;
@@ -217,8 +243,15 @@ class GrpcEagerClient : public EagerClient {
 
   mutable mutex mu_;
 
-  std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
-      enqueue_dispatchers_ TF_GUARDED_BY(mu_);
+  struct EnqueueStream {
+    // Shared with the batcher, whose batches may complete after the stream
+    // is closed.
+    std::shared_ptr<StreamingRPCDispatcher<EnqueueResponse>> dispatcher;
+    // Null unless enqueue batching is enabled.
+    std::shared_ptr<EnqueueBatcher> batcher;
+  };
+  std::unordered_map<uint64, EnqueueStream> enqueue_streams_
+      TF_GUARDED_BY(mu_);
 
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
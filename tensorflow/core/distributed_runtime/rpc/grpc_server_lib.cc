@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/rpc_collective_executor_mgr.h"
 #include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_payload_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_wrapper.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/op.h"
@@ -202,6 +203,13 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   }
   worker_env_.local_devices = worker_env_.device_mgr->ListDevices();
   master_env_.local_devices = worker_env_.device_mgr->ListDevices();
+  bool use_shared_memory = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RENDEZVOUS_USE_SHARED_MEMORY",
+                                        false, &use_shared_memory));
+  if (use_shared_memory) {
+    payload_transport_ = std::make_unique<SharedMemoryPayloadTransport>(env_);
+    worker_env_.payload_transport = payload_transport_.get();
+  }
   worker_env_.rendezvous_mgr = opts.rendezvous_mgr_func == nullptr
                                    ? new RpcRendezvousMgr(&worker_env_)
                                    : opts.rendezvous_mgr_func(&worker_env_);
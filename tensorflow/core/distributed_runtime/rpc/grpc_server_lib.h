@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 #include "tensorflow/core/distributed_runtime/master_env.h"
+#include "tensorflow/core/distributed_runtime/payload_transport.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
@@ -204,6 +205,7 @@ class GrpcServer : public ServerInterface {
   // Implementation of a TensorFlow worker, and RPC polling thread.
   WorkerEnv worker_env_;
   std::unique_ptr<const DeviceMgr> owned_device_manager_;
+  std::unique_ptr<PayloadTransport> payload_transport_;
   std::unique_ptr<GrpcWorker> worker_impl_;
   AsyncServiceInterface* worker_service_ = nullptr;
   std::unique_ptr<Thread> worker_thread_ TF_GUARDED_BY(mu_);
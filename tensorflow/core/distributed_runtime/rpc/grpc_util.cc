@@ -14,13 +14,43 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/random/random.h"
 
 namespace tensorflow {
 
 namespace {
 
+// The memory of a tensor received by gRPC, which keeps the slice holding it
+// alive.
+class GrpcSliceBuffer : public TensorBuffer {
+ public:
+  GrpcSliceBuffer(::grpc::Slice slice, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        slice_(std::move(slice)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("grpc");
+  }
+  // The slice may be referenced by gRPC as well, so its memory must not be
+  // updated in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
 double GenerateUniformRandomNumber() {
   return random::New64() * (1.0 / std::numeric_limits<uint64>::max());
 }
@@ -100,6 +130,22 @@ bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, TensorResponse* dst) {
   return s.ok();
 }
 
+TensorBuffer* GrpcByteSource::ShareBuffer(const char* data, size_t size) {
+  // Dumping the buffer takes references to its slices without copying them,
+  // except for inlined slices, whose copies never hold "data".
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) {
+    return nullptr;
+  }
+  for (::grpc::Slice& slice : slices) {
+    const char* begin = reinterpret_cast<const char*>(slice.begin());
+    if (data >= begin && data + size <= begin + slice.size()) {
+      return new GrpcSliceBuffer(std::move(slice), data, size);
+    }
+  }
+  return nullptr;
+}
+
 // GrpcMaybeParseProto simply copies bytes into the string.
 bool GrpcMaybeParseProto(grpc::ByteBuffer* src, string* dst) {
   dst->clear();
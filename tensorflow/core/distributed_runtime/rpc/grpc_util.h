@@ -53,6 +53,10 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the memory of the slice of the buffer holding "data", unless the
+  // slice is inlined in the buffer.
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
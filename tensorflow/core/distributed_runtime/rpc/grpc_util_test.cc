@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -135,6 +136,30 @@ TEST(GrpcProto, ParseFromString) {
   }
 }
 
+TEST(GrpcByteSource, ShareBuffer) {
+  const string str(1 << 10, 'x');
+  ::grpc::ByteBuffer buf = MakeBuffer(str, 1);
+  TensorBuffer* shared;
+  {
+    GrpcByteSource source(&buf);
+    const void* data;
+    int size;
+    ASSERT_TRUE(source.contents()->Next(&data, &size));
+    ASSERT_EQ(size, static_cast<int>(str.size()));
+    const char* begin = static_cast<const char*>(data);
+    shared = source.ShareBuffer(begin + 8, 512);
+    ASSERT_NE(shared, nullptr);
+    EXPECT_EQ(shared->data(), begin + 8);
+    EXPECT_EQ(shared->size(), 512);
+    // Memory outside of the buffer is not shared.
+    EXPECT_EQ(source.ShareBuffer(str.data(), 512), nullptr);
+  }
+  // The shared memory outlives the buffer.
+  buf.Clear();
+  EXPECT_EQ(string(shared->base<char>(), shared->size()), string(512, 'x'));
+  shared->Unref();
+}
+
 static void BM_UnparseGrpc(::testing::benchmark::State& state) {
   const int size = state.range(0);
 
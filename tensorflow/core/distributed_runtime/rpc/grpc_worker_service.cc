@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
+#include "tensorflow/core/distributed_runtime/payload_transport.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
@@ -145,6 +146,7 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(CompleteInstance, 10, true);
     SETUP_FOR_REQUEST(GetStepSequence, 10, true);
     SETUP_FOR_REQUEST(RecvBuf, 500, true);
+    SETUP_FOR_REQUEST(RecvTensorBatch, 100, true);
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
@@ -301,6 +303,25 @@ class GrpcWorkerServiceThread {
     ENQUEUE_REQUEST(RecvBuf, true);
   }
 
+  void RecvTensorBatchHandler(
+      WorkerCall<RecvTensorBatchRequest, RecvTensorBatchResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorBatchAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from RecvTensorBatch:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(RecvTensorBatch, true);
+  }
+
   void CompleteGroupHandler(
       WorkerCall<CompleteGroupRequest, CompleteGroupResponse>* call) {
     Schedule([this, call]() {
@@ -444,18 +465,87 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                                      StatusCallback done) {
   VLOG(3) << "GrpcRecvTensorAsync req: " << request->DebugString();
   const int64_t request_id = request->request_id();
-  const int64_t step_id = request->step_id();
-
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  PayloadTransport* payload_transport = env_->payload_transport;
+  auto do_response = [request, response, done, cache_enabled,
+                      payload_transport](const Tensor& tensor, bool is_dead,
+                                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      RecvTensorResponse proto;
+      if (!is_dead && payload_transport != nullptr &&
+          payload_transport->ExportPayload(*request, tensor, &proto)) {
+        proto.set_require_ack(cache_enabled);
+        grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
     }
     done(status);
   };
+  RecvTensorWithCacheAsync(opts, request, std::move(do_response));
+}
+
+void GrpcWorker::RecvTensorBatchAsync(CallOptions* opts,
+                                      const RecvTensorBatchRequest* request,
+                                      RecvTensorBatchResponse* response,
+                                      StatusCallback done) {
+  const int num_requests = request->requests_size();
+  if (num_requests == 0) {
+    done(Status::OK());
+    return;
+  }
+  for (int i = 0; i < num_requests; ++i) response->add_responses();
+
+  // Each tensor is received as if it had its own RecvTensor call, and the
+  // batch is answered once the last one is ready.
+  struct BatchState {
+    mutex mu;
+    int pending TF_GUARDED_BY(mu);
+    Status status TF_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<BatchState>();
+  {
+    mutex_lock l(state->mu);
+    state->pending = num_requests;
+  }
+  for (int i = 0; i < num_requests; ++i) {
+    const RecvTensorRequest* sub_request = &request->requests(i);
+    RecvTensorResponse* sub_response = response->mutable_responses(i);
+    const bool cache_enabled =
+        (response_cache_ != nullptr && sub_request->request_id() != 0);
+    RecvTensorWithCacheAsync(
+        /*opts=*/nullptr, sub_request,
+        [state, sub_response, cache_enabled, done](
+            const Tensor& tensor, bool is_dead, const Status& status) {
+          if (status.ok()) {
+            if (is_dead) {
+              sub_response->mutable_tensor()->set_dtype(tensor.dtype());
+            } else {
+              tensor.AsProtoTensorContent(sub_response->mutable_tensor());
+            }
+            sub_response->set_is_dead(is_dead);
+            sub_response->set_require_ack(cache_enabled);
+          }
+          Status batch_status;
+          {
+            mutex_lock l(state->mu);
+            state->status.Update(status);
+            if (--state->pending > 0) return;
+            batch_status = state->status;
+          }
+          done(batch_status);
+        });
+  }
+}
+
+void GrpcWorker::RecvTensorWithCacheAsync(
+    CallOptions* opts, const RecvTensorRequest* request,
+    GrpcResponseCache::FinishResponseCB do_response) {
+  const int64_t request_id = request->request_id();
+  const int64_t step_id = request->step_id();
+  bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
   // If response cache is enabled and the response cache already contains the
   // request, we delegate this retry request to the response cache. Otherwise,
@@ -507,15 +597,18 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // and aborting the step eliminates the opportunity for client side retries.
   // Repeated client failures will eventually cause the step to be aborted by
   // the client.
-  opts->SetCancelCallback(
-      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  if (opts != nullptr) {
+    opts->SetCancelCallback([step_id]() {
+      LOG(WARNING) << "RecvTensor cancelled for " << step_id;
+    });
+  }
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
       [opts, rendezvous_done, src_dev, request](
           const Status& status, const Rendezvous::Args& send_args,
           const Rendezvous::Args& recv_args, const Tensor& val,
           const bool is_dead) {
-        opts->ClearCancelCallback();
+        if (opts != nullptr) opts->ClearCancelCallback();
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
@@ -590,15 +683,23 @@ void GrpcWorker::RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
   const int64_t step_id = request->step_id();
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [this, response, done, cache_enabled](
+  auto do_response = [this, request, response, done, cache_enabled](
                          const Tensor& tensor, bool is_dead,
                          const Status& status) {
-    if (status.ok()) {
-      SetTensorInRecvBufResp(recv_buf_max_chunk_, &tensor, response);
+    Status s = status;
+    if (s.ok()) {
+      if (CollectiveWireEncoder::Applies(*request, tensor)) {
+        RecvBufRespExtra extra;
+        s = wire_encoder_.Encode(*request, tensor, recv_buf_max_chunk_,
+                                 &extra);
+        response->mutable_transport_options()->PackFrom(extra);
+      } else {
+        SetTensorInRecvBufResp(recv_buf_max_chunk_, &tensor, response);
+      }
     }
     response->set_send_start_micros(env_->env->NowMicros());
     response->set_require_ack(cache_enabled);
-    done(status);
+    done(s);
   };
 
   // If response cache is enabled and the response cache already contains the
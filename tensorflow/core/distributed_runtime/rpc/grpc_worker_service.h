@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <unordered_map>
 #include "grpcpp/server_builder.h"
+#include "tensorflow/core/distributed_runtime/collective_wire_format.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_response_cache.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
@@ -52,6 +53,13 @@ class GrpcWorker : public Worker {
   void RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
                     RecvBufResponse* response, StatusCallback done) override;
 
+  // Receives every tensor of the batch, and responds once all are ready.
+  // Retried tensors are deduplicated by the response cache, if enabled.
+  void RecvTensorBatchAsync(CallOptions* opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override;
+
   void CleanupGraphAsync(const CleanupGraphRequest* request,
                          CleanupGraphResponse* response,
                          StatusCallback done) override;
@@ -63,8 +71,17 @@ class GrpcWorker : public Worker {
   void RemoveCacheEntryForId(int64_t request_id);
 
  private:
+  // Receives the tensor named by `request` from the local rendezvous, through
+  // the response cache if it is enabled, and passes it to `do_response`.
+  // `opts` may be null.
+  void RecvTensorWithCacheAsync(
+      CallOptions* opts, const RecvTensorRequest* request,
+      GrpcResponseCache::FinishResponseCB do_response);
+
   std::unique_ptr<GrpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
+  // Encodes the RecvBuf responses that ask for a collective wire format.
+  CollectiveWireEncoder wire_encoder_;
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
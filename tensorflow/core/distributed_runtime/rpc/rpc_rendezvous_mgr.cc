@@ -15,22 +15,30 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/payload_transport.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -38,10 +46,204 @@ namespace tensorflow {
 
 namespace {
 
+// Coalesces the RecvTensor calls that one step issues to the same worker
+// within a short window into a single RecvTensorBatch RPC. Requests to
+// workers that do not implement RecvTensorBatch are sent one by one.
+//
+// Cancelling any call of a batch cancels the whole batch. The calls of a
+// batch all belong to the same step, and they are only cancelled when the
+// step is aborted.
+class RecvTensorCoalescer {
+ public:
+  static constexpr int kMaxBatchSize = 256;
+
+  // `owner` is kept alive while a flush of the pending calls is scheduled.
+  RecvTensorCoalescer(Env* env, int64_t window_micros, core::RefCounted* owner)
+      : env_(env), window_micros_(window_micros), owner_(owner) {}
+
+  // Receives `request` from `src_worker` through `wi` into `response`, and
+  // calls `done` when it is filled. `opts` is only used to cancel the call,
+  // and must outlive it.
+  void Enqueue(const string& src_worker, WorkerInterface* wi,
+               CallOptions* opts, const RecvTensorRequest* request,
+               TensorResponse* response, StatusCallback done) {
+    if (!SupportsBatching(src_worker)) {
+      wi->RecvTensorAsync(opts, request, response, std::move(done));
+      return;
+    }
+    std::shared_ptr<Batch> batch;
+    std::shared_ptr<Batch> full_batch;
+    bool schedule_flush = false;
+    {
+      mutex_lock l(mu_);
+      std::shared_ptr<Batch>& pending = pending_[src_worker];
+      if (pending == nullptr) {
+        pending = std::make_shared<Batch>();
+        pending->src_worker = src_worker;
+        pending->wi = wi;
+        schedule_flush = true;
+      }
+      batch = pending;
+      batch->members.push_back({wi, opts, request, response, std::move(done)});
+      if (batch->members.size() >= static_cast<size_t>(kMaxBatchSize)) {
+        full_batch = batch;
+        pending_.erase(src_worker);
+      }
+    }
+    opts->SetCancelCallback([batch]() { batch->Cancel(); });
+    if (schedule_flush && full_batch == nullptr) {
+      owner_->Ref();
+      env_->SchedClosureAfter(window_micros_, [this, batch]() {
+        Flush(batch);
+        owner_->Unref();
+      });
+    }
+    if (full_batch != nullptr) Issue(std::move(full_batch));
+  }
+
+ private:
+  struct Member {
+    WorkerInterface* wi;  // Not owned.
+    CallOptions* opts;    // Not owned.
+    const RecvTensorRequest* request;
+    TensorResponse* response;
+    StatusCallback done;
+  };
+
+  struct Batch {
+    string src_worker;
+    WorkerInterface* wi;  // Not owned.
+    // Only changed while the batch is pending.
+    std::vector<Member> members;
+    CallOptions opts;
+    RecvTensorBatchRequest request;
+    RecvTensorBatchResponse response;
+
+    mutex mu;
+    bool cancelled TF_GUARDED_BY(mu) = false;
+    bool issued TF_GUARDED_BY(mu) = false;
+
+    void Cancel() {
+      bool issued_before_cancel;
+      {
+        mutex_lock l(mu);
+        cancelled = true;
+        issued_before_cancel = issued;
+      }
+      if (issued_before_cancel) opts.StartCancel();
+    }
+  };
+
+  // Issues `batch` if it is still pending.
+  void Flush(const std::shared_ptr<Batch>& batch) {
+    {
+      mutex_lock l(mu_);
+      auto it = pending_.find(batch->src_worker);
+      if (it == pending_.end() || it->second != batch) return;
+      pending_.erase(it);
+    }
+    Issue(batch);
+  }
+
+  static void Issue(std::shared_ptr<Batch> batch) {
+    for (const Member& member : batch->members) {
+      *batch->request.add_requests() = *member.request;
+    }
+    bool issued;
+    {
+      mutex_lock l(batch->mu);
+      batch->issued = issued = !batch->cancelled;
+    }
+    if (!issued) {
+      Complete(batch, errors::Cancelled("RecvTensor cancelled"));
+      return;
+    }
+    batch->wi->RecvTensorBatchAsync(
+        &batch->opts, &batch->request, &batch->response,
+        [batch](const Status& s) { Complete(batch, s); });
+    // Like RpcRecvTensorCall::StartRTCall, handles a cancellation that came
+    // before the RPC registered its cancellation callback.
+    bool cancelled;
+    {
+      mutex_lock l(batch->mu);
+      cancelled = batch->cancelled;
+    }
+    if (cancelled) batch->opts.StartCancel();
+  }
+
+  static void Complete(const std::shared_ptr<Batch>& batch, Status s) {
+    if (errors::IsUnimplemented(s)) {
+      SetBatchingUnsupported(batch->src_worker);
+      for (Member& member : batch->members) {
+        member.opts->ClearCancelCallback();
+        member.wi->RecvTensorAsync(member.opts, member.request,
+                                   member.response, std::move(member.done));
+      }
+      return;
+    }
+    if (s.ok() &&
+        batch->response.responses_size() !=
+            static_cast<int>(batch->members.size())) {
+      s = errors::Internal("RecvTensorBatch returned ",
+                           batch->response.responses_size(),
+                           " tensors, expected ", batch->members.size());
+    }
+    for (size_t i = 0; i < batch->members.size(); ++i) {
+      Member& member = batch->members[i];
+      Status member_status = s;
+      if (member_status.ok()) {
+        member_status =
+            member.response->InitFrom(batch->response.mutable_responses(i));
+      }
+      member.opts->ClearCancelCallback();
+      member.done(member_status);
+    }
+  }
+
+  // Workers that are known not to implement RecvTensorBatch.
+  static mutex* unsupported_mu() {
+    static mutex* mu = new mutex;
+    return mu;
+  }
+  static std::unordered_set<string>* unsupported_workers()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(unsupported_mu()) {
+    static std::unordered_set<string>* workers =
+        new std::unordered_set<string>;
+    return workers;
+  }
+  static bool SupportsBatching(const string& src_worker) {
+    mutex_lock l(*unsupported_mu());
+    return unsupported_workers()->count(src_worker) == 0;
+  }
+  static void SetBatchingUnsupported(const string& src_worker) {
+    mutex_lock l(*unsupported_mu());
+    unsupported_workers()->insert(src_worker);
+  }
+
+  Env* const env_;  // Not owned.
+  const int64_t window_micros_;
+  core::RefCounted* const owner_;  // Not owned.
+
+  mutex mu_;
+  // The batch being filled for each source worker.
+  std::unordered_map<string, std::shared_ptr<Batch>> pending_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecvTensorCoalescer);
+};
+
+/* static */ constexpr int RecvTensorCoalescer::kMaxBatchSize;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id,
+                      int64_t recv_batch_window_micros)
+      : BaseRemoteRendezvous(env, step_id) {
+    if (recv_batch_window_micros > 0) {
+      coalescer_ = absl::make_unique<RecvTensorCoalescer>(
+          env->env, recv_batch_window_micros, this);
+    }
+  }
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -51,18 +253,24 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Null if RecvTensor calls are not batched.
+  std::unique_ptr<RecvTensorCoalescer> coalescer_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
 // Used only to retrieve tensors from remote processes.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
-  RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
+  RpcRecvTensorCall()
+      : wi_(nullptr), coalescer_(nullptr), dst_device_(nullptr) {}
 
-  void Init(WorkerInterface* wi, int64_t step_id, StringPiece key,
-            AllocatorAttributes alloc_attrs, Device* dst_device,
-            const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+  void Init(WorkerInterface* wi, RecvTensorCoalescer* coalescer,
+            int64_t step_id, StringPiece key, AllocatorAttributes alloc_attrs,
+            Device* dst_device, const Rendezvous::Args& recv_args,
+            Rendezvous::DoneCallback done) {
     wi_ = wi;
+    coalescer_ = coalescer;
     alloc_attrs_ = alloc_attrs;
     dst_device_ = dst_device;
     recv_args_ = recv_args;
@@ -78,6 +286,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     DCHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
         << "Leaking WorkerInterface in RpcRecvTensorCall::Reset().";
 
+    coalescer_ = nullptr;
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
     // We don't clear opts_ and assume that Init will set up the state for
@@ -149,7 +358,12 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
       }
       recv_done();
     };
-    wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
+    if (coalescer_ != nullptr) {
+      coalescer_->Enqueue(src_worker_, wi_, &opts_, &req_, &resp_,
+                          std::move(cb));
+    } else {
+      wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
+    }
 
     // NOTE: Check if the rendezvous was aborted after sending out the RPC. The
     // ordering is important because `StartAbort` could be called right before
@@ -171,6 +385,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;  // Not owned.
+  RecvTensorCoalescer* coalescer_;  // Not owned.
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
   CallOptions opts_;
@@ -269,8 +484,17 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     return;
   }
 
-  call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+  call->Init(rwi, coalescer_.get(), step_id_, parsed.FullKey(),
+             recv_args.alloc_attrs, dst_device, recv_args, std::move(done));
+  // Out-of-band payloads are only copied into host memory.
+  PayloadTransport* payload_transport = env_->payload_transport;
+  if (payload_transport != nullptr &&
+      (recv_args.alloc_attrs.on_host() ||
+       dst_device->attributes().device_type() == DEVICE_CPU)) {
+    payload_transport->AddRequestOptions(&call->req_);
+  } else {
+    payload_transport = nullptr;
+  }
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call, recv_args);
@@ -289,12 +513,16 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   // Start "call".
   Ref();
-  call->Start([this, call, worker_cache]() {
+  call->Start([this, call, worker_cache, payload_transport]() {
     // Removes "call" from active_. Prevent StartAbort().
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
     // current status should be bad.
     Status s = call->status();
+    if (s.ok() && payload_transport != nullptr) {
+      Tensor val = call->tensor();
+      s = payload_transport->ImportPayload(call->resp_.metadata(), &val);
+    }
     // NOTE: `*session()` can potentially be deleted before we return from
     // `call->done()(...)`, so we must release the worker before calling the
     // callback.
@@ -308,11 +536,29 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : RpcRendezvousMgr(env, GetRecvBatchWindowMicrosFromEnv()) {}
+
+RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env,
+                                   int64_t recv_batch_window_micros)
+    : BaseRendezvousMgr(env),
+      recv_batch_window_micros_(recv_batch_window_micros) {}
+
+/* static */ int64_t RpcRendezvousMgr::GetRecvBatchWindowMicrosFromEnv() {
+  int64_t window_micros = 0;
+  const char* window_env = std::getenv("TF_RECV_TENSOR_BATCH_WINDOW_MICROS");
+  if (window_env != nullptr &&
+      !strings::safe_strto64(window_env, &window_micros)) {
+    LOG(ERROR) << "Invalid value for TF_RECV_TENSOR_BATCH_WINDOW_MICROS: "
+               << window_env;
+    window_micros = 0;
+  }
+  return window_micros;
+}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64_t step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id,
+                                 recv_batch_window_micros_);
 }
 
 }  // end namespace tensorflow
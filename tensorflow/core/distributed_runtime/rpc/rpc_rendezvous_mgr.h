@@ -46,10 +46,21 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
 
+  // If `recv_batch_window_micros` is positive, the RecvTensor calls that a
+  // step makes within that many microseconds of each other to the same worker
+  // are sent in one RecvTensorBatch RPC. The other constructor reads the
+  // window from TF_RECV_TENSOR_BATCH_WINDOW_MICROS, and does not batch by
+  // default.
+  RpcRendezvousMgr(const WorkerEnv* env, int64_t recv_batch_window_micros);
+
  protected:
   BaseRemoteRendezvous* Create(int64_t step_id, const WorkerEnv* worker_env);
 
  private:
+  static int64_t GetRecvBatchWindowMicrosFromEnv();
+
+  const int64_t recv_batch_window_micros_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
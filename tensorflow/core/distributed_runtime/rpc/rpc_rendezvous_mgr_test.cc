@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <atomic>
+
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -52,7 +56,9 @@ Rendezvous::ParsedKey MakeKey(const string& s) {
 
 namespace {
 // A dummy worker interface implementation that simply triggers the callback
-// with OK status for RecvTensor request.
+// with OK status for RecvTensor request. RecvTensorBatch requests return the
+// string "batched" for each key, except for keys sent from the "legacy" job,
+// which fail with UNIMPLEMENTED.
 class DummyWorker : public TestWorkerInterface {
  public:
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
@@ -66,6 +72,28 @@ class DummyWorker : public TestWorkerInterface {
       done(Status::OK());
     });
   }
+
+  void RecvTensorBatchAsync(CallOptions* opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    if (absl::StartsWith(request->requests(0).rendezvous_key(),
+                         "/job:legacy/")) {
+      done(errors::Unimplemented("RecvTensorBatchAsync()"));
+      return;
+    }
+    num_batches_++;
+    for (int i = 0; i < request->requests_size(); ++i) {
+      V("batched").AsProtoTensorContent(
+          response->add_responses()->mutable_tensor());
+    }
+    SchedClosure([done = std::move(done)]() { done(Status::OK()); });
+  }
+
+  int num_batches() const { return num_batches_; }
+
+ private:
+  std::atomic<int> num_batches_{0};
 };
 
 // Fake cache implementation for WorkerEnv.
@@ -95,6 +123,9 @@ class DummyWorkerCache : public WorkerCacheInterface {
   void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
                               StatusCallback done) override {}
 
+ public:
+  DummyWorker* dummy_remote_worker() const { return dummy_remote_worker_; }
+
  private:
   DummyWorker* dummy_remote_worker_ = nullptr;
 };
@@ -104,7 +135,9 @@ static Device* CreateDevice(const char* type, const char* name) {
    public:
     explicit FakeDevice(const DeviceAttributes& attr) : Device(nullptr, attr) {}
     Status Sync() override { return Status::OK(); }
-    Allocator* GetAllocator(AllocatorAttributes) override { return nullptr; }
+    Allocator* GetAllocator(AllocatorAttributes) override {
+      return cpu_allocator();
+    }
   };
   DeviceAttributes attr;
   attr.set_name(name);
@@ -129,15 +162,47 @@ class RpcRendezvousMgrTest : public ::testing::Test {
                         std::unique_ptr<WorkerCacheInterface>(cache_),
                         std::unique_ptr<DeviceMgr>(CreateDeviceMgr()),
                         std::unique_ptr<GraphMgr>(), nullptr),
-        rmgr_(&env) {
+        rmgr_(&env),
+        batching_rmgr_(&env, /*recv_batch_window_micros=*/10000) {
     env.env = Env::Default();
   }
 
+  // Receives `num_requests` tensors from `src_device` in one step of
+  // `batching_rmgr_`, and returns the received values.
+  std::vector<Tensor> RecvBatched(const string& src_device, int num_requests) {
+    const int64_t step_id = 123;
+    const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+        src_device, 7890, "/job:mnist/replica:1/task:2/cpu:1", "foo",
+        FrameAndIter(0, 0)));
+    std::vector<Tensor> values(num_requests);
+    {
+      RemoteRendezvous* rendez = batching_rmgr_.Find(step_id);
+      TF_CHECK_OK(rendez->Initialize(&worker_session_));
+      core::ScopedUnref unref(rendez);
+      BlockingCounter counter(num_requests);
+      for (int i = 0; i < num_requests; ++i) {
+        rendez->RecvAsync(key, Rendezvous::Args(),
+                          [&values, &counter, i](
+                              const Status& s, const Rendezvous::Args&,
+                              const Rendezvous::Args&, const Tensor& val,
+                              const bool) {
+                            TF_EXPECT_OK(s);
+                            values[i] = val;
+                            counter.DecrementCount();
+                          });
+      }
+      counter.Wait();
+    }
+    batching_rmgr_.Cleanup(step_id);
+    return values;
+  }
+
   DummyWorkerCache* cache_;  // Managed by worker_session.
   WorkerEnv env;
 
   WorkerSession worker_session_;
   RpcRendezvousMgr rmgr_;
+  RpcRendezvousMgr batching_rmgr_;
 };
 
 TEST_F(RpcRendezvousMgrTest, LocalSendRecv) {
@@ -348,4 +413,20 @@ TEST_F(RpcRendezvousMgrTest, RemoteRecvAsyncMany) {
   rmgr_.Cleanup(step_id);
 }
 
+TEST_F(RpcRendezvousMgrTest, RemoteRecvBatched) {
+  const int num_requests = 100;
+  for (const Tensor& val :
+       RecvBatched("/job:worker/replica:1/task:2/cpu:0", num_requests)) {
+    EXPECT_EQ(V(val), "batched");
+  }
+  const int num_batches = cache_->dummy_remote_worker()->num_batches();
+  EXPECT_GE(num_batches, 1);
+  EXPECT_LT(num_batches, num_requests);
+}
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvBatchedFallsBackToRecvTensor) {
+  RecvBatched("/job:legacy/replica:1/task:2/cpu:0", 10);
+  EXPECT_EQ(cache_->dummy_remote_worker()->num_batches(), 0);
+}
+
 }  // namespace tensorflow
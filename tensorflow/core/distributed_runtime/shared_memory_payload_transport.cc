@@ -0,0 +1,201 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/shared_memory_payload_transport.h"
+
+#ifndef PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // PLATFORM_WINDOWS
+
+#include <cerrno>
+#include <cstring>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// The boot id tells hosts with the same name apart, and the identity of the
+// shared memory mount tells apart containers that do not share it.
+string ComputeHostId(Env* env) {
+#ifdef PLATFORM_WINDOWS
+  return "";
+#else
+  struct stat shm_stat;
+  if (stat("/dev/shm", &shm_stat) != 0) return "";
+  string boot_id;
+  if (ReadFileToString(env, "/proc/sys/kernel/random/boot_id", &boot_id)
+          .ok()) {
+    boot_id = string(str_util::StripSuffix(boot_id, "\n"));
+  }
+  return strings::StrCat(port::Hostname(), ":", boot_id, ":", shm_stat.st_dev,
+                         ":", shm_stat.st_ino);
+#endif  // PLATFORM_WINDOWS
+}
+
+}  // namespace
+
+/* static */ constexpr int64_t SharedMemoryPayloadTransport::kMinPayloadBytes;
+/* static */ constexpr int64_t
+    SharedMemoryPayloadTransport::kSegmentLifetimeMicros;
+/* static */ constexpr int SharedMemoryPayloadTransport::kMaxSegments;
+
+SharedMemoryPayloadTransport::SharedMemoryPayloadTransport(Env* env)
+    : env_(env),
+      host_id_(ComputeHostId(env)),
+      segment_prefix_(strings::StrCat("/tf_payload_", env->GetProcessId(), "_",
+                                      strings::Hex(random::New64()), "_")) {}
+
+SharedMemoryPayloadTransport::~SharedMemoryPayloadTransport() {
+  RemoveExpiredSegments(kint64max);
+}
+
+void SharedMemoryPayloadTransport::AddRequestOptions(
+    RecvTensorRequest* request) {
+  if (host_id_.empty()) return;
+  SharedMemoryTransportOptions options;
+  options.set_host_id(host_id_);
+  request->mutable_transport_options()->PackFrom(options);
+}
+
+bool SharedMemoryPayloadTransport::ExportPayload(
+    const RecvTensorRequest& request, const Tensor& tensor,
+    RecvTensorResponse* response) {
+#ifdef PLATFORM_WINDOWS
+  return false;
+#else
+  SharedMemoryTransportOptions options;
+  if (host_id_.empty() || !request.has_transport_options() ||
+      !request.transport_options().UnpackTo(&options) ||
+      options.host_id() != host_id_) {
+    return false;
+  }
+  const int64_t num_bytes = tensor.TotalBytes();
+  if (!DataTypeCanUseMemcpy(tensor.dtype()) || num_bytes < kMinPayloadBytes) {
+    return false;
+  }
+
+  const string name = strings::StrCat(segment_prefix_, next_segment_++);
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    LOG(WARNING) << "Could not create shared memory segment " << name << ": "
+                 << strerror(errno);
+    return false;
+  }
+  bool copied = false;
+  if (ftruncate(fd, num_bytes) == 0) {
+    void* data =
+        mmap(nullptr, num_bytes, PROT_WRITE, MAP_SHARED, fd, /*offset=*/0);
+    if (data != MAP_FAILED) {
+      memcpy(data, tensor.tensor_data().data(), num_bytes);
+      munmap(data, num_bytes);
+      copied = true;
+    }
+  }
+  close(fd);
+  if (!copied) {
+    LOG(WARNING) << "Could not fill shared memory segment " << name << ": "
+                 << strerror(errno);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  const int64_t now_micros = env_->NowMicros();
+  {
+    mutex_lock l(mu_);
+    segments_.emplace_back(now_micros, name);
+  }
+  RemoveExpiredSegments(now_micros - kSegmentLifetimeMicros);
+
+  response->mutable_tensor()->set_dtype(tensor.dtype());
+  tensor.shape().AsProto(response->mutable_tensor()->mutable_tensor_shape());
+  options.Clear();
+  options.set_segment_name(name);
+  options.set_num_bytes(num_bytes);
+  response->mutable_transport_options()->PackFrom(options);
+  return true;
+#endif  // PLATFORM_WINDOWS
+}
+
+Status SharedMemoryPayloadTransport::ImportPayload(
+    const RecvTensorResponse& response, Tensor* tensor) {
+  if (!response.has_transport_options() ||
+      !response.transport_options().Is<SharedMemoryTransportOptions>()) {
+    return Status::OK();
+  }
+  SharedMemoryTransportOptions options;
+  if (!response.transport_options().UnpackTo(&options)) {
+    return errors::Internal("Cannot parse shared memory transport options");
+  }
+  if (options.segment_name().empty()) return Status::OK();
+#ifdef PLATFORM_WINDOWS
+  return errors::Unimplemented("Shared memory payloads are not supported");
+#else
+  const string& name = options.segment_name();
+  const int64_t num_bytes = tensor->TotalBytes();
+  if (options.num_bytes() != num_bytes) {
+    shm_unlink(name.c_str());
+    return errors::Internal("Shared memory segment ", name, " holds ",
+                            options.num_bytes(), " bytes, expected ",
+                            num_bytes);
+  }
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return errors::Internal("Could not open shared memory segment ", name,
+                            ": ", strerror(errno));
+  }
+  // The mapping outlives the name, so the segment is gone once it is read.
+  shm_unlink(name.c_str());
+  void* data = mmap(nullptr, num_bytes, PROT_READ, MAP_SHARED, fd,
+                    /*offset=*/0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return errors::Internal("Could not map shared memory segment ", name, ": ",
+                            strerror(errno));
+  }
+  memcpy(const_cast<char*>(tensor->tensor_data().data()), data, num_bytes);
+  munmap(data, num_bytes);
+  return Status::OK();
+#endif  // PLATFORM_WINDOWS
+}
+
+void SharedMemoryPayloadTransport::RemoveExpiredSegments(
+    int64_t exported_before_micros) {
+  std::deque<std::pair<int64_t, string>> expired;
+  {
+    mutex_lock l(mu_);
+    while (!segments_.empty() &&
+           (segments_.front().first < exported_before_micros ||
+            segments_.size() > static_cast<size_t>(kMaxSegments))) {
+      expired.push_back(std::move(segments_.front()));
+      segments_.pop_front();
+    }
+  }
+#ifndef PLATFORM_WINDOWS
+  // Segments that the client already removed are gone, which is fine.
+  for (const auto& segment : expired) shm_unlink(segment.second.c_str());
+#endif  // PLATFORM_WINDOWS
+}
+
+}  // namespace tensorflow
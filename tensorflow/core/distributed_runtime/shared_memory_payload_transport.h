@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_PAYLOAD_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_PAYLOAD_TRANSPORT_H_
+
+#include <atomic>
+#include <deque>
+#include <utility>
+
+#include "tensorflow/core/distributed_runtime/payload_transport.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Moves tensor content between worker processes on the same host through
+// POSIX shared memory segments.
+//
+// The server copies each tensor of at least kMinPayloadBytes into a fresh
+// segment, and the client copies it out and removes the segment. Segments
+// that are never collected, e.g. because the response was lost and the client
+// retried, are removed by the server after kSegmentLifetimeMicros, once more
+// than kMaxSegments are outstanding, and when the transport is destroyed.
+class SharedMemoryPayloadTransport : public PayloadTransport {
+ public:
+  static constexpr int64_t kMinPayloadBytes = 64 << 10;
+  static constexpr int64_t kSegmentLifetimeMicros = 60 * 1000 * 1000LL;
+  static constexpr int kMaxSegments = 16384;
+
+  explicit SharedMemoryPayloadTransport(Env* env);
+  ~SharedMemoryPayloadTransport() override;
+
+  // Identifies the host and the shared memory namespace of this process. Two
+  // processes can exchange segments iff they have the same non-empty id.
+  const string& host_id() const { return host_id_; }
+
+  void AddRequestOptions(RecvTensorRequest* request) override;
+
+  bool ExportPayload(const RecvTensorRequest& request, const Tensor& tensor,
+                     RecvTensorResponse* response) override;
+
+  Status ImportPayload(const RecvTensorResponse& response,
+                       Tensor* tensor) override;
+
+ private:
+  // Removes the segments exported before `exported_before_micros`, and the
+  // oldest ones beyond kMaxSegments.
+  void RemoveExpiredSegments(int64_t exported_before_micros);
+
+  Env* const env_;  // Not owned.
+  const string host_id_;
+  const string segment_prefix_;
+  std::atomic<int64_t> next_segment_{0};
+
+  mutex mu_;
+  // Exported segments with their export time, oldest first.
+  std::deque<std::pair<int64_t, string>> segments_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedMemoryPayloadTransport);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_PAYLOAD_TRANSPORT_H_
@@ -0,0 +1,92 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/shared_memory_payload_transport.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64_t kLargeElements =
+    SharedMemoryPayloadTransport::kMinPayloadBytes / sizeof(float);
+
+class SharedMemoryPayloadTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (transport_.host_id().empty()) {
+      GTEST_SKIP() << "Shared memory is not available";
+    }
+  }
+
+  SharedMemoryPayloadTransport transport_{Env::Default()};
+};
+
+TEST_F(SharedMemoryPayloadTransportTest, RoundTrip) {
+  RecvTensorRequest request;
+  transport_.AddRequestOptions(&request);
+  Tensor input(DT_FLOAT, TensorShape({2, kLargeElements}));
+  test::FillIota<float>(&input, 1.0f);
+
+  RecvTensorResponse response;
+  ASSERT_TRUE(transport_.ExportPayload(request, input, &response));
+  EXPECT_TRUE(response.tensor().tensor_content().empty());
+
+  Tensor output(response.tensor().dtype(),
+                TensorShape(response.tensor().tensor_shape()));
+  TF_ASSERT_OK(transport_.ImportPayload(response, &output));
+  test::ExpectTensorEqual<float>(output, input);
+
+  // The client removes the segment once it has read it.
+  EXPECT_EQ(transport_.ImportPayload(response, &output).code(),
+            error::INTERNAL);
+}
+
+TEST_F(SharedMemoryPayloadTransportTest, SmallTensorsStayInBand) {
+  RecvTensorRequest request;
+  transport_.AddRequestOptions(&request);
+  RecvTensorResponse response;
+  EXPECT_FALSE(transport_.ExportPayload(
+      request, test::AsTensor<float>({1.0f, 2.0f}), &response));
+  EXPECT_FALSE(transport_.ExportPayload(
+      request, Tensor(DT_STRING, TensorShape({kLargeElements})), &response));
+}
+
+TEST_F(SharedMemoryPayloadTransportTest, OtherHostsStayInBand) {
+  RecvTensorRequest request;
+  SharedMemoryTransportOptions options;
+  options.set_host_id("some_other_host");
+  request.mutable_transport_options()->PackFrom(options);
+  RecvTensorResponse response;
+  EXPECT_FALSE(transport_.ExportPayload(
+      request, Tensor(DT_FLOAT, TensorShape({kLargeElements})), &response));
+  EXPECT_FALSE(transport_.ExportPayload(
+      RecvTensorRequest(), Tensor(DT_FLOAT, TensorShape({kLargeElements})),
+      &response));
+}
+
+TEST_F(SharedMemoryPayloadTransportTest, InBandResponsesAreIgnored) {
+  RecvTensorResponse response;
+  test::AsTensor<float>({1.0f}).AsProtoTensorContent(
+      response.mutable_tensor());
+  Tensor output = test::AsTensor<float>({3.0f});
+  TF_ASSERT_OK(transport_.ImportPayload(response, &output));
+  test::ExpectTensorEqual<float>(output, test::AsTensor<float>({3.0f}));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,7 @@ TensorResponse::Source::~Source() {}
 
 void TensorResponse::Clear() {
   on_host_ = false;
+  can_share_memory_ = false;
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
@@ -47,6 +48,8 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   if (alloc_attrs_.on_host() || da.device_type() == "CPU") {
     on_host_ = true;
   }
+  can_share_memory_ = on_host_ && !alloc_attrs_.gpu_compatible() &&
+                      !alloc_attrs_.nic_compatible();
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
@@ -129,6 +132,10 @@ bool ReadVarintSizeAsInt(protobuf::io::CodedInputStream* input, int* result) {
   }
 }
 
+// Tensor contents smaller than this are copied rather than pinning the memory
+// of the source, which may be much larger than the tensor.
+constexpr int kMinSharedTensorContentBytes = 1024;
+
 bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
                        protobuf::Message* value) {
   int length;
@@ -143,8 +150,32 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 
 }  // namespace
 
+bool TensorResponse::MaybeShareTensorContent(
+    Source* source, protobuf::io::CodedInputStream* input,
+    const TensorProto& tensor_meta, const TensorShape& shape, int num_bytes,
+    Tensor* tensor) {
+  if (!can_share_memory_ || num_bytes < kMinSharedTensorContentBytes ||
+      static_cast<int64_t>(num_bytes) !=
+          shape.num_elements() * DataTypeSize(tensor_meta.dtype())) {
+    return false;
+  }
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < num_bytes ||
+      reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment != 0) {
+    return false;
+  }
+  TensorBuffer* buf =
+      source->ShareBuffer(static_cast<const char*>(data), num_bytes);
+  if (buf == nullptr) return false;
+  *tensor = Tensor(tensor_meta.dtype(), shape, buf);
+  buf->Unref();
+  return true;
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -195,12 +226,16 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        // Large contents in one aligned chunk of the source are used in
+        // place; otherwise they are copied once, into a new tensor.
+        if (MaybeShareTensorContent(source, input, *tensor_meta, shape,
+                                    num_bytes, &tensor_)) {
+          if (!input->Skip(num_bytes)) return false;
+          break;
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -233,7 +268,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -64,6 +64,17 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a buffer for the "size" bytes at "data", which the stream of the
+    // last call to contents() yielded, that keeps them alive after this source
+    // is destroyed.  Lets ParseFrom() back a tensor with the received bytes
+    // instead of copying them.
+    //
+    // Returns nullptr, the default, if the source cannot share its memory.
+    // Otherwise the caller owns a reference to the returned buffer.
+    virtual TensorBuffer* ShareBuffer(const char* data, size_t size) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -92,12 +103,24 @@ class TensorResponse {
   DeviceBase* device() const { return device_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
+  // Backs "*tensor" with the "num_bytes" bytes of contents at the current
+  // position of "input" if "source" can share its memory.  Returns false if
+  // the contents must be copied instead.
+  bool MaybeShareTensorContent(Source* source,
+                               protobuf::io::CodedInputStream* input,
+                               const TensorProto& tensor_meta,
+                               const TensorShape& shape, int num_bytes,
+                               Tensor* tensor);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
   bool on_host_ = false;
+  // Whether tensors may be backed by the memory of the source, which is not
+  // the case when the allocator provides special memory, e.g. pinned for DMA.
+  bool can_share_memory_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
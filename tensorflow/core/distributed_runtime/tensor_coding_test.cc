@@ -15,13 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "absl/memory/memory.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -156,6 +160,126 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// A source over an array, whose memory is shared with the parsed tensors.
+class SharingArraySource : public TensorResponse::Source {
+ public:
+  SharingArraySource(const char* data, int size) : data_(data), size_(size) {}
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_ = absl::make_unique<protobuf::io::ArrayInputStream>(data_, size_);
+    return stream_.get();
+  }
+
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override {
+    ++num_shared_;
+    return new SharedBuffer(data, size);
+  }
+
+  int num_shared() const { return num_shared_; }
+
+ private:
+  class SharedBuffer : public TensorBuffer {
+   public:
+    SharedBuffer(const char* data, size_t size)
+        : TensorBuffer(const_cast<char*>(data)), size_(size) {}
+    size_t size() const override { return size_; }
+    TensorBuffer* root_buffer() override { return this; }
+    void FillAllocationDescription(
+        AllocationDescription* proto) const override {}
+    bool OwnsMemory() const override { return false; }
+
+   private:
+    const size_t size_;
+  };
+
+  const char* const data_;
+  const int size_;
+  std::unique_ptr<protobuf::io::ArrayInputStream> stream_;
+  int num_shared_ = 0;
+};
+
+// Parses "src", encoded in memory such that its contents start at an address
+// aligned to "alignment" and not to twice that, into "response".  The encoding
+// is held by "*space", and its contents start at "*contents".
+void ParseWithAlignedContents(const Tensor& src, int alignment,
+                              SharingArraySource** source, char** space,
+                              const char** contents,
+                              TensorResponse* response) {
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  const string encoded = proto.SerializeAsString();
+  const size_t content_offset = encoded.find(string(src.tensor_data()));
+  ASSERT_NE(content_offset, string::npos);
+
+  const int kSpaceAlignment = 2 * Allocator::kAllocatorAlignment;
+  *space = static_cast<char*>(
+      port::AlignedMalloc(encoded.size() + 2 * kSpaceAlignment,
+                          kSpaceAlignment));
+  char* begin = *space + kSpaceAlignment + alignment -
+                content_offset % kSpaceAlignment;
+  memcpy(begin, encoded.data(), encoded.size());
+  *contents = begin + content_offset;
+  *source = new SharingArraySource(begin, encoded.size());
+  TF_ASSERT_OK(response->ParseFrom(*source));
+  EXPECT_EQ(response->metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(response->tensor(), src);
+}
+
+TEST_F(TensorResponseTest, SharesAlignedTensorContent) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&src, 0);
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+
+  SharingArraySource* source;
+  char* space;
+  const char* contents;
+  ParseWithAlignedContents(src, Allocator::kAllocatorAlignment, &source,
+                           &space, &contents, &response);
+  EXPECT_EQ(source->num_shared(), 1);
+  EXPECT_EQ(response.tensor().tensor_data().data(), contents);
+  delete source;
+  response.Clear();
+  port::AlignedFree(space);
+}
+
+TEST_F(TensorResponseTest, CopiesMisalignedTensorContent) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&src, 0);
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+
+  SharingArraySource* source;
+  char* space;
+  const char* contents;
+  ParseWithAlignedContents(src, 4, &source, &space, &contents, &response);
+  EXPECT_EQ(source->num_shared(), 0);
+  delete source;
+  port::AlignedFree(space);
+  // The response owns a copy of the contents.
+  test::ExpectTensorEqual<float>(response.tensor(), src);
+}
+
+TEST_F(TensorResponseTest, CopiesSmallTensorContent) {
+  Tensor src(DT_FLOAT, TensorShape({10}));
+  test::FillIota<float>(&src, 0);
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+
+  SharingArraySource* source;
+  char* space;
+  const char* contents;
+  ParseWithAlignedContents(src, Allocator::kAllocatorAlignment, &source,
+                           &space, &contents, &response);
+  EXPECT_EQ(source->num_shared(), 0);
+  delete source;
+  port::AlignedFree(space);
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
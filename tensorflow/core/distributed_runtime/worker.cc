@@ -79,11 +79,24 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
     session = env_->session_mgr->LegacySession();
   }
   if (s.ok()) {
-    s = session->graph_mgr()->Register(
-        request->session_handle(), request->graph_def(), session.get(),
-        request->graph_options(), request->debug_options(),
-        request->config_proto(), request->collective_graph_key(),
-        session->cluster_flr(), response->mutable_graph_handle());
+    GraphMgr* graph_mgr = session->graph_mgr();
+    const uint64 fingerprint = request->graph_fingerprint();
+    if (fingerprint != 0 &&
+        graph_mgr->RegisterCached(fingerprint,
+                                  response->mutable_graph_handle())) {
+      // The graph is already registered in this session.
+    } else if (fingerprint != 0 && !request->has_graph_def()) {
+      s = errors::NotFound("No graph with fingerprint ", fingerprint,
+                           " is registered in session ",
+                           request->session_handle());
+    } else {
+      s = graph_mgr->Register(
+          request->session_handle(), request->graph_def(), session.get(),
+          request->graph_options(), request->debug_options(),
+          request->config_proto(), request->collective_graph_key(),
+          fingerprint, session->cluster_flr(),
+          response->mutable_graph_handle());
+    }
   }
   done(s);
 }
@@ -29,6 +29,7 @@ class CollectiveExecutorMgrInterface;
 class Device;
 class DeviceMgr;
 class Env;
+class PayloadTransport;
 class RendezvousMgrInterface;
 class SessionMgr;
 
@@ -64,6 +65,10 @@ struct WorkerEnv {
 
   // A pool of threads for scheduling compute work.
   thread::ThreadPool* compute_pool = nullptr;
+
+  // If set, moves the content of RecvTensor responses between this worker
+  // and the peers that it can reach out of band.
+  PayloadTransport* payload_transport = nullptr;
 };
 
 }  // end namespace tensorflow
@@ -86,6 +86,12 @@ struct AllocatorStats {
 
   int64_t largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // The bytes the allocator holds from the device, in use or free, if the
+  // allocator pools memory. The difference with bytes_in_use measures the
+  // memory lost to fragmentation and caching.
+  absl::optional<int64_t> pool_bytes;
+  absl::optional<int64_t> peak_pool_bytes;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
@@ -381,6 +387,22 @@ class SubAllocator {
   // returned by this allocator.
   virtual bool SupportsCoalescing() const = 0;
 
+  // Returns true if the physical memory behind parts of the allocations can be
+  // released and mapped again with Decommit() and Recommit(), in ranges
+  // aligned to DecommitGranularity() bytes.
+  virtual bool SupportsDecommit() const { return false; }
+  virtual size_t DecommitGranularity() const { return 0; }
+
+  // Releases the physical memory behind [ptr, ptr + num_bytes) of an
+  // allocation, keeping the addresses reserved, once the device is done with
+  // the range. The range must not be accessed until Recommit() maps memory
+  // behind it again. Returns false if the memory was not released.
+  virtual bool Decommit(void* ptr, size_t num_bytes) { return false; }
+
+  // Maps physical memory behind a range released by Decommit(). Returns false
+  // if no memory could be mapped.
+  virtual bool Recommit(void* ptr, size_t num_bytes) { return false; }
+
  protected:
   // Implementation of Alloc() method must call this on newly allocated
   // value.
@@ -16,8 +16,8 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 
 #include <forward_list>
+#include <vector>
 
-#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -28,113 +28,143 @@ const CancellationToken CancellationManager::kInvalidToken = -1;
 CancellationManager::CancellationManager()
     : is_cancelling_(false),
       is_cancelled_(false),
-      next_cancellation_token_(0) {}
+      next_cancellation_token_(0),
+      state_(nullptr) {}
 
 CancellationManager::CancellationManager(CancellationManager* parent)
-    : is_cancelling_(false), next_cancellation_token_(0), parent_(parent) {
+    : is_cancelling_(false),
+      next_cancellation_token_(0),
+      parent_(parent),
+      state_(nullptr) {
   is_cancelled_ = parent->RegisterChild(this);
 }
 
+CancellationManager::State* CancellationManager::GetOrCreateState() {
+  State* state = state_.load(std::memory_order_acquire);
+  if (state == nullptr) {
+    mutex_lock l(mu_);
+    state = state_.load(std::memory_order_relaxed);
+    if (state == nullptr) {
+      state = new State;
+      state_.store(state, std::memory_order_release);
+    }
+  }
+  return state;
+}
+
 void CancellationManager::StartCancel() {
-  gtl::FlatMap<CancellationToken, CancelCallback> callbacks_to_run;
+  std::vector<CancelCallback> callbacks_to_run;
   std::forward_list<CancellationManager*> children_to_cancel;
-  Notification* cancelled_notification = nullptr;
+  State* state;
   {
     mutex_lock l(mu_);
     if (is_cancelled_.load(std::memory_order_relaxed) || is_cancelling_) {
       return;
     }
     is_cancelling_ = true;
-    if (state_) {
-      std::swap(state_->callbacks, callbacks_to_run);
-
+    state = state_.load(std::memory_order_relaxed);
+    if (state) {
       // Remove all children from the list of children.
-      CancellationManager* child = state_->first_child;
+      CancellationManager* child = state->first_child;
       while (child != nullptr) {
         children_to_cancel.push_front(child);
         child->is_removed_from_parent_ = true;
         child = child->next_sibling_;
       }
-      state_->first_child = nullptr;
-
-      cancelled_notification = &state_->cancelled_notification;
+      state->first_child = nullptr;
     }
   }
-  // We call these callbacks without holding mu_, so that concurrent
+  if (state) {
+    // A registration that takes a shard lock after it is released here
+    // observes is_cancelling_, so no callback is added behind our back.
+    for (CallbackShard& shard : state->shards) {
+      mutex_lock l(shard.mu);
+      for (auto& key_and_value : shard.callbacks) {
+        callbacks_to_run.push_back(std::move(key_and_value.second));
+      }
+      shard.callbacks.clear();
+    }
+  }
+  // We call these callbacks without holding any lock, so that concurrent
   // calls to DeregisterCallback, which can happen asynchronously, do
   // not block. The callbacks remain valid because any concurrent call
   // to DeregisterCallback will block until the
   // cancelled_notification_ is notified.
-  for (auto key_and_value : callbacks_to_run) {
-    key_and_value.second();
+  for (const CancelCallback& callback : callbacks_to_run) {
+    callback();
   }
   for (CancellationManager* child : children_to_cancel) {
     child->StartCancel();
   }
   {
     mutex_lock l(mu_);
-    is_cancelling_ = false;
     is_cancelled_.store(true, std::memory_order_release);
+    is_cancelling_ = false;
+    // A concurrent registration may have allocated the state after it was
+    // read above, and may be waiting for the notification.
+    state = state_.load(std::memory_order_relaxed);
   }
-  if (cancelled_notification) {
-    cancelled_notification->Notify();
+  if (state) {
+    state->cancelled_notification.Notify();
   }
 }
 
 bool CancellationManager::RegisterCallback(CancellationToken token,
                                            CancelCallback callback) {
   DCHECK_LT(token, next_cancellation_token_) << "Invalid cancellation token";
-  mutex_lock l(mu_);
-  bool should_register = !is_cancelled_ && !is_cancelling_;
+  if (IsCancellingOrCancelled()) {
+    return false;
+  }
+  CallbackShard* shard = ShardFor(GetOrCreateState(), token);
+  mutex_lock l(shard->mu);
+  bool should_register = !IsCancellingOrCancelled();
   if (should_register) {
-    if (!state_) {
-      state_ = absl::make_unique<State>();
-    }
-    std::swap(state_->callbacks[token], callback);
+    std::swap(shard->callbacks[token], callback);
   }
   return should_register;
 }
 
 bool CancellationManager::DeregisterCallback(CancellationToken token) {
-  mu_.lock();
+  State* state = state_.load(std::memory_order_acquire);
+  if (state == nullptr) {
+    // No callback has been registered, so there is nothing to wait for.
+    return !IsCancellingOrCancelled();
+  }
+  CallbackShard* shard = ShardFor(state, token);
+  shard->mu.lock();
   if (is_cancelled_) {
-    mu_.unlock();
+    shard->mu.unlock();
     return false;
   } else if (is_cancelling_) {
-    Notification* cancelled_notification =
-        state_ ? &state_->cancelled_notification : nullptr;
-    mu_.unlock();
+    shard->mu.unlock();
     // Wait for all of the cancellation callbacks to be called. This
     // wait ensures that the caller of DeregisterCallback does not
     // return immediately and free objects that may be used in the
     // execution of any currently pending callbacks in StartCancel.
-    if (cancelled_notification) {
-      cancelled_notification->WaitForNotification();
-    }
+    state->cancelled_notification.WaitForNotification();
+    return false;
+  } else if (is_cancelled_) {
+    // StartCancel() completed between the two loads above.
+    shard->mu.unlock();
     return false;
   } else {
-    if (state_) {
-      state_->callbacks.erase(token);
-    }
-    mu_.unlock();
+    shard->callbacks.erase(token);
+    shard->mu.unlock();
     return true;
   }
 }
 
 bool CancellationManager::RegisterChild(CancellationManager* child) {
+  State* state = GetOrCreateState();
   mutex_lock l(mu_);
   if (is_cancelled_.load(std::memory_order_relaxed) || is_cancelling_) {
     child->is_removed_from_parent_ = true;
     return true;
   }
 
-  if (!state_) {
-    state_ = absl::make_unique<State>();
-  }
-
   // Push `child` onto the front of the list of children.
-  CancellationManager* current_head = state_->first_child;
-  state_->first_child = child;
+  CancellationManager* current_head = state->first_child;
+  state->first_child = child;
   child->prev_sibling_ = nullptr;
   child->next_sibling_ = current_head;
   if (current_head) {
@@ -149,14 +179,15 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
   Notification* cancelled_notification = nullptr;
   {
     mutex_lock l(mu_);
+    State* state = state_.load(std::memory_order_relaxed);
     if (!child->is_removed_from_parent_) {
       // Remove the child from this manager's list of children.
-      DCHECK(state_);
+      DCHECK(state);
 
       if (child->prev_sibling_ == nullptr) {
         // The child was at the head of the list.
-        DCHECK_EQ(state_->first_child, child);
-        state_->first_child = child->next_sibling_;
+        DCHECK_EQ(state->first_child, child);
+        state->first_child = child->next_sibling_;
       } else {
         child->prev_sibling_->next_sibling_ = child->next_sibling_;
       }
@@ -167,8 +198,8 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
 
       child->is_removed_from_parent_ = true;
     }
-    if (is_cancelling_) {
-      cancelled_notification = &state_->cancelled_notification;
+    if (is_cancelling_ && state) {
+      cancelled_notification = &state->cancelled_notification;
     }
   }
 
@@ -181,13 +212,16 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
 }
 
 bool CancellationManager::TryDeregisterCallback(CancellationToken token) {
-  mutex_lock lock(mu_);
-  if (is_cancelled_ || is_cancelling_) {
+  State* state = state_.load(std::memory_order_acquire);
+  if (state == nullptr) {
+    return !IsCancellingOrCancelled();
+  }
+  CallbackShard* shard = ShardFor(state, token);
+  mutex_lock lock(shard->mu);
+  if (IsCancellingOrCancelled()) {
     return false;
   } else {
-    if (state_) {
-      state_->callbacks.erase(token);
-    }
+    shard->callbacks.erase(token);
     return true;
   }
 }
@@ -196,15 +230,14 @@ CancellationManager::~CancellationManager() {
   if (parent_) {
     parent_->DeregisterChild(this);
   }
-  if (state_) {
+  State* state = state_.load(std::memory_order_acquire);
+  if (state) {
     StartCancel();
+    delete state;
   }
 }
 
-bool CancellationManager::IsCancelling() {
-  mutex_lock lock(mu_);
-  return is_cancelling_;
-}
+bool CancellationManager::IsCancelling() { return is_cancelling_; }
 
 Status RegisterCancellationCallback(CancellationManager* cancellation_manager,
                                     std::function<void()> callback,
@@ -19,10 +19,9 @@ limitations under the License.
 #include <atomic>
 #include <functional>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/gtl/flatmap.h"
-#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
@@ -45,6 +44,12 @@ typedef std::function<void()> CancelCallback;
 // This class should never simultaneously be used as the cancellation manager
 // for two separate sets of executions (i.e two separate steps, or two separate
 // function executions).
+//
+// The callbacks are kept in shards selected by their token, each guarded by
+// its own mutex, so that the many concurrent registrations and
+// deregistrations of a step do not contend on a single lock. The shards and
+// the list of children are allocated on the first registration, so that a
+// manager that nothing registers with costs no allocation.
 class CancellationManager {
  public:
   // A value that won't be returned by get_cancellation_token().
@@ -147,19 +152,43 @@ class CancellationManager {
   bool IsCancelling();
 
  private:
+  static constexpr int kNumCallbackShards = 16;
+
+  struct CallbackShard {
+    mutex mu;
+    absl::flat_hash_map<CancellationToken, CancelCallback> callbacks
+        TF_GUARDED_BY(mu);
+  };
+
   struct State {
     Notification cancelled_notification;
-    gtl::FlatMap<CancellationToken, CancelCallback> callbacks;
+    CallbackShard shards[kNumCallbackShards];
 
     // If this CancellationManager has any children, this member points to the
     // head of a doubly-linked list of its children.
     CancellationManager* first_child = nullptr;  // Not owned.
   };
 
+  static CallbackShard* ShardFor(State* state, CancellationToken token) {
+    return &state->shards[token & (kNumCallbackShards - 1)];
+  }
+
+  // Returns the state of this manager, allocating it if necessary.
+  State* GetOrCreateState() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns true iff StartCancel() has started. Callers that hold the lock of
+  // a callback shard observe a value that is consistent with the callbacks
+  // that StartCancel() takes from that shard.
+  bool IsCancellingOrCancelled() {
+    // is_cancelled_ is set before is_cancelling_ is cleared, so loading them
+    // in the opposite order sees at least one of them set.
+    return is_cancelling_.load() || is_cancelled_.load();
+  }
+
   bool RegisterChild(CancellationManager* child);
   void DeregisterChild(CancellationManager* child);
 
-  bool is_cancelling_;
+  std::atomic_bool is_cancelling_;
   std::atomic_bool is_cancelled_;
   std::atomic<CancellationToken> next_cancellation_token_;
 
@@ -179,7 +208,9 @@ class CancellationManager {
       nullptr;  // Not owned.
 
   mutex mu_;
-  std::unique_ptr<State> state_ TF_GUARDED_BY(mu_);
+  // Owned. Written once under mu_, and read without it by the callback
+  // (de)registration methods.
+  std::atomic<State*> state_;
 };
 
 // Registers the given cancellation callback, returning a function that can be
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <random>
 #include <vector>
@@ -196,6 +197,43 @@ TEST(Cancellation, TryDeregisterDuringCancel) {
   delete manager;
 }
 
+TEST(Cancellation, ConcurrentRegisterDeregisterDuringCancel) {
+  // Every registered callback is either deregistered or run exactly once,
+  // whichever callback shard it lands in.
+  for (int rounds = 0; rounds < 20; ++rounds) {
+    CancellationManager manager;
+    std::atomic<int> num_registered(0), num_deregistered(0), num_run(0);
+    {
+      thread::ThreadPool w(Env::Default(), "test", 8);
+      for (int i = 0; i < 8; ++i) {
+        w.Schedule([&, i]() {
+          for (int j = 0; j < 100; ++j) {
+            auto token = manager.get_cancellation_token();
+            if (!manager.RegisterCallback(token, [&]() { ++num_run; })) {
+              continue;
+            }
+            ++num_registered;
+            if ((i + j) % 2 == 0 && manager.DeregisterCallback(token)) {
+              ++num_deregistered;
+            }
+          }
+        });
+      }
+      w.Schedule([&]() { manager.StartCancel(); });
+    }
+    EXPECT_TRUE(manager.IsCancelled());
+    EXPECT_EQ(num_registered, num_deregistered + num_run);
+  }
+}
+
+TEST(Cancellation, DeregisterWithoutRegistration) {
+  CancellationManager manager;
+  EXPECT_TRUE(manager.DeregisterCallback(manager.get_cancellation_token()));
+  EXPECT_TRUE(manager.TryDeregisterCallback(manager.get_cancellation_token()));
+  manager.StartCancel();
+  EXPECT_FALSE(manager.DeregisterCallback(manager.get_cancellation_token()));
+}
+
 TEST(Cancellation, Parent_CancelManyChildren) {
   CancellationManager parent;
   std::vector<std::unique_ptr<CancellationManager>> children;
@@ -120,6 +120,13 @@ string CollInstanceParams::ToString() const {
     }
     strings::StrAppend(&v, "}");
   }  // all subdivs
+  const CollectiveWireFormat& wire_format = impl_details.wire_format;
+  if (wire_format.dtype != DT_INVALID || wire_format.topk_fraction > 0) {
+    strings::StrAppend(&v, " wire_format={dtype=",
+                       DataTypeString(wire_format.dtype),
+                       " topk_fraction=", wire_format.topk_fraction,
+                       " min_bytes=", wire_format.min_bytes, "}");
+  }
   if (type == PERMUTE_COLLECTIVE) {
     strings::StrAppend(&v, "}, permute_devices {");
     for (const auto& d : devices) {
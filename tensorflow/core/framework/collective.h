@@ -84,6 +84,26 @@ struct CollGroupParams {
       : group_key(0), group_size(0), device_type(DEVICE_CPU), num_tasks(0) {}
 };
 
+// Optional lossy encoding of the buffers that a collective exchanges between
+// tasks. Buffers exchanged between devices of the same task are never encoded.
+struct CollectiveWireFormat {
+  // DT_HALF or DT_BFLOAT16 to down-cast DT_FLOAT buffers on the wire, or
+  // DT_INVALID to send them at full precision. Receivers convert back to
+  // DT_FLOAT before accumulating.
+  DataType dtype = DT_INVALID;
+  // If in (0, 1), only this fraction of the largest-magnitude elements of a
+  // buffer is sent. The sender keeps what it left out and adds it to the next
+  // send of the same buffer.
+  float topk_fraction = 0.0f;
+  // DT_FLOAT buffers smaller than this are sent unchanged.
+  int64_t min_bytes = 0;
+
+  bool compresses(DataType data_type, int64_t num_bytes) const {
+    return data_type == DT_FLOAT && num_bytes > 0 && num_bytes >= min_bytes &&
+           (dtype != DT_INVALID || (topk_fraction > 0 && topk_fraction < 1));
+  }
+};
+
 // The best implementation of a collective op depends on many factors
 // including the number of devices involved, the topology of
 // interconnects between them and the sizes of inputs.  This structure
@@ -109,6 +129,13 @@ struct CollImplDetails {
                               // e.g. ring or nccl
   float timeout_seconds;      // If non zero, set a completion timeout for the
                               // collective op to detect staleness.
+  // Reductions of one group that share a non-zero fusion_key are packed and
+  // reduced together once all fusion_group_size of them have been issued on
+  // a device.
+  int32 fusion_key = 0;
+  int32 fusion_group_size = 0;
+  // Encoding of the buffers received from remote tasks.
+  CollectiveWireFormat wire_format;
 };
 
 // Data common to all members of a collective instance.
@@ -276,6 +303,20 @@ class CollectiveRemoteAccess {
                             CancellationManager* cancellation_manager,
                             const StatusCallback& done) = 0;
 
+  // Like RecvFromPeer, but lets the transport ship the value from a remote
+  // peer in `wire_format`. Transports without such an encoding ignore it.
+  virtual void RecvFromPeerWithWireFormat(
+      const string& peer_device, const string& peer_task, bool peer_is_local,
+      const string& key, Device* to_device, DeviceContext* to_device_ctx,
+      const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+      const DeviceLocality& client_locality, int dev_to_dev_stream_index,
+      const CollectiveWireFormat& wire_format,
+      CancellationManager* cancellation_manager, const StatusCallback& done) {
+    RecvFromPeer(peer_device, peer_task, peer_is_local, key, to_device,
+                 to_device_ctx, to_alloc_attr, to_tensor, client_locality,
+                 dev_to_dev_stream_index, cancellation_manager, done);
+  }
+
   virtual void PostToPeer(const string& peer_device, const string& peer_task,
                           const string& key, Device* from_device,
                           DeviceContext* from_device_ctx,
@@ -310,6 +351,19 @@ class CollectiveExecutor : public core::RefCounted {
         "a CollectiveExecutor has not been provided."));
   }
 
+  // Like ExecuteAsync(), but runs the collective on `input` and `output`
+  // rather than on the first input and output of `ctx`, so that a kernel can
+  // run collectives on intermediate tensors. Both must outlive `done`.
+  virtual void ExecuteOnTensorsAsync(OpKernelContext* ctx,
+                                     const CollectiveParams* col_params,
+                                     const string& exec_key,
+                                     const Tensor* input, Tensor* output,
+                                     StatusCallback done) {
+    done(errors::Internal(
+        "A collective Op has been called in a context in which "
+        "a CollectiveExecutor has not been provided."));
+  }
+
   virtual void CompleteParamsAsync(const DeviceAttributes& device,
                                    CollectiveParams* cp,
                                    CancellationManager* cancel_mgr,
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
@@ -646,6 +647,12 @@ Status DatasetBase::Get(OpKernelContext* ctx, int64 index,
       "Random access is not implemented for this dataset.");
 }
 
+Status DatasetBase::Get(IteratorContext* ctx, int64 index,
+                        std::vector<Tensor>* out_tensors) const {
+  return errors::Unimplemented(
+      "Random access is not implemented for this dataset.");
+}
+
 Status DatasetBase::MergeOptionsFromInputs() {
   std::vector<const DatasetBase*> inputs;
   Status s = InputDatasets(&inputs);
@@ -823,8 +830,24 @@ Status DatasetBase::DatasetGraphDefBuilder::AddResourceHelper(
   return resource->AsGraphDef(builder(), output);
 }
 
+namespace {
+
+// Returns the name of an iterator from its prefix, which captures the
+// sequence of iterators joined by `::`, the same way as `Model::AddNode`.
+string IteratorName(const string& prefix) {
+  std::vector<string> parts =
+      str_util::Split(prefix, ':', str_util::SkipEmpty());
+  return parts.empty() ? prefix : parts.back();
+}
+
+}  // namespace
+
 DatasetBaseIterator::DatasetBaseIterator(const BaseParams& params)
-    : params_(params) {
+    : params_(params),
+      get_next_latency_sampler_(
+          metrics::GetTFDataGetNextLatencySampler(IteratorName(params.prefix))),
+      buffered_elements_sampler_(metrics::GetTFDataBufferedElementsSampler(
+          IteratorName(params.prefix))) {
   params_.dataset->Ref();
   VLOG(2) << prefix() << " constructor";
   strings::StrAppend(&traceme_metadata_, "name=", dataset()->metadata().name());
@@ -871,6 +894,7 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
   profiler::TraceMe activity([&] { return BuildTraceMeName(); },
                              profiler::TraceMeLevel::kInfo);
   DVLOG(3) << prefix() << " GetNext enter";
+  const uint64 start_us = EnvTime::NowMicros();
   auto model = ctx->model();
   if (collect_resource_usage(ctx)) {
     int64_t now_nanos = EnvTime::NowNanos();
@@ -906,6 +930,7 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
                          s.error_message());
     LOG(ERROR) << s;
   }
+  get_next_latency_sampler_->Add(EnvTime::NowMicros() - start_us);
   DVLOG(3) << prefix() << " GetNext exit";
   return s;
 }
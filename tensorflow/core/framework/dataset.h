@@ -45,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 
 // Polymorphic datasets should support all primitive TensorFlow
@@ -407,7 +408,8 @@ class IteratorContext {
           stats_aggregator(ctx->stats_aggregator()),
           thread_factory(ctx->thread_factory()),
           thread_pool(ctx->thread_pool()),
-          interleave_depth(ctx->interleave_depth()) {}
+          interleave_depth(ctx->interleave_depth()),
+          numa_node(ctx->numa_node()) {}
 
     explicit Params(OpKernelContext* ctx)
         : collective_executor(ctx->collective_executor()),
@@ -492,6 +494,10 @@ class IteratorContext {
     // root node to this node (not including this node) in the input pipeline
     // tree.
     int64 interleave_depth = 0;
+
+    // The NUMA node that the threads and buffers of the input pipeline are
+    // placed on, or `port::kNUMANoAffinity` if they are not placed.
+    int numa_node = port::kNUMANoAffinity;
   };
 
   explicit IteratorContext(IteratorContext* ctx) : params_(Params{ctx}) {}
@@ -552,6 +558,8 @@ class IteratorContext {
 
   int64 interleave_depth() { return params_.interleave_depth; }
 
+  int numa_node() const { return params_.numa_node; }
+
   std::unique_ptr<thread::ThreadPool> CreateThreadPool(const string& name,
                                                        int num_threads) {
     if (params_.thread_pool) {
@@ -561,7 +569,9 @@ class IteratorContext {
       // created `ThreadPool` instance.
       return absl::make_unique<thread::ThreadPool>(params_.thread_pool);
     } else {
-      return absl::make_unique<thread::ThreadPool>(params_.env, ThreadOptions(),
+      ThreadOptions thread_options;
+      thread_options.numa_node = params_.numa_node;
+      return absl::make_unique<thread::ThreadPool>(params_.env, thread_options,
                                                    name, num_threads,
                                                    /*low_latency_hint=*/false);
     }
@@ -572,8 +582,10 @@ class IteratorContext {
     if (params_.thread_factory) {
       return params_.thread_factory->StartThread(name, std::move(fn));
     } else {
+      ThreadOptions thread_options;
+      thread_options.numa_node = params_.numa_node;
       return absl::WrapUnique(
-          Env::Default()->StartThread({}, name, std::move(fn)));
+          Env::Default()->StartThread(thread_options, name, std::move(fn)));
     }
   }
 
@@ -998,6 +1010,11 @@ class DatasetBase : public core::RefCounted {
   virtual Status Get(OpKernelContext* ctx, int64 index,
                      std::vector<Tensor>* out_tensors) const;
 
+  // Return the element at a particular index for a randomly accessible dataset,
+  // from the iterator of a dataset that consumes this one.
+  virtual Status Get(IteratorContext* ctx, int64 index,
+                     std::vector<Tensor>* out_tensors) const;
+
   // Wrapper around a GraphDefBuilder which provides support for serializing
   // Datasets as GraphDefs.
   class DatasetGraphDefBuilder : public GraphDefBuilderWrapper {
@@ -1174,6 +1191,7 @@ class DatasetBaseIterator : public IteratorBase {
   void RecordBufferDequeue(IteratorContext* ctx,
                            const std::vector<Tensor>& element) {
     if (collect_resource_usage(ctx)) {
+      buffered_elements_sampler_->Add(node_->buffered_elements());
       node_->record_buffer_event(-GetAllocatedBytes(element), -1);
 
       DCHECK_GE(node_->buffered_elements(), 0);
@@ -1233,6 +1251,10 @@ class DatasetBaseIterator : public IteratorBase {
 
   string traceme_metadata_;
   BaseParams params_;
+  // Cheap runtime statistics of this iterator, exported through the
+  // monitoring API so that input pipelines can be watched without tracing.
+  monitoring::SamplerCell* const get_next_latency_sampler_;
+  monitoring::SamplerCell* const buffered_elements_sampler_;
 };
 
 // Represents an iterator that is associated with a particular dataset
@@ -151,6 +151,18 @@ class Device : public DeviceBase {
     return Status::OK();
   }
 
+  // Fills in `device_context_map`, indexed by node id, with the contexts that
+  // the nodes of `graph` run with instead of the one TryGetDeviceContext
+  // returns, e.g. to run them on different streams. Leaves the map empty, or
+  // its entries null, for nodes that run with the default context.
+  //
+  // The caller takes ownership of one reference on each non-null
+  // DeviceContext* in the map, and should call Unref().
+  virtual Status FillContextMap(
+      const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+    return Status::OK();
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
@@ -96,12 +96,24 @@ void LocalRendezvous::ItemQueue::push_back(Item* item) {
   }
 }
 
+/* static */ constexpr int LocalRendezvous::kNumShards;
+
 LocalRendezvous::~LocalRendezvous() {
-  if (!table_.empty()) {
+  bool has_items = false;
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    has_items |= !shard.table.empty();
+  }
+  if (has_items) {
     StartAbort(errors::Cancelled("LocalRendezvous deleted"));
   }
 }
 
+Status LocalRendezvous::GetAbortStatus() {
+  mutex_lock l(status_mu_);
+  return status_;
+}
+
 namespace {
 uint64 KeyHash(const StringPiece& k) { return Hash64(k.data(), k.size()); }
 }  // namespace
@@ -122,39 +134,47 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
         ->IncrementBy(1);
   }
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = GetShard(key_hash);
+  shard->mu.lock();
+  if (aborted_.load(std::memory_order_acquire)) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    return s;
+    shard->mu.unlock();
+    return GetAbortStatus();
   }
 
-  ItemQueue* queue = &table_[key_hash];
-  if (queue->head == nullptr || queue->head->type == Item::kSend) {
+  Table& table = shard->table;
+  auto it = table.find(key_hash);
+  if (it == table.end() || it->second.head->type == Item::kSend) {
     // There is no waiter for this message. Append the message
     // into the queue. The waiter will pick it up when arrives.
     // Only send-related fields need to be filled.
     // TODO(b/143786186): Investigate moving the allocation of `Item` outside
     // the lock.
     DVLOG(2) << "Enqueue Send Item (key:" << key.FullKey() << "). ";
-    queue->push_back(new Item(send_args, val, is_dead));
-    mu_.unlock();
+    Item* item = new Item(send_args, val, is_dead);
+    if (it == table.end()) {
+      table[key_hash].push_back(item);
+    } else {
+      it->second.push_back(item);
+    }
+    shard->mu.unlock();
     return Status::OK();
   }
 
   DVLOG(2) << "Consume Recv Item (key:" << key.FullKey() << "). ";
-  // There is an earliest waiter to consume this message.
+  // There is an earliest waiter to consume this message. Taking it does not
+  // allocate.
+  ItemQueue* queue = &it->second;
   Item* item = queue->head;
 
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    table.erase(it);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Notify the waiter by invoking its done closure, outside the
   // lock.
@@ -170,17 +190,18 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   uint64 key_hash = KeyHash(key.FullKey());
   DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = GetShard(key_hash);
+  shard->mu.lock();
+  if (aborted_.load(std::memory_order_acquire)) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    done(s, Rendezvous::Args(), recv_args, Tensor(), false);
+    shard->mu.unlock();
+    done(GetAbortStatus(), Rendezvous::Args(), recv_args, Tensor(), false);
     return;
   }
 
-  ItemQueue* queue = &table_[key_hash];
-  if (queue->head == nullptr || queue->head->type == Item::kRecv) {
+  Table& table = shard->table;
+  auto it = table.find(key_hash);
+  if (it == table.end() || it->second.head->type == Item::kRecv) {
     // There is no message to pick up.
     // Only recv-related fields need to be filled.
     CancellationManager* cm = recv_args.cancellation_manager;
@@ -204,12 +225,15 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       token = cm->get_cancellation_token();
       already_cancelled = !cm->RegisterCallback(token, [this, token, key_hash] {
         Item* item = nullptr;
+        Shard* shard = GetShard(key_hash);
         {
-          mutex_lock l(mu_);
-          ItemQueue* queue = &table_[key_hash];
+          mutex_lock l(shard->mu);
+          auto it = shard->table.find(key_hash);
           // Find an item in the queue with a cancellation token that matches
           // `token`, and remove it.
-          if (queue->head != nullptr && queue->head->type == Item::kRecv) {
+          if (it != shard->table.end() &&
+              it->second.head->type == Item::kRecv) {
+            ItemQueue* queue = &it->second;
             for (Item *prev = nullptr, *curr = queue->head; curr != nullptr;
                  prev = curr, curr = curr->next) {
               if (curr->recv_state.cancellation_token == token) {
@@ -217,7 +241,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
                 if (queue->head->next == nullptr) {
                   // We have a single-element queue, so we can erase it from
                   // the table.
-                  table_.erase(key_hash);
+                  shard->table.erase(it);
                 } else {
                   // Remove the current item from the queue.
                   if (curr == queue->head) {
@@ -249,7 +273,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       });
     }
     if (already_cancelled) {
-      mu_.unlock();
+      shard->mu.unlock();
       // Unref case (2)
       if (rc_owner_) rc_owner_->Unref();
       done(StatusGroup::MakeDerived(
@@ -262,6 +286,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
 
     // TODO(b/143786186): Investigate moving the allocation of `Item` outside
     // the lock.
+    ItemQueue* queue = it == table.end() ? &table[key_hash] : &it->second;
     if (cm != nullptr) {
       // NOTE(mrry): We must wrap `done` with code that deregisters the
       // cancellation callback before calling the `done` callback, because the
@@ -286,23 +311,24 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       queue->push_back(new Item(recv_args, std::move(done), token));
     }
 
-    mu_.unlock();
+    shard->mu.unlock();
     return;
   }
 
   DVLOG(2) << "Consume Send Item (key:" << key.FullKey() << "). ";
   // A message has already arrived and is queued in the table under
   // this key.  Consumes the message and invokes the done closure.
+  ItemQueue* queue = &it->second;
   Item* item = queue->head;
 
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    table.erase(it);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Invoke done() without holding the table lock.
   DCHECK_EQ(item->type, Item::kSend);
@@ -313,22 +339,28 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
 
 void LocalRendezvous::StartAbort(const Status& status) {
   CHECK(!status.ok());
-  Table table;
   {
-    mutex_lock l(mu_);
+    mutex_lock l(status_mu_);
     status_.Update(status);
-    table_.swap(table);
+    aborted_.store(true, std::memory_order_release);
   }
-  for (auto& p : table) {
-    Item* item = p.second.head;
-    while (item != nullptr) {
-      if (item->type == Item::kRecv) {
-        (*item->recv_state.waiter)(status, Rendezvous::Args(),
-                                   Rendezvous::Args(), Tensor(), false);
+  for (Shard& shard : shards_) {
+    Table table;
+    {
+      mutex_lock l(shard.mu);
+      shard.table.swap(table);
+    }
+    for (auto& p : table) {
+      Item* item = p.second.head;
+      while (item != nullptr) {
+        if (item->type == Item::kRecv) {
+          (*item->recv_state.waiter)(status, Rendezvous::Args(),
+                                     Rendezvous::Args(), Tensor(), false);
+        }
+        Item* to_delete = item;
+        item = item->next;
+        delete to_delete;
       }
-      Item* to_delete = item;
-      item = item->next;
-      delete to_delete;
     }
   }
 }
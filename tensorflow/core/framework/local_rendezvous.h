@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 
+#include <atomic>
+
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -66,13 +68,30 @@ class LocalRendezvous {
 
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
+  // The table is sharded by key hash, so that Send and Recv calls for
+  // different keys rarely contend on the same lock.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    Table table TF_GUARDED_BY(mu);
+  };
+  Shard* GetShard(uint64 key_hash) {
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
+
+  // Returns the status the rendezvous was aborted with.
+  Status GetAbortStatus() TF_LOCKS_EXCLUDED(status_mu_);
+
   // Pointer to the owner class of this LocalRendezvous if it is refcounted.
   const Rendezvous* rc_owner_;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ TF_GUARDED_BY(mu_);
-  Status status_ TF_GUARDED_BY(mu_);
+  Shard shards_[kNumShards];
+
+  // Set by StartAbort() before it empties the shards. Once a shard's lock is
+  // taken after that, no item is added to its table.
+  std::atomic<bool> aborted_{false};
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
 };
@@ -39,6 +39,12 @@ auto* graph_optimization_usecs =
                                 "optimization pass in microseconds.",
                                 "kind", "name");
 
+auto* grappler_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler_cache_lookups",
+    "The number of lookups in the optimized graph cache of the Grappler meta "
+    "optimizer.",
+    "result");
+
 auto* graph_run_time_usecs_histogram = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_time_usecs_histogram",
      "The wall-clock time spent on executing graphs in microseconds."},
@@ -51,6 +57,12 @@ auto* graph_pending_queue_length_histogram = monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count 30 (> 191k)
     {monitoring::Buckets::Exponential(1, 1.5, 30)});
 
+auto* executor_work_stealing_nodes = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor_work_stealing_nodes",
+    "The number of nodes run by the work-stealing executor, either inline on "
+    "the thread that made them ready or stolen by an idle thread.",
+    "kind");
+
 auto* graph_run_input_tensor_bytes = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -104,6 +116,24 @@ auto* tf_data_get_next_duration_usecs_histogram = monitoring::Sampler<0>::New(
     {monitoring::Buckets::Explicit(
         {2., 4., 8., 16., 32., 64., 128., 256., 512., 1024., 1e6})});
 
+auto* tf_data_get_next_latency_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/getnext_latency",
+     "Microseconds spent in GetNext() by the iterators of a tf.data "
+     "transformation, including the time spent in their inputs.",
+     "name"},
+    // Power of 2 from 1 microsecond to about 16 seconds.
+    {monitoring::Buckets::Exponential(1, 2, 25)});
+
+auto* tf_data_buffered_elements_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/buffered_elements",
+     "The number of elements buffered by the iterators of a tf.data "
+     "transformation when an element is taken from their buffer.",
+     "name"},
+    // 0, then powers of 2 up to 4096 elements.
+    {monitoring::Buckets::Explicit(
+        {1., 2., 4., 8., 16., 32., 64., 128., 256., 512., 1024., 2048.,
+         4096.})});
+
 auto* tf_data_iterator_busy_counter =
     monitoring::Counter<0>::New("/tensorflow/data/iterator_busy",
                                 "The time (in microseconds) during which a "
@@ -195,6 +225,29 @@ auto* bfc_allocator_delay =
                                 "The total time spent running each graph "
                                 "optimization pass in microseconds.");
 
+auto* collective_bus_bandwidth_mbps = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/collective/bus_bandwidth_mbps",
+     "The bus bandwidth achieved by each collective instance in megabytes per "
+     "second, i.e. the bandwidth of the links of an optimal algorithm.",
+     "collective"},
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* collective_phase_usecs = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/phase_usecs",
+    "The total time spent in each phase of the collective instances in "
+    "microseconds.",
+    "collective", "phase");
+
+auto* collective_peer_recv_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/collective/peer_recv_bytes",
+    "The total bytes received by collectives from each peer device.", "peer");
+
+auto* collective_peer_recv_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/collective/peer_recv_usecs",
+    "The total time collectives waited for receives from each peer device in "
+    "microseconds, including the time until the peer sent.",
+    "peer");
+
 auto* tpu_variable_distribution_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/tpu/variable_distribution_time",
     "Time spent sending variables from primary task to other worker tasks "
@@ -223,6 +276,14 @@ monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
 
+monitoring::SamplerCell* GetTFDataGetNextLatencySampler(const string& name) {
+  return tf_data_get_next_latency_usecs_histogram->GetCell(name);
+}
+
+monitoring::SamplerCell* GetTFDataBufferedElementsSampler(const string& name) {
+  return tf_data_buffered_elements_histogram->GetCell(name);
+}
+
 monitoring::GaugeCell<std::function<std::string()>>* GetTFDataModelGauge(
     const string& id) {
   return tf_data_model_gauge->GetCell(id);
@@ -341,6 +402,17 @@ void UpdateGraphPendingQueueLength(uint64 len) {
   graph_pending_queue_length_cell->Add(len);
 }
 
+void UpdateExecutorWorkStealing(int64_t inline_nodes, int64_t stolen_nodes) {
+  static auto* inline_cell = executor_work_stealing_nodes->GetCell("inline");
+  static auto* stolen_cell = executor_work_stealing_nodes->GetCell("stolen");
+  if (inline_nodes > 0) {
+    inline_cell->IncrementBy(inline_nodes);
+  }
+  if (stolen_nodes > 0) {
+    stolen_cell->IncrementBy(stolen_nodes);
+  }
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -385,6 +457,10 @@ void UpdateGraphOptimizerPassTime(const string& pass_name,
   }
 }
 
+void RecordGrapplerCacheLookup(const string& result) {
+  grappler_cache_lookups->GetCell(result)->IncrementBy(1);
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     static auto* build_graph_calls_cell = build_graph_calls->GetCell();
@@ -419,6 +495,24 @@ void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   }
 }
 
+void RecordCollectiveBusBandwidth(const string& collective, double mbps) {
+  collective_bus_bandwidth_mbps->GetCell(collective)->Add(mbps);
+}
+
+void UpdateCollectivePhaseTime(const string& collective, const string& phase,
+                               const uint64 running_time_usecs) {
+  if (running_time_usecs > 0) {
+    collective_phase_usecs->GetCell(collective, phase)
+        ->IncrementBy(running_time_usecs);
+  }
+}
+
+void RecordCollectivePeerRecv(const string& peer_device, int64_t num_bytes,
+                              const uint64 wait_usecs) {
+  collective_peer_recv_bytes->GetCell(peer_device)->IncrementBy(num_bytes);
+  collective_peer_recv_usecs->GetCell(peer_device)->IncrementBy(wait_usecs);
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
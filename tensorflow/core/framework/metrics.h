@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset_options.pb.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -57,6 +58,21 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 // The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 
+// Returns a sampler that can be used to record the time (in microseconds)
+// spent in `GetNext()` by the iterators of a tf.data.Dataset, including the
+// time spent in their inputs.
+//
+// The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
+monitoring::SamplerCell* GetTFDataGetNextLatencySampler(const string& name);
+
+// Returns a sampler that can be used to record the number of elements buffered
+// by an iterator of a tf.data.Dataset when an element is taken from its
+// buffer. Samples of 0 mean that the consumer of the iterator had to wait for
+// an element to be produced.
+//
+// The `name` argument identifies the Dataset type (e.g. "Prefetch").
+monitoring::SamplerCell* GetTFDataBufferedElementsSampler(const string& name);
+
 // Returns a gauge than can be used to record the performance model information.
 //
 // The `id` argument represents the (unique) model ID.
@@ -138,6 +154,10 @@ void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the nodes run by the work-stealing executor: `inline_nodes` ran on
+// the thread that made them ready, `stolen_nodes` were taken by idle threads.
+void UpdateExecutorWorkStealing(int64_t inline_nodes, int64_t stolen_nodes);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -168,6 +188,10 @@ void UpdateTFDataPassTime(const string& pass_name,
 void UpdateGraphOptimizerPassTime(const string& pass_name,
                                   const uint64 running_time_usecs);
 
+// Records a lookup in the optimized graph cache of the Grappler meta
+// optimizer. `result` is "hit" or "miss".
+void RecordGrapplerCacheLookup(const string& result);
+
 // Updates metrics for time to distribute variables to all TPU hosts.
 void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs);
 
@@ -177,6 +201,19 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
+// Records the bus bandwidth achieved by an instance of `collective`, e.g.
+// "RingReduce".
+void RecordCollectiveBusBandwidth(const string& collective, double mbps);
+
+// Updates the time spent in `phase` of the instances of `collective`.
+void UpdateCollectivePhaseTime(const string& collective, const string& phase,
+                               const uint64 running_time_usecs);
+
+// Records the bytes received by a collective from `peer_device`, and the time
+// waited for them. Peers with a low bandwidth have slow links or straggle.
+void RecordCollectivePeerRecv(const string& peer_device, int64_t num_bytes,
+                              const uint64 wait_usecs);
+
 }  // namespace metrics
 }  // namespace tensorflow
 
@@ -15,8 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <algorithm>
+#include <deque>
+#include <limits>
 #include <memory>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -121,6 +126,43 @@ inline void UpdateStateValues(Node::ModelParameters* parameters) {
   }
 }
 
+// Returns the key of a parameter in `Model::tuned_parameters_`.
+inline string TunedParameterKey(const string& node_path,
+                                const string& parameter_name) {
+  return strings::StrCat(node_path, ":", parameter_name);
+}
+
+// Returns the names of the nodes from the output node to `node`, separated by
+// `/`.
+string NodePath(const Node* node) {
+  std::vector<string> names;
+  for (; node != nullptr; node = node->output()) {
+    names.push_back(node->name());
+  }
+  std::reverse(names.begin(), names.end());
+  return absl::StrJoin(names, "/");
+}
+
+// Sets the tunable parameters of `node`, whose path is `node_path`, to their
+// values in `tuned_parameters`.
+void ApplyTunedParameters(
+    const absl::flat_hash_map<string, double>& tuned_parameters,
+    const Node& node, const string& node_path) {
+  for (auto& parameter : node.TunableParameters()) {
+    auto* value = gtl::FindOrNull(
+        tuned_parameters, TunedParameterKey(node_path, parameter->name));
+    if (!value) continue;
+    const double clamped_value =
+        std::min(std::max(*value, parameter->min), parameter->max);
+    VLOG(2) << "Warm-starting tunable parameter " << node.long_name()
+            << ":: " << parameter->name << " at " << clamped_value;
+    parameter->warm_start_value = clamped_value;
+    mutex_lock l(*parameter->state->mu);
+    parameter->state->value = clamped_value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 // Recursively produces protos for nodes in a subtree of `output` node and
 // appends them to nodes of the given model.
 Status ModelToProtoHelper(std::shared_ptr<Node> output, ModelProto* model) {
@@ -444,13 +486,25 @@ class KnownRatio : public Node {
  public:
   KnownRatio(Node::Args args, double ratio) : Node(args), ratio_(ratio) {}
 
+  KnownRatio(Node::Args args, double ratio,
+             std::vector<std::shared_ptr<Parameter>> parameters)
+      : Node(args), ratio_(ratio) {
+    for (auto& parameter : parameters) {
+      parameters_[parameter->name] = std::move(parameter);
+    }
+  }
+
   virtual ~KnownRatio() {}
 
  protected:
   std::shared_ptr<Node> Clone(std::shared_ptr<Node> output) const override
       TF_SHARED_LOCKS_REQUIRED(mu_) {
+    std::vector<std::shared_ptr<Parameter>> parameters;
+    for (auto& pair : parameters_) {
+      parameters.push_back(pair.second);
+    }
     return std::make_shared<KnownRatio>(Args{id_, name_, std::move(output)},
-                                        ratio_);
+                                        ratio_, parameters);
   }
 
   // The input time is the sum of inherited input time and self processing time,
@@ -948,6 +1002,13 @@ std::shared_ptr<Node> MakeKnownRatioNode(Node::Args args, double ratio) {
   return std::make_shared<KnownRatio>(std::move(args), ratio);
 }
 
+std::shared_ptr<Node> MakeKnownRatioNode(
+    Node::Args args, double ratio,
+    std::vector<std::shared_ptr<Parameter>> parameters) {
+  return std::make_shared<KnownRatio>(std::move(args), ratio,
+                                      std::move(parameters));
+}
+
 std::shared_ptr<Node> MakeAsyncKnownRatioNode(
     Node::Args args, double ratio, double memory_ratio,
     std::vector<std::shared_ptr<Parameter>> parameters) {
@@ -1131,6 +1192,17 @@ Node::ModelParameters Node::CollectTunableParameters() const {
   return CollectTunableParametersLocked();
 }
 
+std::vector<std::shared_ptr<Parameter>> Node::TunableParameters() const {
+  tf_shared_lock l(mu_);
+  std::vector<std::shared_ptr<Parameter>> parameters;
+  for (auto& pair : parameters_) {
+    if (pair.second->state->tunable) {
+      parameters.push_back(pair.second);
+    }
+  }
+  return parameters;
+}
+
 string Node::DebugString() const {
   absl::flat_hash_map<string, string> debug_strings;
   tf_shared_lock l(mu_);
@@ -1234,6 +1306,16 @@ double Node::TotalMaximumBufferedBytes() const {
   return total_bytes[long_name()];
 }
 
+double Node::TotalFixedMaximumBufferedBytes() const {
+  tf_shared_lock l(mu_);
+  double result = FixedMaximumBufferedBytes();
+  for (const auto& node : CollectNodes(TraversalOrder::BFS, IsAnyNode)) {
+    tf_shared_lock l(node->mu_);
+    result += node->FixedMaximumBufferedBytes();
+  }
+  return result;
+}
+
 double Node::TotalProcessingTime(Node::NodeValues* processing_times) {
   // Create a hash map to store the per-element CPU time spent in the subtree
   // rooted in each node.
@@ -1490,9 +1572,28 @@ void Node::TotalMaximumBufferedBytesHelper(Node::NodeValues* total_bytes) const
 }
 
 double Node::MaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_) {
+  // Nodes that buffer elements without an asynchronous producer (e.g. shuffle)
+  // describe their buffer with a `buffer_size` parameter, which need not be
+  // tunable.
+  auto* parameter = gtl::FindOrNull(parameters_, kBufferSize);
+  if (parameter) {
+    return (*parameter)->value * AverageBufferedElementSize();
+  }
   return 0;
 }
 
+double Node::FixedMaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_) {
+  if (!autotune_) {
+    return 0;
+  }
+  for (const auto& pair : parameters_) {
+    if (pair.second->state->tunable) {
+      return 0;
+    }
+  }
+  return MaximumBufferedBytes();
+}
+
 Status Node::ToProto(ModelProto::Node* node_proto) const {
   tf_shared_lock l(mu_);
   node_proto->set_id(id_);
@@ -1620,12 +1721,126 @@ void Model::AddNode(Node::Factory factory, const string& name,
   } else {
     VLOG(3) << "Adding " << node->long_name();
   }
+  if (!tuned_parameters_.empty()) {
+    ApplyTunedParameters(tuned_parameters_, *node, NodePath(node.get()));
+  }
   *out_node = std::move(node);
   // TODO(jsimsa): Reset the optimization period when a node is added so that
   // autotuning adapts to changes to the input pipeline faster. Initial attempt
   // to enable this functionality caused a regression (see b/179812091).
 }
 
+TunedParametersProto Model::GetTunedParameters() {
+  TunedParametersProto tuned;
+  std::deque<std::pair<std::shared_ptr<Node>, string>> queue;
+  {
+    tf_shared_lock l(mu_);
+    tuned.set_fingerprint(fingerprint_);
+    if (output_) queue.push_back({output_, output_->name()});
+  }
+  absl::flat_hash_set<string> keys;
+  while (!queue.empty()) {
+    auto node = std::move(queue.front().first);
+    const string node_path = std::move(queue.front().second);
+    queue.pop_front();
+    for (auto& parameter : node->TunableParameters()) {
+      double value;
+      {
+        mutex_lock l(*parameter->state->mu);
+        value = parameter->state->value;
+      }
+      if (value == kAutotune ||
+          !keys.insert(TunedParameterKey(node_path, parameter->name)).second) {
+        continue;
+      }
+      TunedParametersProto::Parameter* parameter_proto =
+          tuned.add_parameters();
+      parameter_proto->set_node_path(node_path);
+      parameter_proto->set_name(parameter->name);
+      parameter_proto->set_value(value);
+    }
+    for (auto& input : node->inputs()) {
+      queue.push_back({input, strings::StrCat(node_path, "/", input->name())});
+    }
+  }
+  return tuned;
+}
+
+void Model::SetTunedParameters(const TunedParametersProto& tuned) {
+  absl::flat_hash_map<string, double> tuned_parameters;
+  for (const auto& parameter : tuned.parameters()) {
+    tuned_parameters[TunedParameterKey(parameter.node_path(),
+                                       parameter.name())] = parameter.value();
+  }
+  std::vector<std::pair<std::shared_ptr<Node>, string>> nodes;
+  {
+    mutex_lock l(mu_);
+    tuned_parameters_ = tuned_parameters;
+    if (output_) nodes.push_back({output_, output_->name()});
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (auto& input : nodes[i].first->inputs()) {
+        nodes.push_back(
+            {input, strings::StrCat(nodes[i].second, "/", input->name())});
+      }
+    }
+  }
+  // Input pipeline threads may hold the mutex of a parameter state while
+  // adding nodes, so the states of existing nodes are updated without holding
+  // `mu_`.
+  for (auto& pair : nodes) {
+    ApplyTunedParameters(tuned_parameters, *pair.first, pair.second);
+  }
+}
+
+Status Model::SetTunedParametersFile(const string& fname, uint64 fingerprint) {
+  {
+    mutex_lock l(mu_);
+    tuned_parameters_file_ = fname;
+    fingerprint_ = fingerprint;
+  }
+  Env* env = Env::Default();
+  if (!env->FileExists(fname).ok()) {
+    return Status::OK();
+  }
+  TunedParametersProto tuned;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, fname, &tuned));
+  if (tuned.fingerprint() != fingerprint) {
+    VLOG(1) << "Not warm-starting autotuning from " << fname
+            << ", which was saved for another input pipeline.";
+    return Status::OK();
+  }
+  VLOG(1) << "Warm-starting autotuning from " << fname;
+  SetTunedParameters(tuned);
+  return Status::OK();
+}
+
+Status Model::SaveTunedParameters(const string& fname) {
+  // Writes a temporary file first so that readers never see a partial file.
+  Env* env = Env::Default();
+  string tmp_fname = fname;
+  if (!env->CreateUniqueFileName(&tmp_fname, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            fname);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_fname, GetTunedParameters()));
+  return env->RenameFile(tmp_fname, fname);
+}
+
+void Model::InitializeParameterValues(Model::ModelParameters* parameters) {
+  bool warm_start;
+  {
+    tf_shared_lock l(mu_);
+    warm_start = optimization_period_ms_ < kOptimizationPeriodMaxMs;
+  }
+  for (auto& pair : *parameters) {
+    pair.second->value = pair.second->min;
+    if (warm_start) {
+      pair.second->value =
+          std::max(pair.second->value, pair.second->warm_start_value.load());
+    }
+  }
+}
+
 void Model::FlushMetrics() {
   std::deque<std::shared_ptr<Node>> queue;
   {
@@ -1685,11 +1900,10 @@ Model::ModelParameters Model::CollectTunableParameters(
   return node->CollectTunableParameters();
 }
 
-bool Model::ShouldStop(int64_t cpu_budget, int64_t ram_budget,
+bool Model::ShouldStop(int64_t cpu_budget,
                        const Model::ModelParameters& parameters,
                        const Model::ModelParameters& parallelism_parameters,
                        const Model::ModelParameters& buffer_size_parameters,
-                       std::shared_ptr<Node> snapshot,
                        bool* cpu_budget_reached) {
   if (!(*cpu_budget_reached)) {
     // If those essential transformations' parallelism reaches the CPU
@@ -1711,9 +1925,102 @@ bool Model::ShouldStop(int64_t cpu_budget, int64_t ram_budget,
     }
   }
 
-  // If all parameters have reached their maximum values or RAM budget is
-  // reached, we stop the iterations.
-  return all_max || TotalMaximumBufferedBytes(snapshot) > ram_budget;
+  // If all parameters have reached their maximum values, we stop the
+  // iterations. The RAM budget is enforced by `FitRamBudget()` instead, which
+  // lets the memory be redistributed between buffers.
+  return all_max;
+}
+
+bool Model::FitRamBudget(std::shared_ptr<Node> snapshot,
+                         double model_input_time, int64_t ram_budget,
+                         Model::ModelParameters* parameters) {
+  double buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+  while (buffered_bytes > ram_budget) {
+    const double output_time =
+        OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
+    // Decrements the parameter which frees memory at the lowest cost in output
+    // time per byte.
+    double best_cost = std::numeric_limits<double>::max();
+    double best_buffered_bytes = buffered_bytes;
+    Parameter* best_parameter = nullptr;
+    double best_step = 0;
+    for (auto& pair : *parameters) {
+      const double step = std::min(1.0, pair.second->value - pair.second->min);
+      if (step <= 0) {
+        continue;
+      }
+      pair.second->value -= step;
+      const double new_buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+      const double freed_bytes = buffered_bytes - new_buffered_bytes;
+      if (freed_bytes > 0) {
+        const double cost =
+            std::max(0.0, OutputTime(snapshot, model_input_time,
+                                     /*gradients=*/nullptr) -
+                              output_time) /
+            freed_bytes;
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_buffered_bytes = new_buffered_bytes;
+          best_parameter = pair.second.get();
+          best_step = step;
+        }
+      }
+      pair.second->value += step;
+    }
+    if (!best_parameter) {
+      LOG_EVERY_N_SEC(WARNING, 60)
+          << "The tunable parameters of the tf.data input pipeline cannot be "
+             "decreased to fit its RAM budget of "
+          << ram_budget << " bytes; " << buffered_bytes
+          << " bytes would be buffered.";
+      return false;
+    }
+    best_parameter->value -= best_step;
+    buffered_bytes = best_buffered_bytes;
+  }
+  return true;
+}
+
+int64_t Model::EffectiveRamBudget(std::shared_ptr<Node> snapshot,
+                                  int64_t ram_budget) {
+  const double fixed_bytes = snapshot->TotalFixedMaximumBufferedBytes();
+  if (fixed_bytes <= ram_budget) {
+    return ram_budget;
+  }
+  LOG_EVERY_N_SEC(WARNING, 60)
+      << "The buffers of the tf.data input pipeline that cannot be tuned, e.g. "
+         "shuffle buffers, hold up to "
+      << fixed_bytes << " bytes, which exceeds its RAM budget of "
+      << ram_budget
+      << " bytes. The tunable buffers are fitted to the budget on their own.";
+  return ram_budget + static_cast<int64_t>(fixed_bytes);
+}
+
+void Model::RecordOptimizationPlan(
+    std::shared_ptr<Node> snapshot,
+    const OptimizationParams& optimization_params,
+    Model::ModelParameters* parameters, bool cpu_budget_reached,
+    bool ram_budget_reached) {
+  OptimizationPlan plan;
+  plan.set_output_time(OutputTime(snapshot,
+                                  optimization_params.model_input_time(),
+                                  /*gradients=*/nullptr));
+  plan.set_maximum_buffered_bytes(TotalMaximumBufferedBytes(snapshot));
+  std::vector<double> values;
+  values.reserve(parameters->size());
+  for (auto& pair : *parameters) {
+    values.push_back(pair.second->value);
+    pair.second->value = pair.second->min;
+  }
+  plan.set_minimum_buffered_bytes(TotalMaximumBufferedBytes(snapshot));
+  for (size_t i = 0; i < parameters->size(); ++i) {
+    (*parameters)[i].second->value = values[i];
+  }
+  plan.set_cpu_budget_reached(cpu_budget_reached);
+  plan.set_ram_budget_reached(ram_budget_reached);
+  VLOG(2) << "Optimization plan: " << plan.ShortDebugString();
+  mutex_lock l(mu_);
+  optimization_plan_ = std::move(plan);
 }
 
 // TODO(jsimsa): Add support for tracking and using the model input time.
@@ -1753,6 +2060,19 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
     int64_t end_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
     VLOG(2) << "Optimized for " << end_ms - start_ms << " ms.";
 
+    string tuned_parameters_file;
+    {
+      tf_shared_lock l(mu_);
+      tuned_parameters_file = tuned_parameters_file_;
+    }
+    if (!tuned_parameters_file.empty()) {
+      Status s = SaveTunedParameters(tuned_parameters_file);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to save the tuned parameters to "
+                     << tuned_parameters_file << ": " << s;
+      }
+    }
+
     // Exponentially increase the period of running the optimization
     // until a threshold is reached.
     {
@@ -1786,10 +2106,7 @@ void Model::OptimizeGradientDescent(
   CollectParameters(snapshot, parameters, &parallelism_parameters,
                     &buffer_size_parameters);
 
-  // Initialize the parameter values to minimal before tuning.
-  for (auto& pair : parameters) {
-    pair.second->value = pair.second->min;
-  }
+  InitializeParameterValues(&parameters);
 
   // Optimization is stopped once the `OutputTime` improvement is smaller than
   // this value.
@@ -1804,15 +2121,26 @@ void Model::OptimizeGradientDescent(
   // When the CPU budget is reached, the parallelism parameter values are fixed
   // and we only increase the buffer size parameters.
   bool cpu_budget_reached = false;
+  bool ram_budget_reached = false;
+  const int64_t ram_budget =
+      EffectiveRamBudget(snapshot, optimization_params.ram_budget());
 
   for (int i = 0; i < kMaxIterations; ++i) {
     if (cancellation_manager->IsCancelled() ||
-        ShouldStop(optimization_params.cpu_budget(),
-                   optimization_params.ram_budget(), parameters,
-                   parallelism_parameters, buffer_size_parameters, snapshot,
+        ShouldStop(optimization_params.cpu_budget(), parameters,
+                   parallelism_parameters, buffer_size_parameters,
                    &cpu_budget_reached)) {
       break;
     }
+    // Projects the previous step back on the RAM budget. Subsequent steps can
+    // then move memory to the buffers that reduce the output time the most.
+    if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      ram_budget_reached = true;
+      if (!FitRamBudget(snapshot, optimization_params.model_input_time(),
+                        ram_budget, &parameters)) {
+        break;
+      }
+    }
     Model::ParameterGradients gradients;
     new_output_time = OutputTime(
         snapshot, optimization_params.model_input_time(), &gradients);
@@ -1830,6 +2158,14 @@ void Model::OptimizeGradientDescent(
   for (auto& pair : parameters) {
     pair.second->value = std::round(pair.second->value);
   }
+  // The last step, or rounding, may exceed the budget again.
+  if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+    ram_budget_reached = true;
+    FitRamBudget(snapshot, optimization_params.model_input_time(), ram_budget,
+                 &parameters);
+  }
+  RecordOptimizationPlan(snapshot, optimization_params, &parameters,
+                         cpu_budget_reached, ram_budget_reached);
   UpdateStateValues(&parameters);
 }
 
@@ -1850,10 +2186,10 @@ void Model::OptimizeHillClimb(std::shared_ptr<Node> snapshot,
   // improvement is greater than this constant.
   constexpr double kBufferSizeMinDelta = 1.0L;
 
-  // Initialize the parameter values to minimal before tuning.
-  for (auto& pair : parameters) {
-    pair.second->value = pair.second->min;
-  }
+  InitializeParameterValues(&parameters);
+  bool ram_budget_reached = false;
+  const int64_t ram_budget =
+      EffectiveRamBudget(snapshot, optimization_params.ram_budget());
   while (!cancellation_manager->IsCancelled()) {
     const double output_time =
         OutputTime(snapshot, optimization_params.model_input_time(),
@@ -1865,10 +2201,12 @@ void Model::OptimizeHillClimb(std::shared_ptr<Node> snapshot,
         break;
       }
     }
+    if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      ram_budget_reached = true;
+      break;
+    }
     if (output_time < processing_time / optimization_params.cpu_budget() ||
-        all_max ||
-        TotalMaximumBufferedBytes(snapshot) >
-            optimization_params.ram_budget()) {
+        all_max) {
       break;
     }
     double best_delta = -1.0L;
@@ -1898,6 +2236,8 @@ void Model::OptimizeHillClimb(std::shared_ptr<Node> snapshot,
     }
     best_parameter->value++;
   }
+  RecordOptimizationPlan(snapshot, optimization_params, &parameters,
+                         /*cpu_budget_reached=*/false, ram_budget_reached);
   UpdateStateValues(&parameters);
 }
 
@@ -1931,6 +2271,7 @@ double Model::TotalProcessingTime(std::shared_ptr<Node> node) {
 Status Model::ToProto(ModelProto* model_proto) {
   tf_shared_lock l(mu_);
   model_proto->set_id_counter(id_counter_);
+  *model_proto->mutable_optimization_plan() = optimization_plan_;
   return ModelToProtoHelper(output_, model_proto);
 }
 
@@ -1940,6 +2281,7 @@ Status Model::FromProto(ModelProto model_proto, std::unique_ptr<Model>* model) {
   TF_RETURN_IF_ERROR(
       ModelFromProtoHelper(model_proto, &restored_model->output_));
   restored_model->id_counter_ = model_proto.id_counter();
+  restored_model->optimization_plan_ = model_proto.optimization_plan();
   *model = std::move(restored_model);
   return Status::OK();
 }
@@ -1952,6 +2294,7 @@ Status Model::Save(const string& fname, std::shared_ptr<Node> snapshot,
     mutex_lock l(model_snapshot->mu_);
     model_snapshot->output_ = std::move(snapshot);
     model_snapshot->id_counter_ = id_counter_;
+    model_snapshot->optimization_plan_ = optimization_plan_;
   }
   TF_RETURN_IF_ERROR(model_snapshot->ToProto(&model_proto));
   OptimizationParams* saved_optimization_params =
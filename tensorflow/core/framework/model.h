@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -106,6 +107,10 @@ struct Parameter {
 
   // Shared state of the parameter.
   std::shared_ptr<SharedState> state;
+
+  // Value of the parameter in an earlier run of the input pipeline, from which
+  // the optimization starts while the model warms up, or 0 if none.
+  std::atomic<double> warm_start_value{0};
 };
 
 std::shared_ptr<Parameter> MakeParameter(const string& name,
@@ -341,6 +346,11 @@ class Node {
   // Collects tunable parameters in the subtree rooted in this node.
   ModelParameters CollectTunableParameters() const TF_LOCKS_EXCLUDED(mu_);
 
+  // Returns the tunable parameters of this node, whether or not it has
+  // recorded elements.
+  std::vector<std::shared_ptr<Parameter>> TunableParameters() const
+      TF_LOCKS_EXCLUDED(mu_);
+
   // Returns a human-readable representation of this node.
   string DebugString() const TF_LOCKS_EXCLUDED(mu_);
 
@@ -372,6 +382,11 @@ class Node {
   // would be used by the subtree nodes if all of their buffers were full.
   double TotalMaximumBufferedBytes() const TF_LOCKS_EXCLUDED(mu_);
 
+  // Collects the buffer limit of the nodes in the subtree for which autotuning
+  // is enabled and which have no tunable parameters, e.g. shuffle buffers. The
+  // optimization algorithms cannot reduce this memory.
+  double TotalFixedMaximumBufferedBytes() const TF_LOCKS_EXCLUDED(mu_);
+
   // Returns the per-element CPU time spent in the subtree rooted in this node.
   // If `processing_times` is not `nullptr`, collects the per-element CPU time
   // spent in each node of the subtree.
@@ -534,11 +549,16 @@ class Node {
       TF_SHARED_LOCKS_REQUIRED(mu_);
 
   // Compute and return the maximum buffered bytes on the node itself. By
-  // default non-tunable nodes are assumed not to buffer any bytes, so the
-  // tunable nodes as subclasses are expected to override this method to ensure
-  // that the optimization algorithm respects the memory budget.
+  // default nodes are assumed to buffer `buffer_size` elements if they have
+  // such a parameter and no bytes otherwise, so the tunable nodes as subclasses
+  // are expected to override this method to ensure that the optimization
+  // algorithm respects the memory budget.
   virtual double MaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_);
 
+  // Returns the maximum buffered bytes on the node itself if autotuning is
+  // enabled for it and none of its parameters are tunable, and 0 otherwise.
+  double FixedMaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_);
+
   // Restores node from the proto. Note that this is not done recursively, i.e.
   // input nodes are not restored.
   static Status FromProtoHelper(ModelProto::Node node_proto,
@@ -601,6 +621,12 @@ std::shared_ptr<Node> MakeAsyncInterleaveManyNode(
 // input element per output element.
 std::shared_ptr<Node> MakeKnownRatioNode(Node::Args args, double ratio);
 
+// KnownRatio nodes with parameters. A `buffer_size` parameter, tunable or not,
+// counts towards the memory used by the input pipeline.
+std::shared_ptr<Node> MakeKnownRatioNode(
+    Node::Args args, double ratio,
+    std::vector<std::shared_ptr<Parameter>> parameters);
+
 // AsyncKnownRatio nodes are the asynchronous version of KnownRate nodes.
 std::shared_ptr<Node> MakeAsyncKnownRatioNode(
     Node::Args args, double ratio, double memory_ratio,
@@ -637,6 +663,7 @@ std::shared_ptr<Node> MakeUnknownNode(Node::Args args);
 class Model {
  public:
   using OptimizationParams = ModelProto::OptimizationParams;
+  using OptimizationPlan = ModelProto::OptimizationPlan;
   using ModelParameters = Node::ModelParameters;
   using NodeValues = Node::NodeValues;
   using ParameterGradients = Node::ParameterGradients;
@@ -684,6 +711,31 @@ class Model {
   // Removes the given node.
   void RemoveNode(std::shared_ptr<Node> node) TF_LOCKS_EXCLUDED(mu_);
 
+  // Returns the current values of the tunable parameters, keyed by the path of
+  // their nodes. Nodes with the same path, e.g. the inputs of an interleave,
+  // share their values.
+  TunedParametersProto GetTunedParameters() TF_LOCKS_EXCLUDED(mu_);
+
+  // Sets the tunable parameters of existing and future nodes to the values of
+  // `tuned`, e.g. obtained from `GetTunedParameters()` before a restart. Until
+  // the optimization period reaches its maximum, optimizations start from these
+  // values rather than from the minimum, as the model has little data yet.
+  void SetTunedParameters(const TunedParametersProto& tuned)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Sets the tunable parameters from `fname` if it exists and was saved for
+  // the input pipeline with the given fingerprint, and makes `OptimizeLoop()`
+  // save the tuned parameters there after each optimization.
+  Status SetTunedParametersFile(const string& fname, uint64 fingerprint)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the outcome of the last optimization. The chosen parameter values
+  // are those of the model nodes.
+  OptimizationPlan optimization_plan() TF_LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return optimization_plan_;
+  }
+
   // Produces a proto for this model.
   Status ToProto(ModelProto* model_proto);
 
@@ -713,6 +765,13 @@ class Model {
   // Flushes metrics recorded by the model.
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
+  // Saves the result of `GetTunedParameters()` to `fname`.
+  Status SaveTunedParameters(const string& fname) TF_LOCKS_EXCLUDED(mu_);
+
+  // Initializes the values of `parameters` before an optimization.
+  void InitializeParameterValues(ModelParameters* parameters)
+      TF_LOCKS_EXCLUDED(mu_);
+
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then repeatedly identifies the
   // parameter whose increase in parallelism decreases the output time the most.
@@ -730,18 +789,43 @@ class Model {
   // repeated until either the output time improvement is smaller than threshold
   // value or the output time is less than the processing time needed to produce
   // an element divided by CPU budget.
+  //
+  // Parallelism and buffer sizes share one memory cost model: whenever a step
+  // makes the buffers exceed the RAM budget, the parameters are projected back
+  // on the budget by `FitRamBudget()`, so that the following steps trade
+  // memory between buffers instead of stopping.
   void OptimizeGradientDescent(std::shared_ptr<Node> snapshot,
                                const OptimizationParams& optimization_params,
                                CancellationManager* cancellation_manager);
 
   // Determines if we should stop the gradient descent optimization iterations
-  // based on number of increasable parameters, CPU budget, RAM budget and
-  // current resource usage.
-  bool ShouldStop(int64_t cpu_budget, int64_t ram_budget,
-                  const ModelParameters& parameters,
+  // based on number of increasable parameters, CPU budget and current resource
+  // usage.
+  bool ShouldStop(int64_t cpu_budget, const ModelParameters& parameters,
                   const ModelParameters& parallelism_parameters,
                   const ModelParameters& buffer_size_parameters,
-                  std::shared_ptr<Node> snapshot, bool* cpu_budget_reached);
+                  bool* cpu_budget_reached);
+
+  // Decreases `parameters` until the buffers of `snapshot` fit `ram_budget`,
+  // each time decrementing the parameter that frees memory with the smallest
+  // increase of the output time per byte. Returns false if the budget cannot be
+  // met, in which case the parameters are left as low as they can go.
+  bool FitRamBudget(std::shared_ptr<Node> snapshot, double model_input_time,
+                    int64_t ram_budget, ModelParameters* parameters);
+
+  // Returns the budget for the total maximum buffered bytes of `snapshot`.
+  // Buffers that cannot be tuned are charged against `ram_budget` if they fit
+  // in it. Otherwise the budget cannot be met, and they are left out of it, so
+  // that the tunable buffers are not all set to their minimum.
+  int64_t EffectiveRamBudget(std::shared_ptr<Node> snapshot,
+                             int64_t ram_budget);
+
+  // Records the outcome of an optimization of `snapshot` for `ToProto()`.
+  void RecordOptimizationPlan(std::shared_ptr<Node> snapshot,
+                              const OptimizationParams& optimization_params,
+                              ModelParameters* parameters,
+                              bool cpu_budget_reached, bool ram_budget_reached)
+      TF_LOCKS_EXCLUDED(mu_);
 
   // Collects the processing time for the given node.
   double TotalProcessingTime(std::shared_ptr<Node> node);
@@ -769,6 +853,17 @@ class Model {
   // running optimizations.
   int64_t optimization_period_ms_ TF_GUARDED_BY(mu_);
 
+  // Outcome of the last optimization.
+  OptimizationPlan optimization_plan_ TF_GUARDED_BY(mu_);
+
+  // Values set by `SetTunedParameters()`, keyed by node path and parameter
+  // name.
+  absl::flat_hash_map<string, double> tuned_parameters_ TF_GUARDED_BY(mu_);
+  // File to which `OptimizeLoop()` saves the tuned parameters, if any, and
+  // the fingerprint of the input pipeline saved with them.
+  string tuned_parameters_file_ TF_GUARDED_BY(mu_);
+  uint64 fingerprint_ TF_GUARDED_BY(mu_) = 0;
+
   // Gauge cell that can be used to collect the state of the model.
   monitoring::GaugeCell<std::function<std::string()>>* model_gauge_cell_ =
       nullptr;
@@ -20,6 +20,8 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -1167,6 +1169,216 @@ TEST_P(OptimizeZeroRamBudgetTest, Model) {
 INSTANTIATE_TEST_SUITE_P(Test, OptimizeZeroRamBudgetTest,
                          ::testing::Values(0, 1));
 
+TEST(KnownRatioBufferSizeTest, Model) {
+  // A shuffle-like node whose buffer is not tunable.
+  std::shared_ptr<Node> node = model::MakeKnownRatioNode(
+      {1, "shuffle", nullptr}, 1,
+      {model::MakeParameter(
+          "buffer_size",
+          std::make_shared<SharedState>(/*value=*/10, nullptr, nullptr),
+          /*min=*/10, /*max=*/10)});
+  node->record_buffer_event(40, 2);
+  node->record_element();
+  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 200);
+  EXPECT_TRUE(node->CollectTunableParameters().empty());
+
+  // The parameter is preserved by snapshots.
+  EXPECT_EQ(node->Snapshot()->TotalMaximumBufferedBytes(), 200);
+}
+
+TEST(OptimizeGradientDescentRamBudgetTest, Model) {
+  constexpr int64_t kRamBudget = 1000;
+
+  std::shared_ptr<Node> prefetch = model::MakeAsyncKnownRatioNode(
+      {1, "prefetch", nullptr}, 1,
+      {model::MakeParameter("buffer_size",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune,
+                                std::make_shared<mutex>(),
+                                std::make_shared<condition_variable>()),
+                            /*min=*/0, /*max=*/100)});
+  prefetch->record_buffer_event(100, 1);
+  prefetch->record_element();
+  prefetch->add_processing_time(100);
+
+  std::shared_ptr<Node> map = model::MakeAsyncKnownRatioNode(
+      {2, "map", prefetch}, 1,
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune,
+                                std::make_shared<mutex>(),
+                                std::make_shared<condition_variable>()),
+                            /*min=*/1, /*max=*/16)});
+  map->record_buffer_event(100, 1);
+  map->record_element();
+  map->add_processing_time(100000);
+
+  model::Model model;
+  model.AddNode([&prefetch](model::Node::Args args) { return prefetch; },
+                "prefetch", nullptr, &prefetch);
+  model.AddNode([&map](model::Node::Args args) { return map; }, "map",
+                prefetch, &map);
+
+  CancellationManager cancellation_manager;
+  model.Optimize(model::AutotuneAlgorithm::GRADIENT_DESCENT,
+                 /*cpu_budget=*/64, kRamBudget, /*model_input_time=*/0,
+                 &cancellation_manager);
+  EXPECT_LE(prefetch->TotalMaximumBufferedBytes(), kRamBudget);
+
+  ModelProto model_proto;
+  TF_ASSERT_OK(model.ToProto(&model_proto));
+  const ModelProto::OptimizationPlan& plan = model_proto.optimization_plan();
+  EXPECT_LE(plan.maximum_buffered_bytes(), kRamBudget);
+  EXPECT_EQ(plan.minimum_buffered_bytes(), 100);
+  EXPECT_GT(plan.output_time(), 0);
+}
+
+// Optimizes a map with a tunable parallelism of up to 16 and 100 byte elements
+// over a shuffle that buffers `shuffle_bytes` bytes, and returns the tuned
+// parallelism.
+int64_t OptimizeMapOverShuffle(int64_t shuffle_bytes, int64_t ram_budget,
+                               ModelProto::OptimizationPlan* plan) {
+  std::shared_ptr<Node> map = model::MakeAsyncKnownRatioNode(
+      {1, "map", nullptr}, 1,
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune,
+                                std::make_shared<mutex>(),
+                                std::make_shared<condition_variable>()),
+                            /*min=*/1, /*max=*/16)});
+  map->record_buffer_event(100, 1);
+  map->record_element();
+  map->add_processing_time(100000);
+
+  // The shuffle buffer is not tunable.
+  std::shared_ptr<Node> shuffle = model::MakeKnownRatioNode(
+      {2, "shuffle", map}, 1,
+      {model::MakeParameter(
+          "buffer_size",
+          std::make_shared<SharedState>(/*value=*/shuffle_bytes / 10, nullptr,
+                                        nullptr),
+          /*min=*/shuffle_bytes / 10, /*max=*/shuffle_bytes / 10)});
+  shuffle->record_buffer_event(100, 10);
+  shuffle->record_element();
+  EXPECT_EQ(map->TotalFixedMaximumBufferedBytes(), shuffle_bytes);
+
+  model::Model model;
+  model.AddNode([&map](model::Node::Args args) { return map; }, "map",
+                nullptr, &map);
+  model.AddNode([&shuffle](model::Node::Args args) { return shuffle; },
+                "shuffle", map, &shuffle);
+
+  CancellationManager cancellation_manager;
+  model.Optimize(model::AutotuneAlgorithm::GRADIENT_DESCENT,
+                 /*cpu_budget=*/64, ram_budget, /*model_input_time=*/0,
+                 &cancellation_manager);
+  *plan = model.optimization_plan();
+  return map->parameter_value("parallelism");
+}
+
+TEST(OptimizeGradientDescentFixedBuffersTest, Model) {
+  // The shuffle buffer is charged against the RAM budget, which leaves room
+  // for a parallelism of 10.
+  ModelProto::OptimizationPlan plan;
+  const int64_t parallelism = OptimizeMapOverShuffle(
+      /*shuffle_bytes=*/4000, /*ram_budget=*/5000, &plan);
+  EXPECT_GT(parallelism, 1);
+  EXPECT_LE(parallelism, 10);
+  EXPECT_LE(plan.maximum_buffered_bytes(), 5000);
+  EXPECT_EQ(plan.minimum_buffered_bytes(), 4100);
+}
+
+TEST(OptimizeGradientDescentFixedBuffersOverBudgetTest, Model) {
+  // The shuffle buffer alone exceeds the RAM budget. The budget cannot be met,
+  // so it goes to the tunable buffers instead of setting them to the minimum.
+  ModelProto::OptimizationPlan plan;
+  const int64_t parallelism = OptimizeMapOverShuffle(
+      /*shuffle_bytes=*/10000, /*ram_budget=*/5000, &plan);
+  EXPECT_GT(parallelism, 1);
+  EXPECT_LE(plan.maximum_buffered_bytes(), 15000);
+  EXPECT_EQ(plan.minimum_buffered_bytes(), 10100);
+}
+
+// Returns a node with a tunable `parallelism` parameter starting at `value`.
+std::shared_ptr<Node> MakeParallelNode(model::Node::Args args, int64_t value) {
+  return model::MakeAsyncKnownRatioNode(
+      std::move(args), 1,
+      {model::MakeParameter(
+          "parallelism",
+          std::make_shared<SharedState>(value, std::make_shared<mutex>(),
+                                        std::make_shared<condition_variable>()),
+          /*min=*/1, /*max=*/16)});
+}
+
+// Adds a root node and a parallel input node to `model`.
+void AddNodes(model::Model* model, int64_t value,
+              std::shared_ptr<Node>* input) {
+  std::shared_ptr<Node> root;
+  model->AddNode(
+      [](model::Node::Args args) {
+        return model::MakeKnownRatioNode(std::move(args), 1);
+      },
+      "Root", nullptr, &root);
+  model->AddNode(
+      [value](model::Node::Args args) {
+        return MakeParallelNode(std::move(args), value);
+      },
+      "ParallelMap", root, input);
+}
+
+TEST(TunedParametersTest, Model) {
+  model::Model model;
+  std::shared_ptr<Node> input;
+  AddNodes(&model, /*value=*/6, &input);
+  TunedParametersProto tuned = model.GetTunedParameters();
+  ASSERT_EQ(tuned.parameters_size(), 1);
+  EXPECT_EQ(tuned.parameters(0).node_path(), "Root/ParallelMap");
+  EXPECT_EQ(tuned.parameters(0).name(), "parallelism");
+  EXPECT_EQ(tuned.parameters(0).value(), 6);
+
+  // Nodes added after the tuned parameters are set start at the tuned values.
+  model::Model warm_started_model;
+  warm_started_model.SetTunedParameters(tuned);
+  std::shared_ptr<Node> warm_started_input;
+  AddNodes(&warm_started_model, model::kAutotune, &warm_started_input);
+  EXPECT_EQ(warm_started_input->parameter_value("parallelism"), 6);
+
+  // Existing nodes are updated, and values are clamped to their range.
+  tuned.mutable_parameters(0)->set_value(100);
+  warm_started_model.SetTunedParameters(tuned);
+  EXPECT_EQ(warm_started_input->parameter_value("parallelism"), 16);
+}
+
+TEST(TunedParametersTest, TunedParametersFile) {
+  const string fname = io::JoinPath(testing::TmpDir(), "tuned_parameters");
+  model::Model model;
+  std::shared_ptr<Node> input;
+  AddNodes(&model, /*value=*/6, &input);
+  TunedParametersProto tuned = model.GetTunedParameters();
+  tuned.set_fingerprint(42);
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), fname, tuned));
+
+  // Parameters saved for another input pipeline are ignored.
+  model::Model other_model;
+  TF_ASSERT_OK(other_model.SetTunedParametersFile(fname, /*fingerprint=*/7));
+  std::shared_ptr<Node> other_input;
+  AddNodes(&other_model, model::kAutotune, &other_input);
+  EXPECT_EQ(other_input->parameter_value("parallelism"), model::kAutotune);
+
+  model::Model warm_started_model;
+  TF_ASSERT_OK(
+      warm_started_model.SetTunedParametersFile(fname, /*fingerprint=*/42));
+  std::shared_ptr<Node> warm_started_input;
+  AddNodes(&warm_started_model, model::kAutotune, &warm_started_input);
+  EXPECT_EQ(warm_started_input->parameter_value("parallelism"), 6);
+  EXPECT_EQ(warm_started_model.GetTunedParameters().fingerprint(), 42);
+
+  // A missing file is not an error.
+  model::Model cold_model;
+  TF_EXPECT_OK(cold_model.SetTunedParametersFile(
+      io::JoinPath(testing::TmpDir(), "missing"), /*fingerprint=*/42));
+}
+
 TEST(RecordTimeTest, RecordTimeTest) {
   std::shared_ptr<Node> source = model::MakeSourceNode({});
   EXPECT_FALSE(source->is_recording());
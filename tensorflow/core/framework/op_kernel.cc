@@ -346,6 +346,8 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
     allocator = params_->device->GetScopedAllocator(attr, step_id());
     CHECK(allocator);
+  } else if (params_->step_allocator != nullptr && attr.value == 0) {
+    allocator = params_->step_allocator;
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
@@ -688,6 +690,13 @@ Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
   Allocator* a = get_allocator(attr);
+  // Small tensors of the default CPU allocator hold their payload in their
+  // buffer instead, unless the allocation is tracked or logged.
+  if (a == cpu_allocator_base() && !a->TracksAllocationSizes() &&
+      !params_->log_memory && allocation_attr.freed_by_func == nullptr &&
+      Tensor::BuildInlineTensor(type, shape, out_tensor)) {
+    return Status::OK();
+  }
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
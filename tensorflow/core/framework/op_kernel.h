@@ -682,6 +682,10 @@ class OpKernelContext {
 
     // For access to distributed coordination service.
     CoordinationServiceAgent* coordination_service_agent = nullptr;
+
+    // If not null, serves this kernel's allocations with default attributes
+    // in place of the device allocator, e.g. from a pre-planned step arena.
+    Allocator* step_allocator = nullptr;
   };
 
   // params must outlive the OpKernelContext.
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -518,5 +519,48 @@ void BM_PingPong(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_PingPong)->Arg(100)->Arg(200)->Arg(300);
 
+void BM_ConcurrentSendRecv(::testing::benchmark::State& state) {
+  const int num_pairs = state.range(0);
+  const int messages_count = 100;
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", 2 * num_pairs);
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < num_pairs; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("key", i)));
+  }
+
+  // In each iteration, every pair of threads sends and receives
+  // messages_count tensors under its own key.
+  for (auto s : state) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    BlockingCounter done(2 * num_pairs);
+    for (const Rendezvous::ParsedKey& key : keys) {
+      pool->Schedule([rendez, &key, &done, messages_count]() {
+        Tensor foo = V("foo");
+        Rendezvous::Args args;
+        for (int i = 0; i < messages_count; ++i) {
+          TF_CHECK_OK(rendez->Send(key, args, foo, false));
+        }
+        done.DecrementCount();
+      });
+      pool->Schedule([rendez, &key, &done, messages_count]() {
+        Tensor foo(DT_STRING, TensorShape({}));
+        bool is_dead = false;
+        Rendezvous::Args args;
+        for (int i = 0; i < messages_count; ++i) {
+          TF_CHECK_OK(rendez->Recv(key, args, &foo, &is_dead));
+        }
+        CHECK_EQ("foo", V(foo));
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+    rendez->Unref();
+  }
+  state.SetItemsProcessed(num_pairs * messages_count * state.iterations());
+  delete pool;
+}
+BENCHMARK(BM_ConcurrentSendRecv)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_FRAMEWORK_RESOURCE_HANDLE_H_
 #define TENSORFLOW_FRAMEWORK_RESOURCE_HANDLE_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 #include "tensorflow/core/framework/resource_base.h"
@@ -32,6 +34,23 @@ limitations under the License.
 namespace tensorflow {
 
 class ResourceHandleProto;
+class ResourceMgr;
+
+namespace internal {
+
+// Tells whether a resource is still held by the ResourceMgr it was created in.
+// The manager creates one for each resource it holds, and marks it removed
+// when the resource is deleted from the manager.
+class ResourceRegistration : public core::RefCounted {
+ public:
+  bool removed() const { return removed_.load(std::memory_order_acquire); }
+  void MarkRemoved() { removed_.store(true, std::memory_order_release); }
+
+ private:
+  std::atomic<bool> removed_{false};
+};
+
+}  // namespace internal
 
 // Class representing a handle to a tensorflow resource. Handles are
 // not valid across executions, but can be serialized back and forth from within
@@ -53,16 +72,25 @@ class ResourceHandle {
 
   // Container in which this resource is placed.
   const std::string& container() const { return container_; }
-  void set_container(const std::string& container) { container_ = container; }
+  void set_container(const std::string& container) {
+    container_ = container;
+    lookup_cache_.Reset();
+  }
 
   // Unique name of this resource.
   const std::string& name() const { return name_; }
-  void set_name(const std::string& name) { name_ = name; }
+  void set_name(const std::string& name) {
+    name_ = name;
+    lookup_cache_.Reset();
+  }
 
   // Hash code for the type of the resource. Is only valid in the same device
   // and in the same execution.
   uint64 hash_code() const { return hash_code_; }
-  void set_hash_code(uint64 hash_code) { hash_code_ = hash_code; }
+  void set_hash_code(uint64 hash_code) {
+    hash_code_ = hash_code;
+    lookup_cache_.Reset();
+  }
 
   // For debug-only, the name of the type pointed to by this handle, if
   // available.
@@ -169,6 +197,47 @@ class ResourceHandle {
   static int64_t GenerateUniqueId();
 
  private:
+  friend class ResourceMgr;
+
+  // The resource that a ResourceMgr found for this handle, which lets later
+  // lookups through the handle skip the manager's lock and maps.
+  struct CachedLookup {
+    const ResourceMgr* resource_mgr;
+    uint64 type_hash_code;
+    core::RefCountPtr<internal::ResourceRegistration> registration;
+    core::WeakPtr<ResourceBase> resource;
+  };
+
+  // The CachedLookup of a handle. It is set at most once, so that concurrent
+  // lookups never see it freed, and it isn't copied with the handle.
+  class LookupCache {
+   public:
+    LookupCache() = default;
+    LookupCache(const LookupCache&) {}
+    LookupCache& operator=(const LookupCache&) {
+      Reset();
+      return *this;
+    }
+    ~LookupCache() { Reset(); }
+
+    const CachedLookup* get() const {
+      return cached_.load(std::memory_order_acquire);
+    }
+    // Sets the CachedLookup unless one is set already.
+    void SetOnce(std::unique_ptr<CachedLookup> cached) const {
+      CachedLookup* expected = nullptr;
+      if (cached_.compare_exchange_strong(expected, cached.get(),
+                                          std::memory_order_acq_rel)) {
+        cached.release();
+      }
+    }
+    // REQUIRES: No lookup through the handle is running.
+    void Reset() { delete cached_.exchange(nullptr); }
+
+   private:
+    mutable std::atomic<CachedLookup*> cached_{nullptr};
+  };
+
   std::string device_;
   std::string container_;
   std::string name_;
@@ -181,6 +250,7 @@ class ResourceHandle {
   // a "weak-ref" mode, only containing the name of the resource (conceptually a
   // weak reference).
   core::IntrusivePtr<ResourceBase> resource_;
+  LookupCache lookup_cache_;
   static std::atomic<int64_t> current_id_;
 };
 
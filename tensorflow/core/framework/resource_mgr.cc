@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -100,7 +101,8 @@ ResourceMgr::ResourceAndName::ResourceAndName()
 ResourceMgr::ResourceAndName::ResourceAndName(
     StrongOrWeakResourcePtr&& resource, string name)
     : resource(std::move(resource)),
-      name(absl::make_unique<string>(std::move(name))) {}
+      name(absl::make_unique<string>(std::move(name))),
+      registration(new internal::ResourceRegistration) {}
 
 core::RefCountPtr<ResourceBase> ResourceMgr::ResourceAndName::GetResource()
     const {
@@ -120,14 +122,19 @@ ResourceMgr::ResourceAndName::ResourceAndName(
     ResourceAndName&& other) noexcept {
   name = std::move(other.name);
   resource = std::move(other.resource);
+  registration = std::move(other.registration);
 }
 
-ResourceMgr::ResourceAndName::~ResourceAndName() {}
+ResourceMgr::ResourceAndName::~ResourceAndName() {
+  if (registration != nullptr) registration->MarkRemoved();
+}
 
 ResourceMgr::ResourceAndName& ResourceMgr::ResourceAndName::operator=(
     ResourceAndName&& other) noexcept {
+  if (registration != nullptr) registration->MarkRemoved();
   name = std::move(other.name);
   resource = std::move(other.resource);
+  registration = std::move(other.registration);
   return *this;
 }
 
@@ -212,9 +219,43 @@ Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
 
 Status ResourceMgr::Lookup(const ResourceHandle& handle,
                            ResourceBase** resource) const {
-  tf_shared_lock l(mu_);
-  return DoLookup(handle.container(), handle.hash_code(),
-                  /*type_name=*/"ResourceBase", handle.name(), resource);
+  return DoLookup(handle, handle.hash_code(), /*type_name=*/"ResourceBase",
+                  resource);
+}
+
+Status ResourceMgr::DoLookup(const ResourceHandle& handle,
+                             uint64 type_hash_code, const char* type_name,
+                             ResourceBase** resource) const {
+  const ResourceHandle::CachedLookup* cached = handle.lookup_cache_.get();
+  if (cached != nullptr && cached->resource_mgr == this &&
+      cached->type_hash_code == type_hash_code &&
+      !cached->registration->removed()) {
+    // Until the registration is marked removed, the resource is the one held
+    // by *this for the handle, or it is being destroyed, in which case the
+    // weak reference fails like DoLookup does.
+    ResourceBase* ptr = cached->resource.GetNewRef().release();
+    if (ptr != nullptr) {
+      *resource = ptr;
+      return Status::OK();
+    }
+  }
+
+  const ResourceAndName* resource_and_name;
+  {
+    tf_shared_lock l(mu_);
+    TF_RETURN_IF_ERROR(DoLookup(handle.container(), type_hash_code, type_name,
+                                handle.name(), resource, &resource_and_name));
+    if (cached == nullptr) {
+      resource_and_name->registration->Ref();
+      handle.lookup_cache_.SetOnce(
+          absl::WrapUnique(new ResourceHandle::CachedLookup{
+              this, type_hash_code,
+              core::RefCountPtr<internal::ResourceRegistration>(
+                  resource_and_name->registration.get()),
+              core::WeakPtr<ResourceBase>(*resource)}));
+    }
+  }
+  return Status::OK();
 }
 
 Status ResourceMgr::DoLookup(const string& container, TypeIndex type,
@@ -226,7 +267,8 @@ Status ResourceMgr::DoLookup(const string& container, TypeIndex type,
 Status ResourceMgr::DoLookup(const string& container, uint64 type_hash_code,
                              const string& type_name,
                              const string& resource_name,
-                             ResourceBase** resource) const {
+                             ResourceBase** resource,
+                             const ResourceAndName** resource_and_name) const {
   const Container* b = gtl::FindPtrOrNull(containers_, container);
   if (b == nullptr) {
     return errors::NotFound("Container ", container,
@@ -244,6 +286,7 @@ Status ResourceMgr::DoLookup(const string& container, uint64 type_hash_code,
                             type_name, " has been destroyed.");
   }
   *resource = ptr;
+  if (resource_and_name != nullptr) *resource_and_name = &iter->second;
   return Status::OK();
 }
 
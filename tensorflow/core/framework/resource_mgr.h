@@ -189,10 +189,21 @@ class ResourceMgr {
   // If the resource manager has a resource matching "handle", returns it in
   // "*resource" and the caller takes the ownership of one ref on "*resource".
   //
+  // The resource found is cached in "handle", so that later lookups through
+  // the same handle take no lock of *this, until the resource is deleted.
+  //
   // REQUIRES: resource != nullptr
   Status Lookup(const ResourceHandle& handle,
                 ResourceBase** resource) const TF_MUST_USE_RESULT;
 
+  // Same as above, for a resource of type T.
+  //
+  // REQUIRES: std::is_base_of<ResourceBase, T>
+  // REQUIRES: resource != nullptr
+  template <typename T, bool use_dynamic_cast = false>
+  Status Lookup(const ResourceHandle& handle,
+                T** resource) const TF_MUST_USE_RESULT;
+
   // Similar to Lookup, but looks up multiple resources at once, with only a
   // single lock acquisition.  If containers_and_names[i] is uninitialized
   // then this function does not modify resources[i].
@@ -255,6 +266,8 @@ class ResourceMgr {
   struct ResourceAndName {
     StrongOrWeakResourcePtr resource;
     std::unique_ptr<string> name;
+    // Marked removed when the resource is removed from its container.
+    core::RefCountPtr<internal::ResourceRegistration> registration;
 
     ResourceAndName();
     ResourceAndName(StrongOrWeakResourcePtr&& resource, std::string name);
@@ -294,10 +307,17 @@ class ResourceMgr {
       TF_SHARED_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
   Status DoLookup(const std::string& container, uint64 type_hash_code,
                   const std::string& type_name,
-                  const std::string& resource_name,
-                  ResourceBase** resource) const
+                  const std::string& resource_name, ResourceBase** resource,
+                  const ResourceAndName** resource_and_name = nullptr) const
       TF_SHARED_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
 
+  // Looks up the resource of "handle" with the given type, through the
+  // resource cached in the handle if it's still valid, and caches it
+  // otherwise.
+  Status DoLookup(const ResourceHandle& handle, uint64 type_hash_code,
+                  const char* type_name, ResourceBase** resource) const
+      TF_LOCKS_EXCLUDED(mu_) TF_MUST_USE_RESULT;
+
   Status DoDelete(const std::string& container, uint64 type_hash_code,
                   const std::string& resource_name,
                   const std::string& type_name) TF_MUST_USE_RESULT;
@@ -700,6 +720,16 @@ Status ResourceMgr::LookupInternal(const std::string& container,
   return s;
 }
 
+template <typename T, bool use_dynamic_cast>
+Status ResourceMgr::Lookup(const ResourceHandle& handle, T** resource) const {
+  CheckDeriveFromResourceBase<T>();
+  const TypeIndex type = TypeIndex::Make<T>();
+  ResourceBase* found = nullptr;
+  TF_RETURN_IF_ERROR(DoLookup(handle, type.hash_code(), type.name(), &found));
+  *resource = TypeCastFunctor<T, use_dynamic_cast>::Cast(found);
+  return Status::OK();
+}
+
 template <typename T, bool use_dynamic_cast>
 Status ResourceMgr::LookupOrCreate(const std::string& container,
                                    const std::string& name, T** resource,
@@ -799,8 +829,7 @@ Status LookupResource(OpKernelContext* ctx, const ResourceHandle& p,
     return Status::OK();
   }
 
-  return ctx->resource_manager()->Lookup<T, use_dynamic_cast>(p.container(),
-                                                              p.name(), value);
+  return ctx->resource_manager()->Lookup<T, use_dynamic_cast>(p, value);
 }
 
 // Finds the resource as "*value" from the handle. This is a type-erased
@@ -846,6 +875,8 @@ template <typename T>
 Status LookupOrCreateResource(OpKernelContext* ctx, const ResourceHandle& p,
                               T** value, std::function<Status(T**)> creator) {
   TF_RETURN_IF_ERROR(internal::ValidateDeviceAndType<T>(ctx, p));
+  // Existing resources are found through the resource cached in the handle.
+  if (ctx->resource_manager()->Lookup(p, value).ok()) return Status::OK();
   return ctx->resource_manager()->LookupOrCreate(p.container(), p.name(), value,
                                                  creator);
 }
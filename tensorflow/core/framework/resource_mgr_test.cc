@@ -472,4 +472,47 @@ TEST(ResourceHandleTest, DeleteUsingResourceHandle) {
   EXPECT_NE(LookupResource<StubResource>(&ctx, p, &lookup_r).ok(), true);
 }
 
+TEST(ResourceHandleTest, LookupThroughCachedResource) {
+  ResourceMgr resource_mgr("");
+  OpKernelContext::Params params;
+  params.resource_manager = &resource_mgr;
+  StubDevice device("device_name");
+  params.device = &device;
+  OpKernelContext ctx(&params, 0);
+
+  ResourceHandle p =
+      MakeResourceHandle<StubResource>(&ctx, "container", "name");
+  StubResource* r = new StubResource;
+  TF_ASSERT_OK(CreateResource(&ctx, p, r));
+
+  // The second lookup goes through the resource cached by the first.
+  for (int i = 0; i < 2; ++i) {
+    core::RefCountPtr<StubResource> lookup_r;
+    TF_ASSERT_OK(LookupResource(&ctx, p, &lookup_r));
+    EXPECT_EQ(lookup_r.get(), r);
+  }
+
+  // A resource created again under the same name is found, while the deleted
+  // one is still alive.
+  core::RefCountPtr<StubResource> deleted_r;
+  TF_ASSERT_OK(LookupResource(&ctx, p, &deleted_r));
+  TF_ASSERT_OK(DeleteResource<StubResource>(&ctx, p));
+  core::RefCountPtr<StubResource> lookup_r;
+  EXPECT_FALSE(LookupResource(&ctx, p, &lookup_r).ok());
+  StubResource* new_r = new StubResource;
+  TF_ASSERT_OK(CreateResource(&ctx, p, new_r));
+  TF_ASSERT_OK(LookupResource(&ctx, p, &lookup_r));
+  EXPECT_EQ(lookup_r.get(), new_r);
+
+  // Other managers don't use the resource cached by this one.
+  ResourceMgr other_resource_mgr("");
+  OpKernelContext::Params other_params;
+  other_params.resource_manager = &other_resource_mgr;
+  other_params.device = &device;
+  OpKernelContext other_ctx(&other_params, 0);
+  EXPECT_FALSE(LookupResource(&other_ctx, p, &lookup_r).ok());
+  resource_mgr.Clear();
+  EXPECT_FALSE(LookupResource(&ctx, p, &lookup_r).ok());
+}
+
 }  // end namespace tensorflow
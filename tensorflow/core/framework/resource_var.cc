@@ -17,9 +17,24 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+bool Var::SnapshotModeByDefault() {
+  static const bool snapshot_mode = [] {
+    bool snapshot_mode;
+    Status status = ReadBoolFromEnvVar("TF_RESOURCE_VARIABLE_SNAPSHOT_MODE",
+                                       /*default_val=*/false, &snapshot_mode);
+    if (!status.ok()) {
+      LOG(ERROR) << "Var snapshot mode: " << status.error_message();
+      return false;
+    }
+    return snapshot_mode;
+  }();
+  return snapshot_mode;
+}
+
 Status Var::AsGraphDef(GraphDefBuilder* builder, Node** out) const {
   Node* var = ops::SourceOp(
       "VarHandleOp",
@@ -62,9 +62,20 @@ namespace tensorflow {
 // mutex as desired. To access the variable in dense mode grab the mutex either
 // directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
 // modified and then call `PrepareToUpdateVariable` on them in any order.
+//
+// Variables in snapshot mode (enabled for all variables with the environment
+// variable TF_RESOURCE_VARIABLE_SNAPSHOT_MODE=true) instead stay in
+// copy-on-write mode when accessed sparsely, so that every value of the
+// variable is an immutable version that readers alias. Sparse reads hold the
+// shared lock only long enough to alias the current version, and gather from
+// it afterwards. Sparse writes always grab the exclusive lock and, like dense
+// writes, copy the tensor before writing to it if it has outstanding aliases;
+// ResourceScatter* ops build the copy without holding the lock, so that
+// readers don't wait for it. The old versions are freed with their last alias.
 class Var : public ResourceBase {
  public:
-  explicit Var(DataType dtype) : tensor_(dtype) {}
+  explicit Var(DataType dtype)
+      : snapshot_mode(SnapshotModeByDefault()), tensor_(dtype) {}
 
   // When locking multiple variables, the locks must be acquired in order of
   // increasing mu() address.
@@ -94,7 +105,13 @@ class Var : public ResourceBase {
   // so desired.
   std::atomic<bool> copy_on_read_mode{false};
 
+  // Whether sparse accesses keep the variable in copy-on-write mode, see
+  // above. Only set before the variable is shared.
+  bool snapshot_mode;
+
  private:
+  static bool SnapshotModeByDefault();
+
   mutex mu_;
   Tensor tensor_;
 
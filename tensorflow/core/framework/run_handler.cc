@@ -52,14 +52,18 @@ RunHandlerEnvironment::RunHandlerEnvironment(
     : env_(env), thread_options_(thread_options), name_(name) {}
 
 RunHandlerEnvironment::EnvThread* RunHandlerEnvironment::CreateThread(
-    std::function<void()> f, const std::string& thread_name) {
-  return env_->StartThread(thread_options_, thread_name, [=]() {
+    std::function<void()> f, const std::string& thread_name, int numa_node) {
+  ThreadOptions thread_options = thread_options_;
+  if (numa_node != port::kNUMANoAffinity) {
+    thread_options.numa_node = numa_node;
+  }
+  return env_->StartThread(thread_options, thread_name, [=]() {
     // Set the processor flag to flush denormals to zero.
     port::ScopedFlushDenormal flush;
     // Set the processor rounding mode to ROUND TO NEAREST.
     port::ScopedSetRound round(FE_TONEAREST);
-    if (thread_options_.numa_node != port::kNUMANoAffinity) {
-      port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
+    if (thread_options.numa_node != port::kNUMANoAffinity) {
+      port::NUMASetThreadNodeAffinity(thread_options.numa_node);
     }
     f();
   });
@@ -130,6 +134,7 @@ ThreadWorkSource::ThreadWorkSource()
       non_blocking_work_queues_(non_blocking_work_sharding_factor_),
       blocking_inflight_(0),
       non_blocking_inflight_(0),
+      task_execution_micros_(0),
       traceme_id_(0),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
@@ -298,6 +303,18 @@ void ThreadWorkSource::DecrementInflightTaskCount(bool is_blocking) {
   counter->fetch_sub(1, std::memory_order_relaxed);
 }
 
+void ThreadWorkSource::AddTaskExecutionMicros(int64_t micros) {
+  task_execution_micros_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+int64_t ThreadWorkSource::GetTaskExecutionMicros() {
+  return task_execution_micros_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::ResetTaskExecutionMicros() {
+  task_execution_micros_.store(0, std::memory_order_relaxed);
+}
+
 unsigned ThreadWorkSource::NonBlockingWorkShardingFactor() {
   return non_blocking_work_sharding_factor_;
 }
@@ -334,7 +351,9 @@ RunHandlerThreadPool::RunHandlerThreadPool(
           std::vector<double>({0, 0.4}))),
       sub_thread_pool_end_request_percentage_(ParamFromEnvWithDefault(
           "TF_RUN_HANDLER_SUB_THREAD_POOL_END_REQUEST_PERCENTAGE",
-          std::vector<double>({0.4, 1}))) {
+          std::vector<double>({0.4, 1}))),
+      sub_thread_pool_numa_nodes_(ParamFromEnvWithDefault(
+          "TF_RUN_HANDLER_SUB_THREAD_POOL_NUMA_NODES", std::vector<int>())) {
   thread_data_.resize(num_threads_);
   VLOG(1) << "Creating RunHandlerThreadPool " << name << " with  "
           << num_blocking_threads_ << " blocking threads and "
@@ -367,6 +386,11 @@ void RunHandlerThreadPool::Start() {
     }
     thread_data_[i].sub_thread_pool_id = sub_thread_pool_id;
     const bool is_blocking_thread = (i < num_blocking_threads) ? true : false;
+    int numa_node = port::kNUMANoAffinity;
+    if (use_sub_thread_pool_ && is_blocking_thread &&
+        sub_thread_pool_id < sub_thread_pool_numa_nodes_.size()) {
+      numa_node = sub_thread_pool_numa_nodes_[sub_thread_pool_id];
+    }
     // The blocking threads will handle both inter and intra op workload;
     // non-blocking thread will handle intra op workload only; and the
     // sub thread pool is only provided for blocking threads.
@@ -377,7 +401,8 @@ void RunHandlerThreadPool::Start() {
         },
         is_blocking_thread
             ? strings::StrCat(name_, "_blocking_thread_", sub_thread_pool_id)
-            : strings::StrCat(name_, "_non_blocking_thread")));
+            : strings::StrCat(name_, "_non_blocking_thread"),
+        numa_node));
   }
 }
 
@@ -396,7 +421,9 @@ void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
             << tws->GetTracemeId();
+    const uint64 start_us = EnvTime::NowMicros();
     env_.ExecuteTask(t);
+    tws->AddTaskExecutionMicros(EnvTime::NowMicros() - start_us);
   }
 }
 
@@ -633,7 +660,9 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
+      const uint64 start_us = EnvTime::NowMicros();
       env_.ExecuteTask(t);
+      tws->AddTaskExecutionMicros(EnvTime::NowMicros() - start_us);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
     } else {
       profiler::TraceMe activity(
@@ -791,7 +820,9 @@ class RunHandlerPool::Impl {
         version_(0),
         sub_thread_pool_end_request_percentage_(ParamFromEnvWithDefault(
             "TF_RUN_HANDLER_SUB_THREAD_POOL_END_REQUEST_PERCENTAGE",
-            std::vector<double>({1}))) {
+            std::vector<double>({1}))),
+        min_threads_per_priority_(static_cast<int>(ParamFromEnvWithDefault(
+            "TF_RUN_HANDLER_MIN_THREADS_PER_PRIORITY", 0))) {
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
     free_handlers_.reserve(max_handlers_);
     handlers_.reserve(max_handlers_);
@@ -842,6 +873,7 @@ class RunHandlerPool::Impl {
                     static_cast<int32>(ParamFromEnvWithDefault(
                         "TF_RUN_HANDLER_MAX_CONCURRENT_HANDLERS",
                         kMaxConcurrentHandlers))));
+    thread_local std::vector<int64_t> request_priorities;
     uint64 version;
     int num_active_requests;
     RunHandler::Impl* handler_impl;
@@ -874,6 +906,7 @@ class RunHandlerPool::Impl {
 
       num_active_requests = sorted_active_handlers_.size() + 1;
       thread_work_sources->resize(num_active_requests);
+      request_priorities.resize(num_active_requests);
       int priority = options.priority();
       auto it = sorted_active_handlers_.cbegin();
       bool new_handler_inserted = false;
@@ -886,11 +919,13 @@ class RunHandlerPool::Impl {
           --it;
         }
         (*thread_work_sources)[i] = (*it)->tws();
+        request_priorities[i] = (*it)->priority();
         ++it;
       }
       version = ++version_;
     }
-    RecomputePoolStats(num_active_requests, version, *thread_work_sources);
+    RecomputePoolStats(num_active_requests, version, *thread_work_sources,
+                       request_priorities);
     return WrapUnique<RunHandler>(new RunHandler(handler_impl));
   }
 
@@ -936,10 +971,13 @@ class RunHandlerPool::Impl {
   }
 
  private:
+  // `request_priorities` holds the priority of each of the
+  // `thread_work_sources`.
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
-          thread_work_sources);
+          thread_work_sources,
+      const std::vector<int64_t>& request_priorities);
 
   void LogInfo() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -970,12 +1008,17 @@ class RunHandlerPool::Impl {
   mutex mu_;
   int64_t version_ TF_GUARDED_BY(mu_);
   const std::vector<double> sub_thread_pool_end_request_percentage_;
+  // Minimum number of threads of each kind that attempt the requests of every
+  // priority class first, so that high priority requests can not take all the
+  // threads.
+  const int min_threads_per_priority_;
 };
 
 void RunHandlerPool::Impl::RecomputePoolStats(
     int num_active_requests, uint64 version,
     const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
-        thread_work_sources) {
+        thread_work_sources,
+    const std::vector<int64_t>& request_priorities) {
   if (num_active_requests == 0) return;
 
   int sub_thread_pool_id = 0;
@@ -998,6 +1041,9 @@ void RunHandlerPool::Impl::RecomputePoolStats(
 
   std::vector<int> request_idx_list = ChooseRequestsWithExponentialDistribution(
       num_active_requests, num_blocking_threads);
+  ReserveThreadsForPriorityClasses(request_priorities,
+                                   min_threads_per_priority_,
+                                   &request_idx_list);
   for (int i = 0; i < num_blocking_threads; ++i) {
     VLOG(2) << "Set work for tid=" << i
             << " with start_request_idx=" << request_idx_list[i];
@@ -1007,6 +1053,9 @@ void RunHandlerPool::Impl::RecomputePoolStats(
 
   request_idx_list = ChooseRequestsWithExponentialDistribution(
       num_active_requests, num_non_blocking_threads);
+  ReserveThreadsForPriorityClasses(request_priorities,
+                                   min_threads_per_priority_,
+                                   &request_idx_list);
   for (int i = 0; i < num_non_blocking_threads; ++i) {
     VLOG(2) << "Set work for tid=" << (i + num_blocking_threads)
             << " with start_request_idx=" << request_idx_list[i];
@@ -1082,6 +1131,7 @@ void RunHandler::Impl::Reset(
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.ResetTaskExecutionMicros();
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -1114,6 +1164,10 @@ thread::ThreadPoolInterface* RunHandler::AsIntraThreadPoolInterface() {
   return impl_->thread_pool_interface();
 }
 
+int64_t RunHandler::GetTaskExecutionMicros() const {
+  return impl_->tws()->GetTaskExecutionMicros();
+}
+
 RunHandler::~RunHandler() { impl_->pool_impl()->ReleaseHandler(impl_); }
 
 }  // namespace tensorflow
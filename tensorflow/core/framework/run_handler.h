@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
@@ -96,6 +97,10 @@ class RunHandler {
   void ScheduleInterOpClosure(std::function<void()> fn);
   thread::ThreadPoolInterface* AsIntraThreadPoolInterface();
 
+  // Returns the total time, in microseconds, that the pool threads spent
+  // running closures scheduled through this handler since it was obtained.
+  int64_t GetTaskExecutionMicros() const;
+
   ~RunHandler();
 
  private:
@@ -129,8 +134,11 @@ class RunHandlerEnvironment {
   RunHandlerEnvironment(Env* env, const ThreadOptions& thread_options,
                         const string& name);
 
+  // Creates a thread bound to `numa_node`, or to the NUMA node of the thread
+  // options given to the constructor if it is port::kNUMANoAffinity.
   EnvThread* CreateThread(std::function<void()> f,
-                          const std::string& thread_name);
+                          const std::string& thread_name,
+                          int numa_node = port::kNUMANoAffinity);
 
   Task CreateTask(std::function<void()> f);
 
@@ -182,6 +190,12 @@ class ThreadWorkSource {
 
   void DecrementInflightTaskCount(bool is_blocking);
 
+  void AddTaskExecutionMicros(int64_t micros);
+
+  int64_t GetTaskExecutionMicros();
+
+  void ResetTaskExecutionMicros();
+
   unsigned NonBlockingWorkShardingFactor();
 
   std::string ToString();
@@ -198,6 +212,8 @@ class ThreadWorkSource {
 
   std::atomic<int64_t> blocking_inflight_;
   std::atomic<int64_t> non_blocking_inflight_;
+  // Time spent running the tasks of this work source.
+  std::atomic<int64_t> task_execution_micros_;
 
   Queue blocking_work_queue_;
   mutex blocking_queue_op_mu_;
@@ -306,6 +322,10 @@ class RunHandlerThreadPool {
   // fashion.
   std::vector<double> sub_thread_pool_start_request_percentage_;
   std::vector<double> sub_thread_pool_end_request_percentage_;
+
+  // The NUMA node the threads of each sub thread pool are bound to. Sub thread
+  // pools without an entry are not bound to any node.
+  std::vector<int> sub_thread_pool_numa_nodes_;
 };
 
 }  // namespace internal
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
@@ -78,6 +79,24 @@ TEST(RunHandlerUtilTest, TestBasicScheduling) {
   counter.Wait();
 }
 
+TEST(RunHandlerUtilTest, TaskExecutionTime) {
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(1, 1));
+  auto handler = pool->Get(0);
+  EXPECT_EQ(handler->GetTaskExecutionMicros(), 0);
+
+  Notification done;
+  handler->ScheduleInterOpClosure([&done]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    done.Notify();
+  });
+  done.WaitForNotification();
+  // The time is recorded once the closure has returned.
+  while (handler->GetTaskExecutionMicros() == 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_GE(handler->GetTaskExecutionMicros(), 10000);
+}
+
 TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   int num_threads = 2;
   std::unique_ptr<RunHandlerPool> pool(
@@ -181,4 +181,37 @@ std::vector<int> ChooseRequestsWithExponentialDistribution(
   return request_idx_list;
 }
 
+void ReserveThreadsForPriorityClasses(
+    const std::vector<int64_t>& request_priorities, int min_threads_per_class,
+    std::vector<int>* request_idx_list) {
+  if (min_threads_per_class <= 0 || request_priorities.empty()) return;
+  // The class of every request, and the first request of every class.
+  std::vector<int> request_class(request_priorities.size());
+  std::vector<int> class_start;
+  for (int i = 0; i < request_priorities.size(); ++i) {
+    if (i == 0 || request_priorities[i] != request_priorities[i - 1]) {
+      class_start.push_back(i);
+    }
+    request_class[i] = class_start.size() - 1;
+  }
+  if (class_start.size() == 1) return;
+
+  std::vector<int> class_threads(class_start.size(), 0);
+  for (int request_idx : *request_idx_list) {
+    ++class_threads[request_class[request_idx]];
+  }
+  for (int c = 0; c < class_start.size(); ++c) {
+    for (int tid = request_idx_list->size() - 1;
+         tid >= 0 && class_threads[c] < min_threads_per_class; --tid) {
+      const int donor = request_class[(*request_idx_list)[tid]];
+      if (donor == c || class_threads[donor] <= min_threads_per_class) {
+        continue;
+      }
+      --class_threads[donor];
+      ++class_threads[c];
+      (*request_idx_list)[tid] = class_start[c];
+    }
+  }
+}
+
 }  // namespace tensorflow
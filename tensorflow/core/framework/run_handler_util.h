@@ -54,6 +54,19 @@ void ComputeInterOpStealingRanges(int num_threads, int min_threads_per_domain,
 std::vector<int> ChooseRequestsWithExponentialDistribution(
     int num_active_requests, int num_threads);
 
+// Adjusts `request_idx_list`, as returned by
+// ChooseRequestsWithExponentialDistribution, so that every priority class gets
+// at least `min_threads_per_class` threads that attempt its requests first.
+// `request_priorities` holds the priority of each active request, in the order
+// of the requests, which must be sorted by decreasing priority. Threads are
+// taken, starting from the last one, from classes that have more than
+// `min_threads_per_class` threads, and are pointed at the first request of the
+// class that lacks threads. If there are not enough threads, the classes with
+// the highest priority are served first.
+void ReserveThreadsForPriorityClasses(
+    const std::vector<int64_t>& request_priorities, int min_threads_per_class,
+    std::vector<int>* request_idx_list);
+
 // Look up environment variable named 'var_name' and return the value if it
 // exist and can be parsed. Return 'default_value' otherwise.
 double ParamFromEnvWithDefault(const char* var_name, double default_value);
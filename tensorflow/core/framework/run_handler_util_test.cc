@@ -126,6 +126,25 @@ TEST(RunHandlerUtilTest, TestExponentialRequestDistribution) {
   ASSERT_EQ(actual_distribution, expected_distribution);
 }
 
+TEST(RunHandlerUtilTest, TestReserveThreadsForPriorityClasses) {
+  std::vector<int> request_idx_list{0, 0, 0, 0, 0, 1, 1, 1, 2, 2};
+  ReserveThreadsForPriorityClasses({2, 2, 1, 0}, 2, &request_idx_list);
+  std::vector<int> expected_distribution{0, 0, 0, 0, 0, 1, 3, 3, 2, 2};
+  EXPECT_EQ(request_idx_list, expected_distribution);
+
+  // With a single priority class the distribution is left as is.
+  request_idx_list = {0, 0, 1, 2};
+  ReserveThreadsForPriorityClasses({1, 1, 1}, 2, &request_idx_list);
+  expected_distribution = {0, 0, 1, 2};
+  EXPECT_EQ(request_idx_list, expected_distribution);
+
+  // Not enough threads for all classes; higher priorities are served first.
+  request_idx_list = {0, 0};
+  ReserveThreadsForPriorityClasses({3, 2, 1}, 1, &request_idx_list);
+  expected_distribution = {0, 1};
+  EXPECT_EQ(request_idx_list, expected_distribution);
+}
+
 TEST(RunHandlerUtilTest, TestParamFromEnvWithDefault) {
   std::vector<double> result = ParamFromEnvWithDefault(
       "RUN_HANDLER_TEST_ENV", std::vector<double>{0, 0, 0});
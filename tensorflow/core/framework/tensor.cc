@@ -55,6 +55,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -495,6 +496,88 @@ Buffer<T>::~Buffer() {
   }
 }
 
+// A buffer of at most Tensor::kMaxInlineBytes that holds its payload itself,
+// aligned like the allocations of an Allocator. The buffers are recycled
+// through a per-thread freelist, so that the small tensors of control flow
+// heavy graphs, e.g. the outputs of Shape, Size and loop counters, are created
+// without calling an allocator.
+class InlineBuffer : public TensorBuffer {
+ public:
+  explicit InlineBuffer(size_t size)
+      : TensorBuffer(AlignedStorage(storage_)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("inline");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
+ private:
+  static void* AlignedStorage(char* storage) {
+    constexpr uintptr_t kMask = Allocator::kAllocatorAlignment - 1;
+    return reinterpret_cast<void*>(
+        (reinterpret_cast<uintptr_t>(storage) + kMask) & ~kMask);
+  }
+
+  ~InlineBuffer() override {}
+
+  const size_t size_;
+  char storage_[Tensor::kMaxInlineBytes + Allocator::kAllocatorAlignment - 1];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// The InlineBuffers freed by a thread, which it allocates again first. It is
+// trivially destructible, so that buffers freed by the destructors of other
+// thread-locals at thread exit don't use it after its destruction.
+struct InlineBufferFreelist {
+  static constexpr int kCapacity = 64;
+  void* buffers[kCapacity];
+  int size;
+  // Whether the InlineBufferFreelistDrainer of the thread was created, and
+  // whether it ran.
+  bool has_drainer;
+  bool drained;
+};
+thread_local InlineBufferFreelist inline_buffer_freelist;
+
+// Frees the buffers of inline_buffer_freelist at thread exit.
+struct InlineBufferFreelistDrainer {
+  ~InlineBufferFreelistDrainer() {
+    InlineBufferFreelist& freelist = inline_buffer_freelist;
+    while (freelist.size > 0) port::Free(freelist.buffers[--freelist.size]);
+    freelist.drained = true;
+  }
+};
+thread_local InlineBufferFreelistDrainer inline_buffer_freelist_drainer;
+
+void* InlineBuffer::operator new(size_t size) {
+  DCHECK_EQ(size, sizeof(InlineBuffer));
+  InlineBufferFreelist& freelist = inline_buffer_freelist;
+  if (freelist.size > 0) return freelist.buffers[--freelist.size];
+  return port::Malloc(sizeof(InlineBuffer));
+}
+
+void InlineBuffer::operator delete(void* ptr) {
+  InlineBufferFreelist& freelist = inline_buffer_freelist;
+  if (!freelist.has_drainer) {
+    // Odr-using the drainer creates it for this thread.
+    (void)&inline_buffer_freelist_drainer;
+    freelist.has_drainer = true;
+  }
+  if (!freelist.drained && freelist.size < InlineBufferFreelist::kCapacity) {
+    freelist.buffers[freelist.size++] = ptr;
+  } else {
+    port::Free(ptr);
+  }
+}
+
 // Allocates a T[n] buffer. Fills in the buffer with repeated values
 // in "in".  If "in" has less values than "n", fills the rest of T[n]
 // with the last value. If "in" has no values, fills T[n] with the
@@ -805,6 +888,20 @@ Status Tensor::BuildTensor(DataType type, const TensorShape& shape,
   return Status::OK();
 }
 
+bool Tensor::BuildInlineTensor(DataType type, const TensorShape& shape,
+                               Tensor* out_tensor) {
+  const int element_size = DataTypeSize(type);
+  if (!DataTypeCanUseMemcpy(type) || element_size == 0) return false;
+  const int64_t num_elements = shape.num_elements();
+  if (num_elements <= 0 || num_elements > kMaxInlineBytes / element_size) {
+    return false;
+  }
+  InlineBuffer* buf = new InlineBuffer(num_elements * element_size);
+  *out_tensor = Tensor(type, shape, buf);
+  buf->Unref();
+  return true;
+}
+
 // NOTE(mrry): The default allocator for a Tensor (when none is specified) is
 // the default CPU allocator for NUMA zone 0. Accessing that currently involves
 // acquiring a lock, which guards initialization of the per-NUMA zone
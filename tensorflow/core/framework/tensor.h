@@ -179,6 +179,20 @@ class Tensor {
   static Status BuildTensor(DataType type, const TensorShape& shape,
                             Tensor* out_tensor);
 
+  /// \brief The largest tensor, in bytes, that `BuildInlineTensor` creates.
+  static constexpr int64_t kMaxInlineBytes = 64;
+
+  /// \brief Initializes a tensor with the input `type` and `shape` whose
+  /// buffer holds the payload itself, and returns true, if `type` can be
+  /// memcpy'd and the tensor has between 1 and `kMaxInlineBytes` bytes.
+  /// Returns false and leaves `out_tensor` unmodified otherwise.
+  ///
+  /// The buffer is in host memory, and it is recycled through a thread-local
+  /// freelist instead of being allocated by an allocator, so it isn't
+  /// accounted by any allocator.
+  static bool BuildInlineTensor(DataType type, const TensorShape& shape,
+                                Tensor* out_tensor);
+
  private:
   // A tag type for selecting the `Tensor` constructor overload that creates a
   // scalar tensor in host memory.
@@ -1173,6 +1173,41 @@ TEST(Tensor, SharesBufferWith) {
   EXPECT_TRUE(a.SharesBufferWith(copy));
 }
 
+TEST(Tensor, BuildInlineTensor) {
+  Tensor scalar;
+  ASSERT_TRUE(Tensor::BuildInlineTensor(DT_INT64, TensorShape({}), &scalar));
+  EXPECT_EQ(scalar.dtype(), DT_INT64);
+  EXPECT_EQ(scalar.TotalBytes(), sizeof(int64_t));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(scalar.data()) %
+                Allocator::kAllocatorAlignment,
+            0);
+  scalar.scalar<int64_t>()() = 42;
+  Tensor copy(scalar);
+  EXPECT_TRUE(copy.SharesBufferWith(scalar));
+  EXPECT_EQ(copy.scalar<int64_t>()(), 42);
+
+  Tensor vector;
+  ASSERT_TRUE(Tensor::BuildInlineTensor(DT_FLOAT, TensorShape({16}), &vector));
+  vector.flat<float>().setConstant(1.0f);
+  test::ExpectTensorEqual<float>(vector, test::AsTensor<float>(
+                                             std::vector<float>(16, 1.0f)));
+
+  // Too large, not memcpy-able, and empty tensors aren't inline.
+  Tensor unset;
+  EXPECT_FALSE(Tensor::BuildInlineTensor(DT_FLOAT, TensorShape({17}), &unset));
+  EXPECT_FALSE(Tensor::BuildInlineTensor(DT_STRING, TensorShape({}), &unset));
+  EXPECT_FALSE(Tensor::BuildInlineTensor(DT_FLOAT, TensorShape({0}), &unset));
+  EXPECT_EQ(unset.NumElements(), 0);
+
+  // Freed buffers are allocated again.
+  const void* data = scalar.data();
+  scalar = Tensor();
+  copy = Tensor();
+  Tensor reused;
+  ASSERT_TRUE(Tensor::BuildInlineTensor(DT_INT32, TensorShape({2}), &reused));
+  EXPECT_EQ(reused.data(), data);
+}
+
 TEST(Tensor, FailureToAllocate) {
   TensorShape shape({1});
   DummyCPUAllocator allocator;
@@ -1507,6 +1542,21 @@ void BM_CreateAndDestroyWithBuf(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_CreateAndDestroyWithBuf);
 
+// Benchmark create and destroy a scalar tensor, with an allocated or an inline
+// buffer.
+void BM_CreateAndDestroyScalar(::testing::benchmark::State& state) {
+  const bool inline_buffer = state.range(0);
+  Allocator* allocator = cpu_allocator();
+  for (auto s : state) {
+    Tensor a;
+    if (!inline_buffer ||
+        !Tensor::BuildInlineTensor(DT_INT32, TensorShape({}), &a)) {
+      a = Tensor(allocator, DT_INT32, TensorShape({}));
+    }
+  }
+}
+BENCHMARK(BM_CreateAndDestroyScalar)->Arg(0)->Arg(1);
+
 // Benchmark create+copy a tensor, with an allocated buffer.
 void BM_CreateAndCopyCtrWithBuf(::testing::benchmark::State& state) {
   TensorShape shape({10, 20});
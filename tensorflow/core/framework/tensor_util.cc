@@ -18,11 +18,13 @@ limitations under the License.
 #include <cmath>
 #include <vector>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/coding.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -441,5 +443,193 @@ Status MakeShape(const Tensor& shape, TensorShape* out) {
   }
 }
 
+#if defined(TF_CORD_SUPPORT)
+namespace {
+
+// Tensor contents smaller than this are copied, which is cheaper than sharing
+// them.
+constexpr size_t kMinSharedTensorContentBytes = 1024;
+
+constexpr uint32 kWireTypeVarint = 0;
+constexpr uint32 kWireTypeLengthDelimited = 2;
+
+constexpr uint32 MakeTag(int field_number, uint32 wire_type) {
+  return (static_cast<uint32>(field_number) << 3) | wire_type;
+}
+
+// A ZeroCopyInputStream on the chunks of a Cord.
+class CordInputStream : public protobuf::io::ZeroCopyInputStream {
+ public:
+  explicit CordInputStream(const absl::Cord& cord)
+      : it_(cord.chunk_begin()), end_(cord.chunk_end()) {}
+
+  bool Next(const void** data, int* size) override {
+    if (backed_up_ == 0) {
+      do {
+        if (it_ == end_) return false;
+        chunk_ = *it_;
+        ++it_;
+      } while (chunk_.empty());
+      backed_up_ = chunk_.size();
+    }
+    *data = chunk_.data() + chunk_.size() - backed_up_;
+    *size = backed_up_;
+    byte_count_ += backed_up_;
+    backed_up_ = 0;
+    return true;
+  }
+  void BackUp(int count) override {
+    backed_up_ = count;
+    byte_count_ -= count;
+  }
+  bool Skip(int count) override {
+    const void* data;
+    int size;
+    while (count > 0) {
+      if (!Next(&data, &size)) return false;
+      if (size > count) {
+        BackUp(size - count);
+        return true;
+      }
+      count -= size;
+    }
+    return true;
+  }
+  int64_t ByteCount() const override { return byte_count_; }
+
+ private:
+  absl::Cord::ChunkIterator it_;
+  const absl::Cord::ChunkIterator end_;
+  absl::string_view chunk_;
+  int backed_up_ = 0;
+  int64_t byte_count_ = 0;
+};
+
+// The memory of a tensor parsed from a Cord, which keeps the Cord alive.
+class CordTensorBuffer : public TensorBuffer {
+ public:
+  CordTensorBuffer(const absl::Cord& cord, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), cord_(cord), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("cord");
+  }
+  // The Cord may be shared, so its memory must not be updated in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const absl::Cord cord_;
+  const size_t size_;
+};
+
+// Parses the TensorProto in 'in' into a tensor backed by 'in'. Returns false
+// if its contents can't be shared, which is also the case for TensorProtos
+// with fields other than the dtype, the shape and the contents.
+bool ParseSharedTensorProto(const absl::Cord& in, Tensor* tensor) {
+  CordInputStream stream(in);
+  protobuf::io::CodedInputStream input(&stream);
+  DataType dtype = DT_INVALID;
+  TensorShapeProto shape_proto;
+  const char* content = nullptr;
+  uint32 content_size = 0;
+  while (uint32 tag = input.ReadTag()) {
+    switch (tag) {
+      case MakeTag(TensorProto::kDtypeFieldNumber, kWireTypeVarint): {
+        uint32 v;
+        if (!input.ReadVarint32(&v)) return false;
+        dtype = static_cast<DataType>(v);
+        break;
+      }
+      case MakeTag(TensorProto::kTensorShapeFieldNumber,
+                   kWireTypeLengthDelimited): {
+        uint32 length;
+        if (!input.ReadVarint32(&length)) return false;
+        protobuf::io::CodedInputStream::Limit limit = input.PushLimit(length);
+        if (!shape_proto.MergePartialFromCodedStream(&input) ||
+            !input.ConsumedEntireMessage()) {
+          return false;
+        }
+        input.PopLimit(limit);
+        break;
+      }
+      case MakeTag(TensorProto::kTensorContentFieldNumber,
+                   kWireTypeLengthDelimited): {
+        if (!input.ReadVarint32(&content_size)) return false;
+        // The contents must be in a single chunk.
+        const void* data;
+        int size;
+        if (!input.GetDirectBufferPointer(&data, &size) ||
+            static_cast<uint32>(size) < content_size) {
+          return false;
+        }
+        content = static_cast<const char*>(data);
+        if (!input.Skip(content_size)) return false;
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  // ReadTag() also returns 0 for malformed tags.
+  if (input.CurrentPosition() != static_cast<int64_t>(in.size()) ||
+      content == nullptr || content_size < kMinSharedTensorContentBytes ||
+      !DataTypeCanUseMemcpy(dtype) || !TensorShape::IsValid(shape_proto)) {
+    return false;
+  }
+  TensorShape shape(shape_proto);
+  const size_t element_size = DataTypeSize(dtype);
+  if (content_size % element_size != 0 ||
+      shape.num_elements() != content_size / element_size) {
+    return false;
+  }
+  TensorBuffer* buf = new CordTensorBuffer(in, content, content_size);
+  Tensor t(dtype, shape, buf);
+  buf->Unref();
+  if (!t.IsAligned()) return false;
+  *tensor = std::move(t);
+  return true;
+}
+
+}  // namespace
+
+void AppendTensorProtoToCord(const Tensor& tensor, absl::Cord* out) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype()) ||
+      tensor.TotalBytes() < kMinSharedTensorContentBytes) {
+    TensorProto proto;
+    tensor.AsProtoTensorContent(&proto);
+    out->Append(proto.SerializeAsString());
+    return;
+  }
+  // Encoded like AsProtoTensorContent() does, in field number order.
+  TensorProto skeleton;
+  skeleton.set_dtype(tensor.dtype());
+  tensor.shape().AsProto(skeleton.mutable_tensor_shape());
+  std::string header;
+  skeleton.AppendToString(&header);
+  const StringPiece content = tensor.tensor_data();
+  core::PutVarint32(&header, MakeTag(TensorProto::kTensorContentFieldNumber,
+                                     kWireTypeLengthDelimited));
+  core::PutVarint64(&header, content.size());
+  out->Append(header);
+  // The copy of the tensor keeps its buffer alive.
+  out->Append(absl::MakeCordFromExternal(
+      absl::string_view(content.data(), content.size()),
+      [tensor](absl::string_view) {}));
+}
+
+Status ParseTensorProtoFromCord(const absl::Cord& in, Tensor* tensor) {
+  if (ParseSharedTensorProto(in, tensor)) return Status::OK();
+  TensorProto proto;
+  CordInputStream stream(in);
+  if (!proto.ParseFromZeroCopyStream(&stream) || !tensor->FromProto(proto)) {
+    return errors::InvalidArgument("Cannot parse tensor from TensorProto");
+  }
+  return Status::OK();
+}
+#endif  // defined(TF_CORD_SUPPORT)
+
 }  // namespace tensor
 }  // namespace tensorflow
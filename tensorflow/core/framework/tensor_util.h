@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/type_traits.h"
+#include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -326,6 +327,20 @@ inline bool CompressTensorProtoInPlace(TensorProto* tensor) {
 // 1-dimensional tensor of type int32 or int64.
 Status MakeShape(const Tensor& shape_t, TensorShape* out);
 
+#if defined(TF_CORD_SUPPORT)
+// Appends to *out the serialization of the TensorProto that
+// tensor.AsProtoTensorContent() fills. For large tensors of types that can be
+// memcpy'ed, *out references the buffer of 'tensor' instead of copying its
+// contents, and keeps it alive.
+void AppendTensorProtoToCord(const Tensor& tensor, absl::Cord* out);
+
+// Parses the serialization of a TensorProto in 'in' into *tensor. When 'in'
+// holds the tensor_content of a large tensor of a type that can be memcpy'ed in
+// one chunk, suitably aligned, *tensor is backed by that chunk, which it keeps
+// alive, instead of a copy.
+Status ParseTensorProtoFromCord(const absl::Cord& in, Tensor* tensor);
+#endif  // defined(TF_CORD_SUPPORT)
+
 }  // namespace tensor
 }  // namespace tensorflow
 
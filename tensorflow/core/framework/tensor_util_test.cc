@@ -683,5 +683,65 @@ TEST(TensorProtoUtil, CompressTensorProtoNegatizeZero) {
   }
 }
 
+#if defined(TF_CORD_SUPPORT)
+TEST(TensorProtoUtil, TensorProtoCordSharesLargeTensors) {
+  Tensor tensor(DT_FLOAT, TensorShape({16, 64}));
+  tensor.flat<float>().setRandom();
+  absl::Cord cord;
+  tensor::AppendTensorProtoToCord(tensor, &cord);
+
+  TensorProto expected;
+  tensor.AsProtoTensorContent(&expected);
+  EXPECT_EQ(std::string(cord), expected.SerializeAsString());
+  bool shares_contents = false;
+  for (absl::string_view chunk : cord.Chunks()) {
+    shares_contents |= chunk.data() == tensor.tensor_data().data();
+  }
+  EXPECT_TRUE(shares_contents);
+
+  Tensor parsed;
+  TF_ASSERT_OK(tensor::ParseTensorProtoFromCord(cord, &parsed));
+  test::ExpectTensorEqual<float>(tensor, parsed);
+  EXPECT_EQ(parsed.tensor_data().data(), tensor.tensor_data().data());
+}
+
+TEST(TensorProtoUtil, TensorProtoCordCopiesSmallAndStringTensors) {
+  Tensor small = test::AsTensor<int32>({1, 2, 3});
+  Tensor strings = test::AsTensor<tstring>({"a", "bc"});
+  for (const Tensor& tensor : {small, strings}) {
+    absl::Cord cord;
+    tensor::AppendTensorProtoToCord(tensor, &cord);
+    TensorProto expected;
+    tensor.AsProtoTensorContent(&expected);
+    EXPECT_EQ(std::string(cord), expected.SerializeAsString());
+
+    Tensor parsed;
+    TF_ASSERT_OK(tensor::ParseTensorProtoFromCord(cord, &parsed));
+    EXPECT_EQ(parsed.DebugString(3), tensor.DebugString(3));
+  }
+}
+
+TEST(TensorProtoUtil, ParseTensorProtoFromCordCopiesUnalignedContents) {
+  Tensor tensor(DT_INT64, TensorShape({1024}));
+  tensor.flat<int64_t>().setConstant(7);
+  TensorProto proto;
+  tensor.AsProtoTensorContent(&proto);
+  // A flat Cord, in which the contents follow the few bytes of the dtype and
+  // shape.
+  const absl::Cord cord(proto.SerializeAsString());
+
+  Tensor parsed;
+  TF_ASSERT_OK(tensor::ParseTensorProtoFromCord(cord, &parsed));
+  test::ExpectTensorEqual<int64_t>(tensor, parsed);
+  EXPECT_TRUE(parsed.IsAligned());
+}
+
+TEST(TensorProtoUtil, ParseTensorProtoFromCordRejectsMalformedProtos) {
+  Tensor tensor;
+  EXPECT_FALSE(
+      tensor::ParseTensorProtoFromCord(absl::Cord("\xff\xff"), &tensor).ok());
+}
+#endif  // defined(TF_CORD_SUPPORT)
+
 }  // namespace
 }  // namespace tensorflow
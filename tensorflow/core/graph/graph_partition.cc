@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <algorithm>
 #include <deque>
+#include <limits>
+#include <map>
 #include <queue>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -26,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/memory_types.h"
 #include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -781,6 +786,231 @@ Status AddControlFlow(const PartitionOptions& opts, Graph* g,
   return Status::OK();
 }
 
+// A tensor that crosses from one device to another, with the edges that
+// consume it on the destination device.
+struct CoalescedTensor {
+  const Node* src;
+  int src_output;
+  TensorShape shape;
+  std::vector<const Edge*> edges;
+};
+
+// The tensors that cross from one device to another with the same type, and
+// that are coalesced into a single transfer.
+struct CoalescedTransfer {
+  std::vector<CoalescedTensor> tensors;
+};
+
+bool IsCoalescibleType(DataType dtype) {
+  return dtype == DT_HALF || dtype == DT_BFLOAT16 || dtype == DT_FLOAT ||
+         dtype == DT_DOUBLE;
+}
+
+bool GetOutputShape(const PartitionOptions& opts, const Node* node, int index,
+                    TensorShape* shape) {
+  if (opts.get_output_shape) {
+    return opts.get_output_shape(node, index, shape);
+  }
+  std::vector<PartialTensorShape> output_shapes;
+  if (!GetNodeAttr(node->attrs(), "_output_shapes", &output_shapes).ok() ||
+      index >= static_cast<int>(output_shapes.size())) {
+    return false;
+  }
+  return output_shapes[index].AsTensorShape(shape);
+}
+
+// Drops from `transfer` the tensors whose source is reachable from the
+// destination of any of its edges: coalescing them would make the transfer
+// depend on its own output.
+void DropCyclicTensors(const Graph& g, CoalescedTransfer* transfer) {
+  std::vector<bool> reachable(g.num_node_ids(), false);
+  std::deque<const Node*> queue;
+  for (const CoalescedTensor& tensor : transfer->tensors) {
+    for (const Edge* edge : tensor.edges) {
+      if (!reachable[edge->dst()->id()]) {
+        reachable[edge->dst()->id()] = true;
+        queue.push_back(edge->dst());
+      }
+    }
+  }
+  while (!queue.empty()) {
+    const Node* node = queue.front();
+    queue.pop_front();
+    for (const Node* out : node->out_nodes()) {
+      if (!reachable[out->id()]) {
+        reachable[out->id()] = true;
+        queue.push_back(out);
+      }
+    }
+  }
+  auto& tensors = transfer->tensors;
+  tensors.erase(std::remove_if(tensors.begin(), tensors.end(),
+                               [&reachable](const CoalescedTensor& t) {
+                                 return reachable[t.src->id()];
+                               }),
+                tensors.end());
+}
+
+Node* AddCoalesceConst(const PartitionOptions& opts, Graph* g,
+                       const Tensor& value, const string& device_name,
+                       Status* status) {
+  Node* res_node;
+  *status = NodeBuilder(opts.new_name("coalesce/const"), "Const",
+                        g->op_registry())
+                .Attr("dtype", value.dtype())
+                .Attr("value", value)
+                .Finalize(g, &res_node);
+  if (!status->ok()) return nullptr;
+  res_node->set_assigned_device_name(device_name);
+  return res_node;
+}
+
+// Replaces the edges of `transfer` by a ConcatV2 of the flattened tensors on
+// the source device, and a SplitV followed by a Reshape per tensor on the
+// destination device.
+Status AddCoalescedTransfer(const PartitionOptions& opts,
+                            const CoalescedTransfer& transfer, Graph* g) {
+  const CoalescedTensor& first = transfer.tensors[0];
+  const string& src_device = first.src->assigned_device_name();
+  const string& dst_device = first.edges[0]->dst()->assigned_device_name();
+  const int num_tensors = transfer.tensors.size();
+  Status status;
+
+  Tensor flat_shape(DT_INT32, TensorShape({1}));
+  flat_shape.vec<int32>()(0) = -1;
+  Node* src_flat_shape =
+      AddCoalesceConst(opts, g, flat_shape, src_device, &status);
+  if (!status.ok()) return status;
+  Node* src_axis =
+      AddCoalesceConst(opts, g, Tensor(int32{0}), src_device, &status);
+  if (!status.ok()) return status;
+  std::vector<NodeBuilder::NodeOut> flat_tensors;
+  // The sizes and shapes are int32, which the GPU kernels of SplitV and
+  // Reshape read from host memory.
+  Tensor split_sizes(DT_INT32, TensorShape({num_tensors}));
+  for (int i = 0; i < num_tensors; ++i) {
+    const CoalescedTensor& tensor = transfer.tensors[i];
+    Node* flat;
+    TF_RETURN_IF_ERROR(
+        NodeBuilder(opts.new_name("coalesce/flatten"), "Reshape",
+                    g->op_registry())
+            .Input(const_cast<Node*>(tensor.src), tensor.src_output)
+            .Input(src_flat_shape)
+            .Finalize(g, &flat));
+    flat->set_assigned_device_name(src_device);
+    flat_tensors.emplace_back(flat);
+    split_sizes.vec<int32>()(i) = tensor.shape.num_elements();
+  }
+  Node* concat;
+  TF_RETURN_IF_ERROR(NodeBuilder(opts.new_name("coalesce/concat"), "ConcatV2",
+                                 g->op_registry())
+                         .Input(flat_tensors)
+                         .Input(src_axis)
+                         .Finalize(g, &concat));
+  concat->set_assigned_device_name(src_device);
+
+  Node* dst_sizes = AddCoalesceConst(opts, g, split_sizes, dst_device, &status);
+  if (!status.ok()) return status;
+  Node* dst_axis =
+      AddCoalesceConst(opts, g, Tensor(int32{0}), dst_device, &status);
+  if (!status.ok()) return status;
+  Node* split;
+  TF_RETURN_IF_ERROR(NodeBuilder(opts.new_name("coalesce/split"), "SplitV",
+                                 g->op_registry())
+                         .Input(concat)
+                         .Input(dst_sizes)
+                         .Input(dst_axis)
+                         .Attr("num_split", num_tensors)
+                         .Finalize(g, &split));
+  split->set_assigned_device_name(dst_device);
+  for (int i = 0; i < num_tensors; ++i) {
+    const CoalescedTensor& tensor = transfer.tensors[i];
+    Tensor shape(DT_INT32, TensorShape({tensor.shape.dims()}));
+    for (int d = 0; d < tensor.shape.dims(); ++d) {
+      shape.vec<int32>()(d) = tensor.shape.dim_size(d);
+    }
+    Node* dst_shape = AddCoalesceConst(opts, g, shape, dst_device, &status);
+    if (!status.ok()) return status;
+    Node* reshape;
+    TF_RETURN_IF_ERROR(NodeBuilder(opts.new_name("coalesce/reshape"),
+                                   "Reshape", g->op_registry())
+                           .Input(split, i)
+                           .Input(dst_shape)
+                           .Finalize(g, &reshape));
+    reshape->set_assigned_device_name(dst_device);
+    for (const Edge* edge : tensor.edges) {
+      TF_RETURN_IF_ERROR(
+          g->UpdateEdge(reshape, 0, edge->dst(), edge->dst_input()));
+    }
+  }
+  return Status::OK();
+}
+
+// Coalesces the small tensors that cross between the same pair of devices,
+// as described by PartitionOptions::max_coalesced_tensor_bytes.
+Status CoalesceTransfers(const PartitionOptions& opts, Graph* g) {
+  for (const Node* node : g->op_nodes()) {
+    // Coalescing tensors would merge their deadness, and move them out of
+    // their frames.
+    if (node->IsControlFlow()) return Status::OK();
+  }
+  GraphInfo g_info;
+  TF_RETURN_IF_ERROR(BuildMemoryDeviceInfo(*g, &g_info));
+
+  // Keyed by the source and destination devices and the type, in this order,
+  // so that the rewrite is deterministic.
+  std::map<std::tuple<string, string, DataType>, CoalescedTransfer> transfers;
+  for (const Node* src : g->op_nodes()) {
+    const string src_loc = opts.node_to_loc(src);
+    for (int i = 0; i < src->num_outputs(); ++i) {
+      const DataType dtype = src->output_type(i);
+      TensorShape shape;
+      if (!IsCoalescibleType(dtype) ||
+          g_info.output_types[{src->id(), i}] != DEVICE_MEMORY ||
+          !GetOutputShape(opts, src, i, &shape) ||
+          shape.num_elements() > std::numeric_limits<int32>::max() ||
+          shape.num_elements() * DataTypeSize(dtype) >
+              opts.max_coalesced_tensor_bytes) {
+        continue;
+      }
+      // The tensor is transferred once to every other device it is used on.
+      std::map<string, CoalescedTensor> by_dst_device;
+      for (const Edge* edge : src->out_edges()) {
+        const Node* dst = edge->dst();
+        if (edge->IsControlEdge() || edge->src_output() != i ||
+            !dst->IsOp() || opts.node_to_loc(dst) == src_loc ||
+            g_info.input_types[{dst->id(), edge->dst_input()}] !=
+                DEVICE_MEMORY) {
+          continue;
+        }
+        CoalescedTensor& tensor = by_dst_device[dst->assigned_device_name()];
+        tensor.src = src;
+        tensor.src_output = i;
+        tensor.shape = shape;
+        tensor.edges.push_back(edge);
+      }
+      for (auto& it : by_dst_device) {
+        transfers[{src->assigned_device_name(), it.first, dtype}]
+            .tensors.push_back(std::move(it.second));
+      }
+    }
+  }
+
+  int num_coalesced = 0;
+  for (auto& it : transfers) {
+    CoalescedTransfer& transfer = it.second;
+    if (transfer.tensors.size() < 2) continue;
+    // The graph includes the previous rewrites, so that no combination of
+    // them introduces a cycle either.
+    DropCyclicTensors(*g, &transfer);
+    if (transfer.tensors.size() < 2) continue;
+    TF_RETURN_IF_ERROR(AddCoalescedTransfer(opts, transfer, g));
+    num_coalesced += transfer.tensors.size();
+  }
+  VLOG(1) << "Coalesced " << num_coalesced << " cross-device tensors";
+  return Status::OK();
+}
+
 struct PriorityTopoSortNode {
   PriorityTopoSortNode(const NodeDef* n, int64_t st)
       : node(n), start_time(st) {}
@@ -984,6 +1214,12 @@ Status Partition(const PartitionOptions& opts, Graph* g,
   Status status;
   partitions->clear();
 
+  if (opts.max_coalesced_tensor_bytes > 0 && !opts.scheduling_for_recvs &&
+      !opts.need_to_record_start_times) {
+    status = CoalesceTransfers(opts, g);
+    if (!status.ok()) return status;
+  }
+
   GraphInfo g_info;
   if (!opts.control_flow_added) {
     // Add the "code" for distributed execution of control flow. Code is
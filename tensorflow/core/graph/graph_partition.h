@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 
@@ -66,6 +67,23 @@ struct PartitionOptions {
   typedef std::function<DataType(const Edge*)> ShouldCastFunc;
   ShouldCastFunc should_cast = nullptr;
 
+  // If positive, the data edges between two locations that carry tensors of
+  // at most this many bytes are coalesced: the tensors that cross from the
+  // same device to the same device with the same floating point type are
+  // flattened and concatenated on the source device, sent as one tensor,
+  // and split back on the destination device. This trades a copy of each
+  // tensor for a single send/recv pair, which pays off when many small
+  // tensors cross devices. Graphs with control flow are not coalesced.
+  int64_t max_coalesced_tensor_bytes = 0;
+
+  // A function that returns in `*shape` the shape of output `index` of
+  // `node` if it is statically known, and false otherwise. Only tensors of
+  // known shape are coalesced. If not set, the shapes are read from the
+  // "_output_shapes" attribute of the nodes.
+  typedef std::function<bool(const Node* node, int index, TensorShape* shape)>
+      GetOutputShapeFunc;
+  GetOutputShapeFunc get_output_shape = nullptr;
+
   // Schedule the execution of the recvs based on their start times
   // computed by some scheduling algorithm. The recvs are divided into
   // epochs based on their start times. A recv is enabled only when
@@ -74,8 +74,11 @@ string DeviceName(const Node* node) {
   }
 }
 
+// If `max_coalesced_tensor_bytes` is positive, the float tensors are
+// coalesced as if they all held two elements.
 void Partition(const GraphDef& graph_def,
-               std::unordered_map<string, GraphDef>* partitions) {
+               std::unordered_map<string, GraphDef>* partitions,
+               int64_t max_coalesced_tensor_bytes = 0) {
   Graph g(OpRegistry::Global());
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
@@ -95,6 +98,11 @@ void Partition(const GraphDef& graph_def,
   popts.get_incarnation = [](const string& name) {
     return (name[0] - 'A') + 100;
   };
+  popts.max_coalesced_tensor_bytes = max_coalesced_tensor_bytes;
+  popts.get_output_shape = [](const Node* node, int index, TensorShape* shape) {
+    *shape = TensorShape({2});
+    return true;
+  };
   Status s = Partition(popts, &g, partitions);
   CHECK(s.ok()) << s;
 
@@ -487,6 +495,66 @@ TEST_F(GraphPartitionTest, Functions) {
   ExpectFunctions(partitions_[b].library(), {"XTimesTwo", "XTimesFour"});
 }
 
+int CountOps(const GraphDef& graph_def, const string& op) {
+  int count = 0;
+  for (const NodeDef& ndef : graph_def.node()) {
+    if (ndef.op() == op) ++count;
+  }
+  return count;
+}
+
+TEST_F(GraphPartitionTest, CoalesceCrossDeviceData) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto a2 = FloatInput(in_.WithOpName("A2"));
+  auto a3 = FloatInput(in_.WithOpName("A3"));
+  Combine(in_.WithOpName("B1"), a1, a2);
+  Combine(in_.WithOpName("B2"), a2, a3);
+
+  Partition(ToGraphDef(), &partitions_, /*max_coalesced_tensor_bytes=*/8);
+  EXPECT_EQ(2, partitions_.size());
+
+  const GraphDef& a = partitions_["/job:a/replica:0/task:0/cpu:0"];
+  const GraphDef& b = partitions_["/job:a/replica:0/task:0/cpu:1"];
+  EXPECT_EQ(1, CountOps(a, "_Send"));
+  EXPECT_EQ(1, CountOps(a, "ConcatV2"));
+  EXPECT_EQ(3, CountOps(a, "Reshape"));
+  EXPECT_EQ(1, CountOps(b, "_Recv"));
+  EXPECT_EQ(1, CountOps(b, "SplitV"));
+  EXPECT_EQ(3, CountOps(b, "Reshape"));
+  for (const NodeDef& ndef : b.node()) {
+    if (ndef.op() == "Combine") {
+      for (const string& input : ndef.input()) {
+        EXPECT_TRUE(absl::StartsWith(input, "coalesce/reshape")) << input;
+      }
+    }
+  }
+}
+
+TEST_F(GraphPartitionTest, CoalesceCrossDeviceData_TooLarge) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto a2 = FloatInput(in_.WithOpName("A2"));
+  Combine(in_.WithOpName("B1"), a1, a2);
+
+  Partition(ToGraphDef(), &partitions_, /*max_coalesced_tensor_bytes=*/4);
+  const GraphDef& a = partitions_["/job:a/replica:0/task:0/cpu:0"];
+  EXPECT_EQ(2, CountOps(a, "_Send"));
+  EXPECT_EQ(0, CountOps(a, "ConcatV2"));
+}
+
+TEST_F(GraphPartitionTest, CoalesceCrossDeviceData_NoCycle) {
+  // A3 depends on B1, which consumes A1, so A1 and A3 can't be sent
+  // together.
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto b1 = Combine(in_.WithOpName("B1"), a1, a1);
+  auto a3 = Combine(in_.WithOpName("A3"), b1, b1);
+  Combine(in_.WithOpName("B2"), a3, a1);
+
+  Partition(ToGraphDef(), &partitions_, /*max_coalesced_tensor_bytes=*/8);
+  const GraphDef& a = partitions_["/job:a/replica:0/task:0/cpu:0"];
+  EXPECT_EQ(2, CountOps(a, "_Send"));
+  EXPECT_EQ(0, CountOps(a, "ConcatV2"));
+}
+
 TEST_F(GraphPartitionTest, SetIncarnation) {
   GraphDef gdef;
   const char* const kSendRecvAttrs = R"proto(
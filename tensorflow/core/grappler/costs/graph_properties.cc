@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/function_shape_cache.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/function.pb.h"
@@ -36,7 +37,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -934,51 +937,80 @@ class SymbolicShapeRefiner {
       output_node->mutable_attr()->erase("index");
     }
 
-    // Perform inference on function body.
-    GraphProperties gp(grappler_function_item);
-    TF_RETURN_IF_ERROR(gp.InferStatically(
-        /*assume_valid_feeds=*/true,
-        /*aggressive_shape_inference=*/aggressive_shape_inference_,
-        /*include_tensor_values=*/true));
+    // The shapes of the function body only depend on the body with the
+    // inputs annotated and replaced above, so calls of the same function with
+    // the same inputs, e.g. when the graph is optimized again, share them.
+    FunctionShapeCache* cache = FunctionShapeCache::Global();
+    uint64 key = 0;
+    std::shared_ptr<const FunctionShapes> shapes;
+    if (cache->enabled()) {
+      key = FingerprintCat64(
+          Fingerprint64("GraphProperties"),
+          DeterministicProtoHash64(grappler_function_item.graph));
+      key = FingerprintCat64(key, aggressive_shape_inference_);
+      for (const auto& out_arg : grappler_function_item.outputs()) {
+        key = FingerprintCat64(key, Fingerprint64(out_arg.node_name));
+      }
+      shapes = cache->Lookup(key);
+    }
+
+    if (shapes == nullptr) {
+      // Perform inference on function body.
+      GraphProperties gp(grappler_function_item);
+      TF_RETURN_IF_ERROR(gp.InferStatically(
+          /*assume_valid_feeds=*/true,
+          /*aggressive_shape_inference=*/aggressive_shape_inference_,
+          /*include_tensor_values=*/true));
+
+      FunctionShapes inferred_shapes;
+      for (auto const& out_arg : grappler_function_item.outputs()) {
+        // It is guaranteed that output_tensors does not contain any control
+        // inputs, so port_id >= 0.
+        TensorId out_tensor = ParseTensorName(out_arg.node_name);
+
+        if (output_nodes.count(out_tensor.node()) <= 0) {
+          return errors::FailedPrecondition(
+              "Unable to find return function_node ", out_tensor.node(),
+              " for ", function_node->name());
+        }
+        const NodeDef* retnode = output_nodes[out_tensor.node()];
+
+        auto output_properties = gp.GetOutputProperties(retnode->name());
+        int output_properties_size = output_properties.size();
+        if (out_tensor.index() >= output_properties_size) {
+          return errors::InvalidArgument(
+              out_tensor.ToString(), " has invalid position ",
+              out_tensor.index(),
+              " (output_properties.size() = ", output_properties.size(), ").");
+        }
+        auto& outprop = output_properties[out_tensor.index()];
+        inferred_shapes.outputs.emplace_back();
+        FunctionShapes::Output& output = inferred_shapes.outputs.back();
+        output.shape = outprop.shape();
+        NormalizeShapeForOutput(&*output.shape);
+        if (outprop.has_value()) output.value = outprop.value();
+      }
+      shapes =
+          std::make_shared<const FunctionShapes>(std::move(inferred_shapes));
+      if (cache->enabled()) cache->Insert(key, *shapes);
+    }
 
     // Add return nodes for output shapes.
-    int output = 0;
     ctx->output_tensors_as_shapes.resize(grappler_function_item.output_size());
     ctx->output_tensor_protos.resize(grappler_function_item.output_size(),
                                      nullptr);
-    for (auto const& out_arg : grappler_function_item.outputs()) {
-      // It is guaranteed that output_tensors does not contain any control
-      // inputs, so port_id >= 0.
-      TensorId out_tensor = ParseTensorName(out_arg.node_name);
-
-      if (output_nodes.count(out_tensor.node()) <= 0) {
-        return errors::FailedPrecondition(
-            "Unable to find return function_node ", out_tensor.node(), " for ",
-            function_node->name());
-      }
-      const NodeDef* retnode = output_nodes[out_tensor.node()];
-
-      auto output_properties = gp.GetOutputProperties(retnode->name());
-      int output_properties_size = output_properties.size();
-      if (out_tensor.index() >= output_properties_size) {
-        return errors::InvalidArgument(
-            out_tensor.ToString(), " has invalid position ", out_tensor.index(),
-            " (output_properties.size() = ", output_properties.size(), ").");
-      }
-      auto& outprop = output_properties[out_tensor.index()];
-      TensorShapeProto shape = outprop.shape();
-      NormalizeShapeForOutput(&shape);
+    for (int output = 0; output < shapes->outputs.size(); ++output) {
+      const FunctionShapes::Output& outprop = shapes->outputs[output];
       ShapeHandle out;
-      TF_RETURN_IF_ERROR(ic->MakeShapeFromShapeProto(shape, &out));
+      TF_RETURN_IF_ERROR(ic->MakeShapeFromShapeProto(*outprop.shape, &out));
       ic->set_output(output, out);
-      if (outprop.has_value()) {
+      if (outprop.value) {
         // Forward tensor value to output_tensors_as_shape.
-        MaybeTensorProtoToShape(ic, outprop.value(),
+        MaybeTensorProtoToShape(ic, *outprop.value,
                                 &ctx->output_tensors_as_shapes[output]);
-        const_tensors_to_propagate_.push_back(outprop.value());
+        const_tensors_to_propagate_.push_back(*outprop.value);
         ctx->output_tensor_protos[output] = &const_tensors_to_propagate_.back();
       }
-      output++;
     }
 
     return Status::OK();
@@ -0,0 +1,141 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_op_costs.h"
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+int64_t RoundUpToPowerOfTwo(int64_t dim) {
+  int64_t bucket = 1;
+  while (bucket < dim) bucket <<= 1;
+  return bucket;
+}
+
+int64_t TotalInputBytes(const OpInfo& op_info) {
+  int64_t total_bytes = 0;
+  for (const auto& input : op_info.inputs()) {
+    total_bytes += CalculateTensorSize(input);
+  }
+  return total_bytes;
+}
+
+}  // namespace
+
+string MeasuredOpCosts::BucketKey(const OpInfo& op_info) {
+  std::vector<string> parts = {op_info.op(), op_info.device().type()};
+  // Attributes starting with an underscore don't change the kernel that runs.
+  std::map<string, string> attrs;
+  for (const auto& attr : op_info.attr()) {
+    if (attr.first.empty() || attr.first[0] == '_') continue;
+    attrs[attr.first] = SummarizeAttrValue(attr.second);
+  }
+  for (const auto& attr : attrs) {
+    parts.push_back(absl::StrCat(attr.first, "=", attr.second));
+  }
+  for (const auto& input : op_info.inputs()) {
+    std::vector<string> dims;
+    if (input.shape().unknown_rank()) {
+      dims.push_back("?");
+    } else {
+      for (const auto& dim : input.shape().dim()) {
+        dims.push_back(dim.size() < 0
+                           ? "?"
+                           : absl::StrCat(RoundUpToPowerOfTwo(dim.size())));
+      }
+    }
+    parts.push_back(absl::StrCat(DataTypeString(input.dtype()), "[",
+                                 absl::StrJoin(dims, ","), "]"));
+  }
+  return absl::StrJoin(parts, ";");
+}
+
+void MeasuredOpCosts::Add(const OpPerformance& op_performance) {
+  if (op_performance.compute_cost() <= 0) return;
+  Bucket& bucket = buckets_[BucketKey(op_performance.op())];
+  ++bucket.num_measurements;
+  bucket.total_time_ns += op_performance.compute_cost();
+  bucket.total_input_bytes += TotalInputBytes(op_performance.op());
+}
+
+void MeasuredOpCosts::Add(const OpPerformanceList& op_performance_list) {
+  for (const OpPerformance& op_performance :
+       op_performance_list.op_performance()) {
+    Add(op_performance);
+  }
+}
+
+Status MeasuredOpCosts::Load(const string& filename) {
+  OpPerformanceList op_performance_list;
+  TF_RETURN_IF_ERROR(
+      ReadTextOrBinaryProto(Env::Default(), filename, &op_performance_list));
+  Add(op_performance_list);
+  return Status::OK();
+}
+
+bool MeasuredOpCosts::Find(const OpInfo& op_info,
+                           Costs::NanoSeconds* execution_time) const {
+  auto it = buckets_.find(BucketKey(op_info));
+  if (it == buckets_.end()) return false;
+  const Bucket& bucket = it->second;
+  const int64_t input_bytes = TotalInputBytes(op_info);
+  if (bucket.total_input_bytes > 0 && input_bytes > 0) {
+    *execution_time = Costs::NanoSeconds(
+        static_cast<double>(bucket.total_time_ns) * input_bytes /
+        bucket.total_input_bytes);
+  } else {
+    *execution_time =
+        Costs::NanoSeconds(bucket.total_time_ns / bucket.num_measurements);
+  }
+  return true;
+}
+
+/* static */ std::shared_ptr<const MeasuredOpCosts>
+MeasuredOpCosts::FromEnvironment() {
+  static const auto* const measured_op_costs =
+      new std::shared_ptr<const MeasuredOpCosts>([]() {
+        const char* filename = getenv(kMeasuredOpCostsEnvVar);
+        if (filename == nullptr || *filename == '\0') {
+          return std::shared_ptr<const MeasuredOpCosts>();
+        }
+        auto costs = std::make_shared<MeasuredOpCosts>();
+        const Status status = costs->Load(filename);
+        if (!status.ok()) {
+          LOG(WARNING) << "Could not load the measured op costs from "
+                       << filename << ": " << status;
+          return std::shared_ptr<const MeasuredOpCosts>();
+        }
+        VLOG(1) << "Loaded " << costs->buckets_.size()
+                << " measured op costs from " << filename;
+        return std::shared_ptr<const MeasuredOpCosts>(std::move(costs));
+      }());
+  return *measured_op_costs;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_OP_COSTS_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_OP_COSTS_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Environment variable naming a file with an OpPerformanceList of measured op
+// costs, e.g. written by op_cost_calibration, that the OpLevelCostEstimator
+// prefers over its analytical estimates.
+constexpr char kMeasuredOpCostsEnvVar[] = "TF_GRAPPLER_MEASURED_OP_COSTS";
+
+// A table of measured op execution times, keyed by the op, its attributes,
+// the device type and the shape bucket of its inputs. A shape bucket rounds
+// every input dimension up to a power of two, and the times measured in a
+// bucket are scaled by the input sizes of the op to look up.
+class MeasuredOpCosts {
+ public:
+  MeasuredOpCosts() = default;
+
+  // Adds the op_performance.compute_cost() measured for op_performance.op().
+  void Add(const OpPerformance& op_performance);
+  void Add(const OpPerformanceList& op_performance_list);
+
+  // Loads a binary or text OpPerformanceList from `filename`.
+  Status Load(const string& filename);
+
+  // Returns true and sets `*execution_time` if there is a measurement for the
+  // bucket of `op_info`.
+  bool Find(const OpInfo& op_info, Costs::NanoSeconds* execution_time) const;
+
+  bool empty() const { return buckets_.empty(); }
+
+  // Returns the key of the bucket of `op_info`.
+  static string BucketKey(const OpInfo& op_info);
+
+  // Returns the table named by kMeasuredOpCostsEnvVar, loaded once per
+  // process, or nullptr if the variable is not set or the file cannot be
+  // loaded.
+  static std::shared_ptr<const MeasuredOpCosts> FromEnvironment();
+
+ private:
+  struct Bucket {
+    int64_t num_measurements = 0;
+    int64_t total_time_ns = 0;
+    int64_t total_input_bytes = 0;
+  };
+
+  std::unordered_map<string, Bucket> buckets_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_OP_COSTS_H_
@@ -0,0 +1,93 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_op_costs.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpInfo DescribeOp(const string& op, const std::vector<int64_t>& dims) {
+  OpInfo op_info;
+  op_info.set_op(op);
+  op_info.mutable_device()->set_type("CPU");
+  auto* input = op_info.add_inputs();
+  input->set_dtype(DT_FLOAT);
+  for (int64_t dim : dims) input->mutable_shape()->add_dim()->set_size(dim);
+  return op_info;
+}
+
+OpPerformance Measurement(const OpInfo& op_info, int64_t compute_cost) {
+  OpPerformance op_performance;
+  *op_performance.mutable_op() = op_info;
+  op_performance.set_compute_cost(compute_cost);
+  return op_performance;
+}
+
+TEST(MeasuredOpCostsTest, BucketKey) {
+  EXPECT_EQ(MeasuredOpCosts::BucketKey(DescribeOp("Relu", {3, 8, -1})),
+            "Relu;CPU;float[4,8,?]");
+  OpInfo op_info = DescribeOp("Relu", {5});
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  (*op_info.mutable_attr())["_class"].set_s("loc:@x");
+  op_info.mutable_device()->set_type("GPU");
+  EXPECT_EQ(MeasuredOpCosts::BucketKey(op_info),
+            "Relu;GPU;T=DT_FLOAT;float[8]");
+}
+
+TEST(MeasuredOpCostsTest, ScalesByInputSize) {
+  MeasuredOpCosts costs;
+  EXPECT_TRUE(costs.empty());
+  costs.Add(Measurement(DescribeOp("Relu", {100, 100}), 1000));
+  costs.Add(Measurement(DescribeOp("Relu", {100, 100}), 3000));
+  EXPECT_FALSE(costs.empty());
+
+  Costs::NanoSeconds time;
+  ASSERT_TRUE(costs.Find(DescribeOp("Relu", {100, 100}), &time));
+  EXPECT_EQ(time, Costs::NanoSeconds(2000));
+  ASSERT_TRUE(costs.Find(DescribeOp("Relu", {100, 50}), &time));
+  EXPECT_EQ(time, Costs::NanoSeconds(1000));
+  EXPECT_FALSE(costs.Find(DescribeOp("Relu", {100, 200}), &time));
+  EXPECT_FALSE(costs.Find(DescribeOp("Tanh", {100, 100}), &time));
+}
+
+TEST(MeasuredOpCostsTest, Load) {
+  OpPerformanceList op_performance_list;
+  *op_performance_list.add_op_performance() =
+      Measurement(DescribeOp("Relu", {16}), 100);
+  // Ops that were not measured are ignored.
+  *op_performance_list.add_op_performance() =
+      Measurement(DescribeOp("Tanh", {16}), 0);
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "measured_op_costs.pb");
+  TF_ASSERT_OK(
+      WriteBinaryProto(Env::Default(), filename, op_performance_list));
+
+  MeasuredOpCosts costs;
+  TF_ASSERT_OK(costs.Load(filename));
+  Costs::NanoSeconds time;
+  ASSERT_TRUE(costs.Find(DescribeOp("Relu", {16}), &time));
+  EXPECT_EQ(time, Costs::NanoSeconds(100));
+  EXPECT_FALSE(costs.Find(DescribeOp("Tanh", {16}), &time));
+}
+
+}  // namespace
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,236 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/measured_op_costs.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMeasuredNode[] = "op";
+
+bool CanMakeInput(const OpInfo::TensorProperties& input) {
+  if (input.has_value()) return true;
+  return DataTypeCanUseMemcpy(input.dtype()) &&
+         PartialTensorShape(input.shape()).IsFullyDefined();
+}
+
+Status MakeInput(const OpInfo::TensorProperties& input, Tensor* tensor) {
+  if (input.has_value()) {
+    if (!tensor->FromProto(input.value())) {
+      return errors::InvalidArgument("Cannot parse input value ",
+                                     input.value().ShortDebugString());
+    }
+    return Status::OK();
+  }
+  TensorShape shape;
+  if (!CanMakeInput(input) ||
+      !PartialTensorShape(input.shape()).AsTensorShape(&shape)) {
+    return errors::InvalidArgument("Cannot make an input of type ",
+                                   DataTypeString(input.dtype()),
+                                   " and shape ",
+                                   input.shape().ShortDebugString());
+  }
+  *tensor = Tensor(input.dtype(), shape);
+  switch (input.dtype()) {
+    case DT_FLOAT:
+      tensor->flat<float>().setRandom();
+      break;
+    case DT_DOUBLE:
+      tensor->flat<double>().setRandom();
+      break;
+    case DT_HALF:
+      tensor->flat<Eigen::half>().setRandom();
+      break;
+    case DT_BFLOAT16:
+      tensor->flat<bfloat16>().setRandom();
+      break;
+    default:
+      // Zeros are valid indices, sizes and axes for most ops.
+      memset(const_cast<char*>(tensor->tensor_data().data()), 0,
+             tensor->TotalBytes());
+      break;
+  }
+  return Status::OK();
+}
+
+// Builds a graph that feeds constants to the op, or to a NoOp unless
+// `with_op`, which measures the overhead of running the graph.
+Status BuildGraph(const OpInfo& op_info, bool with_op, const string& device,
+                  GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(kMeasuredNode);
+  node->set_device(device);
+  if (with_op) {
+    node->set_op(op_info.op());
+    for (const auto& attr : op_info.attr()) {
+      // Internal attributes may refer to nodes of the original graph.
+      if (!attr.first.empty() && attr.first[0] == '_') continue;
+      (*node->mutable_attr())[attr.first] = attr.second;
+    }
+  } else {
+    node->set_op("NoOp");
+  }
+  for (int i = 0; i < op_info.inputs_size(); ++i) {
+    Tensor tensor;
+    TF_RETURN_IF_ERROR(MakeInput(op_info.inputs(i), &tensor));
+    NodeDef* input = graph->add_node();
+    input->set_name(absl::StrCat("input_", i));
+    input->set_op("Const");
+    input->set_device(device);
+    (*input->mutable_attr())["dtype"].set_type(tensor.dtype());
+    tensor.AsProtoTensorContent(
+        (*input->mutable_attr())["value"].mutable_tensor());
+    node->add_input(with_op ? input->name()
+                            : AsControlDependency(input->name()));
+  }
+  return Status::OK();
+}
+
+// Returns the median time to run the graph.
+Status TimeGraph(const GraphDef& graph,
+                 const OpCostCalibrationOptions& options,
+                 int64_t* median_time_ns) {
+  SessionOptions session_options;
+  // Keep the graph as is, the op must not be folded into a constant.
+  GraphOptions* graph_options = session_options.config.mutable_graph_options();
+  graph_options->mutable_optimizer_options()->set_opt_level(
+      OptimizerOptions::L0);
+  graph_options->mutable_rewrite_options()->set_disable_meta_optimizer(true);
+  std::unique_ptr<Session> session(NewSession(session_options));
+  if (session == nullptr) {
+    return errors::Internal("Cannot create a session");
+  }
+  TF_RETURN_IF_ERROR(session->Create(graph));
+
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < options.num_warmup_runs; ++i) {
+    TF_RETURN_IF_ERROR(session->Run({}, {}, {kMeasuredNode}, &outputs));
+  }
+  std::vector<int64_t> times;
+  for (int i = 0; i < std::max(options.num_runs, 1); ++i) {
+    const uint64 start_ns = Env::Default()->NowNanos();
+    TF_RETURN_IF_ERROR(session->Run({}, {}, {kMeasuredNode}, &outputs));
+    times.push_back(Env::Default()->NowNanos() - start_ns);
+  }
+  std::nth_element(times.begin(), times.begin() + times.size() / 2,
+                   times.end());
+  *median_time_ns = times[times.size() / 2];
+  return session->Close();
+}
+
+}  // namespace
+
+Status CollectOpsToMeasure(const GrapplerItem& item,
+                           const DeviceProperties& device,
+                           std::vector<OpInfo>* ops) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(
+      properties.InferStatically(/*assume_valid_feeds=*/false));
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  std::unordered_set<string> buckets;
+  for (const NodeDef& node : item.graph.node()) {
+    const OpDef* op_def = nullptr;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        IsConstant(node) || IsPlaceholder(node) || IsNoOp(node) ||
+        IsControlFlow(node) || IsSend(node) || IsRecv(node) ||
+        IsStateful(node) || !properties.HasInputProperties(node.name())) {
+      continue;
+    }
+    const auto& inputs = properties.GetInputProperties(node.name());
+    if (!std::all_of(inputs.begin(), inputs.end(), CanMakeInput)) {
+      VLOG(2) << "Cannot make the inputs of " << node.name();
+      continue;
+    }
+    OpInfo op_info = BuildOpInfoWithoutDevice(node, name_to_node, inputs);
+    *op_info.mutable_device() = device;
+    if (buckets.insert(MeasuredOpCosts::BucketKey(op_info)).second) {
+      ops->push_back(std::move(op_info));
+    }
+  }
+  return Status::OK();
+}
+
+Status MeasureOpCost(const OpInfo& op_info,
+                     const OpCostCalibrationOptions& options,
+                     OpPerformance* op_performance) {
+  GraphDef graph;
+  TF_RETURN_IF_ERROR(
+      BuildGraph(op_info, /*with_op=*/true, options.device, &graph));
+  GraphDef baseline_graph;
+  TF_RETURN_IF_ERROR(
+      BuildGraph(op_info, /*with_op=*/false, options.device, &baseline_graph));
+
+  int64_t time_ns;
+  TF_RETURN_IF_ERROR(TimeGraph(graph, options, &time_ns));
+  int64_t baseline_time_ns;
+  TF_RETURN_IF_ERROR(TimeGraph(baseline_graph, options, &baseline_time_ns));
+
+  *op_performance->mutable_op() = op_info;
+  // Ops that take less time than the noise of the measurement still take
+  // some time.
+  op_performance->set_compute_cost(
+      std::max<int64_t>(time_ns - baseline_time_ns, 1));
+  return Status::OK();
+}
+
+Status CalibrateOpCosts(const GrapplerItem& item,
+                        const OpCostCalibrationOptions& options,
+                        OpPerformanceList* op_costs) {
+  std::vector<OpInfo> ops;
+  TF_RETURN_IF_ERROR(
+      CollectOpsToMeasure(item, GetDeviceInfo(options.device), &ops));
+  for (const OpInfo& op_info : ops) {
+    OpPerformance op_performance;
+    const Status status = MeasureOpCost(op_info, options, &op_performance);
+    if (!status.ok()) {
+      LOG(WARNING) << "Cannot measure " << GetOpDescription(op_info) << ": "
+                   << status;
+      continue;
+    }
+    VLOG(1) << GetOpDescription(op_info) << " takes "
+            << op_performance.compute_cost() << " ns";
+    *op_costs->add_op_performance() = std::move(op_performance);
+  }
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Measures the execution time of the ops of a graph on the local machine, to
+// build the table of measured op costs (see MeasuredOpCosts) that the
+// OpLevelCostEstimator prefers over its analytical estimates.
+struct OpCostCalibrationOptions {
+  // The device that runs the ops.
+  string device = "/device:CPU:0";
+  // Number of runs before the measurement starts.
+  int num_warmup_runs = 3;
+  // Number of measured runs. The median of their times is recorded.
+  int num_runs = 20;
+};
+
+// Returns the ops of `item` that can be measured: stateless ops with known
+// input shapes and types that can be filled with random values. Ops that fall
+// into the same MeasuredOpCosts bucket are only returned once, and the ops are
+// described as running on `device`.
+Status CollectOpsToMeasure(const GrapplerItem& item,
+                           const DeviceProperties& device,
+                           std::vector<OpInfo>* ops);
+
+// Measures the execution time of `op_info` by running it in a session on
+// inputs of the described shapes, and sets op_performance->compute_cost() to
+// it, in nanoseconds. Inputs with a known value use that value, the others
+// are random.
+Status MeasureOpCost(const OpInfo& op_info,
+                     const OpCostCalibrationOptions& options,
+                     OpPerformance* op_performance);
+
+// Measures the ops returned by CollectOpsToMeasure. Ops that fail to run are
+// skipped.
+Status CalibrateOpCosts(const GrapplerItem& item,
+                        const OpCostCalibrationOptions& options,
+                        OpPerformanceList* op_costs);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
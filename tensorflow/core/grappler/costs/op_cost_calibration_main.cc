@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the ops of a graph on this machine, and writes the table of
+// measured op costs that the OpLevelCostEstimator uses when the
+// TF_GRAPPLER_MEASURED_OP_COSTS environment variable names it:
+//
+//   op_cost_calibration --graph=model.pb --output=op_costs.pb
+//   TF_GRAPPLER_MEASURED_OP_COSTS=op_costs.pb python train.py
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+int ParseFlagsAndCalibrate(int argc, char* argv[]) {
+  string graph_file;
+  string output_file;
+  OpCostCalibrationOptions options;
+  std::vector<Flag> flag_list = {
+      Flag("graph", &graph_file,
+           "binary or text GraphDef of the ops to measure"),
+      Flag("output", &output_file,
+           "file to write the OpPerformanceList of measured op costs to, in "
+           "text format if it ends with .pbtxt"),
+      Flag("device", &options.device, "device to measure the ops on"),
+      Flag("num_warmup_runs", &options.num_warmup_runs,
+           "number of runs of each op before measuring it"),
+      Flag("num_runs", &options.num_runs, "number of measured runs of each op"),
+  };
+  const string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc > 1 || graph_file.empty() ||
+      output_file.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+
+  GrapplerItem item;
+  item.id = graph_file;
+  Status status = ReadTextOrBinaryProto(Env::Default(), graph_file,
+                                        &item.graph);
+  if (!status.ok()) {
+    LOG(ERROR) << "Cannot load " << graph_file << ": " << status;
+    return -1;
+  }
+
+  OpPerformanceList op_costs;
+  status = CalibrateOpCosts(item, options, &op_costs);
+  if (!status.ok()) {
+    LOG(ERROR) << "Cannot measure the ops of " << graph_file << ": "
+               << status;
+    return -1;
+  }
+  status = absl::EndsWith(output_file, ".pbtxt")
+               ? WriteTextProto(Env::Default(), output_file, op_costs)
+               : WriteBinaryProto(Env::Default(), output_file, op_costs);
+  if (!status.ok()) {
+    LOG(ERROR) << "Cannot write " << output_file << ": " << status;
+    return -1;
+  }
+  LOG(INFO) << "Wrote the costs of " << op_costs.op_performance_size()
+            << " ops to " << output_file;
+  return 0;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::grappler::ParseFlagsAndCalibrate(argc, argv);
+}
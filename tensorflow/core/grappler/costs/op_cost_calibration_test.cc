@@ -0,0 +1,104 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/costs/measured_op_costs.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+GrapplerItem CreateItem() {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {},
+            {{"dtype", DT_FLOAT}, {"shape", TensorShape({16, 32})}}),
+       NDef("y", "Placeholder", {},
+            {{"dtype", DT_FLOAT}, {"shape", TensorShape({32, 8})}}),
+       NDef("u", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("relu", "Relu", {"x"}, {{"T", DT_FLOAT}}),
+       NDef("relu_1", "Relu", {"relu"}, {{"T", DT_FLOAT}}),
+       NDef("matmul", "MatMul", {"relu_1", "y"}, {{"T", DT_FLOAT}}),
+       NDef("unknown", "Relu", {"u"}, {{"T", DT_FLOAT}})},
+      {});
+  return item;
+}
+
+TEST(OpCostCalibrationTest, CollectOpsToMeasure) {
+  DeviceProperties device;
+  device.set_type("CPU");
+  std::vector<OpInfo> ops;
+  TF_ASSERT_OK(CollectOpsToMeasure(CreateItem(), device, &ops));
+
+  // The Relus of the same shape are measured once, and the Relu of an unknown
+  // shape is not measured.
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].op(), "Relu");
+  EXPECT_EQ(ops[0].device().type(), "CPU");
+  EXPECT_EQ(ops[1].op(), "MatMul");
+  ASSERT_EQ(ops[1].inputs_size(), 2);
+  EXPECT_EQ(ops[1].inputs(1).shape().dim(1).size(), 8);
+}
+
+TEST(OpCostCalibrationTest, CalibrateOpCosts) {
+  OpCostCalibrationOptions options;
+  options.num_warmup_runs = 1;
+  options.num_runs = 3;
+  OpPerformanceList op_costs;
+  TF_ASSERT_OK(CalibrateOpCosts(CreateItem(), options, &op_costs));
+  ASSERT_EQ(op_costs.op_performance_size(), 2);
+
+  MeasuredOpCosts measured_op_costs;
+  measured_op_costs.Add(op_costs);
+  for (const OpPerformance& op_performance : op_costs.op_performance()) {
+    EXPECT_GT(op_performance.compute_cost(), 0);
+    Costs::NanoSeconds time;
+    EXPECT_TRUE(measured_op_costs.Find(op_performance.op(), &time));
+  }
+}
+
+TEST(OpCostCalibrationTest, MeasureOpWithKnownInputValue) {
+  OpInfo op_info;
+  op_info.set_op("Reshape");
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  (*op_info.mutable_attr())["Tshape"].set_type(DT_INT32);
+  auto* tensor = op_info.add_inputs();
+  tensor->set_dtype(DT_FLOAT);
+  TensorShape({4, 6}).AsProto(tensor->mutable_shape());
+  auto* shape = op_info.add_inputs();
+  shape->set_dtype(DT_INT32);
+  shape->mutable_shape()->add_dim()->set_size(2);
+  test::AsTensor<int32>({3, 8}).AsProtoTensorContent(shape->mutable_value());
+
+  OpCostCalibrationOptions options;
+  options.num_warmup_runs = 0;
+  options.num_runs = 1;
+  OpPerformance op_performance;
+  TF_ASSERT_OK(MeasureOpCost(op_info, options, &op_performance));
+  EXPECT_GT(op_performance.compute_cost(), 0);
+  EXPECT_EQ(op_performance.op().op(), "Reshape");
+}
+
+}  // namespace
+}  // end namespace grappler
+}  // end namespace tensorflow
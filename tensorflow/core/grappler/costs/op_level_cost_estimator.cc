@@ -645,6 +645,8 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  measured_op_costs_ = MeasuredOpCosts::FromEnvironment();
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
@@ -654,8 +656,20 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
     if (node_costs.has_costs) {
       return node_costs.costs;
     }
-    // Convert NodeCosts to Costs.
-    if (node_costs.minimum_cost_op) {
+    // Prefer the measured execution time of the op, if any.
+    Costs::NanoSeconds measured_time;
+    const bool has_measured_time =
+        measured_op_costs_ != nullptr &&
+        measured_op_costs_->Find(op_context.op_info, &measured_time);
+    if (has_measured_time) {
+      // The measured time covers both the compute and the memory accesses.
+      costs.compute_time = measured_time;
+      costs.execution_time = measured_time;
+      costs.memory_time = 0;
+      costs.intermediate_memory_time = 0;
+      costs.intermediate_memory_read_time = 0;
+      costs.intermediate_memory_write_time = 0;
+    } else if (node_costs.minimum_cost_op) {
       // Override to minimum cost; Note that some ops with minimum cost may have
       // non-typical device (e.g., channel for _Send), which may fail with
       // GetDeviceInfo(), called from PredictOpCountBasedCost(). Make sure we
@@ -679,7 +693,7 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
     costs.max_memory = node_costs.max_memory;
     costs.persistent_memory = node_costs.persistent_memory;
     costs.temporary_memory = node_costs.temporary_memory;
-    costs.inaccurate = node_costs.inaccurate;
+    costs.inaccurate = node_costs.inaccurate && !has_measured_time;
     costs.num_ops_with_unknown_shapes =
         node_costs.num_nodes_with_unknown_shapes;
     costs.num_ops_total = node_costs.num_nodes;
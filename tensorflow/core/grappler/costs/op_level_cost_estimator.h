@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 
+#include <memory>
 #include <numeric>
 
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measured_op_costs.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -98,6 +100,15 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Predicts the execution time of the ops covered by `measured_op_costs`
+  // from these measurements rather than the analytical cost model. By default,
+  // the table named by the TF_GRAPPLER_MEASURED_OP_COSTS environment variable
+  // is used, if any.
+  void SetMeasuredOpCosts(
+      std::shared_ptr<const MeasuredOpCosts> measured_op_costs) {
+    measured_op_costs_ = std::move(measured_op_costs);
+  }
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -320,6 +331,7 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  std::shared_ptr<const MeasuredOpCosts> measured_op_costs_;
 
  private:
   friend class OpLevelCostEstimatorTest;
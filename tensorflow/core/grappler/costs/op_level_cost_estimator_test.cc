@@ -2310,5 +2310,34 @@ TEST_F(OpLevelCostEstimatorTest, CropAndResizeExecutionTime) {
   }
 }
 
+TEST_F(OpLevelCostEstimatorTest, PrefersMeasuredCosts) {
+  auto measured_op_costs = std::make_shared<MeasuredOpCosts>();
+  OpPerformance op_performance;
+  *op_performance.mutable_op() = DescribeMatMul(64, 64, 64, 64).op_info;
+  op_performance.set_compute_cost(1000);
+  measured_op_costs->Add(op_performance);
+  estimator_.SetMeasuredOpCosts(measured_op_costs);
+
+  {
+    const auto cost = PredictCosts(DescribeMatMul(64, 64, 64, 64));
+    EXPECT_EQ(cost.execution_time, Costs::Duration(1000));
+    EXPECT_EQ(cost.compute_time, Costs::Duration(1000));
+    EXPECT_EQ(cost.memory_time, Costs::Duration(0));
+    EXPECT_FALSE(cost.inaccurate);
+  }
+  {
+    // The same bucket, with 3/4 of the input size.
+    const auto cost = PredictCosts(DescribeMatMul(48, 64, 64, 48));
+    EXPECT_EQ(cost.execution_time, Costs::Duration(750));
+  }
+  {
+    // Shapes outside of the measured bucket use the analytical estimate.
+    const auto cost = PredictCosts(DescribeMatMul(128, 64, 64, 128));
+    EXPECT_GT(cost.memory_time, Costs::Duration(0));
+    EXPECT_EQ(cost.execution_time, cost.compute_time + cost.memory_time);
+  }
+  estimator_.SetMeasuredOpCosts(nullptr);
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -973,7 +974,8 @@ class AutoMixedPrecisionImpl {
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
                          GraphDef* graph, string id,
-                         AutoMixedPrecisionMode mode)
+                         AutoMixedPrecisionMode mode,
+                         const GraphProperties* properties)
       : virtual_placer_(cluster->GetDevices()),
         nodes_to_preserve_(nodes_to_preserve),
         graph_(graph),
@@ -983,6 +985,7 @@ class AutoMixedPrecisionImpl {
         cuda_version_(GetCudaVersion(*cluster)),
         cudnn_version_(GetCudnnVersion(*cluster)),
         mode_(mode),
+        properties_(properties),
         target_dtype_(mode_ == AutoMixedPrecisionMode::CUDA ? DT_HALF
                                                             : DT_BFLOAT16) {}
 
@@ -1022,6 +1025,7 @@ class AutoMixedPrecisionImpl {
       std::vector<NodeTypeIdEdge>* implicit_data_edges) const;
   void AddAllowlistOps(absl::flat_hash_set<int>* allow_set) const;
   void RemoveAllowsetWithFp32(absl::flat_hash_set<int>* allow_set) const;
+  void RemoveAllowsetWithoutSpeedup(absl::flat_hash_set<int>* allow_set) const;
   void PropagateDenyFwdThroughClearAndInfer(
       absl::flat_hash_set<int>* deny_set) const;
   void ForceColorMatchBetweenTensorListOps(
@@ -1058,6 +1062,9 @@ class AutoMixedPrecisionImpl {
   gtl::FlatSet<string> f16_inferlist_;
   gtl::FlatSet<string> f16_clearlist_;
   absl::flat_hash_set<const NodeDef*> should_process_nodes_;
+  // The statically inferred shapes of the input graph, used by the cost model
+  // of the MKL mode. May be null.
+  const GraphProperties* properties_;
   DataType target_dtype_;  // Either DT_HALF or DT_BFLOAT16
 };
 
@@ -1279,6 +1286,76 @@ bool ShouldIgnorePerformance() {
   return is_enabled;
 }
 
+// The minimum number of floating point operations that a bfloat16 region must
+// save per element it casts at its boundaries for the rewrite to pay off on
+// the CPU. Casts are memory bound, and cost a read of the float32 tensor and a
+// write of the bfloat16 one, which is amortized by the faster bfloat16 compute
+// (e.g. with AMX or AVX512_BF16) only for regions of large enough matmuls and
+// convolutions. Zero disables the check.
+int64_t MinFlopsPerCastElement() {
+  static int64_t min_flops = [] {
+    int64_t ret = 0;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_MKL_MIN_FLOPS_PER_CAST_ELEMENT",
+        /*default_val=*/16, &ret));
+    return ret;
+  }();
+  return min_flops;
+}
+
+// Returns the number of elements of the tensor, or -1 if its shape isn't fully
+// known.
+int64_t NumElements(const OpInfo::TensorProperties& tensor) {
+  return PartialTensorShape(tensor.shape()).num_elements();
+}
+
+// Returns the number of elements of the output of the node, or -1 if unknown.
+int64_t NumOutputElements(const GraphProperties& properties,
+                          const NodeDef& node, int port) {
+  if (!properties.HasOutputProperties(node.name())) return -1;
+  const auto& outputs = properties.GetOutputProperties(node.name());
+  if (port < 0 || port >= outputs.size()) return -1;
+  return NumElements(outputs[port]);
+}
+
+bool GetBoolAttr(const NodeDef& node, const string& name) {
+  auto it = node.attr().find(name);
+  return it != node.attr().end() && it->second.b();
+}
+
+// Estimates the floating point operations of a matmul or forward convolution
+// node, as twice the product of its output size and its reduction size.
+// Returns -1 for other ops, or when the shapes aren't known.
+int64_t EstimateFlops(const GraphProperties& properties, const NodeDef& node) {
+  const int64_t output_elements = NumOutputElements(properties, node, 0);
+  if (output_elements < 0 || !properties.HasInputProperties(node.name())) {
+    return -1;
+  }
+  const auto& inputs = properties.GetInputProperties(node.name());
+  if (inputs.size() < 2) return -1;
+  const PartialTensorShape a(inputs[0].shape());
+  const PartialTensorShape b(inputs[1].shape());
+  const int rank = a.dims();
+  int64_t reduction = -1;
+  if (node.op() == "MatMul" && rank == 2) {
+    reduction = a.dim_size(GetBoolAttr(node, "transpose_a") ? 0 : 1);
+  } else if ((node.op() == "BatchMatMul" || node.op() == "BatchMatMulV2") &&
+             rank >= 2) {
+    reduction = a.dim_size(GetBoolAttr(node, "adj_x") ? rank - 2 : rank - 1);
+  } else if ((node.op() == "Conv2D" || node.op() == "Conv3D") &&
+             b.dims() > 0 && b.IsFullyDefined()) {
+    // The filter is [spatial..., in_channels, out_channels].
+    reduction = b.num_elements() / b.dim_size(b.dims() - 1);
+  } else if (node.op() == "DepthwiseConv2dNative" && b.dims() == 4 &&
+             b.IsFullyDefined()) {
+    // The filter is [height, width, in_channels, channel_multiplier], and
+    // each output channel reduces over a single input channel.
+    reduction = b.dim_size(0) * b.dim_size(1);
+  }
+  if (reduction < 0) return -1;
+  return 2 * output_elements * reduction;
+}
+
 Status AutoMixedPrecisionImpl::Optimize() {
   string optimization_level;
   TF_RETURN_IF_ERROR(ReadStringFromEnvVar(
@@ -1413,6 +1490,14 @@ Status AutoMixedPrecisionImpl::Optimize() {
   RemoveAllowsetWithFp32(&allow_set);
   VLOG(2) << "Finished pass 5";
 
+  if (mode_ == AutoMixedPrecisionMode::MKL && properties_ != nullptr &&
+      MinFlopsPerCastElement() > 0) {
+    VLOG(2) << "Beginning pass 6 to remove allow regions whose casts cost "
+               "more than their speedup";
+    RemoveAllowsetWithoutSpeedup(&allow_set);
+    VLOG(2) << "Finished pass 6";
+  }
+
   VLOG(2) << "Forcing color match between data structure ops";
   for (const auto& cluster : tensor_list_clusters) {
     ForceColorMatchBetweenTensorListOps(cluster, &allow_set, &deny_set);
@@ -1751,6 +1836,111 @@ void AutoMixedPrecisionImpl::RemoveAllowsetWithFp32(
   }
 }
 
+// Removes the connected regions of allow nodes whose estimated compute savings
+// don't cover the Casts that would be inserted at their boundaries. Only the
+// matmuls and forward convolutions are costed; a region containing any other
+// allowlist op, or any tensor of unknown size, is assumed to be worth it.
+void AutoMixedPrecisionImpl::RemoveAllowsetWithoutSpeedup(
+    absl::flat_hash_set<int>* allow_set) const {
+  // Label the connected regions of the allow set.
+  absl::flat_hash_map<int, int> region_of;
+  int num_regions = 0;
+  for (int root_idx : *allow_set) {
+    if (region_of.count(root_idx)) continue;
+    const int region = num_regions++;
+    std::vector<int> stack = {root_idx};
+    region_of[root_idx] = region;
+    while (!stack.empty()) {
+      const int idx = stack.back();
+      stack.pop_back();
+      auto visit = [&](int neighbor) {
+        if (allow_set->count(neighbor) &&
+            region_of.emplace(neighbor, region).second) {
+          stack.push_back(neighbor);
+        }
+      };
+      for (int fanin : graph_type_view_.GetFanin(idx)) visit(fanin);
+      for (int fanout : graph_type_view_.GetFanout(idx)) visit(fanout);
+    }
+  }
+
+  struct RegionCost {
+    int64_t flops = 0;
+    int64_t cast_elements = 0;
+    bool has_allowlist_op = false;
+    bool unknown = false;
+  };
+  std::vector<RegionCost> costs(num_regions);
+  for (const auto& it : region_of) {
+    const NodeDef& node = *graph_type_view_.GetNode(it.first)->node;
+    if (!f16_allowlist_.count(node.op())) continue;
+    RegionCost& cost = costs[it.second];
+    cost.has_allowlist_op = true;
+    const int64_t flops = EstimateFlops(*properties_, node);
+    if (flops < 0) {
+      cost.unknown = true;
+    } else {
+      cost.flops += flops;
+    }
+  }
+
+  // Count the elements of the fp32 outputs that would be cast into or out of
+  // each region, with one Cast per output and direction like
+  // ChangeTypeAttrsAndAddCasts. Casts of constants are folded away.
+  for (int src_idx = 0; src_idx < graph_type_view_.num_nodes(); ++src_idx) {
+    const NodeTypeId& src_type = *graph_type_view_.GetNode(src_idx);
+    if (!IsFloat32(src_type)) continue;
+    auto src_it = region_of.find(src_idx);
+    const int src_region = src_it == region_of.end() ? -1 : src_it->second;
+    for (int port :
+         node_type_map_.GetOutputPorts(*src_type.node, src_type.type_attr)) {
+      GraphView::OutputPort src(src_type.node, port);
+      absl::flat_hash_set<int> cast_regions;
+      for (const auto& dst : graph_view_.GetFanout(src)) {
+        const absl::optional<int> maybe_dst_type_idx =
+            graph_type_view_.GetNodeIndex(
+                dst.node->name(),
+                node_type_map_.GetInputTypeAttr(*dst.node, dst.port_id));
+        if (!maybe_dst_type_idx.has_value()) continue;
+        auto dst_it = region_of.find(maybe_dst_type_idx.value());
+        if (src_region >= 0 && dst_it == region_of.end()) {
+          cast_regions.insert(src_region);
+        } else if (src_region < 0 && dst_it != region_of.end() &&
+                   !IsConstant(*src_type.node)) {
+          cast_regions.insert(dst_it->second);
+        }
+      }
+      if (cast_regions.empty()) continue;
+      const int64_t elements =
+          NumOutputElements(*properties_, *src_type.node, port);
+      for (int region : cast_regions) {
+        if (elements < 0) {
+          costs[region].unknown = true;
+        } else {
+          costs[region].cast_elements += elements;
+        }
+      }
+    }
+  }
+
+  const int64_t min_flops_per_cast_element = MinFlopsPerCastElement();
+  for (auto it = region_of.begin(); it != region_of.end(); ++it) {
+    const RegionCost& cost = costs[it->second];
+    if (!cost.has_allowlist_op || cost.unknown ||
+        cost.flops >= min_flops_per_cast_element * cost.cast_elements) {
+      continue;
+    }
+    allow_set->erase(it->first);
+    if (VLOG_IS_ON(2)) {
+      const NodeTypeId& item = *graph_type_view_.GetNode(it->first);
+      VLOG(2) << "UnPainting type " << item.type_attr.DebugString()
+              << " of node " << item.node->name() << " ALLOW because its "
+              << "region saves " << cost.flops << " flops for "
+              << cost.cast_elements << " cast elements";
+    }
+  }
+}
+
 // Forces NextIteration nodes and their output Merge node(s) to have the same
 // color. Specifically, it removes them all from allow_set if any of the Merge
 // nodes is not in allow_set, otherwise it adds the NextIteration node to
@@ -2039,9 +2229,23 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
     return Status::OK();
   }
 
+  // The bfloat16 rewrite on the CPU is weighed against the cost of its casts,
+  // which needs the tensor shapes.
+  std::unique_ptr<GraphProperties> properties;
+  if (mode_ == AutoMixedPrecisionMode::MKL) {
+    properties = std::make_unique<GraphProperties>(item);
+    Status shapes_status =
+        properties->InferStatically(/*assume_valid_feeds=*/false);
+    if (!shapes_status.ok()) {
+      VLOG(1) << "Shape inference failed, not costing casts: "
+              << shapes_status.ToString();
+      properties.reset();
+    }
+  }
+
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id, mode_);
+                                   item.id, mode_, properties.get());
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
@@ -1368,6 +1368,33 @@ TEST_F(AutoMixedPrecisionMklTest, TensorListSetGet) {
   }
 }
 
+TEST_F(AutoMixedPrecisionMklTest, SkipCastsWithoutSpeedup) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  Output input1 = ops::Const(s.WithOpName("input1"), 1.f / 4, {64, 4});
+  Output input2 = ops::Const(s.WithOpName("input2"), 1.f / 4, {4, 4});
+  Output deny1 = ops::Exp(s.WithOpName("deny1"), input1);
+  Output deny2 = ops::Exp(s.WithOpName("deny2"), input2);
+  // A matmul with a reduction over 4 elements saves too little compute to pay
+  // for casting its inputs and output.
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), deny1, deny2);
+  Output deny3 = ops::Log(s.WithOpName("deny3"), allow1);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), deny3);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::MKL};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  EXPECT_EQ(output.node_size(), item.graph.node_size());
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_FLOAT);
+}
+
 #endif  // INTEL_MKL
 
 }  // namespace
@@ -15,23 +15,171 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/transitive_fanin.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 namespace grappler {
 const char kAutoParallelPrefix[] = "AutoParallel";
 
+namespace {
+
+int Rank(const OpInfo::TensorProperties& tensor) {
+  return tensor.shape().unknown_rank() ? -1 : tensor.shape().dim_size();
+}
+
+// Returns true if the unbatched `tensor` broadcasts against the sub-batches
+// of a batched tensor of rank `batched_rank` as it does against the batch.
+bool BroadcastsAcrossBatch(const OpInfo::TensorProperties& tensor,
+                           int batched_rank) {
+  const int rank = Rank(tensor);
+  if (rank < 0 || batched_rank < 0) return false;
+  return rank < batched_rank ||
+         (rank == batched_rank && tensor.shape().dim(0).size() == 1);
+}
+
+// Returns true if reshaping the batched `tensor` to `shape` reshapes each of
+// its examples separately.
+bool ReshapesEachExample(const OpInfo::TensorProperties& tensor,
+                         const OpInfo::TensorProperties& shape) {
+  if (Rank(tensor) < 1 || !shape.has_value()) return false;
+  int64_t example_size = 1;
+  for (int i = 1; i < tensor.shape().dim_size(); ++i) {
+    if (tensor.shape().dim(i).size() < 0) return false;
+    example_size *= tensor.shape().dim(i).size();
+  }
+  Tensor new_shape;
+  if (!new_shape.FromProto(shape.value()) || new_shape.dims() != 1 ||
+      new_shape.NumElements() < 1) {
+    return false;
+  }
+  std::vector<int64_t> dims;
+  for (int i = 0; i < new_shape.NumElements(); ++i) {
+    dims.push_back(new_shape.dtype() == DT_INT32
+                       ? new_shape.vec<int32>()(i)
+                       : new_shape.vec<int64_t>()(i));
+  }
+  if (dims[0] != -1) return false;
+  int64_t new_example_size = 1;
+  for (int i = 1; i < dims.size(); ++i) {
+    if (dims[i] < 0) return false;
+    new_example_size *= dims[i];
+  }
+  return new_example_size == example_size;
+}
+
+// Returns true if `node` computes the examples of its batched inputs
+// independently, so that running it on sub-batches split from dimension 0 of
+// these inputs yields the sub-batches of its output. `batched_inputs` tells
+// which regular inputs of the node are batched.
+bool IsBatchSeparable(const NodeDef& node,
+                      const std::vector<bool>& batched_inputs,
+                      const GraphProperties& properties) {
+  if (IsStateful(node) || IsControlFlow(node)) return false;
+  const auto& inputs = properties.GetInputProperties(node.name());
+  if (batched_inputs.empty() || inputs.size() != batched_inputs.size()) {
+    return false;
+  }
+  const int num_batched =
+      std::count(batched_inputs.begin(), batched_inputs.end(), true);
+  // Most ops take the examples in their first input, and e.g. weights in the
+  // other ones.
+  const bool only_first_batched = batched_inputs[0] && num_batched == 1;
+
+  if (IsUnaryElementWise(node) || IsCast(node) || IsLeakyRelu(node)) {
+    return only_first_batched;
+  }
+  if (IsSoftmax(node) || node.op() == "LogSoftmax") {
+    return only_first_batched && Rank(inputs[0]) >= 2;
+  }
+  if (IsMatMul(node)) {
+    bool transpose_a = true;
+    return only_first_batched &&
+           TryGetNodeAttr(node, "transpose_a", &transpose_a) && !transpose_a;
+  }
+  if (IsConv2D(node) || IsDepthwiseConv2dNative(node) || IsBiasAdd(node) ||
+      node.op() == "MaxPool" || node.op() == "AvgPool") {
+    return only_first_batched;
+  }
+  if (IsFusedBatchNorm(node)) {
+    bool is_training = true;
+    return only_first_batched &&
+           TryGetNodeAttr(node, "is_training", &is_training) && !is_training;
+  }
+  if (IsReshape(node)) {
+    return only_first_batched && ReshapesEachExample(inputs[0], inputs[1]);
+  }
+  if (IsAdd(node) || IsSub(node) || IsMul(node) || IsRealDiv(node) ||
+      IsMaximum(node) || IsMinimum(node) || IsSquaredDifference(node)) {
+    int batched_rank = -1;
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (batched_inputs[i]) {
+        batched_rank = std::max(batched_rank, Rank(inputs[i]));
+      }
+    }
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (batched_inputs[i] ? Rank(inputs[i]) != batched_rank
+                            : !BroadcastsAcrossBatch(inputs[i], batched_rank)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+Tensor Int32Vector(const std::vector<int32>& values) {
+  Tensor tensor(DT_INT32, TensorShape({static_cast<int64_t>(values.size())}));
+  std::copy(values.begin(), values.end(), tensor.vec<int32>().data());
+  return tensor;
+}
+
+NodeDef* AddConstNode(const string& name, const Tensor& value,
+                      const string& device, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(device);
+  (*node->mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+NodeDef* AddInt32Node(const string& name, const string& op,
+                      const std::vector<string>& inputs, const string& device,
+                      GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  node->set_device(device);
+  for (const string& input : inputs) node->add_input(input);
+  (*node->mutable_attr())["T"].set_type(DT_INT32);
+  return node;
+}
+
+}  // namespace
+
 NodeDef* AutoParallel::AddNodeDivConst() {
   NodeDef* node = graph_.add_node();
   node->set_name(strings::StrCat(kAutoParallelPrefix, "-Div-Const"));
@@ -263,8 +411,214 @@ void AutoParallel::BuildGraph(GraphDef* graph) {
   LOG(INFO) << "Parallelized graph size: " << graph->node_size();
 }
 
+Status AutoParallel::OptimizeInference(const GrapplerItem& item,
+                                       GraphDef* output) const {
+  if (item.fetch.empty()) {
+    return errors::InvalidArgument("No fetch nodes provided.");
+  }
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : item.graph.node()) {
+    nodes.emplace(node.name(), &node);
+  }
+
+  // Split the fed placeholders whose first dimension is the dynamic batch
+  // size. The other feeds, e.g. hyperparameters, are shared by the replicas.
+  std::vector<const NodeDef*> split_feeds;
+  std::set<string> batched_nodes;
+  for (const auto& feed : item.feed) {
+    auto it = nodes.find(NodeName(feed.first));
+    if (it == nodes.end() || !IsPlaceholder(*it->second) ||
+        batched_nodes.count(it->first) > 0) {
+      continue;
+    }
+    PartialTensorShape shape;
+    if (GetNodeAttr(*it->second, "shape", &shape).ok() && shape.dims() >= 1 &&
+        shape.dim_size(0) < 0) {
+      split_feeds.push_back(it->second);
+      batched_nodes.insert(it->first);
+    }
+  }
+  if (split_feeds.empty()) {
+    return errors::Aborted("No feed has a dynamic batch dimension.");
+  }
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(/*assume_valid_feeds=*/true));
+
+  std::vector<const NodeDef*> fanin;
+  TF_RETURN_IF_ERROR(ComputeTransitiveFanin(item.graph, item.fetch, &fanin));
+  std::set<string> fanin_nodes;
+  for (const NodeDef* node : fanin) fanin_nodes.insert(node->name());
+
+  // The nodes computing the fetches from the split feeds are batched, and
+  // replicated. The other nodes are shared by the replicas.
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item.graph, &topo_order));
+  std::vector<const NodeDef*> replica_nodes;
+  for (const NodeDef* node : topo_order) {
+    if (fanin_nodes.count(node->name()) == 0 ||
+        batched_nodes.count(node->name()) > 0) {
+      continue;
+    }
+    std::vector<bool> batched_inputs;
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) break;
+      batched_inputs.push_back(batched_nodes.count(NodeName(input)) > 0);
+    }
+    if (std::find(batched_inputs.begin(), batched_inputs.end(), true) ==
+        batched_inputs.end()) {
+      continue;
+    }
+    if (!IsBatchSeparable(*node, batched_inputs, properties)) {
+      return errors::Aborted("Cannot split the batch of ", node->name(), " (",
+                             node->op(), ").");
+    }
+    batched_nodes.insert(node->name());
+    replica_nodes.push_back(node);
+  }
+
+  // The batched fetch nodes are replaced by the concatenation of their
+  // replicas, which only works for their first output.
+  std::map<string, DataType> batched_fetches;
+  for (const string& fetch : item.fetch) {
+    const TensorId id = ParseTensorName(fetch);
+    const string node_name(id.node());
+    if (batched_nodes.count(node_name) == 0) continue;
+    const NodeDef& node = *nodes[node_name];
+    if (id.index() > 0 || IsPlaceholder(node)) {
+      return errors::Aborted("Cannot concatenate the batch of fetch ", fetch,
+                             ".");
+    }
+    const OpDef* op_def = nullptr;
+    DataType type;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+    TF_RETURN_IF_ERROR(OutputTypeForNode(node, *op_def, 0, &type));
+    batched_fetches.emplace(node_name, type);
+  }
+  if (batched_fetches.empty()) {
+    return errors::Aborted("No fetch depends on a batched feed.");
+  }
+  for (const NodeDef& node : item.graph.node()) {
+    for (const string& input : node.input()) {
+      const TensorId id = ParseTensorName(input);
+      if (id.index() > 0 && batched_fetches.count(string(id.node())) > 0) {
+        return errors::Aborted("Cannot concatenate the batch of fetch ",
+                               id.node(), ", whose output ", id.index(),
+                               " is used.");
+      }
+    }
+  }
+  VLOG(1) << "Splitting the batch of " << split_feeds.size() << " feeds into "
+          << num_replicas_ << " replicas of " << replica_nodes.size()
+          << " nodes.";
+
+  *output = item.graph;
+  output->clear_node();
+  for (const NodeDef& node : item.graph.node()) {
+    if (batched_fetches.count(node.name()) == 0) *output->add_node() = node;
+  }
+
+  // Replica i gets the examples [(i * batch_size) / num_replicas,
+  // ((i + 1) * batch_size) / num_replicas) of each split feed.
+  auto prefixed = [](const string& name) {
+    return strings::StrCat(kAutoParallelPrefix, "-", name);
+  };
+  const NodeDef& first_feed = *split_feeds[0];
+  const string& device = first_feed.device();
+  NodeDef* shape = output->add_node();
+  shape->set_name(prefixed("BatchShape"));
+  shape->set_op("Shape");
+  shape->set_device(device);
+  shape->add_input(first_feed.name());
+  (*shape->mutable_attr())["T"].set_type(first_feed.attr().at("dtype").type());
+  (*shape->mutable_attr())["out_type"].set_type(DT_INT32);
+  AddConstNode(prefixed("Zero"), Int32Vector({0}), device, output);
+  AddConstNode(prefixed("One"), Int32Vector({1}), device, output);
+  NodeDef* batch_size = AddInt32Node(
+      prefixed("BatchSize"), "StridedSlice",
+      {shape->name(), prefixed("Zero"), prefixed("One"), prefixed("One")},
+      device, output);
+  (*batch_size->mutable_attr())["Index"].set_type(DT_INT32);
+  (*batch_size->mutable_attr())["shrink_axis_mask"].set_i(1);
+  std::vector<int32> replicas(num_replicas_ + 1);
+  std::iota(replicas.begin(), replicas.end(), 0);
+  AddConstNode(prefixed("ReplicaBegins"),
+               Int32Vector({replicas.begin(), replicas.end() - 1}), device,
+               output);
+  AddConstNode(prefixed("ReplicaEnds"),
+               Int32Vector({replicas.begin() + 1, replicas.end()}), device,
+               output);
+  AddConstNode(prefixed("NumReplicas"), Tensor(num_replicas_), device, output);
+  for (const char* bound : {"Begins", "Ends"}) {
+    const string scaled = prefixed(strings::StrCat("Scaled", bound));
+    AddInt32Node(
+        scaled, "Mul",
+        {batch_size->name(), prefixed(strings::StrCat("Replica", bound))},
+        device, output);
+    AddInt32Node(prefixed(strings::StrCat("Batch", bound)), "FloorDiv",
+                 {scaled, prefixed("NumReplicas")}, device, output);
+  }
+  AddInt32Node(prefixed("BatchSplits"), "Sub",
+               {prefixed("BatchEnds"), prefixed("BatchBegins")}, device,
+               output);
+  AddConstNode(prefixed("BatchAxis"), Tensor(0), device, output);
+
+  std::map<string, string> split_names;
+  for (const NodeDef* feed : split_feeds) {
+    NodeDef* split = output->add_node();
+    split->set_name(prefixed(strings::StrCat("Split-", feed->name())));
+    split->set_op("SplitV");
+    split->set_device(feed->device());
+    split->add_input(feed->name());
+    split->add_input(prefixed("BatchSplits"));
+    split->add_input(prefixed("BatchAxis"));
+    (*split->mutable_attr())["T"].set_type(feed->attr().at("dtype").type());
+    (*split->mutable_attr())["Tlen"].set_type(DT_INT32);
+    (*split->mutable_attr())["num_split"].set_i(num_replicas_);
+    split_names.emplace(feed->name(), split->name());
+  }
+
+  for (int i = 0; i < num_replicas_; ++i) {
+    const string prefix = prefixed(strings::StrCat("Replica-", i));
+    for (const NodeDef* node : replica_nodes) {
+      NodeDef* replica = output->add_node();
+      *replica = *node;
+      replica->set_name(AddPrefixToNodeName(node->name(), prefix));
+      replica->mutable_attr()->erase("_output_shapes");
+      for (string& input : *replica->mutable_input()) {
+        const string input_node = NodeName(input);
+        auto split = split_names.find(input_node);
+        if (split != split_names.end()) {
+          if (!IsControlInput(input)) {
+            input = strings::StrCat(split->second, ":", i);
+          }
+        } else if (batched_nodes.count(input_node) > 0) {
+          input = AddPrefixToNodeName(input, prefix);
+        }
+      }
+    }
+  }
+
+  for (const auto& fetch : batched_fetches) {
+    NodeDef* concat = output->add_node();
+    concat->set_name(fetch.first);
+    concat->set_op("ConcatV2");
+    concat->set_device(nodes[fetch.first]->device());
+    for (int i = 0; i < num_replicas_; ++i) {
+      concat->add_input(AddPrefixToNodeName(
+          fetch.first, prefixed(strings::StrCat("Replica-", i))));
+    }
+    concat->add_input(prefixed("BatchAxis"));
+    (*concat->mutable_attr())["N"].set_i(num_replicas_);
+    (*concat->mutable_attr())["T"].set_type(fetch.second);
+    (*concat->mutable_attr())["Tidx"].set_type(DT_INT32);
+  }
+  return Status::OK();
+}
+
 Status AutoParallel::Optimize(Cluster* cluster, const GrapplerItem& item,
                               GraphDef* output) {
+  if (inference_) return OptimizeInference(item, output);
   TF_RETURN_IF_ERROR(Initialize(item));
   BuildGraph(output);
   return Status::OK();
@@ -24,9 +24,17 @@ namespace tensorflow {
 namespace grappler {
 
 // Automatically parallelize a graph by splitting in the batch dimension.
+//
+// Training graphs are replicated once per replica, each replica dequeuing its
+// own batch and applying its share of the gradients. For inference graphs,
+// the fed batch is split into sub-batches instead, the subgraph computing the
+// fetches is replicated for each of them and the replica outputs are
+// concatenated, so that large batches run on the inter-op threads in parallel
+// rather than relying on the intra-op parallelism of each kernel.
 class AutoParallel : public GraphOptimizer {
  public:
-  AutoParallel(int num_replicas) : num_replicas_(num_replicas) {
+  AutoParallel(int num_replicas, bool inference = false)
+      : num_replicas_(num_replicas), inference_(inference) {
     CHECK(num_replicas_ >= 2);
   }
   ~AutoParallel() override {}
@@ -46,6 +54,7 @@ class AutoParallel : public GraphOptimizer {
   std::set<string> shared_nodes_;
   const GrapplerItem* item_;
   int num_replicas_;
+  bool inference_;
   int num_gpus_;
   Status Initialize(const GrapplerItem& item);
   NodeDef* AddNodeDivConst();
@@ -57,6 +66,11 @@ class AutoParallel : public GraphOptimizer {
   void AddSharedNodes(GraphDef* graph);
   void AddOneReplica(GraphDef* graph, int number);
   void BuildGraph(GraphDef* graph);
+  // Splits the feeds with a dynamic batch dimension into `num_replicas_`
+  // sub-batches, and replicates the nodes computing the fetches from them.
+  // Aborts unless all these nodes compute the examples of a batch
+  // independently.
+  Status OptimizeInference(const GrapplerItem& item, GraphDef* output) const;
 };
 
 }  // end namespace grappler
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -126,6 +127,71 @@ TEST_F(AutoParallelTest, SimpleParallel) {
   EXPECT_EQ("^AutoParallel-Control-Fetch", node_gradient.input(0));
 }
 
+TEST_F(AutoParallelTest, SplitInferenceBatch) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(
+      s.WithOpName("x"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output weights = ops::Const(s.WithOpName("weights"), 1.0f, {4, 3});
+  Output bias = ops::Const(s.WithOpName("bias"), 1.0f, {3});
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), x, weights);
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+
+  GrapplerItem item;
+  item.fetch.push_back("relu");
+  item.feed.emplace_back("x", Tensor(DT_FLOAT, TensorShape({8, 4})));
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoParallel parallel(2, /*inference=*/true);
+  GraphDef output;
+  TF_EXPECT_OK(parallel.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* split = node_map.GetNode("AutoParallel-Split-x");
+  ASSERT_NE(split, nullptr);
+  EXPECT_EQ("SplitV", split->op());
+  EXPECT_EQ("x", split->input(0));
+  for (int i = 0; i < 2; ++i) {
+    const string prefix = strings::StrCat("AutoParallel-Replica-", i, "/");
+    const NodeDef* replica_matmul = node_map.GetNode(prefix + "matmul");
+    ASSERT_NE(replica_matmul, nullptr);
+    EXPECT_EQ(strings::StrCat("AutoParallel-Split-x:", i),
+              replica_matmul->input(0));
+    EXPECT_EQ("weights", replica_matmul->input(1));
+    const NodeDef* replica_bias_add = node_map.GetNode(prefix + "bias_add");
+    ASSERT_NE(replica_bias_add, nullptr);
+    EXPECT_EQ(prefix + "matmul", replica_bias_add->input(0));
+    EXPECT_EQ("bias", replica_bias_add->input(1));
+    EXPECT_NE(node_map.GetNode(prefix + "relu"), nullptr);
+  }
+  const NodeDef* concat = node_map.GetNode("relu");
+  ASSERT_NE(concat, nullptr);
+  EXPECT_EQ("ConcatV2", concat->op());
+  ASSERT_EQ(3, concat->input_size());
+  EXPECT_EQ("AutoParallel-Replica-0/relu", concat->input(0));
+  EXPECT_EQ("AutoParallel-Replica-1/relu", concat->input(1));
+}
+
+TEST_F(AutoParallelTest, DoNotSplitBatchCoupledInference) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(
+      s.WithOpName("x"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output axis = ops::Const(s.WithOpName("axis"), 0);
+  // The mean over the batch mixes the examples.
+  Output mean = ops::Mean(s.WithOpName("mean"), x, axis);
+
+  GrapplerItem item;
+  item.fetch.push_back("mean");
+  item.feed.emplace_back("x", Tensor(DT_FLOAT, TensorShape({8, 4})));
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoParallel parallel(2, /*inference=*/true);
+  GraphDef output;
+  EXPECT_EQ(error::ABORTED, parallel.Optimize(nullptr, item, &output).code());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
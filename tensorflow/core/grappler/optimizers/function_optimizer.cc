@@ -21,7 +21,9 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/core/common_runtime/device.h"
@@ -1428,6 +1430,198 @@ void RestoreTensorMapping(const FunctionOptimizerContext& ctx,
   }
 }
 
+// -------------------------------------------------------------------------- //
+// Peel function outputs into the caller graph.
+//
+// Function outputs are often forwarded function arguments, or computed by a
+// single Identity, Cast, Transpose or Reshape of an argument, e.g. in exported
+// Keras models. Optimizers
+// that run on the caller graph can't see through the function call, so they
+// miss redundant pairs of such ops on the two sides of the call boundary. When
+// the function is not inlined, we copy these ops into the caller graph, and
+// read the output from the copy instead of the function call node.
+//
+// Example: function f(x) returns Transpose(x, perm) and Square(x)
+//
+//   c = PartitionedCall[f=f](t)        c = PartitionedCall[f=f](t)
+//   a = Transpose(c:0, inv_perm)  ->   p = Transpose(t, perm)
+//   b = Identity(c:1)                  a = Transpose(p, inv_perm)
+//                                      b = Identity(c:1)
+//
+// The now unused function output is pruned by the next function optimizer
+// pass, and the inverse transposes cancel out in the arithmetic optimizer.
+
+bool IsPeelableFunctionOutput(const NodeDef& node) {
+  return IsIdentity(node) || IsCast(node) || IsTranspose(node) ||
+         IsReshape(node);
+}
+
+// Returns the node of the function body with the given `name`, or nullptr.
+const NodeDef* FindFunctionBodyNode(const FunctionDef& func,
+                                    absl::string_view name) {
+  for (const NodeDef& node : func.node_def()) {
+    if (node.name() == name) return &node;
+  }
+  return nullptr;
+}
+
+// Returns the index of the function argument with the given `name`, or -1.
+int FindFunctionArg(const FunctionDef& func, absl::string_view name) {
+  for (int i = 0; i < func.signature().input_arg_size(); ++i) {
+    if (func.signature().input_arg(i).name() == name) return i;
+  }
+  return -1;
+}
+
+bool HasPlaceholderAttrs(const NodeDef& node) {
+  return absl::c_any_of(node.attr(), [](const auto& attr) {
+    return attr.second.value_case() == AttrValue::kPlaceholder;
+  });
+}
+
+// Peeled function output: `op` reads the `arg_index` argument, and its second
+// input is a Const node `constant` for Transpose and Reshape.
+struct PeeledFunctionOutput {
+  int output_index;
+  int arg_index;
+  NodeDef op;
+  const NodeDef* constant;
+};
+
+std::vector<PeeledFunctionOutput> FindPeelableFunctionOutputs(
+    const FunctionDef& func) {
+  std::vector<PeeledFunctionOutput> peeled;
+  const OpDef& signature = func.signature();
+  const auto is_list = [](const OpDef::ArgDef& arg) {
+    return !arg.number_attr().empty() || !arg.type_list_attr().empty();
+  };
+  if (absl::c_any_of(signature.input_arg(), is_list) ||
+      absl::c_any_of(signature.output_arg(), is_list)) {
+    return peeled;
+  }
+
+  for (int i = 0; i < signature.output_arg_size(); ++i) {
+    const auto ret = func.ret().find(signature.output_arg(i).name());
+    if (ret == func.ret().end()) continue;
+    // Function body nodes are referenced as "node:output_arg:index".
+    const std::vector<absl::string_view> ret_tensor =
+        absl::StrSplit(ret->second, ':');
+    // Forwarded function arguments are peeled as an Identity.
+    const int forwarded_arg = FindFunctionArg(func, ret->second);
+    if (forwarded_arg >= 0) {
+      const DataType type = signature.input_arg(forwarded_arg).type();
+      if (type == DT_INVALID) continue;
+      NodeDef identity;
+      identity.set_op("Identity");
+      (*identity.mutable_attr())["T"].set_type(type);
+      peeled.push_back({i, forwarded_arg, std::move(identity), nullptr});
+      continue;
+    }
+    if (ret_tensor.size() != 3 || ret_tensor[2] != "0") continue;
+    const NodeDef* op = FindFunctionBodyNode(func, ret_tensor[0]);
+    if (op == nullptr || !IsPeelableFunctionOutput(*op) ||
+        HasPlaceholderAttrs(*op)) {
+      continue;
+    }
+    const int num_inputs = IsIdentity(*op) || IsCast(*op) ? 1 : 2;
+    if (op->input_size() != num_inputs) continue;
+    const int arg_index = FindFunctionArg(func, op->input(0));
+    if (arg_index < 0) continue;
+
+    const NodeDef* constant = nullptr;
+    if (op->input_size() == 2) {
+      const std::vector<absl::string_view> const_tensor =
+          absl::StrSplit(op->input(1), ':');
+      if (const_tensor.size() != 3 || const_tensor[2] != "0") continue;
+      constant = FindFunctionBodyNode(func, const_tensor[0]);
+      if (constant == nullptr || !IsConstant(*constant) ||
+          constant->input_size() != 0 || HasPlaceholderAttrs(*constant)) {
+        continue;
+      }
+    }
+    peeled.push_back({i, arg_index, *op, constant});
+  }
+  return peeled;
+}
+
+Status PeelFunctionOutputs(const FunctionOptimizerContext& ctx,
+                           GraphDef* optimized_graph) {
+  absl::flat_hash_set<string> node_names;
+  for (const NodeDef& node : optimized_graph->node()) {
+    node_names.insert(node.name());
+  }
+
+  absl::flat_hash_map<SafeTensorId, SafeTensorId, SafeTensorId::Hasher>
+      peeled_tensors;
+  std::vector<NodeDef> peeled_nodes;
+  for (const NodeDef& node : optimized_graph->node()) {
+    const FunctionDef* func = FindFunctionCall(ctx, node);
+    if (func == nullptr || ctx.IsFetchNode(node.name()) ||
+        ctx.IsFeedNode(node.name()) || MarkedForXlaCompilation(node) ||
+        NumNonControlInputs(node) != func->signature().input_arg_size()) {
+      continue;
+    }
+    // Keep the side effects of a stateful function call ordered before the
+    // consumers of its outputs.
+    const bool is_stateful = IsStateful(node, &ctx.function_library());
+
+    for (const PeeledFunctionOutput& output :
+         FindPeelableFunctionOutputs(*func)) {
+      const string peeled_name =
+          absl::StrCat(node.name(), "/peeled_output_", output.output_index);
+      const string constant_name =
+          output.constant == nullptr
+              ? ""
+              : absl::StrCat(peeled_name, "/", output.constant->name());
+      if (node_names.contains(peeled_name) ||
+          node_names.contains(constant_name)) {
+        continue;
+      }
+      const string& arg = node.input(output.arg_index);
+
+      NodeDef peeled = output.op;
+      peeled.set_name(peeled_name);
+      peeled.set_device(node.device());
+      peeled.clear_input();
+      peeled.add_input(arg);
+      if (output.constant != nullptr) {
+        NodeDef constant = *output.constant;
+        constant.set_name(constant_name);
+        constant.set_device(node.device());
+        // Keep the constant in the frame of the function call.
+        *constant.add_input() = AsControlDependency(NodeName(arg));
+        peeled.add_input(constant_name);
+        peeled_nodes.push_back(std::move(constant));
+      }
+      if (is_stateful) *peeled.add_input() = AsControlDependency(node.name());
+      peeled_nodes.push_back(std::move(peeled));
+
+      VLOG(3) << "Peel function output: function=" << func->signature().name()
+              << " output=" << output.output_index
+              << " op=" << output.op.op() << " caller=" << node.name();
+      peeled_tensors.emplace(SafeTensorId(node.name(), output.output_index),
+                             SafeTensorId(peeled_name, 0));
+    }
+  }
+  if (peeled_tensors.empty()) return Status::OK();
+
+  for (NodeDef& node : peeled_nodes) {
+    *optimized_graph->add_node() = std::move(node);
+  }
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    for (int idx = 0; idx < node.input_size(); ++idx) {
+      const TensorId input_tensor = ParseTensorName(node.input(idx));
+      if (input_tensor.index() == Graph::kControlSlot) break;
+
+      auto peeled = peeled_tensors.find(input_tensor);
+      if (peeled != peeled_tensors.end()) {
+        node.set_input(idx, TensorIdToString(peeled->second));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 Status FunctionOptimizer::RunFunctionOptimizerPass(
@@ -1496,6 +1690,9 @@ Status FunctionOptimizer::RunFunctionOptimizerPass(
 
   RestoreTensorMapping(ctx, optimized_graph);
 
+  // Peel function outputs computed by simple ops back into the caller graph.
+  TF_RETURN_IF_ERROR(PeelFunctionOutputs(ctx, optimized_graph));
+
   // Preserve the graph version.
   *optimized_graph->mutable_versions() = item.graph.versions();
   // Prune unreachable function from the library.
@@ -2097,5 +2097,129 @@ TEST_F(FunctionOptimizerTest, PruningUselessLibraryFunctions) {
             "XTimesTwo_specialized_for_y_at_test_graph");
 }
 
+TEST_F(FunctionOptimizerTest, PeelFunctionOutputs) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionOptimizer optimizer(RewriterConfig::DEFAULT, true);
+
+  // MyFunc returns transpose(x), x and square(x).
+  FunctionDef my_func = FDH::Create(
+      "MyFunc", {"x:float"}, {"t:float", "f:float", "s:float"}, {},
+      {{{"perm"}, "Const", {}, {{"dtype", DT_INT32},
+                                {"value", test::AsTensor<int32>({1, 0})}}},
+       {{"transpose"},
+        "Transpose",
+        {"x", "perm:output:0"},
+        {{"T", DT_FLOAT}, {"Tperm", DT_INT32}}},
+       {{"square"}, "Square", {"x"}, {{"T", DT_FLOAT}}}},
+      {{"t", "transpose:y:0"}, {"f", "x"}, {"s", "square:y:0"}});
+  (*my_func.mutable_attr())["_noinline"].set_b(true);
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("fn", "PartitionedCall", {"x"},
+            {{"Tin", DataTypeSlice{DT_FLOAT}},
+             {"Tout", DataTypeSlice{DT_FLOAT, DT_FLOAT, DT_FLOAT}},
+             {"f", FDH::FunctionRef("MyFunc", {})}},
+            kDevice),
+       NDef("t", "Identity", {"fn:0"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("f", "Identity", {"fn:1"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("s", "Identity", {"fn:2"}, {{"T", DT_FLOAT}}, kDevice)},
+      {my_func});
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "fn/peeled_output_0" && ++found) {
+      EXPECT_EQ(node.op(), "Transpose");
+      EXPECT_EQ(node.device(), kDevice);
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "fn/peeled_output_0/perm");
+    } else if (node.name() == "fn/peeled_output_0/perm" && ++found) {
+      EXPECT_EQ(node.op(), "Const");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "^x");
+    } else if (node.name() == "fn/peeled_output_1" && ++found) {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "x");
+    } else if (node.name() == "t" && ++found) {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "fn/peeled_output_0");
+    } else if (node.name() == "f" && ++found) {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "fn/peeled_output_1");
+    } else if (node.name() == "s" && ++found) {
+      // Square stays in the function body.
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "fn:2");
+    }
+  }
+  EXPECT_EQ(found, 6);
+
+  item.fetch = {"t", "f", "s"};
+  item.feed.emplace_back("x", test::AsTensor<float>({1, 2, 3, 4, 5, 6},
+                                                    TensorShape({2, 3})));
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
+TEST_F(FunctionOptimizerTest, PeelStatefulFunctionOutputs) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionOptimizer optimizer(RewriterConfig::DEFAULT, true);
+
+  FunctionDef my_func =
+      FDH::Create("MyFunc", {"x:float"}, {"y:half"}, {},
+                  {{{"cast"},
+                    "Cast",
+                    {"x"},
+                    {{"SrcT", DT_FLOAT}, {"DstT", DT_HALF}}}},
+                  {{"y", "cast:y:0"}});
+  (*my_func.mutable_attr())["_noinline"].set_b(true);
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("fn", "StatefulPartitionedCall", {"x"},
+            {{"Tin", DataTypeSlice{DT_FLOAT}},
+             {"Tout", DataTypeSlice{DT_HALF}},
+             {"f", FDH::FunctionRef("MyFunc", {})}},
+            kDevice),
+       NDef("y", "Identity", {"fn"}, {{"T", DT_HALF}}, kDevice)},
+      {my_func});
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "fn/peeled_output_0" && ++found) {
+      EXPECT_EQ(node.op(), "Cast");
+      // The function call still runs before the consumers of its output.
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "^fn");
+    } else if (node.name() == "y" && ++found) {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "fn/peeled_output_0");
+    }
+  }
+  EXPECT_EQ(found, 2);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -701,6 +702,81 @@ TEST_F(GenericLayoutOptimizerTest, PreserveInputShapes) {
   EXPECT_TRUE(arg->HasAttr("_output_shapes"));
 }
 
+TEST_F(GenericLayoutOptimizerTest, CPUNhwcToNchwConversion) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "The CPU layout conversion only applies without GPUs";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  using test::function::NDef;
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHW);
+
+  Tensor filter = GenerateRandomTensor<DT_FLOAT>({2, 2, 3, 8});
+  GrapplerItem item;
+  item.graph = test::function::GDef({
+      NDef("x", "Placeholder", {},
+           {{"dtype", DT_FLOAT}, {"shape", TensorShape({2, 6, 6, 3})}},
+           "/CPU:0"),
+      NDef("filter", "Const", {}, {{"dtype", DT_FLOAT}, {"value", filter}},
+           "/CPU:0"),
+      NDef("conv", "Conv2D", {"x", "filter"},
+           {{"T", DT_FLOAT},
+            {"data_format", "NHWC"},
+            {"padding", "SAME"},
+            {"strides", gtl::ArraySlice<int>({1, 1, 1, 1})}},
+           "/CPU:0"),
+      NDef("relu", "Relu", {"conv"}, {{"T", DT_FLOAT}}, "/CPU:0"),
+      NDef("pool", "MaxPool", {"relu"},
+           {{"T", DT_FLOAT},
+            {"data_format", "NHWC"},
+            {"padding", "VALID"},
+            {"ksize", gtl::ArraySlice<int>({1, 2, 2, 1})},
+            {"strides", gtl::ArraySlice<int>({1, 2, 2, 1})}},
+           "/CPU:0"),
+      NDef("output", "Identity", {"pool"}, {{"T", DT_FLOAT}}, "/CPU:0"),
+  });
+
+  GraphDef output;
+  Status status = optimizer.Optimize(virtual_cluster_.get(), item, &output);
+  if (!IsMKLEnabled()) {
+    EXPECT_EQ(status.code(), error::ABORTED);
+    return;
+  }
+  TF_ASSERT_OK(status);
+
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("conv");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  auto* pool_node = graph_view.GetNode("pool");
+  ASSERT_NE(pool_node, nullptr);
+  VerifyDataFormatAttributeMatch(pool_node, "NCHW");
+
+  // The layout is only converted at the boundaries of the NCHW region, the
+  // transposes around Relu cancel out.
+  VerifyRegularFaninMatch(conv_node, 0,
+                          "conv-0-TransposeNHWCToNCHW-LayoutOptimizer", 0);
+  auto* relu_node = graph_view.GetNode("relu");
+  ASSERT_NE(relu_node, nullptr);
+  VerifyRegularFaninMatch(relu_node, 0, "conv", 0);
+  VerifyRegularFaninMatch(pool_node, 0, "relu", 0);
+  auto* output_node = graph_view.GetNode("output");
+  ASSERT_NE(output_node, nullptr);
+  VerifyRegularFaninMatch(output_node, 0,
+                          "pool-0-0-TransposeNCHWToNHWC-LayoutOptimizer", 0);
+
+  Tensor x = GenerateRandomTensor<DT_FLOAT>({2, 6, 6, 3});
+  item.fetch = {"output"};
+  item.feed.emplace_back("x", x);
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors.size(), 1);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-4);
+}
+
 // TODO(yanzha): Add more complex Graph for test.
 
 }  // namespace grappler
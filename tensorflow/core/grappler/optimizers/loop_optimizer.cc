@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -714,6 +715,443 @@ Status CheckForDeadFanout(const MutableGraphView& view,
   return Status::OK();
 }
 
+// Unrolls the while loops whose trip count is known statically into straight
+// line graphs, which saves running the Enter, Merge, Switch, NextIteration and
+// Exit nodes and the loop condition in every iteration.
+//
+// Only loops that neither contain nor are nested in other loops, and whose
+// bodies are free of stateful ops, are unrolled. The trip count is found by
+// simulating a loop counter that starts from a constant, is compared against
+// a constant in the loop condition and is incremented by a constant in the
+// loop body.
+class LoopUnroller {
+ public:
+  LoopUnroller(const std::unordered_set<string>& nodes_to_preserve,
+               const absl::flat_hash_set<string>& feed_nodes,
+               int max_trip_count, int max_unrolled_nodes,
+               GraphDef* optimized_graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        feed_nodes_(feed_nodes),
+        max_trip_count_(max_trip_count),
+        max_unrolled_nodes_(max_unrolled_nodes),
+        optimized_graph_(optimized_graph) {}
+
+  Status Optimize();
+
+ private:
+  struct LoopVariable {
+    const NodeDef* enter = nullptr;
+    const NodeDef* merge = nullptr;
+    const NodeDef* switch_node = nullptr;
+    const NodeDef* next_iteration = nullptr;
+    const NodeDef* exit = nullptr;
+  };
+
+  struct Loop {
+    string frame_name;
+    std::vector<const NodeDef*> nodes;
+    const NodeDef* loop_cond = nullptr;
+    std::vector<LoopVariable> variables;
+    // Maps the names of the Merge and Switch nodes to their loop variables.
+    std::unordered_map<string, int> variable_index;
+    absl::flat_hash_set<string> invariant_enters;
+    // The nodes computing the next values of the loop variables, which are
+    // copied into every iteration.
+    std::vector<const NodeDef*> body;
+    absl::flat_hash_set<string> body_names;
+  };
+
+  // Unrolls one of the loops of the graph. Sets `*unrolled` to false if there
+  // is no loop left to unroll.
+  Status UnrollOneLoop(bool* unrolled);
+  // Returns true if the `loop` is a well formed loop with a body that can be
+  // copied, and fills in its loop variables and body.
+  bool AnalyzeLoop(const NodeMap& node_map, Loop* loop) const;
+  // Computes the trip count of the `loop`, or returns false if it is not known
+  // statically or exceeds the limit.
+  bool GetTripCount(const NodeMap& node_map, const Loop& loop,
+                    int* trip_count) const;
+  // Returns the node producing `input` and its output port, looking through
+  // Identity nodes.
+  const NodeDef* SkipIdentities(const NodeMap& node_map, const string& input,
+                                int* port) const;
+  // Returns true if `node` is a constant integer scalar, possibly entered
+  // into the loop as a loop invariant, and sets `*value` to it.
+  bool GetConstantScalar(const NodeMap& node_map, const NodeDef* node,
+                         int64_t* value) const;
+  // Returns the input of the copy of a body node for the given `iteration`,
+  // given the values of the loop variables in this iteration. Returns an
+  // empty string for control inputs that can be dropped.
+  string MapInput(const Loop& loop, const string& input, int iteration,
+                  const std::vector<string>& values) const;
+  string CopyName(const string& name, int iteration) const;
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const absl::flat_hash_set<string>& feed_nodes_;
+  const int max_trip_count_;
+  const int max_unrolled_nodes_;
+  GraphDef* optimized_graph_;
+  // The frames that cannot be unrolled.
+  absl::flat_hash_set<string> skipped_frames_;
+};
+
+Status LoopUnroller::Optimize() {
+  bool unrolled = true;
+  while (unrolled) {
+    TF_RETURN_IF_ERROR(UnrollOneLoop(&unrolled));
+  }
+  return Status::OK();
+}
+
+Status LoopUnroller::UnrollOneLoop(bool* unrolled) {
+  *unrolled = false;
+  FrameView frame_view;
+  TF_RETURN_IF_ERROR(frame_view.InferFromGraph(*optimized_graph_));
+  if (frame_view.num_frames() == 0) return Status::OK();
+
+  std::vector<Loop> loops(frame_view.num_frames());
+  std::vector<bool> is_unrollable(frame_view.num_frames(), true);
+  for (const NodeDef& node : optimized_graph_->node()) {
+    const std::vector<int>& frames = frame_view.Frames(node);
+    if (frames.empty()) continue;
+    // Outer and nested loops are left alone.
+    if (frames.size() > 1) {
+      for (int frame : frames) is_unrollable[frame] = false;
+      continue;
+    }
+    Loop& loop = loops[frames[0]];
+    loop.nodes.push_back(&node);
+    if (IsEnter(node)) {
+      const string& frame_name = node.attr().at("frame_name").s();
+      if (skipped_frames_.contains(frame_name)) {
+        is_unrollable[frames[0]] = false;
+      }
+      loop.frame_name = frame_name;
+    }
+  }
+
+  NodeMap node_map(optimized_graph_);
+  for (int frame = 0; frame < loops.size(); ++frame) {
+    Loop& loop = loops[frame];
+    if (!is_unrollable[frame] || loop.frame_name.empty()) continue;
+    int trip_count;
+    if (!AnalyzeLoop(node_map, &loop) ||
+        !GetTripCount(node_map, loop, &trip_count)) {
+      skipped_frames_.insert(loop.frame_name);
+      continue;
+    }
+    if (static_cast<int64_t>(trip_count) * loop.body.size() >
+        max_unrolled_nodes_) {
+      VLOG(2) << "Loop " << loop.frame_name << " with " << loop.body.size()
+              << " nodes and trip count " << trip_count
+              << " is too large to unroll.";
+      skipped_frames_.insert(loop.frame_name);
+      continue;
+    }
+    VLOG(1) << "Unrolling loop " << loop.frame_name << " with trip count "
+            << trip_count << " and " << loop.body.size() << " nodes.";
+
+    GraphDef unrolled_graph;
+    absl::flat_hash_set<const NodeDef*> loop_nodes(loop.nodes.begin(),
+                                                   loop.nodes.end());
+    for (const NodeDef& node : optimized_graph_->node()) {
+      if (!loop_nodes.contains(&node)) *unrolled_graph.add_node() = node;
+    }
+    std::vector<string> values;
+    for (const LoopVariable& variable : loop.variables) {
+      values.push_back(variable.enter->input(0));
+    }
+    for (int iteration = 0; iteration < trip_count; ++iteration) {
+      for (const NodeDef* node : loop.body) {
+        NodeDef* copy = unrolled_graph.add_node();
+        *copy = *node;
+        copy->set_name(CopyName(node->name(), iteration));
+        copy->clear_input();
+        for (const string& input : node->input()) {
+          string mapped_input = MapInput(loop, input, iteration, values);
+          if (!mapped_input.empty()) copy->add_input(std::move(mapped_input));
+        }
+      }
+      std::vector<string> next_values;
+      for (const LoopVariable& variable : loop.variables) {
+        next_values.push_back(MapInput(
+            loop, variable.next_iteration->input(0), iteration, values));
+      }
+      values = std::move(next_values);
+    }
+    // The Exit nodes forward the final values of the loop variables.
+    for (int i = 0; i < loop.variables.size(); ++i) {
+      const NodeDef* exit = loop.variables[i].exit;
+      if (exit == nullptr) continue;
+      NodeDef* identity = unrolled_graph.add_node();
+      identity->set_name(exit->name());
+      identity->set_op("Identity");
+      identity->set_device(exit->device());
+      identity->add_input(values[i]);
+      (*identity->mutable_attr())["T"] = exit->attr().at("T");
+    }
+    *unrolled_graph.mutable_library() = optimized_graph_->library();
+    *unrolled_graph.mutable_versions() = optimized_graph_->versions();
+    *optimized_graph_ = std::move(unrolled_graph);
+    *unrolled = true;
+    return Status::OK();
+  }
+  return Status::OK();
+}
+
+bool LoopUnroller::AnalyzeLoop(const NodeMap& node_map, Loop* loop) const {
+  absl::flat_hash_set<string> loop_node_names;
+  for (const NodeDef* node : loop->nodes) loop_node_names.insert(node->name());
+  for (const NodeDef* node : loop->nodes) {
+    if (IsMerge(*node)) {
+      if (NumNonControlInputs(*node) != 2) return false;
+      const NodeDef* enter = node_map.GetNode(node->input(0));
+      const NodeDef* next_iteration = node_map.GetNode(node->input(1));
+      if (enter == nullptr || !IsEnter(*enter) || next_iteration == nullptr ||
+          !IsNextIteration(*next_iteration)) {
+        return false;
+      }
+      loop->variable_index[node->name()] = loop->variables.size();
+      LoopVariable variable;
+      variable.enter = enter;
+      variable.merge = node;
+      variable.next_iteration = next_iteration;
+      loop->variables.push_back(variable);
+    } else if (IsLoopCond(*node)) {
+      if (loop->loop_cond != nullptr) return false;
+      loop->loop_cond = node;
+    } else if (IsEnter(*node)) {
+      if (node->attr().at("is_constant").b()) {
+        loop->invariant_enters.insert(node->name());
+      }
+    } else if (!IsSwitch(*node) && !IsExit(*node) && !IsNextIteration(*node) &&
+               (IsControlFlow(*node) || IsStateful(*node))) {
+      return false;
+    }
+    // The outputs of the loop are only observable through its Exit nodes.
+    if (!IsExit(*node)) {
+      if (nodes_to_preserve_.count(node->name()) > 0) return false;
+      for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+        if (!loop_node_names.contains(fanout->name())) return false;
+      }
+    }
+  }
+  if (loop->loop_cond == nullptr || loop->variables.empty()) return false;
+
+  for (const NodeDef* node : loop->nodes) {
+    if (IsSwitch(*node)) {
+      auto it = loop->variable_index.find(NodeName(node->input(0)));
+      if (it == loop->variable_index.end() ||
+          NodeName(node->input(1)) != loop->loop_cond->name() ||
+          loop->variables[it->second].switch_node != nullptr) {
+        return false;
+      }
+      loop->variables[it->second].switch_node = node;
+      loop->variable_index[node->name()] = it->second;
+    }
+  }
+  for (const NodeDef* node : loop->nodes) {
+    if (IsExit(*node)) {
+      const TensorId input = ParseTensorName(node->input(0));
+      auto it = loop->variable_index.find(string(input.node()));
+      if (it == loop->variable_index.end() ||
+          loop->variables[it->second].switch_node == nullptr ||
+          input.node() != loop->variables[it->second].switch_node->name() ||
+          input.index() != 0 || loop->variables[it->second].exit != nullptr) {
+        return false;
+      }
+      loop->variables[it->second].exit = node;
+    }
+  }
+
+  // The body is the fanin of the NextIteration nodes, up to the Switch nodes
+  // and the loop invariants.
+  std::vector<const NodeDef*> stack;
+  for (const LoopVariable& variable : loop->variables) {
+    if (variable.switch_node == nullptr) return false;
+    stack.push_back(variable.next_iteration);
+  }
+  absl::flat_hash_set<const NodeDef*> visited;
+  while (!stack.empty()) {
+    const NodeDef* node = stack.back();
+    stack.pop_back();
+    if (!visited.insert(node).second) continue;
+    for (const string& input : node->input()) {
+      const TensorId id = ParseTensorName(input);
+      const NodeDef* input_node = node_map.GetNode(string(id.node()));
+      if (input_node == nullptr) return false;
+      if (!loop_node_names.contains(input_node->name())) continue;
+      if (IsSwitch(*input_node)) {
+        // The false branch of the Switch only leads to the Exit.
+        if (id.index() == 0) return false;
+        continue;
+      }
+      if (IsMerge(*input_node) || IsLoopCond(*input_node)) {
+        // Control dependencies on these are dropped, the loop always runs
+        // the iterations of the unrolled loop.
+        if (id.index() >= 0) return false;
+        continue;
+      }
+      if (IsEnter(*input_node) || IsNextIteration(*input_node)) {
+        if (!loop->invariant_enters.contains(input_node->name())) return false;
+        continue;
+      }
+      stack.push_back(input_node);
+    }
+    if (!IsNextIteration(*node)) {
+      loop->body.push_back(node);
+      loop->body_names.insert(node->name());
+    }
+  }
+  return true;
+}
+
+const NodeDef* LoopUnroller::SkipIdentities(const NodeMap& node_map,
+                                            const string& input,
+                                            int* port) const {
+  TensorId id = ParseTensorName(input);
+  const NodeDef* node = node_map.GetNode(string(id.node()));
+  while (node != nullptr && IsIdentity(*node) && id.index() == 0) {
+    id = ParseTensorName(node->input(0));
+    node = node_map.GetNode(string(id.node()));
+  }
+  *port = id.index();
+  return node;
+}
+
+bool LoopUnroller::GetConstantScalar(const NodeMap& node_map,
+                                     const NodeDef* node,
+                                     int64_t* value) const {
+  if (node != nullptr && IsEnter(*node) &&
+      node->attr().at("is_constant").b()) {
+    node = node_map.GetNode(node->input(0));
+  }
+  if (node == nullptr || !IsReallyConstant(*node, feed_nodes_)) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node->attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+  } else if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64_t>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool LoopUnroller::GetTripCount(const NodeMap& node_map, const Loop& loop,
+                                int* trip_count) const {
+  const NodeDef* predicate = node_map.GetNode(loop.loop_cond->input(0));
+  if (predicate == nullptr || !IsSimpleBinaryOperator(*predicate) ||
+      NumNonControlInputs(*predicate) != 2) {
+    return false;
+  }
+  // One operand of the predicate is the loop counter, the other one the
+  // limit.
+  int counter_operand = -1;
+  int counter_index = -1;
+  for (int i = 0; i < 2; ++i) {
+    int port;
+    const NodeDef* operand =
+        SkipIdentities(node_map, predicate->input(i), &port);
+    if (operand == nullptr) return false;
+    auto it = loop.variable_index.find(operand->name());
+    if (it != loop.variable_index.end() && IsMerge(*operand) && port == 0) {
+      counter_operand = i;
+      counter_index = it->second;
+    }
+  }
+  if (counter_operand < 0) return false;
+  int port;
+  int64_t limit;
+  if (!GetConstantScalar(
+          node_map,
+          SkipIdentities(node_map, predicate->input(1 - counter_operand),
+                         &port),
+          &limit)) {
+    return false;
+  }
+  const LoopVariable& counter = loop.variables[counter_index];
+  int64_t value;
+  if (!GetConstantScalar(node_map, node_map.GetNode(counter.enter->input(0)),
+                         &value)) {
+    return false;
+  }
+
+  const NodeDef* increment =
+      SkipIdentities(node_map, counter.next_iteration->input(0), &port);
+  if (increment == nullptr || port != 0 ||
+      !(IsAdd(*increment) || IsSub(*increment)) ||
+      NumNonControlInputs(*increment) != 2) {
+    return false;
+  }
+  int64_t step;
+  const NodeDef* lhs = SkipIdentities(node_map, increment->input(0), &port);
+  if (lhs != counter.switch_node || port != 1 ||
+      !GetConstantScalar(
+          node_map, SkipIdentities(node_map, increment->input(1), &port),
+          &step)) {
+    return false;
+  }
+  if (IsSub(*increment)) step = -step;
+
+  auto condition = [&](int64_t counter_value) {
+    const int64_t a = counter_operand == 0 ? counter_value : limit;
+    const int64_t b = counter_operand == 0 ? limit : counter_value;
+    if (IsLess(*predicate)) return a < b;
+    if (IsLessEqual(*predicate)) return a <= b;
+    if (IsGreater(*predicate)) return a > b;
+    if (IsGreaterEqual(*predicate)) return a >= b;
+    return a == b;
+  };
+  *trip_count = 0;
+  while (condition(value)) {
+    if (++*trip_count > max_trip_count_) return false;
+    value += step;
+  }
+  return true;
+}
+
+string LoopUnroller::MapInput(const Loop& loop, const string& input,
+                              int iteration,
+                              const std::vector<string>& values) const {
+  const TensorId id = ParseTensorName(input);
+  const string node_name(id.node());
+  const bool is_control = id.index() < 0;
+  if (loop.body_names.contains(node_name)) {
+    return is_control ? AsControlDependency(CopyName(node_name, iteration))
+                      : TensorId(CopyName(node_name, iteration), id.index())
+                            .ToString();
+  }
+  auto variable = loop.variable_index.find(node_name);
+  if (variable != loop.variable_index.end()) {
+    // The true output of a Switch is the value of its loop variable.
+    const string& value = values[variable->second];
+    if (!is_control) return value;
+    // Control dependencies on the Merge and Switch nodes ordered the node
+    // after the loop variable was computed.
+    return AsControlDependency(NodeName(value));
+  }
+  if (loop.invariant_enters.contains(node_name)) {
+    const NodeDef* enter = nullptr;
+    for (const NodeDef* node : loop.nodes) {
+      if (node->name() == node_name) enter = node;
+    }
+    return is_control ? AsControlDependency(NodeName(enter->input(0)))
+                      : enter->input(0);
+  }
+  if (node_name == loop.loop_cond->name()) return "";
+  return input;
+}
+
+string LoopUnroller::CopyName(const string& name, int iteration) const {
+  return AddPrefixToNodeName(
+      name, StrCat(kLoopOptimizer, "-Unrolled-", iteration));
+}
+
 }  // namespace
 
 LoopOptimizer::LoopOptimizer()
@@ -725,7 +1163,7 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -733,7 +1171,8 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
-      !options_.enable_dead_branch_removal) {
+      !options_.enable_dead_branch_removal &&
+      !options_.enable_loop_unrolling) {
     return errors::Aborted("Nothing to do.");
   }
   *optimized_graph = item.graph;
@@ -754,6 +1193,18 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     TF_RETURN_IF_ERROR(RemoveDeadBranches(item.NodesToPreserve(), node_map,
                                           feed_nodes, optimized_graph));
   }
+  if (options_.enable_loop_unrolling) {
+    absl::flat_hash_set<string> feed_nodes;
+    for (const auto& feed : item.feed) {
+      feed_nodes.insert(NodeName(feed.first));
+    }
+    const std::unordered_set<string> nodes_to_preserve =
+        item.NodesToPreserve();
+    LoopUnroller unroller(nodes_to_preserve, feed_nodes,
+                          options_.max_unrolled_trip_count,
+                          options_.max_unrolled_nodes, optimized_graph);
+    TF_RETURN_IF_ERROR(unroller.Optimize());
+  }
 
   return Status::OK();
 }
@@ -53,9 +53,16 @@ class LoopOptimizer : public GraphOptimizer {
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
+    // Unrolls the loops with a static trip count of at most
+    // max_unrolled_trip_count, as long as the unrolled body has at most
+    // max_unrolled_nodes nodes.
+    bool enable_loop_unrolling = false;
+    int max_unrolled_trip_count = 16;
+    int max_unrolled_nodes = 1000;
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      options.enable_loop_unrolling = opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
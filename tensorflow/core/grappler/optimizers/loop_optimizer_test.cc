@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
@@ -60,6 +61,49 @@ class LoopOptimizerTest : public GrapplerTest {
     AddNode(name, op, inputs, attributes, graph);
   }
 
+  // Adds a loop that counts from `start` to `limit` by `step` and doubles
+  // `Input` in every iteration, with outputs `while/Exit` and `while/Exit_1`.
+  void AddCounterLoop(int start, int limit, int step, GraphDef* graph) const {
+    AddInt32Const("Const", start, {}, graph);
+    AttrValue type;
+    type.set_type(DT_FLOAT);
+    AddNode("Input", "Placeholder", {}, {{"dtype", type}}, graph);
+    AddInt32Node("while/Enter", "Enter", {"Const"}, graph);
+    AddEnterNode("while/Enter_1", "while/while/", false, 1, {"Input"}, graph);
+    AddInt32Node("while/Merge", "Merge", {"while/Enter", "while/NextIteration"},
+                 graph);
+    AddSimpleNode("while/Merge_1", "Merge",
+                  {"while/Enter_1", "while/NextIteration_1"}, graph);
+    AddInt32Const("while/Less/y", limit, {"^while/Merge"}, graph);
+    AddInt32Node("while/Less", "Less", {"while/Merge", "while/Less/y"}, graph);
+    AddNode("while/LoopCond", "LoopCond", {"while/Less"}, {}, graph);
+    AddInt32Node("while/Switch", "Switch", {"while/Merge", "while/LoopCond"},
+                 graph);
+    AddSimpleNode("while/Switch_1", "Switch",
+                  {"while/Merge_1", "while/LoopCond"}, graph);
+    AddInt32Node("while/Identity", "Identity", {"while/Switch:1"}, graph);
+    AddSimpleNode("while/Identity_1", "Identity", {"while/Switch_1:1"},
+                  graph);
+    AddInt32Const("while/add/y", step, {"^while/Identity"}, graph);
+    AddInt32Node("while/add", "AddV2", {"while/Identity", "while/add/y"},
+                 graph);
+    AddSimpleNode("while/add_1", "AddV2",
+                  {"while/Identity_1", "while/Identity_1"}, graph);
+    AddInt32Node("while/NextIteration", "NextIteration", {"while/add"}, graph);
+    AddSimpleNode("while/NextIteration_1", "NextIteration", {"while/add_1"},
+                  graph);
+    AddInt32Node("while/Exit", "Exit", {"while/Switch"}, graph);
+    AddSimpleNode("while/Exit_1", "Exit", {"while/Switch_1"}, graph);
+    for (NodeDef& node : *graph->mutable_node()) {
+      if (node.op() == "Merge") (*node.mutable_attr())["N"].set_i(2);
+      if (node.name() == "while/Enter") {
+        (*node.mutable_attr())["frame_name"].set_s("while/while/");
+        (*node.mutable_attr())["is_constant"].set_b(false);
+        (*node.mutable_attr())["parallel_iterations"].set_i(1);
+      }
+    }
+  }
+
   void EnableOnlyLoopInvariantNodeMotion(LoopOptimizer* optimizer) {
     DisableAllStages(optimizer);
     optimizer->options_.enable_loop_invariant_node_motion = true;
@@ -70,7 +114,28 @@ class LoopOptimizerTest : public GrapplerTest {
     optimizer->options_.enable_stack_push_removal = true;
   }
 
+  void EnableOnlyLoopUnrolling(LoopOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_loop_unrolling = true;
+  }
+
  private:
+  void AddInt32Node(const string& name, const string& op,
+                    const std::vector<string>& inputs, GraphDef* graph) const {
+    AttrValue type;
+    type.set_type(DT_INT32);
+    AddNode(name, op, inputs, {{"T", type}}, graph);
+  }
+
+  void AddInt32Const(const string& name, int value,
+                     const std::vector<string>& inputs, GraphDef* graph) const {
+    AttrValue type;
+    type.set_type(DT_INT32);
+    AttrValue tensor;
+    test::AsScalar<int32>(value).AsProtoTensorContent(tensor.mutable_tensor());
+    AddNode(name, "Const", inputs, {{"dtype", type}, {"value", tensor}}, graph);
+  }
+
   void DisableAllStages(LoopOptimizer* optimizer) {
     LoopOptimizer::LoopOptimizerOptions options;
     options.enable_loop_invariant_node_motion = false;
@@ -1773,5 +1838,55 @@ versions {
   EXPECT_TRUE(found);
 }
 
+TEST_F(LoopOptimizerTest, UnrollLoop) {
+  GrapplerItem item;
+  AddCounterLoop(/*start=*/0, /*limit=*/10, /*step=*/3, &item.graph);
+  item.fetch = {"while/Exit", "while/Exit_1"};
+  Tensor input = test::AsScalar<float>(1.5f);
+  item.feed.emplace_back("Input", input);
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 2);
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopUnrolling(&optimizer);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The loop runs 4 times.
+  int num_copies = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_FALSE(IsControlFlow(node)) << node.DebugString();
+    if (node.op() == "AddV2") ++num_copies;
+    if (node.name() == "while/Exit") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "LoopOptimizer-Unrolled-3/while/add");
+    }
+    if (node.name() == "LoopOptimizer-Unrolled-0/while/Identity_1") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "Input");
+    }
+  }
+  EXPECT_EQ(num_copies, 8);
+
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorEqual<int32>(tensors[0], tensors_expected[0]);
+  test::ExpectTensorEqual<float>(tensors[1], tensors_expected[1]);
+  test::ExpectTensorEqual<float>(tensors[1], test::AsScalar<float>(24.0f));
+}
+
+TEST_F(LoopOptimizerTest, DoNotUnrollLongLoop) {
+  GrapplerItem item;
+  AddCounterLoop(/*start=*/0, /*limit=*/100, /*step=*/1, &item.graph);
+  item.fetch = {"while/Exit", "while/Exit_1"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopUnrolling(&optimizer);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  CompareGraphs(item.graph, output);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -16,10 +16,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <limits>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -440,6 +443,24 @@ void RecomputeSubgraph(
   }
 }
 
+// Duplicates the sub-graphs in `recomputed_subgraphs` of the topologically
+// sorted `graph` and sets up their control dependencies.
+void RecomputeSubgraphs(
+    const std::vector<RecomputedSubGraph>& recomputed_subgraphs,
+    const NodeMap& node_map, GraphDef* graph) {
+  if (recomputed_subgraphs.empty()) return;
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < graph->node().size();
+       ++node_number) {
+    topological_numbering[graph->mutable_node(node_number)] =
+        graph->node().size() - node_number - 1;
+  }
+  for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
+    RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
+                      node_map, topological_numbering, graph);
+  }
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
                                 GraphDef* graph, const GrapplerItem& item) {
@@ -497,19 +518,27 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
         },
         is_target);
   }
-  if (!recomputed_subgraphs.empty()) {
-    std::unordered_map<const NodeDef*, int> topological_numbering;
-    for (int node_number = 0; node_number < graph->node().size();
-         ++node_number) {
-      topological_numbering[graph->mutable_node(node_number)] =
-          graph->node().size() - node_number - 1;
-    }
-    // Duplicate the indicated sub-graphs and set up control dependencies
-    for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
-      RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
-                        node_map, topological_numbering, graph);
-    }
-  }
+  // Duplicate the indicated sub-graphs and set up control dependencies
+  RecomputeSubgraphs(recomputed_subgraphs, node_map, graph);
+}
+
+// Recomputes the nodes in `nodes_to_recompute` for their fanouts in
+// `targets`.
+Status RecomputeNodesForTargets(
+    const std::unordered_set<string>& nodes_to_recompute,
+    const std::unordered_set<string>& targets, GraphDef* graph) {
+  TF_RETURN_IF_ERROR(TopologicalSort(graph));
+  NodeMap node_map(graph);
+  std::vector<RecomputedSubGraph> recomputed_subgraphs = GetOpGroupsToRecompute(
+      graph, node_map,
+      [&nodes_to_recompute](const NodeDef& node) {
+        return nodes_to_recompute.count(node.name()) > 0;
+      },
+      [&targets](const NodeDef& node) {
+        return targets.count(node.name()) > 0;
+      });
+  RecomputeSubgraphs(recomputed_subgraphs, node_map, graph);
+  return Status::OK();
 }
 
 bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
@@ -977,6 +1006,40 @@ struct MemInfo {
   bool operator<(const MemInfo& other) const { return fitness < other.fitness; }
 };
 
+// Runs a step of `item` on a virtual copy of `cluster`, and returns the time
+// at which each op completes and, if `op_run_times` is not null, for how long
+// it runs.
+Status SimulateStep(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::NanoSeconds>* op_completion_times,
+    std::unordered_map<string, Costs::NanoSeconds>* op_run_times) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  TF_RETURN_IF_ERROR(vcluster.Provision());
+  TF_RETURN_IF_ERROR(vcluster.Initialize(item));
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return s;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      Costs::NanoSeconds exec_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.all_start_micros() +
+                              node_stats.op_end_rel_micros());
+      op_completion_times->emplace(node_stats.node_name(), exec_time);
+      if (op_run_times != nullptr) {
+        op_run_times->emplace(
+            node_stats.node_name(),
+            Costs::MicroSeconds(node_stats.op_end_rel_micros() -
+                                node_stats.op_start_rel_micros()));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 static bool IdentifySwappingCandidates(
     Cluster* cluster, GrapplerItem* item,
     std::unique_ptr<GraphMemory>* memory_ptr,
@@ -1012,29 +1075,10 @@ static bool IdentifySwappingCandidates(
     int64_t required_savings = mem_usage.used_memory - prop.memory_size();
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    if (!SimulateStep(cluster, *item, &op_completion_times,
+                      /*op_run_times=*/nullptr)
+             .ok()) {
+      return false;
     }
 
     Costs::Duration peak_time = -1;
@@ -1270,6 +1314,239 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   return updated_graph;
 }
 
+// The ways to free the memory of a tensor that is live at the memory peak,
+// and the step time that each of them costs.
+struct ActivationPlan {
+  string node;
+  int output_id;
+  int64_t memory_used;
+  // The fanouts that run after the peak.
+  std::vector<std::pair<string, int>> late_uses;
+  // The time that the step waits for the tensor to be swapped out and back
+  // in, which is infinite if it cannot be swapped.
+  double swap_cost;
+  // The time it takes to recompute the tensor, which is infinite if it cannot
+  // be recomputed.
+  double recompute_cost;
+
+  double cost() const { return std::min(swap_cost, recompute_cost); }
+};
+
+// Returns whether `node` can run again right before the uses of its output
+// that end at `latest_use`, without keeping any other tensor alive for longer.
+bool IsRecomputable(const MutableGraphView& graph, const NodeDef& node,
+                    const std::unordered_set<string>& feeds,
+                    const std::unordered_map<string, Costs::Duration>&
+                        deallocation_times,
+                    Costs::NanoSeconds latest_use) {
+  if (feeds.count(node.name()) > 0 || IsControlFlow(node) ||
+      !IsFreeOfSideEffect(node) || IsPersistent(node) ||
+      absl::StartsWith(node.name(), kRecomputedNodePrefix)) {
+    return false;
+  }
+  for (const auto& fanin :
+       graph.GetFanins(node, /*include_controlling_nodes=*/false)) {
+    if (IsPersistent(*fanin.node) || IsConstant(*fanin.node)) continue;
+    // The input has to be live until the late uses anyway.
+    auto it = deallocation_times.find(
+        strings::StrCat(fanin.node->name(), ":", fanin.port_id));
+    if (it == deallocation_times.end() || it->second < latest_use) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Simulates a step of `item` and, on each device that runs out of memory,
+// frees the tensors that are live at the memory peak at the least cost in
+// step time. A tensor is either recomputed right before its uses after the
+// peak, swapped to the host in between them, or kept. Recomputations are
+// rewritten right away, swaps are annotated for SwappingPass.
+bool PlanningPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
+                  GrapplerItem* item, std::unordered_set<string>* skip_list) {
+  // Like SwappingPass, assume that we swap over PCIe running at 16 GBps.
+  constexpr double kSwapBytesPerNanosecond = 16;
+
+  if ((*memory_ptr) == nullptr) {
+    memory_ptr->reset(new GraphMemory(*item));
+    Status s = (*memory_ptr)->InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      memory_ptr->reset();
+      VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+      return false;
+    }
+  }
+  const GraphMemory& memory = **memory_ptr;
+
+  std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
+  std::unordered_map<string, Costs::NanoSeconds> op_run_times;
+  bool simulated = false;
+
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+
+  std::unordered_set<string> nodes_to_recompute;
+  std::unordered_set<string> recompute_targets;
+  std::unordered_map<string, std::vector<int>> inputs_to_swap;
+  MutableGraphView graph(&item->graph);
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.type() != "GPU" || prop.memory_size() <= 0) {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= prop.memory_size()) {
+      continue;
+    }
+    int64_t required_savings = mem_usage.used_memory - prop.memory_size();
+
+    if (!simulated) {
+      if (!SimulateStep(cluster, *item, &op_completion_times, &op_run_times)
+               .ok()) {
+        return false;
+      }
+      simulated = true;
+    }
+
+    Costs::Duration peak_time = -1;
+    std::unordered_map<string, Costs::Duration> deallocation_times;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      peak_time = std::max(peak_time, live_tensor.allocation_time);
+      deallocation_times[strings::StrCat(live_tensor.node, ":",
+                                         live_tensor.output_id)] =
+          live_tensor.deallocation_time;
+    }
+
+    std::vector<ActivationPlan> plans;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024 ||
+          skip_list->find(live_tensor.node) != skip_list->end()) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      MutableGraphView::OutputPort port =
+          graph.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      if (port.node == nullptr) continue;
+
+      ActivationPlan plan;
+      plan.node = live_tensor.node;
+      plan.output_id = live_tensor.output_id;
+      plan.memory_used = live_tensor.memory_used;
+      Costs::NanoSeconds earliest_use(Costs::Duration::infinity());
+      Costs::NanoSeconds latest_use(0);
+      bool valid = true;
+      bool swappable = IsSwappable(graph, port);
+      for (MutableGraphView::InputPort input : graph.GetFanout(port)) {
+        auto it = op_completion_times.find(input.node->name());
+        if (it == op_completion_times.end()) {
+          valid = false;
+          break;
+        }
+        if (it->second <= peak_time) {
+          continue;
+        }
+        if (input.port_id < 0 ||
+            skip_list->find(strings::StrCat(input.node->name(), ":",
+                                            input.port_id)) !=
+                skip_list->end()) {
+          valid = false;
+          break;
+        }
+        swappable = swappable && IsSwappable(input);
+        plan.late_uses.emplace_back(input.node->name(), input.port_id);
+        earliest_use = std::min(earliest_use, it->second);
+        latest_use = std::max(latest_use, it->second);
+      }
+      if (!valid || plan.late_uses.empty()) {
+        continue;
+      }
+
+      plan.swap_cost = std::numeric_limits<double>::infinity();
+      if (swappable) {
+        // The swaps are free as long as they overlap with the ops that run
+        // between the allocation and the peak, and between the peak and the
+        // first late use.
+        const double swap_time = plan.memory_used / kSwapBytesPerNanosecond;
+        plan.swap_cost =
+            std::max(0.0, swap_time - (peak_time -
+                                       live_tensor.allocation_time).count()) +
+            std::max(0.0, swap_time - (earliest_use - peak_time).count());
+      }
+      plan.recompute_cost = std::numeric_limits<double>::infinity();
+      auto run_time = op_run_times.find(plan.node);
+      if (run_time != op_run_times.end() &&
+          IsRecomputable(graph, *port.node, feeds, deallocation_times,
+                         latest_use)) {
+        plan.recompute_cost = run_time->second.count();
+      }
+      if (plan.cost() < std::numeric_limits<double>::infinity()) {
+        plans.push_back(std::move(plan));
+      }
+    }
+
+    // Free the tensors that cost the least step time per byte first.
+    std::sort(plans.begin(), plans.end(),
+              [](const ActivationPlan& a, const ActivationPlan& b) {
+                const double a_cost = a.cost() / a.memory_used;
+                const double b_cost = b.cost() / b.memory_used;
+                return a_cost < b_cost ||
+                       (a_cost == b_cost &&
+                        std::tie(a.node, a.output_id) <
+                            std::tie(b.node, b.output_id));
+              });
+    for (const ActivationPlan& plan : plans) {
+      if (required_savings < 0) {
+        break;
+      }
+      if (plan.recompute_cost <= plan.swap_cost) {
+        VLOG(1) << "Will recompute " << plan.node << ":" << plan.output_id
+                << " of size " << plan.memory_used << " in "
+                << plan.recompute_cost << " ns";
+        nodes_to_recompute.insert(plan.node);
+        for (const auto& use : plan.late_uses) {
+          recompute_targets.insert(use.first);
+        }
+      } else {
+        VLOG(1) << "Will swap " << plan.node << ":" << plan.output_id
+                << " of size " << plan.memory_used << " at a cost of "
+                << plan.swap_cost << " ns";
+        for (const auto& use : plan.late_uses) {
+          inputs_to_swap[use.first].push_back(use.second);
+        }
+      }
+      required_savings -= plan.memory_used;
+    }
+  }
+  if (nodes_to_recompute.empty() && inputs_to_swap.empty()) {
+    return false;
+  }
+
+  // Recomputing invalidates the nodes, so the swaps are annotated by name
+  // afterwards.
+  if (!nodes_to_recompute.empty() &&
+      !RecomputeNodesForTargets(nodes_to_recompute, recompute_targets,
+                                &item->graph)
+           .ok()) {
+    return false;
+  }
+  for (NodeDef& node : *item->graph.mutable_node()) {
+    auto it = inputs_to_swap.find(node.name());
+    if (it == inputs_to_swap.end()) continue;
+    AttrValue& swap_to_host = (*node.mutable_attr())["_swap_to_host"];
+    if (swap_to_host.value_case() == AttrValue::kI) {
+      const int64_t input_id = swap_to_host.i();
+      swap_to_host.mutable_list()->add_i(input_id);
+    }
+    for (int input_id : it->second) {
+      swap_to_host.mutable_list()->add_i(input_id);
+    }
+  }
+  return true;
+}
+
 bool CrossesTaskOrCpuGpuBoundary(const NodeDef& node1, const NodeDef& node2) {
   string task1;
   string device1;
@@ -1422,11 +1699,21 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
         }
       }
 
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+      if (optimization_level_ == RewriterConfig::COST_MODEL_HEURISTICS) {
+        if (PlanningPass(cluster, &memory, &optimized_item, &skip_list)) {
+          // Reset the inferred memory usage since the graph changed.
+          memory.reset();
+          updated_graph = true;
+        }
+      }
+
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
       if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
            optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
            optimization_level_ == RewriterConfig::HEURISTICS ||
-           optimization_level_ == RewriterConfig::MANUAL) &&
+           optimization_level_ == RewriterConfig::MANUAL ||
+           optimization_level_ == RewriterConfig::COST_MODEL_HEURISTICS) &&
           cluster != nullptr) {
         if (SwappingPass(optimization_level_, cluster, &memory, &optimized_item,
                          &skip_list)) {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -53,7 +54,16 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -92,6 +102,16 @@ int NumIterations(const RewriterConfig& cfg) {
              : cfg.meta_optimizer_iterations();
 }
 
+// Whether the meta optimizer optimizes the functions of the library in
+// parallel. Off by default: the functions then share the cluster and the CPU
+// device, which the optimizers only read and run kernels on.
+bool ParallelFunctionOptimizationEnabled() {
+  bool enabled = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_GRAPPLER_PARALLEL_FUNCTION_OPTIMIZATION",
+                                 /*default_val=*/false, &enabled));
+  return enabled;
+}
+
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
@@ -132,6 +152,104 @@ bool AutoMixedPrecisionEnabled(RewriterConfig::Toggle opt_level) {
   return false;
 }
 
+// Returns the path of the cached optimized graph for `item`, or an empty
+// string if the cache is disabled. The key covers everything else the meta
+// optimizer reads: the TensorFlow version, the config, the item and the
+// available devices.
+string OptimizedGraphCachePath(const ConfigProto& config,
+                               const GrapplerItem& item,
+                               const Cluster* cluster) {
+  const string& cache_dir =
+      config.graph_options().rewrite_options().meta_optimizer_cache_dir();
+  if (cache_dir.empty()) return "";
+
+  ConfigProto key_config = config;
+  key_config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->clear_meta_optimizer_cache_dir();
+  string serialized_config;
+  string serialized_graph;
+  if (!SerializeToStringDeterministic(key_config, &serialized_config) ||
+      !SerializeToStringDeterministic(item.graph, &serialized_graph)) {
+    return "";
+  }
+
+  string metadata = strings::StrCat(TF_VERSION_STRING, "\n", serialized_config,
+                                    "\n", absl::StrJoin(item.fetch, ","), "\n");
+  for (const auto& feed : item.feed) {
+    absl::StrAppend(&metadata, feed.first, ":", feed.second.dtype(), ":",
+                    feed.second.shape().DebugString(), ",");
+  }
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  absl::StrAppend(&metadata, "\n", absl::StrJoin(item.init_ops, ","), "\n",
+                  absl::StrJoin(item.keep_ops, ","), "\n", item.save_op, ",",
+                  item.restore_op, ",", item.save_restore_loc_tensor, "\n",
+                  options.allow_non_differentiable_rewrites,
+                  options.allow_pruning_stateful_and_dataset_ops,
+                  options.optimize_function_library, options.is_eager_mode,
+                  "\n");
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  absl::StrAppend(&metadata, absl::StrJoin(devices, ","), "\n");
+  if (cluster != nullptr) {
+    std::vector<string> cluster_devices = cluster->GetDeviceNames();
+    std::sort(cluster_devices.begin(), cluster_devices.end());
+    for (const string& device : cluster_devices) {
+      string properties;
+      SerializeToStringDeterministic(cluster->GetDevices().at(device),
+                                     &properties);
+      absl::StrAppend(&metadata, device, ":", properties, ",");
+    }
+  }
+
+  const Fprint128 graph_fingerprint = Fingerprint128(serialized_graph);
+  const Fprint128 metadata_fingerprint = Fingerprint128(metadata);
+  return io::JoinPath(
+      cache_dir,
+      absl::StrCat(absl::Hex(graph_fingerprint.high64, absl::kZeroPad16),
+                   absl::Hex(graph_fingerprint.low64, absl::kZeroPad16),
+                   absl::Hex(metadata_fingerprint.high64, absl::kZeroPad16),
+                   absl::Hex(metadata_fingerprint.low64, absl::kZeroPad16),
+                   ".pb"));
+}
+
+// Reads the optimized graph from the cache. Returns false if it is not there.
+bool LookupOptimizedGraph(const string& path, GraphDef* optimized_graph) {
+  Env* env = Env::Default();
+  bool hit = false;
+  if (env->FileExists(path).ok()) {
+    const Status status = ReadBinaryProto(env, path, optimized_graph);
+    if (status.ok()) {
+      hit = true;
+    } else {
+      LOG(WARNING) << "Ignoring unreadable cached optimized graph " << path
+                   << ": " << status;
+      optimized_graph->Clear();
+    }
+  }
+  VLOG(1) << "Optimized graph cache " << (hit ? "hit" : "miss") << ": "
+          << path;
+  metrics::RecordGrapplerCacheLookup(hit ? "hit" : "miss");
+  return hit;
+}
+
+// Writes the optimized graph to the cache. The graph is written to a
+// temporary file first, so that readers never see a partial graph.
+void StoreOptimizedGraph(const string& path, const GraphDef& optimized_graph) {
+  Env* env = Env::Default();
+  const string tmp_path =
+      strings::StrCat(path, ".tmp.", strings::Hex(random::New64()));
+  Status status = env->RecursivelyCreateDir(string(io::Dirname(path)));
+  if (status.ok()) status = WriteBinaryProto(env, tmp_path, optimized_graph);
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to cache optimized graph " << path << ": "
+                 << status;
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
+
 bool IsXlaGlobalJitOn(
     const OptimizerOptions::GlobalJitLevel& jit_level_in_session_opts) {
   xla_config_registry::XlaGlobalJitLevel xla_global_jit_level =
@@ -228,7 +346,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("arithmetic", "arithmetic_optimization",
          new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", "auto_parallel",
-         new AutoParallel(cfg_.auto_parallel().num_replicas()));
+         new AutoParallel(cfg_.auto_parallel().num_replicas(),
+                          cfg_.auto_parallel().inference()));
   MK_OPT("loop", "loop_optimization",
          new LoopOptimizer(cfg_.loop_optimization(), cpu_device_));
   MK_OPT("dependency", "dependency_optimization",
@@ -254,6 +373,7 @@ MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
   auto global_jit_level =
       cfg.graph_options().optimizer_options().global_jit_level();
   xla_auto_clustering_on_ = IsXlaGlobalJitOn(global_jit_level);
+  parallel_function_optimization_ = ParallelFunctionOptimizationEnabled();
 }
 
 Status MetaOptimizer::InitializeOptimizers(
@@ -363,7 +483,8 @@ Status MetaOptimizer::InitializeOptimizers(
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
     optimizers->push_back(
-        MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas()));
+        MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas(),
+                                 cfg_.auto_parallel().inference()));
   }
 
 #ifndef ENABLE_MKL
@@ -748,7 +869,10 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -889,12 +1013,222 @@ void PropagateTFDataAttrs(const FunctionLibraryDefinition& flib,
   }
 }
 
+Status MetaOptimizer::OptimizeFunctions(
+    Cluster* cluster, const std::vector<const FunctionDef*>& funcs,
+    const absl::flat_hash_set<string>& differentiable_functions, int producer,
+    bool is_tpu_graph, FunctionLibraryDefinition* flib) {
+  const int num_funcs = funcs.size();
+
+  struct FunctionResult {
+    GrapplerFunctionItem item;
+    GraphDef optimized_graph;
+    Status status;
+    bool done = false;
+  };
+  std::vector<FunctionResult> results(num_funcs);
+
+  // Guards `flib` and the scheduling state below.
+  mutex mu;
+  condition_variable all_done;
+  int num_replaced = 0;
+  int num_running = 0;
+  Status status;
+
+  const auto optimize_function = [&](int i) -> Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    const FunctionDef& func = *funcs[i];
+    const string& func_name = func.signature().name();
+    VLOG(3) << "Optimize function: function=" << func_name << " [" << i
+            << " of " << num_funcs << "]";
+
+    // Make a GrapplerItem from a FunctionDef.
+    FunctionResult& result = results[i];
+    GrapplerFunctionItem& func_item = result.item;
+    {
+      mutex_lock l(mu);
+      TF_RETURN_IF_ERROR(
+          MakeGrapplerFunctionItem(func, *flib, producer, &func_item));
+    }
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item.optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item.devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // Optimize function body graph.
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+          func_item.graph.release_library());
+      *func_item.graph.mutable_library() =
+          GetFunctionDefLibraryStub(*func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, func_item,
+                                              &result.optimized_graph);
+    } else {
+      GrapplerFunctionItem func_item_copy = func_item;
+      return OptimizeGraph(cluster, std::move(func_item_copy),
+                           &result.optimized_graph);
+    }
+  };
+
+  // Replaces an optimized function in the library.
+  const auto replace_function = [&](int i) -> Status {
+    FunctionResult& result = results[i];
+    TF_RETURN_IF_ERROR(result.status);
+
+    // Function body optimization might have created new specialized
+    // functions for each instantiation context. Add them to the library.
+    for (const FunctionDef& func_def :
+         result.optimized_graph.library().function()) {
+      if (flib->Find(func_def.signature().name()) == nullptr) {
+        TF_RETURN_IF_ERROR(flib->AddFunctionDef(func_def));
+      }
+    }
+
+    // Convert optimized graph back to FunctionDef.
+    FunctionDef optimized_func;
+    result.item.SwapFunctionBody(std::move(result.optimized_graph));
+    TF_RETURN_IF_ERROR(MakeFunctionDef(result.item, *flib, &optimized_func));
+
+    // Replace optimized function with a new FunctionDef.
+    return flib->ReplaceFunction(funcs[i]->signature().name(), optimized_func);
+  };
+
+  if (!parallel_function_optimization_ || num_funcs <= 1) {
+    for (int i = 0; i < num_funcs; ++i) {
+      results[i].status = optimize_function(i);
+      TF_RETURN_IF_ERROR(replace_function(i));
+    }
+    return Status::OK();
+  }
+
+  absl::flat_hash_map<string, int> func_indices;
+  for (int i = 0; i < num_funcs; ++i) {
+    func_indices[funcs[i]->signature().name()] = i;
+  }
+
+  // A function starts once the functions before it in `funcs` that it calls
+  // have been replaced, so it sees them the way it would if the functions
+  // were optimized one by one. waiting[k] are the functions that start once
+  // the first k functions have been replaced.
+  std::vector<std::vector<int>> waiting(num_funcs);
+  for (int i = 0; i < num_funcs; ++i) {
+    int num_before = 0;
+    for (const string& name :
+         flib->ReachableDefinitions(*funcs[i]).ListFunctionNames()) {
+      const int* index = gtl::FindOrNull(func_indices, name);
+      if (index != nullptr && *index < i) {
+        num_before = std::max(num_before, *index + 1);
+      }
+    }
+    waiting[num_before].push_back(i);
+  }
+
+  int first_result;
+  {
+    mutex_lock l(optimization_results_mu_);
+    first_result = optimization_results_.size();
+  }
+
+  thread::ThreadPool pool(Env::Default(), "meta_optimizer_functions",
+                          std::min(num_funcs, port::MaxParallelism()));
+  // Schedules the functions that can start now. Requires `mu`.
+  std::function<void()> start_waiting;
+  start_waiting = [&]() {
+    if (num_replaced == num_funcs) return;
+    for (int i : waiting[num_replaced]) {
+      ++num_running;
+      pool.Schedule([&, i]() {
+        const Status func_status = optimize_function(i);
+        mutex_lock l(mu);
+        results[i].status = func_status;
+        results[i].done = true;
+        --num_running;
+        // Replace functions in library order, so that the library does not
+        // depend on the order in which the functions finish.
+        while (status.ok() && num_replaced < num_funcs &&
+               results[num_replaced].done) {
+          status = replace_function(num_replaced);
+          if (!status.ok()) break;
+          ++num_replaced;
+          start_waiting();
+        }
+        all_done.notify_all();
+      });
+    }
+  };
+
+  {
+    mutex_lock l(mu);
+    start_waiting();
+    while (num_running > 0 || (status.ok() && num_replaced < num_funcs)) {
+      all_done.wait(l);
+    }
+  }
+
+  // Record the results of the functions in library order, like the serial
+  // loop does, rather than in the order in which they finished.
+  {
+    mutex_lock l(optimization_results_mu_);
+    std::stable_sort(optimization_results_.begin() + first_result,
+                     optimization_results_.end(),
+                     [&func_indices](const GraphOptimizationResult& a,
+                                     const GraphOptimizationResult& b) {
+                       return func_indices.at(a.id) < func_indices.at(b.id);
+                     });
+  }
+  return status;
+}
+
 Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
                                           GraphDef* optimized_graph) {
   const uint64 start_us = Env::Default()->NowMicros();
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
+
+  // Replicas loading the same model can skip the optimization altogether.
+  const string cache_path =
+      OptimizedGraphCachePath(config_proto_, item, cluster);
+  if (!cache_path.empty() &&
+      LookupOptimizedGraph(cache_path, optimized_graph)) {
+    metrics::UpdateGrapplerPassTime("*",
+                                    Env::Default()->NowMicros() - start_us);
+    return Status::OK();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -1004,10 +1338,9 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   while (optimize_function_library) {
     optimize_function_library = false;
 
-    int function_idx = 0;
+    // Functions to optimize in this pass, in library order.
+    std::vector<const FunctionDef*> funcs;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -1027,93 +1360,22 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // and in function instantiation.
       if (data::IsTFDataFunction(func)) continue;
 
-      VLOG(3) << "Optimize function: function=" << func_name << " ["
-              << function_idx++ << " of "
-              << optimized_graph->library().function_size() << "]";
-
-      // Function optimization might specialize nested function calls, so we
-      // have to reset the flag and do at least one more pass over the library.
-      optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
-
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
-      }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
-      }
-
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+    // Function optimization might specialize nested function calls, so we
+    // have to do at least one more pass over the library.
+    optimize_function_library = !funcs.empty();
+    if (!optimize_function_library) break;
 
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
-    }
+    TF_RETURN_IF_ERROR(OptimizeFunctions(
+        cluster, funcs, differentiable_functions, producer,
+        IsTPUGraphDef(*optimized_graph), &flib));
 
-    // If optimized at least one function, update the graph library.
-    if (optimize_function_library) {
-      *optimized_graph->mutable_library() = flib.ToProto();
-    }
+    // Update the graph library with the optimized functions. This
+    // invalidates `funcs`.
+    *optimized_graph->mutable_library() = flib.ToProto();
   }
 
   VLOG(1) << "Optimized " << optimized_funcs.size()
@@ -1126,6 +1388,8 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
         *optimized_graph);
   }
 
+  if (!cache_path.empty()) StoreOptimizedGraph(cache_path, *optimized_graph);
+
   const uint64 end_us = Env::Default()->NowMicros();
   metrics::UpdateGrapplerPassTime("*", end_us - start_us);
 
@@ -1134,6 +1398,7 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
+  mutex_lock l(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     absl::StrAppend(&result_string,
                     "Optimization results for grappler item: ", graph_result.id,
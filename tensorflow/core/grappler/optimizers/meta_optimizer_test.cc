@@ -18,6 +18,8 @@ limitations under the License.
 #include <atomic>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -235,6 +238,47 @@ TEST_F(MetaOptimizerTest, RunOptimizersTwice) {
   TF_EXPECT_OK(status);
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_cache");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_cache_dir(cache_dir);
+
+  const auto optimize = [&](const GrapplerItem& input, GraphDef* output) {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, input, output));
+  };
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  optimize(item, &output);
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef cached_output;
+  optimize(item, &cached_output);
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(output, cached_output);
+
+  // Any change to the item misses the cache.
+  item.keep_ops.push_back(item.graph.node(0).name());
+  optimize(item, &output);
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+}
+
 TEST_F(MetaOptimizerTest, RunToggleOptimizersAndCustomGraphOptimizerTwice) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
   GrapplerItem item;
@@ -703,6 +747,113 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
       optimization_options_my_mul_2->allow_non_differentiable_rewrites);
 }
 
+// Optimizes `item` with the function library optimized serially or in
+// parallel. Returns the IDs of the optimized grappler items in the order in
+// which their results are reported.
+std::vector<string> OptimizeFunctionLibraryWithParallelism(
+    bool parallel, const GrapplerItem& item, GraphDef* output) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.add_optimizers("arithmetic");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  if (parallel) {
+    setenv("TF_GRAPPLER_PARALLEL_FUNCTION_OPTIMIZATION", "1", 1 /* replace */);
+  }
+  MetaOptimizer optimizer(nullptr, config_proto);
+  unsetenv("TF_GRAPPLER_PARALLEL_FUNCTION_OPTIMIZATION");
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, output));
+
+  std::vector<string> ids;
+  constexpr char kPrefix[] = "Optimization results for grappler item: ";
+  for (absl::string_view line :
+       absl::StrSplit(optimizer.GetResultString(), '\n')) {
+    if (absl::ConsumePrefix(&line, kPrefix)) {
+      ids.emplace_back(line);
+    }
+  }
+  return ids;
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  using test::function::NDef;
+
+  // Define function library:
+  //
+  //  *MySquare(x) = x * x
+  //  *MyQuartic(x) = MySquare(MySquare(x))
+  //
+  //  * - marked as noinline
+  FunctionDef square_func = FunctionDefHelper::Create(
+      "MySquare", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"mul"}, "Mul", {"x", "x"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+  (*square_func.mutable_attr())["_noinline"].set_b(true);
+
+  FunctionDef quartic_func = FunctionDefHelper::Create(
+      "MyQuartic", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"square"}, "MySquare", {"x"}, {{"T", "$T"}}},
+       {{"quartic"}, "MySquare", {"square:z"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "quartic:z:0"}});
+  (*quartic_func.mutable_attr())["_noinline"].set_b(true);
+
+  // Tensorflow graph:
+  //
+  //   a = tf.Placeholder(tf.float);
+  //
+  //   square = MySquare(a);    // a^2
+  //   quartic = MyQuartic(a);  // a^4
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("square", "MySquare", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("quartic", "MyQuartic", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("out_s", "Identity", {"square:0"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("out_q", "Identity", {"quartic:0"}, {{"T", DT_FLOAT}}, kDevice)},
+      /*funcs=*/
+      {square_func, quartic_func});
+  item.fetch = {"out_s", "out_q"};
+
+  GraphDef serial_output;
+  const std::vector<string> serial_ids = OptimizeFunctionLibraryWithParallelism(
+      /*parallel=*/false, item, &serial_output);
+  GraphDef parallel_output;
+  const std::vector<string> parallel_ids =
+      OptimizeFunctionLibraryWithParallelism(/*parallel=*/true, item,
+                                             &parallel_output);
+
+  // The main graph and the specializations of both functions are optimized,
+  // and their results are reported in the same order.
+  EXPECT_GE(serial_ids.size(), 3);
+  EXPECT_EQ(serial_ids, parallel_ids);
+
+  CompareGraphs(serial_output, parallel_output);
+  FunctionLibraryDefinition serial_flib(OpRegistry::Global(),
+                                        serial_output.library());
+  FunctionLibraryDefinition parallel_flib(OpRegistry::Global(),
+                                          parallel_output.library());
+  EXPECT_EQ(serial_flib.num_functions(), parallel_flib.num_functions());
+  for (const string& name : serial_flib.ListFunctionNames()) {
+    const FunctionDef* serial_func = serial_flib.Find(name);
+    const FunctionDef* parallel_func = parallel_flib.Find(name);
+    ASSERT_NE(parallel_func, nullptr) << name;
+    EXPECT_TRUE(FunctionDefsEqual(*serial_func, *parallel_func)) << name;
+  }
+
+  item.feed.emplace_back("a", test::AsScalar<float>(3.0f));
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(parallel_output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+  test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
+}
+
 class SleepingOptimizer : public CustomGraphOptimizer {
  public:
   SleepingOptimizer() {}
@@ -524,6 +524,76 @@ TEST_F(MklRemapperTest, FuseMatMulWithBiasAddAndAdd) {
   test::ExpectClose(tensors_expected[0], tensors[0], 0, 1e-6);
 }
 
+TEST_F(MklRemapperTest, QuantizeMatMulWithFakeQuantInputs) {
+  setenv("TF_ENABLE_ONEDNN_INT8_MATMUL", "1", 1 /* replace */);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = ops::Placeholder::Shape({4, 32});
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto filter_tensor =
+      GenerateTensorWithSetRandom<DT_FLOAT>(TensorShape({32, 8}));
+  auto bias_tensor = GenerateTensorWithSetRandom<DT_FLOAT>(TensorShape({8}));
+  auto filter =
+      ops::Const(s.WithOpName("filter"), Input::Initializer(filter_tensor));
+  auto bias = ops::Const(s.WithOpName("bias"), Input::Initializer(bias_tensor));
+
+  auto range = ops::FakeQuantWithMinMaxArgs::Min(-1.0f).Max(1.0f);
+  auto input_fake_quant = ops::FakeQuantWithMinMaxArgs(
+      s.WithOpName("input_fake_quant"), input, range);
+  auto filter_fake_quant = ops::FakeQuantWithMinMaxArgs(
+      s.WithOpName("filter_fake_quant"), filter, range);
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), input_fake_quant,
+                            filter_fake_quant);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  ops::Identity(s.WithOpName("fetch"), bias_add);
+
+  auto input_tensor = GenerateTensorWithSetRandom<DT_FLOAT>(
+      TensorShape(input_shape.shape_.dim_sizes()));
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"input", input_tensor}};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::AGGRESSIVE);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  unsetenv("TF_ENABLE_ONEDNN_INT8_MATMUL");
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("matmul", node.name());
+    EXPECT_NE("input_fake_quant", node.name());
+    EXPECT_NE("filter_fake_quant", node.name());
+    if (node.name() == "bias_add") {
+      EXPECT_EQ("QuantizedMatMulWithBiasAndDequantize", node.op());
+      ASSERT_EQ(9, node.input_size());
+      EXPECT_EQ("bias", node.input(2));
+      EXPECT_EQ(DT_QUINT8, node.attr().at("T1").type());
+      EXPECT_EQ(DT_QINT8, node.attr().at("T2").type());
+      EXPECT_EQ("MIN_FIRST", node.attr().at("input_quant_mode").s());
+      found++;
+    } else if (node.op() == "QuantizeV2") {
+      EXPECT_EQ("input", node.input(0));
+      EXPECT_EQ("MIN_FIRST", node.attr().at("mode").s());
+      found++;
+    }
+  }
+  EXPECT_EQ(2, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  EXPECT_EQ(1, tensors_expected.size());
+  EXPECT_EQ(1, tensors.size());
+  // Real and emulated quantization round differently.
+  test::ExpectClose(tensors_expected[0], tensors[0], 0.1, 0.01);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
 #endif  // INTEL_MKL && ENABLE_MKL
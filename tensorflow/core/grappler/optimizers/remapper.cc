@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/graph_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -56,6 +60,14 @@ namespace grappler {
 //   (1) FusedBatchNorm + <Activation>
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
+// Elementwise ops on CPU -> _FusedElementwise
+//   (1) A tree of unary and binary cwise ops whose inputs are scalars or have
+//       the shape of the result, if the cost model expects it to be faster.
+//
+// MatMul with FakeQuant inputs on CPU -> QuantizedMatMulWithBiasAndDequantize
+//   (1) MatMul(FakeQuant(x), [FakeQuant](Const)) + <BiasAdd>, with oneDNN and
+//       TF_ENABLE_ONEDNN_INT8_MATMUL=1.
+//
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
@@ -68,6 +80,12 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+constexpr char kQuantizedMatMulWithBiasAndDequantize[] =
+    "QuantizedMatMulWithBiasAndDequantize";
+
+// Largest number of ops fused into one _FusedElementwise.
+constexpr int kMaxFusedElementwiseOps = 32;
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -236,6 +254,29 @@ struct ContractionWithBiasAndAddActivation {
   int activation = kMissingIndex;
 };
 
+// MatMul whose inputs are annotated with calibrated ranges by FakeQuant nodes,
+// optionally followed by a BiasAdd, that can run in int8.
+struct QuantizedContractionWithBiasAdd {
+  int input_fake_quant = kMissingIndex;
+  int filter = kMissingIndex;
+  // The FakeQuant of the constant filter, unless constant folding already
+  // folded it into the filter.
+  int filter_fake_quant = kMissingIndex;
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+};
+
+// A tree of elementwise ops that can be evaluated by a _FusedElementwise.
+struct ElementwiseChain {
+  // The nodes of the chain in topological order, ending with the root.
+  std::vector<int> nodes;
+  // The tensors read by the chain, as NodeDef inputs.
+  std::vector<string> args;
+  std::vector<OpInfo::TensorProperties> arg_properties;
+  // The operands of each node, numbered as in _FusedElementwise.
+  std::vector<int> operands;
+};
+
 bool IsInPreserveSet(const RemapperContext& ctx, const NodeDef* node) {
   return ctx.nodes_to_preserve.count(node->name()) > 0;
 }
@@ -1173,6 +1214,321 @@ bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+// The int8 rewrite of MatMuls with FakeQuant inputs changes the numerics of
+// the graph from emulated to real quantization, so it is opt-in.
+bool Int8MatMulRewriteEnabled() {
+  bool is_enabled = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_ENABLE_ONEDNN_INT8_MATMUL",
+                                 /*default_val=*/false, &is_enabled));
+  return is_enabled;
+}
+
+bool IsFakeQuantWithMinMax(const NodeDef& node) {
+  return node.op() == "FakeQuantWithMinMaxArgs" ||
+         node.op() == "FakeQuantWithMinMaxVars";
+}
+
+// Reads the value of a scalar float Const.
+bool GetScalarConstValue(const NodeDef& node, float* value) {
+  if (!IsConstant(node) || !HasDataType(&node, DT_FLOAT, "dtype")) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  *value = tensor.flat<float>()(0);
+  return true;
+}
+
+// Reads the range of the 8 bit per tensor quantization emulated by the
+// FakeQuantWithMinMax{Args,Vars} node at `node_index`, whose range must be
+// constant.
+bool GetFakeQuantRange(const RemapperContext& ctx, int node_index, float* min,
+                       float* max, bool* narrow_range) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsFakeQuantWithMinMax(*node_def)) return false;
+
+  int num_bits = 8;
+  *narrow_range = false;
+  TryGetNodeAttr(*node_def, "num_bits", &num_bits);
+  TryGetNodeAttr(*node_def, "narrow_range", narrow_range);
+  if (num_bits != 8) return false;
+
+  if (node_def->op() == "FakeQuantWithMinMaxArgs") {
+    *min = -6.0f;
+    *max = 6.0f;
+    TryGetNodeAttr(*node_def, "min", min);
+    TryGetNodeAttr(*node_def, "max", max);
+  } else {
+    if (node_view->NumRegularFanins() != 3) return false;
+    const auto& min_fanin = node_view->GetRegularFanin(1);
+    const auto& max_fanin = node_view->GetRegularFanin(2);
+    if (!GetScalarConstValue(*min_fanin.node_view()->node(), min) ||
+        !GetScalarConstValue(*max_fanin.node_view()->node(), max))
+      return false;
+  }
+  return *min < *max;
+}
+
+bool FindQuantizedContractionWithBias(
+    const RemapperContext& ctx, int node_index,
+    QuantizedContractionWithBiasAdd* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  // Root of the pattern is a BiasAdd of a MatMul, or a MatMul without bias.
+  QuantizedContractionWithBiasAdd pattern;
+  const auto* contraction_node_view = node_view;
+  if (IsBiasAdd(*node_view->node())) {
+    if (node_view->NumRegularFanins() < 2) return false;
+    pattern.bias_add = node_index;
+    contraction_node_view = node_view->GetRegularFanin(0).node_view();
+    if (HasControlFaninOrFanout(*contraction_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*contraction_node_view) ||
+        IsInPreserveSet(ctx, contraction_node_view->node()))
+      return false;
+  }
+  const auto* contraction_node_def = contraction_node_view->node();
+  if (!IsMatMul(*contraction_node_def) ||
+      !NodeIsOnCpu(contraction_node_def) ||
+      !HasDataType(node_view->node(), DT_FLOAT) ||
+      !HaveSameDataType(node_view->node(), contraction_node_def) ||
+      contraction_node_view->NumRegularFanins() != 2)
+    return false;
+  pattern.contraction = contraction_node_view->node_index();
+
+  // The quantized kernel does not transpose its input. The filter is
+  // transposed when it is quantized.
+  bool transpose_a = false;
+  TryGetNodeAttr(*contraction_node_def, "transpose_a", &transpose_a);
+  if (transpose_a) return false;
+
+  // The input is quantized to quint8 with the range of its FakeQuant.
+  const auto* input_view =
+      contraction_node_view->GetRegularFanin(0).node_view();
+  float min, max;
+  bool narrow_range;
+  if (HasControlFaninOrFanout(*input_view) ||
+      !HasAtMostOneFanoutAtPort0(*input_view) ||
+      IsInPreserveSet(ctx, input_view->node()) ||
+      !GetFakeQuantRange(ctx, input_view->node_index(), &min, &max,
+                         &narrow_range) ||
+      narrow_range)
+    return false;
+  pattern.input_fake_quant = input_view->node_index();
+
+  // The filter must be a constant matrix, which is quantized to qint8 ahead
+  // of time.
+  const auto* filter_view =
+      contraction_node_view->GetRegularFanin(1).node_view();
+  if (IsFakeQuantWithMinMax(*filter_view->node())) {
+    if (HasControlFaninOrFanout(*filter_view) ||
+        !HasAtMostOneFanoutAtPort0(*filter_view) ||
+        IsInPreserveSet(ctx, filter_view->node()) ||
+        !GetFakeQuantRange(ctx, filter_view->node_index(), &min, &max,
+                           &narrow_range))
+      return false;
+    pattern.filter_fake_quant = filter_view->node_index();
+    filter_view = filter_view->GetRegularFanin(0).node_view();
+  }
+  const auto* filter_node_def = filter_view->node();
+  if (!IsConstant(*filter_node_def) ||
+      !HasDataType(filter_node_def, DT_FLOAT, "dtype") ||
+      filter_node_def->attr().at("value").tensor().tensor_shape().dim_size() !=
+          2)
+    return false;
+  pattern.filter = filter_view->node_index();
+
+  *matched = pattern;
+
+  return true;
+}
+
+// Returns the number of inputs of `node` if _FusedElementwise can evaluate
+// it, and 0 otherwise.
+int FusableElementwiseArity(const NodeDef& node) {
+  static const auto* const kArities = new absl::flat_hash_map<string, int>({
+      {"Add", 2},     {"AddV2", 2},   {"Sub", 2},
+      {"Mul", 2},     {"RealDiv", 2}, {"Maximum", 2},
+      {"Minimum", 2}, {"SquaredDifference", 2},
+      {"Neg", 1},     {"Square", 1},  {"Sqrt", 1},
+      {"Rsqrt", 1},   {"Exp", 1},     {"Log", 1},
+      {"Tanh", 1},    {"Sigmoid", 1}, {"Relu", 1},
+      {"Erf", 1},
+  });
+  auto it = kArities->find(node.op());
+  return it == kArities->end() ? 0 : it->second;
+}
+
+bool IsElementwiseFusionCandidate(const NodeDef& node) {
+  return FusableElementwiseArity(node) > 0 && NodeIsOnCpu(&node) &&
+         (HasDataType(&node, DT_FLOAT) || HasDataType(&node, DT_DOUBLE));
+}
+
+bool IsScalarShape(const TensorShapeProto& shape) {
+  return !shape.unknown_rank() && shape.dim_size() == 0;
+}
+
+// Ops whose activations the contraction and batch norm fusions look for. The
+// elementwise fusion does not take their consumers away from them.
+bool IsFusedActivationProducer(const NodeDef& node) {
+  return IsBiasAdd(node) || IsFusedBatchNorm(node) || IsConv2D(node) ||
+         IsMatMul(node) || IsDepthwiseConv2dNative(node);
+}
+
+// Returns the size of the tensor, counting unknown dimensions as 1.
+int64_t TensorBytes(const OpInfo::TensorProperties& tensor) {
+  int64_t num_elements = 1;
+  if (!tensor.shape().unknown_rank()) {
+    for (const auto& dim : tensor.shape().dim()) {
+      num_elements *= std::max<int64_t>(dim.size(), 1);
+    }
+  }
+  return num_elements * DataTypeSize(tensor.dtype());
+}
+
+// Compares the cost of running the nodes of `chain` one by one with the cost
+// of one pass that reads the arguments and writes the result once. Both take
+// the same compute time, but the unfused ops also write and read back every
+// intermediate result.
+bool IsElementwiseFusionProfitable(const RemapperContext& ctx,
+                                   const ElementwiseChain& chain) {
+  OpLevelCostEstimator estimator;
+  const DeviceProperties device = GetLocalCPUInfo();
+  double unfused_ns = 0;
+  double compute_ns = 0;
+  for (int node_index : chain.nodes) {
+    const NodeDef* node = ctx.graph_view.GetNode(node_index)->node();
+    OpContext op_context;
+    op_context.name = node->name();
+    op_context.device_name = node->device();
+    OpInfo& op_info = op_context.op_info;
+    op_info.set_op(node->op());
+    *op_info.mutable_attr() = node->attr();
+    for (const auto& input :
+         ctx.graph_properties.GetInputProperties(node->name())) {
+      *op_info.add_inputs() = input;
+    }
+    for (const auto& output :
+         ctx.graph_properties.GetOutputProperties(node->name())) {
+      *op_info.add_outputs() = output;
+    }
+    *op_info.mutable_device() = device;
+    const Costs costs = estimator.PredictCosts(op_context);
+    unfused_ns += costs.execution_time.count();
+    compute_ns += costs.compute_time.count();
+  }
+
+  const NodeDef* root = ctx.graph_view.GetNode(chain.nodes.back())->node();
+  int64_t io_bytes =
+      TensorBytes(ctx.graph_properties.GetOutputProperties(root->name())[0]);
+  for (const auto& arg : chain.arg_properties) io_bytes += TensorBytes(arg);
+  // Bytes divided by GB/s are nanoseconds.
+  const double fused_ns =
+      compute_ns + io_bytes / estimator.GetDeviceInfo(device).gb_per_sec;
+  VLOG(2) << "Elementwise chain of " << chain.nodes.size() << " ops at "
+          << root->name() << ": " << unfused_ns << " ns unfused, " << fused_ns
+          << " ns fused";
+  return fused_ns < unfused_ns;
+}
+
+bool FindElementwiseChain(const RemapperContext& ctx, int node_index,
+                          ElementwiseChain* matched) {
+  if (ctx.xla_auto_clustering_on || !ctx.inferred_graph_properties) {
+    return false;
+  }
+  const auto* root_view = ctx.graph_view.GetNode(node_index);
+  const auto* root = root_view->node();
+  if (!IsElementwiseFusionCandidate(*root) ||
+      root_view->NumControllingFanins() > 0 ||
+      !ctx.graph_properties.HasOutputProperties(root->name())) {
+    return false;
+  }
+  const TensorShapeProto& shape =
+      ctx.graph_properties.GetOutputProperties(root->name())[0].shape();
+
+  // Whether each input of the node is either a scalar or has the shape of
+  // the root.
+  const auto has_fusable_inputs = [&](const NodeDef& node) -> bool {
+    const auto& inputs = ctx.graph_properties.GetInputProperties(node.name());
+    if (inputs.size() != FusableElementwiseArity(node)) return false;
+    for (const auto& input : inputs) {
+      if (!IsScalarShape(input.shape()) &&
+          !ShapesSymbolicallyEqual(input.shape(), shape)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!has_fusable_inputs(*root)) return false;
+
+  const auto can_absorb = [&](const utils::MutableNodeView& fanin_view,
+                              int port) -> bool {
+    const NodeDef* fanin = fanin_view.node();
+    if (port != 0 || !IsElementwiseFusionCandidate(*fanin) ||
+        IsInPreserveSet(ctx, fanin) || HasControlFaninOrFanout(fanin_view) ||
+        fanin_view.NumRegularFanouts() != 1 ||
+        fanin->device() != root->device() || !HaveSameDataType(fanin, root) ||
+        !ctx.graph_properties.HasOutputProperties(fanin->name()) ||
+        !ShapesSymbolicallyEqual(
+            ctx.graph_properties.GetOutputProperties(fanin->name())[0].shape(),
+            shape) ||
+        !has_fusable_inputs(*fanin)) {
+      return false;
+    }
+    for (const auto& input : fanin_view.GetRegularFanins()) {
+      if (IsFusedActivationProducer(*input.node_view()->node())) return false;
+    }
+    return true;
+  };
+
+  // Visits the fanins depth first, so that the nodes come out in topological
+  // order. Arguments are numbered -1, -2, ... until the number of arguments
+  // is known.
+  ElementwiseChain chain;
+  absl::flat_hash_map<string, int> arg_numbers;
+  int num_ops = 1;
+  std::function<int(const utils::MutableNodeView&)> visit =
+      [&](const utils::MutableNodeView& node_view) -> int {
+    std::vector<int> operands;
+    for (int i = 0; i < node_view.NumRegularFanins(); ++i) {
+      const auto& fanin = node_view.GetRegularFanin(i);
+      if (num_ops < kMaxFusedElementwiseOps &&
+          can_absorb(*fanin.node_view(), fanin.index())) {
+        ++num_ops;
+        operands.push_back(visit(*fanin.node_view()));
+        continue;
+      }
+      const string key =
+          strings::StrCat(fanin.node_view()->GetName(), ":", fanin.index());
+      auto it = arg_numbers.find(key);
+      if (it == arg_numbers.end()) {
+        it = arg_numbers.emplace(key, -1 - chain.args.size()).first;
+        chain.args.push_back(node_view.node()->input(i));
+        chain.arg_properties.push_back(ctx.graph_properties.GetInputProperties(
+            node_view.GetName())[i]);
+      }
+      operands.push_back(it->second);
+    }
+    chain.operands.insert(chain.operands.end(), operands.begin(),
+                          operands.end());
+    chain.nodes.push_back(node_view.node_index());
+    return chain.nodes.size() - 1;
+  };
+  visit(*root_view);
+  if (chain.nodes.size() < 2) return false;
+
+  for (int& operand : chain.operands) {
+    operand = operand < 0 ? -1 - operand : chain.args.size() + operand;
+  }
+  if (!IsElementwiseFusionProfitable(ctx, chain)) return false;
+  *matched = std::move(chain);
+  return true;
+}
+
 void CopyConv2DAttributes(const NodeDef& conv2d, NodeDef* fused_conv2d,
                           const NodeDef* activation = nullptr) {
   DCHECK(IsConv2D(conv2d)) << "Input node must be a Conv2D";
@@ -1976,6 +2332,214 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedElementwiseNode(RemapperContext* ctx,
+                                const ElementwiseChain& matched,
+                                std::vector<bool>* invalidated_nodes,
+                                std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& root = graph->node(matched.nodes.back());
+  VLOG(2) << "Fuse " << matched.nodes.size()
+          << " elementwise ops into _FusedElementwise: root=" << root.name()
+          << " on device=" << root.device();
+
+  NodeDef fused_op;
+  fused_op.set_name(root.name());
+  fused_op.set_op(kFusedElementwise);
+  fused_op.set_device(root.device());
+  for (const string& arg : matched.args) fused_op.add_input(arg);
+
+  std::vector<string> fused_ops;
+  for (int node_index : matched.nodes) {
+    fused_ops.push_back(graph->node(node_index).op());
+  }
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = root.attr().at("T");
+  SetAttrValue(static_cast<int>(matched.args.size()), &(*attr)["num_args"]);
+  SetAttrValue(fused_ops, &(*attr)["fused_ops"]);
+  SetAttrValue(matched.operands, &(*attr)["fused_operands"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.nodes.back()] = true;
+  for (int i = 0; i + 1 < matched.nodes.size(); ++i) {
+    (*nodes_to_delete)[matched.nodes[i]] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddQuantizedContractionNode(
+    RemapperContext* ctx, const QuantizedContractionWithBiasAdd& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& input_fake_quant = graph->node(matched.input_fake_quant);
+  const NodeDef& filter = graph->node(matched.filter);
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const bool has_bias = matched.bias_add != kMissingIndex;
+  const NodeDef& root =
+      graph->node(has_bias ? matched.bias_add : matched.contraction);
+  VLOG(2) << "Quantize " << contraction.op() << " with FakeQuant inputs:"
+          << " contraction=" << contraction.name()
+          << " input_fake_quant=" << input_fake_quant.name()
+          << " filter=" << filter.name() << " bias_add="
+          << (has_bias ? graph->node(matched.bias_add).name() : "none");
+
+  float min_input, max_input;
+  bool narrow_range;
+  if (!GetFakeQuantRange(*ctx, matched.input_fake_quant, &min_input,
+                         &max_input, &narrow_range)) {
+    return errors::Internal("Unsupported FakeQuant ", input_fake_quant.name());
+  }
+
+  // The filter is quantized symmetrically, in the SCALED mode of the kernel,
+  // with the range of its FakeQuant, or else the range of its values.
+  Tensor filter_tensor;
+  if (!filter_tensor.FromProto(filter.attr().at("value").tensor())) {
+    return errors::InvalidArgument("Cannot parse the value of ", filter.name());
+  }
+  const auto filter_values = filter_tensor.matrix<float>();
+  float filter_range = 0.0f;
+  if (matched.filter_fake_quant != kMissingIndex) {
+    float min_filter, max_filter;
+    if (!GetFakeQuantRange(*ctx, matched.filter_fake_quant, &min_filter,
+                           &max_filter, &narrow_range)) {
+      return errors::Internal("Unsupported FakeQuant ",
+                              graph->node(matched.filter_fake_quant).name());
+    }
+    filter_range = std::max(std::abs(min_filter), std::abs(max_filter));
+  } else {
+    const auto flat_filter_values = filter_tensor.flat<float>();
+    for (int64_t i = 0; i < flat_filter_values.size(); ++i) {
+      filter_range = std::max(filter_range, std::abs(flat_filter_values(i)));
+    }
+  }
+  if (filter_range == 0.0f) filter_range = 1.0f;
+
+  bool transpose_b = false;
+  TryGetNodeAttr(contraction, "transpose_b", &transpose_b);
+  const int64_t k = filter_tensor.dim_size(transpose_b ? 1 : 0);
+  const int64_t n = filter_tensor.dim_size(transpose_b ? 0 : 1);
+  Tensor quantized_filter(DT_QINT8, TensorShape({k, n}));
+  auto quantized_values = quantized_filter.matrix<qint8>();
+  const float scale = 127.0f / filter_range;
+  for (int64_t i = 0; i < k; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      const float value =
+          transpose_b ? filter_values(j, i) : filter_values(i, j);
+      quantized_values(i, j) = static_cast<int8>(
+          std::round(std::min(std::max(value * scale, -127.0f), 127.0f)));
+    }
+  }
+
+  // The float filter is no longer needed, unless it is shared.
+  const auto* filter_view = ctx->graph_view.GetNode(matched.filter);
+  const bool delete_filter = !HasControlFaninOrFanout(*filter_view) &&
+                             HasAtMostOneFanoutAtPort0(*filter_view) &&
+                             !IsInPreserveSet(*ctx, &filter);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  const auto add_const = [&](const string& prefix, Tensor value,
+                             string* name) -> Status {
+    NodeDef const_node;
+    *name = AddPrefixToNodeName(prefix, root.name());
+    TF_RETURN_IF_ERROR(ConstantFolding::CreateNodeDef(
+        *name, TensorValue(&value), &const_node));
+    const_node.set_device(contraction.device());
+    mutation->AddNode(std::move(const_node), &status);
+    return status;
+  };
+  const auto add_scalar_const = [&](const string& prefix, float value,
+                                    string* name) -> Status {
+    Tensor tensor(DT_FLOAT, TensorShape());
+    tensor.scalar<float>()() = value;
+    return add_const(prefix, tensor, name);
+  };
+
+  string min_input_name, max_input_name, filter_name, min_filter_name,
+      max_filter_name, freezed_output_name, bias_name;
+  TF_RETURN_IF_ERROR(add_scalar_const("MinInput", min_input, &min_input_name));
+  TF_RETURN_IF_ERROR(add_scalar_const("MaxInput", max_input, &max_input_name));
+  TF_RETURN_IF_ERROR(
+      add_const("QuantizedFilter", quantized_filter, &filter_name));
+  TF_RETURN_IF_ERROR(
+      add_scalar_const("MinFilter", -filter_range, &min_filter_name));
+  TF_RETURN_IF_ERROR(
+      add_scalar_const("MaxFilter", filter_range, &max_filter_name));
+  // The range of the output is only used when it is requantized.
+  TF_RETURN_IF_ERROR(
+      add_scalar_const("FreezedOutput", 0.0f, &freezed_output_name));
+  if (has_bias) {
+    bias_name = graph->node(matched.bias_add).input(1);
+  } else {
+    Tensor bias(DT_FLOAT, TensorShape({n}));
+    bias.flat<float>().setZero();
+    TF_RETURN_IF_ERROR(add_const("Bias", bias, &bias_name));
+  }
+
+  // The input is quantized with its calibrated range, in MIN_FIRST mode since
+  // it may be negative.
+  NodeDef quantize;
+  quantize.set_name(AddPrefixToNodeName("QuantizeInput", root.name()));
+  quantize.set_op("QuantizeV2");
+  quantize.set_device(contraction.device());
+  quantize.add_input(input_fake_quant.input(0));
+  quantize.add_input(min_input_name);
+  quantize.add_input(max_input_name);
+  auto* quantize_attr = quantize.mutable_attr();
+  (*quantize_attr)["T"].set_type(DT_QUINT8);
+  (*quantize_attr)["mode"].set_s("MIN_FIRST");
+  (*quantize_attr)["round_mode"].set_s("HALF_AWAY_FROM_ZERO");
+  (*quantize_attr)["narrow_range"].set_b(false);
+  (*quantize_attr)["axis"].set_i(-1);
+  (*quantize_attr)["ensure_minimum_range"].set_f(0.01f);
+  const string quantize_name = quantize.name();
+  const string min_a_name = absl::StrCat(quantize_name, ":1");
+  const string max_a_name = absl::StrCat(quantize_name, ":2");
+  mutation->AddNode(std::move(quantize), &status);
+  TF_RETURN_IF_ERROR(status);
+
+  NodeDef quantized_op;
+  quantized_op.set_name(root.name());
+  quantized_op.set_op(kQuantizedMatMulWithBiasAndDequantize);
+  quantized_op.set_device(contraction.device());
+  quantized_op.add_input(quantize_name);        // 0: a
+  quantized_op.add_input(filter_name);          // 1: b
+  quantized_op.add_input(bias_name);            // 2: bias
+  quantized_op.add_input(min_a_name);           // 3: min_a
+  quantized_op.add_input(max_a_name);           // 4: max_a
+  quantized_op.add_input(min_filter_name);      // 5: min_b
+  quantized_op.add_input(max_filter_name);      // 6: max_b
+  quantized_op.add_input(freezed_output_name);  // 7: min_freezed_output
+  quantized_op.add_input(freezed_output_name);  // 8: max_freezed_output
+  auto* attr = quantized_op.mutable_attr();
+  (*attr)["T1"].set_type(DT_QUINT8);
+  (*attr)["T2"].set_type(DT_QINT8);
+  (*attr)["Tbias"].set_type(DT_FLOAT);
+  (*attr)["Toutput"].set_type(DT_FLOAT);
+  (*attr)["transpose_a"].set_b(false);
+  (*attr)["transpose_b"].set_b(false);
+  (*attr)["input_quant_mode"].set_s("MIN_FIRST");
+  mutation->AddNode(std::move(quantized_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[has_bias ? matched.bias_add : matched.contraction] =
+      true;
+  if (has_bias) (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.input_fake_quant] = true;
+  if (matched.filter_fake_quant != kMissingIndex) {
+    (*nodes_to_delete)[matched.filter_fake_quant] = true;
+  }
+  if (delete_filter) (*nodes_to_delete)[matched.filter] = true;
+
+  return Status::OK();
+}
+
 bool IsConv2DOrMatMul(const NodeDef& node) {
   return IsConv2D(node) || IsMatMul(node);
 }
@@ -2114,13 +2678,21 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
+  // Candidate for an elementwise fusion.
+  const auto is_elementwise_fusion_candidate = [&]() -> bool {
+    return !ctx.xla_auto_clustering_on &&
+           IsElementwiseFusionCandidate(*node_def);
+  };
+
   if (IsMKLEnabled())
     return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
-           IsContractionWithAdd(ctx, node_index);
+           IsContractionWithAdd(ctx, node_index) ||
+           is_elementwise_fusion_candidate();
 
   return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
-         is_batch_norm_grad_fusion_candidate();
+         is_batch_norm_grad_fusion_candidate() ||
+         is_elementwise_fusion_candidate();
 }
 
 }  // namespace
@@ -2147,6 +2719,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   // not perform rewrite if the graph will be differentiated later.
   bool allow_non_differentiable_rewrites =
       item.optimization_options().allow_non_differentiable_rewrites;
+  const bool int8_matmul_rewrite_enabled =
+      IsMKLEnabled() && Int8MatMulRewriteEnabled();
 
   for (int i = num_nodes - 1; i >= 0; --i) {
     // Check if node was invalidated by one of the previous remaps.
@@ -2169,6 +2743,17 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
 
     if (IsMKLEnabled() && !item.optimization_options().is_eager_mode) {
+      // Remap MatMul with FakeQuant inputs (+BiasAdd) into the int8
+      // QuantizedMatMulWithBiasAndDequantize.
+      QuantizedContractionWithBiasAdd quantized_contraction;
+      if (allow_non_differentiable_rewrites && int8_matmul_rewrite_enabled &&
+          FindQuantizedContractionWithBias(ctx, i, &quantized_contraction)) {
+        TF_RETURN_IF_ERROR(
+            AddQuantizedContractionNode(&ctx, quantized_contraction,
+                                        &invalidated_nodes, &nodes_to_delete));
+        continue;
+      }
+
       // Remap Conv2D+BiasAdd+Add+relu into the _FusedConv2D.
       if (FindContractionWithBiasAndAddActivation(
               ctx, i, &contract_with_bias_and_add_activation)) {
@@ -2290,6 +2875,15 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       TF_RETURN_IF_ERROR(AddBatchNormNodes(&ctx, fused_batch_norm));
       continue;
     }
+
+    // Remap trees of elementwise ops into the _FusedElementwise.
+    ElementwiseChain elementwise_chain;
+    if (allow_non_differentiable_rewrites &&
+        FindElementwiseChain(ctx, i, &elementwise_chain)) {
+      TF_RETURN_IF_ERROR(AddFusedElementwiseNode(
+          &ctx, elementwise_chain, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
   }
 
   // Remove invalidated nodes.
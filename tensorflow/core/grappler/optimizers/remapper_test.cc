@@ -1367,5 +1367,98 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FuseElementwiseChain) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // 0.5 * x * (1 + tanh(0.7978845608 * (x + 0.044715 * x^3)))
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 32}));
+  auto x3 = ops::Mul(s.WithOpName("x3"),
+                     ops::Mul(s.WithOpName("x2"), x, x), x);
+  auto inner = ops::AddV2(
+      s.WithOpName("inner"), x,
+      ops::Mul(s.WithOpName("scaled_x3"), ops::Const(s, 0.044715f), x3));
+  auto tanh = ops::Tanh(
+      s.WithOpName("tanh"),
+      ops::Mul(s.WithOpName("scaled_inner"), ops::Const(s, 0.7978845608f),
+               inner));
+  auto one_plus =
+      ops::AddV2(s.WithOpName("one_plus"), ops::Const(s, 1.0f), tanh);
+  auto half_x = ops::Mul(s.WithOpName("half_x"), ops::Const(s, 0.5f), x);
+  auto gelu = ops::Mul(s.WithOpName("gelu"), half_x, one_plus);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "Mul") << node.name();
+    EXPECT_NE(node.op(), "Tanh") << node.name();
+    if (node.name() == "gelu") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      EXPECT_EQ(node.attr().at("num_args").i(), 5);
+      ASSERT_EQ(node.input_size(), 5);
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 9);
+      EXPECT_EQ(fused_ops[8], "Mul");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, DoNotFuseElementwiseOpsWithMultipleFanouts) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 32}));
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+  auto fetch0 = ops::Identity(s.WithOpName("fetch0"), exp);
+  auto fetch1 = ops::Identity(s.WithOpName("fetch1"), neg);
+
+  GrapplerItem item;
+  item.fetch = {"fetch0", "fetch1"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedElementwise") << node.name();
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
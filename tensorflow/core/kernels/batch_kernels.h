@@ -94,6 +94,7 @@ class BatchFunctionKernel : public AsyncOpKernel {
   FunctionLibraryRuntime* flib_;
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
+  int32 priority_ = 0;
   bool enable_adaptive_batch_threads_ = false;
 
   mutex mu_;
@@ -0,0 +1,148 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/lib/monitoring/gauge.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+namespace {
+
+// Weight of the past in the processing time fit and in the arrival rate, per
+// processed batch.
+constexpr double kDecay = 0.95;
+
+// Number of standard deviations of the fitting error added to the estimated
+// processing time; 2.33 is the 99th percentile of a normal distribution.
+constexpr double kErrorMargin = 2.33;
+
+void RecordBatchTimeoutMicros(int64_t batch_timeout_micros,
+                              const std::string& name) {
+  static auto* cell = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/latency_tuner/batch_timeout_micros",
+      "Tracks the batch timeout picked to meet the latency target.", "name");
+  cell->GetCell(name)->Set(batch_timeout_micros);
+}
+
+void RecordMaxBatchSize(int64_t max_batch_size, const std::string& name) {
+  static auto* cell = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/latency_tuner/max_batch_size",
+      "Tracks the batch size picked to meet the latency target.", "name");
+  cell->GetCell(name)->Set(max_batch_size);
+}
+
+}  // namespace
+
+BatchLatencyTuner::BatchLatencyTuner(const std::string& name,
+                                     int64_t latency_target_micros,
+                                     int64_t max_batch_size,
+                                     int64_t initial_batch_timeout_micros)
+    : name_(name),
+      latency_target_micros_(latency_target_micros),
+      max_allowed_batch_size_(max_batch_size),
+      batch_timeout_micros_(
+          std::min(initial_batch_timeout_micros, latency_target_micros)),
+      max_batch_size_(max_batch_size) {
+  RecordBatchTimeoutMicros(batch_timeout_micros_, name_);
+  RecordMaxBatchSize(max_batch_size_, name_);
+}
+
+void BatchLatencyTuner::RecordTask(int64_t task_size) {
+  units_since_rate_start_ += task_size;
+}
+
+void BatchLatencyTuner::RecordBatch(int64_t batch_size,
+                                    int64_t processing_micros,
+                                    uint64 now_micros) {
+  const double x = batch_size;
+  const double y = processing_micros;
+  weight_sum_ = kDecay * weight_sum_ + 1;
+  x_sum_ = kDecay * x_sum_ + x;
+  y_sum_ = kDecay * y_sum_ + y;
+  xx_sum_ = kDecay * xx_sum_ + x * x;
+  xy_sum_ = kDecay * xy_sum_ + x * y;
+  yy_sum_ = kDecay * yy_sum_ + y * y;
+
+  if (rate_start_micros_ == 0) {
+    // The tasks enqueued before the first batch finished arrived over an
+    // unknown period, so the measurement starts now.
+    units_since_rate_start_ = 0;
+    rate_start_micros_ = now_micros;
+  } else if (now_micros > rate_start_micros_) {
+    const double rate =
+        units_since_rate_start_ / (now_micros - rate_start_micros_);
+    arrival_rate_ = kDecay * arrival_rate_ + (1 - kDecay) * rate;
+    units_since_rate_start_ = 0;
+    rate_start_micros_ = now_micros;
+  }
+
+  UpdateChoices();
+}
+
+void BatchLatencyTuner::UpdateChoices() {
+  const double mean_x = x_sum_ / weight_sum_;
+  const double mean_y = y_sum_ / weight_sum_;
+  const double var_x = std::max(0.0, xx_sum_ / weight_sum_ - mean_x * mean_x);
+  const double var_y = std::max(0.0, yy_sum_ / weight_sum_ - mean_y * mean_y);
+  const double cov_xy = xy_sum_ / weight_sum_ - mean_x * mean_y;
+
+  // Batch sizes are integers, so a smaller variance means that (nearly) all
+  // batches had the same size and the slope can't be fitted. In that case, and
+  // when the fit is not meaningful, assume the cost is proportional to the
+  // size, which overestimates the cost of larger batches.
+  double slope = 0;
+  double intercept = -1;
+  if (var_x >= 0.25) {
+    slope = cov_xy / var_x;
+    intercept = mean_y - slope * mean_x;
+  }
+  if (slope < 0 || intercept < 0) {
+    slope = mean_y / std::max(mean_x, 1.0);
+    intercept = 0;
+  }
+  const double offset = mean_y - slope * mean_x - intercept;
+  const double error_var =
+      var_y - 2 * slope * cov_xy + slope * slope * var_x + offset * offset;
+  const double margin = kErrorMargin * std::sqrt(std::max(0.0, error_var));
+
+  // Time left for waiting and for the size-dependent part of processing.
+  const double budget = latency_target_micros_ - intercept - margin;
+  if (budget <= slope) {
+    // Even a batch of one unit misses the target; don't wait for more.
+    max_batch_size_ = 1;
+    batch_timeout_micros_ = 0;
+  } else {
+    max_batch_size_ =
+        slope > 0 ? std::min<double>(max_allowed_batch_size_,
+                                     std::floor(budget / slope))
+                  : max_allowed_batch_size_;
+    max_batch_size_ = std::max<int64_t>(1, max_batch_size_);
+    // The largest timeout T with T + slope * (1 + rate * T) <= budget.
+    batch_timeout_micros_ = std::min<double>(
+        latency_target_micros_,
+        (budget - slope) / (1 + slope * arrival_rate_));
+  }
+  RecordBatchTimeoutMicros(batch_timeout_micros_, name_);
+  RecordMaxBatchSize(max_batch_size_, name_);
+}
+
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
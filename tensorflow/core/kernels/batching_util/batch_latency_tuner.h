@@ -0,0 +1,95 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
+
+#include <string>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+
+// BatchLatencyTuner picks the batch timeout and the batch size at which a
+// queue closes batches so as to maximize throughput while keeping the
+// latency of tasks within a target.
+//
+// It models the processing time of a batch as `a + b * batch_size`, fitted by
+// exponentially weighted least squares on the observed processing times, plus
+// a margin of 2.33 standard deviations of the fitting error, which approximates
+// the 99th percentile, and tracks the rate at which task units arrive. The
+// task that opens a batch waits for the timeout and then for the processing of
+// the batch, of about `1 + arrival_rate * timeout` units, so the timeout is the
+// largest one for which that stays within the target. The batch size is capped
+// at the largest one that can be processed within the target.
+//
+// The choices are exported through the
+// /tensorflow/serving/batching/latency_tuner/* gauges, labeled by `name`.
+//
+// This is an internal helper of internal::Queue<TaskType>; it is thread-
+// compatible, and the queue calls it under its lock.
+class BatchLatencyTuner {
+ public:
+  // `initial_batch_timeout_micros` is used until the first batch has been
+  // processed; it is capped at `latency_target_micros`.
+  BatchLatencyTuner(const std::string& name, int64_t latency_target_micros,
+                    int64_t max_batch_size,
+                    int64_t initial_batch_timeout_micros);
+
+  // Records that a task of `task_size` units was enqueued.
+  void RecordTask(int64_t task_size);
+
+  // Records that a batch of `batch_size` units took `processing_micros` to
+  // process, and updates the choices. `now_micros` is the time at which it
+  // finished.
+  void RecordBatch(int64_t batch_size, int64_t processing_micros,
+                   uint64 now_micros);
+
+  int64_t batch_timeout_micros() const { return batch_timeout_micros_; }
+  int64_t max_batch_size() const { return max_batch_size_; }
+
+ private:
+  void UpdateChoices();
+
+  const std::string name_;
+  const int64_t latency_target_micros_;
+  const int64_t max_allowed_batch_size_;
+
+  int64_t batch_timeout_micros_;
+  int64_t max_batch_size_;
+
+  // Exponentially weighted sums for the least squares fit of processing time
+  // (y) against batch size (x).
+  double weight_sum_ = 0;
+  double x_sum_ = 0;
+  double y_sum_ = 0;
+  double xx_sum_ = 0;
+  double xy_sum_ = 0;
+  double yy_sum_ = 0;
+
+  // Task units enqueued since `rate_start_micros_`, and the smoothed arrival
+  // rate in units per microsecond.
+  double units_since_rate_start_ = 0;
+  uint64 rate_start_micros_ = 0;
+  double arrival_rate_ = 0;
+};
+
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_tuner.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+namespace {
+
+// Records batches of sizes 10 and 20 that take 1000 + 100 * size micros.
+void RecordLinearCostBatches(BatchLatencyTuner* tuner) {
+  uint64 now_micros = 1;
+  for (int i = 0; i < 20; ++i) {
+    const int64_t batch_size = i % 2 == 0 ? 10 : 20;
+    const int64_t processing_micros = 1000 + 100 * batch_size;
+    now_micros += processing_micros;
+    tuner->RecordBatch(batch_size, processing_micros, now_micros);
+  }
+}
+
+TEST(BatchLatencyTunerTest, InitialChoices) {
+  BatchLatencyTuner tuner("initial", /*latency_target_micros=*/1000,
+                          /*max_batch_size=*/32,
+                          /*initial_batch_timeout_micros=*/5000);
+  EXPECT_EQ(tuner.batch_timeout_micros(), 1000);
+  EXPECT_EQ(tuner.max_batch_size(), 32);
+}
+
+TEST(BatchLatencyTunerTest, LinearCost) {
+  BatchLatencyTuner tuner("linear", /*latency_target_micros=*/5050,
+                          /*max_batch_size=*/100,
+                          /*initial_batch_timeout_micros=*/0);
+  RecordLinearCostBatches(&tuner);
+  // 1000 + 100 * 40 <= 5050 < 1000 + 100 * 41.
+  EXPECT_EQ(tuner.max_batch_size(), 40);
+  // No tasks arrive, so the opening task is alone in its batch and can wait
+  // 5050 - 1000 - 100 micros.
+  EXPECT_NEAR(tuner.batch_timeout_micros(), 3950, 1);
+}
+
+TEST(BatchLatencyTunerTest, MaxBatchSizeIsCapped) {
+  BatchLatencyTuner tuner("capped", /*latency_target_micros=*/5050,
+                          /*max_batch_size=*/16,
+                          /*initial_batch_timeout_micros=*/0);
+  RecordLinearCostBatches(&tuner);
+  EXPECT_EQ(tuner.max_batch_size(), 16);
+}
+
+TEST(BatchLatencyTunerTest, HigherArrivalRateShortensTimeout) {
+  BatchLatencyTuner idle("idle", /*latency_target_micros=*/5050,
+                         /*max_batch_size=*/100,
+                         /*initial_batch_timeout_micros=*/0);
+  BatchLatencyTuner busy("busy", /*latency_target_micros=*/5050,
+                         /*max_batch_size=*/100,
+                         /*initial_batch_timeout_micros=*/0);
+  uint64 now_micros = 1;
+  for (int i = 0; i < 20; ++i) {
+    const int64_t batch_size = i % 2 == 0 ? 10 : 20;
+    const int64_t processing_micros = 1000 + 100 * batch_size;
+    now_micros += processing_micros;
+    busy.RecordTask(batch_size);
+    idle.RecordBatch(batch_size, processing_micros, now_micros);
+    busy.RecordBatch(batch_size, processing_micros, now_micros);
+  }
+  EXPECT_EQ(busy.max_batch_size(), idle.max_batch_size());
+  EXPECT_GT(busy.batch_timeout_micros(), 0);
+  EXPECT_LT(busy.batch_timeout_micros(), idle.batch_timeout_micros());
+}
+
+TEST(BatchLatencyTunerTest, UnreachableTarget) {
+  BatchLatencyTuner tuner("unreachable", /*latency_target_micros=*/500,
+                          /*max_batch_size=*/100,
+                          /*initial_batch_timeout_micros=*/100);
+  RecordLinearCostBatches(&tuner);
+  EXPECT_EQ(tuner.max_batch_size(), 1);
+  EXPECT_EQ(tuner.batch_timeout_micros(), 0);
+}
+
+TEST(BatchLatencyTunerTest, SingleBatchSizeAssumesProportionalCost) {
+  BatchLatencyTuner tuner("single_size", /*latency_target_micros=*/10000,
+                          /*max_batch_size=*/100,
+                          /*initial_batch_timeout_micros=*/0);
+  for (int i = 0; i < 10; ++i) {
+    tuner.RecordBatch(/*batch_size=*/8, /*processing_micros=*/800, i + 1);
+  }
+  // 100 micros per unit.
+  EXPECT_EQ(tuner.max_batch_size(), 100);
+  EXPECT_NEAR(tuner.batch_timeout_micros(), 9900, 1);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -185,6 +186,27 @@ void RecordBatchParamAllowedBatchSizes(const string& allowed_batch_sizes,
   cell->GetCell(model_name, op_name)->Set(allowed_batch_sizes);
 }
 
+void RecordQueueDepth(int64_t queue_depth, const string& model_name,
+                      const string& op_name, int priority) {
+  static auto* cell = monitoring::Gauge<int64_t, 3>::New(
+      "/tensorflow/serving/batching/queue_depth",
+      "Tracks the number of tasks waiting to be batched, as seen by arriving "
+      "tasks, by model_name (if available), op_name and priority.",
+      "model_name", "op_name", "priority");
+  cell->GetCell(model_name, op_name, absl::StrCat(priority))->Set(queue_depth);
+}
+
+void RecordExpiredTask(const string& model_name, const string& op_name,
+                       int priority) {
+  static auto* cell = monitoring::Counter<3>::New(
+      "/tensorflow/serving/batching/expired_task_count",
+      "Tracks the number of tasks dropped because their deadline passed before "
+      "their batch was processed, by model_name (if available), op_name and "
+      "priority.",
+      "model_name", "op_name", "priority");
+  cell->GetCell(model_name, op_name, absl::StrCat(priority))->IncrementBy(1);
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -192,6 +214,45 @@ const string& GetModelName(OpKernelContext* ctx) {
   return ctx->session_metadata()->name();
 }
 
+// Fails the tasks of 'batch' whose deadline has passed with DeadlineExceeded,
+// and returns a closed batch with the other tasks, which may be empty.
+std::unique_ptr<BatchResourceBase::BatchT> DropExpiredTasks(
+    std::unique_ptr<BatchResourceBase::BatchT> batch) {
+  const absl::Time now = absl::Now();
+  auto is_expired = [now](const BatchResourceBase::BatchTask& task) {
+    return task.deadline.has_value() && *task.deadline <= now;
+  };
+  bool has_expired_task = false;
+  for (int i = 0; i < batch->num_tasks() && !has_expired_task; ++i) {
+    has_expired_task = is_expired(batch->task(i));
+  }
+  if (!has_expired_task) {
+    return batch;
+  }
+
+  auto remaining_batch =
+      absl::make_unique<BatchResourceBase::BatchT>(batch->traceme_context_id());
+  for (auto& task : batch->RemoveAllTasks()) {
+    if (!is_expired(*task)) {
+      remaining_batch->AddTask(std::move(task));
+      continue;
+    }
+    RecordExpiredTask(GetModelName(task->context),
+                      task->context->op_kernel().name(), task->priority);
+    const Status status = errors::DeadlineExceeded(
+        "The deadline of the batched op invocation passed before its batch "
+        "was processed.");
+    if (task->is_partial) {
+      task->status->Update(status);
+    } else {
+      task->context->SetStatus(status);
+    }
+    task->done_callback();
+  }
+  remaining_batch->Close();
+  return remaining_batch;
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -210,6 +271,8 @@ BatchResourceBase::BatchTask::CreateSplitTask(
   task->status = this->status;
   task->is_partial = true;
   task->start_time = this->start_time;
+  task->priority = this->priority;
+  task->deadline = this->deadline;
   task->request_cost = this->request_cost;
 
   return task;
@@ -222,9 +285,18 @@ using TensorMatrix = std::vector<std::vector<Tensor>>;
 Status BatchResourceBase::RegisterInput(
     int64_t guid, OpKernelContext* context, const string& batcher_queue_name,
     AsyncOpKernel::DoneCallback done_callback) {
+  return RegisterInput(guid, context, batcher_queue_name, /*priority=*/0,
+                       std::move(done_callback));
+}
+
+Status BatchResourceBase::RegisterInput(
+    int64_t guid, OpKernelContext* context, const string& batcher_queue_name,
+    int priority, AsyncOpKernel::DoneCallback done_callback) {
   std::unique_ptr<BatchTask> batch_components;
   TF_RETURN_IF_ERROR(CreateBatchTask(context, &batch_components));
   batch_components->start_time = EnvTime::NowNanos();
+  batch_components->priority = priority;
+  batch_components->deadline = context->deadline();
   batch_components->guid = guid;
   batch_components->propagated_context = Context(ContextKind::kThread);
   OpInputList tensors;
@@ -294,8 +366,10 @@ Status BatchResourceBase::RegisterInput(
   }
 
   BatcherQueueT* batcher_queue;
-  TF_RETURN_IF_ERROR(
-      LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+  TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(batcher_queue_name, priority,
+                                                &batcher_queue));
+  RecordQueueDepth(batcher_queue->NumEnqueuedTasks(), GetModelName(context),
+                   context->op_kernel().name(), priority);
   return batcher_queue->Schedule(&batch_components);
 }
 
@@ -391,6 +465,17 @@ int BatchResourceBase::RoundToLowestAllowedBatchSize(int batch_size) const {
   return batch_size;
 }
 
+/*static*/ bool BatchResourceBase::ForwardSingleTaskInputs(
+    const BatchT& batch, int padding_amount,
+    std::vector<Tensor>* batch_inputs) {
+  if (batch.num_tasks() != 1 || padding_amount != 0) {
+    return false;
+  }
+  const std::vector<Tensor>& inputs = batch.task(0).inputs;
+  batch_inputs->insert(batch_inputs->end(), inputs.begin(), inputs.end());
+  return true;
+}
+
 Status BatchResourceBase::ConcatInputTensors(
     const BatchT& batch, OpKernelContext* context,
     std::vector<Tensor>* concatenated_tensors) const {
@@ -418,6 +503,10 @@ Status BatchResourceBase::ConcatInputTensors(
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
 
+  if (ForwardSingleTaskInputs(batch, padding_amount, concatenated_tensors)) {
+    return Status::OK();
+  }
+
   // Process each input one at a time (the typical case has just one).
   for (int i = 0; i < num_inputs; ++i) {
     // Concatenate the tasks ith input tensors into a big output tensor.
@@ -552,6 +641,31 @@ Status BatchResourceBase::ConcatInputTensors(
   return Status::OK();
 }
 
+/*static*/ Status BatchResourceBase::SplitIntoSlices(
+    const Tensor& tensor, const std::vector<int64_t>& sizes,
+    std::vector<Tensor>* split_tensors) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype()) && tensor.dtype() != DT_STRING) {
+    return tensor::Split(tensor, sizes, split_tensors);
+  }
+  if (tensor.dims() == 0) {
+    return errors::InvalidArgument("Cannot split a zero-dimensional tensor");
+  }
+  int64_t start = 0;
+  for (int64_t size : sizes) {
+    if (size < 0 || start + size > tensor.dim_size(0)) break;
+    Tensor slice = tensor.Slice(start, start + size);
+    split_tensors->push_back(slice.IsAligned() ? slice
+                                               : tensor::DeepCopy(slice));
+    start += size;
+  }
+  if (start != tensor.dim_size(0) || split_tensors->size() != sizes.size()) {
+    return errors::InvalidArgument(
+        "The values in 'sizes' do not sum to the zeroth-dimension size of "
+        "'tensor'");
+  }
+  return Status::OK();
+}
+
 Status BatchResourceBase::SplitOutputTensors(
     const std::vector<Tensor>& combined_outputs, BatchT* batch) const {
   DCHECK_GE(batch->num_tasks(), 1);
@@ -595,7 +709,7 @@ Status BatchResourceBase::SplitOutputTensors(
     }
 
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
+    const Status split_status = SplitIntoSlices(
         output_tensor, task_sizes_plus_optional_padding, &split_tensor);
     DCHECK(split_status.ok()) << split_status.ToString();
     if (!split_status.ok()) {
@@ -626,6 +740,7 @@ Status BatchResourceBase::SplitOutputTensors(
 }
 
 void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
+  batch = DropExpiredTasks(std::move(batch));
   if (batch->empty()) {
     return;
   }
@@ -635,9 +750,10 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   // which are running this Session, of which this BatchOp is a part.
   WithContext wc(batch->task(batch->num_tasks() - 1).propagated_context);
 
-  // Creates the CostMeasurement within the same context that runs the Session.
-  std::unique_ptr<CostMeasurement> batch_cost_measurement =
-      CreateCostMeasurement();
+  // Creates the CostMeasurements within the same context that runs the
+  // Session.
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements =
+      CreateCostMeasurements();
 
   auto& last_task = batch->task(batch->num_tasks() - 1);
   OpKernelContext* last_task_context = last_task.context;
@@ -649,11 +765,12 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   bool cleanup_done = false;
   int64_t processed_size = batch->size();
   auto cleanup_fn = [&cleanup_done, &batch, &processed_size,
-                     &batch_cost_measurement](const Status& status) {
+                     &batch_cost_measurements](const Status& status) {
     if (cleanup_done) {
       return;
     }
-    SplitBatchCost(batch_cost_measurement.get(), processed_size, *batch);
+    SplitBatchCostsAndRecordMetrics(batch_cost_measurements, processed_size,
+                                    *batch);
     for (int i = 0; i < batch->num_tasks(); ++i) {
       if (batch->task(i).is_partial) {
         batch->mutable_task(i)->status->Update(status);
@@ -722,6 +839,7 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
 
 // Processes a batch of one or more BatchTask entries.
 void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
+  batch = DropExpiredTasks(std::move(batch));
   if (batch->empty()) {
     return;
   }
@@ -731,13 +849,15 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   // which are running this Session, of which this BatchOp is a part.
   WithContext wc(batch->task(batch->num_tasks() - 1).propagated_context);
 
-  // Creates the CostMeasurement within the same context that runs the Session.
-  std::unique_ptr<CostMeasurement> batch_cost_measurement =
-      CreateCostMeasurement();
+  // Creates the CostMeasurements within the same context that runs the
+  // Session.
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements =
+      CreateCostMeasurements();
 
   int64_t processed_size = batch->size();
   auto batch_cost_split_cleanup = gtl::MakeCleanup([&] {
-    SplitBatchCost(batch_cost_measurement.get(), processed_size, *batch);
+    SplitBatchCostsAndRecordMetrics(batch_cost_measurements, processed_size,
+                                    *batch);
   });
 
   OpKernelContext* last_task_context =
@@ -822,13 +942,19 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   return Status::OK();
 }
 
-// Looks up the batcher queue for 'queue_name'. If it did't previously exist,
-// creates it.
+// Looks up the batcher queue for 'queue_name' and 'priority'. If it did't
+// previously exist, creates it.
 Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
+                                                     int priority,
                                                      BatcherQueueT** queue) {
+  // Tasks of different priorities are batched in different queues, which the
+  // shared batch scheduler services in order of priority.
+  const string queue_key =
+      priority == 0 ? queue_name
+                    : absl::StrCat(queue_name, "/priority:", priority);
   mutex_lock l(batcher_queues_mu_);
 
-  auto it = batcher_queues_.find(queue_name);
+  auto it = batcher_queues_.find(queue_key);
   if (it != batcher_queues_.end()) {
     *queue = it->second.get();
     return Status::OK();
@@ -843,7 +969,9 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
     }
   };
   if (batcher_) {
-    TF_RETURN_IF_ERROR(batcher_->AddQueue(batcher_queue_options_,
+    BatcherT::QueueOptions batcher_queue_options = batcher_queue_options_;
+    batcher_queue_options.priority = priority;
+    TF_RETURN_IF_ERROR(batcher_->AddQueue(batcher_queue_options,
                                           process_batch_callback, &new_queue));
   } else if (adaptive_batcher_) {
     TF_RETURN_IF_ERROR(adaptive_batcher_->AddQueue(
@@ -852,7 +980,7 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
     return errors::Internal("No batcher defined.");
   }
   *queue = new_queue.get();
-  batcher_queues_[queue_name] = std::move(new_queue);
+  batcher_queues_[queue_key] = std::move(new_queue);
   return Status::OK();
 }
 
@@ -863,43 +991,61 @@ Status BatchResourceBase::CreateBatchTask(
   return Status::OK();
 }
 
-void BatchResourceBase::SplitBatchCost(CostMeasurement* batch_cost_measurement,
-                                       const int64_t processed_size,
-                                       BatchT& batch) {
-  if (batch_cost_measurement == nullptr ||
-      batch_cost_measurement->GetTotalCost() <= absl::ZeroDuration()) {
-    return;
-  }
-  if (batch.size() == 0) {  // NOLINT: empty() checks the batch contains 0
-                            // tasks. size() gets the sum of task sizes.
-    LOG_EVERY_N_SEC(ERROR, 60)
-        << "Non-zero cost collected but the batch size is 0.";
-    return;
-  }
-  if (processed_size == 0) {
-    LOG_EVERY_N_SEC(ERROR, 60)
-        << "Non-zero cost collected but the processed size is 0.";
-    return;
+void BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+    const std::vector<std::unique_ptr<CostMeasurement>>&
+        batch_cost_measurements,
+    const int64_t processed_size, BatchT& batch) {
+  absl::flat_hash_map<std::string, absl::Duration> batch_costs;
+  // 1. Split the batch costs to each task.
+  for (const auto& batch_cost_measurement : batch_cost_measurements) {
+    if (batch_cost_measurement->GetTotalCost() <= absl::ZeroDuration()) {
+      continue;
+    }
+    if (batch.size() == 0) {  // NOLINT: empty() checks the batch contains 0
+                              // tasks. size() gets the sum of task sizes.
+      LOG_EVERY_N_SEC(ERROR, 60)
+          << "Non-zero cost collected but the batch size is 0.";
+      return;
+    }
+    if (processed_size == 0) {
+      LOG_EVERY_N_SEC(ERROR, 60)
+          << "Non-zero cost collected but the processed size is 0.";
+      return;
+    }
+    const absl::string_view cost_type = batch_cost_measurement->GetCostType();
+    const absl::Duration total_cost = batch_cost_measurement->GetTotalCost();
+    batch_costs[cost_type] = total_cost;
+
+    for (int i = 0; i < batch.num_tasks(); i++) {
+      RequestCost* request_cost = batch.task(i).request_cost;
+      // Skip recording the cost if the request_cost is null.
+      if (!request_cost) continue;
+
+      // Smeared cost: cost of paddings are assigned to each task.
+      const auto cost_with_smear =
+          total_cost / batch.size() * batch.task(i).size();
+
+      // Non-smeared cost: cost of paddings are not assigned to any tasks.
+      const auto cost_no_smear =
+          total_cost / processed_size * batch.task(i).size();
+
+      request_cost->RecordCost(
+          {{absl::StrCat(cost_type, kWithSmearSuffix), cost_with_smear},
+           {absl::StrCat(cost_type, kNoSmearSuffix), cost_no_smear}});
+    }
   }
-  const absl::string_view cost_type = batch_cost_measurement->GetCostType();
-  const absl::Duration total_cost = batch_cost_measurement->GetTotalCost();
 
+  // 2. Record the batch metrics for each task.
+  const int64_t padding_size =
+      processed_size - static_cast<int64_t>(batch.size());
   for (int i = 0; i < batch.num_tasks(); i++) {
     RequestCost* request_cost = batch.task(i).request_cost;
-    // Skip recording the cost if the request_cost is null.
+    // Skip recording the metrics if the request_cost is null.
     if (!request_cost) continue;
 
-    // Smeared cost: cost of paddings are assigned to each task.
-    const auto cost_with_smear =
-        total_cost / batch.size() * batch.task(i).size();
-
-    // Non-smeared cost: cost of paddings are not assigned to any tasks.
-    const auto cost_no_smear =
-        total_cost / processed_size * batch.task(i).size();
-
-    request_cost->RecordCost(
-        {{absl::StrCat(cost_type, kWithSmearSuffix), cost_with_smear},
-         {absl::StrCat(cost_type, kNoSmearSuffix), cost_no_smear}});
+    request_cost->RecordBatchMetrics(RequestCost::BatchMetrics{
+        processed_size, static_cast<int64_t>(batch.task(i).size()),
+        padding_size, batch_costs});
   }
 }
 
@@ -17,8 +17,12 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_RESOURCE_BASE_H_
 
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/request_cost.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -52,6 +56,13 @@ class BatchResourceBase : public ResourceBase {
                        const string& batcher_queue_name,
                        AsyncOpKernel::DoneCallback done_callback);
 
+  // Like above, but the data is batched with that of other invocations with
+  // the same 'priority' only. Batches of a higher priority are processed
+  // before those of a lower one, with a SharedBatchScheduler.
+  Status RegisterInput(int64_t guid, OpKernelContext* context,
+                       const string& batcher_queue_name, int priority,
+                       AsyncOpKernel::DoneCallback done_callback);
+
  public:
   // One task to be batched, corresponds to a `slice` of input from one batch-op
   // invocation.
@@ -93,6 +104,12 @@ class BatchResourceBase : public ResourceBase {
 
     uint64 start_time;
 
+    // The priority the task was registered with, and the deadline of the op
+    // invocation, if any. Tasks whose deadline has passed by the time their
+    // batch is processed fail with DeadlineExceeded instead of being run.
+    int priority = 0;
+    absl::optional<absl::Time> deadline;
+
     size_t size() const override { return inputs[0].shape().dim_size(0); }
 
     // Create a split task from this one. The caller needs to setup the inputs
@@ -177,23 +194,42 @@ class BatchResourceBase : public ResourceBase {
       int max_batch_size,
       std::vector<std::unique_ptr<BatchTask>>* output_tasks);
 
-  // Splits the batch cost to each task.
+  // Splits 'tensor' along its 0th dimension into pieces of 'sizes' rows, like
+  // tensor::Split. Pieces that are suitably aligned alias the buffer of
+  // 'tensor' instead of copying it, which keeps the whole buffer alive as long
+  // as any of them is.
+  static Status SplitIntoSlices(const Tensor& tensor,
+                                const std::vector<int64_t>& sizes,
+                                std::vector<Tensor>* split_tensors);
+
+  // If 'batch' consists of a single task and needs no padding, appends the
+  // inputs of that task to 'batch_inputs' and returns true: they already form
+  // the batch, and need not be concatenated. Returns false otherwise.
+  static bool ForwardSingleTaskInputs(const BatchT& batch, int padding_amount,
+                                      std::vector<Tensor>* batch_inputs);
+
+  // Splits the batch costs to each task, and records the batch metrics.
   //
   // Inputs:
-  // 1) batch_cost_measurement, which provides the total cost and cost type;
+  // 1) batch_cost_measurements, which provide the total cost of each cost type;
   // 2) processed_size, it's the batch size plus the padding amount;
   // 3) batch, provides the batch size.
   //
   // Outputs:
   // The request_cost in each batch task will be updated. This function will use
-  // two approaches to split the batch cost (if it's non-zero), thus two costs
-  // will be output.
+  // two approaches to split each batch cost (if it's non-zero), thus two costs
+  // will be output per cost type.
   // 1) smeared cost: batch cost is split proportionally to each task's size,
   //    and paddings do not share any cost;
   // 2) non-smeared cost: batch cost is split proportionally to each task or
   //    padding's size. Here padding's cost is not assigned to any tasks.
-  static void SplitBatchCost(CostMeasurement* batch_cost_measurement,
-                             const int64_t processed_size, BatchT& batch);
+  // The batch metrics (processed size, task size, padding size and batch
+  // costs) are also recorded in the request_cost of each task, to tell how
+  // much of each batch served each request.
+  static void SplitBatchCostsAndRecordMetrics(
+      const std::vector<std::unique_ptr<CostMeasurement>>&
+          batch_cost_measurements,
+      const int64_t processed_size, BatchT& batch);
 
  private:
   // Implementation of calling the process batch function.
@@ -237,9 +273,9 @@ class BatchResourceBase : public ResourceBase {
   static Status EmitIndexTensor(OpKernelContext* context, const BatchT& batch,
                                 int output_index);
 
-  // Looks up the batcher queue for 'queue_name'. If it did't previously exist,
-  // creates it.
-  Status LookupOrCreateBatcherQueue(const string& queue_name,
+  // Looks up the batcher queue for 'queue_name' and 'priority'. If it did't
+  // previously exist, creates it.
+  Status LookupOrCreateBatcherQueue(const string& queue_name, int priority,
                                     BatcherQueueT** queue);
 
   // True if user specified a batch processing function for this resource.
@@ -252,7 +288,7 @@ class BatchResourceBase : public ResourceBase {
   std::shared_ptr<AdaptiveBatcherT> adaptive_batcher_;
   AdaptiveBatcherT::QueueOptions adaptive_batcher_queue_options_;
 
-  // A collection of batcher queues, keyed on queue name.
+  // A collection of batcher queues, keyed on queue name and priority.
   // TODO(olston): Garbage-collect unused queues (perhaps simply remove empty
   // ones (with a time delay?); it's okay if they get recreated later).
   mutable mutex batcher_queues_mu_;
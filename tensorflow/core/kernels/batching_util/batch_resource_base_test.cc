@@ -15,8 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/no_op_cost_measurement.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -32,6 +38,12 @@ class TestCostMeasurement : public CostMeasurement {
   absl::string_view GetCostType() const override { return "test"; }
 };
 
+class OtherTestCostMeasurement : public CostMeasurement {
+ public:
+  absl::Duration GetTotalCost() override { return absl::Milliseconds(20); }
+  absl::string_view GetCostType() const override { return "other_test"; }
+};
+
 std::unique_ptr<BatchResourceBase::BatchTask> MakeBatchTask(
     const int64_t task_size, RequestCost* request_cost) {
   auto task = absl::make_unique<BatchResourceBase::BatchTask>();
@@ -40,61 +52,73 @@ std::unique_ptr<BatchResourceBase::BatchTask> MakeBatchTask(
   return task;
 }
 
-TEST(SplitBatchCostTest, SkipOnNoCostMeasurement) {
+TEST(SplitBatchCostsAndRecordMetricsTest, SkipOnNoCostMeasurement) {
   BatchResourceBase::BatchT batch;
   RequestCost cost;
   batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost));
   batch.Close();
-  BatchResourceBase::SplitBatchCost(/*batch_cost_measurement*/ nullptr,
-                                    /*processed_size=*/16, batch);
+
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/16, batch);
   EXPECT_TRUE(batch.task(0).request_cost->GetCosts().empty());
+  ASSERT_EQ(batch.task(0).request_cost->GetBatchMetrics().size(), 1);
+  EXPECT_TRUE(
+      batch.task(0).request_cost->GetBatchMetrics()[0].batch_costs.empty());
 }
 
-TEST(SplitBatchCostTest, SkipOnZeroCost) {
+TEST(SplitBatchCostsAndRecordMetricsTest, SkipOnZeroCost) {
   BatchResourceBase::BatchT batch;
   RequestCost cost;
   batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost));
   batch.Close();
 
-  NoOpCostMeasurement no_op_cost_measurement;
-  BatchResourceBase::SplitBatchCost(&no_op_cost_measurement,
-                                    /*processed_size=*/16, batch);
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(absl::make_unique<NoOpCostMeasurement>());
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/16, batch);
   EXPECT_TRUE(batch.task(0).request_cost->GetCosts().empty());
+  ASSERT_EQ(batch.task(0).request_cost->GetBatchMetrics().size(), 1);
+  EXPECT_TRUE(
+      batch.task(0).request_cost->GetBatchMetrics()[0].batch_costs.empty());
 }
 
-TEST(SplitBatchCostTest, SkipOnZeroBatchSize) {
+TEST(SplitBatchCostsAndRecordMetricsTest, SkipOnZeroBatchSize) {
   BatchResourceBase::BatchT batch;
   batch.Close();
 
-  TestCostMeasurement test_cost_measurement;
-  BatchResourceBase::SplitBatchCost(&test_cost_measurement,
-                                    /*processed_size=*/0, batch);
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(absl::make_unique<TestCostMeasurement>());
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/0, batch);
 }
 
-TEST(SplitBatchCostTest, SkipOnNoRequestCost) {
+TEST(SplitBatchCostsAndRecordMetricsTest, SkipOnNoRequestCost) {
   BatchResourceBase::BatchT batch;
   batch.AddTask(MakeBatchTask(/*task_size=*/1, nullptr));
   batch.AddTask(MakeBatchTask(/*task_size=*/9, nullptr));
   batch.Close();
 
-  TestCostMeasurement test_cost_measurement;
-  BatchResourceBase::SplitBatchCost(&test_cost_measurement,
-                                    /*processed_size=*/16, batch);
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(absl::make_unique<TestCostMeasurement>());
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/16, batch);
 
   EXPECT_EQ(batch.task(0).request_cost, nullptr);
   EXPECT_EQ(batch.task(1).request_cost, nullptr);
 }
 
-TEST(SplitBatchCostTest, Basic) {
+TEST(SplitBatchCostsAndRecordMetricsTest, Basic) {
   BatchResourceBase::BatchT batch;
   RequestCost cost1, cost2;
   batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost1));
   batch.AddTask(MakeBatchTask(/*task_size=*/9, &cost2));
   batch.Close();
 
-  TestCostMeasurement test_cost_measurement;
-  BatchResourceBase::SplitBatchCost(&test_cost_measurement,
-                                    /*processed_size=*/20, batch);
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(absl::make_unique<TestCostMeasurement>());
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/20, batch);
 
   EXPECT_THAT(
       batch.task(0).request_cost->GetCosts(),
@@ -104,6 +128,139 @@ TEST(SplitBatchCostTest, Basic) {
       batch.task(1).request_cost->GetCosts(),
       UnorderedElementsAre(Pair("test_with_smear", absl::Milliseconds(90)),
                            Pair("test_no_smear", absl::Milliseconds(45))));
+
+  ASSERT_EQ(batch.task(0).request_cost->GetBatchMetrics().size(), 1);
+  const RequestCost::BatchMetrics batch_metrics1 =
+      batch.task(0).request_cost->GetBatchMetrics()[0];
+  EXPECT_EQ(batch_metrics1.processed_size, 20);
+  EXPECT_EQ(batch_metrics1.input_size, 1);
+  EXPECT_EQ(batch_metrics1.padding_size, 10);
+  EXPECT_THAT(batch_metrics1.batch_costs,
+              UnorderedElementsAre(Pair("test", absl::Milliseconds(100))));
+
+  ASSERT_EQ(batch.task(1).request_cost->GetBatchMetrics().size(), 1);
+  const RequestCost::BatchMetrics batch_metrics2 =
+      batch.task(1).request_cost->GetBatchMetrics()[0];
+  EXPECT_EQ(batch_metrics2.processed_size, 20);
+  EXPECT_EQ(batch_metrics2.input_size, 9);
+  EXPECT_EQ(batch_metrics2.padding_size, 10);
+  EXPECT_THAT(batch_metrics2.batch_costs,
+              UnorderedElementsAre(Pair("test", absl::Milliseconds(100))));
+}
+
+TEST(SplitBatchCostsAndRecordMetricsTest, SplitsMultiCostTypes) {
+  BatchResourceBase::BatchT batch;
+  RequestCost cost1, cost2;
+  batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost1));
+  batch.AddTask(MakeBatchTask(/*task_size=*/9, &cost2));
+  batch.Close();
+
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(absl::make_unique<TestCostMeasurement>());
+  batch_cost_measurements.push_back(
+      absl::make_unique<OtherTestCostMeasurement>());
+  BatchResourceBase::SplitBatchCostsAndRecordMetrics(
+      batch_cost_measurements, /*processed_size=*/20, batch);
+
+  EXPECT_THAT(
+      batch.task(0).request_cost->GetCosts(),
+      UnorderedElementsAre(Pair("test_with_smear", absl::Milliseconds(10)),
+                           Pair("test_no_smear", absl::Milliseconds(5)),
+                           Pair("other_test_with_smear", absl::Milliseconds(2)),
+                           Pair("other_test_no_smear", absl::Milliseconds(1))));
+  EXPECT_THAT(
+      batch.task(1).request_cost->GetCosts(),
+      UnorderedElementsAre(
+          Pair("test_with_smear", absl::Milliseconds(90)),
+          Pair("test_no_smear", absl::Milliseconds(45)),
+          Pair("other_test_with_smear", absl::Milliseconds(18)),
+          Pair("other_test_no_smear", absl::Milliseconds(9))));
+
+  ASSERT_EQ(batch.task(0).request_cost->GetBatchMetrics().size(), 1);
+  EXPECT_THAT(
+      batch.task(0).request_cost->GetBatchMetrics()[0].batch_costs,
+      UnorderedElementsAre(Pair("test", absl::Milliseconds(100)),
+                           Pair("other_test", absl::Milliseconds(20))));
+}
+
+TEST(SplitIntoSlicesTest, AlignedSlicesAliasTheBatch) {
+  // 16 doubles per row keep every slice aligned.
+  Tensor batch_output(DT_DOUBLE, TensorShape({4, 16}));
+  test::FillIota<double>(&batch_output, 0.0);
+
+  std::vector<Tensor> slices;
+  TF_ASSERT_OK(BatchResourceBase::SplitIntoSlices(batch_output, {1, 3},
+                                                  &slices));
+  ASSERT_EQ(slices.size(), 2);
+  EXPECT_EQ(slices[0].shape(), TensorShape({1, 16}));
+  EXPECT_EQ(slices[1].shape(), TensorShape({3, 16}));
+  EXPECT_TRUE(slices[0].SharesBufferWith(batch_output));
+  EXPECT_TRUE(slices[1].SharesBufferWith(batch_output));
+  EXPECT_EQ(slices[1].matrix<double>()(0, 0), 16.0);
+
+  // The slices keep the batch output alive.
+  batch_output = Tensor();
+  EXPECT_EQ(slices[1].matrix<double>()(2, 15), 63.0);
+}
+
+TEST(SplitIntoSlicesTest, UnalignedSlicesAreCopied) {
+  Tensor batch_output(DT_DOUBLE, TensorShape({3, 1}));
+  test::FillValues<double>(&batch_output, {1.0, 2.0, 3.0});
+
+  std::vector<Tensor> slices;
+  TF_ASSERT_OK(BatchResourceBase::SplitIntoSlices(batch_output, {1, 2},
+                                                  &slices));
+  ASSERT_EQ(slices.size(), 2);
+  EXPECT_TRUE(slices[0].SharesBufferWith(batch_output));
+  EXPECT_FALSE(slices[1].SharesBufferWith(batch_output));
+  EXPECT_TRUE(slices[1].IsAligned());
+  test::ExpectTensorEqual<double>(
+      slices[1], test::AsTensor<double>({2.0, 3.0}, TensorShape({2, 1})));
+}
+
+TEST(SplitIntoSlicesTest, SizesMustCoverTheBatch) {
+  Tensor batch_output(DT_DOUBLE, TensorShape({4, 16}));
+  std::vector<Tensor> slices;
+  EXPECT_FALSE(
+      BatchResourceBase::SplitIntoSlices(batch_output, {1, 2}, &slices).ok());
+  slices.clear();
+  EXPECT_FALSE(
+      BatchResourceBase::SplitIntoSlices(batch_output, {3, 2}, &slices).ok());
+}
+
+TEST(ForwardSingleTaskInputsTest, ForwardsTheOnlyTask) {
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeBatchTask(/*task_size=*/8, nullptr));
+  batch.Close();
+
+  std::vector<Tensor> batch_inputs;
+  EXPECT_TRUE(BatchResourceBase::ForwardSingleTaskInputs(
+      batch, /*padding_amount=*/0, &batch_inputs));
+  ASSERT_EQ(batch_inputs.size(), 1);
+  EXPECT_TRUE(batch_inputs[0].SharesBufferWith(batch.task(0).inputs[0]));
+}
+
+TEST(ForwardSingleTaskInputsTest, DoesNotForwardPaddedBatch) {
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeBatchTask(/*task_size=*/7, nullptr));
+  batch.Close();
+
+  std::vector<Tensor> batch_inputs;
+  EXPECT_FALSE(BatchResourceBase::ForwardSingleTaskInputs(
+      batch, /*padding_amount=*/1, &batch_inputs));
+  EXPECT_TRUE(batch_inputs.empty());
+}
+
+TEST(ForwardSingleTaskInputsTest, DoesNotForwardMultipleTasks) {
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeBatchTask(/*task_size=*/4, nullptr));
+  batch.AddTask(MakeBatchTask(/*task_size=*/4, nullptr));
+  batch.Close();
+
+  std::vector<Tensor> batch_inputs;
+  EXPECT_FALSE(BatchResourceBase::ForwardSingleTaskInputs(
+      batch, /*padding_amount=*/0, &batch_inputs));
+  EXPECT_TRUE(batch_inputs.empty());
 }
 
 }  // namespace
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -26,10 +27,12 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/time/clock.h"
 #include "absl/types/variant.h"
 #include "absl/utility/utility.h"
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_tuner.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -83,6 +86,9 @@ namespace serving {
 // from a queue and then moving to the next queue. Each queue behaves like a
 // BasicBatchScheduler instance, in the sense that it has maximum batch size and
 // timeout parameters, which govern when a batch is eligible to be processed.
+// Queues may be given a priority (see QueueOptions::priority), in which case a
+// free batch thread takes a batch from the highest-priority queue that has
+// one, and only round-robins among queues of that priority.
 //
 // Each queue is independently configured with a maximum size (in terms of the
 // maximum number of batches worth of enqueued tasks). For online serving, it is
@@ -218,6 +224,28 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If positive, the queue adapts the batch timeout and the batch size at
+    // which it closes batches to the observed traffic, so as to maximize
+    // throughput while keeping the time from enqueueing a task to processing
+    // it within this target at the 99th percentile. The queue learns the
+    // processing time of batches as a function of their size, and tracks the
+    // arrival rate of tasks; see internal::BatchLatencyTuner for details.
+    //
+    // `batch_timeout_micros` is then only used until the first batch has been
+    // processed, and batches never exceed `max_execution_batch_size`. Time
+    // spent waiting for a batch thread is not accounted for, so there should
+    // be enough batch threads for the load.
+    int64_t latency_target_micros = 0;
+
+    // The label of the /tensorflow/serving/batching/latency_tuner/* gauges
+    // that export the choices of a queue with a `latency_target_micros`.
+    std::string latency_tuner_name = "unnamed";
+
+    // Batches of queues with a higher priority are processed before those of
+    // queues with a lower priority, as long as they are schedulable. A steady
+    // stream of high-priority batches may starve lower-priority queues.
+    int priority = 0;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -366,6 +394,8 @@ class Queue {
 
   bool closed() const TF_NO_THREAD_SAFETY_ANALYSIS { return closed_.load(); }
 
+  int priority() const { return options_.priority; }
+
  private:
   // Computes the max_execution_batch_size of the queue based on queue options.
   static size_t GetMaxExecutionBatchSize(
@@ -421,6 +451,11 @@ class Queue {
   // Returns the number of enqueued batches.
   int64 num_enqueued_batches() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // The timeout and size at which the open batch becomes schedulable; these
+  // are picked by `latency_tuner_` if the queue has a latency target.
+  int64_t batch_timeout_micros() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  size_t batch_close_size() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -465,6 +500,10 @@ class Queue {
   // The counter of the TraceMe context ids.
   uint64 traceme_context_id_counter_ TF_GUARDED_BY(mu_) = 0;
 
+  // Picks the batch timeout and close size; set iff
+  // `options_.latency_target_micros` is positive.
+  std::unique_ptr<BatchLatencyTuner> latency_tuner_ TF_GUARDED_BY(mu_);
+
   // The time at which the first task was added to the open (back-most) batch
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
@@ -588,6 +627,11 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "max_enqueued_batches must be positive; was ",
         options.max_enqueued_batches);
   }
+  if (options.latency_target_micros < 0) {
+    return errors::InvalidArgument(
+        "latency_target_micros must be non-negative; was ",
+        options.latency_target_micros);
+  }
 
   if (options.enable_large_batch_splitting &&
       options.split_input_task_func == nullptr) {
@@ -665,37 +709,58 @@ void SharedBatchScheduler<TaskType>::GetNextWorkItem_Locked(
     BatchUniquePtr* batch_to_process_out) {
   BatchUniquePtr batch_to_process;
   internal::Queue<TaskType>* queue_for_batch = nullptr;
-  const int num_queues = queues_.size();
-  for (int num_queues_tried = 0;
-       (BatchExists(batch_to_process)) && num_queues_tried < num_queues;
-       ++num_queues_tried) {
-    DCHECK(next_queue_to_schedule_ != queues_.end());
-
-    // If a closed queue responds to ScheduleBatch() with nullptr, the queue
-    // will never yield any further batches so we can drop it. To avoid a
-    // race, we take a snapshot of the queue's closedness state *before*
-    // calling ScheduleBatch().
-    const bool queue_closed = (*next_queue_to_schedule_)->closed();
 
-    // Ask '*next_queue_to_schedule_' if it wants us to process a batch.
-    batch_to_process = (*next_queue_to_schedule_)->ScheduleBatch();
-
-    if (!BatchExists(batch_to_process)) {
-      queue_for_batch = next_queue_to_schedule_->get();
-    }
-
-    // Advance 'next_queue_to_schedule_'.
-    if (queue_closed && (*next_queue_to_schedule_)->IsEmpty() &&
-        (BatchExists(batch_to_process))) {
-      // We've encountered a closed queue with no work to do. Drop it.
-      DCHECK_NE(queue_for_batch, next_queue_to_schedule_->get());
-      next_queue_to_schedule_ = queues_.erase(next_queue_to_schedule_);
-    } else {
-      ++next_queue_to_schedule_;
+  // Queues are asked for a batch in decreasing order of priority. Usually all
+  // queues have the same priority, and this is a single round-robin pass.
+  absl::InlinedVector<int, 4> priorities;
+  for (const auto& queue : queues_) {
+    priorities.push_back(queue->priority());
+  }
+  std::sort(priorities.begin(), priorities.end(), std::greater<int>());
+  priorities.erase(std::unique(priorities.begin(), priorities.end()),
+                   priorities.end());
+
+  for (const int priority : priorities) {
+    const int num_queues = queues_.size();
+    for (int num_queues_tried = 0;
+         (BatchExists(batch_to_process)) && num_queues_tried < num_queues;
+         ++num_queues_tried) {
+      DCHECK(next_queue_to_schedule_ != queues_.end());
+
+      if ((*next_queue_to_schedule_)->priority() == priority) {
+        // If a closed queue responds to ScheduleBatch() with nullptr, the
+        // queue will never yield any further batches so we can drop it. To
+        // avoid a race, we take a snapshot of the queue's closedness state
+        // *before* calling ScheduleBatch().
+        const bool queue_closed = (*next_queue_to_schedule_)->closed();
+
+        // Ask '*next_queue_to_schedule_' if it wants us to process a batch.
+        batch_to_process = (*next_queue_to_schedule_)->ScheduleBatch();
+
+        if (!BatchExists(batch_to_process)) {
+          queue_for_batch = next_queue_to_schedule_->get();
+        }
+
+        // Advance 'next_queue_to_schedule_'.
+        if (queue_closed && (*next_queue_to_schedule_)->IsEmpty() &&
+            (BatchExists(batch_to_process))) {
+          // We've encountered a closed queue with no work to do. Drop it.
+          DCHECK_NE(queue_for_batch, next_queue_to_schedule_->get());
+          next_queue_to_schedule_ = queues_.erase(next_queue_to_schedule_);
+        } else {
+          ++next_queue_to_schedule_;
+        }
+      } else {
+        // Queues of other priorities are visited in their own pass.
+        ++next_queue_to_schedule_;
+      }
+      if (next_queue_to_schedule_ == queues_.end() && !queues_.empty()) {
+        // We've hit the end. Wrap to the first queue.
+        next_queue_to_schedule_ = queues_.begin();
+      }
     }
-    if (next_queue_to_schedule_ == queues_.end() && !queues_.empty()) {
-      // We've hit the end. Wrap to the first queue.
-      next_queue_to_schedule_ = queues_.begin();
+    if (!BatchExists(batch_to_process)) {
+      break;
     }
   }
   *queue_for_batch_out = queue_for_batch;
@@ -768,6 +833,11 @@ Queue<TaskType>::Queue(
   // time of the queue. This prevents the batches in different queues to have
   // the same traceme_context_id_counter_.
   traceme_context_id_counter_ = absl::GetCurrentTimeNanos() << 32;
+  if (options_.latency_target_micros > 0) {
+    latency_tuner_ = std::make_unique<BatchLatencyTuner>(
+        options_.latency_tuner_name, options_.latency_target_micros,
+        max_execution_batch_size_, options_.batch_timeout_micros);
+  }
   // Create an initial, open batch.
   if (options_.enable_lazy_split) {
     task_handle_batches_.emplace_back(
@@ -812,6 +882,7 @@ Status Queue<TaskType>::ScheduleWithLazySplit(std::unique_ptr<TaskType>* task) {
   });
   // The max size to be enqueued.
   const int max_execution_batch_size = options_.max_execution_batch_size;
+  const int64_t input_task_size = (*task)->size();
 
   bool notify_of_schedulable_batch = false;
   {
@@ -852,6 +923,9 @@ Status Queue<TaskType>::ScheduleWithLazySplit(std::unique_ptr<TaskType>* task) {
 
       task_handle_batches_.back()->AddTask(std::move(task_handles[i]));
     }
+    if (latency_tuner_ != nullptr) {
+      latency_tuner_->RecordTask(input_task_size);
+    }
 
     if (!schedulable_batch_) {
       if (batches_.size() > 1 || IsOpenBatchSchedulable()) {
@@ -931,6 +1005,9 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplit(
           batches_.back()->traceme_context_id());
       batches_.back()->AddTask(std::move(output_tasks[i]));
     }
+    if (latency_tuner_ != nullptr) {
+      latency_tuner_->RecordTask(input_task_size);
+    }
 
     if (!schedulable_batch_) {
       if (batches_.size() > 1 || IsOpenBatchSchedulable()) {
@@ -1081,10 +1158,18 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const int64_t batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  const uint64 end_time_micros = env_->NowMicros();
 
   {
     mutex_lock l(mu_);
+    if (latency_tuner_ != nullptr) {
+      latency_tuner_->RecordBatch(batch_size,
+                                  end_time_micros - start_time_micros,
+                                  end_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -1154,9 +1239,9 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= batch_close_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
 }
 
 template <typename TaskType>
@@ -1169,9 +1254,9 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= batch_close_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
 }
 
 template <typename TaskType>
@@ -1191,6 +1276,22 @@ int64 Queue<TaskType>::num_enqueued_batches() const {
   return batches_.size();
 }
 
+template <typename TaskType>
+int64_t Queue<TaskType>::batch_timeout_micros() const {
+  if (latency_tuner_ != nullptr) {
+    return latency_tuner_->batch_timeout_micros();
+  }
+  return options_.batch_timeout_micros;
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::batch_close_size() const {
+  if (latency_tuner_ != nullptr) {
+    return latency_tuner_->max_batch_size();
+  }
+  return max_execution_batch_size();
+}
+
 template <typename TaskType>
 QueueHandle<TaskType>::QueueHandle(
     std::shared_ptr<SharedBatchScheduler<TaskType>> scheduler,
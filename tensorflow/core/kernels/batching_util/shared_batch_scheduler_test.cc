@@ -544,6 +544,53 @@ TEST_P(SharedBatchSchedulerTest, Fairness) {
   stop_teardown.Notify();
 }
 
+TEST_P(SharedBatchSchedulerTest, HigherPriorityQueueIsScheduledFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification high_first_batch_scheduled, high_first_batch_proceed,
+        high_second_batch_processed, low_batch_processed;
+    auto high_callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      if (!high_first_batch_scheduled.HasBeenNotified()) {
+        high_first_batch_scheduled.Notify();
+        high_first_batch_proceed.WaitForNotification();
+      } else {
+        high_second_batch_processed.Notify();
+      }
+    };
+    auto low_callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      EXPECT_TRUE(high_second_batch_processed.HasBeenNotified());
+      low_batch_processed.Notify();
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    QueueOptions queue_options = CreateQueueOptions(
+        /*max_execution_batch_size=*/10, /*input_batch_size_limit=*/10,
+        /*batch_timeout_micros=*/1, /*max_enqueued_batches=*/100);
+    auto low_queue = CreateQueue(scheduler, queue_options, low_callback);
+    queue_options.priority = 1;
+    auto high_queue = CreateQueue(scheduler, queue_options, high_callback);
+
+    // Occupy the only batch thread with a batch of the high-priority queue, so
+    // that round-robin alone would pick the low-priority queue next.
+    TF_ASSERT_OK(ScheduleTask(10, high_queue.get()));
+    env.AdvanceByMicroseconds(1);
+    high_first_batch_scheduled.WaitForNotification();
+
+    TF_ASSERT_OK(ScheduleTask(10, low_queue.get()));
+    TF_ASSERT_OK(ScheduleTask(10, high_queue.get()));
+    env.AdvanceByMicroseconds(1);
+    high_first_batch_proceed.Notify();
+    low_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST_P(SharedBatchSchedulerTest, ConstMethods) {
   for (const int max_enqueued_batches : {1, 2, 5}) {
     Notification processing, proceed;
@@ -755,6 +802,68 @@ TEST_P(SharedBatchSchedulerTest, InvalidLazySplitOptions) {
                         "enable_large_batch_splitting is enabled."));
 }
 
+TEST_P(SharedBatchSchedulerTest, InvalidLatencyTarget) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {
+    // do nothing.
+  };
+
+  auto scheduler = CreateSharedBatchScheduler(2);
+
+  QueueOptions options = CreateQueueOptions(
+      /*max_execution_batch_size=*/10, /*input_batch_size_limit=*/10,
+      /*batch_timeout_micros=*/100, /*max_enqueued_batches=*/2);
+  options.latency_target_micros = -1;
+  std::unique_ptr<Queue> queue;
+  EXPECT_THAT(scheduler->AddQueue(options, callback, &queue),
+              testing::StatusIs(
+                  error::INVALID_ARGUMENT,
+                  "latency_target_micros must be non-negative; was -1"));
+}
+
+TEST_P(SharedBatchSchedulerTest, LatencyTargetClosesBatchesEarlier) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification first_batch_processed, second_batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      // Processing takes 50 micros per unit.
+      env.AdvanceByMicroseconds(50 * batch->size());
+      if (!first_batch_processed.HasBeenNotified()) {
+        EXPECT_EQ(batch->size(), 1);
+        first_batch_processed.Notify();
+        return;
+      }
+      EXPECT_EQ(batch->size(), 20);
+      second_batch_processed.Notify();
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+
+    QueueOptions options = CreateQueueOptions(
+        /*max_execution_batch_size=*/100, /*input_batch_size_limit=*/100,
+        /*batch_timeout_micros=*/10, /*max_enqueued_batches=*/2);
+    options.latency_target_micros = 1000;
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // The first batch closes on the initial timeout.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(10);
+    first_batch_processed.WaitForNotification();
+
+    // Batches of 20 units take the whole latency target to process, so they
+    // are closed without waiting for the timeout or for a full batch.
+    TF_ASSERT_OK(ScheduleTask(20, queue.get()));
+    second_batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 // Tests that queue configured with zero `max_enqueued_batches` get one queue.
 // Note, technically an invalid-argument error should be returned.
 // Since existing models (with very low QPS) rely on the rewrite, retain the
@@ -13,6 +13,7 @@
 // limitations under the License.
 // =============================================================================
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -79,6 +80,19 @@ std::vector<float> GenerateQuantiles(const QuantileStream& stream,
   return boundaries;
 }
 
+// Rows below which a block of rows isn't worth a quantile stream of its own.
+constexpr int64_t kMinRowsPerQuantileBlock = 65536;
+
+// Returns the blocks of rows to build the summaries of each feature from, so
+// that the intra-op threads have work when there are few features.
+int64_t NumQuantileRowBlocks(const int64_t num_features,
+                             const int64_t batch_size, const int num_threads) {
+  if (num_features >= num_threads) return 1;
+  return std::max<int64_t>(
+      1, std::min<int64_t>((num_threads + num_features - 1) / num_features,
+                           batch_size / kMinRowsPerQuantileBlock));
+}
+
 std::vector<float> GetBuckets(const int32_t feature,
                               const OpInputList& buckets_list) {
   const auto& buckets = buckets_list[feature].flat<float>();
@@ -172,42 +186,94 @@ class BoostedTreesMakeQuantileSummariesOp : public OpKernel {
     OP_REQUIRES_OK(
         context, context->output_list(kSummariesName, &summaries_output_list));
 
-    auto do_quantile_summary_gen = [&](const int64_t begin, const int64_t end) {
-      // Iterating features.
-      for (int64_t index = begin; index < end; index++) {
-        const auto feature_values = float_features_list[index].flat<float>();
-        QuantileStream stream(epsilon, batch_size + 1);
-        // Run quantile summary generation.
-        for (int64_t j = 0; j < batch_size; j++) {
-          stream.PushEntry(feature_values(j), (weight_size > 1)
-                                                  ? example_weights(j)
-                                                  : example_weights(0));
-        }
-        stream.Finalize();
-        const auto summary_entry_list = stream.GetFinalSummary().GetEntryList();
-        Tensor* output_t;
-        OP_REQUIRES_OK(
-            context,
-            summaries_output_list.allocate(
-                index,
-                TensorShape({static_cast<int64>(summary_entry_list.size()), 4}),
-                &output_t));
-        auto output = output_t->matrix<float>();
-        for (auto row = 0; row < summary_entry_list.size(); row++) {
-          const auto& entry = summary_entry_list[row];
-          output(row, 0) = entry.value;
-          output(row, 1) = entry.weight;
-          output(row, 2) = entry.min_rank;
-          output(row, 3) = entry.max_rank;
-        }
+    // Builds the summary of the rows in [begin, end) of a feature.
+    auto build_summary = [&](const int64_t index, const double eps,
+                             const int64_t begin, const int64_t end) {
+      const auto feature_values = float_features_list[index].flat<float>();
+      QuantileStream stream(eps, end - begin + 1);
+      // Run quantile summary generation.
+      for (int64_t j = begin; j < end; j++) {
+        stream.PushEntry(feature_values(j), (weight_size > 1)
+                                                ? example_weights(j)
+                                                : example_weights(0));
       }
+      stream.Finalize();
+      return stream.GetFinalSummary();
     };
-    // TODO(tanzheny): comment on the magic number.
-    const int64_t kCostPerUnit = 500 * batch_size;
+    auto output_summary = [&](const int64_t index,
+                              const QuantileSummary& summary) {
+      const auto summary_entry_list = summary.GetEntryList();
+      Tensor* output_t;
+      OP_REQUIRES_OK(
+          context,
+          summaries_output_list.allocate(
+              index,
+              TensorShape({static_cast<int64>(summary_entry_list.size()), 4}),
+              &output_t));
+      auto output = output_t->matrix<float>();
+      for (auto row = 0; row < summary_entry_list.size(); row++) {
+        const auto& entry = summary_entry_list[row];
+        output(row, 0) = entry.value;
+        output(row, 1) = entry.weight;
+        output(row, 2) = entry.min_rank;
+        output(row, 3) = entry.max_rank;
+      }
+    };
+
     const DeviceBase::CpuWorkerThreads& worker_threads =
         *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_row_blocks = NumQuantileRowBlocks(
+        num_features_, batch_size, worker_threads.num_threads);
+    if (num_row_blocks == 1) {
+      auto do_quantile_summary_gen = [&](const int64_t begin,
+                                         const int64_t end) {
+        // Iterating features.
+        for (int64_t index = begin; index < end; index++) {
+          output_summary(index, build_summary(index, epsilon, 0, batch_size));
+        }
+      };
+      // TODO(tanzheny): comment on the magic number.
+      const int64_t kCostPerUnit = 500 * batch_size;
+      Shard(worker_threads.num_threads, worker_threads.workers, num_features_,
+            kCostPerUnit, do_quantile_summary_gen);
+      return;
+    }
+
+    // Summaries of blocks of rows are built at the same time, then merged.
+    // Merging keeps the largest error of the merged summaries, and the merged
+    // summary is compressed back to about 2 / epsilon entries, which adds
+    // epsilon / 2 to its error. The blocks are therefore summarized with an
+    // error of epsilon / 2, as for distributed summaries of height 2.
+    const int64_t rows_per_block =
+        (batch_size + num_row_blocks - 1) / num_row_blocks;
+    std::vector<QuantileSummary> block_summaries(num_features_ *
+                                                 num_row_blocks);
+    auto do_block_summary_gen = [&](const int64_t begin, const int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t index = unit / num_row_blocks;
+        const int64_t block = unit % num_row_blocks;
+        block_summaries[unit] = build_summary(
+            index, epsilon / 2, block * rows_per_block,
+            std::min(batch_size, (block + 1) * rows_per_block));
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_features_ * num_row_blocks, 500 * rows_per_block,
+          do_block_summary_gen);
+
+    const int64_t merged_size = static_cast<int64>(std::ceil(2.0 / epsilon));
+    auto do_summary_merge = [&](const int64_t begin, const int64_t end) {
+      for (int64_t index = begin; index < end; index++) {
+        QuantileSummary summary;
+        for (int64_t block = 0; block < num_row_blocks; ++block) {
+          summary.Merge(block_summaries[index * num_row_blocks + block]);
+        }
+        summary.Compress(merged_size, epsilon / 2);
+        output_summary(index, summary);
+      }
+    };
     Shard(worker_threads.num_threads, worker_threads.workers, num_features_,
-          kCostPerUnit, do_quantile_summary_gen);
+          10 * num_row_blocks * merged_size, do_summary_merge);
   }
 
  private:
@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/boosted_trees/quantiles/weighted_quantiles_summary.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class BoostedTreesMakeQuantileSummariesOpTest : public OpsTestBase {};
+
+TEST_F(BoostedTreesMakeQuantileSummariesOpTest, KeepsErrorBoundOnLargeBatch) {
+  // Large enough for the summary to be merged from summaries of row blocks.
+  constexpr int kNumRows = 200000;
+  constexpr float kEpsilon = 0.01;
+  TF_ASSERT_OK(NodeDefBuilder("make_quantile_summaries",
+                              "BoostedTreesMakeQuantileSummaries")
+                   .Input(FakeInput(1, DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("num_features", 1)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // A permutation of [0, kNumRows), so that the rank of a value is the value.
+  AddInput<float>(TensorShape({kNumRows}),
+                  [](int i) { return (i * 7919) % kNumRows; });
+  AddInputFromArray<float>(TensorShape({1}), {1});
+  AddInputFromArray<float>(TensorShape({}), {kEpsilon});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const auto summary = GetOutput(0)->matrix<float>();
+  using Summary = boosted_trees::quantiles::WeightedQuantilesSummary<float,
+                                                                     float>;
+  std::vector<Summary::SummaryEntry> entries;
+  for (int row = 0; row < summary.dimension(0); ++row) {
+    const float value = summary(row, 0);
+    const float min_rank = summary(row, 2);
+    const float max_rank = summary(row, 3);
+    EXPECT_LE(min_rank, value);
+    EXPECT_GE(max_rank, value + 1);
+    entries.emplace_back(value, summary(row, 1), min_rank, max_rank);
+  }
+  Summary merged;
+  merged.BuildFromSummaryEntries(entries);
+  EXPECT_EQ(merged.MinValue(), 0);
+  EXPECT_EQ(merged.MaxValue(), kNumRows - 1);
+  EXPECT_EQ(merged.TotalWeight(), kNumRows);
+  EXPECT_LE(merged.ApproximationError(), kEpsilon);
+}
+
+Graph* MakeQuantileSummariesGraph(int num_features, int batch_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> features;
+  for (int feature = 0; feature < num_features; ++feature) {
+    Tensor values(DT_FLOAT, TensorShape({batch_size}));
+    values.flat<float>().setRandom();
+    features.emplace_back(test::graph::Constant(g, values));
+  }
+  Tensor weights(DT_FLOAT, TensorShape({1}));
+  weights.flat<float>().setConstant(1);
+  Tensor epsilon(DT_FLOAT, TensorShape({}));
+  epsilon.scalar<float>()() = 0.01;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "BoostedTreesMakeQuantileSummaries")
+          .Input(features)
+          .Input(test::graph::Constant(g, weights))
+          .Input(test::graph::Constant(g, epsilon))
+          .Attr("num_features", num_features)
+          .Finalize(g, nullptr));
+  return g;
+}
+
+void BM_MakeQuantileSummaries(::testing::benchmark::State& state) {
+  const int num_features = state.range(0);
+  const int batch_size = (1 << 21) / num_features;
+  test::Benchmark("cpu", MakeQuantileSummariesGraph(num_features, batch_size),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_features * batch_size);
+}
+BENCHMARK(BM_MakeQuantileSummaries)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow
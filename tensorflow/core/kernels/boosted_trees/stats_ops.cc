@@ -13,11 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <limits>
 #include <string>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -1289,6 +1292,70 @@ REGISTER_KERNEL_BUILDER(
     Name("BoostedTreesSparseCalculateBestFeatureSplit").Device(DEVICE_CPU),
     BoostedTreesSparseCalculateBestFeatureSplitOp);
 
+// Rows below which a block of rows isn't worth a histogram of its own.
+constexpr int64_t kMinRowsPerStatsBlock = 16384;
+
+// Accumulates the stats of `batch_size` rows into `stats_t`, a zeroed rank 4
+// tensor of doubles, on the intra-op threads.
+// `accumulate(column, begin, end, stats)` must add the stats of the rows in
+// [begin, end) of `column` into `stats`, without touching the stats of other
+// columns. The columns are accumulated at the same time. When there are
+// fewer columns than threads, blocks of rows of a column are accumulated into
+// histograms of their own, which are summed into `stats_t` afterwards.
+template <typename AccumulateFn>
+Status AccumulateStats(OpKernelContext* const context,
+                       const int64_t num_columns, const int64_t batch_size,
+                       const int64_t cost_per_row, Tensor* const stats_t,
+                       const AccumulateFn& accumulate) {
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  int64_t num_row_blocks = 1;
+  if (num_columns < worker_threads.num_threads) {
+    num_row_blocks = std::max<int64_t>(
+        1, std::min<int64_t>(
+               (worker_threads.num_threads + num_columns - 1) / num_columns,
+               batch_size / kMinRowsPerStatsBlock));
+  }
+  const int64_t rows_per_block =
+      (batch_size + num_row_blocks - 1) / num_row_blocks;
+
+  // The first block accumulates into the output.
+  std::vector<Tensor> block_stats_t(num_row_blocks);
+  block_stats_t[0] = *stats_t;
+  for (int64_t block = 1; block < num_row_blocks; ++block) {
+    TF_RETURN_IF_ERROR(context->allocate_temp(DT_DOUBLE, stats_t->shape(),
+                                              &block_stats_t[block]));
+    block_stats_t[block].flat<double>().setZero();
+  }
+
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        num_columns * num_row_blocks, rows_per_block * cost_per_row,
+        [&](const int64_t begin, const int64_t end) {
+          for (int64_t unit = begin; unit < end; ++unit) {
+            const int64_t column = unit / num_row_blocks;
+            const int64_t block = unit % num_row_blocks;
+            auto stats = block_stats_t[block].tensor<double, 4>();
+            accumulate(column, block * rows_per_block,
+                       std::min(batch_size, (block + 1) * rows_per_block),
+                       stats);
+          }
+        });
+
+  if (num_row_blocks > 1) {
+    auto stats = stats_t->flat<double>();
+    Shard(worker_threads.num_threads, worker_threads.workers, stats.size(),
+          num_row_blocks, [&](const int64_t begin, const int64_t end) {
+            for (int64_t block = 1; block < num_row_blocks; ++block) {
+              const auto block_stats = block_stats_t[block].flat<double>();
+              for (int64_t i = begin; i < end; ++i) {
+                stats(i) += block_stats(i);
+              }
+            }
+          });
+  }
+  return Status::OK();
+}
+
 class BoostedTreesMakeStatsSummaryOp : public OpKernel {
  public:
   explicit BoostedTreesMakeStatsSummaryOp(OpKernelConstruction* const context)
@@ -1328,15 +1395,22 @@ class BoostedTreesMakeStatsSummaryOp : public OpKernel {
     temp_stats_double.setZero();
 
     // Partition by node, and then bucketize.
-    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
-      const auto& features = bucketized_features_list[feature_idx].vec<int32>();
-      for (int i = 0; i < batch_size; ++i) {
-        const int32_t node = node_ids(i);
-        const int32_t bucket = features(i);
-        temp_stats_double(feature_idx, node, bucket, 0) += gradients(i, 0);
-        temp_stats_double(feature_idx, node, bucket, 1) += hessians(i, 0);
-      }
-    }
+    OP_REQUIRES_OK(
+        context,
+        AccumulateStats(
+            context, num_features_, batch_size, /*cost_per_row=*/10,
+            &temp_stats_double_t,
+            [&](const int64_t feature_idx, const int64_t begin,
+                const int64_t end, TTypes<double, 4>::Tensor stats) {
+              const auto features =
+                  bucketized_features_list[feature_idx].vec<int32>();
+              for (int64_t i = begin; i < end; ++i) {
+                const int32_t node = node_ids(i);
+                const int32_t bucket = features(i);
+                stats(feature_idx, node, bucket, 0) += gradients(i, 0);
+                stats(feature_idx, node, bucket, 1) += hessians(i, 0);
+              }
+            }));
 
     // Copy temp tensor over to output tensor.
     Tensor* output_stats_summary_t = nullptr;
@@ -1404,22 +1478,30 @@ class BoostedTreesAggregateStatsOp : public OpKernel {
     auto temp_stats_double = temp_stats_double_t.tensor<double, 4>();
     temp_stats_double.setZero();
 
-    for (int i = 0; i < batch_size; ++i) {
-      const int32_t node = node_ids(i);
-      for (int feature_dim = 0; feature_dim < feature_dims; ++feature_dim) {
-        const int32_t feature_value = feature(i, feature_dim);
-        const int32_t bucket =
-            (feature_value == -1) ? num_buckets_ : feature_value;
-        for (int stat_dim = 0; stat_dim < logits_dims; ++stat_dim) {
-          temp_stats_double(node, feature_dim, bucket, stat_dim) +=
-              gradients(i, stat_dim);
-        }
-        for (int stat_dim = logits_dims; stat_dim < stats_dims; ++stat_dim) {
-          temp_stats_double(node, feature_dim, bucket, stat_dim) +=
-              hessians(i, stat_dim - logits_dims);
-        }
-      }
-    }
+    const int num_buckets = num_buckets_;
+    OP_REQUIRES_OK(
+        context,
+        AccumulateStats(
+            context, feature_dims, batch_size,
+            /*cost_per_row=*/5 * stats_dims, &temp_stats_double_t,
+            [&](const int64_t feature_dim, const int64_t begin,
+                const int64_t end, TTypes<double, 4>::Tensor stats) {
+              for (int64_t i = begin; i < end; ++i) {
+                const int32_t node = node_ids(i);
+                const int32_t feature_value = feature(i, feature_dim);
+                const int32_t bucket =
+                    (feature_value == -1) ? num_buckets : feature_value;
+                for (int stat_dim = 0; stat_dim < logits_dims; ++stat_dim) {
+                  stats(node, feature_dim, bucket, stat_dim) +=
+                      gradients(i, stat_dim);
+                }
+                for (int stat_dim = logits_dims; stat_dim < stats_dims;
+                     ++stat_dim) {
+                  stats(node, feature_dim, bucket, stat_dim) +=
+                      hessians(i, stat_dim - logits_dims);
+                }
+              }
+            }));
 
     // Copy temp tensor over to output tensor, downcasting to float.
     Tensor* output_stats_summary_t = nullptr;
@@ -0,0 +1,187 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Large enough for the rows of a feature to be accumulated in several blocks.
+constexpr int kBatchSize = 40000;
+constexpr int kMaxSplits = 3;
+constexpr int kNumBuckets = 4;
+
+float Gradient(int i) { return (i % 7) * 0.5f - 1.0f; }
+float Hessian(int i) { return (i % 3) * 0.25f + 0.5f; }
+
+std::vector<float> Gradients() {
+  std::vector<float> gradients(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) gradients[i] = Gradient(i);
+  return gradients;
+}
+
+std::vector<float> Hessians() {
+  std::vector<float> hessians(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) hessians[i] = Hessian(i);
+  return hessians;
+}
+
+std::vector<int32> NodeIds() {
+  std::vector<int32> node_ids(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) node_ids[i] = (i / 5) % kMaxSplits;
+  return node_ids;
+}
+
+int32 Bucket(int feature, int i) { return (i * (feature + 3)) % kNumBuckets; }
+
+class BoostedTreesMakeStatsSummaryOpTest : public OpsTestBase {};
+
+TEST_F(BoostedTreesMakeStatsSummaryOpTest, AccumulatesAllRows) {
+  constexpr int kNumFeatures = 2;
+  TF_ASSERT_OK(NodeDefBuilder("make_stats_summary",
+                              "BoostedTreesMakeStatsSummary")
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(kNumFeatures, DT_INT32))
+                   .Attr("max_splits", kMaxSplits)
+                   .Attr("num_buckets", kNumBuckets)
+                   .Attr("num_features", kNumFeatures)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<int32> node_ids = NodeIds();
+  AddInputFromArray<int32>(TensorShape({kBatchSize}), node_ids);
+  AddInputFromArray<float>(TensorShape({kBatchSize, 1}), Gradients());
+  AddInputFromArray<float>(TensorShape({kBatchSize, 1}), Hessians());
+  std::vector<double> expected_stats(
+      kNumFeatures * kMaxSplits * kNumBuckets * 2, 0);
+  for (int feature = 0; feature < kNumFeatures; ++feature) {
+    std::vector<int32> buckets(kBatchSize);
+    for (int i = 0; i < kBatchSize; ++i) {
+      buckets[i] = Bucket(feature, i);
+      const int offset =
+          ((feature * kMaxSplits + node_ids[i]) * kNumBuckets + buckets[i]) *
+          2;
+      expected_stats[offset] += Gradient(i);
+      expected_stats[offset + 1] += Hessian(i);
+    }
+    AddInputFromArray<int32>(TensorShape({kBatchSize}), buckets);
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT,
+                  TensorShape({kNumFeatures, kMaxSplits, kNumBuckets, 2}));
+  test::FillFn<float>(&expected, [&expected_stats](int i) {
+    return static_cast<float>(expected_stats[i]);
+  });
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-3);
+}
+
+class BoostedTreesAggregateStatsOpTest : public OpsTestBase {};
+
+TEST_F(BoostedTreesAggregateStatsOpTest, AccumulatesAllRows) {
+  constexpr int kFeatureDims = 2;
+  TF_ASSERT_OK(NodeDefBuilder("aggregate_stats", "BoostedTreesAggregateStats")
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Attr("max_splits", kMaxSplits)
+                   .Attr("num_buckets", kNumBuckets)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<int32> node_ids = NodeIds();
+  AddInputFromArray<int32>(TensorShape({kBatchSize}), node_ids);
+  AddInputFromArray<float>(TensorShape({kBatchSize, 1}), Gradients());
+  AddInputFromArray<float>(TensorShape({kBatchSize, 1}), Hessians());
+  // The last bucket is for missing values.
+  std::vector<double> expected_stats(
+      kMaxSplits * kFeatureDims * (kNumBuckets + 1) * 2, 0);
+  std::vector<int32> feature(kBatchSize * kFeatureDims);
+  for (int i = 0; i < kBatchSize; ++i) {
+    for (int dim = 0; dim < kFeatureDims; ++dim) {
+      const int32 bucket = i % 11 == 0 ? kNumBuckets : Bucket(dim, i);
+      feature[i * kFeatureDims + dim] = bucket == kNumBuckets ? -1 : bucket;
+      const int offset =
+          ((node_ids[i] * kFeatureDims + dim) * (kNumBuckets + 1) + bucket) *
+          2;
+      expected_stats[offset] += Gradient(i);
+      expected_stats[offset + 1] += Hessian(i);
+    }
+  }
+  AddInputFromArray<int32>(TensorShape({kBatchSize, kFeatureDims}), feature);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({kMaxSplits, kFeatureDims,
+                                         kNumBuckets + 1, 2}));
+  test::FillFn<float>(&expected, [&expected_stats](int i) {
+    return static_cast<float>(expected_stats[i]);
+  });
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-3);
+}
+
+Graph* MakeStatsSummaryGraph(int num_features, int batch_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor node_ids(DT_INT32, TensorShape({batch_size}));
+  node_ids.flat<int32>().setZero();
+  Tensor gradients(DT_FLOAT, TensorShape({batch_size, 1}));
+  gradients.flat<float>().setRandom();
+  Tensor hessians(DT_FLOAT, TensorShape({batch_size, 1}));
+  hessians.flat<float>().setRandom();
+  std::vector<NodeBuilder::NodeOut> features;
+  for (int feature = 0; feature < num_features; ++feature) {
+    Tensor buckets(DT_INT32, TensorShape({batch_size}));
+    test::FillFn<int32>(&buckets, [feature](int i) {
+      return (i * (feature + 3)) % 32;
+    });
+    features.emplace_back(test::graph::Constant(g, buckets));
+  }
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "BoostedTreesMakeStatsSummary")
+                  .Input(test::graph::Constant(g, node_ids))
+                  .Input(test::graph::Constant(g, gradients))
+                  .Input(test::graph::Constant(g, hessians))
+                  .Input(features)
+                  .Attr("max_splits", 1)
+                  .Attr("num_buckets", 32)
+                  .Attr("num_features", num_features)
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+// The rows are split between few features, so that they are mostly
+// accumulated in blocks of rows.
+void BM_MakeStatsSummary(::testing::benchmark::State& state) {
+  const int num_features = state.range(0);
+  const int batch_size = (1 << 22) / num_features;
+  test::Benchmark("cpu", MakeStatsSummaryGraph(num_features, batch_size),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_features * batch_size);
+}
+BENCHMARK(BM_MakeStatsSummary)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow
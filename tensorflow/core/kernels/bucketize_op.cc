@@ -20,8 +20,10 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -32,17 +34,22 @@ namespace functor {
 
 template <typename T>
 struct BucketizeFunctor<CPUDevice, T> {
-  // PRECONDITION: boundaries_vector must be sorted.
   static Status Compute(OpKernelContext* context,
                         const typename TTypes<T, 1>::ConstTensor& input,
-                        const std::vector<float>& boundaries_vector,
+                        const SortedBoundaries<float>& boundaries,
                         typename TTypes<int32, 1>::Tensor& output) {
-    const int N = input.size();
-    for (int i = 0; i < N; i++) {
-      auto first_bigger_it = std::upper_bound(
-          boundaries_vector.begin(), boundaries_vector.end(), input(i));
-      output(i) = first_bigger_it - boundaries_vector.begin();
-    }
+    const int64_t N = input.size();
+    // A search costs a comparison and a load per level of the tree.
+    const int64_t cost_per_unit =
+        4 * (Log2Ceiling64(boundaries.size() + 1) + 1);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, N,
+          cost_per_unit, [&](int64_t start, int64_t limit) {
+            for (int64_t i = start; i < limit; ++i) {
+              output(i) = boundaries.UpperBound(input(i));
+            }
+          });
 
     return Status::OK();
   }
@@ -54,9 +61,11 @@ template <typename Device, typename T>
 class BucketizeOp : public OpKernel {
  public:
   explicit BucketizeOp(OpKernelConstruction* context) : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->GetAttr("boundaries", &boundaries_));
-    OP_REQUIRES(context, std::is_sorted(boundaries_.begin(), boundaries_.end()),
+    std::vector<float> boundaries;
+    OP_REQUIRES_OK(context, context->GetAttr("boundaries", &boundaries));
+    OP_REQUIRES(context, std::is_sorted(boundaries.begin(), boundaries.end()),
                 errors::InvalidArgument("Expected sorted boundaries"));
+    boundaries_ = SortedBoundaries<float>(boundaries);
   }
 
   void Compute(OpKernelContext* context) override {
@@ -74,7 +83,7 @@ class BucketizeOp : public OpKernel {
   }
 
  private:
-  std::vector<float> boundaries_;
+  SortedBoundaries<float> boundaries_;
 };
 
 #define REGISTER_KERNEL(T)                                         \
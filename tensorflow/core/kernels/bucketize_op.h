@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/sorted_search.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -31,7 +32,7 @@ template <typename Device, typename T>
 struct BucketizeFunctor {
   static Status Compute(OpKernelContext* context,
                         const typename TTypes<T, 1>::ConstTensor& input,
-                        const std::vector<float>& boundaries_vector,
+                        const SortedBoundaries<float>& boundaries,
                         typename TTypes<int32, 1>::Tensor& output);
 };
 
@@ -77,12 +77,12 @@ namespace functor {
 
 template <typename T>
 struct BucketizeFunctor<GPUDevice, T> {
-  // PRECONDITION: boundaries_vector must be sorted.
   static Status Compute(OpKernelContext* context,
                         const typename TTypes<T, 1>::ConstTensor& input,
-                        const std::vector<float>& boundaries_vector,
+                        const SortedBoundaries<float>& boundaries,
                         typename TTypes<int32, 1>::Tensor& output) {
     const GPUDevice& d = context->eigen_device<GPUDevice>();
+    const std::vector<float>& boundaries_vector = boundaries.sorted();
 
     GpuDeviceArrayOnHost<float> boundaries_array(context,
                                                  boundaries_vector.size());
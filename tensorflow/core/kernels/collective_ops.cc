@@ -12,9 +12,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -25,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_requires.h"
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -599,6 +604,12 @@ class CollectiveReduceV2OpKernel : public CollectiveOpV2Kernel {
     OP_REQUIRES_OK(c, c->GetAttr("final_op", &final_op_name));
     OP_REQUIRES_OK(
         c, c->GetAttr("max_subdivs_per_device", &max_subdivs_per_device_));
+    OP_REQUIRES_OK(c, c->GetAttr("fusion_key", &fusion_key_));
+    OP_REQUIRES_OK(c, c->GetAttr("fusion_group_size", &fusion_group_size_));
+    OP_REQUIRES(c, fusion_group_size_ >= 0,
+                errors::InvalidArgument(
+                    "fusion_group_size must be non-negative but got ",
+                    fusion_group_size_));
     // Prepare OpKernels for reduction and final operations.
     // The merge_op takes two inputs
     NodeDef sub_node;
@@ -627,6 +638,8 @@ class CollectiveReduceV2OpKernel : public CollectiveOpV2Kernel {
                                               /*instance_key*/ c->input(3)),
                          done);
     col_params->instance.shape = c->input(0).shape();
+    col_params->instance.impl_details.fusion_key = fusion_key_;
+    col_params->instance.impl_details.fusion_group_size = fusion_group_size_;
     col_params->merge_op = merge_op_.get();
     col_params->final_op = final_op_.get();
     VLOG(1) << "CollectiveReduceV2 group_size " << col_params->group.group_size
@@ -643,6 +656,8 @@ class CollectiveReduceV2OpKernel : public CollectiveOpV2Kernel {
 
  private:
   int max_subdivs_per_device_;
+  int fusion_key_;
+  int fusion_group_size_;
   std::unique_ptr<OpKernel> merge_op_;
   std::unique_ptr<OpKernel> final_op_;
 };
@@ -1045,6 +1060,36 @@ class CollectiveOpV3Kernel : public AsyncOpKernel {
     });
   }
 
+  // Like Run(), but runs the collective on `input` and `output`, which must
+  // live until `done` is called, and passes its status to `done`.
+  void RunOnTensors(OpKernelContext* c, CollectiveParams* col_params,
+                    const Tensor* input, Tensor* output, StatusCallback done) {
+    CollectiveExecutor* col_exec = c->collective_executor();
+    if (col_exec == nullptr) {
+      done(errors::Internal(
+          "Failed to get CollectiveExecutor from OpKernelContext for Op ",
+          name_));
+      return;
+    }
+    col_exec->RunClosure([c, done = std::move(done), col_params, col_exec,
+                          input, output]() {
+      col_exec->CompleteParamsAsync(
+          c->device()->attributes(), col_params, c->cancellation_manager(),
+          [c, done = std::move(done), col_params, col_exec, input,
+           output](const Status& s) {
+            if (!s.ok()) {
+              done(s);
+              return;
+            }
+            col_exec->ExecuteOnTensorsAsync(
+                c, col_params,
+                CollectiveKey(c, col_params->group.group_key,
+                              col_params->instance.instance_key),
+                input, output, std::move(done));
+          });
+    });
+  }
+
  protected:
   string name_;
   DataType data_type_ = DT_INVALID;
@@ -1161,5 +1206,248 @@ REGISTER_KERNEL_BUILDER(Name("CollectiveAllToAllV3").Device(DEVICE_CPU),
                         CollectiveAllToAllV3OpKernel);
 REGISTER_KERNEL_BUILDER(Name("CollectiveAllToAllV3").Device(DEVICE_GPU),
                         CollectiveAllToAllV3OpKernel);
+
+// The state of a CollectiveEmbeddingLookupV3 while its collectives run.
+struct EmbeddingLookupState {
+  ~EmbeddingLookupState() {
+    for (CollectiveParams* col_params : this->col_params) {
+      if (col_params != nullptr) col_params->Unref();
+    }
+  }
+
+  CollectiveParams* col_params[3] = {nullptr, nullptr, nullptr};
+  int num_shards;
+  int rank;
+  TensorShape row_shape;
+  int64_t row_bytes;
+  // For each id, the index of its first occurrence among the unique ids.
+  std::vector<int32> unique_index;
+  // For each unique id, its shard and its position in the shard's request.
+  std::vector<std::pair<int32, int64_t>> unique_location;
+  // For each shard, the rows of the shard requested by this rank.
+  std::vector<std::vector<int64_t>> requested_rows;
+  // The largest number of rows that any rank requests from any shard.
+  int64_t max_rows = 0;
+  Tensor send, recv;
+};
+
+// Looks up rows of a table that is sharded with the "mod" strategy over the
+// ranks of a communicator, with three all-to-alls: the number of ids each
+// rank requests from each other rank, the ids themselves, padded to the
+// largest request, and the rows.
+template <typename Tindices>
+class CollectiveEmbeddingLookupV3OpKernel : public CollectiveOpV3Kernel {
+ public:
+  explicit CollectiveEmbeddingLookupV3OpKernel(OpKernelConstruction* c)
+      : CollectiveOpV3Kernel(c) {
+    name_ = strings::StrCat(c->def().name(), ": EmbeddingLookupV3");
+    VLOG(2) << "CollectiveEmbeddingLookupV3 " << this << " name " << name_;
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    const Tensor& params = c->input(0);
+    OP_REQUIRES_ASYNC(c, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+                      errors::InvalidArgument(
+                          "params must be at least 1 dimensional, got ",
+                          params.shape().DebugString()),
+                      done);
+    core::RefCountPtr<CollectiveGroupResource> resource;
+    OP_REQUIRES_OK_ASYNC(c, LookupResource(c, HandleFromInput(c, 2), &resource),
+                         done);
+
+    auto* lookup = new Lookup;
+    auto done_with_cleanup = [lookup, done = std::move(done)]() {
+      done();
+      delete lookup;
+    };
+    // All the instance keys are taken now, so that other collectives on the
+    // communicator cannot interleave with the ones of this lookup.
+    for (CollectiveParams*& col_params : lookup->col_params) {
+      col_params = new CollectiveParams();
+      OP_REQUIRES_OK_ASYNC(
+          c,
+          FillCollectiveParams(col_params, c->input(3), ALL_TO_ALL_COLLECTIVE,
+                               resource.get()),
+          done_with_cleanup);
+    }
+    lookup->num_shards = lookup->col_params[0]->group.group_size;
+    lookup->rank = resource->rank();
+    lookup->row_shape = params.shape();
+    lookup->row_shape.RemoveDim(0);
+    lookup->row_bytes = lookup->row_shape.num_elements() *
+                        DataTypeSize(params.dtype());
+
+    Status s = PartitionIds(c->input(1), lookup);
+    if (!s.ok()) {
+      Fail(c, s, std::move(done_with_cleanup));
+      return;
+    }
+    ExchangeCounts(c, lookup, std::move(done_with_cleanup));
+  }
+
+ private:
+  using Lookup = EmbeddingLookupState;
+
+  // Fails the lookup. Since the other ranks may wait for this one, the
+  // collective executor is aborted as well.
+  void Fail(OpKernelContext* c, const Status& s, DoneCallback done) {
+    if (c->collective_executor() != nullptr) {
+      c->collective_executor()->StartAbort(s);
+    }
+    c->SetStatus(s);
+    done();
+  }
+
+  Status PartitionIds(const Tensor& ids, Lookup* lookup) {
+    const auto ids_flat = ids.flat<Tindices>();
+    absl::flat_hash_map<Tindices, int32> unique_ids;
+    lookup->unique_index.reserve(ids_flat.size());
+    lookup->requested_rows.resize(lookup->num_shards);
+    for (int64_t i = 0; i < ids_flat.size(); ++i) {
+      const Tindices id = ids_flat(i);
+      if (id < 0) {
+        return errors::InvalidArgument("ids[", i, "] = ", id,
+                                       " is negative");
+      }
+      auto it_and_inserted = unique_ids.emplace(id, unique_ids.size());
+      if (it_and_inserted.second) {
+        std::vector<int64_t>& rows =
+            lookup->requested_rows[id % lookup->num_shards];
+        lookup->unique_location.emplace_back(id % lookup->num_shards,
+                                             rows.size());
+        rows.push_back(id / lookup->num_shards);
+      }
+      lookup->unique_index.push_back(it_and_inserted.first->second);
+    }
+    return Status::OK();
+  }
+
+  // Sends the number of rows requested from each shard to every rank, so
+  // that all ranks agree on the padded size of the requests.
+  void ExchangeCounts(OpKernelContext* c, Lookup* lookup, DoneCallback done) {
+    const int n = lookup->num_shards;
+    lookup->send = Tensor(DT_INT64, TensorShape({n, n}));
+    lookup->recv = Tensor(DT_INT64, TensorShape({n, n}));
+    auto send = lookup->send.matrix<int64_t>();
+    for (int dst = 0; dst < n; ++dst) {
+      for (int shard = 0; shard < n; ++shard) {
+        send(dst, shard) = lookup->requested_rows[shard].size();
+      }
+    }
+    CollectiveParams* col_params = lookup->col_params[0];
+    col_params->instance.data_type = DT_INT64;
+    col_params->instance.shape = lookup->send.shape();
+    RunOnTensors(c, col_params, &lookup->send, &lookup->recv,
+                 [this, c, lookup, done = std::move(done)](const Status& s) {
+                   if (!s.ok()) {
+                     c->SetStatus(s);
+                     done();
+                     return;
+                   }
+                   ExchangeIds(c, lookup, std::move(done));
+                 });
+  }
+
+  void ExchangeIds(OpKernelContext* c, Lookup* lookup, DoneCallback done) {
+    const int n = lookup->num_shards;
+    // Row `src` of the counts holds the requests of rank `src`.
+    Tensor counts = std::move(lookup->recv);
+    lookup->max_rows = 0;
+    for (int64_t i = 0; i < counts.NumElements(); ++i) {
+      lookup->max_rows = std::max(lookup->max_rows, counts.flat<int64_t>()(i));
+    }
+    lookup->send = Tensor(DT_INT64, TensorShape({n, lookup->max_rows}));
+    lookup->recv = Tensor(DT_INT64, TensorShape({n, lookup->max_rows}));
+    auto send = lookup->send.matrix<int64_t>();
+    send.setZero();
+    for (int shard = 0; shard < n; ++shard) {
+      const std::vector<int64_t>& rows = lookup->requested_rows[shard];
+      for (size_t i = 0; i < rows.size(); ++i) send(shard, i) = rows[i];
+    }
+    CollectiveParams* col_params = lookup->col_params[1];
+    col_params->instance.data_type = DT_INT64;
+    col_params->instance.shape = lookup->send.shape();
+    RunOnTensors(
+        c, col_params, &lookup->send, &lookup->recv,
+        [this, c, lookup, counts, done = std::move(done)](const Status& s) {
+          if (!s.ok()) {
+            c->SetStatus(s);
+            done();
+            return;
+          }
+          // Gathers the rows requested from this rank's shard.
+          const Tensor& params = c->input(0);
+          const int n = lookup->num_shards;
+          const auto counts_matrix = counts.matrix<int64_t>();
+          Tensor rows_tensor = std::move(lookup->recv);
+          const auto rows = rows_tensor.matrix<int64_t>();
+          TensorShape shape({n, lookup->max_rows});
+          shape.AppendShape(lookup->row_shape);
+          lookup->send = Tensor(params.dtype(), shape);
+          lookup->recv = Tensor(params.dtype(), shape);
+          char* dst = const_cast<char*>(lookup->send.tensor_data().data());
+          const char* src = params.tensor_data().data();
+          memset(dst, 0, lookup->send.TotalBytes());
+          for (int src_rank = 0; src_rank < n; ++src_rank) {
+            for (int64_t i = 0; i < counts_matrix(src_rank, lookup->rank);
+                 ++i) {
+              const int64_t row = rows(src_rank, i);
+              if (row >= params.dim_size(0)) {
+                Fail(c,
+                     errors::InvalidArgument(
+                         "id ", row * n + lookup->rank, " is not in [0, ",
+                         params.dim_size(0) * n, ")"),
+                     std::move(done));
+                return;
+              }
+              memcpy(dst + (src_rank * lookup->max_rows + i) *
+                               lookup->row_bytes,
+                     src + row * lookup->row_bytes, lookup->row_bytes);
+            }
+          }
+          ExchangeRows(c, lookup, std::move(done));
+        });
+  }
+
+  void ExchangeRows(OpKernelContext* c, Lookup* lookup, DoneCallback done) {
+    CollectiveParams* col_params = lookup->col_params[2];
+    col_params->instance.data_type = lookup->send.dtype();
+    col_params->instance.shape = lookup->send.shape();
+    RunOnTensors(c, col_params, &lookup->send, &lookup->recv,
+                 [c, lookup, done = std::move(done)](const Status& s) {
+                   if (!s.ok()) {
+                     c->SetStatus(s);
+                     done();
+                     return;
+                   }
+                   Tensor* output = nullptr;
+                   TensorShape shape = c->input(1).shape();
+                   shape.AppendShape(lookup->row_shape);
+                   OP_REQUIRES_OK_ASYNC(
+                       c, c->allocate_output(0, shape, &output), done);
+                   char* dst = const_cast<char*>(output->tensor_data().data());
+                   const char* src = lookup->recv.tensor_data().data();
+                   for (size_t i = 0; i < lookup->unique_index.size(); ++i) {
+                     const auto& location =
+                         lookup->unique_location[lookup->unique_index[i]];
+                     memcpy(dst + i * lookup->row_bytes,
+                            src + (location.first * lookup->max_rows +
+                                   location.second) *
+                                      lookup->row_bytes,
+                            lookup->row_bytes);
+                   }
+                   done();
+                 });
+  }
+};
+
+#define REGISTER_KERNEL(Tindices)                                  \
+  REGISTER_KERNEL_BUILDER(Name("CollectiveEmbeddingLookupV3")      \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<Tindices>("Tindices"), \
+                          CollectiveEmbeddingLookupV3OpKernel<Tindices>);
+REGISTER_KERNEL(int32);
+REGISTER_KERNEL(int64_t);
+#undef REGISTER_KERNEL
 }  // namespace
 }  // namespace tensorflow
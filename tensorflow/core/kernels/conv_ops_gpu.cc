@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/protobuf/autotuning.pb.h"
+#include "tensorflow/core/util/autotune_maps/autotune_serialize.h"
 #include "tensorflow/core/util/proto/proto_utils.h"
 #include "tensorflow/core/util/use_cudnn.h"
 
@@ -122,6 +123,7 @@ StatusOr<se::dnn::AlgorithmConfig> AutotuneFusedConv(
   auto* stream = ctx->op_device_context()->stream();
 
   if (cudnn_use_autotune) {
+    MaybeLoadAutotuneMapsFromEnv();
     // Check if we already have an algorithm selected for the given parameters.
     if (autotune_map->Find(params, &algorithm_config)) {
       return algorithm_config;
@@ -212,6 +214,7 @@ StatusOr<se::dnn::AlgorithmConfig> AutotuneFusedConv(
     TF_RETURN_IF_ERROR(
         BestCudnnConvAlgorithm(results, &plans, &algorithm_config));
     autotune_map->Insert(params, algorithm_config);
+    MaybeSaveAutotuneMapsFromEnv();
   } else if (CudnnUseFrontend()) {
     // FusedConvolveWithExecutionPlan does not fall back to a default algorithm
     // if unspecified; we have to choose one.  Since autotuning is disabled,
@@ -298,6 +301,7 @@ StatusOr<se::dnn::AlgorithmConfig> AutotuneUnfusedConv(
 #endif
       cudnn_use_autotune;
   if (do_autotune) {
+    MaybeLoadAutotuneMapsFromEnv();
     if (!autotune_map->Find(conv_parameters, &algorithm_config)) {
       profiler::ScopedAnnotation annotation("cudnn_autotuning");
 
@@ -435,6 +439,7 @@ StatusOr<se::dnn::AlgorithmConfig> AutotuneUnfusedConv(
           BestCudnnConvAlgorithm(results, &plans, &algorithm_config));
 
       autotune_map->Insert(conv_parameters, algorithm_config);
+      MaybeSaveAutotuneMapsFromEnv();
     }
 #if GOOGLE_CUDA
   } else if (CudnnUseFrontend()) {
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/ctc/ctc_beam_search.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -322,43 +323,52 @@ class CTCBeamSearchDecoderOp : public OpKernel {
 
     log_prob_t.setZero();
 
-    std::vector<typename TTypes<T>::UnalignedConstMatrix> input_list_t;
-
-    input_list_t.reserve(max_time);
-    for (std::size_t t = 0; t < max_time; ++t) {
-      input_list_t.emplace_back(inputs_t.data() + t * batch_size * num_classes,
-                                batch_size, num_classes);
-    }
-
-    ctc::CTCBeamSearchDecoder<T> beam_search(num_classes, beam_width_,
-                                             &beam_scorer_, 1 /* batch_size */,
-                                             merge_repeated_);
-    Tensor input_chip(DataTypeToEnum<T>::v(), TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<T>();
-
     std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<T> log_probs;
+    mutex mu;
+    Status status;
 
+    // The batch entries are decoded in parallel, each shard with a decoder of
+    // its own. The default beam scorer is stateless, so they share it.
     // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(
-            input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
-      }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
+    auto decode = [&](const int64_t begin, const int64_t end) {
+      ctc::CTCBeamSearchDecoder<T> beam_search(num_classes, beam_width_,
+                                               &beam_scorer_,
+                                               1 /* batch_size */,
+                                               merge_repeated_);
+      std::vector<T> log_probs;
+      for (int64_t b = begin; b < end; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(decode_helper_.GetTopPaths());
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          // The classes of a time step and batch entry are contiguous.
+          auto input_bi = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(
+              inputs_t.data() + (t * batch_size + b) * num_classes,
+              num_classes);
+          beam_search.Step(input_bi);
+        }
+        Status s = beam_search.TopPaths(decode_helper_.GetTopPaths(),
+                                        &best_paths_b, &log_probs,
+                                        merge_repeated_);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          status.Update(s);
+          return;
+        }
 
-      beam_search.Reset();
+        beam_search.Reset();
 
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+        for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
-    }
+    };
+
+    const int64_t kCostPerUnit = 50 * max_time * num_classes * beam_width_;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          kCostPerUnit, decode);
+    OP_REQUIRES_OK(ctx, status);
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
                             best_paths, &decoded_indices, &decoded_values,
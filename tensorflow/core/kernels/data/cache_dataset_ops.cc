@@ -18,6 +18,7 @@ limitations under the License.
 #include <utility>
 
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/hash_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -28,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -66,15 +69,49 @@ constexpr char kIncompleteCacheErrorMessage[] =
     "an input pipeline similar to `dataset.cache().take(k).repeat()`. You "
     "should use `dataset.take(k).cache().repeat()` instead.";
 
+// Returns the file cache that replaces the in-memory cache of `input` when
+// TF_DATA_SHARED_CACHE_DIR is set, so that the processes of a host caching the
+// same data decode it once and share it.  The cache is keyed by the
+// fingerprint of the input dataset graph.  Returns an empty string if the
+// cache is not shared, e.g. because the input depends on external state and
+// the processes may not produce the same elements.
+string SharedCacheFilename(OpKernelContext* ctx, const DatasetBase* input) {
+  string dir;
+  Status s = ReadStringFromEnvVar("TF_DATA_SHARED_CACHE_DIR", "", &dir);
+  if (!s.ok()) LOG(ERROR) << s;
+  if (dir.empty()) return "";
+
+  GraphDef graph_def;
+  SerializationContext::Params params(ctx);
+  std::vector<std::pair<string, Tensor>> input_list;
+  params.input_list = &input_list;
+  params.external_state_policy =
+      SerializationContext::ExternalStatePolicy::kFail;
+  s = AsGraphDef(ctx, input, SerializationContext(params), &graph_def);
+  uint64 hash;
+  if (s.ok()) s = HashGraph(graph_def, &hash);
+  if (!s.ok()) {
+    VLOG(1) << "Not sharing the cache of " << input->DebugString() << ": "
+            << s;
+    return "";
+  }
+  return io::JoinPath(dir, strings::StrCat("cache_", strings::Hex(hash)));
+}
+
 }  // namespace
 
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
+  // If `shared` is true, the cache replaces an in-memory cache and is shared
+  // with other processes: iterators that find it being written by another
+  // process pass the input elements through, and the cache is read in place
+  // from a memory mapping.
   FileDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                  string filename, Env* env)
+                  string filename, Env* env, bool shared = false)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         filename_(std::move(filename)),
+        shared_(shared),
         env_(env),
         num_tensors_(input->output_dtypes().size()),
         tensor_index_padding_size_(StringPaddingSize(num_tensors_)),
@@ -122,10 +159,26 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   }
 
  protected:
+  // Returns the filename to serialize, which is empty for shared caches so
+  // that the dataset is cached in memory, or shared again, where it is
+  // deserialized.
+  tstring SerializedFilename() const { return shared_ ? "" : filename_; }
+
   const DatasetBase* const input_;
   const tstring filename_;
+  const bool shared_;
 
  private:
+  // Returns true if the cache has been completely written.  The lockfiles of
+  // the writer are deleted only once the shards have been merged, so a shared
+  // cache is complete once its metadata exists and its writer is gone.
+  bool CacheCompleted() const {
+    if (!env_->FileExists(MetaFilename(filename_)).ok()) return false;
+    return !shared_ ||
+           !env_->FileExists(strings::StrCat(filename_, "_0", kLockFileSuffix))
+                .ok();
+  }
+
   static size_t StringPaddingSize(size_t num_tensors) {
     return strings::Printf(kPaddingSizeStrFormat, num_tensors - 1).size();
   }
@@ -139,9 +192,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
    public:
     explicit FileIterator(const Params& params)
         : DatasetIterator<FileDatasetBase>(params) {
-      if (params.dataset->env_
-              ->FileExists(MetaFilename(params.dataset->filename_))
-              .ok()) {
+      if (params.dataset->CacheCompleted()) {
         mode_ = Mode::read;
       } else {
         mode_ = Mode::write;
@@ -181,10 +232,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kMode), &temp));
         mode_ = static_cast<Mode>(temp);
       }
-      if (mode_ == Mode::write &&
-          dataset()
-              ->env_->FileExists(MetaFilename(dataset()->filename_))
-              .ok()) {
+      if (mode_ == Mode::write && dataset()->CacheCompleted()) {
         // This could happen if the cache was completely written after the
         // checkpoint was saved.
         LOG(WARNING)
@@ -216,6 +264,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     // partial cache gets flushed to disk in files with prefix
     // <filename>_<shard_id> where shard_id is unique for each checkpoint.
     // When all elements have been produced, these shards get coalesced.
+    //
+    // An iterator of a shared cache that finds the cache being written by
+    // another process passes the input elements through without caching them.
     class FileWriterIterator : public DatasetIterator<FileDatasetBase> {
      public:
       explicit FileWriterIterator(const Params& params)
@@ -226,9 +277,12 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                 strings::StrCat(params.dataset->filename_, "_", shard_id_)),
             lockfile_(strings::StrCat(filename_, kLockFileSuffix)),
             lockfile_created_(false),
-            iteration_completed_(false) {}
+            iteration_completed_(false),
+            passthrough_(false) {}
 
       ~FileWriterIterator() override {
+        // The cache files belong to the process writing the cache.
+        if (passthrough_) return;
         if (!dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
           LOG(WARNING) << kIncompleteCacheErrorMessage;
           std::vector<string> cache_files;
@@ -262,6 +316,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           return Status::OK();
         }
+        if (passthrough_) {
+          return input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
+        }
         TF_RETURN_IF_ERROR(writer_->status());
         if (cur_index_ >= kMaxItems) {
           // As a courtesy, close the [truncated] cache file.
@@ -375,7 +432,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_,
+                                                  dataset()->WriterOptions());
         return Status::OK();
       }
 
@@ -386,12 +444,23 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
           *end_of_sequence = true;
           return Status::OK();
         }
-        if (lockfile_created_) {
+        if (lockfile_created_ || passthrough_) {
           return Status::OK();
         }
 
         // Perform rudimentary locking to help catch concurrent writes to the
         // same cache files.
+        if (dataset()->shared_ &&
+            (dataset()->env_->FileExists(MetaFilename(filename_)).ok() ||
+             dataset()->env_->FileExists(lockfile_).ok())) {
+          LOG(INFO) << "The shared cache " << dataset()->filename_
+                    << " is being written by another iterator; passing the "
+                    << "input elements through without caching them. If no "
+                    << "other process is writing the cache, delete "
+                    << lockfile_ << ".";
+          passthrough_ = true;
+          return Status::OK();
+        }
 
         // 1. Check that a checkpoint for the shard has not already been
         // written.
@@ -437,7 +506,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_,
+                                                  dataset()->WriterOptions());
         lockfile_created_ = true;
         return Status::OK();
       }
@@ -484,6 +554,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       string lockfile_ TF_GUARDED_BY(mu_);
       bool lockfile_created_ TF_GUARDED_BY(mu_);
       bool iteration_completed_ TF_GUARDED_BY(mu_);
+      bool passthrough_ TF_GUARDED_BY(mu_);
     };  // FileWriterIterator
 
     class FileReaderIterator : public DatasetIterator<FileDatasetBase> {
@@ -491,7 +562,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       explicit FileReaderIterator(const Params& params)
           : DatasetIterator<FileDatasetBase>(params),
             cur_index_(0),
-            reader_(dataset()->env_, dataset()->filename_),
+            reader_(dataset()->env_, dataset()->filename_,
+                    dataset()->ReaderOptions()),
             iterator_restored_(false) {}
 
       Status GetNextInternal(IteratorContext* ctx,
@@ -606,6 +678,23 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     std::unique_ptr<IteratorBase> iterator_ TF_GUARDED_BY(mu_);
   };  // FileIterator
 
+  // Shared caches align the tensors they write, so that readers alias them in
+  // the memory mapping instead of copying them.  The cache is written by
+  // another process of the same host, so the checksums of the mapped tensors
+  // are not verified.
+  BundleWriter::Options WriterOptions() const {
+    BundleWriter::Options options;
+    if (shared_) options.data_alignment = Allocator::kAllocatorAlignment;
+    return options;
+  }
+
+  BundleReader::Options ReaderOptions() const {
+    BundleReader::Options options;
+    options.use_mmap = shared_;
+    options.verify_mapped_checksums = false;
+    return options;
+  }
+
   Env* const env_;
   const size_t num_tensors_;
   const size_t tensor_index_padding_size_;
@@ -625,7 +714,7 @@ class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
     Node* input_graph = nullptr;
     TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph));
     Node* filename = nullptr;
-    TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename));
+    TF_RETURN_IF_ERROR(b->AddScalar(SerializedFilename(), &filename));
     TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph, filename}, output));
     return Status::OK();
   }
@@ -635,8 +724,8 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDatasetBase {
  public:
   explicit FileDatasetV2(OpKernelContext* ctx, const DatasetBase* input,
                          string filename, Env* env,
-                         const Tensor& resource_handle)
-      : FileDatasetBase(ctx, input, filename, env),
+                         const Tensor& resource_handle, bool shared = false)
+      : FileDatasetBase(ctx, input, filename, env, shared),
         resource_handle_(resource_handle) {}
 
  protected:
@@ -646,7 +735,7 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDatasetBase {
     Node* input_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_node));
     Node* filename_node = nullptr;
-    TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename_node));
+    TF_RETURN_IF_ERROR(b->AddScalar(SerializedFilename(), &filename_node));
     Node* resource_handle_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddTensor(resource_handle_, &resource_handle_node));
     TF_RETURN_IF_ERROR(b->AddDataset(
@@ -1029,6 +1118,11 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   // Parse out the filenames tensor.
   tstring filename;
   OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kFileName, &filename));
+  bool shared = false;
+  if (filename.empty()) {
+    filename = SharedCacheFilename(ctx, input);
+    shared = !filename.empty();
+  }
   if (filename.empty()) {
     static std::atomic<int64_t> resource_id_counter(0);
     const string& container = ctx->resource_manager()->default_container();
@@ -1071,10 +1165,10 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     }
   } else {
     if (op_version_ == 2) {
-      *output =
-          new FileDatasetV2(ctx, input, filename, ctx->env(), ctx->input(2));
+      *output = new FileDatasetV2(ctx, input, filename, ctx->env(),
+                                  ctx->input(2), shared);
     } else {
-      *output = new FileDataset(ctx, input, filename, ctx->env());
+      *output = new FileDataset(ctx, input, filename, ctx->env(), shared);
     }
   }
 }
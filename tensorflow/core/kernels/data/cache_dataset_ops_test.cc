@@ -370,6 +370,74 @@ INSTANTIATE_TEST_CASE_P(CacheDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+Status GetAll(TestIterator* iterator, std::vector<Tensor>* out_tensors) {
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_RETURN_IF_ERROR(iterator->GetNext(&next, &end_of_sequence));
+    out_tensors->insert(out_tensors->end(), next.begin(), next.end());
+  }
+  return Status::OK();
+}
+
+TEST_F(CacheDatasetOpTest, SharedMemoryCache) {
+  const string dir = io::JoinPath(testing::TmpDir(), "shared_cache");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  setenv("TF_DATA_SHARED_CACHE_DIR", dir.c_str(), /*overwrite=*/1);
+  auto dataset_params = CacheDatasetParams3();
+  Status s = Initialize(dataset_params);
+  // Another replica caching the same data.
+  std::unique_ptr<TestDataset> replica;
+  if (s.ok()) s = MakeDataset(dataset_params, &replica);
+  unsetenv("TF_DATA_SHARED_CACHE_DIR");
+  TF_ASSERT_OK(s);
+
+  // The in-memory caches are replaced by a shared file cache.
+  name_utils::IteratorPrefixParams iterator_prefix_params;
+  iterator_prefix_params.dataset_prefix = kFileDatasetPrefix;
+  TF_ASSERT_OK(CheckIteratorPrefix(name_utils::IteratorPrefix(
+      CacheDatasetOp::kDatasetType, dataset_params.iterator_prefix(),
+      iterator_prefix_params)));
+  const std::vector<Tensor> expected_outputs = CreateTensors<int64_t>(
+      TensorShape({3, 1}), {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+
+  // While the cache is being written, the replica passes the input through.
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  std::unique_ptr<TestIterator> replica_iterator;
+  TF_ASSERT_OK(MakeIterator(dataset_params, *replica, &replica_iterator));
+  std::vector<Tensor> replica_outputs;
+  TF_ASSERT_OK(GetAll(replica_iterator.get(), &replica_outputs));
+  TF_EXPECT_OK(ExpectEqual(replica_outputs, expected_outputs,
+                           /*compare_order=*/true));
+
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+
+  // Once the cache is complete, the replica reads it.
+  TF_ASSERT_OK(MakeIterator(dataset_params, *replica, &replica_iterator));
+  replica_outputs.clear();
+  TF_ASSERT_OK(GetAll(replica_iterator.get(), &replica_outputs));
+  TF_EXPECT_OK(ExpectEqual(replica_outputs, expected_outputs,
+                           /*compare_order=*/true));
+
+  std::vector<string> files;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(io::JoinPath(dir, "*"),
+                                                &files));
+  EXPECT_FALSE(files.empty());
+  for (const string& file : files) {
+    TF_EXPECT_OK(Env::Default()->DeleteFile(file));
+  }
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
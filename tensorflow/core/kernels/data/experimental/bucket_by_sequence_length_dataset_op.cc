@@ -0,0 +1,681 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBoundaries;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBatchSizes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddedShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kLengthComponent;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPadToBucketBoundary;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kNumPaddedShapes;
+/* static */ constexpr int64_t LengthBuckets::kMaxTableSize;
+
+namespace {
+
+constexpr char kInputImplEmpty[] = "input_impl_empty";
+constexpr char kBuckets[] = "buckets";
+constexpr char kSize[] = "size";
+constexpr char kBatch[] = "batch";
+constexpr char kElements[] = "elements";
+
+}  // namespace
+
+LengthBuckets::LengthBuckets(std::vector<int64_t> boundaries)
+    : boundaries_(std::move(boundaries)) {
+  const int64_t table_size =
+      boundaries_.empty()
+          ? 0
+          : std::min(std::max<int64_t>(boundaries_.back(), 0), kMaxTableSize);
+  table_.resize(table_size);
+  int32 bucket = 0;
+  for (int64_t length = 0; length < table_size; ++length) {
+    while (bucket < boundaries_.size() && boundaries_[bucket] <= length) {
+      ++bucket;
+    }
+    table_[length] = bucket;
+  }
+}
+
+int64_t LengthBuckets::Bucket(int64_t length) const {
+  if (length >= 0 && length < table_.size()) {
+    return table_[length];
+  }
+  return std::upper_bound(boundaries_.begin(), boundaries_.end(), length) -
+         boundaries_.begin();
+}
+
+class BucketBySequenceLengthDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::vector<int64_t> bucket_boundaries,
+          std::vector<int64_t> bucket_batch_sizes,
+          std::vector<PartialTensorShape> padded_shapes,
+          std::vector<Tensor> padding_values, bool drop_remainder,
+          int64_t length_component, bool pad_to_bucket_boundary)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        length_component_(length_component),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary),
+        buckets_(bucket_boundaries_),
+        traceme_metadata_(
+            {{"num_buckets",
+              strings::Printf("%lld", static_cast<long long>(
+                                          buckets_.num_buckets()))},
+             {"drop_remainder", drop_remainder ? "true" : "false"}}) {
+    input_->Ref();
+    bucket_padded_shapes_.resize(buckets_.num_buckets());
+    preallocated_.resize(buckets_.num_buckets());
+    for (int64_t bucket = 0; bucket < buckets_.num_buckets(); ++bucket) {
+      bool fully_defined = true;
+      for (PartialTensorShape shape : padded_shapes_) {
+        if (pad_to_bucket_boundary_ && bucket < bucket_boundaries_.size()) {
+          for (int dim = 0; dim < shape.dims(); ++dim) {
+            if (shape.dim_size(dim) == -1) {
+              shape.set_dim(dim, bucket_boundaries_[bucket] - 1);
+            }
+          }
+        }
+        fully_defined = fully_defined && shape.IsFullyDefined();
+        bucket_padded_shapes_[bucket].push_back(std::move(shape));
+      }
+      preallocated_[bucket] = fully_defined;
+    }
+
+    // The batch dimension is only known if every batch has the same size, and
+    // the other dimensions only if the buckets agree on them.
+    int64_t batch_size = bucket_batch_sizes_[0];
+    for (int64_t size : bucket_batch_sizes_) {
+      if (size != batch_size || !drop_remainder_) {
+        batch_size = -1;
+      }
+    }
+    for (int i = 0; i < padded_shapes_.size(); ++i) {
+      PartialTensorShape shape = bucket_padded_shapes_[0][i];
+      for (const auto& bucket_shapes : bucket_padded_shapes_) {
+        for (int dim = 0; dim < shape.dims(); ++dim) {
+          if (bucket_shapes[i].dim_size(dim) != shape.dim_size(dim)) {
+            shape.set_dim(dim, -1);
+          }
+        }
+      }
+      output_shapes_.push_back(
+          PartialTensorShape({batch_size}).Concatenate(shape));
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t Cardinality() const override {
+    int64_t n = input_->Cardinality();
+    if (n == kInfiniteCardinality) {
+      return n;
+    }
+    return kUnknownCardinality;
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* bucket_boundaries = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+    Node* bucket_batch_sizes = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_batch_sizes_, &bucket_batch_sizes));
+
+    std::vector<Node*> padded_shapes;
+    padded_shapes.reserve(padded_shapes_.size());
+    for (int i = 0; i < padded_shapes_.size(); i++) {
+      Node* node;
+      Tensor t(DT_INT64, TensorShape({padded_shapes_[i].dims()}));
+      for (int j = 0; j < padded_shapes_[i].dims(); j++) {
+        t.vec<int64_t>()(j) = padded_shapes_[i].dim_size(j);
+      }
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padded_shapes.emplace_back(node);
+    }
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+
+    AttrValue length_component;
+    b->BuildAttrValue(length_component_, &length_component);
+    AttrValue pad_to_bucket_boundary;
+    b->BuildAttrValue(pad_to_bucket_boundary_, &pad_to_bucket_boundary);
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+    AttrValue N;
+    b->BuildAttrValue<int64_t>(padded_shapes_.size(), &N);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {1, bucket_boundaries},
+         {2, bucket_batch_sizes},
+         {5, drop_remainder}},
+        {{3, padded_shapes}, {4, padding_values}},
+        {{kLengthComponent, length_component},
+         {kPadToBucketBoundary, pad_to_bucket_boundary},
+         {kToutputTypes, output_types},
+         {kNumPaddedShapes, N}},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          buckets_(params.dataset->buckets_.num_buckets()) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      while (input_impl_) {
+        std::vector<Tensor> element;
+        bool end_of_input = false;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) {
+          input_impl_.reset();
+          break;
+        }
+        int64_t length;
+        TF_RETURN_IF_ERROR(ElementLength(element, &length));
+        const int64_t bucket = dataset()->buckets_.Bucket(length);
+        TF_RETURN_IF_ERROR(Append(ctx, bucket, std::move(element)));
+        if (buckets_[bucket].size == dataset()->bucket_batch_sizes_[bucket]) {
+          *end_of_sequence = false;
+          return EmitBatch(ctx, bucket, out_tensors);
+        }
+      }
+      // At the end of the input, the partial batches are emitted in bucket
+      // order.
+      for (int64_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+        if (buckets_[bucket].size == 0) {
+          continue;
+        }
+        if (dataset()->drop_remainder_) {
+          buckets_[bucket] = Bucket();
+          continue;
+        }
+        *end_of_sequence = false;
+        return EmitBatch(ctx, bucket, out_tensors);
+      }
+      *end_of_sequence = true;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kInputImplEmpty), ""));
+      }
+      const int64_t num_components = dataset()->padded_shapes_.size();
+      for (int64_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+        const Bucket& b = buckets_[bucket];
+        const std::string bucket_prefix =
+            absl::StrCat(kBuckets, "[", bucket, "]");
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(absl::StrCat(bucket_prefix, kSize)), b.size));
+        if (b.size == 0) {
+          continue;
+        }
+        if (dataset()->preallocated_[bucket]) {
+          for (int64_t c = 0; c < num_components; ++c) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                full_name(absl::StrCat(bucket_prefix, kBatch, "[", c, "]")),
+                b.batch[c]));
+          }
+          continue;
+        }
+        for (int64_t i = 0; i < b.size; ++i) {
+          for (int64_t c = 0; c < num_components; ++c) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                full_name(absl::StrCat(bucket_prefix, kElements, "[", i, "][",
+                                       c, "]")),
+                b.elements[i][c]));
+          }
+        }
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kInputImplEmpty))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      const int64_t num_components = dataset()->padded_shapes_.size();
+      for (int64_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+        Bucket& b = buckets_[bucket];
+        b = Bucket();
+        const std::string bucket_prefix =
+            absl::StrCat(kBuckets, "[", bucket, "]");
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(absl::StrCat(bucket_prefix, kSize)), &b.size));
+        if (b.size == 0) {
+          continue;
+        }
+        if (dataset()->preallocated_[bucket]) {
+          b.batch.resize(num_components);
+          for (int64_t c = 0; c < num_components; ++c) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                ctx->flr(),
+                full_name(absl::StrCat(bucket_prefix, kBatch, "[", c, "]")),
+                &b.batch[c]));
+          }
+          continue;
+        }
+        b.elements.resize(b.size);
+        for (int64_t i = 0; i < b.size; ++i) {
+          b.elements[i].resize(num_components);
+          for (int64_t c = 0; c < num_components; ++c) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                ctx->flr(),
+                full_name(absl::StrCat(bucket_prefix, kElements, "[", i, "][",
+                                       c, "]")),
+                &b.elements[i][c]));
+          }
+        }
+      }
+      return Status::OK();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return dataset()->traceme_metadata_;
+    }
+
+   private:
+    // The batch being built for a bucket.
+    struct Bucket {
+      // The number of elements in the batch.
+      int64_t size = 0;
+      // For buckets with fully defined padded shapes, the padded batch, which
+      // is allocated when its first element arrives. Elements are copied into
+      // it as they arrive.
+      std::vector<Tensor> batch;
+      // For the other buckets, the elements of the batch, which are copied
+      // once the padded shape of the batch is known.
+      std::vector<std::vector<Tensor>> elements;
+    };
+
+    // Returns the length of `element`: the value of its length component if
+    // that is an integer scalar, and the size of its first dimension
+    // otherwise.
+    Status ElementLength(const std::vector<Tensor>& element, int64_t* length) {
+      const Tensor& t = element[dataset()->length_component_];
+      if (t.dims() > 0) {
+        *length = t.dim_size(0);
+        return Status::OK();
+      }
+      if (t.dtype() == DT_INT32) {
+        *length = t.scalar<int32>()();
+        return Status::OK();
+      }
+      if (t.dtype() == DT_INT64) {
+        *length = t.scalar<int64_t>()();
+        return Status::OK();
+      }
+      return errors::InvalidArgument(
+          "The length component ", dataset()->length_component_,
+          " must be an integer scalar or have at least one dimension, got a ",
+          DataTypeString(t.dtype()), " scalar.");
+    }
+
+    // Checks that the `component`-th component of an element, of shape
+    // `shape`, fits the padded shape of the batches of `bucket`.
+    Status CheckShape(int64_t bucket, int64_t component,
+                      const TensorShape& shape) {
+      const PartialTensorShape& padded_shape =
+          dataset()->bucket_padded_shapes_[bucket][component];
+      if (shape.dims() != padded_shape.dims()) {
+        return errors::InvalidArgument(
+            "All elements in a batch must have the same rank as the padded "
+            "shape for component",
+            component, ": expected rank ", padded_shape.dims(),
+            " but got element with rank ", shape.dims());
+      }
+      for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+        if (padded_shape.dim_size(dim) != -1 &&
+            shape.dim_size(dim) > padded_shape.dim_size(dim)) {
+          return errors::DataLoss(
+              "Attempted to pad to a smaller size than the input element.");
+        }
+      }
+      return Status::OK();
+    }
+
+    // Adds `element` to the batch of `bucket`.
+    Status Append(IteratorContext* ctx, int64_t bucket,
+                  std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket& b = buckets_[bucket];
+      for (int64_t c = 0; c < element.size(); ++c) {
+        TF_RETURN_IF_ERROR(CheckShape(bucket, c, element[c].shape()));
+      }
+      if (!dataset()->preallocated_[bucket]) {
+        b.elements.push_back(std::move(element));
+        ++b.size;
+        return Status::OK();
+      }
+      if (b.size == 0) {
+        b.batch.clear();
+        for (int64_t c = 0; c < element.size(); ++c) {
+          TensorShape shape({dataset()->bucket_batch_sizes_[bucket]});
+          TensorShape padded_shape;
+          dataset()->bucket_padded_shapes_[bucket][c].AsTensorShape(
+              &padded_shape);
+          shape.AppendShape(padded_shape);
+          b.batch.emplace_back(ctx->allocator({}), output_dtypes()[c], shape);
+          TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+              &b.batch.back(), dataset()->padding_values_[c]));
+        }
+      }
+      for (int64_t c = 0; c < element.size(); ++c) {
+        // The padded shape is fully defined here, so compatible elements need
+        // no padding.
+        if (dataset()->bucket_padded_shapes_[bucket][c].IsCompatibleWith(
+                element[c].shape())) {
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+              std::move(element[c]), &b.batch[c], b.size));
+        } else {
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
+              element[c], &b.batch[c], b.size));
+        }
+      }
+      ++b.size;
+      return Status::OK();
+    }
+
+    // Moves the batch of `bucket` to `out_tensors`.
+    Status EmitBatch(IteratorContext* ctx, int64_t bucket,
+                     std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket b = std::move(buckets_[bucket]);
+      buckets_[bucket] = Bucket();
+      out_tensors->clear();
+      if (dataset()->preallocated_[bucket]) {
+        if (b.size == dataset()->bucket_batch_sizes_[bucket]) {
+          *out_tensors = std::move(b.batch);
+          return Status::OK();
+        }
+        // A partial batch at the end of the input.
+        for (Tensor& batch : b.batch) {
+          TensorShape shape = batch.shape();
+          shape.set_dim(0, b.size);
+          out_tensors->emplace_back(ctx->allocator({}), batch.dtype(), shape);
+          TF_RETURN_IF_ERROR(batch_util::CopyContiguousSlices(
+              batch, /*src_offset=*/0, /*dst_offset=*/0, b.size,
+              &out_tensors->back()));
+        }
+        return Status::OK();
+      }
+      for (int64_t c = 0; c < dataset()->padded_shapes_.size(); ++c) {
+        // Unknown dimensions are padded to the largest element of the batch.
+        const PartialTensorShape& padded_shape =
+            dataset()->bucket_padded_shapes_[bucket][c];
+        TensorShape shape({b.size});
+        for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+          int64_t size = padded_shape.dim_size(dim);
+          if (size == -1) {
+            size = 0;
+            for (const auto& element : b.elements) {
+              size = std::max(size, element[c].dim_size(dim));
+            }
+          }
+          shape.AddDim(size);
+        }
+        out_tensors->emplace_back(ctx->allocator({}), output_dtypes()[c],
+                                  shape);
+        Tensor& batch = out_tensors->back();
+        TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+            &batch, dataset()->padding_values_[c]));
+        for (int64_t i = 0; i < b.size; ++i) {
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
+              b.elements[i][c], &batch, i));
+        }
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+  };
+
+  const DatasetBase* const input_;
+  const std::vector<int64_t> bucket_boundaries_;
+  const std::vector<int64_t> bucket_batch_sizes_;
+  const std::vector<PartialTensorShape> padded_shapes_;
+  const std::vector<Tensor> padding_values_;
+  const bool drop_remainder_;
+  const int64_t length_component_;
+  const bool pad_to_bucket_boundary_;
+  const LengthBuckets buckets_;
+  // The padded shapes of the batches of each bucket, and whether they are
+  // fully defined.
+  std::vector<std::vector<PartialTensorShape>> bucket_padded_shapes_;
+  std::vector<bool> preallocated_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const TraceMeMetadata traceme_metadata_;
+};
+
+BucketBySequenceLengthDatasetOp::BucketBySequenceLengthDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kLengthComponent, &length_component_));
+  OP_REQUIRES_OK(ctx,
+                 ctx->GetAttr(kPadToBucketBoundary, &pad_to_bucket_boundary_));
+}
+
+void BucketBySequenceLengthDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                                  DatasetBase* input,
+                                                  DatasetBase** output) {
+  const int64_t num_components = input->output_dtypes().size();
+  OP_REQUIRES(
+      ctx, length_component_ < num_components,
+      errors::InvalidArgument("`length_component` (", length_component_,
+                              ") must be less than the number of components "
+                              "in the input dataset's elements (",
+                              num_components, ")"));
+
+  std::vector<int64_t> bucket_boundaries;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBoundaries,
+                                                   &bucket_boundaries));
+  for (int i = 1; i < bucket_boundaries.size(); ++i) {
+    OP_REQUIRES(ctx, bucket_boundaries[i - 1] < bucket_boundaries[i],
+                errors::InvalidArgument(
+                    "`bucket_boundaries` must be strictly increasing."));
+  }
+  OP_REQUIRES(
+      ctx,
+      !pad_to_bucket_boundary_ || bucket_boundaries.empty() ||
+          bucket_boundaries[0] > 0,
+      errors::InvalidArgument("`bucket_boundaries` must be positive when "
+                              "`pad_to_bucket_boundary` is true."));
+
+  std::vector<int64_t> bucket_batch_sizes;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBatchSizes,
+                                                   &bucket_batch_sizes));
+  OP_REQUIRES(ctx, bucket_batch_sizes.size() == bucket_boundaries.size() + 1,
+              errors::InvalidArgument(
+                  "`bucket_batch_sizes` must have one more element than "
+                  "`bucket_boundaries`, got ",
+                  bucket_batch_sizes.size(), " and ", bucket_boundaries.size(),
+                  " elements."));
+  for (int64_t batch_size : bucket_batch_sizes) {
+    OP_REQUIRES(ctx, batch_size > 0,
+                errors::InvalidArgument(
+                    "Bucket batch sizes must be greater than zero."));
+  }
+
+  bool drop_remainder;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
+
+  OpInputList padded_shape_tensors;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddedShapes, &padded_shape_tensors));
+  OP_REQUIRES(ctx, padded_shape_tensors.size() == num_components,
+              errors::InvalidArgument("Number of padded shapes (",
+                                      padded_shape_tensors.size(),
+                                      ") must match the number of components "
+                                      "in the input dataset's elements (",
+                                      num_components, ")"));
+  std::vector<PartialTensorShape> padded_shapes;
+  padded_shapes.reserve(num_components);
+  for (const Tensor& padded_shape_t : padded_shape_tensors) {
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                errors::InvalidArgument("All padded shapes must be vectors"));
+    PartialTensorShape padded_shape;
+    OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                            padded_shape_t.vec<int64_t>().data(),
+                            padded_shape_t.NumElements(), &padded_shape));
+    padded_shapes.push_back(std::move(padded_shape));
+  }
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  OP_REQUIRES(ctx, padding_values_list.size() == num_components,
+              errors::InvalidArgument(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of components in the input "
+                  "dataset's elements (",
+                  num_components, ")"));
+  std::vector<Tensor> padding_values;
+  padding_values.reserve(num_components);
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  *output = new Dataset(ctx, input, std::move(bucket_boundaries),
+                        std::move(bucket_batch_sizes), std::move(padded_shapes),
+                        std::move(padding_values), drop_remainder,
+                        length_component_, pad_to_bucket_boundary_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+}  // namespace
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
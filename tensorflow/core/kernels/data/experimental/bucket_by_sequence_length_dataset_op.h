@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_SEQUENCE_LENGTH_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_SEQUENCE_LENGTH_DATASET_OP_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Maps sequence lengths to the buckets delimited by sorted `boundaries`:
+// bucket `i` holds the lengths in `[boundaries[i - 1], boundaries[i])`, the
+// first bucket also holds the lengths below `boundaries[0]` and the last one
+// the lengths from `boundaries.back()` on.
+//
+// Lengths below `kMaxTableSize` are looked up in a table, so that the bucket
+// of an element is found in constant time. Longer lengths fall back to a
+// binary search.
+class LengthBuckets {
+ public:
+  explicit LengthBuckets(std::vector<int64_t> boundaries);
+
+  int64_t num_buckets() const { return boundaries_.size() + 1; }
+
+  // Returns the bucket of `length`.
+  int64_t Bucket(int64_t length) const;
+
+ private:
+  static constexpr int64_t kMaxTableSize = 1 << 16;
+
+  const std::vector<int64_t> boundaries_;
+  std::vector<int32> table_;
+};
+
+// See api_def_BucketBySequenceLengthDataset.pbtxt in
+// tensorflow/core/api_def/base_api for the API definition that corresponds to
+// this kernel.
+class BucketBySequenceLengthDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  // Names of op parameters, public so that they can be accessed by test cases.
+  // Make sure that these are kept in sync with the REGISTER_OP call in
+  // tensorflow/core/ops/experimental_dataset_ops.cc
+  static constexpr const char* const kDatasetType = "BucketBySequenceLength";
+  static constexpr const char* const kInputDataset = "input_dataset";
+  static constexpr const char* const kBucketBoundaries = "bucket_boundaries";
+  static constexpr const char* const kBucketBatchSizes = "bucket_batch_sizes";
+  static constexpr const char* const kPaddedShapes = "padded_shapes";
+  static constexpr const char* const kPaddingValues = "padding_values";
+  static constexpr const char* const kDropRemainder = "drop_remainder";
+  static constexpr const char* const kLengthComponent = "length_component";
+  static constexpr const char* const kPadToBucketBoundary =
+      "pad_to_bucket_boundary";
+  static constexpr const char* const kToutputTypes = "Toutput_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+  static constexpr const char* const kNumPaddedShapes = "N";
+
+  explicit BucketBySequenceLengthDatasetOp(OpKernelConstruction* ctx);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+
+  int64_t length_component_;
+  bool pad_to_bucket_boundary_;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_BUCKET_BY_SEQUENCE_LENGTH_DATASET_OP_H_
@@ -0,0 +1,276 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "bucket_by_sequence_length_dataset";
+
+class BucketBySequenceLengthDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  BucketBySequenceLengthDatasetParams(
+      T input_dataset_params, std::vector<int64_t> bucket_boundaries,
+      std::vector<int64_t> bucket_batch_sizes,
+      std::vector<Tensor> padded_shapes, std::vector<Tensor> padding_values,
+      bool drop_remainder, int64_t length_component,
+      bool pad_to_bucket_boundary, DataTypeVector output_dtypes,
+      std::vector<PartialTensorShape> output_shapes, string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        length_component_(length_component),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    std::vector<Tensor> input_tensors = {
+        CreateTensor<int64_t>(
+            TensorShape({static_cast<int64_t>(bucket_boundaries_.size())}),
+            bucket_boundaries_),
+        CreateTensor<int64_t>(
+            TensorShape({static_cast<int64_t>(bucket_batch_sizes_.size())}),
+            bucket_batch_sizes_)};
+    for (const Tensor& padded_shape : padded_shapes_) {
+      input_tensors.push_back(padded_shape);
+    }
+    for (const Tensor& padding_value : padding_values_) {
+      input_tensors.push_back(padding_value);
+    }
+    input_tensors.push_back(
+        CreateTensor<bool>(TensorShape({}), {drop_remainder_}));
+    return input_tensors;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {BucketBySequenceLengthDatasetOp::kInputDataset,
+                    BucketBySequenceLengthDatasetOp::kBucketBoundaries,
+                    BucketBySequenceLengthDatasetOp::kBucketBatchSizes};
+    for (int i = 0; i < padded_shapes_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddedShapes, "_", i));
+    }
+    for (int i = 0; i < padding_values_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddingValues, "_", i));
+    }
+    input_names->push_back(BucketBySequenceLengthDatasetOp::kDropRemainder);
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {BucketBySequenceLengthDatasetOp::kLengthComponent, length_component_},
+        {BucketBySequenceLengthDatasetOp::kPadToBucketBoundary,
+         pad_to_bucket_boundary_},
+        {BucketBySequenceLengthDatasetOp::kToutputTypes, output_dtypes_},
+        {BucketBySequenceLengthDatasetOp::kOutputShapes, output_shapes_},
+        {BucketBySequenceLengthDatasetOp::kNumPaddedShapes,
+         static_cast<int>(padded_shapes_.size())},
+        {"metadata", ""}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return BucketBySequenceLengthDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<int64_t> bucket_boundaries_;
+  std::vector<int64_t> bucket_batch_sizes_;
+  std::vector<Tensor> padded_shapes_;
+  std::vector<Tensor> padding_values_;
+  bool drop_remainder_;
+  int64_t length_component_;
+  bool pad_to_bucket_boundary_;
+};
+
+class BucketBySequenceLengthDatasetOpTest : public DatasetOpsTestBase {};
+
+// Buckets the scalars of a range by their value.
+BucketBySequenceLengthDatasetParams RangeParams(
+    bool drop_remainder, std::vector<int64_t> bucket_boundaries = {3, 6},
+    std::vector<int64_t> bucket_batch_sizes = {2, 2, 3},
+    int64_t length_component = 0) {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1), std::move(bucket_boundaries),
+      std::move(bucket_batch_sizes),
+      /*padded_shapes=*/{CreateTensor<int64_t>(TensorShape({0}), {})},
+      /*padding_values=*/{CreateTensor<int64_t>(TensorShape({}), {0})},
+      drop_remainder, length_component, /*pad_to_bucket_boundary=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+// Buckets vectors by the length in their second component, padding the
+// vectors of the first bucket to its boundary and the vectors of the last
+// bucket to the longest vector of their batch.
+BucketBySequenceLengthDatasetParams PaddedParams() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(TensorShape({4, 2}),
+                                            {1, 2, 3, 4, 5, 6, 7, 8}),
+                      CreateTensor<int64_t>(TensorShape({4}), {1, 2, 4, 5})},
+      /*node_name=*/"tensor_slice");
+  return BucketBySequenceLengthDatasetParams(
+      std::move(tensor_slice_dataset_params), /*bucket_boundaries=*/{4},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/
+      {CreateTensor<int64_t>(TensorShape({1}), {-1}),
+       CreateTensor<int64_t>(TensorShape({0}), {})},
+      /*padding_values=*/
+      {CreateTensor<int64_t>(TensorShape({}), {-1}),
+       CreateTensor<int64_t>(TensorShape({}), {0})},
+      /*drop_remainder=*/false, /*length_component=*/1,
+      /*pad_to_bucket_boundary=*/true,
+      /*output_dtypes=*/{DT_INT64, DT_INT64},
+      /*output_shapes=*/
+      {PartialTensorShape({-1, -1}), PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> RangeOutputs(bool drop_remainder) {
+  std::vector<Tensor> outputs = {
+      CreateTensor<int64_t>(TensorShape({2}), {0, 1}),
+      CreateTensor<int64_t>(TensorShape({2}), {3, 4}),
+      CreateTensor<int64_t>(TensorShape({3}), {6, 7, 8})};
+  if (!drop_remainder) {
+    outputs.push_back(CreateTensor<int64_t>(TensorShape({1}), {2}));
+    outputs.push_back(CreateTensor<int64_t>(TensorShape({1}), {5}));
+    outputs.push_back(CreateTensor<int64_t>(TensorShape({1}), {9}));
+  }
+  return outputs;
+}
+
+std::vector<Tensor> PaddedOutputs() {
+  return {CreateTensor<int64_t>(TensorShape({2, 3}), {1, 2, -1, 3, 4, -1}),
+          CreateTensor<int64_t>(TensorShape({2}), {1, 2}),
+          CreateTensor<int64_t>(TensorShape({2, 2}), {5, 6, 7, 8}),
+          CreateTensor<int64_t>(TensorShape({2}), {4, 5})};
+}
+
+TEST(LengthBucketsTest, Bucket) {
+  LengthBuckets buckets({3, 6});
+  EXPECT_EQ(buckets.num_buckets(), 3);
+  EXPECT_EQ(buckets.Bucket(-1), 0);
+  EXPECT_EQ(buckets.Bucket(0), 0);
+  EXPECT_EQ(buckets.Bucket(2), 0);
+  EXPECT_EQ(buckets.Bucket(3), 1);
+  EXPECT_EQ(buckets.Bucket(5), 1);
+  EXPECT_EQ(buckets.Bucket(6), 2);
+  EXPECT_EQ(buckets.Bucket(1000), 2);
+}
+
+TEST(LengthBucketsTest, BoundariesBeyondTable) {
+  LengthBuckets buckets({10, 1 << 20});
+  EXPECT_EQ(buckets.Bucket(9), 0);
+  EXPECT_EQ(buckets.Bucket(10), 1);
+  EXPECT_EQ(buckets.Bucket(1 << 17), 1);
+  EXPECT_EQ(buckets.Bucket((1 << 20) - 1), 1);
+  EXPECT_EQ(buckets.Bucket(1 << 20), 2);
+}
+
+TEST(LengthBucketsTest, NoBoundaries) {
+  LengthBuckets buckets({});
+  EXPECT_EQ(buckets.num_buckets(), 1);
+  EXPECT_EQ(buckets.Bucket(0), 0);
+  EXPECT_EQ(buckets.Bucket(100), 0);
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, GetNext) {
+  auto dataset_params = RangeParams(/*drop_remainder=*/false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({-1})}));
+  TF_ASSERT_OK(CheckIteratorGetNext(RangeOutputs(/*drop_remainder=*/false),
+                                    /*compare_order=*/true));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DropRemainder) {
+  auto dataset_params = RangeParams(/*drop_remainder=*/true);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(RangeOutputs(/*drop_remainder=*/true),
+                                    /*compare_order=*/true));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, StaticBatchSize) {
+  auto dataset_params =
+      RangeParams(/*drop_remainder=*/true, /*bucket_boundaries=*/{5},
+                  /*bucket_batch_sizes=*/{2, 2});
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({2})}));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, PadsToBucketBoundary) {
+  auto dataset_params = PaddedParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(PaddedOutputs(), /*compare_order=*/true));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, SaveAndRestore) {
+  auto dataset_params = RangeParams(/*drop_remainder=*/false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), RangeOutputs(/*drop_remainder=*/false),
+      /*breakpoints=*/{0, 1, 3, 6}, /*compare_order=*/true));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, SaveAndRestoreBufferedBucket) {
+  auto dataset_params = PaddedParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), PaddedOutputs(),
+      /*breakpoints=*/{0, 1, 2}, /*compare_order=*/true));
+}
+
+class ParameterizedInvalidArgumentTest
+    : public BucketBySequenceLengthDatasetOpTest,
+      public ::testing::WithParamInterface<
+          BucketBySequenceLengthDatasetParams> {};
+
+TEST_P(ParameterizedInvalidArgumentTest, InvalidArguments) {
+  auto dataset_params = GetParam();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BucketBySequenceLengthDatasetOpTest, ParameterizedInvalidArgumentTest,
+    ::testing::ValuesIn(
+        {RangeParams(/*drop_remainder=*/false, /*bucket_boundaries=*/{6, 3}),
+         RangeParams(/*drop_remainder=*/false, /*bucket_boundaries=*/{3, 6},
+                     /*bucket_batch_sizes=*/{2, 2}),
+         RangeParams(/*drop_remainder=*/false, /*bucket_boundaries=*/{3, 6},
+                     /*bucket_batch_sizes=*/{2, 0, 3}),
+         RangeParams(/*drop_remainder=*/false, /*bucket_boundaries=*/{3, 6},
+                     /*bucket_batch_sizes=*/{2, 2, 3},
+                     /*length_component=*/1)}));
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
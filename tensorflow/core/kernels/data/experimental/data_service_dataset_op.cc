@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/dispatcher_client.h"
 #include "tensorflow/core/data/service/grpc_util.h"
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/data/service/worker_client.h"
 #include "tensorflow/core/data/service/worker_impl.h"
@@ -50,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/status.h"
@@ -101,6 +103,14 @@ bool IsColocatedTask(const TaskInfo& task) {
     return absl::AsciiStrToUpper(worker_tag) == kColocatedWorkerTag;
   });
 }
+
+// Returns whether the worker of `task` runs on the same host as the client,
+// according to the hostname it reported to the dispatcher.
+bool IsSameHostTask(const TaskInfo& task) {
+  static const std::string* const hostname = new std::string(port::Hostname());
+  return !task.worker_hostname().empty() &&
+         task.worker_hostname() == *hostname;
+}
 }  // namespace
 
 // Dataset for reading data from the tf.data service non-deterministically.
@@ -330,10 +340,17 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       EnsureThreadsStarted(ctx);
       Result result;
       do {
+        int64_t wait_start_micros = -1;
         while (!ResultReady() && !Finished() && !cancelled_ && status_.ok()) {
           VLOG(3) << "Blocking in GetNext: " << DebugString();
+          if (wait_start_micros < 0) {
+            wait_start_micros = Env::Default()->NowMicros();
+          }
           get_next_cv_.wait(l);
         }
+        if (wait_start_micros >= 0) {
+          wait_time_micros_ += Env::Default()->NowMicros() - wait_start_micros;
+        }
         if (cancelled_) {
           VLOG(3) << "Returning from GetNext due to cancellation";
           return errors::Cancelled("Data service iterator was cancelled");
@@ -605,11 +622,21 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     }
 
     Status AddTask(const TaskInfo& task_info) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::string transfer_address = task_info.transfer_address();
+      std::string transfer_protocol = dataset()->data_transfer_protocol_;
+      // Shared memory only reaches workers on other processes of this host.
+      // Workers on other hosts are read through gRPC, and workers in this
+      // process through the local protocol that gRPC reads are upgraded to.
+      if (transfer_protocol == kSharedMemoryTransferProtocol &&
+          (!IsSameHostTask(task_info) ||
+           LocalWorkers::Get(task_info.worker_address()) != nullptr)) {
+        transfer_address = task_info.worker_address();
+        transfer_protocol = kGrpcTransferProtocol;
+      }
       TF_ASSIGN_OR_RETURN(
           std::unique_ptr<DataServiceWorkerClient> worker,
-          CreateDataServiceWorkerClient(task_info.transfer_address(),
-                                        dataset()->protocol_,
-                                        dataset()->data_transfer_protocol_));
+          CreateDataServiceWorkerClient(transfer_address, dataset()->protocol_,
+                                        transfer_protocol));
       tasks_.push_back(std::make_shared<Task>(task_info, std::move(worker)));
       worker_thread_cv_.notify_one();
       if (StrictRoundRobin()) {
@@ -628,12 +655,22 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     void Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
       ClientHeartbeatRequest req;
       req.set_job_client_id(job_client_id_);
-      if (StrictRoundRobin()) {
+      {
         mutex_lock l(mu_);
-        req.set_current_round(current_round_);
-        if (round_robin_round_limit_.has_value()) {
-          req.set_blocked_round(round_robin_round_limit_.value());
+        if (StrictRoundRobin()) {
+          req.set_current_round(current_round_);
+          if (round_robin_round_limit_.has_value()) {
+            req.set_blocked_round(round_robin_round_limit_.value());
+          }
         }
+        int64_t now_micros = Env::Default()->NowMicros();
+        if (last_heartbeat_micros_ >= 0) {
+          ConsumerMetrics* metrics = req.mutable_consumer_metrics();
+          metrics->set_wait_time_usec(wait_time_micros_);
+          metrics->set_interval_usec(now_micros - last_heartbeat_micros_);
+        }
+        wait_time_micros_ = 0;
+        last_heartbeat_micros_ = now_micros;
       }
       ClientHeartbeatResponse resp;
       Status s = dispatcher_->ClientHeartbeat(req, resp);
@@ -730,7 +767,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       // Cross-TF/TPU host reads may cause resource contention on the TF/TPU
       // hosts. tf.data service avoids reading from non-local TF-hosted workers.
       const bool is_cross_tf_host_read =
-          !is_local_task && IsColocatedTask(task);
+          !is_local_task && !IsSameHostTask(task) && IsColocatedTask(task);
       if (dataset()->target_workers_ == TARGET_WORKERS_AUTO &&
           is_cross_tf_host_read) {
         return false;
@@ -755,9 +792,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         absl::string_view worker_address = task->info.worker_address();
         // The `LocalWorkers` class may not truthfully reflect local workers
         // when a local worker is temporarily down. Instead, we assume that if
-        // a worker is initially local, it must always be local.
+        // a worker is initially local, it must always be local. Workers in
+        // other processes of the same host are preferred like local workers.
         if (previous_local_tasks.contains(worker_address) ||
-            LocalWorkers::Get(worker_address)) {
+            LocalWorkers::Get(worker_address) || IsSameHostTask(task->info)) {
           local_tasks[worker_address] = task;
         }
       }
@@ -1215,6 +1253,9 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
 
     // List of tasks to read from.
     std::vector<std::shared_ptr<Task>> tasks_ TF_GUARDED_BY(mu_);
+    // Tasks of the workers in this process or on this host, keyed by worker
+    // address. They are read first, and get additional buffer space, so that
+    // other hosts are only read when the local workers are behind.
     absl::flat_hash_map<std::string, std::shared_ptr<Task>> local_tasks_
         TF_GUARDED_BY(mu_);
 
@@ -1228,6 +1269,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     //            next_task_index_ must be 0.
     absl::optional<int64_t> round_robin_round_limit_ TF_GUARDED_BY(mu_);
 
+    // The time `GetNext` spent waiting for results since the last heartbeat,
+    // which the heartbeat reports for autoscaling.
+    int64_t wait_time_micros_ TF_GUARDED_BY(mu_) = 0;
+    // The time of the last heartbeat, or -1 before the first heartbeat.
+    int64_t last_heartbeat_micros_ TF_GUARDED_BY(mu_) = -1;
+
     // A status to be returned from the next call to `GetNext`. This is set by
     // asynchronous threads when they encounter errors.
     Status status_ TF_GUARDED_BY(mu_) = Status::OK();
@@ -0,0 +1,283 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/global_shuffle_dataset_op.h"
+
+#include <atomic>
+
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kDatasetType;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kInputDataset;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kSeed;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kSeed2;
+/* static */ constexpr const char* const
+    GlobalShuffleDatasetOp::kReshuffleEachIteration;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kOutputShapes;
+/* static */ constexpr const int IndexPermutation::kNumRounds;
+
+namespace {
+
+constexpr char kEpoch[] = "epoch";
+constexpr char kNextIndex[] = "next_index";
+
+// The finalizer of SplitMix64, which mixes the bits of `x` well.
+uint64 Mix(uint64 x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+}  // namespace
+
+IndexPermutation::IndexPermutation(int64_t n, int64_t seed, int64_t seed2)
+    : n_(n) {
+  int bits = 2;
+  while (bits < 64 && (uint64{1} << bits) < static_cast<uint64>(n)) {
+    bits += 2;
+  }
+  half_bits_ = bits / 2;
+  half_mask_ = (uint64{1} << half_bits_) - 1;
+
+  random::PhiloxRandom generator(seed, seed2);
+  for (int i = 0; i < kNumRounds; i += 2) {
+    const random::PhiloxRandom::ResultType sample = generator();
+    keys_[i] = (static_cast<uint64>(sample[0]) << 32) | sample[1];
+    keys_[i + 1] = (static_cast<uint64>(sample[2]) << 32) | sample[3];
+  }
+}
+
+uint64 IndexPermutation::Round(int round, uint64 half) const {
+  return Mix(half ^ keys_[round]) & half_mask_;
+}
+
+int64_t IndexPermutation::Permute(int64_t index) const {
+  DCHECK_GE(index, 0);
+  DCHECK_LT(index, n_);
+  uint64 x = index;
+  do {
+    uint64 left = x >> half_bits_;
+    uint64 right = x & half_mask_;
+    for (int round = 0; round < kNumRounds; ++round) {
+      const uint64 next = left ^ Round(round, right);
+      left = right;
+      right = next;
+    }
+    x = (left << half_bits_) | right;
+  } while (x >= static_cast<uint64>(n_));
+  return x;
+}
+
+class GlobalShuffleDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t seed,
+          int64_t seed2, bool reshuffle_each_iteration)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        seeds_(seed, seed2),
+        effective_seeds_(MaybeOverrideSeeds(seeds_)),
+        reshuffle_each_iteration_(reshuffle_each_iteration),
+        cardinality_(input->Cardinality()),
+        permutation_(cardinality_, effective_seeds_.first,
+                     effective_seeds_.second) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    const int64_t epoch = reshuffle_each_iteration_ ? epochs_++ : 0;
+    return absl::make_unique<Iterator>(
+        Iterator::Params{this,
+                         name_utils::IteratorPrefix(kDatasetType, prefix)},
+        epoch);
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(seeds_.first, seeds_.second);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64_t Cardinality() const override { return cardinality_; }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+  // Random access uses the permutation of the first epoch.
+  Status Get(OpKernelContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    return input_->Get(ctx, permutation_.Permute(index), out_tensors);
+  }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    return input_->Get(ctx, permutation_.Permute(index), out_tensors);
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* seed = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.first, &seed));
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.second, &seed2));
+    AttrValue reshuffle_each_iteration;
+    b->BuildAttrValue(reshuffle_each_iteration_, &reshuffle_each_iteration);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, seed, seed2},
+        {{kReshuffleEachIteration, reshuffle_each_iteration}}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    Iterator(const Params& params, int64_t epoch)
+        : DatasetIterator<Dataset>(params),
+          epoch_(epoch),
+          permutation_(MakePermutation(epoch)) {}
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (next_index_ >= dataset()->cardinality_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(dataset()->input_->Get(
+          ctx, permutation_.Permute(next_index_), out_tensors));
+      ++next_index_;
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args),
+                                       /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kEpoch), epoch_));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kNextIndex), next_index_));
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kEpoch), &epoch_));
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kNextIndex), &next_index_));
+      permutation_ = MakePermutation(epoch_);
+      return Status::OK();
+    }
+
+   private:
+    // Each epoch uses its own stream of Philox samples.
+    IndexPermutation MakePermutation(int64_t epoch) const {
+      return IndexPermutation(
+          dataset()->cardinality_, dataset()->effective_seeds_.first,
+          static_cast<uint64>(dataset()->effective_seeds_.second) + epoch);
+    }
+
+    mutex mu_;
+    int64_t epoch_ TF_GUARDED_BY(mu_);
+    IndexPermutation permutation_ TF_GUARDED_BY(mu_);
+    int64_t next_index_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  const DatasetBase* const input_;
+  const std::pair<int64_t, int64_t> seeds_;
+  const std::pair<int64_t, int64_t> effective_seeds_;
+  const bool reshuffle_each_iteration_;
+  const int64_t cardinality_;
+  // The permutation used for random access.
+  const IndexPermutation permutation_;
+  // The number of iterators created so far.
+  mutable std::atomic<int64_t> epochs_{0};
+};
+
+GlobalShuffleDatasetOp::GlobalShuffleDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReshuffleEachIteration,
+                                   &reshuffle_each_iteration_));
+}
+
+void GlobalShuffleDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                         DatasetBase* input,
+                                         DatasetBase** output) {
+  const int64_t cardinality = input->Cardinality();
+  OP_REQUIRES(ctx, cardinality >= 0,
+              errors::InvalidArgument(
+                  "A global shuffle requires an input dataset of known, finite "
+                  "cardinality, got ",
+                  cardinality == kInfiniteCardinality ? "infinite"
+                                                      : "unknown",
+                  " cardinality for ", input->DebugString(), "."));
+  int64_t seed;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed, &seed));
+  int64_t seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed2, &seed2));
+  *output = new Dataset(ctx, input, seed, seed2, reshuffle_each_iteration_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("GlobalShuffleDataset").Device(DEVICE_CPU),
+                        GlobalShuffleDatasetOp);
+}  // namespace
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,193 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/global_shuffle_dataset_op.h"
+
+#include <set>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "global_shuffle_dataset";
+constexpr int64_t kSeed = 42;
+constexpr int64_t kSeed2 = 7;
+
+class GlobalShuffleDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  GlobalShuffleDatasetParams(T input_dataset_params, int64_t seed,
+                             int64_t seed2, bool reshuffle_each_iteration,
+                             DataTypeVector output_dtypes,
+                             std::vector<PartialTensorShape> output_shapes,
+                             string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        seed_(seed),
+        seed2_(seed2),
+        reshuffle_each_iteration_(reshuffle_each_iteration) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<int64_t>(TensorShape({}), {seed_}),
+            CreateTensor<int64_t>(TensorShape({}), {seed2_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {GlobalShuffleDatasetOp::kInputDataset,
+                    GlobalShuffleDatasetOp::kSeed,
+                    GlobalShuffleDatasetOp::kSeed2};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {GlobalShuffleDatasetOp::kReshuffleEachIteration,
+         reshuffle_each_iteration_},
+        {GlobalShuffleDatasetOp::kOutputTypes, output_dtypes_},
+        {GlobalShuffleDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return GlobalShuffleDatasetOp::kDatasetType;
+  }
+
+ private:
+  int64_t seed_;
+  int64_t seed2_;
+  bool reshuffle_each_iteration_;
+};
+
+class GlobalShuffleDatasetOpTest : public DatasetOpsTestBase {};
+
+GlobalShuffleDatasetParams RangeShuffleParams(bool reshuffle_each_iteration) {
+  return GlobalShuffleDatasetParams(
+      RangeDatasetParams(0, 20, 1), kSeed, kSeed2, reshuffle_each_iteration,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+// The outputs of the first iteration of `RangeShuffleParams()`.
+std::vector<Tensor> FirstEpochOutputs() {
+  IndexPermutation permutation(20, kSeed, kSeed2);
+  std::vector<Tensor> outputs;
+  for (int64_t i = 0; i < 20; ++i) {
+    outputs.push_back(
+        CreateTensor<int64_t>(TensorShape({}), {permutation.Permute(i)}));
+  }
+  return outputs;
+}
+
+TEST(IndexPermutationTest, IsABijection) {
+  for (int64_t n : {1, 2, 3, 5, 16, 17, 1000, 4097}) {
+    IndexPermutation permutation(n, kSeed, kSeed2);
+    std::set<int64_t> images;
+    for (int64_t i = 0; i < n; ++i) {
+      const int64_t image = permutation.Permute(i);
+      EXPECT_GE(image, 0);
+      EXPECT_LT(image, n);
+      images.insert(image);
+    }
+    EXPECT_EQ(images.size(), n);
+  }
+}
+
+TEST(IndexPermutationTest, DependsOnSeeds) {
+  IndexPermutation permutation(1000, kSeed, kSeed2);
+  IndexPermutation other_permutation(1000, kSeed, kSeed2 + 1);
+  int num_fixed_points = 0;
+  int num_differences = 0;
+  for (int64_t i = 0; i < 1000; ++i) {
+    num_fixed_points += permutation.Permute(i) == i;
+    num_differences += permutation.Permute(i) != other_permutation.Permute(i);
+  }
+  EXPECT_LT(num_fixed_points, 10);
+  EXPECT_GT(num_differences, 990);
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, ShufflesAllElements) {
+  auto dataset_params = RangeShuffleParams(/*reshuffle_each_iteration=*/false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(20));
+  std::vector<Tensor> expected_outputs = FirstEpochOutputs();
+  TF_ASSERT_OK(CheckIteratorGetNext(expected_outputs, /*compare_order=*/true));
+  // Each element of the input is produced once.
+  TF_ASSERT_OK(ExpectEqual(
+      expected_outputs,
+      CreateTensors<int64_t>(TensorShape({}),
+                             {{0},  {1},  {2},  {3},  {4},  {5},  {6},
+                              {7},  {8},  {9},  {10}, {11}, {12}, {13},
+                              {14}, {15}, {16}, {17}, {18}, {19}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, RandomAccessMatchesFirstEpoch) {
+  auto dataset_params = RangeShuffleParams(/*reshuffle_each_iteration=*/true);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> expected_outputs = FirstEpochOutputs();
+  for (int i = 0; i < 20; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(dataset_->Get(iterator_ctx_.get(), i, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    TF_EXPECT_OK(ExpectEqual(outputs[0], expected_outputs[i]));
+  }
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, ReshufflesEachIteration) {
+  auto dataset_params = RangeShuffleParams(/*reshuffle_each_iteration=*/true);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::unique_ptr<IteratorBase> second_iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      "Iterator", &second_iterator));
+  std::vector<Tensor> first_outputs;
+  std::vector<Tensor> second_outputs;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(
+        second_iterator->GetNext(iterator_ctx_.get(), &second_outputs,
+                                 &end_of_sequence));
+  }
+  end_of_sequence = false;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &first_outputs,
+                                    &end_of_sequence));
+  }
+  EXPECT_FALSE(ExpectEqual(first_outputs, second_outputs,
+                           /*compare_order=*/true)
+                   .ok());
+  TF_EXPECT_OK(ExpectEqual(first_outputs, second_outputs,
+                           /*compare_order=*/false));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, SaveAndRestore) {
+  auto dataset_params = RangeShuffleParams(/*reshuffle_each_iteration=*/true);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), FirstEpochOutputs(),
+      /*breakpoints=*/{0, 7, 20}, /*compare_order=*/true));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,604 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/prefetch_to_device_dataset_op.h"
+
+#include <cstring>
+#include <deque>
+
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    PrefetchToDeviceDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    PrefetchToDeviceDatasetOp::kInputDataset;
+/* static */ constexpr const char* const PrefetchToDeviceDatasetOp::kBufferSize;
+/* static */ constexpr const char* const
+    PrefetchToDeviceDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    PrefetchToDeviceDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kBuffer[] = "buffer";
+constexpr char kStatus[] = "status";
+constexpr char kSizeSuffix[] = ".size";
+constexpr char kCodeSuffix[] = ".code";
+constexpr char kErrorMessageSuffix[] = ".error_message";
+
+}  // namespace
+
+class PrefetchToDeviceDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t buffer_size)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        buffer_size_(buffer_size) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t Cardinality() const override { return input_->Cardinality(); }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* buffer_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {input_graph_node, buffer_size}, output));
+    return Status::OK();
+  }
+
+ private:
+  // Elements move through a ring of `buffer_size` slots. A background thread
+  // reads an element from the input into a free slot, stages its tensors in
+  // pinned host memory and starts asynchronous copies into device memory on
+  // the host-to-device stream of the device context. The slot becomes ready
+  // when all of its copies complete and is freed when `GetNext()` consumes it,
+  // so that the copies of the next elements overlap with the computation that
+  // consumes the current one. The number of slots is tuned by the autotuner.
+  //
+  // The copies only happen if the iterator lives on a device with its own
+  // memory, i.e. if its iterator ops are placed on that device. Otherwise, the
+  // elements stay in host memory and the ring acts as a prefetch buffer.
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          mu_(std::make_shared<mutex>()),
+          cond_var_(std::make_shared<condition_variable>()),
+          buffer_size_(std::make_shared<model::SharedState>(
+              params.dataset->buffer_size_, mu_, cond_var_)) {}
+
+    ~Iterator() override {
+      CancelThreads();
+      // Joins the staging thread, after which no more copies are started.
+      staging_thread_.reset();
+      {
+        // The callbacks of the copies in flight refer to this iterator.
+        mutex_lock l(*mu_);
+        while (num_staging_elements_ > 0) {
+          cond_var_->wait(l);
+        }
+      }
+      if (deregister_fn_) deregister_fn_();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(*mu_);
+      if (buffer_size_->value == model::kAutotune) {
+        buffer_size_->value = 1;
+      }
+      InitializeDevice(ctx);
+      cancellation_manager_ = absl::make_unique<CancellationManager>();
+      TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+          ctx->cancellation_manager(), [this]() { CancelThreads(); },
+          &deregister_fn_));
+      IteratorContext::Params params(ctx);
+      params.cancellation_manager = cancellation_manager_.get();
+      return dataset()->input_->MakeIterator(IteratorContext(params), this,
+                                             prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(*mu_);
+      EnsureStagingThreadStarted(ctx);
+      // Wait until the copies of the next element have completed, or we are
+      // shutting down.
+      while (!cancelled_ && (buffer_.empty() ? !staging_thread_finished_
+                                             : !buffer_.front()->ready)) {
+        RecordStop(ctx);
+        cond_var_->wait(l);
+        RecordStart(ctx);
+      }
+      if (cancelled_) {
+        return errors::Cancelled("Iterator was cancelled");
+      }
+      if (buffer_.empty()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      std::shared_ptr<BufferElement> element = std::move(buffer_.front());
+      buffer_.pop_front();
+      RecordBufferDequeue(ctx, element->value);
+      // Wake the staging thread, which may be waiting for a free slot.
+      cond_var_->notify_all();
+      *end_of_sequence = false;
+      if (element->status.ok()) {
+        *out_tensors = std::move(element->value);
+      }
+      return element->status;
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeAsyncKnownRatioNode(
+          std::move(args),
+          /*ratio=*/1,
+          {model::MakeParameter(kBufferSize, buffer_size_, /*min=*/1,
+                                /*max=*/std::numeric_limits<int64_t>::max())});
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      // Acquire both locks to ensure that the staging thread and all GetNext
+      // threads are blocked.
+      mutex_lock input_l(input_mu_);
+      mutex_lock l(*mu_);
+      // Wait for the copies in flight, so that the buffer holds the final
+      // values of its elements.
+      while (num_staging_elements_ > 0) {
+        cond_var_->wait(l);
+      }
+      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(prefix(), kBufferSize, buffer_.size()));
+      for (size_t i = 0; i < buffer_.size(); i++) {
+        const BufferElement& element = *buffer_[i];
+        TF_RETURN_IF_ERROR(WriteStatus(writer, i, element.status));
+        if (!element.status.ok()) {
+          continue;
+        }
+        const string key = absl::StrCat(prefix(), "::", i);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            key, absl::StrCat(kBuffer, kSizeSuffix), element.value.size()));
+        for (size_t j = 0; j < element.value.size(); j++) {
+          Tensor host_tensor;
+          TF_RETURN_IF_ERROR(CopyToHost(element.value[j], &host_tensor));
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              key, absl::StrCat(kBuffer, "[", j, "]"), host_tensor));
+        }
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock input_l(input_mu_);
+      std::vector<std::shared_ptr<BufferElement>> elements_to_stage;
+      {
+        mutex_lock l(*mu_);
+        DCHECK(buffer_.empty());
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+        int64_t buffer_size;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(prefix(), kBufferSize, &buffer_size));
+        for (int64_t i = 0; i < buffer_size; i++) {
+          auto element = std::make_shared<BufferElement>();
+          TF_RETURN_IF_ERROR(ReadStatus(reader, i, &element->status));
+          if (element->status.ok()) {
+            const string key = absl::StrCat(prefix(), "::", i);
+            int64_t value_size;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                key, absl::StrCat(kBuffer, kSizeSuffix), &value_size));
+            element->value.resize(value_size);
+            for (int64_t j = 0; j < value_size; j++) {
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  ctx->flr(), key, absl::StrCat(kBuffer, "[", j, "]"),
+                  &element->value[j]));
+            }
+          }
+          if (Enqueue(ctx, element)) {
+            elements_to_stage.push_back(std::move(element));
+          }
+        }
+      }
+      // The restored elements are in host memory, so they are copied to the
+      // device again.
+      for (const auto& element : elements_to_stage) {
+        StageElement(element);
+      }
+      return Status::OK();
+    }
+
+    data::TraceMeMetadata GetTraceMeMetadata() const override {
+      int64_t limit = -1, size = -1;
+      // NOTE: We only set the values if the lock can be acquired right away to
+      // avoid introducing tracing overhead.
+      if (mu_->try_lock()) {
+        limit = buffer_size_->value;
+        size = buffer_.size();
+        mu_->unlock();
+      }
+      data::TraceMeMetadata result;
+      result.push_back(std::make_pair(
+          "buffer_limit",
+          limit == -1
+              ? kTraceInfoUnavailable
+              : strings::Printf("%lld", static_cast<long long>(limit))));
+      result.push_back(std::make_pair(
+          "buffer_size",
+          size == -1 ? kTraceInfoUnavailable
+                     : strings::Printf("%lld", static_cast<long long>(size))));
+      result.push_back(std::make_pair(
+          "autotune",
+          dataset()->buffer_size_ == model::kAutotune ? "true" : "false"));
+      result.push_back(
+          std::make_pair("device", device_ ? device_->name() : "host"));
+      return result;
+    }
+
+   private:
+    // A slot of the ring. The staging thread sets `status` if getting the input
+    // element or copying it fails.
+    struct BufferElement {
+      Status status;
+      // The buffered element. Its tensors are in device memory once `ready`.
+      std::vector<Tensor> value;
+      // The staging buffers in pinned host memory and the destination tensors
+      // of the copies in flight.
+      std::vector<Tensor> staged_value;
+      std::vector<Tensor> device_value;
+      int64_t num_pending_copies = 0;
+      bool ready = false;
+    };
+
+    // Resolves the device that the elements are copied to. Elements are only
+    // copied if the device has a device context, as accelerators do.
+    void InitializeDevice(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      Device* device = ctx->flr() ? ctx->flr()->device() : nullptr;
+      if (device == nullptr) {
+        return;
+      }
+      const DeviceBase::GpuDeviceInfo* device_info =
+          device->tensorflow_gpu_device_info();
+      if (device_info == nullptr || device_info->default_context == nullptr) {
+        return;
+      }
+      device_ = device;
+      device_context_ = device_info->default_context;
+      AllocatorAttributes staging_attr;
+      staging_attr.set_on_host(true);
+      staging_attr.set_gpu_compatible(true);
+      staging_allocator_ = device->GetAllocator(staging_attr);
+      device_allocator_ = device->GetAllocator(AllocatorAttributes());
+    }
+
+    void CancelThreads() TF_LOCKS_EXCLUDED(mu_) {
+      cancellation_manager_->StartCancel();
+      mutex_lock l(*mu_);
+      cancelled_ = true;
+      cond_var_->notify_all();
+    }
+
+    void EnsureStagingThreadStarted(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (!staging_thread_) {
+        std::shared_ptr<IteratorContext> new_ctx =
+            std::make_shared<IteratorContext>(*ctx);
+        staging_thread_ =
+            ctx->StartThread("tf_data_prefetch_to_device",
+                             [this, new_ctx]() { StagingThread(new_ctx); });
+      }
+    }
+
+    // Reads elements of the input into free slots of the ring and starts their
+    // copies to the device.
+    //
+    // It owns the iterator context passed to it.
+    void StagingThread(const std::shared_ptr<IteratorContext>& ctx) {
+      RecordStart(ctx.get());
+      auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+      while (true) {
+        // 1. Wait for a free slot.
+        {
+          mutex_lock l(*mu_);
+          while (!cancelled_ &&
+                 static_cast<int64_t>(buffer_.size()) >= buffer_size_->value) {
+            RecordStop(ctx.get());
+            cond_var_->wait(l);
+            RecordStart(ctx.get());
+          }
+          if (cancelled_) {
+            staging_thread_finished_ = true;
+            cond_var_->notify_all();
+            return;
+          }
+        }
+
+        // 2. Read the next element. The input mutex is held until the copies
+        // of the element have started, so that `SaveInternal()` does not miss
+        // the element.
+        mutex_lock input_l(input_mu_);
+        auto element = std::make_shared<BufferElement>();
+        bool end_of_sequence;
+        {
+          profiler::TraceMe traceme("PrefetchToDeviceProduce",
+                                    profiler::kInfo);
+          element->status = input_impl_->GetNext(ctx.get(), &element->value,
+                                                 &end_of_sequence);
+        }
+        if (element->status.ok() && end_of_sequence) {
+          mutex_lock l(*mu_);
+          staging_thread_finished_ = true;
+          cond_var_->notify_all();
+          return;
+        }
+
+        // 3. Add the element to the ring and start its copies.
+        bool needs_staging;
+        {
+          mutex_lock l(*mu_);
+          needs_staging = Enqueue(ctx.get(), element);
+        }
+        if (needs_staging) {
+          StageElement(element);
+        }
+      }
+    }
+
+    // Adds `element` to the ring. Returns true if its tensors need to be copied
+    // to the device, in which case the element becomes ready once
+    // `StageElement()` completes the copies.
+    bool Enqueue(IteratorContext* ctx,
+                 const std::shared_ptr<BufferElement>& element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      RecordBufferEnqueue(ctx, element->value);
+      buffer_.push_back(element);
+      cond_var_->notify_all();
+      if (device_ == nullptr || !element->status.ok()) {
+        element->ready = true;
+        return false;
+      }
+      // One extra count keeps the element pending while its copies start.
+      element->num_pending_copies = element->value.size() + 1;
+      ++num_staging_elements_;
+      return true;
+    }
+
+    // Copies the tensors of `element` into staging buffers in pinned host
+    // memory, from which the device context copies them asynchronously into
+    // device memory. The staging buffers are returned to the pinned allocator
+    // when the copies complete, so at most `buffer_size` elements' worth of
+    // them are live at a time.
+    void StageElement(const std::shared_ptr<BufferElement>& element)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      const size_t num_components = element->value.size();
+      // The copies refer to these tensors, so the vectors must not be resized
+      // once the copies start.
+      element->staged_value.resize(num_components);
+      element->device_value.resize(num_components);
+      for (size_t i = 0; i < num_components; ++i) {
+        const Tensor& host_tensor = element->value[i];
+        if (!DataTypeCanUseMemcpy(host_tensor.dtype())) {
+          CopyDone(element,
+                   errors::InvalidArgument(
+                       "Cannot prefetch a tensor of type ",
+                       DataTypeString(host_tensor.dtype()), " to device ",
+                       device_->name(), "."));
+          continue;
+        }
+        Tensor& staged = element->staged_value[i];
+        staged = Tensor(staging_allocator_, host_tensor.dtype(),
+                        host_tensor.shape());
+        Tensor& device_tensor = element->device_value[i];
+        device_tensor = Tensor(device_allocator_, host_tensor.dtype(),
+                               host_tensor.shape());
+        if (!staged.IsInitialized() || !device_tensor.IsInitialized()) {
+          CopyDone(element, errors::ResourceExhausted(
+                                "OOM when prefetching a tensor of shape ",
+                                host_tensor.shape().DebugString(),
+                                " to device ", device_->name(), "."));
+          continue;
+        }
+        if (host_tensor.TotalBytes() > 0) {
+          std::memcpy(const_cast<char*>(staged.tensor_data().data()),
+                      host_tensor.tensor_data().data(),
+                      host_tensor.TotalBytes());
+        }
+        device_context_->CopyCPUTensorToDevice(
+            &staged, device_, &device_tensor,
+            [this, element](const Status& s) { CopyDone(element, s); });
+      }
+      CopyDone(element, Status::OK());
+    }
+
+    // Called when a copy of `element` completes, and once more when all of its
+    // copies have started.
+    void CopyDone(const std::shared_ptr<BufferElement>& element,
+                  const Status& status) TF_LOCKS_EXCLUDED(*mu_) {
+      mutex_lock l(*mu_);
+      element->status.Update(status);
+      if (--element->num_pending_copies > 0) {
+        return;
+      }
+      if (element->status.ok()) {
+        element->value = std::move(element->device_value);
+      }
+      element->staged_value.clear();
+      element->device_value.clear();
+      element->ready = true;
+      --num_staging_elements_;
+      cond_var_->notify_all();
+    }
+
+    // Copies a buffered tensor back to host memory for checkpointing.
+    Status CopyToHost(const Tensor& tensor, Tensor* host_tensor)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (device_ == nullptr) {
+        *host_tensor = tensor;
+        return Status::OK();
+      }
+      *host_tensor = Tensor(cpu_allocator(), tensor.dtype(), tensor.shape());
+      return device_context_->CopyDeviceTensorToCPUSync(
+          &tensor, /*tensor_name=*/"", device_, host_tensor);
+    }
+
+    Status WriteStatus(IteratorStateWriter* writer, size_t index,
+                       const Status& status) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(absl::StrCat(prefix(), "::", index), CodeKey(),
+                              static_cast<int64_t>(status.code())));
+      if (!status.ok()) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(absl::StrCat(prefix(), "::", index),
+                                ErrorMessageKey(), status.error_message()));
+      }
+      return Status::OK();
+    }
+
+    Status ReadStatus(IteratorStateReader* reader, size_t index, Status* status)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      int64_t code_int;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(absl::StrCat(prefix(), "::", index),
+                                            CodeKey(), &code_int));
+      error::Code code = static_cast<error::Code>(code_int);
+      if (code != error::Code::OK) {
+        tstring error_message;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(absl::StrCat(prefix(), "::", index),
+                               ErrorMessageKey(), &error_message));
+        *status = Status(code, error_message);
+      } else {
+        *status = Status::OK();
+      }
+      return Status::OK();
+    }
+
+    string CodeKey() { return absl::StrCat(kStatus, kCodeSuffix); }
+
+    string ErrorMessageKey() {
+      return absl::StrCat(kStatus, kErrorMessageSuffix);
+    }
+
+    // This mutex is used to ensure exclusivity between multiple threads
+    // reading/writing this iterator's local state.
+    //
+    // NOTE: We should never call GetNext on the input while holding this mutex.
+    const std::shared_ptr<mutex> mu_;
+    // This mutex is used to ensure exclusivity between multiple threads
+    // accessing the input iterator. We keep this separate from `mu_` to allow
+    // prefetching to run in parallel with GetNext calls.
+    mutex input_mu_ TF_ACQUIRED_BEFORE(*mu_);
+    // Controls cancellation of `input_impl_`. Must be ordered before
+    // `input_impl_` so that `input_impl_` is destroyed first.
+    std::unique_ptr<CancellationManager> cancellation_manager_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(input_mu_);
+    const std::shared_ptr<condition_variable> cond_var_;
+    // The number of slots in the ring.
+    const std::shared_ptr<model::SharedState> buffer_size_;
+    std::deque<std::shared_ptr<BufferElement>> buffer_ TF_GUARDED_BY(*mu_);
+    // The number of elements in `buffer_` whose copies have not completed.
+    int64_t num_staging_elements_ TF_GUARDED_BY(*mu_) = 0;
+    std::unique_ptr<Thread> staging_thread_ TF_GUARDED_BY(*mu_);
+    bool cancelled_ TF_GUARDED_BY(*mu_) = false;
+    bool staging_thread_finished_ TF_GUARDED_BY(*mu_) = false;
+
+    // The target of the copies, set by `Initialize()`. If `device_` is null,
+    // the elements are not copied.
+    Device* device_ = nullptr;
+    DeviceContext* device_context_ = nullptr;
+    Allocator* staging_allocator_ = nullptr;
+    Allocator* device_allocator_ = nullptr;
+
+    // Method for deregistering the cancellation callback.
+    std::function<void()> deregister_fn_;
+  };
+
+  const DatasetBase* const input_;
+  const int64_t buffer_size_;
+};
+
+void PrefetchToDeviceDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                            DatasetBase* input,
+                                            DatasetBase** output) {
+  int64_t buffer_size = 0;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64_t>(ctx, kBufferSize, &buffer_size));
+  OP_REQUIRES(ctx, buffer_size > 0 || buffer_size == model::kAutotune,
+              errors::InvalidArgument("buffer_size must be positive or ",
+                                      model::kAutotune, ", but got ",
+                                      buffer_size, "."));
+  *output = new Dataset(ctx, input, buffer_size);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("PrefetchToDeviceDataset").Device(DEVICE_CPU),
+                        PrefetchToDeviceDatasetOp);
+}  // namespace
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
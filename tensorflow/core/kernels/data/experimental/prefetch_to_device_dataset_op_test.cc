@@ -0,0 +1,112 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/prefetch_to_device_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "prefetch_to_device_dataset";
+
+class PrefetchToDeviceDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  PrefetchToDeviceDatasetParams(T input_dataset_params, int64_t buffer_size,
+                                DataTypeVector output_dtypes,
+                                std::vector<PartialTensorShape> output_shapes,
+                                string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        buffer_size_(buffer_size) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<int64_t>(TensorShape({}), {buffer_size_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {PrefetchToDeviceDatasetOp::kInputDataset,
+                    PrefetchToDeviceDatasetOp::kBufferSize};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{PrefetchToDeviceDatasetOp::kOutputTypes, output_dtypes_},
+                    {PrefetchToDeviceDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return PrefetchToDeviceDatasetOp::kDatasetType;
+  }
+
+ private:
+  int64_t buffer_size_;
+};
+
+class PrefetchToDeviceDatasetOpTest : public DatasetOpsTestBase {};
+
+PrefetchToDeviceDatasetParams RangePrefetchToDeviceParams(int64_t buffer_size) {
+  return PrefetchToDeviceDatasetParams(
+      RangeDatasetParams(0, 10, 1), buffer_size,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> RangeOutputs() {
+  return CreateTensors<int64_t>(
+      TensorShape({}), {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}});
+}
+
+// The test runtime has no accelerator, so these tests cover the ring of
+// buffered host elements.
+TEST_F(PrefetchToDeviceDatasetOpTest, ProducesInputInOrder) {
+  auto dataset_params = RangePrefetchToDeviceParams(/*buffer_size=*/3);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(10));
+  TF_ASSERT_OK(CheckIteratorGetNext(RangeOutputs(), /*compare_order=*/true));
+}
+
+TEST_F(PrefetchToDeviceDatasetOpTest, Autotune) {
+  auto dataset_params = RangePrefetchToDeviceParams(model::kAutotune);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(RangeOutputs(), /*compare_order=*/true));
+}
+
+TEST_F(PrefetchToDeviceDatasetOpTest, SaveAndRestore) {
+  auto dataset_params = RangePrefetchToDeviceParams(/*buffer_size=*/3);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), RangeOutputs(),
+      /*breakpoints=*/{0, 4, 11}, /*compare_order=*/true));
+}
+
+TEST_F(PrefetchToDeviceDatasetOpTest, InvalidBufferSize) {
+  auto dataset_params = RangePrefetchToDeviceParams(/*buffer_size=*/0);
+  EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
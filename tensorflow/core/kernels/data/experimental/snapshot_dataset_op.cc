@@ -57,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -83,6 +84,8 @@ namespace experimental {
 /* static */ constexpr const char* const
     SnapshotDatasetV2Op::kShardFuncTarguments;
 /* static */ constexpr const int SnapshotDatasetV2Op::kFileFormatVersion;
+/* static */ constexpr const int
+    SnapshotDatasetV2Op::kRandomAccessFileFormatVersion;
 
 // ==== Snapshot Implementation ====
 
@@ -126,6 +129,7 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
         hash_(hash),
         path_(path),
         compression_(compression),
+        file_format_version_(FileFormatVersion(compression)),
         reader_prefix_(reader_prefix),
         writer_prefix_(writer_prefix),
         reader_func_(std::move(reader_func)),
@@ -240,10 +244,28 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
   }
 
  private:
+  // Returns the file format version to write snapshots with the given
+  // compression in.
+  static int64_t FileFormatVersion(const std::string& compression) {
+    if (compression != io::compression::kNone) {
+      return kFileFormatVersion;
+    }
+    bool random_access = false;
+    Status s = ReadBoolFromEnvVar("TF_DATA_SNAPSHOT_RANDOM_ACCESS",
+                                  /*default_val=*/false, &random_access);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+    }
+    return random_access ? kRandomAccessFileFormatVersion : kFileFormatVersion;
+  }
+
   const DatasetBase* input_;
   const uint64 hash_;
   const tstring path_;
   const std::string compression_;
+  // The version of the snapshot files written; readers use the version
+  // recorded in the snapshot metadata.
+  const int64_t file_format_version_;
   const std::string reader_prefix_;
   const std::string writer_prefix_;
 
@@ -431,7 +453,8 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
           auto writer = std::make_unique<snapshot_util::AsyncWriter>(
               ctx->env(), shard_index, snapshot_shard_directory,
               current_checkpoint_id_, dataset()->compression_,
-              kFileFormatVersion, dataset()->output_dtypes(), [this](Status s) {
+              dataset()->file_format_version_, dataset()->output_dtypes(),
+              [this](Status s) {
                 if (!s.ok()) {
                   LOG(ERROR) << "AsyncWriter in snapshot writer failed: " << s;
                   mutex_lock l(writer_status_mu_);
@@ -514,7 +537,7 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
       metadata.set_creation_timestamp(EnvTime::NowMicros());
       metadata.set_graph_hash(strings::StrCat(dataset()->hash_));
       metadata.set_run_id(strings::StrCat(run_id_));
-      metadata.set_version(kFileFormatVersion);
+      metadata.set_version(dataset()->file_format_version_);
       for (const auto& output_dtype : dataset()->output_dtypes()) {
         metadata.add_dtype(output_dtype);
       }
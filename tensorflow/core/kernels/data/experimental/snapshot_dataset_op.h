@@ -71,6 +71,10 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
 
  private:
   static constexpr const int kFileFormatVersion = 2;
+  // The file format version written instead of `kFileFormatVersion` when
+  // TF_DATA_SNAPSHOT_RANDOM_ACCESS is set and the snapshot is not compressed.
+  // Its files can be memory-mapped and read from any element.
+  static constexpr const int kRandomAccessFileFormatVersion = 3;
 
   class Dataset;
 
@@ -19,8 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
-#include "tensorflow/core/lib/io/inputbuffer.h"
-#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/prefetching_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 
@@ -46,6 +45,8 @@ constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kCurrentPos[] = "current_pos";
 constexpr char kZLIB[] = "ZLIB";
 constexpr char kGZIP[] = "GZIP";
+// The number of buffers read ahead of each file's records in the background.
+constexpr int kPrefetchBuffers = 2;
 
 class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
  public:
@@ -139,7 +140,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
           const int64_t current_pos = input_buffer_->Tell();
           DCHECK_GE(file_pos_limit_, 0);
           if (current_pos < file_pos_limit_) {
-            string record;
+            tstring record;
             TF_RETURN_IF_ERROR(
                 input_buffer_->ReadNBytes(dataset()->record_bytes_, &record));
             static monitoring::CounterCell* bytes_counter =
@@ -148,7 +149,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
 
             // Produce the record as output.
             Tensor record_tensor(ctx->allocator({}), DT_STRING, {});
-            record_tensor.scalar<tstring>()() = record;
+            record_tensor.scalar<tstring>()() = std::move(record);
             out_tensors->emplace_back(std::move(record_tensor));
             *end_of_sequence = false;
             return Status::OK();
@@ -188,8 +189,8 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
         }
         TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
             dataset()->filenames_[current_file_index_], &file_));
-        input_buffer_ = absl::make_unique<io::InputBuffer>(
-            file_.get(), dataset()->buffer_size_);
+        input_buffer_ = absl::make_unique<io::PrefetchingInputStream>(
+            file_.get(), dataset()->buffer_size_, kPrefetchBuffers);
         TF_RETURN_IF_ERROR(input_buffer_->SkipNBytes(dataset()->header_bytes_));
       } while (true);
     }
@@ -231,8 +232,8 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
         file_pos_limit_ = file_size - dataset()->footer_bytes_;
         TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
             dataset()->filenames_[current_file_index_], &file_));
-        input_buffer_ = absl::make_unique<io::InputBuffer>(
-            file_.get(), dataset()->buffer_size_);
+        input_buffer_ = absl::make_unique<io::PrefetchingInputStream>(
+            file_.get(), dataset()->buffer_size_, kPrefetchBuffers);
         TF_RETURN_IF_ERROR(input_buffer_->Seek(current_pos));
       }
 
@@ -244,7 +245,8 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
     size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
     std::unique_ptr<RandomAccessFile> file_
         TF_GUARDED_BY(mu_);  // must outlive input_buffer_
-    std::unique_ptr<io::InputBuffer> input_buffer_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::PrefetchingInputStream> input_buffer_
+        TF_GUARDED_BY(mu_);
     int64_t file_pos_limit_ TF_GUARDED_BY(mu_) = -1;
   };
 
@@ -316,6 +318,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
           // We have reached the end of the current file, so maybe move on to
           // next file.
           buffered_input_stream_.reset();
+          file_stream_.reset();
           file_.reset();
           ++current_file_index_;
         }
@@ -355,8 +358,8 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
               dataset()->compression_type_ == kZLIB
                   ? io::ZlibCompressionOptions::DEFAULT()
                   : io::ZlibCompressionOptions::GZIP();
-          file_stream_ =
-              absl::make_unique<io::RandomAccessInputStream>(file_.get());
+          file_stream_ = absl::make_unique<io::PrefetchingInputStream>(
+              file_.get(), dataset()->buffer_size_, kPrefetchBuffers);
           buffered_input_stream_ = absl::make_unique<io::ZlibInputStream>(
               file_stream_.get(), dataset()->buffer_size_,
               dataset()->buffer_size_, zlib_options);
@@ -409,6 +412,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
 
       // Seek to current_pos.
       buffered_input_stream_.reset();
+      file_stream_.reset();
       file_.reset();
       if (current_pos >= 0) {  // There was an active buffered_input_stream_.
         TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
@@ -417,8 +421,8 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
             dataset()->compression_type_ == kZLIB
                 ? io::ZlibCompressionOptions::DEFAULT()
                 : io::ZlibCompressionOptions::GZIP();
-        file_stream_ =
-            absl::make_unique<io::RandomAccessInputStream>(file_.get());
+        file_stream_ = absl::make_unique<io::PrefetchingInputStream>(
+            file_.get(), dataset()->buffer_size_, kPrefetchBuffers);
         buffered_input_stream_ = absl::make_unique<io::ZlibInputStream>(
             file_stream_.get(), dataset()->buffer_size_,
             dataset()->buffer_size_, zlib_options);
@@ -437,7 +441,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
     size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
     std::unique_ptr<RandomAccessFile> file_
         TF_GUARDED_BY(mu_);  // must outlive buffered_input_stream_
-    std::unique_ptr<io::RandomAccessInputStream>
+    std::unique_ptr<io::PrefetchingInputStream>
         file_stream_;  // must outlive buffered_input_stream_
     std::unique_ptr<io::InputStreamInterface> buffered_input_stream_
         TF_GUARDED_BY(mu_);
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
+#include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 #include "tensorflow/core/data/captured_function.h"
@@ -54,6 +55,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/resource.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -76,6 +78,12 @@ const char kOutputTypes[] = "output_types";
 // Safely subtracts x from y avoiding underflow.
 inline uint64 safe_sub(uint64 x, uint64 y) { return x >= y ? x - y : 0; }
 
+ThreadOptions NumaThreadOptions(int numa_node) {
+  ThreadOptions thread_options;
+  thread_options.numa_node = numa_node;
+  return thread_options;
+}
+
 }  // namespace
 
 /* static */ constexpr const char* const
@@ -88,7 +96,9 @@ IteratorResource::IteratorResource(
     std::unique_ptr<FunctionLibraryDefinition> flib_def,
     std::unique_ptr<ProcessFunctionLibraryRuntime> pflr,
     FunctionLibraryRuntime* flr)
-    : unbounded_thread_pool_(env, "tf_data_iterator_resource"),
+    : numa_node_(GetNumaNode(flr->device()->attributes())),
+      unbounded_thread_pool_(env, "tf_data_iterator_resource",
+                             NumaThreadOptions(numa_node_)),
       device_mgr_(std::move(device_mgr)),
       iterator_state_(std::make_shared<State>(std::move(flib_def),
                                               std::move(pflr), flr,
@@ -106,6 +116,26 @@ IteratorResource::~IteratorResource() {
   VLOG(2) << "destroying iterator resource";
 }
 
+void IteratorResource::SetNumaParams(IteratorContext::Params* params) const {
+  if (numa_node_ == port::kNUMANoAffinity) return;
+  params->numa_node = numa_node_;
+  // Host buffers come from the NUMA node, except for memory registered with
+  // devices or NICs.
+  const bool on_cpu = params->flr->device()->device_type() == DEVICE_CPU;
+  Allocator* numa_allocator =
+      ProcessState::singleton()->GetNUMAAllocator(numa_node_);
+  params->allocator_getter =
+      [on_cpu, numa_allocator,
+       device_getter = std::move(params->allocator_getter)](
+          AllocatorAttributes attrs) {
+        if ((on_cpu || attrs.on_host()) && !attrs.gpu_compatible() &&
+            !attrs.nic_compatible()) {
+          return numa_allocator;
+        }
+        return device_getter(attrs);
+      };
+}
+
 Status IteratorResource::GetNext(OpKernelContext* ctx,
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) {
@@ -126,6 +156,7 @@ Status IteratorResource::GetNext(OpKernelContext* ctx,
   params.resource_mgr = captured_state->resource_mgr();
   params.thread_factory = unbounded_thread_pool_.get_thread_factory();
   params.thread_pool = &unbounded_thread_pool_;
+  SetNumaParams(&params);
   params.cancellation_manager = captured_state->cancellation_manager();
   std::function<void()> deregister_fn;
   TF_RETURN_IF_ERROR(RegisterCancellationCallback(
@@ -214,6 +245,7 @@ Status IteratorResource::Restore(OpKernelContext* ctx,
   params.resource_mgr = new_state->resource_mgr();
   params.thread_factory = unbounded_thread_pool_.get_thread_factory();
   params.thread_pool = &unbounded_thread_pool_;
+  SetNumaParams(&params);
   params.cancellation_manager = new_state->cancellation_manager();
   std::function<void()> deregister_fn;
   TF_RETURN_IF_ERROR(RegisterCancellationCallback(
@@ -249,6 +281,7 @@ Status IteratorResource::SetIteratorFromDataset(OpKernelContext* ctx,
   params.resource_mgr = new_state->resource_mgr();
   params.thread_factory = unbounded_thread_pool_.get_thread_factory();
   params.thread_pool = &unbounded_thread_pool_;
+  SetNumaParams(&params);
   params.cancellation_manager = new_state->cancellation_manager();
   std::function<void()> deregister_fn;
   TF_RETURN_IF_ERROR(RegisterCancellationCallback(
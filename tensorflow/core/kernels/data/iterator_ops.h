@@ -121,6 +121,12 @@ class IteratorResource : public ResourceBase {
     std::unique_ptr<DatasetBaseIterator> iterator_;
   };
 
+  // Places the threads and buffers of the iterator on the NUMA node of its
+  // device, if NUMA-aware input pipelines are enabled.
+  void SetNumaParams(IteratorContext::Params* params) const;
+
+  // The NUMA node of the device, or `port::kNUMANoAffinity`.
+  const int numa_node_;
   UnboundedThreadPool unbounded_thread_pool_;
   mutex mu_;
   // Records the number of currently active `GetNext()` calls.
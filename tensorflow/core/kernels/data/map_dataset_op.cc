@@ -93,15 +93,12 @@ class MapDatasetOp::Dataset : public DatasetBase {
 
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
-    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
-    std::vector<Tensor> args;
-    TF_RETURN_IF_ERROR(input_->Get(ctx, index, &args));
-    if (!instantiated_captured_func_) {
-      TF_RETURN_IF_ERROR(
-          captured_func_->Instantiate(InstantiateCapturedFunctionParams(ctx),
-                                      &instantiated_captured_func_));
-    }
-    return instantiated_captured_func_->RunInstantiated(args, out_tensors);
+    return GetImpl(ctx, index, out_tensors);
+  }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    return GetImpl(ctx, index, out_tensors);
   }
 
  protected:
@@ -146,6 +143,21 @@ class MapDatasetOp::Dataset : public DatasetBase {
   }
 
  private:
+  // `Context` is either `OpKernelContext` or `IteratorContext`.
+  template <typename Context>
+  Status GetImpl(Context* ctx, int64 index,
+                 std::vector<Tensor>* out_tensors) const {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    std::vector<Tensor> args;
+    TF_RETURN_IF_ERROR(input_->Get(ctx, index, &args));
+    if (!instantiated_captured_func_) {
+      TF_RETURN_IF_ERROR(
+          captured_func_->Instantiate(InstantiateCapturedFunctionParams(ctx),
+                                      &instantiated_captured_func_));
+    }
+    return instantiated_captured_func_->RunInstantiated(args, out_tensors);
+  }
+
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
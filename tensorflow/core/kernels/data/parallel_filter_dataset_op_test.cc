@@ -0,0 +1,244 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/filter_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/kernels/data/parallel_filter_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "parallel_filter_dataset";
+
+class ParallelFilterDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  ParallelFilterDatasetParams(T input_dataset_params,
+                              std::vector<Tensor> other_arguments,
+                              int64_t num_parallel_calls,
+                              const std::string& deterministic,
+                              FunctionDefHelper::AttrValueWrapper pred_func,
+                              std::vector<FunctionDef> func_lib,
+                              DataTypeVector type_arguments,
+                              DataTypeVector output_dtypes,
+                              std::vector<PartialTensorShape> output_shapes,
+                              string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        other_arguments_(std::move(other_arguments)),
+        num_parallel_calls_(num_parallel_calls),
+        deterministic_(deterministic),
+        pred_func_(std::move(pred_func)),
+        func_lib_(std::move(func_lib)),
+        type_arguments_(std::move(type_arguments)) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    auto input_tensors = other_arguments_;
+    input_tensors.emplace_back(
+        CreateTensor<int64_t>(TensorShape({}), {num_parallel_calls_}));
+    return input_tensors;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    input_names->clear();
+    input_names->reserve(input_dataset_params_.size() +
+                         other_arguments_.size() + 1);
+    input_names->emplace_back(ParallelFilterDatasetOp::kInputDataset);
+    for (int i = 0; i < other_arguments_.size(); ++i) {
+      input_names->emplace_back(
+          absl::StrCat(ParallelFilterDatasetOp::kOtherArguments, "_", i));
+    }
+    input_names->emplace_back(ParallelFilterDatasetOp::kNumParallelCalls);
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"predicate", pred_func_},
+                    {"deterministic", deterministic_},
+                    {"Targuments", type_arguments_},
+                    {"output_shapes", output_shapes_},
+                    {"output_types", output_dtypes_},
+                    {"metadata", ""}};
+    return Status::OK();
+  }
+
+  std::vector<FunctionDef> func_lib() const override { return func_lib_; }
+
+  string dataset_type() const override {
+    return ParallelFilterDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<Tensor> other_arguments_;
+  int64_t num_parallel_calls_;
+  std::string deterministic_;
+  FunctionDefHelper::AttrValueWrapper pred_func_;
+  std::vector<FunctionDef> func_lib_;
+  DataTypeVector type_arguments_;
+};
+
+class ParallelFilterDatasetOpTest : public DatasetOpsTestBase {};
+
+ParallelFilterDatasetParams IsZeroParams(int64_t num_parallel_calls,
+                                         const std::string& deterministic) {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/
+      {CreateTensor<int64_t>(TensorShape{9, 1}, {0, 0, 0, 3, 4, 5, 6, 7, 8})},
+      /*node_name=*/"tensor_slice_dataset");
+  return ParallelFilterDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*other_arguments=*/{}, num_parallel_calls, deterministic,
+      /*pred_func=*/FunctionDefHelper::FunctionRef("IsZero", {{"T", DT_INT64}}),
+      /*func_lib=*/{test::function::IsZero()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*node_name=*/kNodeName);
+}
+
+// The predicate keeps the odd elements of a slice of nonzero values, so that
+// the order of the outputs is observable.
+ParallelFilterDatasetParams IsOddParams(int64_t num_parallel_calls,
+                                        const std::string& deterministic) {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/
+      {CreateTensor<int64_t>(TensorShape{8}, {1, 2, 3, 4, 5, 6, 7, 8})},
+      /*node_name=*/"tensor_slice_dataset");
+  FunctionDef is_odd = FunctionDefHelper::Create(
+      "IsOdd", {"x: int64"}, {"z: bool"}, {},
+      {{{"two"}, "Const", {}, {{"value", test::AsScalar<int64_t>(2)},
+                               {"dtype", DT_INT64}}},
+       {{"remainder"}, "FloorMod", {"x", "two:output:0"}, {{"T", DT_INT64}}},
+       {{"one"}, "Const", {}, {{"value", test::AsScalar<int64_t>(1)},
+                               {"dtype", DT_INT64}}},
+       {{"is_odd"},
+        "Equal",
+        {"remainder:z:0", "one:output:0"},
+        {{"T", DT_INT64}}}},
+      {{"z", "is_odd:z:0"}});
+  return ParallelFilterDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*other_arguments=*/{}, num_parallel_calls, deterministic,
+      /*pred_func=*/FunctionDefHelper::FunctionRef("IsOdd"),
+      /*func_lib=*/{is_odd},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> OddOutputs() {
+  return CreateTensors<int64_t>(TensorShape({}), {{1}, {3}, {5}, {7}});
+}
+
+TEST_F(ParallelFilterDatasetOpTest, Deterministic) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/3,
+                                    DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
+  TF_ASSERT_OK(CheckIteratorGetNext(OddOutputs(), /*compare_order=*/true));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, Nondeterministic) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/3,
+                                    DeterminismPolicy::kNondeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(OddOutputs(), /*compare_order=*/false));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, Autotune) {
+  auto dataset_params =
+      IsOddParams(model::kAutotune, DeterminismPolicy::kDefault);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(OddOutputs(), /*compare_order=*/true));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, NonScalarElements) {
+  auto dataset_params = IsZeroParams(/*num_parallel_calls=*/2,
+                                     DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64_t>(TensorShape({1}), {{0}, {0}, {0}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/2,
+                                    DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(ParallelFilterDatasetOp::kDatasetType)));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/2,
+                                    DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(
+      name_utils::IteratorPrefix(ParallelFilterDatasetOp::kDatasetType,
+                                 dataset_params.iterator_prefix())));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, SaveAndRestore) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/3,
+                                    DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), OddOutputs(),
+      /*breakpoints=*/{0, 2, 6}, /*compare_order=*/true));
+}
+
+TEST_F(ParallelFilterDatasetOpTest, InvalidPredicate) {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/
+      {CreateTensor<int64_t>(TensorShape{9}, {0, 0, 0, 3, 4, 5, 6, 7, 8})},
+      /*node_name=*/"tensor_slice_dataset");
+  // The predicate returns a scalar int64 tensor.
+  auto dataset_params = ParallelFilterDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*other_arguments=*/{}, /*num_parallel_calls=*/2,
+      DeterminismPolicy::kDeterministic,
+      /*pred_func=*/
+      FunctionDefHelper::FunctionRef("NonZero", {{"T", DT_INT64}}),
+      /*func_lib=*/{test::function::NonZero()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      tensorflow::error::INVALID_ARGUMENT);
+  EXPECT_TRUE(out_tensors.empty());
+}
+
+TEST_F(ParallelFilterDatasetOpTest, InvalidNumParallelCalls) {
+  auto dataset_params = IsOddParams(/*num_parallel_calls=*/0,
+                                    DeterminismPolicy::kDeterministic);
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
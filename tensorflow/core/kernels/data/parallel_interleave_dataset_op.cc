@@ -115,6 +115,12 @@ constexpr double kDefaultCyclePrefetchFactor = 2.0L;
 // match the behavior of the original implementation.
 constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 
+// When `buffer_output_elements` is autotuned and the output is deterministic,
+// the results buffer budget of the cycle is shifted toward the inputs that the
+// consumer blocks on. `kMaxPerIteratorBufferFactor * buffer_output_elements` is
+// the largest buffer a single input can get this way.
+constexpr int64_t kMaxPerIteratorBufferFactor = 4;
+
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
@@ -160,17 +166,21 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input,
           std::unique_ptr<CapturedFunction> captured_func, int64_t cycle_length,
-          int64_t block_length, int64_t buffer_output_elements,
-          int64_t prefetch_input_elements, int64_t num_parallel_calls,
-          DeterminismPolicy deterministic, const DataTypeVector& output_types,
+          bool autotune_cycle_length, int64_t block_length,
+          int64_t buffer_output_elements, int64_t prefetch_input_elements,
+          int64_t num_parallel_calls, DeterminismPolicy deterministic,
+          const DataTypeVector& output_types,
           const std::vector<PartialTensorShape>& output_shapes, int op_version)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         captured_func_(std::move(captured_func)),
         cycle_length_(cycle_length),
+        autotune_cycle_length_(autotune_cycle_length),
         block_length_(block_length),
         buffer_output_elements_(
             ComputeBufferOutputElements(buffer_output_elements, block_length)),
+        autotune_buffer_output_elements_(buffer_output_elements ==
+                                         model::kAutotune),
         prefetch_input_elements_(ComputePrefetchInputElements(
             prefetch_input_elements, cycle_length)),
         num_parallel_calls_(num_parallel_calls),
@@ -255,8 +265,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                                                   &other_arguments_types));
     list_inputs.emplace_back(input_index++, other_arguments);
 
+    // Autotuned values are serialized as `kAutotune`, so that graph rewrites
+    // preserve the adaptive behavior of the iterator.
     Node* cycle_length_node;
-    TF_RETURN_IF_ERROR(b->AddScalar(cycle_length_, &cycle_length_node));
+    TF_RETURN_IF_ERROR(b->AddScalar(
+        autotune_cycle_length_ ? model::kAutotune : cycle_length_,
+        &cycle_length_node));
     inputs.emplace_back(input_index++, cycle_length_node);
 
     Node* block_length_node;
@@ -265,8 +279,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
 
     if (op_version_ >= 4) {
       Node* buffer_output_elements_node;
-      TF_RETURN_IF_ERROR(
-          b->AddScalar(buffer_output_elements_, &buffer_output_elements_node));
+      TF_RETURN_IF_ERROR(b->AddScalar(autotune_buffer_output_elements_
+                                          ? model::kAutotune
+                                          : buffer_output_elements_,
+                                      &buffer_output_elements_node));
       inputs.emplace_back(input_index++, buffer_output_elements_node);
 
       Node* prefetch_input_elements_node;
@@ -315,6 +331,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
           deterministic_(deterministic),
+          adaptive_cycle_length_(
+              !deterministic && params.dataset->autotune_cycle_length_ &&
+              params.dataset->num_parallel_calls_ == model::kAutotune),
+          redistribute_buffers_(
+              deterministic &&
+              params.dataset->autotune_buffer_output_elements_),
           current_elements_(params.dataset->cycle_length_) {}
 
     ~ParallelInterleaveIterator() override { CancelThreads(/*wait=*/true); }
@@ -364,11 +386,13 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         EnsureInitialElementsCreated();
         EnsureThreadsStarted();
+        OpenInputs();
         while (!cancelled_ && !Consume(&result)) {
           RecordStop(ctx);
           if (deterministic_) {
             VLOG(3) << "Blocked waiting for element "
                     << current_elements_[cycle_index_]->id;
+            ShiftBufferToSlowInput(current_elements_[cycle_index_]);
             current_elements_[cycle_index_]->cond_var.wait(l);
           } else {
             any_element_available_cond_var_.wait(l);
@@ -571,6 +595,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // Buffer for storing the outputs of `iterator`.
       std::deque<std::shared_ptr<Result>> TF_GUARDED_BY(
           &ParallelInterleaveIterator::mu_) results;
+      // The number of results to buffer ahead of the consumer.
+      int64_t buffer_limit TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = 0;
       // The element's index in the cycle, if it is in the current cycle.
       // -1 if the element is not in the current cycle.
       int64_t cycle_index TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = -1;
@@ -591,9 +617,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           TF_EXCLUSIVE_LOCKS_REQUIRED(&ParallelInterleaveIterator::mu_) {
         return absl::StrFormat(
             "Element(id: %d, iterator_null: %d, results_size: %d, "
-            "cycle_index: %d, active: %d, initialized: %d, no_input: %d)",
-            id, iterator == nullptr, results.size(), cycle_index, active,
-            initialized, no_input);
+            "buffer_limit: %d, cycle_index: %d, active: %d, initialized: %d, "
+            "no_input: %d)",
+            id, iterator == nullptr, results.size(), buffer_limit, cycle_index,
+            active, initialized, no_input);
       }
     };
 
@@ -624,7 +651,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
 
     void EnsureInitialElementsCreated() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (!initial_elements_created_) {
-        for (int i = 0; i < dataset()->cycle_length_; ++i) {
+        const int64_t num_open_inputs = NumOpenInputs();
+        for (int i = 0; i < num_open_inputs; ++i) {
           current_elements_[i] = MakeElement();
           if (!current_elements_[i]) {
             break;
@@ -637,6 +665,103 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Returns the number of elements of the cycle to keep open. When the cycle
+    // length is autotuned, `cycle_length_` is only an upper bound and the
+    // number of open inputs follows the autotuned parallelism, so that each
+    // current worker has an input of its own. Inputs beyond it are closed as
+    // they are exhausted.
+    int64_t NumOpenInputs() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!adaptive_cycle_length_) {
+        return dataset()->cycle_length_;
+      }
+      return std::max<int64_t>(
+          1, std::min<int64_t>(dataset()->cycle_length_,
+                               std::ceil(num_parallel_calls_->value)));
+    }
+
+    // Fills the empty slots below `NumOpenInputs()`, which appear when
+    // autotuning increases the cycle length.
+    void OpenInputs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!adaptive_cycle_length_) {
+        return;
+      }
+      const int64_t num_open_inputs = NumOpenInputs();
+      for (int64_t i = 0; i < num_open_inputs; ++i) {
+        if (current_elements_[i]) {
+          continue;
+        }
+        if (!future_elements_.empty()) {
+          current_elements_[i] = std::move(future_elements_.front());
+          future_elements_.pop_front();
+          if (current_elements_[i]->iterator) {
+            EnableAutotune(ctx_.get(), current_elements_[i]->iterator.get());
+          }
+          future_workers_cond_var_.notify_one();
+        } else {
+          current_elements_[i] = MakeElement();
+          if (!current_elements_[i]) {
+            return;
+          }
+        }
+        current_elements_[i]->cycle_index = i;
+        elements_to_process_.push_back(i);
+        current_workers_cond_var_.notify_one();
+        last_valid_current_element_ =
+            std::max<int64_t>(last_valid_current_element_, i);
+      }
+    }
+
+    // Sets the results buffer limit of `element`, which is joining the cycle,
+    // from the budget left by the other current elements.
+    void AssignBufferLimit(const std::shared_ptr<Element>& element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!redistribute_buffers_) {
+        return;
+      }
+      int64_t budget =
+          dataset()->cycle_length_ * dataset()->buffer_output_elements_;
+      for (const auto& other : current_elements_) {
+        if (other && other != element) {
+          budget -= other->buffer_limit;
+        }
+      }
+      element->buffer_limit = std::max<int64_t>(
+          dataset()->block_length_,
+          std::min(dataset()->buffer_output_elements_, budget));
+    }
+
+    // Moves one result of buffer budget to `element`, on which the consumer
+    // is blocked, from the current element with the largest full buffer.
+    // Inputs that keep up with the consumer have full buffers, so this shifts
+    // the budget toward slow inputs without changing the total number of
+    // buffered results.
+    void ShiftBufferToSlowInput(const std::shared_ptr<Element>& element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!redistribute_buffers_ || !element->iterator ||
+          element->buffer_limit >= kMaxPerIteratorBufferFactor *
+                                       dataset()->buffer_output_elements_) {
+        return;
+      }
+      std::shared_ptr<Element> donor;
+      for (const auto& other : current_elements_) {
+        if (other && other != element &&
+            other->buffer_limit > dataset()->block_length_ &&
+            other->results.size() >= other->buffer_limit &&
+            (!donor || other->buffer_limit > donor->buffer_limit)) {
+          donor = other;
+        }
+      }
+      if (!donor) {
+        return;
+      }
+      --donor->buffer_limit;
+      ++element->buffer_limit;
+      if (!element->active) {
+        elements_to_process_.push_back(element->cycle_index);
+        current_workers_cond_var_.notify_one();
+      }
+    }
+
     void EnsureThreadsStarted() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (!threads_initialized_) {
         IncrementOutstandingThreads();
@@ -725,8 +850,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         // We've consumed all results from the element. Get a new element from
         // future_elements, or create a new element if no future elements are
-        // available.
-        if (!future_elements_.empty()) {
+        // available. If autotuning decreased the cycle length, the slot is
+        // closed instead.
+        if (cycle_index_ >= NumOpenInputs()) {
+          current_elements_[cycle_index_].reset();
+        } else if (!future_elements_.empty()) {
           std::shared_ptr<Element> future_element =
               std::move(future_elements_.front());
           future_elements_.pop_front();
@@ -734,6 +862,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
             EnableAutotune(ctx_.get(), future_element->iterator.get());
           }
           future_element->cycle_index = cycle_index_;
+          AssignBufferLimit(future_element);
           current_elements_[cycle_index_] = std::move(future_element);
           future_workers_cond_var_.notify_one();
           if (!current_elements_[cycle_index_]->active) {
@@ -743,18 +872,19 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           current_elements_[cycle_index_] = MakeElement();
           if (current_elements_[cycle_index_]) {
             current_elements_[cycle_index_]->cycle_index = cycle_index_;
+            AssignBufferLimit(current_elements_[cycle_index_]);
             elements_to_process_.push_back(cycle_index_);
             element->cycle_index = cycle_index_;
             current_workers_cond_var_.notify_one();
           }
-          while (last_valid_current_element_ >= 0 &&
-                 !current_elements_[last_valid_current_element_]) {
-            last_valid_current_element_--;
-            if (cycle_index_ > last_valid_current_element_) {
-              // We are about to move the cycle index below in
-              // AdvanceToNextInCycle().
-              cycle_index_ = last_valid_current_element_;
-            }
+        }
+        while (last_valid_current_element_ >= 0 &&
+               !current_elements_[last_valid_current_element_]) {
+          last_valid_current_element_--;
+          if (cycle_index_ > last_valid_current_element_) {
+            // We are about to move the cycle index below in
+            // AdvanceToNextInCycle().
+            cycle_index_ = last_valid_current_element_;
           }
         }
         if (last_valid_current_element_ != -1) {
@@ -770,6 +900,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
       auto element = std::make_shared<Element>();
       element->id = element_id_counter_++;
+      element->buffer_limit = dataset()->buffer_output_elements_;
       uninitialized_elements_.push_back(element);
       return element;
     }
@@ -1004,7 +1135,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
-        if (element->results.size() == dataset()->buffer_output_elements_) {
+        if (element->results.size() >= element->buffer_limit) {
           break;
         }
       }
@@ -1106,7 +1237,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         return true;
       }
       return element->iterator &&
-             element->results.size() < dataset()->buffer_output_elements_;
+             element->results.size() < element->buffer_limit;
     }
 
     inline void IncrementCurrentWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1295,6 +1426,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       auto element = std::make_shared<Element>();
       {
         mutex_lock l(*mu_);
+        element->buffer_limit = dataset()->buffer_output_elements_;
         const auto& iterator_name =
             absl::StrCat(prefix(), "::", key_prefix, "::", idx);
         if (!reader->Contains(iterator_name,
@@ -1558,6 +1690,16 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
 
     // Identifies position in the interleave cycle.
     int64_t block_index_ TF_GUARDED_BY(mu_) = 0;
+    // Whether the number of open inputs follows the autotuned parallelism
+    // (see `NumOpenInputs()`). Changing the cycle length changes the order of
+    // the output, so this is only done when the output is nondeterministic.
+    const bool adaptive_cycle_length_;
+
+    // Whether the results buffer budget is shifted toward slow inputs (see
+    // `ShiftBufferToSlowInput()`). This only helps when the consumer blocks
+    // on a particular input, i.e. when the output is deterministic.
+    const bool redistribute_buffers_;
+
     // It is an invariant that either `last_valid_current_element_ == -1` or
     // `cycle_index_ <= last_valid_current_element_`.
     int64_t cycle_index_ TF_GUARDED_BY(mu_) = 0;
@@ -1611,8 +1753,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   const DatasetBase* const input_;
   const std::unique_ptr<CapturedFunction> captured_func_;
   const int64_t cycle_length_;
+  const bool autotune_cycle_length_;
   const int64_t block_length_;
   const int64_t buffer_output_elements_;
+  const bool autotune_buffer_output_elements_;
   const int64_t prefetch_input_elements_;
   const int64_t num_parallel_calls_;
   const DeterminismPolicy deterministic_;
@@ -1686,7 +1830,8 @@ void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
       errors::InvalidArgument("num_parallel_calls must be greater than zero."));
   int64_t cycle_length = 0;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kCycleLength, &cycle_length));
-  if (cycle_length == model::kAutotune) {
+  const bool autotune_cycle_length = cycle_length == model::kAutotune;
+  if (autotune_cycle_length) {
     if (num_parallel_calls != model::kAutotune) {
       cycle_length = std::min(num_parallel_calls,
                               static_cast<int64_t>(port::MaxParallelism()));
@@ -1717,9 +1862,10 @@ void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
   }
 
   *output = new Dataset(
-      ctx, input, std::move(captured_func), cycle_length, block_length,
-      buffer_output_elements, prefetch_input_elements, num_parallel_calls,
-      deterministic_, output_types_, output_shapes_, op_version_);
+      ctx, input, std::move(captured_func), cycle_length,
+      autotune_cycle_length, block_length, buffer_output_elements,
+      prefetch_input_elements, num_parallel_calls, deterministic_,
+      output_types_, output_shapes_, op_version_);
 }
 
 namespace {
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/range_dataset_op.h"
 
 #include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/framework/metrics.h"
 
 namespace tensorflow {
 namespace data {
@@ -135,6 +136,22 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(RangeDatasetOpTest, RangeDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+TEST_F(RangeDatasetOpTest, RecordsGetNextLatency) {
+  auto range_dataset_params = PositiveStepRangeDatasetParams();
+  TF_ASSERT_OK(Initialize(range_dataset_params));
+  monitoring::SamplerCell* latency_sampler =
+      metrics::GetTFDataGetNextLatencySampler(RangeDatasetOp::kDatasetType);
+  const double num_samples = latency_sampler->value().num();
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  // 4 elements and the end of sequence.
+  EXPECT_EQ(latency_sampler->value().num() - num_samples, 5);
+}
+
 TEST_F(RangeDatasetOpTest, ZeroStep) {
   auto range_dataset_params = ZeroStepRangeDatasetParams();
   EXPECT_EQ(Initialize(range_dataset_params).code(),
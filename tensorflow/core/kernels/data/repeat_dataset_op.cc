@@ -106,6 +106,12 @@ class RepeatDatasetOp::Dataset : public DatasetBase {
     return input_->Get(ctx, index % input_->Cardinality(), out_tensors);
   }
 
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    return input_->Get(ctx, index % input_->Cardinality(), out_tensors);
+  }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
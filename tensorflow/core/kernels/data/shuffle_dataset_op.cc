@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <string>
@@ -131,19 +132,13 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
-    {
-      mutex_lock l(mu_);
-      if (shuffled_indices_.empty()) {
-        InitializeRandomAccessIndices();
-      }
-    }
-    int64 shuffled_index;
-    {
-      tf_shared_lock l(mu_);
-      shuffled_index = shuffled_indices_[index];
-    }
-    TF_RETURN_IF_ERROR(input_->Get(ctx, shuffled_index, out_tensors));
-    return Status::OK();
+    return input_->Get(ctx, ShuffledIndex(index), out_tensors);
+  }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    return input_->Get(ctx, ShuffledIndex(index), out_tensors);
   }
 
   string DebugString() const override {
@@ -160,6 +155,18 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         seed_generator_.get());
   }
 
+  // Returns the index of the input element at `index` of the shuffled dataset.
+  int64 ShuffledIndex(int64 index) const {
+    {
+      mutex_lock l(mu_);
+      if (shuffled_indices_.empty()) {
+        InitializeRandomAccessIndices();
+      }
+    }
+    tf_shared_lock l(mu_);
+    return shuffled_indices_[index];
+  }
+
   void InitializeRandomAccessIndices() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     const int64 cardinality = Cardinality();
     shuffled_indices_ = std::vector<std::int64_t>(cardinality);
@@ -228,8 +235,20 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
-      return model::MakeKnownRatioNode(std::move(args),
-                                       /*ratio=*/1);
+      // The shuffle buffer cannot be tuned without changing the order of the
+      // elements, but its memory counts towards the RAM budget of autotuning.
+      int64_t buffer_size = dataset()->buffer_size_;
+      const int64_t cardinality = dataset()->Cardinality();
+      if (cardinality > 0) {
+        buffer_size = std::min(buffer_size, cardinality);
+      }
+      return model::MakeKnownRatioNode(
+          std::move(args),
+          /*ratio=*/1,
+          {model::MakeParameter(model::kBufferSize,
+                                std::make_shared<model::SharedState>(
+                                    buffer_size, nullptr, nullptr),
+                                /*min=*/buffer_size, /*max=*/buffer_size)});
     }
 
     void ResetRngs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
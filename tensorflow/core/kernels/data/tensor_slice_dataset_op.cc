@@ -91,13 +91,12 @@ class TensorSliceDatasetOp::Dataset : public DatasetBase {
 
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
-    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
-    out_tensors->clear();
-    out_tensors->reserve(tensors_.size());
-    for (int i = 0; i < tensors_.size(); ++i) {
-      out_tensors->push_back(MaybeCopySubSlice(tensors_[i], index));
-    }
-    return Status::OK();
+    return GetSlice(index, out_tensors);
+  }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    return GetSlice(index, out_tensors);
   }
 
  protected:
@@ -132,6 +131,16 @@ class TensorSliceDatasetOp::Dataset : public DatasetBase {
   }
 
  private:
+  Status GetSlice(int64 index, std::vector<Tensor>* out_tensors) const {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    out_tensors->clear();
+    out_tensors->reserve(tensors_.size());
+    for (int i = 0; i < tensors_.size(); ++i) {
+      out_tensors->push_back(MaybeCopySubSlice(tensors_[i], index));
+    }
+    return Status::OK();
+  }
+
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
@@ -20,7 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
-#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/prefetching_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 
@@ -36,6 +36,8 @@ constexpr char kZLIB[] = "ZLIB";
 constexpr char kGZIP[] = "GZIP";
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kCurrentPos[] = "current_pos";
+// The number of buffers read ahead of each file's lines in the background.
+constexpr int kPrefetchBuffers = 2;
 
 class TextLineDatasetOp::Dataset : public DatasetBase {
  public:
@@ -191,8 +193,9 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
       // Actually move on to next file.
       TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
           dataset()->filenames_[current_file_index_], &file_));
-      input_stream_ =
-          absl::make_unique<io::RandomAccessInputStream>(file_.get(), false);
+      input_stream_ = absl::make_unique<io::PrefetchingInputStream>(
+          file_.get(), dataset()->options_.input_buffer_size,
+          kPrefetchBuffers);
 
       if (dataset()->use_compression_) {
         zlib_input_stream_ = absl::make_unique<io::ZlibInputStream>(
@@ -217,7 +220,7 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
     }
 
     mutex mu_;
-    std::unique_ptr<io::RandomAccessInputStream> input_stream_
+    std::unique_ptr<io::PrefetchingInputStream> input_stream_
         TF_GUARDED_BY(mu_);
     std::unique_ptr<io::ZlibInputStream> zlib_input_stream_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::BufferedInputStream> buffered_input_stream_
@@ -38,10 +38,17 @@ namespace data {
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
+constexpr char kRecordNumber[] = "record_number";
 constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64_t kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64_t kS3BlockSize = kCloudTpuBlockSize;
+// The number of threads decompressing each gzip file written in blocks, see
+// `ZlibCompressionOptions::block_size`.
+constexpr int32 kGzipDecompressionThreads = 4;
+// The number of buffers read ahead of each file's reader in the background,
+// see `RecordReaderOptions::prefetch_buffers`.
+constexpr int32 kPrefetchBuffers = 2;
 
 bool is_cloud_tpu_gcs_fs() {
 #if (defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)) || \
@@ -63,6 +70,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
+    options_.zlib_options.decompression_threads = kGzipDecompressionThreads;
+    // The buffers used for cloud file systems are too large to hold several.
+    if (options_.buffer_size < kCloudTpuBlockSize) {
+      options_.prefetch_buffers = kPrefetchBuffers;
+    }
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -130,6 +142,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
                 metrics::GetTFDataBytesReadCounter(kDatasetType);
             bytes_counter->IncrementBy(
                 out_tensors->back().scalar<tstring>()().size());
+            if (record_number_ >= 0) ++record_number_;
             *end_of_sequence = false;
             return Status::OK();
           }
@@ -167,10 +180,12 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         // We are currently processing a file, so try to skip reading
         // the next (num_to_skip - *num_skipped) record.
         if (reader_) {
+          SkipWithIndexLocked(ctx->env(), num_to_skip, num_skipped);
           int last_num_skipped;
           Status s = reader_->SkipRecords(num_to_skip - *num_skipped,
                                           &last_num_skipped);
           *num_skipped += last_num_skipped;
+          if (record_number_ >= 0) record_number_ += last_num_skipped;
           if (s.ok()) {
             *end_of_sequence = false;
             return Status::OK();
@@ -215,6 +230,8 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       if (reader_) {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(full_name(kOffset), reader_->TellOffset()));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name(kRecordNumber), record_number_));
       }
       return Status::OK();
     }
@@ -232,6 +249,13 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
         TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        // Checkpoints from before the record number was saved leave it
+        // unknown, which disables skipping with the index.
+        record_number_ = -1;
+        if (reader->Contains(full_name(kRecordNumber))) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name(kRecordNumber), &record_number_));
+        }
       }
       return Status::OK();
     }
@@ -257,6 +281,58 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      record_number_ = 0;
+      index_.reset();
+      index_loaded_ = false;
+    }
+
+    // Loads the index of the current file, if it is uncompressed and has
+    // one. The index is optional, so failing to read it is not an error.
+    void LoadIndexLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      index_loaded_ = true;
+      if (dataset()->options_.compression_type !=
+          io::RecordReaderOptions::NONE) {
+        return;
+      }
+      const string& filename = dataset()->filenames_[current_file_index_];
+      const string index_filename = io::RecordIndex::IndexFilename(filename);
+      if (!env->FileExists(index_filename).ok()) return;
+      auto index = absl::make_unique<io::RecordIndex>();
+      auto read_index = [&]() -> Status {
+        uint64 file_size;
+        TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+        std::unique_ptr<RandomAccessFile> index_file;
+        TF_RETURN_IF_ERROR(
+            env->NewRandomAccessFile(index_filename, &index_file));
+        return io::RecordIndex::Read(index_file.get(), file_size, index.get());
+      };
+      const Status s = read_index();
+      if (!s.ok()) {
+        LOG(WARNING) << "Not using the index " << index_filename << ": " << s;
+        return;
+      }
+      index_ = std::move(index);
+    }
+
+    // Moves the reader forward to the last indexed record before the one
+    // `num_to_skip - *num_skipped` records ahead, if that skips any record,
+    // and adds the records skipped to `*num_skipped`.
+    void SkipWithIndexLocked(Env* env, int num_to_skip, int* num_skipped)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (record_number_ < 0) return;
+      if (!index_loaded_) LoadIndexLocked(env);
+      if (index_ == nullptr) return;
+      const int64_t target = std::min<int64_t>(
+          record_number_ + num_to_skip - *num_skipped, index_->num_records());
+      int64_t indexed_record_number;
+      uint64 offset;
+      index_->Lookup(target, &indexed_record_number, &offset);
+      if (indexed_record_number <= record_number_ ||
+          !reader_->SeekOffset(offset).ok()) {
+        return;
+      }
+      *num_skipped += indexed_record_number - record_number_;
+      record_number_ = indexed_record_number;
     }
 
     mutex mu_;
@@ -266,6 +342,13 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // The number of records read or skipped from the current file, or -1 if
+    // unknown, and its index, which SkipInternal() uses to skip whole chunks
+    // of records without reading them.
+    int64_t record_number_ TF_GUARDED_BY(mu_) = 0;
+    std::unique_ptr<io::RecordIndex> index_ TF_GUARDED_BY(mu_);
+    bool index_loaded_ TF_GUARDED_BY(mu_) = false;
   };
 
   const std::vector<string> filenames_;
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -48,9 +49,35 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   }
 }
 
+bool FIFOQueue::TryEnqueueNow(std::vector<Tuple>* elements,
+                              CancellationManager* cm, DoneCallback callback) {
+  if (cm->IsCancelled()) return false;
+  bool flush;
+  {
+    mutex_lock l(mu_);
+    // Earlier attempts, including a pending Close, go first.
+    if (closed_ || !enqueue_attempts_.empty() ||
+        queues_[0].size() + elements->size() > static_cast<size_t>(capacity_)) {
+      return false;
+    }
+    for (Tuple& element : *elements) {
+      for (int i = 0; i < num_components(); ++i) {
+        queues_[i].push_back(std::move(element[i]));
+      }
+    }
+    flush = !dequeue_attempts_.empty();
+  }
+  if (flush) FlushUnlocked();
+  callback();
+  return true;
+}
+
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  std::vector<Tuple> elements = {tuple};
+  if (TryEnqueueNow(&elements, cm, callback)) return;
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -107,7 +134,25 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     return;
   }
 
+  // Split the batch before taking the lock, so that the copies don't hold
+  // up the other enqueues and dequeues.
+  std::vector<Tuple> elements(batch_size);
+  for (int64_t index = 0; index < batch_size; ++index) {
+    elements[index].resize(num_components());
+    for (int i = 0; i < num_components(); ++i) {
+      Status s = GetElementComponentFromBatch(tuple, index, i, ctx,
+                                              &elements[index][i]);
+      if (!s.ok()) {
+        ctx->SetStatus(s);
+        callback();
+        return;
+      }
+    }
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
+  if (TryEnqueueNow(&elements, cm, callback)) return;
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -117,7 +162,7 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     if (!already_cancelled) {
       enqueue_attempts_.emplace_back(
           batch_size, callback, ctx, cm, token,
-          [tuple, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          [elements, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
             if (closed_) {
               attempt->context->SetStatus(
                   errors::Cancelled("FIFOQueue '", name_, "' is closed."));
@@ -127,13 +172,9 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
             while (queues_[0].size() < static_cast<size_t>(capacity_)) {
               result = kProgress;
               const int64_t index =
-                  tuple[0].dim_size(0) - attempt->elements_requested;
+                  elements.size() - attempt->elements_requested;
               for (int i = 0; i < num_components(); ++i) {
-                Tensor element;
-                attempt->context->SetStatus(GetElementComponentFromBatch(
-                    tuple, index, i, attempt->context, &element));
-                if (!attempt->context->status().ok()) return kComplete;
-                queues_[i].push_back(element);
+                queues_[i].push_back(elements[index][i]);
               }
               --attempt->elements_requested;
               if (attempt->elements_requested == 0) {
@@ -154,6 +195,23 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  if (!cm->IsCancelled()) {
+    Tuple tuple;
+    bool flush = false;
+    {
+      mutex_lock l(mu_);
+      if (dequeue_attempts_.empty() && !queues_[0].empty()) {
+        DequeueLocked(ctx, &tuple);
+        flush = !enqueue_attempts_.empty();
+      }
+    }
+    if (!tuple.empty()) {
+      if (flush) FlushUnlocked();
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -245,6 +303,8 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 
   CancellationManager* cm = ctx->cancellation_manager();
+  if (TryDequeueManyNow(num_elements, ctx, callback)) return;
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -355,6 +415,60 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 }
 
+bool FIFOQueue::TryDequeueManyNow(int num_elements, OpKernelContext* ctx,
+                                  const CallbackWithTuple& callback) {
+  auto can_dequeue_now = [this, num_elements]()
+                             TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                               return dequeue_attempts_.empty() &&
+                                      queues_[0].size() >=
+                                          static_cast<size_t>(num_elements);
+                             };
+  if (ctx->cancellation_manager()->IsCancelled()) return false;
+  {
+    mutex_lock l(mu_);
+    if (!can_dequeue_now()) return false;
+  }
+
+  // Allocate the batch before dequeuing, so that no element is lost if the
+  // allocation fails.
+  Tuple batch;
+  batch.reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor component;
+    if (!ctx->allocate_temp(component_dtypes_[i],
+                            ManyOutShape(i, num_elements), &component)
+             .ok()) {
+      return false;
+    }
+    batch.emplace_back(std::move(component));
+  }
+
+  std::vector<Tuple> elements(num_elements);
+  bool flush;
+  {
+    mutex_lock l(mu_);
+    if (!can_dequeue_now()) return false;
+    for (Tuple& element : elements) DequeueLocked(ctx, &element);
+    flush = !enqueue_attempts_.empty();
+  }
+  if (flush) FlushUnlocked();
+
+  // Copy the elements into the batch without holding the lock.
+  for (int64_t index = 0; index < num_elements; ++index) {
+    for (int i = 0; i < num_components(); ++i) {
+      Status s = batch_util::CopyElementToSlice(std::move(elements[index][i]),
+                                                &batch[i], index);
+      if (!s.ok()) {
+        ctx->SetStatus(s);
+        callback(Tuple());
+        return true;
+      }
+    }
+  }
+  callback(batch);
+  return true;
+}
+
 Status FIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
   if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
       !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
@@ -66,6 +66,19 @@ class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
                                              OpKernelContext* ctx,
                                              Tensor* out_tensor);
 
+  // Fast paths of the enqueues and dequeues that can complete right away,
+  // without waiting behind earlier attempts. They skip the allocation of an
+  // attempt and the registration of a cancellation callback, and run
+  // `callback` if they complete, returning true.
+  //
+  // Enqueues all of `elements`, if they fit in the queue.
+  bool TryEnqueueNow(std::vector<Tuple>* elements, CancellationManager* cm,
+                     DoneCallback callback);
+  // Dequeues a batch of `num_elements`, if the queue holds as many. The
+  // elements are copied into the batch after releasing the lock.
+  bool TryDequeueManyNow(int num_elements, OpKernelContext* ctx,
+                         const CallbackWithTuple& callback);
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueue);
 };
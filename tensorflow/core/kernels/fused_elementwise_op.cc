@@ -0,0 +1,294 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "unsupported/Eigen/SpecialFunctions"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+enum class ElementwiseOp {
+  kAdd,
+  kSub,
+  kMul,
+  kRealDiv,
+  kMaximum,
+  kMinimum,
+  kSquaredDifference,
+  kNeg,
+  kSquare,
+  kSqrt,
+  kRsqrt,
+  kExp,
+  kLog,
+  kTanh,
+  kSigmoid,
+  kRelu,
+  kErf,
+};
+
+Status ParseElementwiseOp(const string& name, ElementwiseOp* op, int* arity) {
+  static const auto* const kOps =
+      new std::unordered_map<string, std::pair<ElementwiseOp, int>>({
+          {"Add", {ElementwiseOp::kAdd, 2}},
+          {"AddV2", {ElementwiseOp::kAdd, 2}},
+          {"Sub", {ElementwiseOp::kSub, 2}},
+          {"Mul", {ElementwiseOp::kMul, 2}},
+          {"RealDiv", {ElementwiseOp::kRealDiv, 2}},
+          {"Maximum", {ElementwiseOp::kMaximum, 2}},
+          {"Minimum", {ElementwiseOp::kMinimum, 2}},
+          {"SquaredDifference", {ElementwiseOp::kSquaredDifference, 2}},
+          {"Neg", {ElementwiseOp::kNeg, 1}},
+          {"Square", {ElementwiseOp::kSquare, 1}},
+          {"Sqrt", {ElementwiseOp::kSqrt, 1}},
+          {"Rsqrt", {ElementwiseOp::kRsqrt, 1}},
+          {"Exp", {ElementwiseOp::kExp, 1}},
+          {"Log", {ElementwiseOp::kLog, 1}},
+          {"Tanh", {ElementwiseOp::kTanh, 1}},
+          {"Sigmoid", {ElementwiseOp::kSigmoid, 1}},
+          {"Relu", {ElementwiseOp::kRelu, 1}},
+          {"Erf", {ElementwiseOp::kErf, 1}},
+      });
+  auto it = kOps->find(name);
+  if (it == kOps->end()) {
+    return errors::Unimplemented("Elementwise op ", name,
+                                 " cannot be fused");
+  }
+  *op = it->second.first;
+  *arity = it->second.second;
+  return Status::OK();
+}
+
+// Evaluates `op` on `n` elements of `a` and `b` into `out`, which may be
+// either of them.
+template <typename T>
+void EvaluateElementwiseOp(ElementwiseOp op, const T* a, const T* b,
+                           int64_t n, T* out) {
+  using Vec = Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+  using ConstVec = Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>>;
+  ConstVec x(a, n);
+  ConstVec y(b, b == nullptr ? 0 : n);
+  Vec z(out, n);
+  switch (op) {
+    case ElementwiseOp::kAdd:
+      z = x + y;
+      break;
+    case ElementwiseOp::kSub:
+      z = x - y;
+      break;
+    case ElementwiseOp::kMul:
+      z = x * y;
+      break;
+    case ElementwiseOp::kRealDiv:
+      z = x / y;
+      break;
+    case ElementwiseOp::kMaximum:
+      z = x.cwiseMax(y);
+      break;
+    case ElementwiseOp::kMinimum:
+      z = x.cwiseMin(y);
+      break;
+    case ElementwiseOp::kSquaredDifference:
+      z = (x - y).square();
+      break;
+    case ElementwiseOp::kNeg:
+      z = -x;
+      break;
+    case ElementwiseOp::kSquare:
+      z = x.square();
+      break;
+    case ElementwiseOp::kSqrt:
+      z = x.sqrt();
+      break;
+    case ElementwiseOp::kRsqrt:
+      z = x.rsqrt();
+      break;
+    case ElementwiseOp::kExp:
+      z = x.exp();
+      break;
+    case ElementwiseOp::kLog:
+      z = x.log();
+      break;
+    case ElementwiseOp::kTanh:
+      z = x.tanh();
+      break;
+    case ElementwiseOp::kSigmoid:
+      z = x.sigmoid();
+      break;
+    case ElementwiseOp::kRelu:
+      z = x.cwiseMax(static_cast<T>(0));
+      break;
+    case ElementwiseOp::kErf:
+      z = x.erf();
+      break;
+  }
+}
+
+}  // namespace
+
+// Evaluates the chain of `fused_ops` block by block, so that the
+// intermediate results of a block stay in cache while the whole chain runs
+// on it.
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  // The intermediate results of a block take at most this many bytes.
+  static constexpr int64_t kScratchBytes = 64 << 10;
+  static constexpr int64_t kMinBlockSize = 64;
+  static constexpr int64_t kMaxBlockSize = 4096;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args_));
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    std::vector<int32> fused_operands;
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("fused_operands", &fused_operands));
+    int next_operand = 0;
+    for (int i = 0; i < fused_ops.size(); ++i) {
+      Step step;
+      int arity;
+      OP_REQUIRES_OK(context,
+                     ParseElementwiseOp(fused_ops[i], &step.op, &arity));
+      OP_REQUIRES(context, next_operand + arity <= fused_operands.size(),
+                  errors::InvalidArgument("Missing operands for fused op ", i,
+                                          " (", fused_ops[i], ")"));
+      for (int j = 0; j < arity; ++j) {
+        const int operand = fused_operands[next_operand++];
+        OP_REQUIRES(context, operand >= 0 && operand < num_args_ + i,
+                    errors::InvalidArgument("Fused op ", i, " (",
+                                            fused_ops[i], ") has operand ",
+                                            operand, ", which is not in [0, ",
+                                            num_args_ + i, ")"));
+        step.operands[j] = operand;
+      }
+      steps_.push_back(step);
+    }
+    OP_REQUIRES(context, next_operand == fused_operands.size(),
+                errors::InvalidArgument("Got ", fused_operands.size(),
+                                        " fused operands, expected ",
+                                        next_operand));
+    const int64_t step_bytes = steps_.size() * sizeof(T);
+    block_size_ = std::max(
+        kMinBlockSize, std::min(kMaxBlockSize, kScratchBytes / step_bytes));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList args;
+    OP_REQUIRES_OK(context, context->input_list("args", &args));
+    TensorShape shape;
+    std::vector<int> forwardable_inputs;
+    for (int i = 0; i < args.size(); ++i) {
+      if (TensorShapeUtils::IsScalar(args[i].shape())) continue;
+      if (forwardable_inputs.empty()) {
+        shape = args[i].shape();
+      } else {
+        OP_REQUIRES(context, args[i].shape() == shape,
+                    errors::InvalidArgument(
+                        "Arguments of _FusedElementwise must be scalars or "
+                        "have the same shape, got ",
+                        shape.DebugString(), " and ",
+                        args[i].shape().DebugString()));
+      }
+      forwardable_inputs.push_back(i);
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                forwardable_inputs, 0, shape, &output));
+    const int64_t num_elements = shape.num_elements();
+    if (num_elements == 0) return;
+
+    std::vector<const T*> arg_data(args.size());
+    for (int i = 0; i < args.size(); ++i) {
+      arg_data[i] = args[i].flat<T>().data();
+    }
+    T* output_data = output->flat<T>().data();
+    const int64_t num_blocks =
+        (num_elements + block_size_ - 1) / block_size_;
+    auto work = [&](int64_t begin_block, int64_t end_block) {
+      // Scalars are broadcast into a block, and each op gets a block for its
+      // result.
+      std::vector<T> scratch((args.size() + steps_.size()) * block_size_);
+      std::vector<const T*> operands(args.size() + steps_.size());
+      for (int i = 0; i < args.size(); ++i) {
+        if (TensorShapeUtils::IsScalar(args[i].shape())) {
+          std::fill_n(scratch.data() + i * block_size_, block_size_,
+                      *arg_data[i]);
+        }
+      }
+      for (int64_t block = begin_block; block < end_block; ++block) {
+        const int64_t offset = block * block_size_;
+        const int64_t n = std::min(block_size_, num_elements - offset);
+        for (int i = 0; i < args.size(); ++i) {
+          operands[i] = TensorShapeUtils::IsScalar(args[i].shape())
+                            ? scratch.data() + i * block_size_
+                            : arg_data[i] + offset;
+        }
+        for (int i = 0; i < steps_.size(); ++i) {
+          const Step& step = steps_[i];
+          T* result = i + 1 == steps_.size()
+                          ? output_data + offset
+                          : scratch.data() + (args.size() + i) * block_size_;
+          EvaluateElementwiseOp<T>(
+              step.op, operands[step.operands[0]],
+              step.operands[1] < 0 ? nullptr : operands[step.operands[1]], n,
+              result);
+          operands[args.size() + i] = result;
+        }
+      }
+    };
+    const int64_t cost_per_block = block_size_ * steps_.size() * 10;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          cost_per_block, work);
+  }
+
+ private:
+  struct Step {
+    ElementwiseOp op;
+    // The second operand is -1 for unary ops.
+    int operands[2] = {-1, -1};
+  };
+
+  int num_args_;
+  std::vector<Step> steps_;
+  int64_t block_size_;
+};
+
+#define REGISTER_CPU(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status Init(int num_args, const std::vector<string>& fused_ops,
+              const std::vector<int>& fused_operands) {
+    TF_CHECK_OK(NodeDefBuilder("fused", "_FusedElementwise")
+                    .Input(FakeInput(num_args, DT_FLOAT))
+                    .Attr("fused_ops", fused_ops)
+                    .Attr("fused_operands", fused_operands)
+                    .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, Gelu) {
+  // 0.5 * x * (1 + tanh(0.7978845608 * (x + 0.044715 * x^3))), with the
+  // arguments x, 0.044715, 0.7978845608, 1 and 0.5.
+  TF_ASSERT_OK(Init(5, {"Mul", "Mul", "Mul", "AddV2", "Mul", "Tanh", "AddV2",
+                        "Mul", "Mul"},
+                    {0, 0, 5, 0, 1, 6, 0, 7, 2, 8, 9, 3, 10, 0, 11, 4, 12}));
+  // Spans several blocks, the last of which is partial.
+  const int n = 10001;
+  std::vector<float> x(n);
+  std::vector<float> expected(n);
+  for (int i = 0; i < n; ++i) {
+    x[i] = (i - n / 2) * 0.001f;
+    const float inner = 0.7978845608f * (x[i] + 0.044715f * x[i] * x[i] * x[i]);
+    expected[i] = 0.5f * x[i] * (1 + std::tanh(inner));
+  }
+  AddInputFromArray<float>(TensorShape({n}), x);
+  AddInputFromArray<float>(TensorShape({}), {0.044715f});
+  AddInputFromArray<float>(TensorShape({}), {0.7978845608f});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({n}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectTensorNear<float>(expected_tensor, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedElementwiseOpTest, UnaryAndBinaryOps) {
+  // relu(a - b) * sigmoid(b)
+  TF_ASSERT_OK(Init(2, {"Sub", "Relu", "Sigmoid", "Mul"}, {0, 1, 2, 1, 3, 4}));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({2, 2}), {2, 1, 0, 4});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {0, 1 / (1 + std::exp(-1.0f)), 1.5f, 0});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsLaterOperands) {
+  EXPECT_FALSE(Init(1, {"Neg", "Neg"}, {2, 0}).ok());
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsMismatchedOperands) {
+  EXPECT_FALSE(Init(2, {"Add"}, {0}).ok());
+  EXPECT_FALSE(Init(2, {"Neg"}, {0, 1}).ok());
+  EXPECT_FALSE(Init(1, {"MatMul"}, {0, 0}).ok());
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsMismatchedShapes) {
+  TF_ASSERT_OK(Init(2, {"Add"}, {0, 1}));
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  EXPECT_EQ(RunOpKernel().code(), error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace tensorflow
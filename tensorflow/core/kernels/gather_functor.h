@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 #define TENSORFLOW_CORE_KERNELS_GATHER_FUNCTOR_H_
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/core/framework/bounds_check.h"
@@ -52,6 +54,16 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   }
   // Compute slice_bytes here so that static knowledge is available
   const size_t slice_bytes = slice_elems * sizeof(T);
+  // Rows of large tables are mostly cache misses at random addresses, which
+  // the hardware prefetcher can't predict, so the rows to copy are prefetched
+  // a few slices ahead. Only the head of long slices is prefetched; the rest
+  // is read sequentially.
+  constexpr int64_t kPrefetchDistance = 8;
+  constexpr size_t kCacheLineSize = 64;
+  constexpr size_t kMaxPrefetchBytes = 4 * kCacheLineSize;
+  const size_t prefetch_bytes =
+      is_simple_type<T>::value ? std::min(slice_bytes, kMaxPrefetchBytes)
+                               : sizeof(T);
   auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
   mutex mu;
   // Store the value of invalidate index for printing error information, it's a
@@ -60,30 +72,39 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   auto work = [&](int64_t start, int64_t end) {
     SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
     SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
-    SliceIndex batch_idx_end = static_cast<SliceIndex>(end / indices_size);
-    SliceIndex indices_idx_end = static_cast<SliceIndex>(end % indices_size);
+    // Position of the slice that is prefetched next, which runs
+    // kPrefetchDistance slices ahead of the one being copied.
+    int64_t ahead = start;
+    SliceIndex ahead_batch_idx = batch_idx;
+    SliceIndex ahead_indices_idx = indices_idx;
+    auto prefetch_ahead = [&]() {
+      const Index ahead_index = indices(ahead_indices_idx);
+      if (FastBoundsCheck(ahead_index, limit)) {
+        const char* row = reinterpret_cast<const char*>(
+            &params(ahead_batch_idx, ahead_index, 0));
+        for (size_t offset = 0; offset < prefetch_bytes;
+             offset += kCacheLineSize) {
+          port::prefetch<port::PREFETCH_HINT_T0>(row + offset);
+        }
+      }
+      ++ahead;
+      if (++ahead_indices_idx == indices_size) {
+        ahead_indices_idx = 0;
+        ++ahead_batch_idx;
+      }
+    };
+    while (ahead < end && ahead - start < kPrefetchDistance) {
+      prefetch_ahead();
+    }
 
-    while ((batch_idx < batch_idx_end) ||
-           (batch_idx == batch_idx_end && indices_idx < indices_idx_end)) {
-      SliceIndex i_next = indices_idx + 1;
-      SliceIndex b_next = batch_idx + 1;
+    for (int64_t i = start; i < end; ++i) {
+      if (ahead < end) prefetch_ahead();
       const Index index = internal::SubtleMustCopy(indices(indices_idx));
       if (!FastBoundsCheck(index, limit)) {
         mutex_lock l(mu);
         result = indices_idx;
         return;
       }
-      if ((batch_idx == batch_idx_end && i_next < indices_idx_end) ||
-          (i_next < indices_size)) {
-        port::prefetch<port::PREFETCH_HINT_T0>(
-            &params(batch_idx, indices(i_next), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(batch_idx, i_next, 0));
-        b_next = batch_idx;
-      } else if (b_next <= batch_idx_end) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b_next, indices(0), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, 0, 0));
-        i_next = 0;
-      }
       // Copy using memcpy if possible, otherwise an Eigen loop
       // TODO(cwhipkey): avoid linking to framework to get Allocator (to improve
       // ahead-of-time compilation binary size).
@@ -100,8 +121,10 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
         out.template chip<0>(batch_idx).template chip<0>(indices_idx) =
             params.template chip<0>(batch_idx).template chip<0>(index);
       }
-      indices_idx = i_next;
-      batch_idx = b_next;
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
     }
   };
 
@@ -0,0 +1,240 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// Bilinear interpolation weights along one dimension of the output.
+struct SampleWeights {
+  int64_t lower;  // Lower source index after scaling by the channels.
+  int64_t upper;  // Upper source index after scaling by the channels.
+  float lerp;
+};
+
+// Computes where each of the `out_size` output pixels samples the decoded,
+// `ratio` times downscaled image, whose first row or column is `in_start` and
+// which has `in_size` of them. The output covers [crop_start, crop_start +
+// crop_size) of the full size image, and every decoded pixel i covers
+// [i * ratio, (i + 1) * ratio) of it.
+std::vector<SampleWeights> ComputeSampleWeights(int crop_start, int crop_size,
+                                                int out_size, int ratio,
+                                                int in_start, int in_size,
+                                                int64_t stride) {
+  std::vector<SampleWeights> weights(out_size);
+  const double scale = static_cast<double>(crop_size) / out_size;
+  for (int i = 0; i < out_size; ++i) {
+    // The center of the output pixel in decoded pixel coordinates.
+    const double in = (crop_start + (i + 0.5) * scale) / ratio - 0.5 - in_start;
+    const double clamped = std::min<double>(std::max(in, 0.0), in_size - 1);
+    const int64_t lower = static_cast<int64_t>(clamped);
+    weights[i].lower = lower * stride;
+    weights[i].upper = std::min<int64_t>(lower + 1, in_size - 1) * stride;
+    weights[i].lerp = static_cast<float>(clamped - lower);
+  }
+  return weights;
+}
+
+// Decodes the crop window of a JPEG image at the smallest DCT scale that
+// still has the output size, and resizes it to the output size.
+class DecodeAndResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 0, 1, or 3, got ",
+                                        channels_));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context, context->GetAttr("acceptable_fraction",
+                                             &flags_.min_acceptable_fraction));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    // The same default as DecodeAndCropJpeg.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+    flags_.components = channels_;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<tstring>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(crop_window.shape()) &&
+                    crop_window.NumElements() == 4,
+                errors::InvalidArgument("crop_window must have four elements, "
+                                        "got shape ",
+                                        crop_window.shape().DebugString()));
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(size.shape()) &&
+                    size.NumElements() == 2,
+                errors::InvalidArgument("size must have two elements, got "
+                                        "shape ",
+                                        size.shape().DebugString()));
+    auto crop_window_vec = crop_window.vec<int32>();
+    const int crop_y = crop_window_vec(0);
+    const int crop_x = crop_window_vec(1);
+    const int crop_height = crop_window_vec(2);
+    const int crop_width = crop_window_vec(3);
+    auto size_vec = size.vec<int32>();
+    const int out_height = size_vec(0);
+    const int out_width = size_vec(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        out_height, ", ", out_width, "]"));
+
+    int width, height;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                                   nullptr),
+                errors::InvalidArgument("Invalid JPEG data, size ",
+                                        input.size()));
+    OP_REQUIRES(
+        context,
+        crop_height > 0 && crop_width > 0 && crop_y >= 0 && crop_x >= 0 &&
+            crop_y <= height - crop_height && crop_x <= width - crop_width,
+        errors::InvalidArgument("Invalid crop window [", crop_y, ", ", crop_x,
+                                ", ", crop_height, ", ", crop_width,
+                                "] for an image of ", height, " x ", width));
+
+    // Decodes the rows and columns of the scaled image that the crop window
+    // overlaps.
+    const int ratio =
+        jpeg::ScaleRatioForSize(crop_width, crop_height, out_width, out_height);
+    const int scaled_height = (height + ratio - 1) / ratio;
+    const int scaled_width = (width + ratio - 1) / ratio;
+    jpeg::UncompressFlags flags = flags_;
+    flags.ratio = ratio;
+    flags.crop = true;
+    flags.crop_y = crop_y / ratio;
+    flags.crop_x = crop_x / ratio;
+    flags.crop_height =
+        std::min((crop_y + crop_height + ratio - 1) / ratio, scaled_height) -
+        flags.crop_y;
+    flags.crop_width =
+        std::min((crop_x + crop_width + ratio - 1) / ratio, scaled_width) -
+        flags.crop_x;
+
+    Tensor decoded;
+    int decoded_channels = 0;
+    uint8* buffer = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [&](int decoded_width, int decoded_height, int channels) -> uint8* {
+          Status status = context->allocate_temp(
+              DT_UINT8, TensorShape({decoded_height, decoded_width, channels}),
+              &decoded);
+          if (!status.ok()) {
+            VLOG(1) << status;
+            context->SetStatus(status);
+            return nullptr;
+          }
+          decoded_channels = channels;
+          return decoded.flat<uint8>().data();
+        });
+    OP_REQUIRES(
+        context, buffer,
+        errors::InvalidArgument(
+            "jpeg::Uncompress failed. Invalid JPEG data or crop window."));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, TensorShape({out_height, out_width, decoded_channels}),
+            &output));
+    const int64_t in_row_size =
+        static_cast<int64_t>(flags.crop_width) * decoded_channels;
+    const std::vector<SampleWeights> ys =
+        ComputeSampleWeights(crop_y, crop_height, out_height, ratio,
+                             flags.crop_y, flags.crop_height, in_row_size);
+    const std::vector<SampleWeights> xs =
+        ComputeSampleWeights(crop_x, crop_width, out_width, ratio,
+                             flags.crop_x, flags.crop_width, decoded_channels);
+    const uint8* in = decoded.flat<uint8>().data();
+    float* out = output->flat<float>().data();
+    const int64_t out_row_size =
+        static_cast<int64_t>(out_width) * decoded_channels;
+    auto resize_rows = [&](int64_t begin, int64_t end) {
+      for (int64_t y = begin; y < end; ++y) {
+        const uint8* top = in + ys[y].lower;
+        const uint8* bottom = in + ys[y].upper;
+        const float y_lerp = ys[y].lerp;
+        float* out_row = out + y * out_row_size;
+        for (int x = 0; x < out_width; ++x) {
+          const SampleWeights& xw = xs[x];
+          for (int c = 0; c < decoded_channels; ++c) {
+            const float top_left = top[xw.lower + c];
+            const float top_right = top[xw.upper + c];
+            const float bottom_left = bottom[xw.lower + c];
+            const float bottom_right = bottom[xw.upper + c];
+            const float top_value = top_left + (top_right - top_left) * xw.lerp;
+            const float bottom_value =
+                bottom_left + (bottom_right - bottom_left) * xw.lerp;
+            out_row[x * decoded_channels + c] =
+                top_value + (bottom_value - top_value) * y_lerp;
+          }
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, out_height,
+          /*cost_per_unit=*/out_row_size * 10, resize_rows);
+  }
+
+ private:
+  int channels_;
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeAndResizeJpeg").Device(DEVICE_CPU),
+                        DecodeAndResizeJpegOp);
+
+}  // namespace
+}  // namespace tensorflow
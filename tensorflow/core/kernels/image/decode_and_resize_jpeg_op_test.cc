@@ -0,0 +1,150 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+
+class DecodeAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void SetUp() override {
+    std::vector<uint8> image(kWidth * kHeight * 3);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth; ++x) {
+        uint8* pixel = &image[(y * kWidth + x) * 3];
+        pixel[0] = x * 4;
+        pixel[1] = y * 5;
+        pixel[2] = 128;
+      }
+    }
+    jpeg::CompressFlags flags;
+    flags.format = jpeg::FORMAT_RGB;
+    ASSERT_TRUE(jpeg::Compress(image.data(), kWidth, kHeight, flags, &jpeg_));
+  }
+
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("decode_and_resize", "DecodeAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("channels", 3)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  Status Run(const std::vector<int32>& crop_window,
+             const std::vector<int32>& size) {
+    AddInputFromArray<tstring>(TensorShape({}), {jpeg_});
+    AddInputFromArray<int32>(TensorShape({4}), crop_window);
+    AddInputFromArray<int32>(TensorShape({2}), size);
+    return RunOpKernel();
+  }
+
+  // Returns rows [y, y + height) and columns [x, x + width) of the image
+  // decoded at 1/`ratio` scale, as floats.
+  Tensor DecodeScaled(int ratio, int y, int x, int height, int width) {
+    jpeg::UncompressFlags flags;
+    flags.ratio = ratio;
+    flags.components = 3;
+    flags.dct_method = JDCT_IFAST;
+    int decoded_width, decoded_height, channels;
+    std::unique_ptr<uint8[]> decoded(
+        jpeg::Uncompress(jpeg_.data(), jpeg_.size(), flags, &decoded_width,
+                         &decoded_height, &channels, nullptr));
+    EXPECT_NE(decoded, nullptr);
+    Tensor expected(DT_FLOAT, TensorShape({height, width, 3}));
+    auto expected_tensor = expected.tensor<float, 3>();
+    for (int i = 0; i < height; ++i) {
+      for (int j = 0; j < width; ++j) {
+        for (int c = 0; c < 3; ++c) {
+          expected_tensor(i, j, c) =
+              decoded[((y + i) * decoded_width + x + j) * 3 + c];
+        }
+      }
+    }
+    return expected;
+  }
+
+  tstring jpeg_;
+};
+
+TEST_F(DecodeAndResizeJpegOpTest, FullSize) {
+  MakeOp();
+  TF_ASSERT_OK(Run({0, 0, kHeight, kWidth}, {kHeight, kWidth}));
+  test::ExpectTensorEqual<float>(*GetOutput(0),
+                                 DecodeScaled(1, 0, 0, kHeight, kWidth));
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, DownscalesWhileDecoding) {
+  MakeOp();
+  TF_ASSERT_OK(Run({0, 0, kHeight, kWidth}, {kHeight / 4, kWidth / 4}));
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), DecodeScaled(4, 0, 0, kHeight / 4, kWidth / 4));
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, CropsAndDownscalesWhileDecoding) {
+  MakeOp();
+  TF_ASSERT_OK(Run({16, 16, 32, 32}, {16, 16}));
+  test::ExpectTensorEqual<float>(*GetOutput(0), DecodeScaled(2, 8, 8, 16, 16));
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InterpolatesToSize) {
+  MakeOp();
+  TF_ASSERT_OK(Run({8, 4, 30, 50}, {20, 13}));
+  const Tensor& output = *GetOutput(0);
+  EXPECT_EQ(output.shape(), TensorShape({20, 13, 3}));
+  // The red channel is a horizontal ramp of 4 per pixel, so it increases from
+  // column to column by about the 50 / 13 pixels between their centers.
+  auto output_tensor = output.tensor<float, 3>();
+  for (int y = 0; y < 20; ++y) {
+    for (int x = 1; x < 13; ++x) {
+      EXPECT_NEAR(output_tensor(y, x, 0) - output_tensor(y, x - 1, 0),
+                  4.0 * 50 / 13, 4.0);
+    }
+  }
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InvalidCropWindow) {
+  MakeOp();
+  Status status = Run({0, 1, kHeight, kWidth}, {10, 10});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "Invalid crop window"))
+      << status;
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InvalidSize) {
+  MakeOp();
+  Status status = Run({0, 0, kHeight, kWidth}, {0, 10});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,407 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs a curated set of CPU kernel benchmarks at realistic shapes, writes the
+// results as BenchmarkEntries (see test_log.proto), and compares them to a
+// stored baseline.
+//
+// The wall time per iteration and, when hardware performance counters are
+// available, the cycles, instructions, cache misses and instructions per
+// cycle are recorded for each benchmark. Running each benchmark several times
+// gives the standard deviations used to tell regressions from noise:
+//
+//   kernel_regression_benchmarks --benchmark_repetitions=5 \
+//       --output=/tmp/current.pbtxt --baseline=/path/to/baseline.pbtxt
+//
+// The binary exits with a non-zero status when a benchmark regressed. A new
+// baseline is written by running without --baseline.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/png/png_io.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/util/benchmark_regression.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor RandomFloats(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  return tensor;
+}
+
+// Returns `size` random indices in [0, limit), sorted if `sorted`.
+Tensor RandomIndices(int64_t size, int64_t limit, bool sorted) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> indices(size);
+  for (int32& index : indices) index = rnd.Uniform(limit);
+  if (sorted) std::sort(indices.begin(), indices.end());
+  Tensor tensor(DT_INT32, TensorShape({size}));
+  std::copy(indices.begin(), indices.end(), tensor.flat<int32>().data());
+  return tensor;
+}
+
+// A dense layer of a serving model, or a larger training step.
+void BM_MatMul(::testing::benchmark::State& state) {
+  const int m = state.range(0);
+  const int k = state.range(1);
+  const int n = state.range(2);
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, test::graph::Constant(g, RandomFloats({m, k})),
+                      test::graph::Constant(g, RandomFloats({k, n})),
+                      /*transpose_a=*/false, /*transpose_b=*/false);
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetItemsProcessed(state.iterations() * 2 * m * k * n);
+}
+BENCHMARK(BM_MatMul)
+    ->UseRealTime()
+    ->Args({1, 1024, 1024})
+    ->Args({128, 1024, 1024})
+    ->Args({512, 2048, 2048});
+
+// The layers of ResNet-50, in NHWC.
+void BM_Conv2D(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  const int size = state.range(1);
+  const int in_depth = state.range(2);
+  const int filter_size = state.range(3);
+  const int out_depth = state.range(4);
+  const int stride = state.range(5);
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* conv;
+  TF_CHECK_OK(NodeBuilder(g->NewName("conv"), "Conv2D")
+                  .Input(test::graph::Constant(
+                      g, RandomFloats({batch, size, size, in_depth})))
+                  .Input(test::graph::Constant(
+                      g, RandomFloats(
+                             {filter_size, filter_size, in_depth, out_depth})))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("strides", {1, stride, stride, 1})
+                  .Attr("padding", "SAME")
+                  .Attr("data_format", "NHWC")
+                  .Finalize(g, &conv));
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+}
+BENCHMARK(BM_Conv2D)
+    ->UseRealTime()
+    ->Args({8, 224, 3, 7, 64, 2})
+    ->Args({32, 56, 64, 3, 64, 1})
+    ->Args({32, 28, 128, 3, 128, 1})
+    ->Args({32, 14, 256, 3, 256, 1});
+
+// Embedding lookups.
+void BM_Gather(::testing::benchmark::State& state) {
+  const int rows = state.range(0);
+  const int dim = state.range(1);
+  const int lookups = state.range(2);
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor axis(DT_INT32, TensorShape({}));
+  axis.scalar<int32>()() = 0;
+  test::graph::Gather(
+      g, test::graph::Constant(g, RandomFloats({rows, dim})),
+      test::graph::Constant(g, RandomIndices(lookups, rows, /*sorted=*/false)),
+      test::graph::HostConstant(g, axis));
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetBytesProcessed(state.iterations() * lookups * dim * sizeof(float));
+}
+BENCHMARK(BM_Gather)
+    ->UseRealTime()
+    ->Args({100000, 64, 8192})
+    ->Args({1000000, 16, 65536});
+
+// Sums the embeddings of variable length features.
+void BM_SegmentSum(::testing::benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int segments = state.range(2);
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* sum;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("segment_sum"), "SegmentSum")
+          .Input(test::graph::Constant(g, RandomFloats({rows, cols})))
+          .Input(test::graph::Constant(
+              g, RandomIndices(rows, segments, /*sorted=*/true)))
+          .Finalize(g, &sum));
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetBytesProcessed(state.iterations() * rows * cols * sizeof(float));
+}
+BENCHMARK(BM_SegmentSum)
+    ->UseRealTime()
+    ->Args({65536, 64, 1024})
+    ->Args({4096, 1024, 64});
+
+constexpr int kNumDenseFeatures = 10;
+constexpr int kDenseFeatureSize = 16;
+constexpr int kNumSparseFeatures = 5;
+constexpr int kSparseFeatureSize = 8;
+
+// Parses a batch of examples with a mix of dense float and sparse int64
+// features, like the input of a ranking model.
+void BM_ParseExample(::testing::benchmark::State& state) {
+  const int batch_size = state.range(0);
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  Tensor dense_keys(DT_STRING, TensorShape({kNumDenseFeatures}));
+  for (int i = 0; i < kNumDenseFeatures; ++i) {
+    dense_keys.vec<tstring>()(i) = absl::StrCat("dense_", i);
+    auto* values = features[dense_keys.vec<tstring>()(i)].mutable_float_list();
+    for (int j = 0; j < kDenseFeatureSize; ++j) values->add_value(j);
+  }
+  Tensor sparse_keys(DT_STRING, TensorShape({kNumSparseFeatures}));
+  for (int i = 0; i < kNumSparseFeatures; ++i) {
+    sparse_keys.vec<tstring>()(i) = absl::StrCat("sparse_", i);
+    auto* values =
+        features[sparse_keys.vec<tstring>()(i)].mutable_int64_list();
+    for (int j = 0; j < kSparseFeatureSize; ++j) values->add_value(j * 1000);
+  }
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  for (int i = 0; i < batch_size; ++i) {
+    serialized.vec<tstring>()(i) = example.SerializeAsString();
+  }
+
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  for (int i = 0; i < kNumDenseFeatures; ++i) {
+    dense_defaults.emplace_back(
+        test::graph::Constant(g, Tensor(DT_FLOAT, TensorShape({0}))));
+  }
+  Node* parse;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("parse"), "ParseExampleV2")
+          .Input(test::graph::Constant(g, serialized))
+          .Input(test::graph::Constant(
+              g, Tensor(DT_STRING, TensorShape({batch_size}))))
+          .Input(test::graph::Constant(g, sparse_keys))
+          .Input(test::graph::Constant(g, dense_keys))
+          .Input(test::graph::Constant(g, Tensor(DT_STRING, TensorShape({0}))))
+          .Input(dense_defaults)
+          .Attr("num_sparse", kNumSparseFeatures)
+          .Attr("sparse_types",
+                std::vector<DataType>(kNumSparseFeatures, DT_INT64))
+          .Attr("ragged_value_types", std::vector<DataType>())
+          .Attr("ragged_split_types", std::vector<DataType>())
+          .Attr("dense_shapes",
+                std::vector<PartialTensorShape>(
+                    kNumDenseFeatures, PartialTensorShape({kDenseFeatureSize})))
+          .Finalize(g, &parse));
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_ParseExample)->UseRealTime()->Arg(1)->Arg(128)->Arg(512);
+
+// Returns a smooth RGB image, which compresses like a photo rather than like
+// noise.
+std::vector<uint8> MakeImage(int width, int height) {
+  std::vector<uint8> image(width * height * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8* pixel = &image[(y * width + x) * 3];
+      pixel[0] = x * 255 / width;
+      pixel[1] = y * 255 / height;
+      pixel[2] = (x + y) % 256;
+    }
+  }
+  return image;
+}
+
+void RunDecodeBenchmark(const std::string& op, const tstring& contents,
+                        ::testing::benchmark::State& state) {
+  Tensor contents_t(DT_STRING, TensorShape({}));
+  contents_t.scalar<tstring>()() = contents;
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* decode;
+  TF_CHECK_OK(NodeBuilder(g->NewName("decode"), op)
+                  .Input(test::graph::Constant(g, contents_t))
+                  .Attr("channels", 3)
+                  .Finalize(g, &decode));
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetBytesProcessed(state.iterations() * contents.size());
+}
+
+void BM_DecodeJpeg(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  flags.quality = 90;
+  tstring contents;
+  CHECK(jpeg::Compress(MakeImage(width, height).data(), width, height, flags,
+                       &contents));
+  RunDecodeBenchmark("DecodeJpeg", contents, state);
+}
+BENCHMARK(BM_DecodeJpeg)->UseRealTime()->Args({640, 480})->Args({1920, 1080});
+
+void BM_DecodePng(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  tstring contents;
+  CHECK(png::WriteImageToBuffer(MakeImage(width, height).data(), width, height,
+                                /*row_bytes=*/width * 3, /*num_channels=*/3,
+                                /*channel_bits=*/8, /*compression=*/-1,
+                                &contents, /*metadata=*/nullptr));
+  RunDecodeBenchmark("DecodePng", contents, state);
+}
+BENCHMARK(BM_DecodePng)->UseRealTime()->Args({640, 480});
+
+// Prints the runs to the console, and gathers them into BenchmarkEntries.
+// The repetitions of a benchmark are merged into one entry, with the
+// standard deviations of the wall time per iteration and of the counters as
+// extras, see BenchmarkStddevKey.
+class TestLogReporter : public benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run>& reports) override {
+    benchmark::ConsoleReporter::ReportRuns(reports);
+    for (const Run& run : reports) {
+      if (run.run_type != Run::RT_Iteration || run.error_occurred) continue;
+      const std::string name = run.run_name.str();
+      if (runs_.find(name) == runs_.end()) names_.push_back(name);
+      runs_[name].push_back(run);
+    }
+  }
+
+  BenchmarkEntries GetEntries() const {
+    BenchmarkEntries entries;
+    for (const std::string& name : names_) {
+      const std::vector<Run>& runs = runs_.at(name);
+      BenchmarkEntry* entry = entries.add_entry();
+      entry->set_name(name);
+      std::vector<double> wall_times;
+      std::map<std::string, std::vector<double>> counters;
+      for (const Run& run : runs) {
+        entry->set_iters(entry->iters() + run.iterations);
+        entry->set_wall_time(entry->wall_time() + run.real_accumulated_time);
+        entry->set_cpu_time(entry->cpu_time() + run.cpu_accumulated_time);
+        wall_times.push_back(run.real_accumulated_time / run.iterations);
+        for (const auto& counter : run.counters) {
+          counters[counter.first].push_back(counter.second.value);
+        }
+      }
+      AddStddev(kBenchmarkWallTime, wall_times, entry);
+      for (const auto& counter : counters) {
+        MetricEntry* metric = entry->add_metrics();
+        metric->set_name(counter.first);
+        metric->set_value(Mean(counter.second));
+        AddStddev(counter.first, counter.second, entry);
+      }
+    }
+    return entries;
+  }
+
+ private:
+  static double Mean(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    return sum / values.size();
+  }
+
+  static void AddStddev(const std::string& metric,
+                        const std::vector<double>& values,
+                        BenchmarkEntry* entry) {
+    if (values.size() < 2) return;
+    const double mean = Mean(values);
+    double sum_squares = 0.0;
+    for (double value : values) sum_squares += (value - mean) * (value - mean);
+    (*entry->mutable_extras())[BenchmarkStddevKey(metric)].set_double_value(
+        std::sqrt(sum_squares / (values.size() - 1)));
+  }
+
+  std::vector<std::string> names_;
+  std::map<std::string, std::vector<Run>> runs_;
+};
+
+Status WriteEntries(const std::string& path, const BenchmarkEntries& entries) {
+  if (absl::EndsWith(path, ".pbtxt")) {
+    return WriteTextProto(Env::Default(), path, entries);
+  }
+  return WriteBinaryProto(Env::Default(), path, entries);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  std::string baseline_path;
+  std::string output_path;
+  tensorflow::BenchmarkRegressionOptions options;
+  float min_relative_change = options.min_relative_change;
+  float num_stddevs = options.num_stddevs;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("baseline", &baseline_path,
+                       "BenchmarkEntries to compare the results to, in text "
+                       "or binary format."),
+      tensorflow::Flag("output", &output_path,
+                       "Where to write the results as BenchmarkEntries, in "
+                       "text format if the path ends with .pbtxt."),
+      tensorflow::Flag("min_relative_change", &min_relative_change,
+                       "Increases smaller than this fraction of the baseline "
+                       "are noise."),
+      tensorflow::Flag("num_stddevs", &num_stddevs,
+                       "Increases smaller than this many standard deviations "
+                       "are noise."),
+  };
+  std::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  benchmark::Initialize(&argc, argv);
+  if (!tensorflow::Flags::Parse(&argc, argv, flag_list)) {
+    LOG(ERROR) << usage;
+    return 2;
+  }
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  options.min_relative_change = min_relative_change;
+  options.num_stddevs = num_stddevs;
+
+  tensorflow::TestLogReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  const tensorflow::BenchmarkEntries entries = reporter.GetEntries();
+  if (!output_path.empty()) {
+    TF_CHECK_OK(tensorflow::WriteEntries(output_path, entries));
+  }
+  if (baseline_path.empty()) return 0;
+
+  tensorflow::BenchmarkEntries baseline;
+  TF_CHECK_OK(tensorflow::ReadTextOrBinaryProto(tensorflow::Env::Default(),
+                                                baseline_path, &baseline));
+  const std::vector<tensorflow::BenchmarkRegression> regressions =
+      tensorflow::FindBenchmarkRegressions(baseline, entries, options);
+  for (const tensorflow::BenchmarkRegression& regression : regressions) {
+    fprintf(stderr, "REGRESSION %s\n", regression.DebugString().c_str());
+  }
+  return regressions.empty() ? 0 : 1;
+}
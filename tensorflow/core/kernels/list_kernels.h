@@ -216,6 +216,14 @@ class TensorListStack : public OpKernel {
                     partial_element_shape.DebugString()));
     TensorShape output_shape = element_shape;
     output_shape.InsertDim(0, tensor_list->tensors().size());
+    // The elements of lists made from a tensor may still be stacked in it.
+    Tensor stacked;
+    if (tensor_list->GetStackedElements(0, tensor_list->tensors().size(),
+                                        &stacked) &&
+        stacked.shape() == output_shape) {
+      c->set_output(0, stacked);
+      return;
+    }
     Tensor* output;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() == 0) {
@@ -704,6 +712,26 @@ class TensorListGather : public OpKernel {
                                 partial_element_shape.DebugString()));
     TensorShape output_shape = element_shape;
     output_shape.InsertDim(0, indices.NumElements());
+    // Consecutive elements of lists made from a tensor may still be stacked in
+    // it.
+    if (indices.NumElements() > 0) {
+      const auto indices_flat = indices.flat<int32>();
+      bool consecutive = true;
+      for (int index = 1; consecutive && index < indices.NumElements();
+           ++index) {
+        consecutive = indices_flat(index) == indices_flat(index - 1) + 1;
+      }
+      Tensor gathered;
+      if (consecutive &&
+          tensor_list->GetStackedElements(
+              indices_flat(0),
+              static_cast<int64_t>(indices_flat(0)) + indices.NumElements(),
+              &gathered) &&
+          gathered.shape() == output_shape) {
+        c->set_output(0, gathered);
+        return;
+      }
+    }
     Tensor* output;
     OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
     if (output->NumElements() == 0) {
@@ -789,12 +817,20 @@ class TensorListFromTensor : public OpKernel {
                                  ? &CopyTensorPluggableDevice<T>
                                  : &CopyTensor<Device, T>;
 
+    // The elements are the slices of `t` when they are aligned, which saves
+    // copying them here and lets TensorListStack return `t` itself.
+    bool elements_are_slices = DataTypeCanUseMemcpy(t.dtype());
     for (int i = 0; i < t.shape().dim_size(0); ++i) {
       Tensor tmp = t.Slice(i, i + 1);
       TensorShape tmp_shape = tmp.shape();
       tmp_shape.RemoveDim(0);
       OP_REQUIRES(c, tmp.CopyFrom(tmp, tmp_shape),
                   errors::Unknown("Unexpected shape error."));
+      if (elements_are_slices && tmp.IsAligned()) {
+        output_list.tensors().push_back(tmp);
+        continue;
+      }
+      elements_are_slices = false;
       // TODO(apassos) maybe not always align; but weird compiler bugs seem to
       // prevent this.
       Tensor aligned;
@@ -802,6 +838,7 @@ class TensorListFromTensor : public OpKernel {
       copy_tensor(c, tmp, aligned);
       output_list.tensors().push_back(aligned);
     }
+    if (elements_are_slices) output_list.set_storage(t);
     output_tensor->scalar<Variant>()() = std::move(output_list);
   }
 };
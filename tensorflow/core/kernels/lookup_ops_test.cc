@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -100,5 +101,47 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+TEST_F(LookupOpsTest, ShardedMutableHashTable) {
+  TF_ASSERT_OK(NodeDefBuilder("sharded_table", "ShardedMutableHashTable")
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_INT64)
+                   .Attr("num_shards", 8)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+  const ResourceHandle& handle = GetOutput(0)->scalar<ResourceHandle>()();
+  lookup::LookupInterface* table;
+  TF_ASSERT_OK(device_->resource_manager()->Lookup(handle.container(),
+                                                   handle.name(), &table));
+  core::ScopedUnref unref(table);
+
+  constexpr int64_t kNumKeys = 1000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_INT64, TensorShape({kNumKeys}));
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    keys.flat<int64_t>()(i) = i * 7919;
+    values.flat<int64_t>()(i) = i;
+  }
+  TF_ASSERT_OK(table->Insert(context_.get(), keys, values));
+  EXPECT_EQ(table->size(), kNumKeys);
+
+  // Duplicate keys of a batch keep the last value.
+  Tensor update_keys = test::AsTensor<int64_t>({0, 0, -1});
+  Tensor update_values = test::AsTensor<int64_t>({-5, -6, -7});
+  TF_ASSERT_OK(table->Insert(context_.get(), update_keys, update_values));
+  EXPECT_EQ(table->size(), kNumKeys + 1);
+
+  Tensor remove_keys = test::AsTensor<int64_t>({7919, 42});
+  TF_ASSERT_OK(table->Remove(context_.get(), remove_keys));
+  EXPECT_EQ(table->size(), kNumKeys);
+
+  Tensor find_keys = test::AsTensor<int64_t>({0, 7919, 2 * 7919, -1, 3});
+  Tensor found(DT_INT64, TensorShape({5}));
+  Tensor default_value = test::AsScalar<int64_t>(100);
+  TF_ASSERT_OK(table->Find(context_.get(), find_keys, &found, default_value));
+  test::ExpectTensorEqual<int64_t>(
+      found, test::AsTensor<int64_t>({-6, 100, 2, -7, 100}));
+}
+
 }  // namespace
 }  // namespace tensorflow
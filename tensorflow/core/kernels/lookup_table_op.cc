@@ -16,10 +16,14 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
@@ -27,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -878,6 +883,323 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Lookup table of scalars like MutableHashTableOfScalars, split into
+// `num_shards` independently locked absl::flat_hash_map shards. The swiss
+// tables probe groups of slots at once with SIMD instructions, and the shards
+// let lookups and inserts from different threads proceed in parallel. Each
+// batch of keys is partitioned by shard so that every shard is locked once per
+// batch, and the shards of a large batch are processed by the intra-op thread
+// pool. A shard that grows only blocks its own keys while it rehashes.
+//
+// This table is mutable and thread safe. Only ImportValues, ExportValues and
+// AsGraphDef lock all the shards at once.
+template <class K, class V>
+class ShardedMutableHashTableOfScalars final : public LookupInterface {
+ public:
+  ShardedMutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {
+    int64_t num_shards;
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards >= 1,
+                errors::InvalidArgument("num_shards must be at least 1, got: ",
+                                        num_shards));
+    num_shards_ = num_shards;
+    shards_.reset(new TableShard[num_shards_]);
+  }
+
+  size_t size() const override {
+    size_t size = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      size += shards_[s].table.size();
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const auto default_flat = default_value.flat<V>();
+    const bool is_full_size_default =
+        (value_values.size() == default_flat.size());
+
+    const KeyPartition partition = PartitionKeys(key_values);
+    ForEachShard(ctx, partition, [&](int64_t s, int64_t begin, int64_t end) {
+      const TableShard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64_t j = begin; j < end; ++j) {
+        const int64_t i = partition.indices[j];
+        auto it = shard.table.find(SubtleMustCopyIfIntegral(key_values(i)),
+                                   partition.hashes[i]);
+        if (it != shard.table.end()) {
+          value_values(i) = it->second;
+        } else {
+          value_values(i) =
+              is_full_size_default ? default_flat(i) : default_flat(0);
+        }
+      }
+    });
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    // The partition keeps the order of the keys within a shard, so the last of
+    // duplicate keys wins, as in MutableHashTableOfScalars.
+    const KeyPartition partition = PartitionKeys(key_values);
+    ForEachShard(ctx, partition, [&](int64_t s, int64_t begin, int64_t end) {
+      TableShard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64_t j = begin; j < end; ++j) {
+        const int64_t i = partition.indices[j];
+        shard.table.insert_or_assign(SubtleMustCopyIfIntegral(key_values(i)),
+                                     SubtleMustCopyIfIntegral(value_values(i)));
+      }
+    });
+    return Status::OK();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    const KeyPartition partition = PartitionKeys(key_values);
+    ForEachShard(ctx, partition, [&](int64_t s, int64_t begin, int64_t end) {
+      TableShard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64_t j = begin; j < end; ++j) {
+        shard.table.erase(
+            SubtleMustCopyIfIntegral(key_values(partition.indices[j])));
+      }
+    });
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    AllShardsLock l(this, /*shared=*/false);
+    ImportLocked(key_values, value_values);
+    return Status::OK();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    AllShardsLock l(this, /*shared=*/true);
+    const int64_t size = SizeLocked();
+
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+    ExportKeysAndValuesLocked(keys, values);
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64_t MemoryUsed() const override {
+    int64_t ret = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      // Each slot holds a key and a value, and has a control byte.
+      ret += shards_[s].table.capacity() * (sizeof(std::pair<K, V>) + 1);
+    }
+    return sizeof(ShardedMutableHashTableOfScalars) +
+           num_shards_ * sizeof(TableShard) + ret;
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    AllShardsLock l(this, /*shared=*/true);
+    const int64_t size = SizeLocked();
+    Tensor keys(key_dtype(), TensorShape({size}));
+    Tensor values(value_dtype(), TensorShape({size}));
+    ExportKeysAndValuesLocked(&keys, &values);
+
+    // See MutableHashTableOfScalars::AsGraphDef about the unique node name.
+    Node* table = ops::SourceOp(
+        "ShardedMutableHashTable",
+        builder->opts()
+            .WithName(UniqueNodeName("ShardedMutableHashTableFromGraphDef"))
+            .WithAttr("use_node_name_sharing", true)
+            .WithAttr("key_dtype", key_dtype())
+            .WithAttr("value_dtype", value_dtype())
+            .WithAttr("num_shards", num_shards_));
+    Node* keys_node = ops::SourceOp(
+        "Const",
+        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
+    Node* values_node =
+        ops::SourceOp("Const", builder->opts()
+                                   .WithAttr("dtype", value_dtype())
+                                   .WithAttr("value", values));
+    Node* import_table =
+        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                       builder->opts()
+                           .WithAttr("Tin", key_dtype())
+                           .WithAttr("Tout", value_dtype()));
+    *out = ops::UnaryOp("Identity", table,
+                        builder->opts().WithControlInput(import_table));
+    return Status::OK();
+  }
+
+ private:
+  struct TableShard {
+    mutable mutex mu;
+    absl::flat_hash_map<K, V> table TF_GUARDED_BY(mu);
+  };
+
+  // The keys of a batch grouped by shard: the keys of shard `s` are at
+  // `indices[offsets[s]]` to `indices[offsets[s + 1] - 1]`, in batch order.
+  struct KeyPartition {
+    std::vector<size_t> hashes;
+    std::vector<int64_t> offsets;
+    std::vector<int64_t> indices;
+  };
+
+  // Locks all the shards, in order, for the lifetime of the object.
+  class AllShardsLock {
+   public:
+    AllShardsLock(const ShardedMutableHashTableOfScalars* table, bool shared)
+        TF_NO_THREAD_SAFETY_ANALYSIS : table_(table), shared_(shared) {
+      for (int64_t s = 0; s < table_->num_shards_; ++s) {
+        if (shared_) {
+          table_->shards_[s].mu.lock_shared();
+        } else {
+          table_->shards_[s].mu.lock();
+        }
+      }
+    }
+    ~AllShardsLock() TF_NO_THREAD_SAFETY_ANALYSIS {
+      for (int64_t s = table_->num_shards_ - 1; s >= 0; --s) {
+        if (shared_) {
+          table_->shards_[s].mu.unlock_shared();
+        } else {
+          table_->shards_[s].mu.unlock();
+        }
+      }
+    }
+
+   private:
+    const ShardedMutableHashTableOfScalars* const table_;
+    const bool shared_;
+  };
+
+  // Maps a key hash to a shard. The shard comes from the high bits as the
+  // swiss tables pick slots with the low bits.
+  int64_t ShardIndex(size_t hash) const {
+    const uint64 high_bits = static_cast<uint64>(hash) >> 32;
+    return static_cast<int64_t>(
+        (high_bits * static_cast<uint64>(num_shards_)) >> 32);
+  }
+
+  KeyPartition PartitionKeys(
+      const typename TTypes<K>::ConstFlat& key_values) const {
+    const int64_t num_keys = key_values.size();
+    KeyPartition partition;
+    partition.hashes.resize(num_keys);
+    partition.offsets.assign(num_shards_ + 1, 0);
+    partition.indices.resize(num_keys);
+    std::vector<int64_t> shard_of(num_keys);
+    for (int64_t i = 0; i < num_keys; ++i) {
+      partition.hashes[i] = hasher_(SubtleMustCopyIfIntegral(key_values(i)));
+      shard_of[i] = ShardIndex(partition.hashes[i]);
+      ++partition.offsets[shard_of[i] + 1];
+    }
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      partition.offsets[s + 1] += partition.offsets[s];
+    }
+    std::vector<int64_t> next(partition.offsets.begin(),
+                              partition.offsets.end() - 1);
+    for (int64_t i = 0; i < num_keys; ++i) {
+      partition.indices[next[shard_of[i]]++] = i;
+    }
+    return partition;
+  }
+
+  // Runs `fn(shard, begin, end)` on every shard that has keys in `partition`,
+  // in parallel on the intra-op thread pool when the batch is large enough.
+  void ForEachShard(
+      OpKernelContext* ctx, const KeyPartition& partition,
+      const std::function<void(int64_t, int64_t, int64_t)>& fn) const {
+    auto work = [&partition, &fn](int64_t first, int64_t last) {
+      for (int64_t s = first; s < last; ++s) {
+        const int64_t begin = partition.offsets[s];
+        const int64_t end = partition.offsets[s + 1];
+        if (begin < end) fn(s, begin, end);
+      }
+    };
+    if (ctx == nullptr || num_shards_ == 1) {
+      work(0, num_shards_);
+      return;
+    }
+    const int64_t num_keys = partition.indices.size();
+    const int64_t cost_per_shard = kCostPerKey * num_keys / num_shards_ + 1;
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_shards_,
+          cost_per_shard, work);
+  }
+
+  // Clears the table and inserts `key_values` and `value_values`. All the
+  // shards must be locked exclusively.
+  void ImportLocked(const typename TTypes<K>::ConstFlat& key_values,
+                    const typename TTypes<V>::ConstFlat& value_values)
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      shards_[s].table.clear();
+    }
+    for (int64_t i = 0; i < key_values.size(); ++i) {
+      const K key = SubtleMustCopyIfIntegral(key_values(i));
+      shards_[ShardIndex(hasher_(key))].table.insert_or_assign(
+          key, SubtleMustCopyIfIntegral(value_values(i)));
+    }
+  }
+
+  // Returns the number of entries. All the shards must be locked.
+  int64_t SizeLocked() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    int64_t size = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      size += shards_[s].table.size();
+    }
+    return size;
+  }
+
+  // Writes all keys and values into `keys` and `values`, which must have
+  // `SizeLocked()` elements. All the shards must be locked.
+  void ExportKeysAndValuesLocked(Tensor* keys, Tensor* values) const
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64_t i = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      for (const auto& key_and_value : shards_[s].table) {
+        keys_data(i) = key_and_value.first;
+        values_data(i) = key_and_value.second;
+        ++i;
+      }
+    }
+  }
+
+  // Rough cost in cycles of a hash table operation, used to decide how many
+  // threads a batch is worth.
+  static constexpr int64_t kCostPerKey = 100;
+
+  int64_t num_shards_;
+  typename absl::flat_hash_map<K, V>::hasher hasher_;
+  std::unique_ptr<TableShard[]> shards_;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -1152,6 +1474,34 @@ REGISTER_KERNEL(tstring, int64_t);
 
 #undef REGISTER_KERNEL
 
+// Register the ShardedMutableHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                             \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("ShardedMutableHashTable")                                       \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype"),                      \
+      LookupTableOp<                                                        \
+          lookup::ShardedMutableHashTableOfScalars<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(int64_t, tstring);
+REGISTER_KERNEL(int64_t, Variant);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64_t);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableHashTableOfTensors op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                                \
   REGISTER_KERNEL_BUILDER(                                                     \
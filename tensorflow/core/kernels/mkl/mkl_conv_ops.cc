@@ -129,6 +129,8 @@ class MklConvFwdPrimitive : public MklPrimitive {
                const Tinput* bn_scale_data, const Tinput* bn_mean_data,
                const Tinput* bn_offset_data, const Tinput* bn_rsqrt_data,
                std::shared_ptr<stream> fwd_stream) {
+    // The primitive may be shared by threads, see IsPrimitiveCacheShared.
+    mutex_lock lock(primitive_execution_mu_);
 #ifndef ENABLE_ONEDNN_OPENMP
     // TODO: Create a common function and avoid the duplicate code
     context_.src_mem->set_data_handle(
@@ -419,6 +421,7 @@ class MklConvFwdPrimitive : public MklPrimitive {
   }
 
   struct ConvFwdContext context_;
+  mutex primitive_execution_mu_;
 };
 
 // TODO(nhasabni): We should not require passing a type to MklPrimitiveFactory.
@@ -455,7 +458,8 @@ class MklConvFwdPrimitiveFactory : public MklPrimitiveFactory<float> {
   }
 
  private:
-  MklConvFwdPrimitiveFactory() {}
+  MklConvFwdPrimitiveFactory()
+      : MklPrimitiveFactory<float>(/*shareable=*/true) {}
   ~MklConvFwdPrimitiveFactory() {}
 
   static const int kDilationH = 0, kDilationW = 1;
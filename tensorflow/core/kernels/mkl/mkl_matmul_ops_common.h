@@ -110,6 +110,8 @@ class MklDnnMatMulFwdPrimitive : public MklPrimitive {
   void Execute(const Tinput* src_data, const Tweight* weight_data,
                const Tbias* bias_data, Toutput* dst_data,
                std::shared_ptr<stream> fwd_stream) {
+    // The primitive may be shared by threads, see IsPrimitiveCacheShared.
+    mutex_lock lock(primitive_execution_mu_);
 #ifndef ENABLE_ONEDNN_OPENMP
     context_.src_mem->set_data_handle(
         static_cast<void*>(const_cast<Tinput*>(src_data)), *fwd_stream);
@@ -302,6 +304,7 @@ class MklDnnMatMulFwdPrimitive : public MklPrimitive {
   }
 
   struct MklDnnMatMulFwdContext context_;
+  mutex primitive_execution_mu_;
 };
 
 template <typename T, typename Tinput, typename Tweight, typename Tbias,
@@ -338,7 +341,8 @@ class MklDnnMatMulFwdPrimitiveFactory : public MklPrimitiveFactory<T> {
   }
 
  private:
-  MklDnnMatMulFwdPrimitiveFactory() {}
+  MklDnnMatMulFwdPrimitiveFactory()
+      : MklPrimitiveFactory<T>(/*shareable=*/true) {}
   ~MklDnnMatMulFwdPrimitiveFactory() {}
 
   static MklDnnMatMulFwdPrimitiveFactory& GetInstance() {
@@ -561,6 +565,8 @@ class MklMatMulPrimitive : public MklPrimitive {
 
   void Execute(const T* a_data, const T* b_data, T* c_data,
                std::shared_ptr<stream> stream) {
+    // The primitive may be shared by threads, see IsPrimitiveCacheShared.
+    mutex_lock lock(primitive_execution_mu_);
 #ifndef ENABLE_ONEDNN_OPENMP
     context_.a_mem->set_data_handle(static_cast<void*>(const_cast<T*>(a_data)),
                                     *stream);
@@ -651,6 +657,7 @@ class MklMatMulPrimitive : public MklPrimitive {
   }
 
   struct MklMatMulContext context_;
+  mutex primitive_execution_mu_;
 };
 
 template <typename T>
@@ -678,7 +685,7 @@ class MklMatMulPrimitiveFactory : public MklPrimitiveFactory<T> {
   }
 
  private:
-  MklMatMulPrimitiveFactory() {}
+  MklMatMulPrimitiveFactory() : MklPrimitiveFactory<T>(/*shareable=*/true) {}
   ~MklMatMulPrimitiveFactory() {}
 
   static MklMatMulPrimitiveFactory& GetInstance() {
@@ -22,7 +22,9 @@ limitations under the License.
 
 #include "tensorflow/cc/ops/nn_ops.h"
 
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -1395,6 +1397,70 @@ BM_ImageNetSoftmaxFwd(32, 1008, 1, true, "softmax32");
 BM_ImageNetSoftmaxFwd(128, 1008, 1, true, "softmax128");
 BM_ImageNetSoftmaxFwd(8192, 1024, 1, true, "softmax32");
 BM_ImageNetSoftmaxFwd(8192, 32768, 1, true, "softmax128");
+// Few long rows, like the logits over a large vocabulary.
+BM_ImageNetSoftmaxFwd(1, 32768, 8, false, "softmax_long_rows");
+BM_ImageNetSoftmaxFwd(4, 131072, 8, false, "softmax_long_rows");
+
+class SoftmaxOpTest : public OpsTestBase {
+ protected:
+  // Runs `op` on `logits`, whose rows are long enough to be split into
+  // blocks, and compares the result to a computation in double.
+  void RunLongRows(const string& op, const Tensor& logits) {
+    TF_ASSERT_OK(NodeDefBuilder("softmax", op)
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<float>(logits.shape(), logits.flat<float>());
+    TF_ASSERT_OK(RunOpKernel());
+
+    const bool log = op == "LogSoftmax";
+    const auto in = logits.matrix<float>();
+    Tensor expected(DT_FLOAT, logits.shape());
+    auto out = expected.matrix<float>();
+    for (int64_t row = 0; row < in.dimension(0); ++row) {
+      double max = -std::numeric_limits<double>::infinity();
+      for (int64_t col = 0; col < in.dimension(1); ++col) {
+        max = std::max<double>(max, in(row, col));
+      }
+      double sum = 0;
+      for (int64_t col = 0; col < in.dimension(1); ++col) {
+        sum += std::exp(in(row, col) - max);
+      }
+      for (int64_t col = 0; col < in.dimension(1); ++col) {
+        out(row, col) = log ? in(row, col) - max - std::log(sum)
+                            : std::exp(in(row, col) - max) / sum;
+      }
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+};
+
+TEST_F(SoftmaxOpTest, LongRows) {
+  Tensor logits(DT_FLOAT, TensorShape({2, 20000}));
+  logits.flat<float>().setRandom();
+  logits.flat<float>() = logits.flat<float>() * 10.0f;
+  RunLongRows("Softmax", logits);
+}
+
+TEST_F(SoftmaxOpTest, LogSoftmaxLongRows) {
+  Tensor logits(DT_FLOAT, TensorShape({2, 20000}));
+  logits.flat<float>().setRandom();
+  logits.flat<float>() = logits.flat<float>() * 10.0f;
+  RunLongRows("LogSoftmax", logits);
+}
+
+TEST_F(SoftmaxOpTest, LongRowsWithMaskedBlock) {
+  // The first block of each row is masked out with -inf.
+  Tensor logits(DT_FLOAT, TensorShape({2, 20000}));
+  logits.flat<float>().setRandom();
+  auto matrix = logits.matrix<float>();
+  for (int row = 0; row < 2; ++row) {
+    for (int col = 0; col < 10000; ++col) {
+      matrix(row, col) = -std::numeric_limits<float>::infinity();
+    }
+  }
+  RunLongRows("Softmax", logits);
+}
 
 static void BM_TopK(::testing::benchmark::State& state, int rows, int cols,
                     int k, int num_threads, bool use_gpu, const string& label) {
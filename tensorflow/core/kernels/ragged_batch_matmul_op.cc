@@ -0,0 +1,157 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+using errors::InvalidArgument;
+
+// Multiplies every row of a ragged tensor `a` with shape `[B, (I), J]` by the
+// matrix of its batch in `b`, which has shape `[B, J, K]`, without padding `a`
+// or repeating `b`. `a` is given as its flat values, with shape `[N, J]`, and
+// its row splits, and the output is the `[N, K]` flat values of the result,
+// which has the row splits of `a`.
+template <typename T, typename SPLITS_TYPE>
+class RaggedBatchMatMulOp : public OpKernel {
+ public:
+  explicit RaggedBatchMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a_values_in = context->input(0);
+    const Tensor& a_row_splits_in = context->input(1);
+    const Tensor& b_in = context->input(2);
+
+    OP_REQUIRES(context, a_values_in.dims() == 2,
+                InvalidArgument("a_values must be a matrix, got shape ",
+                                a_values_in.shape().DebugString()));
+    OP_REQUIRES(context, a_row_splits_in.dims() == 1,
+                InvalidArgument("a_row_splits must be a vector, got shape ",
+                                a_row_splits_in.shape().DebugString()));
+    OP_REQUIRES(context, b_in.dims() == 3,
+                InvalidArgument("b must have rank 3, got shape ",
+                                b_in.shape().DebugString()));
+    const int64_t nvals = a_values_in.dim_size(0);
+    const int64_t inner_size = a_values_in.dim_size(1);
+    const int64_t nrows = b_in.dim_size(0);
+    const int64_t b_inner_size = b_in.dim_size(transpose_b_ ? 2 : 1);
+    const int64_t out_cols = b_in.dim_size(transpose_b_ ? 1 : 2);
+    OP_REQUIRES(context, inner_size == b_inner_size,
+                InvalidArgument("Matrix size-incompatible: a_values has ",
+                                inner_size, " columns but b has ",
+                                b_inner_size, " inner rows"));
+    OP_REQUIRES(context, a_row_splits_in.dim_size(0) == nrows + 1,
+                InvalidArgument("a_row_splits must have ", nrows + 1,
+                                " elements to match the batch size of b, got ",
+                                a_row_splits_in.dim_size(0)));
+
+    const auto a_row_splits = a_row_splits_in.vec<SPLITS_TYPE>();
+    OP_REQUIRES(context, a_row_splits(0) == 0,
+                InvalidArgument("a_row_splits must start with 0, got ",
+                                a_row_splits(0)));
+    for (int64_t i = 0; i < nrows; ++i) {
+      OP_REQUIRES(context, a_row_splits(i) <= a_row_splits(i + 1),
+                  InvalidArgument("a_row_splits must be sorted, got ",
+                                  a_row_splits(i), " before ",
+                                  a_row_splits(i + 1)));
+    }
+    OP_REQUIRES(context, a_row_splits(nrows) == nvals,
+                InvalidArgument("a_row_splits must end with the number of "
+                                "rows in a_values (",
+                                nvals, "), got ", a_row_splits(nrows)));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({nvals, out_cols}), &output));
+    if (nvals == 0 || out_cols == 0) return;
+
+    using Matrix =
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using ConstMatrixMap = Eigen::Map<const Matrix>;
+    using MatrixMap = Eigen::Map<Matrix>;
+    const T* a_values = a_values_in.flat<T>().data();
+    const T* b = b_in.flat<T>().data();
+    T* out = output->flat<T>().data();
+    const int64_t b_rows = b_in.dim_size(1);
+    const int64_t b_cols = b_in.dim_size(2);
+    const SPLITS_TYPE* splits_begin = a_row_splits.data();
+    const SPLITS_TYPE* splits_end = splits_begin + nrows + 1;
+
+    // Shards by rows of the values, so that long and short ragged rows are
+    // balanced. Each shard multiplies the values rows it owns in every batch
+    // it overlaps by the matrix of that batch.
+    auto work = [&](int64_t start, int64_t end) {
+      int64_t batch =
+          std::upper_bound(splits_begin, splits_end, start) - splits_begin - 1;
+      while (start < end) {
+        const int64_t batch_end =
+            std::min<int64_t>(end, a_row_splits(batch + 1));
+        if (batch_end > start) {
+          ConstMatrixMap a_block(a_values + start * inner_size,
+                                 batch_end - start, inner_size);
+          ConstMatrixMap b_matrix(b + batch * b_rows * b_cols, b_rows, b_cols);
+          MatrixMap out_block(out + start * out_cols, batch_end - start,
+                              out_cols);
+          if (transpose_b_) {
+            out_block.noalias() = a_block * b_matrix.transpose();
+          } else {
+            out_block.noalias() = a_block * b_matrix;
+          }
+          start = batch_end;
+        }
+        ++batch;
+      }
+    };
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, nvals,
+          /*cost_per_unit=*/std::max<int64_t>(1, inner_size * out_cols * 2),
+          work);
+  }
+
+ private:
+  bool transpose_b_;
+};
+
+#define REGISTER_CPU_KERNEL(TYPE)                                  \
+  REGISTER_KERNEL_BUILDER(Name("RaggedBatchMatMul")                \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<TYPE>("T")           \
+                              .TypeConstraint<int32>("Tsplits"),   \
+                          RaggedBatchMatMulOp<TYPE, int32>);       \
+  REGISTER_KERNEL_BUILDER(Name("RaggedBatchMatMul")                \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<TYPE>("T")           \
+                              .TypeConstraint<int64_t>("Tsplits"), \
+                          RaggedBatchMatMulOp<TYPE, int64>);
+TF_CALL_bfloat16(REGISTER_CPU_KERNEL);
+TF_CALL_half(REGISTER_CPU_KERNEL);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+TF_CALL_complex64(REGISTER_CPU_KERNEL);
+TF_CALL_complex128(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class RaggedBatchMatMulOpTest : public ::tensorflow::OpsTestBase {
+ protected:
+  // Builds the tensorflow test graph for the RaggedBatchMatMul op.
+  void BuildRaggedBatchMatMulGraph(bool transpose_b) {
+    TF_ASSERT_OK(NodeDefBuilder("tested_op", "RaggedBatchMatMul")
+                     .Input(FakeInput(DT_FLOAT))  // a_values
+                     .Input(FakeInput(DT_INT64))  // a_row_splits
+                     .Input(FakeInput(DT_FLOAT))  // b
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(RaggedBatchMatMulOpTest, Simple) {
+  BuildRaggedBatchMatMulGraph(/*transpose_b=*/false);
+  // a = [[[1, 2]], [], [[1, 0], [0, 1], [1, 1]]]
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 1, 0, 0, 1, 1, 1});
+  AddInputFromArray<int64_t>(TensorShape({4}), {0, 1, 1, 4});
+  AddInputFromArray<float>(TensorShape({3, 2, 2}),
+                           {1, 2, 3, 4, 0, 0, 0, 0, 5, 6, 7, 8});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Expected: [[[7, 10]], [], [[5, 6], [7, 8], [12, 14]]]
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0),
+      test::AsTensor<float>({7, 10, 5, 6, 7, 8, 12, 14}, TensorShape({4, 2})));
+}
+
+TEST_F(RaggedBatchMatMulOpTest, TransposeB) {
+  BuildRaggedBatchMatMulGraph(/*transpose_b=*/true);
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 1, 0, 0, 1, 1, 1});
+  AddInputFromArray<int64_t>(TensorShape({4}), {0, 1, 1, 4});
+  AddInputFromArray<float>(TensorShape({3, 2, 2}),
+                           {1, 3, 2, 4, 0, 0, 0, 0, 5, 7, 6, 8});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0),
+      test::AsTensor<float>({7, 10, 5, 6, 7, 8, 12, 14}, TensorShape({4, 2})));
+}
+
+TEST_F(RaggedBatchMatMulOpTest, InvalidRowSplits) {
+  BuildRaggedBatchMatMulGraph(/*transpose_b=*/false);
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 1, 0, 0, 1, 1, 1});
+  AddInputFromArray<int64_t>(TensorShape({4}), {0, 3, 1, 4});
+  AddInputFromArray<float>(TensorShape({3, 2, 2}),
+                           {1, 2, 3, 4, 0, 0, 0, 0, 5, 6, 7, 8});
+  EXPECT_EQ("a_row_splits must be sorted, got 3 before 1",
+            RunOpKernel().error_message());
+}
+
+TEST_F(RaggedBatchMatMulOpTest, RowSplitsMismatch) {
+  BuildRaggedBatchMatMulGraph(/*transpose_b=*/false);
+  AddInputFromArray<float>(TensorShape({4, 2}), {1, 2, 1, 0, 0, 1, 1, 1});
+  AddInputFromArray<int64_t>(TensorShape({4}), {0, 1, 1, 3});
+  AddInputFromArray<float>(TensorShape({3, 2, 2}),
+                           {1, 2, 3, 4, 0, 0, 0, 0, 5, 6, 7, 8});
+  EXPECT_EQ(
+      "a_row_splits must end with the number of rows in a_values (4), got 3",
+      RunOpKernel().error_message());
+}
+
+TEST_F(RaggedBatchMatMulOpTest, ShapeFn) {
+  ShapeInferenceTestOp op("RaggedBatchMatMul");
+  TF_ASSERT_OK(NodeDefBuilder("test", "RaggedBatchMatMul")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("transpose_b", false)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[?,2];[4];[3,2,5]", "[d0_0,d2_2]");
+  INFER_OK(op, "?;?;?", "[?,?]");
+  INFER_ERROR("Dimensions must be equal", op, "[?,2];?;[3,4,5]");
+  INFER_ERROR("Dimensions must be equal", op, "[?,2];[3];[3,2,5]");
+
+  TF_ASSERT_OK(NodeDefBuilder("test", "RaggedBatchMatMul")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("transpose_b", true)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[?,2];[4];[3,5,2]", "[d0_0,d2_1]");
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -72,6 +73,26 @@ struct FillPhiloxRandom {
   }
 };
 
+// Draws the samples of a distribution from a PhiloxRandom. Distributions
+// without state that take a PhiloxRandom are rebound to take a
+// BatchedPhiloxRandom instead, which returns the same stream faster.
+template <class Distribution, typename Enable = void>
+struct BatchedDistribution {
+  typedef random::PhiloxRandom Generator;
+  static Distribution Rebind(const Distribution& dist) { return dist; }
+};
+
+template <template <class, typename> class D, typename T>
+struct BatchedDistribution<
+    D<random::PhiloxRandom, T>,
+    typename std::enable_if<std::is_empty<D<random::PhiloxRandom, T>>::value>::
+        type> {
+  typedef random::BatchedPhiloxRandom Generator;
+  static D<Generator, T> Rebind(const D<random::PhiloxRandom, T>&) {
+    return D<Generator, T>();
+  }
+};
+
 // A class to fill a specified range of random groups
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
@@ -81,11 +102,15 @@ struct FillPhiloxRandomTask;
 template <class Distribution>
 struct FillPhiloxRandomTask<Distribution, false> {
   typedef typename Distribution::ResultElementType T;
-  static void Run(random::PhiloxRandom gen, T* data, int64_t size,
-                  int64_t start_group, int64_t limit_group, Distribution dist) {
+  static void Run(random::PhiloxRandom philox, T* data, int64_t size,
+                  int64_t start_group, int64_t limit_group,
+                  Distribution philox_dist) {
     const int kGroupSize = Distribution::kResultElementCount;
 
-    gen.Skip(start_group);
+    philox.Skip(start_group);
+    typedef BatchedDistribution<Distribution> Batched;
+    typename Batched::Generator gen(philox);
+    auto dist = Batched::Rebind(philox_dist);
     int64_t offset = start_group * kGroupSize;
 
     // First fill all the full-size groups
@@ -16,7 +16,13 @@ limitations under the License.
 #include <random>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/platform/test.h"
@@ -116,6 +122,21 @@ void BM_PhiloxRandom(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_PhiloxRandom);
 
+void BM_BatchedPhiloxRandom(::testing::benchmark::State& state) {
+  // Fill 2M random numbers
+  int count = 2 << 20;
+  random::BatchedPhiloxRandom gen(random::PhiloxRandom(0x12345));
+
+  for (auto s : state) {
+    for (int j = 0; j < count; j += 4) {
+      auto samples = gen();
+      tensorflow::testing::DoNotOptimize(samples);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * count);
+}
+BENCHMARK(BM_BatchedPhiloxRandom);
+
 void BM_StdMTRandom(::testing::benchmark::State& state) {
   // Fill 2M random numbers
   int count = 2 << 20;
@@ -132,5 +153,101 @@ void BM_StdMTRandom(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_StdMTRandom);
 
+Tensor Seed() { return test::AsTensor<int64_t>({17, 29}); }
+
+// Dropout of n floats, either with StatelessDropout or with the unfused
+// computation from StatelessRandomUniform.
+Graph* Dropout(int64_t n, bool fused) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x(DT_FLOAT, TensorShape({n}));
+  x.flat<float>().setConstant(1.0f);
+  Node* x_node = test::graph::Constant(g, x);
+  Node* rate = test::graph::Constant(g, test::AsScalar<float>(0.25f));
+  Node* seed = test::graph::Constant(g, Seed());
+  Node* ret;
+  if (fused) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "StatelessDropout")
+                    .Input(x_node)
+                    .Input(rate)
+                    .Input(seed)
+                    .Finalize(g, &ret));
+    return g;
+  }
+  Node* uniform;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "StatelessRandomUniform")
+                  .Input(test::graph::Constant(g, VecShape(n)))
+                  .Input(seed)
+                  .Attr("dtype", DT_FLOAT)
+                  .Finalize(g, &uniform));
+  Node* keep = test::graph::Binary(g, "GreaterEqual", uniform, rate);
+  Node* mask = test::graph::Cast(g, keep, DT_FLOAT);
+  Node* scaled = test::graph::Multi(
+      g, "Mul", {x_node, test::graph::Constant(g, test::AsScalar(4.0f / 3))});
+  test::graph::Multi(g, "Mul", {scaled, mask});
+  return g;
+}
+
+void BM_cpu_Dropout(::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  const bool fused = state.range(1);
+  test::Benchmark("cpu", Dropout(n, fused), /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+}
+BENCHMARK(BM_cpu_Dropout)->ArgPair(1 << 20, 0)->ArgPair(1 << 20, 1);
+
+class StatelessDropoutOpTest : public OpsTestBase {};
+
+TEST_F(StatelessDropoutOpTest, MatchesStatelessRandomUniform) {
+  // Not a multiple of the group size, nor of the shards.
+  const int64_t n = 100003;
+  const float rate = 0.3f;
+  TF_ASSERT_OK(NodeDefBuilder("uniform", "StatelessRandomUniform")
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT64))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<int32>(TensorShape({1}), {static_cast<int32>(n)});
+  AddInputFromArray<int64_t>(TensorShape({2}), {17, 29});
+  TF_ASSERT_OK(RunOpKernel());
+  const Tensor uniform = *GetOutput(0);
+
+  Tensor x(DT_FLOAT, TensorShape({n}));
+  x.flat<float>().setRandom();
+  const float scale = 1.0f / (1.0f - rate);
+  Tensor expected(DT_FLOAT, TensorShape({n}));
+  for (int64_t i = 0; i < n; ++i) {
+    expected.flat<float>()(i) =
+        uniform.flat<float>()(i) >= rate ? x.flat<float>()(i) * scale : 0.0f;
+  }
+
+  inputs_.clear();
+  TF_ASSERT_OK(NodeDefBuilder("dropout", "StatelessDropout")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(x.shape(), x.flat<float>());
+  AddInputFromArray<float>(TensorShape({}), {rate});
+  AddInputFromArray<int64_t>(TensorShape({2}), {17, 29});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(StatelessDropoutOpTest, InvalidRate) {
+  TF_ASSERT_OK(NodeDefBuilder("dropout", "StatelessDropout")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({}), {1.0f});
+  AddInputFromArray<int64_t>(TensorShape({2}), {17, 29});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -126,6 +127,93 @@ class ReductionHelper {
   gtl::InlinedVector<int64_t, 4> out_reshape_;  // Reshape output for reduction.
 };
 
+namespace functor {
+
+// True iff reducing the results of a Reducer over the blocks of a row with
+// the same Reducer gives its result over the whole row.
+template <typename Reducer>
+struct ReducesPartials : std::false_type {};
+template <typename T>
+struct ReducesPartials<Eigen::internal::SumReducer<T>> : std::true_type {};
+template <typename T>
+struct ReducesPartials<Eigen::internal::ProdReducer<T>> : std::true_type {};
+template <typename T, int NaNPropagation>
+struct ReducesPartials<Eigen::internal::MaxReducer<T, NaNPropagation>>
+    : std::true_type {};
+template <typename T, int NaNPropagation>
+struct ReducesPartials<Eigen::internal::MinReducer<T, NaNPropagation>>
+    : std::true_type {};
+template <>
+struct ReducesPartials<Eigen::internal::AndReducer> : std::true_type {};
+template <>
+struct ReducesPartials<Eigen::internal::OrReducer> : std::true_type {};
+
+// Reduces the rows of a matrix, when they are too few and too long for the
+// Eigen reduction to use all the threads: Eigen splits the rows between the
+// threads, so a single row is reduced by a single thread. Returns false if
+// the reduction is left to Eigen.
+template <typename Device, typename T, typename Reducer, typename Enable = void>
+struct LongRowReducer {
+  static bool Reduce(OpKernelContext* ctx,
+                     typename TTypes<T>::ConstMatrix in,
+                     typename TTypes<T>::Vec out, const Reducer& reducer) {
+    return false;
+  }
+};
+
+// The CPU implementation splits each row into blocks, that are reduced in
+// parallel into a matrix of partial results, which is then reduced. The
+// blocks have the same size whatever the number of threads, so that the
+// results are deterministic. The bfloat16 and half reductions accumulate in
+// float, which partial results would round, so they are left to Eigen.
+template <typename T, typename Reducer>
+struct LongRowReducer<
+    CPUDevice, T, Reducer,
+    typename std::enable_if<ReducesPartials<Reducer>::value &&
+                            !std::is_same<T, bfloat16>::value &&
+                            !std::is_same<T, Eigen::half>::value>::type> {
+  static constexpr int64_t kBlockSize = 8192;
+
+  static bool Reduce(OpKernelContext* ctx,
+                     typename TTypes<T>::ConstMatrix in,
+                     typename TTypes<T>::Vec out, const Reducer& reducer) {
+    const int64_t num_rows = in.dimension(0);
+    const int64_t num_cols = in.dimension(1);
+    const int64_t num_blocks = Eigen::divup(num_cols, kBlockSize);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    if (num_blocks < 2 || num_rows >= worker_threads.num_threads) {
+      return false;
+    }
+    Tensor partials;
+    if (!ctx->allocate_temp(DataTypeToEnum<T>::value,
+                            TensorShape({num_rows, num_blocks}), &partials)
+             .ok()) {
+      return false;
+    }
+    auto partials_matrix = partials.matrix<T>();
+    const Eigen::array<Eigen::Index, 1> along_block = {0};
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_blocks, kBlockSize,
+          [&](int64_t start, int64_t limit) {
+            for (int64_t i = start; i < limit; ++i) {
+              const int64_t row = i / num_blocks;
+              const int64_t block = i % num_blocks;
+              const int64_t begin = block * kBlockSize;
+              typename TTypes<T>::ConstVec block_values(
+                  &in(row, begin), std::min(kBlockSize, num_cols - begin));
+              typename TTypes<T>::Scalar partial(&partials_matrix(row, block));
+              partial = block_values.reduce(along_block, reducer);
+            }
+          });
+    const Eigen::array<Eigen::Index, 1> along_row = {1};
+    out = partials_matrix.reduce(along_row, reducer);
+    return true;
+  }
+};
+
+}  // namespace functor
+
 // For operations where the output is a reduction function along some
 // dimensions of the input.
 template <typename Device, class T, typename Tperm, typename Reducer>
@@ -205,8 +293,12 @@ class ReductionOp : public OpKernel {
                         constants.kZero, reducer);
       } else if ((helper.ndims() == 2) && !helper.reduce_first_axis()) {
         // Can be viewed as a reduction of a matrix along 2nd dimension.
-        Functor::Reduce(ctx, helper.out<T, 1>(&tmp_out), helper.in<T, 2>(data),
-                        constants.kOne, reducer);
+        if (!functor::LongRowReducer<Device, T, Reducer>::Reduce(
+                ctx, helper.in<T, 2>(data), helper.out<T, 1>(&tmp_out),
+                reducer)) {
+          Functor::Reduce(ctx, helper.out<T, 1>(&tmp_out),
+                          helper.in<T, 2>(data), constants.kOne, reducer);
+        }
       } else if ((helper.ndims() == 3) && helper.reduce_first_axis()) {
         // Can be viewed as a reduction of a 3D tensor along 1st and 3rd
         // dimensions.
@@ -231,9 +323,13 @@ class ReductionOp : public OpKernel {
         const int64_t unreduced = tmp_out.NumElements();
         const int64_t reduced = shuffled.NumElements() / unreduced;
         const Tensor& const_shuffled = shuffled;
-        Functor::Reduce(ctx, tmp_out.flat<T>(),
-                        const_shuffled.shaped<T, 2>({unreduced, reduced}),
-                        constants.kOne, reducer);
+        if (!functor::LongRowReducer<Device, T, Reducer>::Reduce(
+                ctx, const_shuffled.shaped<T, 2>({unreduced, reduced}),
+                tmp_out.flat<T>(), reducer)) {
+          Functor::Reduce(ctx, tmp_out.flat<T>(),
+                          const_shuffled.shaped<T, 2>({unreduced, reduced}),
+                          constants.kOne, reducer);
+        }
       }
     }
 
@@ -14,8 +14,13 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -168,6 +173,18 @@ static void BM_Sum2DToScalarGPUHalf(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_Sum2DToScalarGPUHalf)->RangePair(1, 8192, 1, 8192);
 
+// A few long rows, which are reduced in blocks on CPU.
+static void BM_Sum2DLongRowReduceCPU(::testing::benchmark::State& state) {
+  const int num_x = state.range(0);
+  const int num_y = state.range(1);
+
+  DoRowReduce(state, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum2DLongRowReduceCPU)
+    ->UseRealTime()
+    ->ArgPair(1, 1 << 20)
+    ->ArgPair(4, 1 << 18);
+
 static void BM_Sum2DRowReduceGPU(::testing::benchmark::State& state) {
   const int num_x = state.range(0);
   const int num_y = state.range(1);
@@ -247,5 +264,62 @@ static void BM_Bool2DToScalarGPU(::testing::benchmark::State& state) {
   ReduceToScalar<bool>(state, "gpu", "All", num_x, num_y);
 }
 BENCHMARK(BM_Bool2DToScalarGPU)->RangePair(2048, 8192, 2048, 8192);
+class LongRowReductionTest : public OpsTestBase {
+ protected:
+  // Reduces the rows of `data` with `op`.
+  template <typename T>
+  void Reduce(const string& op, const Tensor& data) {
+    TF_ASSERT_OK(NodeDefBuilder("reduce", op)
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<T>(data.shape(), data.flat<T>());
+    AddInputFromArray<int32>(TensorShape({}), {1});
+    TF_ASSERT_OK(RunOpKernel());
+  }
+};
+
+TEST_F(LongRowReductionTest, Sum) {
+  // Small integers, whose sums are exact in any order.
+  Tensor data(DT_FLOAT, TensorShape({3, 20001}));
+  auto matrix = data.matrix<float>();
+  Tensor expected(DT_FLOAT, TensorShape({3}));
+  for (int row = 0; row < 3; ++row) {
+    float sum = 0;
+    for (int col = 0; col < 20001; ++col) {
+      matrix(row, col) = (row + col) % 7 - 3;
+      sum += matrix(row, col);
+    }
+    expected.vec<float>()(row) = sum;
+  }
+  Reduce<float>("Sum", data);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(LongRowReductionTest, Max) {
+  Tensor data(DT_INT64, TensorShape({2, 30000}));
+  auto matrix = data.matrix<int64_t>();
+  Tensor expected(DT_INT64, TensorShape({2}));
+  for (int row = 0; row < 2; ++row) {
+    int64_t max = 0;
+    for (int col = 0; col < 30000; ++col) {
+      matrix(row, col) = (col * 7919 + row) % 30011;
+      max = std::max(max, matrix(row, col));
+    }
+    expected.vec<int64_t>()(row) = max;
+  }
+  Reduce<int64_t>("Max", data);
+  test::ExpectTensorEqual<int64_t>(expected, *GetOutput(0));
+}
+
+TEST_F(LongRowReductionTest, Mean) {
+  // Mean isn't reduced in blocks, but must still be right.
+  Tensor data(DT_FLOAT, TensorShape({2, 20000}));
+  data.flat<float>().setConstant(2.0f);
+  Reduce<float>("Mean", data);
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({2.0f, 2.0f}, TensorShape({2})), *GetOutput(0));
+}
 
 }  // end namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "re2/re2.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/regex_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -52,9 +53,9 @@ class RegexFullMatchOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
                                              &output_tensor));
     auto output_flat = output_tensor->flat<bool>();
-    for (size_t i = 0; i < input_flat.size(); ++i) {
+    ForEachString(ctx, input_flat, [&](int64_t i) {
       output_flat(i) = RE2::FullMatch(input_flat(i), *regex);
-    }
+    });
   }
 
  private:
@@ -65,8 +66,8 @@ class RegexFullMatchOp : public OpKernel {
         return regex_;
       }
     }
-    // Construct the new RE2 object before acquiring the lock.
-    auto regex = std::make_shared<RE2>(pattern);
+    // Look the new RE2 object up before acquiring the lock.
+    auto regex = RegexCache::Global()->Lookup(pattern);
     {
       mutex_lock l(mu_);
       // Swap instead of assigning so that we destruct the old
@@ -105,9 +106,9 @@ class StaticRegexFullMatchOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
                                              &output_tensor));
     auto output_flat = output_tensor->flat<bool>();
-    for (size_t i = 0; i < input_flat.size(); ++i) {
+    ForEachString(ctx, input_flat, [&](int64_t i) {
       output_flat(i) = RE2::FullMatch(input_flat(i), *re_);
-    }
+    });
   }
 
  private:
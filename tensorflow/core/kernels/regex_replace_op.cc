@@ -13,11 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "re2/re2.h"
+#include "re2/set.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/regex_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -27,12 +32,13 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-// Execute the specified regex using the given context.
+// Apply `replace` to each string of the input in the given context, in
+// parallel.
 // Context requirements:
 //  - "input" string Tensor at input_index=0
 //  - "output" string Tensor at output_index=0
-Status InternalCompute(const RE2& regex, const string& rewrite,
-                       const bool replace_global, OpKernelContext* ctx) {
+Status InternalCompute(const std::function<void(string*)>& replace,
+                       OpKernelContext* ctx) {
   const Tensor* input_tensor;
   TF_RETURN_IF_ERROR(ctx->input("input", &input_tensor));
   Tensor* output_tensor;
@@ -49,19 +55,30 @@ Status InternalCompute(const RE2& regex, const string& rewrite,
     output_tensor->flat<tstring>() = input_tensor->flat<tstring>();
   }
   auto output_flat = output_tensor->flat<tstring>();
-  for (size_t i = 0; i < output_flat.size(); ++i) {
-    // TODO(dero): Mitigate copy; Global and GlobalReplace below currently only
-    // accept std::string.
-    string buf = output_flat(i);
-    if (replace_global) {
-      RE2::GlobalReplace(&buf, regex, rewrite);
-    } else {
-      RE2::Replace(&buf, regex, rewrite);
-    }
-    output_flat(i) = std::move(buf);
-  }
+  ForEachString(ctx, input_tensor->flat<tstring>(),
+                [&output_flat, &replace](int64_t i) {
+                  // TODO(dero): Mitigate copy; Global and GlobalReplace
+                  // currently only accept std::string.
+                  string buf = output_flat(i);
+                  replace(&buf);
+                  output_flat(i) = std::move(buf);
+                });
   return Status::OK();
 }
+
+// Execute the specified regex using the given context.
+Status InternalCompute(const RE2& regex, const string& rewrite,
+                       const bool replace_global, OpKernelContext* ctx) {
+  return InternalCompute(
+      [&regex, &rewrite, replace_global](string* buf) {
+        if (replace_global) {
+          RE2::GlobalReplace(buf, regex, rewrite);
+        } else {
+          RE2::Replace(buf, regex, rewrite);
+        }
+      },
+      ctx);
+}
 }  // namespace
 
 class RegexReplaceOp : public OpKernel {
@@ -101,8 +118,8 @@ class RegexReplaceOp : public OpKernel {
         return regex_;
       }
     }
-    // Construct the new RE2 object before acquiring the lock.
-    auto regex = std::make_shared<RE2>(pattern);
+    // Look the new RE2 object up before acquiring the lock.
+    auto regex = RegexCache::Global()->Lookup(pattern);
     {
       mutex_lock l(mu_);
       // Swap instead of assigning so that we destruct the old
@@ -149,4 +166,88 @@ class StaticRegexReplaceOp : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("StaticRegexReplace").Device(DEVICE_CPU),
                         StaticRegexReplaceOp);
 
+// Applies a sequence of replacements to each string, equivalent to a chain of
+// StaticRegexReplace ops. An RE2::Set of all the patterns finds the patterns
+// that match in one pass over the string, so that the patterns that don't
+// match are skipped. The set is matched again only after a replacement
+// changes the string, since it may create or remove matches of the later
+// patterns.
+class StaticRegexReplaceSequenceOp : public OpKernel {
+ public:
+  explicit StaticRegexReplaceSequenceOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), set_(RE2::Options(), RE2::UNANCHORED) {
+    std::vector<string> patterns;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("patterns", &patterns));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("rewrites", &rewrites_));
+    OP_REQUIRES(ctx, patterns.size() == rewrites_.size(),
+                errors::InvalidArgument(
+                    "There must be as many rewrites as patterns, but got ",
+                    rewrites_.size(), " rewrites for ", patterns.size(),
+                    " patterns"));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("replace_global", &replace_global_));
+    for (const string& pattern : patterns) {
+      res_.push_back(MakeUnique<RE2>(pattern));
+      OP_REQUIRES(ctx, res_.back()->ok(),
+                  errors::InvalidArgument("Invalid pattern: ", pattern,
+                                          ", error: ", res_.back()->error()));
+      string error;
+      OP_REQUIRES(ctx, set_.Add(pattern, &error) >= 0,
+                  errors::InvalidArgument("Invalid pattern: ", pattern,
+                                          ", error: ", error));
+    }
+    OP_REQUIRES(ctx, set_.Compile(),
+                errors::ResourceExhausted(
+                    "Out of memory compiling the set of patterns"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, InternalCompute(
+                            [this](string* buf) { ReplaceAll(buf); }, ctx));
+  }
+
+ private:
+  // Returns true iff the replacement changed `*buf`.
+  bool ReplaceOne(int i, string* buf) const {
+    if (replace_global_) {
+      return RE2::GlobalReplace(buf, *res_[i], rewrites_[i]) > 0;
+    }
+    return RE2::Replace(buf, *res_[i], rewrites_[i]);
+  }
+
+  void ReplaceAll(string* buf) const {
+    const int num_patterns = res_.size();
+    std::vector<int> matches;
+    int next = 0;
+    while (next < num_patterns) {
+      matches.clear();
+      RE2::Set::ErrorInfo error_info;
+      if (!set_.Match(*buf, &matches, &error_info) &&
+          error_info.kind != RE2::Set::kNoError) {
+        // The set ran out of memory, so apply the remaining patterns one by
+        // one.
+        for (; next < num_patterns; ++next) ReplaceOne(next, buf);
+        return;
+      }
+      std::sort(matches.begin(), matches.end());
+      auto it = std::lower_bound(matches.begin(), matches.end(), next);
+      next = num_patterns;
+      for (; it != matches.end(); ++it) {
+        if (ReplaceOne(*it, buf)) {
+          next = *it + 1;
+          break;
+        }
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<RE2>> res_;
+  RE2::Set set_;
+  std::vector<string> rewrites_;
+  bool replace_global_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("StaticRegexReplaceSequence").Device(DEVICE_CPU),
+    StaticRegexReplaceSequenceOp);
+
 }  // namespace tensorflow
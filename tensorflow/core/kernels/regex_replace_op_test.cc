@@ -25,7 +25,9 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -134,4 +136,111 @@ BENCHMARK(BM_StaticRegexReplace)
     ->Arg(128)
     ->Arg(256);
 
+class StaticRegexReplaceSequenceOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const std::vector<string>& patterns,
+              const std::vector<string>& rewrites, bool replace_global) {
+    TF_ASSERT_OK(
+        NodeDefBuilder("static_regex_replace_sequence_op",
+                       "StaticRegexReplaceSequence")
+            .Input(FakeInput(DT_STRING))
+            .Attr("patterns", patterns)
+            .Attr("rewrites", rewrites)
+            .Attr("replace_global", replace_global)
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(StaticRegexReplaceSequenceOpTest, AppliesPatternsInOrder) {
+  // The second pattern matches the output of the first one only, and the
+  // third one matches nothing.
+  MakeOp({"a+", "bb", "z"}, {"bb", "c", "y"}, /*replace_global=*/true);
+  AddInputFromArray<tstring>(TensorShape({4}),
+                             {"aaxa", "xyz", "", "bbbb"});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_STRING, TensorShape({4}));
+  test::FillValues<tstring>(&expected, {"cxc", "xyy", "", "cc"});
+  test::ExpectTensorEqual<tstring>(expected, *GetOutput(0));
+}
+
+TEST_F(StaticRegexReplaceSequenceOpTest, ReplacesFirstMatchOnly) {
+  MakeOp({"a", "b"}, {"b", "c"}, /*replace_global=*/false);
+  AddInputFromArray<tstring>(TensorShape({2}), {"aa", "bab"});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_STRING, TensorShape({2}));
+  test::FillValues<tstring>(&expected, {"ca", "cbb"});
+  test::ExpectTensorEqual<tstring>(expected, *GetOutput(0));
+}
+
+TEST_F(StaticRegexReplaceSequenceOpTest, InvalidPattern) {
+  TF_ASSERT_OK(NodeDefBuilder("static_regex_replace_sequence_op",
+                              "StaticRegexReplaceSequence")
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("patterns", {"a", "("})
+                   .Attr("rewrites", {"b", "c"})
+                   .Finalize(node_def()));
+  EXPECT_TRUE(errors::IsInvalidArgument(InitOp()));
+}
+
+TEST_F(StaticRegexReplaceSequenceOpTest, MismatchedRewrites) {
+  TF_ASSERT_OK(NodeDefBuilder("static_regex_replace_sequence_op",
+                              "StaticRegexReplaceSequence")
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("patterns", {"a", "b"})
+                   .Attr("rewrites", {"c"})
+                   .Finalize(node_def()));
+  EXPECT_TRUE(errors::IsInvalidArgument(InitOp()));
+}
+
+// A text normalization chain, most of whose patterns don't match most lines.
+const std::vector<string>& NormalizationPatterns() {
+  static const auto* patterns = new std::vector<string>{
+      "\\p{P}", "\\s+", "https?://\\S+", "[0-9]+", "\\bTensorFlow\\b",
+      "\\bGPU\\b", "\\bCPU\\b", "&amp;", "&lt;", "&gt;",
+      "\\bC\\+\\+", "[A-Z]{4,}", "_{2,}", "\\(\\)", "^ | $"};
+  return *patterns;
+}
+
+// Applies the normalization chain with one StaticRegexReplace per pattern
+// (0), or with a StaticRegexReplaceSequence (1).
+static void BM_RegexReplaceChain(::testing::benchmark::State& state) {
+  const int batch_size = state.range(0);
+  const bool fused = state.range(1);
+  const std::vector<string>& patterns = NormalizationPatterns();
+  const std::vector<string> rewrites(patterns.size(), " ");
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node = test::graph::Constant(g, GetTestTensor(batch_size));
+  if (fused) {
+    TF_CHECK_OK(
+        NodeBuilder("regex_replace_sequence", "StaticRegexReplaceSequence")
+            .Input(node)
+            .Attr("patterns", patterns)
+            .Attr("rewrites", rewrites)
+            .Finalize(g, &node));
+  } else {
+    for (int i = 0; i < patterns.size(); ++i) {
+      TF_CHECK_OK(NodeBuilder(strings::StrCat("regex_replace_", i),
+                              "StaticRegexReplace")
+                      .Input(node)
+                      .Attr("pattern", patterns[i])
+                      .Attr("rewrite", rewrites[i])
+                      .Finalize(g, &node));
+    }
+  }
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          batch_size);
+}
+
+BENCHMARK(BM_RegexReplaceChain)
+    ->UseRealTime()
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
 }  // end namespace tensorflow
@@ -0,0 +1,83 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/regex_util.h"
+
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+RegexCache* RegexCache::Global() {
+  static RegexCache* cache = new RegexCache();
+  return cache;
+}
+
+std::shared_ptr<RE2> RegexCache::Lookup(const std::string& pattern) {
+  {
+    mutex_lock l(mu_);
+    auto it = index_.find(pattern);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+  }
+  // Compile the pattern without holding the lock, which is what the cache
+  // saves on a hit.
+  auto regex = std::make_shared<RE2>(pattern);
+  std::shared_ptr<RE2> evicted;
+  mutex_lock l(mu_);
+  auto it = index_.find(pattern);
+  if (it != index_.end()) {
+    // Another thread compiled the pattern in the meantime.
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+  entries_.emplace_front(pattern, regex);
+  index_[pattern] = entries_.begin();
+  if (entries_.size() > static_cast<size_t>(capacity_)) {
+    // Kernels may still hold references to the evicted regex. Otherwise it
+    // is destroyed after the lock is released.
+    evicted = std::move(entries_.back().second);
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return regex;
+}
+
+void ForEachString(OpKernelContext* ctx, TTypes<tstring>::ConstFlat strings,
+                   const std::function<void(int64_t i)>& fn) {
+  const int64_t size = strings.size();
+  if (size == 0) return;
+  int64_t total_bytes = 0;
+  for (int64_t i = 0; i < size; ++i) {
+    total_bytes += strings(i).size();
+  }
+  // Matching costs a few tens of cycles per byte, plus the copies of the
+  // strings in and out of the regex library.
+  static constexpr int64_t kCostPerByte = 20;
+  static constexpr int64_t kCostPerString = 200;
+  const int64_t cost_per_unit = kCostPerString + kCostPerByte * total_bytes /
+                                                     size;
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, size,
+        cost_per_unit, [&fn](int64_t start, int64_t limit) {
+          for (int64_t i = start; i < limit; ++i) {
+            fn(i);
+          }
+        });
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_REGEX_UTIL_H_
+#define TENSORFLOW_CORE_KERNELS_REGEX_UTIL_H_
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "re2/re2.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A cache of compiled regular expressions, keyed by pattern, that evicts the
+// least recently used pattern when it is full. The kernels that take their
+// pattern as an input share the process wide cache, so that alternating
+// patterns are compiled once rather than at each change.
+//
+// This class is thread safe.
+class RegexCache {
+ public:
+  static constexpr int kDefaultCapacity = 256;
+
+  explicit RegexCache(int capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+  // Returns the process wide cache.
+  static RegexCache* Global();
+
+  // Returns the compiled `pattern`, compiling it on a miss. The result may
+  // not be ok(), in which case its error() describes why.
+  std::shared_ptr<RE2> Lookup(const std::string& pattern);
+
+  int size() const {
+    tf_shared_lock l(mu_);
+    return entries_.size();
+  }
+
+ private:
+  typedef std::list<std::pair<std::string, std::shared_ptr<RE2>>> EntryList;
+
+  const int capacity_;
+  mutable mutex mu_;
+  // The entries, in the order of their last use, most recent first.
+  EntryList entries_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RegexCache);
+};
+
+// Calls `fn(i)` for each index of `strings`, splitting them between the
+// intra-op threads of `ctx` when they are long or numerous enough to be
+// worth it.
+void ForEachString(OpKernelContext* ctx, TTypes<tstring>::ConstFlat strings,
+                   const std::function<void(int64_t i)>& fn);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_REGEX_UTIL_H_
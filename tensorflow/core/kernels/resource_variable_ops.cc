@@ -44,6 +44,14 @@ limitations under the License.
 //   that they want to perform the write without locks held
 //   (use_locking=false), we never copy even if the variable's
 //   reference count is >1.
+//
+// Variables in snapshot mode keep the general strategy for sparse
+// operations, trading the copies for readers that don't wait on
+// writers: sparse reads release the mutex once they copied the Tensor
+// object, and sparse writes copy the variable if it is >1. The
+// ResourceScatter* ops make that copy, and apply their update to it,
+// without holding the mutex, and only acquire it in "exclusive" mode
+// to replace the variable's Tensor.
 
 #define EIGEN_USE_THREADS
 
@@ -57,6 +65,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -622,9 +631,15 @@ class ResourceGatherOp : public OpKernel {
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
     // reference count greater than one and make a copy of the
-    // (potentially very large) tensor buffer.
-    tf_shared_lock ml(*v->mu());
-    const Tensor& params = *v->tensor();
+    // (potentially very large) tensor buffer. Variables in snapshot
+    // mode make that copy rather than stall the gather.
+    absl::optional<tf_shared_lock> ml(absl::in_place, *v->mu());
+    Tensor version;
+    if (v->snapshot_mode) {
+      version = *v->tensor();
+      ml.reset();
+    }
+    const Tensor& params = v->snapshot_mode ? version : *v->tensor();
     const Tensor& indices = c->input(1);
     OP_REQUIRES(
         c, TensorShapeUtils::IsVectorOrHigher(params.shape()),
@@ -800,9 +815,15 @@ class ResourceGatherNdOp : public OpKernel {
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
     // reference count greater than one and make a copy of the
-    // (potentially very large) tensor buffer.
-    tf_shared_lock ml(*v->mu());
-    const Tensor& params = *v->tensor();
+    // (potentially very large) tensor buffer. Variables in snapshot
+    // mode make that copy rather than stall the gather.
+    absl::optional<tf_shared_lock> ml(absl::in_place, *v->mu());
+    Tensor version;
+    if (v->snapshot_mode) {
+      version = *v->tensor();
+      ml.reset();
+    }
+    const Tensor& params = v->snapshot_mode ? version : *v->tensor();
     const Tensor& indices = c->input(1);
 
     Tensor out;
@@ -887,26 +908,61 @@ class ResourceScatterUpdateOp : public OpKernel {
     core::RefCountPtr<Var> v;
     OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
     OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
+    if (v->snapshot_mode) {
+      ComputeNextVersion(c, v.get());
+      return;
+    }
     const bool is_non_pod_dtype = c->input_dtype(0) == DT_RESOURCE ||
                                   c->input_dtype(0) == DT_STRING ||
                                   c->input_dtype(0) == DT_VARIANT;
     if (is_non_pod_dtype || use_exclusive_lock_) {
       mutex_lock ml(*v->mu());
-      DoCompute(c);
+      DoCompute(c, v->tensor());
     } else {
       // For POD dtypes, we can safely run the update without the mutex.
       tf_shared_lock ml(*v->mu());
-      DoCompute(c);
+      DoCompute(c, v->tensor());
     }
   }
 
  private:
   bool use_exclusive_lock_;
 
-  void DoCompute(OpKernelContext* c) {
-    core::RefCountPtr<Var> v;
-    OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
-    Tensor* params = v->tensor();
+  // Updates a variable in snapshot mode. When no reader aliases the
+  // current version it is updated in place, otherwise the update is
+  // applied to a copy made without holding the mutex, which then
+  // replaces the current version unless another write replaced it in
+  // the meantime. In that case the update is applied again, to the
+  // newer version, under the mutex.
+  void ComputeNextVersion(OpKernelContext* c, Var* v) {
+    Tensor version;
+    {
+      mutex_lock ml(*v->mu());
+      const Tensor* t = v->tensor();
+      if (t->NumElements() == 0 || t->RefCountIsOne()) {
+        DoCompute(c, v->tensor());
+        return;
+      }
+      version = *v->tensor();
+    }
+    Tensor next = version;
+    OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(
+                          c, &next, /*copy_on_read_mode=*/true));
+    DoCompute(c, &next);
+    if (!c->status().ok()) return;
+    mutex_lock ml(*v->mu());
+    // Writes to the variable copy it while `version` aliases it, so the
+    // current version is `version` as long as it shares its buffer.
+    if (v->tensor()->SharesBufferWith(version)) {
+      *v->tensor() = next;
+      return;
+    }
+    OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(
+                          c, v->tensor(), /*copy_on_read_mode=*/false));
+    DoCompute(c, v->tensor());
+  }
+
+  void DoCompute(OpKernelContext* c, Tensor* params) {
     const Tensor& indices = c->input(1);
     const Tensor& updates = c->input(2);
 
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -281,7 +282,13 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && reader->options().use_mmap) {
+      // Lookup the full tensor, letting it alias the mapped data file instead
+      // of allocating an output to copy it into.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored));
+      context->set_output(idx, restored);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -383,9 +390,24 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  // Full tensors are read in one batch, which coalesces and parallelizes the
+  // reads; mapped bundles do not read them at all.
+  std::vector<string> batched_names;
+  std::vector<Tensor*> batched_tensors;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
+    if (shape_and_slice.empty() && !default_reader.options().use_mmap) {
+      TensorShape restored_full_shape;
+      TF_RETURN_IF_ERROR(
+          default_reader.LookupTensorShape(tensor_name, &restored_full_shape));
+      Tensor* restored_tensor;
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(i, restored_full_shape, &restored_tensor));
+      batched_names.push_back(tensor_name);
+      batched_tensors.push_back(restored_tensor);
+      continue;
+    }
     auto op =
         new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
     if (op->should_run_in_pool(&default_reader)) {
@@ -395,6 +417,22 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     }
   }
 
+  if (!batched_names.empty()) {
+    BundleReader::BatchLookupOptions options;
+    int64_t num_threads;
+    TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_V2_IO_THREADS",
+                                           options.num_threads, &num_threads));
+    options.num_threads = num_threads;
+    int64_t max_inflight_mb;
+    TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_V2_MAX_INFLIGHT_MB",
+                                           options.max_inflight_bytes >> 20,
+                                           &max_inflight_mb));
+    options.max_inflight_bytes = max_inflight_mb << 20;
+    VLOG(1) << "Restoring " << batched_names.size() << " tensors in a batch";
+    TF_RETURN_IF_ERROR(
+        default_reader.BatchLookup(batched_names, batched_tensors, options));
+  }
+
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 
@@ -85,6 +86,21 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Deletes the directories of "input_prefixes" other than that of
+// "merged_prefix", once they have been merged.
+void DeleteOldDirs(Env* env, gtl::ArraySlice<string> input_prefixes,
+                   const string& merged_prefix) {
+  const string merged_dir(io::Dirname(merged_prefix));
+  for (const string& input_prefix : input_prefixes) {
+    const string dirname(io::Dirname(input_prefix));
+    if (dirname == merged_dir) continue;
+    Status status = env->DeleteDir(dirname);
+    // For sharded save, only the first delete will go through and all
+    // others will hit NotFound.  Use vlog to be less verbose.
+    if (!status.ok()) VLOG(1) << status;
+  }
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
@@ -106,6 +122,34 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
+    AsyncBundleWriter* async_writer = AsyncBundleWriter::Global();
+    if (async_writer != nullptr) {
+      // Snapshots the tensors and writes them in the background.
+      std::vector<AsyncBundleWriter::Entry> entries(num_tensors);
+      for (int i = 0; i < num_tensors; ++i) {
+        AsyncBundleWriter::Entry& entry = entries[i];
+        entry.key = tensor_names_flat(i);
+        entry.tensor = context->input(i + kFixedInputs);
+        if (!shape_and_slices_flat(i).empty()) {
+          const string& shape_spec = shape_and_slices_flat(i);
+          TensorShape slice_shape;
+          entry.is_slice = true;
+          OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
+                                      shape_spec, &entry.full_shape,
+                                      &entry.slice_spec, &slice_shape));
+          OP_REQUIRES(context, slice_shape.IsSameSize(entry.tensor.shape()),
+                      errors::InvalidArgument(
+                          "Slice in shape_and_slice specification does not "
+                          "match the shape of the tensor to  save: ",
+                          shape_spec, ", tensor: ",
+                          entry.tensor.shape().DebugString()));
+        }
+      }
+      OP_REQUIRES_OK(context, async_writer->ScheduleWrite(prefix_string,
+                                                          std::move(entries)));
+      return;
+    }
+
     BundleWriter writer(Env::Default(), prefix_string);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
@@ -182,6 +226,12 @@ class RestoreV2 : public OpKernel {
 
     const string& prefix_string = prefix.scalar<tstring>()();
 
+    // The bundle may still be being written in the background.
+    AsyncBundleWriter* async_writer = AsyncBundleWriter::Global();
+    if (async_writer != nullptr) {
+      OP_REQUIRES_OK(context, async_writer->WaitFor(prefix_string));
+    }
+
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
     // We here attempt to read a V1 checkpoint, if "prefix_string" does not
@@ -239,19 +289,32 @@ class MergeV2Checkpoints : public OpKernel {
         gtl::ArraySlice<tstring>(checkpoint_prefixes.flat<tstring>());
     Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<tstring>()();
+
+    AsyncBundleWriter* async_writer = AsyncBundleWriter::Global();
+    if (async_writer != nullptr) {
+      // Merges once the background writes of the inputs are done.
+      std::vector<string> prefixes(input_prefixes.begin(),
+                                   input_prefixes.end());
+      std::function<void()> after;
+      if (delete_old_dirs_) {
+        after = [env, prefixes, merged_prefix]() {
+          DeleteOldDirs(env, prefixes, merged_prefix);
+        };
+      }
+      OP_REQUIRES_OK(context,
+                     async_writer->ScheduleMerge(std::move(prefixes),
+                                                 merged_prefix,
+                                                 std::move(after)));
+      return;
+    }
+
     OP_REQUIRES_OK(
         context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
 
     if (delete_old_dirs_) {
-      const string merged_dir(io::Dirname(merged_prefix));
-      for (const string& input_prefix : input_prefixes) {
-        const string dirname(io::Dirname(input_prefix));
-        if (dirname == merged_dir) continue;
-        Status status = env->DeleteDir(dirname);
-        // For sharded save, only the first delete will go through and all
-        // others will hit NotFound.  Use vlog to be less verbose.
-        if (!status.ok()) VLOG(1) << status;
-      }
+      std::vector<string> prefixes(input_prefixes.begin(),
+                                   input_prefixes.end());
+      DeleteOldDirs(env, prefixes, merged_prefix);
     }
   }
 
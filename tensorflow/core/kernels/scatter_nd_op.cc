@@ -257,6 +257,10 @@ class ScatterNdUpdateOp : public OpKernel {
       OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
       OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
       mutex_lock m(*v->mu());
+      if (v->snapshot_mode) {
+        OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(
+                              c, v->tensor(), /*copy_on_read_mode=*/false));
+      }
       DoCompute(c);
     } else if (use_exclusive_lock_) {
       // If we're here, it means the input type is a ref.
@@ -20,6 +20,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <atomic>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/kernels/scatter_nd_op.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
 
@@ -128,7 +130,30 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
       }
     }
 
+    // The output rows are updated in index order, which is random for large
+    // tables, so the row of the update kPrefetchDistance locations ahead is
+    // prefetched while the current one is applied.
+    constexpr Eigen::DenseIndex kPrefetchDistance = 8;
+    auto prefetch_row = [&](Eigen::DenseIndex loc) {
+      Index i = 0;
+      for (int dim = 0; dim < IXDIM; ++dim) {
+        const Index ix_d = Tindices(loc, dim);
+        if (!FastBoundsCheck(ix_d, output_shape_prefix[dim])) return;
+        i += ix_d * batch_strides[dim];
+      }
+      port::prefetch<port::PREFETCH_HINT_T0>(&Toutput(i, 0));
+    };
+    if (slice_size > 0) {
+      for (Eigen::DenseIndex loc = 0;
+           loc < std::min(kPrefetchDistance, batch_size); ++loc) {
+        prefetch_row(loc);
+      }
+    }
+
     for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
+      if (slice_size > 0 && loc + kPrefetchDistance < batch_size) {
+        prefetch_row(loc + kPrefetchDistance);
+      }
       Index i = 0;
       bool out_of_bounds = false;
       for (int dim = 0; dim < IXDIM; ++dim) {
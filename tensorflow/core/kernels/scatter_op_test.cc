@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -266,6 +267,55 @@ TEST_F(ScatterUpdateOpTest, Error_MismatchedIndicesAndUpdateDimensions) {
       << s;
 }
 
+class ResourceScatterUpdateOpTest : public OpsTestBase {
+ protected:
+  // Makes a ResourceScatterUpdate op on `var`, a float variable in snapshot
+  // mode, with the value {1, 2, 3, 4}.
+  void MakeOp(Var** var) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "ResourceScatterUpdate")
+                     .Input(FakeInput(DT_RESOURCE))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    *var = new Var(DT_FLOAT);
+    (*var)->snapshot_mode = true;
+    *(*var)->tensor() = test::AsTensor<float>({1, 2, 3, 4});
+    (*var)->is_initialized = true;
+    AddResourceInput<Var>("", "var", *var);
+  }
+};
+
+TEST_F(ResourceScatterUpdateOpTest, SnapshotModeKeepsReadVersions) {
+  Var* var;
+  MakeOp(&var);
+  AddInputFromArray<int32>(TensorShape({1}), {1});
+  AddInputFromArray<float>(TensorShape({1}), {20});
+  // Aliased by a read.
+  const Tensor version = *var->tensor();
+  TF_ASSERT_OK(RunOpKernel());
+
+  EXPECT_FALSE(var->copy_on_read_mode.load());
+  EXPECT_FALSE(var->tensor()->SharesBufferWith(version));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3, 4}),
+                                 version);
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 20, 3, 4}),
+                                 *var->tensor());
+}
+
+TEST_F(ResourceScatterUpdateOpTest, SnapshotModeUpdatesUnreadVersionInPlace) {
+  Var* var;
+  MakeOp(&var);
+  AddInputFromArray<int32>(TensorShape({2}), {0, 3});
+  AddInputFromArray<float>(TensorShape({2}), {10, 40});
+  const char* data = var->tensor()->tensor_data().data();
+  TF_ASSERT_OK(RunOpKernel());
+
+  EXPECT_EQ(data, var->tensor()->tensor_data().data());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({10, 2, 3, 40}),
+                                 *var->tensor());
+}
+
 class ScatterUpdateBM : public ScatterUpdateOpTest {
  public:
   void TestBody() override {}
@@ -22,14 +22,42 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/sorted_search.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
+namespace {
+// Calls `search(sorted_inputs_row, value)` for each value, in parallel, and
+// stores the results in `output`.
+template <typename T, typename OutType, typename Search>
+void SearchAll(OpKernelContext* context,
+               const typename TTypes<T, 1>::ConstTensor& sorted_inputs,
+               const typename TTypes<T, 1>::ConstTensor& values,
+               int batch_size, int num_inputs, int num_values,
+               typename TTypes<OutType, 1>::Tensor* output, Search search) {
+  // A search costs a comparison and a load per halving of the row.
+  const int64_t cost_per_unit = 4 * (Log2Ceiling64(num_inputs + 1) + 1);
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        static_cast<int64_t>(batch_size) * num_values, cost_per_unit,
+        [&](int64_t start, int64_t limit) {
+          for (int64_t i = start; i < limit; ++i) {
+            const int64_t b = i / num_values;
+            (*output)(i) =
+                search(sorted_inputs.data() + b * num_inputs, values(i));
+          }
+        });
+}
+}  // namespace
+
 template <typename T, typename OutType>
 struct UpperBoundFunctor<CPUDevice, T, OutType> {
   static Status Compute(OpKernelContext* context,
@@ -37,17 +65,13 @@ struct UpperBoundFunctor<CPUDevice, T, OutType> {
                         const typename TTypes<T, 1>::ConstTensor& values,
                         int batch_size, int num_inputs, int num_values,
                         typename TTypes<OutType, 1>::Tensor* output) {
-    // TODO(rmlarsen): add multithreading or interleaving.
-    for (int b = 0; b < batch_size; ++b) {
-      const T* sorted_inputs_ptr = sorted_inputs.data() + b * num_inputs;
-      OutType* output_ptr = output->data() + b * num_values;
-      for (int i = 0; i < num_values; ++i) {
-        output_ptr[i] =
-            std::upper_bound(sorted_inputs_ptr, sorted_inputs_ptr + num_inputs,
-                             values(i + b * num_values)) -
-            sorted_inputs_ptr;
-      }
-    }
+    SearchAll<T, OutType>(
+        context, sorted_inputs, values, batch_size, num_inputs, num_values,
+        output, [num_inputs](const T* row, const T& value) {
+          return BranchlessUpperBound(
+              row, num_inputs, value,
+              [](const T& a, const T& b) { return a < b; });
+        });
 
     return Status::OK();
   }
@@ -60,17 +84,13 @@ struct LowerBoundFunctor<CPUDevice, T, OutType> {
                         const typename TTypes<T, 1>::ConstTensor& values,
                         int batch_size, int num_inputs, int num_values,
                         typename TTypes<OutType, 1>::Tensor* output) {
-    // TODO(rmlarsen): add multithreading or interleaving.
-    for (int b = 0; b < batch_size; ++b) {
-      const T* sorted_inputs_ptr = sorted_inputs.data() + b * num_inputs;
-      OutType* output_ptr = output->data() + b * num_values;
-      for (int i = 0; i < num_values; ++i) {
-        output_ptr[i] =
-            std::lower_bound(sorted_inputs_ptr, sorted_inputs_ptr + num_inputs,
-                             values(i + b * num_values)) -
-            sorted_inputs_ptr;
-      }
-    }
+    SearchAll<T, OutType>(
+        context, sorted_inputs, values, batch_size, num_inputs, num_values,
+        output, [num_inputs](const T* row, const T& value) {
+          return BranchlessLowerBound(
+              row, num_inputs, value,
+              [](const T& a, const T& b) { return a < b; });
+        });
 
     return Status::OK();
   }
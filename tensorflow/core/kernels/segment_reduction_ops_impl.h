@@ -23,6 +23,7 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -127,81 +129,112 @@ class SegmentReductionOp : public OpKernel {
 #else
     Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
 #endif
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
-    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
-        }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
-      }
-
-      // Process segment [start, end)
-      const T* in_slice_ptr = &input_flat(start, 0);
-      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                               Eigen::Unaligned>
-          OutT;
 
+    // Find the runs of equal segment ids, checking that they are increasing
+    // and in range. `run_starts` has a sentinel `num_indices` at the end.
+    std::vector<Index> run_starts;
+    std::vector<Index> run_ids;
+    Index out_index = internal::SubtleMustCopy(segment_vec(0));
+    run_starts.push_back(0);
+    run_ids.push_back(out_index);
+    for (Index i = 1; i < num_indices; ++i) {
+      const Index next_index = internal::SubtleMustCopy(segment_vec(i));
+      if (next_index == out_index) continue;
+      // We have a new segment here.  Verify that the segment ids are growing.
+      OP_REQUIRES(context, out_index < next_index,
+                  errors::InvalidArgument("segment ids are not increasing"));
+      run_starts.push_back(i);
+      run_ids.push_back(next_index);
+      out_index = next_index;
+    }
+    run_starts.push_back(num_indices);
+    for (const Index id : {run_ids.front(), run_ids.back()}) {
       OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
+          context, FastBoundsCheck(id, output_rows),
           errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
+              "Segment id ", id, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
+    }
+    const int64_t num_runs = run_ids.size();
+
+    // Reduces the runs [first_run, last_run) and sets the output rows in the
+    // gaps before each of them to the default value.
+    //
+    // We don't use out_slice.device(context->eigen_device<Device>) because
+    // the segments are likely to be very small and the context switching
+    // overhead dwarfs any benefit we get from using another thread for each.
+    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
+    auto reduce_runs = [&](int64_t first_run, int64_t last_run) {
+      for (int64_t run = first_run; run < last_run; ++run) {
+        const Index start = run_starts[run];
+        const Index end = run_starts[run + 1];
+        const Index run_id = run_ids[run];
+        const Index uninitialized_index = run == 0 ? 0 : run_ids[run - 1] + 1;
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        if (run_id > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              run_id - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(T(default_value));
+        }
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(T(default_value));
-      }
-
-      T* out_slice_ptr = &output_flat(out_index, 0);
-      OutT out_slice(out_slice_ptr, out_slice_shape);
-      // We don't use out_slice.device(context->eigen_device<Device>)
-      // because these pieces of work are likely to be very small and
-      // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
-      if (start == end - 1) {
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, out_slice_shape);
-        out_slice = in_slice;
-      } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
-                                                           num_col);
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+        const T* in_slice_ptr = &input_flat(start, 0);
+        typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
                                  Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, in_slice_shape);
-
-        out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+            OutT;
+        T* out_slice_ptr = &output_flat(run_id, 0);
+        OutT out_slice(out_slice_ptr, out_slice_shape);
+        if (start == end - 1) {
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, out_slice_shape);
+          out_slice = in_slice;
+        } else {
+          Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
+                                                             num_col);
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, in_slice_shape);
+
+          out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        }
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
+    };
+
+    // The runs are split into shards of about the same number of input rows,
+    // so that a few long segments do not serialize the reduction.
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_shards = std::max<int64_t>(
+        1, std::min<int64_t>({num_runs, 4 * worker_threads.num_threads,
+                              num_indices * num_col / kMinElementsPerShard}));
+    if (num_shards == 1) {
+      reduce_runs(0, num_runs);
+      return;
     }
+    // Returns the first run that starts at or after input row `row`.
+    auto first_run_from = [&](int64_t row) -> int64_t {
+      return std::lower_bound(run_starts.begin(), run_starts.end() - 1,
+                              static_cast<Index>(row)) -
+             run_starts.begin();
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_shards,
+          /*cost_per_unit=*/num_indices / num_shards * num_col * 5,
+          [&](int64_t start_shard, int64_t limit_shard) {
+            reduce_runs(first_run_from(start_shard * num_indices / num_shards),
+                        first_run_from(limit_shard * num_indices / num_shards));
+          });
   }
+
+ private:
+  // Inputs with fewer elements per thread than this are reduced on a single
+  // thread.
+  static constexpr int64_t kMinElementsPerShard = 16 * 1024;
 };
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -351,13 +384,39 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
                   typename TTypes<Index>::ConstFlat segment_ids,
                   typename TTypes<T, 2>::ConstTensor data,
                   typename TTypes<T, 2>::Tensor output) {
-    output.setConstant(InitialValueF()());
     if (data.size() == 0) {
+      output.setConstant(InitialValueF()());
       return;
     }
     const int64_t N = segment_ids.dimension(0);
     const int64_t num_segments = output.dimension(0);
+    const int64_t num_col = output.dimension(1);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_shards = std::max<int64_t>(
+        1, std::min<int64_t>({num_segments, 4 * worker_threads.num_threads,
+                              N * num_col / kMinElementsPerShard}));
     ReductionF reduction;
+    if (num_shards == 1) {
+      output.setConstant(InitialValueF()());
+      for (int64_t i = 0; i < N; ++i) {
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < 0) {
+          continue;
+        }
+        OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                    errors::InvalidArgument(
+                        "segment_ids", SliceDebugString(segment_ids_shape, i),
+                        " = ", j, " is out of range [0, ", num_segments, ")"));
+        reduction(data.template chip<0>(i), output.template chip<0>(j));
+      }
+      return;
+    }
+
+    // The data rows are grouped by segment with a stable counting sort. Each
+    // shard then owns a contiguous range of output segments and reduces their
+    // rows in input order, so the result is the same as on a single thread.
+    std::vector<int64_t> row_begin(num_segments + 1, 0);
     for (int64_t i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
       if (j < 0) {
@@ -367,9 +426,63 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", num_segments, ")"));
-      reduction(data.template chip<0>(i), output.template chip<0>(j));
+      ++row_begin[j + 1];
     }
+    for (int64_t j = 0; j < num_segments; ++j) {
+      row_begin[j + 1] += row_begin[j];
+    }
+    std::vector<int64_t> next_row(row_begin.begin(), row_begin.end() - 1);
+    std::vector<int64_t> rows(row_begin[num_segments]);
+    for (int64_t i = 0; i < N; ++i) {
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      if (j >= 0) {
+        rows[next_row[j]++] = i;
+      }
+    }
+
+    // The segment ranges hold about the same number of data rows, counting
+    // one more for each segment to initialize.
+    const int64_t total_cost = row_begin[num_segments] + num_segments;
+    auto first_segment_from = [&](int64_t cost) {
+      int64_t lo = 0;
+      int64_t hi = num_segments;
+      while (lo < hi) {
+        const int64_t mid = lo + (hi - lo) / 2;
+        if (row_begin[mid] + mid < cost) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      return lo;
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_shards,
+          /*cost_per_unit=*/(N / num_shards + 1) * num_col * 5,
+          [&](int64_t start_shard, int64_t limit_shard) {
+            const int64_t begin =
+                first_segment_from(start_shard * total_cost / num_shards);
+            const int64_t end =
+                first_segment_from(limit_shard * total_cost / num_shards);
+            if (begin == end) return;
+            Eigen::DSizes<Eigen::DenseIndex, 2> slice_shape(end - begin,
+                                                            num_col);
+            Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                             Eigen::Unaligned>
+                slice(&output(begin, 0), slice_shape);
+            slice.setConstant(InitialValueF()());
+            for (int64_t j = begin; j < end; ++j) {
+              for (int64_t k = row_begin[j]; k < row_begin[j + 1]; ++k) {
+                reduction(data.template chip<0>(rows[k]),
+                          output.template chip<0>(j));
+              }
+            }
+          });
   }
+
+ private:
+  // Inputs with fewer elements per thread than this are reduced on a single
+  // thread.
+  static constexpr int64_t kMinElementsPerShard = 16 * 1024;
 };
 
 template <typename T>
@@ -1134,6 +1247,120 @@ class SparseSegmentSqrtNGradOp
             context, SparseSegmentReductionOperation::kSqrtN) {}
 };
 
+// Like SparseSegmentGradOpBase, but only produces the rows of the gradient
+// that `indices` refers to, together with their sorted unique indices, instead
+// of a dense [output_dim0, ...] gradient that is mostly zeros. The two outputs
+// form the values and indices of an IndexedSlices.
+template <typename Device, class T, typename Index, typename SegmentId>
+class SparseSegmentGradV2OpBase : public OpKernel {
+ public:
+  explicit SparseSegmentGradV2OpBase(OpKernelConstruction* context,
+                                     SparseSegmentReductionOperation operation)
+      : OpKernel(context), operation_(operation) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& dense_output_dim0 = context->input(3);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(input.shape()),
+                errors::InvalidArgument("grad must be at least 1D."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(dense_output_dim0.shape()),
+        errors::InvalidArgument("dense_output_dim0 should be a scalar."));
+
+    const int64_t N = indices.NumElements();
+    OP_REQUIRES(context, N == segment_ids.NumElements(),
+                errors::InvalidArgument(
+                    "segment_ids and indices should have same size."));
+    const Index M =
+        internal::SubtleMustCopy(dense_output_dim0.scalar<int32>()());
+
+    // Sort and deduplicate the indices, and map each of them to its row in the
+    // output.
+    const auto indices_vec = indices.vec<Index>();
+    std::vector<Index> sorted_unique_indices(N);
+    for (int64_t i = 0; i < N; ++i) {
+      const Index index = internal::SubtleMustCopy(indices_vec(i));
+      OP_REQUIRES(context, FastBoundsCheck(index, M),
+                  errors::InvalidArgument("Index ", index, " out of range [0, ",
+                                          M, ")."));
+      sorted_unique_indices[i] = index;
+    }
+    std::sort(sorted_unique_indices.begin(), sorted_unique_indices.end());
+    sorted_unique_indices.erase(
+        std::unique(sorted_unique_indices.begin(), sorted_unique_indices.end()),
+        sorted_unique_indices.end());
+    const int64_t num_unique = sorted_unique_indices.size();
+
+    Tensor* unique_indices_output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1,
+                                                     TensorShape({num_unique}),
+                                                     &unique_indices_output));
+    std::copy(sorted_unique_indices.begin(), sorted_unique_indices.end(),
+              unique_indices_output->vec<Index>().data());
+
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, num_unique);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (N == 0) return;
+
+    Tensor output_rows;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<Index>::value,
+                                          TensorShape({N}), &output_rows));
+    auto output_rows_vec = output_rows.vec<Index>();
+    for (int64_t i = 0; i < N; ++i) {
+      output_rows_vec(i) = static_cast<Index>(
+          std::lower_bound(sorted_unique_indices.begin(),
+                           sorted_unique_indices.end(), indices_vec(i)) -
+          sorted_unique_indices.begin());
+    }
+
+    const Tensor& const_output_rows = output_rows;
+    functor::SparseSegmentGradFunctor<Device, T, Index, SegmentId>()(
+        context, operation_, input.flat_outer_dims<T>(),
+        const_output_rows.vec<Index>(), segment_ids.vec<SegmentId>(),
+        output->flat_outer_dims<T>());
+  }
+
+ private:
+  const SparseSegmentReductionOperation operation_;
+};
+
+template <typename Device, class T, typename Index, typename SegmentId>
+class SparseSegmentSumGradV2Op
+    : public SparseSegmentGradV2OpBase<Device, T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentSumGradV2Op(OpKernelConstruction* context)
+      : SparseSegmentGradV2OpBase<Device, T, Index, SegmentId>(
+            context, SparseSegmentReductionOperation::kSum) {}
+};
+
+template <typename Device, class T, typename Index, typename SegmentId>
+class SparseSegmentMeanGradV2Op
+    : public SparseSegmentGradV2OpBase<Device, T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentMeanGradV2Op(OpKernelConstruction* context)
+      : SparseSegmentGradV2OpBase<Device, T, Index, SegmentId>(
+            context, SparseSegmentReductionOperation::kMean) {}
+};
+
+template <typename Device, class T, typename Index, typename SegmentId>
+class SparseSegmentSqrtNGradV2Op
+    : public SparseSegmentGradV2OpBase<Device, T, Index, SegmentId> {
+ public:
+  explicit SparseSegmentSqrtNGradV2Op(OpKernelConstruction* context)
+      : SparseSegmentGradV2OpBase<Device, T, Index, SegmentId>(
+            context, SparseSegmentReductionOperation::kSqrtN) {}
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
@@ -18,6 +18,10 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -40,9 +44,126 @@ struct SoftmaxFunctorBase {
     SoftmaxEigenImpl<Device, T>::Compute(d, logits, softmax, log);
   }
 };
+
+// Computes Softmax or LogSoftmax on CPU when there are fewer rows than
+// threads, and the rows are long, as for the logits over a large vocabulary
+// at a small batch size. Eigen splits its reductions between the rows, so it
+// would compute the sum of each row on a single thread.
+//
+// The rows are instead split into blocks, in two parallel passes. The first
+// pass computes the maximum `m` of each block and the sum of the exponentials
+// of its logits shifted by `m`; the partial sums of a row are then rescaled to
+// its maximum and added up. The second pass normalizes the blocks. The blocks
+// have the same size whatever the number of threads, so that the results are
+// deterministic.
+template <typename T>
+struct LongRowSoftmax {
+  static constexpr int64_t kBlockSize = 8192;
+
+  // Returns false if the shape of the logits doesn't call for it.
+  static bool Compute(const CPUDevice& d,
+                      typename TTypes<T>::ConstMatrix logits,
+                      typename TTypes<T>::Matrix softmax, const bool log) {
+    const int64_t num_rows = logits.dimension(0);
+    const int64_t num_cols = logits.dimension(1);
+    const int64_t num_blocks = Eigen::divup(num_cols, kBlockSize);
+    if (num_blocks < 2 || num_rows >= d.numThreads()) return false;
+
+    std::vector<T> block_max(num_rows * num_blocks);
+    std::vector<T> block_sum(num_rows * num_blocks);
+    const auto for_each_block = [&](double cycles_per_element,
+                                    const std::function<void(
+                                        int64_t row, int64_t begin,
+                                        int64_t size, int64_t i)>& fn) {
+      const Eigen::TensorOpCost cost(kBlockSize * sizeof(T),
+                                     kBlockSize * sizeof(T),
+                                     kBlockSize * cycles_per_element);
+      d.parallelFor(num_rows * num_blocks, cost,
+                    [&](Eigen::Index start, Eigen::Index limit) {
+                      for (Eigen::Index i = start; i < limit; ++i) {
+                        const int64_t row = i / num_blocks;
+                        const int64_t begin = (i % num_blocks) * kBlockSize;
+                        fn(row, begin, std::min(kBlockSize, num_cols - begin),
+                           i);
+                      }
+                    });
+    };
+
+    const double exp_cycles = Eigen::internal::functor_traits<
+        Eigen::internal::scalar_exp_op<T>>::Cost;
+    for_each_block(exp_cycles, [&](int64_t row, int64_t begin, int64_t size,
+                                   int64_t i) {
+      typename TTypes<T>::ConstVec block(&logits(row, begin), size);
+      const Eigen::Tensor<T, 0, Eigen::RowMajor> max = block.maximum();
+      block_max[i] = max();
+      if (max() == -std::numeric_limits<T>::infinity()) {
+        // The exponentials of the whole block are 0.
+        block_sum[i] = T(0);
+      } else {
+        const Eigen::Tensor<T, 0, Eigen::RowMajor> sum =
+            (block - max()).exp().sum();
+        block_sum[i] = sum();
+      }
+    });
+
+    // The maximum of each row, and the sum of the exponentials of its logits
+    // shifted by it, or its logarithm for LogSoftmax.
+    std::vector<T> row_max(num_rows);
+    std::vector<T> row_sum(num_rows);
+    for (int64_t row = 0; row < num_rows; ++row) {
+      const T* maxes = block_max.data() + row * num_blocks;
+      const T* sums = block_sum.data() + row * num_blocks;
+      row_max[row] = *std::max_element(maxes, maxes + num_blocks);
+      T sum(0);
+      for (int64_t b = 0; b < num_blocks; ++b) {
+        // Skip the blocks of -inf, whose shift by the maximum is NaN if the
+        // whole row is -inf.
+        if (sums[b] != T(0)) {
+          sum += sums[b] * Eigen::numext::exp(maxes[b] - row_max[row]);
+        }
+      }
+      row_sum[row] = log ? Eigen::numext::log(sum) : T(1) / sum;
+    }
+
+    for_each_block(exp_cycles, [&](int64_t row, int64_t begin, int64_t size,
+                                   int64_t i) {
+      typename TTypes<T>::ConstVec block(&logits(row, begin), size);
+      typename TTypes<T>::Vec out(&softmax(row, begin), size);
+      if (log) {
+        out = block - (row_max[row] + row_sum[row]);
+      } else {
+        out = (block - row_max[row]).exp() * row_sum[row];
+      }
+    });
+    return true;
+  }
+};
+
 template <typename T>
 struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
+template <>
+struct SoftmaxFunctor<CPUDevice, float> {
+  void operator()(const CPUDevice& d,
+                  typename TTypes<float>::ConstMatrix logits,
+                  typename TTypes<float>::Matrix softmax, const bool log) {
+    if (!LongRowSoftmax<float>::Compute(d, logits, softmax, log)) {
+      SoftmaxEigenImpl<CPUDevice, float>::Compute(d, logits, softmax, log);
+    }
+  }
+};
+
+template <>
+struct SoftmaxFunctor<CPUDevice, double> {
+  void operator()(const CPUDevice& d,
+                  typename TTypes<double>::ConstMatrix logits,
+                  typename TTypes<double>::Matrix softmax, const bool log) {
+    if (!LongRowSoftmax<double>::Compute(d, logits, softmax, log)) {
+      SoftmaxEigenImpl<CPUDevice, double>::Compute(d, logits, softmax, log);
+    }
+  }
+};
+
 }  // namespace functor
 
 template <typename Device, typename T>
@@ -0,0 +1,139 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
+#define TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/lib/core/bits.h"
+
+namespace tensorflow {
+
+// Binary searches without data dependent branches, which the CPU can't
+// predict when the values are random: the loops only depend on the length
+// of the range, and the comparisons select the next position with a
+// conditional move. `less(a, b)` must be a strict weak order, in which the
+// range [first, first + n) is sorted.
+//
+// Returns the index of the first element of the range that is not less than
+// `value`, like std::lower_bound.
+template <typename T, typename U, typename Less>
+inline int64_t BranchlessLowerBound(const T* first, int64_t n, const U& value,
+                                    Less less) {
+  if (n == 0) return 0;
+  const T* base = first;
+  while (n > 1) {
+    const int64_t half = n / 2;
+    base = less(base[half], value) ? base + half : base;
+    n -= half;
+  }
+  return (base - first) + less(*base, value);
+}
+
+// Returns the index of the first element of the range that `value` is less
+// than, like std::upper_bound.
+template <typename T, typename U, typename Less>
+inline int64_t BranchlessUpperBound(const T* first, int64_t n, const U& value,
+                                    Less less) {
+  if (n == 0) return 0;
+  const T* base = first;
+  while (n > 1) {
+    const int64_t half = n / 2;
+    base = less(value, base[half]) ? base : base + half;
+    n -= half;
+  }
+  return (base - first) + !less(value, *base);
+}
+
+// A set of sorted boundaries, laid out once for the fast computation of the
+// upper bounds of many values.
+//
+// Few boundaries are scanned linearly, in a loop that the compiler
+// vectorizes. More are stored in the Eytzinger layout, which stores the
+// binary search tree of the boundaries in breadth first order: the first
+// levels of the tree, which every search visits, share a few cache lines,
+// and the children of a node are next to each other.
+template <typename T>
+class SortedBoundaries {
+ public:
+  // The largest number of boundaries that are scanned linearly.
+  static constexpr int64_t kMaxLinearScanSize = 32;
+
+  SortedBoundaries() = default;
+
+  // REQUIRES: `boundaries` is sorted.
+  explicit SortedBoundaries(const std::vector<T>& boundaries)
+      : sorted_(boundaries) {
+    const int64_t n = sorted_.size();
+    if (n <= kMaxLinearScanSize) return;
+    // Index 0 is unused, so that the children of node k are 2k and 2k + 1.
+    tree_.resize(n + 1);
+    ranks_.resize(n + 1);
+    int64_t i = 0;
+    Build(1, &i);
+  }
+
+  int64_t size() const { return sorted_.size(); }
+  const std::vector<T>& sorted() const { return sorted_; }
+
+  // Returns the number of boundaries that are not greater than `value`,
+  // which is the index of the first boundary greater than `value`, like
+  // std::upper_bound.
+  template <typename U>
+  int64_t UpperBound(const U& value) const {
+    const int64_t n = sorted_.size();
+    if (n <= kMaxLinearScanSize) {
+      int64_t count = 0;
+      for (int64_t i = 0; i < n; ++i) {
+        count += !(value < sorted_[i]);
+      }
+      return count;
+    }
+    // Descend to a leaf, going right past the boundaries not greater than
+    // `value`. The position after the last left turn is the first boundary
+    // greater than `value`, which is recovered by removing the trailing
+    // right turns and the last left turn from k.
+    int64_t k = 1;
+    while (k <= n) {
+      k = 2 * k + !(value < tree_[k]);
+    }
+    const uint64_t lowest_zero = (k + 1) & ~k;
+    k >>= Log2Floor64(lowest_zero) + 1;
+    return k == 0 ? n : ranks_[k];
+  }
+
+ private:
+  // Fills the subtree rooted at node k with the boundaries from *i on, in
+  // order.
+  void Build(int64_t k, int64_t* i) {
+    if (k >= static_cast<int64_t>(tree_.size())) return;
+    Build(2 * k, i);
+    tree_[k] = sorted_[*i];
+    ranks_[k] = *i;
+    ++*i;
+    Build(2 * k + 1, i);
+  }
+
+  std::vector<T> sorted_;
+  std::vector<T> tree_;
+  // The index in sorted_ of each node of tree_.
+  std::vector<int64_t> ranks_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
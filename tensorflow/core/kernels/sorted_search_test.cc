@@ -0,0 +1,122 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/sorted_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<float> RandomSorted(int n, random::SimplePhilox* rand) {
+  std::vector<float> values(n);
+  for (float& value : values) {
+    // Few distinct values, so that there are duplicates.
+    value = rand->Uniform(n) * 0.5f;
+  }
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+TEST(SortedSearchTest, BranchlessBoundsMatchStd) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  const auto less = [](float a, float b) { return a < b; };
+  for (int n : {0, 1, 2, 3, 7, 8, 100}) {
+    const std::vector<float> sorted = RandomSorted(n, &rand);
+    for (int i = -2; i < n + 2; ++i) {
+      const float value = i * 0.25f;
+      EXPECT_EQ(BranchlessLowerBound(sorted.data(), n, value, less),
+                std::lower_bound(sorted.begin(), sorted.end(), value) -
+                    sorted.begin())
+          << n << " " << value;
+      EXPECT_EQ(BranchlessUpperBound(sorted.data(), n, value, less),
+                std::upper_bound(sorted.begin(), sorted.end(), value) -
+                    sorted.begin())
+          << n << " " << value;
+    }
+  }
+}
+
+TEST(SortedSearchTest, SortedBoundariesMatchUpperBound) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  // Around the largest linear scan, and complete and incomplete trees.
+  for (int n : {0, 1, 5, 32, 33, 63, 64, 100, 1000}) {
+    const std::vector<float> sorted = RandomSorted(n, &rand);
+    const SortedBoundaries<float> boundaries(sorted);
+    ASSERT_EQ(boundaries.size(), n);
+    for (int i = -2; i < n + 2; ++i) {
+      const float value = i * 0.25f;
+      EXPECT_EQ(boundaries.UpperBound(value),
+                std::upper_bound(sorted.begin(), sorted.end(), value) -
+                    sorted.begin())
+          << n << " " << value;
+    }
+    // Like std::upper_bound, NaN is greater than all the boundaries.
+    EXPECT_EQ(boundaries.UpperBound(std::numeric_limits<float>::quiet_NaN()),
+              n);
+    // Integers are compared as floats.
+    EXPECT_EQ(boundaries.UpperBound(int64_t{3}),
+              std::upper_bound(sorted.begin(), sorted.end(), int64_t{3}) -
+                  sorted.begin());
+  }
+}
+
+// Computes the upper bounds of random values in `num_boundaries` sorted
+// boundaries with std::upper_bound (0) or SortedBoundaries (1).
+void BM_UpperBound(::testing::benchmark::State& state) {
+  const int num_boundaries = state.range(0);
+  const bool use_sorted_boundaries = state.range(1);
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  const std::vector<float> sorted = RandomSorted(num_boundaries, &rand);
+  const SortedBoundaries<float> boundaries(sorted);
+  std::vector<float> values(1 << 16);
+  for (float& value : values) {
+    value = rand.RandFloat() * num_boundaries * 0.5f;
+  }
+  for (auto s : state) {
+    int64_t sum = 0;
+    if (use_sorted_boundaries) {
+      for (float value : values) sum += boundaries.UpperBound(value);
+    } else {
+      for (float value : values) {
+        sum += std::upper_bound(sorted.begin(), sorted.end(), value) -
+               sorted.begin();
+      }
+    }
+    testing::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(BM_UpperBound)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(100000, 0)
+    ->ArgPair(100000, 1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -282,6 +282,42 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
         csr_matrix.values_vec<T>(batch_index).data() + row_offset);
   }
 
+  // Splits the rows of the given batch of `csr_matrix` into `num_shards`
+  // contiguous ranges and returns their `num_shards + 1` boundaries. The
+  // ranges have about the same cost, counting one unit per nonzero and one per
+  // row, so that rows with many nonzeros, as in power-law graphs, do not end up
+  // in the same shard.
+  std::vector<int64_t> BalancedRowShardBoundaries(
+      const CSRSparseMatrix& csr_matrix, const int batch_index,
+      const int64_t num_rows, const int64_t num_shards) {
+    const auto row_ptrs = csr_matrix.row_pointers_vec(batch_index);
+    const int64_t row_offset = row_ptrs(0);
+    // Cost of the rows [0, row); non-decreasing in `row`.
+    auto cost_before = [&](int64_t row) {
+      return row_ptrs(row) - row_offset + row;
+    };
+    const int64_t total_cost = cost_before(num_rows);
+    std::vector<int64_t> boundaries(num_shards + 1);
+    boundaries[0] = 0;
+    for (int64_t shard = 1; shard < num_shards; ++shard) {
+      const int64_t target = shard * total_cost / num_shards;
+      int64_t lo = boundaries[shard - 1];
+      int64_t hi = num_rows;
+      // Finds the first row whose preceding rows cost at least `target`.
+      while (lo < hi) {
+        const int64_t mid = lo + (hi - lo) / 2;
+        if (cost_before(mid) < target) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      boundaries[shard] = lo;
+    }
+    boundaries[num_shards] = num_rows;
+    return boundaries;
+  }
+
   // Sparse-Dense Matrix Multiplication between a CSRSparseMatrix (LHS) and a
   // dense Tensor (RHS).
   void SparseDenseMatMulWithoutTransposedLHS(OpKernelContext* ctx,
@@ -291,45 +327,56 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
                                              const Tensor& rhs,
                                              Tensor* output) {
     // Parallelize matrix multiplication across batch dimensions and across
-    // rows in each batch.
+    // rows in each batch. The rows of each batch are split into shards by
+    // their number of nonzeros rather than by their count.
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int32_t num_threads = worker_threads.num_threads;
-    const int64_t block_size =
-        num_lhs_rows / std::max(kMaxShards, kNumShardsPerThread * num_threads);
+    const int64_t num_shards = std::max<int64_t>(
+        1, std::min<int64_t>(
+               num_lhs_rows,
+               std::max(kMaxShards, kNumShardsPerThread * num_threads)));
+    std::vector<std::vector<int64_t>> shard_boundaries(batch_size);
+    for (int64_t batch_idx = 0; batch_idx < batch_size; ++batch_idx) {
+      shard_boundaries[batch_idx] =
+          BalancedRowShardBoundaries(lhs, batch_idx, num_lhs_rows, num_shards);
+    }
     const int64_t num_rhs_rows = rhs.dim_size(rhs.dims() - 2);
     const int64_t num_rhs_cols = rhs.dim_size(rhs.dims() - 1);
     worker_threads.workers->ParallelFor(
-        batch_size * num_lhs_rows /* total */,
+        batch_size * num_shards /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64_t batch_and_row_begin, int64_t batch_and_row_end) {
-          HandleBatchAndRowRange(
-              num_lhs_rows, batch_and_row_begin, batch_and_row_end,
-              [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
-                const int64_t num_shard_rows = row_end - row_begin;
-
-                // Define an Eigen::SparseMatrix over the row range:
-                // [row_begin, row_end) of the CSR SparseMatrix A.
-                std::vector<int32> row_ptrs;
-                auto sparse_matrix = GetSparseMatrixRef(
-                    lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
-
-                // Map the corresponding rows of the rhs.
-                ConstMatrixMap rhs_map(rhs.flat<T>().data() + batch_idx *
-                                                                  num_rhs_rows *
-                                                                  num_rhs_cols,
-                                       num_rhs_rows, num_rhs_cols);
-
-                // Write to the corresponding rows of the output matrix.
-                MatrixMap output_map(
-                    output->flat<T>().data() +
-                        batch_idx * num_lhs_rows * num_rhs_cols +
-                        row_begin * num_rhs_cols,
-                    num_shard_rows, num_rhs_cols);
-                output_map.noalias() = sparse_matrix * rhs_map;
-              });
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64_t batch_and_shard_begin, int64_t batch_and_shard_end) {
+          for (int64_t batch_and_shard = batch_and_shard_begin;
+               batch_and_shard < batch_and_shard_end; ++batch_and_shard) {
+            const int64_t batch_idx = batch_and_shard / num_shards;
+            const int64_t shard = batch_and_shard % num_shards;
+            const int64_t row_begin = shard_boundaries[batch_idx][shard];
+            const int64_t row_end = shard_boundaries[batch_idx][shard + 1];
+            const int64_t num_shard_rows = row_end - row_begin;
+            if (num_shard_rows == 0) continue;
+
+            // Define an Eigen::SparseMatrix over the row range:
+            // [row_begin, row_end) of the CSR SparseMatrix A.
+            std::vector<int32> row_ptrs;
+            auto sparse_matrix = GetSparseMatrixRef(
+                lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
+
+            // Map the corresponding rows of the rhs.
+            ConstMatrixMap rhs_map(
+                rhs.flat<T>().data() + batch_idx * num_rhs_rows * num_rhs_cols,
+                num_rhs_rows, num_rhs_cols);
+
+            // Write to the corresponding rows of the output matrix.
+            MatrixMap output_map(
+                output->flat<T>().data() +
+                    batch_idx * num_lhs_rows * num_rhs_cols +
+                    row_begin * num_rhs_cols,
+                num_shard_rows, num_rhs_cols);
+            output_map.noalias() = sparse_matrix * rhs_map;
+          }
         });
   }
 
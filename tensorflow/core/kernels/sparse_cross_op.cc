@@ -319,11 +319,92 @@ class StringCrosser {
     return absl::StrJoin(cross_vec, k_feature_separator_);
   }
 
+  // Passes all the crosses of `batch_index` to `updater`.
+  template <typename Updater>
+  void GenerateBatch(const int64_t batch_index, bool unused_strong_hash,
+                     const Updater& updater) const;
+
  private:
   const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
   const tstring k_feature_separator_;
 };
 
+// Returns the output value of a hashed cross given its fingerprint.
+int64_t HashedCrossOutput(uint64 hashed_output, int64_t num_buckets) {
+  // The return value is int64 based on the number of buckets.
+  if (num_buckets > 0) {
+    return hashed_output % num_buckets;
+  } else {
+    // To prevent negative output we take modulo to max int64.
+    return hashed_output % std::numeric_limits<int64_t>::max();
+  }
+}
+
+// Passes the hashed crosses of `batch_index` to `updater`, in the order of
+// `ProductIterator`. The crosses are fingerprinted as
+// FingerprintCat64(...FingerprintCat64(h_0, h_1)..., h_n), where h_0 is
+// combined with `*hash_key` first if it is given.
+//
+// Every feature is hashed once per batch rather than once per cross, and the
+// fingerprint of the leading features is shared by all the crosses that start
+// with them, so most crosses take a single FingerprintCat64 and no strings are
+// formed.
+template <typename Updater>
+void GenerateHashedCrosses(
+    const std::vector<std::unique_ptr<ColumnInterface<int64_t>>>& columns,
+    const int64_t batch_index, const bool strong_hash, const uint64* hash_key,
+    const int64_t num_buckets, const Updater& updater) {
+  const int num_columns = columns.size();
+  if (num_columns == 0) {
+    if (hash_key != nullptr) {
+      updater.Update(batch_index, 0, HashedCrossOutput(*hash_key, num_buckets));
+    }
+    return;
+  }
+  gtl::InlinedVector<std::vector<uint64>, 6> feature_hashes(num_columns);
+  for (int i = 0; i < num_columns; ++i) {
+    const int64_t feature_count = columns[i]->FeatureCount(batch_index);
+    // If one column is missing any feature, there won't be any cross.
+    if (feature_count == 0) return;
+    feature_hashes[i].resize(feature_count);
+    for (int64_t n = 0; n < feature_count; ++n) {
+      feature_hashes[i][n] = columns[i]->Feature(batch_index, n, strong_hash);
+    }
+  }
+
+  // prefix_hashes[i] is the fingerprint of the features of the columns
+  // [0, i] in the current permutation.
+  gtl::InlinedVector<int64_t, 6> permutation(num_columns, 0);
+  gtl::InlinedVector<uint64, 6> prefix_hashes(num_columns);
+  auto update_prefix_hashes = [&](int first_column) {
+    for (int i = first_column; i < num_columns; ++i) {
+      const uint64 hash_i = feature_hashes[i][permutation[i]];
+      if (i > 0) {
+        prefix_hashes[i] = FingerprintCat64(prefix_hashes[i - 1], hash_i);
+      } else if (hash_key != nullptr) {
+        prefix_hashes[i] = FingerprintCat64(*hash_key, hash_i);
+      } else {
+        prefix_hashes[i] = hash_i;
+      }
+    }
+  };
+  update_prefix_hashes(0);
+  for (int64_t cross_count = 0;; ++cross_count) {
+    updater.Update(
+        batch_index, cross_count,
+        HashedCrossOutput(prefix_hashes[num_columns - 1], num_buckets));
+    // Advances to the next permutation, the last column moving fastest.
+    int i = num_columns - 1;
+    while (i >= 0 &&
+           ++permutation[i] == static_cast<int64_t>(feature_hashes[i].size())) {
+      permutation[i] = 0;
+      --i;
+    }
+    if (i < 0) break;
+    update_prefix_hashes(i);
+  }
+}
+
 // Generates the sparse crosses as nested hash to avoid string manipulations.
 class HashCrosser {
  public:
@@ -333,22 +414,12 @@ class HashCrosser {
       const tstring k_feature_separator_unused)
       : columns_(columns), num_buckets_(num_buckets), hash_key_(hash_key) {}
 
-  int64_t Generate(const int64_t batch_index,
-                   const std::vector<int>& permutation,
-                   bool unused_strong_hash) const {
-    // Do the fingerprint concatenation on uint64.
-    uint64 hashed_output = hash_key_;
-    for (size_t i = 0; i < permutation.size(); ++i) {
-      uint64 hash_i = columns_[i]->Feature(batch_index, permutation[i], false);
-      hashed_output = FingerprintCat64(hashed_output, hash_i);
-    }
-    // The return value is int64 based on the number of buckets.
-    if (num_buckets_ > 0) {
-      return hashed_output % num_buckets_;
-    } else {
-      // To prevent negative output we take modulo to max int64.
-      return hashed_output % std::numeric_limits<int64_t>::max();
-    }
+  // Passes all the crosses of `batch_index` to `updater`.
+  template <typename Updater>
+  void GenerateBatch(const int64_t batch_index, bool unused_strong_hash,
+                     const Updater& updater) const {
+    GenerateHashedCrosses(columns_, batch_index, /*strong_hash=*/false,
+                          &hash_key_, num_buckets_, updater);
   }
 
  private:
@@ -366,24 +437,12 @@ class HashCrosserV2 {
       const tstring k_feature_separator_unused)
       : columns_(columns), num_buckets_(num_buckets) {}
 
-  int64_t Generate(const int64_t batch_index,
-                   const std::vector<int>& permutation,
-                   bool strong_hash) const {
-    // Do the fingerprint concatenation on uint64.
-    uint64 hashed_output =
-        columns_[0]->Feature(batch_index, permutation[0], strong_hash);
-    for (size_t i = 1; i < permutation.size(); ++i) {
-      uint64 hash_i =
-          columns_[i]->Feature(batch_index, permutation[i], strong_hash);
-      hashed_output = FingerprintCat64(hashed_output, hash_i);
-    }
-    // The return value is int64 based on the number of buckets.
-    if (num_buckets_ > 0) {
-      return hashed_output % num_buckets_;
-    } else {
-      // To prevent negative output we take modulo to max int64.
-      return hashed_output % std::numeric_limits<int64_t>::max();
-    }
+  // Passes all the crosses of `batch_index` to `updater`.
+  template <typename Updater>
+  void GenerateBatch(const int64_t batch_index, bool strong_hash,
+                     const Updater& updater) const {
+    GenerateHashedCrosses(columns_, batch_index, strong_hash,
+                          /*hash_key=*/nullptr, num_buckets_, updater);
   }
 
  private:
@@ -440,6 +499,21 @@ class ProductIterator {
   std::vector<int> next_permutation_;
 };
 
+template <typename InternalType>
+template <typename Updater>
+void StringCrosser<InternalType>::GenerateBatch(const int64_t batch_index,
+                                                bool unused_strong_hash,
+                                                const Updater& updater) const {
+  ProductIterator<InternalType> product_iterator(columns_, batch_index);
+  int64_t cross_count = 0;
+  while (product_iterator.HasNext()) {
+    const auto permutation = product_iterator.Next();
+    updater.Update(batch_index, cross_count,
+                   Generate(batch_index, permutation, false));
+    cross_count++;
+  }
+}
+
 template <bool HASHED_OUTPUT, typename InternalType>
 struct CrossTraits;
 
@@ -783,16 +857,9 @@ class SparseCrossOp : public OpKernel {
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Updater updater(
         output_start_indices, indices_out, values_out);
-    auto do_work = [&columns, crosser, updater](int64_t begin, int64_t end) {
+    auto do_work = [&crosser, &updater](int64_t begin, int64_t end) {
       for (int b = begin; b < end; b++) {
-        ProductIterator<InternalType> product_iterator(columns, b);
-        int64_t cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count,
-                         crosser.Generate(b, permutation, false));
-          cross_count++;
-        }
+        crosser.GenerateBatch(b, false, updater);
       }
     };
 
@@ -850,16 +917,9 @@ class SparseCrossV2Op : public OpKernel {
     StringCrosser<tstring> crosser(columns, 0, 0, separator);
     OutputUpdater<tstring> updater(output_start_indices, indices_out,
                                    values_out);
-    auto do_work = [&columns, crosser, updater](int64_t begin, int64_t end) {
+    auto do_work = [&crosser, &updater](int64_t begin, int64_t end) {
       for (int b = begin; b < end; b++) {
-        ProductIterator<tstring> product_iterator(columns, b);
-        int64_t cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count,
-                         crosser.Generate(b, permutation, false));
-          cross_count++;
-        }
+        crosser.GenerateBatch(b, false, updater);
       }
     };
 
@@ -924,17 +984,10 @@ class SparseCrossHashedOp : public OpKernel {
     HashCrosserV2 crosser(columns, num_buckets, 0, unused_sep);
     OutputUpdater<int64_t> updater(output_start_indices, indices_out,
                                    values_out);
-    auto do_work = [&columns, crosser, updater, strong_hash](int64_t begin,
-                                                             int64_t end) {
+    auto do_work = [&crosser, &updater, strong_hash](int64_t begin,
+                                                     int64_t end) {
       for (int b = begin; b < end; b++) {
-        ProductIterator<int64> product_iterator(columns, b);
-        int64_t cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count,
-                         crosser.Generate(b, permutation, strong_hash));
-          cross_count++;
-        }
+        crosser.GenerateBatch(b, strong_hash, updater);
       }
     };
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/random_poisson_op.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -201,6 +202,87 @@ class StatelessRandomPoissonOp : public StatelessRandomOpBase {
   TF_DISALLOW_COPY_AND_ASSIGN(StatelessRandomPoissonOp);
 };
 
+// Applies dropout to a tensor with the samples of StatelessRandomUniform for
+// the same seed, generating and applying the samples in one pass.
+template <typename T>
+class StatelessDropoutOp : public OpKernel {
+ public:
+  explicit StatelessDropoutOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& rate_t = context->input(1);
+    const Tensor& seed_t = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(rate_t.shape()),
+                errors::InvalidArgument("rate must be 0-D, got shape ",
+                                        rate_t.shape().DebugString()));
+    OP_REQUIRES(context, seed_t.dims() == 1 && seed_t.dim_size(0) == 2,
+                errors::InvalidArgument("seed must have shape [2], not ",
+                                        seed_t.shape().DebugString()));
+    const T rate = rate_t.scalar<T>()();
+    OP_REQUIRES(context, rate >= T(0) && rate < T(1),
+                errors::InvalidArgument("rate must be in [0, 1), got ",
+                                        static_cast<float>(rate)));
+
+    Tensor* output;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &output));
+    const int64_t size = x.NumElements();
+    if (size == 0) return;
+
+    random::PhiloxRandom::Key key;
+    random::PhiloxRandom::ResultType counter;
+    OP_REQUIRES_OK(context, GenerateKey(seed_t, &key, &counter));
+    const random::PhiloxRandom philox(counter, key);
+
+    typedef random::UniformDistribution<random::BatchedPhiloxRandom, T>
+        Distribution;
+    const int kGroupSize = Distribution::kResultElementCount;
+    const int kGroupCost =
+        random::PhiloxRandom::kResultElementCount *
+            (random::PhiloxRandom::kElementCost + Distribution::kElementCost) +
+        2 * kGroupSize;
+    // The same computation as the unfused `x * scale * (uniform >= rate)`.
+    const T scale = T(1) / (T(1) - rate);
+    const T* in = x.flat<T>().data();
+    T* out = output->flat<T>().data();
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          (size + kGroupSize - 1) / kGroupSize, kGroupCost,
+          [&](int64_t start_group, int64_t limit_group) {
+            random::PhiloxRandom gen = philox;
+            gen.Skip(start_group);
+            random::BatchedPhiloxRandom batched_gen(gen);
+            Distribution dist;
+            for (int64_t group = start_group; group < limit_group; ++group) {
+              const auto samples = dist(&batched_gen);
+              const int64_t offset = group * kGroupSize;
+              const int n = std::min<int64_t>(kGroupSize, size - offset);
+              for (int i = 0; i < n; ++i) {
+                out[offset + i] = in[offset + i] * scale *
+                                  static_cast<T>(samples[i] >= rate);
+              }
+            }
+          });
+  }
+};
+
+#define REGISTER_DROPOUT(TYPE)                            \
+  REGISTER_KERNEL_BUILDER(Name("StatelessDropout")        \
+                              .Device(DEVICE_CPU)         \
+                              .HostMemory("rate")         \
+                              .HostMemory("seed")         \
+                              .TypeConstraint<TYPE>("T"), \
+                          StatelessDropoutOp<TYPE>)
+
+TF_CALL_half(REGISTER_DROPOUT);
+TF_CALL_bfloat16(REGISTER_DROPOUT);
+TF_CALL_float(REGISTER_DROPOUT);
+TF_CALL_double(REGISTER_DROPOUT);
+
+#undef REGISTER_DROPOUT
+
 #define REGISTER(DEVICE, TYPE)                                              \
   REGISTER_KERNEL_BUILDER(                                                  \
       Name("StatelessRandomUniform")                                        \
@@ -329,6 +329,11 @@ class StridedSliceAssignOp : public OpKernel {
                         "l-value dtype ", DataTypeString(old_lhs->dtype()),
                         " does not match r-value dtype ",
                         DataTypeString(DataTypeToEnum<T>::value)));
+        if (v->snapshot_mode) {
+          OP_REQUIRES_OK(context, PrepareToUpdateVariable<Device, T>(
+                                      context, v->tensor(),
+                                      /*copy_on_read_mode=*/false));
+        }
       } else {
         context->forward_ref_input_to_ref_output(0, 0);
         tmp = context->mutable_input(0, true);
@@ -23,17 +23,48 @@ limitations under the License.
 #include "tensorflow/core/summary/schema.h"
 #include "tensorflow/core/summary/summary_db_writer.h"
 #include "tensorflow/core/summary/summary_file_writer.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/event.pb.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Reads whether the summary file writers write on a background thread, and
+// what they do when their queue is full, from the environment.
+Status ReadAsyncSummaryOptionsFromEnv(SummaryFileWriterOptions* options) {
+  TF_RETURN_IF_ERROR(
+      ReadBoolFromEnvVar("TF_ASYNC_SUMMARY_WRITES", false, &options->async));
+  string policy;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar("TF_ASYNC_SUMMARY_OVERFLOW_POLICY",
+                                          "block", &policy));
+  if (policy == "block") {
+    options->overflow_policy = SummaryQueueOverflowPolicy::kBlock;
+  } else if (policy == "drop_newest") {
+    options->overflow_policy = SummaryQueueOverflowPolicy::kDropNewest;
+  } else if (policy == "drop_oldest") {
+    options->overflow_policy = SummaryQueueOverflowPolicy::kDropOldest;
+  } else if (policy == "coalesce") {
+    options->overflow_policy = SummaryQueueOverflowPolicy::kCoalesce;
+  } else {
+    return errors::InvalidArgument(
+        "Invalid TF_ASYNC_SUMMARY_OVERFLOW_POLICY: ", policy,
+        ". Expected one of block, drop_newest, drop_oldest and coalesce.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 REGISTER_KERNEL_BUILDER(Name("SummaryWriter").Device(DEVICE_CPU),
                         ResourceHandleOp<SummaryWriterInterface>);
 
 class CreateSummaryFileWriterOp : public OpKernel {
  public:
   explicit CreateSummaryFileWriterOp(OpKernelConstruction* ctx)
-      : OpKernel(ctx) {}
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ReadAsyncSummaryOptionsFromEnv(&options_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor* tmp;
@@ -54,16 +85,26 @@ class CreateSummaryFileWriterOp : public OpKernel {
                 errors::InvalidArgument("filename_suffix must be a scalar"));
     const string filename_suffix = tmp->scalar<tstring>()();
 
+    SummaryFileWriterOptions options = options_;
+    options.max_queue = max_queue;
+    options.flush_millis = flush_millis;
+
     core::RefCountPtr<SummaryWriterInterface> s;
     OP_REQUIRES_OK(ctx, LookupOrCreateResource<SummaryWriterInterface>(
                             ctx, HandleFromInput(ctx, 0), &s,
-                            [max_queue, flush_millis, logdir, filename_suffix,
+                            [options, logdir, filename_suffix,
                              ctx](SummaryWriterInterface** s) {
-                              return CreateSummaryFileWriter(
-                                  max_queue, flush_millis, logdir,
-                                  filename_suffix, ctx->env(), s);
+                              SummaryFileWriterInterface* writer = nullptr;
+                              const Status status = CreateSummaryFileWriter(
+                                  options, logdir, filename_suffix,
+                                  ctx->env(), &writer);
+                              *s = writer;
+                              return status;
                             }));
   }
+
+ private:
+  SummaryFileWriterOptions options_;
 };
 REGISTER_KERNEL_BUILDER(Name("CreateSummaryFileWriter").Device(DEVICE_CPU),
                         CreateSummaryFileWriterOp);
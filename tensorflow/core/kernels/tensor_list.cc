@@ -25,6 +25,30 @@ TensorList::~TensorList() {
   if (tensors_) tensors_->Unref();
 }
 
+bool TensorList::GetStackedElements(int64_t begin, int64_t end,
+                                    Tensor* stacked) const {
+  const Tensor& storage = tensors_->storage_;
+  if (!storage.IsInitialized() || !DataTypeCanUseMemcpy(storage.dtype()) ||
+      storage.dims() == 0 || begin < 0 || begin >= end ||
+      end > storage.dim_size(0) || end > tensors().size()) {
+    return false;
+  }
+  TensorShape element_shape = storage.shape();
+  element_shape.RemoveDim(0);
+  const StringPiece data = storage.tensor_data();
+  const size_t element_bytes = data.size() / storage.dim_size(0);
+  for (int64_t i = begin; i < end; ++i) {
+    const Tensor& t = tensors()[i];
+    if (t.dtype() != storage.dtype() || t.shape() != element_shape ||
+        !t.SharesBufferWith(storage) ||
+        t.tensor_data().data() != data.data() + i * element_bytes) {
+      return false;
+    }
+  }
+  *stacked = storage.Slice(begin, end);
+  return true;
+}
+
 void TensorList::Encode(VariantTensorData* data) const {
   data->set_type_name(TypeName());
   std::vector<size_t> invalid_indices;
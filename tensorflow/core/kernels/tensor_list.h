@@ -134,9 +134,20 @@ class TensorList {
     out.max_num_elements = max_num_elements;
     // This performs a copy of the std::vector.
     out.tensors_->values_ = tensors_->values_;
+    out.tensors_->storage_ = tensors_->storage_;
     return out;
   }
 
+  // Sets the tensor whose slices along its first dimension are the elements,
+  // e.g. for lists made from a tensor. Elements which are still those slices
+  // can then be stacked without copying them. The storage is kept alive by the
+  // list even after its elements are replaced.
+  void set_storage(const Tensor& storage) { tensors_->storage_ = storage; }
+
+  // If the elements [begin, end) are the slices [begin, end) of the storage,
+  // sets `*stacked` to these slices of the storage and returns true.
+  bool GetStackedElements(int64_t begin, int64_t end, Tensor* stacked) const;
+
   // Is this TensorList the only one with a reference to the underlying
   // container?
   bool RefCountIsOne() const { return tensors_->RefCountIsOne(); }
@@ -145,6 +156,7 @@ class TensorList {
   class Tensors : public core::RefCounted {
    public:
     std::vector<Tensor> values_;
+    Tensor storage_;
   };
   Tensors* tensors_;
 };
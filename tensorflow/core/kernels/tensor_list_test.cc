@@ -0,0 +1,87 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/tensor_list.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns a list of the slices of `storage`.
+TensorList ListOfSlices(const Tensor& storage) {
+  TensorList list;
+  list.element_dtype = storage.dtype();
+  for (int64_t i = 0; i < storage.dim_size(0); ++i) {
+    Tensor element = storage.SubSlice(i);
+    list.tensors().push_back(element);
+  }
+  list.set_storage(storage);
+  return list;
+}
+
+TEST(TensorListTest, GetStackedElementsOfSlices) {
+  Tensor storage(DT_FLOAT, TensorShape({4, 16}));
+  test::FillIota<float>(&storage, 0.0f);
+  const TensorList list = ListOfSlices(storage);
+
+  Tensor stacked;
+  ASSERT_TRUE(list.GetStackedElements(0, 4, &stacked));
+  EXPECT_TRUE(stacked.SharesBufferWith(storage));
+  test::ExpectTensorEqual<float>(storage, stacked);
+
+  ASSERT_TRUE(list.GetStackedElements(1, 3, &stacked));
+  EXPECT_EQ(stacked.tensor_data().data(),
+            list.tensors()[1].tensor_data().data());
+  test::ExpectTensorEqual<float>(storage.Slice(1, 3), stacked);
+
+  EXPECT_FALSE(list.GetStackedElements(2, 2, &stacked));
+  EXPECT_FALSE(list.GetStackedElements(3, 5, &stacked));
+  EXPECT_FALSE(list.GetStackedElements(-1, 2, &stacked));
+}
+
+TEST(TensorListTest, GetStackedElementsOfReplacedElements) {
+  Tensor storage(DT_FLOAT, TensorShape({4, 16}));
+  test::FillIota<float>(&storage, 0.0f);
+  TensorList list = ListOfSlices(storage);
+  list.tensors()[2] = Tensor(DT_FLOAT, TensorShape({16}));
+  list.tensors().push_back(storage.SubSlice(0));
+
+  Tensor stacked;
+  EXPECT_TRUE(list.GetStackedElements(0, 2, &stacked));
+  EXPECT_FALSE(list.GetStackedElements(0, 3, &stacked));
+  EXPECT_FALSE(list.GetStackedElements(0, 5, &stacked));
+
+  // Copies of the list keep the storage, but have their own elements.
+  TensorList copy = list.Copy();
+  copy.tensors()[2] = storage.SubSlice(2);
+  EXPECT_TRUE(copy.GetStackedElements(0, 4, &stacked));
+  EXPECT_FALSE(list.GetStackedElements(0, 4, &stacked));
+}
+
+TEST(TensorListTest, GetStackedElementsWithoutStorage) {
+  TensorList list;
+  list.element_dtype = DT_FLOAT;
+  list.tensors().push_back(Tensor(DT_FLOAT, TensorShape({16})));
+  Tensor stacked;
+  EXPECT_FALSE(list.GetStackedElements(0, 1, &stacked));
+}
+
+}  // namespace
+
+}  // namespace tensorflow
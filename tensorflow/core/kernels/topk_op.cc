@@ -20,8 +20,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/topk_op.h"
 
 #include <algorithm>
+#include <memory>
 #include <numeric>
 #include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -36,6 +39,107 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace {
+
+// A row is only split across threads when every chunk gets at least this many
+// columns, and at least `kMinChunkSizePerK * k` columns.
+constexpr int64_t kMinChunkSize = 32 * 1024;
+constexpr int64_t kMinChunkSizePerK = 8;
+// The number of columns that are compared to the threshold at once.
+constexpr int kFilterBlockSize = 16;
+
+// Returns the number of chunks to split a row into for `TopKByChunks`, or 1 if
+// the rows should rather be sharded as a whole.
+int64_t NumTopKChunks(int num_threads, int k, int64_t num_rows,
+                      int64_t num_cols) {
+  if (k == num_cols || num_rows >= num_threads) return 1;
+  const int64_t min_chunk_size =
+      std::max(kMinChunkSize, kMinChunkSizePerK * static_cast<int64_t>(k));
+  return std::max<int64_t>(
+      1, std::min<int64_t>(num_threads, num_cols / min_chunk_size));
+}
+
+// Computes the indices of the top `k` elements of one row of `num_cols`
+// elements with `num_chunks` threads. Each thread selects the top `k` of its
+// chunk with a `TopN` heap; once the heap is full, only elements greater than
+// its bottom can enter it, so blocks of columns that are all at most the bottom
+// are skipped with a branch-free comparison the compiler can vectorize. The
+// candidates of all chunks are then merged with another `TopN`. Ties are
+// broken by the lower index, as for a single `TopN` over the whole row.
+template <typename T>
+void TopKByChunks(const DeviceBase::CpuWorkerThreads& worker_threads,
+                  bool sorted, int k, const T* input_data, int64_t num_cols,
+                  int64_t num_chunks, int32* indices) {
+  const auto stable_comp = [input_data](const int32_t a, const int32_t b) {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  };
+  const int64_t chunk_size = MathUtil::CeilOfRatio(num_cols, num_chunks);
+  std::vector<std::unique_ptr<std::vector<int32>>> candidates(num_chunks);
+  auto select_chunks = [&](int64_t start_chunk, int64_t limit_chunk) {
+    for (int64_t chunk = start_chunk; chunk < limit_chunk; ++chunk) {
+      const int32 begin = chunk * chunk_size;
+      const int32 end = std::min(num_cols, (chunk + 1) * chunk_size);
+      gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
+      filter.reserve(k + 1);
+      int32 c = begin;
+      for (; c < end && filter.size() < static_cast<size_t>(k); ++c) {
+        filter.push(c);
+      }
+      if (c == end) {
+        candidates[chunk].reset(filter.ExtractUnsorted());
+        continue;
+      }
+      // Columns are visited in increasing order, so an element equal to the
+      // bottom loses the tie and never enters the heap.
+      T threshold = input_data[filter.peek_bottom()];
+      auto push_if_greater = [&](int32 col) {
+        if (input_data[col] > threshold) {
+          filter.push(col);
+          threshold = input_data[filter.peek_bottom()];
+        }
+      };
+      for (; c + kFilterBlockSize <= end; c += kFilterBlockSize) {
+        bool any_greater = false;
+        for (int i = 0; i < kFilterBlockSize; ++i) {
+          any_greater |= input_data[c + i] > threshold;
+        }
+        if (!any_greater) continue;
+        for (int i = 0; i < kFilterBlockSize; ++i) {
+          push_if_greater(c + i);
+        }
+      }
+      for (; c < end; ++c) {
+        push_if_greater(c);
+      }
+      candidates[chunk].reset(filter.ExtractUnsorted());
+    }
+  };
+  const double cost_per_chunk =
+      chunk_size * (Eigen::TensorOpCost::AddCost<T>() +
+                    Eigen::TensorOpCost::AddCost<int32>());
+  Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+        static_cast<int64_t>(cost_per_chunk), select_chunks);
+
+  gtl::TopN<int32, decltype(stable_comp)> merged(k, stable_comp);
+  merged.reserve(num_chunks * k);
+  for (const auto& chunk_candidates : candidates) {
+    for (int32 c : *chunk_candidates) {
+      merged.push(c);
+    }
+  }
+  std::unique_ptr<std::vector<int32>> top_k(sorted ? merged.Extract()
+                                                   : merged.ExtractUnsorted());
+  std::copy(top_k->begin(), top_k->end(), indices);
+}
+
+}  // namespace
+
 template <typename Device, typename T>
 class TopK : public OpKernel {
  public:
@@ -146,6 +250,23 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // A few long rows, as in retrieval over a large vocabulary, are split into
+    // chunks that are searched in parallel.
+    const int64_t num_chunks =
+        NumTopKChunks(worker_threads.num_threads, k, num_rows, num_cols);
+    if (num_chunks > 1) {
+      for (int64_t b = 0; b < num_rows; ++b) {
+        TopKByChunks<T>(worker_threads, sorted, k, &input(b, 0), num_cols,
+                        num_chunks, &indices(b, 0));
+        std::transform(
+            &indices(b, 0), &indices(b, k), &values(b, 0),
+            [b, &input](const int32_t loc) { return input(b, loc); });
+      }
+      return Status::OK();
+    }
+
     auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
       for (int32_t b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
@@ -233,7 +354,6 @@ struct TopKFunctor<CPUDevice, T> {
     const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
@@ -30,7 +30,8 @@ namespace tensorflow {
 // lock.
 template <typename Device, typename T>
 Status EnsureSparseVariableAccess(OpKernelContext* ctx, Var* var) {
-  if (var->copy_on_read_mode.load()) {
+  // Variables in snapshot mode are sparsely accessed in copy-on-write mode.
+  if (var->copy_on_read_mode.load() || var->snapshot_mode) {
     return Status::OK();
   }
   mutex_lock ml(*var->mu());
@@ -133,9 +134,10 @@ mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input, bool sparse,
 // variable gets switched to copy-on-read mode before trying to acquire the
 // locks. If do_lock is false, returns immediately for reference variables. For
 // resource variables in copy-on-read-mode it will grab a shared lock if do_lock
-// is false, exclusive lock otherwise.  Note that this silently doesn't lock
-// mutexes for invalid variable references; in all usages this is followed by
-// GetInputTensor which will signal a failure.
+// is false, exclusive lock otherwise. Variables in snapshot mode are always
+// locked exclusively, as their updates may replace their tensor.  Note that
+// this silently doesn't lock mutexes for invalid variable references; in all
+// usages this is followed by GetInputTensor which will signal a failure.
 template <typename Device, typename T>
 VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
     OpKernelContext* ctx, bool do_lock, bool sparse,
@@ -176,7 +178,7 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
     mutex* mu = GetTrainingVariableMutex<Device, T>(ctx, input, sparse, &var);
     core::ScopedUnref scoped_unref(var);
     if (mu != nullptr) {
-      if (!sparse || do_lock) {
+      if (!sparse || do_lock || (var != nullptr && var->snapshot_mode)) {
         locks->emplace_back(*mu);
       } else {
         shared_locks->emplace_back(*mu);
@@ -232,8 +234,9 @@ Status PrepareToUpdateVariable(OpKernelContext* ctx, Tensor* tensor,
 // the tensor, grabbing the lock if lock_held is False.
 //
 // For resource variables we, if sparse is true, ensure it's in copy-on-read
-// mode, and then, regardless of the value of sparse, ensure its refcount is 1
-// (by potentially copying its contents). In this case lock_held is ignored.
+// mode unless it is in snapshot mode, and then, regardless of the value of
+// sparse, ensure its refcount is 1 (by potentially copying its contents). In
+// this case lock_held is ignored.
 template <typename Device, typename T>
 Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
                                   bool lock_held, bool sparse, Tensor* out) {
@@ -242,8 +245,10 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     TF_RETURN_IF_ERROR(LookupResource(ctx, HandleFromInput(ctx, input), &var));
     if (sparse) {
       TF_RETURN_IF_ERROR(EnsureSparseVariableAccess<Device, T>(ctx, var.get()));
-      *out = *var->tensor();
-      return Status::OK();
+      if (!var->snapshot_mode) {
+        *out = *var->tensor();
+        return Status::OK();
+      }
     }
     TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(
         ctx, var->tensor(), var->copy_on_read_mode.load()));
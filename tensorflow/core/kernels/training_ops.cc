@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <algorithm>  // NOLINT
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -3654,6 +3655,194 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Applies Adam to the rows of `var` that `indices` refers to and leaves the
+// slots of all other rows untouched. Duplicate indices are first combined by
+// summing their gradient rows, so every row is updated exactly once and the
+// per-row updates can run in parallel without racing.
+template <typename T, typename Tindex>
+class SparseApplyLazyAdamOp : public OpKernel {
+ public:
+  explicit SparseApplyLazyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+  }
+
+  void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
+    const bool sparse = true;
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+
+    Tensor var;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor m;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &m));
+    Tensor v;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, sparse, &v));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, m.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    OP_REQUIRES(
+        ctx, v.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(2)));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(m.shape()),
+                errors::InvalidArgument("var and m do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        m.shape().DebugString()));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(v.shape()),
+                errors::InvalidArgument("var and v do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        v.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(var.shape()),
+                errors::InvalidArgument("var must be at least 1 dimensional"));
+
+    const Tensor& beta1_power = ctx->input(3);
+    const Tensor& beta2_power = ctx->input(4);
+    const Tensor& lr = ctx->input(5);
+    const Tensor& beta1 = ctx->input(6);
+    const Tensor& beta2 = ctx->input(7);
+    const Tensor& epsilon = ctx->input(8);
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1_power.shape()),
+                errors::InvalidArgument("beta1_power is not a scalar: ",
+                                        beta1_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2_power.shape()),
+                errors::InvalidArgument("beta2_power is not a scalar: ",
+                                        beta2_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar : ",
+                                        lr.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1.shape()),
+                errors::InvalidArgument("beta1 is not a scalar: ",
+                                        beta1.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2.shape()),
+                errors::InvalidArgument("beta2 is not a scalar: ",
+                                        beta2.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(epsilon.shape()),
+                errors::InvalidArgument("epsilon is not a scalar: ",
+                                        epsilon.shape().DebugString()));
+
+    const Tensor& grad = ctx->input(9);
+    const Tensor& indices = ctx->input(10);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices must be one-dimensional"));
+    OP_REQUIRES(ctx, var.dims() == grad.dims(),
+                errors::InvalidArgument(
+                    "var and grad must have the same rank: ",
+                    var.shape().DebugString(), " ",
+                    grad.shape().DebugString()));
+
+    int64_t inner_dim = 1;
+    for (int d = 1; d < var.dims(); d++) {
+      OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
+                  errors::InvalidArgument(strings::StrCat(
+                      "var and grad must match in dimension ", d)));
+      inner_dim *= grad.dim_size(d);
+    }
+    const Tindex N = indices.dim_size(0);
+    OP_REQUIRES(
+        ctx, grad.dim_size(0) == N,
+        errors::InvalidArgument(
+            "grad must be the same size as indices in the first dimension."));
+    if (N == 0 || inner_dim == 0) {
+      return;
+    }
+
+    // Maps every distinct index to a row of `unique_grad`, in order of first
+    // occurrence.
+    const auto indices_vec = indices.vec<Tindex>();
+    const Tindex first_dim_size = var.dim_size(0);
+    absl::flat_hash_map<Tindex, int64_t> slots;
+    slots.reserve(N);
+    std::vector<Tindex> unique_indices;
+    std::vector<int64_t> slot_of(N);
+    for (Tindex i = 0; i < N; ++i) {
+      const Tindex index = internal::SubtleMustCopy(indices_vec(i));
+      OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
+                  errors::InvalidArgument(
+                      strings::StrCat("Index ", index, " at offset ", i,
+                                      " in indices is out of range")));
+      auto inserted = slots.emplace(index, unique_indices.size());
+      if (inserted.second) {
+        unique_indices.push_back(index);
+      }
+      slot_of[i] = inserted.first->second;
+    }
+    const int64_t num_unique = unique_indices.size();
+
+    // Without duplicates the gradient rows are already in slot order.
+    Tensor unique_grad_t = grad;
+    if (num_unique < N) {
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                  TensorShape({num_unique, inner_dim}),
+                                  &unique_grad_t));
+      const auto grad_flat = grad.flat_outer_dims<T>();
+      auto summed = unique_grad_t.matrix<T>();
+      summed.setZero();
+      for (Tindex i = 0; i < N; ++i) {
+        summed.template chip<0>(slot_of[i]) += grad_flat.template chip<0>(i);
+      }
+    }
+    const auto unique_grad = unique_grad_t.flat_outer_dims<T>();
+
+    auto var_flat = var.flat_outer_dims<T>();
+    auto m_flat = m.flat_outer_dims<T>();
+    auto v_flat = v.flat_outer_dims<T>();
+    const T one(1);
+    const T beta1_t = beta1.scalar<T>()();
+    const T beta2_t = beta2.scalar<T>()();
+    const T epsilon_t = epsilon.scalar<T>()();
+    const T alpha = lr.scalar<T>()() *
+                    Eigen::numext::sqrt(one - beta2_power.scalar<T>()()) /
+                    (one - beta1_power.scalar<T>()());
+
+    // The unique rows are disjoint, so each shard owns the rows it updates.
+    auto update_rows = [&](int64_t start, int64_t end) {
+      for (int64_t j = start; j < end; ++j) {
+        const Tindex row = unique_indices[j];
+        auto g = unique_grad.template chip<0>(j);
+        auto m_row = m_flat.template chip<0>(row);
+        auto v_row = v_flat.template chip<0>(row);
+        m_row += (g - m_row) * (one - beta1_t);
+        v_row += (g.square() - v_row) * (one - beta2_t);
+        var_flat.template chip<0>(row) -=
+            (m_row * alpha) / (v_row.sqrt() + epsilon_t);
+      }
+    };
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/4 * inner_dim * sizeof(T),
+        /*bytes_stored=*/3 * inner_dim * sizeof(T),
+        /*compute_cycles=*/10 * inner_dim);
+    ctx->eigen_cpu_device().parallelFor(num_unique, cost, update_rows);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+};
+
+#define REGISTER_KERNELS(T, Tindices)                                    \
+  REGISTER_KERNEL_BUILDER(Name("ResourceSparseApplyLazyAdam")            \
+                              .Device(DEVICE_CPU)                        \
+                              .TypeConstraint<T>("T")                    \
+                              .TypeConstraint<Tindices>("Tindices"),     \
+                          SparseApplyLazyAdamOp<T, Tindices>);
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_KERNELS(T, int32);   \
+  REGISTER_KERNELS(T, int64_t);
+
+TF_CALL_FLOAT_TYPES(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdamWithAmsgradOp : public OpKernel {
  public:
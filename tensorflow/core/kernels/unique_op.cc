@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -25,7 +28,9 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +73,150 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Inputs with fewer elements than this are uniquified on a single thread,
+// since partitioning them costs more than it saves.
+constexpr int64_t kMinParallelUniqueSize = 256 * 1024;
+
+// `ParallelUnique` uniquifies a vector of integers on the CPU worker threads.
+// The generic version declines, so that the caller falls back to the serial
+// implementation; the specialization below handles `int32` and `int64` keys.
+template <typename T, typename TIndex,
+          bool = std::is_same<T, int32>::value ||
+                 std::is_same<T, int64_t>::value>
+struct ParallelUnique {
+  static bool Run(OpKernelContext* context, typename TTypes<T>::ConstFlat in,
+                  typename TTypes<TIndex>::Vec idx,
+                  std::vector<int64_t>* first_positions) {
+    return false;
+  }
+};
+
+// Computes the same result as the serial hash map, with the unique elements in
+// order of first occurrence:
+//
+// 1. The input is split into one block per thread. Every element is assigned
+//    to a partition by its hash, and a stable counting sort gathers the
+//    positions of each partition in input order.
+// 2. Each partition is uniquified with its own hash map. As keys never span
+//    partitions, this finds every first occurrence and gives each element a
+//    partition-local id.
+// 3. The first occurrences are numbered in input order with a prefix sum over
+//    the blocks, which defines the global ids, and the local ids are rewritten
+//    to global ones.
+//
+// Returns false, without touching the outputs, if the input is too small or
+// there is only one thread to run on.
+template <typename T, typename TIndex>
+struct ParallelUnique<T, TIndex, true> {
+  static bool Run(OpKernelContext* context, typename TTypes<T>::ConstFlat in,
+                  typename TTypes<TIndex>::Vec idx,
+                  std::vector<int64_t>* first_positions) {
+    const int64_t n = in.size();
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int num_partitions = worker_threads.num_threads;
+    if (n < kMinParallelUniqueSize || num_partitions <= 1) {
+      return false;
+    }
+
+    const int64_t num_blocks = num_partitions;
+    const int64_t block_size = MathUtil::CeilOfRatio<int64_t>(n, num_blocks);
+    auto partition_of = [&in, num_partitions](int64_t i) {
+      const uint64 h =
+          static_cast<uint64>(in(i)) * uint64{0x9E3779B97F4A7C15};
+      return static_cast<int>(((h >> 32) * num_partitions) >> 32);
+    };
+    auto for_each_block = [&](const std::function<void(int64_t, int64_t,
+                                                       int64_t)>& fn) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            /*cost_per_unit=*/block_size * 10,
+            [&](int64_t start, int64_t limit) {
+              for (int64_t b = start; b < limit; ++b) {
+                fn(b, std::min(n, b * block_size),
+                   std::min(n, (b + 1) * block_size));
+              }
+            });
+    };
+
+    // Step 1: count the elements of each partition in each block, and turn the
+    // counts into the offsets at which each block writes its positions.
+    std::vector<int64_t> offsets(num_blocks * num_partitions, 0);
+    for_each_block([&](int64_t b, int64_t begin, int64_t end) {
+      int64_t* counts = &offsets[b * num_partitions];
+      for (int64_t i = begin; i < end; ++i) {
+        ++counts[partition_of(i)];
+      }
+    });
+    std::vector<int64_t> partition_begin(num_partitions + 1);
+    int64_t total = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_begin[p] = total;
+      for (int64_t b = 0; b < num_blocks; ++b) {
+        const int64_t count = offsets[b * num_partitions + p];
+        offsets[b * num_partitions + p] = total;
+        total += count;
+      }
+    }
+    partition_begin[num_partitions] = total;
+    std::vector<int64_t> positions(n);
+    for_each_block([&](int64_t b, int64_t begin, int64_t end) {
+      int64_t* next = &offsets[b * num_partitions];
+      for (int64_t i = begin; i < end; ++i) {
+        positions[next[partition_of(i)]++] = i;
+      }
+    });
+
+    // Step 2: uniquify each partition, storing local ids in `idx`.
+    std::vector<uint8> is_first(n, 0);
+    std::vector<std::vector<TIndex>> local_to_global(num_partitions);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          /*cost_per_unit=*/block_size * 50, [&](int64_t start, int64_t limit) {
+            for (int64_t p = start; p < limit; ++p) {
+              absl::flat_hash_map<T, TIndex> uniq;
+              uniq.reserve(partition_begin[p + 1] - partition_begin[p]);
+              for (int64_t k = partition_begin[p]; k < partition_begin[p + 1];
+                   ++k) {
+                const int64_t i = positions[k];
+                const TIndex next_id = static_cast<TIndex>(uniq.size());
+                auto it = uniq.emplace(in(i), next_id);
+                idx(i) = it.first->second;
+                if (it.second) {
+                  is_first[i] = 1;
+                }
+              }
+              local_to_global[p].resize(uniq.size());
+            }
+          });
+
+    // Step 3: number the first occurrences in input order.
+    std::vector<int64_t> block_begin(num_blocks + 1, 0);
+    for_each_block([&](int64_t b, int64_t begin, int64_t end) {
+      block_begin[b + 1] = std::count(is_first.begin() + begin,
+                                      is_first.begin() + end, uint8{1});
+    });
+    for (int64_t b = 0; b < num_blocks; ++b) {
+      block_begin[b + 1] += block_begin[b];
+    }
+    first_positions->resize(block_begin[num_blocks]);
+    for_each_block([&](int64_t b, int64_t begin, int64_t end) {
+      int64_t id = block_begin[b];
+      for (int64_t i = begin; i < end; ++i) {
+        if (is_first[i]) {
+          (*first_positions)[id] = i;
+          local_to_global[partition_of(i)][idx(i)] = static_cast<TIndex>(id);
+          ++id;
+        }
+      }
+    });
+    for_each_block([&](int64_t b, int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        idx(i) = local_to_global[partition_of(i)][idx(i)];
+      }
+    });
+    return true;
+  }
+};
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -150,26 +299,41 @@ class UniqueOp : public OpKernel {
       auto Tin = input.flat<T>();
       const int64_t N = static_cast<int64_t>(Tin.size());
 
-      typename UniqueOpHashMap<T, TIndex>::map_type uniq;
-      uniq.reserve(2 * N);
-      for (Eigen::Index i = 0, j = 0; i < N; ++i) {
-        auto it = uniq.emplace(Tin(i), j);
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
+      std::vector<int64_t> first_positions;
+      if (ParallelUnique<T, TIndex>::Run(context, Tin, idx_vec,
+                                         &first_positions)) {
+        uniq_size = static_cast<int64_t>(first_positions.size());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        auto Tout = output->flat<T>();
+        for (int64_t j = 0; j < uniq_size; ++j) {
+          Tout(j) = Tin(first_positions[j]);
+        }
+      } else {
+        typename UniqueOpHashMap<T, TIndex>::map_type uniq;
+        uniq.reserve(2 * N);
+        for (Eigen::Index i = 0, j = 0; i < N; ++i) {
+          auto it = uniq.emplace(Tin(i), j);
+          idx_vec(i) = it.first->second;
+          if (it.second) {
+            ++j;
+          }
         }
-      }
 
-      uniq_size = static_cast<int64_t>(uniq.size());
-      TensorShape output_shape(input.shape());
-      output_shape.set_dim(axis, uniq_size);
-      Tensor* output = nullptr;
-      OP_REQUIRES_OK(context,
-                     context->allocate_output(0, output_shape, &output));
-      auto Tout = output->flat<T>();
+        uniq_size = static_cast<int64_t>(uniq.size());
+        TensorShape output_shape(input.shape());
+        output_shape.set_dim(axis, uniq_size);
+        Tensor* output = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(0, output_shape, &output));
+        auto Tout = output->flat<T>();
 
-      for (const auto& it : uniq) {
-        Tout(it.second) = it.first;
+        for (const auto& it : uniq) {
+          Tout(it.second) = it.first;
+        }
       }
     } else {
       // General implementation when unique is run over multiple elements.
@@ -111,6 +111,34 @@ void BM_Unique_INT32_Repeat(::testing::benchmark::State& state) {
                           sizeof(int32));
 }
 
+void BM_Unique_INT64(::testing::benchmark::State& state) {
+  const int64_t dim = state.range(0);
+  const int64_t max_int = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+
+  // Filled directly rather than through a proto, which would be too large for
+  // the bigger sizes.
+  Tensor input(DT_INT64, TensorShape({dim}));
+  auto input_flat = input.flat<int64_t>();
+  for (int64_t i = 0; i < dim; ++i) {
+    input_flat(i) = std::rand() % max_int;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Unique")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+  FixupSourceAndSinkEdges(g);
+
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "SINGLE_THREADED_EXECUTOR", /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * dim *
+                          sizeof(int64_t));
+}
+
 TensorProto GetRandomStringsTensorProto(int dim, int max_str_len) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_STRING);
@@ -193,6 +221,14 @@ BENCHMARK(BM_Unique_INT32_Repeat)
     ->ArgPair(64 * 1024, 64 * 1024 * 1024)
     ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
 
+BENCHMARK(BM_Unique_INT64)
+    ->UseRealTime()
+    ->ArgPair(1000 * 1000, 1000 * 1000)
+    ->ArgPair(10 * 1000 * 1000, 1000 * 1000)
+    ->ArgPair(10 * 1000 * 1000, 100 * 1000 * 1000)
+    ->ArgPair(100 * 1000 * 1000, 1000 * 1000)
+    ->ArgPair(100 * 1000 * 1000, 100 * 1000 * 1000);
+
 BENCHMARK(BM_Unique_STRING)
     ->UseRealTime()
     ->Arg(32)
@@ -21,8 +21,10 @@ namespace compression {
 
 const char kNone[] = "";
 const char kGzip[] = "GZIP";
+const char kLz4[] = "LZ4";
 const char kSnappy[] = "SNAPPY";
 const char kZlib[] = "ZLIB";
+const char kZstd[] = "ZSTD";
 
 }  // namespace compression
 }  // namespace io
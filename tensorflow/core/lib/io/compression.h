@@ -22,8 +22,10 @@ namespace compression {
 
 extern const char kNone[];
 extern const char kGzip[];
+extern const char kLz4[];
 extern const char kSnappy[];
 extern const char kZlib[];
+extern const char kZstd[];
 
 }  // namespace compression
 }  // namespace io
@@ -0,0 +1,252 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/gzip_block_inputstream.h"
+
+#include <zlib.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/gzip_block_outputbuffer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+// Returns the size of the whole gzip member starting with `header` if it was
+// written by GzipBlockOutputBuffer, or 0 otherwise.
+uint32 BlockSize(const tstring& header) {
+  if (header.size() < GzipBlockOutputBuffer::kHeaderSize) return 0;
+  const char* p = header.data();
+  if (p[0] != '\x1f' || p[1] != '\x8b' || p[2] != Z_DEFLATED || p[3] != 4 ||
+      core::DecodeFixed16(p + 10) != 8 ||
+      p[12] != GzipBlockOutputBuffer::kSubfieldId1 ||
+      p[13] != GzipBlockOutputBuffer::kSubfieldId2 ||
+      core::DecodeFixed16(p + 14) != 4) {
+    return 0;
+  }
+  const uint32 block_size = core::DecodeFixed32(p + 16);
+  constexpr size_t kMinBlockSize =
+      GzipBlockOutputBuffer::kHeaderSize + GzipBlockOutputBuffer::kTrailerSize;
+  if (block_size < kMinBlockSize) return 0;
+  return block_size;
+}
+
+// Decompresses the raw deflate data of the gzip member `block` into
+// `output`, checking it against the trailer.
+Status Inflate(const tstring& block, tstring* output) {
+  const size_t data_size = block.size() - GzipBlockOutputBuffer::kHeaderSize -
+                           GzipBlockOutputBuffer::kTrailerSize;
+  const char* trailer =
+      block.data() + GzipBlockOutputBuffer::kHeaderSize + data_size;
+  const uint32 expected_crc = core::DecodeFixed32(trailer);
+  const uint32 uncompressed_size = core::DecodeFixed32(trailer + 4);
+  if (uncompressed_size > GzipBlockOutputBuffer::kMaxBlockSize) {
+    return errors::DataLoss("Corrupted gzip block: uncompressed size ",
+                            uncompressed_size, " is too large");
+  }
+
+  output->resize_uninitialized(uncompressed_size);
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    return errors::Internal("inflateInit failed");
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(
+      block.data() + GzipBlockOutputBuffer::kHeaderSize));
+  stream.avail_in = data_size;
+  stream.next_out = reinterpret_cast<Bytef*>(output->mdata());
+  stream.avail_out = uncompressed_size;
+  const int status = inflate(&stream, Z_FINISH);
+  const uLong total_out = stream.total_out;
+  inflateEnd(&stream);
+  if (status != Z_STREAM_END || total_out != uncompressed_size) {
+    return errors::DataLoss("Corrupted gzip block: inflate returned ", status,
+                            " after ", total_out, " of ", uncompressed_size,
+                            " bytes");
+  }
+  const uint32 crc = crc32(crc32(0, Z_NULL, 0),
+                           reinterpret_cast<const Bytef*>(output->data()),
+                           output->size());
+  if (crc != expected_crc) {
+    return errors::DataLoss("Corrupted gzip block: CRC mismatch");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+struct GzipBlockInputStream::Block {
+  // The whole gzip member.
+  tstring compressed;
+  // Set once `done` is notified.
+  tstring uncompressed;
+  Status status;
+  Notification done;
+  // The number of bytes of `uncompressed` already returned.
+  size_t pos = 0;
+};
+
+GzipBlockInputStream::GzipBlockInputStream(
+    InputStreamInterface* input_stream,
+    const ZlibCompressionOptions& zlib_options, bool owns_input_stream)
+    : input_stream_(input_stream),
+      zlib_options_(zlib_options),
+      owns_input_stream_(owns_input_stream),
+      max_blocks_in_flight_(
+          2 * std::max<int32>(zlib_options.decompression_threads, 1)) {}
+
+GzipBlockInputStream::~GzipBlockInputStream() {
+  // Waits for pending decompressions, which only touch their own blocks.
+  thread_pool_.reset();
+  zlib_stream_.reset();
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+Status GzipBlockInputStream::Initialize() {
+  tstring header;
+  Status s =
+      input_stream_->ReadNBytes(GzipBlockOutputBuffer::kHeaderSize, &header);
+  if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  if (BlockSize(header) == 0) {
+    zlib_stream_ = absl::make_unique<ZlibInputStream>(
+        input_stream_, zlib_options_.input_buffer_size,
+        zlib_options_.output_buffer_size, zlib_options_);
+  } else if (zlib_options_.decompression_threads > 1) {
+    thread_pool_ = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "gzip_block_decompression",
+        zlib_options_.decompression_threads);
+  }
+  initialized_ = true;
+  return Status::OK();
+}
+
+Status GzipBlockInputStream::ScheduleBlocks() {
+  while (blocks_.size() < max_blocks_in_flight_ && !input_exhausted_) {
+    const int64_t offset = input_stream_->Tell();
+    auto block = std::make_shared<Block>();
+    Status s = input_stream_->ReadNBytes(GzipBlockOutputBuffer::kHeaderSize,
+                                         &block->compressed);
+    if (errors::IsOutOfRange(s) && block->compressed.empty()) {
+      input_exhausted_ = true;
+      break;
+    }
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("Truncated gzip block header at offset ",
+                              offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    const uint32 block_size = BlockSize(block->compressed);
+    if (block_size == 0) {
+      return errors::DataLoss("Expected a gzip block at offset ", offset);
+    }
+    tstring data;
+    s = input_stream_->ReadNBytes(
+        block_size - GzipBlockOutputBuffer::kHeaderSize, &data);
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("Truncated gzip block at offset ", offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    block->compressed.append(data);
+
+    blocks_.push_back(block);
+    auto decompress = [block]() {
+      block->status = Inflate(block->compressed, &block->uncompressed);
+      block->compressed = tstring();
+      block->done.Notify();
+    };
+    if (thread_pool_ != nullptr) {
+      thread_pool_->Schedule(std::move(decompress));
+    } else {
+      decompress();
+    }
+  }
+  return Status::OK();
+}
+
+Status GzipBlockInputStream::ReadNBytes(int64_t bytes_to_read,
+                                        tstring* result) {
+  if (!initialized_) TF_RETURN_IF_ERROR(Initialize());
+  if (zlib_stream_ != nullptr) {
+    return zlib_stream_->ReadNBytes(bytes_to_read, result);
+  }
+
+  result->clear();
+  result->resize_uninitialized(bytes_to_read);
+  char* result_ptr = result->mdata();
+  while (bytes_to_read > 0) {
+    Status s = ScheduleBlocks();
+    if (s.ok() && blocks_.empty()) {
+      s = errors::OutOfRange("reached end of gzip input");
+    }
+    if (s.ok()) {
+      blocks_.front()->done.WaitForNotification();
+      s = blocks_.front()->status;
+    }
+    if (!s.ok()) {
+      result->resize(result_ptr - result->data());
+      return s;
+    }
+    Block* block = blocks_.front().get();
+    const size_t n = std::min<size_t>(bytes_to_read,
+                                      block->uncompressed.size() - block->pos);
+    memcpy(result_ptr, block->uncompressed.data() + block->pos, n);
+    block->pos += n;
+    result_ptr += n;
+    bytes_to_read -= n;
+    bytes_read_ += n;
+    if (block->pos == block->uncompressed.size()) {
+      blocks_.pop_front();
+    }
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status GzipBlockInputStream::ReadNBytes(int64_t bytes_to_read,
+                                        absl::Cord* result) {
+  tstring buf;
+  Status s = ReadNBytes(bytes_to_read, &buf);
+  result->Clear();
+  result->Append(buf.data());
+  return s;
+}
+#endif
+
+int64_t GzipBlockInputStream::Tell() const {
+  if (zlib_stream_ != nullptr) return zlib_stream_->Tell();
+  return bytes_read_;
+}
+
+Status GzipBlockInputStream::Reset() {
+  if (zlib_stream_ != nullptr) return zlib_stream_->Reset();
+  blocks_.clear();
+  input_exhausted_ = false;
+  bytes_read_ = 0;
+  return input_stream_->Reset();
+}
+
+}  // namespace io
+}  // namespace tensorflow
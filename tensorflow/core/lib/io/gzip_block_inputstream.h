@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads gzip input written by GzipBlockOutputBuffer, decompressing up to
+// `2 * zlib_options.decompression_threads` blocks ahead of the reader on a
+// thread pool of `zlib_options.decompression_threads` threads.
+//
+// The first read checks whether the input starts with such a block. If it
+// does not, the stream reads the whole input through a ZlibInputStream
+// instead, so it can be used for any input that ZlibInputStream accepts.
+//
+// A given instance of an GzipBlockInputStream is NOT safe for concurrent use
+// by multiple threads.
+class GzipBlockInputStream : public InputStreamInterface {
+ public:
+  // Takes ownership of `input_stream` iff `owns_input_stream` is true.
+  GzipBlockInputStream(InputStreamInterface* input_stream,
+                       const ZlibCompressionOptions& zlib_options,
+                       bool owns_input_stream);
+
+  ~GzipBlockInputStream() override;
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:           If successful.
+  // OUT_OF_RANGE: If there are not enough bytes to read before the end of
+  //               the stream.
+  // DATA_LOSS:    If a block is corrupted.
+  // others:       If reading from stream failed.
+  Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status ReadNBytes(int64_t bytes_to_read, absl::Cord* result) override;
+#endif
+
+  int64_t Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Block;
+
+  // Checks the format of the input and sets up the thread pool or
+  // `zlib_stream_` accordingly.
+  Status Initialize();
+
+  // Reads blocks from `input_stream_` and schedules their decompression until
+  // `max_blocks_in_flight_` are pending or the input ends.
+  Status ScheduleBlocks();
+
+  InputStreamInterface* input_stream_;
+  const ZlibCompressionOptions zlib_options_;
+  const bool owns_input_stream_;
+  const size_t max_blocks_in_flight_;
+
+  bool initialized_ = false;
+  // Reads the input if it is not made of blocks.
+  std::unique_ptr<ZlibInputStream> zlib_stream_;
+
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  // Blocks read from `input_stream_`, in order, whose data has not been read
+  // entirely yet.
+  std::deque<std::shared_ptr<Block>> blocks_;
+  // Whether `input_stream_` returned all of its data.
+  bool input_exhausted_ = false;
+
+  // The number of decompressed bytes read by the client.
+  int64_t bytes_read_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GzipBlockInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_INPUTSTREAM_H_
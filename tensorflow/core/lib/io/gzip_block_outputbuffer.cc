@@ -0,0 +1,186 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/gzip_block_outputbuffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+constexpr size_t GzipBlockOutputBuffer::kHeaderSize;
+constexpr size_t GzipBlockOutputBuffer::kTrailerSize;
+constexpr char GzipBlockOutputBuffer::kSubfieldId1;
+constexpr char GzipBlockOutputBuffer::kSubfieldId2;
+constexpr int64_t GzipBlockOutputBuffer::kMaxBlockSize;
+
+GzipBlockOutputBuffer::GzipBlockOutputBuffer(
+    WritableFile* file, const ZlibCompressionOptions& zlib_options)
+    : file_(file), zlib_options_(zlib_options) {}
+
+GzipBlockOutputBuffer::~GzipBlockOutputBuffer() {
+  if (z_stream_ != nullptr) {
+    deflateEnd(z_stream_.get());
+  }
+}
+
+Status GzipBlockOutputBuffer::Init() {
+  const int64_t block_size = zlib_options_.block_size;
+  if (block_size <= 0 || block_size > kMaxBlockSize) {
+    init_status_ = errors::InvalidArgument(
+        "Gzip block_size must be between 1 and ", kMaxBlockSize, ", got ",
+        block_size);
+    return init_status_;
+  }
+  if (zlib_options_.window_bits <= MAX_WBITS) {
+    init_status_ = errors::InvalidArgument(
+        "Blocked output requires gzip encoding, got window_bits ",
+        zlib_options_.window_bits);
+    return init_status_;
+  }
+  // Each block gets its own gzip header and trailer, so deflate writes raw
+  // data.
+  z_stream_.reset(new z_stream);
+  memset(z_stream_.get(), 0, sizeof(z_stream));
+  const int status =
+      deflateInit2(z_stream_.get(), zlib_options_.compression_level,
+                   zlib_options_.compression_method,
+                   -(zlib_options_.window_bits - 16), zlib_options_.mem_level,
+                   zlib_options_.compression_strategy);
+  if (status != Z_OK) {
+    z_stream_.reset();
+    init_status_ = errors::InvalidArgument("deflateInit failed with status ",
+                                           status);
+    return init_status_;
+  }
+  input_.reserve(block_size);
+  return Status::OK();
+}
+
+Status GzipBlockOutputBuffer::Append(StringPiece data) {
+  TF_RETURN_IF_ERROR(init_status_);
+  if (z_stream_ == nullptr) {
+    return errors::FailedPrecondition(
+        "GzipBlockOutputBuffer is closed or not initialized");
+  }
+  const size_t block_size = zlib_options_.block_size;
+  while (!data.empty()) {
+    const size_t n = std::min(data.size(), block_size - input_.size());
+    input_.append(data.data(), n);
+    data.remove_prefix(n);
+    if (input_.size() == block_size) {
+      TF_RETURN_IF_ERROR(WriteBlock());
+    }
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status GzipBlockOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status GzipBlockOutputBuffer::Close() {
+  TF_RETURN_IF_ERROR(init_status_);
+  if (z_stream_ == nullptr) {
+    return errors::FailedPrecondition(
+        "GzipBlockOutputBuffer is closed or not initialized");
+  }
+  TF_RETURN_IF_ERROR(WriteBlock());
+  deflateEnd(z_stream_.get());
+  z_stream_.reset();
+  return Status::OK();
+}
+
+Status GzipBlockOutputBuffer::Flush() {
+  TF_RETURN_IF_ERROR(init_status_);
+  if (z_stream_ == nullptr) {
+    return errors::FailedPrecondition(
+        "GzipBlockOutputBuffer is closed or not initialized");
+  }
+  TF_RETURN_IF_ERROR(WriteBlock());
+  return file_->Flush();
+}
+
+Status GzipBlockOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status GzipBlockOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status GzipBlockOutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
+Status GzipBlockOutputBuffer::WriteBlock() {
+  if (input_.empty()) return Status::OK();
+
+  z_stream* stream = z_stream_.get();
+  if (deflateReset(stream) != Z_OK) {
+    return errors::Internal("deflateReset failed");
+  }
+  const size_t max_compressed_size = deflateBound(stream, input_.size());
+  output_.resize(kHeaderSize + max_compressed_size + kTrailerSize);
+  stream->next_in = reinterpret_cast<Bytef*>(&input_[0]);
+  stream->avail_in = input_.size();
+  stream->next_out = reinterpret_cast<Bytef*>(&output_[kHeaderSize]);
+  stream->avail_out = max_compressed_size;
+  const int status = deflate(stream, Z_FINISH);
+  if (status != Z_STREAM_END) {
+    return errors::DataLoss("deflate failed with status ", status);
+  }
+  const size_t block_bytes = kHeaderSize + stream->total_out + kTrailerSize;
+
+  // The gzip member header (RFC 1952): no modification time, unknown OS, and
+  // an extra field holding the size of the whole member.
+  char* header = &output_[0];
+  header[0] = '\x1f';
+  header[1] = '\x8b';
+  header[2] = Z_DEFLATED;
+  header[3] = 4;  // FEXTRA
+  core::EncodeFixed32(header + 4, 0);
+  header[8] = 0;
+  header[9] = '\xff';
+  core::EncodeFixed16(header + 10, 8);  // XLEN
+  header[12] = kSubfieldId1;
+  header[13] = kSubfieldId2;
+  core::EncodeFixed16(header + 14, 4);  // LEN
+  core::EncodeFixed32(header + 16, block_bytes);
+
+  char* trailer = &output_[kHeaderSize + stream->total_out];
+  const uLong crc =
+      crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(input_.data()),
+            input_.size());
+  core::EncodeFixed32(trailer, crc);
+  core::EncodeFixed32(trailer + 4, input_.size());
+
+  input_.clear();
+  return file_->Append(StringPiece(output_.data(), block_bytes));
+}
+
+}  // namespace io
+}  // namespace tensorflow
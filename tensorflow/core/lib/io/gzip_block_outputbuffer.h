@@ -0,0 +1,122 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_OUTPUTBUFFER_H_
+
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Writes gzip output made of independently compressed blocks, in the spirit
+// of BGZF (https://samtools.github.io/hts-specs/SAMv1.pdf), so that readers
+// can decompress several blocks in parallel, see GzipBlockInputStream.
+//
+// Every `zlib_options.block_size` bytes of input become one complete gzip
+// member. Its header carries an extra subfield ("TF", 4 bytes) holding the
+// total size of the member, which lets readers find the next block without
+// decompressing this one. Concatenated gzip members are valid gzip, so the
+// output stays readable by gzip, zlib and ZlibInputStream.
+//
+// A given instance of an GzipBlockOutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class GzipBlockOutputBuffer : public WritableFile {
+ public:
+  // The size of the gzip member header, including the extra subfield.
+  static constexpr size_t kHeaderSize = 20;
+  // The size of the gzip member trailer: CRC32 and uncompressed size.
+  static constexpr size_t kTrailerSize = 8;
+  // The identifier of the extra subfield holding the member size.
+  static constexpr char kSubfieldId1 = 'T';
+  static constexpr char kSubfieldId2 = 'F';
+  // The largest supported `block_size`.
+  static constexpr int64_t kMaxBlockSize = 1 << 30;
+
+  // Does not take ownership of `file`. `zlib_options` must use gzip encoding
+  // and a positive `block_size`.
+  GzipBlockOutputBuffer(WritableFile* file,
+                        const ZlibCompressionOptions& zlib_options);
+
+  // Per convention, the dtor does not call Flush() or Close(). We expect the
+  // caller to call those manually when done.
+  ~GzipBlockOutputBuffer() override;
+
+  // Initializes the compression state. This call is required before any
+  // other operation on the buffer.
+  Status Init();
+
+  // Adds `data` to the current block, compressing and writing out every block
+  // that fills up.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses the pending input as a block of its own and writes it to
+  // file. This must be called before the destructor to avoid any data loss.
+  // Does not close `file`.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or
+  // `Close()` will fail.
+  Status Close() override;
+
+  // Compresses the pending input as a block of its own and flushes the file.
+  // Frequent flushes make small blocks that compress worse.
+  Status Flush() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Flushes and syncs the underlying file.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64_t* position) override;
+
+ private:
+  // Compresses `input_` into a gzip member and appends it to `file_`.
+  Status WriteBlock();
+
+  WritableFile* file_;  // Not owned
+  const ZlibCompressionOptions zlib_options_;
+  Status init_status_;
+
+  std::unique_ptr<z_stream> z_stream_;
+
+  // Uncompressed data of the current block.
+  std::string input_;
+  // The gzip member being written.
+  std::string output_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GzipBlockOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_GZIP_BLOCK_OUTPUTBUFFER_H_
@@ -0,0 +1,187 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(TF_USE_LZ4)
+#include "lz4frame.h"
+#endif
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+Lz4InputStream::Lz4InputStream(InputStreamInterface* input_stream,
+                               size_t input_buffer_bytes,
+                               size_t output_buffer_bytes,
+                               bool owns_input_stream)
+    : input_stream_(input_stream),
+      input_buffer_bytes_(input_buffer_bytes),
+      output_buffer_bytes_(output_buffer_bytes),
+      owns_input_stream_(owns_input_stream),
+      output_buffer_(new char[output_buffer_bytes]) {
+  init_status_ = Init();
+}
+
+Lz4InputStream::Lz4InputStream(InputStreamInterface* input_stream,
+                               size_t input_buffer_bytes,
+                               size_t output_buffer_bytes)
+    : Lz4InputStream(input_stream, input_buffer_bytes, output_buffer_bytes,
+                     false) {}
+
+Lz4InputStream::~Lz4InputStream() {
+#if defined(TF_USE_LZ4)
+  if (context_ != nullptr) LZ4F_freeDecompressionContext(context_);
+#endif
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+Status Lz4InputStream::Init() {
+#if defined(TF_USE_LZ4)
+  if (input_buffer_bytes_ == 0 || output_buffer_bytes_ == 0) {
+    return errors::InvalidArgument("LZ4 buffer sizes must be positive");
+  }
+  const LZ4F_errorCode_t ret =
+      LZ4F_createDecompressionContext(&context_, LZ4F_VERSION);
+  if (LZ4F_isError(ret)) {
+    context_ = nullptr;
+    return errors::ResourceExhausted("Failed to create an LZ4 context: ",
+                                     LZ4F_getErrorName(ret));
+  }
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with LZ4 support");
+#endif
+}
+
+Status Lz4InputStream::ReadNBytes(int64_t bytes_to_read, tstring* result) {
+  result->clear();
+  TF_RETURN_IF_ERROR(init_status_);
+  result->resize_uninitialized(bytes_to_read);
+
+  char* result_ptr = result->mdata();
+  // Read as many bytes as possible from the cache.
+  size_t bytes_read = ReadBytesFromCache(bytes_to_read, result_ptr);
+  bytes_to_read -= bytes_read;
+  result_ptr += bytes_read;
+
+  while (bytes_to_read > 0) {
+    DCHECK_EQ(avail_out_, 0);
+    // Fill the cache with more data.
+    Status s = Inflate();
+    if (!s.ok()) {
+      result->resize(result_ptr - result->data());
+      return s;
+    }
+    bytes_read = ReadBytesFromCache(bytes_to_read, result_ptr);
+    bytes_to_read -= bytes_read;
+    result_ptr += bytes_read;
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status Lz4InputStream::ReadNBytes(int64_t bytes_to_read, absl::Cord* result) {
+  tstring buf;
+  Status s = ReadNBytes(bytes_to_read, &buf);
+  result->Clear();
+  result->Append(buf.data());
+  return s;
+}
+#endif
+
+Status Lz4InputStream::Inflate() {
+#if defined(TF_USE_LZ4)
+  size_t decompressed = 0;
+  while (decompressed == 0) {
+    if (input_pos_ == input_buffer_.size() && !input_exhausted_) {
+      Status s = input_stream_->ReadNBytes(input_buffer_bytes_, &input_buffer_);
+      input_pos_ = 0;
+      if (errors::IsOutOfRange(s)) {
+        input_exhausted_ = true;
+      } else {
+        TF_RETURN_IF_ERROR(s);
+      }
+      continue;
+    }
+    if (input_pos_ == input_buffer_.size() && frame_finished_) {
+      return errors::OutOfRange("End of LZ4 stream");
+    }
+    size_t consumed = input_buffer_.size() - input_pos_;
+    decompressed = output_buffer_bytes_;
+    const size_t ret =
+        LZ4F_decompress(context_, output_buffer_.get(), &decompressed,
+                        input_buffer_.data() + input_pos_, &consumed,
+                        /*dOptPtr=*/nullptr);
+    if (LZ4F_isError(ret)) {
+      return errors::DataLoss("LZ4 decompression failed: ",
+                              LZ4F_getErrorName(ret));
+    }
+    input_pos_ += consumed;
+    frame_finished_ = ret == 0;
+    // A stream that ends within a frame, such as a file that is still being
+    // written, ends at the last complete block.
+    if (decompressed == 0 && input_exhausted_ &&
+        input_pos_ == input_buffer_.size()) {
+      return errors::OutOfRange("End of LZ4 stream");
+    }
+  }
+  next_out_ = output_buffer_.get();
+  avail_out_ = decompressed;
+  return Status::OK();
+#else
+  return init_status_;
+#endif
+}
+
+size_t Lz4InputStream::ReadBytesFromCache(size_t bytes_to_read,
+                                          char* result) {
+  const size_t can_read_bytes = std::min(bytes_to_read, avail_out_);
+  if (can_read_bytes > 0) {
+    memcpy(result, next_out_, can_read_bytes);
+    next_out_ += can_read_bytes;
+    avail_out_ -= can_read_bytes;
+  }
+  bytes_read_ += can_read_bytes;
+  return can_read_bytes;
+}
+
+int64_t Lz4InputStream::Tell() const { return bytes_read_; }
+
+Status Lz4InputStream::Reset() {
+  TF_RETURN_IF_ERROR(init_status_);
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+#if defined(TF_USE_LZ4)
+  LZ4F_resetDecompressionContext(context_);
+#endif
+  input_buffer_.clear();
+  input_pos_ = 0;
+  input_exhausted_ = false;
+  frame_finished_ = true;
+  avail_out_ = 0;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
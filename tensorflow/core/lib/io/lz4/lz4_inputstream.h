@@ -0,0 +1,117 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+struct LZ4F_dctx_s;
+
+namespace tensorflow {
+namespace io {
+
+// An Lz4InputStream provides support for reading from a stream in the LZ4
+// frame format (https://lz4.github.io/lz4/). The stream may hold several
+// concatenated frames.
+//
+// A given instance of an Lz4InputStream is NOT safe for concurrent use
+// by multiple threads.
+class Lz4InputStream : public InputStreamInterface {
+ public:
+  // Create a Lz4InputStream for `input_stream` with a buffer of size
+  // `input_buffer_bytes` bytes for reading contents from `input_stream` and
+  // another buffer with size `output_buffer_bytes` for caching decompressed
+  // contents.
+  //
+  // Takes ownership of `input_stream` iff `owns_input_stream` is true.
+  Lz4InputStream(InputStreamInterface* input_stream, size_t input_buffer_bytes,
+                 size_t output_buffer_bytes, bool owns_input_stream);
+
+  // Equivalent to the previous constructor with owns_input_stream=false.
+  Lz4InputStream(InputStreamInterface* input_stream, size_t input_buffer_bytes,
+                 size_t output_buffer_bytes);
+
+  ~Lz4InputStream() override;
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:            If successful.
+  // OUT_OF_RANGE:  If there are not enough bytes to read before the end of
+  //                the stream.
+  // DATA_LOSS:     If the stream is corrupted or truncated.
+  // UNIMPLEMENTED: If TensorFlow was built without LZ4.
+  // others:        If reading from stream failed.
+  Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status ReadNBytes(int64_t bytes_to_read, absl::Cord* result) override;
+#endif
+
+  int64_t Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  // Creates the decompression context.
+  Status Init();
+
+  // Decompresses the next chunk of data into `output_buffer_`. Returns
+  // OUT_OF_RANGE at the end of the last frame.
+  Status Inflate();
+
+  // Copies up to `bytes_to_read` bytes from `output_buffer_` to `result` and
+  // returns the number of bytes copied.
+  size_t ReadBytesFromCache(size_t bytes_to_read, char* result);
+
+  InputStreamInterface* input_stream_;
+  const size_t input_buffer_bytes_;
+  const size_t output_buffer_bytes_;
+  const bool owns_input_stream_;
+  Status init_status_;
+
+  LZ4F_dctx_s* context_ = nullptr;
+
+  // Compressed data read from `input_stream_`, of which the bytes before
+  // `input_pos_` have been decompressed.
+  tstring input_buffer_;
+  size_t input_pos_ = 0;
+  // Whether `input_stream_` returned all of its data.
+  bool input_exhausted_ = false;
+  // Whether the last decompressed byte ended a frame.
+  bool frame_finished_ = true;
+
+  // Decompressed data not yet read by the client starts at `next_out_` and
+  // spans `avail_out_` bytes.
+  std::unique_ptr<char[]> output_buffer_;
+  char* next_out_ = nullptr;
+  size_t avail_out_ = 0;
+
+  // The number of decompressed bytes read by the client.
+  int64_t bytes_read_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Lz4InputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
@@ -0,0 +1,224 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/lz4/lz4_outputbuffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(TF_USE_LZ4)
+#include "lz4frame.h"
+#endif
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+#if defined(TF_USE_LZ4)
+namespace {
+
+// Returns the LZ4F preferences for `options`, which Init() has validated.
+LZ4F_preferences_t Preferences(const Lz4CompressionOptions& options) {
+  LZ4F_preferences_t preferences;
+  memset(&preferences, 0, sizeof(preferences));
+  preferences.compressionLevel = options.compression_level;
+  switch (options.block_size) {
+    case 64 << 10:
+      preferences.frameInfo.blockSizeID = LZ4F_max64KB;
+      break;
+    case 256 << 10:
+      preferences.frameInfo.blockSizeID = LZ4F_max256KB;
+      break;
+    case 1 << 20:
+      preferences.frameInfo.blockSizeID = LZ4F_max1MB;
+      break;
+    default:
+      preferences.frameInfo.blockSizeID = LZ4F_max4MB;
+      break;
+  }
+  return preferences;
+}
+
+}  // namespace
+#endif
+
+Lz4OutputBuffer::Lz4OutputBuffer(WritableFile* file,
+                                 int32_t output_buffer_bytes,
+                                 const Lz4CompressionOptions& lz4_options)
+    : file_(file),
+      min_output_buffer_bytes_(output_buffer_bytes),
+      lz4_options_(lz4_options) {}
+
+Lz4OutputBuffer::~Lz4OutputBuffer() {
+#if defined(TF_USE_LZ4)
+  if (context_ != nullptr) LZ4F_freeCompressionContext(context_);
+#endif
+}
+
+Status Lz4OutputBuffer::Init() {
+  init_status_ = CreateContext();
+  return init_status_;
+}
+
+Status Lz4OutputBuffer::CheckOpen() const {
+  if (!init_status_.ok()) return init_status_;
+  if (context_ == nullptr) {
+    return errors::FailedPrecondition(
+        "Lz4OutputBuffer is closed or not initialized");
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::CreateContext() {
+#if defined(TF_USE_LZ4)
+  const int64_t block_size = lz4_options_.block_size;
+  if (block_size != 64 << 10 && block_size != 256 << 10 &&
+      block_size != 1 << 20 && block_size != 4 << 20) {
+    return errors::InvalidArgument(
+        "LZ4 block_size must be 64KB, 256KB, 1MB or 4MB, got ", block_size);
+  }
+  LZ4F_errorCode_t ret = LZ4F_createCompressionContext(&context_, LZ4F_VERSION);
+  if (LZ4F_isError(ret)) {
+    context_ = nullptr;
+    return errors::ResourceExhausted("Failed to create an LZ4 context: ",
+                                     LZ4F_getErrorName(ret));
+  }
+  // Every LZ4F_compressUpdate() call is given at most one block of input, so
+  // this is enough room for any single call.
+  const LZ4F_preferences_t preferences = Preferences(lz4_options_);
+  const size_t max_output_bytes =
+      LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(block_size, &preferences);
+  output_buffer_capacity_ =
+      std::max(min_output_buffer_bytes_, max_output_bytes);
+  output_buffer_.reset(new char[output_buffer_capacity_]);
+  ret = LZ4F_compressBegin(context_, output_buffer_.get(),
+                           output_buffer_capacity_, &preferences);
+  if (LZ4F_isError(ret)) {
+    return errors::InvalidArgument("Failed to start an LZ4 frame: ",
+                                   LZ4F_getErrorName(ret));
+  }
+  output_pos_ = ret;
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with LZ4 support");
+#endif
+}
+
+Status Lz4OutputBuffer::Append(StringPiece data) {
+#if defined(TF_USE_LZ4)
+  TF_RETURN_IF_ERROR(CheckOpen());
+  const LZ4F_preferences_t preferences = Preferences(lz4_options_);
+  while (!data.empty()) {
+    const size_t n = std::min<size_t>(data.size(), lz4_options_.block_size);
+    TF_RETURN_IF_ERROR(ReserveOutput(LZ4F_compressBound(n, &preferences)));
+    const size_t ret = LZ4F_compressUpdate(
+        context_, output_buffer_.get() + output_pos_,
+        output_buffer_capacity_ - output_pos_, data.data(), n,
+        /*cOptPtr=*/nullptr);
+    if (LZ4F_isError(ret)) {
+      return errors::Internal("LZ4 compression failed: ",
+                              LZ4F_getErrorName(ret));
+    }
+    output_pos_ += ret;
+    data.remove_prefix(n);
+  }
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with LZ4 support");
+#endif
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status Lz4OutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status Lz4OutputBuffer::Close() {
+#if defined(TF_USE_LZ4)
+  TF_RETURN_IF_ERROR(CheckOpen());
+  const LZ4F_preferences_t preferences = Preferences(lz4_options_);
+  TF_RETURN_IF_ERROR(ReserveOutput(LZ4F_compressBound(0, &preferences)));
+  const size_t ret =
+      LZ4F_compressEnd(context_, output_buffer_.get() + output_pos_,
+                       output_buffer_capacity_ - output_pos_,
+                       /*cOptPtr=*/nullptr);
+  if (LZ4F_isError(ret)) {
+    return errors::Internal("LZ4 compression failed: ", LZ4F_getErrorName(ret));
+  }
+  output_pos_ += ret;
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  LZ4F_freeCompressionContext(context_);
+  context_ = nullptr;
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with LZ4 support");
+#endif
+}
+
+Status Lz4OutputBuffer::Flush() {
+#if defined(TF_USE_LZ4)
+  TF_RETURN_IF_ERROR(CheckOpen());
+  const LZ4F_preferences_t preferences = Preferences(lz4_options_);
+  TF_RETURN_IF_ERROR(ReserveOutput(LZ4F_compressBound(0, &preferences)));
+  const size_t ret = LZ4F_flush(context_, output_buffer_.get() + output_pos_,
+                                output_buffer_capacity_ - output_pos_,
+                                /*cOptPtr=*/nullptr);
+  if (LZ4F_isError(ret)) {
+    return errors::Internal("LZ4 compression failed: ", LZ4F_getErrorName(ret));
+  }
+  output_pos_ += ret;
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  return file_->Flush();
+#else
+  return errors::Unimplemented("TensorFlow was not built with LZ4 support");
+#endif
+}
+
+Status Lz4OutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status Lz4OutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status Lz4OutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
+Status Lz4OutputBuffer::ReserveOutput(size_t bytes) {
+  if (output_buffer_capacity_ - output_pos_ < bytes) {
+    TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::FlushOutputBufferToFile() {
+  if (output_pos_ == 0) return Status::OK();
+  TF_RETURN_IF_ERROR(
+      file_->Append(StringPiece(output_buffer_.get(), output_pos_)));
+  output_pos_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_OUTPUTBUFFER_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/io/lz4/lz4_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+struct LZ4F_cctx_s;
+
+namespace tensorflow {
+namespace io {
+
+// Compresses input data into the LZ4 frame format (https://lz4.github.io/lz4/)
+// and writes it to `file`.
+//
+// lz4 buffers up to one block of input itself, so only the compressed output
+// is cached, in a buffer of at least `output_buffer_bytes` which gets written
+// to file when full. Flush() ends the current block so that everything
+// appended so far can be decompressed.
+//
+// A given instance of an Lz4OutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class Lz4OutputBuffer : public WritableFile {
+ public:
+  // Does not take ownership of `file`.
+  Lz4OutputBuffer(WritableFile* file, int32_t output_buffer_bytes,
+                  const Lz4CompressionOptions& lz4_options);
+
+  // Per convention, the dtor does not call Flush() or Close(). We expect the
+  // caller to call those manually when done.
+  ~Lz4OutputBuffer() override;
+
+  // Initializes the compression context and starts the frame. This call is
+  // required before any other operation on the buffer.
+  Status Init();
+
+  // Adds `data` to the compression pipeline.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Ends the LZ4 frame and writes all output to file. This must be called
+  // before the destructor to avoid any data loss. Does not close `file`.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or
+  // `Close()` will fail.
+  Status Close() override;
+
+  // Compresses any buffered input and writes all output to file.
+  Status Flush() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Compresses any buffered input, writes all output to file and syncs it.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64_t* position) override;
+
+ private:
+  // Creates the compression context for Init().
+  Status CreateContext();
+
+  // Returns OK if the buffer is initialized and not closed yet.
+  Status CheckOpen() const;
+
+  // Makes sure `output_buffer_` has room for `bytes` more bytes, writing its
+  // contents to file if needed.
+  Status ReserveOutput(size_t bytes);
+
+  // Appends the contents of `output_buffer_` to `file_`.
+  Status FlushOutputBufferToFile();
+
+  WritableFile* file_;  // Not owned
+  const size_t min_output_buffer_bytes_;
+  const Lz4CompressionOptions lz4_options_;
+
+  LZ4F_cctx_s* context_ = nullptr;
+  // The result of Init().
+  Status init_status_;
+
+  std::unique_ptr<char[]> output_buffer_;
+  size_t output_buffer_capacity_ = 0;
+  size_t output_pos_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Lz4OutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_OUTPUTBUFFER_H_
@@ -0,0 +1,198 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/prefetching_inputstream.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+namespace io {
+
+struct PrefetchingInputStream::Buffer {
+  // The file offset of `data`.
+  int64_t offset = 0;
+  // Set once `done` is notified. Shorter than the buffer size only at the end
+  // of the file.
+  tstring data;
+  Status status;
+  Notification done;
+  // Set when the buffer is discarded, so that a pending read can be skipped.
+  std::atomic<bool> discarded{false};
+  // The number of bytes of `data` already returned.
+  size_t pos = 0;
+};
+
+PrefetchingInputStream::PrefetchingInputStream(RandomAccessFile* file,
+                                               size_t buffer_bytes,
+                                               int num_buffers)
+    : file_(file),
+      buffer_bytes_(buffer_bytes),
+      num_buffers_(std::max(num_buffers, 1)) {
+  DCHECK_GT(buffer_bytes_, 0);
+  thread_pool_ = absl::make_unique<thread::ThreadPool>(
+      Env::Default(), "prefetching_input_stream", num_buffers_);
+}
+
+PrefetchingInputStream::~PrefetchingInputStream() {
+  Restart(pos_);
+  // Waits for pending reads, which only touch their own buffers.
+  thread_pool_.reset();
+}
+
+void PrefetchingInputStream::ScheduleBuffers() {
+  while (buffers_.size() < num_buffers_ && !file_exhausted_) {
+    auto buffer = std::make_shared<Buffer>();
+    buffer->offset = next_buffer_offset_;
+    next_buffer_offset_ += buffer_bytes_;
+    buffers_.push_back(buffer);
+    RandomAccessFile* file = file_;
+    const size_t buffer_bytes = buffer_bytes_;
+    thread_pool_->Schedule([file, buffer_bytes, buffer]() {
+      if (!buffer->discarded) {
+        buffer->data.resize_uninitialized(buffer_bytes);
+        StringPiece data;
+        Status s = file->Read(buffer->offset, buffer_bytes, &data,
+                              buffer->data.mdata());
+        if (!data.empty() && data.data() != buffer->data.data()) {
+          memmove(buffer->data.mdata(), data.data(), data.size());
+        }
+        buffer->data.resize(data.size());
+        // A short buffer marks the end of the file.
+        if (!errors::IsOutOfRange(s)) buffer->status = s;
+      }
+      buffer->done.Notify();
+    });
+  }
+}
+
+Status PrefetchingInputStream::Consume(int64_t bytes_to_consume, char* result,
+                                       int64_t* bytes_consumed) {
+  *bytes_consumed = 0;
+  while (*bytes_consumed < bytes_to_consume) {
+    ScheduleBuffers();
+    if (buffers_.empty()) {
+      return errors::OutOfRange("reached end of file");
+    }
+    Buffer* buffer = buffers_.front().get();
+    buffer->done.WaitForNotification();
+    if (!buffer->status.ok()) {
+      const Status s = buffer->status;
+      // Reads the failed buffer again on the next call.
+      Restart(pos_);
+      return s;
+    }
+    const size_t n =
+        std::min<size_t>(bytes_to_consume - *bytes_consumed,
+                         buffer->data.size() - buffer->pos);
+    if (result != nullptr) {
+      memcpy(result + *bytes_consumed, buffer->data.data() + buffer->pos, n);
+    }
+    buffer->pos += n;
+    *bytes_consumed += n;
+    pos_ += n;
+    if (buffer->pos == buffer->data.size()) {
+      if (buffer->data.size() < buffer_bytes_) {
+        // The buffers after the end of the file are empty.
+        Restart(pos_);
+        file_exhausted_ = true;
+      } else {
+        buffers_.pop_front();
+      }
+    }
+  }
+  return Status::OK();
+}
+
+void PrefetchingInputStream::Restart(int64_t position) {
+  for (const auto& buffer : buffers_) {
+    buffer->discarded = true;
+  }
+  buffers_.clear();
+  next_buffer_offset_ = position;
+  file_exhausted_ = false;
+  pos_ = position;
+}
+
+Status PrefetchingInputStream::ReadNBytes(int64_t bytes_to_read,
+                                          tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->resize_uninitialized(bytes_to_read);
+  int64_t bytes_read = 0;
+  Status s = Consume(bytes_to_read, result->mdata(), &bytes_read);
+  result->resize(bytes_read);
+  return s;
+}
+
+Status PrefetchingInputStream::SkipNBytes(int64_t bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  // Skips over data that is read already or being read.
+  if (file_exhausted_ || bytes_to_skip <= next_buffer_offset_ - pos_) {
+    int64_t bytes_skipped;
+    return Consume(bytes_to_skip, nullptr, &bytes_skipped);
+  }
+  // Otherwise jumps ahead, if the file extends that far.
+  char scratch;
+  StringPiece data;
+  Status s = file_->Read(pos_ + bytes_to_skip - 1, 1, &data, &scratch);
+  if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+  if (data.size() == 1) {
+    Restart(pos_ + bytes_to_skip);
+    return Status::OK();
+  }
+  // The file ends before, so skips to its end.
+  int64_t bytes_skipped;
+  return Consume(bytes_to_skip, nullptr, &bytes_skipped);
+}
+
+int64_t PrefetchingInputStream::Tell() const { return pos_; }
+
+Status PrefetchingInputStream::Seek(int64_t position) {
+  if (position < 0) {
+    return errors::InvalidArgument("Seeking to a negative position: ",
+                                   position);
+  }
+  if (position >= pos_) {
+    return SkipNBytes(position - pos_);
+  }
+  // Re-uses the returned data of the first buffer, if it holds `position`.
+  if (!buffers_.empty() && position >= buffers_.front()->offset) {
+    buffers_.front()->pos -= pos_ - position;
+    pos_ = position;
+    return Status::OK();
+  }
+  Restart(position);
+  return Status::OK();
+}
+
+Status PrefetchingInputStream::Reset() { return Seek(0); }
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_PREFETCHING_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_PREFETCHING_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a file sequentially in buffers of `buffer_bytes`, keeping up to
+// `num_buffers` of them read or being read ahead of the reader on a thread
+// pool, so that the reads of the file overlap with consuming its data. With
+// the default of two buffers, the next buffer is filled while the current
+// one is consumed.
+//
+// Seeking within the buffers re-uses their data. Seeking elsewhere discards
+// them and starts reading at the new position.
+//
+// A given instance of a PrefetchingInputStream is NOT safe for concurrent use
+// by multiple threads.
+class PrefetchingInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  PrefetchingInputStream(RandomAccessFile* file, size_t buffer_bytes,
+                         int num_buffers = 2);
+
+  ~PrefetchingInputStream() override;
+
+  Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64_t bytes_to_skip) override;
+
+  int64_t Tell() const override;
+
+  // Seeks to `position` within the file.
+  Status Seek(int64_t position);
+
+  Status Reset() override;
+
+ private:
+  struct Buffer;
+
+  // Schedules reads of the buffers after the last one in `buffers_` until
+  // `num_buffers_` are pending or the end of the file is reached.
+  void ScheduleBuffers();
+
+  // Consumes up to `bytes_to_consume` bytes from the buffers, copying them to
+  // `result` unless it is null, and sets `*bytes_consumed`. Returns
+  // OUT_OF_RANGE if the file ends first.
+  Status Consume(int64_t bytes_to_consume, char* result,
+                 int64_t* bytes_consumed);
+
+  // Discards the buffers and continues reading at `position`.
+  void Restart(int64_t position);
+
+  RandomAccessFile* const file_;
+  const size_t buffer_bytes_;
+  const size_t num_buffers_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  // Buffers read or being read, in file order. The first one holds the data
+  // at `pos_`.
+  std::deque<std::shared_ptr<Buffer>> buffers_;
+  // The file offset the buffer scheduled next starts at.
+  int64_t next_buffer_offset_ = 0;
+  // Whether a buffer reached the end of the file.
+  bool file_exhausted_ = false;
+  // The number of bytes of the file before the data returned next.
+  int64_t pos_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrefetchingInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_PREFETCHING_INPUTSTREAM_H_
@@ -0,0 +1,190 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/prefetching_inputstream.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+std::vector<int> BufferSizes() { return {1, 2, 3, 4, 5, 9, 10, 11, 65536}; }
+
+std::vector<int> NumBuffers() { return {1, 2, 3}; }
+
+class PrefetchingInputStreamTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Env* env = Env::Default();
+    string fname;
+    ASSERT_TRUE(env->LocalTempFilename(&fname));
+    TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+    TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_));
+  }
+
+  std::unique_ptr<RandomAccessFile> file_;
+};
+
+TEST_F(PrefetchingInputStreamTest, ReadNBytes) {
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      PrefetchingInputStream in(file_.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "3456");
+      EXPECT_EQ(7, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "789");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST_F(PrefetchingInputStreamTest, SkipNBytes) {
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      PrefetchingInputStream in(file_.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.SkipNBytes(3));
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "34");
+      TF_ASSERT_OK(in.SkipNBytes(4));
+      EXPECT_EQ(9, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(1, &read));
+      EXPECT_EQ(read, "9");
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(1)));
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+TEST_F(PrefetchingInputStreamTest, SkipNBytesPastEndOfFile) {
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      PrefetchingInputStream in(file_.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(1, &read));
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(100)));
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+    }
+  }
+}
+
+TEST_F(PrefetchingInputStreamTest, Seek) {
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      PrefetchingInputStream in(file_.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(5, &read));
+      TF_ASSERT_OK(in.Seek(2));
+      EXPECT_EQ(2, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "234");
+      TF_ASSERT_OK(in.Seek(8));
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "89");
+      TF_ASSERT_OK(in.Seek(4));
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "45");
+      TF_ASSERT_OK(in.Reset());
+      TF_ASSERT_OK(in.ReadNBytes(10, &read));
+      EXPECT_EQ(read, "0123456789");
+      EXPECT_TRUE(errors::IsInvalidArgument(in.Seek(-1)));
+    }
+  }
+}
+
+TEST_F(PrefetchingInputStreamTest, UnderBufferedInputStream) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(
+      WriteStringToFile(env, fname, "line one\nline two\nline three\n"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    PrefetchingInputStream input_stream(file.get(), buf_size);
+    BufferedInputStream in(&input_stream, buf_size);
+    string line;
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "line one");
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "line two");
+    TF_ASSERT_OK(in.Seek(0));
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "line one");
+    TF_ASSERT_OK(in.SkipLine());
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "line three");
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadLine(&line)));
+  }
+}
+
+// Fails the first read at offset 4.
+class FailOnceFile : public RandomAccessFile {
+ public:
+  explicit FailOnceFile(RandomAccessFile* file) : file_(file) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    if (offset == 4 && !failed_.exchange(true)) {
+      *result = StringPiece();
+      return errors::Unavailable("read failed");
+    }
+    return file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  RandomAccessFile* const file_;
+  mutable std::atomic<bool> failed_{false};
+};
+
+TEST_F(PrefetchingInputStreamTest, RetriesFailedRead) {
+  for (auto num_buffers : NumBuffers()) {
+    FailOnceFile file(file_.get());
+    PrefetchingInputStream in(&file, 4, num_buffers);
+    tstring read;
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "01");
+    Status s = in.ReadNBytes(4, &read);
+    EXPECT_TRUE(errors::IsUnavailable(s)) << s;
+    EXPECT_EQ(read, "23");
+    EXPECT_EQ(4, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(6, &read));
+    EXPECT_EQ(read, "456789");
+  }
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
@@ -17,13 +17,17 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/prefetching_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/strcat.h"
 
 namespace tensorflow {
 namespace io {
@@ -46,6 +50,10 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
   } else if (compression_type == compression::kSnappy) {
     options.compression_type = io::RecordReaderOptions::SNAPPY_COMPRESSION;
+  } else if (compression_type == compression::kZstd) {
+    options.compression_type = io::RecordReaderOptions::ZSTD_COMPRESSION;
+  } else if (compression_type == compression::kLz4) {
+    options.compression_type = io::RecordReaderOptions::LZ4_COMPRESSION;
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No compression will be used.";
@@ -59,7 +67,10 @@ RecordReader::RecordReader(RandomAccessFile* file,
     : options_(options),
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.buffer_size > 0 && options.prefetch_buffers > 0) {
+    input_stream_.reset(new PrefetchingInputStream(
+        file, options.buffer_size, options.prefetch_buffers));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
@@ -68,7 +79,12 @@ RecordReader::RecordReader(RandomAccessFile* file,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (options.compression_type == RecordReaderOptions::ZLIB_COMPRESSION) {
+  if (options.compression_type == RecordReaderOptions::ZLIB_COMPRESSION &&
+      options.zlib_options.decompression_threads > 1) {
+    input_stream_.reset(new GzipBlockInputStream(input_stream_.release(),
+                                                 options.zlib_options, true));
+  } else if (options.compression_type ==
+             RecordReaderOptions::ZLIB_COMPRESSION) {
     input_stream_.reset(new ZlibInputStream(
         input_stream_.release(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options, true));
@@ -77,6 +93,16 @@ RecordReader::RecordReader(RandomAccessFile* file,
     input_stream_.reset(
         new SnappyInputStream(input_stream_.release(),
                               options.snappy_options.output_buffer_size, true));
+  } else if (options.compression_type ==
+             RecordReaderOptions::ZSTD_COMPRESSION) {
+    input_stream_.reset(new ZstdInputStream(
+        input_stream_.release(), options.zstd_options.input_buffer_size,
+        options.zstd_options.output_buffer_size, options.zstd_options, true));
+  } else if (options.compression_type ==
+             RecordReaderOptions::LZ4_COMPRESSION) {
+    input_stream_.reset(new Lz4InputStream(
+        input_stream_.release(), options.lz4_options.input_buffer_size,
+        options.lz4_options.output_buffer_size, true));
   } else if (options.compression_type == RecordReaderOptions::NONE) {
     // Nothing to do.
   } else {
@@ -245,5 +271,57 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+string RecordIndex::IndexFilename(StringPiece filename) {
+  return strings::StrCat(filename, ".index");
+}
+
+Status RecordIndex::Read(RandomAccessFile* index_file, uint64 file_size,
+                         RecordIndex* index) {
+  index->entries_.clear();
+  SequentialRecordReader reader(index_file);
+  tstring record;
+  while (true) {
+    Status s = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(s)) break;
+    TF_RETURN_IF_ERROR(s);
+    if (record.size() != 2 * sizeof(uint64)) {
+      return errors::DataLoss("Invalid TFRecord index entry of ",
+                              record.size(), " bytes");
+    }
+    const int64_t record_number = core::DecodeFixed64(record.data());
+    const uint64 offset = core::DecodeFixed64(record.data() + sizeof(uint64));
+    if (!index->entries_.empty() &&
+        (record_number < index->entries_.back().first ||
+         offset < index->entries_.back().second)) {
+      return errors::DataLoss("TFRecord index entries are not increasing");
+    }
+    index->entries_.emplace_back(record_number, offset);
+  }
+  if (index->entries_.empty() || index->entries_.back().second != file_size) {
+    return errors::FailedPrecondition(
+        "The TFRecord index is incomplete or does not match a file of ",
+        file_size, " bytes");
+  }
+  return Status::OK();
+}
+
+void RecordIndex::Lookup(int64_t record_number,
+                         int64_t* indexed_record_number,
+                         uint64* offset) const {
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), record_number,
+      [](int64_t number, const std::pair<int64_t, uint64>& entry) {
+        return number < entry.first;
+      });
+  if (it == entries_.begin()) {
+    *indexed_record_number = 0;
+    *offset = 0;
+    return;
+  }
+  --it;
+  *indexed_record_number = it->first;
+  *offset = it->second;
+}
+
 }  // namespace io
 }  // namespace tensorflow
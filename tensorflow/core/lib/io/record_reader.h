@@ -16,14 +16,22 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/gzip_block_inputstream.h"
+#include "tensorflow/core/lib/io/lz4/lz4_compression_options.h"
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
 #include "tensorflow/core/lib/io/snappy/snappy_compression_options.h"
 #include "tensorflow/core/lib/io/snappy/snappy_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
 #endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -38,7 +46,9 @@ struct RecordReaderOptions {
   enum CompressionType {
     NONE = 0,
     ZLIB_COMPRESSION = 1,
-    SNAPPY_COMPRESSION = 2
+    SNAPPY_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3,
+    LZ4_COMPRESSION = 4
   };
   CompressionType compression_type = NONE;
 
@@ -47,6 +57,11 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64_t buffer_size = 0;
 
+  // If both buffer_size and prefetch_buffers are non-zero, the file is read
+  // through a PrefetchingInputStream, which reads up to prefetch_buffers
+  // buffers of buffer_size bytes ahead of the reader in the background.
+  int32 prefetch_buffers = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -54,6 +69,8 @@ struct RecordReaderOptions {
   // Options specific to compression.
   ZlibCompressionOptions zlib_options;
   SnappyCompressionOptions snappy_options;
+  ZstdCompressionOptions zstd_options;
+  Lz4CompressionOptions lz4_options;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -174,6 +191,45 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// The index of an uncompressed TFRecord file, which RecordWriter writes to a
+// sidecar file after RecordWriter::EnableIndex(). Readers use it to start
+// reading at an indexed record without scanning the file from its start, for
+// example to split a file among parallel readers or to skip records.
+//
+// The index is itself a TFRecord file. Each record holds a fixed64 record
+// number and the fixed64 offset of that record in the indexed file. The last
+// record holds the number of records and the size of the indexed file.
+class RecordIndex {
+ public:
+  // Returns the name of the index of the TFRecord file `filename` that
+  // readers look for.
+  static string IndexFilename(StringPiece filename);
+
+  // Reads the index in "*index_file" of a TFRecord file of `file_size` bytes.
+  // Returns FAILED_PRECONDITION if the index is incomplete or was written for
+  // a file of a different size.
+  static Status Read(RandomAccessFile* index_file, uint64 file_size,
+                     RecordIndex* index);
+
+  // The number of records in the indexed file.
+  int64_t num_records() const { return entries_.back().first; }
+
+  // The indexed record numbers with their offsets, in increasing order. The
+  // last entry is the end of the file.
+  const std::vector<std::pair<int64_t, uint64>>& entries() const {
+    return entries_;
+  }
+
+  // Sets "*indexed_record_number" and "*offset" to the last indexed record
+  // at or before `record_number`. A `record_number` at or past num_records()
+  // yields the end of the file.
+  void Lookup(int64_t record_number, int64_t* indexed_record_number,
+              uint64* offset) const;
+
+ private:
+  std::vector<std::pair<int64_t, uint64>> entries_;
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -39,7 +40,19 @@ namespace {
 io::RecordReaderOptions GetMatchingReaderOptions(
     const io::RecordWriterOptions& options) {
   if (options.compression_type == io::RecordWriterOptions::ZLIB_COMPRESSION) {
-    return io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB");
+    io::RecordReaderOptions reader_options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB");
+    reader_options.zlib_options = options.zlib_options;
+    return reader_options;
+  }
+  if (options.compression_type == io::RecordWriterOptions::ZSTD_COMPRESSION) {
+    io::RecordReaderOptions reader_options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("ZSTD");
+    reader_options.zstd_options = options.zstd_options;
+    return reader_options;
+  }
+  if (options.compression_type == io::RecordWriterOptions::LZ4_COMPRESSION) {
+    return io::RecordReaderOptions::CreateRecordReaderOptions("LZ4");
   }
   return io::RecordReaderOptions::CreateRecordReaderOptions("");
 }
@@ -305,6 +318,216 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+// Writes and reads back records compressed with a codec that may not be
+// compiled in, checking that it reports Unimplemented in that case.
+void VerifyOptionalCodec(const io::RecordWriterOptions& options,
+                         bool supported) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_codec_test";
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, string(i % 97, 'x')));
+  }
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get(), options);
+    Status s = writer.WriteRecord(records[0]);
+    if (!supported) {
+      EXPECT_EQ(s.code(), error::UNIMPLEMENTED);
+      return;
+    }
+    TF_EXPECT_OK(s);
+    for (size_t i = 1; i < records.size(); ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(records[i]));
+    }
+    TF_EXPECT_OK(writer.Close());
+    TF_EXPECT_OK(file->Close());
+  }
+  EXPECT_LT(GetFileSize(fname), records.size() * 64);
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(read_file.get(), GetMatchingReaderOptions(options));
+  uint64 offset = 0;
+  tstring record;
+  for (const string& expected : records) {
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(expected, record);
+  }
+  EXPECT_EQ(reader.ReadRecord(&offset, &record).code(), error::OUT_OF_RANGE);
+}
+
+TEST(RecordReaderWriterTest, TestZstd) {
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("ZSTD");
+  EXPECT_EQ(options.compression_type,
+            io::RecordWriterOptions::ZSTD_COMPRESSION);
+  for (auto buf_size : BufferSizes()) {
+    options.zstd_options.input_buffer_size = buf_size;
+    options.zstd_options.output_buffer_size = buf_size;
+    VerifyOptionalCodec(options, io::ZstdSupported());
+  }
+  if (io::ZstdSupported()) VerifyFlush(options);
+}
+
+TEST(RecordReaderWriterTest, TestZstdDictionary) {
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("ZSTD");
+  options.zstd_options.compression_level = 19;
+  options.zstd_options.dictionary = "record xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx";
+  VerifyOptionalCodec(options, io::ZstdSupported());
+  if (!io::ZstdSupported()) return;
+
+  // Reading without the dictionary fails.
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_codec_test";
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(
+      read_file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions("ZSTD"));
+  uint64 offset = 0;
+  tstring record;
+  EXPECT_EQ(reader.ReadRecord(&offset, &record).code(), error::DATA_LOSS);
+}
+
+TEST(RecordReaderWriterTest, TestLz4) {
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("LZ4");
+  EXPECT_EQ(options.compression_type, io::RecordWriterOptions::LZ4_COMPRESSION);
+  for (auto buf_size : BufferSizes()) {
+    options.lz4_options.input_buffer_size = buf_size;
+    options.lz4_options.output_buffer_size = buf_size;
+    VerifyOptionalCodec(options, io::Lz4Supported());
+  }
+  options.lz4_options.compression_level = 9;
+  options.lz4_options.block_size = 64 << 10;
+  VerifyOptionalCodec(options, io::Lz4Supported());
+  if (io::Lz4Supported()) VerifyFlush(options);
+}
+
+TEST(RecordReaderWriterTest, TestGzipBlocks) {
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("GZIP");
+  // Read back through GetMatchingReaderOptions().
+  options.zlib_options.decompression_threads = 4;
+  for (int64_t block_size : {1000, 4096, 1 << 20}) {
+    options.zlib_options.block_size = block_size;
+    VerifyOptionalCodec(options, /*supported=*/true);
+  }
+  VerifyFlush(options);
+}
+
+TEST(RecordReaderWriterTest, TestPrefetching) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_prefetch_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 100; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record", i)));
+    }
+    TF_CHECK_OK(writer.Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &read_file));
+  for (auto buf_size : BufferSizes()) {
+    io::RecordReaderOptions options;
+    options.buffer_size = buf_size;
+    options.prefetch_buffers = 2;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    tstring record;
+    for (int i = 0; i < 10; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(strings::StrCat("record", i), record);
+    }
+    int num_skipped;
+    TF_ASSERT_OK(reader.SkipRecords(&offset, 50, &num_skipped));
+    EXPECT_EQ(50, num_skipped);
+    for (int i = 60; i < 100; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(strings::StrCat("record", i), record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+    // Reads from the start again.
+    offset = 0;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("record0", record);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  const string index_fname = io::RecordIndex::IndexFilename(fname);
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    std::unique_ptr<WritableFile> index_file;
+    TF_CHECK_OK(env->NewWritableFile(index_fname, &index_file));
+    io::RecordWriter writer(file.get());
+    TF_ASSERT_OK(writer.EnableIndex(index_file.get(), /*interval=*/3));
+    for (int i = 0; i < 10; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record", i)));
+    }
+    TF_CHECK_OK(writer.Close());
+    EXPECT_EQ(writer.EnableIndex(index_file.get(), 3).code(),
+              error::FAILED_PRECONDITION);
+  }
+
+  uint64 file_size;
+  TF_ASSERT_OK(env->GetFileSize(fname, &file_size));
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(index_fname, &index_file));
+  io::RecordIndex index;
+  EXPECT_EQ(io::RecordIndex::Read(index_file.get(), file_size + 1, &index)
+                .code(),
+            error::FAILED_PRECONDITION);
+  TF_ASSERT_OK(io::RecordIndex::Read(index_file.get(), file_size, &index));
+  EXPECT_EQ(10, index.num_records());
+  // Records 0, 3, 6 and 9, and the end of the file.
+  EXPECT_EQ(5, index.entries().size());
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(read_file.get());
+  for (int i = 0; i < 10; ++i) {
+    int64_t indexed_record_number;
+    uint64 offset;
+    index.Lookup(i, &indexed_record_number, &offset);
+    EXPECT_EQ(i / 3 * 3, indexed_record_number);
+    tstring record;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(strings::StrCat("record", indexed_record_number), record);
+  }
+  int64_t indexed_record_number;
+  uint64 offset;
+  index.Lookup(100, &indexed_record_number, &offset);
+  EXPECT_EQ(10, indexed_record_number);
+  EXPECT_EQ(file_size, offset);
+}
+
+TEST(RecordReaderWriterTest, TestIndexRequiresNoCompression) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_zlib_test";
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(env->NewWritableFile(fname, &file));
+  std::unique_ptr<WritableFile> index_file;
+  TF_CHECK_OK(
+      env->NewWritableFile(io::RecordIndex::IndexFilename(fname), &index_file));
+  io::RecordWriter writer(
+      file.get(), io::RecordWriterOptions::CreateRecordWriterOptions("ZLIB"));
+  EXPECT_EQ(writer.EnableIndex(index_file.get(), 3).code(),
+            error::UNIMPLEMENTED);
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -328,4 +551,68 @@ TEST(RecordReaderWriterTest, TestUseAfterClose) {
   }
 }
 
+// Measures the throughput of reading back records written with each
+// compression type, in uncompressed bytes.
+void BM_ReadCompressedRecords(::testing::benchmark::State& state) {
+  static const char* const kCompressionTypes[] = {
+      "", "ZLIB", "GZIP", "SNAPPY", "ZSTD", "LZ4", "GZIP"};
+  const string compression_type = kCompressionTypes[state.range(0)];
+  // The last configuration writes gzip blocks and decompresses them in
+  // parallel.
+  const bool gzip_blocks = state.range(0) == 6;
+  state.SetLabel(gzip_blocks                ? "GZIP_BLOCKS"
+                 : compression_type.empty() ? "NONE"
+                                            : compression_type);
+  if ((compression_type == "ZSTD" && !io::ZstdSupported()) ||
+      (compression_type == "LZ4" && !io::Lz4Supported())) {
+    state.SkipWithError("Not built with this codec");
+    return;
+  }
+
+  // Records that look like serialized examples: field names repeat across
+  // records while the values vary.
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  const int kNumRecords = 10000;
+  int64_t record_bytes = 0;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type);
+    if (gzip_blocks) options.zlib_options.block_size = 64 << 10;
+    io::RecordWriter writer(file.get(), options);
+    uint64 value = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < kNumRecords; ++i) {
+      string record;
+      for (int j = 0; j < 16; ++j) {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+        strings::StrAppend(&record, "feature/", j, "/value:", value >> 40,
+                           ";label:", i % 10, ";");
+      }
+      record_bytes += record.size();
+      TF_ASSERT_OK(writer.WriteRecord(record));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReaderOptions options =
+      io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+  if (gzip_blocks) options.zlib_options.decompression_threads = 4;
+  for (auto s : state) {
+    io::SequentialRecordReader reader(file.get(), options);
+    tstring record;
+    for (int i = 0; i < kNumRecords; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * record_bytes);
+  TF_ASSERT_OK(env->DeleteFile(fname));
+}
+BENCHMARK(BM_ReadCompressedRecords)->DenseRange(0, 6);
+
 }  // namespace tensorflow
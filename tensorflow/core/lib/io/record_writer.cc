@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/record_writer.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
@@ -30,6 +32,14 @@ bool IsZlibCompressed(const RecordWriterOptions& options) {
 bool IsSnappyCompressed(const RecordWriterOptions& options) {
   return options.compression_type == RecordWriterOptions::SNAPPY_COMPRESSION;
 }
+
+bool IsZstdCompressed(const RecordWriterOptions& options) {
+  return options.compression_type == RecordWriterOptions::ZSTD_COMPRESSION;
+}
+
+bool IsLz4Compressed(const RecordWriterOptions& options) {
+  return options.compression_type == RecordWriterOptions::LZ4_COMPRESSION;
+}
 }  // namespace
 
 RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
@@ -49,6 +59,10 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
   } else if (compression_type == compression::kSnappy) {
     options.compression_type = io::RecordWriterOptions::SNAPPY_COMPRESSION;
+  } else if (compression_type == compression::kZstd) {
+    options.compression_type = io::RecordWriterOptions::ZSTD_COMPRESSION;
+  } else if (compression_type == compression::kLz4) {
+    options.compression_type = io::RecordWriterOptions::LZ4_COMPRESSION;
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No compression will be used.";
@@ -65,7 +79,18 @@ RecordWriter::RecordWriter(WritableFile* dest,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (IsZlibCompressed(options)) {
+  if (IsZlibCompressed(options) && options.zlib_options.block_size > 0 &&
+      options.zlib_options.window_bits > MAX_WBITS) {
+    GzipBlockOutputBuffer* gzip_block_output_buffer =
+        new GzipBlockOutputBuffer(dest, options.zlib_options);
+    // On failure, writes report the error instead.
+    Status s = gzip_block_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to initialize gzip block outputbuffer. Error: "
+                 << s;
+    }
+    dest_ = gzip_block_output_buffer;
+  } else if (IsZlibCompressed(options)) {
     ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
         dest, options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options);
@@ -79,6 +104,24 @@ RecordWriter::RecordWriter(WritableFile* dest,
     dest_ =
         new SnappyOutputBuffer(dest, options.snappy_options.input_buffer_size,
                                options.snappy_options.output_buffer_size);
+  } else if (IsZstdCompressed(options)) {
+    ZstdOutputBuffer* zstd_output_buffer = new ZstdOutputBuffer(
+        dest, options.zstd_options.output_buffer_size, options.zstd_options);
+    // On failure, writes report the error instead.
+    Status s = zstd_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to initialize Zstd outputbuffer. Error: " << s;
+    }
+    dest_ = zstd_output_buffer;
+  } else if (IsLz4Compressed(options)) {
+    Lz4OutputBuffer* lz4_output_buffer = new Lz4OutputBuffer(
+        dest, options.lz4_options.output_buffer_size, options.lz4_options);
+    // On failure, writes report the error instead.
+    Status s = lz4_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to initialize LZ4 outputbuffer. Error: " << s;
+    }
+    dest_ = lz4_output_buffer;
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
   } else {
@@ -96,11 +139,44 @@ RecordWriter::~RecordWriter() {
   }
 }
 
+Status RecordWriter::EnableIndex(WritableFile* index, int64_t interval) {
+  if (options_.compression_type != RecordWriterOptions::NONE) {
+    return errors::Unimplemented(
+        "Indexing compressed TFRecord files is not supported");
+  }
+  if (interval <= 0) {
+    return errors::InvalidArgument("Index interval must be positive, got ",
+                                   interval);
+  }
+  if (num_records_ > 0 || index_writer_ != nullptr) {
+    return errors::FailedPrecondition(
+        "The index must be enabled before writing any record");
+  }
+  index_writer_ = absl::make_unique<RecordWriter>(index);
+  index_interval_ = interval;
+  return Status::OK();
+}
+
+Status RecordWriter::IndexRecord(size_t size) {
+  if (index_writer_ == nullptr) return Status::OK();
+  if (num_records_ % index_interval_ == 0) {
+    char entry[2 * sizeof(uint64)];
+    core::EncodeFixed64(entry, num_records_);
+    core::EncodeFixed64(entry + sizeof(uint64), offset_);
+    TF_RETURN_IF_ERROR(
+        index_writer_->WriteRecord(StringPiece(entry, sizeof(entry))));
+  }
+  ++num_records_;
+  offset_ += kHeaderSize + size + kFooterSize;
+  return Status::OK();
+}
+
 Status RecordWriter::WriteRecord(StringPiece data) {
   if (dest_ == nullptr) {
     return Status(::tensorflow::error::FAILED_PRECONDITION,
                   "Writer not initialized or previously closed");
   }
+  TF_RETURN_IF_ERROR(IndexRecord(data.size()));
   // Format of a single record:
   //  uint64    length
   //  uint32    masked crc of length
@@ -121,6 +197,7 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
     return Status(::tensorflow::error::FAILED_PRECONDITION,
                   "Writer not initialized or previously closed");
   }
+  TF_RETURN_IF_ERROR(IndexRecord(data.size()));
   // Format of a single record:
   //  uint64    length
   //  uint32    masked crc of length
@@ -138,7 +215,17 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
 
 Status RecordWriter::Close() {
   if (dest_ == nullptr) return Status::OK();
-  if (IsZlibCompressed(options_) || IsSnappyCompressed(options_)) {
+  if (index_writer_ != nullptr) {
+    // The last entry holds the number of records and the size of the file.
+    char entry[2 * sizeof(uint64)];
+    core::EncodeFixed64(entry, num_records_);
+    core::EncodeFixed64(entry + sizeof(uint64), offset_);
+    Status s = index_writer_->WriteRecord(StringPiece(entry, sizeof(entry)));
+    s.Update(index_writer_->Close());
+    index_writer_.reset();
+    TF_RETURN_IF_ERROR(s);
+  }
+  if (options_.compression_type != RecordWriterOptions::NONE) {
     Status s = dest_->Close();
     delete dest_;
     dest_ = nullptr;
@@ -152,6 +239,9 @@ Status RecordWriter::Flush() {
     return Status(::tensorflow::error::FAILED_PRECONDITION,
                   "Writer not initialized or previously closed");
   }
+  if (index_writer_ != nullptr) {
+    TF_RETURN_IF_ERROR(index_writer_->Flush());
+  }
   return dest_->Flush();
 }
 
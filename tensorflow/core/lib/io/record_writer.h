@@ -16,15 +16,22 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/gzip_block_outputbuffer.h"
+#include "tensorflow/core/lib/io/lz4/lz4_compression_options.h"
+#include "tensorflow/core/lib/io/lz4/lz4_outputbuffer.h"
 #include "tensorflow/core/lib/io/snappy/snappy_compression_options.h"
 #include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
 #endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/macros.h"
@@ -41,7 +48,9 @@ struct RecordWriterOptions {
   enum CompressionType {
     NONE = 0,
     ZLIB_COMPRESSION = 1,
-    SNAPPY_COMPRESSION = 2
+    SNAPPY_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3,
+    LZ4_COMPRESSION = 4
   };
   CompressionType compression_type = NONE;
 
@@ -52,6 +61,8 @@ struct RecordWriterOptions {
   // Options specific to compression.
   tensorflow::io::ZlibCompressionOptions zlib_options;
   tensorflow::io::SnappyCompressionOptions snappy_options;
+  tensorflow::io::ZstdCompressionOptions zstd_options;
+  tensorflow::io::Lz4CompressionOptions lz4_options;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -77,6 +88,14 @@ class RecordWriter {
   // implicit Close() call in the destructor.
   ~RecordWriter();
 
+  // Makes the writer record in "*index" the offset of every
+  // "interval"-th record, so that readers can start at these records without
+  // scanning the file from its start. See RecordIndex for the format.
+  // "*index" must be initially empty and must remain live while this Writer
+  // is in use. Must be called before any record is written, and only without
+  // compression.
+  Status EnableIndex(WritableFile* index, int64_t interval);
+
   Status WriteRecord(StringPiece data);
 
 #if defined(TF_CORD_SUPPORT)
@@ -111,9 +130,19 @@ class RecordWriter {
 #endif
 
  private:
+  // Adds the record that is about to be written to the index, if it is due.
+  Status IndexRecord(size_t size);
+
   WritableFile* dest_;
   RecordWriterOptions options_;
 
+  // Set by EnableIndex(), together with the number of records written and
+  // the offset of the next record.
+  std::unique_ptr<RecordWriter> index_writer_;
+  int64_t index_interval_ = 0;
+  int64_t num_records_ = 0;
+  uint64 offset_ = 0;
+
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
   }
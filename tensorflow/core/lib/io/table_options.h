@@ -22,6 +22,7 @@ namespace tensorflow {
 namespace table {
 
 class Cache;
+class FilterPolicy;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -68,6 +69,15 @@ struct Options {
 
   // If non-null, use the specified cache for blocks.
   Cache* block_cache = nullptr;
+
+  // If non-null, use the specified filter policy to reduce disk reads.
+  // Tables written with a filter policy store a filter block that readers
+  // opening them with the same policy consult in Table::KeyMayMatch(), so
+  // that lookups of absent keys can skip reading data blocks.  Tables
+  // without a filter block stay readable, and older readers ignore it.
+  // Many applications will benefit from passing the result of
+  // NewBloomFilterPolicy() here.
+  const FilterPolicy* filter_policy = nullptr;
 };
 
 }  // namespace table
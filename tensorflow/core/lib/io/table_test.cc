@@ -17,17 +17,21 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -236,6 +240,7 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.filter_policy = options.filter_policy;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -245,6 +250,10 @@ class TableConstructor : public Constructor {
     return table_->ApproximateOffsetOf(key);
   }
 
+  bool KeyMayMatch(const StringPiece& key) const {
+    return table_->KeyMayMatch(key);
+  }
+
   uint64 BytesRead() const { return source_->BytesRead(); }
 
  private:
@@ -633,5 +642,82 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BloomFilterSkipsAbsentKeys) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  TableConstructor c;
+  for (int i = 0; i < 2000; i += 2) {
+    c.Add(strings::Printf("k%05d", i), string(50, 'v'));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  options.filter_policy = policy.get();
+  c.Finish(options, &keys, &kvmap);
+
+  const uint64 bytes_read = c.BytesRead();
+  int false_positives = 0;
+  for (int i = 0; i < 2000; ++i) {
+    const string key = strings::Printf("k%05d", i);
+    if (i % 2 == 0) {
+      EXPECT_TRUE(c.KeyMayMatch(key)) << key;
+    } else if (c.KeyMayMatch(key)) {
+      ++false_positives;
+    }
+  }
+  // About 1% with 10 bits per key.
+  EXPECT_LT(false_positives, 50);
+  // The filter is loaded when the table is opened.
+  EXPECT_EQ(c.BytesRead(), bytes_read);
+  EXPECT_FALSE(c.KeyMayMatch("a"));
+  EXPECT_FALSE(c.KeyMayMatch("z"));
+
+  // The filter does not change the contents.
+  std::unique_ptr<Iterator> iter(c.NewIterator());
+  iter->SeekToFirst();
+  for (const string& key : keys) {
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ(key, iter->key());
+    iter->Next();
+  }
+  EXPECT_FALSE(iter->Valid());
+}
+
+TEST(TableTest, MissingFilterMatchesAllKeys) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  Options options;
+  options.compression = kNoCompression;
+  std::vector<string> keys;
+  KVMap kvmap;
+
+  // Written without a filter and opened with one.
+  {
+    TableConstructor c;
+    c.Add("k01", "v");
+    c.Finish(options, &keys, &kvmap);
+    EXPECT_TRUE(c.KeyMayMatch("k02"));
+  }
+
+  // Written with a filter and opened without one.
+  {
+    StringSink sink;
+    options.filter_policy = policy.get();
+    TableBuilder builder(options, &sink);
+    builder.Add("k01", "v");
+    TF_ASSERT_OK(builder.Finish());
+    StringSource source(sink.contents());
+    Table* table = nullptr;
+    TF_ASSERT_OK(
+        Table::Open(Options(), &source, sink.contents().size(), &table));
+    std::unique_ptr<Table> table_deleter(table);
+    EXPECT_TRUE(table->KeyMayMatch("k02"));
+    std::unique_ptr<Iterator> iter(table->NewIterator());
+    iter->Seek("k01");
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ("v", iter->value());
+  }
+}
+
 }  // namespace table
 }  // namespace tensorflow
@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/gzip_block_inputstream.h"
+#include "tensorflow/core/lib/io/gzip_block_outputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -372,5 +375,122 @@ TEST(ZlibInputStream, TestSoftErrorOnDecompressGzip) {
   TestSoftErrorOnDecompress(CompressionOptions::GZIP());
 }
 
+void WriteGzipBlockFile(Env* env, const string& fname, int64_t block_size,
+                        const string& data) {
+  std::unique_ptr<WritableFile> file_writer;
+  TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+
+  CompressionOptions options = CompressionOptions::GZIP();
+  options.block_size = block_size;
+  GzipBlockOutputBuffer out(file_writer.get(), options);
+  TF_ASSERT_OK(out.Init());
+  // Appends pieces of varying sizes, so that they straddle blocks.
+  for (size_t pos = 0, n = 1; pos < data.size(); pos += n, n = n * 3 + 1) {
+    TF_ASSERT_OK(out.Append(StringPiece(data).substr(pos, n)));
+  }
+  TF_ASSERT_OK(out.Close());
+  TF_ASSERT_OK(file_writer->Close());
+}
+
+TEST(GzipBlocks, RoundTrip) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  for (auto file_size : NumCopies()) {
+    string data = GenTestString(file_size);
+    for (int64_t block_size : {100, 1000, 64 << 10}) {
+      WriteGzipBlockFile(env, fname, block_size, data);
+      std::unique_ptr<RandomAccessFile> file_reader;
+      TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+
+      for (int threads : {1, 4}) {
+        RandomAccessInputStream input_stream(file_reader.get());
+        CompressionOptions options = CompressionOptions::GZIP();
+        options.decompression_threads = threads;
+        GzipBlockInputStream in(&input_stream, options, false);
+        tstring first_half;
+        TF_ASSERT_OK(in.ReadNBytes(data.size() / 2, &first_half));
+        EXPECT_EQ(in.Tell(), data.size() / 2);
+        tstring second_half;
+        TF_ASSERT_OK(in.ReadNBytes(data.size() - first_half.size(),
+                                   &second_half));
+        EXPECT_EQ(in.Tell(), data.size());
+        EXPECT_EQ(first_half + second_half, data);
+
+        tstring rest;
+        EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &rest)));
+        EXPECT_TRUE(rest.empty());
+
+        TF_ASSERT_OK(in.Reset());
+        EXPECT_EQ(in.Tell(), 0);
+        tstring result;
+        TF_ASSERT_OK(in.SkipNBytes(data.size() / 3));
+        TF_ASSERT_OK(in.ReadNBytes(data.size() - data.size() / 3, &result));
+        EXPECT_EQ(result, data.substr(data.size() / 3));
+      }
+
+      // The concatenated blocks are plain gzip.
+      RandomAccessInputStream input_stream(file_reader.get());
+      ZlibInputStream in(&input_stream, 1000, 1000,
+                         CompressionOptions::GZIP());
+      tstring result;
+      TF_ASSERT_OK(in.ReadNBytes(data.size(), &result));
+      EXPECT_EQ(result, data);
+    }
+  }
+}
+
+TEST(GzipBlocks, ReadsPlainGzip) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  string data = GenTestString(50);
+  WriteCompressedFile(env, fname, 1000, 1000, CompressionOptions::GZIP(), data);
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+  RandomAccessInputStream input_stream(file_reader.get());
+  CompressionOptions options = CompressionOptions::GZIP();
+  options.decompression_threads = 4;
+  GzipBlockInputStream in(&input_stream, options, false);
+  tstring result;
+  TF_ASSERT_OK(in.ReadNBytes(data.size(), &result));
+  EXPECT_EQ(result, data);
+  EXPECT_EQ(in.Tell(), data.size());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &result)));
+}
+
+TEST(GzipBlocks, DetectsCorruption) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  string data = GenTestString(50);
+  WriteGzipBlockFile(env, fname, 1000, data);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &contents));
+
+  CompressionOptions options = CompressionOptions::GZIP();
+  options.decompression_threads = 4;
+  // Flips a byte in the compressed data of the third block, then truncates
+  // the file in the middle of a block.
+  string corrupted = contents;
+  size_t offset = 0;
+  for (int i = 0; i < 2; ++i) {
+    offset += core::DecodeFixed32(corrupted.data() + offset + 16);
+  }
+  corrupted[offset + GzipBlockOutputBuffer::kHeaderSize + 10] ^= 0x55;
+  for (const string& file_contents :
+       {corrupted, contents.substr(0, contents.size() - 10)}) {
+    TF_ASSERT_OK(WriteStringToFile(env, fname, file_contents));
+    std::unique_ptr<RandomAccessFile> file_reader;
+    TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+    RandomAccessInputStream input_stream(file_reader.get());
+    GzipBlockInputStream in(&input_stream, options, false);
+    tstring result;
+    Status s = in.ReadNBytes(data.size(), &result);
+    EXPECT_EQ(s.code(), error::DATA_LOSS) << s;
+  }
+}
+
 }  // namespace io
 }  // namespace tensorflow
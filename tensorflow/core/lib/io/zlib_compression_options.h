@@ -117,6 +117,23 @@ class ZlibCompressionOptions {
   //
   // This option is ignored for `ZlibOutputBuffer`.
   bool soft_fail_on_error = false;  // NOLINT
+
+  // If positive and writing gzip (window_bits > 15), RecordWriter compresses
+  // every `block_size` bytes of input into an independent gzip member whose
+  // header records its compressed size, see GzipBlockOutputBuffer. Standard
+  // gzip tools read such files as usual, and readers can decompress several
+  // blocks in parallel. Smaller blocks compress slightly worse. At most 1GB.
+  // Defaults to 0, a single gzip stream.
+  //
+  // This option is ignored for reading.
+  int64_t block_size = 0;
+
+  // If greater than 1, RecordReader decompresses files written with
+  // `block_size` on this many threads, see GzipBlockInputStream. Other files
+  // are decompressed serially as before.
+  //
+  // This option is ignored for writing.
+  int32 decompression_threads = 0;
 };
 
 inline ZlibCompressionOptions ZlibCompressionOptions::DEFAULT() {
@@ -0,0 +1,57 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
+
+#include <string>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+struct ZstdCompressionOptions {
+  // Size of the buffer used for caching the data read from source file.
+  int64_t input_buffer_size = 256 << 10;
+
+  // Size of the sink buffer where the compressed/decompressed data produced by
+  // zstd is cached.
+  int64_t output_buffer_size = 256 << 10;
+
+  // Compression level between 1 (fastest) and 22 (smallest); negative levels
+  // trade even more ratio for speed. 0 selects zstd's default level (3).
+  int32 compression_level = 0;
+
+  // Base-2 logarithm of the largest back-reference distance. Larger windows
+  // compress better but need more memory to decompress. 0 lets zstd choose
+  // from the compression level. Readers must use a window_log at least as
+  // large as the writer's when it exceeds 27.
+  int32 window_log = 0;
+
+  // Dictionary for compressing or decompressing, either raw content or
+  // trained with `zstd --train`. Small records compress much better with a
+  // dictionary trained on similar data. Readers must use the same dictionary
+  // as the writer.
+  std::string dictionary;
+};
+
+// Returns true if TensorFlow was built with zstd support.
+bool ZstdSupported();
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_COMPRESSION_OPTIONS_H_
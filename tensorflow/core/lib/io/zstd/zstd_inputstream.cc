@@ -0,0 +1,202 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(TF_USE_ZSTD)
+#include "zstd.h"
+#endif
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const ZstdCompressionOptions& zstd_options,
+                                 bool owns_input_stream)
+    : input_stream_(input_stream),
+      input_buffer_bytes_(input_buffer_bytes),
+      output_buffer_bytes_(output_buffer_bytes),
+      zstd_options_(zstd_options),
+      owns_input_stream_(owns_input_stream),
+      output_buffer_(new char[output_buffer_bytes]) {
+  init_status_ = Init();
+}
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const ZstdCompressionOptions& zstd_options)
+    : ZstdInputStream(input_stream, input_buffer_bytes, output_buffer_bytes,
+                      zstd_options, false) {}
+
+ZstdInputStream::~ZstdInputStream() {
+#if defined(TF_USE_ZSTD)
+  ZSTD_freeDCtx(context_);
+#endif
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+Status ZstdInputStream::Init() {
+#if defined(TF_USE_ZSTD)
+  if (input_buffer_bytes_ == 0 || output_buffer_bytes_ == 0) {
+    return errors::InvalidArgument("zstd buffer sizes must be positive");
+  }
+  context_ = ZSTD_createDCtx();
+  if (context_ == nullptr) {
+    return errors::ResourceExhausted("Failed to create a zstd context");
+  }
+  if (zstd_options_.window_log > 0) {
+    const size_t ret = ZSTD_DCtx_setParameter(
+        context_, ZSTD_d_windowLogMax, zstd_options_.window_log);
+    if (ZSTD_isError(ret)) {
+      return errors::InvalidArgument("Invalid zstd window_log ",
+                                     zstd_options_.window_log, ": ",
+                                     ZSTD_getErrorName(ret));
+    }
+  }
+  if (!zstd_options_.dictionary.empty()) {
+    const size_t ret =
+        ZSTD_DCtx_loadDictionary(context_, zstd_options_.dictionary.data(),
+                                 zstd_options_.dictionary.size());
+    if (ZSTD_isError(ret)) {
+      return errors::InvalidArgument("Failed to load the zstd dictionary: ",
+                                     ZSTD_getErrorName(ret));
+    }
+  }
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+Status ZstdInputStream::ReadNBytes(int64_t bytes_to_read, tstring* result) {
+  result->clear();
+  TF_RETURN_IF_ERROR(init_status_);
+  result->resize_uninitialized(bytes_to_read);
+
+  char* result_ptr = result->mdata();
+  // Read as many bytes as possible from the cache.
+  size_t bytes_read = ReadBytesFromCache(bytes_to_read, result_ptr);
+  bytes_to_read -= bytes_read;
+  result_ptr += bytes_read;
+
+  while (bytes_to_read > 0) {
+    DCHECK_EQ(avail_out_, 0);
+    // Fill the cache with more data.
+    Status s = Inflate();
+    if (!s.ok()) {
+      result->resize(result_ptr - result->data());
+      return s;
+    }
+    bytes_read = ReadBytesFromCache(bytes_to_read, result_ptr);
+    bytes_to_read -= bytes_read;
+    result_ptr += bytes_read;
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ZstdInputStream::ReadNBytes(int64_t bytes_to_read, absl::Cord* result) {
+  tstring buf;
+  Status s = ReadNBytes(bytes_to_read, &buf);
+  result->Clear();
+  result->Append(buf.data());
+  return s;
+}
+#endif
+
+Status ZstdInputStream::Inflate() {
+#if defined(TF_USE_ZSTD)
+  ZSTD_outBuffer output = {output_buffer_.get(), output_buffer_bytes_, 0};
+  while (output.pos == 0) {
+    if (input_pos_ == input_buffer_.size() && !input_exhausted_) {
+      Status s = input_stream_->ReadNBytes(input_buffer_bytes_, &input_buffer_);
+      input_pos_ = 0;
+      if (errors::IsOutOfRange(s)) {
+        input_exhausted_ = true;
+      } else {
+        TF_RETURN_IF_ERROR(s);
+      }
+      continue;
+    }
+    if (input_pos_ == input_buffer_.size() && frame_finished_) {
+      return errors::OutOfRange("End of zstd stream");
+    }
+    ZSTD_inBuffer input = {input_buffer_.data(), input_buffer_.size(),
+                           input_pos_};
+    const size_t ret = ZSTD_decompressStream(context_, &output, &input);
+    if (ZSTD_isError(ret)) {
+      return errors::DataLoss("zstd decompression failed: ",
+                              ZSTD_getErrorName(ret));
+    }
+    input_pos_ = input.pos;
+    frame_finished_ = ret == 0;
+    // A stream that ends within a frame, such as a file that is still being
+    // written, ends at the last complete block.
+    if (output.pos == 0 && input_exhausted_ &&
+        input_pos_ == input_buffer_.size()) {
+      return errors::OutOfRange("End of zstd stream");
+    }
+  }
+  next_out_ = output_buffer_.get();
+  avail_out_ = output.pos;
+  return Status::OK();
+#else
+  return init_status_;
+#endif
+}
+
+size_t ZstdInputStream::ReadBytesFromCache(size_t bytes_to_read,
+                                           char* result) {
+  const size_t can_read_bytes = std::min(bytes_to_read, avail_out_);
+  if (can_read_bytes > 0) {
+    memcpy(result, next_out_, can_read_bytes);
+    next_out_ += can_read_bytes;
+    avail_out_ -= can_read_bytes;
+  }
+  bytes_read_ += can_read_bytes;
+  return can_read_bytes;
+}
+
+int64_t ZstdInputStream::Tell() const { return bytes_read_; }
+
+Status ZstdInputStream::Reset() {
+  TF_RETURN_IF_ERROR(init_status_);
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+#if defined(TF_USE_ZSTD)
+  ZSTD_DCtx_reset(context_, ZSTD_reset_session_only);
+#endif
+  input_buffer_.clear();
+  input_pos_ = 0;
+  input_exhausted_ = false;
+  frame_finished_ = true;
+  avail_out_ = 0;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
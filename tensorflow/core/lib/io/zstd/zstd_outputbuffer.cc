@@ -0,0 +1,183 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
+
+#if defined(TF_USE_ZSTD)
+#include "zstd.h"
+#endif
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ZstdOutputBuffer::ZstdOutputBuffer(WritableFile* file,
+                                   int32_t output_buffer_bytes,
+                                   const ZstdCompressionOptions& zstd_options)
+    : file_(file),
+      output_buffer_capacity_(output_buffer_bytes),
+      zstd_options_(zstd_options),
+      output_buffer_(new char[output_buffer_bytes]) {}
+
+ZstdOutputBuffer::~ZstdOutputBuffer() {
+#if defined(TF_USE_ZSTD)
+  ZSTD_freeCCtx(context_);
+#endif
+}
+
+Status ZstdOutputBuffer::Init() {
+  init_status_ = CreateContext();
+  return init_status_;
+}
+
+Status ZstdOutputBuffer::CheckOpen() const {
+  if (!init_status_.ok()) return init_status_;
+  if (context_ == nullptr) {
+    return errors::FailedPrecondition(
+        "ZstdOutputBuffer is closed or not initialized");
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::CreateContext() {
+#if defined(TF_USE_ZSTD)
+  if (output_buffer_capacity_ == 0) {
+    return errors::InvalidArgument("zstd output buffer size must be positive");
+  }
+  context_ = ZSTD_createCCtx();
+  if (context_ == nullptr) {
+    return errors::ResourceExhausted("Failed to create a zstd context");
+  }
+  size_t ret = ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel,
+                                      zstd_options_.compression_level);
+  if (ZSTD_isError(ret)) {
+    return errors::InvalidArgument("Invalid zstd compression_level ",
+                                   zstd_options_.compression_level, ": ",
+                                   ZSTD_getErrorName(ret));
+  }
+  if (zstd_options_.window_log > 0) {
+    ret = ZSTD_CCtx_setParameter(context_, ZSTD_c_windowLog,
+                                 zstd_options_.window_log);
+    if (ZSTD_isError(ret)) {
+      return errors::InvalidArgument("Invalid zstd window_log ",
+                                     zstd_options_.window_log, ": ",
+                                     ZSTD_getErrorName(ret));
+    }
+  }
+  if (!zstd_options_.dictionary.empty()) {
+    ret = ZSTD_CCtx_loadDictionary(context_, zstd_options_.dictionary.data(),
+                                   zstd_options_.dictionary.size());
+    if (ZSTD_isError(ret)) {
+      return errors::InvalidArgument("Failed to load the zstd dictionary: ",
+                                     ZSTD_getErrorName(ret));
+    }
+  }
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+Status ZstdOutputBuffer::Append(StringPiece data) {
+#if defined(TF_USE_ZSTD)
+  return Compress(data, ZSTD_e_continue);
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ZstdOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status ZstdOutputBuffer::Close() {
+#if defined(TF_USE_ZSTD)
+  TF_RETURN_IF_ERROR(Compress(StringPiece(), ZSTD_e_end));
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  ZSTD_freeCCtx(context_);
+  context_ = nullptr;
+  return Status::OK();
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+Status ZstdOutputBuffer::Flush() {
+#if defined(TF_USE_ZSTD)
+  TF_RETURN_IF_ERROR(Compress(StringPiece(), ZSTD_e_flush));
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  return file_->Flush();
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+Status ZstdOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ZstdOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ZstdOutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
+Status ZstdOutputBuffer::Compress(StringPiece data, int end_directive) {
+#if defined(TF_USE_ZSTD)
+  TF_RETURN_IF_ERROR(CheckOpen());
+  ZSTD_inBuffer input = {data.data(), data.size(), 0};
+  while (true) {
+    ZSTD_outBuffer output = {output_buffer_.get(), output_buffer_capacity_,
+                             output_pos_};
+    const size_t remaining = ZSTD_compressStream2(
+        context_, &output, &input,
+        static_cast<ZSTD_EndDirective>(end_directive));
+    if (ZSTD_isError(remaining)) {
+      return errors::Internal("zstd compression failed: ",
+                              ZSTD_getErrorName(remaining));
+    }
+    output_pos_ = output.pos;
+    if (output_pos_ == output_buffer_capacity_) {
+      TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+    }
+    if (end_directive == ZSTD_e_continue ? input.pos == input.size
+                                         : remaining == 0) {
+      return Status::OK();
+    }
+  }
+#else
+  return errors::Unimplemented("TensorFlow was not built with zstd support");
+#endif
+}
+
+Status ZstdOutputBuffer::FlushOutputBufferToFile() {
+  if (output_pos_ == 0) return Status::OK();
+  TF_RETURN_IF_ERROR(
+      file_->Append(StringPiece(output_buffer_.get(), output_pos_)));
+  output_pos_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
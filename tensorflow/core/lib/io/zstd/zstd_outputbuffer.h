@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+struct ZSTD_CCtx_s;
+
+namespace tensorflow {
+namespace io {
+
+// Compresses input data using Zstandard (https://facebook.github.io/zstd/)
+// and writes it to `file`.
+//
+// zstd buffers the input itself, so only the compressed output is cached, in
+// a buffer of size `output_buffer_bytes` which gets written to file when full.
+// Flush() ends the current block so that everything appended so far can be
+// decompressed, at some cost in compression ratio.
+//
+// A given instance of an ZstdOutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class ZstdOutputBuffer : public WritableFile {
+ public:
+  // Does not take ownership of `file`.
+  ZstdOutputBuffer(WritableFile* file, int32_t output_buffer_bytes,
+                   const ZstdCompressionOptions& zstd_options);
+
+  // Per convention, the dtor does not call Flush() or Close(). We expect the
+  // caller to call those manually when done.
+  ~ZstdOutputBuffer() override;
+
+  // Initializes the compression context. This call is required before any
+  // other operation on the buffer.
+  Status Init();
+
+  // Adds `data` to the compression pipeline.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Ends the zstd frame and writes all output to file. This must be called
+  // before the destructor to avoid any data loss. Does not close `file`.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or
+  // `Close()` will fail.
+  Status Close() override;
+
+  // Compresses any buffered input and writes all output to file.
+  Status Flush() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Compresses any buffered input, writes all output to file and syncs it.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64_t* position) override;
+
+ private:
+  // Creates the compression context for Init().
+  Status CreateContext();
+
+  // Returns OK if the buffer is initialized and not closed yet.
+  Status CheckOpen() const;
+
+  // Feeds `data` to zstd with the given ZSTD_EndDirective, writing the output
+  // to file whenever `output_buffer_` fills up. With ZSTD_e_flush or
+  // ZSTD_e_end, returns once zstd has produced all of its output.
+  Status Compress(StringPiece data, int end_directive);
+
+  // Appends the contents of `output_buffer_` to `file_`.
+  Status FlushOutputBufferToFile();
+
+  WritableFile* file_;  // Not owned
+  const size_t output_buffer_capacity_;
+  const ZstdCompressionOptions zstd_options_;
+
+  ZSTD_CCtx_s* context_ = nullptr;
+  // The result of Init().
+  Status init_status_;
+
+  std::unique_ptr<char[]> output_buffer_;
+  size_t output_pos_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ZstdOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
@@ -354,13 +354,13 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   tempdata = nullptr;
 
 #if defined(LIBJPEG_TURBO_VERSION)
-  if (flags.crop && cinfo.output_scanline < cinfo.output_height) {
-    // Skip the rest of scanlines, required by jpeg_destroy_decompress.
-    jpeg_skip_scanlines(&cinfo,
-                        cinfo.output_height - flags.crop_y - flags.crop_height);
-    // After this, cinfo.output_height must be equal to cinfo.output_height;
-    // otherwise, jpeg_destroy_decompress would fail.
-  }
+  // The scanlines below the crop window are not needed. Skipping them would
+  // still entropy decode them just so that jpeg_finish_decompress can check
+  // the end of the data, so abort the decompression instead.
+  const bool skip_remaining_scanlines =
+      flags.crop && cinfo.output_scanline < cinfo.output_height;
+#else
+  const bool skip_remaining_scanlines = false;
 #endif
 
   // Convert the RGB data to RGBA, with alpha set to 0xFF to indicate
@@ -424,7 +424,11 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   // Handle errors in JPEG
   switch (error) {
     case JPEGERRORS_OK:
-      jpeg_finish_decompress(&cinfo);
+      if (skip_remaining_scanlines) {
+        jpeg_abort_decompress(&cinfo);
+      } else {
+        jpeg_finish_decompress(&cinfo);
+      }
       break;
     case JPEGERRORS_UNEXPECTED_END_OF_DATA:
     case JPEGERRORS_BAD_PARAM:
@@ -548,6 +552,18 @@ uint8* Uncompress(const void* srcdata, int datasize,
   return result;
 }
 
+int ScaleRatioForSize(int width, int height, int target_width,
+                      int target_height) {
+  for (int ratio = 8; ratio > 1; ratio /= 2) {
+    // libjpeg rounds the scaled dimensions up.
+    if ((width + ratio - 1) / ratio >= target_width &&
+        (height + ratio - 1) / ratio >= target_height) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
 // ----------------------------------------------------------------------------
 // Computes image information from jpeg header.
 // Returns true on success; false on failure.
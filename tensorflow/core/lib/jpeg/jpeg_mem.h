@@ -100,6 +100,12 @@ uint8* Uncompress(const void* srcdata, int datasize,
                   const UncompressFlags& flags, int64_t* nwarn,
                   std::function<uint8*(int, int, int)> allocate_output);
 
+// Returns the largest ratio in UncompressFlags::ratio that decodes an image of
+// width x height to at least target_width x target_height pixels, or 1 if no
+// such ratio downscales it.
+int ScaleRatioForSize(int width, int height, int target_width,
+                      int target_height);
+
 // Read jpeg header and get image information.  Returns true on success.
 // The width, height, and components points may be null.
 bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
@@ -283,6 +283,20 @@ TEST(JpegMemTest, CropAndDecodeJpegWithInvalidCropWindow) {
   CheckInvalidCropWindowFailed(temp, fsize, 11, /*y=*/h - 10, 11, 11);
 }
 
+TEST(JpegMemTest, ScaleRatioForSize) {
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 640, 480), 1);
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 320, 240), 2);
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 321, 240), 1);
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 80, 60), 8);
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 10, 10), 8);
+  EXPECT_EQ(ScaleRatioForSize(640, 480, 100, 60), 4);
+  // libjpeg rounds the scaled size up, so 1/4 of 41 x 41 decodes to 11 x 11.
+  EXPECT_EQ(ScaleRatioForSize(41, 41, 11, 11), 4);
+  EXPECT_EQ(ScaleRatioForSize(40, 40, 11, 11), 2);
+  // Upscaling needs the full size image.
+  EXPECT_EQ(ScaleRatioForSize(64, 64, 128, 128), 1);
+}
+
 TEST(JpegMemTest, Jpeg2) {
   // create known data, for size in_w x in_h
   const int in_w = 256;
@@ -111,6 +111,8 @@ class PhiloxRandom {
   // The type for the 64-bit key stored in the form of two 32-bit uint
   // that are used in the diffusion process.
   using Key = Array<uint32, 2>;
+  // The number of groups that GenerateBatch computes at once.
+  static constexpr int kBatchSize = 16;
 
   PHILOX_DEVICE_INLINE
   PhiloxRandom() {}
@@ -190,6 +192,48 @@ class PhiloxRandom {
     return counter;
   }
 
+  // Fills `groups` with the next kBatchSize groups of random numbers, the same
+  // as kBatchSize invocations of operator() return. The groups are computed
+  // side by side in lanes rather than one after the other, so that the
+  // compiler vectorizes the rounds on CPU, e.g. 8 or 16 lanes per instruction
+  // with AVX2 or AVX-512. Host only.
+  void GenerateBatch(ResultType* groups) {
+    uint32 c0[kBatchSize];
+    uint32 c1[kBatchSize];
+    uint32 c2[kBatchSize];
+    uint32 c3[kBatchSize];
+    for (int i = 0; i < kBatchSize; ++i) {
+      c0[i] = counter_[0];
+      c1[i] = counter_[1];
+      c2[i] = counter_[2];
+      c3[i] = counter_[3];
+      SkipOne();
+    }
+
+    uint32 key0 = key_[0];
+    uint32 key1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      // The same as ComputeSingleRound, for every lane.
+      for (int i = 0; i < kBatchSize; ++i) {
+        const uint64 product0 = static_cast<uint64>(kPhiloxM4x32A) * c0[i];
+        const uint64 product1 = static_cast<uint64>(kPhiloxM4x32B) * c2[i];
+        c0[i] = static_cast<uint32>(product1 >> 32) ^ c1[i] ^ key0;
+        c2[i] = static_cast<uint32>(product0 >> 32) ^ c3[i] ^ key1;
+        c1[i] = static_cast<uint32>(product1);
+        c3[i] = static_cast<uint32>(product0);
+      }
+      key0 += kPhiloxW32A;
+      key1 += kPhiloxW32B;
+    }
+
+    for (int i = 0; i < kBatchSize; ++i) {
+      groups[i][0] = c0[i];
+      groups[i][1] = c1[i];
+      groups[i][2] = c2[i];
+      groups[i][3] = c3[i];
+    }
+  }
+
  private:
   // We use the same constants as recommended by the original paper.
   static constexpr uint32 kPhiloxW32A = 0x9E3779B9;
@@ -252,6 +296,35 @@ class PhiloxRandom {
   Key key_;
 };
 
+// A generator that returns the same stream as the PhiloxRandom it is
+// constructed from, computing kBatchSize groups at a time with GenerateBatch.
+// It is meant to be used in place of a PhiloxRandom by the distributions that
+// draw many groups on CPU.
+class BatchedPhiloxRandom {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+  using ResultElementType = PhiloxRandom::ResultElementType;
+  // The number of elements that will be returned.
+  static constexpr int kResultElementCount = PhiloxRandom::kResultElementCount;
+  // Cost of generation of a single element (in cycles).
+  static constexpr int kElementCost = PhiloxRandom::kElementCost;
+
+  explicit BatchedPhiloxRandom(const PhiloxRandom& gen) : gen_(gen) {}
+
+  ResultType operator()() {
+    if (next_ == PhiloxRandom::kBatchSize) {
+      gen_.GenerateBatch(groups_);
+      next_ = 0;
+    }
+    return groups_[next_++];
+  }
+
+ private:
+  PhiloxRandom gen_;
+  ResultType groups_[PhiloxRandom::kBatchSize];
+  int next_ = PhiloxRandom::kBatchSize;
+};
+
 }  // namespace random
 }  // namespace tensorflow
 
@@ -68,6 +68,41 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+TEST(PhiloxRandomTest, GenerateBatchMatchesSingleGroups) {
+  PhiloxRandom gen(GetTestSeed(), GetTestSeed());
+  // Start next to a carry of the low counter word.
+  gen.Skip(0xfffffff8u);
+  PhiloxRandom single = gen;
+  for (int batch = 0; batch < 3; ++batch) {
+    PhiloxRandom::ResultType groups[PhiloxRandom::kBatchSize];
+    gen.GenerateBatch(groups);
+    for (int i = 0; i < PhiloxRandom::kBatchSize; ++i) {
+      const PhiloxRandom::ResultType expected = single();
+      for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+        ASSERT_EQ(groups[i][j], expected[j]);
+      }
+    }
+  }
+  // Both generators are at the same point of the stream afterwards.
+  const PhiloxRandom::ResultType next = gen();
+  const PhiloxRandom::ResultType expected = single();
+  for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+    EXPECT_EQ(next[j], expected[j]);
+  }
+}
+
+TEST(PhiloxRandomTest, BatchedPhiloxRandomMatchesPhiloxRandom) {
+  PhiloxRandom gen(GetTestSeed());
+  BatchedPhiloxRandom batched(gen);
+  for (int i = 0; i < 3 * PhiloxRandom::kBatchSize + 5; ++i) {
+    const PhiloxRandom::ResultType expected = gen();
+    const PhiloxRandom::ResultType sample = batched();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(sample[j], expected[j]);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/nccl/nccl_manager.h"
 
+#include <type_traits>
 #include <utility>
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
 #elif TENSORFLOW_USE_ROCM
@@ -85,14 +87,20 @@ struct NcclManager::NcclStream : public core::RefCounted {
   std::unique_ptr<se::Stream> stream;
 #endif
 
+  // A kernel to launch, for one stripe of one participant of a collective.
+  struct Launch {
+    Collective* collective;
+    int participant_idx;
+    int stripe;
+  };
+
   // `mu` protects access to `pending_launches_`, which is the list of
   // collectives ready but whose kernels are yet to be launched.  When the
   // NcclManager object that owns this NcclStream object is destroyed, it
   // signals `cv` to unblock the thread waiting on more collectives.
   mutex mu;
   condition_variable cv;
-  // Has (collective, participant_idx) pairs.
-  std::deque<std::pair<Collective*, int>> pending_launches_ TF_GUARDED_BY(mu);
+  std::deque<Launch> pending_launches_ TF_GUARDED_BY(mu);
   bool shutdown_requested TF_GUARDED_BY(mu) = false;
 };
 
@@ -111,16 +119,28 @@ struct NcclManager::CommunicatorMember {
 struct NcclManager::Communicator {
  public:
   explicit Communicator(std::vector<CommunicatorMember> members,
-                        const string& key)
-      : num_devices(members.size()), members(std::move(members)), key(key) {}
+                        const string& key, int stripe)
+      : num_devices(members.size()),
+        members(std::move(members)),
+        key(key),
+        stripe(stripe) {}
 
   const int num_devices;
   std::vector<CommunicatorMember> members;
+  // The NCCL unique id of the communicator for multi-node collectives.
   const string key;
+  // The stripe of the collectives that the communicator runs.
+  const int stripe;
 };
 
 namespace {
 
+// Stripes start at multiples of this many elements, to keep their buffers
+// aligned.
+constexpr int64_t kStripeAlignment = 64;
+
+constexpr int64_t kDefaultMinStripeBytes = 16 << 20;
+
 static constexpr DataTypeSet kValidDataTypes =
     ToSet(DT_HALF) | ToSet(DT_FLOAT) | ToSet(DT_DOUBLE) | ToSet(DT_INT32) |
     ToSet(DT_INT64);
@@ -148,6 +168,26 @@ void StringToNcclUniqueId(const string& str_id, ncclUniqueId* nccl_id) {
   }
 }
 
+// Returns the part of `communicator_key` for the communicator of `stripe`.
+string StripeCommunicatorKey(const string& communicator_key, int stripe) {
+  if (communicator_key.empty()) return communicator_key;
+  return communicator_key.substr(stripe * NCCL_UNIQUE_ID_BYTES,
+                                 NCCL_UNIQUE_ID_BYTES);
+}
+
+int NumStripesFromEnv() {
+  int64_t num_stripes;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_NUM_STRIPES", 1, &num_stripes));
+  return num_stripes;
+}
+
+int64_t MinStripeBytesFromEnv() {
+  int64_t min_stripe_bytes;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_MIN_STRIPE_BYTES",
+                                  kDefaultMinStripeBytes, &min_stripe_bytes));
+  return min_stripe_bytes;
+}
+
 }  // namespace
 
 // A `Collective` encapsulates state for a collective instance at one node.
@@ -194,7 +234,12 @@ struct NcclManager::Collective : public core::RefCounted {
   const bool single_node;          // true if all devices are at one node
   const string communicator_key;
 
-  Communicator* communicator = nullptr;
+  // The number of contiguous stripes the tensors are split into, and the
+  // number of elements of each stripe but the last.  Each stripe runs on its
+  // own communicator.
+  int num_stripes = 1;
+  int64_t stripe_elements = 0;
+  std::vector<Communicator*> communicators;
 
   // All collective participants.
   //
@@ -223,10 +268,33 @@ struct NcclManager::Collective : public core::RefCounted {
   uint64 trace_context = 0;
 
   Status status;
+
+  // Records that the kernel of one stripe of participant `participant_idx`
+  // finished with `stripe_status`.  Returns true and sets `participant_status`
+  // to the first error of the participant's stripes once they all finished.
+  bool FinishStripe(int participant_idx, const Status& stripe_status,
+                    Status* participant_status) {
+    mutex_lock l(mu);
+    participant_statuses[participant_idx].Update(stripe_status);
+    if (--num_pending_stripes[participant_idx] > 0) return false;
+    *participant_status = participant_statuses[participant_idx];
+    return true;
+  }
+
+  mutex mu;
+  // The number of stripes of each participant whose kernels have not finished.
+  std::vector<int> num_pending_stripes TF_GUARDED_BY(mu);
+  std::vector<Status> participant_statuses TF_GUARDED_BY(mu);
 };
 
-NcclManager::NcclManager() {
-  VLOG(2) << "New NcclManager " << this;
+NcclManager::NcclManager()
+    : NcclManager(NumStripesFromEnv(), MinStripeBytesFromEnv()) {}
+
+NcclManager::NcclManager(int num_stripes, int64_t min_stripe_bytes)
+    : num_stripes_(std::max(num_stripes, 1)),
+      min_stripe_bytes_(min_stripe_bytes) {
+  VLOG(2) << "New NcclManager " << this << " with " << num_stripes_
+          << " stripes";
 #if TENSORFLOW_USE_ROCM
   ++instance_count;
 #endif
@@ -259,13 +327,22 @@ NcclManager* NcclManager::instance() {
 }
 
 string NcclManager::GenerateCommunicatorKey() {
-  ncclUniqueId nccl_id;
-  ncclGetUniqueId(&nccl_id);
-  return string(nccl_id.internal, NCCL_UNIQUE_ID_BYTES);
+  string key;
+#if TENSORFLOW_USE_ROCM
+  const int num_stripes = 1;
+#else
+  const int num_stripes = num_stripes_;
+#endif
+  for (int i = 0; i < num_stripes; ++i) {
+    ncclUniqueId nccl_id;
+    ncclGetUniqueId(&nccl_id);
+    key.append(nccl_id.internal, NCCL_UNIQUE_ID_BYTES);
+  }
+  return key;
 }
 
-Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
-                                    NcclManager::Communicator** communicator) {
+Status NcclManager::GetCommunicators(NcclManager::Collective* collective,
+                                     bool create) {
   // Sort by device ID, executor, and global rank to make ordering of
   // participants deterministic.
   std::sort(collective->participants.begin(), collective->participants.end(),
@@ -285,12 +362,49 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     return status_;
   }
 
+  if (!collective->communicator_key.empty()) {
+#if NCCL_MAJOR < 2
+    return errors::Internal(
+        "Cannot use multi-node NCCL collectives with NCCL 1.x");
+#endif
+    if (collective->communicator_key.size() % NCCL_UNIQUE_ID_BYTES != 0) {
+      return errors::Internal(
+          "Expected communicator_key of size a multiple of ",
+          NCCL_UNIQUE_ID_BYTES, " but found size ",
+          collective->communicator_key.size());
+    }
+  }
+
+  // The stripes of a collective run concurrently, so their communicators use
+  // different communication streams where possible.
+  std::set<NcclStream*> used_streams;
+  collective->communicators.clear();
+  for (int stripe = 0; stripe < collective->num_stripes; ++stripe) {
+    Communicator* communicator = FindCommunicator(collective, stripe);
+    if (communicator == nullptr) {
+      if (!create) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(CreateCommunicator(collective, stripe, used_streams,
+                                            &communicator));
+    }
+    for (const CommunicatorMember& member : communicator->members) {
+      used_streams.insert(member.nccl_stream);
+    }
+    collective->communicators.push_back(communicator);
+  }
+  return Status::OK();
+}
+
+NcclManager::Communicator* NcclManager::FindCommunicator(
+    const Collective* collective, int stripe) {
   if (collective->communicator_key.empty()) {
     // For single-node collectives, when the caller does not specify a
     // `communicator_key`, we identify a communicator uniquely by the set of
-    // devices participating in the collective.  For example, if a collective is
-    // for GPUs 0, 1, and 2 then this will scan to find the communicator for
-    // GPUs 0, 1, and 2.
+    // devices participating in the collective and the stripe.  For example, if
+    // a collective is for GPUs 0, 1, and 2 then this will scan to find the
+    // communicator for GPUs 0, 1, and 2, which is shared by all the collectives
+    // for these devices whatever their keys.
     //
     // Note that each executor identifies a context on one device, so this is
     // the same as getting the communicator connecting the devices in the
@@ -308,7 +422,8 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     // kernels to per-stream launch queues.  The launch queues are processed by
     // LoopKernelLaunches.
     for (auto& comm : communicators_) {
-      if (comm->num_devices == collective->num_global_devices) {
+      if (comm->num_devices == collective->num_global_devices &&
+          comm->stripe == stripe) {
         int i;
         for (i = 0; i < collective->num_local_devices; ++i) {
           if (comm->members[i].nccl_stream->executor !=
@@ -317,34 +432,30 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
           }
         }
         if (i == collective->num_local_devices) {
-          *communicator = comm.get();
-          return Status::OK();
+          return comm.get();
         }
       }
     }
-  } else {
-#if NCCL_MAJOR < 2
-    return errors::Internal(
-        "Cannot use multi-node NCCL collectives with NCCL 1.x");
-#endif
-    if (collective->communicator_key.size() != NCCL_UNIQUE_ID_BYTES) {
-      return errors::Internal("Expected communicator_key of size ",
-                              NCCL_UNIQUE_ID_BYTES, " but found size ",
-                              collective->communicator_key.size());
-    }
-    // This is an instance of multi-node collective.  We have previously
-    // created a NCCL unique id and shared with all workers.  Now we find the
-    // `Communicator` corresponding to this id.
-    for (auto& comm : communicators_) {
-      if (comm->key == collective->communicator_key) {
-        *communicator = comm.get();
-        return Status::OK();
-      }
+    return nullptr;
+  }
+  // This is an instance of multi-node collective.  We have previously
+  // created a NCCL unique id per stripe and shared them with all workers.  Now
+  // we find the `Communicator` corresponding to the id of this stripe.
+  const string key =
+      StripeCommunicatorKey(collective->communicator_key, stripe);
+  for (auto& comm : communicators_) {
+    if (comm->key == key) {
+      return comm.get();
     }
   }
+  return nullptr;
+}
 
+Status NcclManager::CreateCommunicator(
+    const Collective* collective, int stripe,
+    const std::set<NcclStream*>& used_streams, Communicator** communicator) {
   auto* env = Env::Default();
-  std::set<NcclStream*> used_streams;
+  std::set<NcclStream*> member_streams;
 
   // Create and initialize a new communicator.
   // Note that this is done under the lock; performance is not expected to
@@ -358,7 +469,7 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     auto& streams = device_to_comm_streams_[executor];
     NcclStream* nccl_stream = nullptr;
     for (const auto& s : streams) {
-      if (used_streams.insert(s).second) {
+      if (used_streams.count(s) == 0 && member_streams.insert(s).second) {
         nccl_stream = s;
         break;
       }
@@ -374,7 +485,7 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
 #endif
 
       streams.emplace_back(nccl_stream);
-      used_streams.insert(nccl_stream);
+      member_streams.insert(nccl_stream);
 
       nccl_stream->Ref();
       env->SchedClosure([this, nccl_stream]() {
@@ -387,6 +498,8 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     devices[i] = collective->participants[i]->gpu_device_id;
   }
 
+  const string key =
+      StripeCommunicatorKey(collective->communicator_key, stripe);
   std::vector<ncclComm_t> nccl_comms(collective->num_local_devices);
 #if NCCL_MAJOR >= 2
   // For NCCL 2, we always initialize using ncclCommInitRank guarded by NCCL
@@ -395,7 +508,7 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   if (collective->single_node) {
     NCCL_RETURN_IF_ERROR(ncclGetUniqueId(&nccl_id));
   } else {
-    StringToNcclUniqueId(collective->communicator_key, &nccl_id);
+    StringToNcclUniqueId(key, &nccl_id);
   }
   int saved_device = 0;
   CUDA_RETURN_IF_ERROR(cudaGetDevice(&saved_device));
@@ -424,11 +537,40 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     members[i].nccl_comm = nccl_comms[i];
   }
   communicators_.emplace_back(
-      new Communicator(std::move(members), collective->communicator_key));
+      new Communicator(std::move(members), key, stripe));
   *communicator = communicators_.back().get();
   return Status::OK();
 }
 
+void NcclManager::SetStripes(Collective* collective) const {
+#if TENSORFLOW_USE_ROCM
+  // On ROCm, all the communicators of a device share its nccl stream.
+  return;
+#endif
+  // An all-gather concatenates the inputs, so its stripes would interleave
+  // them.
+  if (collective->type == kAllGather) return;
+  const int max_stripes =
+      collective->communicator_key.empty()
+          ? num_stripes_
+          : collective->communicator_key.size() / NCCL_UNIQUE_ID_BYTES;
+  if (max_stripes <= 1) return;
+  // All the participants of a collective have tensors of the same size.
+  const Participant* p = collective->participants[0].get();
+  const int64_t num_elements =
+      p->output ? p->output->NumElements() : p->input->NumElements();
+  if (num_elements <= kStripeAlignment ||
+      num_elements * DataTypeSize(collective->data_type) < min_stripe_bytes_) {
+    return;
+  }
+  int64_t stripe_elements = (num_elements + max_stripes - 1) / max_stripes;
+  stripe_elements = (stripe_elements + kStripeAlignment - 1) /
+                    kStripeAlignment * kStripeAlignment;
+  collective->num_stripes =
+      (num_elements + stripe_elements - 1) / stripe_elements;
+  collective->stripe_elements = stripe_elements;
+}
+
 void NcclManager::AddToAllReduce(std::unique_ptr<Participant> participant,
                                  const Context& context,
                                  ncclRedOp_t reduction_op) {
@@ -615,24 +757,38 @@ void NcclManager::RunCollective(Collective* collective) {
   tensorflow::profiler::TraceMeProducer traceme("Schedule Collective");
   collective->trace_context = traceme.GetContextId();
 
-  static mutex collective_mu(LINKER_INITIALIZED);
-
   Status status = collective->status;
   if (status.ok()) {
-    status = GetCommunicator(collective, &collective->communicator);
+    SetStripes(collective);
+    status = GetCommunicators(collective, /*create=*/false);
   }
+  if (status.ok() &&
+      collective->communicators.size() < collective->num_stripes) {
+    Env::Default()->SchedClosure([this, collective]() {
+      EnqueueCollective(collective,
+                        GetCommunicators(collective, /*create=*/true));
+    });
+    return;
+  }
+  EnqueueCollective(collective, status);
+}
+
+void NcclManager::EnqueueCollective(Collective* collective, Status status) {
+  static mutex collective_mu(LINKER_INITIALIZED);
 
   for (int i = 0; status.ok() && i < collective->num_local_devices; ++i) {
     Participant* p = collective->participants[i].get();
-    NcclStream* nccl_stream = collective->communicator->members[i].nccl_stream;
-    CHECK(nccl_stream != nullptr);
     const int rank = p->global_rank >= 0 ? p->global_rank : i;
 
-    if (p->input != nullptr) {
-      // Wait to ensure that the kernel that produces the data in the input
-      // tensor has finished running before the nccl kernel runs on the
-      // communication stream.
-      nccl_stream->stream->ThenWaitFor(p->tensor_stream);
+    for (Communicator* communicator : collective->communicators) {
+      NcclStream* nccl_stream = communicator->members[i].nccl_stream;
+      CHECK(nccl_stream != nullptr);
+      if (p->input != nullptr) {
+        // Wait to ensure that the kernel that produces the data in the input
+        // tensor has finished running before the nccl kernel runs on the
+        // communication stream.
+        nccl_stream->stream->ThenWaitFor(p->tensor_stream);
+      }
     }
     if (p->root) {
       if (collective->root_rank == -1) {
@@ -644,7 +800,8 @@ void NcclManager::RunCollective(Collective* collective) {
       }
     }
     VLOG(2) << "RunCollective rank " << rank << " global_rank "
-            << p->global_rank << " root_rank " << collective->root_rank;
+            << p->global_rank << " root_rank " << collective->root_rank
+            << " num_stripes " << collective->num_stripes;
   }
 
   if (status.ok() && collective->type == kBroadcast &&
@@ -661,21 +818,31 @@ void NcclManager::RunCollective(Collective* collective) {
     return;
   }
 
+  {
+    mutex_lock l(collective->mu);
+    collective->num_pending_stripes.assign(collective->num_local_devices,
+                                           collective->num_stripes);
+    collective->participant_statuses.assign(collective->num_local_devices,
+                                            Status::OK());
+  }
+
   {
     // Allow only one collective at a time to queue kernels for launching. This
     // is to prevent collectives from deadlocking each other.
     // Note that it would be possible to run multiple collectives at once, if
     // they have non-intersecting sets of devices.
     mutex_lock l(collective_mu);
-    for (int i = 0; i < collective->num_local_devices; ++i) {
-      NcclStream* nccl_stream =
-          collective->communicator->members[i].nccl_stream;
-      mutex_lock l(nccl_stream->mu);
-      nccl_stream->pending_launches_.push_front(std::make_pair(collective, i));
-      // Ownership is shared between LoopKernelLaunches for each stream in this
-      // collective.
-      collective->Ref();
-      nccl_stream->cv.notify_all();
+    for (int stripe = 0; stripe < collective->num_stripes; ++stripe) {
+      for (int i = 0; i < collective->num_local_devices; ++i) {
+        NcclStream* nccl_stream =
+            collective->communicators[stripe]->members[i].nccl_stream;
+        mutex_lock l(nccl_stream->mu);
+        nccl_stream->pending_launches_.push_front({collective, i, stripe});
+        // Ownership is shared between LoopKernelLaunches for each stream in
+        // this collective.
+        collective->Ref();
+        nccl_stream->cv.notify_all();
+      }
     }
   }
   collective->Unref();
@@ -693,6 +860,17 @@ size_t ComputeBufferSize(const NcclManager::Participant* p,
   }
   return num_elements * DataTypeSize(data_type);
 }
+
+// Offsets `buffer` to the start of `stripe`.
+template <typename T>
+T* StripeBuffer(T* buffer, int stripe, int64_t stripe_elements,
+                DataType data_type) {
+  if (buffer == nullptr) return buffer;
+  using Byte = typename std::conditional<std::is_const<T>::value, const char,
+                                         char>::type;
+  return reinterpret_cast<Byte*>(buffer) +
+         stripe * stripe_elements * DataTypeSize(data_type);
+}
 }  // namespace
 
 void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
@@ -707,7 +885,7 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
 
   while (true) {
     // Find collective to run.
-    std::pair<Collective*, int> next_launch;
+    NcclStream::Launch next_launch;
     {
       VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
       mutex_lock l(nccl_stream->mu);
@@ -723,22 +901,36 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
     }
 
     // Launch the nccl kernel.
-    Collective* collective = next_launch.first;
+    Collective* collective = next_launch.collective;
     tensorflow::profiler::TraceMeConsumer traceme("Run Collective",
                                                   collective->trace_context);
 
     ncclDataType_t data_type = ToNcclType(collective->data_type);
-    int p_idx = next_launch.second;
+    int p_idx = next_launch.participant_idx;
+    const int stripe = next_launch.stripe;
     Participant* p = collective->participants[p_idx].get();
-    auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
+    auto nccl_comm =
+        collective->communicators[stripe]->members[p_idx].nccl_comm;
+    // The element count of this stripe, for the collectives that are striped.
+    auto stripe_count = [collective, stripe](int64_t num_elements) {
+      if (collective->num_stripes == 1) return num_elements;
+      return std::min(collective->stripe_elements,
+                      num_elements - stripe * collective->stripe_elements);
+    };
+    auto stripe_buffer = [collective, stripe](auto* buffer) {
+      return StripeBuffer(buffer, stripe, collective->stripe_elements,
+                          collective->data_type);
+    };
     ncclResult_t nccl_result = ncclSuccess;
     switch (collective->type) {
       case kAllReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff = const_cast<char*>(p->output->tensor_data().data());
+        const void* sendbuff = stripe_buffer(p->input->tensor_data().data());
+        void* recvbuff =
+            stripe_buffer(const_cast<char*>(p->output->tensor_data().data()));
 
         VLOG(2) << "call NcclAllReduce collective_key "
                 << collective->collective_key << " participant " << p_idx
+                << " stripe " << stripe
                 << " num_participants " << collective->participants.size()
                 << " sendbuff " << sendbuff << " recvbuff " << recvbuff
                 << " nccl_comm " << nccl_comm << " comm_stream " << comm_stream
@@ -749,9 +941,9 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
               {{"buffer_size", ComputeBufferSize(p, collective->data_type)},
                {"collective_type", "all_reduce"}});
         });
-        nccl_result = ncclAllReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                    data_type, collective->reduction_op,
-                                    nccl_comm, *cu_stream);
+        nccl_result = ncclAllReduce(
+            sendbuff, recvbuff, stripe_count(p->input->NumElements()),
+            data_type, collective->reduction_op, nccl_comm, *cu_stream);
         break;
       }
       case kBroadcast: {
@@ -770,11 +962,20 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
           recvbuff = const_cast<void*>(sendbuff);
         }
         if (num_elements < 0) {
-          p->done_callback(errors::Internal(
-              "Both input and output are null in ncclBroadcast"));
+          Status status;
+          if (collective->FinishStripe(
+                  p_idx,
+                  errors::Internal(
+                      "Both input and output are null in ncclBroadcast"),
+                  &status)) {
+            p->done_callback(status);
+          }
           collective->Unref();
           continue;
         }
+        sendbuff = stripe_buffer(sendbuff);
+        recvbuff = stripe_buffer(recvbuff);
+        num_elements = stripe_count(num_elements);
         VLOG(2) << "call NcclBroadcast collective_key "
                 << collective->collective_key << " participant " << p_idx
                 << " sendbuff " << sendbuff << " recvbuff " << recvbuff
@@ -792,19 +993,20 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         break;
       }
       case kReduce: {
-        const void* sendbuff = p->input->tensor_data().data();
-        void* recvbuff =
+        const void* sendbuff = stripe_buffer(p->input->tensor_data().data());
+        void* recvbuff = stripe_buffer(
             p->output ? const_cast<char*>(p->output->tensor_data().data())
-                      : nullptr;
+                      : nullptr);
         profiler::AnnotatedTraceMe traceme([&] {
           return profiler::TraceMeEncode(
               "buffer_size",
               {{"output_size", ComputeBufferSize(p, collective->data_type)},
                {"collective_type", "reduce"}});
         });
-        nccl_result = ncclReduce(sendbuff, recvbuff, p->input->NumElements(),
-                                 data_type, collective->reduction_op,
-                                 collective->root_rank, nccl_comm, *cu_stream);
+        nccl_result = ncclReduce(
+            sendbuff, recvbuff, stripe_count(p->input->NumElements()),
+            data_type, collective->reduction_op, collective->root_rank,
+            nccl_comm, *cu_stream);
         break;
       }
       case kAllGather: {
@@ -831,17 +1033,23 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
     }
 
     // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, p_idx, nccl_result]() {
+    // The participant is done once the kernels of all its stripes are.
+    auto done_callback = [collective, p_idx, stripe, nccl_result]() {
       VLOG(2) << "done Nccl kernel collective_key "
               << collective->collective_key << " participant " << p_idx
-              << " ncclResult " << nccl_result;
+              << " stripe " << stripe << " ncclResult " << nccl_result;
+      Status status;
       if (nccl_result == ncclSuccess) {
-        collective->participants[p_idx]->done_callback(Status::OK());
+        status = Status::OK();
       } else {
         // Propagate the error, but note that if other members of the collective
         // did launch their kernels, then they are hanging.
-        collective->participants[p_idx]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+        status = errors::Unknown("Error invoking NCCL: ",
+                                 ncclGetErrorString(nccl_result));
+      }
+      Status participant_status;
+      if (collective->FinishStripe(p_idx, status, &participant_status)) {
+        collective->participants[p_idx]->done_callback(participant_status);
       }
       collective->Unref();
     };
@@ -17,6 +17,7 @@ limitations under the License.
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <set>
 #include <vector>
 
 // TODO(rmlarsen): Get rid of this workaround. "gpu_assert" is defined when
@@ -44,12 +45,23 @@ namespace tensorflow {
 // NCCL manager is used to make the asynchronous communicator calls and to
 // manage the per-device streams used for communication.
 //
+// Large all-reduces, broadcasts and reduces can be striped: they are split
+// into contiguous stripes, each run on its own communicator and communication
+// stream, so that the stripes run concurrently and NCCL can spread them over
+// several NICs.
+//
 // See nccl_ops.cc for example usage, including description of memory
 // management and stream synchronization.
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
+  // Reads the number of stripes from TF_NCCL_NUM_STRIPES (1 by default, which
+  // disables striping) and the minimum size of striped collectives from
+  // TF_NCCL_MIN_STRIPE_BYTES (16MB by default).
   NcclManager();
+  // Splits the collectives of at least `min_stripe_bytes` into up to
+  // `num_stripes` stripes. Striping is not supported on ROCm.
+  NcclManager(int num_stripes, int64_t min_stripe_bytes);
   ~NcclManager();
 
   static NcclManager* instance();
@@ -58,9 +70,11 @@ class NcclManager {
   static int instance_count;
 #endif
 
-  // Calls `ncclGetUniqueId` and returns the id as a string.  The returned value
-  // may be shared with other participants on different nodes and passed in to
-  // multi-node collective invocations.
+  // Calls `ncclGetUniqueId` once per stripe and returns the concatenated ids
+  // as a string.  The returned value may be shared with other participants on
+  // different nodes and passed in to multi-node collective invocations, whose
+  // large collectives are then split into as many stripes as the key has ids.
+  // All the nodes must use the same minimum stripe size.
   string GenerateCommunicatorKey();
 
   // A participant in a Collective.
@@ -211,13 +225,32 @@ class NcclManager {
   struct CommunicatorMember;
   struct NcclStream;
 
-  // Gets the `Communicator` object that will be used to enqueue NCCL kernels
-  // for `collective`, and returns it via `communicator`.
+  // Gets the `Communicator` objects that will be used to enqueue NCCL kernels
+  // for the stripes of `collective`, and stores them in
+  // `collective->communicators`.  If `create` is false, only the existing
+  // communicators are looked up, and `collective->communicators` ends with the
+  // first missing one.
   //
   // This may involve creating CUDA streams and NCCL initialization.  If a NCCL
   // or CUDA error occurs in the process, this returns an INTERNAL error with
   // the corresponding NCCL/CUDA error string.
-  Status GetCommunicator(Collective* collective, Communicator** communicator);
+  Status GetCommunicators(Collective* collective, bool create);
+
+  // Returns the existing communicator for `stripe` of `collective`, or
+  // nullptr.
+  Communicator* FindCommunicator(const Collective* collective, int stripe)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Creates the communicator for `stripe` of `collective`, whose members use
+  // communication streams that are not in `used_streams`, if possible.
+  Status CreateCommunicator(const Collective* collective, int stripe,
+                            const std::set<NcclStream*>& used_streams,
+                            Communicator** communicator)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Sets the number of stripes of `collective` and their size, based on the
+  // size of its tensors.
+  void SetStripes(Collective* collective) const;
 
   // Adds a participant device to the local `Collective` instance corresponding
   // to `collective_key`.  Launches the `Collective` if it is ready, which it
@@ -238,9 +271,20 @@ class NcclManager {
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Run <collective>.  This calls takes ownership of <collective>.
+  //
+  // Creating a communicator waits in `ncclGroupEnd` for all of its members,
+  // which may be on other nodes, so when `collective` needs new communicators
+  // they are created, and the collective enqueued, on a background thread.
   void RunCollective(Collective* collective);
+  // Adds the kernels of <collective> to the launch queues of its streams, or
+  // calls the done callbacks with `status` if it is an error.  This call takes
+  // ownership of <collective>.
+  void EnqueueCollective(Collective* collective, Status status);
   void LoopKernelLaunches(NcclStream* stream);
 
+  const int num_stripes_;
+  const int64_t min_stripe_bytes_;
+
   mutex mu_;
 
   // Maps key to collectives currently being assembled or run.
@@ -494,6 +494,36 @@ TYPED_TEST(NcclManagerTest, BasicSumReduction) {
   }
 }
 
+// Same as the Basic test, but with the reduction split into uneven stripes.
+TYPED_TEST(NcclManagerTest, StripedSumReduction) {
+  const int num_ranks = this->NumGPUs();
+  NcclManager nccl_manager(/*num_stripes=*/3, /*min_stripe_bytes=*/0);
+
+  for (int step = 0; step < 2; ++step) {
+    std::unique_ptr<typename TestFixture::TestCase> test_case(
+        this->MakeReductionTestCase(/*num_nodes=*/1, num_ranks, ncclSum,
+                                    TensorShape({65, 33}), 0.0f));
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+      auto* info = device->tensorflow_gpu_device_info();
+      auto* stream = device->tensorflow_gpu_device_info()->stream;
+      auto participant = absl::make_unique<NcclManager::Participant>(
+          device->executor(), stream, info, &test_case->ins[rank],
+          &test_case->outs[rank], /*global_rank=*/-1,
+          this->CreateDoneCallback(test_case.get()));
+      nccl_manager.AddToAllReduce(
+          std::move(participant),
+          {"allreduce", /*num_local_devices=*/num_ranks,
+           /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+           /*source_rank=*/-1},
+          ncclSum);
+    }
+
+    LOG(INFO) << "Verifying results";
+    this->VerifyResults(test_case.get());
+  }
+}
+
 // Same as the Basic test, but with multiple threads launching parts of many
 // reductions.
 //
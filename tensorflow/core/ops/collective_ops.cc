@@ -122,6 +122,8 @@ REGISTER_OP("CollectiveReduceV2")
     .Attr("timeout_seconds: float = 0")
     .Attr("Nordering_token: int >= 0 = 0")
     .Attr("max_subdivs_per_device: int = -1")
+    .Attr("fusion_key: int = 0")
+    .Attr("fusion_group_size: int = 0")
     .SetIsStateful()
     .SetIsDistributedCommunication()
     .SetShapeFn(shape_inference::UnchangedShape);
@@ -219,4 +221,27 @@ REGISTER_OP("CollectiveAllToAllV3")
     .SetIsDistributedCommunication()
     .SetShapeFn(shape_inference::UnchangedShape);
 
+REGISTER_OP("CollectiveEmbeddingLookupV3")
+    .Input("params: T")
+    .Input("ids: Tindices")
+    .Input("communicator: resource")
+    .Input("group_assignment: int32")
+    .Output("output: T")
+    .Attr("T: {bfloat16, float, float16, float64, int32, int64}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("timeout_seconds: float = 0")
+    .SetIsStateful()
+    .SetIsDistributedCommunication()
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle params;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &params));
+      shape_inference::ShapeHandle params_subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(params, 1, &params_subshape));
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->Concatenate(c->input(1), params_subshape, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
 Status RaggedRangeShapeFn(InferenceContext* c);
+Status RaggedBatchMatMulShapeFn(InferenceContext* c);
 
 //==============================================================================
 // Registered Ops
@@ -38,6 +39,16 @@ REGISTER_OP("RaggedRange")
     .Attr("Tsplits: {int32, int64} = DT_INT64")
     .SetShapeFn(RaggedRangeShapeFn);
 
+REGISTER_OP("RaggedBatchMatMul")
+    .Input("a_values: T")
+    .Input("a_row_splits: Tsplits")
+    .Input("b: T")
+    .Output("output_values: T")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {bfloat16, half, float, double, complex64, complex128}")
+    .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .SetShapeFn(RaggedBatchMatMulShapeFn);
+
 //==============================================================================
 // Shape Functions
 //==============================================================================
@@ -78,4 +89,28 @@ Status RaggedRangeShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status RaggedBatchMatMulShapeFn(InferenceContext* c) {
+  // a_values: [N, J], a_row_splits: [B + 1], b: [B, J, K] (or [B, K, J] if
+  // transpose_b), output_values: [N, K].
+  ShapeHandle a_values;
+  ShapeHandle a_row_splits;
+  ShapeHandle b;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a_values));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &a_row_splits));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 3, &b));
+
+  bool transpose_b;
+  TF_RETURN_IF_ERROR(c->GetAttr("transpose_b", &transpose_b));
+  DimensionHandle inner_dim;
+  TF_RETURN_IF_ERROR(c->Merge(c->Dim(a_values, 1),
+                              c->Dim(b, transpose_b ? 2 : 1), &inner_dim));
+  DimensionHandle nrows_plus_one;
+  TF_RETURN_IF_ERROR(c->Add(c->Dim(b, 0), 1, &nrows_plus_one));
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(a_row_splits, 0), nrows_plus_one, &nrows_plus_one));
+  c->set_output(0, c->Matrix(c->Dim(a_values, 0),
+                             c->Dim(b, transpose_b ? 1 : 2)));
+  return Status::OK();
+}
+
 }  // namespace tensorflow
@@ -180,4 +180,23 @@ REGISTER_OP("StatelessRandomGammaV2")
     .Attr("Tseed: {int32, int64} = DT_INT64")
     .SetShapeFn(StatelessShape);
 
+REGISTER_OP("StatelessDropout")
+    .Input("x: T")
+    .Input("rate: T")
+    .Input("seed: Tseed")
+    .Output("output: T")
+    .Attr("T: {half, bfloat16, float, double}")
+    .Attr("Tseed: {int32, int64} = DT_INT64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      // Check seed shape
+      ShapeHandle seed;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &seed));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(seed, 0), 2, &unused_dim));
+      c->set_output(0, c->input(0));
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
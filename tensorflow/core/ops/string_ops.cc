@@ -57,6 +57,14 @@ REGISTER_OP("StaticRegexReplace")
     .Attr("replace_global: bool = true")
     .SetShapeFn(shape_inference::UnchangedShape);
 
+REGISTER_OP("StaticRegexReplaceSequence")
+    .Input("input: string")
+    .Attr("patterns: list(string) >= 0")
+    .Attr("rewrites: list(string) >= 0")
+    .Output("output: string")
+    .Attr("replace_global: bool = true")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
 REGISTER_OP("RegexFullMatch")
     .Input("input: string")
     .Input("pattern: string")
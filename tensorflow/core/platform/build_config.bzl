@@ -22,6 +22,7 @@ load(
     _tf_kernel_tests_linkstatic = "tf_kernel_tests_linkstatic",
     _tf_lib_proto_parsing_deps = "tf_lib_proto_parsing_deps",
     _tf_logging_deps = "tf_logging_deps",
+    _tf_lz4_deps = "tf_lz4_deps",
     _tf_platform_alias = "tf_platform_alias",
     _tf_platform_deps = "tf_platform_deps",
     _tf_portable_deps_no_runtime = "tf_portable_deps_no_runtime",
@@ -43,6 +44,7 @@ load(
     _tf_testing_deps = "tf_testing_deps",
     _tf_tpu_dependencies = "tf_tpu_dependencies",
     _tf_windows_aware_platform_deps = "tf_windows_aware_platform_deps",
+    _tf_zstd_deps = "tf_zstd_deps",
 )
 
 if_llvm_aarch64_available = _if_llvm_aarch64_available
@@ -65,6 +67,7 @@ tf_jspb_proto_library = _tf_jspb_proto_library
 tf_kernel_tests_linkstatic = _tf_kernel_tests_linkstatic
 tf_lib_proto_parsing_deps = _tf_lib_proto_parsing_deps
 tf_logging_deps = _tf_logging_deps
+tf_lz4_deps = _tf_lz4_deps
 tf_platform_alias = _tf_platform_alias
 tf_platform_deps = _tf_platform_deps
 tf_portable_proto_lib = _tf_portable_proto_lib
@@ -85,4 +88,5 @@ tf_resource_deps = _tf_resource_deps
 tf_stream_executor_deps = _tf_stream_executor_deps
 tf_testing_deps = _tf_testing_deps
 tf_windows_aware_platform_deps = _tf_windows_aware_platform_deps
+tf_zstd_deps = _tf_zstd_deps
 tf_tpu_dependencies = _tf_tpu_dependencies
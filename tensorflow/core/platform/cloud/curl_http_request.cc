@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
 
 #include <algorithm>
+#include <limits>
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -97,6 +98,8 @@ class LibCurlProxy : public LibCurl {
     return ::curl_easy_getinfo(curl, info, value);
   }
 
+  void curl_easy_reset(CURL* curl) override { ::curl_easy_reset(curl); }
+
   void curl_easy_cleanup(CURL* curl) override {
     return ::curl_easy_cleanup(curl);
   }
@@ -117,13 +120,61 @@ class LibCurlProxy : public LibCurl {
 };
 }  // namespace
 
+CurlHandlePool::CurlHandlePool(size_t max_idle_handles)
+    : CurlHandlePool(LibCurlProxy::Load(), max_idle_handles) {}
+
+CurlHandlePool::CurlHandlePool(LibCurl* libcurl, size_t max_idle_handles)
+    : libcurl_(libcurl), max_idle_handles_(max_idle_handles) {}
+
+CurlHandlePool::~CurlHandlePool() {
+  for (CURL* handle : idle_handles_) {
+    libcurl_->curl_easy_cleanup(handle);
+  }
+}
+
+CURL* CurlHandlePool::Acquire() {
+  {
+    mutex_lock l(mu_);
+    if (!idle_handles_.empty()) {
+      CURL* handle = idle_handles_.back();
+      idle_handles_.pop_back();
+      return handle;
+    }
+  }
+  return libcurl_->curl_easy_init();
+}
+
+void CurlHandlePool::Release(CURL* handle) {
+  // Clears the options, which may point to the buffers of the request that
+  // used the handle, but keeps the connections.
+  libcurl_->curl_easy_reset(handle);
+  {
+    mutex_lock l(mu_);
+    if (idle_handles_.size() < max_idle_handles_) {
+      idle_handles_.push_back(handle);
+      return;
+    }
+  }
+  libcurl_->curl_easy_cleanup(handle);
+}
+
 CurlHttpRequest::CurlHttpRequest() : CurlHttpRequest(LibCurlProxy::Load()) {}
 
-CurlHttpRequest::CurlHttpRequest(LibCurl* libcurl, Env* env)
-    : libcurl_(libcurl), env_(env) {
+CurlHttpRequest::CurlHttpRequest(const Options& options)
+    : CurlHttpRequest(LibCurlProxy::Load(), Env::Default(), options) {}
+
+CurlHttpRequest::CurlHttpRequest(LibCurl* libcurl, Env* env,
+                                 const Options& options)
+    : libcurl_(libcurl), env_(env), handle_pool_(options.handle_pool) {
   default_response_buffer_.reserve(CURL_MAX_WRITE_SIZE);
 
-  curl_ = libcurl_->curl_easy_init();
+  if (handle_pool_) {
+    CHECK_EQ(handle_pool_->libcurl(), libcurl_)
+        << "The curl handle pool uses a different libcurl.";
+    curl_ = handle_pool_->Acquire();
+  } else {
+    curl_ = libcurl_->curl_easy_init();
+  }
   CHECK(curl_ != nullptr) << "Couldn't initialize a curl session.";
 
   // NOTE: The cURL CA bundle path is, by default, set to
@@ -144,9 +195,21 @@ CurlHttpRequest::CurlHttpRequest(LibCurl* libcurl, Env* env)
   // Do not use signals for timeouts - does not work in multi-threaded programs.
   CHECK_CURL_OK(libcurl_->curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L));
 
-  // TODO(b/74351157): Enable HTTP/2.
-  CHECK_CURL_OK(libcurl_->curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION,
-                                           CURL_HTTP_VERSION_1_1));
+  // HTTPS requests negotiate HTTP/2 with the server if requested. Setting the
+  // version fails if libcurl is built without HTTP/2 support.
+  bool http2 = false;
+  if (options.http2) {
+    http2 = libcurl_->curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION,
+                                       CURL_HTTP_VERSION_2TLS) == CURLE_OK;
+    if (!http2) {
+      LOG_FIRST_N(WARNING, 1)
+          << "libcurl does not support HTTP/2, using HTTP/1.1 instead.";
+    }
+  }
+  if (!http2) {
+    CHECK_CURL_OK(libcurl_->curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION,
+                                             CURL_HTTP_VERSION_1_1));
+  }
 
   // Set up the progress meter.
   CHECK_CURL_OK(
@@ -173,7 +236,11 @@ CurlHttpRequest::~CurlHttpRequest() {
     }
   }
   if (curl_) {
-    libcurl_->curl_easy_cleanup(curl_);
+    if (handle_pool_) {
+      handle_pool_->Release(curl_);
+    } else {
+      libcurl_->curl_easy_cleanup(curl_);
+    }
   }
 }
 
@@ -236,6 +303,12 @@ void CurlHttpRequest::SetDeleteRequest() {
 
 Status CurlHttpRequest::SetPutFromFile(const string& body_filepath,
                                        size_t offset) {
+  return SetPutFromFileRange(body_filepath, offset,
+                             std::numeric_limits<size_t>::max());
+}
+
+Status CurlHttpRequest::SetPutFromFileRange(const string& body_filepath,
+                                            size_t offset, size_t length) {
   CheckNotSent();
   CheckMethodNotSet();
   is_method_set_ = true;
@@ -251,16 +324,19 @@ Status CurlHttpRequest::SetPutFromFile(const string& body_filepath,
                                    body_filepath);
   }
   fseek(put_body_, 0, SEEK_END);
-  const auto size = ftell(put_body_) - offset;
+  const size_t file_size = ftell(put_body_);
   fseek(put_body_, offset, SEEK_SET);
+  put_body_remaining_ =
+      offset < file_size ? std::min(length, file_size - offset) : 0;
 
   curl_headers_ = libcurl_->curl_slist_append(
-      curl_headers_, strings::StrCat("Content-Length: ", size).c_str());
+      curl_headers_,
+      strings::StrCat("Content-Length: ", put_body_remaining_).c_str());
   CHECK_CURL_OK(libcurl_->curl_easy_setopt(curl_, CURLOPT_PUT, 1));
   CHECK_CURL_OK(libcurl_->curl_easy_setopt(curl_, CURLOPT_READDATA,
-                                           reinterpret_cast<void*>(put_body_)));
-  // Using the default CURLOPT_READFUNCTION, which is doing an fread() on the
-  // FILE * userdata set with CURLOPT_READDATA.
+                                           reinterpret_cast<void*>(this)));
+  CHECK_CURL_OK(libcurl_->curl_easy_setopt(
+      curl_, CURLOPT_READFUNCTION, &CurlHttpRequest::ReadFileCallback));
   return Status::OK();
 }
 
@@ -397,6 +473,17 @@ size_t CurlHttpRequest::ReadCallback(void* ptr, size_t size, size_t nmemb,
   return bytes_to_copy;
 }
 
+size_t CurlHttpRequest::ReadFileCallback(void* ptr, size_t size, size_t nmemb,
+                                         FILE* this_object) {
+  CHECK(ptr);
+  auto that = reinterpret_cast<CurlHttpRequest*>(this_object);
+  const size_t bytes_read =
+      fread(ptr, 1, std::min(size * nmemb, that->put_body_remaining_),
+            that->put_body_);
+  that->put_body_remaining_ -= bytes_read;
+  return bytes_read;
+}
+
 size_t CurlHttpRequest::HeaderCallback(const void* ptr, size_t size,
                                        size_t nmemb, void* this_object) {
   CHECK(ptr);
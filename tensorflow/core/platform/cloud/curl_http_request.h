@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_CURL_HTTP_REQUEST_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_CURL_HTTP_REQUEST_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
@@ -34,6 +36,40 @@ namespace tensorflow {
 
 class LibCurl;  // libcurl interface as a class, for dependency injection.
 
+/// \brief A pool of idle curl handles, shared by the requests that use it.
+///
+/// A curl handle keeps its connections, TLS sessions and DNS lookups after a
+/// transfer. Requests that take their handle from a pool reuse the open
+/// connections of the previous requests instead of each setting up a new one.
+///
+/// This class is thread-safe.
+class CurlHandlePool {
+ public:
+  /// Keeps up to `max_idle_handles` idle handles of the real libcurl.
+  explicit CurlHandlePool(size_t max_idle_handles);
+  CurlHandlePool(LibCurl* libcurl, size_t max_idle_handles);
+  ~CurlHandlePool();
+
+  /// Returns an idle handle with the default options, or a new one.
+  CURL* Acquire();
+
+  /// \brief Returns a handle taken with Acquire() to the pool.
+  ///
+  /// The handle is reset to the default options, keeping its connections, or
+  /// cleaned up if the pool already has `max_idle_handles` idle handles.
+  void Release(CURL* handle);
+
+  LibCurl* libcurl() const { return libcurl_; }
+
+ private:
+  LibCurl* const libcurl_;
+  const size_t max_idle_handles_;
+  mutex mu_;
+  std::vector<CURL*> idle_handles_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CurlHandlePool);
+};
+
 /// \brief A basic HTTP client based on the libcurl library.
 ///
 /// The usage pattern for the class reflects the one of the libcurl library:
@@ -46,16 +82,37 @@ class LibCurl;  // libcurl interface as a class, for dependency injection.
 ///   request->Send();
 class CurlHttpRequest : public HttpRequest {
  public:
+  /// Transport options of a request.
+  struct Options {
+    // If set, the request takes its curl handle from this pool and returns it
+    // when destroyed, reusing the connections of the previous requests. The
+    // pool must use the same LibCurl as the request.
+    std::shared_ptr<CurlHandlePool> handle_pool;
+
+    // Whether to negotiate HTTP/2 for HTTPS requests. Falls back to HTTP/1.1
+    // if libcurl is built without HTTP/2 support or the server does not
+    // support it.
+    bool http2 = false;
+  };
+
   class Factory : public HttpRequest::Factory {
    public:
+    Factory() {}
+    explicit Factory(const Options& options) : options_(options) {}
     virtual ~Factory() {}
-    virtual HttpRequest* Create() { return new CurlHttpRequest(); }
+    virtual HttpRequest* Create() { return new CurlHttpRequest(options_); }
+
+   private:
+    Options options_;
   };
 
   CurlHttpRequest();
+  explicit CurlHttpRequest(const Options& options);
   explicit CurlHttpRequest(LibCurl* libcurl)
       : CurlHttpRequest(libcurl, Env::Default()) {}
-  CurlHttpRequest(LibCurl* libcurl, Env* env);
+  CurlHttpRequest(LibCurl* libcurl, Env* env)
+      : CurlHttpRequest(libcurl, env, Options()) {}
+  CurlHttpRequest(LibCurl* libcurl, Env* env, const Options& options);
   ~CurlHttpRequest() override;
 
   /// Sets the request URI.
@@ -87,6 +144,9 @@ class CurlHttpRequest : public HttpRequest {
   /// the given offset.
   Status SetPutFromFile(const string& body_filepath, size_t offset) override;
 
+  Status SetPutFromFileRange(const string& body_filepath, size_t offset,
+                             size_t length) override;
+
   /// Makes the request a PUT request with an empty body.
   void SetPutEmptyBody() override;
 
@@ -157,6 +217,9 @@ class CurlHttpRequest : public HttpRequest {
   /// A read callback in the form which can be accepted by libcurl.
   static size_t ReadCallback(void* ptr, size_t size, size_t nmemb,
                              FILE* userdata);
+  /// A read callback for the PUT body set with SetPutFromFileRange().
+  static size_t ReadFileCallback(void* ptr, size_t size, size_t nmemb,
+                                 FILE* this_object);
   /// A header callback in the form which can be accepted by libcurl.
   static size_t HeaderCallback(const void* ptr, size_t size, size_t nmemb,
                                void* this_object);
@@ -174,8 +237,11 @@ class CurlHttpRequest : public HttpRequest {
 
   LibCurl* libcurl_;
   Env* env_;
+  std::shared_ptr<CurlHandlePool> handle_pool_;
 
   FILE* put_body_ = nullptr;
+  // The number of bytes of put_body_ left to send.
+  size_t put_body_remaining_ = 0;
 
   StringPiece post_body_buffer_;
   size_t post_body_read_ = 0;
@@ -262,6 +328,7 @@ class LibCurl {
                                      uint64* value) TF_MUST_USE_RESULT = 0;
   virtual CURLcode curl_easy_getinfo(CURL* curl, CURLINFO info,
                                      double* value) TF_MUST_USE_RESULT = 0;
+  virtual void curl_easy_reset(CURL* curl) = 0;
   virtual void curl_easy_cleanup(CURL* curl) = 0;
   virtual curl_slist* curl_slist_append(curl_slist* list, const char* str) = 0;
   virtual void curl_slist_free_all(curl_slist* list) = 0;
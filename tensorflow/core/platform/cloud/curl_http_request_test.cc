@@ -55,6 +55,7 @@ class FakeLibCurl : public LibCurl {
         response_headers_(response_headers) {}
   CURL* curl_easy_init() override {
     is_initialized_ = true;
+    ++num_initialized_;
     // The reuslt just needs to be non-null.
     return reinterpret_cast<CURL*>(this);
   }
@@ -67,6 +68,12 @@ class FakeLibCurl : public LibCurl {
       case CURLOPT_PUT:
         is_put_ = param;
         break;
+      case CURLOPT_HTTP_VERSION:
+        if (param == CURL_HTTP_VERSION_2TLS && !http2_supported_) {
+          return CURLE_UNSUPPORTED_PROTOCOL;
+        }
+        http_version_ = param;
+        break;
       default:
         break;
     }
@@ -199,6 +206,7 @@ class FakeLibCurl : public LibCurl {
     }
     return CURLE_OK;
   }
+  void curl_easy_reset(CURL* curl) override { ++num_reset_; }
   void curl_easy_cleanup(CURL* curl) override { is_cleaned_up_ = true; }
   curl_slist* curl_slist_append(curl_slist* list, const char* str) override {
     std::vector<string>* v = list ? reinterpret_cast<std::vector<string>*>(list)
@@ -233,6 +241,7 @@ class FakeLibCurl : public LibCurl {
   string response_content_;
   uint64 response_code_;
   std::vector<string> response_headers_;
+  bool http2_supported_ = true;
 
   // Internal variables to store the libcurl state.
   string url_;
@@ -242,6 +251,9 @@ class FakeLibCurl : public LibCurl {
   char* error_buffer_ = nullptr;
   bool is_initialized_ = false;
   bool is_cleaned_up_ = false;
+  int num_initialized_ = 0;
+  int num_reset_ = 0;
+  uint64 http_version_ = 0;
   std::vector<string>* headers_ = nullptr;
   bool is_post_ = false;
   bool is_put_ = false;
@@ -583,6 +595,48 @@ TEST(CurlHttpRequestTest, PutRequest_WithBody_FromFile_NonZeroOffset) {
   std::remove(content_filename.c_str());
 }
 
+TEST(CurlHttpRequestTest, PutRequest_WithBody_FromFileRange) {
+  FakeLibCurl libcurl("", 200);
+  CurlHttpRequest http_request(&libcurl);
+
+  auto content_filename = io::JoinPath(testing::TmpDir(), "content");
+  std::ofstream content(content_filename, std::ofstream::binary);
+  content << "post body content";
+  content.close();
+
+  http_request.SetUri("http://www.testuri.com");
+  TF_EXPECT_OK(http_request.SetPutFromFileRange(content_filename, 5, 4));
+  TF_EXPECT_OK(http_request.Send());
+
+  // Check interactions with libcurl.
+  EXPECT_EQ(1, libcurl.headers_->size());
+  EXPECT_EQ("Content-Length: 4", (*libcurl.headers_)[0]);
+  EXPECT_TRUE(libcurl.is_put_);
+  EXPECT_EQ("body", libcurl.posted_content_);
+
+  std::remove(content_filename.c_str());
+}
+
+TEST(CurlHttpRequestTest, PutRequest_WithBody_FromFileRange_PastEof) {
+  FakeLibCurl libcurl("", 200);
+  CurlHttpRequest http_request(&libcurl);
+
+  auto content_filename = io::JoinPath(testing::TmpDir(), "content");
+  std::ofstream content(content_filename, std::ofstream::binary);
+  content << "post body content";
+  content.close();
+
+  http_request.SetUri("http://www.testuri.com");
+  TF_EXPECT_OK(http_request.SetPutFromFileRange(content_filename, 10, 100));
+  TF_EXPECT_OK(http_request.Send());
+
+  // Check interactions with libcurl.
+  EXPECT_EQ("Content-Length: 7", (*libcurl.headers_)[0]);
+  EXPECT_EQ("content", libcurl.posted_content_);
+
+  std::remove(content_filename.c_str());
+}
+
 TEST(CurlHttpRequestTest, PutRequest_WithoutBody) {
   FakeLibCurl libcurl("", 200);
   CurlHttpRequest http_request(&libcurl);
@@ -958,5 +1012,68 @@ TEST(CurlHttpRequestTest, StatsPut) {
   TF_EXPECT_OK(stats.record_response_result_);
 }
 
+TEST(CurlHttpRequestTest, Http11ByDefault) {
+  FakeLibCurl libcurl("", 200);
+  CurlHttpRequest http_request(&libcurl);
+
+  EXPECT_EQ(CURL_HTTP_VERSION_1_1, libcurl.http_version_);
+}
+
+TEST(CurlHttpRequestTest, Http2) {
+  FakeLibCurl libcurl("", 200);
+  CurlHttpRequest::Options options;
+  options.http2 = true;
+  CurlHttpRequest http_request(&libcurl, Env::Default(), options);
+
+  EXPECT_EQ(CURL_HTTP_VERSION_2TLS, libcurl.http_version_);
+}
+
+TEST(CurlHttpRequestTest, Http2_FallsBackToHttp11) {
+  FakeLibCurl libcurl("", 200);
+  libcurl.http2_supported_ = false;
+  CurlHttpRequest::Options options;
+  options.http2 = true;
+  CurlHttpRequest http_request(&libcurl, Env::Default(), options);
+
+  EXPECT_EQ(CURL_HTTP_VERSION_1_1, libcurl.http_version_);
+}
+
+TEST(CurlHttpRequestTest, HandlePool_ReusesHandles) {
+  FakeLibCurl libcurl("get response", 200);
+  CurlHttpRequest::Options options;
+  options.handle_pool = std::make_shared<CurlHandlePool>(&libcurl, 1);
+
+  for (int i = 0; i < 3; ++i) {
+    CurlHttpRequest http_request(&libcurl, Env::Default(), options);
+    http_request.SetUri("http://www.testuri.com");
+    TF_EXPECT_OK(http_request.Send());
+  }
+
+  // The requests take turns using the same handle, which is reset after each
+  // of them.
+  EXPECT_EQ(1, libcurl.num_initialized_);
+  EXPECT_EQ(3, libcurl.num_reset_);
+  EXPECT_FALSE(libcurl.is_cleaned_up_);
+
+  options.handle_pool.reset();
+  EXPECT_TRUE(libcurl.is_cleaned_up_);
+}
+
+TEST(CurlHttpRequestTest, HandlePool_CleansUpHandlesOverCapacity) {
+  FakeLibCurl libcurl("get response", 200);
+  CurlHttpRequest::Options options;
+  options.handle_pool = std::make_shared<CurlHandlePool>(&libcurl, 1);
+
+  {
+    CurlHttpRequest first_request(&libcurl, Env::Default(), options);
+    CurlHttpRequest second_request(&libcurl, Env::Default(), options);
+    EXPECT_EQ(2, libcurl.num_initialized_);
+  }
+
+  // Only one of the two handles is kept.
+  EXPECT_TRUE(libcurl.is_cleaned_up_);
+  EXPECT_EQ(2, libcurl.num_reset_);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -56,6 +56,11 @@ class FileBlockCacheStatsInterface {
   /// RecordBlockLoadRequest is called to record the size of a missed block.
   virtual void RecordCacheMissBlockSize(size_t bytes_transferred) = 0;
 
+  /// RecordCachePrefetchBlockSize is called to record the size of a block
+  /// fetched ahead of the reads of a sequential scan.  Reads of prefetched
+  /// blocks are recorded as hits.
+  virtual void RecordCachePrefetchBlockSize(size_t bytes_transferred) {}
+
   virtual ~FileBlockCacheStatsInterface() = default;
 };
 
@@ -94,6 +99,15 @@ class FileBlockCache {
   virtual Status Read(const string& filename, size_t offset, size_t n,
                       char* buffer, size_t* bytes_transferred) = 0;
 
+  /// Read as Read() does and, if the reads of `filename` through this method
+  /// are sequential, prefetch the blocks that follow in the background. Caches
+  /// that do not read ahead simply Read().
+  virtual Status ReadWithReadAhead(const string& filename, size_t offset,
+                                   size_t n, char* buffer,
+                                   size_t* bytes_transferred) {
+    return Read(filename, offset, n, buffer, bytes_transferred);
+  }
+
   // Validate the given file signature with the existing file signature in the
   // cache. Returns true if the signature doesn't change or the file did not
   // exist before. If the signature changes, update the existing signature with
@@ -43,6 +43,10 @@ class TestHttpRequest : public HttpRequest {
   Status SetPutFromFile(const string& body_filepath, size_t offset) override {
     return Status::OK();
   }
+  Status SetPutFromFileRange(const string& body_filepath, size_t offset,
+                             size_t length) override {
+    return Status::OK();
+  }
   void SetPutEmptyBody() override {}
   void SetPostFromBuffer(const char* buffer, size_t size) override {}
   void SetPostEmptyBody() override {}
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/time_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/path.h"
@@ -48,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 #ifdef _WIN32
@@ -66,6 +68,10 @@ constexpr char kStorageHost[] = "storage.googleapis.com";
 constexpr char kBucketMetadataLocationKey[] = "location";
 constexpr size_t kReadAppendableFileBufferSize = 1024 * 1024;  // In bytes.
 constexpr int kGetChildrenDefaultPageSize = 1000;
+// Requests of a ReadBatch() that are at most this many bytes apart are served
+// by one HTTP request, up to kReadBatchMaxReadBytes.
+constexpr uint64 kReadBatchMaxGapBytes = 256 * 1024;
+constexpr uint64 kReadBatchMaxReadBytes = 64 * 1024 * 1024;
 // The HTTP response code "308 Resume Incomplete".
 constexpr uint64 HTTP_CODE_RESUME_INCOMPLETE = 308;
 // The HTTP response code "412 Precondition Failed".
@@ -145,6 +151,29 @@ constexpr char kAppendMode[] = "GCS_APPEND_MODE";
 // objects.
 constexpr char kComposeAppend[] = "compose";
 
+// The environment variable that overrides the number of idle HTTP connections
+// kept open for later requests. A value of 0 means every request opens a new
+// connection.
+constexpr char kHttpConnectionPoolSize[] = "GCS_HTTP_CONNECTION_POOL_SIZE";
+constexpr size_t kHttpConnectionPoolDefaultSize = 32;
+// The environment variable that enables HTTP/2 (format: true/false), if
+// libcurl supports it.
+constexpr char kHttp2[] = "GCS_HTTP2";
+// The environment variable that sets the size (in MB) from which files are
+// uploaded with parallel composite uploads. These are disabled by default, as
+// composite objects have no MD5 hash and the temporary objects may be stranded
+// if the upload fails.
+constexpr char kParallelCompositeUploadThreshold[] =
+    "GCS_PARALLEL_COMPOSITE_UPLOAD_THRESHOLD_MB";
+// The environment variable that overrides the size (in MB) of the temporary
+// objects of parallel composite uploads.
+constexpr char kParallelCompositeUploadComponentSize[] =
+    "GCS_PARALLEL_COMPOSITE_UPLOAD_COMPONENT_SIZE_MB";
+// The environment variable that overrides the number of temporary objects
+// uploaded at once by parallel composite uploads.
+constexpr char kParallelCompositeUploadThreads[] =
+    "GCS_PARALLEL_COMPOSITE_UPLOAD_THREADS";
+
 Status GetTmpFilename(string* filename) {
   *filename = io::GetTempFilename("");
   return Status::OK();
@@ -282,6 +311,13 @@ class GcsRandomAccessFile : public RandomAccessFile {
     return read_fn_(filename_, offset, n, result, scratch);
   }
 
+  /// Coalesces nearby requests and issues the merged reads concurrently,
+  /// since every read that misses the block cache is an HTTP request.
+  Status ReadBatch(std::vector<ReadRequest>* requests) const override {
+    return internal::CoalescedReadBatch(*this, kReadBatchMaxGapBytes,
+                                        kReadBatchMaxReadBytes, requests);
+  }
+
  private:
   /// The filename of this file.
   const string filename_;
@@ -422,6 +458,7 @@ class GcsWritableFile : public WritableFile {
                   GcsFileSystem::TimeoutConfig* timeouts,
                   std::function<void()> file_cache_erase,
                   RetryConfig retry_config, bool compose_append,
+                  GcsFileSystem::ParallelCompositeUploadConfig parallel_upload,
                   SessionCreator session_creator,
                   ObjectUploader object_uploader, StatusPoller status_poller,
                   GenerationGetter generation_getter)
@@ -433,6 +470,7 @@ class GcsWritableFile : public WritableFile {
         sync_needed_(true),
         retry_config_(retry_config),
         compose_append_(compose_append),
+        parallel_upload_(parallel_upload),
         start_offset_(0),
         session_creator_(std::move(session_creator)),
         object_uploader_(std::move(object_uploader)),
@@ -456,6 +494,7 @@ class GcsWritableFile : public WritableFile {
                   GcsFileSystem::TimeoutConfig* timeouts,
                   std::function<void()> file_cache_erase,
                   RetryConfig retry_config, bool compose_append,
+                  GcsFileSystem::ParallelCompositeUploadConfig parallel_upload,
                   SessionCreator session_creator,
                   ObjectUploader object_uploader, StatusPoller status_poller,
                   GenerationGetter generation_getter)
@@ -467,6 +506,7 @@ class GcsWritableFile : public WritableFile {
         sync_needed_(true),
         retry_config_(retry_config),
         compose_append_(compose_append),
+        parallel_upload_(parallel_upload),
         start_offset_(0),
         session_creator_(std::move(session_creator)),
         object_uploader_(std::move(object_uploader)),
@@ -542,17 +582,17 @@ class GcsWritableFile : public WritableFile {
  private:
   /// Copies the current version of the file to GCS.
   ///
-  /// This SyncImpl() uploads the object to GCS.
-  /// In case of a failure, it resumes failed uploads as recommended by the GCS
-  /// resumable API documentation. When the whole upload needs to be
-  /// restarted, Sync() returns UNAVAILABLE and relies on RetryingFileSystem.
+  /// This SyncImpl() uploads the object to GCS, or a part of it to compose
+  /// with the object in compose append mode, or large files as several parts
+  /// at once to compose into the object.
   Status SyncImpl() {
     outfile_.flush();
     if (!outfile_.good()) {
       return errors::Internal(
           "Could not write to the internal temporary file.");
     }
-    UploadSessionHandle session_handle;
+    uint64 file_size;
+    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
     uint64 start_offset = 0;
     string object_to_upload = object_;
     bool should_compose = false;
@@ -562,21 +602,46 @@ class GcsWritableFile : public WritableFile {
       should_compose = start_offset > 0;
       if (should_compose) {
         object_to_upload =
-            strings::StrCat(io::Dirname(object_), "/.tmpcompose/",
-                            io::Basename(object_), ".", start_offset_);
+            GetTmpComposeObject(strings::StrCat(".", start_offset_));
       }
     }
-    TF_RETURN_IF_ERROR(CreateNewUploadSession(start_offset, object_to_upload,
-                                              &session_handle));
+    Status upload_status;
+    if (!should_compose && parallel_upload_.threshold_bytes > 0 &&
+        file_size >= parallel_upload_.threshold_bytes) {
+      upload_status = ParallelCompositeUpload(file_size);
+    } else {
+      upload_status = UploadObject(object_to_upload, start_offset, file_size);
+    }
+    if (upload_status.ok()) {
+      if (should_compose) {
+        TF_RETURN_IF_ERROR(AppendObject(object_to_upload));
+      }
+      TF_RETURN_IF_ERROR(GetCurrentFileSize(&start_offset_));
+    }
+    return upload_status;
+  }
+
+  /// \brief Uploads the bytes [start_offset, end_offset) of the temporary file
+  /// to `object_to_upload`.
+  ///
+  /// In case of a failure, it resumes failed uploads as recommended by the GCS
+  /// resumable API documentation. When the whole upload needs to be
+  /// restarted, returns UNAVAILABLE and relies on RetryingFileSystem.
+  Status UploadObject(const string& object_to_upload, uint64 start_offset,
+                      uint64 end_offset) {
+    UploadSessionHandle session_handle;
+    TF_RETURN_IF_ERROR(CreateNewUploadSession(
+        start_offset, end_offset, object_to_upload, &session_handle));
     uint64 already_uploaded = 0;
     bool first_attempt = true;
     const Status upload_status = RetryingUtils::CallWithRetries(
-        [&first_attempt, &already_uploaded, &session_handle, &start_offset,
-         this]() {
+        [&first_attempt, &already_uploaded, &session_handle, start_offset,
+         end_offset, this]() {
           if (session_handle.resumable && !first_attempt) {
             bool completed;
             TF_RETURN_IF_ERROR(RequestUploadSessionStatus(
-                session_handle.session_uri, &completed, &already_uploaded));
+                session_handle.session_uri, end_offset - start_offset,
+                &completed, &already_uploaded));
             LOG(INFO) << "### RequestUploadSessionStatus: completed = "
                       << completed
                       << ", already_uploaded = " << already_uploaded
@@ -592,7 +657,7 @@ class GcsWritableFile : public WritableFile {
           }
           first_attempt = false;
           return UploadToSession(session_handle.session_uri, start_offset,
-                                 already_uploaded);
+                                 already_uploaded, end_offset);
         },
         retry_config_);
     if (upload_status.code() == errors::Code::NOT_FOUND) {
@@ -602,13 +667,110 @@ class GcsWritableFile : public WritableFile {
           "Upload to gs://", bucket_, "/", object_,
           " failed, caused by: ", upload_status.error_message()));
     }
-    if (upload_status.ok()) {
-      if (should_compose) {
-        TF_RETURN_IF_ERROR(AppendObject(object_to_upload));
+    return upload_status;
+  }
+
+  /// \brief Uploads the temporary file as several temporary objects at once,
+  /// then composes them into the object and deletes them.
+  ///
+  /// The file is split into parts of about the configured component size, or
+  /// into kMaxComposeComponents larger parts if it has more.
+  Status ParallelCompositeUpload(uint64 file_size) {
+    const uint64 component_size =
+        std::max<uint64>(parallel_upload_.component_size_bytes, 1);
+    const uint64 num_components = std::min<uint64>(
+        (file_size + component_size - 1) / component_size,
+        GcsFileSystem::ParallelCompositeUploadConfig::kMaxComposeComponents);
+    const uint64 component_length =
+        (file_size + num_components - 1) / num_components;
+    std::vector<string> components;
+    std::vector<uint64> component_offsets;
+    for (uint64 offset = 0; offset < file_size; offset += component_length) {
+      components.push_back(
+          GetTmpComposeObject(strings::StrCat(".part", components.size())));
+      component_offsets.push_back(offset);
+    }
+    component_offsets.push_back(file_size);
+    VLOG(3) << "ParallelCompositeUpload: " << GetGcsPath() << " as "
+            << components.size() << " objects";
+
+    std::vector<Status> statuses(components.size());
+    auto upload_component = [&components, &component_offsets, &statuses,
+                             this](size_t i) {
+      statuses[i] = UploadObject(components[i], component_offsets[i],
+                                 component_offsets[i + 1]);
+    };
+    if (parallel_upload_.threads > 1 && components.size() > 1) {
+      thread::ThreadPool pool(
+          Env::Default(), "gcs_parallel_upload",
+          std::min<int>(parallel_upload_.threads, components.size()));
+      for (size_t i = 0; i < components.size(); ++i) {
+        pool.Schedule([&upload_component, i]() { upload_component(i); });
+      }
+    } else {
+      for (size_t i = 0; i < components.size(); ++i) {
+        upload_component(i);
       }
-      TF_RETURN_IF_ERROR(GetCurrentFileSize(&start_offset_));
     }
-    return upload_status;
+
+    Status status;
+    for (const Status& component_status : statuses) {
+      status.Update(component_status);
+    }
+    if (status.ok()) {
+      status = ComposeObjects(components);
+    }
+    // Deletes the uploaded temporary objects whether or not the upload
+    // succeeded, to not leave them behind.
+    for (size_t i = 0; i < components.size(); ++i) {
+      if (!statuses[i].ok()) continue;
+      const string component_path = GetGcsPathWithObject(components[i]);
+      Status delete_status = RetryingUtils::DeleteWithRetries(
+          [&component_path, this]() {
+            return filesystem_->DeleteFile(component_path, nullptr);
+          },
+          retry_config_);
+      if (!delete_status.ok()) {
+        LOG(WARNING) << "Could not delete the temporary object "
+                     << component_path << ": " << delete_status;
+      }
+      status.Update(delete_status);
+    }
+    return status;
+  }
+
+  /// Replaces the object with the concatenation of `source_objects`.
+  Status ComposeObjects(const std::vector<string>& source_objects) {
+    VLOG(3) << "ComposeObjects: " << source_objects.size() << " objects to "
+            << GetGcsPath();
+    string source_objects_list;
+    for (const string& source_object : source_objects) {
+      strings::StrAppend(&source_objects_list,
+                         source_objects_list.empty() ? "" : ",", "{'name': '",
+                         source_object, "'}");
+    }
+    const string request_body =
+        strings::StrCat("{'sourceObjects': [", source_objects_list, "]}");
+    TF_RETURN_IF_ERROR(RetryingUtils::CallWithRetries(
+        [&request_body, this]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+
+          request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                          request->EscapeString(object_),
+                                          "/compose"));
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->metadata);
+          request->AddHeader("content-type", "application/json");
+          request->SetPostFromBuffer(request_body.c_str(), request_body.size());
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(),
+                                          " when composing to ", GetGcsPath());
+          return Status::OK();
+        },
+        retry_config_));
+    // Erase the file from the file cache on every successful write.
+    file_cache_erase_();
+    return Status::OK();
   }
 
   Status CheckWritable() const {
@@ -629,14 +791,19 @@ class GcsWritableFile : public WritableFile {
     return Status::OK();
   }
 
-  /// Initiates a new resumable upload session.
-  Status CreateNewUploadSession(uint64 start_offset,
-                                std::string object_to_upload,
+  /// Initiates a new resumable upload session of the bytes
+  /// [start_offset, end_offset) of the temporary file.
+  Status CreateNewUploadSession(uint64 start_offset, uint64 end_offset,
+                                const std::string& object_to_upload,
                                 UploadSessionHandle* session_handle) {
-    uint64 file_size;
-    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
-    return session_creator_(start_offset, object_to_upload, bucket_, file_size,
-                            GetGcsPath(), session_handle);
+    return session_creator_(start_offset, object_to_upload, bucket_,
+                            end_offset, GetGcsPath(), session_handle);
+  }
+
+  /// Returns the name of a temporary object next to the object.
+  string GetTmpComposeObject(const string& suffix) const {
+    return io::JoinPath(io::Dirname(object_), ".tmpcompose",
+                        strings::StrCat(io::Basename(object_), suffix));
   }
 
   /// Appends the data of append_object to the original object and deletes
@@ -684,22 +851,20 @@ class GcsWritableFile : public WritableFile {
   /// If the upload has already succeeded, sets 'completed' to true.
   /// Otherwise sets 'completed' to false and 'uploaded' to the currently
   /// uploaded size in bytes.
-  Status RequestUploadSessionStatus(const string& session_uri, bool* completed,
+  Status RequestUploadSessionStatus(const string& session_uri,
+                                    uint64 object_size, bool* completed,
                                     uint64* uploaded) {
-    uint64 file_size;
-    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
-    return status_poller_(session_uri, file_size, GetGcsPath(), completed,
+    return status_poller_(session_uri, object_size, GetGcsPath(), completed,
                           uploaded);
   }
 
-  /// Uploads data to object.
+  /// Uploads the bytes [start_offset + already_uploaded, end_offset) of the
+  /// temporary file to the session.
   Status UploadToSession(const string& session_uri, uint64 start_offset,
-                         uint64 already_uploaded) {
-    uint64 file_size;
-    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
+                         uint64 already_uploaded, uint64 end_offset) {
     Status status =
         object_uploader_(session_uri, start_offset, already_uploaded,
-                         tmp_content_filename_, file_size, GetGcsPath());
+                         tmp_content_filename_, end_offset, GetGcsPath());
     if (status.ok()) {
       // Erase the file from the file cache on every successful write.
       // Note: Only local cache, this does nothing on distributed cache. The
@@ -725,6 +890,7 @@ class GcsWritableFile : public WritableFile {
   bool sync_needed_;  // whether there is buffered data that needs to be synced
   RetryConfig retry_config_;
   bool compose_append_;
+  const GcsFileSystem::ParallelCompositeUploadConfig parallel_upload_;
   uint64 start_offset_;
   // Callbacks to the file system used to upload object into GCS.
   const SessionCreator session_creator_;
@@ -750,6 +916,20 @@ bool StringPieceIdentity(StringPiece str, StringPiece* value) {
   return true;
 }
 
+/// \brief Utility function to parse "true"/"1" or "false"/"0", ignoring case.
+bool StringPieceToBool(StringPiece str, bool* value) {
+  const string lowercase = absl::AsciiStrToLower(str);
+  if (lowercase == "true" || lowercase == "1") {
+    *value = true;
+    return true;
+  }
+  if (lowercase == "false" || lowercase == "0") {
+    *value = false;
+    return true;
+  }
+  return false;
+}
+
 /// \brief Utility function to split a comma delimited list of strings to an
 /// unordered set, lowercasing all values.
 bool SplitByCommaToLowercaseSet(StringPiece list,
@@ -773,7 +953,21 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
 
   uint64 max_staleness = kDefaultMaxStaleness;
 
-  http_request_factory_ = std::make_shared<CurlHttpRequest::Factory>();
+  // Requests reuse the connections of the previous ones, unless disabled.
+  CurlHttpRequest::Options http_options;
+  size_t http_connection_pool_size = kHttpConnectionPoolDefaultSize;
+  if (GetEnvVar(kHttpConnectionPoolSize, strings::safe_strtou64, &value)) {
+    http_connection_pool_size = value;
+  }
+  if (http_connection_pool_size > 0) {
+    http_options.handle_pool =
+        std::make_shared<CurlHandlePool>(http_connection_pool_size);
+  }
+  GetEnvVar(kHttp2, StringPieceToBool, &http_options.http2);
+  VLOG(1) << "GCS HTTP connection pool size = " << http_connection_pool_size
+          << " ; HTTP/2 = " << http_options.http2;
+  http_request_factory_ =
+      std::make_shared<CurlHttpRequest::Factory>(http_options);
   compute_engine_metadata_client_ =
       std::make_shared<ComputeEngineMetadataClient>(http_request_factory_);
   auth_provider_ = std::unique_ptr<AuthProvider>(
@@ -799,12 +993,16 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+  if (GetEnvVar(kMaxReadAheadBlocks, strings::safe_strtou64, &value)) {
+    max_read_ahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "max read-ahead blocks = " << max_read_ahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -925,6 +1123,21 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   } else {
     compose_append_ = false;
   }
+
+  // Apply the overrides for parallel composite uploads.
+  if (GetEnvVar(kParallelCompositeUploadThreshold, strings::safe_strtou64,
+                &value)) {
+    parallel_composite_upload_.threshold_bytes = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kParallelCompositeUploadComponentSize, strings::safe_strtou64,
+                &value)) {
+    parallel_composite_upload_.component_size_bytes = value * 1024 * 1024;
+  }
+  uint32 threads;
+  if (GetEnvVar(kParallelCompositeUploadThreads, strings::safe_strtou32,
+                &threads)) {
+    parallel_composite_upload_.threads = threads;
+  }
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -981,8 +1194,10 @@ Status GcsFileSystem::NewRandomAccessFile(
       }
       *result = StringPiece();
       size_t bytes_transferred;
-      TF_RETURN_IF_ERROR(file_block_cache_->Read(fname, offset, n, scratch,
-                                                 &bytes_transferred));
+      // Random access files are usually scanned sequentially, e.g. by record
+      // readers, so they let the cache read ahead of sequential reads.
+      TF_RETURN_IF_ERROR(file_block_cache_->ReadWithReadAhead(
+          fname, offset, n, scratch, &bytes_transferred));
       *result = StringPiece(scratch, bytes_transferred);
       if (bytes_transferred < n) {
         return errors::OutOfRange("EOF reached, ", result->size(),
@@ -1032,7 +1247,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), max_read_ahead_blocks_));
 
   // Check if cache is enabled here to avoid unnecessary mutex contention.
   cache_enabled_ = file_block_cache->IsCacheEnabled();
@@ -1147,8 +1363,9 @@ Status GcsFileSystem::UploadToSession(const std::string& session_uri,
   }
   request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.write);
 
-  TF_RETURN_IF_ERROR(request->SetPutFromFile(tmp_content_filename,
-                                             start_offset + already_uploaded));
+  TF_RETURN_IF_ERROR(request->SetPutFromFileRange(
+      tmp_content_filename, start_offset + already_uploaded,
+      file_size - start_offset - already_uploaded));
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading ",
                                   file_path);
   return Status::OK();
@@ -1298,8 +1515,8 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
   result->reset(new GcsWritableFile(
       bucket, object, this, &timeouts_,
       [this, fname]() { ClearFileCaches(fname); }, retry_config_,
-      compose_append_, session_creator, object_uploader, status_poller,
-      generation_getter));
+      compose_append_, parallel_composite_upload_, session_creator,
+      object_uploader, status_poller, generation_getter));
   return Status::OK();
 }
 
@@ -1378,8 +1595,8 @@ Status GcsFileSystem::NewAppendableFile(const string& fname,
   result->reset(new GcsWritableFile(
       bucket, object, this, old_content_filename, &timeouts_,
       [this, fname]() { ClearFileCaches(fname); }, retry_config_,
-      compose_append_, session_creator, object_uploader, status_poller,
-      generation_getter));
+      compose_append_, parallel_composite_upload_, session_creator,
+      object_uploader, status_poller, generation_getter));
   return Status::OK();
 }
 
@@ -62,6 +62,11 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the maximum number of blocks the
+// cache fetches ahead of sequential reads of a file. A value of 0 means that
+// the cache does not read ahead.
+constexpr char kMaxReadAheadBlocks[] = "GCS_READ_CACHE_MAX_READ_AHEAD_BLOCKS";
+constexpr size_t kDefaultMaxReadAheadBlocks = 0;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -125,6 +130,7 @@ struct UploadSessionHandle {
 class GcsFileSystem : public FileSystem {
  public:
   struct TimeoutConfig;
+  struct ParallelCompositeUploadConfig;
 
   // Main constructor used (via RetryingFileSystem) throughout Tensorflow
   explicit GcsFileSystem(bool make_default_cache = true);
@@ -210,6 +216,9 @@ class GcsFileSystem : public FileSystem {
     return file_block_cache_->max_staleness();
   }
   TimeoutConfig timeouts() const { return timeouts_; }
+  ParallelCompositeUploadConfig parallel_composite_upload() const {
+    return parallel_composite_upload_;
+  }
   std::unordered_set<string> allowed_locations() const {
     return allowed_locations_;
   }
@@ -267,6 +276,34 @@ class GcsFileSystem : public FileSystem {
           write(write) {}
   };
 
+  /// \brief Structure containing the configuration of parallel composite
+  /// uploads.
+  ///
+  /// Files of at least `threshold_bytes` are uploaded as several temporary
+  /// objects at once, which are then composed into the file and deleted.
+  struct ParallelCompositeUploadConfig {
+    // Files smaller than this are uploaded as a single object. 0 disables
+    // parallel composite uploads.
+    uint64 threshold_bytes = 0;
+
+    // The size of the temporary objects. Larger files are split into at most
+    // kMaxComposeComponents larger objects instead.
+    uint64 component_size_bytes = 32 * 1024 * 1024;  // 32 MB
+
+    // The number of temporary objects uploaded at once.
+    int threads = 8;
+
+    // The number of source objects a GCS compose request may have.
+    static constexpr int kMaxComposeComponents = 32;
+  };
+
+  /// Sets the configuration of parallel composite uploads of the files that
+  /// are created afterwards.
+  void SetParallelCompositeUploadConfig(
+      const ParallelCompositeUploadConfig& config) {
+    parallel_composite_upload_ = config;
+  }
+
   Status CreateHttpRequest(std::unique_ptr<HttpRequest>* request);
 
   /// \brief Sets a new AuthProvider on the GCS FileSystem.
@@ -300,7 +337,8 @@ class GcsFileSystem : public FileSystem {
                                         const std::string& gcs_path,
                                         UploadSessionHandle* session_handle);
 
-  // Uploads object data to session.
+  // Uploads the bytes [start_offset + already_uploaded, file_size) of the
+  // temporary file to the session.
   virtual Status UploadToSession(const std::string& session_uri,
                                  uint64 start_offset, uint64 already_uploaded,
                                  const std::string& tmp_content_filename,
@@ -415,6 +453,10 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The maximum number of blocks the block cache fetches ahead of the
+  // sequential reads of files.
+  size_t max_read_ahead_blocks_ = kDefaultMaxReadAheadBlocks;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -435,6 +477,7 @@ class GcsFileSystem : public FileSystem {
   std::unique_ptr<BucketLocationCache> bucket_location_cache_;
   std::unordered_set<string> allowed_locations_;
   bool compose_append_;
+  ParallelCompositeUploadConfig parallel_composite_upload_;
 
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
@@ -4094,5 +4094,283 @@ TEST(GcsFileSystemTest, AppendModeDefault) {
   EXPECT_EQ(false, fs1.compose_append());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_ParallelCompositeUpload) {
+  std::vector<HttpRequest*> requests({
+      // Upload the 17 bytes as three temporary objects.
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 6\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location0"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location0\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-5/6\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: conten\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part1\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 6\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location1"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location1\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-5/6\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: t1,con\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part2\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 5\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location2"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location2\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-4/5\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: tent2\n",
+                          ""),
+      // Compose them into the file and delete them.
+      new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                          "bucket/o/path%2Fwriteable/compose\n"
+                          "Auth Token: fake_token\n"
+                          "Timeouts: 5 1 10\n"
+                          "Header content-type: application/json\n"
+                          "Post body: {'sourceObjects': ["
+                          "{'name': 'path/.tmpcompose/writeable.part0'},"
+                          "{'name': 'path/.tmpcompose/writeable.part1'},"
+                          "{'name': 'path/.tmpcompose/writeable.part2'}]}\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part1\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part2\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          "")
+  });
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelCompositeUploadConfig config;
+  config.threshold_bytes = 16;
+  config.component_size_bytes = 6;
+  config.threads = 1;
+  fs.SetParallelCompositeUploadConfig(config);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/path/writeable", nullptr, &wfile));
+  TF_EXPECT_OK(wfile->Append("content1,"));
+  TF_EXPECT_OK(wfile->Append("content2"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_ParallelCompositeUploadFails) {
+  std::vector<HttpRequest*> requests({
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 9\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location0"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location0\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-8/9\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: content1,\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part1\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 8\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location1"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location1\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-7/8\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: content2\n",
+                          "", errors::PermissionDenied("upload failed"),
+                          403),
+      // Delete the temporary object that was uploaded.
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          ""),
+      // These calls will be made in the Close() attempt from the destructor.
+      // Letting the destructor succeed.
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 9\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location0"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location0\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-8/9\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: content1,\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=path%2F.tmpcompose%2Fwriteable.part1\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 8\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location1"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location1\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-7/8\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: content2\n",
+                          ""),
+      new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                          "bucket/o/path%2Fwriteable/compose\n"
+                          "Auth Token: fake_token\n"
+                          "Timeouts: 5 1 10\n"
+                          "Header content-type: application/json\n"
+                          "Post body: {'sourceObjects': ["
+                          "{'name': 'path/.tmpcompose/writeable.part0'},"
+                          "{'name': 'path/.tmpcompose/writeable.part1'}]}\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part0\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "path%2F.tmpcompose%2Fwriteable.part1\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Delete: yes\n",
+          "")
+  });
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelCompositeUploadConfig config;
+  config.threshold_bytes = 16;
+  config.component_size_bytes = 9;
+  config.threads = 1;
+  fs.SetParallelCompositeUploadConfig(config);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/path/writeable", nullptr, &wfile));
+  TF_EXPECT_OK(wfile->Append("content1,"));
+  TF_EXPECT_OK(wfile->Append("content2"));
+  const Status status = wfile->Close();
+  EXPECT_EQ(errors::Code::PERMISSION_DENIED, status.code()) << status;
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_SmallFileSkipsParallelCompositeUpload) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=resumable&name=path%2Fwriteable\n"
+           "Auth Token: fake_token\n"
+           "Header X-Upload-Content-Length: 17\n"
+           "Post: yes\n"
+           "Timeouts: 5 1 10\n",
+           "", {{"Location", "https://custom/upload/location"}}),
+       new FakeHttpRequest("Uri: https://custom/upload/location\n"
+                           "Auth Token: fake_token\n"
+                           "Header Content-Range: bytes 0-16/17\n"
+                           "Timeouts: 5 1 30\n"
+                           "Put body: content1,content2\n",
+                           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelCompositeUploadConfig config;
+  config.threshold_bytes = 18;
+  config.component_size_bytes = 6;
+  fs.SetParallelCompositeUploadConfig(config);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/path/writeable", nullptr, &wfile));
+  TF_EXPECT_OK(wfile->Append("content1,"));
+  TF_EXPECT_OK(wfile->Append("content2"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
+TEST(GcsFileSystemTest, OverrideParallelCompositeUploadParameters) {
+  setenv("GCS_PARALLEL_COMPOSITE_UPLOAD_THRESHOLD_MB", "100", 1);
+  setenv("GCS_PARALLEL_COMPOSITE_UPLOAD_COMPONENT_SIZE_MB", "16", 1);
+  setenv("GCS_PARALLEL_COMPOSITE_UPLOAD_THREADS", "4", 1);
+  GcsFileSystem fs1;
+  EXPECT_EQ(100 * 1024 * 1024, fs1.parallel_composite_upload().threshold_bytes);
+  EXPECT_EQ(16 * 1024 * 1024,
+            fs1.parallel_composite_upload().component_size_bytes);
+  EXPECT_EQ(4, fs1.parallel_composite_upload().threads);
+  unsetenv("GCS_PARALLEL_COMPOSITE_UPLOAD_THRESHOLD_MB");
+  unsetenv("GCS_PARALLEL_COMPOSITE_UPLOAD_COMPONENT_SIZE_MB");
+  unsetenv("GCS_PARALLEL_COMPOSITE_UPLOAD_THREADS");
+}
+
+TEST(GcsFileSystemTest, ParallelCompositeUploadDisabledByDefault) {
+  GcsFileSystem fs1;
+  EXPECT_EQ(0, fs1.parallel_composite_upload().threshold_bytes);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -126,6 +126,13 @@ class HttpRequest {
   /// the given offset.
   virtual Status SetPutFromFile(const string& body_filepath, size_t offset) = 0;
 
+  /// \brief Makes the request a PUT request.
+  ///
+  /// The request body will be the `length` bytes of the specified file
+  /// starting from the given offset, or the rest of the file if it is shorter.
+  virtual Status SetPutFromFileRange(const string& body_filepath, size_t offset,
+                                     size_t length) = 0;
+
   /// Makes the request a PUT request with an empty body.
   virtual void SetPutEmptyBody() = 0;
 
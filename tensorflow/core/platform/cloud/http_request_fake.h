@@ -97,6 +97,15 @@ class FakeHttpRequest : public CurlHttpRequest {
     actual_request_ += "Put body: " + content + "\n";
     return Status::OK();
   }
+  Status SetPutFromFileRange(const string& body_filepath, size_t offset,
+                             size_t length) override {
+    std::ifstream stream(body_filepath);
+    const string& content = string(std::istreambuf_iterator<char>(stream),
+                                   std::istreambuf_iterator<char>())
+                                .substr(offset, length);
+    actual_request_ += "Put body: " + content + "\n";
+    return Status::OK();
+  }
   void SetPostFromBuffer(const char* buffer, size_t size) override {
     if (captured_post_body_) {
       *captured_post_body_ = string(buffer, size);
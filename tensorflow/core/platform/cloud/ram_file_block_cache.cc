@@ -46,6 +46,11 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
     }
   }
 
+  return Insert_Locked(key);
+}
+
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Insert_Locked(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -78,16 +83,20 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
     lru_list_.push_front(key);
     block->lru_iterator = lru_list_.begin();
   }
+  block->prefetched = false;
 
   // Check for inconsistent state. If there is a block later in the same file
   // in the cache, and our current block is not block size, this likely means
   // we have inconsistent state within the cache. Note: it's possible some
-  // incomplete reads may still go undetected.
+  // incomplete reads may still go undetected. Blocks prefetched past the end
+  // of the file and not read since are not inconsistent.
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
     auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    while (fcmp != block_map_.begin() && key < (--fcmp)->first) {
+      if (!fcmp->second->prefetched) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -97,7 +106,8 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
 }
 
 Status RamFileBlockCache::MaybeFetch(const Key& key,
-                                     const std::shared_ptr<Block>& block) {
+                                     const std::shared_ptr<Block>& block,
+                                     bool prefetch) {
   bool downloaded_block = false;
   auto reconcile_state =
       gtl::MakeCleanup([this, &downloaded_block, &key, &block] {
@@ -135,7 +145,11 @@ Status RamFileBlockCache::MaybeFetch(const Key& key,
         status.Update(block_fetcher_(key.first, key.second, block_size_,
                                      block->data.data(), &bytes_transferred));
         if (cache_stats_ != nullptr) {
-          cache_stats_->RecordCacheMissBlockSize(bytes_transferred);
+          if (prefetch) {
+            cache_stats_->RecordCachePrefetchBlockSize(bytes_transferred);
+          } else {
+            cache_stats_->RecordCacheMissBlockSize(bytes_transferred);
+          }
         }
         block->mu.lock();  // Reacquire the lock immediately afterwards
         if (status.ok()) {
@@ -227,6 +241,74 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   return Status::OK();
 }
 
+Status RamFileBlockCache::ReadWithReadAhead(const string& filename,
+                                            size_t offset, size_t n,
+                                            char* buffer,
+                                            size_t* bytes_transferred) {
+  const Status status = Read(filename, offset, n, buffer, bytes_transferred);
+  if (read_ahead_pool_ == nullptr || n == 0 || n > max_bytes_) return status;
+
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> prefetches;
+  {
+    mutex_lock lock(mu_);
+    ReadAheadState& state = read_ahead_state_[filename];
+    if (!status.ok() || *bytes_transferred < n) {
+      // The scan reached the end of the file.
+      state.window = 0;
+    } else if (offset == state.next_offset) {
+      const size_t max_window =
+          std::min(max_read_ahead_blocks_,
+                   std::max<size_t>(1, max_bytes_ / 2 / block_size_));
+      state.window =
+          std::min(std::max<size_t>(1, 2 * state.window), max_window);
+    } else {
+      state.window = 0;
+    }
+    state.next_offset = offset + n;
+
+    // Start after the last block of the read.
+    const size_t start = block_size_ * ((offset + n - 1) / block_size_ + 1);
+    for (size_t i = 0; i < state.window; ++i) {
+      Key key = std::make_pair(filename, start + i * block_size_);
+      if (block_map_.find(key) != block_map_.end()) continue;
+      if (prefetching_bytes_ + block_size_ > max_bytes_ / 2) break;
+      prefetching_bytes_ += block_size_;
+      std::shared_ptr<Block> block = Insert_Locked(key);
+      block->prefetched = true;
+      prefetches.emplace_back(std::move(key), std::move(block));
+    }
+  }
+  for (auto& prefetch : prefetches) {
+    read_ahead_pool_->Schedule(
+        [this, key = std::move(prefetch.first),
+         block = std::move(prefetch.second)]() { Prefetch(key, block); });
+  }
+  return status;
+}
+
+void RamFileBlockCache::Prefetch(const Key& key,
+                                 const std::shared_ptr<Block>& block) {
+  const Status status = MaybeFetch(key, block, /*prefetch=*/true);
+  mutex_lock lock(mu_);
+  prefetching_bytes_ -= block_size_;
+  if (!status.ok()) {
+    VLOG(1) << "Failed to prefetch " << key.first << "@" << key.second << ": "
+            << status;
+    // Drop the block, e.g. past the end of the file, unless a read is already
+    // fetching it again.
+    auto entry = block_map_.find(key);
+    if (entry != block_map_.end() && entry->second == block) {
+      mutex_lock l(block->mu);
+      if (block->state == FetchState::ERROR) {
+        // The buffer of a failed fetch is not accounted for in cache_size_.
+        std::vector<char>().swap(block->data);
+        RemoveBlock(entry);
+      }
+    }
+  }
+  Trim();
+}
+
 bool RamFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
                                                        int64_t file_signature) {
   mutex_lock lock(mu_);
@@ -271,12 +353,14 @@ void RamFileBlockCache::Flush() {
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  read_ahead_state_.clear();
   cache_size_ = 0;
 }
 
 void RamFileBlockCache::RemoveFile(const string& filename) {
   mutex_lock lock(mu_);
   RemoveFile_Locked(filename);
+  read_ahead_state_.erase(filename);
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -50,22 +52,34 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// ReadWithReadAhead() keeps up to `max_read_ahead_blocks` blocks fetched
+  /// ahead of sequential scans, or does not read ahead if it is 0.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t max_read_ahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        max_read_ahead_blocks_(IsCacheEnabled() ? max_read_ahead_blocks : 0) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (max_read_ahead_blocks_ > 0) {
+      read_ahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_read_ahead_FBC",
+          std::min<size_t>(max_read_ahead_blocks_, kMaxReadAheadThreads)));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying read_ahead_pool_ will block until the pending prefetches
+    // complete.
+    read_ahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -91,6 +105,17 @@ class RamFileBlockCache : public FileBlockCache {
   Status Read(const string& filename, size_t offset, size_t n, char* buffer,
               size_t* bytes_transferred) override;
 
+  /// Read as Read() does, and read ahead of sequential scans: once a read of
+  /// `filename` starts where the previous one ended, the blocks that follow
+  /// are fetched concurrently in the background.  The number of blocks kept
+  /// ahead doubles with every sequential read, up to `max_read_ahead_blocks`,
+  /// and drops to 0 when the scan seeks elsewhere or reaches the end of the
+  /// file.  Blocks being prefetched use at most half of `max_bytes`, so that
+  /// prefetching does not evict the blocks being read.
+  Status ReadWithReadAhead(const string& filename, size_t offset, size_t n,
+                           char* buffer, size_t* bytes_transferred) override
+      TF_LOCKS_EXCLUDED(mu_);
+
   // Validate the given file signature with the existing file signature in the
   // cache. Returns true if the signature doesn't change or the file doesn't
   // exist before. If the signature changes, update the existing signature with
@@ -131,6 +156,9 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The maximum number of blocks fetched ahead of a sequential scan.
+  const size_t max_read_ahead_blocks_;
+  static constexpr size_t kMaxReadAheadThreads = 16;
 
   /// \brief The key type for the file block cache.
   ///
@@ -158,10 +186,11 @@ class RamFileBlockCache : public FileBlockCache {
   /// was cached, a coordination lock, and state & condition variables.
   ///
   /// Thread safety:
-  /// The iterator and timestamp fields should only be accessed while holding
-  /// the block-cache-wide mu_ instance variable. The state variable should only
-  /// be accessed while holding the Block's mu lock. The data vector should only
-  /// be accessed after state == FINISHED, and it should never be modified.
+  /// The iterator, timestamp and prefetched fields should only be accessed
+  /// while holding the block-cache-wide mu_ instance variable. The state
+  /// variable should only be accessed while holding the Block's mu lock. The
+  /// data vector should only be accessed after state == FINISHED, and it should
+  /// never be modified.
   ///
   /// In order to prevent deadlocks, never grab the block-cache-wide mu_ lock
   /// AFTER grabbing any block's mu lock. It is safe to grab mu without locking
@@ -175,6 +204,8 @@ class RamFileBlockCache : public FileBlockCache {
     std::list<Key>::iterator lra_iterator;
     /// The timestamp (seconds since epoch) at which the block was cached.
     uint64 timestamp;
+    /// Whether the block was prefetched and has not been read since.
+    bool prefetched = false;
     /// Mutex to guard state variable
     mutex mu;
     /// The state of the block.
@@ -197,7 +228,17 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
 
-  Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
+  /// Insert a new empty block for `key`, which must not be in the cache.
+  std::shared_ptr<Block> Insert_Locked(const Key& key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Fetch the block if it was not fetched yet.  `prefetch` tells whether the
+  /// block is fetched ahead of a read, for the stats.
+  Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block,
+                    bool prefetch = false) TF_LOCKS_EXCLUDED(mu_);
+
+  /// Fetch a block inserted by ReadWithReadAhead() on read_ahead_pool_.
+  void Prefetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
   /// Trim the block cache to make room for another entry.
@@ -221,6 +262,17 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// The pool fetching blocks ahead of sequential scans.
+  std::unique_ptr<thread::ThreadPool> read_ahead_pool_;
+
+  /// \brief The read-ahead state of a file read by ReadWithReadAhead().
+  struct ReadAheadState {
+    /// The offset at which a read continues the scan.
+    size_t next_offset = 0;
+    /// The number of blocks kept fetched ahead of the scan.
+    size_t window = 0;
+  };
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -243,6 +295,12 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64_t> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// The read-ahead state of the files read by ReadWithReadAhead().
+  std::map<string, ReadAheadState> read_ahead_state_ TF_GUARDED_BY(mu_);
+
+  /// The combined size of the blocks being prefetched.
+  size_t prefetching_bytes_ TF_GUARDED_BY(mu_) = 0;
 };
 
 }  // namespace tensorflow
@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
+#include <atomic>
 #include <cstring>
+#include <map>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cloud/now_seconds_env.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -566,5 +570,140 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+Status ReadCacheWithReadAhead(RamFileBlockCache* cache, const string& filename,
+                              size_t offset, size_t n, std::vector<char>* out) {
+  out->clear();
+  out->resize(n, 0);
+  size_t bytes_transferred = 0;
+  Status status = cache->ReadWithReadAhead(filename, offset, n, out->data(),
+                                           &bytes_transferred);
+  EXPECT_LE(bytes_transferred, n);
+  out->resize(bytes_transferred, n);
+  return status;
+}
+
+// Serves a file of `file_size` bytes, whose byte at offset `i` is `i % 256`,
+// and counts the fetches of every offset.
+class CountingFetcher {
+ public:
+  explicit CountingFetcher(size_t file_size) : file_size_(file_size) {}
+
+  RamFileBlockCache::BlockFetcher fetcher() {
+    return [this](const string& filename, size_t offset, size_t n,
+                  char* buffer, size_t* bytes_transferred) {
+      {
+        mutex_lock l(mu_);
+        ++fetches_[offset];
+      }
+      *bytes_transferred = offset < file_size_
+                               ? std::min(n, file_size_ - offset)
+                               : 0;
+      for (size_t i = 0; i < *bytes_transferred; ++i) {
+        buffer[i] = static_cast<char>((offset + i) % 256);
+      }
+      return Status::OK();
+    };
+  }
+
+  std::map<size_t, int> fetches() {
+    mutex_lock l(mu_);
+    return fetches_;
+  }
+
+ private:
+  const size_t file_size_;
+  mutex mu_;
+  std::map<size_t, int> fetches_ TF_GUARDED_BY(mu_);
+};
+
+class CountingStats : public FileBlockCacheStatsInterface {
+ public:
+  void Configure(const FileBlockCache* block_cache) override {}
+  void RecordCacheHitBlockSize(size_t bytes_transferred) override {}
+  void RecordCacheMissBlockSize(size_t bytes_transferred) override {
+    ++misses;
+  }
+  void RecordCachePrefetchBlockSize(size_t bytes_transferred) override {
+    ++prefetches;
+  }
+
+  std::atomic<int> misses{0};
+  std::atomic<int> prefetches{0};
+};
+
+TEST(RamFileBlockCacheTest, ReadAheadOfSequentialReads) {
+  const size_t block_size = 16;
+  CountingFetcher fetcher(1 << 20);
+  CountingStats stats;
+  auto cache = absl::make_unique<RamFileBlockCache>(
+      block_size, 64 * block_size, 0, fetcher.fetcher(), Env::Default(),
+      /*max_read_ahead_blocks=*/4);
+  cache->SetStats(&stats);
+  std::vector<char> out;
+  for (size_t offset = 0; offset < 4 * block_size; offset += block_size) {
+    TF_EXPECT_OK(
+        ReadCacheWithReadAhead(cache.get(), "a", offset, block_size, &out));
+    ASSERT_EQ(out.size(), block_size);
+    EXPECT_EQ(out[0], static_cast<char>(offset));
+  }
+  // Waits for the pending prefetches.
+  cache.reset();
+
+  // The window grew to 4 blocks, which were fetched ahead of the last read,
+  // and no block was fetched twice.
+  std::map<size_t, int> fetches = fetcher.fetches();
+  ASSERT_EQ(fetches.size(), 8);
+  for (const auto& fetch : fetches) {
+    EXPECT_EQ(fetch.first % block_size, 0);
+    EXPECT_LT(fetch.first, 8 * block_size);
+    EXPECT_EQ(fetch.second, 1) << "at offset " << fetch.first;
+  }
+  EXPECT_GE(stats.prefetches, 4);
+  EXPECT_EQ(stats.misses + stats.prefetches, 8);
+}
+
+TEST(RamFileBlockCacheTest, ReadAheadStopsOnSeek) {
+  const size_t block_size = 16;
+  CountingFetcher fetcher(1 << 20);
+  auto cache = absl::make_unique<RamFileBlockCache>(
+      block_size, 64 * block_size, 0, fetcher.fetcher(), Env::Default(),
+      /*max_read_ahead_blocks=*/4);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCacheWithReadAhead(cache.get(), "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCacheWithReadAhead(cache.get(), "a", 10 * block_size,
+                                      block_size, &out));
+  // Read() does not read ahead.
+  TF_EXPECT_OK(ReadCache(cache.get(), "b", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(cache.get(), "b", block_size, block_size, &out));
+  cache.reset();
+
+  // Only the block after the first read was prefetched.
+  std::map<size_t, int> fetches = fetcher.fetches();
+  std::map<size_t, int> expected = {
+      {0, 2}, {block_size, 2}, {10 * block_size, 1}};
+  EXPECT_EQ(fetches, expected);
+}
+
+TEST(RamFileBlockCacheTest, ReadAheadPastEndOfFile) {
+  const size_t block_size = 16;
+  const size_t file_size = 40;
+  CountingFetcher fetcher(file_size);
+  RamFileBlockCache cache(block_size, 64 * block_size, 0, fetcher.fetcher(),
+                          Env::Default(), /*max_read_ahead_blocks=*/4);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCacheWithReadAhead(&cache, "", 0, block_size, &out));
+  TF_EXPECT_OK(
+      ReadCacheWithReadAhead(&cache, "", block_size, block_size, &out));
+  // The blocks prefetched past the end of the file do not make the last,
+  // partial block inconsistent.
+  TF_EXPECT_OK(
+      ReadCacheWithReadAhead(&cache, "", 2 * block_size, block_size, &out));
+  EXPECT_EQ(out.size(), file_size - 2 * block_size);
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, file_size, &out));
+  EXPECT_EQ(out.size(), file_size);
+  EXPECT_EQ(ReadCache(&cache, "", file_size + 8, 4, &out).code(),
+            error::OUT_OF_RANGE);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -582,6 +582,7 @@ def tf_additional_lib_hdrs():
         ],
         "//conditions:default": [
             "//tensorflow/core/platform/default:posix_file_system.h",
+            "//tensorflow/core/platform/default:posix_io_uring.h",
             "//tensorflow/core/platform/default:subprocess.h",
         ],
     })
@@ -712,6 +713,15 @@ def tf_additional_rpc_deps():
 def tf_additional_tensor_coding_deps():
     return []
 
+# Zstandard and LZ4 are not part of the default workspace. Builds that provide
+# them return targets here that also define TF_USE_ZSTD and TF_USE_LZ4
+# respectively; without them the codecs report Unimplemented at runtime.
+def tf_zstd_deps():
+    return []
+
+def tf_lz4_deps():
+    return []
+
 def tf_fingerprint_deps():
     return [
         "@farmhash_archive//:farmhash",
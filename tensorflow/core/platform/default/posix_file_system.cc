@@ -30,6 +30,7 @@ limitations under the License.
 #include <unistd.h>
 
 #include "tensorflow/core/platform/default/posix_file_system.h"
+#include "tensorflow/core/platform/default/posix_io_uring.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/errors.h"
@@ -95,6 +96,20 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  // With TF_POSIX_IO_URING set, the reads are submitted through io_uring and
+  // are all in flight at once.
+  Status ReadBatch(std::vector<ReadRequest>* requests) const override {
+    if (requests->size() > 1 && internal::IoUringRequested() &&
+        internal::IoUringReadBatch(fd_, filename_, requests)) {
+      Status s;
+      for (const ReadRequest& request : *requests) {
+        s.Update(request.status);
+      }
+      return s;
+    }
+    return RandomAccessFile::ReadBatch(requests);
+  }
+
 #if defined(TF_CORD_SUPPORT)
   Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {
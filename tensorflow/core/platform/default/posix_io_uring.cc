@@ -0,0 +1,302 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/default/posix_io_uring.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TF_HAS_IO_URING 1
+#endif
+#endif
+
+#if defined(TF_HAS_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#endif
+
+#include "tensorflow/core/platform/error.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace internal {
+
+bool IoUringRequested() {
+  const char* value = getenv("TF_POSIX_IO_URING");
+  return value != nullptr &&
+         (strcmp(value, "1") == 0 || strcasecmp(value, "true") == 0);
+}
+
+#if defined(TF_HAS_IO_URING)
+
+namespace {
+
+// The number of reads each io_uring keeps in flight.
+constexpr unsigned kIoUringQueueDepth = 64;
+
+// A minimal io_uring, set up with the raw system calls, that reads into
+// caller-provided buffers. Not thread-safe: every thread uses its own ring.
+class IoUring {
+ public:
+  // Returns nullptr if the kernel does not support io_uring.
+  static std::unique_ptr<IoUring> Create(unsigned entries);
+
+  ~IoUring() {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+  }
+
+  // Reads `requests` from `fd`, setting their result and status. Returns an
+  // error if the ring itself failed, in which case it must not be used again.
+  Status ReadBatch(int fd, const std::string& filename,
+                   std::vector<RandomAccessFile::ReadRequest>* requests);
+
+ private:
+  IoUring() = default;
+
+  int ring_fd_ = -1;
+  unsigned sq_entries_ = 0;
+
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  unsigned* cq_head_ = nullptr;
+  const unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  const io_uring_cqe* cqes_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+std::unique_ptr<IoUring> IoUring::Create(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd < 0) {
+    LOG(WARNING) << "io_uring_setup() failed, reading files with pread(): "
+                 << strerror(errno);
+    return nullptr;
+  }
+  std::unique_ptr<IoUring> ring(new IoUring());
+  ring->ring_fd_ = ring_fd;
+  ring->sq_entries_ = params.sq_entries;
+
+  ring->sq_ring_size_ =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    ring->sq_ring_size_ = ring->cq_ring_size_ =
+        std::max(ring->sq_ring_size_, ring->cq_ring_size_);
+  }
+  void* sq_ring =
+      mmap(nullptr, ring->sq_ring_size_, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    LOG(WARNING) << "Mapping the io_uring submission queue failed: "
+                 << strerror(errno);
+    return nullptr;
+  }
+  ring->sq_ring_ = sq_ring;
+  if (single_mmap) {
+    ring->cq_ring_ = sq_ring;
+  } else {
+    void* cq_ring =
+        mmap(nullptr, ring->cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      LOG(WARNING) << "Mapping the io_uring completion queue failed: "
+                   << strerror(errno);
+      return nullptr;
+    }
+    ring->cq_ring_ = cq_ring;
+  }
+  ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    LOG(WARNING) << "Mapping the io_uring submission entries failed: "
+                 << strerror(errno);
+    return nullptr;
+  }
+  ring->sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(ring->sq_ring_);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(ring->cq_ring_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return ring;
+}
+
+Status IoUring::ReadBatch(
+    int fd, const std::string& filename,
+    std::vector<RandomAccessFile::ReadRequest>* requests) {
+  const size_t num_requests = requests->size();
+  // The bytes read so far and the iovec of the current read, per request.
+  std::vector<size_t> bytes_read(num_requests, 0);
+  std::vector<iovec> iovecs(num_requests);
+  std::deque<size_t> pending;
+  for (size_t i = 0; i < num_requests; ++i) {
+    RandomAccessFile::ReadRequest& request = (*requests)[i];
+    request.status = Status::OK();
+    if (request.n > 0) pending.push_back(i);
+  }
+
+  // Reads in the submission queue or in the kernel, and the subset of them
+  // that io_uring_enter() has not consumed yet.
+  unsigned in_flight = 0;
+  unsigned unsubmitted = 0;
+  Status ring_status;
+  while (!pending.empty() || in_flight > 0) {
+    unsigned sq_tail = *sq_tail_;
+    while (!pending.empty() && in_flight < sq_entries_) {
+      const size_t i = pending.front();
+      pending.pop_front();
+      const RandomAccessFile::ReadRequest& request = (*requests)[i];
+      iovecs[i].iov_base = request.scratch + bytes_read[i];
+      // Some platforms limit single reads to what fits in a 32-bit integer,
+      // as in PosixRandomAccessFile::Read().
+      iovecs[i].iov_len = std::min<size_t>(request.n - bytes_read[i],
+                                           INT32_MAX);
+      const unsigned index = sq_tail & sq_mask_;
+      io_uring_sqe* sqe = &sqes_[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(&iovecs[i]);
+      sqe->len = 1;
+      sqe->off = request.offset + bytes_read[i];
+      sqe->user_data = i;
+      sq_array_[index] = index;
+      ++sq_tail;
+      ++in_flight;
+      ++unsubmitted;
+    }
+    // Publishes the new entries to the kernel.
+    __atomic_store_n(sq_tail_, sq_tail, __ATOMIC_RELEASE);
+
+    const int submitted =
+        syscall(__NR_io_uring_enter, ring_fd_, unsubmitted, /*min_complete=*/1,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (submitted >= 0) {
+      unsubmitted -= submitted;
+    } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      const int error = errno;
+      // Reads that the kernel has taken would still write into the callers'
+      // buffers after this returns, so only failing before any of them is
+      // recoverable.
+      CHECK_EQ(in_flight, unsubmitted)
+          << "io_uring_enter() failed with reads in flight: "
+          << strerror(error);
+      ring_status = IOError("io_uring_enter", error);
+      break;
+    }
+
+    unsigned cq_head = *cq_head_;
+    const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; cq_head != cq_tail; ++cq_head) {
+      const io_uring_cqe& cqe = cqes_[cq_head & cq_mask_];
+      const size_t i = cqe.user_data;
+      RandomAccessFile::ReadRequest& request = (*requests)[i];
+      --in_flight;
+      if (cqe.res > 0) {
+        bytes_read[i] += cqe.res;
+        // Reads the rest of a short read.
+        if (bytes_read[i] < request.n) pending.push_back(i);
+      } else if (cqe.res == 0) {
+        request.status =
+            Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+      } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+        pending.push_back(i);
+      } else {
+        request.status = IOError(filename, -cqe.res);
+      }
+    }
+    __atomic_store_n(cq_head_, cq_head, __ATOMIC_RELEASE);
+  }
+
+  for (size_t i = 0; i < num_requests; ++i) {
+    RandomAccessFile::ReadRequest& request = (*requests)[i];
+    if (!ring_status.ok() && request.status.ok() &&
+        bytes_read[i] < request.n) {
+      request.status = ring_status;
+    }
+    request.result = StringPiece(request.scratch, bytes_read[i]);
+  }
+  return ring_status;
+}
+
+}  // namespace
+
+bool IoUringReadBatch(int fd, const std::string& filename,
+                      std::vector<RandomAccessFile::ReadRequest>* requests) {
+  static std::atomic<bool> unsupported(false);
+  if (unsupported.load(std::memory_order_relaxed)) return false;
+  thread_local std::unique_ptr<IoUring> ring;
+  if (ring == nullptr) {
+    ring = IoUring::Create(kIoUringQueueDepth);
+    if (ring == nullptr) {
+      unsupported.store(true, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  if (!ring->ReadBatch(fd, filename, requests).ok()) {
+    ring.reset();
+  }
+  return true;
+}
+
+#else  // defined(TF_HAS_IO_URING)
+
+bool IoUringReadBatch(int fd, const std::string& filename,
+                      std::vector<RandomAccessFile::ReadRequest>* requests) {
+  return false;
+}
+
+#endif  // defined(TF_HAS_IO_URING)
+
+}  // namespace internal
+}  // namespace tensorflow
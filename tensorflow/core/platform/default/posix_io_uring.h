@@ -0,0 +1,46 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_DEFAULT_POSIX_IO_URING_H_
+#define TENSORFLOW_CORE_PLATFORM_DEFAULT_POSIX_IO_URING_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace internal {
+
+// Returns true if TF_POSIX_IO_URING is set, in which case the POSIX file
+// system reads batches of requests through io_uring when the kernel supports
+// it.
+bool IoUringRequested();
+
+// Reads `requests` from the file descriptor `fd` through an io_uring owned by
+// the calling thread, keeping up to the ring's queue depth of reads in flight.
+// Sets the result and status of every request as
+// `RandomAccessFile::Read()` would, and returns true.
+//
+// Returns false without reading anything if io_uring is not supported by this
+// build or by the kernel, in which case the caller should read the requests
+// another way.
+bool IoUringReadBatch(int fd, const std::string& filename,
+                      std::vector<RandomAccessFile::ReadRequest>* requests);
+
+}  // namespace internal
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_DEFAULT_POSIX_IO_URING_H_
@@ -90,6 +90,42 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadBatch) {
+  const string filename = io::JoinPath(BaseDir(), "read_batch");
+  const string input = CreateTestFile(env_, filename, 1 << 20);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_ASSERT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // Runs once with the default reads and once with io_uring, if available.
+  for (const bool io_uring : {false, true}) {
+    if (io_uring) setenv("TF_POSIX_IO_URING", "1", /*overwrite=*/1);
+    // More reads than the io_uring queue depth, and a last one past EOF.
+    constexpr int kNumReads = 200;
+    std::vector<string> scratch(kNumReads + 1);
+    std::vector<RandomAccessFile::ReadRequest> requests(kNumReads + 1);
+    for (int i = 0; i < kNumReads; ++i) {
+      requests[i].offset = (i * 7919) % (input.size() - 8192);
+      requests[i].n = 1 + (i * 131) % 8192;
+    }
+    requests[kNumReads].offset = input.size() - 10;
+    requests[kNumReads].n = 20;
+    for (int i = 0; i <= kNumReads; ++i) {
+      scratch[i].resize(requests[i].n);
+      requests[i].scratch = &scratch[i][0];
+    }
+
+    EXPECT_EQ(error::OUT_OF_RANGE, f->ReadBatch(&requests).code());
+    for (int i = 0; i < kNumReads; ++i) {
+      TF_EXPECT_OK(requests[i].status);
+      EXPECT_EQ(input.substr(requests[i].offset, requests[i].n),
+                requests[i].result);
+    }
+    EXPECT_EQ(error::OUT_OF_RANGE, requests[kNumReads].status.code());
+    EXPECT_EQ(input.substr(input.size() - 10), requests[kNumReads].result);
+    unsetenv("TF_POSIX_IO_URING");
+  }
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
@@ -441,6 +441,16 @@ string FileSystem::CreateURI(StringPiece scheme, StringPiece host,
   return strings::StrCat(scheme, "://", host, path);
 }
 
+Status RandomAccessFile::ReadBatch(std::vector<ReadRequest>* requests) const {
+  Status status;
+  for (ReadRequest& request : *requests) {
+    request.status =
+        Read(request.offset, request.n, &request.result, request.scratch);
+    status.Update(request.status);
+  }
+  return status;
+}
+
 std::string FileSystem::DecodeTransaction(const TransactionToken* token) {
   // TODO(sami): Switch using StrCat when void* is supported
   if (token) {
@@ -769,6 +769,31 @@ class RandomAccessFile {
   virtual tensorflow::Status Read(uint64 offset, size_t n, StringPiece* result,
                                   char* scratch) const = 0;
 
+  /// \brief A read issued through `ReadBatch()`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// `scratch[0..n-1]` may be written by `ReadBatch()`.
+    char* scratch = nullptr;
+
+    /// Set by `ReadBatch()` as `Read()` sets its `result` and return value.
+    StringPiece result;
+    tensorflow::Status status;
+  };
+
+  /// \brief Reads every request in `*requests`.
+  ///
+  /// Each request behaves like `Read(offset, n, &result, scratch)`, but
+  /// implementations may keep all of them in flight at once, so that a few
+  /// threads can saturate storage that needs many concurrent reads. The
+  /// default implementation reads the requests one after the other.
+  ///
+  /// Returns the status of the first request that failed, or OK.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual tensorflow::Status ReadBatch(
+      std::vector<ReadRequest>* requests) const;
+
 #if defined(TF_CORD_SUPPORT)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
   virtual tensorflow::Status Read(uint64 offset, size_t n,
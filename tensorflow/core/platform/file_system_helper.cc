@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/platform/file_system_helper.h"
 
+#include <algorithm>
+#include <cstring>
 #include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
@@ -265,5 +269,84 @@ Status GetMatchingPaths(FileSystem* fs, Env* env, const string& pattern,
   return Status::OK();
 }
 
+namespace {
+
+// One RandomAccessFile::Read() of CoalescedReadBatch(), covering one or more
+// requests.
+struct MergedRead {
+  uint64 offset;
+  uint64 size;
+  std::vector<RandomAccessFile::ReadRequest*> requests;
+};
+
+void ExecuteMergedRead(const RandomAccessFile& file, const MergedRead& read) {
+  if (read.requests.size() == 1) {
+    RandomAccessFile::ReadRequest* request = read.requests[0];
+    request->status = file.Read(request->offset, request->n, &request->result,
+                                request->scratch);
+    return;
+  }
+  std::unique_ptr<char[]> buffer(new char[read.size]);
+  StringPiece data;
+  const Status status = file.Read(read.offset, read.size, &data, buffer.get());
+  // At EOF, the requests that end before it still succeed.
+  const bool data_valid = status.ok() || errors::IsOutOfRange(status);
+  for (RandomAccessFile::ReadRequest* request : read.requests) {
+    const uint64 begin = request->offset - read.offset;
+    size_t available = 0;
+    if (data_valid && data.size() > begin) {
+      available = std::min<uint64>(data.size() - begin, request->n);
+      memcpy(request->scratch, data.data() + begin, available);
+    }
+    request->result = StringPiece(request->scratch, available);
+    request->status = available == request->n ? Status::OK() : status;
+  }
+}
+
+}  // namespace
+
+Status CoalescedReadBatch(
+    const RandomAccessFile& file, uint64 max_gap_bytes, uint64 max_read_bytes,
+    std::vector<RandomAccessFile::ReadRequest>* requests) {
+  std::vector<RandomAccessFile::ReadRequest*> sorted;
+  sorted.reserve(requests->size());
+  for (RandomAccessFile::ReadRequest& request : *requests) {
+    sorted.push_back(&request);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const RandomAccessFile::ReadRequest* a,
+               const RandomAccessFile::ReadRequest* b) {
+              return a->offset < b->offset;
+            });
+  std::vector<MergedRead> reads;
+  for (RandomAccessFile::ReadRequest* request : sorted) {
+    const uint64 end = request->offset + request->n;
+    if (!reads.empty()) {
+      MergedRead& last = reads.back();
+      const uint64 last_end = last.offset + last.size;
+      const uint64 merged_end = std::max(end, last_end);
+      if (request->offset <= last_end + max_gap_bytes &&
+          merged_end - last.offset <= max_read_bytes) {
+        last.size = merged_end - last.offset;
+        last.requests.push_back(request);
+        continue;
+      }
+    }
+    reads.push_back({request->offset, request->n, {request}});
+  }
+
+  if (reads.size() == 1) {
+    ExecuteMergedRead(file, reads[0]);
+  } else if (reads.size() > 1) {
+    ForEach(0, reads.size(),
+            [&file, &reads](int i) { ExecuteMergedRead(file, reads[i]); });
+  }
+  Status status;
+  for (const RandomAccessFile::ReadRequest& request : *requests) {
+    status.Update(request.status);
+  }
+  return status;
+}
+
 }  // namespace internal
 }  // namespace tensorflow
@@ -19,7 +19,9 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
@@ -45,6 +47,20 @@ namespace internal {
 Status GetMatchingPaths(FileSystem* fs, Env* env, const string& pattern,
                         std::vector<string>* results);
 
+// Reads `requests` from `file` with few, concurrent calls to
+// RandomAccessFile::Read().
+//
+// This helper may be used by implementations of RandomAccessFile::ReadBatch()
+// whose reads have a high fixed cost, such as a network round trip. Requests
+// whose ranges are at most `max_gap_bytes` apart are merged into one read of
+// at most `max_read_bytes`, and the merged reads run in parallel (except on
+// iOS).
+//
+// Returns the status of the first request that failed, or OK.
+Status CoalescedReadBatch(const RandomAccessFile& file, uint64 max_gap_bytes,
+                          uint64 max_read_bytes,
+                          std::vector<RandomAccessFile::ReadRequest>* requests);
+
 }  // namespace internal
 }  // namespace tensorflow
 
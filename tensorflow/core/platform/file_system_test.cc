@@ -18,6 +18,8 @@ limitations under the License.
 #include <sys/stat.h>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/file_system_helper.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/null_file_system.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/str_util.h"
@@ -306,4 +308,82 @@ TEST(TestFileSystemTest, RootDirectory) {
   EXPECT_EQ("./test", results[0]);
 }
 
+// A file of the bytes 0, 1, 2, ... that counts its reads.
+class CountingRandomAccessFile : public RandomAccessFile {
+ public:
+  explicit CountingRandomAccessFile(size_t size) : size_(size) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    {
+      mutex_lock l(mu_);
+      ++num_reads_;
+    }
+    const size_t available = offset < size_ ? std::min(n, size_ - offset) : 0;
+    for (size_t i = 0; i < available; ++i) {
+      scratch[i] = static_cast<char>(offset + i);
+    }
+    *result = StringPiece(scratch, available);
+    if (available < n) {
+      return errors::OutOfRange("Read less bytes than requested");
+    }
+    return Status::OK();
+  }
+
+  int num_reads() const {
+    mutex_lock l(mu_);
+    return num_reads_;
+  }
+
+ private:
+  const size_t size_;
+  mutable mutex mu_;
+  mutable int num_reads_ TF_GUARDED_BY(mu_) = 0;
+};
+
+TEST(CoalescedReadBatchTest, MergesNearbyRequests) {
+  CountingRandomAccessFile file(1000);
+  // Two groups of nearby reads, [0, 30) and [500, 520), out of order and with
+  // one past EOF.
+  const std::vector<std::pair<uint64, size_t>> ranges = {
+      {500, 10}, {0, 10}, {15, 15}, {5, 10}, {990, 30}};
+  std::vector<string> scratch(ranges.size());
+  std::vector<RandomAccessFile::ReadRequest> requests(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    requests[i].offset = ranges[i].first;
+    requests[i].n = ranges[i].second;
+    scratch[i].resize(requests[i].n);
+    requests[i].scratch = &scratch[i][0];
+  }
+
+  EXPECT_TRUE(errors::IsOutOfRange(internal::CoalescedReadBatch(
+      file, /*max_gap_bytes=*/10, /*max_read_bytes=*/100, &requests)));
+  EXPECT_EQ(3, file.num_reads());
+  for (size_t i = 0; i + 1 < requests.size(); ++i) {
+    TF_EXPECT_OK(requests[i].status);
+    ASSERT_EQ(requests[i].n, requests[i].result.size());
+    for (size_t j = 0; j < requests[i].n; ++j) {
+      EXPECT_EQ(static_cast<char>(requests[i].offset + j),
+                requests[i].result[j]);
+    }
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(requests.back().status));
+  EXPECT_EQ(10, requests.back().result.size());
+}
+
+TEST(CoalescedReadBatchTest, RespectsMaxReadBytes) {
+  CountingRandomAccessFile file(1000);
+  std::vector<string> scratch(10, string(10, '\0'));
+  std::vector<RandomAccessFile::ReadRequest> requests(10);
+  for (int i = 0; i < 10; ++i) {
+    requests[i].offset = i * 10;
+    requests[i].n = 10;
+    requests[i].scratch = &scratch[i][0];
+  }
+  TF_EXPECT_OK(internal::CoalescedReadBatch(
+      file, /*max_gap_bytes=*/0, /*max_read_bytes=*/30, &requests));
+  EXPECT_EQ(4, file.num_reads());
+  EXPECT_EQ(90, requests[9].result[0]);
+}
+
 }  // namespace tensorflow
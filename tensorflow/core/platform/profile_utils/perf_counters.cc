@@ -0,0 +1,115 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
+
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+#if defined(__linux__)
+
+namespace {
+
+int OpenPerfEvent(uint64 config) {
+  perf_event_attr pe;
+  memset(&pe, 0, sizeof(perf_event_attr));
+  pe.type = PERF_TYPE_HARDWARE;
+  pe.size = sizeof(perf_event_attr);
+  pe.config = config;
+  pe.disabled = 1;
+  pe.inherit = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv = 1;
+  pe.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(__NR_perf_event_open, &pe, /*pid=*/0, /*cpu=*/-1,
+                 /*group_fd=*/-1, /*flags=*/0);
+}
+
+int64_t ReadPerfEvent(int fd) {
+  // The value, the time enabled and the time running, see read_format.
+  uint64 values[3] = {0, 0, 0};
+  if (read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(static_cast<double>(values[0]) * values[1] /
+                              values[2]);
+}
+
+}  // namespace
+
+/*static*/ std::unique_ptr<PerfCounters> PerfCounters::Create() {
+  std::vector<int> fds;
+  for (uint64 config : {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                        PERF_COUNT_HW_CACHE_MISSES}) {
+    const int fd = OpenPerfEvent(config);
+    if (fd < 0) {
+      VLOG(1) << "Hardware performance counters are not available: "
+              << strerror(errno);
+      for (int open_fd : fds) close(open_fd);
+      return nullptr;
+    }
+    fds.push_back(fd);
+  }
+  return std::unique_ptr<PerfCounters>(new PerfCounters(std::move(fds)));
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) close(fd);
+}
+
+void PerfCounters::Start() {
+  for (int fd : fds_) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+PerfCounters::Values PerfCounters::Stop() {
+  for (int fd : fds_) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  Values values;
+  values.cycles = ReadPerfEvent(fds_[0]);
+  values.instructions = ReadPerfEvent(fds_[1]);
+  values.cache_misses = ReadPerfEvent(fds_[2]);
+  return values;
+}
+
+#else  // !defined(__linux__)
+
+/*static*/ std::unique_ptr<PerfCounters> PerfCounters::Create() {
+  return nullptr;
+}
+
+PerfCounters::~PerfCounters() {}
+
+void PerfCounters::Start() {}
+
+PerfCounters::Values PerfCounters::Stop() { return Values(); }
+
+#endif  // defined(__linux__)
+
+}  // namespace profile_utils
+}  // namespace tensorflow
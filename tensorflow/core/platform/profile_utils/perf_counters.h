@@ -0,0 +1,72 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PLATFORM_PROFILE_UTILS_PERF_COUNTERS_H_
+#define TENSORFLOW_CORE_PLATFORM_PROFILE_UTILS_PERF_COUNTERS_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+// Counts hardware events with perf_event_open(2), for benchmarks.
+//
+// The events of the thread calling Create() are counted, as well as those of
+// the threads it creates afterwards, so that the counters cover the
+// threadpools of a benchmark when they are created before the threadpools.
+class PerfCounters {
+ public:
+  struct Values {
+    int64_t cycles = 0;
+    int64_t instructions = 0;
+    // Usually the last level cache misses, see PERF_COUNT_HW_CACHE_MISSES.
+    int64_t cache_misses = 0;
+
+    // Instructions per cycle.
+    double Ipc() const {
+      return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+    }
+  };
+
+  // Returns nullptr if the counters are not supported on this platform or
+  // not permitted, e.g. by /proc/sys/kernel/perf_event_paranoid.
+  static std::unique_ptr<PerfCounters> Create();
+
+  ~PerfCounters();
+
+  // Resets the counters and starts counting.
+  void Start();
+
+  // Stops counting, and returns the events counted since Start(). The counts
+  // are scaled up when the kernel multiplexed the counters.
+  Values Stop();
+
+ private:
+  explicit PerfCounters(std::vector<int> fds) : fds_(std::move(fds)) {}
+
+  // One file descriptor per field of Values, in order.
+  const std::vector<int> fds_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerfCounters);
+};
+
+}  // namespace profile_utils
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_PROFILE_UTILS_PERF_COUNTERS_H_
@@ -0,0 +1,50 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/platform/profile_utils/perf_counters.h"
+
+#include <memory>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace profile_utils {
+namespace {
+
+TEST(PerfCountersTest, CountsWork) {
+  std::unique_ptr<PerfCounters> counters = PerfCounters::Create();
+  if (counters == nullptr) {
+    LOG(INFO) << "Skipping the test, perf counters are not available.";
+    return;
+  }
+  counters->Start();
+  int64_t sum = 0;
+  for (int i = 0; i < 1000000; ++i) {
+    sum += i;
+    testing::DoNotOptimize(sum);
+  }
+  const PerfCounters::Values values = counters->Stop();
+  EXPECT_GT(values.instructions, 1000000);
+  EXPECT_GE(values.cache_misses, 0);
+  // Cycles may not be counted by some virtual machines.
+  if (values.cycles > 0) {
+    EXPECT_GT(values.Ipc(), 0.0);
+  }
+}
+
+}  // namespace
+}  // namespace profile_utils
+}  // namespace tensorflow
@@ -83,7 +83,12 @@ class TraceMeRecorder {
   // Starts recording of TraceMe().
   // Only traces <= level will be recorded.
   // Level must be >= 0. If level is 0, no traces will be recorded.
-  static bool Start(int level) { return Get()->StartRecording(level); }
+  // If max_events_per_thread is positive, each thread records at most that
+  // many events until Stop() and drops the rest, which bounds the memory used
+  // by the recorder.
+  static bool Start(int level, int64_t max_events_per_thread = 0) {
+    return Get()->StartRecording(level, max_events_per_thread);
+  }
 
   // Stops recording and returns events recorded since Start().
   // Events passed to Record after Stop has started will be dropped.
@@ -117,7 +122,7 @@ class TraceMeRecorder {
   void RegisterThread(uint32 tid, std::shared_ptr<ThreadLocalRecorder> thread);
   void UnregisterThread(uint32 tid);
 
-  bool StartRecording(int level);
+  bool StartRecording(int level, int64_t max_events_per_thread);
   Events StopRecording();
 
   // Clears events from all active threads that were added due to Record
@@ -0,0 +1,123 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/convert/xplane_to_op_metrics_db.h"
+#include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+
+/*static*/ std::unique_ptr<SamplingProfiler> SamplingProfiler::Create(
+    const SamplingProfilerOptions& options) {
+  return absl::WrapUnique(new SamplingProfiler(options));
+}
+
+SamplingProfiler::SamplingProfiler(const SamplingProfilerOptions& options)
+    : options_(options),
+      op_metrics_db_combiner_(
+          absl::make_unique<OpMetricsDbCombiner>(&op_metrics_db_)) {
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "sampling_profiler", [this]() { Run(); }));
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  {
+    mutex_lock l(mu_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  thread_.reset();
+}
+
+void SamplingProfiler::Run() {
+  Env* env = Env::Default();
+  const int64_t idle_ms =
+      std::max<int64_t>(options_.sampling_period - 1, 0) *
+      options_.sample_duration_ms;
+  uint64 next_export_micros =
+      env->NowMicros() + options_.export_interval_ms * 1000;
+  while (!WaitForStop(idle_ms)) {
+    Sample();
+    const uint64 now_micros = env->NowMicros();
+    if (now_micros >= next_export_micros) {
+      Export();
+      next_export_micros = now_micros + options_.export_interval_ms * 1000;
+    }
+  }
+  Export();
+}
+
+void SamplingProfiler::Sample() {
+  if (!AcquireProfilerLock()) {
+    VLOG(1) << "Skipping a sample while another profiler session is active.";
+    return;
+  }
+  // All TraceMe captured have a timestamp greater or equal to
+  // start_timestamp_ns, see HostTracer::Start.
+  const uint64 start_timestamp_ns = GetCurrentTimeNanos();
+  if (!TraceMeRecorder::Start(options_.host_tracer_level,
+                              options_.max_events_per_thread)) {
+    ReleaseProfilerLock();
+    return;
+  }
+  WaitForStop(options_.sample_duration_ms);
+  TraceMeRecorder::Events events = TraceMeRecorder::Stop();
+  ReleaseProfilerLock();
+
+  XPlane plane;
+  ConvertCompleteEventsToXPlane(start_timestamp_ns, std::move(events), &plane);
+  op_metrics_db_combiner_->Combine(
+      ConvertHostThreadsXPlaneToOpMetricsDb(plane));
+  ++num_samples_;
+}
+
+void SamplingProfiler::Export() {
+  if (num_samples_ > 0 && options_.export_fn) {
+    VLOG(1) << "Exporting the op metrics of " << num_samples_ << " samples.";
+    options_.export_fn(op_metrics_db_);
+  }
+  // The combiner indexes the metrics of the database, so it is reset first.
+  op_metrics_db_combiner_.reset();
+  op_metrics_db_.Clear();
+  op_metrics_db_combiner_ =
+      absl::make_unique<OpMetricsDbCombiner>(&op_metrics_db_);
+  num_samples_ = 0;
+}
+
+bool SamplingProfiler::WaitForStop(int64_t duration_ms) {
+  Env* env = Env::Default();
+  const uint64 deadline_micros = env->NowMicros() + duration_ms * 1000;
+  mutex_lock l(mu_);
+  while (!stopped_) {
+    const uint64 now_micros = env->NowMicros();
+    if (now_micros >= deadline_micros) break;
+    cv_.wait_for(l, std::chrono::microseconds(deadline_micros - now_micros));
+  }
+  return stopped_;
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/convert/op_metrics_db_combiner.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+struct SamplingProfilerOptions {
+  // Host traces with a level <= host_tracer_level are recorded, see
+  // ProfileOptions::host_tracer_level.
+  int host_tracer_level = 2;
+
+  // Each sample records host traces for sample_duration_ms.
+  int64_t sample_duration_ms = 100;
+
+  // One sample is taken every sampling_period sample durations, so host
+  // tracing is on for 1 / sampling_period of the time.
+  int64_t sampling_period = 100;
+
+  // Each thread records at most max_events_per_thread events per sample and
+  // drops the rest.
+  int64_t max_events_per_thread = 1 << 16;
+
+  // The op metrics of the samples are exported every export_interval_ms.
+  int64_t export_interval_ms = 60 * 1000;
+
+  // Called on the profiler's thread with the combined op metrics of the
+  // samples taken since the previous call. The times only cover the samples,
+  // i.e. about 1 / sampling_period of the export interval.
+  std::function<void(const OpMetricsDb&)> export_fn;
+};
+
+// Continuously samples host traces at a low overhead, to find regressions in
+// production servers rather than to capture them on demand like a
+// ProfilerSession. Host tracing is only on during the samples, so most TraceMe
+// are skipped at the cost of checking the trace level, the events recorded by
+// each thread during a sample are bounded, and the events are converted to op
+// metrics after each sample.
+//
+// Samples are skipped while another profiler session is active, and other
+// profiler sessions can't start while a sample is taken.
+class SamplingProfiler {
+ public:
+  // Starts taking samples on a background thread.
+  static std::unique_ptr<SamplingProfiler> Create(
+      const SamplingProfilerOptions& options);
+
+  // Stops taking samples and exports the op metrics not exported yet.
+  ~SamplingProfiler();
+
+ private:
+  explicit SamplingProfiler(const SamplingProfilerOptions& options);
+
+  // Takes samples and exports their op metrics until stopped.
+  void Run();
+
+  // Takes one sample and combines its op metrics into op_metrics_db_.
+  void Sample();
+
+  // Exports op_metrics_db_ and starts combining a new one.
+  void Export();
+
+  // Waits for up to `duration_ms`, and returns whether sampling stops.
+  bool WaitForStop(int64_t duration_ms);
+
+  const SamplingProfilerOptions options_;
+
+  mutex mu_;
+  condition_variable cv_;
+  bool stopped_ TF_GUARDED_BY(mu_) = false;
+
+  // Only accessed by the profiler's thread.
+  OpMetricsDb op_metrics_db_;
+  std::unique_ptr<OpMetricsDbCombiner> op_metrics_db_combiner_;
+  int64_t num_samples_ = 0;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
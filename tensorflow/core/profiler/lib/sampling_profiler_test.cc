@@ -0,0 +1,78 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include <atomic>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+TEST(SamplingProfilerTest, ExportsOpMetrics) {
+  std::atomic<int64_t> num_exports(0);
+  std::atomic<int64_t> matmul_occurrences(0);
+  SamplingProfilerOptions options;
+  options.sample_duration_ms = 10;
+  options.sampling_period = 1;
+  options.export_interval_ms = 0;
+  options.export_fn = [&](const OpMetricsDb& op_metrics_db) {
+    ++num_exports;
+    for (const OpMetrics& metrics : op_metrics_db.metrics_db()) {
+      if (metrics.name() == "matmul" && metrics.category() == "MatMul") {
+        matmul_occurrences += metrics.occurrences();
+      }
+    }
+  };
+  std::unique_ptr<SamplingProfiler> profiler =
+      SamplingProfiler::Create(options);
+
+  // Runs ops until a sample has recorded one.
+  for (int i = 0; i < 100000 && matmul_occurrences == 0; ++i) {
+    TraceMe trace_me("matmul:MatMul");
+    Env::Default()->SleepForMicroseconds(10);
+  }
+  profiler.reset();
+  EXPECT_GT(num_exports, 0);
+  EXPECT_GT(matmul_occurrences, 0);
+}
+
+TEST(SamplingProfilerTest, SkipsSamplesWhileAnotherSessionIsActive) {
+  ASSERT_TRUE(AcquireProfilerLock());
+  std::atomic<int64_t> num_exports(0);
+  SamplingProfilerOptions options;
+  options.sample_duration_ms = 1;
+  options.sampling_period = 1;
+  options.export_interval_ms = 0;
+  options.export_fn = [&](const OpMetricsDb& op_metrics_db) { ++num_exports; };
+  std::unique_ptr<SamplingProfiler> profiler =
+      SamplingProfiler::Create(options);
+  Env::Default()->SleepForMicroseconds(50 * 1000);
+  profiler.reset();
+  ReleaseProfilerLock();
+
+  EXPECT_EQ(num_exports, 0);
+  // The recorder was not started by the profiler.
+  EXPECT_FALSE(TraceMe::Active());
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
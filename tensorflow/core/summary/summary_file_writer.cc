@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -29,13 +32,24 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-class SummaryFileWriter : public SummaryWriterInterface {
+// Returns the tags of the summary values of `event`, in order.
+std::vector<string> SummaryTags(const Event& event) {
+  std::vector<string> tags;
+  for (const Summary::Value& value : event.summary().value()) {
+    tags.push_back(value.tag());
+  }
+  return tags;
+}
+
+class SummaryFileWriter : public SummaryFileWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
-      : SummaryWriterInterface(),
+  SummaryFileWriter(const SummaryFileWriterOptions& options, Env* env)
+      : SummaryFileWriterInterface(),
         is_initialized_(false),
-        max_queue_(max_queue),
-        flush_millis_(flush_millis),
+        max_queue_(options.max_queue),
+        flush_millis_(options.flush_millis),
+        async_(options.async),
+        overflow_policy_(options.overflow_policy),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -55,17 +69,26 @@ class SummaryFileWriter : public SummaryWriterInterface {
     const string uniquified_filename_suffix = absl::StrCat(
         ".", pid, ".", file_id_counter.fetch_add(1), sep, filename_suffix);
     mutex_lock ml(mu_);
-    events_writer_ =
-        tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+    events_writer_ = tensorflow::MakeUnique<EventsWriter>(
+        io::JoinPath(logdir, "events"), env_);
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
         events_writer_->InitWithSuffix(uniquified_filename_suffix),
         "Could not initialize events writer.");
     last_flush_ = env_->NowMicros();
     is_initialized_ = true;
+    if (async_) {
+      {
+        mutex_lock l(queue_mu_);
+        last_batch_micros_ = last_flush_;
+      }
+      thread_.reset(env_->StartThread(ThreadOptions(), "summary_file_writer",
+                                      [this]() { WriterLoop(); }));
+    }
     return Status::OK();
   }
 
   Status Flush() override {
+    if (thread_ != nullptr) return FlushQueue();
     mutex_lock ml(mu_);
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
@@ -74,9 +97,32 @@ class SummaryFileWriter : public SummaryWriterInterface {
   }
 
   ~SummaryFileWriter() override {
+    if (thread_ != nullptr) {
+      {
+        mutex_lock l(queue_mu_);
+        shutdown_ = true;
+        work_cv_.notify_all();
+      }
+      // Joins the thread, which writes the queued events first.
+      thread_.reset();
+    }
     (void)Flush();  // Ignore errors.
   }
 
+  SummaryFileWriterStats GetStats() override {
+    SummaryFileWriterStats stats;
+    if (async_) {
+      mutex_lock l(queue_mu_);
+      stats.queue_depth = pending_.size() + num_writing_events_;
+      stats.num_dropped_events = num_dropped_events_;
+      stats.num_coalesced_events = num_coalesced_events_;
+    } else {
+      mutex_lock ml(mu_);
+      stats.queue_depth = queue_.size();
+    }
+    return stats;
+  }
+
   Status WriteTensor(int64_t global_step, Tensor t, const string& tag,
                      const string& serialized_metadata) override {
     std::unique_ptr<Event> e{new Event};
@@ -150,6 +196,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
   }
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
+    if (async_) return EnqueueEvent(std::move(event));
     mutex_lock ml(mu_);
     queue_.emplace_back(std::move(event));
     if (queue_.size() > max_queue_ ||
@@ -166,6 +213,118 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
+  // The number of events an asynchronous writer queues for its thread.
+  size_t QueueCapacity() const { return std::max(max_queue_, 1); }
+
+  Status EnqueueEvent(std::unique_ptr<Event> event) {
+    mutex_lock l(queue_mu_);
+    // Errors of the background thread are reported once.
+    const Status status = unreported_status_;
+    unreported_status_ = Status::OK();
+    if (pending_.size() >= QueueCapacity()) {
+      switch (overflow_policy_) {
+        case SummaryQueueOverflowPolicy::kBlock:
+          while (pending_.size() >= QueueCapacity()) {
+            room_cv_.wait(l);
+          }
+          break;
+        case SummaryQueueOverflowPolicy::kDropNewest:
+          ++num_dropped_events_;
+          return status;
+        case SummaryQueueOverflowPolicy::kCoalesce:
+          if (ReplaceQueuedEvent(&event)) {
+            ++num_coalesced_events_;
+            return status;
+          }
+          TF_FALLTHROUGH_INTENDED;
+        case SummaryQueueOverflowPolicy::kDropOldest:
+          pending_.pop_front();
+          ++num_dropped_events_;
+          break;
+      }
+    }
+    pending_.push_back(std::move(event));
+    // The thread writes full batches, and otherwise flushes every
+    // flush_millis_.
+    if (pending_.size() >= QueueCapacity()) work_cv_.notify_all();
+    return status;
+  }
+
+  // Replaces the last queued event with the same summary tags as `event`.
+  bool ReplaceQueuedEvent(std::unique_ptr<Event>* event)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(queue_mu_) {
+    if (!(*event)->has_summary()) return false;
+    const std::vector<string> tags = SummaryTags(**event);
+    for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+      if ((*it)->has_summary() && SummaryTags(**it) == tags) {
+        *it = std::move(*event);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Status FlushQueue() {
+    mutex_lock l(queue_mu_);
+    const int64_t request = ++num_flush_requests_;
+    work_cv_.notify_all();
+    while (num_flushes_done_ < request) {
+      done_cv_.wait(l);
+    }
+    const Status status = unreported_status_;
+    unreported_status_ = Status::OK();
+    return status;
+  }
+
+  // Waits for a batch of events, appends it to the events file and flushes
+  // the file, until the writer is destroyed.
+  void WriterLoop() {
+    while (true) {
+      std::deque<std::unique_ptr<Event>> batch;
+      int64_t flush_request;
+      bool shutdown;
+      {
+        mutex_lock l(queue_mu_);
+        while (!shutdown_ && pending_.size() < QueueCapacity() &&
+               num_flushes_done_ == num_flush_requests_) {
+          if (pending_.empty()) {
+            work_cv_.wait(l);
+            continue;
+          }
+          const int64_t elapsed_millis =
+              (env_->NowMicros() - last_batch_micros_) / 1000;
+          if (elapsed_millis >= flush_millis_) break;
+          WaitForMilliseconds(&l, &work_cv_, flush_millis_ - elapsed_millis);
+        }
+        batch.swap(pending_);
+        num_writing_events_ = batch.size();
+        flush_request = num_flush_requests_;
+        shutdown = shutdown_;
+        room_cv_.notify_all();
+      }
+
+      Status status;
+      {
+        mutex_lock ml(mu_);
+        for (std::unique_ptr<Event>& e : batch) {
+          queue_.push_back(std::move(e));
+        }
+        status = InternalFlush();
+      }
+      if (!status.ok()) {
+        LOG(ERROR) << "Could not write summaries: " << status;
+      }
+
+      mutex_lock l(queue_mu_);
+      num_writing_events_ = 0;
+      last_batch_micros_ = env_->NowMicros();
+      unreported_status_.Update(status);
+      num_flushes_done_ = flush_request;
+      done_cv_.notify_all();
+      if (shutdown && pending_.empty()) return;
+    }
+  }
+
   Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     for (const std::unique_ptr<Event>& e : queue_) {
       events_writer_->WriteEvent(*e);
@@ -180,6 +339,8 @@ class SummaryFileWriter : public SummaryWriterInterface {
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
+  const bool async_;
+  const SummaryQueueOverflowPolicy overflow_policy_;
   uint64 last_flush_;
   Env* env_;
   mutex mu_;
@@ -188,6 +349,23 @@ class SummaryFileWriter : public SummaryWriterInterface {
   std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(mu_);
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       TF_GUARDED_BY(mu_);
+
+  // The queue of an asynchronous writer, handed over to `thread_` in batches.
+  // Writing a batch takes mu_ while holding no lock on queue_mu_.
+  mutex queue_mu_;
+  condition_variable work_cv_;
+  condition_variable room_cv_;
+  condition_variable done_cv_;
+  std::deque<std::unique_ptr<Event>> pending_ TF_GUARDED_BY(queue_mu_);
+  int64_t num_writing_events_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_dropped_events_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_coalesced_events_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_flush_requests_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_flushes_done_ TF_GUARDED_BY(queue_mu_) = 0;
+  uint64 last_batch_micros_ TF_GUARDED_BY(queue_mu_) = 0;
+  Status unreported_status_ TF_GUARDED_BY(queue_mu_);
+  bool shutdown_ TF_GUARDED_BY(queue_mu_) = false;
+  std::unique_ptr<Thread> thread_;
 };
 
 }  // namespace
@@ -196,7 +374,21 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  SummaryFileWriterOptions options;
+  options.max_queue = max_queue;
+  options.flush_millis = flush_millis;
+  SummaryFileWriterInterface* w = nullptr;
+  const Status s =
+      CreateSummaryFileWriter(options, logdir, filename_suffix, env, &w);
+  *result = w;
+  return s;
+}
+
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryFileWriterInterface** result) {
+  SummaryFileWriter* w = new SummaryFileWriter(options, env);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
@@ -38,6 +38,61 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result);
 
+/// \brief What an asynchronous summary file writer does with an event written
+/// while its queue is full.
+enum class SummaryQueueOverflowPolicy {
+  /// Waits for the background thread to make room.
+  kBlock,
+  /// Drops the new event.
+  kDropNewest,
+  /// Drops the oldest queued event.
+  kDropOldest,
+  /// Replaces the last queued event with the same summary tags, such as the
+  /// previous value of a scalar, or drops the oldest one if there is none.
+  kCoalesce,
+};
+
+/// \brief Options of a summary file writer.
+struct SummaryFileWriterOptions {
+  /// The number of events queued before they are flushed.
+  int max_queue = 10;
+  /// The maximum time between flushes.
+  int flush_millis = 120000;
+  /// Whether the events are serialized, appended and flushed on a background
+  /// thread, so that the summary ops only wait for the remote file systems
+  /// when Flush is called.
+  bool async = false;
+  /// How an asynchronous writer treats events once `max_queue` of them are
+  /// waiting for the background thread.
+  SummaryQueueOverflowPolicy overflow_policy =
+      SummaryQueueOverflowPolicy::kBlock;
+};
+
+/// \brief Counters of the queue of a summary file writer.
+struct SummaryFileWriterStats {
+  /// The events written but not appended to the events file yet.
+  int64_t queue_depth = 0;
+  /// The events dropped because the queue was full.
+  int64_t num_dropped_events = 0;
+  /// The events that replaced a queued event because the queue was full.
+  int64_t num_coalesced_events = 0;
+};
+
+/// \brief A summary writer appending to an events file.
+class SummaryFileWriterInterface : public SummaryWriterInterface {
+ public:
+  virtual SummaryFileWriterStats GetStats() = 0;
+};
+
+/// \brief Creates a summary file writer configured by `options`.
+///
+/// Like the function above otherwise. The errors of the background thread of
+/// an asynchronous writer are returned by the next write or flush.
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryFileWriterInterface** result);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_SUMMARY_SUMMARY_FILE_WRITER_H_
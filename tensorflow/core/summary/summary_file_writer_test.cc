@@ -20,9 +20,12 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/util/event.pb.h"
 
@@ -40,6 +43,94 @@ class FakeClockEnv : public EnvWrapper {
   uint64 current_millis_;
 };
 
+// Holds the syncs of the files it creates while it is closed, to keep the
+// thread of an asynchronous writer busy.
+class SyncGateEnv : public FakeClockEnv {
+ public:
+  // The files are all created in the test directory.
+  SyncGateEnv() {
+    FileSystem* file_system;
+    TF_CHECK_OK(
+        FakeClockEnv::GetFileSystemForFile(testing::TmpDir(), &file_system));
+    file_system_.reset(new GatedFileSystem(this, file_system));
+  }
+
+  Status GetFileSystemForFile(const std::string& fname,
+                              FileSystem** result) override {
+    *result = file_system_.get();
+    return Status::OK();
+  }
+
+  void Close() {
+    mutex_lock l(mu_);
+    open_ = false;
+  }
+
+  void Open() {
+    mutex_lock l(mu_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+  // Waits for a sync to be held.
+  void WaitForHeldSync() {
+    mutex_lock l(mu_);
+    while (num_held_syncs_ == 0) cv_.wait(l);
+  }
+
+ private:
+  class GatedFile : public WritableFile {
+   public:
+    GatedFile(SyncGateEnv* env, std::unique_ptr<WritableFile> file)
+        : env_(env), file_(std::move(file)) {}
+    Status Append(StringPiece data) override { return file_->Append(data); }
+    Status Close() override { return file_->Close(); }
+    Status Flush() override { return file_->Flush(); }
+    Status Name(StringPiece* result) const override {
+      return file_->Name(result);
+    }
+    Status Sync() override {
+      env_->PassGate();
+      return file_->Sync();
+    }
+    Status Tell(int64_t* position) override { return file_->Tell(position); }
+
+   private:
+    SyncGateEnv* const env_;
+    std::unique_ptr<WritableFile> file_;
+  };
+
+  class GatedFileSystem : public WrappedFileSystem {
+   public:
+    GatedFileSystem(SyncGateEnv* env, FileSystem* file_system)
+        : WrappedFileSystem(file_system, nullptr), env_(env) {}
+    Status NewWritableFile(const std::string& fname, TransactionToken* token,
+                           std::unique_ptr<WritableFile>* result) override {
+      TF_RETURN_IF_ERROR(
+          WrappedFileSystem::NewWritableFile(fname, token, result));
+      result->reset(new GatedFile(env_, std::move(*result)));
+      return Status::OK();
+    }
+
+   private:
+    SyncGateEnv* const env_;
+  };
+
+  void PassGate() {
+    mutex_lock l(mu_);
+    ++num_held_syncs_;
+    cv_.notify_all();
+    while (!open_) cv_.wait(l);
+    --num_held_syncs_;
+  }
+
+  std::unique_ptr<GatedFileSystem> file_system_;
+  mutex mu_;
+  condition_variable cv_;
+  bool open_ = true;
+  int num_held_syncs_ = 0;
+};
+
 class SummaryFileWriterTest : public ::testing::Test {
  protected:
   Status SummaryTestHelper(
@@ -281,5 +372,159 @@ TEST_F(SummaryFileWriterTest, AvoidFilenameCollision) {
       << "files = [" << absl::StrJoin(files, ", ") << "]";
 }
 
+class AsyncSummaryFileWriterTest : public ::testing::Test {
+ protected:
+  SummaryFileWriterInterface* CreateWriter(const string& test_name,
+                                           SummaryQueueOverflowPolicy policy) {
+    SummaryFileWriterOptions options;
+    options.max_queue = 1;
+    // Only full batches and explicit flushes are written.
+    options.flush_millis = 1000000;
+    options.async = true;
+    options.overflow_policy = policy;
+    SummaryFileWriterInterface* writer;
+    TF_CHECK_OK(CreateSummaryFileWriter(options, testing::TmpDir(), test_name,
+                                        &env_, &writer));
+    return writer;
+  }
+
+  // Writes the first event and waits for the thread to hold its flush, so that
+  // the next events are queued.
+  void WriteFirstEvent(SummaryWriterInterface* writer) {
+    env_.Close();
+    TF_ASSERT_OK(WriteEvent(writer, 1, "a"));
+    env_.WaitForHeldSync();
+  }
+
+  static Status WriteEvent(SummaryWriterInterface* writer, int64_t step,
+                           const string& tag) {
+    std::unique_ptr<Event> e{new Event};
+    e->set_step(step);
+    e->mutable_summary()->add_value()->set_tag(tag);
+    return writer->WriteEvent(std::move(e));
+  }
+
+  // Returns the steps of the events written for `test_name`.
+  std::vector<int64_t> ReadSteps(const string& test_name) {
+    std::vector<string> files;
+    TF_CHECK_OK(env_.GetChildren(testing::TmpDir(), &files));
+    std::vector<int64_t> steps;
+    for (const string& f : files) {
+      if (!absl::StrContains(f, test_name)) continue;
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                           &read_file));
+      io::RecordReader reader(read_file.get(), io::RecordReaderOptions());
+      tstring record;
+      uint64 offset = 0;
+      // The first event is the file version.
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      while (reader.ReadRecord(&offset, &record).ok()) {
+        Event e;
+        e.ParseFromString(record);
+        steps.push_back(e.step());
+      }
+    }
+    return steps;
+  }
+
+  SyncGateEnv env_;
+};
+
+TEST_F(AsyncSummaryFileWriterTest, WritesEventsOnFlush) {
+  SummaryFileWriterInterface* writer =
+      CreateWriter("async_flush_test", SummaryQueueOverflowPolicy::kBlock);
+  core::ScopedUnref deleter(writer);
+  for (int step = 1; step <= 3; ++step) {
+    TF_ASSERT_OK(WriteEvent(writer, step, "a"));
+  }
+  TF_ASSERT_OK(writer->Flush());
+  EXPECT_EQ(writer->GetStats().queue_depth, 0);
+  EXPECT_EQ(ReadSteps("async_flush_test"), std::vector<int64_t>({1, 2, 3}));
+}
+
+TEST_F(AsyncSummaryFileWriterTest, WritesQueuedEventsOnDestruction) {
+  SummaryFileWriterInterface* writer = CreateWriter(
+      "async_destruction_test", SummaryQueueOverflowPolicy::kBlock);
+  WriteFirstEvent(writer);
+  TF_ASSERT_OK(WriteEvent(writer, 2, "a"));
+  env_.Open();
+  writer->Unref();
+  EXPECT_EQ(ReadSteps("async_destruction_test"),
+            std::vector<int64_t>({1, 2}));
+}
+
+TEST_F(AsyncSummaryFileWriterTest, BlocksWhenFull) {
+  SummaryFileWriterInterface* writer =
+      CreateWriter("async_block_test", SummaryQueueOverflowPolicy::kBlock);
+  core::ScopedUnref deleter(writer);
+  WriteFirstEvent(writer);
+  TF_ASSERT_OK(WriteEvent(writer, 2, "a"));
+  {
+    std::unique_ptr<Thread> thread(
+        env_.StartThread(ThreadOptions(), "write", [writer]() {
+          TF_ASSERT_OK(WriteEvent(writer, 3, "a"));
+        }));
+    env_.Open();
+  }
+  TF_ASSERT_OK(writer->Flush());
+  const SummaryFileWriterStats stats = writer->GetStats();
+  EXPECT_EQ(stats.num_dropped_events, 0);
+  EXPECT_EQ(stats.num_coalesced_events, 0);
+  EXPECT_EQ(ReadSteps("async_block_test"), std::vector<int64_t>({1, 2, 3}));
+}
+
+TEST_F(AsyncSummaryFileWriterTest, DropsNewestEventsWhenFull) {
+  SummaryFileWriterInterface* writer = CreateWriter(
+      "async_drop_newest_test", SummaryQueueOverflowPolicy::kDropNewest);
+  core::ScopedUnref deleter(writer);
+  WriteFirstEvent(writer);
+  TF_ASSERT_OK(WriteEvent(writer, 2, "a"));
+  TF_ASSERT_OK(WriteEvent(writer, 3, "a"));
+  SummaryFileWriterStats stats = writer->GetStats();
+  EXPECT_EQ(stats.queue_depth, 2);
+  EXPECT_EQ(stats.num_dropped_events, 1);
+  env_.Open();
+  TF_ASSERT_OK(writer->Flush());
+  EXPECT_EQ(writer->GetStats().queue_depth, 0);
+  EXPECT_EQ(ReadSteps("async_drop_newest_test"),
+            std::vector<int64_t>({1, 2}));
+}
+
+TEST_F(AsyncSummaryFileWriterTest, DropsOldestEventsWhenFull) {
+  SummaryFileWriterInterface* writer = CreateWriter(
+      "async_drop_oldest_test", SummaryQueueOverflowPolicy::kDropOldest);
+  core::ScopedUnref deleter(writer);
+  WriteFirstEvent(writer);
+  TF_ASSERT_OK(WriteEvent(writer, 2, "a"));
+  TF_ASSERT_OK(WriteEvent(writer, 3, "a"));
+  EXPECT_EQ(writer->GetStats().num_dropped_events, 1);
+  env_.Open();
+  TF_ASSERT_OK(writer->Flush());
+  EXPECT_EQ(ReadSteps("async_drop_oldest_test"),
+            std::vector<int64_t>({1, 3}));
+}
+
+TEST_F(AsyncSummaryFileWriterTest, CoalescesEventsWithTheSameTags) {
+  SummaryFileWriterInterface* writer = CreateWriter(
+      "async_coalesce_test", SummaryQueueOverflowPolicy::kCoalesce);
+  core::ScopedUnref deleter(writer);
+  WriteFirstEvent(writer);
+  TF_ASSERT_OK(WriteEvent(writer, 2, "a"));
+  // Replaces the event of step 2.
+  TF_ASSERT_OK(WriteEvent(writer, 3, "a"));
+  SummaryFileWriterStats stats = writer->GetStats();
+  EXPECT_EQ(stats.num_coalesced_events, 1);
+  EXPECT_EQ(stats.num_dropped_events, 0);
+  // Nothing to coalesce with, so the event of step 3 is dropped.
+  TF_ASSERT_OK(WriteEvent(writer, 4, "b"));
+  stats = writer->GetStats();
+  EXPECT_EQ(stats.num_coalesced_events, 1);
+  EXPECT_EQ(stats.num_dropped_events, 1);
+  env_.Open();
+  TF_ASSERT_OK(writer->Flush());
+  EXPECT_EQ(ReadSteps("async_coalesce_test"), std::vector<int64_t>({1, 4}));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -21,6 +21,65 @@ limitations under the License.
 
 namespace tfrt {
 namespace tf {
+namespace {
+
+// The capacity of the first table of a shard.
+constexpr size_t kInitialTableCapacity = 16;
+
+}  // namespace
+
+size_t OpCache::Size() const {
+  size_t size = 0;
+  for (const Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    size += shard.entries.size();
+  }
+  return size;
+}
+
+CoreRuntimeOp* OpCache::Lookup(const CacheKey& key, size_t hash) const {
+  const Table* table = ShardFor(hash).table.load(std::memory_order_acquire);
+  if (table == nullptr) return nullptr;
+  for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+    Entry* entry = table->slots[i].load(std::memory_order_acquire);
+    if (entry == nullptr) return nullptr;
+    if (entry->hash == hash && entry->key == key) return &entry->op;
+  }
+}
+
+CoreRuntimeOp* OpCache::Insert(CacheKey key, size_t hash, CoreRuntimeOp op) {
+  Shard& shard = ShardFor(hash);
+  mutex_lock l(shard.mu);
+  // If an entry with the same key was inserted since the lookup due to race
+  // condition, keep it, since the other thread may be using it.
+  if (CoreRuntimeOp* existing = Lookup(key, hash)) return existing;
+
+  key.MakeConcrete();
+  shard.entries.push_back(
+      std::make_unique<Entry>(std::move(key), hash, std::move(op)));
+  Entry* entry = shard.entries.back().get();
+
+  auto insert_into = [](const Table& table, Entry* new_entry) {
+    size_t i = new_entry->hash & table.mask;
+    while (table.slots[i].load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & table.mask;
+    }
+    table.slots[i].store(new_entry, std::memory_order_release);
+  };
+  const Table* table = shard.table.load(std::memory_order_relaxed);
+  if (table == nullptr || 2 * shard.entries.size() > table->mask + 1) {
+    // Publish a larger table holding all the entries, including the new one.
+    const size_t capacity =
+        table == nullptr ? kInitialTableCapacity : 2 * (table->mask + 1);
+    shard.tables.push_back(std::make_unique<Table>(capacity));
+    const Table& new_table = *shard.tables.back();
+    for (const auto& e : shard.entries) insert_into(new_table, e.get());
+    shard.table.store(&new_table, std::memory_order_release);
+  } else {
+    insert_into(*table, entry);
+  }
+  return &entry->op;
+}
 
 Expected<CoreRuntimeOp*> OpCache::GetOrAddOp(
     string_view op_name, OpHandler* op_handler, string_view device_name,
@@ -28,11 +87,8 @@ Expected<CoreRuntimeOp*> OpCache::GetOrAddOp(
     OperationInterface* const op_interface) {
   CacheKey cache_key{op_name, op_handler,
                      (op_handler == nullptr ? device_name : ""), dtypes};
-  {
-    mutex_lock l(cache_mu_);
-    auto iter = cache_.find(cache_key);
-    if (iter != cache_.end()) return &iter->second;
-  }
+  const size_t hash = CacheKeyHash()(cache_key);
+  if (CoreRuntimeOp* op = Lookup(cache_key, hash)) return op;
 
   ContextInterface* context = op_interface->context_;
 
@@ -48,35 +104,22 @@ Expected<CoreRuntimeOp*> OpCache::GetOrAddOp(
       context->GetCoreRuntime()->MakeOp(tfrt_op_name, op_handler);
   if (!expected_op) return MakeStringError(expected_op.takeError());
 
-  mutex_lock l(cache_mu_);
-  // Insert the new op to cache. If an entry with the same key is already
-  // present in the cache at this moment due to race condition, overwrites it.
-  cache_key.MakeConcrete();
-  cache_[cache_key] = std::move(expected_op.get());
-  return &cache_[cache_key];
+  return Insert(std::move(cache_key), hash, std::move(expected_op.get()));
 }
 
 Expected<CoreRuntimeOp*> OpCache::GetOrAddXlaOp(string_view op_name,
                                                 ContextInterface* context) {
   // Device name and dtype are not meaningful to a XLA op.
   CacheKey cache_key{op_name, nullptr, "", {}};
-  {
-    mutex_lock l(cache_mu_);
-    auto iter = cache_.find(cache_key);
-    if (iter != cache_.end()) return &iter->second;
-  }
+  const size_t hash = CacheKeyHash()(cache_key);
+  if (CoreRuntimeOp* op = Lookup(cache_key, hash)) return op;
 
   auto tfrt_op_name = StrCat("tf.", op_name);
   Expected<CoreRuntimeOp> expected_op = context->GetCoreRuntime()->MakeOp(
       tfrt_op_name, context->GetFallbackOpHandler());
   if (!expected_op) return MakeStringError(expected_op.takeError());
 
-  mutex_lock l(cache_mu_);
-  // Insert the new op to cache. If an entry with the same key is already
-  // present in the cache at this moment due to race condition, overwrites it.
-  cache_key.MakeConcrete();
-  cache_[cache_key] = std::move(expected_op.get());
-  return &cache_[cache_key];
+  return Insert(std::move(cache_key), hash, std::move(expected_op.get()));
 }
 
 }  // namespace tf
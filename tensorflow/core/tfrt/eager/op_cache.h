@@ -15,6 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_EAGER_OP_CACHE_H_
 #define TENSORFLOW_CORE_TFRT_EAGER_OP_CACHE_H_
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/eager/attr_builder.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/framework/function.h"
@@ -40,6 +44,11 @@ class ContextInterface;
 class OperationInterface;
 
 // Cache for a single core runtime op. Thread safe.
+//
+// The cache is split into shards, each with an insert-only open addressing
+// table of its entries. Lookups read the current table of a shard without
+// taking a lock, so the cache hits of concurrent ops don't contend; only
+// the insertion of a new op takes the lock of its shard.
 class OpCache {
  public:
   // Helper function to look up the cache. If miss, insert the CoreRuntimeOp
@@ -48,30 +57,24 @@ class OpCache {
                                       OpHandler* op_handler,
                                       string_view device_name,
                                       llvm::SmallVector<string_view, 4> dtypes,
-                                      OperationInterface* const op_interface)
-      TFRT_EXCLUDES(cache_mu_);
+                                      OperationInterface* const op_interface);
 
   // Compile with XLA is currently supported via fallback, and the compilation
   // result is a CoreRuntimeOp.
   // TODO(tfrt-devs): Native support of compile_with_xla.
   Expected<CoreRuntimeOp*> GetOrAddXlaOp(string_view op_name,
-                                         ContextInterface* context)
-      TFRT_EXCLUDES(cache_mu_);
+                                         ContextInterface* context);
 
   // The following helper functions are for debugging and testing only.
-  size_t Size() const {
-    mutex_lock l(cache_mu_);
-    return cache_.size();
-  }
+  size_t Size() const;
 
   bool Contains(string_view op_name, OpHandler* op_handler,
                 string_view device_name,
                 llvm::SmallVector<string_view, 4> dtypes) const {
-    const CacheKey& cache_key{op_name, op_handler,
-                              (op_handler == nullptr ? device_name : ""),
-                              dtypes};
-    mutex_lock l(cache_mu_);
-    return cache_.find(cache_key) != cache_.end();
+    const CacheKey cache_key{op_name, op_handler,
+                             (op_handler == nullptr ? device_name : ""),
+                             dtypes};
+    return Lookup(cache_key, CacheKeyHash()(cache_key)) != nullptr;
   }
 
  private:
@@ -84,29 +87,6 @@ class OpCache {
           device_name_(device_name),
           dtypes_(dtypes) {}
 
-    CacheKey(const CacheKey& other)
-        : op_handler_(other.op_handler_),
-          op_name_(other.op_name_),
-          device_name_(other.device_name_),
-          dtypes_(other.dtypes_) {
-      // Copy the concrete strings if the key is concrete, and set the
-      // string_views to refer to the concrete strings.
-      if (other.is_concrete_) {
-        op_name_concrete_ = other.op_name_concrete_;
-        op_name_ = op_name_concrete_.data();
-        device_name_concrete_ = other.device_name_concrete_;
-        device_name_ = device_name_concrete_.data();
-        size_t n = other.dtypes_concrete_.size();
-        dtypes_concrete_.reserve(n);
-        dtypes_.clear();
-        for (size_t i = 0; i < n; ++i) {
-          dtypes_concrete_.push_back(other.dtypes_concrete_[i]);
-          dtypes_.push_back(dtypes_concrete_[i].data());
-        }
-        is_concrete_ = true;
-      }
-    }
-
     // Make the cache key concrete by copying the key components (strings) to
     // internal storage.
     void MakeConcrete() {
@@ -117,34 +97,34 @@ class OpCache {
       is_concrete_ = true;
     }
 
+    // During comparing keys, self or other can be either concrete or not. The
+    // string_view fields of a concrete key are not used, since the key may
+    // have outlived the strings they refer to.
     bool operator==(const CacheKey& other) const {
-      // During comparing keys, self or other can be either concrete or not.
-      // If a CacheKey is concrete, it's likely that the string_view fields
-      // are not valid (for example the key is obtained from the cache). We
-      // need to make the string_view fields refer to the concrete fields
-      // by constructing copies of them.
-      CacheKey lhs{*this};
-      CacheKey rhs{other};
-
-      if (lhs.op_handler_ != rhs.op_handler_) return false;
-      if (lhs.dtypes_.size() != rhs.dtypes_.size()) return false;
-
-      for (size_t i = 0, n = lhs.dtypes_.size(); i < n; ++i) {
-        if (lhs.dtypes_[i] != rhs.dtypes_[i]) return false;
+      if (op_handler_ != other.op_handler_) return false;
+      if (NumDtypes() != other.NumDtypes()) return false;
+      for (size_t i = 0, n = NumDtypes(); i < n; ++i) {
+        if (Dtype(i) != other.Dtype(i)) return false;
       }
-      return (lhs.op_name_ == rhs.op_name_ &&
-              lhs.device_name_ == rhs.device_name_);
+      return (OpName() == other.OpName() &&
+              DeviceName() == other.DeviceName());
     }
 
-    string_view OpName() { return op_name_; }
-
-    string_view DeviceName() { return device_name_; }
-
-    const llvm::SmallVector<string_view, 4>& Dtypes() { return dtypes_; }
+    string_view OpName() const {
+      return is_concrete_ ? string_view(op_name_concrete_) : op_name_;
+    }
+    string_view DeviceName() const {
+      return is_concrete_ ? string_view(device_name_concrete_) : device_name_;
+    }
+    size_t NumDtypes() const {
+      return is_concrete_ ? dtypes_concrete_.size() : dtypes_.size();
+    }
+    string_view Dtype(size_t i) const {
+      return is_concrete_ ? string_view(dtypes_concrete_[i]) : dtypes_[i];
+    }
 
    private:
     class OpHandler* op_handler_;
-    // friend size_t CacheKeyHash::operator()(const CacheKey& input_key);
     // string_view is used for efficient cache look up to avoid string copy.
     string_view op_name_, device_name_;
     llvm::SmallVector<string_view, 4> dtypes_;
@@ -164,23 +144,68 @@ class OpCache {
               tensorflow::FingerprintCat64(a.high64, b.high64)};
     }
 
-    size_t operator()(const CacheKey& input_key) const {
-      CacheKey key{input_key};
+    size_t operator()(const CacheKey& key) const {
       tensorflow::Fprint128 hash = tensorflow::Fingerprint128(
           {key.OpName().data(), key.OpName().size()});
       hash = FingerprintCat128(
           hash, tensorflow::Fingerprint128(
                     {key.DeviceName().data(), key.DeviceName().size()}));
-      for (const auto& dtype : key.Dtypes())
+      for (size_t i = 0, n = key.NumDtypes(); i < n; ++i) {
+        const string_view dtype = key.Dtype(i);
         hash = FingerprintCat128(
             hash, tensorflow::Fingerprint128({dtype.data(), dtype.size()}));
+      }
       return hash.high64 ^ hash.low64;
     }
   };
 
-  mutable mutex cache_mu_;
-  std::unordered_map<CacheKey, CoreRuntimeOp, CacheKeyHash> cache_
-      TFRT_GUARDED_BY(cache_mu_);
+  struct Entry {
+    Entry(CacheKey cache_key, size_t key_hash, CoreRuntimeOp cached_op)
+        : key(std::move(cache_key)), hash(key_hash), op(std::move(cached_op)) {}
+
+    const CacheKey key;  // Concrete.
+    const size_t hash;
+    CoreRuntimeOp op;
+  };
+
+  // A table of entries with linear probing, which is at most half full. The
+  // slots only ever change from null to an entry, so they can be probed while
+  // an entry is inserted.
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<Entry*>[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) slots[i].store(nullptr);
+    }
+
+    const size_t mask;
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+  };
+
+  struct Shard {
+    // The current table, which is replaced by one twice as large when it
+    // fills up. The replaced tables are kept in `tables` until the cache is
+    // destroyed, since lookups may still be probing them.
+    std::atomic<const Table*> table{nullptr};
+    mutable mutex mu;
+    std::vector<std::unique_ptr<Entry>> entries TFRT_GUARDED_BY(mu);
+    std::vector<std::unique_ptr<Table>> tables TFRT_GUARDED_BY(mu);
+  };
+
+  static constexpr int kNumShards = 16;
+
+  Shard& ShardFor(size_t hash) const {
+    // The low bits of the hash pick the slots in the tables of the shard.
+    return shards_[(hash >> 32) % kNumShards];
+  }
+
+  // Returns the op for `key`, or nullptr.
+  CoreRuntimeOp* Lookup(const CacheKey& key, size_t hash) const;
+
+  // Inserts `op` for `key` unless another thread inserted an op for it since
+  // the lookup, and returns the op in the cache.
+  CoreRuntimeOp* Insert(CacheKey key, size_t hash, CoreRuntimeOp op);
+
+  mutable Shard shards_[kNumShards];
 };
 
 }  // namespace tf
@@ -15,6 +15,8 @@ limitations under the License.
 #include "tensorflow/core/tfrt/eager/op_cache.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/types/span.h"
 #include "tensorflow/c/eager/c_api.h"
@@ -143,6 +145,35 @@ TEST_F(OpCacheTest, TestOpCacheAlreadyPlaced) {
   EXPECT_EQ(cache_.Size(), 1);
 }
 
+TEST_F(OpCacheTest, TestOpCacheManyEntries) {
+  // Enough entries for the tables of the shards to grow.
+  constexpr int kNumEntries = 200;
+  std::vector<std::string> dtypes;
+  for (int i = 0; i < kNumEntries; ++i) dtypes.push_back(StrCat("DT_", i));
+
+  std::vector<CoreRuntimeOp*> ops;
+  for (const std::string& dtype : dtypes) {
+    auto expected_op =
+        cache_.GetOrAddOp(op_name, /*op_handler=*/nullptr, device_name,
+                          {dtype}, op_interface_.get());
+    ASSERT_TRUE((bool)expected_op) << StrCat(expected_op.takeError());
+    ops.push_back(expected_op.get());
+  }
+  EXPECT_EQ(cache_.Size(), kNumEntries);
+
+  // The entries stay where they were inserted, and are found with keys whose
+  // strings are copies of the original ones.
+  for (int i = 0; i < kNumEntries; ++i) {
+    const std::string dtype = StrCat("DT_", i);
+    auto expected_op =
+        cache_.GetOrAddOp(op_name, /*op_handler=*/nullptr, device_name,
+                          {dtype}, op_interface_.get());
+    ASSERT_TRUE((bool)expected_op) << StrCat(expected_op.takeError());
+    EXPECT_EQ(expected_op.get(), ops[i]);
+  }
+  EXPECT_EQ(cache_.Size(), kNumEntries);
+}
+
 }  // namespace
 }  // namespace tf
 }  // namespace tfrt
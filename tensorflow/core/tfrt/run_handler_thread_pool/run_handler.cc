@@ -126,6 +126,8 @@ ThreadWorkSource::ThreadWorkSource()
     : non_blocking_work_sharding_factor_(
           static_cast<int32_t>(ParamFromEnvWithDefault(
               "TF_RUN_HANDLER_NUM_OF_NON_BLOCKING_QUEUES", 1))),
+      prioritize_continuations_(ParamFromEnvBoolWithDefault(
+          "TF_RUN_HANDLER_PRIORITIZE_CONTINUATIONS", true)),
       non_blocking_work_queues_(non_blocking_work_sharding_factor_),
       blocking_inflight_(0),
       non_blocking_inflight_(0),
@@ -147,7 +149,7 @@ ThreadWorkSource::~ThreadWorkSource() {
 }
 
 Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
-                                   bool enable_wake_up) {
+                                   bool enable_wake_up, int thread_id) {
   uint64_t id = t.f->trace_id;
   tensorflow::profiler::TraceMe activity(
       [id, is_blocking] {
@@ -159,16 +161,22 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
   Queue* task_queue = nullptr;
   thread_local int64_t closure_counter = 0;
 
-  if (!is_blocking) {
-    int queue_index = ++closure_counter % non_blocking_work_sharding_factor_;
-    task_queue = &(non_blocking_work_queues_[queue_index]->queue);
-    mu = &non_blocking_work_queues_[queue_index]->queue_op_mu;
+  if (!is_blocking && prioritize_continuations_ && thread_id >= 0) {
+    // The local queue of the thread. Workers pop from the back, starting from
+    // the queue at their thread id, see RunHandlerThreadPool::FindTask.
+    int queue_index = thread_id % non_blocking_work_sharding_factor_;
+    // PushBack is safe to call concurrently with the other operations.
+    t = non_blocking_work_queues_[queue_index]->queue.PushBack(std::move(t));
   } else {
-    task_queue = &blocking_work_queue_;
-    mu = &blocking_queue_op_mu_;
-  }
+    if (!is_blocking) {
+      int queue_index = ++closure_counter % non_blocking_work_sharding_factor_;
+      task_queue = &(non_blocking_work_queues_[queue_index]->queue);
+      mu = &non_blocking_work_queues_[queue_index]->queue_op_mu;
+    } else {
+      task_queue = &blocking_work_queue_;
+      mu = &blocking_queue_op_mu_;
+    }
 
-  {
     tensorflow::mutex_lock l(*mu);
     // For a given queue, only one thread can call PushFront.
     t = task_queue->PushFront(std::move(t));
@@ -410,7 +418,8 @@ void RunHandlerThreadPool::StartOneThreadForTesting() {
 void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
                                           bool is_blocking, TaskFunction fn) {
   Task t = env_.CreateTask(std::move(fn));
-  t = tws->EnqueueTask(std::move(t), is_blocking, enable_wake_up_);
+  t = tws->EnqueueTask(std::move(t), is_blocking, enable_wake_up_,
+                       CurrentThreadId());
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
             << tws->GetTracemeId();
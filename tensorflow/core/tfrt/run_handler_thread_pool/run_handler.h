@@ -215,7 +215,18 @@ class ThreadWorkSource {
 
   ~ThreadWorkSource();
 
-  Task EnqueueTask(Task t, bool is_blocking, bool enable_wake_up);
+  // Enqueues `t`, and returns it back if the queue is full. `thread_id` is the
+  // id of the pool thread that enqueues the task, or -1 for other threads.
+  //
+  // A non-blocking task enqueued by a pool thread is usually the continuation
+  // of the work that thread is running, e.g. an async value that it just made
+  // available. Unless disabled with TF_RUN_HANDLER_PRIORITIZE_CONTINUATIONS,
+  // it goes to the back of the thread's own queue, where it is popped next,
+  // ahead of older tasks, while its inputs are still hot in the cache; the
+  // other threads still steal it when they run out of work. Other tasks are
+  // spread over the queues from the front, and run in FIFO order.
+  Task EnqueueTask(Task t, bool is_blocking, bool enable_wake_up,
+                   int thread_id = -1);
 
   Task PopBlockingTask();
 
@@ -253,6 +264,7 @@ class ThreadWorkSource {
   };
 
   int32_t non_blocking_work_sharding_factor_;
+  bool prioritize_continuations_;
   Eigen::MaxSizeVector<NonBlockingQueue*> non_blocking_work_queues_;
 
   // The number of tasks that are executing now.
@@ -13,7 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -32,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tfrt/host_context/task_function.h"  // from @tf_runtime
 
 namespace tfrt {
@@ -170,6 +174,32 @@ TEST_P(RunHandlerThreadPoolTest, EnqueueTask) {
   EXPECT_EQ(result, 2);
 }
 
+TEST_P(RunHandlerThreadPoolTest, EnqueueContinuationToLocalQueue) {
+  internal::RunHandlerEnvironment env(tensorflow::Env::Default(),
+                                      tensorflow::ThreadOptions(),
+                                      "tf_run_handler_pool");
+  internal::ThreadWorkSource tws;
+
+  int result = 0;
+  std::function<void()> fn = [&result] { result = 1; };
+  std::function<void()> fn2 = [&result] { result = 2; };
+  EXPECT_EQ(tws.EnqueueTask(env.CreateTask(TaskFunction(fn)),
+                            /*is_blocking=*/false, /*enable_wake_up=*/false)
+                .f,
+            nullptr);
+  // The continuation enqueued by the pool thread runs before the older task.
+  EXPECT_EQ(tws.EnqueueTask(env.CreateTask(TaskFunction(fn2)),
+                            /*is_blocking=*/false, /*enable_wake_up=*/false,
+                            /*thread_id=*/0)
+                .f,
+            nullptr);
+  EXPECT_EQ(tws.TaskQueueSize(/*is_blocking=*/false), 2);
+  tws.PopNonBlockingTask(0, true).f->f();
+  EXPECT_EQ(result, 2);
+  tws.PopNonBlockingTask(0, true).f->f();
+  EXPECT_EQ(result, 1);
+}
+
 TEST_P(RunHandlerThreadPoolTest, FindTask) {
   Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(2);
   waiters_mu.resize(2);
@@ -622,6 +652,80 @@ INSTANTIATE_TEST_SUITE_P(Parameter, RunHandlerThreadPoolTest,
                          testing::Combine(::testing::Bool(),
                                           ::testing::Bool()));
 
+void Spin(int iterations) {
+  volatile int sink = 0;
+  for (int i = 0; i < iterations; ++i) sink = sink + i;
+}
+
+// The latency of small requests, each a chain of short continuations, that
+// run concurrently with large requests that fan out many longer closures.
+// Arg 0 queues the continuations like any other closure, arg 1 runs them from
+// the local queue of the thread that scheduled them.
+void BM_MixedRequestsTailLatency(::testing::benchmark::State& state) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumRequests = 32;
+  constexpr int kNumContinuations = 16;
+  constexpr int kFanOut = 256;
+  setenv("TF_RUN_HANDLER_PRIORITIZE_CONTINUATIONS",
+         state.range(0) ? "true" : "false", 1);
+  RunHandlerPool::Options options;
+  options.num_intra_op_threads = kNumThreads;
+  options.num_inter_op_threads = kNumThreads;
+  options.max_concurrent_handler = kNumRequests;
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(options));
+  unsetenv("TF_RUN_HANDLER_PRIORITIZE_CONTINUATIONS");
+  tensorflow::thread::ThreadPool request_pool(tensorflow::Env::Default(),
+                                              "requests", kNumRequests);
+
+  std::vector<uint64_t> latencies;
+  tensorflow::mutex latencies_mu;
+  for (auto s : state) {
+    tensorflow::BlockingCounter requests(kNumRequests);
+    for (int i = 0; i < kNumRequests; ++i) {
+      request_pool.Schedule([&, i] {
+        const uint64_t start = tensorflow::Env::Default()->NowMicros();
+        auto handler = pool->Get(i);
+        RunHandler* h = handler.get();
+        if (i % 8 == 0) {
+          tensorflow::BlockingCounter closures(kFanOut);
+          for (int j = 0; j < kFanOut; ++j) {
+            h->ScheduleIntraOpClosure(TaskFunction([&closures] {
+              Spin(50000);
+              closures.DecrementCount();
+            }));
+          }
+          closures.Wait();
+        } else {
+          tensorflow::BlockingCounter done(1);
+          std::function<void(int)> next = [&](int n) {
+            Spin(2000);
+            if (n == 0) {
+              done.DecrementCount();
+            } else {
+              h->ScheduleIntraOpClosure(
+                  TaskFunction([&next, n] { next(n - 1); }));
+            }
+          };
+          h->ScheduleIntraOpClosure(
+              TaskFunction([&next] { next(kNumContinuations); }));
+          done.Wait();
+          tensorflow::mutex_lock l(latencies_mu);
+          latencies.push_back(tensorflow::Env::Default()->NowMicros() - start);
+        }
+        requests.DecrementCount();
+      });
+    }
+    requests.Wait();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  if (!latencies.empty()) {
+    state.counters["p50_us"] = latencies[latencies.size() / 2];
+    state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+  }
+}
+BENCHMARK(BM_MixedRequestsTailLatency)->Arg(0)->Arg(1)->UseRealTime();
+
 }  // namespace
 }  // namespace tf
 }  // namespace tfrt
@@ -18,18 +18,42 @@ limitations under the License.
 
 #include <map>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/activation_mode.h"
 #include "tensorflow/core/util/autotune_maps/autotune_map.pb.h"
 #include "tensorflow/core/util/autotune_maps/autotune_maps_utils.h"
 #include "tensorflow/core/util/autotune_maps/conv_autotune_maps.h"
 #include "tensorflow/core/util/autotune_maps/conv_parameters.h"
 #include "tensorflow/core/util/autotune_maps/conv_parameters.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/stream_executor/dnn.h"
 #include "tensorflow/stream_executor/dnn.pb.h"
+#include "tensorflow/stream_executor/multi_platform_manager.h"
+#include "tensorflow/stream_executor/stream_executor_pimpl.h"
 
 namespace tensorflow {
+namespace {
+
+bool IsTextProtoPath(const std::string &path) {
+  return absl::EndsWith(path, ".pbtxt") || absl::EndsWith(path, ".txt");
+}
+
+Status ReadAutotuneMapsProto(const std::string &path,
+                             AutotuneMapsProto *proto) {
+  if (IsTextProtoPath(path)) {
+    return ReadTextProto(Env::Default(), path, proto);
+  }
+  return ReadBinaryProto(Env::Default(), path, proto);
+}
+
+}  // namespace
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 namespace {
@@ -75,6 +99,40 @@ ConvMapProto ConvMapToProto() {
   return proto;
 }
 
+// Returns the version of the DNN library of the first GPU, or an empty string
+// when it is unknown.
+std::string DnnVersion() {
+  static const std::string *version = [] {
+#if GOOGLE_CUDA
+    const char *platform_name = "CUDA";
+#else
+    const char *platform_name = "ROCM";
+#endif
+    auto *version = new std::string;
+    auto platform =
+        stream_executor::MultiPlatformManager::PlatformWithName(platform_name);
+    if (!platform.ok()) return version;
+    auto executor = platform.ValueOrDie()->ExecutorForDevice(0);
+    if (!executor.ok()) return version;
+    stream_executor::dnn::DnnSupport *dnn = executor.ValueOrDie()->AsDnn();
+    if (dnn == nullptr) return version;
+    auto version_info = dnn->GetVersion();
+    if (!version_info.ok()) return version;
+    *version = absl::StrCat(version_info.ValueOrDie().major_version(), ".",
+                            version_info.ValueOrDie().minor_version(), ".",
+                            version_info.ValueOrDie().patch());
+    return version;
+  }();
+  return *version;
+}
+
+AutotuneMapsProto AutotuneMapsToProto() {
+  AutotuneMapsProto proto;
+  *proto.mutable_conv_map() = ConvMapToProto();
+  proto.set_dnn_version(DnnVersion());
+  return proto;
+}
+
 Status PopulateConvMap(const ConvMapProto &m) {
   // Map device_id's to corresponding device_identifiers.
   std::vector<string> device_ids_map =
@@ -124,10 +182,34 @@ Status PopulateConvMap(const ConvMapProto &m) {
 }  // namespace
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+namespace {
+
+Status PopulateAutotuneMaps(const AutotuneMapsProto &proto) {
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  // Like entries of another ConvParameters version, maps of another DNN
+  // library version are rejected as a whole: the algorithms they picked may
+  // not exist or not be the fastest anymore.
+  const std::string runtime_dnn_version = DnnVersion();
+  if (!proto.dnn_version().empty() && !runtime_dnn_version.empty() &&
+      proto.dnn_version() != runtime_dnn_version) {
+    return errors::Aborted(
+        "Aborted because the loaded autotune maps were autotuned with DNN "
+        "library version ",
+        proto.dnn_version(), " while the runtime uses version ",
+        runtime_dnn_version, ".");
+  }
+  TF_RETURN_IF_ERROR(PopulateConvMap(proto.conv_map()));
+  // TODO(b/189530096): Populate autotune maps for more ops.
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  return Status::OK();
+}
+
+}  // namespace
+
 Status SerializeAutotuneMaps(std::string *output) {
   AutotuneMapsProto proto;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-  *proto.mutable_conv_map() = ConvMapToProto();
+  proto = AutotuneMapsToProto();
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   *output = autotune_maps_utils::SerializeProtoDeterministic(proto);
   return Status::OK();
@@ -143,12 +225,136 @@ Status LoadSerializedAutotuneMaps(absl::string_view s) {
     return errors::InvalidArgument(
         "Failed to parse the autotune maps from string.");
   }
-  TF_RETURN_IF_ERROR(PopulateConvMap(proto.conv_map()));
-  // TODO(b/189530096): Populate autotune maps for more ops.
+  TF_RETURN_IF_ERROR(PopulateAutotuneMaps(proto));
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   return Status::OK();
 }
 
+Status MergeSerializedAutotuneMaps(const std::vector<std::string> &inputs,
+                                   std::string *output) {
+  struct Votes {
+    ConvMapProto::Entry entry;
+    int count = 0;
+  };
+  // The votes for the algorithms of each problem, keyed by the serialized
+  // problem and algorithm, so that the merge doesn't depend on the order of
+  // the inputs.
+  std::map<string, std::map<string, Votes>> conv_votes;
+  AutotuneMapsProto merged;
+  for (int i = 0; i < inputs.size(); ++i) {
+    AutotuneMapsProto proto;
+    if (!proto.ParseFromString(inputs[i])) {
+      return errors::InvalidArgument("Failed to parse the autotune maps ", i,
+                                     " from string.");
+    }
+    if (i == 0) {
+      merged.set_dnn_version(proto.dnn_version());
+    } else if (proto.dnn_version() != merged.dnn_version()) {
+      return errors::InvalidArgument(
+          "Cannot merge autotune maps autotuned with different DNN library "
+          "versions: ",
+          merged.dnn_version(), " and ", proto.dnn_version(), ".");
+    }
+    for (const ConvMapProto::Entry &kv : proto.conv_map().kv_pairs()) {
+      const string key =
+          autotune_maps_utils::SerializeProtoDeterministic(kv.key());
+      const string value =
+          autotune_maps_utils::SerializeProtoDeterministic(kv.value());
+      Votes &votes = conv_votes[key][value];
+      if (votes.count++ == 0) votes.entry = kv;
+    }
+  }
+  for (const auto &problem : conv_votes) {
+    // Ties go to the smallest serialized algorithm, the first in the map.
+    const Votes *winner = nullptr;
+    for (const auto &algorithm : problem.second) {
+      if (winner == nullptr || algorithm.second.count > winner->count) {
+        winner = &algorithm.second;
+      }
+    }
+    *merged.mutable_conv_map()->add_kv_pairs() = winner->entry;
+  }
+  *output = autotune_maps_utils::SerializeProtoDeterministic(merged);
+  return Status::OK();
+}
+
+Status LoadAutotuneMapsFromFile(const std::string &path) {
+  AutotuneMapsProto proto;
+  TF_RETURN_IF_ERROR(ReadAutotuneMapsProto(path, &proto));
+  return PopulateAutotuneMaps(proto);
+}
+
+Status SaveAutotuneMapsToFile(const std::string &path) {
+  AutotuneMapsProto proto;
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  proto = AutotuneMapsToProto();
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  Env *env = Env::Default();
+  std::string tmp_path = path;
+  if (!env->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  if (IsTextProtoPath(path)) {
+    TF_RETURN_IF_ERROR(WriteTextProto(env, tmp_path, proto));
+  } else {
+    TF_RETURN_IF_ERROR(WriteStringToFile(
+        env, tmp_path,
+        autotune_maps_utils::SerializeProtoDeterministic(proto)));
+  }
+  return env->RenameFile(tmp_path, path);
+}
+
+void MaybeLoadAutotuneMapsFromEnv() {
+  static const bool loaded = [] {
+    std::string paths;
+    TF_CHECK_OK(
+        ReadStringFromEnvVar("TF_AUTOTUNE_MAPS_LOAD_FILES", "", &paths));
+    std::vector<std::string> inputs;
+    for (absl::string_view path :
+         absl::StrSplit(paths, ',', absl::SkipEmpty())) {
+      AutotuneMapsProto proto;
+      Status status = ReadAutotuneMapsProto(std::string(path), &proto);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to read the autotune maps from " << path
+                     << ": " << status;
+        return false;
+      }
+      inputs.push_back(autotune_maps_utils::SerializeProtoDeterministic(proto));
+    }
+    if (inputs.empty()) return false;
+    std::string merged;
+    Status status = MergeSerializedAutotuneMaps(inputs, &merged);
+    if (status.ok()) status = LoadSerializedAutotuneMaps(merged);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to load the autotune maps from " << paths << ": "
+                   << status;
+      return false;
+    }
+    VLOG(1) << "Loaded the autotune maps from " << paths;
+    return true;
+  }();
+  (void)loaded;
+}
+
+void MaybeSaveAutotuneMapsFromEnv() {
+  static const std::string *path = [] {
+    auto *path = new std::string;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_AUTOTUNE_MAPS_SAVE_FILE", "", path));
+    return path;
+  }();
+  if (path->empty()) return;
+  // Serializes the saves, so that an older snapshot of the maps never
+  // replaces a newer one.
+  static mutex mu(LINKER_INITIALIZED);
+  mutex_lock lock(mu);
+  Status status = SaveAutotuneMapsToFile(*path);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to save the autotune maps to " << *path << ": "
+                 << status;
+  }
+}
+
 void ResetAutotuneMaps() {
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   AutotuneConv::GetInstance()->ClearMap();
@@ -26,6 +26,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_AUTOTUNE_MAPS_AUTOTUNE_SERIALIZE_H_
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/platform/status.h"
 
@@ -40,6 +41,33 @@ Status LoadSerializedAutotuneMaps(absl::string_view s);
 // LoadSerializedAutotuneMaps.
 Status SerializeAutotuneMaps(std::string* output);
 
+// Merges maps output by SerializeAutotuneMaps, e.g. on different workers, into
+// maps that LoadSerializedAutotuneMaps can load. Where the inputs disagree on
+// the algorithm of a problem, the algorithm most of them picked wins, and ties
+// are broken deterministically, so that every worker loading the merged maps
+// uses the same algorithms. All inputs must be autotuned with the same cuDNN
+// version.
+Status MergeSerializedAutotuneMaps(const std::vector<std::string>& inputs,
+                                   std::string* output);
+
+// Loads and saves the autotune maps from and to files, as text protos if
+// `path` ends in ".pbtxt" or ".txt" and as binary protos otherwise. The save
+// writes a temporary file that is renamed to `path`, so that processes saving
+// concurrently never leave a partial file behind.
+Status LoadAutotuneMapsFromFile(const std::string& path);
+Status SaveAutotuneMapsToFile(const std::string& path);
+
+// Loads the files that TF_AUTOTUNE_MAPS_LOAD_FILES lists, separated by
+// commas, merged with MergeSerializedAutotuneMaps when there are several.
+// Only the first call loads them; failures are logged, and autotuning then
+// proceeds as if nothing was loaded.
+void MaybeLoadAutotuneMapsFromEnv();
+
+// Saves the autotune maps to TF_AUTOTUNE_MAPS_SAVE_FILE, if set. Called
+// whenever autotuning adds an entry, so that the file always holds everything
+// autotuned so far.
+void MaybeSaveAutotuneMapsFromEnv();
+
 // Resets all autotune maps. For test use only.
 void ResetAutotuneMaps();
 
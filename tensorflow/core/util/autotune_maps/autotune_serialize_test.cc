@@ -18,8 +18,12 @@ limitations under the License.
 
 #include "tensorflow/core/util/autotune_maps/autotune_serialize.h"
 
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/autotune_maps/autotune_map.pb.h"
+#include "tensorflow/core/util/autotune_maps/autotune_maps_utils.h"
 #include "tensorflow/core/util/autotune_maps/conv_autotune_maps.h"
 #include "tensorflow/core/util/autotune_maps/conv_parameters.h"
 #include "tensorflow/core/util/autotune_maps/conv_parameters.pb.h"
@@ -174,6 +178,104 @@ TEST(AutotuneSerializeTest, VersionControl) {
                HasSubstr("Aborted because the loaded autotune results")));
   EXPECT_EQ(AutotuneConv::GetInstance()->GetMap().size(), 0);
 }
+
+ConvParameters ConvParametersWithBatchSize(int64_t batch_size) {
+  return {/*batch_size=*/batch_size,
+          /*in_depths=*/1,
+          /*in=*/{{1, 1}},
+          /*data_format=*/TensorFormat::FORMAT_NCHW,
+          /*out_depth=*/1,
+          /*filter=*/{{1, 1}},
+          /*dilation=*/{{1, 1}},
+          /*stride=*/{{1, 1}},
+          /*padding=*/{{1, 1}},
+          /*dtype=*/DataType::DT_INT8,
+          /*device_id=*/0,
+          /*group_count=*/1};
+}
+
+AlgorithmConfig AlgorithmConfigWithId(int64_t algo_id) {
+  AlgorithmDesc algorithm(algo_id, /*use_tensor_op=*/true);
+  return AlgorithmConfig(algorithm, /*scratch_size=*/1, algorithm);
+}
+
+// Serializes maps holding `config` for the convolution of `params`.
+std::string SerializeConvMap(const ConvParameters& params,
+                             const AlgorithmConfig& config) {
+  ResetAutotuneMaps();
+  AutotuneConv::GetInstance()->Insert(params, config);
+  std::string serialized_string;
+  TF_CHECK_OK(SerializeAutotuneMaps(&serialized_string));
+  return serialized_string;
+}
+
+// Test that LoadSerializedAutotuneMaps will reject maps autotuned with another
+// DNN library version.
+TEST(AutotuneSerializeTest, DnnVersionControl) {
+  TF_CHECK_OK(GpuDriver::Init());
+  AutotuneMapsProto proto;
+  ASSERT_TRUE(proto.ParseFromString(
+      SerializeConvMap(ConvParametersWithBatchSize(1),
+                       AlgorithmConfigWithId(1))));
+  if (proto.dnn_version().empty()) {
+    GTEST_SKIP() << "The DNN library version is unknown.";
+  }
+  proto.set_dnn_version("0.0.0");
+
+  ResetAutotuneMaps();
+  EXPECT_THAT(
+      LoadSerializedAutotuneMaps(
+          autotune_maps_utils::SerializeProtoDeterministic(proto)),
+      StatusIs(error::ABORTED, HasSubstr("DNN library version 0.0.0")));
+  EXPECT_EQ(AutotuneConv::GetInstance()->GetMap().size(), 0);
+}
+
+// Tests that merging picks the algorithm most of the inputs picked, whatever
+// the order of the inputs, and keeps the problems only some inputs have.
+TEST(AutotuneSerializeTest, MergeVotes) {
+  TF_CHECK_OK(GpuDriver::Init());
+  const ConvParameters contested = ConvParametersWithBatchSize(1);
+  const ConvParameters uncontested = ConvParametersWithBatchSize(2);
+  const std::vector<std::string> inputs = {
+      SerializeConvMap(contested, AlgorithmConfigWithId(1)),
+      SerializeConvMap(contested, AlgorithmConfigWithId(2)),
+      SerializeConvMap(uncontested, AlgorithmConfigWithId(3)),
+      SerializeConvMap(contested, AlgorithmConfigWithId(2))};
+  std::string merged;
+  TF_CHECK_OK(MergeSerializedAutotuneMaps(inputs, &merged));
+  const std::vector<std::string> reversed_inputs(inputs.rbegin(),
+                                                 inputs.rend());
+  std::string reversed_merged;
+  TF_CHECK_OK(MergeSerializedAutotuneMaps(reversed_inputs, &reversed_merged));
+  EXPECT_EQ(merged, reversed_merged);
+
+  ResetAutotuneMaps();
+  TF_CHECK_OK(LoadSerializedAutotuneMaps(merged));
+  EXPECT_EQ(AutotuneConv::GetInstance()->GetMap().size(), 2);
+  AlgorithmConfig algorithm_config;
+  EXPECT_TRUE(AutotuneConv::GetInstance()->Find(contested, &algorithm_config));
+  EXPECT_EQ(algorithm_config, AlgorithmConfigWithId(2));
+  EXPECT_TRUE(
+      AutotuneConv::GetInstance()->Find(uncontested, &algorithm_config));
+  EXPECT_EQ(algorithm_config, AlgorithmConfigWithId(3));
+}
+
+// Tests that the maps saved to binary and text files load back.
+TEST(AutotuneSerializeTest, FileRoundTrip) {
+  TF_CHECK_OK(GpuDriver::Init());
+  const ConvParameters params = ConvParametersWithBatchSize(1);
+  for (const char* file_name : {"autotune_maps.pb", "autotune_maps.pbtxt"}) {
+    const std::string path = io::JoinPath(testing::TmpDir(), file_name);
+    SerializeConvMap(params, AlgorithmConfigWithId(1));
+    TF_CHECK_OK(SaveAutotuneMapsToFile(path));
+
+    ResetAutotuneMaps();
+    TF_CHECK_OK(LoadAutotuneMapsFromFile(path));
+    AlgorithmConfig algorithm_config;
+    EXPECT_TRUE(AutotuneConv::GetInstance()->Find(params, &algorithm_config));
+    EXPECT_EQ(algorithm_config, AlgorithmConfigWithId(1));
+  }
+}
 }  // namespace
 }  // namespace tensorflow
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/util/benchmark_regression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+double GetStddev(const BenchmarkEntry& entry, absl::string_view metric) {
+  auto it = entry.extras().find(BenchmarkStddevKey(metric));
+  if (it == entry.extras().end() ||
+      it->second.kind_case() != EntryValue::kDoubleValue) {
+    return 0.0;
+  }
+  return it->second.double_value();
+}
+
+double WallTimePerIteration(const BenchmarkEntry& entry) {
+  return entry.iters() > 0 ? entry.wall_time() / entry.iters()
+                           : entry.wall_time();
+}
+
+const MetricEntry* FindMetric(const BenchmarkEntry& entry,
+                              absl::string_view name) {
+  for (const MetricEntry& metric : entry.metrics()) {
+    if (metric.name() == name) return &metric;
+  }
+  return nullptr;
+}
+
+void MaybeAddRegression(const BenchmarkEntry& baseline,
+                        const BenchmarkEntry& current, absl::string_view metric,
+                        double baseline_value, double current_value,
+                        const BenchmarkRegressionOptions& options,
+                        std::vector<BenchmarkRegression>* regressions) {
+  const double baseline_stddev = GetStddev(baseline, metric);
+  const double current_stddev = GetStddev(current, metric);
+  const double threshold = std::max(
+      options.min_relative_change * std::abs(baseline_value),
+      options.num_stddevs * std::sqrt(baseline_stddev * baseline_stddev +
+                                      current_stddev * current_stddev));
+  if (current_value - baseline_value <= threshold) return;
+  BenchmarkRegression regression;
+  regression.name = current.name();
+  regression.metric = std::string(metric);
+  regression.baseline = baseline_value;
+  regression.current = current_value;
+  regression.threshold = threshold;
+  regressions->push_back(std::move(regression));
+}
+
+}  // namespace
+
+std::string BenchmarkStddevKey(absl::string_view metric) {
+  return absl::StrCat(metric, "_stddev");
+}
+
+std::string BenchmarkRegression::DebugString() const {
+  return absl::StrFormat(
+      "%s: %s increased from %g to %g (%+.1f%%), above the noise threshold "
+      "of %g",
+      name, metric, baseline, current,
+      baseline != 0.0 ? 100.0 * (current - baseline) / baseline : 0.0,
+      threshold);
+}
+
+std::vector<BenchmarkRegression> FindBenchmarkRegressions(
+    const BenchmarkEntries& baseline, const BenchmarkEntries& current,
+    const BenchmarkRegressionOptions& options) {
+  absl::flat_hash_map<std::string, const BenchmarkEntry*> baseline_entries;
+  for (const BenchmarkEntry& entry : baseline.entry()) {
+    baseline_entries[entry.name()] = &entry;
+  }
+  std::vector<BenchmarkRegression> regressions;
+  for (const BenchmarkEntry& entry : current.entry()) {
+    auto it = baseline_entries.find(entry.name());
+    if (it == baseline_entries.end()) {
+      VLOG(1) << "No baseline for benchmark " << entry.name();
+      continue;
+    }
+    const BenchmarkEntry& baseline_entry = *it->second;
+    MaybeAddRegression(baseline_entry, entry, kBenchmarkWallTime,
+                       WallTimePerIteration(baseline_entry),
+                       WallTimePerIteration(entry), options, &regressions);
+    for (const std::string& name : options.metrics) {
+      const MetricEntry* baseline_metric = FindMetric(baseline_entry, name);
+      const MetricEntry* metric = FindMetric(entry, name);
+      if (baseline_metric == nullptr || metric == nullptr) continue;
+      MaybeAddRegression(baseline_entry, entry, name, baseline_metric->value(),
+                         metric->value(), options, &regressions);
+    }
+  }
+  return regressions;
+}
+
+}  // namespace tensorflow
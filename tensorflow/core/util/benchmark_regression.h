@@ -0,0 +1,70 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_UTIL_BENCHMARK_REGRESSION_H_
+#define TENSORFLOW_CORE_UTIL_BENCHMARK_REGRESSION_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+
+// The name under which the wall time per iteration is compared.
+constexpr char kBenchmarkWallTime[] = "wall_time";
+
+// Returns the key of the BenchmarkEntry extra holding the standard deviation
+// of `metric` over repeated runs of the benchmark, e.g. "wall_time_stddev".
+// The standard deviation of the wall time is per iteration, in seconds.
+std::string BenchmarkStddevKey(absl::string_view metric);
+
+struct BenchmarkRegressionOptions {
+  // Increases smaller than this fraction of the baseline are noise.
+  double min_relative_change = 0.05;
+
+  // Increases smaller than this many standard deviations of the difference
+  // are noise. The standard deviations of the baseline and the current runs
+  // are read from the extras, see BenchmarkStddevKey.
+  double num_stddevs = 3.0;
+
+  // The metrics compared in addition to the wall time. Lower is better for
+  // all of them.
+  std::vector<std::string> metrics = {"cycles", "cache_misses"};
+};
+
+struct BenchmarkRegression {
+  std::string name;
+  // kBenchmarkWallTime or the name of a metric.
+  std::string metric;
+  double baseline = 0.0;
+  double current = 0.0;
+  // The largest increase over the baseline that is considered noise.
+  double threshold = 0.0;
+
+  std::string DebugString() const;
+};
+
+// Compares the entries of `current` to the entries of `baseline` with the
+// same name, and returns the wall times and metrics which increased by more
+// than the noise allowed by `options`. Entries and metrics missing from
+// either side are not compared.
+std::vector<BenchmarkRegression> FindBenchmarkRegressions(
+    const BenchmarkEntries& baseline, const BenchmarkEntries& current,
+    const BenchmarkRegressionOptions& options);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_BENCHMARK_REGRESSION_H_
@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/util/benchmark_regression.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+BenchmarkEntry* AddEntry(const std::string& name, int64_t iters,
+                         double wall_time, double wall_time_stddev,
+                         BenchmarkEntries* entries) {
+  BenchmarkEntry* entry = entries->add_entry();
+  entry->set_name(name);
+  entry->set_iters(iters);
+  entry->set_wall_time(wall_time);
+  (*entry->mutable_extras())[BenchmarkStddevKey(kBenchmarkWallTime)]
+      .set_double_value(wall_time_stddev);
+  return entry;
+}
+
+void AddMetric(const std::string& name, double value, BenchmarkEntry* entry) {
+  MetricEntry* metric = entry->add_metrics();
+  metric->set_name(name);
+  metric->set_value(value);
+}
+
+TEST(BenchmarkRegressionTest, FindsWallTimeRegression) {
+  BenchmarkEntries baseline, current;
+  // 1ms per iteration.
+  AddEntry("BM_Fast", 100, 0.1, 0.0, &baseline);
+  AddEntry("BM_Slow", 100, 0.1, 0.0, &baseline);
+  // 2% slower, which is noise.
+  AddEntry("BM_Fast", 200, 0.204, 0.0, &current);
+  // 20% slower.
+  AddEntry("BM_Slow", 100, 0.12, 0.0, &current);
+
+  std::vector<BenchmarkRegression> regressions =
+      FindBenchmarkRegressions(baseline, current, BenchmarkRegressionOptions());
+  ASSERT_EQ(regressions.size(), 1);
+  EXPECT_EQ(regressions[0].name, "BM_Slow");
+  EXPECT_EQ(regressions[0].metric, kBenchmarkWallTime);
+  EXPECT_DOUBLE_EQ(regressions[0].baseline, 1e-3);
+  EXPECT_DOUBLE_EQ(regressions[0].current, 1.2e-3);
+  EXPECT_DOUBLE_EQ(regressions[0].threshold, 5e-5);
+}
+
+TEST(BenchmarkRegressionTest, IgnoresNoisyIncrease) {
+  BenchmarkEntries baseline, current;
+  AddEntry("BM_Noisy", 100, 0.1, 1e-4, &baseline);
+  AddEntry("BM_Noisy", 100, 0.12, 1e-4, &current);
+
+  // The threshold is 3 * sqrt(2) * 1e-4 ~= 4.2e-4, above the 2e-4 increase.
+  EXPECT_TRUE(
+      FindBenchmarkRegressions(baseline, current, BenchmarkRegressionOptions())
+          .empty());
+}
+
+TEST(BenchmarkRegressionTest, FindsMetricRegression) {
+  BenchmarkEntries baseline, current;
+  AddMetric("cache_misses", 1000, AddEntry("BM_Op", 100, 0.1, 0.0, &baseline));
+  AddMetric("cycles", 1e6, baseline.mutable_entry(0));
+  AddMetric("cache_misses", 2000, AddEntry("BM_Op", 100, 0.1, 0.0, &current));
+  AddMetric("cycles", 0.9e6, current.mutable_entry(0));
+
+  std::vector<BenchmarkRegression> regressions =
+      FindBenchmarkRegressions(baseline, current, BenchmarkRegressionOptions());
+  ASSERT_EQ(regressions.size(), 1);
+  EXPECT_EQ(regressions[0].name, "BM_Op");
+  EXPECT_EQ(regressions[0].metric, "cache_misses");
+  EXPECT_DOUBLE_EQ(regressions[0].baseline, 1000);
+  EXPECT_DOUBLE_EQ(regressions[0].current, 2000);
+}
+
+TEST(BenchmarkRegressionTest, SkipsMissingBaseline) {
+  BenchmarkEntries baseline, current;
+  AddEntry("BM_Old", 100, 0.1, 0.0, &baseline);
+  AddMetric("cycles", 1e6, AddEntry("BM_New", 100, 0.5, 0.0, &current));
+
+  EXPECT_TRUE(
+      FindBenchmarkRegressions(baseline, current, BenchmarkRegressionOptions())
+          .empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
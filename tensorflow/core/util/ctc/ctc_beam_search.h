@@ -21,6 +21,7 @@ limitations under the License.
 #include <cmath>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -132,6 +133,11 @@ class CTCBeamSearchDecoder : public CTCDecoder<T> {
   Status TopPaths(int n, std::vector<std::vector<int>>* paths,
                   std::vector<T>* log_probs, bool merge_repeated) const;
 
+  // Extract the labels that all the paths in the beam start with. Later steps
+  // only extend the paths in the beam, so these labels are final, and
+  // streaming decoders can emit them before the end of the sequence.
+  std::vector<int> StablePrefix(bool merge_repeated) const;
+
  private:
   int beam_width_;
 
@@ -152,6 +158,11 @@ class CTCBeamSearchDecoder : public CTCDecoder<T> {
   std::unique_ptr<BeamRoot> beam_root_;
   BaseBeamScorer<T, CTCBeamState>* beam_scorer_;
 
+  // Scratch buffers of the label selection, reused across steps.
+  std::vector<T> top_k_logits_;
+  std::vector<int> top_k_indices_;
+  std::vector<int> label_order_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
 };
 
@@ -220,36 +231,34 @@ template <typename Vector>
 T CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::GetTopK(
     const int K, const Vector& input, std::vector<T>* top_k_logits,
     std::vector<int>* top_k_indices) {
-  // Find Top K choices, complexity nk in worst case. The array input is read
-  // just once.
+  // Find Top K choices in O(n + K log K): partition the labels around the
+  // K-th largest logit, then only sort the K largest ones. Ties keep the
+  // lowest label first.
   CHECK_EQ(this->num_classes_, input.size());
-  top_k_logits->clear();
-  top_k_indices->clear();
-  top_k_logits->resize(K, -INFINITY);
-  top_k_indices->resize(K, -1);
-  for (int j = 0; j < this->num_classes_ - 1; ++j) {
-    const T logit = input(j);
-    if (logit > (*top_k_logits)[K - 1]) {
-      int k = K - 1;
-      while (k > 0 && logit > (*top_k_logits)[k - 1]) {
-        (*top_k_logits)[k] = (*top_k_logits)[k - 1];
-        (*top_k_indices)[k] = (*top_k_indices)[k - 1];
-        k--;
-      }
-      (*top_k_logits)[k] = logit;
-      (*top_k_indices)[k] = j;
-    }
+  const int num_labels = this->num_classes_ - 1;
+  const int k = std::min(K, num_labels);
+  label_order_.resize(num_labels);
+  std::iota(label_order_.begin(), label_order_.end(), 0);
+  auto greater = [&input](int a, int b) {
+    return input(a) > input(b) || (input(a) == input(b) && a < b);
+  };
+  std::nth_element(label_order_.begin(), label_order_.begin() + k,
+                   label_order_.end(), greater);
+  std::sort(label_order_.begin(), label_order_.begin() + k, greater);
+  top_k_logits->assign(K, -INFINITY);
+  top_k_indices->assign(K, -1);
+  for (int i = 0; i < k; ++i) {
+    (*top_k_indices)[i] = label_order_[i];
+    (*top_k_logits)[i] = input(label_order_[i]);
   }
   // Return max value which is in 0th index or blank character logit
-  return std::max((*top_k_logits)[0], input(this->num_classes_ - 1));
+  return std::max((*top_k_logits)[0], input(num_labels));
 }
 
 template <typename T, typename CTCBeamState, typename CTCBeamComparer>
 template <typename Vector>
 void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
     const Vector& raw_input) {
-  std::vector<T> top_k_logits;
-  std::vector<int> top_k_indices;
   const bool top_k =
       (label_selection_size_ > 0 && label_selection_size_ < raw_input.size());
   // Number of character classes to consider in each step.
@@ -258,17 +267,15 @@ void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
   // Get max coefficient and remove it from raw_input later.
   T max_coeff;
   if (top_k) {
-    max_coeff = GetTopK(label_selection_size_, raw_input, &top_k_logits,
-                        &top_k_indices);
+    max_coeff = GetTopK(label_selection_size_, raw_input, &top_k_logits_,
+                        &top_k_indices_);
   } else {
     max_coeff = raw_input.maxCoeff();
   }
-  // Get normalization term of softmax: log(sum(exp(logit[j]-max_coeff))).
-  T logsumexp = T(0.0);
-  for (int j = 0; j < raw_input.size(); ++j) {
-    logsumexp += Eigen::numext::exp(raw_input(j) - max_coeff);
-  }
-  logsumexp = Eigen::numext::log(logsumexp);
+  // Get normalization term of softmax: log(sum(exp(logit[j]-max_coeff))),
+  // with the vectorized exp of Eigen.
+  const T logsumexp =
+      Eigen::numext::log((raw_input.array() - max_coeff).exp().sum());
   // Final normalization offset to get correct log probabilities.
   T norm_offset = max_coeff + logsumexp;
 
@@ -337,8 +344,8 @@ void CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::Step(
     }
 
     for (int ind = 0; ind < max_classes; ind++) {
-      const int label = top_k ? top_k_indices[ind] : ind;
-      const T logit = top_k ? top_k_logits[ind] : raw_input(ind);
+      const int label = top_k ? top_k_indices_[ind] : ind;
+      const T logit = top_k ? top_k_logits_[ind] : raw_input(ind);
       // Perform label selection: if input for this label looks very
       // unpromising, never evaluate it with a scorer.
       // We may compare logits instead of log probabilities, 
@@ -429,6 +436,37 @@ Status CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::TopPaths(
   return Status::OK();
 }
 
+template <typename T, typename CTCBeamState, typename CTCBeamComparer>
+std::vector<int>
+CTCBeamSearchDecoder<T, CTCBeamState, CTCBeamComparer>::StablePrefix(
+    bool merge_repeated) const {
+  auto depth = [](const BeamEntry* e) {
+    int d = 0;
+    for (; e->parent != nullptr; e = e->parent) ++d;
+    return d;
+  };
+  // Walk the paths up to their deepest common ancestor.
+  const BeamEntry* common = nullptr;
+  int common_depth = 0;
+  for (auto it = leaves_.unsorted_begin(); it != leaves_.unsorted_end(); ++it) {
+    const BeamEntry* e = *it;
+    int d = depth(e);
+    if (common == nullptr) {
+      common = e;
+      common_depth = d;
+      continue;
+    }
+    for (; d > common_depth; --d) e = e->parent;
+    for (; common_depth > d; --common_depth) common = common->parent;
+    for (; e != common; --common_depth) {
+      e = e->parent;
+      common = common->parent;
+    }
+  }
+  if (common == nullptr) return {};
+  return common->LabelSeq(merge_repeated);
+}
+
 }  // namespace ctc
 }  // namespace tensorflow
 
@@ -371,6 +371,100 @@ void ctc_beam_search_label_selection() {
   }
 }
 
+template <class T>
+void ctc_beam_search_top_k_matches_full_selection() {
+  const int num_classes = 50;
+  const int beam_width = 8;
+  const int top_paths = 4;
+  const int timesteps = 6;
+
+  typename tensorflow::ctc::CTCBeamSearchDecoder<T>::DefaultBeamScorer
+      default_scorer;
+  tensorflow::ctc::CTCBeamSearchDecoder<T> full_decoder(
+      num_classes, beam_width, &default_scorer);
+  tensorflow::ctc::CTCBeamSearchDecoder<T> top_k_decoder(
+      num_classes, beam_width, &default_scorer);
+  // Selecting all the labels but the blank one goes through the top k path,
+  // and must not change the result.
+  top_k_decoder.SetLabelSelectionParameters(num_classes - 1, T(-1));
+
+  Eigen::Array<T, Eigen::Dynamic, 1> input(num_classes);
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      input(c) = 3 * std::sin(31 * t + 7 * c);
+    }
+    full_decoder.Step(input);
+    top_k_decoder.Step(input);
+  }
+
+  std::vector<std::vector<int>> full_paths, top_k_paths;
+  std::vector<T> full_log_probs, top_k_log_probs;
+  EXPECT_TRUE(full_decoder
+                  .TopPaths(top_paths, &full_paths, &full_log_probs,
+                            /*merge_repeated=*/false)
+                  .ok());
+  EXPECT_TRUE(top_k_decoder
+                  .TopPaths(top_paths, &top_k_paths, &top_k_log_probs,
+                            /*merge_repeated=*/false)
+                  .ok());
+  EXPECT_EQ(full_paths, top_k_paths);
+  for (int i = 0; i < top_paths; ++i) {
+    EXPECT_NEAR(full_log_probs[i], top_k_log_probs[i], 1e-5);
+  }
+}
+
+template <class T>
+void ctc_beam_search_get_top_k() {
+  typename tensorflow::ctc::CTCBeamSearchDecoder<T>::DefaultBeamScorer
+      default_scorer;
+  tensorflow::ctc::CTCBeamSearchDecoder<T> decoder(5, 4, &default_scorer);
+  Eigen::Array<T, Eigen::Dynamic, 1> input(5);
+  input << 1, 3, 3, 0, 2;
+  std::vector<T> top_k_logits;
+  std::vector<int> top_k_indices;
+  // The blank label is never selected, but counts for the max logit. Ties
+  // select the lowest label first.
+  EXPECT_EQ(decoder.GetTopK(2, input, &top_k_logits, &top_k_indices), T(3));
+  EXPECT_EQ(top_k_indices, std::vector<int>({1, 2}));
+  EXPECT_EQ(top_k_logits, std::vector<T>({3, 3}));
+  input << 1, 0, 4, 2, 5;
+  EXPECT_EQ(decoder.GetTopK(3, input, &top_k_logits, &top_k_indices), T(5));
+  EXPECT_EQ(top_k_indices, std::vector<int>({2, 3, 0}));
+}
+
+template <class T>
+void ctc_beam_search_stable_prefix() {
+  const int num_classes = 4;
+  typename tensorflow::ctc::CTCBeamSearchDecoder<T>::DefaultBeamScorer
+      default_scorer;
+  tensorflow::ctc::CTCBeamSearchDecoder<T> decoder(num_classes,
+                                                   /*beam_width=*/2,
+                                                   &default_scorer);
+  EXPECT_TRUE(decoder.StablePrefix(/*merge_repeated=*/false).empty());
+
+  // Label 1 is almost certain at first, so the beam holds "1" and one of the
+  // unlikely paths, which share no label.
+  Eigen::Array<T, Eigen::Dynamic, 1> input(num_classes);
+  input << std::log(0.01), std::log(0.97), std::log(0.01), std::log(0.01);
+  decoder.Step(input);
+  EXPECT_TRUE(decoder.StablePrefix(/*merge_repeated=*/false).empty());
+
+  // Then label 2 and the blank label are as likely, so the beam holds "1" and
+  // "1 2", which both start with the final label 1.
+  input << std::log(1e-6), std::log(1e-6), std::log(0.5), std::log(0.5);
+  decoder.Step(input);
+  EXPECT_EQ(decoder.StablePrefix(/*merge_repeated=*/false),
+            std::vector<int>({1}));
+
+  std::vector<std::vector<int>> paths;
+  std::vector<T> log_probs;
+  EXPECT_TRUE(decoder.TopPaths(2, &paths, &log_probs, false).ok());
+  for (const std::vector<int>& path : paths) {
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(path[0], 1);
+  }
+}
+
 TEST(CtcBeamSearch, FloatDecodingWithAndWithoutDictionary) {
   ctc_beam_search_decoding_with_and_without_dictionary<float>();
 }
@@ -395,4 +489,24 @@ TEST(CtcBeamSearch, DoubleLabelSelection) {
   ctc_beam_search_label_selection<double>();
 }
 
+TEST(CtcBeamSearch, FloatTopKMatchesFullSelection) {
+  ctc_beam_search_top_k_matches_full_selection<float>();
+}
+
+TEST(CtcBeamSearch, DoubleTopKMatchesFullSelection) {
+  ctc_beam_search_top_k_matches_full_selection<double>();
+}
+
+TEST(CtcBeamSearch, FloatGetTopK) { ctc_beam_search_get_top_k<float>(); }
+
+TEST(CtcBeamSearch, DoubleGetTopK) { ctc_beam_search_get_top_k<double>(); }
+
+TEST(CtcBeamSearch, FloatStablePrefix) {
+  ctc_beam_search_stable_prefix<float>();
+}
+
+TEST(CtcBeamSearch, DoubleStablePrefix) {
+  ctc_beam_search_stable_prefix<double>();
+}
+
 }  // namespace
@@ -31,10 +31,10 @@ limitations under the License.
 namespace tensorflow {
 
 EventsWriter::EventsWriter(const string& file_prefix)
-    // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
-    : env_(Env::Default()),
-      file_prefix_(file_prefix),
-      num_outstanding_events_(0) {}
+    : EventsWriter(file_prefix, Env::Default()) {}
+
+EventsWriter::EventsWriter(const string& file_prefix, Env* env)
+    : env_(env), file_prefix_(file_prefix), num_outstanding_events_(0) {}
 
 EventsWriter::~EventsWriter() {
   Close().IgnoreError();  // Autoclose in destructor.
@@ -45,6 +45,9 @@ class EventsWriter {
   // Note that it is not recommended to simultaneously have two
   // EventWriters writing to the same file_prefix.
   explicit EventsWriter(const std::string& file_prefix);
+  // Like the above, with the files created and timestamped through `env`,
+  // which must outlive the EventsWriter.
+  EventsWriter(const std::string& file_prefix, Env* env);
   ~EventsWriter();
 
   // Sets the event file filename and opens file for writing.  If not called by
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -113,6 +114,58 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+constexpr uint64 kVarintContinuationBits = 0x8080808080808080ULL;
+
+// Returns the number of varints in [begin, end), i.e. the number of bytes
+// without the continuation bit.  Counts eight bytes at a time.
+size_t CountVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  const uint8* p = begin;
+  for (; end - p >= 8; p += 8) {
+    uint64 word;
+    std::memcpy(&word, p, sizeof(word));
+    // Sums the (at most 8) final bytes of the word into its top byte.
+    const uint64 final_bytes = (~word & kVarintContinuationBits) >> 7;
+    count += (final_bytes * 0x0101010101010101ULL) >> 56;
+  }
+  for (; p < end; ++p) count += *p < 0x80;
+  return count;
+}
+
+// Decodes the packed varints in [begin, end), storing the first `capacity` of
+// them in `values`.  Returns false if the varints are malformed.
+//
+// Runs of eight one-byte varints, which are common for ids and counts, are
+// decoded without testing every byte.
+bool DecodePackedVarints(const uint8* begin, const uint8* end, int64_t* values,
+                         size_t capacity) {
+  const uint8* p = begin;
+  size_t index = 0;
+  while (p < end) {
+    if (end - p >= 8 && index + 8 <= capacity) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      if ((word & kVarintContinuationBits) == 0) {
+        for (int i = 0; i < 8; ++i) values[index + i] = p[i];
+        p += 8;
+        index += 8;
+        continue;
+      }
+    }
+    uint64 value = 0;
+    for (int shift = 0;; shift += 7) {
+      // At most 10 bytes, as in CodedInputStream::ReadVarint64().
+      if (p == end || shift > 63) return false;
+      const uint8 byte = *p++;
+      value |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (byte < 0x80) break;
+    }
+    if (index < capacity) values[index] = static_cast<int64_t>(value);
+    ++index;
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -301,10 +354,21 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64_t>(n));
+        // Decode the packed values straight from the buffer, after resizing
+        // the output "vector" once to hold all of them.
+        const void* packed_data;
+        int packed_size;
+        if (stream.GetDirectBufferPointer(&packed_data, &packed_size)) {
+          const uint8* begin = static_cast<const uint8*>(packed_data);
+          const uint8* end = begin + packed_size;
+          const size_t initial_size = int64_list->size();
+          int64_list->resize(initial_size + CountVarints(begin, end));
+          if (!DecodePackedVarints(begin, end,
+                                   int64_list->data() + initial_size,
+                                   int64_list->size() - initial_size)) {
+            return false;
+          }
+          if (!stream.Skip(packed_size)) return false;
         }
 
         stream.PopLimit(packed_limit);
@@ -13,12 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -249,6 +252,34 @@ static string ExampleWithSomeFeatures() {
 
 TEST(FastParse, SomeFeatures) { TestCorrectness(ExampleWithSomeFeatures()); }
 
+TEST(FastParse, PackedInt64Values) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Runs of one-byte values, mixed with values of every length.
+  for (int i = 0; i < 21; ++i) int64_list->add_value(i * 6);
+  for (int64_t value : {int64_t{127}, int64_t{128}, int64_t{16383},
+                        int64_t{16384}, int64_t{-1}, int64_t{1} << 62,
+                        std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max()}) {
+    int64_list->add_value(value);
+    for (int i = 0; i < 9; ++i) int64_list->add_value(i);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  // The packed value of 'age' has its continuation bit set.
+  const string serialized(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x8d",
+      16);
+  Example example;
+  EXPECT_FALSE(example.ParseFromString(serialized));
+  Example fast_example;
+  EXPECT_FALSE(TestFastParse(serialized, &fast_example));
+}
+
 static void AddDenseFeature(const char* feature_name, DataType dtype,
                             PartialTensorShape shape, bool variable_length,
                             size_t elements_per_stride,
@@ -423,6 +454,82 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, DenseInt64WrongSize) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  for (int i = 0; i < 20; ++i) int64_list->add_value(i);
+  std::vector<tstring> serialized = {Serialize(example)};
+
+  FastParseExampleConfig config;
+  AddDenseFeature("int64_list", DT_INT64, {16}, false, 16, &config);
+  Result result;
+  Status status =
+      FastParseExample(config, serialized, {}, nullptr, &result);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "Values size: 20"))
+      << status;
+
+  config.dense.clear();
+  AddDenseFeature("int64_list", DT_INT64, {20}, false, 20, &config);
+  TF_EXPECT_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(result.dense_values.size(), 1);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(result.dense_values[0].flat<int64_t>()(i), i);
+  }
+}
+
+// Parses batches of wide Examples, as input pipelines of ranking models do:
+// each has `num_features` features of 8 int64 ids, parsed as sparse, and
+// `num_features` features of 16 floats, parsed as dense.
+void BM_FastParseExampleWide(::testing::benchmark::State& state) {
+  const int batch_size = state.range(0);
+  const int num_features = state.range(1);
+  random::PhiloxRandom philox(42);
+  random::SimplePhilox rng(&philox);
+
+  FastParseExampleConfig config;
+  std::vector<string> names;
+  for (int i = 0; i < num_features; ++i) {
+    names.push_back(strings::StrCat("ids_", i));
+    names.push_back(strings::StrCat("floats_", i));
+  }
+  for (int i = 0; i < num_features; ++i) {
+    AddSparseFeature(names[2 * i].c_str(), DT_INT64, &config);
+    AddDenseFeature(names[2 * i + 1].c_str(), DT_FLOAT, {16}, false, 16,
+                    &config);
+  }
+
+  std::vector<tstring> serialized;
+  int64_t num_values = 0;
+  for (int e = 0; e < batch_size; ++e) {
+    Example example;
+    auto* features = example.mutable_features()->mutable_feature();
+    for (int i = 0; i < num_features; ++i) {
+      Int64List* ids = (*features)[names[2 * i]].mutable_int64_list();
+      for (int v = 0; v < 8; ++v) {
+        // Mostly small ids, with some hashed ones.
+        ids->add_value(v % 4 == 0 ? rng.Rand64() >> 1 : rng.Uniform(100));
+      }
+      FloatList* floats = (*features)[names[2 * i + 1]].mutable_float_list();
+      for (int v = 0; v < 16; ++v) floats->add_value(rng.RandFloat());
+      num_values += 8 + 16;
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  for (auto s : state) {
+    Result result;
+    TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  }
+  state.SetItemsProcessed(state.iterations() * num_values);
+}
+BENCHMARK(BM_FastParseExampleWide)
+    ->ArgPair(1, 100)
+    ->ArgPair(128, 100)
+    ->ArgPair(128, 500);
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
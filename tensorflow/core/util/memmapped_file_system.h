@@ -46,7 +46,8 @@ namespace tensorflow {
 // kMemmappedPackageDefaultGraphDef;
 //
 // A "frozen" GraphDef can be converted into this format using
-// tensorflow/contrib/util/convert_graphdef_memmapped_format
+// tensorflow/contrib/util/convert_graphdef_memmapped_format, and a whole
+// SavedModel using tensorflow/cc/tools:convert_saved_model_to_memmapped_package
 class MemmappedFileSystem : public FileSystem {
  public:
   // Memmapped regions use this prefix to distinguish from
@@ -34,6 +34,7 @@ namespace {
 constexpr char kTensor1FileName[] = "memmapped_package://t1";
 constexpr char kTensor2FileName[] = "memmapped_package://t2";
 constexpr char kProtoFileName[] = "memmapped_package://b";
+constexpr char kFileFileName[] = "memmapped_package://f.txt";
 constexpr int kTestGraphDefVersion = 666;
 
 Status CreateMemmappedFileSystemFile(const string& filename, bool corrupted,
@@ -53,6 +54,7 @@ Status CreateMemmappedFileSystemFile(const string& filename, bool corrupted,
   graph_def.mutable_versions()->set_producer(kTestGraphDefVersion);
   graph_def.mutable_versions()->set_min_consumer(kTestGraphDefVersion);
   TF_RETURN_IF_ERROR(writer.SaveProtobuf(graph_def, kProtoFileName));
+  TF_RETURN_IF_ERROR(writer.SaveFile("file contents", kFileFileName));
 
   // Save a tensor after the proto to check that alignment works.
   test::FillFn<float>(test_tensor,
@@ -82,6 +84,10 @@ TEST(MemmappedFileSystemTest, SimpleTest) {
       ReadBinaryProto(&memmapped_env, kProtoFileName, &test_graph_def));
   EXPECT_EQ(kTestGraphDefVersion, test_graph_def.versions().producer());
   EXPECT_EQ(kTestGraphDefVersion, test_graph_def.versions().min_consumer());
+  // Try to read a file from the file.
+  string file_contents;
+  TF_EXPECT_OK(ReadFileToString(&memmapped_env, kFileFileName, &file_contents));
+  EXPECT_EQ("file contents", file_contents);
   // Check that we can correctly get a tensor memory.
   std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
   TF_ASSERT_OK(memmapped_env.NewReadOnlyMemoryRegionFromFile(kTensor2FileName,
@@ -78,6 +78,28 @@ Status MemmappedFileSystemWriter::SaveProtobuf(
   return res;
 }
 
+Status MemmappedFileSystemWriter::SaveFile(StringPiece contents,
+                                           const string& element_name) {
+  if (!output_file_) {
+    return errors::FailedPrecondition(
+        "MemmappedEnvWritter: saving file into not opened file");
+  }
+  if (!MemmappedFileSystem::IsWellFormedMemmappedPackageFilename(
+          element_name)) {
+    return errors::InvalidArgument(
+        "MemmappedEnvWritter: element_name is invalid: must have memmapped "
+        "package prefix ",
+        MemmappedFileSystem::kMemmappedPackagePrefix,
+        " and include [A-Za-z0-9_.]");
+  }
+  AddToDirectoryElement(element_name, contents.size());
+  const auto res = output_file_->Append(contents);
+  if (res.ok()) {
+    output_file_offset_ += contents.size();
+  }
+  return res;
+}
+
 namespace {
 
 StringPiece EncodeUint64LittleEndian(uint64 val, char* output_buffer) {
@@ -35,6 +35,8 @@ class MemmappedFileSystemWriter {
   Status SaveTensor(const Tensor& tensor, const string& element_name);
   Status SaveProtobuf(const protobuf::MessageLite& message,
                       const string& element_name);
+  // Saves `contents` as is, e.g. the contents of an asset file.
+  Status SaveFile(StringPiece contents, const string& element_name);
   // Writes out the directory of regions and closes the output file.
   Status FlushAndClose();
 
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_MKL_UTIL_H_
 #ifdef INTEL_MKL
 
+#include <algorithm>
+#include <array>
 #include <list>
 #include <memory>
 #include <string>
@@ -32,9 +34,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/mkl_threadpool.h"
 #include "tensorflow/core/util/padding.h"
@@ -1702,6 +1706,15 @@ class MklPrimitive {
 
 const mkldnn::memory::dims NONE_DIMS = {};
 
+// Counts the lookups of the primitive caches by result: "hit", "miss" or
+// "eviction".
+inline monitoring::Counter<1>* MklPrimitiveCacheLookups() {
+  static monitoring::Counter<1>* lookups = monitoring::Counter<1>::New(
+      "/tensorflow/core/mkl/primitive_cache_lookups",
+      "The number of lookups of the oneDNN primitive caches.", "result");
+  return lookups;
+}
+
 //
 // LRUCache is a class which implements LRU (Least Recently Used) cache.
 // The implementation is similar to that of
@@ -1729,8 +1742,10 @@ class LRUCache {
   T* GetOp(const string& key) {
     auto it = cache_.find(key);
     if (it == cache_.end()) {
+      MklPrimitiveCacheLookups()->GetCell("miss")->IncrementBy(1);
       return nullptr;
     }
+    MklPrimitiveCacheLookups()->GetCell("hit")->IncrementBy(1);
 
     // Move to the front of LRU list as the most recently accessed.
     lru_list_.erase(it->second.lru_iterator);
@@ -1792,6 +1807,7 @@ class LRUCache {
     string key = lru_list_.back();
     lru_list_.pop_back();
     cache_.erase(key);
+    MklPrimitiveCacheLookups()->GetCell("eviction")->IncrementBy(1);
     return true;
   }
 
@@ -1807,19 +1823,120 @@ class LRUCache {
   std::list<string> lru_list_;
 };
 
+// SharedLRUCache is a thread-safe LRUCache shared by all the threads of the
+// process, so that threads running the same ops don't each create and keep
+// their own copy of the same objects.
+//
+// A thread keeps using the object it got after releasing the lock, while
+// other threads may evict it. So the objects are reference counted, and each
+// thread holds the last kNumHeld objects it got or set, which are destroyed
+// only once no thread holds them anymore.
+template <typename T>
+class SharedLRUCache {
+ public:
+  explicit SharedLRUCache(size_t capacity) : capacity_(capacity) {}
+
+  T* GetOp(const string& key) TF_LOCKS_EXCLUDED(mu_) {
+    std::shared_ptr<T> op;
+    {
+      mutex_lock lock(mu_);
+      auto it = cache_.find(key);
+      if (it == cache_.end()) {
+        MklPrimitiveCacheLookups()->GetCell("miss")->IncrementBy(1);
+        return nullptr;
+      }
+      MklPrimitiveCacheLookups()->GetCell("hit")->IncrementBy(1);
+      lru_list_.splice(lru_list_.begin(), lru_list_, it->second.lru_iterator);
+      op = it->second.op;
+    }
+    return Hold(std::move(op));
+  }
+
+  // Takes ownership of `op`. If another thread set an object for `key` in
+  // the meantime, `op` isn't cached, but stays valid for the calling thread.
+  void SetOp(const string& key, T* op) TF_LOCKS_EXCLUDED(mu_) {
+    std::shared_ptr<T> shared_op(op);
+    // Destroyed outside of the lock.
+    std::shared_ptr<T> evicted_op;
+    {
+      mutex_lock lock(mu_);
+      if (cache_.count(key) == 0) {
+        if (lru_list_.size() >= capacity_ && !lru_list_.empty()) {
+          auto it = cache_.find(lru_list_.back());
+          evicted_op = std::move(it->second.op);
+          cache_.erase(it);
+          lru_list_.pop_back();
+          MklPrimitiveCacheLookups()->GetCell("eviction")->IncrementBy(1);
+        }
+        lru_list_.push_front(key);
+        cache_.emplace(key, Entry{shared_op, lru_list_.begin()});
+      }
+    }
+    Hold(std::move(shared_op));
+  }
+
+  size_t size() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock lock(mu_);
+    return cache_.size();
+  }
+
+  void Clear() TF_LOCKS_EXCLUDED(mu_) {
+    std::unordered_map<string, Entry> cache;
+    {
+      mutex_lock lock(mu_);
+      std::swap(cache, cache_);
+      lru_list_.clear();
+    }
+  }
+
+ private:
+  static constexpr int kNumHeld = 4;
+
+  struct Entry {
+    std::shared_ptr<T> op;
+    typename std::list<string>::iterator lru_iterator;
+  };
+
+  // Keeps `op` alive for the calling thread, in place of the object it held
+  // the longest.
+  T* Hold(std::shared_ptr<T> op) {
+    static thread_local std::array<std::shared_ptr<T>, kNumHeld> held;
+    static thread_local int next = 0;
+    T* raw_op = op.get();
+    held[next] = std::move(op);
+    next = (next + 1) % kNumHeld;
+    return raw_op;
+  }
+
+  const size_t capacity_;
+  mutex mu_;
+  std::unordered_map<string, Entry> cache_ TF_GUARDED_BY(mu_);
+  std::list<string> lru_list_ TF_GUARDED_BY(mu_);
+};
+
 template <typename T>
 class MklPrimitiveFactory {
  public:
   MklPrimitiveFactory() {}
+  // Factories whose primitives serialize their Execute calls can be shared
+  // by all threads, see IsPrimitiveCacheShared.
+  explicit MklPrimitiveFactory(bool shareable) : shareable_(shareable) {}
 
   ~MklPrimitiveFactory() {}
 
   MklPrimitive* GetOp(const string& key) {
+    if (shareable_ && IsPrimitiveCacheShared()) {
+      return GetSharedLRUCache().GetOp(key);
+    }
     auto& lru_cache = MklPrimitiveFactory<T>::GetLRUCache();
     return lru_cache.GetOp(key);
   }
 
   void SetOp(const string& key, MklPrimitive* op) {
+    if (shareable_ && IsPrimitiveCacheShared()) {
+      GetSharedLRUCache().SetOp(key, op);
+      return;
+    }
     auto& lru_cache = MklPrimitiveFactory<T>::GetLRUCache();
     lru_cache.SetOp(key, op);
   }
@@ -1845,12 +1962,45 @@ class MklPrimitiveFactory {
     return is_primitive_mem_opt_enabled;
   }
 
+  /// Function to check whether the primitives of the shareable factories are
+  /// cached once per process rather than once per thread. This bounds the
+  /// memory of the primitives regardless of the number of threads, but
+  /// threads running the same primitive at the same time take turns.
+  static inline bool IsPrimitiveCacheShared() {
+    static const bool is_primitive_cache_shared = [] {
+      bool value = false;
+      TF_CHECK_OK(ReadBoolFromEnvVar("TF_MKL_SHARE_PRIMITIVE_CACHE", false,
+                                     &value));
+      return value;
+    }();
+    return is_primitive_cache_shared;
+  }
+
+  /// The maximum number of primitives kept by each cache.
+  static inline int64_t PrimitiveCacheCapacity() {
+    static const int64_t capacity = [] {
+      int64_t value = 1024;
+      TF_CHECK_OK(ReadInt64FromEnvVar("TF_MKL_PRIMITIVE_CACHE_CAPACITY", 1024,
+                                      &value));
+      return std::max<int64_t>(value, 1);
+    }();
+    return capacity;
+  }
+
  private:
   static inline LRUCache<MklPrimitive>& GetLRUCache() {
-    static const int kCapacity = 1024;  // cache capacity
-    static thread_local LRUCache<MklPrimitive> lru_cache_(kCapacity);
+    static thread_local LRUCache<MklPrimitive> lru_cache_(
+        PrimitiveCacheCapacity());
     return lru_cache_;
   }
+
+  static inline SharedLRUCache<MklPrimitive>& GetSharedLRUCache() {
+    static SharedLRUCache<MklPrimitive>* shared_lru_cache =
+        new SharedLRUCache<MklPrimitive>(PrimitiveCacheCapacity());
+    return *shared_lru_cache;
+  }
+
+  const bool shareable_ = false;
 };
 
 // utility class for creating keys of MKL primitive pool.
@@ -16,7 +16,9 @@ limitations under the License.
 #ifdef INTEL_MKL
 
 #include "tensorflow/core/util/mkl_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace {
@@ -115,6 +117,51 @@ TEST(MklUtilTest, LRUCacheTest) {
   }
 }
 
+TEST(MklUtilTest, SharedLRUCacheTest) {
+  size_t capacity = 8;
+  SharedLRUCache<int> lru_cache(capacity);
+
+  // A second object set for the same key isn't cached, but stays valid.
+  lru_cache.SetOp("0", new int(0));
+  int* duplicate = new int(1);
+  lru_cache.SetOp("0", duplicate);
+  EXPECT_EQ(*duplicate, 1);
+  EXPECT_EQ(*lru_cache.GetOp("0"), 0);
+
+  // An evicted object stays valid for the thread that got it, until it got
+  // a few more.
+  SharedLRUCache<int> small_lru_cache(2);
+  small_lru_cache.SetOp("a", new int(0));
+  int* evicted = small_lru_cache.GetOp("a");
+  small_lru_cache.SetOp("b", new int(1));
+  small_lru_cache.SetOp("c", new int(2));
+  EXPECT_EQ(small_lru_cache.size(), 2);
+  EXPECT_EQ(nullptr, small_lru_cache.GetOp("a"));
+  EXPECT_EQ(*evicted, 0);
+
+  // Threads looking up and setting the same keys share the cached objects.
+  {
+    thread::ThreadPool pool(Env::Default(), "shared_lru_cache", 8);
+    for (int i = 0; i < 64; ++i) {
+      pool.Schedule([&lru_cache, i]() {
+        for (int k = 0; k < 100; ++k) {
+          const string key = std::to_string((i + k) % (2 * capacity));
+          int* op = lru_cache.GetOp(key);
+          if (op == nullptr) {
+            op = new int(std::stoi(key));
+            lru_cache.SetOp(key, op);
+          }
+          EXPECT_EQ(*op, std::stoi(key));
+        }
+      });
+    }
+  }
+  EXPECT_EQ(lru_cache.size(), capacity);
+
+  lru_cache.Clear();
+  EXPECT_EQ(lru_cache.size(), 0);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
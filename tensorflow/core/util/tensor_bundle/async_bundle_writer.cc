@@ -0,0 +1,231 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
+
+#include <utility>
+
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+namespace {
+
+Status WriteBundle(Env* env, const string& prefix,
+                   const std::vector<AsyncBundleWriter::Entry>& entries) {
+  BundleWriter writer(env, prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (const AsyncBundleWriter::Entry& entry : entries) {
+    if (entry.is_slice) {
+      TF_RETURN_IF_ERROR(writer.AddSlice(entry.key, entry.full_shape,
+                                         entry.slice_spec, entry.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(entry.key, entry.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+}  // namespace
+
+AsyncBundleWriter* AsyncBundleWriter::Global() {
+  static AsyncBundleWriter* writer = []() -> AsyncBundleWriter* {
+    bool enabled = false;
+    Status s =
+        ReadBoolFromEnvVar("TF_ASYNC_CHECKPOINT_WRITES", false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    if (!enabled) return nullptr;
+    int64_t max_inflight_mb;
+    s = ReadInt64FromEnvVar("TF_ASYNC_CHECKPOINT_MAX_INFLIGHT_MB", 1024,
+                            &max_inflight_mb);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    return new AsyncBundleWriter(Env::Default(), max_inflight_mb << 20);
+  }();
+  return writer;
+}
+
+AsyncBundleWriter::AsyncBundleWriter(Env* env, int64_t max_inflight_bytes)
+    : env_(env), max_inflight_bytes_(max_inflight_bytes) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "async_bundle_writer",
+                                  [this]() { WorkLoop(); }));
+}
+
+AsyncBundleWriter::~AsyncBundleWriter() {
+  {
+    mutex_lock l(mu_);
+    shutdown_ = true;
+    cv_.notify_all();
+  }
+  // Joins the thread, which drains the queue first.
+  thread_.reset();
+}
+
+Status AsyncBundleWriter::ScheduleWrite(const string& prefix,
+                                        std::vector<Entry> entries) {
+  int64_t bytes = 0;
+  for (const Entry& entry : entries) {
+    bytes += entry.tensor.TotalBytes();
+  }
+  {
+    mutex_lock l(mu_);
+    // A snapshot larger than the budget is taken once nothing else is pending.
+    while (inflight_bytes_ > 0 &&
+           inflight_bytes_ + bytes > max_inflight_bytes_) {
+      cv_.wait(l);
+    }
+    inflight_bytes_ += bytes;
+  }
+
+  // The caller may update the tensors as soon as this returns.
+  for (Entry& entry : entries) {
+    entry.tensor = tensor::DeepCopy(entry.tensor);
+  }
+  VLOG(1) << "Scheduled the write of " << entries.size() << " tensors ("
+          << bytes << " bytes) to " << prefix;
+
+  Work work;
+  work.prefix = prefix;
+  work.bytes = bytes;
+  work.fn = [env = env_, prefix, entries = std::move(entries)]() {
+    return WriteBundle(env, prefix, entries);
+  };
+  return Schedule(std::move(work));
+}
+
+Status AsyncBundleWriter::ScheduleMerge(std::vector<string> prefixes,
+                                        const string& merged_prefix,
+                                        std::function<void()> after) {
+  Work work;
+  work.prefix = merged_prefix;
+  work.fn = [env = env_, prefixes = std::move(prefixes), merged_prefix,
+             after = std::move(after)]() {
+    std::vector<tstring> input_prefixes(prefixes.begin(), prefixes.end());
+    TF_RETURN_IF_ERROR(MergeBundles(env, input_prefixes, merged_prefix));
+    if (after) after();
+    return Status::OK();
+  };
+  return Schedule(std::move(work));
+}
+
+Status AsyncBundleWriter::Schedule(Work work) {
+  mutex_lock l(mu_);
+  ++prefixes_[work.prefix].pending;
+  queue_.push_back(std::move(work));
+  cv_.notify_all();
+  Status s = unreported_status_;
+  unreported_status_ = Status::OK();
+  return s;
+}
+
+void AsyncBundleWriter::WorkLoop() {
+  while (true) {
+    Work work;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !shutdown_) {
+        cv_.wait(l);
+      }
+      if (queue_.empty()) return;
+      work = std::move(queue_.front());
+      queue_.pop_front();
+      running_ = true;
+    }
+
+    const Status s = work.fn();
+    if (!s.ok()) {
+      LOG(ERROR) << "Asynchronous checkpoint write to " << work.prefix
+                 << " failed: " << s;
+    }
+
+    std::vector<std::function<void(const Status&)>> callbacks;
+    Status prefix_status;
+    {
+      mutex_lock l(mu_);
+      running_ = false;
+      inflight_bytes_ -= work.bytes;
+      unreported_status_.Update(s);
+      PrefixState& state = prefixes_[work.prefix];
+      state.status.Update(s);
+      if (--state.pending == 0) {
+        callbacks.swap(state.callbacks);
+        prefix_status = state.status;
+        if (state.status.ok()) prefixes_.erase(work.prefix);
+      }
+      cv_.notify_all();
+    }
+    for (const auto& callback : callbacks) {
+      callback(prefix_status);
+    }
+  }
+}
+
+Status AsyncBundleWriter::WaitFor(const string& prefix) {
+  mutex_lock l(mu_);
+  while (true) {
+    auto it = prefixes_.find(prefix);
+    if (it == prefixes_.end()) return Status::OK();
+    if (it->second.pending == 0) {
+      // Only failures are kept once the work is done; report them once.
+      Status s = it->second.status;
+      prefixes_.erase(it);
+      return s;
+    }
+    cv_.wait(l);
+  }
+}
+
+void AsyncBundleWriter::WhenDone(const string& prefix,
+                                 std::function<void(const Status&)> done) {
+  Status s;
+  {
+    mutex_lock l(mu_);
+    auto it = prefixes_.find(prefix);
+    if (it != prefixes_.end()) {
+      if (it->second.pending > 0) {
+        it->second.callbacks.push_back(std::move(done));
+        return;
+      }
+      s = it->second.status;
+    }
+  }
+  done(s);
+}
+
+Status AsyncBundleWriter::Flush() {
+  mutex_lock l(mu_);
+  while (!queue_.empty() || running_) {
+    cv_.wait(l);
+  }
+  Status s = unreported_status_;
+  unreported_status_ = Status::OK();
+  return s;
+}
+
+int64_t AsyncBundleWriter::inflight_bytes() const {
+  mutex_lock l(mu_);
+  return inflight_bytes_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,145 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Writes tensor bundles in the background, so that ops saving checkpoints can
+// return as soon as the tensors they save are snapshotted, and the training
+// steps that follow overlap with the writes.
+//
+// Work runs on one background thread in the order it is scheduled, so a merge
+// scheduled after the writes of its input bundles sees them complete.  The
+// snapshots of pending writes are bounded by `max_inflight_bytes`: scheduling a
+// write blocks until the snapshots of earlier writes fit.
+//
+// Errors of the background work are reported by WaitFor() for the prefixes
+// concerned.  The first error not yet reported by Flush(), ScheduleWrite() or
+// ScheduleMerge() is returned by the next call to one of them, so that a
+// training loop saving periodically learns of a failed save.
+//
+// This class is thread-safe.
+class AsyncBundleWriter {
+ public:
+  // A tensor to save, with the arguments of BundleWriter::Add() or, if
+  // `is_slice` is true, of BundleWriter::AddSlice().
+  struct Entry {
+    string key;
+    Tensor tensor;
+    bool is_slice = false;
+    TensorShape full_shape;
+    TensorSlice slice_spec;
+  };
+
+  // Returns the process-wide writer used by the SaveV2 and MergeV2Checkpoints
+  // kernels, or nullptr if TF_ASYNC_CHECKPOINT_WRITES is not set.  The budget
+  // for pending snapshots is TF_ASYNC_CHECKPOINT_MAX_INFLIGHT_MB (1024 by
+  // default).
+  //
+  // The global writer is never destroyed, so callers must Flush() it before
+  // the process exits to make sure their checkpoints are complete.
+  static AsyncBundleWriter* Global();
+
+  AsyncBundleWriter(Env* env, int64_t max_inflight_bytes);
+
+  // Waits for all scheduled work to complete.
+  ~AsyncBundleWriter();
+
+  // Snapshots the tensors of "entries" and schedules writing them to the
+  // bundle "prefix".
+  Status ScheduleWrite(const string& prefix, std::vector<Entry> entries)
+      TF_MUST_USE_RESULT;
+
+  // Schedules merging the bundles "prefixes" into "merged_prefix", as
+  // MergeBundles() does, and then running "after", e.g. to clean up the
+  // inputs.
+  Status ScheduleMerge(std::vector<string> prefixes,
+                       const string& merged_prefix,
+                       std::function<void()> after = nullptr)
+      TF_MUST_USE_RESULT;
+
+  // Blocks until all work scheduled so far for "prefix" has completed, and
+  // returns its status.
+  Status WaitFor(const string& prefix);
+
+  // Calls "done" once all work scheduled so far for "prefix" has completed,
+  // with its status.  Lets a checkpoint manager learn when a checkpoint is
+  // complete without blocking.  "done" may be called from this thread.
+  void WhenDone(const string& prefix, std::function<void(const Status&)> done);
+
+  // Blocks until all scheduled work has completed, and returns the first error
+  // not yet reported.
+  Status Flush();
+
+  // Returns the total size of the snapshots of pending writes.
+  int64_t inflight_bytes() const;
+
+ private:
+  struct Work {
+    string prefix;
+    int64_t bytes = 0;
+    std::function<Status()> fn;
+  };
+
+  // The state of the work scheduled for one prefix.
+  struct PrefixState {
+    int pending = 0;
+    Status status;
+    std::vector<std::function<void(const Status&)>> callbacks;
+  };
+
+  Status Schedule(Work work);
+  void WorkLoop();
+
+  Env* const env_;
+  const int64_t max_inflight_bytes_;
+
+  mutable mutex mu_;
+  condition_variable cv_;
+  std::deque<Work> queue_ TF_GUARDED_BY(mu_);
+  bool running_ TF_GUARDED_BY(mu_) = false;  // Whether work is executing.
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  int64_t inflight_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // Prefixes with pending work, or whose failure WaitFor() has not reported.
+  std::unordered_map<string, PrefixState> prefixes_ TF_GUARDED_BY(mu_);
+  Status unreported_status_ TF_GUARDED_BY(mu_);
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncBundleWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_BUNDLE_WRITER_H_
@@ -0,0 +1,123 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_bundle_writer.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& prefix) {
+  return strings::StrCat(testing::TmpDir(), "/", prefix);
+}
+
+Tensor Constant(float v, int64_t n) {
+  Tensor t(DT_FLOAT, TensorShape({n}));
+  t.flat<float>().setConstant(v);
+  return t;
+}
+
+void ExpectRestored(const string& prefix, const string& key,
+                    const Tensor& expected) {
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup(key, &val));
+  test::ExpectTensorEqual<float>(val, expected);
+}
+
+TEST(AsyncBundleWriterTest, WritesSnapshots) {
+  AsyncBundleWriter writer(Env::Default(), /*max_inflight_bytes=*/1 << 20);
+  Tensor t = Constant(1, 100);
+  std::vector<AsyncBundleWriter::Entry> entries(1);
+  entries[0].key = "a";
+  entries[0].tensor = t;
+  TF_ASSERT_OK(writer.ScheduleWrite(Prefix("snapshot"), std::move(entries)));
+  // Updates after scheduling are not saved.
+  t.flat<float>().setConstant(2);
+
+  TF_ASSERT_OK(writer.WaitFor(Prefix("snapshot")));
+  EXPECT_EQ(writer.inflight_bytes(), 0);
+  ExpectRestored(Prefix("snapshot"), "a", Constant(1, 100));
+}
+
+TEST(AsyncBundleWriterTest, MergesAfterWrites) {
+  AsyncBundleWriter writer(Env::Default(), /*max_inflight_bytes=*/1 << 20);
+  std::vector<string> prefixes;
+  for (int i = 0; i < 4; ++i) {
+    std::vector<AsyncBundleWriter::Entry> entries(1);
+    entries[0].key = strings::StrCat("t", i);
+    entries[0].tensor = Constant(i, 1000);
+    prefixes.push_back(Prefix(strings::StrCat("shard", i)));
+    TF_ASSERT_OK(writer.ScheduleWrite(prefixes.back(), std::move(entries)));
+  }
+  bool after_ran = false;
+  TF_ASSERT_OK(writer.ScheduleMerge(prefixes, Prefix("merged"),
+                                    [&after_ran]() { after_ran = true; }));
+  Notification done;
+  Status done_status = errors::Unknown("not called");
+  writer.WhenDone(Prefix("merged"), [&](const Status& s) {
+    done_status = s;
+    done.Notify();
+  });
+  done.WaitForNotification();
+  TF_ASSERT_OK(done_status);
+  EXPECT_TRUE(after_ran);
+  for (int i = 0; i < 4; ++i) {
+    ExpectRestored(Prefix("merged"), strings::StrCat("t", i),
+                   Constant(i, 1000));
+  }
+}
+
+TEST(AsyncBundleWriterTest, BoundsInflightBytes) {
+  constexpr int64_t kMaxInflightBytes = 64 << 10;
+  AsyncBundleWriter writer(Env::Default(), kMaxInflightBytes);
+  for (int i = 0; i < 10; ++i) {
+    std::vector<AsyncBundleWriter::Entry> entries(1);
+    entries[0].key = "a";
+    entries[0].tensor = Constant(i, 4 << 10);  // 16KB.
+    TF_ASSERT_OK(writer.ScheduleWrite(Prefix(strings::StrCat("bounded", i)),
+                                      std::move(entries)));
+    EXPECT_LE(writer.inflight_bytes(), kMaxInflightBytes);
+  }
+  // A snapshot larger than the budget is still written.
+  std::vector<AsyncBundleWriter::Entry> entries(1);
+  entries[0].key = "a";
+  entries[0].tensor = Constant(1, 64 << 10);
+  TF_ASSERT_OK(writer.ScheduleWrite(Prefix("large"), std::move(entries)));
+  TF_ASSERT_OK(writer.Flush());
+  EXPECT_EQ(writer.inflight_bytes(), 0);
+  ExpectRestored(Prefix("large"), "a", Constant(1, 64 << 10));
+}
+
+TEST(AsyncBundleWriterTest, ReportsErrors) {
+  AsyncBundleWriter writer(Env::Default(), /*max_inflight_bytes=*/1 << 20);
+  // Merging bundles that do not exist fails in the background.
+  TF_ASSERT_OK(writer.ScheduleMerge({Prefix("missing")}, Prefix("bad_merge")));
+  EXPECT_FALSE(writer.WaitFor(Prefix("bad_merge")).ok());
+  // The failure is reported once more, by the next scheduling call or flush.
+  EXPECT_FALSE(writer.Flush().ok());
+  TF_EXPECT_OK(writer.Flush());
+  TF_EXPECT_OK(writer.WaitFor(Prefix("bad_merge")));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,11 +16,14 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -33,8 +36,10 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -44,6 +49,9 @@ limitations under the License.
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap.h"
@@ -383,6 +391,14 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// The bloom filter stored in metadata tables, which lets BundleReader answer
+// lookups of absent keys without reading a data block.  Older releases ignore
+// the filter block.
+const table::FilterPolicy* MetadataFilterPolicy() {
+  static const table::FilterPolicy* policy = table::NewBloomFilterPolicy(10);
+  return policy;
+}
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -390,6 +406,7 @@ table::Options TableBuilderOptions() {
   // (version 1.2) with the intention that they will be enabled again at
   // some point (perhaps the 1.3 release?).
   o.compression = table::kNoCompression;
+  o.filter_policy = MetadataFilterPolicy();
   return o;
 }
 
@@ -541,6 +558,7 @@ Status BundleWriter::Finish() {
     // platforms (e.g. Android).  The metadata file is small, so this is fine.
     table::Options options;
     options.compression = table::kNoCompression;
+    options.filter_policy = MetadataFilterPolicy();
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
@@ -741,11 +759,101 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
   return status;
 }
 
+// A memory-mapped data file, shared by the reader that mapped it and the
+// tensors aliasing it.
+class MappedBundleDataFile : public core::RefCounted {
+ public:
+  explicit MappedBundleDataFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const { return static_cast<const char*>(region_->data()); }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+namespace {
+
+// A tensor buffer aliasing part of a mapped data file.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(MappedBundleDataFile* file, uint64 offset, size_t size)
+      : TensorBuffer(const_cast<char*>(file->data()) + offset),
+        file_(file),
+        size_(size) {
+    file_->Ref();
+  }
+  ~MappedTensorBuffer() override { file_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name("tensor_bundle_mmap");
+  }
+  bool GetAllocatedBytes(size_t*) const override { return false; }
+
+  // The mapping is read-only, so the buffer must never be forwarded to a
+  // kernel that writes to it.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  MappedBundleDataFile* const file_;
+  const size_t size_;
+};
+
+// The reader options registered by ScopedBundleReaderOptions.
+struct RegisteredReaderOptions {
+  mutex mu;
+  // The options for each prefix, with the number of live registrations.
+  std::unordered_map<string, std::pair<BundleReader::Options, int>> by_prefix
+      TF_GUARDED_BY(mu);
+};
+
+RegisteredReaderOptions* GetRegisteredReaderOptions() {
+  static RegisteredReaderOptions* registered = new RegisteredReaderOptions;
+  return registered;
+}
+
+BundleReader::Options ReaderOptionsForPrefix(StringPiece prefix) {
+  RegisteredReaderOptions* registered = GetRegisteredReaderOptions();
+  mutex_lock l(registered->mu);
+  auto it = registered->by_prefix.find(string(prefix));
+  if (it == registered->by_prefix.end()) return BundleReader::Options();
+  return it->second.first;
+}
+
+}  // namespace
+
+ScopedBundleReaderOptions::ScopedBundleReaderOptions(
+    StringPiece prefix, const BundleReader::Options& options)
+    : prefix_(prefix) {
+  RegisteredReaderOptions* registered = GetRegisteredReaderOptions();
+  mutex_lock l(registered->mu);
+  auto it = registered->by_prefix.emplace(prefix_, std::make_pair(options, 0))
+                .first;
+  ++it->second.second;
+}
+
+ScopedBundleReaderOptions::~ScopedBundleReaderOptions() {
+  RegisteredReaderOptions* registered = GetRegisteredReaderOptions();
+  mutex_lock l(registered->mu);
+  auto it = registered->by_prefix.find(prefix_);
+  if (--it->second.second == 0) registered->by_prefix.erase(it);
+}
+
 // Interface for reading a tensor bundle.
 
 BundleReader::BundleReader(Env* env, StringPiece prefix)
+    : BundleReader(env, prefix, ReaderOptionsForPrefix(prefix)) {}
+
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       index_cache_(nullptr),
@@ -763,6 +871,7 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   metadata_ = wrapper.release();
 
   table::Options o;
+  o.filter_policy = MetadataFilterPolicy();
   int64_t cache_size;
   Status s =
       ReadInt64FromEnvVar("TF_TABLE_INDEX_CACHE_SIZE_IN_MB", 0, &cache_size);
@@ -817,6 +926,9 @@ BundleReader::~BundleReader() {
   for (auto& temp : tensor_slices_) {
     delete temp.second;
   }
+  for (auto& temp : mapped_data_) {
+    if (temp.second != nullptr) temp.second->Unref();
+  }
   data_.clear();
   tensor_slices_.clear();
 }
@@ -825,6 +937,9 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
   TF_CHECK_OK(status_);
+  if (!table_->KeyMayMatch(key)) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
   Seek(key);
   if (!iter_->Valid() || iter_->key() != key) {
     return errors::NotFound("Key ", key, " not found in checkpoint");
@@ -842,7 +957,91 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
+Status BundleReader::GetDataFile(int32_t shard_id,
+                                 io::InputBuffer** buffered_file) {
+  // Open the data file if it has not been opened.
+  *buffered_file = data_[shard_id];
+  if (*buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    *buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    data_[shard_id] = *buffered_file;
+  }
+  return Status::OK();
+}
+
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry,
+                                    Tensor* val, bool* mapped) {
+  *mapped = false;
+  const TensorShape stored_shape(entry.shape());
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || need_to_swap_bytes_ ||
+      entry.size() == 0) {
+    return Status::OK();
+  }
+  if (val->NumElements() != 0 &&
+      (val->dtype() != entry.dtype() || val->shape() != stored_shape)) {
+    // Let GetValue() report the mismatch.
+    return Status::OK();
+  }
+  const uint64 expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+
+  // Map the data file if it has not been mapped.
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    const string filename =
+        DataFilename(prefix_, entry.shard_id(), num_shards_);
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    MappedBundleDataFile* file = nullptr;
+    if (s.ok()) {
+      file = new MappedBundleDataFile(std::move(region));
+    } else {
+      VLOG(1) << "Unable to map " << filename << ", reading it instead: " << s;
+    }
+    it = mapped_data_.emplace(entry.shard_id(), file).first;
+  }
+  MappedBundleDataFile* file = it->second;
+  if (file == nullptr || entry.offset() + entry.size() > file->length()) {
+    return Status::OK();
+  }
+  const char* data = file->data() + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment !=
+      0) {
+    return Status::OK();
+  }
+
+  if (options_.verify_mapped_checksums) {
+    const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the mapped bytes ", actual_crc32c);
+    }
+  }
+  core::RefCountPtr<TensorBuffer> buf(
+      new MappedTensorBuffer(file, entry.offset(), entry.size()));
+  *val = Tensor(entry.dtype(), stored_shape, std::move(buf));
+  *mapped = true;
+  return Status::OK();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (options_.use_mmap) {
+    bool mapped;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &mapped));
+    if (mapped) return Status::OK();
+  }
+
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
@@ -871,17 +1070,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -952,6 +1142,226 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+namespace {
+
+// A tensor to be read by BundleReader::BatchLookup().
+struct BatchedTensor {
+  string key;
+  BundleEntryProto entry;
+  Tensor* val;
+};
+
+// One read of a data file, covering one or more tensors.
+struct CoalescedRead {
+  RandomAccessFile* file;
+  int32 shard_id;
+  uint64 offset;
+  uint64 size;
+  std::vector<BatchedTensor*> tensors;
+};
+
+// Returns the buffer that `read` reads into, which is the tensor itself if it
+// covers only one tensor.
+char* CoalescedReadBuffer(const CoalescedRead& read,
+                          std::unique_ptr<char[]>* scratch) {
+  if (read.tensors.size() == 1) {
+    return const_cast<char*>(read.tensors[0]->val->tensor_data().data());
+  }
+  scratch->reset(new char[read.size]);
+  return scratch->get();
+}
+
+// Checks the result of `read` and copies it into the tensors it covers.
+Status FinishCoalescedRead(const CoalescedRead& read, const Status& status,
+                           StringPiece result, StringPiece prefix,
+                           bool need_to_swap_bytes) {
+  TF_RETURN_IF_ERROR(status);
+  if (result.size() != read.size) {
+    return errors::DataLoss("Requested ", read.size, " bytes at offset ",
+                            read.offset, " of shard ", read.shard_id,
+                            " of TensorBundle at ", prefix, " but read ",
+                            result.size());
+  }
+
+  for (BatchedTensor* tensor : read.tensors) {
+    const BundleEntryProto& entry = tensor->entry;
+    char* backing_buffer =
+        const_cast<char*>(tensor->val->tensor_data().data());
+    const char* data = result.data() + (entry.offset() - read.offset);
+    if (data != backing_buffer) {
+      memmove(backing_buffer, data, entry.size());
+    }
+    // Note that we compute the checksum *before* byte-swapping. The checksum
+    // should be on the bytes in the order they appear in the file.
+    const uint32 actual_crc32c = crc32c::Value(backing_buffer, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+    if (need_to_swap_bytes) {
+      TF_RETURN_IF_ERROR(ByteSwapTensor(tensor->val));
+    }
+  }
+  return Status::OK();
+}
+
+Status ExecuteCoalescedRead(const CoalescedRead& read, StringPiece prefix,
+                            bool need_to_swap_bytes) {
+  std::unique_ptr<char[]> scratch;
+  char* buffer = CoalescedReadBuffer(read, &scratch);
+  StringPiece result;
+  const Status status =
+      read.file->Read(read.offset, read.size, &result, buffer);
+  return FinishCoalescedRead(read, status, result, prefix, need_to_swap_bytes);
+}
+
+// Issues `reads`, which are all of the same file, with one
+// RandomAccessFile::ReadBatch() call, so that file systems that support it can
+// serve them concurrently.
+Status ExecuteCoalescedReads(const CoalescedRead* reads, size_t num_reads,
+                             StringPiece prefix, bool need_to_swap_bytes) {
+  if (num_reads == 1) {
+    return ExecuteCoalescedRead(reads[0], prefix, need_to_swap_bytes);
+  }
+  std::vector<std::unique_ptr<char[]>> scratch(num_reads);
+  std::vector<RandomAccessFile::ReadRequest> requests(num_reads);
+  for (size_t i = 0; i < num_reads; ++i) {
+    requests[i].offset = reads[i].offset;
+    requests[i].n = reads[i].size;
+    requests[i].scratch = CoalescedReadBuffer(reads[i], &scratch[i]);
+  }
+  reads[0].file->ReadBatch(&requests).IgnoreError();
+  for (size_t i = 0; i < num_reads; ++i) {
+    TF_RETURN_IF_ERROR(FinishCoalescedRead(reads[i], requests[i].status,
+                                           requests[i].result, prefix,
+                                           need_to_swap_bytes));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status BundleReader::BatchLookup(gtl::ArraySlice<string> keys,
+                                 gtl::ArraySlice<Tensor*> vals,
+                                 const BatchLookupOptions& options) {
+  if (keys.size() != vals.size()) {
+    return errors::InvalidArgument("Got ", keys.size(), " keys but ",
+                                   vals.size(), " tensors");
+  }
+
+  // Tensors with a fixed-size encoding are batched; the others are looked up
+  // right away.
+  std::vector<BatchedTensor> batched;
+  batched.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty()) {
+      TF_RETURN_IF_ERROR(GetSliceValue(
+          keys[i], entry,
+          /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()),
+          vals[i]));
+      continue;
+    }
+    if (!DataTypeCanUseMemcpy(entry.dtype()) || options_.use_mmap) {
+      TF_RETURN_IF_ERROR(GetValue(entry, vals[i]));
+      continue;
+    }
+
+    Tensor* val = vals[i];
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+    }
+    if (entry.size() != val->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", val->TotalBytes());
+    }
+    if (entry.size() == 0) continue;
+    batched.push_back({keys[i], std::move(entry), val});
+  }
+  if (batched.empty()) return Status::OK();
+
+  // Coalesces the reads of tensors that are close to each other in the same
+  // data file.
+  std::sort(batched.begin(), batched.end(),
+            [](const BatchedTensor& a, const BatchedTensor& b) {
+              return std::make_pair(a.entry.shard_id(), a.entry.offset()) <
+                     std::make_pair(b.entry.shard_id(), b.entry.offset());
+            });
+  std::vector<CoalescedRead> reads;
+  for (BatchedTensor& tensor : batched) {
+    const BundleEntryProto& entry = tensor.entry;
+    const uint64 end = entry.offset() + entry.size();
+    if (!reads.empty()) {
+      CoalescedRead& last = reads.back();
+      const uint64 last_end = last.offset + last.size;
+      if (last.shard_id == entry.shard_id() && entry.offset() >= last_end &&
+          entry.offset() - last_end <= options.max_coalesce_gap_bytes &&
+          end - last.offset <= options.max_coalesced_read_bytes) {
+        last.size = end - last.offset;
+        last.tensors.push_back(&tensor);
+        continue;
+      }
+    }
+    io::InputBuffer* buffered_file;
+    TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+    reads.push_back({buffered_file->file(), entry.shard_id(), entry.offset(),
+                     entry.size(), {&tensor}});
+  }
+
+  if (reads.size() == 1 || options.num_threads <= 1) {
+    // Batches the reads of each data file, up to max_inflight_bytes at once.
+    size_t begin = 0;
+    while (begin < reads.size()) {
+      size_t end = begin + 1;
+      int64_t batch_bytes = reads[begin].size;
+      while (end < reads.size() && reads[end].file == reads[begin].file &&
+             batch_bytes + reads[end].size <= options.max_inflight_bytes) {
+        batch_bytes += reads[end].size;
+        ++end;
+      }
+      TF_RETURN_IF_ERROR(ExecuteCoalescedReads(&reads[begin], end - begin,
+                                               prefix_, need_to_swap_bytes_));
+      begin = end;
+    }
+    return Status::OK();
+  }
+
+  // Issues the reads concurrently, bounding the bytes in flight.
+  mutex mu;
+  condition_variable cv;
+  int64_t inflight_bytes = 0;
+  Status status;
+  {
+    thread::ThreadPool pool(
+        env_, "bundle_batch_lookup",
+        std::min<int64_t>(options.num_threads, reads.size()));
+    for (const CoalescedRead& read : reads) {
+      {
+        mutex_lock l(mu);
+        while (inflight_bytes > 0 &&
+               inflight_bytes + read.size > options.max_inflight_bytes) {
+          cv.wait(l);
+        }
+        if (!status.ok()) break;
+        inflight_bytes += read.size;
+      }
+      pool.Schedule([this, &read, &mu, &cv, &inflight_bytes, &status]() {
+        Status s = ExecuteCoalescedRead(read, prefix_, need_to_swap_bytes_);
+        mutex_lock l(mu);
+        inflight_bytes -= read.size;
+        status.Update(s);
+        cv.notify_all();
+      });
+    }
+  }
+  return status;
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1106,6 +1516,7 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
 }
 
 bool BundleReader::Contains(StringPiece key) {
+  if (!table_->KeyMayMatch(key)) return false;
   Seek(key);
   return Valid() && (this->key() == key);
 }
@@ -85,6 +85,7 @@ limitations under the License.
 namespace tensorflow {
 
 class FileOutputBuffer;
+class MappedBundleDataFile;
 
 // Versioning of the tensor bundle format.
 // Follows the same rules as 3p/tf/core/public/version.h.
@@ -183,15 +184,48 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
+  struct Options {
+    Options() {}
+    // If true, the data files are memory-mapped, and restored tensors that are
+    // uncompressed, memcpy-able, stored in the host's byte order and aligned to
+    // Allocator::kAllocatorAlignment alias the mapping instead of being copied
+    // into a new buffer.  Such tensors never forward their buffer, so kernels
+    // updating them in place copy them first.  Tensors that do not qualify, or
+    // files whose filesystem does not support mapping, are read as usual.
+    //
+    // The data files must not be modified while any aliasing tensor is alive.
+    bool use_mmap = false;
+    // If false, the checksums of tensors that alias the mapping are not
+    // verified, so that restoring them does not read the whole file and pages
+    // are only faulted in when the tensor is used.
+    bool verify_mapped_checksums = true;
+  };
+
+  struct BatchLookupOptions {
+    BatchLookupOptions() {}
+    // The number of threads issuing reads concurrently.
+    int num_threads = 8;
+    // The maximum number of bytes being read at once.  A single read larger
+    // than this is issued once no other read is in flight.
+    int64_t max_inflight_bytes = 256 << 20;
+    // Reads of tensors stored in the same data file that are at most this many
+    // bytes apart are coalesced into one read, up to max_coalesced_read_bytes.
+    int64_t max_coalesce_gap_bytes = 64 << 10;
+    int64_t max_coalesced_read_bytes = 16 << 20;
+  };
+
+  // Uses the options registered for "prefix" by a ScopedBundleReaderOptions,
+  // if any, and the default options otherwise.
   BundleReader(Env* const env, StringPiece prefix);
+  BundleReader(Env* const env, StringPiece prefix, const Options& options);
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
   // the metadata).
   Status status() const { return status_; }
 
-  // Queries whether the bundle contains an entry keyed by "key".  Calls Seek()
-  // internally, so this call invalidates the reader's current position.
+  // Queries whether the bundle contains an entry keyed by "key".  May call
+  // Seek() internally, so this call invalidates the reader's current position.
   // REQUIRES: status().ok()
   bool Contains(StringPiece key);
 
@@ -216,10 +250,30 @@ class BundleReader {
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
+  // If options().use_mmap is set, "val" may instead be replaced by a tensor
+  // aliasing the mapped data file, in which case its existing buffer is not
+  // filled.
+  //
   // Validates the stored crc32c checksum against the restored bytes.
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys" into the corresponding "vals", each
+  // with the requirements and semantics of "Lookup()".
+  //
+  // The memcpy-able, unpartitioned tensors are grouped by data file and offset,
+  // adjacent ones are read together, and the reads are issued concurrently
+  // with a bound on the bytes in flight, so that restoring from a remote
+  // filesystem is limited by bandwidth rather than latency.  Other tensors are
+  // looked up one at a time.
+  //
+  // On error, "vals" may contain nonsense data.
+  // REQUIRES: status().ok() && keys.size() == vals.size()
+  Status BatchLookup(gtl::ArraySlice<string> keys,
+                     gtl::ArraySlice<Tensor*> vals,
+                     const BatchLookupOptions& options = BatchLookupOptions())
+      TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -264,6 +318,8 @@ class BundleReader {
 
   string DebugString();
 
+  const Options& options() const { return options_; }
+
  private:
   // Seeks for "key" and reads the metadata proto.
   // On non-OK return, clears "entry" for the caller.
@@ -276,6 +332,16 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Returns the buffered data file of shard "shard_id", opening it if needed.
+  Status GetDataFile(int32_t shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
+  // If the tensor described by "entry" can alias the mapped data file, points
+  // "val" at it and sets "*mapped" to true.  Otherwise leaves "val" untouched
+  // and sets "*mapped" to false.
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* mapped) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -286,6 +352,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -294,6 +361,9 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The mapped data files, or nullptr for files that cannot be mapped.  Each
+  // holds a reference, and so does every tensor aliasing it.
+  std::unordered_map<int32, MappedBundleDataFile*> mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -312,6 +382,23 @@ class BundleReader {
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
 };
 
+// While alive, makes BundleReaders constructed for "prefix" without explicit
+// options use "options".  Lets callers that restore through ops constructing
+// their own readers, such as the SavedModel loader, choose how the bundle is
+// read.  If instances for the same prefix overlap, the options of the first
+// one apply until all of them are destroyed.
+class ScopedBundleReaderOptions {
+ public:
+  ScopedBundleReaderOptions(StringPiece prefix,
+                            const BundleReader::Options& options);
+  ~ScopedBundleReaderOptions();
+
+ private:
+  const string prefix_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedBundleReaderOptions);
+};
+
 // A buffering wrapper for a WritableFile.  Useful if the caller wishes to issue
 // small writes to a file (e.g. writing out a list of small varints).
 // External synchronization must be used in the presence of concurrent callers.
@@ -1113,6 +1113,141 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, MmapAliasesAlignedTensors) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), Prefix("mmap"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant<float>(1, TensorShape({100}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<int32>(2, TensorShape({3, 5}))));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  Tensor a;
+  Tensor b;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap"), options);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.Lookup("a", &a));
+    Expect<int32>(&reader, "b", Constant<int32>(2, TensorShape({3, 5})));
+    Expect<tstring>(&reader, "c", Constant_2x3<tstring>("foo"));
+    TF_ASSERT_OK(reader.Lookup("b", &b));
+  }
+  // The aliasing tensors outlive the reader, and never forward their buffer.
+  test::ExpectTensorEqual<float>(a, Constant<float>(1, TensorShape({100})));
+  test::ExpectTensorEqual<int32>(b, Constant<int32>(2, TensorShape({3, 5})));
+  EXPECT_FALSE(a.RefCountIsOne());
+  EXPECT_FALSE(b.RefCountIsOne());
+}
+
+TEST(TensorBundleTest, MmapReadsUnalignedTensors) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<float>(2, TensorShape({100}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"), options);
+  TF_ASSERT_OK(reader.status());
+  Expect<int8>(&reader, "a", Constant<int8>(1, TensorShape({3})));
+  Expect<float>(&reader, "b", Constant<float>(2, TensorShape({100})));
+  Tensor b;
+  TF_ASSERT_OK(reader.Lookup("b", &b));
+  EXPECT_TRUE(b.RefCountIsOne());
+}
+
+TEST(TensorBundleTest, ScopedReaderOptions) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), Prefix("scoped"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant<float>(1, TensorShape({100}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleReader::Options options;
+    options.use_mmap = true;
+    ScopedBundleReaderOptions scoped(Prefix("scoped"), options);
+    BundleReader reader(Env::Default(), Prefix("scoped"));
+    TF_ASSERT_OK(reader.status());
+    EXPECT_TRUE(reader.options().use_mmap);
+    Tensor a;
+    TF_ASSERT_OK(reader.Lookup("a", &a));
+    EXPECT_FALSE(a.RefCountIsOne());
+  }
+  BundleReader reader(Env::Default(), Prefix("scoped"));
+  EXPECT_FALSE(reader.options().use_mmap);
+}
+
+TEST(TensorBundleTest, BatchLookup) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("batch"));
+    for (int i = 0; i < 20; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("t", i),
+                              Constant<int32>(i, TensorShape({i + 1}))));
+    }
+    TF_EXPECT_OK(writer.Add("s", Constant_2x3<tstring>("foo")));
+    TF_EXPECT_OK(writer.AddSlice("p", TensorShape({2, 3}),
+                                 TensorSlice::ParseOrDie("-:-"),
+                                 Constant_2x3<float>(5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  std::vector<string> keys;
+  for (int i = 19; i >= 0; --i) {
+    keys.push_back(strings::StrCat("t", i));
+  }
+  keys.push_back("s");
+  keys.push_back("p");
+
+  struct Config {
+    int num_threads;
+    int64_t max_inflight_bytes;
+    int64_t max_coalesce_gap_bytes;
+  };
+  for (const Config& config : std::vector<Config>{
+           {1, 256 << 20, 64 << 10}, {4, 256 << 20, 0}, {4, 16, 64 << 10}}) {
+    BundleReader reader(Env::Default(), Prefix("batch"));
+    TF_ASSERT_OK(reader.status());
+    BundleReader::BatchLookupOptions options;
+    options.num_threads = config.num_threads;
+    options.max_inflight_bytes = config.max_inflight_bytes;
+    options.max_coalesce_gap_bytes = config.max_coalesce_gap_bytes;
+    std::vector<Tensor> vals(keys.size());
+    // Preallocated tensors are filled in place.  Partitioned tensors must be
+    // preallocated, as with Lookup().
+    vals[0] = Tensor(DT_INT32, TensorShape({20}));
+    vals[21] = Tensor(DT_FLOAT, TensorShape({2, 3}));
+    std::vector<Tensor*> val_ptrs;
+    for (Tensor& val : vals) val_ptrs.push_back(&val);
+    TF_ASSERT_OK(reader.BatchLookup(keys, val_ptrs, options));
+    for (int i = 0; i < 20; ++i) {
+      test::ExpectTensorEqual<int32>(
+          vals[19 - i], Constant<int32>(i, TensorShape({i + 1})));
+    }
+    test::ExpectTensorEqual<tstring>(vals[20], Constant_2x3<tstring>("foo"));
+    test::ExpectTensorEqual<float>(vals[21], Constant_2x3<float>(5));
+  }
+}
+
+TEST(TensorBundleTest, BatchLookupErrors) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("batch_errors"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("batch_errors"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  EXPECT_TRUE(errors::IsNotFound(reader.BatchLookup({"a", "b"}, {&val, &val})));
+  Tensor wrong_shape(DT_FLOAT, TensorShape({3}));
+  EXPECT_TRUE(errors::IsDataLoss(reader.BatchLookup({"a"}, {&wrong_shape})));
+  EXPECT_TRUE(errors::IsInvalidArgument(reader.BatchLookup({"a"}, {})));
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
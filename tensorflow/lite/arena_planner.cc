@@ -18,8 +18,10 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -32,8 +34,38 @@ namespace {
 
 constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
 
+// Layout of the offline memory plan metadata.
+constexpr int32_t kOfflineMemoryPlanVersion = 1;
+constexpr int kOfflineMemoryPlanHeaderSize = 3;
+
 }  // namespace
 
+bool ParseOfflineMemoryPlan(const std::string& metadata, int subgraph_index,
+                            std::vector<int32_t>* offsets) {
+  if (metadata.size() % sizeof(int32_t) != 0 ||
+      metadata.size() < kOfflineMemoryPlanHeaderSize * sizeof(int32_t)) {
+    return false;
+  }
+  std::vector<int32_t> values(metadata.size() / sizeof(int32_t));
+  std::memcpy(values.data(), metadata.data(), metadata.size());
+  if (values[0] != kOfflineMemoryPlanVersion || values[1] != subgraph_index ||
+      values[2] !=
+          static_cast<int32_t>(values.size()) - kOfflineMemoryPlanHeaderSize) {
+    return false;
+  }
+  offsets->assign(values.begin() + kOfflineMemoryPlanHeaderSize, values.end());
+  return true;
+}
+
+std::string SerializeOfflineMemoryPlan(int subgraph_index,
+                                       const std::vector<int32_t>& offsets) {
+  std::vector<int32_t> values = {kOfflineMemoryPlanVersion, subgraph_index,
+                                 static_cast<int32_t>(offsets.size())};
+  values.insert(values.end(), offsets.begin(), offsets.end());
+  return std::string(reinterpret_cast<const char*>(values.data()),
+                     values.size() * sizeof(int32_t));
+}
+
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_all_tensors, int tensor_alignment)
@@ -46,6 +78,24 @@ ArenaPlanner::ArenaPlanner(TfLiteContext* context,
 
 ArenaPlanner::~ArenaPlanner() {}
 
+void ArenaPlanner::SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+  offline_offsets_ = std::move(offsets);
+}
+
+void ArenaPlanner::SetConcurrentLevels(const std::vector<int>& levels) {
+  level_ends_.assign(levels.size(), 0);
+  for (int i = static_cast<int>(levels.size()) - 1; i >= 0; --i) {
+    const bool last_of_level =
+        i + 1 == static_cast<int>(levels.size()) || levels[i + 1] != levels[i];
+    level_ends_[i] = last_of_level ? i : level_ends_[i + 1];
+  }
+}
+
+int32_t ArenaPlanner::LevelEnd(int node) const {
+  return node < static_cast<int>(level_ends_.size()) ? level_ends_[node]
+                                                     : node;
+}
+
 std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
   if (type == kTfLiteArenaRwPersistent) {
     return persistent_arena_.BasePointer();
@@ -106,7 +156,9 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
       return kTfLiteOk;
     }
     TF_LITE_ENSURE(context_, dealloc_node_[tensor] == kNodeNotAssigned);
-    dealloc_node_[tensor] = node;
+    // The other nodes of the level may still be using the tensor, and a tensor
+    // allocated by any of them must not take its place.
+    dealloc_node_[tensor] = LevelEnd(node);
     return kTfLiteOk;
   };
 
@@ -200,7 +252,7 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
       int tensor_index = node_temporaries->data[j];
       alloc_node_[tensor_index] = i;
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = LevelEnd(i);
       }
     }
   }
@@ -312,10 +364,30 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
     }
   }
 
+  // Tensors planned offline go first, so that the other tensors are planned
+  // around them. The plan covers the allocation of the graph from its first
+  // node only.
+  const bool use_offline_plan = first_node == 0 &&
+                                !offline_offsets_.empty() &&
+                                IsOfflinePlanValid(tensor_order);
+  if (use_offline_plan) {
+    for (const auto& tensor_index : tensor_order) {
+      TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+      const int32_t offset = OfflineOffset(tensor_index);
+      if (tensor.allocation_type == kTfLiteArenaRw && offset >= 0) {
+        TF_LITE_ENSURE_STATUS(arena_.AllocateAt(
+            context_, offset, tensor.bytes, tensor_index,
+            alloc_node_[tensor_index], dealloc_node_[tensor_index],
+            &allocs_[tensor_index]));
+      }
+    }
+  }
+
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw) {
+    if (tensor.allocation_type == kTfLiteArenaRw &&
+        !(use_offline_plan && OfflineOffset(tensor_index) >= 0)) {
       TF_LITE_ENSURE_STATUS(
           arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
                           tensor_index, alloc_node_[tensor_index],
@@ -334,6 +406,46 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+int32_t ArenaPlanner::OfflineOffset(int tensor_index) const {
+  return tensor_index < static_cast<int>(offline_offsets_.size())
+             ? offline_offsets_[tensor_index]
+             : -1;
+}
+
+bool ArenaPlanner::IsOfflinePlanValid(
+    const std::vector<int32_t>& tensor_order) const {
+  std::vector<int32_t> planned;
+  for (int32_t tensor_index : tensor_order) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    const int32_t offset = OfflineOffset(tensor_index);
+    if (tensor.allocation_type != kTfLiteArenaRw || tensor.bytes == 0 ||
+        offset < 0) {
+      continue;
+    }
+    if (offset % tensor_alignment_ != 0) return false;
+    planned.push_back(tensor_index);
+  }
+  std::sort(planned.begin(), planned.end(), [this](int32_t a, int32_t b) {
+    return offline_offsets_[a] < offline_offsets_[b];
+  });
+  // Only the tensors starting within a tensor's range can overlap with it.
+  for (size_t i = 0; i < planned.size(); ++i) {
+    const int32_t a = planned[i];
+    const size_t end = offline_offsets_[a] + graph_info_->tensor(a)->bytes;
+    for (size_t j = i + 1; j < planned.size() &&
+                           static_cast<size_t>(offline_offsets_[planned[j]]) <
+                               end;
+         ++j) {
+      const int32_t b = planned[j];
+      if (alloc_node_[a] <= dealloc_node_[b] &&
+          alloc_node_[b] <= dealloc_node_[a]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
@@ -30,6 +31,23 @@ namespace tflite {
 constexpr const int kDefaultArenaAlignment = 64;
 struct AllocationInfo;
 
+// Name of the model metadata holding a memory plan computed offline. The format
+// is the one TFLite Micro uses: an int32 array holding a version (1), the
+// subgraph index, the number of tensors and then the arena offset of each
+// tensor. An offset of -1 leaves the tensor to the online planner.
+constexpr const char kOfflineMemoryAllocationMetadata[] =
+    "OfflineMemoryAllocation";
+
+// Extracts the offsets in an offline memory plan for `subgraph_index`. Returns
+// false if `metadata` is malformed or holds the plan of another subgraph.
+bool ParseOfflineMemoryPlan(const std::string& metadata, int subgraph_index,
+                            std::vector<int32_t>* offsets);
+
+// Returns the metadata holding `offsets` as the offline memory plan of
+// `subgraph_index`.
+std::string SerializeOfflineMemoryPlan(int subgraph_index,
+                                       const std::vector<int32_t>& offsets);
+
 // A memory planner that makes all the allocations using arenas.
 //
 // Before a model is executed by the interpreter, this class determines when
@@ -63,10 +81,18 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus AcquireNonPersistentMemory() override;
   bool HasNonPersistentMemory() override;
   void DumpDebugInfo(const std::vector<int>& execution_plan) const override;
+  void SetConcurrentLevels(const std::vector<int>& levels) override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Places tensors at the arena offsets in `offsets`, indexed by tensor, which
+  // were planned offline. Tensors without an offset, or with an offset of -1,
+  // are planned online around them. The offline plan is checked against the
+  // actual sizes and lifetimes of the tensors, and is ignored if they conflict,
+  // e.g. after an input has been resized.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets);
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -86,6 +112,13 @@ class ArenaPlanner : public MemoryPlanner {
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Returns the offline planned offset of a tensor, or -1 if it has none.
+  int32_t OfflineOffset(int tensor_index) const;
+
+  // Returns true if the offline plan places the tensors in `tensor_order`
+  // without overlapping any two of them that are used at the same time.
+  bool IsOfflinePlanValid(const std::vector<int32_t>& tensor_order) const;
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -98,6 +131,10 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Returns the last node of the level of `node`, after which the tensors
+  // last used by `node` can be deallocated.
+  int32_t LevelEnd(int node) const;
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -127,6 +164,13 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // Arena offsets planned offline, indexed by tensor.
+  std::vector<int32_t> offline_offsets_;
+
+  // The last node of the level of each node, when the nodes of a level run at
+  // the same time. Empty when each node runs on its own.
+  std::vector<int32_t> level_ends_;
 };
 
 }  // namespace tflite
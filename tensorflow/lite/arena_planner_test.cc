@@ -23,6 +23,7 @@ limitations under the License.
 #include <initializer_list>
 #include <memory>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -184,6 +185,15 @@ class ArenaPlannerTest : public ::testing::Test {
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
 
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+    planner_->SetOfflinePlannedOffsets(std::move(offsets));
+  }
+
+  void SetConcurrentLevels(const std::vector<int>& levels) {
+    planner_->SetConcurrentLevels(levels);
+    CHECK(planner_->PlanAllocations() == kTfLiteOk);
+  }
+
   void SwapGraph(TestGraph* graph) {
     graph_->Swap(graph);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
@@ -228,6 +238,15 @@ class ArenaPlannerTest : public ::testing::Test {
     return offset;
   }
 
+  // Returns true if the buffers of the given tensors overlap.
+  bool Overlap(int tensor_a, int tensor_b) {
+    const std::ptrdiff_t begin_a = GetOffset(tensor_a);
+    const std::ptrdiff_t begin_b = GetOffset(tensor_b);
+    const std::ptrdiff_t end_a = begin_a + (*graph_->tensors())[tensor_a].bytes;
+    const std::ptrdiff_t end_b = begin_b + (*graph_->tensors())[tensor_b].bytes;
+    return begin_a < end_b && begin_b < end_a;
+  }
+
   // Returns if the given tensor is unallocated or not.
   bool IsUnallocated(int tensor_index) {
     return (*graph_->tensors())[tensor_index].data.raw == nullptr;
@@ -759,5 +778,137 @@ TEST_F(ArenaPlannerTest, DebugTensors) {
   EXPECT_EQ(tensorOffsets.size(), 8);
 }
 
+TEST_F(ArenaPlannerTest, OfflinePlannedOffsets) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // Tensor 3 reuses the memory of tensor 2, which is free by then.
+  SetOfflinePlannedOffsets({0, 4, 12, 12, 24, 40});
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), 4);
+  EXPECT_EQ(GetOffset(2), 12);
+  EXPECT_EQ(GetOffset(3), 12);
+  EXPECT_EQ(GetOffset(4), 24);
+  EXPECT_EQ(GetOffset(5), 40);
+}
+
+TEST_F(ArenaPlannerTest, PartialOfflinePlan) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // Only the inputs are planned offline, the other tensors fit below them.
+  SetOfflinePlannedOffsets({64, 68, -1});
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 64);
+  EXPECT_EQ(GetOffset(1), 68);
+  EXPECT_EQ(GetOffset(5), 0);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+}
+
+TEST_F(ArenaPlannerTest, ConflictingOfflinePlanIsIgnored) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // Tensors 2 and 4 are both used by the second op.
+  SetOfflinePlannedOffsets({0, 4, 12, 12, 12, 40});
+  Execute(0, 10);
+
+  // Same as SimpleGraph.
+  EXPECT_EQ(GetOffset(5), 12);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(1), 4);
+}
+
+// Two branches of two ops each, whose ops run at the same time as the ops of
+// the other branch, followed by an op joining them.
+TestGraph TwoBranchGraph() {
+  return TestGraph({0},
+                   {
+                       /* in, out, tmp */
+                       {{0}, {1}, {6}},     // Level 0
+                       {{0}, {2}, {7}},     // Level 0
+                       {{1}, {3}, {}},      // Level 1
+                       {{2}, {4}, {}},      // Level 1
+                       {{3, 4}, {5}, {}}    // Level 2
+                   },
+                   {5});
+}
+
+TEST_F(ArenaPlannerTest, SequentialOpsShareMemory) {
+  TestGraph graph = TwoBranchGraph();
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // The temporaries of the first two ops, and the input of the third op and
+  // the output of the fourth one.
+  EXPECT_TRUE(Overlap(6, 7));
+  EXPECT_TRUE(Overlap(1, 4));
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentLevelsDontShareMemory) {
+  TestGraph graph = TwoBranchGraph();
+  SetGraph(&graph);
+  SetConcurrentLevels({0, 0, 1, 1, 2});
+  Execute(0, 10);
+
+  // Tensors used by the ops of a level.
+  const std::vector<std::vector<int>> level_tensors = {
+      {0, 1, 2, 6, 7}, {1, 2, 3, 4}, {3, 4, 5}};
+  for (const std::vector<int>& tensors : level_tensors) {
+    for (int a : tensors) {
+      for (int b : tensors) {
+        if (a != b) {
+          EXPECT_FALSE(Overlap(a, b)) << a << " and " << b;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ArenaPlannerTest, EmptyConcurrentLevelsRunOpsOnTheirOwn) {
+  TestGraph graph = TwoBranchGraph();
+  SetGraph(&graph);
+  SetConcurrentLevels({0, 0, 1, 1, 2});
+  SetConcurrentLevels({});
+  Execute(0, 10);
+
+  EXPECT_TRUE(Overlap(6, 7));
+}
+
+TEST(OfflineMemoryPlanTest, SerializeAndParse) {
+  const std::string metadata = SerializeOfflineMemoryPlan(1, {0, -1, 64});
+  std::vector<int32_t> offsets;
+  ASSERT_TRUE(ParseOfflineMemoryPlan(metadata, 1, &offsets));
+  EXPECT_EQ(offsets, std::vector<int32_t>({0, -1, 64}));
+  EXPECT_FALSE(ParseOfflineMemoryPlan(metadata, 0, &offsets));
+  EXPECT_FALSE(ParseOfflineMemoryPlan(metadata.substr(0, 8), 1, &offsets));
+  EXPECT_FALSE(
+      ParseOfflineMemoryPlan(metadata.substr(0, metadata.size() - 4), 1,
+                             &offsets));
+}
+
 }  // namespace
 }  // namespace tflite
@@ -0,0 +1,191 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/async_invoker.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+
+bool InvokeFence::IsSignaled() const {
+  return status_.valid() && status_.wait_for(std::chrono::seconds(0)) ==
+                                std::future_status::ready;
+}
+
+TfLiteStatus InvokeFence::Wait() const {
+  if (!status_.valid()) return kTfLiteError;
+  return status_.get();
+}
+
+std::unique_ptr<AsyncInvoker> AsyncInvoker::Create(Interpreter* interpreter) {
+  if (interpreter == nullptr) return nullptr;
+  return std::unique_ptr<AsyncInvoker>(new AsyncInvoker(interpreter));
+}
+
+AsyncInvoker::AsyncInvoker(Interpreter* interpreter)
+    : interpreter_(interpreter), worker_([this] { WorkerLoop(); }) {}
+
+AsyncInvoker::~AsyncInvoker() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cond_.notify_one();
+  worker_.join();
+}
+
+TfLiteStatus AsyncInvoker::BindBuffer(int tensor_index,
+                                      const ExternalBuffer& buffer) {
+  ErrorReporter* error_reporter = interpreter_->error_reporter();
+  if (!IsInput(tensor_index) && !IsOutput(tensor_index)) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Tensor %d is not an input or an output.",
+                         tensor_index);
+    return kTfLiteError;
+  }
+  const bool has_handle = buffer.buffer_handle != kTfLiteNullBufferHandle;
+  if ((buffer.data != nullptr) == has_handle) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Tensor %d must be bound to either memory or a "
+                         "buffer handle.",
+                         tensor_index);
+    return kTfLiteError;
+  }
+  if (has_handle) {
+    if (buffer.delegate == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "The buffer handle of tensor %d has no delegate.",
+                           tensor_index);
+      return kTfLiteError;
+    }
+  } else {
+    const TfLiteTensor* tensor = interpreter_->tensor(tensor_index);
+    if (buffer.bytes < tensor->bytes) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Tensor %d needs %zu bytes, got a buffer of %zu.",
+                           tensor_index, tensor->bytes, buffer.bytes);
+      return kTfLiteError;
+    }
+    if (reinterpret_cast<uintptr_t>(buffer.data) % kDefaultTensorAlignment !=
+        0) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "The buffer of tensor %d is not aligned to %d "
+                           "bytes.",
+                           tensor_index, kDefaultTensorAlignment);
+      return kTfLiteError;
+    }
+  }
+  Schedule([this, tensor_index, buffer] {
+    if (ApplyBinding(tensor_index, buffer) != kTfLiteOk) {
+      binding_status_ = kTfLiteError;
+    }
+  });
+  return kTfLiteOk;
+}
+
+InvokeFence AsyncInvoker::InvokeAsync() {
+  auto promise = std::make_shared<std::promise<TfLiteStatus>>();
+  InvokeFence fence(promise->get_future().share());
+  Schedule([this, promise] { promise->set_value(RunInvocation()); });
+  return fence;
+}
+
+void AsyncInvoker::Schedule(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cond_.notify_one();
+}
+
+void AsyncInvoker::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      // The queue is drained before stopping, so that no fence is left
+      // unsignaled.
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+TfLiteStatus AsyncInvoker::ApplyBinding(int tensor_index,
+                                        const ExternalBuffer& buffer) {
+  if (buffer.buffer_handle == kTfLiteNullBufferHandle) {
+    TfLiteCustomAllocation allocation = {buffer.data, buffer.bytes};
+    TF_LITE_ENSURE_STATUS(
+        interpreter_->SetCustomAllocationForTensor(tensor_index, allocation));
+    needs_allocation_ = true;
+    return kTfLiteOk;
+  }
+  TF_LITE_ENSURE_STATUS(interpreter_->SetBufferHandle(
+      tensor_index, buffer.buffer_handle, buffer.delegate));
+  if (IsInput(tensor_index)) {
+    // Kernels of other delegates, and of the CPU, read the tensor through
+    // CopyFromBufferHandle, while the delegate of the handle reads it in
+    // place.
+    interpreter_->tensor(tensor_index)->data_is_stale = true;
+  }
+  if (IsOutput(tensor_index)) {
+    // Otherwise Invoke copies the output back into CPU memory.
+    interpreter_->SetAllowBufferHandleOutput(true);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AsyncInvoker::RunInvocation() {
+  if (binding_status_ != kTfLiteOk) {
+    binding_status_ = kTfLiteOk;
+    return kTfLiteError;
+  }
+  if (needs_allocation_) {
+    // Custom allocations only take effect once the tensors are allocated
+    // again. This is cheap when the shapes did not change, as the arena is
+    // not planned again.
+    TF_LITE_ENSURE_STATUS(interpreter_->AllocateTensors());
+    needs_allocation_ = false;
+  }
+  return interpreter_->Invoke();
+}
+
+bool AsyncInvoker::IsInput(int tensor_index) const {
+  const std::vector<int>& inputs = interpreter_->inputs();
+  return std::find(inputs.begin(), inputs.end(), tensor_index) != inputs.end();
+}
+
+bool AsyncInvoker::IsOutput(int tensor_index) const {
+  const std::vector<int>& outputs = interpreter_->outputs();
+  return std::find(outputs.begin(), outputs.end(), tensor_index) !=
+         outputs.end();
+}
+
+}  // namespace tflite
@@ -0,0 +1,160 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_ASYNC_INVOKER_H_
+#define TENSORFLOW_LITE_ASYNC_INVOKER_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+
+/// A buffer owned by the application that an input or output of the
+/// interpreter is bound to, instead of the buffer TFLite allocates for it.
+///
+/// A buffer is either CPU addressable memory, such as a locked
+/// AHardwareBuffer or a mapped dma-buf, given by `data` and `bytes`, or a
+/// buffer handle of `delegate`, such as the handle StatefulNnApiDelegate
+/// returns for a registered ANeuralNetworksMemory, which the delegate reads
+/// and writes directly.
+struct ExternalBuffer {
+  /// CPU addressable memory, aligned to kDefaultTensorAlignment, with at least
+  /// as many bytes as the tensor.
+  void* data = nullptr;
+  size_t bytes = 0;
+  /// A buffer handle of `delegate`. The interpreter takes ownership of the
+  /// handle, and frees it through the delegate when the tensor is bound to
+  /// another handle.
+  TfLiteBufferHandle buffer_handle = kTfLiteNullBufferHandle;
+  TfLiteDelegate* delegate = nullptr;
+};
+
+/// Signaled when an invocation started by AsyncInvoker::InvokeAsync is done.
+/// Fences are cheap to copy, and all copies observe the same invocation.
+class InvokeFence {
+ public:
+  InvokeFence() = default;
+  explicit InvokeFence(std::shared_future<TfLiteStatus> status)
+      : status_(std::move(status)) {}
+
+  /// Returns true once the invocation is done, without blocking.
+  bool IsSignaled() const;
+
+  /// Blocks until the invocation is done, and returns its status.
+  TfLiteStatus Wait() const;
+
+ private:
+  std::shared_future<TfLiteStatus> status_;
+};
+
+/// WARNING: Experimental interface, subject to change
+///
+/// AsyncInvoker runs the invocations of an interpreter on a thread of its
+/// own, so that the caller can prepare the next inputs, or wait on other
+/// work, while the model runs. The inputs and outputs are bound to buffers
+/// of the application, which the kernels and the delegates read and write in
+/// place, with no copy into or out of the buffers of TFLite.
+///
+/// Bindings and invocations are queued, and run in the order they were
+/// requested, so a buffer can be rebound for the next invocation while the
+/// previous one is still running on the old buffer.
+///
+/// Usage:
+///
+/// <pre><code>
+/// auto invoker = tflite::AsyncInvoker::Create(interpreter.get());
+/// if (invoker == nullptr) {
+///   // Return error.
+/// }
+/// tflite::ExternalBuffer input = {camera_frame, camera_frame_bytes};
+/// if (invoker->BindBuffer(interpreter->inputs()[0], input) != kTfLiteOk) {
+///   // Return error.
+/// }
+/// tflite::InvokeFence fence = invoker->InvokeAsync();
+/// ...
+/// if (fence.Wait() != kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// The interpreter must have its tensors allocated, and must outlive the
+/// invoker. It must not be used directly while invocations are pending.
+///
+/// WARNING: This class is *not* thread-safe. The client is responsible for
+/// ensuring serialized interaction to avoid data races and undefined behavior.
+class AsyncInvoker {
+ public:
+  /// Creates an invoker for `interpreter`. Returns nullptr on failure.
+  static std::unique_ptr<AsyncInvoker> Create(Interpreter* interpreter);
+
+  /// Waits for the pending invocations.
+  ~AsyncInvoker();
+
+  /// Binds the input or output `tensor_index` to `buffer` for the invocations
+  /// requested after this call. The buffer must not be written, for an input,
+  /// or read, for an output, until the fence of the last of those invocations
+  /// is signaled. Returns an error if the buffer can't hold the tensor.
+  ///
+  /// Once an output is bound to a buffer handle, outputs are left in the
+  /// buffers of their delegates after an invocation, as with
+  /// Interpreter::SetAllowBufferHandleOutput(true).
+  TfLiteStatus BindBuffer(int tensor_index, const ExternalBuffer& buffer);
+
+  /// Requests an invocation with the current bindings, and returns a fence
+  /// that is signaled with its status. An invocation fails if a binding
+  /// requested before it failed.
+  InvokeFence InvokeAsync();
+
+ private:
+  explicit AsyncInvoker(Interpreter* interpreter);
+
+  // Queues `task` to run on the worker thread.
+  void Schedule(std::function<void()> task);
+  void WorkerLoop();
+
+  // Run on the worker thread.
+  TfLiteStatus ApplyBinding(int tensor_index, const ExternalBuffer& buffer);
+  TfLiteStatus RunInvocation();
+
+  bool IsInput(int tensor_index) const;
+  bool IsOutput(int tensor_index) const;
+
+  Interpreter* interpreter_;
+
+  // Only accessed on the worker thread.
+  // Whether a CPU buffer was bound since the tensors were last allocated.
+  bool needs_allocation_ = false;
+  // The status of the bindings since the last invocation.
+  TfLiteStatus binding_status_ = kTfLiteOk;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::thread worker_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_ASYNC_INVOKER_H_
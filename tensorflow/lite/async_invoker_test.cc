@@ -0,0 +1,200 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/async_invoker.h"
+
+#include <stdlib.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr int kSize = 4;
+
+// A buffer of kSize floats, aligned like the tensors of TFLite.
+struct alignas(kDefaultTensorAlignment) AlignedBuffer {
+  float values[kSize];
+};
+
+ExternalBuffer CpuBuffer(AlignedBuffer* buffer) {
+  ExternalBuffer external;
+  external.data = buffer->values;
+  external.bytes = sizeof(buffer->values);
+  return external;
+}
+
+// A delegate that claims no nodes and only owns buffer handles, which index
+// into `buffers`.
+struct HandleDelegate {
+  HandleDelegate() {
+    delegate = TfLiteDelegateCreate();
+    delegate.data_ = this;
+    delegate.CopyFromBufferHandle = [](TfLiteContext*, TfLiteDelegate* d,
+                                       TfLiteBufferHandle handle,
+                                       TfLiteTensor* tensor) {
+      auto* self = static_cast<HandleDelegate*>(d->data_);
+      memcpy(tensor->data.raw, self->buffers[handle].values, tensor->bytes);
+      return kTfLiteOk;
+    };
+    delegate.FreeBufferHandle = [](TfLiteContext*, TfLiteDelegate* d,
+                                   TfLiteBufferHandle* handle) {
+      static_cast<HandleDelegate*>(d->data_)->num_freed++;
+      *handle = kTfLiteNullBufferHandle;
+    };
+  }
+
+  TfLiteDelegate delegate;
+  std::vector<AlignedBuffer> buffers;
+  int num_freed = 0;
+};
+
+class AsyncInvokerTest : public ::testing::Test {
+ protected:
+  // Builds an interpreter computing `y = x + x` on kSize floats.
+  void SetUp() override {
+    ASSERT_EQ(interpreter_.AddTensors(2), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetInputs({0}), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetOutputs({1}), kTfLiteOk);
+    TfLiteQuantizationParams quant;
+    interpreter_.SetTensorParametersReadWrite(0, kTfLiteFloat32, "x", {kSize},
+                                              quant);
+    interpreter_.SetTensorParametersReadWrite(1, kTfLiteFloat32, "y", {kSize},
+                                              quant);
+    auto* params =
+        reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+    params->activation = kTfLiteActNone;
+    ASSERT_EQ(interpreter_.AddNodeWithParameters({0, 0}, {1}, nullptr, 0,
+                                                 params,
+                                                 ops::builtin::Register_ADD()),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  }
+
+  Interpreter interpreter_;
+};
+
+TEST_F(AsyncInvokerTest, InvokesOnBoundBuffers) {
+  auto invoker = AsyncInvoker::Create(&interpreter_);
+  ASSERT_NE(invoker, nullptr);
+  AlignedBuffer input = {{1, 2, 3, 4}};
+  AlignedBuffer output = {};
+  ASSERT_EQ(invoker->BindBuffer(0, CpuBuffer(&input)), kTfLiteOk);
+  ASSERT_EQ(invoker->BindBuffer(1, CpuBuffer(&output)), kTfLiteOk);
+
+  InvokeFence fence = invoker->InvokeAsync();
+  EXPECT_EQ(fence.Wait(), kTfLiteOk);
+  EXPECT_TRUE(fence.IsSignaled());
+  EXPECT_THAT(output.values, ElementsAre(2, 4, 6, 8));
+  // The kernels worked in place on the bound buffers.
+  EXPECT_EQ(interpreter_.typed_tensor<float>(0), input.values);
+  EXPECT_EQ(interpreter_.typed_tensor<float>(1), output.values);
+}
+
+TEST_F(AsyncInvokerTest, RebindsBetweenInvocationsInOrder) {
+  auto invoker = AsyncInvoker::Create(&interpreter_);
+  ASSERT_NE(invoker, nullptr);
+  AlignedBuffer inputs[2] = {{{1, 2, 3, 4}}, {{10, 20, 30, 40}}};
+  AlignedBuffer outputs[2] = {};
+  std::vector<InvokeFence> fences;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(invoker->BindBuffer(0, CpuBuffer(&inputs[i])), kTfLiteOk);
+    ASSERT_EQ(invoker->BindBuffer(1, CpuBuffer(&outputs[i])), kTfLiteOk);
+    fences.push_back(invoker->InvokeAsync());
+  }
+  for (const InvokeFence& fence : fences) EXPECT_EQ(fence.Wait(), kTfLiteOk);
+  EXPECT_THAT(outputs[0].values, ElementsAre(2, 4, 6, 8));
+  EXPECT_THAT(outputs[1].values, ElementsAre(20, 40, 60, 80));
+}
+
+TEST_F(AsyncInvokerTest, DestructorWaitsForPendingInvocations) {
+  AlignedBuffer input = {{1, 2, 3, 4}};
+  AlignedBuffer output = {};
+  InvokeFence fence;
+  {
+    auto invoker = AsyncInvoker::Create(&interpreter_);
+    ASSERT_NE(invoker, nullptr);
+    ASSERT_EQ(invoker->BindBuffer(0, CpuBuffer(&input)), kTfLiteOk);
+    ASSERT_EQ(invoker->BindBuffer(1, CpuBuffer(&output)), kTfLiteOk);
+    fence = invoker->InvokeAsync();
+  }
+  EXPECT_TRUE(fence.IsSignaled());
+  EXPECT_EQ(fence.Wait(), kTfLiteOk);
+  EXPECT_THAT(output.values, ElementsAre(2, 4, 6, 8));
+}
+
+TEST_F(AsyncInvokerTest, ReadsInputsFromDelegateBufferHandles) {
+  HandleDelegate delegate;
+  delegate.buffers.push_back({{1, 2, 3, 4}});
+  auto invoker = AsyncInvoker::Create(&interpreter_);
+  ASSERT_NE(invoker, nullptr);
+  ExternalBuffer input;
+  input.buffer_handle = 0;
+  input.delegate = &delegate.delegate;
+  ASSERT_EQ(invoker->BindBuffer(0, input), kTfLiteOk);
+  AlignedBuffer output = {};
+  ASSERT_EQ(invoker->BindBuffer(1, CpuBuffer(&output)), kTfLiteOk);
+
+  EXPECT_EQ(invoker->InvokeAsync().Wait(), kTfLiteOk);
+  EXPECT_THAT(output.values, ElementsAre(2, 4, 6, 8));
+
+  // Binding another handle frees the previous one.
+  delegate.buffers.push_back({{5, 6, 7, 8}});
+  input.buffer_handle = 1;
+  ASSERT_EQ(invoker->BindBuffer(0, input), kTfLiteOk);
+  EXPECT_EQ(invoker->InvokeAsync().Wait(), kTfLiteOk);
+  EXPECT_EQ(delegate.num_freed, 1);
+  EXPECT_THAT(output.values, ElementsAre(10, 12, 14, 16));
+  // Release the handle before the delegate goes away.
+  invoker.reset();
+  ASSERT_EQ(interpreter_.SetBufferHandle(0, kTfLiteNullBufferHandle,
+                                         &delegate.delegate),
+            kTfLiteOk);
+  EXPECT_EQ(delegate.num_freed, 2);
+}
+
+TEST_F(AsyncInvokerTest, RejectsInvalidBuffers) {
+  auto invoker = AsyncInvoker::Create(&interpreter_);
+  ASSERT_NE(invoker, nullptr);
+  AlignedBuffer buffer = {};
+  ExternalBuffer small = CpuBuffer(&buffer);
+  small.bytes = sizeof(float);
+  EXPECT_EQ(invoker->BindBuffer(0, small), kTfLiteError);
+  ExternalBuffer misaligned = CpuBuffer(&buffer);
+  misaligned.data = buffer.values + 1;
+  EXPECT_EQ(invoker->BindBuffer(0, misaligned), kTfLiteError);
+  ExternalBuffer both = CpuBuffer(&buffer);
+  both.buffer_handle = 0;
+  EXPECT_EQ(invoker->BindBuffer(0, both), kTfLiteError);
+  EXPECT_EQ(invoker->BindBuffer(0, ExternalBuffer()), kTfLiteError);
+  ExternalBuffer no_delegate;
+  no_delegate.buffer_handle = 0;
+  EXPECT_EQ(invoker->BindBuffer(0, no_delegate), kTfLiteError);
+  // Only inputs and outputs can be bound.
+  EXPECT_EQ(invoker->BindBuffer(2, CpuBuffer(&buffer)), kTfLiteError);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,173 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batched_invoker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+
+namespace {
+
+bool HasFixedSizeType(const TfLiteTensor& tensor) {
+  return tensor.type != kTfLiteString && tensor.type != kTfLiteResource &&
+         tensor.type != kTfLiteVariant;
+}
+
+}  // namespace
+
+std::unique_ptr<BatchedInvoker> BatchedInvoker::Create(
+    Interpreter* interpreter, const BatchedInvokerOptions& options) {
+  if (options.max_batch_size <= 0) {
+    TF_LITE_REPORT_ERROR(interpreter->error_reporter(),
+                         "max_batch_size must be positive, got %d.",
+                         options.max_batch_size);
+    return nullptr;
+  }
+  std::vector<std::vector<int>> example_dims;
+  for (int index : interpreter->inputs()) {
+    const TfLiteTensor* tensor = interpreter->tensor(index);
+    if (tensor->dims == nullptr || tensor->dims->size == 0 ||
+        !HasFixedSizeType(*tensor)) {
+      TF_LITE_REPORT_ERROR(interpreter->error_reporter(),
+                           "Input %d cannot be batched.", index);
+      return nullptr;
+    }
+    example_dims.emplace_back(tensor->dims->data + 1,
+                              tensor->dims->data + tensor->dims->size);
+  }
+  return std::unique_ptr<BatchedInvoker>(
+      new BatchedInvoker(interpreter, options, std::move(example_dims)));
+}
+
+BatchedInvoker::BatchedInvoker(Interpreter* interpreter,
+                               const BatchedInvokerOptions& options,
+                               std::vector<std::vector<int>> example_dims)
+    : interpreter_(interpreter),
+      max_batch_size_(options.max_batch_size),
+      batch_sizes_(options.batch_sizes),
+      example_dims_(std::move(example_dims)) {
+  if (batch_sizes_.empty()) {
+    for (int size = 1; size < max_batch_size_; size *= 2) {
+      batch_sizes_.push_back(size);
+    }
+    batch_sizes_.push_back(max_batch_size_);
+  }
+  std::sort(batch_sizes_.begin(), batch_sizes_.end());
+}
+
+int BatchedInvoker::PaddedBatchSize(int num_examples) const {
+  auto it =
+      std::lower_bound(batch_sizes_.begin(), batch_sizes_.end(), num_examples);
+  // A single request may be larger than any configured size.
+  return it == batch_sizes_.end() ? num_examples : *it;
+}
+
+TfLiteStatus BatchedInvoker::ResizeBatch(int batch_size) {
+  if (batch_size == allocated_batch_size_) return kTfLiteOk;
+  for (size_t i = 0; i < example_dims_.size(); ++i) {
+    std::vector<int> dims = {batch_size};
+    dims.insert(dims.end(), example_dims_[i].begin(), example_dims_[i].end());
+    TF_LITE_ENSURE_STATUS(
+        interpreter_->ResizeInputTensor(interpreter_->inputs()[i], dims));
+  }
+  // Forget the previous size first, so that a failed allocation is retried.
+  allocated_batch_size_ = 0;
+  TF_LITE_ENSURE_STATUS(interpreter_->AllocateTensors());
+  allocated_batch_size_ = batch_size;
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchedInvoker::InvokeBatch(
+    const std::vector<BatchedRequest>& requests, size_t begin, size_t end,
+    int num_examples) {
+  const int batch_size = PaddedBatchSize(num_examples);
+  TF_LITE_ENSURE_STATUS(ResizeBatch(batch_size));
+
+  for (size_t i = 0; i < interpreter_->inputs().size(); ++i) {
+    TfLiteTensor* tensor = interpreter_->input_tensor(i);
+    const size_t example_bytes = tensor->bytes / batch_size;
+    char* data = tensor->data.raw;
+    for (size_t r = begin; r < end; ++r) {
+      const size_t bytes = example_bytes * requests[r].batch_size;
+      std::memcpy(data, requests[r].inputs[i], bytes);
+      data += bytes;
+    }
+    std::memset(data, 0, tensor->data.raw + tensor->bytes - data);
+  }
+
+  TF_LITE_ENSURE_STATUS(interpreter_->Invoke());
+
+  for (size_t i = 0; i < interpreter_->outputs().size(); ++i) {
+    const TfLiteTensor* tensor = interpreter_->output_tensor(i);
+    if (tensor->dims->size == 0 || tensor->dims->data[0] != batch_size ||
+        !HasFixedSizeType(*tensor)) {
+      TF_LITE_REPORT_ERROR(interpreter_->error_reporter(),
+                           "Output %d is not batched along its first "
+                           "dimension.",
+                           interpreter_->outputs()[i]);
+      return kTfLiteError;
+    }
+    const size_t example_bytes = tensor->bytes / batch_size;
+    const char* data = tensor->data.raw;
+    for (size_t r = begin; r < end; ++r) {
+      const size_t bytes = example_bytes * requests[r].batch_size;
+      std::memcpy(requests[r].outputs[i], data, bytes);
+      data += bytes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchedInvoker::Invoke(
+    const std::vector<BatchedRequest>& requests) {
+  for (const BatchedRequest& request : requests) {
+    if (request.batch_size <= 0 ||
+        request.inputs.size() != interpreter_->inputs().size() ||
+        request.outputs.size() != interpreter_->outputs().size()) {
+      TF_LITE_REPORT_ERROR(interpreter_->error_reporter(),
+                           "Request does not match the interpreter: batch "
+                           "size %d, %d inputs and %d outputs.",
+                           request.batch_size,
+                           static_cast<int>(request.inputs.size()),
+                           static_cast<int>(request.outputs.size()));
+      return kTfLiteError;
+    }
+  }
+  // Packs consecutive requests into batches of at most max_batch_size_
+  // examples, keeping their order.
+  size_t begin = 0;
+  while (begin < requests.size()) {
+    int num_examples = requests[begin].batch_size;
+    size_t end = begin + 1;
+    while (end < requests.size() &&
+           num_examples + requests[end].batch_size <= max_batch_size_) {
+      num_examples += requests[end].batch_size;
+      ++end;
+    }
+    TF_LITE_ENSURE_STATUS(InvokeBatch(requests, begin, end, num_examples));
+    begin = end;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,118 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_BATCHED_INVOKER_H_
+#define TENSORFLOW_LITE_BATCHED_INVOKER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+
+/// A single request for BatchedInvoker. Every input and output of the
+/// interpreter is batched along its first dimension, and the request holds
+/// `batch_size` consecutive examples of each of them.
+struct BatchedRequest {
+  /// Number of examples in the request.
+  int batch_size = 1;
+  /// `inputs[i]` points to the data of interpreter input `i`.
+  std::vector<const void*> inputs;
+  /// `outputs[i]` receives the data of interpreter output `i`, and must have
+  /// room for `batch_size` examples.
+  std::vector<void*> outputs;
+};
+
+struct BatchedInvokerOptions {
+  /// Upper bound on the batch size of a single invocation. Requests that do
+  /// not fit in the current batch are run in the next one.
+  int max_batch_size = 64;
+  /// Sorted batch sizes the interpreter is resized to, with the unused tail of
+  /// a batch padded with zeros. Keeping the number of distinct sizes small
+  /// means the tensors are rarely reallocated. When empty, the powers of two
+  /// up to `max_batch_size` are used.
+  std::vector<int> batch_sizes;
+};
+
+/// WARNING: Experimental interface, subject to change
+///
+/// BatchedInvoker runs several independent requests through one interpreter
+/// invocation, which amortizes the per-invocation overhead and lets kernels
+/// work on larger batches. The inputs of the requests are concatenated along
+/// the batch dimension, the interpreter is invoked once, and the outputs are
+/// split back into the buffers of the requests. The interpreter is only
+/// resized and reallocated when the batch size changes.
+///
+/// Usage:
+///
+/// <pre><code>
+/// auto invoker = tflite::BatchedInvoker::Create(interpreter.get(), {});
+/// if (invoker == nullptr) {
+///   // Return error.
+/// }
+/// std::vector<tflite::BatchedRequest> requests = ...;
+/// if (invoker->Invoke(requests) != kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// The interpreter must outlive the invoker, and should not be resized by
+/// anyone else while the invoker is in use.
+///
+/// WARNING: This class is *not* thread-safe. The client is responsible for
+/// ensuring serialized interaction to avoid data races and undefined behavior.
+class BatchedInvoker {
+ public:
+  /// Creates an invoker for `interpreter`, whose inputs and outputs must all
+  /// have a batch dimension and a fixed size type. The current shapes of the
+  /// inputs give the per-example shapes. Returns nullptr on failure.
+  static std::unique_ptr<BatchedInvoker> Create(
+      Interpreter* interpreter, const BatchedInvokerOptions& options);
+
+  /// Runs all of `requests`, invoking the interpreter as few times as
+  /// `max_batch_size` allows.
+  TfLiteStatus Invoke(const std::vector<BatchedRequest>& requests);
+
+  /// Returns the batch size the interpreter is currently allocated for, or 0
+  /// before the first invocation.
+  int allocated_batch_size() const { return allocated_batch_size_; }
+
+ private:
+  BatchedInvoker(Interpreter* interpreter, const BatchedInvokerOptions& options,
+                 std::vector<std::vector<int>> example_dims);
+
+  // Returns the smallest configured batch size that holds `num_examples`.
+  int PaddedBatchSize(int num_examples) const;
+
+  // Resizes the inputs to `batch_size` examples, if they are not already.
+  TfLiteStatus ResizeBatch(int batch_size);
+
+  // Runs `requests` in [begin, end), which hold `num_examples` in total.
+  TfLiteStatus InvokeBatch(const std::vector<BatchedRequest>& requests,
+                           size_t begin, size_t end, int num_examples);
+
+  Interpreter* interpreter_;
+  int max_batch_size_;
+  std::vector<int> batch_sizes_;
+  // The shape of one example of each input, without the batch dimension.
+  std::vector<std::vector<int>> example_dims_;
+  int allocated_batch_size_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_BATCHED_INVOKER_H_
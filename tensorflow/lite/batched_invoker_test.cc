@@ -0,0 +1,141 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batched_invoker.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+constexpr int kExampleSize = 2;
+
+class BatchedInvokerTest : public ::testing::Test {
+ protected:
+  // Builds an interpreter computing `y = x + x` on examples of kExampleSize
+  // floats.
+  void SetUp() override {
+    ASSERT_EQ(interpreter_.AddTensors(2), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetInputs({0}), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetOutputs({1}), kTfLiteOk);
+    TfLiteQuantizationParams quant;
+    interpreter_.SetTensorParametersReadWrite(0, kTfLiteFloat32, "x",
+                                              {1, kExampleSize}, quant);
+    interpreter_.SetTensorParametersReadWrite(1, kTfLiteFloat32, "y",
+                                              {1, kExampleSize}, quant);
+    auto* params =
+        reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+    params->activation = kTfLiteActNone;
+    ASSERT_EQ(interpreter_.AddNodeWithParameters({0, 0}, {1}, nullptr, 0,
+                                                 params,
+                                                 ops::builtin::Register_ADD()),
+              kTfLiteOk);
+  }
+
+  // Returns a request of `batch_size` examples whose values start at `first`.
+  BatchedRequest MakeRequest(int batch_size, float first) {
+    inputs_.emplace_back();
+    outputs_.emplace_back(batch_size * kExampleSize, -1.0f);
+    for (int i = 0; i < batch_size * kExampleSize; ++i) {
+      inputs_.back().push_back(first + i);
+    }
+    BatchedRequest request;
+    request.batch_size = batch_size;
+    request.inputs = {inputs_.back().data()};
+    request.outputs = {outputs_.back().data()};
+    return request;
+  }
+
+  Interpreter interpreter_;
+  // Tests reserve these up front, so that the requests keep pointing at valid
+  // buffers.
+  std::vector<std::vector<float>> inputs_;
+  std::vector<std::vector<float>> outputs_;
+};
+
+TEST_F(BatchedInvokerTest, SplitsOutputsBetweenRequests) {
+  inputs_.reserve(3);
+  outputs_.reserve(3);
+  auto invoker = BatchedInvoker::Create(&interpreter_, {});
+  ASSERT_NE(invoker, nullptr);
+  std::vector<BatchedRequest> requests = {
+      MakeRequest(1, 0), MakeRequest(2, 10), MakeRequest(2, 20)};
+  ASSERT_EQ(invoker->Invoke(requests), kTfLiteOk);
+  // The five examples are padded to a batch of eight.
+  EXPECT_EQ(invoker->allocated_batch_size(), 8);
+  EXPECT_THAT(outputs_[0], ElementsAreArray({0, 2}));
+  EXPECT_THAT(outputs_[1], ElementsAreArray({20, 22, 24, 26}));
+  EXPECT_THAT(outputs_[2], ElementsAreArray({40, 42, 44, 46}));
+}
+
+TEST_F(BatchedInvokerTest, SplitsLargeBatches) {
+  inputs_.reserve(3);
+  outputs_.reserve(3);
+  BatchedInvokerOptions options;
+  options.max_batch_size = 4;
+  options.batch_sizes = {4};
+  auto invoker = BatchedInvoker::Create(&interpreter_, options);
+  ASSERT_NE(invoker, nullptr);
+  std::vector<BatchedRequest> requests = {
+      MakeRequest(3, 0), MakeRequest(2, 10), MakeRequest(1, 20)};
+  ASSERT_EQ(invoker->Invoke(requests), kTfLiteOk);
+  EXPECT_EQ(invoker->allocated_batch_size(), 4);
+  EXPECT_THAT(outputs_[0], ElementsAreArray({0, 2, 4, 6, 8, 10}));
+  EXPECT_THAT(outputs_[1], ElementsAreArray({20, 22, 24, 26}));
+  EXPECT_THAT(outputs_[2], ElementsAreArray({40, 42}));
+}
+
+TEST_F(BatchedInvokerTest, ReusesAllocation) {
+  inputs_.reserve(2);
+  outputs_.reserve(2);
+  auto invoker = BatchedInvoker::Create(&interpreter_, {});
+  ASSERT_NE(invoker, nullptr);
+  ASSERT_EQ(invoker->Invoke({MakeRequest(3, 0)}), kTfLiteOk);
+  const float* input = interpreter_.typed_input_tensor<float>(0);
+  ASSERT_EQ(invoker->Invoke({MakeRequest(4, 0)}), kTfLiteOk);
+  // Both batches round up to four, so the tensors are not reallocated.
+  EXPECT_EQ(invoker->allocated_batch_size(), 4);
+  EXPECT_EQ(interpreter_.typed_input_tensor<float>(0), input);
+  EXPECT_THAT(outputs_[1], ElementsAreArray({0, 2, 4, 6, 8, 10, 12, 14}));
+}
+
+TEST_F(BatchedInvokerTest, RejectsMismatchedRequests) {
+  auto invoker = BatchedInvoker::Create(&interpreter_, {});
+  ASSERT_NE(invoker, nullptr);
+  BatchedRequest request;
+  EXPECT_EQ(invoker->Invoke({request}), kTfLiteError);
+}
+
+TEST_F(BatchedInvokerTest, RejectsScalarInputs) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(1), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "x", {},
+                                           TfLiteQuantizationParams());
+  EXPECT_EQ(BatchedInvoker::Create(&interpreter, {}), nullptr);
+}
+
+}  // namespace
+}  // namespace tflite
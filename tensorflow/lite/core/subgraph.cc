@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/inter_op_thread_pool.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -476,6 +477,13 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  // Kernels running on the inter-op thread pool use the CPU backend context
+  // of their thread.
+  if (type == kTfLiteCpuBackendContext && inter_op_thread_pool_ != nullptr) {
+    TfLiteExternalContext* thread_context =
+        inter_op_thread_pool_->CpuBackendContextOfCurrentThread();
+    if (thread_context != nullptr) return thread_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -623,6 +631,22 @@ TfLiteStatus Subgraph::SetMetadata(
   return kTfLiteOk;
 }
 
+bool Subgraph::GetOfflinePlannedOffsets(std::vector<int32_t>* offsets) const {
+#ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
+  return false;
+#else
+  if (metadata_ == nullptr || subgraphs_ == nullptr) return false;
+  const auto it = metadata_->find(kOfflineMemoryAllocationMetadata);
+  if (it == metadata_->end()) return false;
+  for (int i = 0; i < subgraphs_->size(); ++i) {
+    if ((*subgraphs_)[i].get() == this) {
+      return ParseOfflineMemoryPlan(it->second, i, offsets);
+    }
+  }
+  return false;
+#endif
+}
+
 void Subgraph::SetCancellationFunction(void* data,
                                        bool (*check_cancelled_func)(void*)) {
   cancellation_data_ = data;
@@ -1047,10 +1071,19 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
     memory_planner_.reset(new SimplePlanner(&context_, CreateGraphInfo()));
 #else
-    memory_planner_.reset(new ArenaPlanner(&context_, CreateGraphInfo(),
+    auto* arena_planner = new ArenaPlanner(&context_, CreateGraphInfo(),
                                            preserve_all_tensors_,
-                                           kDefaultTensorAlignment));
+                                           kDefaultTensorAlignment);
+    std::vector<int32_t> offline_offsets;
+    if (GetOfflinePlannedOffsets(&offline_offsets)) {
+      // The offline plan was made for the lifetimes of the current order.
+      arena_planner->SetOfflinePlannedOffsets(std::move(offline_offsets));
+    } else if (memory_aware_reordering_) {
+      ReorderExecutionPlanForMemory();
+    }
+    memory_planner_.reset(arena_planner);
 #endif
+    PlanConcurrentLevels();
     memory_planner_->PlanAllocations();
   }
 
@@ -1135,6 +1168,8 @@ TfLiteStatus Subgraph::Invoke() {
   }
   TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler_.get(), "Invoke");
 
+  if (CanInvokeConcurrently()) return InvokeConcurrently();
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1155,37 +1190,7 @@ TfLiteStatus Subgraph::Invoke() {
     if (profiler_) op_name = GetTFLiteOpName(registration);
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsReadable(node, registration));
 
     if (check_cancelled_func_ != nullptr &&
         check_cancelled_func_(cancellation_data_)) {
@@ -1224,6 +1229,137 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+TfLiteStatus Subgraph::EnsureNodeInputsReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+bool Subgraph::CanInvokeConcurrently() const {
+  // The profilers are not thread-safe, and dynamic tensors must be allocated
+  // between the nodes producing and consuming them.
+  return inter_op_thread_pool_ != nullptr && profiler_ == nullptr &&
+         !has_dynamic_tensors_ &&
+         next_execution_plan_index_to_prepare_ ==
+             static_cast<int>(execution_plan_.size()) &&
+         concurrent_execution_plan_ == execution_plan_;
+}
+
+bool Subgraph::CanRunConcurrently(
+    const TfLiteNode& node, const TfLiteRegistration& registration) const {
+  // Delegate kernels may share the state of their delegate, custom kernels may
+  // not be reentrant, and control flow kernels invoke other subgraphs.
+  return node.delegate == nullptr &&
+         registration.builtin_code != kTfLiteBuiltinDelegate &&
+         registration.builtin_code != kTfLiteBuiltinCustom &&
+         !OpMightHaveSideEffect(&node, &registration);
+}
+
+TfLiteStatus Subgraph::InvokeConcurrently() {
+  std::vector<int> concurrent_nodes;
+  std::vector<int> serial_nodes;
+  std::vector<TfLiteStatus> statuses;
+  const int num_nodes = execution_plan_.size();
+  for (int begin = 0, end = 0; begin < num_nodes; begin = end) {
+    concurrent_nodes.clear();
+    serial_nodes.clear();
+    const int level = concurrent_levels_[begin];
+    for (end = begin; end < num_nodes && concurrent_levels_[end] == level;
+         ++end) {
+      const int node_index = execution_plan_[end];
+      const TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+      // Tensors are copied out of delegate buffers before the level runs, as
+      // several nodes of the level may read the same tensor.
+      TF_LITE_ENSURE_STATUS(EnsureNodeInputsReadable(node, registration));
+      if (CanRunConcurrently(node, registration)) {
+        concurrent_nodes.push_back(node_index);
+      } else {
+        serial_nodes.push_back(node_index);
+      }
+    }
+    if (concurrent_nodes.size() == 1) {
+      serial_nodes.push_back(concurrent_nodes.back());
+      concurrent_nodes.clear();
+    }
+
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    if (!concurrent_nodes.empty()) {
+      statuses.assign(concurrent_nodes.size(), kTfLiteOk);
+      // Kernels create the CPU backend context of a pool thread with the
+      // recommended number of threads. The nodes of the level are the
+      // parallelism there, so the contexts are single threaded.
+      const int recommended_num_threads = context_.recommended_num_threads;
+      context_.recommended_num_threads = 1;
+      inter_op_thread_pool_->Run(concurrent_nodes.size(), [&](int i) {
+        auto& node_and_registration =
+            nodes_and_registration_[concurrent_nodes[i]];
+        statuses[i] = OpInvoke(node_and_registration.second,
+                               &node_and_registration.first);
+      });
+      context_.recommended_num_threads = recommended_num_threads;
+      for (size_t i = 0; i < concurrent_nodes.size(); ++i) {
+        if (statuses[i] != kTfLiteOk) {
+          const int node_index = concurrent_nodes[i];
+          return ReportOpError(&context_,
+                               nodes_and_registration_[node_index].first,
+                               nodes_and_registration_[node_index].second,
+                               node_index, "failed to invoke");
+        }
+      }
+    }
+    // Nodes that can't run at the same time as others run on the calling
+    // thread, once the other nodes of the level are done.
+    for (int node_index : serial_nodes) {
+      TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+      if (OpInvoke(registration, &node) != kTfLiteOk) {
+        return ReportOpError(&context_, node, registration, node_index,
+                             "failed to invoke");
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -1633,6 +1769,8 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    // The execution plan may have changed since it was last planned.
+    PlanConcurrentLevels();
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
@@ -1792,9 +1930,31 @@ const std::string& Subgraph::GetName() const { return name_; }
 
 void Subgraph::DumpMemoryPlannerDebugInfo() const {
   if (memory_planner_ == nullptr) return;
+  if (peak_bytes_after_reordering_ != 0) {
+    TFLITE_LOG_PROD(TFLITE_LOG_INFO,
+                    "Execution plan reordered for memory, estimated peak "
+                    "arena size %zu -> %zu bytes.",
+                    peak_bytes_before_reordering_,
+                    peak_bytes_after_reordering_);
+  }
   memory_planner_->DumpDebugInfo(execution_plan());
 }
 
+void Subgraph::ReorderExecutionPlanForMemory() {
+  InterpreterInfo info(this);
+  std::vector<int> order;
+  size_t peak_bytes = 0;
+  size_t reordered_peak_bytes = 0;
+  ReorderNodesForMemory(&info, &order, &peak_bytes, &reordered_peak_bytes);
+  if (reordered_peak_bytes >= peak_bytes) return;
+  std::vector<int> new_plan;
+  new_plan.reserve(order.size());
+  for (int index : order) new_plan.push_back(execution_plan_[index]);
+  execution_plan_ = std::move(new_plan);
+  peak_bytes_before_reordering_ = peak_bytes;
+  peak_bytes_after_reordering_ = reordered_peak_bytes;
+}
+
 TfLiteStatus Subgraph::PreserveAllTensorsExperimental() {
   if (memory_planner_) {
     ReportError(
@@ -1805,6 +1965,44 @@ TfLiteStatus Subgraph::PreserveAllTensorsExperimental() {
   return kTfLiteOk;
 }
 
+void Subgraph::PlanConcurrentLevels() {
+  if (inter_op_thread_pool_ == nullptr) return;
+  InterpreterInfo info(this);
+  std::vector<int> order;
+  PartitionIntoConcurrentLevels(&info, &order, &concurrent_levels_);
+  std::vector<int> new_plan;
+  new_plan.reserve(order.size());
+  for (int index : order) new_plan.push_back(execution_plan_[index]);
+  execution_plan_ = std::move(new_plan);
+  concurrent_execution_plan_ = execution_plan_;
+  memory_planner_->SetConcurrentLevels(concurrent_levels_);
+}
+
+TfLiteStatus Subgraph::SetNumInterOpThreadsExperimental(int num_threads) {
+  if (memory_planner_) {
+    ReportError(
+        "SetNumInterOpThreadsExperimental called after memory was planned.");
+    return kTfLiteError;
+  }
+  if (num_threads > 1) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_threads));
+  } else {
+    inter_op_thread_pool_.reset();
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::EnableMemoryAwareReorderingExperimental() {
+  if (memory_planner_) {
+    ReportError(
+        "EnableMemoryAwareReorderingExperimental called after memory was "
+        "planned.");
+    return kTfLiteError;
+  }
+  memory_aware_reordering_ = true;
+  return kTfLiteOk;
+}
+
 std::unique_ptr<GraphInfo> Subgraph::CreateGraphInfo() {
   return std::unique_ptr<GraphInfo>(new InterpreterInfo(this));
 }
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/inter_op_thread_pool.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
 
@@ -655,6 +656,36 @@ class Subgraph {
   // Enables preserving intermediates for debugging.
   TfLiteStatus PreserveAllTensorsExperimental();
 
+  // Enables reordering the execution plan to lower the peak arena size before
+  // memory is planned.
+  TfLiteStatus EnableMemoryAwareReorderingExperimental();
+
+  // Enables running the independent nodes of the execution plan at the same
+  // time on `num_threads` threads, the calling thread included, before memory
+  // is planned. The nodes run one after the other when `num_threads` is 1.
+  TfLiteStatus SetNumInterOpThreadsExperimental(int num_threads);
+
+  // Sorts the execution plan by concurrent level, and has the memory planner
+  // keep apart the tensors of a level, if inter-op parallelism is enabled.
+  void PlanConcurrentLevels();
+
+  // Returns true if Invoke() can run the nodes of a level at the same time.
+  bool CanInvokeConcurrently() const;
+
+  // Returns true if `node` can run at the same time as the other nodes of its
+  // level.
+  bool CanRunConcurrently(const TfLiteNode& node,
+                          const TfLiteRegistration& registration) const;
+
+  // Runs the execution plan level by level, with the nodes of a level running
+  // at the same time on the inter-op thread pool.
+  TfLiteStatus InvokeConcurrently();
+
+  // Makes the input tensors of `node` readable, copying them from delegate
+  // buffers if needed, and checks that they have data.
+  TfLiteStatus EnsureNodeInputsReadable(const TfLiteNode& node,
+                                        const TfLiteRegistration& registration);
+
   // Returns true if 'node' could have side effect (e.g. stateful op).
   // Note that any node that might update other tensors beside op's output
   // are considered to have side effect.
@@ -667,6 +698,15 @@ class Subgraph {
   // Returns new GraphInfo object based on the current Subgraph.
   std::unique_ptr<GraphInfo> CreateGraphInfo();
 
+  // Retrieves the arena offsets of the tensors of this subgraph from the
+  // offline memory plan in the model metadata. Returns false if the model has
+  // no plan for this subgraph.
+  bool GetOfflinePlannedOffsets(std::vector<int32_t>* offsets) const;
+
+  // Replaces the execution plan with an order of its nodes that lowers the
+  // estimated peak arena size, if there is one.
+  void ReorderExecutionPlanForMemory();
+
   // Store a ptr to the model metadata owned by the Interpreter.
   // Since the lifetime of the Interpreter exceeds the Subgraph, metadata
   // remains valid for the latter's lifetime.
@@ -826,6 +866,23 @@ class Subgraph {
   // debugging.
   bool preserve_all_tensors_ = false;
 
+  // Whether the execution plan should be reordered to lower the peak arena
+  // size before memory is planned.
+  bool memory_aware_reordering_ = false;
+
+  // The estimated peak arena size of the execution plan before and after it
+  // was reordered for memory. Both are zero if it was not reordered.
+  size_t peak_bytes_before_reordering_ = 0;
+  size_t peak_bytes_after_reordering_ = 0;
+
+  // Runs the nodes of a concurrent level at the same time, if not null.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // The concurrent level of each node of `concurrent_execution_plan_`, which
+  // is the execution plan they were computed for.
+  std::vector<int> concurrent_levels_;
+  std::vector<int> concurrent_execution_plan_;
+
   // Model-metadata owned by the Interpreter.
   const std::map<std::string, std::string>* metadata_ = nullptr;
 };
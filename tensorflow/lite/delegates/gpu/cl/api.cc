@@ -23,6 +23,7 @@ limitations under the License.
 #include <cstring>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_command_queue.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_errors.h"
@@ -856,6 +857,10 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     } else {
       RETURN_IF_ERROR(CreateDefaultGPUDevice(&device));
     }
+    const OpenClInfo& cl_info = device.GetInfo().opencl_info;
+    properties_.device_fingerprint =
+        absl::StrCat(cl_info.device_name, "|", cl_info.vendor_name, "|",
+                     cl_info.platform_version, "|", cl_info.driver_version);
 
 #ifdef CL_DELEGATE_ALLOW_GL
     properties_.is_gl_sharing_supported = IsGlSharingSupported(device);
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/api.h"
@@ -68,6 +69,11 @@ struct InferenceEnvironmentProperties {
 
   // Indicates whether fast CL->GL synchronization is supported.
   bool is_cl_to_gl_fast_sync_supported = false;
+
+  // Identifies the GPU, its OpenCL platform and driver. Serialized models and
+  // compiled programs are only valid on the device they were built for, so
+  // clients caching them should include this in their cache keys.
+  std::string device_fingerprint;
 };
 
 // Environment manages all resources that need to stay until any inference is
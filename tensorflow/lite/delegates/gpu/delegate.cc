@@ -92,12 +92,12 @@ class Delegate {
     if (options_.max_delegated_partitions <= 0) {
       options_.max_delegated_partitions = 1;
     }
-    if (options->experimental_flags &
+    if (options_.experimental_flags &
             TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION &&
-        options->model_token && options->serialization_dir) {
+        options_.model_token && options_.serialization_dir) {
       SerializationParams params;
-      params.model_token = options->model_token;
-      params.cache_dir = options->serialization_dir;
+      params.model_token = options_.model_token;
+      params.cache_dir = options_.serialization_dir;
       serialization_.reset(new Serialization(params));
     }
   }
@@ -329,23 +329,23 @@ class DelegateKernel {
     }
     options.usage = ToUsage(delegate_options.inference_preference);
 
+    RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
+                                                &properties));
     if (!serialization) {
       // This path is faster when there is no serialization involved.
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
-                                                  &properties));
       *graph_is_destroyed = true;
       RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
           options, std::move(*graph), builder));
     } else {
+      // The serialized model holds the compiled program binaries and the tuned
+      // work group sizes, which are only valid for this device and driver.
+      auto data_entry = GetSerializationEntry(context, delegate_params, options,
+                                              properties, serialization);
       // If serialization data is found, initialize CL from it & return early.
-      if (MaybeInitializeSerializedOpenCL(context, delegate_params, builder,
-                                          &options, &env_options, &properties,
-                                          serialization)
-              .ok())
+      if (MaybeInitializeSerializedOpenCL(context, data_entry, builder).ok()) {
         return absl::OkStatus();
+      }
 
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
-                                                  &properties));
       *graph_is_destroyed = true;
       std::vector<uint8_t> serialized_model;
       RETURN_IF_ERROR(cl_environment_->BuildSerializedModel(
@@ -353,8 +353,8 @@ class DelegateKernel {
       RETURN_IF_ERROR(
           cl_environment_->NewInferenceBuilder(serialized_model, builder));
 
-      RETURN_IF_ERROR(SaveSerializedOpenCL(context, delegate_params, &options,
-                                           serialization, serialized_model));
+      RETURN_IF_ERROR(
+          SaveSerializedOpenCL(context, data_entry, serialized_model));
     }
 
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
@@ -362,55 +362,58 @@ class DelegateKernel {
     return absl::OkStatus();
   }
 
-  // Returns Ok only if serialized data is successsfully found.
-  absl::Status MaybeInitializeSerializedOpenCL(
+  // Returns the entry the serialized model is stored in. Besides the model and
+  // the delegated nodes, it is keyed by the inference options and the device,
+  // so that a driver update or a different GPU never reuses stale binaries.
+  delegates::SerializationEntry GetSerializationEntry(
       TfLiteContext* context, const TfLiteDelegateParams* delegate_params,
-      std::unique_ptr<InferenceBuilder>* builder, cl::InferenceOptions* options,
-      cl::InferenceEnvironmentOptions* env_options,
-      cl::InferenceEnvironmentProperties* properties,
+      const cl::InferenceOptions& options,
+      const cl::InferenceEnvironmentProperties& properties,
       Serialization* serialization) {
-    if (!serialization) return absl::InvalidArgumentError("No serialization");
     // We use a fingerprint of the options to ensure compatibility.
     std::string options_fingerprint =
-        delegates::StrFingerprint(options, sizeof(cl::InferenceOptions));
-    auto data_key = serialization->GetEntryForKernel(
-        std::string(kSerializedDataPrefix) + options_fingerprint, context,
-        delegate_params);
+        delegates::StrFingerprint(&options, sizeof(cl::InferenceOptions));
+    std::string device_fingerprint = delegates::StrFingerprint(
+        properties.device_fingerprint.data(),
+        properties.device_fingerprint.size());
+    return serialization->GetEntryForKernel(
+        std::string(kSerializedDataPrefix) + options_fingerprint + "_" +
+            device_fingerprint,
+        context, delegate_params);
+  }
 
+  // Returns Ok only if serialized data is successsfully found and is still
+  // valid for the current device.
+  absl::Status MaybeInitializeSerializedOpenCL(
+      TfLiteContext* context, const delegates::SerializationEntry& data_entry,
+      std::unique_ptr<InferenceBuilder>* builder) {
     std::string model_data;
-    auto model_data_status = data_key.GetData(context, &model_data);
-    if (model_data_status == kTfLiteOk) {
-      absl::Span<const uint8_t> model_span = absl::Span<const uint8_t>{
-          reinterpret_cast<const uint8_t*>(model_data.data()),
-          model_data.size()};
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(
-          *env_options, &cl_environment_, properties));
-      RETURN_IF_ERROR(
-          cl_environment_->NewInferenceBuilder(model_span, builder));
-      TFLITE_LOG_PROD_ONCE(
-          tflite::TFLITE_LOG_INFO,
-          "Initialized OpenCL-based API from serialized data.");
-      return absl::OkStatus();
+    auto model_data_status = data_entry.GetData(context, &model_data);
+    if (model_data_status != kTfLiteOk) {
+      return absl::NotFoundError("Serialization data not found");
     }
-
-    return absl::NotFoundError("Serialization data not found");
+    absl::Span<const uint8_t> model_span = absl::Span<const uint8_t>{
+        reinterpret_cast<const uint8_t*>(model_data.data()), model_data.size()};
+    const absl::Status status =
+        cl_environment_->NewInferenceBuilder(model_span, builder);
+    if (!status.ok()) {
+      // The data is corrupted or was written by an incompatible version; it is
+      // overwritten once the model has been rebuilt.
+      TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                      "Discarding serialized OpenCL data: %s",
+                      std::string(status.message()).c_str());
+      return status;
+    }
+    TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
+                         "Initialized OpenCL-based API from serialized data.");
+    return absl::OkStatus();
   }
 
   // Returns Ok only if serialization happens successfully.
   absl::Status SaveSerializedOpenCL(
-      TfLiteContext* context, const TfLiteDelegateParams* delegate_params,
-      cl::InferenceOptions* options, Serialization* serialization,
+      TfLiteContext* context, const delegates::SerializationEntry& data_entry,
       const std::vector<uint8_t>& serialized_model) {
-    if (!serialization) return absl::InvalidArgumentError("No serialization");
-    // We use a fingerprint of the options to ensure compatibility.
-    std::string options_fingerprint =
-        delegates::StrFingerprint(options, sizeof(cl::InferenceOptions));
-
-    // Save data.
-    auto data_key = serialization->GetEntryForKernel(
-        std::string(kSerializedDataPrefix) + options_fingerprint, context,
-        delegate_params);
-    auto save_status = data_key.SetData(
+    auto save_status = data_entry.SetData(
         context, reinterpret_cast<const char*>(serialized_model.data()),
         serialized_model.size());
     if (save_status != kTfLiteOk) {
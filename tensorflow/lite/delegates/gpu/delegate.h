@@ -60,6 +60,9 @@ enum TfLiteGpuExperimentalFlags {
   // at the cost of space on disk.
   // Delegate performs serialization the first time it is applied with a new
   // model or inference params. Later initializations are fast.
+  // The data holds the compiled OpenCL programs and the tuned work group sizes.
+  // It is keyed by the GPU and its driver as well, so it is regenerated when
+  // either changes.
   // ModifyGraphWithDelegate will fail if data cannot be serialized.
   //
   // NOTE: User also needs to set serialization_dir & model_token in
@@ -0,0 +1,233 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+constexpr int kInputChannels = 4;
+constexpr int kOutputChannels = 2;
+
+// Creates a model with two fully connected ops on the same input, whose INT8
+// filters share one buffer, as the converter does for identical buffers, but
+// are dequantized with different scales.
+std::vector<char> CreateSharedBufferModel() {
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<flatbuffers::Offset<OperatorCode>> operator_codes{
+      {CreateOperatorCode(builder, BuiltinOperator_DEQUANTIZE),
+       CreateOperatorCode(builder, BuiltinOperator_FULLY_CONNECTED)}};
+
+  const std::array<int8_t, kInputChannels * kOutputChannels> filter_data{
+      {1, -2, 3, -4, 5, -6, 7, -8}};
+  std::vector<flatbuffers::Offset<Buffer>> buffers{
+      {CreateBuffer(builder, builder.CreateVector({})),
+       CreateBuffer(builder,
+                    builder.CreateVector(
+                        reinterpret_cast<const uint8_t*>(filter_data.data()),
+                        filter_data.size()))}};
+
+  const std::array<int32_t, 2> input_shape{{1, kInputChannels}};
+  const std::array<int32_t, 2> filter_shape{{kOutputChannels, kInputChannels}};
+  const std::array<int32_t, 2> output_shape{{1, kOutputChannels}};
+  const auto shape = [&](const std::array<int32_t, 2>& dims) {
+    return builder.CreateVector<int32_t>(dims.data(), dims.size());
+  };
+  const auto quantized_filter = [&](float scale) {
+    return CreateTensor(builder, shape(filter_shape), TensorType_INT8,
+                        /*buffer=*/1, /*name=*/0,
+                        CreateQuantizationParameters(
+                            builder, /*min=*/0, /*max=*/0,
+                            builder.CreateVector<float>({scale}),
+                            builder.CreateVector<int64_t>({0})));
+  };
+  const std::vector<flatbuffers::Offset<Tensor>> tensors{{
+      quantized_filter(0.5f),
+      quantized_filter(0.25f),
+      CreateTensor(builder, shape(input_shape), TensorType_FLOAT32),
+      CreateTensor(builder, shape(filter_shape), TensorType_FLOAT32),
+      CreateTensor(builder, shape(filter_shape), TensorType_FLOAT32),
+      CreateTensor(builder, shape(output_shape), TensorType_FLOAT32),
+      CreateTensor(builder, shape(output_shape), TensorType_FLOAT32),
+  }};
+
+  const auto dequantize = [&](int32_t input, int32_t output) {
+    const std::array<int32_t, 1> inputs{{input}};
+    const std::array<int32_t, 1> outputs{{output}};
+    return CreateOperator(
+        builder, /*opcode_index=*/0,
+        builder.CreateVector<int32_t>(inputs.data(), inputs.size()),
+        builder.CreateVector<int32_t>(outputs.data(), outputs.size()));
+  };
+  const auto fully_connected = [&](int32_t filter, int32_t output) {
+    const std::array<int32_t, 2> inputs{{2, filter}};
+    const std::array<int32_t, 1> outputs{{output}};
+    return CreateOperator(
+        builder, /*opcode_index=*/1,
+        builder.CreateVector<int32_t>(inputs.data(), inputs.size()),
+        builder.CreateVector<int32_t>(outputs.data(), outputs.size()),
+        BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder).Union());
+  };
+  const std::vector<flatbuffers::Offset<Operator>> operators{{
+      dequantize(0, 3),
+      dequantize(1, 4),
+      fully_connected(3, 5),
+      fully_connected(4, 6),
+  }};
+
+  const std::array<int32_t, 1> subgraph_inputs{{2}};
+  const std::array<int32_t, 2> subgraph_outputs{{5, 6}};
+  flatbuffers::Offset<SubGraph> subgraph = CreateSubGraph(
+      builder, builder.CreateVector(tensors.data(), tensors.size()),
+      builder.CreateVector<int32_t>(subgraph_inputs.data(),
+                                    subgraph_inputs.size()),
+      builder.CreateVector<int32_t>(subgraph_outputs.data(),
+                                    subgraph_outputs.size()),
+      builder.CreateVector(operators.data(), operators.size()));
+
+  flatbuffers::Offset<Model> model_buffer = CreateModel(
+      builder, TFLITE_SCHEMA_VERSION,
+      builder.CreateVector(operator_codes.data(), operator_codes.size()),
+      builder.CreateVector(&subgraph, 1),
+      builder.CreateString("Shared buffer model"),
+      builder.CreateVector(buffers.data(), buffers.size()));
+  builder.Finish(model_buffer);
+
+  return std::vector<char>(builder.GetBufferPointer(),
+                           builder.GetBufferPointer() + builder.GetSize());
+}
+
+std::unique_ptr<Interpreter> CreateInterpreter(const Model* model) {
+  std::unique_ptr<Interpreter> interpreter;
+  EXPECT_EQ(
+      InterpreterBuilder(
+          model,
+          ::tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates())(
+          &interpreter),
+      kTfLiteOk);
+  EXPECT_TRUE(interpreter);
+  if (interpreter) {
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  }
+  return interpreter;
+}
+
+using DelegatePtr =
+    std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>;
+
+DelegatePtr CreateDelegate(TfLiteXNNPackDelegateWeightsCache* weights_cache) {
+  TfLiteXNNPackDelegateOptions delegate_options =
+      TfLiteXNNPackDelegateOptionsDefault();
+  delegate_options.weights_cache = weights_cache;
+  return DelegatePtr(TfLiteXNNPackDelegateCreate(&delegate_options),
+                     TfLiteXNNPackDelegateDelete);
+}
+
+// Checks that both outputs of `interpreter` match those of the reference
+// interpreter without delegate.
+void ExpectMatchesReference(Interpreter* interpreter,
+                            Interpreter* reference_interpreter) {
+  const std::array<float, kInputChannels> input{{0.5f, -1.0f, 2.0f, 1.5f}};
+  for (Interpreter* i : {interpreter, reference_interpreter}) {
+    std::copy(input.begin(), input.end(), i->typed_input_tensor<float>(0));
+    ASSERT_EQ(i->Invoke(), kTfLiteOk);
+  }
+  for (int output = 0; output < 2; output++) {
+    const float* data = interpreter->typed_output_tensor<float>(output);
+    const float* reference_data =
+        reference_interpreter->typed_output_tensor<float>(output);
+    for (int c = 0; c < kOutputChannels; c++) {
+      EXPECT_FLOAT_EQ(reference_data[c], data[c])
+          << "output " << output << ", channel " << c;
+    }
+  }
+}
+
+TEST(WeightsCache, SharedBufferWithDifferentScales) {
+  std::vector<char> buffer = CreateSharedBufferModel();
+  const Model* model = GetModel(buffer.data());
+  std::unique_ptr<TfLiteXNNPackDelegateWeightsCache,
+                  decltype(&TfLiteXNNPackDelegateWeightsCacheDelete)>
+      weights_cache(TfLiteXNNPackDelegateWeightsCacheCreate(),
+                    TfLiteXNNPackDelegateWeightsCacheDelete);
+  DelegatePtr delegate = CreateDelegate(weights_cache.get());
+
+  std::unique_ptr<Interpreter> interpreter = CreateInterpreter(model);
+  std::unique_ptr<Interpreter> reference_interpreter = CreateInterpreter(model);
+  ASSERT_TRUE(interpreter && reference_interpreter);
+  ASSERT_EQ(interpreter->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+
+  // Both filters are unpacked, although they share their packed data.
+  EXPECT_EQ(2,
+            TfLiteXNNPackDelegateWeightsCacheNumEntries(weights_cache.get()));
+  ExpectMatchesReference(interpreter.get(), reference_interpreter.get());
+}
+
+TEST(WeightsCache, SharedAcrossInterpreters) {
+  std::vector<char> buffer = CreateSharedBufferModel();
+  const Model* model = GetModel(buffer.data());
+  TfLiteXNNPackDelegateWeightsCache* weights_cache =
+      TfLiteXNNPackDelegateWeightsCacheCreate();
+  DelegatePtr delegate1 = CreateDelegate(weights_cache);
+  DelegatePtr delegate2 = CreateDelegate(weights_cache);
+
+  std::unique_ptr<Interpreter> interpreter1 = CreateInterpreter(model);
+  std::unique_ptr<Interpreter> interpreter2 = CreateInterpreter(model);
+  std::unique_ptr<Interpreter> reference_interpreter = CreateInterpreter(model);
+  ASSERT_TRUE(interpreter1 && interpreter2 && reference_interpreter);
+
+  ASSERT_EQ(interpreter1->ModifyGraphWithDelegate(delegate1.get()), kTfLiteOk);
+  EXPECT_EQ(2, TfLiteXNNPackDelegateWeightsCacheNumEntries(weights_cache));
+  // The second interpreter reuses the filters that the first one unpacked.
+  ASSERT_EQ(interpreter2->ModifyGraphWithDelegate(delegate2.get()), kTfLiteOk);
+  EXPECT_EQ(2, TfLiteXNNPackDelegateWeightsCacheNumEntries(weights_cache));
+
+  // The delegates keep the weights they use after the cache is deleted.
+  TfLiteXNNPackDelegateWeightsCacheDelete(weights_cache);
+  ExpectMatchesReference(interpreter1.get(), reference_interpreter.get());
+  ExpectMatchesReference(interpreter2.get(), reference_interpreter.get());
+}
+
+TEST(WeightsCache, NotSharedWithoutCache) {
+  std::vector<char> buffer = CreateSharedBufferModel();
+  const Model* model = GetModel(buffer.data());
+  DelegatePtr delegate = CreateDelegate(/*weights_cache=*/nullptr);
+
+  std::unique_ptr<Interpreter> interpreter = CreateInterpreter(model);
+  std::unique_ptr<Interpreter> reference_interpreter = CreateInterpreter(model);
+  ASSERT_TRUE(interpreter && reference_interpreter);
+  ASSERT_EQ(interpreter->ModifyGraphWithDelegate(delegate.get()), kTfLiteOk);
+
+  ExpectMatchesReference(interpreter.get(), reference_interpreter.get());
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
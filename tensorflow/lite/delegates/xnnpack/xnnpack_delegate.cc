@@ -19,8 +19,10 @@ limitations under the License.
 #include <array>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -37,6 +39,76 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/utils/sparsity_format_converter.h"
 #include "tensorflow/lite/minimal_logging.h"
 
+// Cache of unpacked data for quasi-static tensors, shared by the delegates of
+// the interpreters created from one model. Entries are keyed by the address of
+// the packed data, which is only unique while the model is alive, so the cache
+// is owned by the user with the model rather than by any delegate.
+struct TfLiteXNNPackDelegateWeightsCache {
+  struct Key {
+    const char* packed_data;
+    // Tensors that share a buffer may still unpack it differently, e.g. when
+    // the converter merged identical buffers of tensors with different
+    // quantization parameters, so the key has all the inputs of the unpacking.
+    int input_tensor;
+    int output_tensor;
+    int builtin_code;
+    TfLiteType input_type;
+    TfLiteType output_type;
+    size_t unpacked_bytes;
+    float scale;
+    int32_t zero_point;
+
+    bool operator==(const Key& other) const {
+      return packed_data == other.packed_data &&
+             input_tensor == other.input_tensor &&
+             output_tensor == other.output_tensor &&
+             builtin_code == other.builtin_code &&
+             input_type == other.input_type &&
+             output_type == other.output_type &&
+             unpacked_bytes == other.unpacked_bytes && scale == other.scale &&
+             zero_point == other.zero_point;
+    }
+  };
+
+  // Returns the unpacked data for `key`, or nullptr if it was not added yet.
+  std::shared_ptr<const std::vector<char>> Lookup(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(key);
+    return it == entries_.end() ? nullptr : it->second;
+  }
+
+  // Adds the unpacked data for `key`. Returns the data to use, which differs
+  // from `data` if another delegate has added it in the meantime.
+  std::shared_ptr<const std::vector<char>> Insert(
+      const Key& key, std::shared_ptr<const std::vector<char>> data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.emplace(key, std::move(data)).first->second;
+  }
+
+  size_t NumEntries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = std::hash<const char*>()(key.packed_data);
+      hash = hash * 31 + key.input_tensor;
+      hash = hash * 31 + key.output_tensor;
+      hash = hash * 31 + key.builtin_code;
+      hash = hash * 31 + key.output_type;
+      return hash * 31 + key.unpacked_bytes;
+    }
+  };
+
+  std::mutex mutex_;
+  // Delegates hold references to the entries they use, so that they can
+  // outlive the cache.
+  std::unordered_map<Key, std::shared_ptr<const std::vector<char>>, KeyHash>
+      entries_;
+};
+
 namespace tflite {
 namespace xnnpack {
 namespace {
@@ -84,11 +156,12 @@ class Delegate {
   };
 
   // Unpacked data for quasi-static tensors, i.e. tensors produced by
-  // dequantizing or unpacking static buffers.
-  std::vector<char> static_unpacked_data_;
-  // Mapping from a tensor index for a quasi-static tensor to the offset to
-  // its unpacked data within static_unpacked_data_.
-  std::unordered_map<int, size_t> static_unpacked_data_map_;
+  // dequantizing or unpacking static buffers. The buffers are shared with the
+  // other delegates created with the same weights cache.
+  std::vector<std::shared_ptr<const std::vector<char>>> static_unpacked_data_;
+  // Mapping from a tensor index for a quasi-static tensor to its unpacked data
+  // within static_unpacked_data_.
+  std::unordered_map<int, const char*> static_unpacked_data_map_;
   // Set of indices of nodes which unpack static data, e.g. Dequantize
   // operators which convert FP16 static weights to FP32. These nodes are simply
   // ignored in the delegate implementation, because their outputs are
@@ -427,7 +500,7 @@ class Subgraph {
         // Check for quasi-static data.
         const auto it = delegate->static_unpacked_data_map_.find(t);
         if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
+          data = it->second;
         }
       }
       if (inputs.count(t) != 0) {
@@ -489,7 +562,7 @@ class Subgraph {
 
     // Create a set of quasi-static tensors for VisitNode function
     std::unordered_set<int> quasi_static_tensors;
-    for (const std::pair<const int, size_t>& entry :
+    for (const std::pair<const int, const char*>& entry :
          delegate->static_unpacked_data_map_) {
       quasi_static_tensors.insert(entry.first);
     }
@@ -3665,18 +3738,34 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
       }
     }
 
-    // Align to XNN_EXTRA_BYTES bytes
-    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
-      static_unpacked_data_.push_back(0);
-    }
-    const size_t tensor_offset = static_unpacked_data_.size();
-    static_unpacked_data_.resize(tensor_offset + context->tensors[t].bytes);
-
-    char* unpacked_data = static_unpacked_data_.data() + tensor_offset;
     const char* packed_data =
         static_unpacked_input_it_ != static_unpacked_data_map_.end()
-            ? static_unpacked_data_.data() + static_unpacked_input_it_->second
+            ? static_unpacked_input_it_->second
             : static_cast<const char*>(input_tensor.data.data);
+    TfLiteXNNPackDelegateWeightsCache* cache = options_.weights_cache;
+    const TfLiteXNNPackDelegateWeightsCache::Key cache_key = {
+        packed_data,
+        node->inputs->data[0],
+        t,
+        registration->builtin_code,
+        input_tensor.type,
+        output_tensor.type,
+        output_tensor.bytes,
+        input_tensor.params.scale,
+        input_tensor.params.zero_point,
+    };
+    std::shared_ptr<const std::vector<char>> cached_data =
+        cache != nullptr ? cache->Lookup(cache_key) : nullptr;
+    if (cached_data != nullptr) {
+      static_unpacked_data_.push_back(cached_data);
+      static_unpacked_data_map_[t] = cached_data->data();
+      continue;
+    }
+
+    // XNNPACK may read up to XNN_EXTRA_BYTES past the end of the data.
+    auto unpacked_buffer = std::make_shared<std::vector<char>>(
+        output_tensor.bytes + XNN_EXTRA_BYTES);
+    char* unpacked_data = unpacked_buffer->data();
     switch (registration->builtin_code) {
       case kTfLiteBuiltinDequantize: {
         // Such a condition has been checked when preparing to unpack FP16/INT8
@@ -3772,7 +3861,13 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
         return nullptr;  // Hard error.
     }
 
-    static_unpacked_data_map_[t] = tensor_offset;
+    if (cache != nullptr) {
+      cached_data = cache->Insert(cache_key, std::move(unpacked_buffer));
+    } else {
+      cached_data = std::move(unpacked_buffer);
+    }
+    static_unpacked_data_.push_back(cached_data);
+    static_unpacked_data_map_[t] = cached_data->data();
   }
 
   // Add nodes that unpack static data consumed by delegated nodes.
@@ -3878,6 +3973,20 @@ TfLiteDelegate* TfLiteXNNPackDelegateCreate(
   return xnnpack_delegate ? xnnpack_delegate->tflite_delegate() : nullptr;
 }
 
+TfLiteXNNPackDelegateWeightsCache* TfLiteXNNPackDelegateWeightsCacheCreate() {
+  return new TfLiteXNNPackDelegateWeightsCache();
+}
+
+size_t TfLiteXNNPackDelegateWeightsCacheNumEntries(
+    TfLiteXNNPackDelegateWeightsCache* cache) {
+  return cache != nullptr ? cache->NumEntries() : 0;
+}
+
+void TfLiteXNNPackDelegateWeightsCacheDelete(
+    TfLiteXNNPackDelegateWeightsCache* cache) {
+  delete cache;
+}
+
 void* TfLiteXNNPackDelegateGetThreadPool(TfLiteDelegate* delegate) {
   if (delegate == nullptr) {
     return nullptr;
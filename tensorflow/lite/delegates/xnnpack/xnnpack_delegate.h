@@ -22,10 +22,21 @@ limitations under the License.
 extern "C" {
 #endif  // __cplusplus
 
+// Cache of the static weights that the delegate unpacks, e.g. FP16 or INT8
+// weights dequantized to FP32, shared by the delegates created with it. A cache
+// is only valid for one model: create it with the model, use it for the
+// delegates of all the interpreters created from the model, and delete it
+// with the model.
+typedef struct TfLiteXNNPackDelegateWeightsCache
+    TfLiteXNNPackDelegateWeightsCache;
+
 typedef struct {
   // Number of threads to use in the thread pool.
   // 0 or negative value means no thread pool used.
   int32_t num_threads;
+  // Cache of unpacked weights to share with the other delegates for the same
+  // model. nullptr means that the delegate unpacks its own copy.
+  TfLiteXNNPackDelegateWeightsCache* weights_cache;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
@@ -45,6 +56,24 @@ TFL_CAPI_EXPORT TfLiteDelegate* TfLiteXNNPackDelegateCreate(
 TFL_CAPI_EXPORT void* TfLiteXNNPackDelegateGetThreadPool(
     TfLiteDelegate* delegate);
 
+// Creates a new weights cache that need to be destroyed with
+// `TfLiteXNNPackDelegateWeightsCacheDelete` when the model it is used for is
+// destroyed.
+TFL_CAPI_EXPORT TfLiteXNNPackDelegateWeightsCache*
+TfLiteXNNPackDelegateWeightsCacheCreate();
+
+// Returns the number of unpacked tensors in the weights cache.
+//
+// WARNING: This API is experimental and subject to change.
+TFL_CAPI_EXPORT size_t TfLiteXNNPackDelegateWeightsCacheNumEntries(
+    TfLiteXNNPackDelegateWeightsCache* cache);
+
+// Destroys a weights cache created with
+// `TfLiteXNNPackDelegateWeightsCacheCreate` call. The delegates created with
+// the cache keep the weights that they use.
+TFL_CAPI_EXPORT void TfLiteXNNPackDelegateWeightsCacheDelete(
+    TfLiteXNNPackDelegateWeightsCache* cache);
+
 // Destroys a delegate created with `TfLiteXNNPackDelegateCreate` call.
 TFL_CAPI_EXPORT void TfLiteXNNPackDelegateDelete(TfLiteDelegate* delegate);
 
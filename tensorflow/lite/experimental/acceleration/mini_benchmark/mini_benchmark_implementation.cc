@@ -227,7 +227,9 @@ class MemoizedBestAccelerationSelector {
         "Found best latency for %s with delegate %s ( %ld us).\n",
         model_id_.c_str(), delegate.c_str(), min_latency);
 
-    if (min_latency_event->tflite_settings()->delegate() == Delegate_NONE) {
+    // CPU settings to test, e.g. a thread count, are returned like delegates.
+    if (min_latency_event->tflite_settings()->delegate() == Delegate_NONE &&
+        min_latency_event->tflite_settings()->cpu_settings() == nullptr) {
       TFLITE_LOG_PROD_ONCE(
           TFLITE_LOG_INFO,
           "Best latency for %s is without a delegate, not overring defaults.\n",
@@ -0,0 +1,133 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/acceleration/mini_benchmark/settings_sweep.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/acceleration/configuration/configuration_generated.h"
+#include "tensorflow/lite/experimental/acceleration/configuration/delegate_registry.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace acceleration {
+namespace {
+
+std::unique_ptr<TFLiteSettingsT> CreateCpuSettings(Delegate delegate,
+                                                   int num_threads) {
+  auto settings = std::make_unique<TFLiteSettingsT>();
+  settings->delegate = delegate;
+  settings->cpu_settings = std::make_unique<CPUSettingsT>();
+  settings->cpu_settings->num_threads = num_threads;
+  if (delegate == Delegate_XNNPACK) {
+    settings->xnnpack_settings = std::make_unique<XNNPackSettingsT>();
+    settings->xnnpack_settings->num_threads = num_threads;
+  }
+  return settings;
+}
+
+std::unique_ptr<TFLiteSettingsT> CreateGpuSettings(
+    bool is_precision_loss_allowed) {
+  auto settings = std::make_unique<TFLiteSettingsT>();
+  settings->delegate = Delegate_GPU;
+  settings->gpu_settings = std::make_unique<GPUSettingsT>();
+  settings->gpu_settings->is_precision_loss_allowed =
+      is_precision_loss_allowed;
+  return settings;
+}
+
+// Returns the name of the plugin creating `delegate`, as used by the
+// validator, or nullptr if there is no such plugin.
+const char* DelegatePluginName(Delegate delegate) {
+  switch (delegate) {
+    case Delegate_NNAPI:
+      return "NnapiPlugin";
+    case Delegate_GPU:
+      return "GpuPlugin";
+    case Delegate_XNNPACK:
+      return "XNNPackPlugin";
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+std::vector<std::unique_ptr<TFLiteSettingsT>> CreateSettingsSweep(
+    const SettingsSweepOptions& options) {
+  std::vector<std::unique_ptr<TFLiteSettingsT>> sweep;
+  for (int num_threads : options.num_threads) {
+    sweep.push_back(CreateCpuSettings(Delegate_NONE, num_threads));
+    if (options.include_xnnpack) {
+      sweep.push_back(CreateCpuSettings(Delegate_XNNPACK, num_threads));
+    }
+  }
+  if (options.include_gpu) {
+    sweep.push_back(CreateGpuSettings(/*is_precision_loss_allowed=*/false));
+    sweep.push_back(CreateGpuSettings(/*is_precision_loss_allowed=*/true));
+  }
+  return sweep;
+}
+
+void AddSettingsSweep(const SettingsSweepOptions& options,
+                      MinibenchmarkSettingsT* settings) {
+  for (auto& one_setting : CreateSettingsSweep(options)) {
+    settings->settings_to_test.push_back(std::move(one_setting));
+  }
+}
+
+TfLiteStatus ConfigureInterpreterBuilder(
+    const ComputeSettingsT& compute_settings, InterpreterBuilder* builder,
+    BuilderAcceleration* acceleration) {
+  if (compute_settings.tflite_settings == nullptr) return kTfLiteOk;
+  const TFLiteSettingsT& tflite_settings = *compute_settings.tflite_settings;
+  if (tflite_settings.cpu_settings != nullptr &&
+      tflite_settings.cpu_settings->num_threads != -1) {
+    TF_LITE_ENSURE_STATUS(
+        builder->SetNumThreads(tflite_settings.cpu_settings->num_threads));
+  }
+  if (tflite_settings.delegate == Delegate_NONE) return kTfLiteOk;
+
+  const char* plugin_name = DelegatePluginName(tflite_settings.delegate);
+  if (plugin_name == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "Unsupported delegate %s.\n",
+                    EnumNameDelegate(tflite_settings.delegate));
+    return kTfLiteError;
+  }
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(TFLiteSettings::Pack(fbb, &tflite_settings));
+  acceleration->plugin = delegates::DelegatePluginRegistry::CreateByName(
+      plugin_name,
+      *flatbuffers::GetRoot<TFLiteSettings>(fbb.GetBufferPointer()));
+  if (acceleration->plugin == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "%s is not linked in.\n", plugin_name);
+    return kTfLiteError;
+  }
+  acceleration->delegate = acceleration->plugin->Create();
+  if (acceleration->delegate == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "Failed to create %s delegate.\n",
+                    EnumNameDelegate(tflite_settings.delegate));
+    return kTfLiteError;
+  }
+  builder->AddDelegate(acceleration->delegate.get());
+  return kTfLiteOk;
+}
+
+}  // namespace acceleration
+}  // namespace tflite
@@ -0,0 +1,73 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_ACCELERATION_MINI_BENCHMARK_SETTINGS_SWEEP_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_ACCELERATION_MINI_BENCHMARK_SETTINGS_SWEEP_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/acceleration/configuration/configuration_generated.h"
+#include "tensorflow/lite/experimental/acceleration/configuration/delegate_registry.h"
+#include "tensorflow/lite/interpreter_builder.h"
+
+namespace tflite {
+namespace acceleration {
+
+// Which configurations to sweep with the mini-benchmark.
+struct SettingsSweepOptions {
+  // Thread counts tried for the CPU configurations.
+  std::vector<int> num_threads = {1, 2, 4};
+  // Whether to try the XNNPACK delegate, in addition to the built-in kernels,
+  // with each thread count.
+  bool include_xnnpack = true;
+  // Whether to try the GPU delegate, both with and without allowing precision
+  // loss.
+  bool include_gpu = true;
+};
+
+// Returns the configurations described by `options`, to be used as the
+// `settings_to_test` of MinibenchmarkSettings. The mini-benchmark then picks
+// the fastest configuration that runs correctly on the device and persists it,
+// see MiniBenchmark::GetBestAcceleration().
+std::vector<std::unique_ptr<TFLiteSettingsT>> CreateSettingsSweep(
+    const SettingsSweepOptions& options);
+
+// Appends the configurations described by `options` to the `settings_to_test`
+// of `settings`.
+void AddSettingsSweep(const SettingsSweepOptions& options,
+                      MinibenchmarkSettingsT* settings);
+
+// The delegate configured by ConfigureInterpreterBuilder(). It must outlive
+// the interpreters built with the configured builder.
+struct BuilderAcceleration {
+  std::unique_ptr<delegates::DelegatePluginInterface> plugin;
+  delegates::TfLiteDelegatePtr delegate{nullptr, [](TfLiteDelegate*) {}};
+};
+
+// Configures `builder` with the thread count and delegate of
+// `compute_settings`, typically the result of
+// MiniBenchmark::GetBestAcceleration(), so that the configuration chosen for
+// the device is applied when the model is loaded. Does nothing if
+// `compute_settings` has no TFLiteSettings. The plugin of the delegate must be
+// linked in. Returns kTfLiteError if the delegate can't be created.
+TfLiteStatus ConfigureInterpreterBuilder(
+    const ComputeSettingsT& compute_settings, InterpreterBuilder* builder,
+    BuilderAcceleration* acceleration);
+
+}  // namespace acceleration
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_ACCELERATION_MINI_BENCHMARK_SETTINGS_SWEEP_H_
@@ -0,0 +1,119 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/acceleration/mini_benchmark/settings_sweep.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/experimental/acceleration/configuration/configuration_generated.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+namespace acceleration {
+namespace {
+
+TEST(SettingsSweepTest, SweepsThreadsAndDelegates) {
+  SettingsSweepOptions options;
+  options.num_threads = {1, 4};
+  auto sweep = CreateSettingsSweep(options);
+  ASSERT_EQ(sweep.size(), 6);
+  EXPECT_EQ(sweep[0]->delegate, Delegate_NONE);
+  EXPECT_EQ(sweep[0]->cpu_settings->num_threads, 1);
+  EXPECT_EQ(sweep[1]->delegate, Delegate_XNNPACK);
+  EXPECT_EQ(sweep[1]->xnnpack_settings->num_threads, 1);
+  EXPECT_EQ(sweep[2]->delegate, Delegate_NONE);
+  EXPECT_EQ(sweep[2]->cpu_settings->num_threads, 4);
+  EXPECT_EQ(sweep[3]->delegate, Delegate_XNNPACK);
+  EXPECT_EQ(sweep[3]->xnnpack_settings->num_threads, 4);
+  EXPECT_EQ(sweep[4]->delegate, Delegate_GPU);
+  EXPECT_FALSE(sweep[4]->gpu_settings->is_precision_loss_allowed);
+  EXPECT_EQ(sweep[5]->delegate, Delegate_GPU);
+  EXPECT_TRUE(sweep[5]->gpu_settings->is_precision_loss_allowed);
+}
+
+TEST(SettingsSweepTest, AddsToSettingsToTest) {
+  SettingsSweepOptions options;
+  options.num_threads = {2};
+  options.include_xnnpack = false;
+  options.include_gpu = false;
+  MinibenchmarkSettingsT settings;
+  settings.settings_to_test.push_back(std::make_unique<TFLiteSettingsT>());
+  AddSettingsSweep(options, &settings);
+  ASSERT_EQ(settings.settings_to_test.size(), 2);
+  EXPECT_EQ(settings.settings_to_test[1]->cpu_settings->num_threads, 2);
+}
+
+class ConfigureInterpreterBuilderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/add.bin");
+    ASSERT_NE(model_, nullptr);
+    builder_ = std::make_unique<InterpreterBuilder>(*model_, resolver_);
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+  std::unique_ptr<InterpreterBuilder> builder_;
+};
+
+TEST_F(ConfigureInterpreterBuilderTest, NoSettings) {
+  BuilderAcceleration acceleration;
+  EXPECT_EQ(ConfigureInterpreterBuilder(ComputeSettingsT(), builder_.get(),
+                                        &acceleration),
+            kTfLiteOk);
+  EXPECT_EQ(acceleration.delegate, nullptr);
+}
+
+TEST_F(ConfigureInterpreterBuilderTest, AppliesXNNPackSettings) {
+  SettingsSweepOptions options;
+  options.num_threads = {2};
+  options.include_gpu = false;
+  ComputeSettingsT compute_settings;
+  compute_settings.tflite_settings =
+      std::move(CreateSettingsSweep(options).back());
+  BuilderAcceleration acceleration;
+  ASSERT_EQ(ConfigureInterpreterBuilder(compute_settings, builder_.get(),
+                                        &acceleration),
+            kTfLiteOk);
+  ASSERT_NE(acceleration.delegate, nullptr);
+
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ((*builder_)(&interpreter), kTfLiteOk);
+  // The add model is fully delegated.
+  EXPECT_EQ(interpreter->execution_plan().size(), 1);
+  EXPECT_EQ(
+      interpreter->node_and_registration(interpreter->execution_plan()[0])
+          ->first.delegate,
+      acceleration.delegate.get());
+}
+
+TEST_F(ConfigureInterpreterBuilderTest, RejectsUnsupportedDelegate) {
+  ComputeSettingsT compute_settings;
+  compute_settings.tflite_settings = std::make_unique<TFLiteSettingsT>();
+  compute_settings.tflite_settings->delegate = Delegate_EDGETPU;
+  BuilderAcceleration acceleration;
+  EXPECT_EQ(ConfigureInterpreterBuilder(compute_settings, builder_.get(),
+                                        &acceleration),
+            kTfLiteError);
+}
+
+}  // namespace
+}  // namespace acceleration
+}  // namespace tflite
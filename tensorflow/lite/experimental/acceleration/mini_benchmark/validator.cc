@@ -159,7 +159,17 @@ MinibenchmarkStatus Validator::CheckModel(bool load_only) {
       "validation/decode_jpeg",
       ::tflite::acceleration::decode_jpeg_kernel::Register_DECODE_JPEG(), 1);
 
-  tflite::InterpreterBuilder(*model_, resolver_)(&interpreter_);
+  tflite::InterpreterBuilder builder(*model_, resolver_);
+  // Benchmark the thread count being tested as well, which also applies to the
+  // nodes not handled by the delegate.
+  if (compute_settings_ && compute_settings_->tflite_settings() &&
+      compute_settings_->tflite_settings()->cpu_settings() &&
+      compute_settings_->tflite_settings()->cpu_settings()->num_threads() !=
+          -1) {
+    builder.SetNumThreads(
+        compute_settings_->tflite_settings()->cpu_settings()->num_threads());
+  }
+  builder(&interpreter_);
   if (!interpreter_) {
     return kMinibenchmarkInterpreterBuilderFailed;
   }
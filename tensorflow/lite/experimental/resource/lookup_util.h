@@ -97,6 +97,7 @@ class TensorWriter<std::string> {
   void SetData(int index, const std::string& value) {
     buf_.AddString(value.data(), value.length());
   }
+  void SetData(int index, const StringRef& value) { buf_.AddString(value); }
 
   // Commit updates. The stored data in DynamicBuffer will be written into the
   // tensor storage.
@@ -15,13 +15,129 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/resource/static_hashtable.h"
 
+#include <cstring>
 #include <memory>
+#include <vector>
+
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
 
 namespace tflite {
 namespace resource {
 namespace internal {
 
+namespace {
+
+// Slots are probed in groups of kGroupWidth, whose control bytes are packed
+// in a 64-bit word and matched all at once.
+constexpr size_t kGroupWidth = 8;
+// The control byte of an empty slot. Full slots hold 7 bits of the hash of
+// their key, so only empty slots have the high bit set.
+constexpr uint8_t kEmptySlot = 0x80;
+constexpr uint64_t kLowBits = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// The finalizer of MurmurHash3.
+inline uint64_t Mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint64_t HashKey(std::int64_t key) {
+  return Mix(static_cast<uint64_t>(key));
+}
+
+inline uint64_t HashKey(const StringRef& key) {
+  constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+  uint64_t h = kMultiplier ^ static_cast<uint64_t>(key.len);
+  const char* data = key.str;
+  int len = key.len;
+  for (; len >= 8; data += 8, len -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    h = (h ^ Mix(word)) * kMultiplier;
+  }
+  uint64_t tail = 0;
+  for (int i = 0; i < len; ++i) {
+    tail |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+  }
+  return Mix(h ^ tail);
+}
+
+inline bool KeyEquals(std::int64_t a, std::int64_t b) { return a == b; }
+
+inline bool KeyEquals(const StringRef& a, const StringRef& b) {
+  return a.len == b.len && std::memcmp(a.str, b.str, a.len) == 0;
+}
+
+// Splits a hash into the group a probe starts at and the tag stored in the
+// control byte.
+inline size_t HashGroup(uint64_t hash) { return hash >> 7; }
+inline uint8_t HashTag(uint64_t hash) { return hash & 0x7f; }
+
+// Loads the control bytes of a group, with slot i in byte i of the result.
+inline uint64_t LoadGroup(const uint8_t* ctrl) {
+  uint64_t group = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    group |= static_cast<uint64_t>(ctrl[i]) << (8 * i);
+  }
+  return group;
+}
+
+// Returns a mask with the high bit of every byte of `group` equal to `tag`
+// set. Bytes above a match may be reported as well, which callers filter out
+// when comparing the keys.
+inline uint64_t MatchTag(uint64_t group, uint8_t tag) {
+  const uint64_t x = group ^ (kLowBits * tag);
+  return (x - kLowBits) & ~x & kHighBits;
+}
+
+inline uint64_t MatchEmpty(uint64_t group) { return group & kHighBits; }
+
+// Returns the slot of the lowest byte set in a mask from MatchTag() or
+// MatchEmpty().
+inline size_t LowestSlot(uint64_t mask) {
+  const uint64_t lowest = (mask & (~mask + 1)) >> 7;
+  return (lowest * 0x0001020304050607ULL) >> 56;
+}
+
+// Returns a copy of a tensor's data, or the data itself if it is read-only and
+// lives as long as the model.
+const char* GetStableData(const TfLiteTensor* tensor,
+                          std::vector<char>* copy) {
+  if (tensor->allocation_type == kTfLiteMmapRo) {
+    return tensor->data.raw_const;
+  }
+  copy->assign(tensor->data.raw_const, tensor->data.raw_const + tensor->bytes);
+  return copy->data();
+}
+
+}  // namespace
+
+template <typename KeyType, typename ValueType>
+int32_t StaticHashtable<KeyType, ValueType>::FindEntry(
+    const typename KeyReader::Ref& key) const {
+  if (size_ == 0) return -1;
+  const uint64_t hash = HashKey(key);
+  const uint8_t tag = HashTag(hash);
+  size_t group_index = HashGroup(hash) & group_mask_;
+  // Triangular probing visits every group, as their number is a power of two.
+  for (size_t step = 1;; ++step) {
+    const size_t first_slot = group_index * kGroupWidth;
+    const uint64_t group = LoadGroup(&ctrl_[first_slot]);
+    for (uint64_t match = MatchTag(group, tag); match != 0;
+         match &= match - 1) {
+      const int32_t entry = slots_[first_slot + LowestSlot(match)];
+      if (KeyEquals(KeyReader::Get(keys_data_, entry), key)) return entry;
+    }
+    if (MatchEmpty(group) != 0) return -1;
+    group_index = (group_index + step) & group_mask_;
+  }
+}
+
 template <typename KeyType, typename ValueType>
 TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
     TfLiteContext* context, const TfLiteTensor* keys, TfLiteTensor* values,
@@ -34,15 +150,15 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
   auto value_tensor_writer = TensorWriter<ValueType>(values);
   auto default_value_tensor_reader = TensorReader<ValueType>(default_value);
   ValueType first_default_value = default_value_tensor_reader.GetData(0);
 
   for (int i = 0; i < size; ++i) {
-    auto result = map_.find(key_tensor_reader.GetData(i));
-    if (result != map_.end()) {
-      value_tensor_writer.SetData(i, result->second);
+    const int32_t entry = FindEntry(KeyReader::Get(keys->data.raw_const, i));
+    if (entry >= 0) {
+      auto value = ValueReader::Get(values_data_, entry);
+      value_tensor_writer.SetData(i, value);
     } else {
       value_tensor_writer.SetData(i, first_default_value);
     }
@@ -70,10 +186,36 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Import(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
-  auto value_tensor_writer = TensorReader<ValueType>(values);
+  keys_data_ = GetStableData(keys, &owned_keys_);
+  values_data_ = GetStableData(values, &owned_values_);
+
+  // Keeps the load factor at most 7/8.
+  size_t num_groups = 1;
+  while (num_groups * kGroupWidth * 7 < static_cast<size_t>(size) * 8) {
+    num_groups *= 2;
+  }
+  group_mask_ = num_groups - 1;
+  ctrl_.assign(num_groups * kGroupWidth, kEmptySlot);
+  slots_.assign(num_groups * kGroupWidth, -1);
+
   for (int i = 0; i < size; ++i) {
-    map_.insert({key_tensor_reader.GetData(i), value_tensor_writer.GetData(i)});
+    const auto key = KeyReader::Get(keys_data_, i);
+    // Like the TensorFlow kernel, the first of duplicate keys wins.
+    if (FindEntry(key) >= 0) continue;
+    const uint64_t hash = HashKey(key);
+    size_t group_index = HashGroup(hash) & group_mask_;
+    for (size_t step = 1;; ++step) {
+      const size_t first_slot = group_index * kGroupWidth;
+      const uint64_t empty = MatchEmpty(LoadGroup(&ctrl_[first_slot]));
+      if (empty != 0) {
+        const size_t slot = first_slot + LowestSlot(empty);
+        ctrl_[slot] = HashTag(hash);
+        slots_[slot] = i;
+        break;
+      }
+      group_index = (group_index + step) & group_mask_;
+    }
+    ++size_;
   }
 
   is_initialized_ = true;
@@ -15,7 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 #define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
@@ -28,8 +31,35 @@ namespace tflite {
 namespace resource {
 namespace internal {
 
+// Reads entries of a tensor's data buffer. Strings are returned as references
+// into the buffer, so that nothing is copied.
+template <typename T>
+struct TensorDataReader {
+  using Ref = T;
+  static Ref Get(const char* data, int index) {
+    return reinterpret_cast<const T*>(data)[index];
+  }
+};
+
+template <>
+struct TensorDataReader<std::string> {
+  using Ref = StringRef;
+  static Ref Get(const char* data, int index) {
+    const int32_t* offsets = reinterpret_cast<const int32_t*>(data) + 1;
+    return {data + offsets[index],
+            static_cast<int>(offsets[index + 1] - offsets[index])};
+  }
+};
+
 // A static hash table class. This hash table allows initialization one time in
 // its life cycle. This hash table implements Tensorflow core's HashTableV2 op.
+//
+// The table is a flat open addressing table in the style of Swiss tables: a
+// control byte holding 7 bits of the hash of every slot is probed a group of
+// slots at a time, and only candidates with a matching tag are compared. The
+// slots store entry indices into the imported keys and values, which are used
+// in place when they are read-only tensors of the model, so that importing
+// copies no data.
 template <typename KeyType, typename ValueType>
 class StaticHashtable : public tflite::resource::LookupInterface {
  public:
@@ -49,7 +79,7 @@ class StaticHashtable : public tflite::resource::LookupInterface {
                       const TfLiteTensor* values) override;
 
   // Returns the item size of the hash table.
-  size_t Size() override { return map_.size(); }
+  size_t Size() override { return size_; }
 
   TfLiteType GetKeyType() const override { return key_type_; }
   TfLiteType GetValueType() const override { return value_type_; }
@@ -69,7 +99,28 @@ class StaticHashtable : public tflite::resource::LookupInterface {
   TfLiteType key_type_;
   TfLiteType value_type_;
 
-  std::unordered_map<KeyType, ValueType> map_;
+  using KeyReader = TensorDataReader<KeyType>;
+  using ValueReader = TensorDataReader<ValueType>;
+
+  // Returns the index of the entry holding `key`, or -1 if there is none.
+  int32_t FindEntry(const typename KeyReader::Ref& key) const;
+
+  // Buffers of the imported keys and values, in the layout of their tensors.
+  // They point into the tensors when those are read-only, and into the owned
+  // copies otherwise.
+  const char* keys_data_ = nullptr;
+  const char* values_data_ = nullptr;
+  std::vector<char> owned_keys_;
+  std::vector<char> owned_values_;
+
+  // One control byte per slot, either kEmptySlot or 7 bits of the hash of the
+  // key in the slot, followed by the entry index of every slot.
+  std::vector<uint8_t> ctrl_;
+  std::vector<int32_t> slots_;
+  // Number of groups of slots minus one; the number of groups is a power of
+  // two.
+  size_t group_mask_ = 0;
+  size_t size_ = 0;
   bool is_initialized_ = false;
 };
 
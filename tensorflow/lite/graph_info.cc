@@ -15,6 +15,10 @@ limitations under the License.
 #include "tensorflow/lite/graph_info.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
@@ -238,6 +242,219 @@ class PartitionGraphIntoIndependentNodeSubsetsImpl {
 };
 // LINT.ThenChange(//tensorflow/lite/delegates/utils.h)
 
+// Helper class that searches for an order of the execution plan that lowers
+// the peak size of the live arena tensors.
+//
+// The set of scheduled nodes determines which tensors are live, so the search
+// is a dynamic program over these sets, extended by one ready node at a time
+// and keeping the lowest peak reaching each set. Wide graphs have too many
+// such sets, so each step only keeps the most promising ones, within a budget
+// of work that scales down with the size of the graph. With a single set per
+// step, the search is a greedy one.
+class ReorderNodesForMemoryImpl {
+ public:
+  explicit ReorderNodesForMemoryImpl(GraphInfo* info)
+      : info_(info),
+        num_nodes_(info->num_execution_nodes()),
+        dependencies_(num_nodes_),
+        produced_bytes_(num_nodes_, 0),
+        freeable_inputs_(num_nodes_),
+        consumers_(info->num_tensors()) {
+    const int num_tensors = info->num_tensors();
+    std::vector<int> producer(num_tensors, -1);
+    std::vector<bool> persistent(num_tensors, false);
+    for (int tensor : info->outputs()) {
+      if (tensor != kTfLiteOptionalTensor) persistent[tensor] = true;
+    }
+    std::vector<bool> variable(num_tensors, false);
+    for (int tensor : info->variables()) variable[tensor] = true;
+
+    int last_ordered_node = -1;
+    for (int i = 0; i < num_nodes_; ++i) {
+      const TfLiteNode& node = info->node(i);
+      bool ordered = node.might_have_side_effect;
+      for (int tensor : TfLiteIntArrayView(node.inputs)) {
+        if (tensor == kTfLiteOptionalTensor) continue;
+        ordered |= variable[tensor];
+        if (producer[tensor] >= 0) {
+          dependencies_[i].push_back(producer[tensor]);
+        }
+        if (consumers_[tensor].empty() || consumers_[tensor].back() != i) {
+          consumers_[tensor].push_back(i);
+        }
+      }
+      for (int tensor : TfLiteIntArrayView(node.outputs)) {
+        if (tensor == kTfLiteOptionalTensor) continue;
+        ordered |= variable[tensor];
+        producer[tensor] = i;
+        produced_bytes_[i] += ArenaBytes(tensor);
+      }
+      if (ordered) {
+        if (last_ordered_node >= 0) {
+          dependencies_[i].push_back(last_ordered_node);
+        }
+        last_ordered_node = i;
+      }
+    }
+    // Tensors produced by the graph are freed after their last consumer,
+    // unless they are graph outputs.
+    for (int tensor = 0; tensor < num_tensors; ++tensor) {
+      if (producer[tensor] < 0 || persistent[tensor] ||
+          consumers_[tensor].empty() || ArenaBytes(tensor) == 0) {
+        continue;
+      }
+      for (int consumer : consumers_[tensor]) {
+        freeable_inputs_[consumer].push_back(tensor);
+      }
+    }
+  }
+
+  // Returns the estimated peak of scheduling the nodes in `order`.
+  size_t Peak(const std::vector<int>& order) const {
+    std::vector<bool> scheduled(num_nodes_, false);
+    size_t live = 0;
+    size_t peak = 0;
+    for (int node : order) {
+      peak = std::max(peak, live + produced_bytes_[node]);
+      live += produced_bytes_[node];
+      live -= FreedBytes(scheduled, node);
+      scheduled[node] = true;
+    }
+    return peak;
+  }
+
+  // Returns the order with the lowest peak found.
+  std::vector<int> Search() const {
+    // Bounds the work of a step, which is linear in the number of kept sets
+    // and in the size of the graph.
+    constexpr int64_t kWorkBudget = 1 << 26;
+    constexpr int64_t kMaxStates = 256;
+    int64_t graph_size = num_nodes_;
+    for (const auto& dependencies : dependencies_) {
+      graph_size += dependencies.size();
+    }
+    const int64_t max_states = std::max<int64_t>(
+        1, std::min(kMaxStates,
+                    kWorkBudget / std::max<int64_t>(1, graph_size) /
+                        std::max(1, num_nodes_)));
+
+    std::vector<State> states(1);
+    states[0].scheduled.assign(num_nodes_, false);
+    // The node and the state it was scheduled from, for each state of each
+    // step.
+    std::vector<std::vector<std::pair<int, int>>> history;
+    for (int step = 0; step < num_nodes_; ++step) {
+      std::vector<State> next_states;
+      std::vector<std::pair<int, int>> next_history;
+      std::unordered_map<std::vector<bool>, int> index;
+      for (size_t s = 0; s < states.size(); ++s) {
+        const State& state = states[s];
+        for (int node = 0; node < num_nodes_; ++node) {
+          if (state.scheduled[node] || !IsReady(state.scheduled, node)) {
+            continue;
+          }
+          State next;
+          next.peak =
+              std::max(state.peak, state.live + produced_bytes_[node]);
+          next.live = state.live + produced_bytes_[node] -
+                      FreedBytes(state.scheduled, node);
+          next.scheduled = state.scheduled;
+          next.scheduled[node] = true;
+          auto it = index.find(next.scheduled);
+          if (it == index.end()) {
+            index.emplace(next.scheduled, next_states.size());
+            next_states.push_back(std::move(next));
+            next_history.emplace_back(node, s);
+          } else if (next.peak < next_states[it->second].peak) {
+            next_states[it->second].peak = next.peak;
+            next_history[it->second] = {node, s};
+          }
+        }
+      }
+      if (static_cast<int64_t>(next_states.size()) > max_states) {
+        std::vector<int> kept(next_states.size());
+        for (size_t i = 0; i < kept.size(); ++i) kept[i] = i;
+        std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) {
+          if (next_states[a].peak != next_states[b].peak) {
+            return next_states[a].peak < next_states[b].peak;
+          }
+          return next_states[a].live < next_states[b].live;
+        });
+        kept.resize(max_states);
+        std::vector<State> pruned_states;
+        std::vector<std::pair<int, int>> pruned_history;
+        for (int i : kept) {
+          pruned_states.push_back(std::move(next_states[i]));
+          pruned_history.push_back(next_history[i]);
+        }
+        next_states.swap(pruned_states);
+        next_history.swap(pruned_history);
+      }
+      states.swap(next_states);
+      history.push_back(std::move(next_history));
+    }
+
+    std::vector<int> order(num_nodes_);
+    if (num_nodes_ == 0) return order;
+    int best = 0;
+    for (size_t s = 1; s < states.size(); ++s) {
+      if (states[s].peak < states[best].peak) best = s;
+    }
+    for (int step = num_nodes_ - 1; step >= 0; --step) {
+      order[step] = history[step][best].first;
+      best = history[step][best].second;
+    }
+    return order;
+  }
+
+ private:
+  struct State {
+    std::vector<bool> scheduled;
+    size_t live = 0;
+    size_t peak = 0;
+  };
+
+  size_t ArenaBytes(int tensor) const {
+    const TfLiteTensor* t = info_->tensor(tensor);
+    return t->allocation_type == kTfLiteArenaRw ? t->bytes : 0;
+  }
+
+  bool IsReady(const std::vector<bool>& scheduled, int node) const {
+    for (int dependency : dependencies_[node]) {
+      if (!scheduled[dependency]) return false;
+    }
+    return true;
+  }
+
+  // Returns the bytes of the inputs of `node` that are no longer used once it
+  // runs after the nodes in `scheduled`.
+  size_t FreedBytes(const std::vector<bool>& scheduled, int node) const {
+    size_t bytes = 0;
+    for (int tensor : freeable_inputs_[node]) {
+      bool last_use = true;
+      for (int consumer : consumers_[tensor]) {
+        if (consumer != node && !scheduled[consumer]) {
+          last_use = false;
+          break;
+        }
+      }
+      if (last_use) bytes += ArenaBytes(tensor);
+    }
+    return bytes;
+  }
+
+  GraphInfo* info_;
+  int num_nodes_;
+  // Nodes that must run before each node.
+  std::vector<std::vector<int>> dependencies_;
+  // Bytes of the arena outputs of each node.
+  std::vector<size_t> produced_bytes_;
+  // Inputs of each node that are freed after their last consumer.
+  std::vector<std::vector<int>> freeable_inputs_;
+  // Nodes consuming each tensor.
+  std::vector<std::vector<int>> consumers_;
+};
+
 }  // namespace
 
 TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
@@ -249,4 +466,66 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
   return kTfLiteOk;
 }
 
+void ReorderNodesForMemory(GraphInfo* info, std::vector<int>* order,
+                           size_t* peak_bytes, size_t* reordered_peak_bytes) {
+  ReorderNodesForMemoryImpl reorderer(info);
+  std::vector<int> current_order(info->num_execution_nodes());
+  for (size_t i = 0; i < current_order.size(); ++i) current_order[i] = i;
+  const size_t peak = reorderer.Peak(current_order);
+  std::vector<int> reordered = reorderer.Search();
+  size_t reordered_peak = reorderer.Peak(reordered);
+  if (reordered_peak >= peak) {
+    reordered = std::move(current_order);
+    reordered_peak = peak;
+  }
+  *order = std::move(reordered);
+  if (peak_bytes != nullptr) *peak_bytes = peak;
+  if (reordered_peak_bytes != nullptr) *reordered_peak_bytes = reordered_peak;
+}
+
+void PartitionIntoConcurrentLevels(GraphInfo* info, std::vector<int>* order,
+                                   std::vector<int>* levels) {
+  const int num_nodes = info->num_execution_nodes();
+  const int num_tensors = info->num_tensors();
+  std::vector<int> producer(num_tensors, -1);
+  std::vector<bool> variable(num_tensors, false);
+  for (int tensor : info->variables()) variable[tensor] = true;
+
+  std::vector<int> node_levels(num_nodes, 0);
+  int last_ordered_node = -1;
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = info->node(i);
+    bool ordered = node.might_have_side_effect;
+    int level = 0;
+    for (int tensor : TfLiteIntArrayView(node.inputs)) {
+      if (tensor == kTfLiteOptionalTensor) continue;
+      ordered |= variable[tensor];
+      if (producer[tensor] >= 0) {
+        level = std::max(level, node_levels[producer[tensor]] + 1);
+      }
+    }
+    for (int tensor : TfLiteIntArrayView(node.outputs)) {
+      if (tensor == kTfLiteOptionalTensor) continue;
+      ordered |= variable[tensor];
+      producer[tensor] = i;
+    }
+    if (ordered) {
+      if (last_ordered_node >= 0) {
+        level = std::max(level, node_levels[last_ordered_node] + 1);
+      }
+      last_ordered_node = i;
+    }
+    node_levels[i] = level;
+  }
+
+  order->resize(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) (*order)[i] = i;
+  std::stable_sort(order->begin(), order->end(), [&](int a, int b) {
+    return node_levels[a] < node_levels[b];
+  });
+  levels->clear();
+  levels->reserve(num_nodes);
+  for (int node : *order) levels->push_back(node_levels[node]);
+}
+
 }  // namespace tflite
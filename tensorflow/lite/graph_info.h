@@ -90,6 +90,29 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
     const GraphInfo* info, const TfLiteIntArray* nodes_to_partition,
     std::vector<NodeSubset>* node_subsets);
 
+// Finds an order of the nodes in the execution plan of `info` that lowers the
+// peak size of the arena tensors alive at the same time, where a tensor lives
+// from the node producing it to the last node consuming it. Nodes are only
+// moved after the nodes they depend on, and nodes that might have side effects
+// or use variable tensors keep their relative order. `order` receives the
+// positions in the execution plan of the nodes in their new order, which is
+// the current order if no better one is found. `peak_bytes` and
+// `reordered_peak_bytes`, if not null, receive the estimated peak of the
+// current and the new order.
+void ReorderNodesForMemory(GraphInfo* info, std::vector<int>* order,
+                           size_t* peak_bytes, size_t* reordered_peak_bytes);
+
+// Groups the nodes in the execution plan of `info` into levels, such that the
+// nodes of a level don't depend on each other and can run at the same time,
+// once the nodes of the previous levels are done. A node is placed in the
+// level after the last of the nodes it depends on, and nodes that might have
+// side effects or use variable tensors are placed in increasing levels in
+// their relative order. `order` receives the positions in the execution plan
+// of the nodes sorted by level, in execution plan order within a level, and
+// `levels` the level of each node of `order`.
+void PartitionIntoConcurrentLevels(GraphInfo* info, std::vector<int>* order,
+                                   std::vector<int>* levels);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_GRAPH_INFO_H_
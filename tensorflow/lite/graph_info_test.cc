@@ -387,5 +387,146 @@ TEST(PartitionTest, Nodes4PartitionNodes3_WithControlDependency) {
       {expected_subgraph0, expected_subgraph1, expected_subgraph2});
 }
 
+// Places `bytes` bytes of tensor `index` of `graph` in the arena.
+void SetArenaTensor(SimpleTestGraph* graph, int index, size_t bytes) {
+  graph->tensor(index)->allocation_type = kTfLiteArenaRw;
+  graph->tensor(index)->bytes = bytes;
+}
+
+// Builds a graph with two branches, each with a large intermediate tensor
+// reduced to a small one, which are then joined:
+//
+//   0 -> [0] -> 1 (large) -> [2] -> 2 -> [4] -> 5
+//   0 -> [1] -> 3 (large) -> [3] -> 4 -> [4]
+//
+// Running the branches one after the other only keeps one large tensor alive.
+void BuildTwoBranchGraph(SimpleTestGraph* graph,
+                         bool branches_have_side_effects = false) {
+  graph->AddTensors(6);
+  graph->AddNode({0}, {1}, branches_have_side_effects);
+  graph->AddNode({0}, {3}, branches_have_side_effects);
+  graph->AddNode({1}, {2}, branches_have_side_effects);
+  graph->AddNode({3}, {4}, branches_have_side_effects);
+  graph->AddNode({2, 4}, {5});
+  graph->SetInputsAndOutputs({0}, {5});
+  SetArenaTensor(graph, 0, 1);
+  SetArenaTensor(graph, 1, 100);
+  SetArenaTensor(graph, 2, 1);
+  SetArenaTensor(graph, 3, 100);
+  SetArenaTensor(graph, 4, 1);
+  SetArenaTensor(graph, 5, 1);
+}
+
+TEST(ReorderNodesForMemoryTest, EmptyGraph) {
+  SimpleTestGraph graph;
+  std::vector<int> order = {1};
+  size_t peak = 1, reordered_peak = 1;
+  ReorderNodesForMemory(&graph, &order, &peak, &reordered_peak);
+  EXPECT_TRUE(order.empty());
+  EXPECT_EQ(peak, 0);
+  EXPECT_EQ(reordered_peak, 0);
+}
+
+TEST(ReorderNodesForMemoryTest, RunsBranchesOneAfterTheOther) {
+  SimpleTestGraph graph;
+  BuildTwoBranchGraph(&graph);
+  std::vector<int> order;
+  size_t peak = 0, reordered_peak = 0;
+  ReorderNodesForMemory(&graph, &order, &peak, &reordered_peak);
+  EXPECT_EQ(order, std::vector<int>({0, 2, 1, 3, 4}));
+  // Both large tensors and the output of node 2 are alive while it runs.
+  EXPECT_EQ(peak, 201);
+  // A large tensor and the outputs of nodes 2 and 3 while node 3 runs.
+  EXPECT_EQ(reordered_peak, 102);
+}
+
+TEST(ReorderNodesForMemoryTest, KeepsOrderOfNodesWithSideEffects) {
+  SimpleTestGraph graph;
+  BuildTwoBranchGraph(&graph, /*branches_have_side_effects=*/true);
+  std::vector<int> order;
+  size_t peak = 0, reordered_peak = 0;
+  ReorderNodesForMemory(&graph, &order, &peak, &reordered_peak);
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(peak, 201);
+  EXPECT_EQ(reordered_peak, 201);
+}
+
+TEST(ReorderNodesForMemoryTest, KeepsOrderWithoutImprovement) {
+  SimpleTestGraph graph;
+  graph.AddTensors(4);
+  graph.AddNode({0}, {1});
+  graph.AddNode({0}, {2});
+  graph.AddNode({1, 2}, {3});
+  graph.SetInputsAndOutputs({0}, {3});
+  for (int i = 0; i < 4; ++i) SetArenaTensor(&graph, i, 10);
+  std::vector<int> order;
+  size_t peak = 0, reordered_peak = 0;
+  ReorderNodesForMemory(&graph, &order, &peak, &reordered_peak);
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(peak, 30);
+  EXPECT_EQ(reordered_peak, 30);
+}
+
+TEST(ReorderNodesForMemoryTest, IgnoresNodesOutsideExecutionPlan) {
+  SimpleTestGraph graph(/*node_index_offset=*/1);
+  BuildTwoBranchGraph(&graph);
+  std::vector<int> order;
+  ReorderNodesForMemory(&graph, &order, nullptr, nullptr);
+  EXPECT_EQ(order, std::vector<int>({0, 2, 1, 3, 4}));
+}
+
+TEST(PartitionIntoConcurrentLevelsTest, EmptyGraph) {
+  SimpleTestGraph graph;
+  std::vector<int> order = {1};
+  std::vector<int> levels = {1};
+  PartitionIntoConcurrentLevels(&graph, &order, &levels);
+  EXPECT_TRUE(order.empty());
+  EXPECT_TRUE(levels.empty());
+}
+
+TEST(PartitionIntoConcurrentLevelsTest, RunsBranchesAtTheSameTime) {
+  SimpleTestGraph graph;
+  BuildTwoBranchGraph(&graph);
+  std::vector<int> order;
+  std::vector<int> levels;
+  PartitionIntoConcurrentLevels(&graph, &order, &levels);
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(levels, std::vector<int>({0, 0, 1, 1, 2}));
+}
+
+TEST(PartitionIntoConcurrentLevelsTest, MovesIndependentNodesUp) {
+  SimpleTestGraph graph;
+  graph.AddTensors(5);
+  graph.AddNode({0}, {1});
+  graph.AddNode({1}, {2});
+  graph.AddNode({0}, {3});
+  graph.AddNode({2, 3}, {4});
+  graph.SetInputsAndOutputs({0}, {4});
+  std::vector<int> order;
+  std::vector<int> levels;
+  PartitionIntoConcurrentLevels(&graph, &order, &levels);
+  EXPECT_EQ(order, std::vector<int>({0, 2, 1, 3}));
+  EXPECT_EQ(levels, std::vector<int>({0, 0, 1, 2}));
+}
+
+TEST(PartitionIntoConcurrentLevelsTest, SerializesNodesWithSideEffects) {
+  SimpleTestGraph graph;
+  BuildTwoBranchGraph(&graph, /*branches_have_side_effects=*/true);
+  std::vector<int> order;
+  std::vector<int> levels;
+  PartitionIntoConcurrentLevels(&graph, &order, &levels);
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(levels, std::vector<int>({0, 1, 2, 3, 4}));
+}
+
+TEST(PartitionIntoConcurrentLevelsTest, IgnoresNodesOutsideExecutionPlan) {
+  SimpleTestGraph graph(/*node_index_offset=*/1);
+  BuildTwoBranchGraph(&graph);
+  std::vector<int> order;
+  std::vector<int> levels;
+  PartitionIntoConcurrentLevels(&graph, &order, &levels);
+  EXPECT_EQ(levels, std::vector<int>({0, 0, 1, 1, 2}));
+}
+
 }  // namespace
 }  // namespace tflite
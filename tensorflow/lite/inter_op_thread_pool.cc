@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads)
+    : num_threads_(num_threads < 1 ? 1 : num_threads),
+      thread_ids_(num_threads_) {
+  for (int i = 0; i < num_threads_; ++i) {
+    cpu_backend_contexts_.emplace_back(new ExternalCpuBackendContext());
+  }
+  // The ids of the workers are set before any of them can run a task.
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 1; i < num_threads_; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+    thread_ids_[i] = workers_.back().get_id();
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void InterOpThreadPool::Run(int num_tasks,
+                            const std::function<void(int)>& task) {
+  if (num_tasks <= 0) return;
+  const int num_busy_workers = std::min(num_tasks, num_threads_) - 1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_ids_[0] = std::this_thread::get_id();
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    num_busy_workers_ = num_busy_workers;
+    ++generation_;
+  }
+  if (num_busy_workers > 0) work_available_.notify_all();
+  RunShare(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] { return num_busy_workers_ == 0; });
+  thread_ids_[0] = std::thread::id();
+  task_ = nullptr;
+}
+
+TfLiteExternalContext* InterOpThreadPool::CpuBackendContextOfCurrentThread() {
+  const std::thread::id id = std::this_thread::get_id();
+  for (int i = 0; i < num_threads_; ++i) {
+    if (thread_ids_[i] == id) return cpu_backend_contexts_[i].get();
+  }
+  return nullptr;
+}
+
+void InterOpThreadPool::WorkerLoop(int thread) {
+  int64_t last_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock, [this, last_generation] {
+        return stopping_ || generation_ != last_generation;
+      });
+      if (stopping_) return;
+      last_generation = generation_;
+      // Threads without a task in this group skip it.
+      if (thread >= num_tasks_) continue;
+    }
+    RunShare(thread);
+    bool last_done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      last_done = --num_busy_workers_ == 0;
+    }
+    if (last_done) work_done_.notify_one();
+  }
+}
+
+void InterOpThreadPool::RunShare(int thread) {
+  for (int i = thread; i < num_tasks_; i += num_threads_) (*task_)(i);
+}
+
+}  // namespace tflite
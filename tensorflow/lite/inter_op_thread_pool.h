@@ -0,0 +1,86 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+
+namespace tflite {
+
+// A pool of threads that runs groups of independent tasks, such as the nodes
+// of a level of an execution plan, with the calling thread running its share
+// of each group.
+//
+// Each thread of the pool, the calling one included, has a CPU backend context
+// of its own, since the ruy and gemmlowp contexts of a CpuBackendContext
+// can't be used by several kernels at the same time.
+class InterOpThreadPool {
+ public:
+  // Creates a pool running groups on `num_threads` threads, the calling thread
+  // included.
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return num_threads_; }
+
+  // Runs `task(i)` for each i in [0, num_tasks), and returns once they are all
+  // done. Task i runs on thread i % num_threads(), which keeps the tasks of a
+  // group on the same threads from one run to the next. Thread 0 is the
+  // calling thread.
+  void Run(int num_tasks, const std::function<void(int)>& task);
+
+  // Returns the CPU backend context of the calling thread while it runs a
+  // task, or nullptr otherwise.
+  TfLiteExternalContext* CpuBackendContextOfCurrentThread();
+
+ private:
+  void WorkerLoop(int thread);
+  void RunShare(int thread);
+
+  const int num_threads_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      cpu_backend_contexts_;
+  // The threads running the tasks of the current group, indexed like
+  // `cpu_backend_contexts_`. The calling thread is only set during Run.
+  std::vector<std::thread::id> thread_ids_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  // Incremented for each group, so that the workers can tell a new group
+  // from the one they just ran.
+  int64_t generation_ = 0;
+  const std::function<void(int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  int num_busy_workers_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
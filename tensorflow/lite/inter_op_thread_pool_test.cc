@@ -0,0 +1,73 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace {
+
+TEST(InterOpThreadPoolTest, RunsEachTaskOnce) {
+  InterOpThreadPool pool(3);
+  EXPECT_EQ(pool.num_threads(), 3);
+  for (int num_tasks : {0, 1, 2, 3, 7}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    pool.Run(num_tasks, [&runs](int i) { ++runs[i]; });
+    for (int i = 0; i < num_tasks; ++i) {
+      EXPECT_EQ(runs[i], 1) << num_tasks << " tasks, task " << i;
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, RunsTasksOnTheirThreads) {
+  InterOpThreadPool pool(2);
+  std::vector<std::thread::id> ids(4);
+  pool.Run(4, [&ids](int i) { ids[i] = std::this_thread::get_id(); });
+  EXPECT_EQ(ids[0], std::this_thread::get_id());
+  EXPECT_EQ(ids[2], std::this_thread::get_id());
+  EXPECT_NE(ids[1], std::this_thread::get_id());
+  EXPECT_EQ(ids[1], ids[3]);
+}
+
+TEST(InterOpThreadPoolTest, GivesEachThreadItsOwnCpuBackendContext) {
+  InterOpThreadPool pool(3);
+  EXPECT_EQ(pool.CpuBackendContextOfCurrentThread(), nullptr);
+  std::vector<TfLiteExternalContext*> contexts(3);
+  pool.Run(3, [&pool, &contexts](int i) {
+    contexts[i] = pool.CpuBackendContextOfCurrentThread();
+  });
+  std::set<TfLiteExternalContext*> distinct(contexts.begin(), contexts.end());
+  EXPECT_EQ(distinct.size(), 3);
+  EXPECT_EQ(distinct.count(nullptr), 0);
+  EXPECT_EQ(pool.CpuBackendContextOfCurrentThread(), nullptr);
+}
+
+TEST(InterOpThreadPoolTest, SingleThreadRunsOnTheCallingThread) {
+  InterOpThreadPool pool(0);
+  EXPECT_EQ(pool.num_threads(), 1);
+  std::vector<std::thread::id> ids(2);
+  pool.Run(2, [&ids](int i) { ids[i] = std::this_thread::get_id(); });
+  EXPECT_EQ(ids[0], std::this_thread::get_id());
+  EXPECT_EQ(ids[1], std::this_thread::get_id());
+}
+
+}  // namespace
+}  // namespace tflite
@@ -781,6 +781,15 @@ class Interpreter {
   // InterpreterBuilder before allocating any tensors.
   TfLiteStatus PreserveAllTensorsExperimental();
 
+  // Enables reordering the execution plans to lower the peak arena size.
+  // Should only be set by InterpreterBuilder before allocating any tensors.
+  TfLiteStatus EnableMemoryAwareReorderingExperimental();
+
+  // Enables running the independent nodes of the primary subgraph at the same
+  // time on `num_threads` threads. Should only be set by InterpreterBuilder
+  // before allocating any tensors.
+  TfLiteStatus SetNumInterOpThreadsExperimental(int num_threads);
+
   // Sets model metadata as a mapping of name (key) and buffer (value) strings.
   // Used by InterpreterBuilder, should be called after setting up subgraphs.
   TfLiteStatus SetMetadata(const std::map<std::string, std::string>& metadata);
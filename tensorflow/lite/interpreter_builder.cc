@@ -758,6 +758,14 @@ TfLiteStatus InterpreterBuilder::operator()(
     (*interpreter)->PreserveAllTensorsExperimental();
   }
 
+  if (memory_aware_reordering_) {
+    (*interpreter)->EnableMemoryAwareReorderingExperimental();
+  }
+
+  if (num_inter_op_threads_ > 1) {
+    (*interpreter)->SetNumInterOpThreadsExperimental(num_inter_op_threads_);
+  }
+
   (*interpreter)->SetProfiler(tflite::profiling::MaybeCreatePlatformProfiler());
 
   for (int subgraph_index = 0; subgraph_index < subgraphs->size();
@@ -92,6 +92,24 @@ class InterpreterBuilder {
   /// intermediates are undefined due to memory planning and reuse.
   InterpreterBuilder& PreserveAllTensorsExperimental();
 
+  /// Enables reordering the execution plan of each subgraph, within the
+  /// dependencies of its nodes, to lower the peak size of the tensor arena.
+  /// The estimated peak before and after reordering is logged by the memory
+  /// planner debug dump, e.g. from PrintInterpreterState.
+  InterpreterBuilder& EnableMemoryAwareReorderingExperimental();
+
+  /// Runs the independent nodes of the main subgraph, such as the branches of
+  /// a multi-head model, at the same time on `num_threads` threads, the
+  /// invoking thread included. A node runs once all the nodes it depends on
+  /// are done, so the nodes are grouped in levels, and the nodes of a level
+  /// run at the same time, while the memory planner keeps their tensors
+  /// apart. Kernels running at the same time are single threaded, while a
+  /// level with a single node keeps the threads set by SetNumThreads.
+  /// Delegate, custom and control flow nodes, and nodes with side effects,
+  /// are still run one at a time. So are all the nodes of graphs with dynamic
+  /// tensors, and while a profiler is installed.
+  InterpreterBuilder& SetNumInterOpThreadsExperimental(int num_threads);
+
   /// Any delegates added with AddDelegate will be applied to the Interpreter
   /// generated by operator(), in the order that they were added.  (The delegate
   /// parameter passed to AddDelegate should be non-null, otherwise an error
@@ -138,6 +156,8 @@ class InterpreterBuilder {
   bool has_flex_op_ = false;
   int num_fp32_tensors_ = 0;
   bool preserve_all_tensors_ = false;
+  bool memory_aware_reordering_ = false;
+  int num_inter_op_threads_ = 1;
   int num_threads_ = -1;
 };
 
@@ -22,4 +22,18 @@ InterpreterBuilder& InterpreterBuilder::PreserveAllTensorsExperimental() {
   return *this;
 }
 
+// Enables reordering the execution plans to lower the peak arena size.
+InterpreterBuilder&
+InterpreterBuilder::EnableMemoryAwareReorderingExperimental() {
+  memory_aware_reordering_ = true;
+  return *this;
+}
+
+// Enables running the independent nodes of the main subgraph at the same time.
+InterpreterBuilder& InterpreterBuilder::SetNumInterOpThreadsExperimental(
+    int num_threads) {
+  num_inter_op_threads_ = num_threads;
+  return *this;
+}
+
 }  // namespace tflite
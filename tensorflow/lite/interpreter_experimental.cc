@@ -170,4 +170,17 @@ TfLiteStatus Interpreter::PreserveAllTensorsExperimental() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetNumInterOpThreadsExperimental(int num_threads) {
+  return primary_subgraph().SetNumInterOpThreadsExperimental(num_threads);
+}
+
+TfLiteStatus Interpreter::EnableMemoryAwareReorderingExperimental() {
+  for (int subgraph_index = 0; subgraph_index < subgraphs_.size();
+       ++subgraph_index) {
+    TF_LITE_ENSURE_STATUS(
+        subgraphs_[subgraph_index]->EnableMemoryAwareReorderingExperimental());
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
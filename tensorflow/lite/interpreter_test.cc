@@ -2097,5 +2097,74 @@ TEST_F(InterpreterTest, SingleSignature_validate_get_tensor) {
             nullptr);
 }
 
+// Two branches of ADDs off the same input, joined by a last ADD:
+//   t1 = x + x, t2 = t1 + t1, t3 = x + x, t4 = t3 + x, y = t2 + t4 = 7x.
+class InterOpParallelismTest : public InterpreterTest {
+ protected:
+  static constexpr int kSize = 1024;
+
+  void SetUp() override {
+    ASSERT_EQ(interpreter_.AddTensors(6), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetInputs({0}), kTfLiteOk);
+    ASSERT_EQ(interpreter_.SetOutputs({5}), kTfLiteOk);
+    TfLiteQuantizationParams quant;
+    for (int i = 0; i < 6; ++i) {
+      ASSERT_EQ(interpreter_.SetTensorParametersReadWrite(
+                    i, kTfLiteFloat32, "", {kSize}, quant),
+                kTfLiteOk);
+    }
+    AddNode({0, 0}, 1);
+    AddNode({1, 1}, 2);
+    AddNode({0, 0}, 3);
+    AddNode({3, 0}, 4);
+    AddNode({2, 4}, 5);
+  }
+
+  void AddNode(const std::vector<int>& inputs, int output) {
+    auto* params =
+        reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+    params->activation = kTfLiteActNone;
+    ASSERT_EQ(interpreter_.AddNodeWithParameters(inputs, {output}, nullptr, 0,
+                                                 params,
+                                                 ops::builtin::Register_ADD()),
+              kTfLiteOk);
+  }
+
+  void VerifyInvoke() {
+    float* input = interpreter_.typed_tensor<float>(0);
+    for (int i = 0; i < kSize; ++i) input[i] = i;
+    ASSERT_EQ(interpreter_.Invoke(), kTfLiteOk);
+    const float* output = interpreter_.typed_tensor<float>(5);
+    for (int i = 0; i < kSize; ++i) {
+      ASSERT_EQ(output[i], 7.0f * i) << i;
+    }
+  }
+};
+
+TEST_F(InterOpParallelismTest, RunsBranchesAtTheSameTime) {
+  ASSERT_EQ(SetNumInterOpThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  // The nodes are ordered by level, the first nodes of both branches first.
+  EXPECT_THAT(interpreter_.execution_plan(),
+              testing::ElementsAre(0, 2, 1, 3, 4));
+  VerifyInvoke();
+  // Repeated invocations reuse the same plan and threads.
+  VerifyInvoke();
+}
+
+TEST_F(InterOpParallelismTest, SingleThreadKeepsTheExecutionPlan) {
+  ASSERT_EQ(SetNumInterOpThreads(1), kTfLiteOk);
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  EXPECT_THAT(interpreter_.execution_plan(),
+              testing::ElementsAre(0, 1, 2, 3, 4));
+  VerifyInvoke();
+}
+
+TEST_F(InterOpParallelismTest, FailsAfterAllocation) {
+  ASSERT_EQ(interpreter_.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(SetNumInterOpThreads(2), kTfLiteError);
+  VerifyInvoke();
+}
+
 }  // namespace
 }  // namespace tflite
@@ -70,6 +70,10 @@ class InterpreterTest : public ::testing::Test {
     return interpreter_.SetExecutionPlan(new_plan);
   }
 
+  TfLiteStatus SetNumInterOpThreads(int num_threads) {
+    return interpreter_.SetNumInterOpThreadsExperimental(num_threads);
+  }
+
   Interpreter interpreter_;
 };
 
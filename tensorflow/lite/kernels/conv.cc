@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
@@ -117,6 +118,11 @@ struct OpData {
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
+
+  // Set for 1x1 convolutions with a block sparse filter, which are evaluated
+  // as sparse fully connected layers over the pixels of the input.
+  bool use_sparse_kernel = false;
+  optimized_ops::BlockSparseWeights sparse_filter;
 };
 
 inline PaddingType RuntimePaddingType(TfLitePadding padding) {
@@ -403,11 +409,41 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     }
   }
 
+  data->use_sparse_kernel = filter->sparsity != nullptr;
+  if (data->use_sparse_kernel) {
+    TF_LITE_ENSURE_MSG(context,
+                       (input_type == kTfLiteFloat32 &&
+                        filter->type == kTfLiteFloat32) ||
+                           (input_type == kTfLiteInt8 &&
+                            filter->type == kTfLiteInt8),
+                       "Sparse filters are only supported for float and int8 "
+                       "convolutions.");
+    TF_LITE_ENSURE_MSG(
+        context,
+        SizeOfDimension(filter, 1) == 1 && SizeOfDimension(filter, 2) == 1 &&
+            params->stride_height == 1 && params->stride_width == 1 &&
+            params->dilation_height_factor == 1 &&
+            params->dilation_width_factor == 1,
+        "Sparse filters are only supported for 1x1 convolutions with unit "
+        "strides and dilations.");
+    TF_LITE_ENSURE_MSG(
+        context,
+        optimized_ops::GetBlockSparseWeights(
+            *filter->sparsity, GetTensorShape(filter), &data->sparse_filter),
+        "Unsupported sparse convolution filter format.");
+    // The sparse int8 kernel skips zero weights, so they must be quantized
+    // symmetrically.
+    if (input_type == kTfLiteInt8) {
+      TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+    }
+  }
+
   // The multi-threaded kernel supports neither dilation nor hybrid kernels, and
   // is incompatible with mutable input filters that might change between evals.
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->use_sparse_kernel &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) && !IsDynamicTensor(filter);
@@ -1057,6 +1093,51 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+// Evaluates a 1x1 convolution with a block sparse filter as a fully connected
+// layer, treating every pixel of the input as a batch.
+TfLiteStatus EvalSparse(TfLiteContext* context, TfLiteConvParams* params,
+                        OpData* data, const TfLiteTensor* input,
+                        const TfLiteTensor* filter, const TfLiteTensor* bias,
+                        TfLiteTensor* output) {
+  const RuntimeShape weights_shape(
+      {SizeOfDimension(filter, 0), SizeOfDimension(filter, 3)});
+  FullyConnectedParams op_params;
+  switch (input->type) {
+    case kTfLiteFloat32:
+      CalculateActivationRange(params->activation,
+                               &op_params.float_activation_min,
+                               &op_params.float_activation_max);
+      optimized_ops::FullyConnectedSparseWeightBlock(
+          data->sparse_filter, op_params, GetTensorShape(input),
+          GetTensorData<float>(input), weights_shape,
+          GetTensorData<float>(filter), GetTensorShape(bias),
+          GetTensorData<float>(bias), GetTensorShape(output),
+          GetTensorData<float>(output),
+          CpuBackendContext::GetFromContext(context));
+      break;
+    case kTfLiteInt8:
+      op_params.input_offset = -input->params.zero_point;
+      op_params.output_offset = output->params.zero_point;
+      op_params.quantized_activation_min = data->output_activation_min;
+      op_params.quantized_activation_max = data->output_activation_max;
+      optimized_ops::FullyConnectedSparseWeightBlock(
+          data->sparse_filter, op_params,
+          data->per_channel_output_multiplier.data(),
+          data->per_channel_output_shift.data(), /*per_channel=*/true,
+          GetTensorShape(input), GetTensorData<int8_t>(input), weights_shape,
+          GetTensorData<int8_t>(filter), GetTensorShape(bias),
+          GetTensorData<int32_t>(bias), GetTensorShape(output),
+          GetTensorData<int8_t>(output),
+          CpuBackendContext::GetFromContext(context));
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s not supported by sparse conv.",
+                         TfLiteTypeGetName(input->type));
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type, TfLiteType input_type>
 TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -1085,6 +1166,9 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   }
 
   TFLITE_DCHECK_EQ(input_type, input->type);
+  if (data->use_sparse_kernel) {
+    return EvalSparse(context, params, data, input, filter, bias, output);
+  }
   switch (input_type) {  // Already know in/outtypes are same.
     case kTfLiteFloat32:
       if (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8) {
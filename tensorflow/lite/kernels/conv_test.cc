@@ -19,6 +19,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -1804,6 +1805,128 @@ TEST_P(ConvolutionOpTest, SimpleTestHybridWithDilationPerChannel) {
                                  0.16)));
 }
 
+template <typename T>
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input, const TensorData& filter,
+                           const std::vector<T>& filter_data,
+                           const TensorData& output) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    if (input.type == TensorType_FLOAT32) {
+      bias_ = AddInput({TensorType_FLOAT32, {filter.shape[0]}});
+    } else {
+      bias_ = AddInput({TensorType_INT32, {filter.shape[0]}, 0, 0,
+                        GetScale(input_) * GetScale(filter_)});
+    }
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+        CreateConv2DOptions(builder_, Padding_VALID, /*stride_w=*/1,
+                            /*stride_h=*/1, ActivationFunctionType_RELU)
+            .Union());
+
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)},
+                     /*num_threads=*/-1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+
+  void SetInput(const std::vector<float>& data) {
+    if (std::is_same<T, float>::value) {
+      PopulateTensor(input_, data);
+    } else {
+      QuantizeAndPopulate<int8_t>(input_, data);
+    }
+  }
+  void SetBias(const std::vector<float>& data) {
+    if (std::is_same<T, float>::value) {
+      PopulateTensor(bias_, data);
+    } else {
+      QuantizeAndPopulate<int32_t>(bias_, data);
+    }
+  }
+  std::vector<float> GetOutput() {
+    if (std::is_same<T, float>::value) {
+      return ExtractVector<float>(output_);
+    }
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+
+ protected:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+// A 1x1 filter with 4x4 blocks, of which two out of four are zero.
+template <typename T>
+std::vector<T> SparsePointwiseFilter() {
+  return {
+      1,  2,  3,  4,  0,  0,  0,  0,   // output channel 0
+      -1, -2, -3, -4, 0,  0,  0,  0,   // output channel 1
+      1,  0,  -1, 0,  0,  0,  0,  0,   // output channel 2
+      2,  2,  2,  2,  0,  0,  0,  0,   // output channel 3
+      0,  0,  0,  0,  1,  1,  1,  1,   // output channel 4
+      0,  0,  0,  0,  -1, 1,  -1, 1,   // output channel 5
+      0,  0,  0,  0,  0,  0,  0,  3,   // output channel 6
+      0,  0,  0,  0,  -2, -2, -2, -2,  // output channel 7
+  };
+}
+
+TensorData SparsePointwiseFilterData(TensorType type) {
+  TensorData filter = {};
+  filter.type = type;
+  filter.shape = {8, 1, 1, 8};
+  filter.traversal_order = {0, 1, 2, 3, 4, 5};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {0, 3};
+  filter.block_size = {4, 4};
+  return filter;
+}
+
+TEST_P(ConvolutionOpTest, SparsePointwiseFloat32) {
+  SparseConvolutionOpModel<float> m(
+      GetRegistration(), {TensorType_FLOAT32, {1, 1, 2, 8}},
+      SparsePointwiseFilterData(TensorType_FLOAT32),
+      SparsePointwiseFilter<float>(), {TensorType_FLOAT32, {}});
+  m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,      // left pixel
+      1, -1, 1, -1, 2, -2, 2, -2,  // right pixel
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({31, 0, 1, 24, 31, 8, 31, 0,  //
+                                               0, 4, 3, 4, 5, 0, 1, 8}));
+}
+
+TEST_P(ConvolutionOpTest, SparsePointwiseInt8) {
+  TensorData filter = SparsePointwiseFilterData(TensorType_INT8);
+  filter.scale = 1.0;
+  SparseConvolutionOpModel<int8_t> m(
+      GetRegistration(), {TensorType_INT8, {1, 1, 2, 8}, -64, 63.5}, filter,
+      SparsePointwiseFilter<int8_t>(), {TensorType_INT8, {}, -32, 31.75});
+  m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,      // left pixel
+      1, -1, 1, -1, 2, -2, 2, -2,  // right pixel
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({31, 0, 1, 24, 31, 8, 31, 0,  //
+                                               0, 4, 3, 4, 5, 0, 1, 8})));
+}
+
 const auto kQuantizedKernelMap = new std::map<string, TfLiteRegistration*>({
     {"GenericOptimized", ops::builtin::Register_CONV_2D_UINT8()},
 });
@@ -34,6 +34,7 @@ TfLiteRegistration* Register_RANDOM_STANDARD_NORMAL();
 TfLiteRegistration* Register_RANDOM_UNIFORM();
 TfLiteRegistration* Register_RANDOM_UNIFORM_INT();
 TfLiteRegistration* Register_ROLL();
+TfLiteRegistration* Register_SCALED_DOT_PRODUCT_ATTENTION();
 TfLiteRegistration* Register_SIGN();
 TfLiteRegistration* Register_TABLE();
 
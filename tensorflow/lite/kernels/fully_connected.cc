@@ -51,7 +51,6 @@ bool SupportedSparsityFormat(const TfLiteSparsity& sparsity) {
 }
 
 static const int kDimMetadataSizeRandomSparse = 2;
-static const int kDimMetadataSizeBlockSparse = 3;
 
 TfLiteStatus CreateLedgerTensor(const TfLiteSparsity* sparsity,
                                 TfLiteContext* context, TfLiteTensor* ledger) {
@@ -246,6 +245,12 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node) {
         &data->output_activation_max));
   }
 
+  // The sparse int8 kernels skip zero weights, so they must be quantized
+  // symmetrically.
+  if (input->type == kTfLiteInt8 && filter->sparsity != nullptr) {
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+  }
+
   if (input->type == kTfLiteInt16 && output->type == kTfLiteInt16) {
     TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
     TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
@@ -685,10 +690,47 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
 
 namespace {
 template <KernelType kernel_type>
-void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
-                        const TfLiteTensor* filter, const TfLiteTensor* bias,
-                        TfLiteTensor* output,
-                        CpuBackendContext* cpu_backend_context) {
+TfLiteStatus FullyConnectedSparseInt8(TfLiteContext* context,
+                                      const FullyConnectedParams& op_params,
+                                      const OpData* data,
+                                      const TfLiteTensor* input,
+                                      const TfLiteTensor* filter,
+                                      const TfLiteTensor* bias,
+                                      TfLiteTensor* output) {
+  const auto& sparsity = *filter->sparsity;
+  if (kernel_type == kReference) {
+    reference_ops::FullyConnectedSparseWeight(
+        sparsity, op_params, GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        GetTensorData<int8_t>(filter), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output));
+    return kTfLiteOk;
+  }
+  optimized_ops::BlockSparseWeights block_sparse_weights;
+  if (!optimized_ops::GetBlockSparseWeights(sparsity, GetTensorShape(filter),
+                                            &block_sparse_weights)) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Unsupported sparse fully-connected weight format.");
+    return kTfLiteError;
+  }
+  optimized_ops::FullyConnectedSparseWeightBlock(
+      block_sparse_weights, op_params, &data->output_multiplier,
+      &data->output_shift, /*per_channel=*/false, GetTensorShape(input),
+      GetTensorData<int8_t>(input), GetTensorShape(filter),
+      GetTensorData<int8_t>(filter), GetTensorShape(bias),
+      GetTensorData<int32_t>(bias), GetTensorShape(output),
+      GetTensorData<int8_t>(output),
+      CpuBackendContext::GetFromContext(context));
+  return kTfLiteOk;
+}
+
+template <KernelType kernel_type>
+TfLiteStatus FullyConnectedInt8(TfLiteContext* context, const OpData* data,
+                                const TfLiteTensor* input,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* bias,
+                                TfLiteTensor* output) {
   FullyConnectedParams op_params;
   op_params.input_offset = -input->params.zero_point;
   op_params.weights_offset = -filter->params.zero_point;
@@ -699,6 +741,10 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
   op_params.quantized_activation_max = data->output_activation_max;
   op_params.lhs_cacheable = IsConstantTensor(filter);
   op_params.rhs_cacheable = IsConstantTensor(input);
+  if (filter->sparsity != nullptr) {
+    return FullyConnectedSparseInt8<kernel_type>(context, op_params, data,
+                                                 input, filter, bias, output);
+  }
   if (kernel_type == kReference) {
     reference_integer_ops::FullyConnected(
         op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
@@ -711,8 +757,9 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
         GetTensorShape(filter), GetTensorData<int8_t>(filter),
         GetTensorShape(bias), GetTensorData<int32_t>(bias),
         GetTensorShape(output), GetTensorData<int8_t>(output),
-        cpu_backend_context);
+        CpuBackendContext::GetFromContext(context));
   }
+  return kTfLiteOk;
 }
 }  // namespace
 
@@ -793,9 +840,9 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         }
         break;
       case kTfLiteInt8:
-        FullyConnectedInt8<kernel_type>(
-            data, input, filter, bias, output,
-            CpuBackendContext::GetFromContext(context));
+        TF_LITE_ENSURE_OK(context,
+                          FullyConnectedInt8<kernel_type>(
+                              context, data, input, filter, bias, output));
         break;
       case kTfLiteInt16:
         if (input->type == kTfLiteInt16) {
@@ -914,7 +961,10 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
     op_params.float_activation_max = output_activation_max;
     if (filter->sparsity != nullptr) {
       const auto& sparsity = *filter->sparsity;
-      if (!SupportedSparsityFormat(sparsity)) {
+      optimized_ops::BlockSparseWeights block_sparse_weights;
+      if (!SupportedSparsityFormat(sparsity) ||
+          !optimized_ops::GetBlockSparseWeights(
+              sparsity, GetTensorShape(filter), &block_sparse_weights)) {
         TF_LITE_KERNEL_LOG(context,
                            "Unsupported sparse fully-connected weight format.");
         return kTfLiteError;
@@ -928,8 +978,8 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
             GetTensorData<float>(filter), GetTensorShape(bias),
             GetTensorData<float>(bias), GetTensorShape(output),
             GetTensorData<float>(output));
-      } else if (sparsity.dim_metadata_size == kDimMetadataSizeBlockSparse &&
-                 sparsity.dim_metadata[2].dense_size == 4) {
+      } else if (block_sparse_weights.block_rows == 1 &&
+                 block_sparse_weights.block_cols == 4) {
         // Block sparse with block size of 1x4.
         optimized_ops::FullyConnectedSparseWeight1x4(
             sparsity, op_params, GetTensorShape(input),
@@ -939,9 +989,14 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
             GetTensorData<float>(output),
             CpuBackendContext::GetFromContext(context));
       } else {
-        TF_LITE_KERNEL_LOG(context,
-                           "Unsupported sparse fully-connected weight format.");
-        return kTfLiteError;
+        // Other block sizes, e.g. 4x4 or 8x1.
+        optimized_ops::FullyConnectedSparseWeightBlock(
+            block_sparse_weights, op_params, GetTensorShape(input),
+            GetTensorData<float>(input), GetTensorShape(filter),
+            GetTensorData<float>(filter), GetTensorShape(bias),
+            GetTensorData<float>(bias), GetTensorShape(output),
+            GetTensorData<float>(output),
+            CpuBackendContext::GetFromContext(context));
       }
 
     } else {
@@ -1618,6 +1618,154 @@ TEST_P(SparseFullyConnectedOpTest, SparseHybrid1x16TestMultiThreaded) {
                     1e-3)));
   }
 }
+TEST_P(SparseFullyConnectedOpTest, Simple4x4Test) {
+  std::initializer_list<float> weight_data = {
+      1,  2,  3,  4,  0,  0,  0,  0,   // u = 0
+      -1, -2, -3, -4, 0,  0,  0,  0,   // u = 1
+      1,  0,  -1, 0,  0,  0,  0,  0,   // u = 2
+      2,  2,  2,  2,  0,  0,  0,  0,   // u = 3
+      0,  0,  0,  0,  1,  1,  1,  1,   // u = 4
+      0,  0,  0,  0,  -1, 1,  -1, 1,   // u = 5
+      0,  0,  0,  0,  0,  0,  0,  3,   // u = 6
+      0,  0,  0,  0,  -2, -2, -2, -2,  // u = 7
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {8, 8};
+  weight.traversal_order = {0, 1, 2, 3};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0, 1};
+  weight.block_size = {4, 4};
+  SparseFullyConnectedOpModel<float> m(GetRegistration(),
+                                       /*units=*/8, /*batches=*/2,
+                                       /*input=*/{TensorType_FLOAT32, {2, 8}},
+                                       weight, weight_data);
+  m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+
+  m.SetInput({
+      1, 2,  3, 4,  5, 6,  7, 8,   // b = 0
+      1, -1, 1, -1, 2, -2, 2, -2,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 8));
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAre(31, 0, 1, 24, 31, 8, 31, 0, 0, 4, 3, 4, 5, 0, 1, 8));
+}
+
+TEST_P(SparseFullyConnectedOpTest, Simple8x1Test) {
+  std::initializer_list<float> weight_data = {
+      1,  0, 2,   // u = 0
+      3,  0, -1,  // u = 1
+      2,  0, 2,   // u = 2
+      -1, 0, 1,   // u = 3
+      0,  0, 4,   // u = 4
+      1,  0, 1,   // u = 5
+      2,  0, -3,  // u = 6
+      1,  0, 1,   // u = 7
+  };
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {8, 3};
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0};
+  weight.block_size = {8};
+  SparseFullyConnectedOpModel<float> m(GetRegistration(),
+                                       /*units=*/8, /*batches=*/2,
+                                       /*input=*/{TensorType_FLOAT32, {2, 3}},
+                                       weight, weight_data);
+  m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+
+  m.SetInput({
+      1, 5, 2,   // b = 0
+      -1, 3, 1,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 8));
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAre(6, 3, 9, 5, 13, 9, 3, 11, 2, 0, 3, 6, 9, 6, 2, 8));
+}
+
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                       const TensorData& input,
+                                       const TensorData& weights,
+                                       const std::vector<int8_t>& weights_data,
+                                       const TensorData& output) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data);
+    bias_ = AddInput({TensorType_INT32, {weights.shape[0]}, 0, 0,
+                      GetScale(input_) * GetScale(weights_)});
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_RELU)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)});
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(SparseFullyConnectedOpTest, SimpleInt8_4x4Test) {
+  TensorData weight = {};
+  weight.type = TensorType_INT8;
+  weight.shape = {8, 8};
+  weight.scale = 1.0;
+  weight.traversal_order = {0, 1, 2, 3};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {0, 1};
+  weight.block_size = {4, 4};
+  SparseQuantizedFullyConnectedOpModel m(
+      GetRegistration(), /*input=*/{TensorType_INT8, {2, 8}, -64, 63.5},
+      weight,
+      {
+          1,  2,  3,  4,  0,  0,  0,  0,   // u = 0
+          -1, -2, -3, -4, 0,  0,  0,  0,   // u = 1
+          1,  0,  -1, 0,  0,  0,  0,  0,   // u = 2
+          2,  2,  2,  2,  0,  0,  0,  0,   // u = 3
+          0,  0,  0,  0,  1,  1,  1,  1,   // u = 4
+          0,  0,  0,  0,  -1, 1,  -1, 1,   // u = 5
+          0,  0,  0,  0,  0,  0,  0,  3,   // u = 6
+          0,  0,  0,  0,  -2, -2, -2, -2,  // u = 7
+      },
+      /*output=*/{TensorType_INT8, {}, -32, 31.75});
+  m.SetBias({1, 2, 3, 4, 5, 6, 7, 8});
+
+  m.SetInput({
+      1, 2,  3, 4,  5, 6,  7, 8,   // b = 0
+      1, -1, 1, -1, 2, -2, 2, -2,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {31, 0, 1, 24, 31, 8, 31, 0, 0, 4, 3, 4, 5, 0, 1, 8})));
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <initializer_list>
+#include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -857,6 +858,75 @@ TEST(HashtableOpsTest, TestHashtableLookupInt64ToString) {
   EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({3}));
 }
 
+TEST(HashtableOpsTest, TestHashtableLookupManyKeys) {
+  const int kResourceId = 42;
+  const int kNumKeys = 10000;
+  HashtableFindOpModel<std::string, std::int64_t> m(TensorType_STRING,
+                                                    TensorType_INT64, 4);
+
+  m.SetResourceId(kResourceId);
+  m.SetStringLookup({"key0", "key5000", "key9999", "missing"});
+  m.SetDefaultValue({-1});
+
+  std::vector<std::string> keys;
+  std::vector<std::int64_t> values;
+  for (int i = 0; i < kNumKeys; ++i) {
+    keys.push_back("key" + std::to_string(i));
+    values.push_back(i);
+  }
+  // The first of duplicate keys is kept.
+  keys.push_back("key0");
+  values.push_back(kNumKeys);
+
+  auto& resources = m.GetResources();
+  resource::CreateHashtableResourceIfNotAvailable(
+      &resources, kResourceId, kTfLiteString, kTfLiteInt64);
+  auto* lookup = resource::GetHashtableResource(&resources, kResourceId);
+  TfLiteContext context;
+  TfLiteTensor key_tensor = CreateTensor<std::string>(kTfLiteString, keys);
+  TfLiteTensor value_tensor = CreateTensor<std::int64_t>(kTfLiteInt64, values);
+  ASSERT_EQ(lookup->Import(&context, &key_tensor, &value_tensor), kTfLiteOk);
+  // The imported data is copied when the tensors are not read-only.
+  TfLiteTensorFree(&key_tensor);
+  TfLiteTensorFree(&value_tensor);
+  m.Invoke();
+
+  EXPECT_EQ(lookup->Size(), static_cast<size_t>(kNumKeys));
+  EXPECT_THAT(m.GetOutput<std::int64_t>(),
+              ElementsAreArray({0, 5000, 9999, -1}));
+}
+
+TEST(HashtableOpsTest, TestHashtableLookupReadOnlyImport) {
+  const int kResourceId = 42;
+  HashtableFindOpModel<std::int64_t, std::string> m(TensorType_INT64,
+                                                    TensorType_STRING, 3);
+
+  m.SetResourceId(kResourceId);
+  m.SetLookup({6, 4, 7});
+  m.SetStringDefaultValue({"none"});
+
+  auto& resources = m.GetResources();
+  resource::CreateHashtableResourceIfNotAvailable(
+      &resources, kResourceId, kTfLiteInt64, kTfLiteString);
+  auto* lookup = resource::GetHashtableResource(&resources, kResourceId);
+  TfLiteContext context;
+  TfLiteTensor key_tensor = CreateTensor<std::int64_t>(kTfLiteInt64, {4, 5, 6});
+  TfLiteTensor value_tensor =
+      CreateTensor<std::string>(kTfLiteString, {"a", "bb", "ccc"});
+  // Read-only tensors are used in place, so they must outlive the lookups.
+  key_tensor.allocation_type = kTfLiteMmapRo;
+  value_tensor.allocation_type = kTfLiteMmapRo;
+  ASSERT_EQ(lookup->Import(&context, &key_tensor, &value_tensor), kTfLiteOk);
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput<std::string>(),
+              ElementsAreArray({"ccc", "a", "none"}));
+  key_tensor.allocation_type = kTfLiteDynamic;
+  value_tensor.allocation_type = kTfLiteDynamic;
+  TfLiteTensorFree(&key_tensor);
+  TfLiteTensorFree(&value_tensor);
+}
+
 // HashtableImportOpModel creates a model with a HashtableImport op.
 template <typename KeyType, typename ValueType>
 class HashtableImportOpModel : public BaseHashtableOpModel {
@@ -15,6 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
 #define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
@@ -201,6 +205,309 @@ inline void FullyConnectedSparseWeight1x4(
                                   cpu_backend_context);
 }
 
+// The largest number of rows in a block supported by the block sparse kernels
+// below.
+constexpr int kMaxSparseBlockRows = 16;
+
+// A [rows, cols] weights matrix in the block sparse format produced by the
+// converter: the rows are split into groups of `block_rows`, and each group
+// only stores its non-zero blocks of `block_rows` x `block_cols` values, each
+// of them contiguous and in row-major order.
+struct BlockSparseWeights {
+  int block_rows = 1;
+  int block_cols = 1;
+  // The non-zero blocks of the i-th group of rows are in
+  // [segments[i], segments[i + 1]).
+  const int* segments = nullptr;
+  // The column of each non-zero block, in units of `block_cols`.
+  const int* indices = nullptr;
+};
+
+// Reads the block sparse layout of weights of shape `weights_shape` from
+// `sparsity`. All dimensions of the weights but the first and the last must be
+// 1, e.g. [output_depth, 1, 1, input_depth] for the filter of a 1x1
+// convolution, and only the first and the last dimensions may be blocked.
+// Returns false if the layout is not supported by the block sparse kernels.
+inline bool GetBlockSparseWeights(const TfLiteSparsity& sparsity,
+                                  const RuntimeShape& weights_shape,
+                                  BlockSparseWeights* weights) {
+  const int rank = weights_shape.DimensionsCount();
+  const int sparse_dim = rank - 1;
+  const int block_rank =
+      sparsity.block_map == nullptr ? 0 : sparsity.block_map->size;
+  if (rank < 2 || sparsity.dim_metadata_size != rank + block_rank ||
+      sparsity.traversal_order == nullptr ||
+      sparsity.traversal_order->size != sparsity.dim_metadata_size) {
+    return false;
+  }
+  for (int i = 0; i < sparsity.dim_metadata_size; ++i) {
+    const TfLiteDimensionMetadata& metadata = sparsity.dim_metadata[i];
+    if (sparsity.traversal_order->data[i] != i) return false;
+    if (i == sparse_dim) {
+      if (metadata.format != kTfLiteDimSparseCSR) return false;
+    } else if (metadata.format != kTfLiteDimDense ||
+               (i > 0 && i < sparse_dim && metadata.dense_size != 1)) {
+      return false;
+    }
+  }
+  weights->block_rows = 1;
+  weights->block_cols = 1;
+  for (int i = 0; i < block_rank; ++i) {
+    const int block_dim = sparsity.block_map->data[i];
+    const int block_size = sparsity.dim_metadata[rank + i].dense_size;
+    if (block_dim == 0) {
+      weights->block_rows = block_size;
+    } else if (block_dim == sparse_dim) {
+      weights->block_cols = block_size;
+    } else {
+      return false;
+    }
+  }
+  if (weights->block_rows <= 0 || weights->block_rows > kMaxSparseBlockRows ||
+      weights->block_cols <= 0 ||
+      weights_shape.Dims(0) % weights->block_rows != 0 ||
+      weights_shape.Dims(sparse_dim) % weights->block_cols != 0) {
+    return false;
+  }
+  weights->segments = sparsity.dim_metadata[sparse_dim].array_segments->data;
+  weights->indices = sparsity.dim_metadata[sparse_dim].array_indices->data;
+  return true;
+}
+
+// Applies the bias and the activation range to float accumulators.
+struct FloatSparseOutputStage {
+  const float* bias_data;
+  float output_activation_min;
+  float output_activation_max;
+
+  float operator()(float total, int row) const {
+    const float bias_value = bias_data ? bias_data[row] : 0;
+    return ActivationFunctionWithMinMax(total + bias_value,
+                                        output_activation_min,
+                                        output_activation_max);
+  }
+};
+
+// Applies the bias and requantizes int32 accumulators to int8, with either a
+// single or a per output channel multiplier.
+struct Int8SparseOutputStage {
+  const int32_t* bias_data;
+  const int32_t* output_multiplier;
+  const int* output_shift;
+  bool per_channel;
+  int32_t output_offset;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+
+  int8_t operator()(int32_t acc, int row) const {
+    if (bias_data) acc += bias_data[row];
+    const int channel = per_channel ? row : 0;
+    acc = MultiplyByQuantizedMultiplier(acc, output_multiplier[channel],
+                                        output_shift[channel]);
+    acc += output_offset;
+    acc = std::max(acc, output_activation_min);
+    acc = std::min(acc, output_activation_max);
+    return static_cast<int8_t>(acc);
+  }
+};
+
+// Computes the rows of blocks [row_block_start, row_block_end) of the output
+// of a block sparse fully connected layer. A block size of 0 in the template
+// arguments means the block size of `weights` is only known at runtime; the
+// other instantiations let the compiler unroll and vectorize the block loops.
+template <int kBlockRows, int kBlockCols, typename T, typename AccumT,
+          typename OutputT, typename OutputStage>
+inline void BlockSparseFullyConnectedRows(
+    const BlockSparseWeights& weights, const T* weights_data,
+    const T* input_data, AccumT input_offset, int batches, int input_depth,
+    int output_depth, const OutputStage& output_stage, int row_block_start,
+    int row_block_end, OutputT* output_data) {
+  constexpr int kAccumRows = kBlockRows > 0 ? kBlockRows : kMaxSparseBlockRows;
+  const int block_rows = kBlockRows > 0 ? kBlockRows : weights.block_rows;
+  const int block_cols = kBlockCols > 0 ? kBlockCols : weights.block_cols;
+  const int block_size = block_rows * block_cols;
+  for (int b = 0; b < batches; ++b) {
+    const T* input = input_data + b * input_depth;
+    OutputT* output = output_data + b * output_depth;
+    for (int row_block = row_block_start; row_block < row_block_end;
+         ++row_block) {
+      AccumT acc[kAccumRows] = {};
+      for (int k = weights.segments[row_block];
+           k < weights.segments[row_block + 1]; ++k) {
+        const T* block = weights_data + k * block_size;
+        const T* x = input + weights.indices[k] * block_cols;
+        for (int r = 0; r < block_rows; ++r) {
+          AccumT sum = 0;
+          for (int c = 0; c < block_cols; ++c) {
+            sum += static_cast<AccumT>(block[r * block_cols + c]) *
+                   (static_cast<AccumT>(x[c]) + input_offset);
+          }
+          acc[r] += sum;
+        }
+      }
+      const int row = row_block * block_rows;
+      for (int r = 0; r < block_rows; ++r) {
+        output[row + r] = output_stage(acc[r], row + r);
+      }
+    }
+  }
+}
+
+template <typename T, typename AccumT, typename OutputT, typename OutputStage>
+inline void BlockSparseFullyConnectedImpl(
+    const BlockSparseWeights& weights, const T* weights_data,
+    const T* input_data, AccumT input_offset, int batches, int input_depth,
+    int output_depth, const OutputStage& output_stage, int row_block_start,
+    int row_block_end, OutputT* output_data) {
+  ruy::profiler::ScopeLabel label("FullyConnected");
+  ruy::profiler::ScopeLabel inner_label("Block Sparse");
+#define TF_LITE_BLOCK_SPARSE_FC(block_rows, block_cols)                       \
+  BlockSparseFullyConnectedRows<block_rows, block_cols>(                      \
+      weights, weights_data, input_data, input_offset, batches, input_depth,  \
+      output_depth, output_stage, row_block_start, row_block_end, output_data)
+  if (weights.block_rows == 1 && weights.block_cols == 4) {
+    TF_LITE_BLOCK_SPARSE_FC(1, 4);
+  } else if (weights.block_rows == 1 && weights.block_cols == 16) {
+    TF_LITE_BLOCK_SPARSE_FC(1, 16);
+  } else if (weights.block_rows == 4 && weights.block_cols == 4) {
+    TF_LITE_BLOCK_SPARSE_FC(4, 4);
+  } else if (weights.block_rows == 8 && weights.block_cols == 1) {
+    TF_LITE_BLOCK_SPARSE_FC(8, 1);
+  } else {
+    TF_LITE_BLOCK_SPARSE_FC(0, 0);
+  }
+#undef TF_LITE_BLOCK_SPARSE_FC
+}
+
+template <typename T, typename AccumT, typename OutputT, typename OutputStage>
+struct BlockSparseFullyConnectedTask : cpu_backend_threadpool::Task {
+  BlockSparseFullyConnectedTask(const BlockSparseWeights& weights,
+                                const T* weights_data, const T* input_data,
+                                AccumT input_offset, int batches,
+                                int input_depth, int output_depth,
+                                const OutputStage& output_stage,
+                                int row_block_start, int row_block_end,
+                                OutputT* output_data)
+      : weights(weights),
+        weights_data(weights_data),
+        input_data(input_data),
+        input_offset(input_offset),
+        batches(batches),
+        input_depth(input_depth),
+        output_depth(output_depth),
+        output_stage(output_stage),
+        row_block_start(row_block_start),
+        row_block_end(row_block_end),
+        output_data(output_data) {}
+
+  void Run() override {
+    BlockSparseFullyConnectedImpl(weights, weights_data, input_data,
+                                  input_offset, batches, input_depth,
+                                  output_depth, output_stage, row_block_start,
+                                  row_block_end, output_data);
+  }
+
+ private:
+  const BlockSparseWeights& weights;
+  const T* weights_data;
+  const T* input_data;
+  AccumT input_offset;
+  int batches;
+  int input_depth;
+  int output_depth;
+  const OutputStage& output_stage;
+  int row_block_start;
+  int row_block_end;
+  OutputT* output_data;
+};
+
+// Unlike FullyConnectedSparseWeight1x4, the workload is sliced along the rows
+// of the weights, so that single batch inference uses all the threads too.
+template <typename T, typename AccumT, typename OutputT, typename OutputStage>
+inline void BlockSparseFullyConnected(
+    const BlockSparseWeights& weights, const T* weights_data,
+    const T* input_data, AccumT input_offset, int batches, int input_depth,
+    int output_depth, const OutputStage& output_stage, OutputT* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  // Below this number of rows of blocks per thread, the threading overhead
+  // outweighs the gains.
+  constexpr int kMinRowBlocksPerThread = 8;
+  const int row_blocks = output_depth / weights.block_rows;
+  const int max_threads = cpu_backend_context->max_num_threads();
+  const int thread_count = std::max(
+      1, std::min(row_blocks / kMinRowBlocksPerThread, max_threads));
+  if (thread_count == 1) {
+    BlockSparseFullyConnectedImpl(weights, weights_data, input_data,
+                                  input_offset, batches, input_depth,
+                                  output_depth, output_stage, 0, row_blocks,
+                                  output_data);
+    return;
+  }
+  std::vector<BlockSparseFullyConnectedTask<T, AccumT, OutputT, OutputStage>>
+      tasks;
+  tasks.reserve(thread_count);
+  int row_block_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int row_block_end = row_block_start + row_blocks / thread_count;
+    if (i < row_blocks % thread_count) row_block_end++;
+    tasks.emplace_back(weights, weights_data, input_data, input_offset,
+                       batches, input_depth, output_depth, output_stage,
+                       row_block_start, row_block_end, output_data);
+    row_block_start = row_block_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+// Float fully connected layer with block sparse weights. `weights_shape` is
+// [output_depth, input_depth], both multiples of the block size of `weights`.
+inline void FullyConnectedSparseWeightBlock(
+    const BlockSparseWeights& weights, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const float* input_data,
+    const RuntimeShape& weights_shape, const float* weights_data,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  const int output_depth = weights_shape.Dims(0);
+  const int input_depth = weights_shape.Dims(1);
+  const int batches = output_shape.FlatSize() / output_depth;
+  const FloatSparseOutputStage output_stage = {
+      bias_data, params.float_activation_min, params.float_activation_max};
+  BlockSparseFullyConnected(weights, weights_data, input_data,
+                            /*input_offset=*/0.0f, batches, input_depth,
+                            output_depth, output_stage, output_data,
+                            cpu_backend_context);
+}
+
+// Int8 fully connected layer with block sparse, symmetrically quantized
+// weights, with the same shapes as above. `output_multiplier` and
+// `output_shift` hold one entry per output channel if `per_channel` is true,
+// and a single entry otherwise.
+inline void FullyConnectedSparseWeightBlock(
+    const BlockSparseWeights& weights, const FullyConnectedParams& params,
+    const int32_t* output_multiplier, const int* output_shift,
+    bool per_channel, const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  const int output_depth = weights_shape.Dims(0);
+  const int input_depth = weights_shape.Dims(1);
+  const int batches = output_shape.FlatSize() / output_depth;
+  const Int8SparseOutputStage output_stage = {
+      bias_data,
+      output_multiplier,
+      output_shift,
+      per_channel,
+      params.output_offset,
+      params.quantized_activation_min,
+      params.quantized_activation_max};
+  BlockSparseFullyConnected(weights, weights_data, input_data,
+                            params.input_offset, batches, input_depth,
+                            output_depth, output_stage, output_data,
+                            cpu_backend_context);
+}
+
 }  // namespace optimized_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
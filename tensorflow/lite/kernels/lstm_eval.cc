@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/kernel_utils.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -906,6 +908,106 @@ inline void LstmStepFloat(
 // LINT.ThenChange(../tools/optimize/calibration/builtin_logging_ops/lstm.cc,\
 //                 ../experimental/kernels/fp16/lstm_eval.cc)
 
+// Applies the peephole connection, layer normalization and activation to a
+// gate holding the product of the fused gate weights with the input and the
+// output state, for a single batch. Without layer normalization the bias has
+// already been added by the product.
+inline void FinishLstmGateFloat(const float* cell_state,
+                                const float* cell_to_gate_weights,
+                                const float* layer_norm_coefficients,
+                                const float* gate_bias, int n_cell,
+                                TfLiteFusedActivation activation,
+                                float* gate) {
+  if (cell_to_gate_weights != nullptr) {
+    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
+        cell_to_gate_weights, n_cell, cell_state, /*n_batch=*/1, gate);
+  }
+  if (layer_norm_coefficients != nullptr) {
+    tensor_utils::MeanStddevNormalization(gate, gate, n_cell, /*n_batch=*/1);
+    tensor_utils::VectorBatchVectorCwiseProduct(layer_norm_coefficients, n_cell,
+                                                gate, /*n_batch=*/1, gate);
+    tensor_utils::VectorBatchVectorAdd(gate_bias, n_cell, /*n_batch=*/1, gate);
+  }
+  tensor_utils::ApplyActivationToVector(gate, n_cell, activation, gate);
+}
+
+// Same as LstmStepFloat for a single batch, but computes the products of all
+// the gates with one matrix*vector product of the fused gate weights packed by
+// PackFusedGateWeightsFloat with the concatenated input and output state.
+//
+// Scratch buffers:
+//   fused_input: size 'n_input + n_output'
+//   gates: size 'n_gates * n_cell', holding the gates in the order of the
+//     fused gate weights.
+inline void LstmStepFloatFusedGates(
+    const float* input_ptr, const float* fused_gate_weights_ptr,
+    const float* fused_gate_bias_ptr, const float* cell_to_input_weights_ptr,
+    const float* cell_to_forget_weights_ptr,
+    const float* cell_to_output_weights_ptr,
+    const float* input_layer_norm_coefficients_ptr,
+    const float* forget_layer_norm_coefficients_ptr,
+    const float* cell_layer_norm_coefficients_ptr,
+    const float* output_layer_norm_coefficients_ptr,
+    const float* input_gate_bias_ptr, const float* forget_gate_bias_ptr,
+    const float* cell_gate_bias_ptr, const float* output_gate_bias_ptr,
+    const float* projection_weights_ptr, const float* projection_bias_ptr,
+    const TfLiteLSTMParams* params, bool use_cifg, bool use_layer_norm,
+    int n_cell, int n_input, int n_output, float* output_state_ptr,
+    float* cell_state_ptr, float* fused_input_ptr, float* gates_ptr,
+    float* output_ptr, CpuBackendContext* context) {
+  ruy::profiler::ScopeLabel label("LstmStepFloatFusedGates");
+  const int n_gates = use_cifg ? 3 : 4;
+  const int n_fused_input = n_input + n_output;
+  std::copy_n(input_ptr, n_input, fused_input_ptr);
+  std::copy_n(output_state_ptr, n_output, fused_input_ptr + n_input);
+
+  cpu_backend_gemm::MatrixParams<float> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = n_gates * n_cell;
+  lhs_params.cols = n_fused_input;
+  cpu_backend_gemm::MatrixParams<float> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = n_fused_input;
+  rhs_params.cols = 1;
+  cpu_backend_gemm::MatrixParams<float> dst_params;
+  dst_params.order = cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = n_gates * n_cell;
+  dst_params.cols = 1;
+  cpu_backend_gemm::GemmParams<float, float> gemm_params;
+  // With layer norm, the bias is added after the normalization.
+  if (!use_layer_norm) gemm_params.bias = fused_gate_bias_ptr;
+  cpu_backend_gemm::Gemm(lhs_params, fused_gate_weights_ptr, rhs_params,
+                         fused_input_ptr, dst_params, gates_ptr, gemm_params,
+                         context);
+
+  float* input_gate = use_cifg ? nullptr : gates_ptr;
+  float* forget_gate = gates_ptr + (n_gates - 3) * n_cell;
+  float* cell_gate = forget_gate + n_cell;
+  float* output_gate = cell_gate + n_cell;
+  if (!use_cifg) {
+    FinishLstmGateFloat(cell_state_ptr, cell_to_input_weights_ptr,
+                        input_layer_norm_coefficients_ptr, input_gate_bias_ptr,
+                        n_cell, kTfLiteActSigmoid, input_gate);
+  }
+  FinishLstmGateFloat(cell_state_ptr, cell_to_forget_weights_ptr,
+                      forget_layer_norm_coefficients_ptr, forget_gate_bias_ptr,
+                      n_cell, kTfLiteActSigmoid, forget_gate);
+  FinishLstmGateFloat(/*cell_state=*/nullptr, /*cell_to_gate_weights=*/nullptr,
+                      cell_layer_norm_coefficients_ptr, cell_gate_bias_ptr,
+                      n_cell, params->activation, cell_gate);
+  UpdateLstmCellFloat(/*n_batch=*/1, n_cell, cell_state_ptr, input_gate,
+                      forget_gate, cell_gate, use_cifg, params->cell_clip);
+  // The output gate peephole uses the updated cell state.
+  FinishLstmGateFloat(cell_state_ptr, cell_to_output_weights_ptr,
+                      output_layer_norm_coefficients_ptr, output_gate_bias_ptr,
+                      n_cell, kTfLiteActSigmoid, output_gate);
+  CalculateLstmOutputFloat(/*n_batch=*/1, n_cell, n_output, cell_state_ptr,
+                           output_gate, params->activation,
+                           projection_weights_ptr, projection_bias_ptr,
+                           params->proj_clip, output_state_ptr, cell_gate);
+  std::copy_n(output_state_ptr, n_output, output_ptr);
+}
+
 // Same as above but with quantized weight matrices. In detail:
 // Input of size 'n_batch * n_input':
 //   input_ptr
@@ -1867,6 +1969,113 @@ TfLiteStatus EvalFloat(
 }
 // LINT.ThenChange(//tensorflow/lite/tools/optimize/calibration/builtin_logging_ops/lstm.cc)
 
+void PackFusedGateWeightsFloat(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
+    const TfLiteTensor* cell_gate_bias, const TfLiteTensor* output_gate_bias,
+    TfLiteTensor* fused_gate_weights, TfLiteTensor* fused_gate_bias) {
+  const int n_cell = input_to_output_weights->dims->data[0];
+  const int n_input = input_to_output_weights->dims->data[1];
+  const int n_output = recurrent_to_output_weights->dims->data[1];
+  const bool use_cifg = (input_to_input_weights == nullptr);
+  const TfLiteTensor* gate_weights[][3] = {
+      {input_to_input_weights, recurrent_to_input_weights, input_gate_bias},
+      {input_to_forget_weights, recurrent_to_forget_weights, forget_gate_bias},
+      {input_to_cell_weights, recurrent_to_cell_weights, cell_gate_bias},
+      {input_to_output_weights, recurrent_to_output_weights, output_gate_bias},
+  };
+  float* weights_ptr = GetTensorData<float>(fused_gate_weights);
+  float* bias_ptr = GetTensorData<float>(fused_gate_bias);
+  for (int gate = use_cifg ? 1 : 0; gate < 4; ++gate) {
+    const float* input_weights = GetTensorData<float>(gate_weights[gate][0]);
+    const float* recurrent_weights =
+        GetTensorData<float>(gate_weights[gate][1]);
+    for (int c = 0; c < n_cell; ++c) {
+      weights_ptr = std::copy_n(input_weights + c * n_input, n_input,
+                                weights_ptr);
+      weights_ptr = std::copy_n(recurrent_weights + c * n_output, n_output,
+                                weights_ptr);
+    }
+    bias_ptr =
+        std::copy_n(GetTensorData<float>(gate_weights[gate][2]), n_cell,
+                    bias_ptr);
+  }
+}
+
+TfLiteStatus EvalFloatFusedGates(
+    const TfLiteTensor* input, const TfLiteTensor* fused_gate_weights,
+    const TfLiteTensor* fused_gate_bias,
+    const TfLiteTensor* cell_to_input_weights,
+    const TfLiteTensor* cell_to_forget_weights,
+    const TfLiteTensor* cell_to_output_weights,
+    const TfLiteTensor* input_layer_norm_coefficients,
+    const TfLiteTensor* forget_layer_norm_coefficients,
+    const TfLiteTensor* cell_layer_norm_coefficients,
+    const TfLiteTensor* output_layer_norm_coefficients,
+    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
+    const TfLiteTensor* cell_gate_bias, const TfLiteTensor* output_gate_bias,
+    const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
+    const TfLiteLSTMParams* params, bool use_cifg, bool time_major,
+    TfLiteTensor* fused_input, TfLiteTensor* scratch_buffer,
+    TfLiteTensor* output_state, TfLiteTensor* cell_state, TfLiteTensor* output,
+    CpuBackendContext* context) {
+  TF_LITE_ASSERT(input->dims->size >= 2 && input->dims->size <= 3);
+  int max_time, n_batch;
+  if (input->dims->size == 3) {
+    max_time = (time_major) ? input->dims->data[0] : input->dims->data[1];
+    n_batch = (time_major) ? input->dims->data[1] : input->dims->data[0];
+  } else {
+    max_time = 1;
+    n_batch = input->dims->data[0];
+  }
+  // Time major sequences step all the batches at once.
+  TF_LITE_ASSERT(!time_major || n_batch == 1);
+  const int n_input = input->dims->data[input->dims->size - 1];
+  const int n_gates = use_cifg ? 3 : 4;
+  const int n_cell = fused_gate_bias->dims->data[0] / n_gates;
+  const int n_output = fused_gate_weights->dims->data[1] - n_input;
+  const bool use_layer_norm = (forget_layer_norm_coefficients != nullptr);
+
+  // Both layouts store the steps of a batch contiguously when there is one
+  // step or one batch.
+  for (int b = 0; b < n_batch; b++) {
+    float* output_state_ptr = GetTensorData<float>(output_state) + b * n_output;
+    float* cell_state_ptr = GetTensorData<float>(cell_state) + b * n_cell;
+    for (int t = 0; t < max_time; t++) {
+      const int time_offset = b * max_time + t;
+      LstmStepFloatFusedGates(
+          GetTensorData<float>(input) + time_offset * n_input,
+          GetTensorData<float>(fused_gate_weights),
+          GetTensorData<float>(fused_gate_bias),
+          GetTensorData<float>(cell_to_input_weights),
+          GetTensorData<float>(cell_to_forget_weights),
+          GetTensorData<float>(cell_to_output_weights),
+          GetTensorData<float>(input_layer_norm_coefficients),
+          GetTensorData<float>(forget_layer_norm_coefficients),
+          GetTensorData<float>(cell_layer_norm_coefficients),
+          GetTensorData<float>(output_layer_norm_coefficients),
+          GetTensorData<float>(input_gate_bias),
+          GetTensorData<float>(forget_gate_bias),
+          GetTensorData<float>(cell_gate_bias),
+          GetTensorData<float>(output_gate_bias),
+          GetTensorData<float>(projection_weights),
+          GetTensorData<float>(projection_bias), params, use_cifg,
+          use_layer_norm, n_cell, n_input, n_output, output_state_ptr,
+          cell_state_ptr, GetTensorData<float>(fused_input),
+          GetTensorData<float>(scratch_buffer),
+          GetTensorData<float>(output) + time_offset * n_output, context);
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus EvalHybrid(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_input_weights_ledger,
@@ -123,6 +123,49 @@ TfLiteStatus EvalFloat(
     int output_offset, TfLiteTensor* scratch_buffer, TfLiteTensor* output_state,
     TfLiteTensor* cell_state, TfLiteTensor* output);
 
+// Packs the input and recurrent weights of the gates of a float LSTM into
+// `fused_gate_weights`, a row-major matrix of size
+// 'n_gates * n_cell' x 'n_input + n_output', and the gate biases into
+// `fused_gate_bias`, of size 'n_gates * n_cell'. The gates are in the order
+// input (unless CIFG), forget, cell and output.
+void PackFusedGateWeightsFloat(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
+    const TfLiteTensor* cell_gate_bias, const TfLiteTensor* output_gate_bias,
+    TfLiteTensor* fused_gate_weights, TfLiteTensor* fused_gate_bias);
+
+// Same as EvalFloat without auxiliary input, for sequences that are stepped
+// one batch at a time: batch major inputs, or time major inputs with a single
+// batch. Each step computes all the gates with one matrix*vector product of
+// the weights packed by PackFusedGateWeightsFloat, which is what streaming
+// models invoked one frame at a time spend most of their time on.
+// `fused_input` is a scratch buffer of size 'n_input + n_output', and
+// `scratch_buffer` has room for the gates of one batch.
+TfLiteStatus EvalFloatFusedGates(
+    const TfLiteTensor* input, const TfLiteTensor* fused_gate_weights,
+    const TfLiteTensor* fused_gate_bias,
+    const TfLiteTensor* cell_to_input_weights,
+    const TfLiteTensor* cell_to_forget_weights,
+    const TfLiteTensor* cell_to_output_weights,
+    const TfLiteTensor* input_layer_norm_coefficients,
+    const TfLiteTensor* forget_layer_norm_coefficients,
+    const TfLiteTensor* cell_layer_norm_coefficients,
+    const TfLiteTensor* output_layer_norm_coefficients,
+    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
+    const TfLiteTensor* cell_gate_bias, const TfLiteTensor* output_gate_bias,
+    const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
+    const TfLiteLSTMParams* params, bool use_cifg, bool time_major,
+    TfLiteTensor* fused_input, TfLiteTensor* scratch_buffer,
+    TfLiteTensor* output_state, TfLiteTensor* cell_state, TfLiteTensor* output,
+    CpuBackendContext* context);
+
 TfLiteStatus EvalHybrid(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_input_weights_ledger,
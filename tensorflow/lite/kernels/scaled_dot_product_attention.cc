@@ -0,0 +1,462 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace scaled_dot_product_attention {
+namespace {
+
+// Computes softmax(scale * query * key^T + mask) * value for each batch, where
+// the batch dimensions usually hold the batch and the attention heads:
+//   query: [batch..., query_length, depth]
+//   key:   [batch..., key_length, depth]
+//   value: [batch..., key_length, value_depth]
+//   mask (optional, float32): broadcastable to [batch..., query_length,
+//     key_length], added to the scores.
+//   output: [batch..., query_length, value_depth]
+//
+// The scores are computed for a block of queries and a tile of keys at a time,
+// and the softmax is accumulated online: the running maximum and sum of each
+// row rescale the partial results when a tile raises the maximum. The score
+// matrix of a batch is never materialized, and the key and value tiles stay in
+// the cache while the queries of the block use them.
+//
+// int8 tensors are quantized asymmetrically, and int16 ones symmetrically. The
+// query, key, value and output may have different quantization parameters.
+// The scores and the softmax are computed in float in both cases.
+constexpr int kQueryTensor = 0;
+constexpr int kKeyTensor = 1;
+constexpr int kValueTensor = 2;
+constexpr int kMaskTensor = 3;
+constexpr int kOutputTensor = 0;
+
+constexpr int kQueryBlockSize = 8;
+constexpr int kKeyTileSize = 64;
+
+constexpr const char kScaleStr[] = "scale";
+
+struct OpData {
+  float scale;
+  // The offset of the mask of each batch, and the strides of the mask along
+  // the queries and the keys. The strides are 0 for broadcast dimensions.
+  std::vector<int> mask_batch_offsets;
+  int mask_query_stride;
+  int mask_key_stride;
+};
+
+// The arguments of the attention of all batches.
+template <typename T>
+struct AttentionParams {
+  const T* query;
+  const T* key;
+  const T* value;
+  const float* mask;
+  T* output;
+  int query_length;
+  int key_length;
+  int depth;
+  int value_depth;
+  const OpData* op_data;
+  // Multiplies the dot products of the (zero point adjusted) queries and keys.
+  float score_scale;
+  int32_t query_zero_point;
+  int32_t key_zero_point;
+  int32_t value_zero_point;
+  // Multiplies the attention output before it is quantized.
+  float output_multiplier;
+  int32_t output_zero_point;
+};
+
+inline float DotProduct(const float* query, const float* key, int depth,
+                        int32_t, int32_t) {
+  float sum = 0.0f;
+  for (int i = 0; i < depth; ++i) sum += query[i] * key[i];
+  return sum;
+}
+
+template <typename T>
+inline float DotProduct(const T* query, const T* key, int depth,
+                        int32_t query_zero_point, int32_t key_zero_point) {
+  // The products of int16 values overflow int32 sums after a few terms.
+  using AccumT =
+      typename std::conditional<sizeof(T) == 1, int32_t, int64_t>::type;
+  AccumT sum = 0;
+  for (int i = 0; i < depth; ++i) {
+    sum += static_cast<AccumT>(query[i] - query_zero_point) *
+           (key[i] - key_zero_point);
+  }
+  return static_cast<float>(sum);
+}
+
+inline void StoreOutput(float value, const AttentionParams<float>&,
+                        float* output) {
+  *output = value;
+}
+
+template <typename T>
+inline void StoreOutput(float value, const AttentionParams<T>& params,
+                        T* output) {
+  const int32_t quantized =
+      static_cast<int32_t>(std::round(value * params.output_multiplier)) +
+      params.output_zero_point;
+  *output = static_cast<T>(
+      std::min<int32_t>(std::max<int32_t>(quantized,
+                                          std::numeric_limits<T>::min()),
+                        std::numeric_limits<T>::max()));
+}
+
+// Computes the attention of the queries [query_begin, query_end) of `batch`.
+// `scores` holds kQueryBlockSize * kKeyTileSize floats, `accumulators`
+// kQueryBlockSize * value_depth, and `maxima` and `sums` kQueryBlockSize.
+template <typename T>
+void ComputeQueryBlock(const AttentionParams<T>& params, int batch,
+                       int query_begin, int query_end, float* scores,
+                       float* accumulators, float* maxima, float* sums) {
+  const int rows = query_end - query_begin;
+  const int depth = params.depth;
+  const int value_depth = params.value_depth;
+  std::fill(maxima, maxima + rows, -std::numeric_limits<float>::infinity());
+  std::fill(sums, sums + rows, 0.0f);
+  std::fill(accumulators, accumulators + rows * value_depth, 0.0f);
+
+  const T* query =
+      params.query + (batch * params.query_length + query_begin) * depth;
+  const T* key = params.key + batch * params.key_length * depth;
+  const T* value = params.value + batch * params.key_length * value_depth;
+  const OpData& op_data = *params.op_data;
+  const float* mask = params.mask == nullptr
+                          ? nullptr
+                          : params.mask + op_data.mask_batch_offsets[batch] +
+                                query_begin * op_data.mask_query_stride;
+
+  for (int key_begin = 0; key_begin < params.key_length;
+       key_begin += kKeyTileSize) {
+    const int cols = std::min(kKeyTileSize, params.key_length - key_begin);
+    for (int i = 0; i < rows; ++i) {
+      float* row_scores = scores + i * kKeyTileSize;
+      float tile_max = -std::numeric_limits<float>::infinity();
+      for (int j = 0; j < cols; ++j) {
+        float score = params.score_scale *
+                      DotProduct(query + i * depth,
+                                 key + (key_begin + j) * depth, depth,
+                                 params.query_zero_point,
+                                 params.key_zero_point);
+        if (mask != nullptr) {
+          score += mask[i * op_data.mask_query_stride +
+                        (key_begin + j) * op_data.mask_key_stride];
+        }
+        row_scores[j] = score;
+        tile_max = std::max(tile_max, score);
+      }
+      // The whole tile is masked out.
+      if (tile_max == -std::numeric_limits<float>::infinity()) continue;
+
+      float* row_accumulators = accumulators + i * value_depth;
+      const float new_max = std::max(maxima[i], tile_max);
+      if (new_max > maxima[i]) {
+        const float correction = std::exp(maxima[i] - new_max);
+        sums[i] *= correction;
+        for (int d = 0; d < value_depth; ++d) {
+          row_accumulators[d] *= correction;
+        }
+        maxima[i] = new_max;
+      }
+      for (int j = 0; j < cols; ++j) {
+        const float weight = std::exp(row_scores[j] - new_max);
+        sums[i] += weight;
+        const T* value_row = value + (key_begin + j) * value_depth;
+        for (int d = 0; d < value_depth; ++d) {
+          row_accumulators[d] +=
+              weight * (value_row[d] - params.value_zero_point);
+        }
+      }
+    }
+  }
+
+  T* output =
+      params.output + (batch * params.query_length + query_begin) * value_depth;
+  for (int i = 0; i < rows; ++i) {
+    // Rows without any key left by the mask are all zeros.
+    const float inverse_sum = sums[i] > 0.0f ? 1.0f / sums[i] : 0.0f;
+    for (int d = 0; d < value_depth; ++d) {
+      StoreOutput(accumulators[i * value_depth + d] * inverse_sum, params,
+                  output + i * value_depth + d);
+    }
+  }
+}
+
+// Computes the query blocks [block_begin, block_end) of all batches.
+template <typename T>
+struct AttentionTask : cpu_backend_threadpool::Task {
+  AttentionTask(const AttentionParams<T>& params, int block_begin,
+                int block_end)
+      : params(params), block_begin(block_begin), block_end(block_end) {}
+
+  void Run() override {
+    std::vector<float> scores(kQueryBlockSize * kKeyTileSize);
+    std::vector<float> accumulators(kQueryBlockSize * params.value_depth);
+    std::vector<float> maxima(kQueryBlockSize);
+    std::vector<float> sums(kQueryBlockSize);
+    const int blocks_per_batch =
+        (params.query_length + kQueryBlockSize - 1) / kQueryBlockSize;
+    for (int block = block_begin; block < block_end; ++block) {
+      const int batch = block / blocks_per_batch;
+      const int query_begin = (block % blocks_per_batch) * kQueryBlockSize;
+      const int query_end =
+          std::min(query_begin + kQueryBlockSize, params.query_length);
+      ComputeQueryBlock(params, batch, query_begin, query_end, scores.data(),
+                        accumulators.data(), maxima.data(), sums.data());
+    }
+  }
+
+  const AttentionParams<T>& params;
+  const int block_begin;
+  const int block_end;
+};
+
+template <typename T>
+void ComputeAttention(TfLiteContext* context, const AttentionParams<T>& params,
+                      int num_batches) {
+  const int blocks_per_batch =
+      (params.query_length + kQueryBlockSize - 1) / kQueryBlockSize;
+  const int num_blocks = num_batches * blocks_per_batch;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const int num_tasks =
+      std::min(cpu_backend_context->max_num_threads(), num_blocks);
+  if (num_tasks <= 1) {
+    AttentionTask<T>(params, 0, num_blocks).Run();
+    return;
+  }
+  std::vector<AttentionTask<T>> tasks;
+  tasks.reserve(num_tasks);
+  int block_begin = 0;
+  for (int i = 0; i < num_tasks; ++i) {
+    const int block_end = block_begin + (num_blocks - block_begin) /
+                                            (num_tasks - i);
+    tasks.emplace_back(params, block_begin, block_end);
+    block_begin = block_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
+}  // namespace
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  OpData* op_data = new OpData;
+  op_data->scale = 1.0f;
+  if (buffer != nullptr && length > 0) {
+    const flexbuffers::Map& m =
+        flexbuffers::GetRoot(reinterpret_cast<const uint8_t*>(buffer), length)
+            .AsMap();
+    const flexbuffers::Reference scale = m[kScaleStr];
+    if (!scale.IsNull()) op_data->scale = scale.AsFloat();
+  }
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE(context, NumInputs(node) == 3 || NumInputs(node) == 4);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* query;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kQueryTensor, &query));
+  const TfLiteTensor* key;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  const TfLiteTensor* value;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+
+  TF_LITE_ENSURE(context, query->type == kTfLiteFloat32 ||
+                              query->type == kTfLiteInt8 ||
+                              query->type == kTfLiteInt16);
+  TF_LITE_ENSURE_TYPES_EQ(context, key->type, query->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, value->type, query->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, query->type);
+  if (query->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, query->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, key->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, value->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+  if (query->type != kTfLiteFloat32) {
+    TF_LITE_ENSURE(context, output->params.scale > 0.0f);
+  }
+
+  const int rank = NumDimensions(query);
+  TF_LITE_ENSURE(context, rank >= 2);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(key), rank);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(value), rank);
+  for (int i = 0; i < rank - 2; ++i) {
+    TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, i),
+                      SizeOfDimension(query, i));
+    TF_LITE_ENSURE_EQ(context, SizeOfDimension(value, i),
+                      SizeOfDimension(query, i));
+  }
+  const int query_length = SizeOfDimension(query, rank - 2);
+  const int key_length = SizeOfDimension(key, rank - 2);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, rank - 1),
+                    SizeOfDimension(query, rank - 1));
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(value, rank - 2), key_length);
+
+  op_data->mask_batch_offsets.clear();
+  op_data->mask_query_stride = 0;
+  op_data->mask_key_stride = 0;
+  const TfLiteTensor* mask = GetOptionalInputTensor(context, node, kMaskTensor);
+  if (mask != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, mask->type, kTfLiteFloat32);
+    const int mask_rank = NumDimensions(mask);
+    TF_LITE_ENSURE(context, mask_rank <= rank);
+    // The strides of the mask for each dimension of the scores.
+    std::vector<int> strides(rank, 0);
+    int stride = 1;
+    for (int i = rank - 1, j = mask_rank - 1; j >= 0; --i, --j) {
+      const int score_size =
+          i == rank - 1 ? key_length : SizeOfDimension(query, i);
+      const int mask_size = SizeOfDimension(mask, j);
+      TF_LITE_ENSURE(context, mask_size == 1 || mask_size == score_size);
+      if (mask_size != 1) strides[i] = stride;
+      stride *= mask_size;
+    }
+    op_data->mask_query_stride = strides[rank - 2];
+    op_data->mask_key_stride = strides[rank - 1];
+    int num_batches = 1;
+    for (int i = 0; i < rank - 2; ++i) num_batches *= SizeOfDimension(query, i);
+    op_data->mask_batch_offsets.resize(num_batches);
+    for (int batch = 0; batch < num_batches; ++batch) {
+      int offset = 0;
+      for (int i = rank - 3, remaining = batch; i >= 0; --i) {
+        offset += (remaining % SizeOfDimension(query, i)) * strides[i];
+        remaining /= SizeOfDimension(query, i);
+      }
+      op_data->mask_batch_offsets[batch] = offset;
+    }
+  }
+
+  TfLiteIntArray* output_size = TfLiteIntArrayCopy(query->dims);
+  output_size->data[rank - 1] = SizeOfDimension(value, rank - 1);
+  return context->ResizeTensor(context, output, output_size);
+}
+
+template <typename T>
+void EvalAttention(TfLiteContext* context, const OpData& op_data,
+                   const TfLiteTensor* query, const TfLiteTensor* key,
+                   const TfLiteTensor* value, const TfLiteTensor* mask,
+                   TfLiteTensor* output) {
+  const int rank = NumDimensions(query);
+  int num_batches = 1;
+  for (int i = 0; i < rank - 2; ++i) num_batches *= SizeOfDimension(query, i);
+
+  AttentionParams<T> params;
+  params.query = GetTensorData<T>(query);
+  params.key = GetTensorData<T>(key);
+  params.value = GetTensorData<T>(value);
+  params.mask = mask == nullptr ? nullptr : GetTensorData<float>(mask);
+  params.output = GetTensorData<T>(output);
+  params.query_length = SizeOfDimension(query, rank - 2);
+  params.key_length = SizeOfDimension(key, rank - 2);
+  params.depth = SizeOfDimension(query, rank - 1);
+  params.value_depth = SizeOfDimension(value, rank - 1);
+  params.op_data = &op_data;
+  if (std::is_same<T, float>::value) {
+    params.score_scale = op_data.scale;
+    params.query_zero_point = 0;
+    params.key_zero_point = 0;
+    params.value_zero_point = 0;
+    params.output_multiplier = 1.0f;
+    params.output_zero_point = 0;
+  } else {
+    params.score_scale =
+        op_data.scale * query->params.scale * key->params.scale;
+    params.query_zero_point = query->params.zero_point;
+    params.key_zero_point = key->params.zero_point;
+    params.value_zero_point = value->params.zero_point;
+    params.output_multiplier = value->params.scale / output->params.scale;
+    params.output_zero_point = output->params.zero_point;
+  }
+  ComputeAttention(context, params, num_batches);
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* query;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kQueryTensor, &query));
+  const TfLiteTensor* key;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kKeyTensor, &key));
+  const TfLiteTensor* value;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kValueTensor, &value));
+  const TfLiteTensor* mask = GetOptionalInputTensor(context, node, kMaskTensor);
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+
+  switch (query->type) {
+    case kTfLiteFloat32:
+      EvalAttention<float>(context, *op_data, query, key, value, mask, output);
+      break;
+    case kTfLiteInt8:
+      EvalAttention<int8_t>(context, *op_data, query, key, value, mask,
+                            output);
+      break;
+    case kTfLiteInt16:
+      EvalAttention<int16_t>(context, *op_data, query, key, value, mask,
+                             output);
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type '%s' is not supported by %s.",
+                         TfLiteTypeGetName(query->type),
+                         "ScaledDotProductAttention");
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace scaled_dot_product_attention
+
+TfLiteRegistration* Register_SCALED_DOT_PRODUCT_ATTENTION() {
+  static TfLiteRegistration r = {
+      scaled_dot_product_attention::Init, scaled_dot_product_attention::Free,
+      scaled_dot_product_attention::Prepare,
+      scaled_dot_product_attention::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
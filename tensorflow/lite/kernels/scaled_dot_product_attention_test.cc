@@ -0,0 +1,304 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/kernels/custom_ops_register.h"
+#include "tensorflow/lite/kernels/test_util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+template <typename T>
+class ScaledDotProductAttentionOpModel : public SingleOpModel {
+ public:
+  ScaledDotProductAttentionOpModel(const TensorData& query,
+                                   const TensorData& key,
+                                   const TensorData& value,
+                                   const TensorData& output, float scale,
+                                   const std::vector<int>& mask_shape = {},
+                                   int num_threads = 1) {
+    query_ = AddInput(query);
+    key_ = AddInput(key);
+    value_ = AddInput(value);
+    if (!mask_shape.empty()) {
+      mask_ = AddInput({TensorType_FLOAT32, mask_shape});
+    }
+    output_ = AddOutput(output);
+
+    auto flex_builder = std::make_unique<flexbuffers::Builder>();
+    size_t map_start = flex_builder->StartMap();
+    flex_builder->Float("scale", scale);
+    flex_builder->EndMap(map_start);
+    flex_builder->Finish();
+    SetCustomOp("ScaledDotProductAttention", flex_builder->GetBuffer(),
+                ops::custom::Register_SCALED_DOT_PRODUCT_ATTENTION);
+
+    std::vector<std::vector<int>> input_shapes = {
+        GetShape(query_), GetShape(key_), GetShape(value_)};
+    if (!mask_shape.empty()) input_shapes.push_back(mask_shape);
+    BuildInterpreter(input_shapes, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/true);
+  }
+
+  void SetInputs(const std::vector<float>& query,
+                 const std::vector<float>& key,
+                 const std::vector<float>& value) {
+    SetInput(query_, query);
+    SetInput(key_, key);
+    SetInput(value_, value);
+  }
+
+  void SetMask(const std::vector<float>& mask) { PopulateTensor(mask_, mask); }
+
+  std::vector<float> GetOutput() {
+    return Dequantize<T>(ExtractVector<T>(output_), GetScale(output_),
+                         GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  void SetInput(int index, const std::vector<float>& data) {
+    QuantizeAndPopulate<T>(index, data);
+  }
+
+  int query_;
+  int key_;
+  int value_;
+  int mask_ = -1;
+  int output_;
+};
+
+template <>
+void ScaledDotProductAttentionOpModel<float>::SetInput(
+    int index, const std::vector<float>& data) {
+  PopulateTensor(index, data);
+}
+
+template <>
+std::vector<float> ScaledDotProductAttentionOpModel<float>::GetOutput() {
+  return ExtractVector<float>(output_);
+}
+
+// Computes softmax(scale * query * key^T + mask) * value with the full score
+// matrix. `mask` has [batches, 1, key_length] values, broadcast over the heads
+// and the queries.
+std::vector<float> ReferenceAttention(
+    const std::vector<float>& query, const std::vector<float>& key,
+    const std::vector<float>& value, const std::vector<float>& mask,
+    int batches, int heads, int query_length, int key_length, int depth,
+    int value_depth, float scale) {
+  std::vector<float> output(batches * heads * query_length * value_depth);
+  std::vector<float> scores(key_length);
+  for (int b = 0; b < batches * heads; ++b) {
+    for (int i = 0; i < query_length; ++i) {
+      float max_score = -std::numeric_limits<float>::infinity();
+      for (int j = 0; j < key_length; ++j) {
+        float dot = 0.0f;
+        for (int d = 0; d < depth; ++d) {
+          dot += query[(b * query_length + i) * depth + d] *
+                 key[(b * key_length + j) * depth + d];
+        }
+        scores[j] = scale * dot;
+        if (!mask.empty()) scores[j] += mask[(b / heads) * key_length + j];
+        max_score = std::max(max_score, scores[j]);
+      }
+      float sum = 0.0f;
+      for (float& score : scores) {
+        score = std::exp(score - max_score);
+        sum += score;
+      }
+      for (int d = 0; d < value_depth; ++d) {
+        float result = 0.0f;
+        for (int j = 0; j < key_length; ++j) {
+          result +=
+              scores[j] / sum * value[(b * key_length + j) * value_depth + d];
+        }
+        output[(b * query_length + i) * value_depth + d] = result;
+      }
+    }
+  }
+  return output;
+}
+
+// Values in [-1, 1] that don't repeat with a short period.
+std::vector<float> Values(int size, int seed) {
+  std::vector<float> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = std::sin(0.7f * i + seed);
+  }
+  return values;
+}
+
+TEST(ScaledDotProductAttentionOpTest, Float) {
+  // The scores of the query are 0 and ln(3), so the weights are 1/4 and 3/4.
+  ScaledDotProductAttentionOpModel<float> m(
+      {TensorType_FLOAT32, {1, 1, 1, 1}}, {TensorType_FLOAT32, {1, 1, 2, 1}},
+      {TensorType_FLOAT32, {1, 1, 2, 2}}, {TensorType_FLOAT32, {}},
+      /*scale=*/0.5f);
+  m.SetInputs({2.0f}, {0.0f, std::log(3.0f)}, {1.0f, -4.0f, 5.0f, 8.0f});
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 1, 1, 2}));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({4.0f, 5.0f})));
+}
+
+TEST(ScaledDotProductAttentionOpTest, FloatManyKeyTiles) {
+  constexpr int kBatches = 2, kHeads = 3, kQueryLength = 19, kKeyLength = 150,
+                kDepth = 16, kValueDepth = 8;
+  const std::vector<float> query =
+      Values(kBatches * kHeads * kQueryLength * kDepth, 1);
+  const std::vector<float> key =
+      Values(kBatches * kHeads * kKeyLength * kDepth, 2);
+  const std::vector<float> value =
+      Values(kBatches * kHeads * kKeyLength * kValueDepth, 3);
+  for (int num_threads : {1, 4}) {
+    ScaledDotProductAttentionOpModel<float> m(
+        {TensorType_FLOAT32, {kBatches, kHeads, kQueryLength, kDepth}},
+        {TensorType_FLOAT32, {kBatches, kHeads, kKeyLength, kDepth}},
+        {TensorType_FLOAT32, {kBatches, kHeads, kKeyLength, kValueDepth}},
+        {TensorType_FLOAT32, {}}, /*scale=*/0.25f, /*mask_shape=*/{},
+        num_threads);
+    m.SetInputs(query, key, value);
+    ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+    EXPECT_THAT(m.GetOutputShape(),
+                ElementsAreArray(
+                    {kBatches, kHeads, kQueryLength, kValueDepth}));
+    EXPECT_THAT(m.GetOutput(),
+                ElementsAreArray(ArrayFloatNear(ReferenceAttention(
+                    query, key, value, {}, kBatches, kHeads, kQueryLength,
+                    kKeyLength, kDepth, kValueDepth, 0.25f))));
+  }
+}
+
+TEST(ScaledDotProductAttentionOpTest, FloatBroadcastMask) {
+  constexpr int kBatches = 2, kHeads = 2, kQueryLength = 5, kKeyLength = 70,
+                kDepth = 4, kValueDepth = 3;
+  const std::vector<float> query =
+      Values(kBatches * kHeads * kQueryLength * kDepth, 4);
+  const std::vector<float> key =
+      Values(kBatches * kHeads * kKeyLength * kDepth, 5);
+  const std::vector<float> value =
+      Values(kBatches * kHeads * kKeyLength * kValueDepth, 6);
+  // Masks out every third key of the first batch, and the first keys of the
+  // second one, like Keras attention masks.
+  std::vector<float> mask(kBatches * kKeyLength, 0.0f);
+  for (int j = 0; j < kKeyLength; j += 3) mask[j] = -1e9f;
+  for (int j = 0; j < 40; ++j) mask[kKeyLength + j] = -1e9f;
+  ScaledDotProductAttentionOpModel<float> m(
+      {TensorType_FLOAT32, {kBatches, kHeads, kQueryLength, kDepth}},
+      {TensorType_FLOAT32, {kBatches, kHeads, kKeyLength, kDepth}},
+      {TensorType_FLOAT32, {kBatches, kHeads, kKeyLength, kValueDepth}},
+      {TensorType_FLOAT32, {}}, /*scale=*/0.5f,
+      /*mask_shape=*/{kBatches, 1, 1, kKeyLength});
+  m.SetInputs(query, key, value);
+  m.SetMask(mask);
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(ReferenceAttention(
+                  query, key, value, mask, kBatches, kHeads, kQueryLength,
+                  kKeyLength, kDepth, kValueDepth, 0.5f))));
+}
+
+TEST(ScaledDotProductAttentionOpTest, FloatFullyMaskedRowIsZero) {
+  ScaledDotProductAttentionOpModel<float> m(
+      {TensorType_FLOAT32, {1, 2, 1}}, {TensorType_FLOAT32, {1, 2, 1}},
+      {TensorType_FLOAT32, {1, 2, 1}}, {TensorType_FLOAT32, {}},
+      /*scale=*/1.0f, /*mask_shape=*/{2, 2});
+  m.SetInputs({1.0f, 2.0f}, {1.0f, 1.0f}, {3.0f, 5.0f});
+  const float inf = std::numeric_limits<float>::infinity();
+  m.SetMask({0.0f, 0.0f, -inf, -inf});
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({4.0f, 0.0f})));
+}
+
+TEST(ScaledDotProductAttentionOpTest, Int8) {
+  constexpr int kBatches = 2, kHeads = 2, kQueryLength = 17, kKeyLength = 130,
+                kDepth = 8, kValueDepth = 8;
+  const std::vector<float> query =
+      Values(kBatches * kHeads * kQueryLength * kDepth, 7);
+  const std::vector<float> key =
+      Values(kBatches * kHeads * kKeyLength * kDepth, 8);
+  const std::vector<float> value =
+      Values(kBatches * kHeads * kKeyLength * kValueDepth, 9);
+  ScaledDotProductAttentionOpModel<int8_t> m(
+      {TensorType_INT8, {kBatches, kHeads, kQueryLength, kDepth}, -1.0f, 1.0f},
+      {TensorType_INT8, {kBatches, kHeads, kKeyLength, kDepth}, -1.2f, 1.0f},
+      {TensorType_INT8, {kBatches, kHeads, kKeyLength, kValueDepth}, -1.0f,
+       1.1f},
+      {TensorType_INT8, {}, -1.0f, 1.0f}, /*scale=*/0.5f, /*mask_shape=*/{},
+      /*num_threads=*/3);
+  m.SetInputs(query, key, value);
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  ReferenceAttention(query, key, value, {}, kBatches, kHeads,
+                                     kQueryLength, kKeyLength, kDepth,
+                                     kValueDepth, 0.5f),
+                  /*max_abs_error=*/0.02f)));
+}
+
+TEST(ScaledDotProductAttentionOpTest, Int16) {
+  constexpr int kBatches = 1, kHeads = 2, kQueryLength = 9, kKeyLength = 70,
+                kDepth = 8, kValueDepth = 5;
+  const std::vector<float> query =
+      Values(kBatches * kHeads * kQueryLength * kDepth, 10);
+  const std::vector<float> key =
+      Values(kBatches * kHeads * kKeyLength * kDepth, 11);
+  const std::vector<float> value =
+      Values(kBatches * kHeads * kKeyLength * kValueDepth, 12);
+  const float scale = 1.0f / 32767;
+  ScaledDotProductAttentionOpModel<int16_t> m(
+      {TensorType_INT16, {kBatches, kHeads, kQueryLength, kDepth}, 0.0f, 0.0f,
+       scale, 0},
+      {TensorType_INT16, {kBatches, kHeads, kKeyLength, kDepth}, 0.0f, 0.0f,
+       scale, 0},
+      {TensorType_INT16, {kBatches, kHeads, kKeyLength, kValueDepth}, 0.0f,
+       0.0f, scale, 0},
+      {TensorType_INT16, {}, 0.0f, 0.0f, scale, 0}, /*scale=*/0.35f);
+  m.SetInputs(query, key, value);
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  ReferenceAttention(query, key, value, {}, kBatches, kHeads,
+                                     kQueryLength, kKeyLength, kDepth,
+                                     kValueDepth, 0.35f),
+                  /*max_abs_error=*/1e-3f)));
+}
+
+#ifdef GTEST_HAS_DEATH_TEST
+TEST(ScaledDotProductAttentionOpTest, MismatchedDepth) {
+  EXPECT_DEATH(ScaledDotProductAttentionOpModel<float> m(
+                   {TensorType_FLOAT32, {1, 2, 3}},
+                   {TensorType_FLOAT32, {1, 4, 2}},
+                   {TensorType_FLOAT32, {1, 4, 3}}, {TensorType_FLOAT32, {}},
+                   /*scale=*/1.0f),
+               "SizeOfDimension.key, rank - 1. != "
+               "SizeOfDimension.query, rank - 1. .2 != 3.");
+}
+#endif
+
+}  // namespace
+}  // namespace tflite
@@ -41,6 +41,10 @@ struct OpData {
   // The scratch tensor index.
   int scratch_tensor_index;
   bool compute_row_sums = false;
+  // Whether the float gates are computed with fused gate weights, and whether
+  // these still need to be packed.
+  bool use_fused_gates = false;
+  bool pack_fused_gate_weights = false;
 
   lstm_eval::IntegerLstmParameter integer_lstm_param;
 };
@@ -401,6 +405,43 @@ enum TemporaryTensor {
   kNumTemporaryTensors = 12,
 };
 
+// Temporary tensors of the float op with fused gate weights, which reuse the
+// tensors of the hybrid op at the same index.
+enum FusedGatesTemporaryTensor {
+  kFusedGateWeights = 1,
+  kFusedGateBias = 2,
+  kFusedGateInput = 3,
+  kNumFusedGatesTemporaryTensors = 4,
+};
+
+// Returns whether the float gates of `node` can be computed with fused gate
+// weights. These are packed once, so the weights and biases of the gates must
+// be constant, and the sequence must be stepped one batch at a time.
+bool CanUseFusedGates(TfLiteContext* context, TfLiteNode* node,
+                      bool time_major, int n_batch) {
+  if (time_major && n_batch != 1) return false;
+  for (int index : {lstm::full::kInputToInputWeightsTensor,
+                    lstm::full::kInputToForgetWeightsTensor,
+                    lstm::full::kInputToCellWeightsTensor,
+                    lstm::full::kInputToOutputWeightsTensor,
+                    lstm::full::kRecurrentToInputWeightsTensor,
+                    lstm::full::kRecurrentToForgetWeightsTensor,
+                    lstm::full::kRecurrentToCellWeightsTensor,
+                    lstm::full::kRecurrentToOutputWeightsTensor,
+                    lstm::full::kInputGateBiasTensor,
+                    lstm::full::kForgetGateBiasTensor,
+                    lstm::full::kCellGateBiasTensor,
+                    lstm::full::kOutputGateBiasTensor}) {
+    const TfLiteTensor* tensor = GetOptionalInputTensor(context, node, index);
+    // The input gate tensors are missing with CIFG.
+    if (tensor == nullptr) continue;
+    if (tensor->type != kTfLiteFloat32 || !IsConstantTensor(tensor)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   auto* op_data = new OpData();
   context->AddTensors(context, kNumTemporaryTensors,
@@ -947,11 +988,18 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE(context, num_intermediate_tensors == 5);
   }
 
+  op_data->use_fused_gates =
+      input->type == kTfLiteFloat32 &&
+      input_to_output_weights->type == kTfLiteFloat32 &&
+      CanUseFusedGates(context, node, time_major, n_batch);
+
   TfLiteIntArrayFree(node->temporaries);
   if (IsHybridOp(input, input_to_output_weights)) {
     node->temporaries = TfLiteIntArrayCreate(kNumTemporaryTensors);
   } else if (is_integer) {
     node->temporaries = TfLiteIntArrayCreate(6);
+  } else if (op_data->use_fused_gates) {
+    node->temporaries = TfLiteIntArrayCreate(kNumFusedGatesTemporaryTensors);
   } else {
     node->temporaries = TfLiteIntArrayCreate(1);
   }
@@ -1165,6 +1213,60 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
+  if (op_data->use_fused_gates) {
+    op_data->pack_fused_gate_weights = true;
+    const int n_gates = use_cifg ? 3 : 4;
+    node->temporaries->data[kFusedGateWeights] =
+        scratch_tensor_index + kFusedGateWeights;
+    TfLiteTensor* fused_gate_weights;
+    TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node,
+                                                kFusedGateWeights,
+                                                &fused_gate_weights));
+    fused_gate_weights->type = kTfLiteFloat32;
+    fused_gate_weights->allocation_type = kTfLiteArenaRwPersistent;
+    const int fused_gate_weights_dims[2] = {n_gates * n_cell,
+                                            n_input + n_output};
+    if (!TfLiteIntArrayEqualsArray(fused_gate_weights->dims, 2,
+                                   fused_gate_weights_dims)) {
+      TfLiteIntArray* fused_gate_weights_size = TfLiteIntArrayCreate(2);
+      fused_gate_weights_size->data[0] = fused_gate_weights_dims[0];
+      fused_gate_weights_size->data[1] = fused_gate_weights_dims[1];
+      TF_LITE_ENSURE_OK(context,
+                        context->ResizeTensor(context, fused_gate_weights,
+                                              fused_gate_weights_size));
+    }
+    node->temporaries->data[kFusedGateBias] =
+        scratch_tensor_index + kFusedGateBias;
+    TfLiteTensor* fused_gate_bias;
+    TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node, kFusedGateBias,
+                                                &fused_gate_bias));
+    fused_gate_bias->type = kTfLiteFloat32;
+    fused_gate_bias->allocation_type = kTfLiteArenaRwPersistent;
+    const int fused_gate_bias_dims[1] = {n_gates * n_cell};
+    if (!TfLiteIntArrayEqualsArray(fused_gate_bias->dims, 1,
+                                   fused_gate_bias_dims)) {
+      TfLiteIntArray* fused_gate_bias_size = TfLiteIntArrayCreate(1);
+      fused_gate_bias_size->data[0] = fused_gate_bias_dims[0];
+      TF_LITE_ENSURE_OK(context,
+                        context->ResizeTensor(context, fused_gate_bias,
+                                              fused_gate_bias_size));
+    }
+    node->temporaries->data[kFusedGateInput] =
+        scratch_tensor_index + kFusedGateInput;
+    TfLiteTensor* fused_input;
+    TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node, kFusedGateInput,
+                                                &fused_input));
+    fused_input->type = kTfLiteFloat32;
+    fused_input->allocation_type = kTfLiteArenaRw;
+    const int fused_input_dims[1] = {n_input + n_output};
+    if (!TfLiteIntArrayEqualsArray(fused_input->dims, 1, fused_input_dims)) {
+      TfLiteIntArray* fused_input_size = TfLiteIntArrayCreate(1);
+      fused_input_size->data[0] = fused_input_dims[0];
+      TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, fused_input,
+                                                       fused_input_size));
+    }
+  }
+
   if (is_integer) {
     // Integer UnidirectionalSequenceLSTM prepare function for 8x8->16.
     // This code path needs 5 intermediate tensors per Op.
@@ -1326,6 +1428,41 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       TfLiteTensor* scratch_buffer;
       TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node, kScratchBuffer,
                                                   &scratch_buffer));
+      OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+      if (op_data->use_fused_gates) {
+        TfLiteTensor* fused_gate_weights;
+        TF_LITE_ENSURE_OK(context,
+                          GetTemporarySafe(context, node, kFusedGateWeights,
+                                           &fused_gate_weights));
+        TfLiteTensor* fused_gate_bias;
+        TF_LITE_ENSURE_OK(context,
+                          GetTemporarySafe(context, node, kFusedGateBias,
+                                           &fused_gate_bias));
+        TfLiteTensor* fused_input;
+        TF_LITE_ENSURE_OK(context,
+                          GetTemporarySafe(context, node, kFusedGateInput,
+                                           &fused_input));
+        if (op_data->pack_fused_gate_weights) {
+          lstm_eval::PackFusedGateWeightsFloat(
+              input_to_input_weights, input_to_forget_weights,
+              input_to_cell_weights, input_to_output_weights,
+              recurrent_to_input_weights, recurrent_to_forget_weights,
+              recurrent_to_cell_weights, recurrent_to_output_weights,
+              input_gate_bias, forget_gate_bias, cell_gate_bias,
+              output_gate_bias, fused_gate_weights, fused_gate_bias);
+          op_data->pack_fused_gate_weights = false;
+        }
+        return lstm_eval::EvalFloatFusedGates(
+            input, fused_gate_weights, fused_gate_bias, cell_to_input_weights,
+            cell_to_forget_weights, cell_to_output_weights,
+            input_layer_norm_coefficients, forget_layer_norm_coefficients,
+            cell_layer_norm_coefficients, output_layer_norm_coefficients,
+            input_gate_bias, forget_gate_bias, cell_gate_bias,
+            output_gate_bias, projection_weights, projection_bias,
+            &lstm_params, /*use_cifg=*/input_to_input_weights == nullptr,
+            time_major, fused_input, scratch_buffer, output_state, cell_state,
+            output, CpuBackendContext::GetFromContext(context));
+      }
       return lstm_eval::EvalFloat(
           input, input_to_input_weights, input_to_forget_weights,
           input_to_cell_weights, input_to_output_weights,
@@ -2739,6 +2739,159 @@ TEST_F(CifgPeepholeNoProjectionNoClippingUnidirectionalLstmTest,
   VerifyGoldens(lstm_input_, lstm_golden_output_, &lstm);
 }
 
+// The LSTM of NoCifgNoPeepholeNoProjectionNoClippingUnidirectionalLstmTest,
+// with constant weights so that its gates are computed with fused weights.
+class ConstWeightsUnidirectionalLSTMOpModel : public SingleOpModel {
+ public:
+  ConstWeightsUnidirectionalLSTMOpModel(int n_batch, int sequence_length,
+                                        bool time_major) {
+    const int n_input = 2;
+    const int n_cell = 4;
+    const int n_output = 4;
+    if (time_major) {
+      input_ = AddInput({TensorType_FLOAT32,
+                         {sequence_length, n_batch, n_input}});
+    } else {
+      input_ = AddInput({TensorType_FLOAT32,
+                         {n_batch, sequence_length, n_input}});
+    }
+
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.45018822, -0.02338299, -0.0870589, -0.34550029,
+                   0.04266912, -0.15680569, -0.34856534, 0.43890524},
+                  {n_cell, n_input});
+    AddConstInput(TensorType_FLOAT32,
+                  {0.09701663, 0.20334584, -0.50592935, -0.31343272,
+                   -0.40032279, 0.44781327, 0.01387155, -0.35593212},
+                  {n_cell, n_input});
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.50013041, 0.1370284, 0.11810488, 0.2013163,
+                   -0.20583314, 0.44344562, 0.22077113, -0.29909778},
+                  {n_cell, n_input});
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.25065863, -0.28290087, 0.04613829, 0.40525138,
+                   0.44272184, 0.03897077, -0.1556896, 0.19487578},
+                  {n_cell, n_input});
+
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.0063535, -0.2042388, 0.31454784, -0.35746509,
+                   0.28902304, 0.08183324, -0.16555229, 0.02286911,
+                   -0.13566875, 0.03034258, 0.48091322, -0.12528998,
+                   0.24077177, -0.51332325, -0.33502164, 0.10629296},
+                  {n_cell, n_output});
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.48684245, -0.06655136, 0.42224967, 0.2112639,
+                   0.27654213, 0.20864892, -0.07646349, 0.45877004,
+                   0.00141793, -0.14609534, 0.36447752, 0.09196436,
+                   0.28053468, 0.01560611, -0.20127171, -0.01140004},
+                  {n_cell, n_output});
+    AddConstInput(TensorType_FLOAT32,
+                  {-0.3407414, 0.24443203, -0.2078532, 0.26320225,
+                   0.05695659, -0.00123841, -0.4744786, -0.35869038,
+                   -0.06418842, -0.13502428, -0.501764, 0.22830659,
+                   -0.46367589, 0.26016325, -0.03894562, -0.16368064},
+                  {n_cell, n_output});
+    AddConstInput(TensorType_FLOAT32,
+                  {0.43385774, -0.17194885, 0.2718237, 0.09215671,
+                   0.24107647, -0.39835793, 0.18212086, 0.01301402,
+                   0.48572797, -0.50656658, 0.20047462, -0.20607421,
+                   -0.51818722, -0.15390486, 0.0468148, 0.39922136},
+                  {n_cell, n_output});
+
+    // Peephole weights.
+    AddNullInput();
+    AddNullInput();
+    AddNullInput();
+
+    AddConstInput(TensorType_FLOAT32, {0., 0., 0., 0.}, {n_cell});
+    AddConstInput(TensorType_FLOAT32, {1., 1., 1., 1.}, {n_cell});
+    AddConstInput(TensorType_FLOAT32, {0., 0., 0., 0.}, {n_cell});
+    AddConstInput(TensorType_FLOAT32, {0., 0., 0., 0.}, {n_cell});
+
+    // Projection weights and bias.
+    AddNullInput();
+    AddNullInput();
+
+    AddVariableInput(TensorData{TensorType_FLOAT32, {n_batch, n_output}});
+    AddVariableInput(TensorData{TensorType_FLOAT32, {n_batch, n_cell}});
+
+    output_ = AddOutput(TensorType_FLOAT32);
+
+    SetBuiltinOp(BuiltinOperator_UNIDIRECTIONAL_SEQUENCE_LSTM,
+                 BuiltinOptions_UnidirectionalSequenceLSTMOptions,
+                 CreateUnidirectionalSequenceLSTMOptions(
+                     builder_, ActivationFunctionType_TANH, /*cell_clip=*/0.0,
+                     /*proj_clip=*/0.0, time_major)
+                     .Union());
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int output_;
+};
+
+// The input and golden output of
+// NoCifgNoPeepholeNoProjectionNoClippingUnidirectionalLstmTest.
+const std::vector<float>& ConstWeightsLstmInput() {
+  static const auto* input = new std::vector<float>({2., 3., 3., 4., 1., 1.});
+  return *input;
+}
+
+const std::vector<float>& ConstWeightsLstmGoldenOutput() {
+  static const auto* output = new std::vector<float>(
+      {-0.02973187, 0.1229473, 0.20885126, -0.15358765, -0.03716109,
+       0.12507336, 0.41193449, -0.20860538, -0.15053082, 0.09120187,
+       0.24278517, -0.12222792});
+  return *output;
+}
+
+TEST(ConstWeightsUnidirectionalLstmTest, TimeMajorSequence) {
+  ConstWeightsUnidirectionalLSTMOpModel lstm(/*n_batch=*/1,
+                                             /*sequence_length=*/3,
+                                             /*time_major=*/true);
+  lstm.SetInput(ConstWeightsLstmInput());
+  ASSERT_EQ(lstm.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_THAT(lstm.GetOutput(), ElementsAreArray(ArrayFloatNear(
+                                    ConstWeightsLstmGoldenOutput(), 1e-5)));
+}
+
+TEST(ConstWeightsUnidirectionalLstmTest, BatchMajorSequences) {
+  ConstWeightsUnidirectionalLSTMOpModel lstm(/*n_batch=*/2,
+                                             /*sequence_length=*/3,
+                                             /*time_major=*/false);
+  std::vector<float> input = ConstWeightsLstmInput();
+  input.insert(input.end(), input.begin(), input.end());
+  lstm.SetInput(input);
+  ASSERT_EQ(lstm.InvokeUnchecked(), kTfLiteOk);
+  std::vector<float> expected = ConstWeightsLstmGoldenOutput();
+  expected.insert(expected.end(), expected.begin(), expected.end());
+  EXPECT_THAT(lstm.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(expected, 1e-5)));
+}
+
+TEST(ConstWeightsUnidirectionalLstmTest, StreamsOneFrameAtATime) {
+  ConstWeightsUnidirectionalLSTMOpModel lstm(/*n_batch=*/1,
+                                             /*sequence_length=*/1,
+                                             /*time_major=*/true);
+  const std::vector<float>& input = ConstWeightsLstmInput();
+  const std::vector<float>& golden = ConstWeightsLstmGoldenOutput();
+  // The state is kept in the variable tensors between invocations.
+  for (int frame = 0; frame < 3; ++frame) {
+    lstm.SetInput({input[frame * 2], input[frame * 2 + 1]});
+    ASSERT_EQ(lstm.InvokeUnchecked(), kTfLiteOk);
+    EXPECT_THAT(lstm.GetOutput(),
+                ElementsAreArray(ArrayFloatNear(
+                    std::vector<float>(golden.begin() + frame * 4,
+                                       golden.begin() + (frame + 1) * 4),
+                    1e-5)));
+  }
+}
+
 class UnidirectionalSequenceLSTMIntegerOpModel : public SingleOpModel {
  public:
   UnidirectionalSequenceLSTMIntegerOpModel(
@@ -65,6 +65,13 @@ class MemoryPlanner {
   // Dumps the memory planning information against the specified op node
   // execution plan (i.e. `execution_plan`) for the purpose of debugging.
   virtual void DumpDebugInfo(const std::vector<int>& execution_plan) const = 0;
+
+  // Sets the level of each node in the execution plan, where the nodes of a
+  // level run at the same time. The levels must not decrease along the
+  // execution plan. Planners that share memory between tensors must not share
+  // it between tensors used in the same level. An empty vector runs each node
+  // on its own. Takes effect from the next call to PlanAllocations().
+  virtual void SetConcurrentLevels(const std::vector<int>& levels) {}
 };
 
 }  // namespace tflite
@@ -0,0 +1,199 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_counter_profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tflite {
+namespace profiling {
+
+namespace {
+
+constexpr uint64_t kCacheLineBytes = 64;
+
+#if defined(__linux__)
+int OpenCounter(uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.disabled = group_fd < 0 ? 1 : 0;
+  // Counting the user space only is permitted at the default paranoia level
+  // of Android.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, /*pid=*/0,
+                                  /*cpu=*/-1, group_fd, /*flags=*/0));
+}
+#endif
+
+}  // namespace
+
+uint64_t OpPerfCounters::EstimatedBytesRead() const {
+  return cache_misses * kCacheLineBytes;
+}
+
+double OpPerfCounters::OperationalIntensity() const {
+  const uint64_t bytes = EstimatedBytesRead();
+  // Without cache misses, the operator runs out of the caches.
+  if (bytes == 0) return static_cast<double>(instructions);
+  return static_cast<double>(instructions) / bytes;
+}
+
+PerfCounterProfiler::PerfCounterProfiler(uint32_t max_num_entries)
+    : BufferedProfiler(max_num_entries) {
+#if defined(__linux__)
+  group_fd_ = OpenCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (group_fd_ < 0) return;
+  member_fds_[0] = OpenCounter(PERF_COUNT_HW_INSTRUCTIONS, group_fd_);
+  member_fds_[1] = OpenCounter(PERF_COUNT_HW_CACHE_MISSES, group_fd_);
+  if (member_fds_[0] < 0 || member_fds_[1] < 0) {
+    for (int& fd : member_fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+    close(group_fd_);
+    group_fd_ = -1;
+    return;
+  }
+  ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounterProfiler::~PerfCounterProfiler() {
+#if defined(__linux__)
+  for (int fd : member_fds_) {
+    if (fd >= 0) close(fd);
+  }
+  if (group_fd_ >= 0) close(group_fd_);
+#endif
+}
+
+bool PerfCounterProfiler::ReadCounters(uint64_t values[3]) const {
+#if defined(__linux__)
+  // The group is read at once: the number of counters, then their values.
+  uint64_t data[4];
+  if (read(group_fd_, data, sizeof(data)) != sizeof(data) || data[0] != 3) {
+    return false;
+  }
+  std::copy(data + 1, data + 4, values);
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint32_t PerfCounterProfiler::BeginEvent(const char* tag, EventType event_type,
+                                         int64_t event_metadata1,
+                                         int64_t event_metadata2) {
+  const uint32_t event_handle = BufferedProfiler::BeginEvent(
+      tag, event_type, event_metadata1, event_metadata2);
+  if (event_handle == kInvalidEventHandle || !HasCounters() ||
+      event_type != EventType::OPERATOR_INVOKE_EVENT) {
+    return event_handle;
+  }
+  Snapshot snapshot;
+  snapshot.op = {event_metadata2, event_metadata1};
+  snapshot.tag = tag;
+  // Read last, so that the profiler's own work is counted as little as
+  // possible.
+  if (ReadCounters(snapshot.values)) {
+    pending_[event_handle] = snapshot;
+  }
+  return event_handle;
+}
+
+void PerfCounterProfiler::EndEvent(uint32_t event_handle) {
+  EndOperatorEvent(event_handle);
+  BufferedProfiler::EndEvent(event_handle);
+}
+
+void PerfCounterProfiler::EndEvent(uint32_t event_handle,
+                                   int64_t event_metadata1,
+                                   int64_t event_metadata2) {
+  EndOperatorEvent(event_handle);
+  BufferedProfiler::EndEvent(event_handle, event_metadata1, event_metadata2);
+}
+
+void PerfCounterProfiler::EndOperatorEvent(uint32_t event_handle) {
+  if (pending_.empty()) return;
+  uint64_t values[3];
+  // Read first, for the same reason as in BeginEvent.
+  if (!ReadCounters(values)) return;
+  auto it = pending_.find(event_handle);
+  if (it == pending_.end()) return;
+  const Snapshot& snapshot = it->second;
+  OpPerfCounters& counters = op_counters_[snapshot.op];
+  if (counters.num_invocations == 0) counters.tag = snapshot.tag;
+  ++counters.num_invocations;
+  counters.cycles += values[0] - snapshot.values[0];
+  counters.instructions += values[1] - snapshot.values[1];
+  counters.cache_misses += values[2] - snapshot.values[2];
+  pending_.erase(it);
+}
+
+std::string PerfCounterProfiler::GetOutputString(double ridge_point) const {
+  std::vector<std::pair<std::pair<int64_t, int64_t>, const OpPerfCounters*>>
+      ops;
+  for (const auto& op : op_counters_) ops.emplace_back(op.first, &op.second);
+  std::sort(ops.begin(), ops.end(), [](const auto& a, const auto& b) {
+    return a.second->cycles > b.second->cycles;
+  });
+
+  std::stringstream stream;
+  char line[256];
+  snprintf(line, sizeof(line), "%-24s %12s %14s %14s %14s %8s %10s %6s %s\n",
+           "[node type]", "[node]", "[avg cycles]", "[avg instrs]",
+           "[avg misses]", "[IPC]", "[instr/B]", "[%]", "[bound]");
+  stream << line;
+  uint64_t total_cycles = 0;
+  for (const auto& op : ops) total_cycles += op.second->cycles;
+  for (const auto& op : ops) {
+    const OpPerfCounters& counters = *op.second;
+    const double n = counters.num_invocations;
+    const std::string node =
+        std::to_string(op.first.first) + ":" + std::to_string(op.first.second);
+    const double intensity = counters.OperationalIntensity();
+    snprintf(line, sizeof(line),
+             "%-24s %12s %14.0f %14.0f %14.0f %8.2f %10.2f %5.1f%% %s\n",
+             counters.tag.c_str(), node.c_str(), counters.cycles / n,
+             counters.instructions / n, counters.cache_misses / n,
+             counters.cycles == 0
+                 ? 0.0
+                 : static_cast<double>(counters.instructions) / counters.cycles,
+             intensity,
+             total_cycles == 0 ? 0.0 : 100.0 * counters.cycles / total_cycles,
+             intensity < ridge_point ? "memory" : "compute");
+    stream << line;
+  }
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
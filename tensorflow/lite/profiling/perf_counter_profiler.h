@@ -0,0 +1,102 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_COUNTER_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_COUNTER_PROFILER_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// The hardware counters of the invocations of an operator.
+struct OpPerfCounters {
+  std::string tag;
+  int64_t num_invocations = 0;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+
+  // The bytes read from memory, estimated as one cache line per last level
+  // cache miss.
+  uint64_t EstimatedBytesRead() const;
+  // Instructions per estimated byte read from memory.
+  double OperationalIntensity() const;
+};
+
+// A BufferedProfiler that also reads the cycle, instruction and last level
+// cache miss counters of the CPU around each operator invocation, through
+// Linux perf events. The counters only count the invoking thread, so the work
+// of the threads of multi-threaded kernels is missed; run with a single thread
+// to measure all of it.
+//
+// The counters are unavailable when perf events are not supported or not
+// permitted, e.g. by /proc/sys/kernel/perf_event_paranoid, in which case the
+// profiler only records events like a BufferedProfiler.
+class PerfCounterProfiler : public BufferedProfiler {
+ public:
+  explicit PerfCounterProfiler(uint32_t max_num_entries);
+  ~PerfCounterProfiler() override;
+
+  bool HasCounters() const { return group_fd_ >= 0; }
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override;
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  // The counters of each operator, keyed by subgraph and node index. The
+  // counters accumulate over all runs until ResetCounters is called, unlike
+  // the events that Reset clears.
+  const std::map<std::pair<int64_t, int64_t>, OpPerfCounters>& GetOpCounters()
+      const {
+    return op_counters_;
+  }
+  void ResetCounters() { op_counters_.clear(); }
+
+  // Formats a table of the operators in decreasing cycle order, classifying
+  // each operator as memory bound when its operational intensity is below
+  // `ridge_point`, the instructions per byte at which the CPU reaches its
+  // peak instruction rate at its peak memory bandwidth.
+  std::string GetOutputString(double ridge_point) const;
+
+ private:
+  struct Snapshot {
+    std::pair<int64_t, int64_t> op;
+    const char* tag;
+    uint64_t values[3];
+  };
+
+  // Reads the cycles, instructions and cache misses.
+  bool ReadCounters(uint64_t values[3]) const;
+  void EndOperatorEvent(uint32_t event_handle);
+
+  int group_fd_ = -1;
+  int member_fds_[2] = {-1, -1};
+  std::unordered_map<uint32_t, Snapshot> pending_;
+  std::map<std::pair<int64_t, int64_t>, OpPerfCounters> op_counters_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_COUNTER_PROFILER_H_
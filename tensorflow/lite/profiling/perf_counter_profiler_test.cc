@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_counter_profiler.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Reads a buffer larger than the last level cache of most CPUs.
+int64_t ReadBuffer() {
+  static std::vector<int64_t>* buffer = new std::vector<int64_t>(1 << 23, 1);
+  int64_t sum = 0;
+  for (int64_t value : *buffer) sum += value;
+  return sum;
+}
+
+void InvokeOp(Profiler* profiler, const char* tag, int64_t node_index) {
+  const uint32_t handle = profiler->BeginEvent(
+      tag, Profiler::EventType::OPERATOR_INVOKE_EVENT, node_index,
+      /*event_metadata2=*/0);
+  volatile int64_t sum = ReadBuffer();
+  (void)sum;
+  profiler->EndEvent(handle);
+}
+
+TEST(PerfCounterProfilerTest, RecordsEvents) {
+  PerfCounterProfiler profiler(1024);
+  profiler.StartProfiling();
+  InvokeOp(&profiler, "ADD", 0);
+  profiler.StopProfiling();
+  auto events = profiler.GetProfileEvents();
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0]->tag, "ADD");
+}
+
+TEST(PerfCounterProfilerTest, CountsOperators) {
+  PerfCounterProfiler profiler(1024);
+  if (!profiler.HasCounters()) {
+    GTEST_SKIP() << "Perf events are unavailable.";
+  }
+  profiler.StartProfiling();
+  InvokeOp(&profiler, "ADD", 0);
+  InvokeOp(&profiler, "ADD", 0);
+  InvokeOp(&profiler, "MUL", 1);
+  const uint32_t handle = profiler.BeginEvent(
+      "Invoke", Profiler::EventType::DEFAULT, 0, 0);
+  profiler.EndEvent(handle);
+  profiler.StopProfiling();
+  // Not counted while profiling is stopped.
+  InvokeOp(&profiler, "MUL", 1);
+
+  const auto& op_counters = profiler.GetOpCounters();
+  ASSERT_EQ(op_counters.size(), 2);
+  const OpPerfCounters& add = op_counters.at({0, 0});
+  EXPECT_EQ(add.tag, "ADD");
+  EXPECT_EQ(add.num_invocations, 2);
+  EXPECT_GT(add.cycles, 0);
+  EXPECT_GT(add.instructions, 0);
+  EXPECT_EQ(op_counters.at({0, 1}).num_invocations, 1);
+
+  const std::string output = profiler.GetOutputString(/*ridge_point=*/1.0);
+  EXPECT_THAT(output, HasSubstr("ADD"));
+  EXPECT_THAT(output, HasSubstr("MUL"));
+
+  // The counters accumulate over the runs.
+  profiler.Reset();
+  EXPECT_EQ(profiler.GetOpCounters().size(), 2);
+  profiler.ResetCounters();
+  EXPECT_TRUE(profiler.GetOpCounters().empty());
+}
+
+TEST(PerfCounterProfilerTest, OperationalIntensity) {
+  OpPerfCounters counters;
+  counters.instructions = 1280;
+  counters.cache_misses = 10;
+  EXPECT_EQ(counters.EstimatedBytesRead(), 640);
+  EXPECT_DOUBLE_EQ(counters.OperationalIntensity(), 2.0);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
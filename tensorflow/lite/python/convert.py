@@ -452,6 +452,7 @@ def build_toco_flags(inference_type=dtypes.float32,
                      unfold_large_splat_constant=False,
                      supported_backends=None,
                      disable_per_channel_quantization=False,
+                     fuse_attention=False,
                      **_):
   """Build the TOCO flags object from params."""
   toco = _toco_flags_pb2.TocoFlags()
@@ -497,6 +498,7 @@ def build_toco_flags(inference_type=dtypes.float32,
   if supported_backends:
     toco.supported_backends.extend(supported_backends)
   toco.disable_per_channel_quantization = disable_per_channel_quantization
+  toco.fuse_attention = fuse_attention
   return toco
 
 
@@ -534,7 +536,8 @@ def build_toco_convert_protos(input_tensors,
                               allow_bfloat16=False,
                               unfold_large_splat_constant=False,
                               supported_backends=None,
-                              disable_per_channel_quantization=False):
+                              disable_per_channel_quantization=False,
+                              fuse_attention=False):
   """Builds protocol buffers describing a conversion of a model using TOCO.
 
   Typically this is to convert from TensorFlow GraphDef to TFLite, in which
@@ -630,6 +633,8 @@ def build_toco_convert_protos(input_tensors,
       compatibility.
     disable_per_channel_quantization: Disable per-channel quantized weights for
       dynamic range quantization. Only per-tensor quantization will be used.
+    fuse_attention: Whether to fuse scaled dot-product attention into the
+      ScaledDotProductAttention custom op, which is kept in float.
 
   Returns:
     model_flags, toco_flags, debug_info: three protocol buffers describing the
@@ -666,7 +671,8 @@ def build_toco_convert_protos(input_tensors,
       allow_bfloat16=allow_bfloat16,
       unfold_large_splat_constant=unfold_large_splat_constant,
       supported_backends=supported_backends,
-      disable_per_channel_quantization=disable_per_channel_quantization)
+      disable_per_channel_quantization=disable_per_channel_quantization,
+      fuse_attention=fuse_attention)
   model = _model_flags_pb2.ModelFlags()
   model.change_concat_input_ranges = change_concat_input_ranges
   for idx, input_tensor in enumerate(input_tensors):
@@ -472,6 +472,7 @@ class TFLiteConverterBase(object):
     self._experimental_lower_tensor_list_ops = True
     self._experimental_default_to_single_batch_in_tensor_list_ops = False
     self._experimental_unfold_large_splat_constant = False
+    self._experimental_fuse_attention = False
 
   def _grappler_config(self, optimizers=None):
     """Creates a tf.compat.v1.ConfigProto for configuring Grappler.
@@ -571,6 +572,8 @@ class TFLiteConverterBase(object):
             self._experimental_lower_tensor_list_ops,
         "unfold_large_splat_constant":
             self._experimental_unfold_large_splat_constant,
+        "fuse_attention":
+            self._experimental_fuse_attention,
         "default_to_single_batch_in_tensor_list_ops":
             self._experimental_default_to_single_batch_in_tensor_list_ops,
     }
@@ -0,0 +1,219 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shape_bucketed_runner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+
+namespace tflite {
+
+namespace {
+
+bool HasFixedSizeType(const TfLiteTensor& tensor) {
+  return tensor.type != kTfLiteString && tensor.type != kTfLiteResource &&
+         tensor.type != kTfLiteVariant;
+}
+
+// The layout of a tensor around its bucketed dimension: `outer` slices, each
+// holding the entries along the dimension, of `entry_bytes` each.
+struct BucketedLayout {
+  size_t outer = 1;
+  size_t entry_bytes = 0;
+};
+
+BucketedLayout GetBucketedLayout(const TfLiteTensor& tensor, int dim) {
+  BucketedLayout layout;
+  for (int i = 0; i < dim; ++i) {
+    layout.outer *= tensor.dims->data[i];
+  }
+  const size_t slice_entries = layout.outer * tensor.dims->data[dim];
+  if (slice_entries > 0) {
+    layout.entry_bytes = tensor.bytes / slice_entries;
+  }
+  return layout;
+}
+
+}  // namespace
+
+std::unique_ptr<ShapeBucketedRunner> ShapeBucketedRunner::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const ShapeBucketedRunnerOptions& options) {
+  ErrorReporter* reporter = model.error_reporter();
+  if (options.bucket_sizes.empty() || options.bucketed_dim < 0) {
+    TF_LITE_REPORT_ERROR(reporter,
+                         "Bucket sizes and a non-negative bucketed dimension "
+                         "are required.");
+    return nullptr;
+  }
+  std::vector<int> sizes = options.bucket_sizes;
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  if (sizes.front() <= 0) {
+    TF_LITE_REPORT_ERROR(reporter, "Bucket sizes must be positive.");
+    return nullptr;
+  }
+
+  std::vector<Bucket> buckets;
+  buckets.reserve(sizes.size());
+  for (int size : sizes) {
+    Bucket bucket;
+    bucket.size = size;
+    InterpreterBuilder builder(model, op_resolver);
+    if (builder(&bucket.interpreter, options.num_threads) != kTfLiteOk) {
+      return nullptr;
+    }
+    const char* signature_key = options.signature_key;
+    if (signature_key == nullptr) {
+      const auto& keys = bucket.interpreter->signature_keys();
+      if (keys.size() != 1) {
+        TF_LITE_REPORT_ERROR(reporter,
+                             "A signature key is required for models with %d "
+                             "signatures.",
+                             static_cast<int>(keys.size()));
+        return nullptr;
+      }
+      signature_key = keys[0]->c_str();
+    }
+    bucket.runner = bucket.interpreter->GetSignatureRunner(signature_key);
+    if (bucket.runner == nullptr) {
+      TF_LITE_REPORT_ERROR(reporter, "Signature %s was not found.",
+                           signature_key);
+      return nullptr;
+    }
+    for (const char* name : bucket.runner->input_names()) {
+      const TfLiteTensor* tensor = bucket.runner->input_tensor(name);
+      if (!HasFixedSizeType(*tensor)) {
+        TF_LITE_REPORT_ERROR(reporter, "Input %s cannot be bucketed.", name);
+        return nullptr;
+      }
+      if (tensor->dims->size <= options.bucketed_dim) continue;
+      std::vector<int> dims(tensor->dims->data,
+                            tensor->dims->data + tensor->dims->size);
+      dims[options.bucketed_dim] = size;
+      if (bucket.runner->ResizeInputTensor(name, dims) != kTfLiteOk) {
+        return nullptr;
+      }
+    }
+    if (bucket.runner->AllocateTensors() != kTfLiteOk) {
+      return nullptr;
+    }
+    buckets.push_back(std::move(bucket));
+  }
+  return std::unique_ptr<ShapeBucketedRunner>(
+      new ShapeBucketedRunner(options.bucketed_dim, std::move(buckets)));
+}
+
+ShapeBucketedRunner::ShapeBucketedRunner(int bucketed_dim,
+                                         std::vector<Bucket> buckets)
+    : bucketed_dim_(bucketed_dim), buckets_(std::move(buckets)) {}
+
+TfLiteStatus ShapeBucketedRunner::SetInputSize(int size) {
+  auto it = std::lower_bound(
+      buckets_.begin(), buckets_.end(), size,
+      [](const Bucket& bucket, int value) { return bucket.size < value; });
+  if (size <= 0 || it == buckets_.end()) {
+    TF_LITE_REPORT_ERROR(error_reporter(),
+                         "Input size %d does not fit in any bucket, the "
+                         "largest holds %d.",
+                         size, buckets_.back().size);
+    return kTfLiteError;
+  }
+  current_ = &*it;
+  input_size_ = size;
+  return kTfLiteOk;
+}
+
+TfLiteStatus ShapeBucketedRunner::SetInput(const char* input_name,
+                                           const void* data) {
+  if (current_ == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "SetInputSize() was not called.");
+    return kTfLiteError;
+  }
+  TfLiteTensor* tensor = current_->runner->input_tensor(input_name);
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "Input %s was not found.",
+                         input_name);
+    return kTfLiteError;
+  }
+  if (tensor->dims->size <= bucketed_dim_) {
+    std::memcpy(tensor->data.raw, data, tensor->bytes);
+    return kTfLiteOk;
+  }
+  const BucketedLayout layout = GetBucketedLayout(*tensor, bucketed_dim_);
+  const size_t src_bytes = layout.entry_bytes * input_size_;
+  const size_t dst_bytes = layout.entry_bytes * current_->size;
+  const char* src = static_cast<const char*>(data);
+  char* dst = tensor->data.raw;
+  for (size_t i = 0; i < layout.outer; ++i) {
+    std::memcpy(dst, src, src_bytes);
+    std::memset(dst + src_bytes, 0, dst_bytes - src_bytes);
+    src += src_bytes;
+    dst += dst_bytes;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus ShapeBucketedRunner::Invoke() {
+  if (current_ == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "SetInputSize() was not called.");
+    return kTfLiteError;
+  }
+  return current_->runner->Invoke();
+}
+
+TfLiteStatus ShapeBucketedRunner::GetOutput(const char* output_name,
+                                            void* data) const {
+  if (current_ == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "SetInputSize() was not called.");
+    return kTfLiteError;
+  }
+  const TfLiteTensor* tensor = current_->runner->output_tensor(output_name);
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "Output %s was not found.",
+                         output_name);
+    return kTfLiteError;
+  }
+  if (!HasFixedSizeType(*tensor)) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "Output %s cannot be copied.",
+                         output_name);
+    return kTfLiteError;
+  }
+  if (tensor->dims->size <= bucketed_dim_ ||
+      tensor->dims->data[bucketed_dim_] != current_->size) {
+    std::memcpy(data, tensor->data.raw, tensor->bytes);
+    return kTfLiteOk;
+  }
+  const BucketedLayout layout = GetBucketedLayout(*tensor, bucketed_dim_);
+  const size_t src_bytes = layout.entry_bytes * current_->size;
+  const size_t dst_bytes = layout.entry_bytes * input_size_;
+  const char* src = tensor->data.raw;
+  char* dst = static_cast<char*>(data);
+  for (size_t i = 0; i < layout.outer; ++i) {
+    std::memcpy(dst, src, dst_bytes);
+    src += src_bytes;
+    dst += dst_bytes;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,137 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_SHAPE_BUCKETED_RUNNER_H_
+#define TENSORFLOW_LITE_SHAPE_BUCKETED_RUNNER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+
+struct ShapeBucketedRunnerOptions {
+  /// The signature to run. When nullptr, the model must have exactly one
+  /// signature.
+  const char* signature_key = nullptr;
+  /// The dimension of the inputs whose size changes between invocations, e.g.
+  /// the sequence length of an NLP model. Inputs of a lower rank are not
+  /// bucketed.
+  int bucketed_dim = 1;
+  /// Sizes of `bucketed_dim` the runner keeps prepared interpreters for.
+  /// Required.
+  std::vector<int> bucket_sizes;
+  /// Number of threads of each interpreter, -1 to let TFLite decide.
+  int num_threads = -1;
+};
+
+/// WARNING: Experimental interface, subject to change
+///
+/// ShapeBucketedRunner runs a signature of a model whose inputs change size
+/// along one dimension on almost every call. Resizing an interpreter re-runs
+/// `Prepare` for every node and re-plans the whole arena, so instead the runner
+/// keeps one interpreter per bucket size, resized and allocated once when the
+/// runner is created. Each call pads the inputs with zeros up to the nearest
+/// bucket and runs that bucket's interpreter, so switching between sizes costs
+/// no reallocation. The model must tolerate the padding, e.g. through a mask
+/// input that is padded with zeros as well.
+///
+/// Usage:
+///
+/// <pre><code>
+/// tflite::ShapeBucketedRunnerOptions options;
+/// options.bucket_sizes = {16, 32, 64, 128};
+/// auto runner = tflite::ShapeBucketedRunner::Create(*model, resolver,
+///                                                    options);
+/// if (runner == nullptr) {
+///   // Return error.
+/// }
+/// if (runner->SetInputSize(sequence_length) != kTfLiteOk ||
+///     runner->SetInput("input_ids", input_ids) != kTfLiteOk ||
+///     runner->Invoke() != kTfLiteOk ||
+///     runner->GetOutput("logits", logits) != kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// Every bucket has its own arena, so memory use grows with the number of
+/// buckets. The model must outlive the runner.
+///
+/// WARNING: This class is *not* thread-safe. The client is responsible for
+/// ensuring serialized interaction to avoid data races and undefined behavior.
+class ShapeBucketedRunner {
+ public:
+  /// Builds and allocates one interpreter per bucket. Returns nullptr on
+  /// failure.
+  static std::unique_ptr<ShapeBucketedRunner> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const ShapeBucketedRunnerOptions& options);
+
+  /// Selects the smallest bucket that holds inputs of `size` along the
+  /// bucketed dimension. Fails if `size` exceeds the largest bucket.
+  TfLiteStatus SetInputSize(int size);
+
+  /// Copies `data`, which holds input `input_name` with the size passed to
+  /// SetInputSize() along the bucketed dimension, into the current bucket and
+  /// pads it with zeros.
+  TfLiteStatus SetInput(const char* input_name, const void* data);
+
+  /// Invokes the interpreter of the current bucket.
+  TfLiteStatus Invoke();
+
+  /// Copies output `output_name` into `data` and drops the padding along the
+  /// bucketed dimension. Outputs whose bucketed dimension does not match the
+  /// bucket size are copied as is.
+  TfLiteStatus GetOutput(const char* output_name, void* data) const;
+
+  /// Returns the runner of the current bucket, which gives direct access to
+  /// the padded tensors, or nullptr before SetInputSize().
+  SignatureRunner* current_runner() const {
+    return current_ ? current_->runner : nullptr;
+  }
+
+  /// Returns the size of the current bucket, or 0 before SetInputSize().
+  int current_bucket_size() const { return current_ ? current_->size : 0; }
+
+ private:
+  struct Bucket {
+    int size;
+    std::unique_ptr<Interpreter> interpreter;
+    // Owned by `interpreter`.
+    SignatureRunner* runner;
+  };
+
+  ShapeBucketedRunner(int bucketed_dim, std::vector<Bucket> buckets);
+
+  ErrorReporter* error_reporter() const {
+    return buckets_.front().interpreter->error_reporter();
+  }
+
+  const int bucketed_dim_;
+  // Sorted by size.
+  std::vector<Bucket> buckets_;
+  const Bucket* current_ = nullptr;
+  // The size passed to the last successful SetInputSize().
+  int input_size_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_SHAPE_BUCKETED_RUNNER_H_
@@ -0,0 +1,113 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/shape_bucketed_runner.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+class ShapeBucketedRunnerTest : public ::testing::Test {
+ protected:
+  // The "add" signature of the model computes `output_0 = x + 2` on a rank 1
+  // input.
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_signatures.bin", &reporter_);
+    ASSERT_NE(model_, nullptr);
+    options_.signature_key = "add";
+    options_.bucketed_dim = 0;
+    options_.bucket_sizes = {4, 2};
+  }
+
+  TestErrorReporter reporter_;
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+  ShapeBucketedRunnerOptions options_;
+};
+
+TEST_F(ShapeBucketedRunnerTest, PadsToNearestBucket) {
+  auto runner = ShapeBucketedRunner::Create(*model_, resolver_, options_);
+  ASSERT_NE(runner, nullptr);
+  const float input[] = {1, 2, 3};
+  ASSERT_EQ(runner->SetInputSize(3), kTfLiteOk);
+  EXPECT_EQ(runner->current_bucket_size(), 4);
+  ASSERT_EQ(runner->SetInput("x", input), kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  std::vector<float> output(3);
+  ASSERT_EQ(runner->GetOutput("output_0", output.data()), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(3, 4, 5));
+  // The padding is zero.
+  const TfLiteTensor* padded =
+      runner->current_runner()->output_tensor("output_0");
+  EXPECT_EQ(padded->data.f[3], 2);
+}
+
+TEST_F(ShapeBucketedRunnerTest, SwitchesBucketsWithoutReallocating) {
+  auto runner = ShapeBucketedRunner::Create(*model_, resolver_, options_);
+  ASSERT_NE(runner, nullptr);
+  ASSERT_EQ(runner->SetInputSize(1), kTfLiteOk);
+  EXPECT_EQ(runner->current_bucket_size(), 2);
+  const void* small_input =
+      runner->current_runner()->input_tensor("x")->data.raw;
+  ASSERT_EQ(runner->SetInputSize(4), kTfLiteOk);
+  ASSERT_EQ(runner->SetInputSize(2), kTfLiteOk);
+  EXPECT_EQ(runner->current_runner()->input_tensor("x")->data.raw,
+            small_input);
+
+  const float input[] = {5};
+  ASSERT_EQ(runner->SetInputSize(1), kTfLiteOk);
+  ASSERT_EQ(runner->SetInput("x", input), kTfLiteOk);
+  ASSERT_EQ(runner->Invoke(), kTfLiteOk);
+  float output = 0;
+  ASSERT_EQ(runner->GetOutput("output_0", &output), kTfLiteOk);
+  EXPECT_EQ(output, 7);
+}
+
+TEST_F(ShapeBucketedRunnerTest, RejectsSizesAboveLargestBucket) {
+  auto runner = ShapeBucketedRunner::Create(*model_, resolver_, options_);
+  ASSERT_NE(runner, nullptr);
+  EXPECT_EQ(runner->SetInputSize(5), kTfLiteError);
+  EXPECT_EQ(runner->SetInputSize(0), kTfLiteError);
+  EXPECT_EQ(runner->current_runner(), nullptr);
+  EXPECT_EQ(runner->Invoke(), kTfLiteError);
+}
+
+TEST_F(ShapeBucketedRunnerTest, RequiresSignatureKeyForMultipleSignatures) {
+  options_.signature_key = nullptr;
+  EXPECT_EQ(ShapeBucketedRunner::Create(*model_, resolver_, options_),
+            nullptr);
+  options_.signature_key = "dummy";
+  EXPECT_EQ(ShapeBucketedRunner::Create(*model_, resolver_, options_),
+            nullptr);
+}
+
+TEST_F(ShapeBucketedRunnerTest, RequiresBucketSizes) {
+  options_.bucket_sizes.clear();
+  EXPECT_EQ(ShapeBucketedRunner::Create(*model_, resolver_, options_),
+            nullptr);
+}
+
+}  // namespace
+}  // namespace tflite
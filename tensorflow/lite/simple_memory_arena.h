@@ -76,6 +76,14 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Schedule memory allocation for a tensor at a fixed `offset`, e.g. one
+  // planned offline. The caller is responsible for the allocation not
+  // overlapping with any other allocation that is used at the same time.
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t offset, size_t size,
+                          int32_t tensor, int32_t first_node,
+                          int32_t last_node,
+                          ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
@@ -287,6 +287,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<int32_t>(1024));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("enable_op_perf_counters",
+                          BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("perf_counter_ridge_point",
+                          BenchmarkParam::Create<float>(1.0f));
 
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
@@ -351,6 +355,14 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
           "prints to stdout."),
+      CreateFlag<bool>(
+          "enable_op_perf_counters", &params_,
+          "also read the cycle, instruction and cache miss counters around "
+          "each op with Linux perf events, requires enable_op_profiling"),
+      CreateFlag<float>(
+          "perf_counter_ridge_point", &params_,
+          "instructions per byte read from memory below which an op is "
+          "reported as memory bound"),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -391,6 +403,10 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Max profiling buffer entries", verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_op_perf_counters",
+                      "Enable op perf counters", verbose);
+  LOG_BENCHMARK_PARAM(float, "perf_counter_ridge_point",
+                      "Perf counter ridge point", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -836,7 +852,9 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<std::string>("profiling_output_csv_file"),
       CreateProfileSummaryFormatter(
-          !params_.Get<std::string>("profiling_output_csv_file").empty())));
+          !params_.Get<std::string>("profiling_output_csv_file").empty()),
+      params_.Get<bool>("enable_op_perf_counters"),
+      params_.Get<float>("perf_counter_ridge_point")));
 }
 
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
@@ -25,42 +25,57 @@ namespace benchmark {
 ProfilingListener::ProfilingListener(
     Interpreter* interpreter, uint32_t max_num_entries,
     const std::string& csv_file_path,
-    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter)
+    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter,
+    bool enable_perf_counters, double perf_counter_ridge_point)
     : run_summarizer_(summarizer_formatter),
       init_summarizer_(summarizer_formatter),
       csv_file_path_(csv_file_path),
       interpreter_(interpreter),
-      profiler_(max_num_entries) {
+      perf_counter_ridge_point_(perf_counter_ridge_point) {
   TFLITE_TOOLS_CHECK(interpreter);
-  interpreter_->SetProfiler(&profiler_);
+  if (enable_perf_counters) {
+    auto perf_counter_profiler =
+        std::make_unique<profiling::PerfCounterProfiler>(max_num_entries);
+    if (perf_counter_profiler->HasCounters()) {
+      perf_counter_profiler_ = perf_counter_profiler.get();
+    } else {
+      TFLITE_LOG(WARN) << "Perf counters are unavailable, only profiling the "
+                          "operator times.";
+    }
+    profiler_ = std::move(perf_counter_profiler);
+  } else {
+    profiler_ = std::make_unique<profiling::BufferedProfiler>(max_num_entries);
+  }
+  interpreter_->SetProfiler(profiler_.get());
 
   // We start profiling here in order to catch events that are recorded during
   // the benchmark run preparation stage where TFLite interpreter is
   // initialized and model graph is prepared.
-  profiler_.Reset();
-  profiler_.StartProfiling();
+  profiler_->Reset();
+  profiler_->StartProfiling();
 }
 
 void ProfilingListener::OnBenchmarkStart(const BenchmarkParams& params) {
   // At this point, we have completed the preparation for benchmark runs
   // including TFLite interpreter initialization etc. So we are going to process
   // profiling events recorded during this stage.
-  profiler_.StopProfiling();
-  auto profile_events = profiler_.GetProfileEvents();
+  profiler_->StopProfiling();
+  auto profile_events = profiler_->GetProfileEvents();
   init_summarizer_.ProcessProfiles(profile_events, *interpreter_);
-  profiler_.Reset();
+  profiler_->Reset();
+  if (perf_counter_profiler_) perf_counter_profiler_->ResetCounters();
 }
 
 void ProfilingListener::OnSingleRunStart(RunType run_type) {
   if (run_type == REGULAR) {
-    profiler_.Reset();
-    profiler_.StartProfiling();
+    profiler_->Reset();
+    profiler_->StartProfiling();
   }
 }
 
 void ProfilingListener::OnSingleRunEnd() {
-  profiler_.StopProfiling();
-  auto profile_events = profiler_.GetProfileEvents();
+  profiler_->StopProfiling();
+  auto profile_events = profiler_->GetProfileEvents();
   run_summarizer_.ProcessProfiles(profile_events, *interpreter_);
 }
 
@@ -80,6 +95,13 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                 run_summarizer_.GetOutputString(),
                 output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
   }
+  if (perf_counter_profiler_ &&
+      !perf_counter_profiler_->GetOpCounters().empty()) {
+    WriteOutput("Operator-wise Perf Counters for Regular Benchmark Runs:",
+                perf_counter_profiler_->GetOutputString(
+                    perf_counter_ridge_point_),
+                output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
+  }
 }
 
 void ProfilingListener::WriteOutput(const std::string& header,
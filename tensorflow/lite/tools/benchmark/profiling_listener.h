@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_counter_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
@@ -26,14 +27,18 @@ limitations under the License.
 namespace tflite {
 namespace benchmark {
 
-// Dumps profiling events if profiling is enabled.
+// Dumps profiling events if profiling is enabled. When perf counters are
+// enabled, also dumps the hardware counters of each operator, classified as
+// memory or compute bound with `perf_counter_ridge_point`, see
+// PerfCounterProfiler::GetOutputString.
 class ProfilingListener : public BenchmarkListener {
  public:
   ProfilingListener(
       Interpreter* interpreter, uint32_t max_num_entries,
       const std::string& csv_file_path = "",
       std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter =
-          std::make_shared<profiling::ProfileSummaryDefaultFormatter>());
+          std::make_shared<profiling::ProfileSummaryDefaultFormatter>(),
+      bool enable_perf_counters = false, double perf_counter_ridge_point = 1.0);
 
   void OnBenchmarkStart(const BenchmarkParams& params) override;
 
@@ -52,7 +57,10 @@ class ProfilingListener : public BenchmarkListener {
   void WriteOutput(const std::string& header, const string& data,
                    std::ostream* stream);
   Interpreter* interpreter_;
-  profiling::BufferedProfiler profiler_;
+  std::unique_ptr<profiling::BufferedProfiler> profiler_;
+  // Points to profiler_ if perf counters are enabled.
+  profiling::PerfCounterProfiler* perf_counter_profiler_ = nullptr;
+  double perf_counter_ridge_point_;
 };
 
 }  // namespace benchmark
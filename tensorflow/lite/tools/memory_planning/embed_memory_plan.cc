@@ -0,0 +1,69 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Binary to embed an offline memory plan into a TFLite flatbuffer.
+#include <fstream>  // NOLINT
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/memory_planning/offline_memory_planner.h"
+
+namespace tflite {
+
+constexpr char kInputFlatbufferFlag[] = "input_flatbuffer";
+constexpr char kOutputFlatbufferFlag[] = "output_flatbuffer";
+
+int Main(int argc, char* argv[]) {
+  // Command Line Flags.
+  std::string input_flatbuffer_path;
+  std::string output_flatbuffer_path;
+
+  std::vector<Flag> flag_list = {
+      tflite::Flag::CreateFlag(kInputFlatbufferFlag, &input_flatbuffer_path,
+                               "Path to input TFLite flatbuffer."),
+      tflite::Flag::CreateFlag(kOutputFlatbufferFlag, &output_flatbuffer_path,
+                               "Path to output TFLite flatbuffer."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flag_list) ||
+      input_flatbuffer_path.empty() || output_flatbuffer_path.empty()) {
+    LOG(ERROR) << Flags::Usage(argv[0], flag_list);
+    return 1;
+  }
+
+  std::ifstream input_file_stream(input_flatbuffer_path, std::ios::binary);
+  std::stringstream input_model_content;
+  input_model_content << input_file_stream.rdbuf();
+  if (!input_file_stream) {
+    LOG(ERROR) << "Unable to read " << input_flatbuffer_path;
+    return 1;
+  }
+
+  const std::string output_model_content =
+      EmbedOfflineMemoryPlan(input_model_content.str());
+  if (output_model_content.empty()) {
+    LOG(ERROR) << "Unable to plan the memory of " << input_flatbuffer_path;
+    return 1;
+  }
+
+  std::ofstream output_file_stream(output_flatbuffer_path, std::ios::binary);
+  output_file_stream << output_model_content;
+  output_file_stream.close();
+  return 0;
+}
+}  // namespace tflite
+
+int main(int argc, char* argv[]) { return tflite::Main(argc, argv); }
@@ -0,0 +1,278 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/memory_planning/offline_memory_planner.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/context_util.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace {
+
+constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+bool UsedAtTheSameTime(const ArenaBufferUsage& a, const ArenaBufferUsage& b) {
+  return a.first_node <= b.last_node && b.first_node <= a.last_node;
+}
+
+// Places `buffers` in `order`, each in the smallest gap that holds it among
+// the buffers already placed, and returns the size of the arena.
+size_t PlaceBuffers(const std::vector<ArenaBufferUsage>& buffers,
+                    const std::vector<int>& order, size_t alignment,
+                    std::vector<size_t>* offsets) {
+  offsets->assign(buffers.size(), 0);
+  // Indices of the placed buffers, ordered by offset.
+  std::vector<int> placed;
+  size_t arena_size = 0;
+  for (int i : order) {
+    const ArenaBufferUsage& buffer = buffers[i];
+    if (buffer.size == 0) continue;
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t current_offset = 0;
+    for (int j : placed) {
+      if (!UsedAtTheSameTime(buffer, buffers[j])) continue;
+      const size_t aligned_offset = AlignTo(alignment, current_offset);
+      if (aligned_offset + buffer.size <= (*offsets)[j] &&
+          (*offsets)[j] - aligned_offset < best_gap) {
+        best_offset = aligned_offset;
+        best_gap = (*offsets)[j] - aligned_offset;
+      }
+      current_offset =
+          std::max(current_offset, (*offsets)[j] + buffers[j].size);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = AlignTo(alignment, current_offset);
+    }
+    (*offsets)[i] = best_offset;
+    arena_size = std::max(arena_size, best_offset + buffer.size);
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), best_offset,
+                                   [offsets](size_t offset, int j) {
+                                     return offset < (*offsets)[j];
+                                   }),
+                  i);
+  }
+  return arena_size;
+}
+
+}  // namespace
+
+size_t PlanArenaOffsets(const std::vector<ArenaBufferUsage>& buffers,
+                        size_t alignment, std::vector<size_t>* offsets) {
+  auto lifetime = [&buffers](int i) {
+    return static_cast<int64_t>(buffers[i].last_node) - buffers[i].first_node;
+  };
+  auto lives_throughout = [&buffers](int i) {
+    return buffers[i].first_node == 0 &&
+           buffers[i].last_node == kNodeNotAssigned;
+  };
+  using Comparator = std::function<bool(int, int)>;
+  const std::vector<Comparator> orders = {
+      // The order of the online arena planner, given that the buffers are
+      // ordered by tensor index.
+      [&](int a, int b) {
+        if (lives_throughout(a) || lives_throughout(b)) {
+          return lives_throughout(a) && (!lives_throughout(b) || a < b);
+        }
+        if (buffers[a].size != buffers[b].size) {
+          return buffers[a].size > buffers[b].size;
+        }
+        return buffers[a].first_node < buffers[b].first_node;
+      },
+      // Longest lived first.
+      [&](int a, int b) {
+        if (lifetime(a) != lifetime(b)) return lifetime(a) > lifetime(b);
+        return buffers[a].size > buffers[b].size;
+      },
+      // Largest size times lifetime first.
+      [&](int a, int b) {
+        const double area_a = buffers[a].size * (lifetime(a) + 1.0);
+        const double area_b = buffers[b].size * (lifetime(b) + 1.0);
+        if (area_a != area_b) return area_a > area_b;
+        return buffers[a].first_node < buffers[b].first_node;
+      },
+      // In order of allocation.
+      [&](int a, int b) {
+        if (buffers[a].first_node != buffers[b].first_node) {
+          return buffers[a].first_node < buffers[b].first_node;
+        }
+        return buffers[a].size > buffers[b].size;
+      },
+  };
+
+  size_t best_arena_size = std::numeric_limits<size_t>::max();
+  std::vector<size_t> candidate;
+  for (const Comparator& compare : orders) {
+    std::vector<int> order(buffers.size());
+    for (int i = 0; i < buffers.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), compare);
+    const size_t arena_size =
+        PlaceBuffers(buffers, order, alignment, &candidate);
+    if (arena_size < best_arena_size) {
+      best_arena_size = arena_size;
+      offsets->swap(candidate);
+    }
+  }
+  return best_arena_size == std::numeric_limits<size_t>::max()
+             ? 0
+             : best_arena_size;
+}
+
+TfLiteStatus PlanSubgraphMemory(Interpreter* interpreter, int num_tensors,
+                                std::vector<int32_t>* offsets,
+                                size_t* arena_size) {
+  const int total_tensors = interpreter->tensors_size();
+  if (num_tensors > total_tensors) return kTfLiteError;
+  // The usage intervals follow the rules of ArenaPlanner::PlanAllocations.
+  std::vector<int32_t> first_node(total_tensors, kNodeNotAssigned);
+  std::vector<int32_t> last_node(total_tensors, kNodeNotAssigned);
+  std::vector<int> refcounts(total_tensors, 0);
+  auto allocate = [&first_node](int node, int tensor) {
+    if (first_node[tensor] == kNodeNotAssigned) first_node[tensor] = node;
+  };
+  for (int tensor : interpreter->outputs()) {
+    refcounts[tensor]++;
+  }
+  for (int tensor : interpreter->variables()) {
+    refcounts[tensor]++;
+    allocate(0, tensor);
+  }
+  for (int tensor : interpreter->inputs()) {
+    if (tensor != kTfLiteOptionalTensor) {
+      refcounts[tensor]++;
+      allocate(0, tensor);
+    }
+  }
+  const std::vector<int>& execution_plan = interpreter->execution_plan();
+  for (int node_index : execution_plan) {
+    const TfLiteNode& node =
+        interpreter->node_and_registration(node_index)->first;
+    for (int tensor : TfLiteIntArrayView(node.inputs)) {
+      if (tensor != kTfLiteOptionalTensor) refcounts[tensor]++;
+    }
+  }
+  for (int i = 0; i < execution_plan.size(); ++i) {
+    const TfLiteNode& node =
+        interpreter->node_and_registration(execution_plan[i])->first;
+    for (int tensor : TfLiteIntArrayView(node.outputs)) {
+      allocate(i, tensor);
+    }
+    for (int tensor : TfLiteIntArrayView(node.temporaries)) {
+      first_node[tensor] = i;
+      last_node[tensor] = i;
+    }
+    for (int tensor : TfLiteIntArrayView(node.inputs)) {
+      if (tensor != kTfLiteOptionalTensor && --refcounts[tensor] == 0 &&
+          first_node[tensor] != kNodeNotAssigned) {
+        last_node[tensor] = i;
+      }
+    }
+  }
+
+  std::vector<ArenaBufferUsage> buffers;
+  std::vector<int> buffer_tensors;
+  for (int i = 0; i < total_tensors; ++i) {
+    const TfLiteTensor* tensor = interpreter->tensor(i);
+    if (tensor->allocation_type != kTfLiteArenaRw ||
+        first_node[i] == kNodeNotAssigned) {
+      continue;
+    }
+    buffers.push_back({tensor->bytes, first_node[i], last_node[i]});
+    buffer_tensors.push_back(i);
+  }
+  std::vector<size_t> buffer_offsets;
+  const size_t size =
+      PlanArenaOffsets(buffers, kDefaultTensorAlignment, &buffer_offsets);
+  if (size > std::numeric_limits<int32_t>::max()) return kTfLiteError;
+
+  offsets->assign(num_tensors, -1);
+  for (int i = 0; i < buffers.size(); ++i) {
+    if (buffer_tensors[i] < num_tensors) {
+      (*offsets)[buffer_tensors[i]] = buffer_offsets[i];
+    }
+  }
+  if (arena_size != nullptr) *arena_size = size;
+  return kTfLiteOk;
+}
+
+std::string EmbedOfflineMemoryPlan(absl::string_view model_buffer) {
+  std::unique_ptr<FlatBufferModel> model = FlatBufferModel::BuildFromBuffer(
+      model_buffer.data(), model_buffer.size());
+  if (model == nullptr || model->GetModel()->subgraphs() == nullptr ||
+      model->GetModel()->subgraphs()->size() == 0) {
+    return "";
+  }
+  ops::builtin::BuiltinOpResolver resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(*model, resolver)(&interpreter) != kTfLiteOk ||
+      interpreter->AllocateTensors() != kTfLiteOk) {
+    return "";
+  }
+  const auto* tensors = model->GetModel()->subgraphs()->Get(0)->tensors();
+  std::vector<int32_t> offsets;
+  if (tensors == nullptr ||
+      PlanSubgraphMemory(interpreter.get(), tensors->size(), &offsets,
+                         /*arena_size=*/nullptr) != kTfLiteOk) {
+    return "";
+  }
+
+  std::unique_ptr<ModelT> mutable_model(model->GetModel()->UnPack());
+  auto buffer = std::make_unique<BufferT>();
+  const std::string plan =
+      SerializeOfflineMemoryPlan(/*subgraph_index=*/0, offsets);
+  buffer->data.assign(plan.begin(), plan.end());
+  // Reuses the buffer of a previous plan, if any.
+  MetadataT* plan_metadata = nullptr;
+  for (auto& metadata : mutable_model->metadata) {
+    if (metadata->name == kOfflineMemoryAllocationMetadata) {
+      plan_metadata = metadata.get();
+    }
+  }
+  if (plan_metadata == nullptr) {
+    mutable_model->metadata.push_back(std::make_unique<MetadataT>());
+    plan_metadata = mutable_model->metadata.back().get();
+    plan_metadata->name = kOfflineMemoryAllocationMetadata;
+    plan_metadata->buffer = mutable_model->buffers.size();
+    mutable_model->buffers.push_back(std::move(buffer));
+  } else {
+    mutable_model->buffers[plan_metadata->buffer] = std::move(buffer);
+  }
+
+  flatbuffers::FlatBufferBuilder builder(/*initial_size=*/10240);
+  FinishModelBuffer(builder, Model::Pack(builder, mutable_model.get()));
+  return std::string(reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                     builder.GetSize());
+}
+
+}  // namespace tflite
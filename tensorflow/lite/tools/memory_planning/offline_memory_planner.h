@@ -0,0 +1,62 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_MEMORY_PLANNING_OFFLINE_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_TOOLS_MEMORY_PLANNING_OFFLINE_MEMORY_PLANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+
+// A buffer to place in the arena, used from the execution of `first_node` to
+// the execution of `last_node`, both positions in the execution plan.
+struct ArenaBufferUsage {
+  size_t size;
+  int32_t first_node;
+  int32_t last_node;
+};
+
+// Assigns an arena offset aligned to `alignment` to each of `buffers`, so that
+// buffers used at the same time do not overlap. Several placement orders are
+// tried with best-fit placement, including the one of the online arena
+// planner, and the plan with the smallest arena is kept. Returns the size of
+// that arena.
+size_t PlanArenaOffsets(const std::vector<ArenaBufferUsage>& buffers,
+                        size_t alignment, std::vector<size_t>* offsets);
+
+// Plans the arena of the primary subgraph of `interpreter`, whose tensors must
+// have been allocated. `offsets` receives the offsets of the first
+// `num_tensors` tensors, which are the tensors of the model, with -1 for the
+// tensors outside of the arena. Temporary tensors are planned too, so that
+// they fit in the arena, but they are left to the online planner.
+TfLiteStatus PlanSubgraphMemory(Interpreter* interpreter, int num_tensors,
+                                std::vector<int32_t>* offsets,
+                                size_t* arena_size);
+
+// Returns `model_buffer` with an offline memory plan for its primary subgraph
+// in its metadata, replacing any previous plan. The plan is computed for the
+// builtin op kernels. Returns an empty string on error.
+// NOTE: This only supports the primary subgraph for now.
+std::string EmbedOfflineMemoryPlan(absl::string_view model_buffer);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_MEMORY_PLANNING_OFFLINE_MEMORY_PLANNER_H_
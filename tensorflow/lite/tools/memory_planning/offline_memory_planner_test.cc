@@ -0,0 +1,110 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/memory_planning/offline_memory_planner.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(PlanArenaOffsetsTest, BeatsSizeOrder) {
+  // Placing the largest buffer first leaves a gap that is too small for the
+  // last buffer, while placing the longest lived buffer first does not.
+  const std::vector<ArenaBufferUsage> buffers = {
+      {192, 0, 3}, {192, 3, 3}, {256, 0, 1}, {128, 3, 3}};
+  std::vector<size_t> offsets;
+  EXPECT_EQ(PlanArenaOffsets(buffers, 64, &offsets), 512);
+  EXPECT_THAT(offsets, ElementsAre(0, 192, 192, 384));
+}
+
+TEST(PlanArenaOffsetsTest, ReusesMemory) {
+  const std::vector<ArenaBufferUsage> buffers = {
+      {100, 0, 1}, {10, 1, 2}, {100, 2, 3}};
+  std::vector<size_t> offsets;
+  EXPECT_EQ(PlanArenaOffsets(buffers, 64, &offsets), 138);
+  EXPECT_EQ(offsets[0], offsets[2]);
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+std::vector<float> RunModel(const FlatBufferModel& model) {
+  ops::builtin::BuiltinOpResolver resolver;
+  std::unique_ptr<Interpreter> interpreter;
+  EXPECT_EQ(InterpreterBuilder(model, resolver)(&interpreter), kTfLiteOk);
+  EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  TfLiteTensor* input = interpreter->input_tensor(0);
+  for (int i = 0; i < input->bytes / sizeof(float); ++i) {
+    input->data.f[i] = i;
+  }
+  EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+  const TfLiteTensor* output = interpreter->output_tensor(0);
+  return std::vector<float>(output->data.f,
+                            output->data.f + output->bytes / sizeof(float));
+}
+
+TEST(EmbedOfflineMemoryPlanTest, AddModel) {
+  const std::string model_buffer =
+      ReadFile("tensorflow/lite/testdata/add.bin");
+  ASSERT_FALSE(model_buffer.empty());
+  const std::string planned_buffer = EmbedOfflineMemoryPlan(model_buffer);
+  ASSERT_FALSE(planned_buffer.empty());
+
+  auto model = FlatBufferModel::BuildFromBuffer(model_buffer.data(),
+                                                model_buffer.size());
+  auto planned_model = FlatBufferModel::BuildFromBuffer(planned_buffer.data(),
+                                                        planned_buffer.size());
+  ASSERT_NE(model, nullptr);
+  ASSERT_NE(planned_model, nullptr);
+  const std::map<std::string, std::string> metadata =
+      planned_model->ReadAllMetadata();
+  const auto it = metadata.find(kOfflineMemoryAllocationMetadata);
+  ASSERT_NE(it, metadata.end());
+  std::vector<int32_t> offsets;
+  ASSERT_TRUE(ParseOfflineMemoryPlan(it->second, 0, &offsets));
+  EXPECT_EQ(offsets.size(),
+            planned_model->GetModel()->subgraphs()->Get(0)->tensors()->size());
+
+  EXPECT_EQ(RunModel(*planned_model), RunModel(*model));
+
+  // Planning again replaces the plan.
+  const std::string replanned_buffer = EmbedOfflineMemoryPlan(planned_buffer);
+  auto replanned_model = FlatBufferModel::BuildFromBuffer(
+      replanned_buffer.data(), replanned_buffer.size());
+  ASSERT_NE(replanned_model, nullptr);
+  EXPECT_EQ(replanned_model->GetModel()->metadata()->size(),
+            planned_model->GetModel()->metadata()->size());
+}
+
+}  // namespace
+}  // namespace tflite
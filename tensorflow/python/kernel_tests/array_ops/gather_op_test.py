@@ -303,6 +303,31 @@ class GatherTest(test.TestCase, parameterized.TestCase):
       with self.assertRaisesOpError(r"indices\[0,0\] = 7 is not in \[0, 3\)"):
         self.evaluate(array_ops.gather(params, [[7]], axis=1))
 
+  def testRandomRowsCPU(self):
+    # Enough rows for the copies to be sharded and prefetched ahead, with slices
+    # both shorter and longer than the prefetched bytes.
+    np.random.seed(0)
+    for slice_size in (3, 1000):
+      with self.subTest(slice_size=slice_size):
+        params = np.random.rand(500, slice_size).astype(np.float32)
+        indices = np.random.randint(0, 500, size=20000).astype(np.int64)
+        with test_util.force_cpu():
+          self.assertAllEqual(
+              np.take(params, indices, axis=0),
+              self.evaluate(array_ops.gather(params, indices)))
+
+  @test_util.disable_xla(
+      "Assertion inside an op is not supported in XLA. Instead XLA clamps the "
+      "index to be in bounds and returns the indexed value there (Don't rely "
+      "on this behavior).")
+  def testBadIndexAfterValidIndicesCPU(self):
+    params = np.arange(40, dtype=np.float32).reshape(10, 4)
+    indices = np.zeros(100, dtype=np.int32)
+    indices[95] = 10
+    with test_util.force_cpu():
+      with self.assertRaisesOpError(r"indices\[95\] = 10 is not in \[0, 10\)"):
+        self.evaluate(array_ops.gather(params, indices))
+
   def _disabledTestBadIndicesGPU(self):
     # TODO disabled due to different behavior on GPU and CPU
     # On GPU the bad indices do not raise error but fetch 0 values
@@ -1277,6 +1277,36 @@ class CollectiveOpsV3Test(test.TestCase, parameterized.TestCase):
     self.assertAllClose(result[0], [1.0, 2.0], rtol=1e-5, atol=1e-5)
     self.assertAllClose(result[1], [3.0, 4.0], rtol=1e-5, atol=1e-5)
 
+  @combinations.generate(
+      combinations.combine(device='CPU', communication='RING', required_gpus=0))
+  def testEmbeddingLookupV3(self, device, communication):
+    group_size = 2
+    group_key = 105
+
+    # Rows 0, 2 and 4 of the table are on rank 0, rows 1 and 3 on rank 1.
+    shards = [[[0.0, 0.5], [2.0, 2.5], [4.0, 4.5]], [[1.0, 1.5], [3.0, 3.5]]]
+    ids = [[[3, 0], [3, 4]], [[1]]]
+
+    @def_function.function
+    def run_embedding_lookup_2devices():
+      collectives = []
+      for rank in range(group_size):
+        with ops.device('/device:%s:%d' % (device, rank)):
+          group_handle = _collective_ops.initialize_communicator(
+              group_key=group_key,
+              rank=rank,
+              group_size=group_size,
+              communication_hint=communication)
+          collectives.append(
+              _collective_ops.embedding_lookup_v3(group_handle, shards[rank],
+                                                  ids[rank]))
+      return collectives
+
+    result = run_embedding_lookup_2devices()
+    self.assertAllClose(result[0],
+                        [[[3.0, 3.5], [0.0, 0.5]], [[3.0, 3.5], [4.0, 4.5]]])
+    self.assertAllClose(result[1], [[[1.0, 1.5]]])
+
 
 def _setup_context():
   context._reset_context()
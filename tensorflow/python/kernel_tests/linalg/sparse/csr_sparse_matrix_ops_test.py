@@ -525,6 +525,20 @@ class CSRSparseMatrixOpsTest(test.TestCase):
           math_ops.conj(test_util.matmul_without_tf32(a_dense, b)))
       self.assertAllClose(expected_c_value, c_value)
 
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulSkewedRows(self):
+    # A few dense rows among many empty ones, so that shards balanced by the
+    # number of nonzeros differ from shards of equally many rows.
+    a_mats = np.zeros([3, 257, 64], dtype=np.float32)
+    a_mats[:, [0, 1, 128, 255], :] = np.random.randn(3, 4, 64)
+    a_mats[:, 200, 7] = 1.0
+    b_mats = np.random.randn(3, 64, 9).astype(np.float32)
+    a_sm = dense_to_csr_sparse_matrix(a_mats)
+    c = sparse_csr_matrix_ops.sparse_matrix_mat_mul(a_sm, b_mats)
+    c_value, c_dense_value = self.evaluate(
+        (c, test_util.matmul_without_tf32(a_mats, b_mats)))
+    self.assertAllClose(c_value, c_dense_value, rtol=1e-6, atol=2e-5)
+
   @test_util.run_in_graph_and_eager_modes
   def testLargeBatchSparseMatrixMatMul(self):
     dtypes_to_test = [np.float32, np.complex64]
@@ -28,6 +28,7 @@ from tensorflow.python.framework import dtypes as dtypes_lib
 from tensorflow.python.framework import errors_impl
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import gradient_checker_v2
 from tensorflow.python.ops import math_ops
@@ -184,6 +185,23 @@ class SegmentReductionOpTest(SegmentReductionHelper):
         tf_ans = self.evaluate(s)
         self.assertAllClose(np_ans, tf_ans)
 
+  def testLargeSkewedSegments(self):
+    # Large enough to be reduced on multiple threads, with one long segment
+    # and gaps between the others.
+    num_rows = 20000
+    segment_ids = np.sort(
+        np.concatenate([
+            np.full([num_rows // 2], 7),
+            np.random.randint(0, 3 * num_rows, size=num_rows - num_rows // 2)
+        ]))
+    data = np.random.randn(num_rows, 16)
+    np_ans = np.zeros([segment_ids[-1] + 1, 16])
+    np.add.at(np_ans, segment_ids, data)
+    with self.cached_session(use_gpu=False):
+      tf_ans = self.evaluate(
+          math_ops.segment_sum(data=data, segment_ids=segment_ids))
+    self.assertAllClose(np_ans, tf_ans)
+
   @test_util.run_deprecated_v1
   def testSegmentIdsInvalid1(self):
     shape = [4, 4]
@@ -488,6 +506,27 @@ class UnsortedSegmentTest(SegmentReductionHelper):
           unsorted = math_ops.unsorted_segment_sum(data, segment_ids, 2)
           self.assertAllEqual(unsorted, np.zeros((2, 0), dtype=dtype))
 
+  def testLargeSkewedSegments(self):
+    # Large enough to be reduced on multiple threads, with one long segment
+    # and some dropped rows.
+    num_rows = 20000
+    num_segments = 3 * num_rows
+    segment_ids = np.random.randint(-1, num_segments, size=num_rows)
+    segment_ids[::2] = 7
+    data = np.random.randn(num_rows, 16)
+    kept = segment_ids >= 0
+    np_sum = np.zeros([num_segments, 16])
+    np.add.at(np_sum, segment_ids[kept], data[kept])
+    np_max = np.full([num_segments, 16], np.finfo(np.float64).min)
+    np.maximum.at(np_max, segment_ids[kept], data[kept])
+    with self.cached_session(use_gpu=False):
+      tf_sum, tf_max = self.evaluate([
+          math_ops.unsorted_segment_sum(data, segment_ids, num_segments),
+          math_ops.unsorted_segment_max(data, segment_ids, num_segments)
+      ])
+    self.assertAllClose(np_sum, tf_sum)
+    self.assertAllEqual(np_max, tf_max)
+
   def testDropNegatives(self):
     # Note: the test is done by replacing segment_ids with 8 to -1
     # for index  and replace values generated by numpy with 0.
@@ -933,6 +972,37 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           tf_xgrad = tf_op(tf_ygrad, indices, segment_ids, output_dim0)
           self.assertAllClose(tf_xgrad, np_xgrad)
 
+  def testGradientV2MatchesDenseGradient(self):
+    for inner_size in (1, 2, 3, 32):
+      with self.session(use_gpu=False):
+        tf_ygrad, np_ygrad = self._input([3, inner_size],
+                                         dtype=dtypes_lib.float32)
+        segment_ids = [0, 1, 2, 2, 2]
+        indices = [8, 3, 0, 9, 3]
+        output_dim0 = 10
+        ops_list = [
+            (gen_math_ops.sparse_segment_sum_grad_v2, "sum"),
+            (gen_math_ops.sparse_segment_mean_grad_v2, "mean"),
+            (gen_math_ops.sparse_segment_sqrt_n_grad_v2, "sqrtn"),
+        ]
+        for tf_op, mode in ops_list:
+          np_xgrad = self._sparseSegmentReduceGrad(np_ygrad, indices,
+                                                   segment_ids, output_dim0,
+                                                   mode)
+          tf_values, tf_unique_indices = tf_op(tf_ygrad, indices, segment_ids,
+                                               output_dim0)
+          self.assertAllEqual(tf_unique_indices, [0, 3, 8, 9])
+          self.assertAllClose(tf_values, np_xgrad[[0, 3, 8, 9]])
+
+  def testGradientV2IndicesInvalid(self):
+    tf_x, _ = self._input([3, 4], dtype=dtypes_lib.float32)
+    with self.session(use_gpu=False):
+      with self.assertRaisesRegex(errors_impl.InvalidArgumentError,
+                                  r"Index 10 out of range \[0, 10\)"):
+        s = gen_math_ops.sparse_segment_sum_grad_v2(tf_x, [8, 3, 0, 10],
+                                                    [0, 1, 2, 2], 10)
+        self.evaluate(s)
+
   def testGradientValid(self):
     # Baseline for the testGradient*Invalid* methods below.
     tf_x, _ = self._input([3, 4], dtype=dtypes_lib.float32)
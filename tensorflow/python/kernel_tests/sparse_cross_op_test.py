@@ -417,6 +417,30 @@ class SparseCrossOpTest(test.TestCase):
       all_values_are_different = len(out.values) == len(set(out.values))
       self.assertTrue(all_values_are_different)
 
+  def test_hashed_permutation_matches_single_crosses(self):
+    """Tests that each hashed cross only depends on its own features."""
+    features = [['batch1-FC1-F1', 'batch1-FC1-F2', 'batch1-FC1-F3'],
+                ['batch1-FC2-F1', 'batch1-FC2-F2'],
+                ['batch1-FC3-F1', 'batch1-FC3-F2']]
+    op = sparse_ops.sparse_cross_hashed(
+        [self._sparse_tensor([column]) for column in features],
+        num_buckets=1000,
+        hash_key=sparse_ops._DEFAULT_HASH_KEY + 1)
+    single_ops = []
+    for f1 in features[0]:
+      for f2 in features[1]:
+        for f3 in features[2]:
+          single_ops.append(
+              sparse_ops.sparse_cross_hashed(
+                  [self._sparse_tensor([[f]]) for f in (f1, f2, f3)],
+                  num_buckets=1000,
+                  hash_key=sparse_ops._DEFAULT_HASH_KEY + 1).values)
+    with self.cached_session():
+      out = self.evaluate(op)
+      expected = [v[0] for v in self.evaluate(single_ops)]
+      self.assertAllEqual([[0, i] for i in range(12)], out.indices)
+      self.assertAllEqual(expected, out.values)
+
   def _assert_sparse_tensor_empty(self, sp):
     self.assertEqual(0, sp.indices.size)
     self.assertEqual(0, sp.values.size)
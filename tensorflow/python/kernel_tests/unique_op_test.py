@@ -170,6 +170,20 @@ class UniqueTest(test.TestCase):
     self.assertAllEqual(tf_y, true_y)
     self.assertAllEqual(tf_idx, true_idx)
 
+  def testLargeInputOrderedByAppearance(self):
+    # Large enough for the CPU kernel to uniquify on multiple threads.
+    for dtype in [np.int32, np.int64]:
+      x = np.random.randint(-50000, high=50000, size=1 << 20).astype(dtype)
+      _, first_index, true_idx = np.unique(
+          x, return_index=True, return_inverse=True)
+      order = np.argsort(first_index)
+      rank = np.empty_like(order)
+      rank[order] = np.arange(len(order))
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = self.evaluate([y, idx])
+      self.assertAllEqual(tf_y, x[np.sort(first_index)])
+      self.assertAllEqual(tf_idx, rank[true_idx])
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -485,3 +485,39 @@ def all_to_all_v3(communicator, t, group_assignment=None, timeout_seconds=None):
       input=t,
       group_assignment=group_assignment,
       timeout_seconds=timeout_seconds)
+
+
+def embedding_lookup_v3(communicator,
+                        params,
+                        ids,
+                        group_assignment=None,
+                        timeout_seconds=None):
+  """Looks up rows of a table sharded over the ranks of a communicator.
+
+  The table is partitioned with the "mod" strategy: row `id` is held by the
+  rank `id % group_size`, as row `id // group_size` of its shard. All ranks
+  must run the lookup.
+
+  Args:
+    communicator: the resource `tf.Tensor` returned from
+      `initialize_communicator`.
+    params: the `tf.Tensor` holding the shard of the table of this rank.
+    ids: an int32 or int64 `tf.Tensor` with the rows to look up.
+    group_assignment: Optional int32 `tf.Tensor` with shape [num_groups,
+      num_ranks_per_group]. `group_assignment[i]` represents the ranks in the
+      `ith` subgroup.
+    timeout_seconds: If set to a non zero, set a completion timeout to detect
+      staleness. If the timer goes off, a DeadlineExceededError is raised. The
+      timeout value in seconds. This feature is experimental.
+
+  Returns:
+    A `tf.Tensor` of shape `ids.shape + params.shape[1:]`.
+  """
+  if group_assignment is None:
+    group_assignment = []
+  return gen_collective_ops.collective_embedding_lookup_v3(
+      params=params,
+      ids=ids,
+      communicator=communicator,
+      group_assignment=group_assignment,
+      timeout_seconds=timeout_seconds)
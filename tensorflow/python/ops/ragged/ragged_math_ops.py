@@ -990,6 +990,11 @@ def _matmul_3d_with_map_fn(a, b, **kwargs):
   return result
 
 
+_RAGGED_BATCH_MATMUL_DTYPES = (dtypes.bfloat16, dtypes.float16, dtypes.float32,
+                               dtypes.float64, dtypes.complex64,
+                               dtypes.complex128)
+
+
 def _matmul_3d_with_batch_dim_folding(a, b, **kwargs):
   """Multiply batches of 2D matrices where only `a.shape[1]` is ragged.
 
@@ -1002,6 +1007,18 @@ def _matmul_3d_with_batch_dim_folding(a, b, **kwargs):
   Returns:
     A RaggedTensor with `shape=[B, (I), K].
   """
+  if (kwargs.get('output_type') in (None, a.dtype) and
+      a.dtype in _RAGGED_BATCH_MATMUL_DTYPES):
+    # Multiply the flat values of `a` by the matrices of `b` directly, without
+    # repeating `b` for every row of `a`.
+    transpose_b = kwargs.get('transpose_b', False)
+    if kwargs.get('adjoint_b', False):
+      b = math_ops.conj(b)
+      transpose_b = True
+    values = gen_ragged_math_ops.ragged_batch_mat_mul(
+        a.values, a.row_splits, b, transpose_b=transpose_b)
+    return a.with_values(values)
+
   # reshaped_a.shape = [sum(i_1, i_2, ..., i_B), 1, J]
   reshaped_a = array_ops.expand_dims(a.values, 1)
   # reshaped_b.shape = [sum(i_1, i_2, ..., i_B), J, K]
@@ -1012,6 +1029,29 @@ def _matmul_3d_with_batch_dim_folding(a, b, **kwargs):
   return a.with_values(array_ops.squeeze(flat_result, axis=1))
 
 
+@ops.RegisterGradient('RaggedBatchMatMul')
+def _ragged_batch_mat_mul_grad(op, grad):
+  """Gradient for RaggedBatchMatMul."""
+  a_values = math_ops.conj(op.inputs[0])
+  a_row_splits = op.inputs[1]
+  b = math_ops.conj(op.inputs[2])
+  transpose_b = op.get_attr('transpose_b')
+  grad_a_values = gen_ragged_math_ops.ragged_batch_mat_mul(
+      grad, a_row_splits, b, transpose_b=not transpose_b)
+  # The matrix of each batch gets the sum of the outer products of its rows of
+  # `a` and `grad`.
+  if transpose_b:
+    outer_products = (
+        array_ops.expand_dims(grad, 2) * array_ops.expand_dims(a_values, 1))
+  else:
+    outer_products = (
+        array_ops.expand_dims(a_values, 2) * array_ops.expand_dims(grad, 1))
+  row_ids = segment_id_ops.row_splits_to_segment_ids(a_row_splits)
+  grad_b = math_ops.unsorted_segment_sum(outer_products, row_ids,
+                                         array_ops.shape(b)[0])
+  return [grad_a_values, None, grad_b]
+
+
 #===============================================================================
 # ragged.softmax
 #===============================================================================
@@ -26,6 +26,8 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_ragged_math_ops
+from tensorflow.python.ops import gradient_checker_v2
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops.ragged import ragged_concat_ops
 from tensorflow.python.ops.ragged import ragged_factory_ops
@@ -241,6 +243,38 @@ class RaggedMatmulOpTest(test_util.TensorFlowTestCase, parameterized.TestCase):
     with self.assertRaisesRegex(exc, message):
       self.evaluate(ragged_math_ops.matmul(a, b, **kwargs))
 
+  @parameterized.parameters([
+      dict(),
+      dict(transpose_b=True),
+      dict(adjoint_b=True),
+  ])
+  def testMatmulFloatWithBatchDimFolding(self, **kwargs):
+    # Row lengths include an empty row, so some batches contribute no values.
+    a = ragged_tensor.RaggedTensor.from_row_lengths(
+        math_ops.cast(T([9, 4]), dtypes.float32), [3, 0, 5, 1])
+    if kwargs:
+      b = math_ops.cast(T([4, 6, 4]), dtypes.float32)
+    else:
+      b = math_ops.cast(T([4, 4, 6]), dtypes.float32)
+    actual = ragged_math_ops.matmul(a, b, **kwargs)
+    expected = self.eager_ragged_matmul(a, b, **kwargs)
+    self.assertAllClose(actual, expected)
+
+  @parameterized.parameters([False, True])
+  def testRaggedBatchMatMulGradient(self, transpose_b):
+    a_row_splits = [0, 2, 2, 5]
+    b_shape = [3, 4, 2] if transpose_b else [3, 2, 4]
+
+    def f(a_values, b):
+      return gen_ragged_math_ops.ragged_batch_mat_mul(
+          a_values, a_row_splits, b, transpose_b=transpose_b)
+
+    a_values = math_ops.cast(T([5, 2]), dtypes.float64)
+    b = math_ops.cast(T(b_shape), dtypes.float64) / 10.0
+    theoretical, numerical = gradient_checker_v2.compute_gradient(
+        f, [a_values, b])
+    self.assertAllClose(theoretical, numerical)
+
   def testUnknownRank(self):
     no_rank_spec = ragged_tensor.RaggedTensorSpec(None, dtypes.int32, 1)
     rank_only_spec = ragged_tensor.RaggedTensorSpec([None, None], dtypes.int32,
@@ -455,6 +455,42 @@ class TrainingOpsTest(TensorFlowTestCase):
     param_t = param - alpha_t * m_t / (np.sqrt(v_t) + epsilon)
     return param_t, m_t, v_t
 
+  @test_util.run_in_graph_and_eager_modes
+  def testResourceSparseApplyLazyAdam(self):
+    for dtype in [np.float32, np.float64]:
+      var = np.arange(12).reshape(4, 3).astype(dtype)
+      m = np.arange(1, 13).reshape(4, 3).astype(dtype)
+      v = np.arange(13, 25).reshape(4, 3).astype(dtype)
+      # Row 2 appears twice and row 1 not at all.
+      grad = np.arange(9).reshape(3, 3).astype(dtype)
+      indices = np.array([2, 0, 2], dtype=np.int64)
+      with self.cached_session(use_gpu=False):
+        var_t = resource_variable_ops.ResourceVariable(var)
+        m_t = resource_variable_ops.ResourceVariable(m)
+        v_t = resource_variable_ops.ResourceVariable(v)
+        self.evaluate(variables.global_variables_initializer())
+
+        t = 1
+        beta1 = np.array(0.9, dtype=dtype)
+        beta2 = np.array(0.999, dtype=dtype)
+        lr = np.array(0.001, dtype=dtype)
+        epsilon = np.array(1e-8, dtype=dtype)
+        self.evaluate(
+            training_ops.resource_sparse_apply_lazy_adam(
+                var_t.handle, m_t.handle, v_t.handle, beta1**t, beta2**t, lr,
+                beta1, beta2, epsilon, grad, indices))
+
+        expected_var, expected_m, expected_v = var.copy(), m.copy(), v.copy()
+        summed = {0: grad[1], 2: grad[0] + grad[2]}
+        for row, g in summed.items():
+          (expected_var[row], expected_m[row],
+           expected_v[row]) = self._adamUpdateNumpy(var[row], g, t, m[row],
+                                                     v[row], lr, beta1, beta2,
+                                                     epsilon)
+        self.assertAllCloseAccordingToType(expected_var, self.evaluate(var_t))
+        self.assertAllCloseAccordingToType(expected_m, self.evaluate(m_t))
+        self.assertAllCloseAccordingToType(expected_v, self.evaluate(v_t))
+
 
 if __name__ == '__main__':
   googletest.main()
@@ -27,11 +27,14 @@ std::string AllocatorStats::DebugString() const {
       "MaxAllocSize:     %20lld\n"
       "Reserved:         %20lld\n"
       "PeakReserved:     %20lld\n"
-      "LargestFreeBlock: %20lld\n",
+      "LargestFreeBlock: %20lld\n"
+      "PoolBytes:        %20lld\n"
+      "PeakPoolBytes:    %20lld\n",
       this->bytes_limit ? *this->bytes_limit : 0, this->bytes_in_use,
       this->peak_bytes_in_use, this->num_allocs, this->largest_alloc_size,
       this->bytes_reserved, this->peak_bytes_reserved,
-      this->largest_free_block_bytes);
+      this->largest_free_block_bytes, this->pool_bytes ? *this->pool_bytes : 0,
+      this->peak_pool_bytes ? *this->peak_pool_bytes : 0);
 }
 
 }  // namespace stream_executor
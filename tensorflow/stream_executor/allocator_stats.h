@@ -46,6 +46,11 @@ struct AllocatorStats {
 
   int64_t largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // The bytes the allocator holds from the device, in use or free, if the
+  // allocator pools memory.
+  absl::optional<int64_t> pool_bytes;
+  absl::optional<int64_t> peak_pool_bytes;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
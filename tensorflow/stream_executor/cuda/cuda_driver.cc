@@ -1007,6 +1007,80 @@ GpuDriver::CreateMemoryHandle(GpuContext* context, uint64_t bytes) {
   return res;
 }
 
+#if CUDA_VERSION >= 10020
+/* static */ port::Status GpuDriver::BeginStreamCapture(GpuContext* context,
+                                                        CUstream stream) {
+  ScopedActivateContext activated{context};
+  // Only forbid the calling thread from calls that are unsafe during capture,
+  // so other threads can keep using the device.
+  RETURN_IF_CUDA_RES_ERROR(
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "Failed to begin capturing CUDA stream");
+  return port::Status::OK();
+}
+
+/* static */ port::StatusOr<CUgraph> GpuDriver::EndStreamCapture(
+    GpuContext* context, CUstream stream) {
+  ScopedActivateContext activated{context};
+  CUgraph graph;
+  RETURN_IF_CUDA_RES_ERROR(cuStreamEndCapture(stream, &graph),
+                           "Failed to end capturing CUDA stream");
+  return graph;
+}
+
+/* static */ port::StatusOr<CUgraphExec> GpuDriver::InstantiateGraph(
+    GpuContext* context, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUgraphExec exec;
+  RETURN_IF_CUDA_RES_ERROR(
+      cuGraphInstantiate(&exec, graph, /*phErrorNode=*/nullptr,
+                         /*logBuffer=*/nullptr, /*bufferSize=*/0),
+      "Failed to instantiate CUDA graph");
+  return exec;
+}
+
+/* static */ bool GpuDriver::UpdateGraphExec(GpuContext* context,
+                                             CUgraphExec exec, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUgraphNode error_node;
+  CUgraphExecUpdateResult result = CU_GRAPH_EXEC_UPDATE_ERROR;
+  CUresult res = cuGraphExecUpdate(exec, graph, &error_node, &result);
+  if (res != CUDA_SUCCESS) {
+    VLOG(2) << "could not update CUDA graph exec: " << ToString(res)
+            << ", result " << result;
+    return false;
+  }
+  return true;
+}
+
+/* static */ port::Status GpuDriver::LaunchGraph(GpuContext* context,
+                                                 CUgraphExec exec,
+                                                 CUstream stream) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(cuGraphLaunch(exec, stream),
+                           "Failed to launch CUDA graph");
+  return port::Status::OK();
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context,
+                                          CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              CUgraphExec exec) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph exec: " << ToString(res);
+  }
+}
+#endif  // CUDA_VERSION >= 10020
+
 /* static */ bool GpuDriver::GetEventElapsedTime(GpuContext* context,
                                                  float* elapsed_milliseconds,
                                                  CUevent start, CUevent stop) {
@@ -444,6 +444,42 @@ class GpuDriver {
   static port::StatusOr<GpuStatus> QueryEvent(GpuContext* context,
                                               GpuEventHandle event);
 
+#if CUDA_VERSION >= 10020
+  // -- Graph calls. These are not supported in ROCM builds and will result in
+  // a link error if used.
+
+  // Starts capturing the work enqueued onto stream by the calling thread into
+  // a graph instead of running it, via cuStreamBeginCapture.
+  static port::Status BeginStreamCapture(GpuContext* context,
+                                         GpuStreamHandle stream);
+
+  // Stops capturing stream and returns the captured graph, via
+  // cuStreamEndCapture. The caller owns the graph.
+  static port::StatusOr<GpuGraphHandle> EndStreamCapture(
+      GpuContext* context, GpuStreamHandle stream);
+
+  // Creates an executable graph from graph via cuGraphInstantiate. The caller
+  // owns the executable graph.
+  static port::StatusOr<GpuGraphExecHandle> InstantiateGraph(
+      GpuContext* context, GpuGraphHandle graph);
+
+  // Updates the parameters of the nodes of exec to those of graph, via
+  // cuGraphExecUpdate. Returns false if graph has a different topology than
+  // the graph exec was instantiated from, in which case exec is unchanged.
+  static bool UpdateGraphExec(GpuContext* context, GpuGraphExecHandle exec,
+                              GpuGraphHandle graph);
+
+  // Enqueues the executable graph exec onto stream via cuGraphLaunch.
+  static port::Status LaunchGraph(GpuContext* context, GpuGraphExecHandle exec,
+                                  GpuStreamHandle stream);
+
+  // Destroys graph via cuGraphDestroy.
+  static void DestroyGraph(GpuContext* context, GpuGraphHandle graph);
+
+  // Destroys the executable graph exec via cuGraphExecDestroy.
+  static void DestroyGraphExec(GpuContext* context, GpuGraphExecHandle exec);
+#endif  // CUDA_VERSION >= 10020
+
   // -- Pointer-specific calls.
 
   // Returns the context in which pointer was allocated or registered.
@@ -0,0 +1,395 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A C++ binary to benchmark the serving latency of a SavedModel signature
+// under an open-loop load.
+//
+// See README.md for usage instructions.
+
+#include "tensorflow/tools/benchmark/saved_model_serving_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/reporter.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+
+namespace {
+
+Status GetInputShape(const string& key, const TensorInfo& tensor_info,
+                     const ServingBenchmarkOptions& options,
+                     TensorShape* shape) {
+  auto it = options.input_shapes.find(key);
+  if (it != options.input_shapes.end()) {
+    *shape = it->second;
+    return Status::OK();
+  }
+  PartialTensorShape partial_shape(tensor_info.tensor_shape());
+  if (partial_shape.unknown_rank()) {
+    return errors::InvalidArgument("The rank of input ", key,
+                                   " is unknown, specify its shape.");
+  }
+  if (partial_shape.dims() > 0 && partial_shape.dim_size(0) < 0) {
+    partial_shape.set_dim(0, options.batch_size);
+  }
+  if (!partial_shape.AsTensorShape(shape)) {
+    return errors::InvalidArgument("The shape of input ", key, " ",
+                                   partial_shape.DebugString(),
+                                   " is not fully defined, specify it.");
+  }
+  return Status::OK();
+}
+
+template <class T>
+void FillTensor(random::SimplePhilox* rnd, Tensor* tensor) {
+  auto flat = tensor->flat<T>();
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    flat(i) = static_cast<T>(rnd->Uniform(10));
+  }
+}
+
+Status CreateInput(const string& key, const TensorInfo& tensor_info,
+                   const TensorShape& shape, random::SimplePhilox* rnd,
+                   Tensor* tensor) {
+  *tensor = Tensor(tensor_info.dtype(), shape);
+  switch (tensor_info.dtype()) {
+    case DT_FLOAT: {
+      auto flat = tensor->flat<float>();
+      for (int64_t i = 0; i < flat.size(); ++i) flat(i) = rnd->RandFloat();
+      break;
+    }
+    case DT_DOUBLE: {
+      auto flat = tensor->flat<double>();
+      for (int64_t i = 0; i < flat.size(); ++i) flat(i) = rnd->RandDouble();
+      break;
+    }
+    case DT_INT32:
+      FillTensor<int32>(rnd, tensor);
+      break;
+    case DT_INT64:
+      FillTensor<int64_t>(rnd, tensor);
+      break;
+    case DT_UINT8:
+      FillTensor<uint8>(rnd, tensor);
+      break;
+    case DT_BOOL:
+      FillTensor<bool>(rnd, tensor);
+      break;
+    case DT_STRING:
+      tensor->flat<tstring>().setConstant("");
+      break;
+    default:
+      return errors::Unimplemented("Unsupported type ",
+                                   DataTypeString(tensor_info.dtype()),
+                                   " of input ", key);
+  }
+  return Status::OK();
+}
+
+// Nearest-rank percentile of sorted values.
+double Percentile(const std::vector<int64_t>& sorted_values,
+                  double percentile) {
+  if (sorted_values.empty()) return 0.0;
+  const size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * sorted_values.size()));
+  return sorted_values[std::max<size_t>(rank, 1) - 1];
+}
+
+Status ParseInputShapes(const string& input_shapes_string,
+                        std::map<string, TensorShape>* input_shapes) {
+  for (const string& input_shape :
+       str_util::Split(input_shapes_string, ';', str_util::SkipEmpty())) {
+    std::vector<string> key_and_dims = str_util::Split(input_shape, ':');
+    if (key_and_dims.size() != 2) {
+      return errors::InvalidArgument("Invalid input shape ", input_shape);
+    }
+    std::vector<int64_t> dims;
+    for (const string& dim :
+         str_util::Split(key_and_dims[1], ',', str_util::SkipEmpty())) {
+      int64_t size;
+      if (!strings::safe_strto64(dim, &size)) {
+        return errors::InvalidArgument("Invalid input shape ", input_shape);
+      }
+      dims.push_back(size);
+    }
+    TF_RETURN_IF_ERROR(TensorShapeUtils::MakeShape(
+        dims, &(*input_shapes)[key_and_dims[0]]));
+  }
+  return Status::OK();
+}
+
+void RecordBenchmarkEntry(const string& output_prefix,
+                          const string& benchmark_name,
+                          const ServingBenchmarkResult& result) {
+  TestReporter reporter(output_prefix, benchmark_name);
+  TF_QCHECK_OK(reporter.Initialize());
+  TF_QCHECK_OK(reporter.Benchmark(result.num_requests, -1.0,
+                                  result.wall_time_s, result.throughput_qps));
+  TF_QCHECK_OK(reporter.AddMetric("p50_latency_ms", result.p50_latency_ms));
+  TF_QCHECK_OK(reporter.AddMetric("p99_latency_ms", result.p99_latency_ms));
+  TF_QCHECK_OK(reporter.AddMetric("p999_latency_ms", result.p999_latency_ms));
+  TF_QCHECK_OK(reporter.AddMetric("cpu_utilization", result.cpu_utilization));
+  TF_QCHECK_OK(reporter.Close());
+}
+
+}  // namespace
+
+string ServingBenchmarkResult::DebugString() const {
+  return strings::Printf(
+      "requests: %lld, errors: %lld, wall time: %.3fs, throughput: %.1f qps\n"
+      "latency (ms): mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p999 %.3f, "
+      "max %.3f\n"
+      "cpu utilization: %.1f%%",
+      static_cast<long long>(num_requests),  // NOLINT(runtime/int)
+      static_cast<long long>(num_errors),    // NOLINT(runtime/int)
+      wall_time_s, throughput_qps, mean_latency_ms, p50_latency_ms,
+      p90_latency_ms, p99_latency_ms, p999_latency_ms, max_latency_ms,
+      cpu_utilization * 100);
+}
+
+Status CreateSignatureInputs(const SignatureDef& signature_def,
+                             const ServingBenchmarkOptions& options,
+                             std::vector<std::pair<string, Tensor>>* inputs,
+                             std::vector<string>* output_names) {
+  random::PhiloxRandom philox(options.seed);
+  random::SimplePhilox rnd(&philox);
+  // Orders the inputs by key, so that the values don't depend on the order of
+  // the signature map.
+  std::map<string, TensorInfo> tensor_infos(signature_def.inputs().begin(),
+                                            signature_def.inputs().end());
+  inputs->clear();
+  for (const auto& input : tensor_infos) {
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        GetInputShape(input.first, input.second, options, &shape));
+    Tensor tensor;
+    TF_RETURN_IF_ERROR(
+        CreateInput(input.first, input.second, shape, &rnd, &tensor));
+    inputs->emplace_back(input.second.name(), std::move(tensor));
+  }
+  output_names->clear();
+  for (const auto& output : signature_def.outputs()) {
+    output_names->push_back(output.second.name());
+  }
+  return Status::OK();
+}
+
+Status RunServingBenchmark(Session* session, const SignatureDef& signature_def,
+                           const ServingBenchmarkOptions& options,
+                           ServingBenchmarkResult* result) {
+  if (options.qps <= 0 || options.num_requests <= 0 ||
+      options.num_client_threads <= 0) {
+    return errors::InvalidArgument(
+        "The QPS, number of requests and number of client threads must be "
+        "positive.");
+  }
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  TF_RETURN_IF_ERROR(
+      CreateSignatureInputs(signature_def, options, &inputs, &output_names));
+  for (int64_t i = 0; i < options.num_warmup_requests; ++i) {
+    std::vector<Tensor> outputs;
+    TF_RETURN_IF_ERROR(session->Run(inputs, output_names, {}, &outputs));
+  }
+
+  Env* env = Env::Default();
+  random::PhiloxRandom philox(options.seed);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64_t> latencies_us(options.num_requests);
+  mutex mu;
+  int64_t num_errors = 0;
+  Status first_error;
+  BlockingCounter counter(options.num_requests);
+  {
+    thread::ThreadPool pool(env, "serving_benchmark",
+                            options.num_client_threads);
+    const std::clock_t start_cpu = std::clock();
+    const uint64 start_us = env->NowMicros();
+    double arrival_us = start_us;
+    for (int64_t i = 0; i < options.num_requests; ++i) {
+      // Exponential gaps between arrivals make a Poisson process.
+      arrival_us += -std::log(1.0 - rnd.RandDouble()) * 1e6 / options.qps;
+      const uint64 now_us = env->NowMicros();
+      if (arrival_us > now_us) {
+        env->SleepForMicroseconds(static_cast<int64_t>(arrival_us - now_us));
+      }
+      const int64_t scheduled_us = static_cast<int64_t>(arrival_us);
+      pool.Schedule([&, i, scheduled_us]() {
+        std::vector<Tensor> outputs;
+        Status s = session->Run(inputs, output_names, {}, &outputs);
+        latencies_us[i] = env->NowMicros() - scheduled_us;
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (num_errors++ == 0) first_error = s;
+        }
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    result->wall_time_s = (env->NowMicros() - start_us) / 1e6;
+    result->cpu_utilization = static_cast<double>(std::clock() - start_cpu) /
+                              CLOCKS_PER_SEC / result->wall_time_s /
+                              port::NumSchedulableCPUs();
+  }
+  if (num_errors > 0) {
+    LOG(ERROR) << num_errors << " requests failed, the first with "
+               << first_error;
+  }
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  int64_t total_latency_us = 0;
+  for (int64_t latency_us : latencies_us) total_latency_us += latency_us;
+  result->num_requests = options.num_requests;
+  result->num_errors = num_errors;
+  result->throughput_qps = options.num_requests / result->wall_time_s;
+  result->mean_latency_ms =
+      static_cast<double>(total_latency_us) / options.num_requests / 1000;
+  result->p50_latency_ms = Percentile(latencies_us, 50) / 1000;
+  result->p90_latency_ms = Percentile(latencies_us, 90) / 1000;
+  result->p99_latency_ms = Percentile(latencies_us, 99) / 1000;
+  result->p999_latency_ms = Percentile(latencies_us, 99.9) / 1000;
+  result->max_latency_ms = static_cast<double>(latencies_us.back()) / 1000;
+  return Status::OK();
+}
+
+int Main(int argc, char** argv) {
+  string saved_model_dir = "";
+  string tags_string = kSavedModelTagServe;
+  string signature = kDefaultServingSignatureDefKey;
+  float qps = 100.0f;
+  int64_t num_requests = 1000;
+  int64_t num_warmup_requests = 10;
+  int32_t num_client_threads = 16;
+  int64_t batch_size = 1;
+  string input_shapes_string = "";
+  int64_t seed = 1;
+  int32_t intra_op_threads = 0;
+  int32_t inter_op_threads = 0;
+  string benchmark_name = "";
+  string output_prefix = "";
+
+  std::vector<Flag> flag_list = {
+      Flag("saved_model_dir", &saved_model_dir, "SavedModel directory"),
+      Flag("tags", &tags_string, "comma separated MetaGraphDef tags"),
+      Flag("signature", &signature, "signature to run"),
+      Flag("qps", &qps, "requests per second"),
+      Flag("num_requests", &num_requests, "number of requests to time"),
+      Flag("num_warmup_requests", &num_warmup_requests,
+           "number of requests to run before timing"),
+      Flag("num_client_threads", &num_client_threads,
+           "number of threads sending requests"),
+      Flag("batch_size", &batch_size,
+           "size of the first dimension of the inputs when unknown"),
+      Flag("input_shapes", &input_shapes_string,
+           "input shapes overriding the signature, e.g. "
+           "images:1,224,224,3;ids:1,20"),
+      Flag("seed", &seed, "seed of the request arrivals and input values"),
+      Flag("intra_op_threads", &intra_op_threads,
+           "intra op parallelism threads, 0 for the default"),
+      Flag("inter_op_threads", &inter_op_threads,
+           "inter op parallelism threads, 0 for the default"),
+      Flag("benchmark_name", &benchmark_name, "benchmark name"),
+      Flag("output_prefix", &output_prefix, "benchmark output prefix"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || saved_model_dir.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+
+  ServingBenchmarkOptions options;
+  options.qps = qps;
+  options.num_requests = num_requests;
+  options.num_warmup_requests = num_warmup_requests;
+  options.num_client_threads = num_client_threads;
+  options.batch_size = batch_size;
+  options.seed = seed;
+  Status status = ParseInputShapes(input_shapes_string, &options.input_shapes);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return -1;
+  }
+
+  SessionOptions session_options;
+  session_options.config.set_intra_op_parallelism_threads(intra_op_threads);
+  session_options.config.set_inter_op_parallelism_threads(inter_op_threads);
+  const std::vector<string> tags =
+      str_util::Split(tags_string, ',', str_util::SkipEmpty());
+  SavedModelBundle bundle;
+  const uint64 load_start_us = Env::Default()->NowMicros();
+  status = LoadSavedModel(session_options, RunOptions(), saved_model_dir,
+                          std::unordered_set<string>(tags.begin(), tags.end()),
+                          &bundle);
+  if (!status.ok()) {
+    LOG(ERROR) << "Could not load " << saved_model_dir << ": " << status;
+    return -1;
+  }
+  LOG(INFO) << "Loaded the SavedModel in "
+            << (Env::Default()->NowMicros() - load_start_us) / 1e6 << "s";
+  auto it = bundle.GetSignatures().find(signature);
+  if (it == bundle.GetSignatures().end()) {
+    LOG(ERROR) << "Could not find signature " << signature;
+    return -1;
+  }
+
+  ServingBenchmarkResult result;
+  status =
+      RunServingBenchmark(bundle.GetSession(), it->second, options, &result);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return -1;
+  }
+  LOG(INFO) << "Signature " << signature << " at " << qps << " qps on "
+            << port::NumSchedulableCPUs() << " CPUs:\n"
+            << result.DebugString();
+  if (!benchmark_name.empty() && !output_prefix.empty()) {
+    RecordBenchmarkEntry(output_prefix, benchmark_name, result);
+  }
+  return 0;
+}
+
+}  // namespace serving_benchmark
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_SAVED_MODEL_SERVING_BENCHMARK_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_SAVED_MODEL_SERVING_BENCHMARK_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+
+struct ServingBenchmarkOptions {
+  // Requests are sent open-loop, i.e. regardless of the responses, with
+  // exponentially distributed gaps averaging 1 / qps seconds.
+  double qps = 100.0;
+  int64_t num_requests = 1000;
+  // Run one after the other before the measured requests.
+  int64_t num_warmup_requests = 10;
+  // Run the requests; requests wait for a free thread once all of them are
+  // busy, and the wait counts in their latency.
+  int num_client_threads = 16;
+
+  // The size of the first dimension of the inputs when it's unknown in the
+  // signature.
+  int64_t batch_size = 1;
+  // The shapes of the inputs by signature input key, for inputs whose shapes
+  // aren't fully defined by the signature.
+  std::map<string, TensorShape> input_shapes;
+
+  // Seeds the request arrivals and the input values, so that runs on the same
+  // hardware send the same load.
+  uint64 seed = 1;
+};
+
+struct ServingBenchmarkResult {
+  int64_t num_requests = 0;
+  int64_t num_errors = 0;
+  double wall_time_s = 0.0;
+  double throughput_qps = 0.0;
+  // Latencies from the scheduled arrival of the requests to their completion.
+  double mean_latency_ms = 0.0;
+  double p50_latency_ms = 0.0;
+  double p90_latency_ms = 0.0;
+  double p99_latency_ms = 0.0;
+  double p999_latency_ms = 0.0;
+  double max_latency_ms = 0.0;
+  // The process CPU time divided by the wall time and the number of CPUs.
+  double cpu_utilization = 0.0;
+
+  string DebugString() const;
+};
+
+// Creates the inputs of `signature_def` with random values, and the names of
+// its outputs.
+Status CreateSignatureInputs(
+    const SignatureDef& signature_def, const ServingBenchmarkOptions& options,
+    std::vector<std::pair<string, Tensor>>* inputs,
+    std::vector<string>* output_names);
+
+// Sends requests running `signature_def` on `session` at options.qps.
+Status RunServingBenchmark(Session* session, const SignatureDef& signature_def,
+                           const ServingBenchmarkOptions& options,
+                           ServingBenchmarkResult* result);
+
+// Handles all setup and argument parsing.
+int Main(int argc, char** argv);
+
+}  // namespace serving_benchmark
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_SAVED_MODEL_SERVING_BENCHMARK_H_
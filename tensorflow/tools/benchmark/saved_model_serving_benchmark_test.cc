@@ -0,0 +1,103 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/saved_model_serving_benchmark.h"
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving_benchmark {
+namespace {
+
+constexpr char kTestData[] = "cc/saved_model/testdata/half_plus_two/00000123";
+
+class SavedModelServingBenchmarkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string export_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestData);
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                                {kSavedModelTagServe}, &bundle_));
+  }
+
+  const SignatureDef& GetSignature(const string& key) {
+    return bundle_.GetSignatures().at(key);
+  }
+
+  SavedModelBundle bundle_;
+};
+
+TEST_F(SavedModelServingBenchmarkTest, CreateSignatureInputs) {
+  ServingBenchmarkOptions options;
+  options.batch_size = 4;
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  TF_ASSERT_OK(CreateSignatureInputs(GetSignature("regress_x2_to_y3"), options,
+                                     &inputs, &output_names));
+  ASSERT_EQ(inputs.size(), 1);
+  EXPECT_EQ(inputs[0].first, "x2:0");
+  EXPECT_EQ(inputs[0].second.shape(), TensorShape({4, 1}));
+  EXPECT_EQ(output_names, std::vector<string>({"y3:0"}));
+
+  // The same seed creates the same values.
+  std::vector<std::pair<string, Tensor>> other_inputs;
+  TF_ASSERT_OK(CreateSignatureInputs(GetSignature("regress_x2_to_y3"), options,
+                                     &other_inputs, &output_names));
+  test::ExpectTensorEqual<float>(inputs[0].second, other_inputs[0].second);
+}
+
+TEST_F(SavedModelServingBenchmarkTest, InputShapeOverride) {
+  ServingBenchmarkOptions options;
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  // The rank of the serialized examples is unknown.
+  EXPECT_FALSE(CreateSignatureInputs(GetSignature("regress_x_to_y"), options,
+                                     &inputs, &output_names)
+                   .ok());
+  options.input_shapes["inputs"] = TensorShape({3});
+  TF_ASSERT_OK(CreateSignatureInputs(GetSignature("regress_x_to_y"), options,
+                                     &inputs, &output_names));
+  ASSERT_EQ(inputs.size(), 1);
+  EXPECT_EQ(inputs[0].second.shape(), TensorShape({3}));
+}
+
+TEST_F(SavedModelServingBenchmarkTest, RunServingBenchmark) {
+  ServingBenchmarkOptions options;
+  options.qps = 1000;
+  options.num_requests = 50;
+  options.num_warmup_requests = 2;
+  options.num_client_threads = 4;
+  ServingBenchmarkResult result;
+  TF_ASSERT_OK(RunServingBenchmark(bundle_.GetSession(),
+                                   GetSignature("regress_x2_to_y3"), options,
+                                   &result));
+  EXPECT_EQ(result.num_requests, 50);
+  EXPECT_EQ(result.num_errors, 0);
+  EXPECT_GT(result.wall_time_s, 0);
+  EXPECT_GT(result.throughput_qps, 0);
+  EXPECT_LE(result.p50_latency_ms, result.p99_latency_ms);
+  EXPECT_LE(result.p99_latency_ms, result.p999_latency_ms);
+  EXPECT_LE(result.p999_latency_ms, result.max_latency_ms);
+  EXPECT_GE(result.cpu_utilization, 0);
+}
+
+}  // namespace
+}  // namespace serving_benchmark
+}  // namespace tensorflow